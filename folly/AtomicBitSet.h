@@ -23,11 +23,132 @@
 #include <limits>
 
 #include <folly/Portability.h>
+#include <folly/lang/Bits.h>
 
 namespace folly {
 
+namespace detail {
+
+// Pick the largest lock-free type available
+#if (ATOMIC_LLONG_LOCK_FREE == 2)
+typedef unsigned long long AtomicBitSetBlock;
+#elif (ATOMIC_LONG_LOCK_FREE == 2)
+typedef unsigned long AtomicBitSetBlock;
+#else
+// Even if not lock free, what can we do?
+typedef unsigned int AtomicBitSetBlock;
+#endif
+
+/*
+ * Word-level operations shared by AtomicBitSet and DynamicAtomicBitSet, on
+ * the first nbits bits of an array of blocks.  Bits past nbits are ignored.
+ */
+struct AtomicBitSetBlocks {
+  typedef AtomicBitSetBlock BlockType;
+  typedef std::atomic<BlockType> AtomicBlockType;
+
+  static constexpr size_t kBitsPerBlock =
+      std::numeric_limits<BlockType>::digits;
+
+  static constexpr size_t numBlocks(size_t nbits) {
+    return (nbits + kBitsPerBlock - 1) / kBitsPerBlock;
+  }
+
+  // mask of the bits of block b that are in [from, nbits)
+  static BlockType mask(size_t b, size_t from, size_t nbits) {
+    BlockType m = ~BlockType(0);
+    if (from > b * kBitsPerBlock) {
+      m <<= from % kBitsPerBlock;
+    }
+    if (nbits < (b + 1) * kBitsPerBlock) {
+      m &= ~(~BlockType(0) << (nbits % kBitsPerBlock));
+    }
+    return m;
+  }
+
+  // index of the first bit in [from, nbits) equal to value, or nbits
+  static size_t find(
+      AtomicBlockType const* blocks,
+      size_t nbits,
+      size_t from,
+      bool value,
+      std::memory_order order) {
+    for (size_t b = from / kBitsPerBlock; b * kBitsPerBlock < nbits; ++b) {
+      BlockType x = blocks[b].load(order);
+      x = (value ? x : ~x) & mask(b, from, nbits);
+      if (x) {
+        return b * kBitsPerBlock + findFirstSet(x) - 1;
+      }
+    }
+    return nbits;
+  }
+
+  // atomically set the first unset bit in [from, nbits) and return its
+  // index, or nbits if they are all set
+  static size_t setFirstUnset(
+      AtomicBlockType* blocks,
+      size_t nbits,
+      size_t from,
+      std::memory_order order) {
+    for (size_t b = from / kBitsPerBlock; b * kBitsPerBlock < nbits; ++b) {
+      BlockType const m = mask(b, from, nbits);
+      BlockType x = blocks[b].load(std::memory_order_relaxed);
+      BlockType unset;
+      while ((unset = ~x & m) != 0) {
+        BlockType const bit = unset & (~unset + 1);
+        if (blocks[b].compare_exchange_weak(
+                x, x | bit, order, std::memory_order_relaxed)) {
+          return b * kBitsPerBlock + findFirstSet(bit) - 1;
+        }
+      }
+    }
+    return nbits;
+  }
+
+  // invoke f(base + idx) for each set bit idx
+  template <class F>
+  static void forEachSet(
+      AtomicBlockType const* blocks,
+      size_t nbits,
+      size_t base,
+      F& f,
+      std::memory_order order) {
+    for (size_t b = 0; b * kBitsPerBlock < nbits; ++b) {
+      BlockType x = blocks[b].load(order) & mask(b, 0, nbits);
+      while (x) {
+        f(base + b * kBitsPerBlock + findFirstSet(x) - 1);
+        x &= x - 1;
+      }
+    }
+  }
+
+  static size_t count(
+      AtomicBlockType const* blocks,
+      size_t nbits,
+      std::memory_order order) {
+    size_t result = 0;
+    for (size_t b = 0; b * kBitsPerBlock < nbits; ++b) {
+      result += popcount(BlockType(blocks[b].load(order) & mask(b, 0, nbits)));
+    }
+    return result;
+  }
+
+  static void
+  fill(AtomicBlockType* blocks, size_t nbits, bool value, std::memory_order o) {
+    for (size_t b = 0; b * kBitsPerBlock < nbits; ++b) {
+      blocks[b].store(value ? mask(b, 0, nbits) : 0, o);
+    }
+  }
+};
+
+} // namespace detail
+
 /**
  * An atomic bitset of fixed size (specified at compile time).
+ *
+ * Besides single-bit operations, it can be scanned a block (64 bits on most
+ * platforms) at a time.  Scans are not atomic as a whole: each block is read
+ * once, so bits changed concurrently may or may not be observed.
  */
 template <size_t N>
 class AtomicBitSet {
@@ -84,6 +205,52 @@ class AtomicBitSet {
    */
   bool operator[](size_t idx) const;
 
+  /**
+   * Return the index of the first set (or unset) bit at or after from, or
+   * size() if there is none.
+   */
+  size_t find_first_set(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst) const;
+  size_t find_first_unset(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst) const;
+
+  /**
+   * Atomically set the first unset bit at or after from, and return its
+   * index, or size() if all these bits are set.  This is the operation to
+   * claim a free slot when the bits track occupancy.
+   */
+  size_t set_first_unset(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst);
+
+  /**
+   * Invoke f(idx) for each set bit, in increasing order.
+   */
+  template <class F>
+  void for_each_set(
+      F&& f,
+      std::memory_order order = std::memory_order_seq_cst) const;
+
+  /**
+   * Return the number of set bits.
+   */
+  size_t count(std::memory_order order = std::memory_order_seq_cst) const;
+
+  bool any(std::memory_order order = std::memory_order_seq_cst) const {
+    return find_first_set(0, order) != N;
+  }
+  bool none(std::memory_order order = std::memory_order_seq_cst) const {
+    return !any(order);
+  }
+
+  /**
+   * Set all bits to true (or false) with one store per block.
+   */
+  void set_all(std::memory_order order = std::memory_order_seq_cst);
+  void reset_all(std::memory_order order = std::memory_order_seq_cst);
+
   /**
    * Return the size of the bitset.
    */
@@ -92,19 +259,11 @@ class AtomicBitSet {
   }
 
  private:
-  // Pick the largest lock-free type available
-#if (ATOMIC_LLONG_LOCK_FREE == 2)
-  typedef unsigned long long BlockType;
-#elif (ATOMIC_LONG_LOCK_FREE == 2)
-  typedef unsigned long BlockType;
-#else
-  // Even if not lock free, what can we do?
-  typedef unsigned int BlockType;
-#endif
-  typedef std::atomic<BlockType> AtomicBlockType;
+  typedef detail::AtomicBitSetBlocks Blocks;
+  typedef Blocks::BlockType BlockType;
+  typedef Blocks::AtomicBlockType AtomicBlockType;
 
-  static constexpr size_t kBitsPerBlock =
-      std::numeric_limits<BlockType>::digits;
+  static constexpr size_t kBitsPerBlock = Blocks::kBitsPerBlock;
 
   static constexpr size_t blockIndex(size_t bit) {
     return bit / kBitsPerBlock;
@@ -117,7 +276,7 @@ class AtomicBitSet {
   // avoid casts
   static constexpr BlockType kOne = 1;
 
-  std::array<AtomicBlockType, N> data_;
+  std::array<AtomicBlockType, Blocks::numBlocks(N)> data_;
 };
 
 // value-initialize to zero
@@ -126,14 +285,14 @@ inline AtomicBitSet<N>::AtomicBitSet() : data_() {}
 
 template <size_t N>
 inline bool AtomicBitSet<N>::set(size_t idx, std::memory_order order) {
-  assert(idx < N * kBitsPerBlock);
+  assert(idx < N);
   BlockType mask = kOne << bitOffset(idx);
   return data_[blockIndex(idx)].fetch_or(mask, order) & mask;
 }
 
 template <size_t N>
 inline bool AtomicBitSet<N>::reset(size_t idx, std::memory_order order) {
-  assert(idx < N * kBitsPerBlock);
+  assert(idx < N);
   BlockType mask = kOne << bitOffset(idx);
   return data_[blockIndex(idx)].fetch_and(~mask, order) & mask;
 }
@@ -146,7 +305,7 @@ AtomicBitSet<N>::set(size_t idx, bool value, std::memory_order order) {
 
 template <size_t N>
 inline bool AtomicBitSet<N>::test(size_t idx, std::memory_order order) const {
-  assert(idx < N * kBitsPerBlock);
+  assert(idx < N);
   BlockType mask = kOne << bitOffset(idx);
   return data_[blockIndex(idx)].load(order) & mask;
 }
@@ -156,4 +315,334 @@ inline bool AtomicBitSet<N>::operator[](size_t idx) const {
   return test(idx);
 }
 
+template <size_t N>
+inline size_t AtomicBitSet<N>::find_first_set(
+    size_t from,
+    std::memory_order order) const {
+  return Blocks::find(data_.data(), N, from, true, order);
+}
+
+template <size_t N>
+inline size_t AtomicBitSet<N>::find_first_unset(
+    size_t from,
+    std::memory_order order) const {
+  return Blocks::find(data_.data(), N, from, false, order);
+}
+
+template <size_t N>
+inline size_t AtomicBitSet<N>::set_first_unset(
+    size_t from,
+    std::memory_order order) {
+  return Blocks::setFirstUnset(data_.data(), N, from, order);
+}
+
+template <size_t N>
+template <class F>
+inline void AtomicBitSet<N>::for_each_set(F&& f, std::memory_order order)
+    const {
+  Blocks::forEachSet(data_.data(), N, 0, f, order);
+}
+
+template <size_t N>
+inline size_t AtomicBitSet<N>::count(std::memory_order order) const {
+  return Blocks::count(data_.data(), N, order);
+}
+
+template <size_t N>
+inline void AtomicBitSet<N>::set_all(std::memory_order order) {
+  Blocks::fill(data_.data(), N, true, order);
+}
+
+template <size_t N>
+inline void AtomicBitSet<N>::reset_all(std::memory_order order) {
+  Blocks::fill(data_.data(), N, false, order);
+}
+
+/**
+ * An atomic bitset that grows as bits are set.
+ *
+ * The blocks are allocated in segments of doubling size, each installed
+ * with a compare-and-swap the first time a bit in it is set, and freed
+ * only on destruction, so that no operation ever blocks or moves blocks.
+ * Bits in segments that were never allocated read as false.
+ */
+class DynamicAtomicBitSet {
+ public:
+  /**
+   * Construct an empty bitset, allocating room for at least reserveBits
+   * bits up front.
+   */
+  explicit DynamicAtomicBitSet(size_t reserveBits = 0);
+  ~DynamicAtomicBitSet();
+
+  DynamicAtomicBitSet(const DynamicAtomicBitSet&) = delete;
+  DynamicAtomicBitSet& operator=(const DynamicAtomicBitSet&) = delete;
+
+  /**
+   * As in AtomicBitSet.  set() allocates the segment of the bit if needed;
+   * reset() and test() never allocate.
+   */
+  bool set(size_t idx, std::memory_order order = std::memory_order_seq_cst);
+  bool reset(size_t idx, std::memory_order order = std::memory_order_seq_cst);
+  bool set(
+      size_t idx,
+      bool value,
+      std::memory_order order = std::memory_order_seq_cst) {
+    return value ? set(idx, order) : reset(idx, order);
+  }
+  bool test(size_t idx, std::memory_order order = std::memory_order_seq_cst)
+      const;
+  bool operator[](size_t idx) const {
+    return test(idx);
+  }
+
+  /**
+   * Return the index of the first set bit at or after from, or max_size()
+   * if there is none.
+   */
+  size_t find_first_set(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst) const;
+
+  /**
+   * Return the index of the first unset bit at or after from, which may be
+   * past the allocated segments.
+   */
+  size_t find_first_unset(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst) const;
+
+  /**
+   * Atomically set the first unset bit at or after from, allocating
+   * segments as needed, and return its index.
+   */
+  size_t set_first_unset(
+      size_t from = 0,
+      std::memory_order order = std::memory_order_seq_cst);
+
+  template <class F>
+  void for_each_set(
+      F&& f,
+      std::memory_order order = std::memory_order_seq_cst) const;
+
+  size_t count(std::memory_order order = std::memory_order_seq_cst) const;
+
+  /**
+   * Reset all the bits of the allocated segments.
+   */
+  void reset_all(std::memory_order order = std::memory_order_seq_cst);
+
+  /**
+   * Return the number of bits in the allocated segments.
+   */
+  size_t capacity() const;
+
+  static constexpr size_t max_size() {
+    return segmentBase(kMaxSegments) * kBitsPerBlock;
+  }
+
+ private:
+  typedef detail::AtomicBitSetBlocks Blocks;
+  typedef Blocks::BlockType BlockType;
+  typedef Blocks::AtomicBlockType AtomicBlockType;
+
+  static constexpr size_t kBitsPerBlock = Blocks::kBitsPerBlock;
+  static constexpr size_t kFirstSegmentBlocks = 4;
+  // enough for 2^48 bits on 64-bit platforms
+  static constexpr size_t kMaxSegments = sizeof(size_t) == 8 ? 40 : 24;
+
+  static constexpr size_t segmentBlocks(size_t segment) {
+    return kFirstSegmentBlocks << segment;
+  }
+  // index of the first block of the segment
+  static constexpr size_t segmentBase(size_t segment) {
+    return kFirstSegmentBlocks * ((size_t(1) << segment) - 1);
+  }
+  static size_t segmentOf(size_t block) {
+    return findLastSet(block / kFirstSegmentBlocks + 1) - 1;
+  }
+
+  AtomicBlockType* segment(size_t s, std::memory_order order) const {
+    return segments_[s].load(order);
+  }
+  AtomicBlockType* getOrAllocateSegment(size_t s);
+
+  // the block of bit idx, or nullptr if its segment isn't allocated
+  AtomicBlockType* blockOf(size_t idx) const;
+
+  std::array<std::atomic<AtomicBlockType*>, kMaxSegments> segments_{};
+};
+
+inline DynamicAtomicBitSet::DynamicAtomicBitSet(size_t reserveBits) {
+  assert(reserveBits <= max_size());
+  for (size_t s = 0; s < kMaxSegments &&
+       segmentBase(s) * kBitsPerBlock < reserveBits;
+       ++s) {
+    getOrAllocateSegment(s);
+  }
+}
+
+inline DynamicAtomicBitSet::~DynamicAtomicBitSet() {
+  for (auto& s : segments_) {
+    delete[] s.load(std::memory_order_relaxed);
+  }
+}
+
+inline DynamicAtomicBitSet::AtomicBlockType*
+DynamicAtomicBitSet::getOrAllocateSegment(size_t s) {
+  auto p = segment(s, std::memory_order_acquire);
+  if (p) {
+    return p;
+  }
+  // value-initialized to zero
+  auto fresh = new AtomicBlockType[segmentBlocks(s)]();
+  if (segments_[s].compare_exchange_strong(
+          p, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+    return fresh;
+  }
+  delete[] fresh;
+  return p;
+}
+
+inline DynamicAtomicBitSet::AtomicBlockType* DynamicAtomicBitSet::blockOf(
+    size_t idx) const {
+  size_t const block = idx / kBitsPerBlock;
+  size_t const s = segmentOf(block);
+  auto p = segment(s, std::memory_order_acquire);
+  return p ? p + (block - segmentBase(s)) : nullptr;
+}
+
+inline bool DynamicAtomicBitSet::set(size_t idx, std::memory_order order) {
+  assert(idx < max_size());
+  size_t const block = idx / kBitsPerBlock;
+  size_t const s = segmentOf(block);
+  auto p = getOrAllocateSegment(s) + (block - segmentBase(s));
+  BlockType mask = BlockType(1) << (idx % kBitsPerBlock);
+  return p->fetch_or(mask, order) & mask;
+}
+
+inline bool DynamicAtomicBitSet::reset(size_t idx, std::memory_order order) {
+  assert(idx < max_size());
+  auto p = blockOf(idx);
+  if (!p) {
+    return false;
+  }
+  BlockType mask = BlockType(1) << (idx % kBitsPerBlock);
+  return p->fetch_and(~mask, order) & mask;
+}
+
+inline bool DynamicAtomicBitSet::test(size_t idx, std::memory_order order)
+    const {
+  assert(idx < max_size());
+  auto p = blockOf(idx);
+  BlockType mask = BlockType(1) << (idx % kBitsPerBlock);
+  return p && (p->load(order) & mask);
+}
+
+inline size_t DynamicAtomicBitSet::find_first_set(
+    size_t from,
+    std::memory_order order) const {
+  if (from >= max_size()) {
+    return max_size();
+  }
+  for (size_t s = segmentOf(from / kBitsPerBlock); s < kMaxSegments; ++s) {
+    auto p = segment(s, std::memory_order_acquire);
+    if (!p) {
+      continue;
+    }
+    size_t const base = segmentBase(s) * kBitsPerBlock;
+    size_t const nbits = segmentBlocks(s) * kBitsPerBlock;
+    size_t const start = from > base ? from - base : 0;
+    size_t const idx = Blocks::find(p, nbits, start, true, order);
+    if (idx != nbits) {
+      return base + idx;
+    }
+  }
+  return max_size();
+}
+
+inline size_t DynamicAtomicBitSet::find_first_unset(
+    size_t from,
+    std::memory_order order) const {
+  if (from >= max_size()) {
+    return max_size();
+  }
+  for (size_t s = segmentOf(from / kBitsPerBlock); s < kMaxSegments; ++s) {
+    size_t const base = segmentBase(s) * kBitsPerBlock;
+    size_t const start = from > base ? from - base : 0;
+    auto p = segment(s, std::memory_order_acquire);
+    if (!p) {
+      return base + start;
+    }
+    size_t const nbits = segmentBlocks(s) * kBitsPerBlock;
+    size_t const idx = Blocks::find(p, nbits, start, false, order);
+    if (idx != nbits) {
+      return base + idx;
+    }
+  }
+  return max_size();
+}
+
+inline size_t DynamicAtomicBitSet::set_first_unset(
+    size_t from,
+    std::memory_order order) {
+  if (from >= max_size()) {
+    return max_size();
+  }
+  for (size_t s = segmentOf(from / kBitsPerBlock); s < kMaxSegments; ++s) {
+    size_t const base = segmentBase(s) * kBitsPerBlock;
+    size_t const start = from > base ? from - base : 0;
+    size_t const nbits = segmentBlocks(s) * kBitsPerBlock;
+    size_t const idx =
+        Blocks::setFirstUnset(getOrAllocateSegment(s), nbits, start, order);
+    if (idx != nbits) {
+      return base + idx;
+    }
+  }
+  return max_size();
+}
+
+template <class F>
+inline void DynamicAtomicBitSet::for_each_set(F&& f, std::memory_order order)
+    const {
+  for (size_t s = 0; s < kMaxSegments; ++s) {
+    if (auto p = segment(s, std::memory_order_acquire)) {
+      Blocks::forEachSet(
+          p,
+          segmentBlocks(s) * kBitsPerBlock,
+          segmentBase(s) * kBitsPerBlock,
+          f,
+          order);
+    }
+  }
+}
+
+inline size_t DynamicAtomicBitSet::count(std::memory_order order) const {
+  size_t result = 0;
+  for (size_t s = 0; s < kMaxSegments; ++s) {
+    if (auto p = segment(s, std::memory_order_acquire)) {
+      result += Blocks::count(p, segmentBlocks(s) * kBitsPerBlock, order);
+    }
+  }
+  return result;
+}
+
+inline void DynamicAtomicBitSet::reset_all(std::memory_order order) {
+  for (size_t s = 0; s < kMaxSegments; ++s) {
+    if (auto p = segment(s, std::memory_order_acquire)) {
+      Blocks::fill(p, segmentBlocks(s) * kBitsPerBlock, false, order);
+    }
+  }
+}
+
+inline size_t DynamicAtomicBitSet::capacity() const {
+  size_t result = 0;
+  for (size_t s = 0; s < kMaxSegments; ++s) {
+    if (segment(s, std::memory_order_acquire)) {
+      result += segmentBlocks(s) * kBitsPerBlock;
+    }
+  }
+  return result;
+}
+
 } // namespace folly
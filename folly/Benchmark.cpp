@@ -19,6 +19,8 @@
 #include <folly/Benchmark.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -26,6 +28,7 @@
 #include <map>
 #include <memory>
 #include <numeric>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,6 +38,15 @@
 #include <folly/String.h>
 #include <folly/container/Foreach.h>
 #include <folly/json.h>
+#include <folly/portability/Sched.h>
+#include <folly/synchronization/Baton.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -67,9 +79,26 @@ DEFINE_int32(
     1,
     "Maximum # of seconds we'll spend on each benchmark.");
 
+DEFINE_bool(
+    bm_perf_counters,
+    false,
+    "Collect hardware performance counters (Linux only) and report "
+    "percentiles of the time per iteration across epochs.");
+
+DEFINE_int32(
+    bm_cpu,
+    -1,
+    "Pin benchmarks to this CPU (Linux only), or -1 to leave them unpinned.");
+
+DEFINE_bool(
+    bm_mt_pin,
+    false,
+    "Pin thread i of multi-threaded benchmarks to CPU i (Linux only).");
+
 namespace folly {
 
 std::chrono::high_resolution_clock::duration BenchmarkSuspender::timeSpent;
+void (*BenchmarkSuspender::countersHook)(bool) = nullptr;
 
 typedef function<detail::TimeIterData(unsigned int)> BenchmarkFun;
 
@@ -113,9 +142,238 @@ void detail::addBenchmarkImpl(
   benchmarks().push_back({file, name, std::move(fun), useCounter});
 }
 
+namespace {
+
+/**
+ * A group of hardware counters for the calling thread, in user mode only:
+ * cycles, instructions, last level cache misses and branch misses, in the
+ * order of the fields of BenchmarkPerfStats. Counters the kernel or the
+ * hardware do not support read as NaN.
+ */
+class PerfCounterGroup {
+ public:
+  static constexpr size_t kNumCounters = 4;
+  using Values = std::array<double, kNumCounters>;
+
+  PerfCounterGroup() {
+    index_.fill(-1);
+#ifdef __linux__
+    static constexpr uint64_t kEvents[kNumCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (size_t i = 0; i < kNumCounters; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kEvents[i];
+      // The group is enabled and disabled through its leader.
+      attr.disabled = fds_.empty();
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+          PERF_FORMAT_TOTAL_TIME_RUNNING;
+      auto fd = int(syscall(
+          __NR_perf_event_open,
+          &attr,
+          0,
+          -1,
+          fds_.empty() ? -1 : fds_[0],
+          0));
+      if (fd >= 0) {
+        index_[i] = int(fds_.size());
+        fds_.push_back(fd);
+      }
+    }
+#endif
+    if (fds_.empty()) {
+      std::cerr << "WARNING: hardware performance counters are not available"
+                << std::endl;
+    }
+  }
+
+  PerfCounterGroup(const PerfCounterGroup&) = delete;
+  PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+  ~PerfCounterGroup() {
+#ifdef __linux__
+    for (auto fd : fds_) {
+      close(fd);
+    }
+#endif
+  }
+
+  void start() {
+    startSample_ = sample();
+    depth_ = 0;
+    enable(true);
+  }
+
+  Values stop() {
+    enable(false);
+    auto end = sample();
+    Values values;
+    values.fill(std::numeric_limits<double>::quiet_NaN());
+    auto running = end[kRunning] - startSample_[kRunning];
+    if (running == 0) {
+      return values;
+    }
+    // The kernel multiplexes counters when there are more events than
+    // hardware registers; extrapolate to the whole time enabled.
+    auto scale = double(end[kEnabled] - startSample_[kEnabled]) / running;
+    for (size_t i = 0; i < kNumCounters; ++i) {
+      if (index_[i] >= 0) {
+        auto slot = kValues + size_t(index_[i]);
+        values[i] = double(end[slot] - startSample_[slot]) * scale;
+      }
+    }
+    return values;
+  }
+
+  /**
+   * Pauses counting while a BenchmarkSuspender is active. Suspenders may
+   * nest, so only the outermost one has an effect.
+   */
+  void suspend(bool suspend) {
+    if (suspend ? depth_++ == 0 : --depth_ == 0) {
+      enable(!suspend);
+    }
+  }
+
+ private:
+  // Layout of a PERF_FORMAT_GROUP read.
+  enum : size_t { kNr, kEnabled, kRunning, kValues };
+  using Sample = std::array<uint64_t, kValues + kNumCounters>;
+
+  void enable(bool enable) {
+#ifdef __linux__
+    if (!fds_.empty()) {
+      ioctl(
+          fds_[0],
+          enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE,
+          PERF_IOC_FLAG_GROUP);
+    }
+#else
+    (void)enable;
+#endif
+  }
+
+  Sample sample() const {
+    Sample sample{};
+#ifdef __linux__
+    if (!fds_.empty() && read(fds_[0], sample.data(), sizeof(sample)) < 0) {
+      sample = {};
+    }
+#endif
+    return sample;
+  }
+
+  std::vector<int> fds_;
+  // Position of each counter in the group, or -1 if it could not be opened.
+  std::array<int, kNumCounters> index_;
+  Sample startSample_{};
+  size_t depth_{0};
+};
+
+PerfCounterGroup& perfCounters() {
+  static PerfCounterGroup counters;
+  return counters;
+}
+
+void suspendPerfCounters(bool suspend) {
+  perfCounters().suspend(suspend);
+}
+
+double percentile(std::vector<double>& samples, double p) {
+  CHECK(!samples.empty());
+  // Nearest-rank percentile.
+  auto rank = size_t(std::ceil(p * samples.size()));
+  auto nth = samples.begin() + std::max<size_t>(rank, 1) - 1;
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+void pinToCpu(int cpu) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  if (sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+    LOG(ERROR) << "sched_setaffinity failed with error " << errno << ", "
+               << errnoStr(errno);
+  }
+#else
+  (void)cpu;
+  std::cerr << "WARNING: --bm_cpu is not supported on this platform"
+            << std::endl;
+#endif
+}
+
+} // namespace
+
+unsigned detail::runBenchmarkThreads(
+    size_t threads,
+    unsigned iters,
+    const std::function<void(unsigned, size_t)>& body,
+    UserCounters& counters) {
+  using std::chrono::steady_clock;
+  CHECK(threads > 0);
+
+  BenchmarkSuspender suspender;
+  std::atomic<size_t> ready{0};
+  std::atomic<size_t> done{0};
+  std::atomic<bool> go{false};
+  Baton<> allReady;
+  Baton<> allDone;
+  std::vector<steady_clock::duration> elapsed(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      if (FLAGS_bm_mt_pin) {
+        pinToCpu(int(i % std::max(1u, std::thread::hardware_concurrency())));
+      }
+      if (ready.fetch_add(1) + 1 == threads) {
+        allReady.post();
+      }
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      auto start = steady_clock::now();
+      body(iters, i);
+      elapsed[i] = steady_clock::now() - start;
+      if (done.fetch_add(1) + 1 == threads) {
+        allDone.post();
+      }
+    });
+  }
+
+  // Thread creation and teardown are not measured.
+  allReady.wait();
+  suspender.dismiss();
+  go.store(true, std::memory_order_release);
+  allDone.wait();
+  suspender.rehire();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto minmax = std::minmax_element(elapsed.begin(), elapsed.end());
+  if (minmax.second->count() > 0) {
+    counters["imbalance%"] =
+        100 * (*minmax.second - *minmax.first).count() / minmax.second->count();
+  }
+  return unsigned(std::min<uint64_t>(
+      uint64_t(iters) * threads, std::numeric_limits<unsigned>::max()));
+}
+
 static std::pair<double, UserCounters> runBenchmarkGetNSPerIteration(
     const BenchmarkFun& fun,
-    const double globalBaseline) {
+    const double globalBaseline,
+    detail::BenchmarkPerfStats* perf = nullptr) {
   using std::chrono::duration_cast;
   using std::chrono::high_resolution_clock;
   using std::chrono::microseconds;
@@ -145,10 +403,24 @@ static std::pair<double, UserCounters> runBenchmarkGetNSPerIteration(
   std::vector<std::pair<double, UserCounters>> epochResults(epochs);
   size_t actualEpochs = 0;
 
+  // With --bm_perf_counters, the time and hardware counters per iteration
+  // of every measured epoch.
+  std::vector<double> epochTimes;
+  std::vector<PerfCounterGroup::Values> epochCounters;
+
   for (; actualEpochs < epochs; ++actualEpochs) {
     const auto maxIters = uint32_t(FLAGS_bm_max_iters);
     for (auto n = uint32_t(FLAGS_bm_min_iters); n < maxIters; n *= 2) {
+      PerfCounterGroup::Values counters;
+      if (perf) {
+        BenchmarkSuspender::countersHook = suspendPerfCounters;
+        perfCounters().start();
+      }
       detail::TimeIterData timeIterData = fun(static_cast<unsigned int>(n));
+      if (perf) {
+        counters = perfCounters().stop();
+        BenchmarkSuspender::countersHook = nullptr;
+      }
       if (timeIterData.duration < minNanoseconds) {
         continue;
       }
@@ -158,6 +430,13 @@ static std::pair<double, UserCounters> runBenchmarkGetNSPerIteration(
       epochResults[actualEpochs] = std::make_pair(
           max(0.0, double(nsecs.count()) / timeIterData.niter - globalBaseline),
           std::move(timeIterData.userCounters));
+      if (perf) {
+        epochTimes.push_back(epochResults[actualEpochs].first);
+        for (auto& counter : counters) {
+          counter /= timeIterData.niter;
+        }
+        epochCounters.push_back(counters);
+      }
       // Done with the current epoch, we got a meaningful timing.
       break;
     }
@@ -169,6 +448,28 @@ static std::pair<double, UserCounters> runBenchmarkGetNSPerIteration(
     }
   }
 
+  if (perf && !epochTimes.empty()) {
+    perf->epochs = epochTimes.size();
+    perf->p50InNs = percentile(epochTimes, 0.5);
+    perf->p90InNs = percentile(epochTimes, 0.9);
+    perf->p99InNs = percentile(epochTimes, 0.99);
+    double* fields[] = {&perf->cycles,
+                        &perf->instructions,
+                        &perf->cacheMisses,
+                        &perf->branchMisses};
+    std::vector<double> samples;
+    for (size_t i = 0; i < PerfCounterGroup::kNumCounters; ++i) {
+      samples.clear();
+      for (auto const& counters : epochCounters) {
+        if (!std::isnan(counters[i])) {
+          samples.push_back(counters[i]);
+        }
+      }
+      *fields[i] = samples.empty() ? std::numeric_limits<double>::quiet_NaN()
+                                   : percentile(samples, 0.5);
+    }
+  }
+
   // Current state of the art: get the minimum. After some
   // experimentation, it seems taking the minimum is the best.
   auto iter = min_element(
@@ -344,10 +645,34 @@ class BenchmarkResultsPrinter {
         }
       }
       printf("\n");
+      if (datum.perf.epochs != 0) {
+        printPerfStats(datum.perf);
+      }
     }
   }
 
  private:
+  static void printPerfStats(const detail::BenchmarkPerfStats& perf) {
+    printf(
+        "    p50 %s  p90 %s  p99 %s",
+        readableTime(perf.p50InNs / 1E9, 2).c_str(),
+        readableTime(perf.p90InNs / 1E9, 2).c_str(),
+        readableTime(perf.p99InNs / 1E9, 2).c_str());
+    auto counter = [](const char* name, double value) {
+      if (!std::isnan(value)) {
+        printf("  %s %s", name, metricReadable(value, 2).c_str());
+      }
+    };
+    counter("cycles", perf.cycles);
+    counter("instrs", perf.instructions);
+    if (perf.cycles > 0 && !std::isnan(perf.instructions)) {
+      printf("  IPC %.2f", perf.instructions / perf.cycles);
+    }
+    counter("cache-misses", perf.cacheMisses);
+    counter("branch-misses", perf.branchMisses);
+    printf("\n");
+  }
+
   std::set<std::string> counterNames_;
   size_t namesLength_{0};
   double baselineNsPerIter_{numeric_limits<double>::max()};
@@ -519,6 +844,10 @@ void runBenchmarks() {
     bmRegex = std::make_unique<boost::regex>(FLAGS_bm_regex);
   }
 
+  if (FLAGS_bm_cpu >= 0) {
+    pinToCpu(FLAGS_bm_cpu);
+  }
+
   // PLEASE KEEP QUIET. MEASUREMENTS IN PROGRESS.
 
   size_t baselineIndex = getGlobalBenchmarkBaselineIndex();
@@ -537,21 +866,26 @@ void runBenchmarks() {
       continue;
     }
     std::pair<double, UserCounters> elapsed;
+    detail::BenchmarkPerfStats perf;
     auto& bm = benchmarks()[i];
     if (bm.name != "-") { // skip separators
       if (bmRegex && !boost::regex_search(bm.name, *bmRegex)) {
         continue;
       }
-      elapsed = runBenchmarkGetNSPerIteration(bm.func, globalBaseline.first);
+      elapsed = runBenchmarkGetNSPerIteration(
+          bm.func,
+          globalBaseline.first,
+          FLAGS_bm_perf_counters ? &perf : nullptr);
     }
 
     // if customized user counters is used, it cannot print the result in real
     // time as it needs to run all cases first to know the complete set of
     // counters have been used, then the header can be printed out properly
     if (!FLAGS_json_verbose && !FLAGS_json && !useCounter) {
-      printer.print({{bm.file, bm.name, elapsed.first, elapsed.second}});
+      printer.print({{bm.file, bm.name, elapsed.first, elapsed.second, perf}});
     } else {
-      results.push_back({bm.file, bm.name, elapsed.first, elapsed.second});
+      results.push_back(
+          {bm.file, bm.name, elapsed.first, elapsed.second, perf});
     }
 
     // get all counter names
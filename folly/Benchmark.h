@@ -23,10 +23,12 @@
 #include <folly/functional/Invoke.h>
 #include <folly/portability/GFlags.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <functional>
 #include <limits>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
 
@@ -83,11 +85,28 @@ struct BenchmarkRegistration {
   bool useCounter = false;
 };
 
+/**
+ * Extra statistics collected with --bm_perf_counters: percentiles of the
+ * time per iteration across epochs, and hardware counters per iteration
+ * (median across epochs, NaN if the counter is not available).
+ */
+struct BenchmarkPerfStats {
+  size_t epochs{0};
+  double p50InNs{0};
+  double p90InNs{0};
+  double p99InNs{0};
+  double cycles{0};
+  double instructions{0};
+  double cacheMisses{0};
+  double branchMisses{0};
+};
+
 struct BenchmarkResult {
   std::string file;
   std::string name;
   double timeInNs;
   UserCounters counters;
+  BenchmarkPerfStats perf{};
 };
 
 /**
@@ -100,6 +119,18 @@ void addBenchmarkImpl(
     BenchmarkFun,
     bool useCounter);
 
+/**
+ * Runs body(iters, thread) on the given number of threads and returns the
+ * total number of iterations. Only the time between the threads being
+ * released together and the last one finishing is measured. Used by
+ * addBenchmarkMT.
+ */
+unsigned runBenchmarkThreads(
+    size_t threads,
+    unsigned iters,
+    const std::function<void(unsigned, size_t)>& body,
+    UserCounters& counters);
+
 } // namespace detail
 
 /**
@@ -112,6 +143,7 @@ struct BenchmarkSuspender {
 
   BenchmarkSuspender() {
     start = Clock::now();
+    suspendCounters(true);
   }
 
   BenchmarkSuspender(const BenchmarkSuspender&) = delete;
@@ -123,6 +155,7 @@ struct BenchmarkSuspender {
   BenchmarkSuspender& operator=(const BenchmarkSuspender&) = delete;
   BenchmarkSuspender& operator=(BenchmarkSuspender&& rhs) {
     if (start != TimePoint{}) {
+      suspendCounters(false);
       tally();
     }
     start = rhs.start;
@@ -132,12 +165,14 @@ struct BenchmarkSuspender {
 
   ~BenchmarkSuspender() {
     if (start != TimePoint{}) {
+      suspendCounters(false);
       tally();
     }
   }
 
   void dismiss() {
     assert(start != TimePoint{});
+    suspendCounters(false);
     tally();
     start = {};
   }
@@ -145,6 +180,7 @@ struct BenchmarkSuspender {
   void rehire() {
     assert(start == TimePoint{});
     start = Clock::now();
+    suspendCounters(true);
   }
 
   template <class F>
@@ -169,7 +205,19 @@ struct BenchmarkSuspender {
    */
   static Duration timeSpent;
 
+  /**
+   * Set by runBenchmarks() while hardware counters are being collected
+   * (--bm_perf_counters), so that suspended code is not counted either.
+   */
+  static void (*countersHook)(bool suspend);
+
  private:
+  static void suspendCounters(bool suspend) {
+    if (countersHook) {
+      countersHook(suspend);
+    }
+  }
+
   void tally() {
     auto end = Clock::now();
     timeSpent += end - start;
@@ -264,6 +312,51 @@ addBenchmark(const char* file, const char* name, Lambda&& lambda) {
   });
 }
 
+/**
+ * Adds a multi-threaded benchmark. Usually not called directly but
+ * instead through the macros BENCHMARK_MT and BENCHMARK_MT_SCALING
+ * defined below. The lambda takes the number of iterations to run and
+ * the index of the calling thread, and is run concurrently on each of the
+ * given number of threads; the reported time per iteration is the wall
+ * time divided by the total number of iterations across threads.
+ */
+template <typename Lambda>
+void addBenchmarkMT(
+    const char* file,
+    const std::string& name,
+    size_t threads,
+    Lambda&& lambda) {
+  std::function<void(unsigned, size_t)> body(std::forward<Lambda>(lambda));
+  addBenchmark(
+      file, name.c_str(), [=](UserCounters& counters, unsigned int iters) {
+        return detail::runBenchmarkThreads(threads, iters, body, counters);
+      });
+}
+
+/**
+ * Adds the same multi-threaded benchmark for 1, 2, 4, ... threads up to
+ * maxThreads. Each run is relative to the single-threaded one, so the
+ * relative column reads as the throughput scaling curve.
+ */
+template <typename Lambda>
+void addBenchmarkMTScaling(
+    const char* file,
+    const std::string& name,
+    size_t maxThreads,
+    const Lambda& lambda) {
+  for (size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    addBenchmarkMT(
+        file,
+        (threads == 1 ? "" : "%") + name + "(" + std::to_string(threads) +
+            "t)",
+        threads,
+        lambda);
+    if (threads >= maxThreads) {
+      break;
+    }
+  }
+}
+
 /**
  * Call doNotOptimizeAway(var) to ensure that var will be computed even
  * post-optimization.  Use it for variables that are computed during
@@ -655,6 +748,43 @@ void printResultComparison(
     return name(iters, ##__VA_ARGS__);                              \
   }
 
+/**
+ * Introduces a multi-threaded benchmark. The body runs concurrently on
+ * the given number of threads, which are created beforehand and released
+ * together; each runs iters iterations and knows its index in
+ * [0, threads) as thread. Pass --bm_mt_pin to pin thread i to CPU i.
+ *
+ * The per-thread times are summarized in the imbalance% counter, the
+ * difference between the slowest and the fastest thread relative to the
+ * slowest. BENCHMARK_SUSPEND may not be used in the body, and hardware
+ * counters (--bm_perf_counters) only cover the thread running the
+ * benchmarks. Example:
+ *
+ * BENCHMARK_MT(sharedCounter, 4, iters, thread) {
+ *   FOR_EACH_RANGE (i, 0, iters) {
+ *     counter.fetch_add(1);
+ *   }
+ * }
+ */
+#define BENCHMARK_MT(name, threads, iters, thread)                             \
+  static void name(unsigned, size_t);                                          \
+  FOLLY_MAYBE_UNUSED static bool FB_ANONYMOUS_VARIABLE(follyBenchmarkUnused) = \
+      (::folly::addBenchmarkMT(__FILE__, FB_STRINGIZE(name), threads, &name),  \
+       true);                                                                  \
+  static void name(unsigned iters, FOLLY_MAYBE_UNUSED size_t thread)
+
+/**
+ * Like BENCHMARK_MT, but runs the benchmark with 1, 2, 4, ... threads up
+ * to maxThreads, reporting each one relative to the single-threaded run.
+ */
+#define BENCHMARK_MT_SCALING(name, maxThreads, iters, thread)                 \
+  static void name(unsigned, size_t);                                          \
+  FOLLY_MAYBE_UNUSED static bool FB_ANONYMOUS_VARIABLE(follyBenchmarkUnused) = \
+      (::folly::addBenchmarkMTScaling(                                         \
+           __FILE__, FB_STRINGIZE(name), maxThreads, &name),                   \
+       true);                                                                  \
+  static void name(unsigned iters, FOLLY_MAYBE_UNUSED size_t thread)
+
 /**
  * Draws a line of dashes.
  */
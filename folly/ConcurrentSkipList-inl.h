@@ -30,6 +30,7 @@
 #include <boost/random.hpp>
 #include <glog/logging.h>
 
+#include <folly/CPortability.h>
 #include <folly/Memory.h>
 #include <folly/ThreadLocal.h>
 #include <folly/synchronization/MicroSpinLock.h>
@@ -40,6 +41,16 @@ namespace detail {
 template <typename ValT, typename NodeT>
 class csl_iterator;
 
+// Only a hint: prefetching a node that is being removed is harmless.
+template <typename NodeT>
+FOLLY_ALWAYS_INLINE void prefetchSkipListNode(NodeT const* node) {
+#ifndef _WIN32
+  __builtin_prefetch(static_cast<void const*>(node));
+#else
+  (void)node;
+#endif
+}
+
 template <typename T>
 class SkipListNode {
   enum : uint16_t {
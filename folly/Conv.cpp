@@ -16,12 +16,52 @@
 
 #include <folly/Conv.h>
 #include <array>
+#include <cmath>
+#include <cstring>
+
+#include <folly/lang/Bits.h>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define FOLLY_CONV_DTOA_TO_CHARS 1
+#else
+#define FOLLY_CONV_DTOA_TO_CHARS 0
+#endif
 
 namespace folly {
 namespace detail {
 
 namespace {
 
+/**
+ * The bytes of `chunk`, 8 characters loaded little-endian, which aren't
+ * ASCII digits have non-zero bytes in the result. A byte of 0xfa or more
+ * carries into the next byte, so only the lowest non-zero byte is exact.
+ */
+inline uint64_t nonDigitBytes(uint64_t chunk) {
+  constexpr uint64_t kHigh = 0xf0f0f0f0f0f0f0f0;
+  constexpr uint64_t kZeros = 0x3030303030303030;
+  constexpr uint64_t kSixes = 0x0606060606060606;
+  // '0' - '9' are 0x30 - 0x39, so both the byte and the byte + 6 are 0x3?
+  return ((chunk & kHigh) ^ kZeros) | (((chunk + kSixes) & kHigh) ^ kZeros);
+}
+
+/**
+ * Parses 8 ASCII digits loaded little-endian, with SWAR: adjacent digits,
+ * then pairs, then quads are combined with one multiplication each.
+ */
+inline uint32_t parseEightDigits(uint64_t chunk) {
+  chunk -= 0x3030303030303030;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000ff000000ff) * (100 + (1000000ULL << 32))) +
+           (((chunk >> 16) & 0x000000ff000000ff) * (1 + (10000ULL << 32)))) >>
+      32;
+  return uint32_t(chunk);
+}
+
 /**
  * Finds the first non-digit in a string. The number of digits
  * searched depends on the precision of the Tgt integral. Assumes the
@@ -32,10 +72,19 @@ namespace {
  *     if (b >= e || !isdigit(*b)) return b;
  *   }
  *
- *  Complete unrolling marks bottom-line (i.e. entire conversion)
- *  improvements of 20%.
+ * Checks 8 characters at a time where it can.
  */
 inline const char* findFirstNonDigit(const char* b, const char* e) {
+  if (kIsLittleEndian) {
+    for (; e - b >= 8; b += 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, b, sizeof(chunk));
+      auto const nonDigits = nonDigitBytes(chunk);
+      if (nonDigits != 0) {
+        return b + (findFirstSet(nonDigits) - 1) / 8;
+      }
+    }
+  }
   for (; b < e; ++b) {
     auto const c = static_cast<unsigned>(*b) - '0';
     if (c >= 10) {
@@ -574,6 +623,17 @@ inline Expected<Tgt, ConversionCode> digits_to(
 
   UT result = 0;
 
+  if (kIsLittleEndian && std::numeric_limits<UT>::digits10 >= 8) {
+    for (; e - b >= 8; b += 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, b, sizeof(chunk));
+      if (nonDigitBytes(chunk) != 0) {
+        break; // the loops below report it
+      }
+      result = UT(result * 100000000 + parseEightDigits(chunk));
+    }
+  }
+
   for (; e - b >= 4; b += 4) {
     result *= static_cast<UT>(10000);
     const int32_t r0 = shift1000[static_cast<size_t>(b[0])];
@@ -761,6 +821,157 @@ template Expected<unsigned __int128, ConversionCode>
 str_to_integral<unsigned __int128>(StringPiece* src) noexcept;
 #endif
 
+namespace {
+
+// Lays out the shortest digits of a value, which is
+// 0.digits * 10^decimalPoint, the way DoubleToStringConverter::ToShortest()
+// does with `format`. Returns 0 if it doesn't fit in `size`.
+size_t formatShortest(
+    bool negative,
+    const char* digits,
+    int length,
+    int decimalPoint,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format) {
+  int const exponent = decimalPoint - 1;
+  bool const decimal = format.decimalInShortestLow <= exponent &&
+      exponent < format.decimalInShortestHigh;
+  // sign, leading "0." or trailing zeros, point, exponent
+  size_t const needed = 1 + size_t(length) + 8 +
+      (decimal ? size_t(std::abs(decimalPoint)) + 2 : 0);
+  if (needed > size) {
+    return 0;
+  }
+
+  char* out = buffer;
+  if (negative) {
+    *out++ = '-';
+  }
+  if (!decimal) {
+    *out++ = digits[0];
+    if (length > 1) {
+      *out++ = '.';
+      std::memcpy(out, digits + 1, size_t(length - 1));
+      out += length - 1;
+    }
+    *out++ = format.exponentCharacter;
+    unsigned e = unsigned(exponent);
+    if (exponent < 0) {
+      *out++ = '-';
+      e = unsigned(-exponent);
+    } else if (format.emitPositiveExponentSign) {
+      *out++ = '+';
+    }
+    out += uint64ToBufferUnsafe(e, out);
+  } else if (decimalPoint <= 0) {
+    *out++ = '0';
+    *out++ = '.';
+    std::memset(out, '0', size_t(-decimalPoint));
+    out += -decimalPoint;
+    std::memcpy(out, digits, size_t(length));
+    out += length;
+  } else if (decimalPoint >= length) {
+    std::memcpy(out, digits, size_t(length));
+    out += length;
+    std::memset(out, '0', size_t(decimalPoint - length));
+    out += decimalPoint - length;
+    if (format.emitTrailingDecimalPoint) {
+      *out++ = '.';
+    }
+  } else {
+    std::memcpy(out, digits, size_t(decimalPoint));
+    out += decimalPoint;
+    *out++ = '.';
+    std::memcpy(out, digits + decimalPoint, size_t(length - decimalPoint));
+    out += length - decimalPoint;
+  }
+  return size_t(out - buffer);
+}
+
+template <class Src>
+size_t dtoaShortestImpl(
+    Src value,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format) {
+#if FOLLY_CONV_DTOA_TO_CHARS
+  if (!std::isfinite(value)) {
+    // Like double-conversion, NaN never has a sign
+    bool const negative = std::isinf(value) && value < 0;
+    const char* symbol =
+        std::isnan(value) ? format.nanSymbol : format.infinitySymbol;
+    size_t const length = std::strlen(symbol);
+    if (length + 1 > size) {
+      return 0;
+    }
+    buffer[0] = '-';
+    std::memcpy(buffer + (negative ? 1 : 0), symbol, length);
+    return length + (negative ? 1 : 0);
+  }
+
+  // std::to_chars() finds the shortest digits which round-trip (with Ryu,
+  // in libstdc++ and the MSVC STL) without allocating; parse its scientific
+  // output, d[.ddd]e[+-]xx, and lay out the digits as double-conversion does.
+  char scientific[32];
+  auto const result = std::to_chars(
+      scientific,
+      scientific + sizeof(scientific),
+      value,
+      std::chars_format::scientific);
+  if (result.ec != std::errc()) {
+    return 0;
+  }
+  const char* p = scientific;
+  bool const negative = *p == '-';
+  if (negative) {
+    ++p;
+  }
+  char digits[std::numeric_limits<Src>::max_digits10 + 1];
+  int length = 0;
+  for (; *p != 'e'; ++p) {
+    if (*p != '.') {
+      digits[length++] = *p;
+    }
+  }
+  ++p; // 'e'
+  bool const negativeExponent = *p++ == '-';
+  int exponent = 0;
+  for (; p != result.ptr; ++p) {
+    exponent = exponent * 10 + (*p - '0');
+  }
+  if (negativeExponent) {
+    exponent = -exponent;
+  }
+  return formatShortest(
+      negative, digits, length, exponent + 1, buffer, size, format);
+#else
+  (void)value;
+  (void)buffer;
+  (void)size;
+  (void)format;
+  return 0;
+#endif
+}
+
+} // namespace
+
+size_t dtoaShortest(
+    double value,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format) {
+  return dtoaShortestImpl(value, buffer, size, format);
+}
+
+size_t dtoaShortest(
+    float value,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format) {
+  return dtoaShortestImpl(value, buffer, size, format);
+}
+
 } // namespace detail
 
 ConversionError makeConversionError(ConversionCode code, StringPiece input) {
@@ -110,6 +110,7 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <double-conversion/double-conversion.h> // V8 JavaScript implementation
 
@@ -742,6 +743,49 @@ estimateSpaceNeeded(Src value) {
 namespace detail {
 constexpr int kConvMaxDecimalInShortestLow = -6;
 constexpr int kConvMaxDecimalInShortestHigh = 21;
+
+/**
+ * The DoubleToStringConverter parameters and flags which affect
+ * ToShortest(), with the same meaning.
+ */
+struct DtoaShortestFormat {
+  const char* infinitySymbol;
+  const char* nanSymbol;
+  char exponentCharacter;
+  int decimalInShortestLow;
+  int decimalInShortestHigh;
+  bool emitPositiveExponentSign;
+  bool emitTrailingDecimalPoint;
+};
+
+constexpr DtoaShortestFormat kConvDtoaShortestFormat{
+    "Infinity",
+    "NaN",
+    'E',
+    kConvMaxDecimalInShortestLow,
+    kConvMaxDecimalInShortestHigh,
+    false,
+    false,
+};
+
+/**
+ * Write the shortest representation of `value` which round-trips to
+ * `buffer`, exactly as DoubleToStringConverter::ToShortest() (or
+ * ToShortestSingle() for float) would with `format`, without allocating.
+ * Returns the length written, or 0 if the output doesn't fit in `size`
+ * bytes or the standard library has no floating point std::to_chars(), in
+ * which case the caller should use double-conversion.
+ */
+size_t dtoaShortest(
+    double value,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format);
+size_t dtoaShortest(
+    float value,
+    char* buffer,
+    size_t size,
+    DtoaShortestFormat const& format);
 } // namespace detail
 
 /** Wrapper around DoubleToStringConverter **/
@@ -754,6 +798,25 @@ toAppend(
     double_conversion::DoubleToStringConverter::DtoaMode mode,
     unsigned int numDigits) {
   using namespace double_conversion;
+  char buffer[256];
+  if (mode == DoubleToStringConverter::SHORTEST ||
+      mode == DoubleToStringConverter::SHORTEST_SINGLE) {
+    auto const length = mode == DoubleToStringConverter::SHORTEST
+        ? detail::dtoaShortest(
+              static_cast<double>(value),
+              buffer,
+              sizeof(buffer),
+              detail::kConvDtoaShortestFormat)
+        : detail::dtoaShortest(
+              static_cast<float>(value),
+              buffer,
+              sizeof(buffer),
+              detail::kConvDtoaShortestFormat);
+    if (length != 0) {
+      result->append(buffer, length);
+      return;
+    }
+  }
   DoubleToStringConverter conv(
       DoubleToStringConverter::NO_FLAGS,
       "Infinity",
@@ -763,7 +826,6 @@ toAppend(
       detail::kConvMaxDecimalInShortestHigh,
       6, // max leading padding zeros
       1); // max trailing padding zeros
-  char buffer[256];
   StringBuilder builder(buffer, sizeof(buffer));
   switch (mode) {
     case DoubleToStringConverter::SHORTEST:
@@ -1614,6 +1676,56 @@ Tgt to(StringPiece* src) {
           [=](Error e) { return makeConversionError(e, *src); });
 }
 
+/**
+ * Parse `input`, a list of integers separated by `delimiter` such as a CSV
+ * column, appending them to `out`, without splitting it into strings first.
+ * Each field is parsed as by to<Tgt>(StringPiece), and may have leading and
+ * trailing whitespace. An empty `input` is an empty list, an empty field is
+ * an error. On error, `out` holds the integers before the field which failed.
+ *
+ *   std::vector<int64_t> column;
+ *   folly::tryToDelimited(',', "1,-2, 3", column); // {1, -2, 3}
+ */
+template <class Tgt>
+typename std::enable_if<
+    std::is_integral<Tgt>::value && !std::is_same<Tgt, bool>::value,
+    Expected<Unit, ConversionCode>>::type
+tryToDelimited(char delimiter, StringPiece input, std::vector<Tgt>& out) {
+  if (input.empty()) {
+    return unit;
+  }
+  out.reserve(
+      out.size() + 1 +
+      size_t(std::count(input.begin(), input.end(), delimiter)));
+  // Whitespace around a field, which the delimiter itself may be
+  auto skipWhitespace = [&] {
+    while (!input.empty() && input.front() != delimiter &&
+           std::isspace(static_cast<unsigned char>(input.front()))) {
+      input.pop_front();
+    }
+  };
+  while (true) {
+    skipWhitespace();
+    if (UNLIKELY(!input.empty() && input.front() == delimiter)) {
+      // an empty field
+      return makeUnexpected(ConversionCode::NON_DIGIT_CHAR);
+    }
+    auto value = detail::str_to_integral<Tgt>(&input);
+    if (UNLIKELY(!value)) {
+      return makeUnexpected(value.error());
+    }
+    out.push_back(*value);
+    skipWhitespace();
+    if (input.empty()) {
+      return unit;
+    }
+    if (UNLIKELY(input.front() != delimiter)) {
+      return makeUnexpected(ConversionCode::NON_WHITESPACE_AFTER_END);
+    }
+    input.pop_front();
+  }
+}
+
 /*******************************************************************************
  * Enum to anything and back
  ******************************************************************************/
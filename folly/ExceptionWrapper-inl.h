@@ -642,6 +642,20 @@ inline bool exception_wrapper::with_exception_(This& this_, Fn fn_) {
   bool handled = true;
   auto fn = exception_wrapper_detail::catch_(
       static_cast<Ex*>(nullptr), std::move(fn_));
+  using Caught = std::remove_reference_t<arg_type<decltype(fn)>>;
+  // Exceptions not derived from std::exception are matched by rethrowing
+  // them below, unless the ABI lets us look the type up in the exception_ptr
+  if (!IsStdException<Caught>::value &&
+      !std::is_pointer<std::remove_cv_t<Caught>>::value &&
+      this_.has_exception_ptr() &&
+      exception_ptr_get_type(this_.eptr_.ptr_) != nullptr) {
+    auto object = exception_ptr_get_object(this_.eptr_.ptr_, &typeid(Caught));
+    if (object == nullptr) {
+      return false;
+    }
+    fn(*static_cast<Caught*>(object));
+    return true;
+  }
   auto&& all = [&](...) { handled = false; };
   handle_(IsStdException<arg_type<decltype(fn)>>{}, this_, fn, all);
   return handled;
@@ -51,6 +51,9 @@ exception_wrapper::VTable const exception_wrapper::SharedPtr::ops_{
 
 namespace {
 std::exception const* get_std_exception_(std::exception_ptr eptr) noexcept {
+  if (exception_ptr_get_type(eptr)) {
+    return exception_ptr_get_object<std::exception>(eptr);
+  }
   try {
     std::rethrow_exception(eptr);
   } catch (const std::exception& ex) {
@@ -66,6 +69,13 @@ exception_wrapper exception_wrapper::from_exception_ptr(
   if (!ptr) {
     return exception_wrapper();
   }
+  if (exception_ptr_get_type(ptr)) {
+    if (auto e = exception_ptr_get_object<std::exception>(ptr)) {
+      return exception_wrapper(ptr, *e);
+    }
+    Unknown uk;
+    return exception_wrapper(ptr, uk);
+  }
   try {
     std::rethrow_exception(ptr);
   } catch (std::exception& e) {
@@ -38,6 +38,7 @@
 #include <folly/Traits.h>
 #include <folly/Utility.h>
 #include <folly/lang/Assume.h>
+#include <folly/lang/Exception.h>
 
 #ifdef __GNUC__
 #pragma GCC diagnostic push
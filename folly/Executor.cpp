@@ -22,6 +22,12 @@
 
 namespace folly {
 
+void Executor::addBatch(Range<Func*> funcs) {
+  for (auto& func : funcs) {
+    add(std::move(func));
+  }
+}
+
 void Executor::addWithPriority(Func, int8_t /* priority */) {
   throw std::runtime_error(
       "addWithPriority() is not implemented for this Executor");
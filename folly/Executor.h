@@ -21,6 +21,7 @@
 #include <utility>
 
 #include <folly/Function.h>
+#include <folly/Range.h>
 #include <folly/Utility.h>
 
 namespace folly {
@@ -61,6 +62,11 @@ class Executor {
   /// variants must be threadsafe.
   virtual void add(Func) = 0;
 
+  /// Enqueue several functions, which are moved from.  Executors override
+  /// this to enqueue them together and wake up fewer threads; by default,
+  /// each one is add()ed.
+  virtual void addBatch(Range<Func*> funcs);
+
   /// Enqueue a function with a given priority, where 0 is the medium priority
   /// This is up to the implementation to enforce
   virtual void addWithPriority(Func, int8_t priority);
@@ -44,9 +44,12 @@
 #pragma once
 
 #include <array>
+#include <cassert>
 #include <cstdint>
+#include <vector>
 
 #include <folly/Range.h>
+#include <folly/lang/Bits.h>
 
 namespace folly {
 
@@ -91,12 +94,14 @@ FOLLY_DECLARE_FINGERPRINT_TABLES(128);
 
 } // namespace detail
 
+template <int BITS>
+class RollingFingerprint;
+
 /**
  * Compute the Rabin fingerprint.
  *
- * TODO(tudorb): Extend this to allow removing values from the computed
- * fingerprint (so we can fingerprint a sliding window, as in the Rabin-Karp
- * string matching algorithm)
+ * To fingerprint a sliding window (as in the Rabin-Karp string matching
+ * algorithm), use RollingFingerprint below.
  *
  * update* methods return *this, so you can chain them together:
  * Fingerprint<96>().update8(x).update(str).update64(val).write(output);
@@ -140,9 +145,13 @@ class Fingerprint {
   }
 
   Fingerprint& update(StringPiece str) {
-    // TODO(tudorb): We could be smart and do update64 or update32 if aligned
-    for (auto c : str) {
-      update8(uint8_t(c));
+    auto p = str.begin();
+    auto n = str.size();
+    for (; n >= 8; p += 8, n -= 8) {
+      update64(Endian::big(loadUnaligned<uint64_t>(p)));
+    }
+    for (; n > 0; ++p, --n) {
+      update8(uint8_t(*p));
     }
     return *this;
   }
@@ -169,6 +178,9 @@ class Fingerprint {
   }
 
  private:
+  template <int>
+  friend class RollingFingerprint;
+
   // XOR the fingerprint with a value from one of the tables.
   void xortab(std::array<uint64_t, detail::poly_size(BITS)> const& tab) {
     for (int i = 0; i < size(); i++) {
@@ -290,4 +302,123 @@ inline uint64_t Fingerprint<128>::shlor64(uint64_t v) {
   return out;
 }
 
+/**
+ * Rabin fingerprint of the last windowSize bytes added (a rolling hash).
+ *
+ * Unlike Fingerprint this starts from zero, so once the window is full the
+ * value depends only on the bytes inside it. Removing the oldest byte is a
+ * single lookup into a table of (byte * x^(8 * windowSize)) mod P, built at
+ * construction.
+ *
+ * Fingerprint<64>'s value at a position is not comparable with a
+ * RollingFingerprint<64>'s; compare rolling fingerprints with each other.
+ */
+template <int BITS>
+class RollingFingerprint {
+ public:
+  explicit RollingFingerprint(size_t windowSize);
+
+  /**
+   * Add a byte, dropping the oldest one once the window is full.
+   */
+  RollingFingerprint& roll(uint8_t in) {
+    if (count_ == window_.size()) {
+      uint8_t out = window_[pos_];
+      fp_.update8(in);
+      fp_.xortab(removeTable_[out]);
+    } else {
+      fp_.update8(in);
+      ++count_;
+    }
+    window_[pos_] = in;
+    if (++pos_ == window_.size()) {
+      pos_ = 0;
+    }
+    return *this;
+  }
+
+  RollingFingerprint& update(ByteRange data) {
+    for (auto c : data) {
+      roll(c);
+    }
+    return *this;
+  }
+
+  /**
+   * Empty the window.
+   */
+  void reset() {
+    for (int i = 0; i < Fingerprint<BITS>::size(); i++) {
+      fp_.fp_[i] = 0;
+    }
+    count_ = 0;
+    pos_ = 0;
+  }
+
+  size_t windowSize() const {
+    return window_.size();
+  }
+
+  // true once windowSize() bytes have been added since the last reset
+  bool full() const {
+    return count_ == window_.size();
+  }
+
+  /**
+   * The 64 most significant bits of the fingerprint.
+   */
+  uint64_t high64() const {
+    return fp_.fp_[0];
+  }
+
+  /**
+   * Write the fingerprint to an array of Fingerprint<BITS>::size()
+   * uint64_t's, in the same layout as Fingerprint::write().
+   */
+  void write(uint64_t* out) const {
+    fp_.write(out);
+  }
+
+ private:
+  using Poly = std::array<uint64_t, detail::poly_size(BITS)>;
+
+  Fingerprint<BITS> fp_;
+  std::vector<uint8_t> window_;
+  size_t count_{0};
+  size_t pos_{0};
+  std::array<Poly, 256> removeTable_;
+};
+
+template <int BITS>
+RollingFingerprint<BITS>::RollingFingerprint(size_t windowSize)
+    : window_(windowSize) {
+  assert(windowSize > 0);
+  reset();
+
+  // (x^k * x^(8 * windowSize)) mod P for each bit k of a byte; the table
+  // entry for a byte is the xor of those of its set bits.
+  std::array<Poly, 8> bitTable;
+  for (int k = 0; k < 8; k++) {
+    Fingerprint<BITS> fp;
+    for (int i = 0; i < fp.size(); i++) {
+      fp.fp_[i] = 0;
+    }
+    fp.update8(uint8_t(1 << k));
+    for (size_t i = 0; i < windowSize; i++) {
+      fp.update8(0);
+    }
+    fp.write(bitTable[k].data());
+  }
+  for (size_t b = 0; b < removeTable_.size(); b++) {
+    removeTable_[b].fill(0);
+    for (int k = 0; k < 8; k++) {
+      if (b & (1u << k)) {
+        for (size_t i = 0; i < removeTable_[b].size(); i++) {
+          removeTable_[b][i] ^= bitTable[k][i];
+        }
+      }
+    }
+  }
+}
+
 } // namespace folly
@@ -278,6 +278,194 @@ void BaseFormatter<Derived, containerMode, Args...>::operator()(
   }
 }
 
+#if __cpp_nontype_template_parameter_auto >= 201606L && \
+    __cpp_if_constexpr >= 201606L
+namespace detail {
+
+constexpr size_t kFormatLiteral = size_t(-1);
+
+// A piece of a format string: either literal text, or the spec of the
+// argument with index `arg`.
+struct FormatSegment {
+  size_t begin;
+  size_t end;
+  size_t arg;
+};
+
+template <size_t N>
+struct FormatPlan {
+  // every segment consumes at least one character
+  FormatSegment segments[N + 1];
+  size_t size;
+  size_t literalSize;
+};
+
+// Not constexpr, so that calling it in a constant expression fails to compile
+// with `message` in the diagnostic.
+[[noreturn]] inline void formatStringError(const char* message) {
+  throw_exception<BadFormatArg>(message);
+}
+
+constexpr bool isFormatAlign(char c) {
+  return c == '<' || c == '>' || c == '=' || c == '^';
+}
+
+// The same grammar as BaseFormatter::operator() and FormatArg::initSlow().
+template <size_t N>
+constexpr FormatPlan<N> parseFormatString(
+    BasicFixedString<char, N> const& fmt,
+    size_t argCount) {
+  FormatPlan<N> plan{};
+  auto addLiteral = [&](size_t begin, size_t end) {
+    if (begin != end) {
+      plan.segments[plan.size++] = FormatSegment{begin, end, kFormatLiteral};
+      plan.literalSize += end - begin;
+    }
+  };
+
+  size_t const n = fmt.size();
+  size_t start = 0;
+  size_t p = 0;
+  size_t nextArg = 0;
+  bool hasDefaultArgIndex = false;
+  bool hasExplicitArgIndex = false;
+  while (p != n) {
+    if (fmt[p] == '}') {
+      if (p + 1 == n || fmt[p + 1] != '}') {
+        formatStringError("folly::format: single '}' in format string");
+      }
+      // "}}" -> "}"
+      addLiteral(start, p + 1);
+      p += 2;
+      start = p;
+      continue;
+    }
+    if (fmt[p] != '{') {
+      ++p;
+      continue;
+    }
+    addLiteral(start, p);
+    if (p + 1 == n) {
+      formatStringError("folly::format: '{' at end of format string");
+    }
+    if (fmt[p + 1] == '{') {
+      // "{{" -> "{"
+      start = p + 1;
+      p += 2;
+      continue;
+    }
+
+    size_t const begin = p + 1;
+    size_t end = begin;
+    while (end != n && fmt[end] != '}') {
+      ++end;
+    }
+    if (end == n) {
+      formatStringError("folly::format: missing ending '}'");
+    }
+
+    size_t colon = begin;
+    while (colon != end && fmt[colon] != ':') {
+      ++colon;
+    }
+    size_t keyEnd = begin;
+    while (keyEnd != colon && fmt[keyEnd] != '.' && fmt[keyEnd] != '[') {
+      ++keyEnd;
+    }
+    size_t arg = 0;
+    if (keyEnd == begin) {
+      arg = nextArg++;
+      hasDefaultArgIndex = true;
+    } else {
+      for (size_t i = begin; i != keyEnd; ++i) {
+        if (fmt[i] < '0' || fmt[i] > '9') {
+          formatStringError("folly::format: argument index must be integer");
+        }
+        arg = arg * 10 + size_t(fmt[i] - '0');
+      }
+      hasExplicitArgIndex = true;
+    }
+    if (hasDefaultArgIndex && hasExplicitArgIndex) {
+      formatStringError(
+          "folly::format: may not have both default and explicit arg indexes");
+    }
+    if (arg >= argCount) {
+      formatStringError("folly::format: argument index out of range");
+    }
+
+    if (colon != end) {
+      size_t i = colon + 1;
+      if (i + 1 < end && isFormatAlign(fmt[i + 1])) {
+        i += 2;
+      } else if (i < end && isFormatAlign(fmt[i])) {
+        ++i;
+      }
+      if (i < end && (fmt[i] == '+' || fmt[i] == '-' || fmt[i] == ' ')) {
+        ++i;
+      }
+      if (i < end && fmt[i] == '#') {
+        ++i;
+      }
+      if (i < end && fmt[i] == '0') {
+        ++i;
+      }
+      if (i < end && fmt[i] == '*') {
+        formatStringError(
+            "folly::format: dynamic field width not supported in "
+            "compile-time format strings");
+      }
+    }
+
+    plan.segments[plan.size++] = FormatSegment{begin, end, arg};
+    p = end + 1;
+    start = p;
+  }
+  addLiteral(start, n);
+  return plan;
+}
+
+template <auto const& Fmt, size_t ArgCount>
+constexpr auto kFormatPlan = parseFormatString(Fmt, ArgCount);
+
+template <auto const& Fmt, size_t I, class Output, class Tuple>
+void formatSegment(Output& out, Tuple const& args) {
+  constexpr auto& plan = kFormatPlan<Fmt, std::tuple_size<Tuple>::value>;
+  constexpr FormatSegment segment = plan.segments[I];
+  StringPiece const text(Fmt.data() + segment.begin, Fmt.data() + segment.end);
+  if constexpr (segment.arg == kFormatLiteral) {
+    out(text);
+  } else {
+    FormatArg arg(text);
+    arg.splitKey<true>(); // the argument index, resolved above
+    using Arg = std::decay_t<std::tuple_element_t<segment.arg, Tuple>>;
+    FormatValue<Arg>(std::get<segment.arg>(args)).format(arg, out);
+  }
+}
+
+template <auto const& Fmt, class Output, class Tuple, size_t... I>
+void formatSegments(
+    Output& out,
+    Tuple const& args,
+    std::index_sequence<I...>) {
+  (formatSegment<Fmt, I>(out, args), ...);
+}
+
+} // namespace detail
+
+template <auto const& Fmt, class... Args>
+std::string sformat(Args&&... args) {
+  constexpr auto& plan = detail::kFormatPlan<Fmt, sizeof...(Args)>;
+  std::string s;
+  s.reserve(plan.literalSize);
+  auto appender = [&s](StringPiece sp) { s.append(sp.data(), sp.size()); };
+  detail::formatSegments<Fmt>(
+      appender,
+      std::forward_as_tuple(args...),
+      std::make_index_sequence<plan.size>());
+  return s;
+}
+#endif
+
 template <class Derived, bool containerMode, class... Args>
 void writeTo(
     FILE* fp,
@@ -196,6 +196,21 @@ void FormatValue<double>::formatHelper(
       } else if (arg.precision > DoubleToStringConverter::kMaxPrecisionDigits) {
         arg.precision = DoubleToStringConverter::kMaxPrecisionDigits;
       }
+      DtoaShortestFormat const format{
+          infinitySymbol,
+          nanSymbol,
+          exponentSymbol,
+          -4,
+          arg.precision,
+          true,
+          arg.trailingDot,
+      };
+      char shortest[bufLen];
+      auto const length = dtoaShortest(val, shortest, bufLen - 1, format);
+      if (length != 0) {
+        builder.AddSubstring(shortest, int(length));
+        break;
+      }
       DoubleToStringConverter conv(
           flags,
           infinitySymbol,
@@ -25,6 +25,7 @@
 
 #include <folly/CPortability.h>
 #include <folly/Conv.h>
+#include <folly/FixedString.h>
 #include <folly/FormatArg.h>
 #include <folly/Range.h>
 #include <folly/String.h>
@@ -282,6 +283,22 @@ inline std::string sformat(StringPiece fmt, Args&&... args) {
   return format(fmt, std::forward<Args>(args)...).str();
 }
 
+#if __cpp_nontype_template_parameter_auto >= 201606L && \
+    __cpp_if_constexpr >= 201606L
+/**
+ * Like sformat(), but the format string is a FixedString which is parsed and
+ * checked at compile time, so malformed format strings, argument indexes out
+ * of range and mixed default and explicit indexes don't compile. Formatting
+ * appends the literal text and the arguments in order, without scanning the
+ * format string. Dynamic field widths ("{:*}") aren't supported.
+ *
+ * static constexpr auto kCounter = folly::makeFixedString("{}.{}.count");
+ * std::string name = sformat<kCounter>(service, method);
+ */
+template <auto const& Fmt, class... Args>
+std::string sformat(Args&&... args);
+#endif
+
 /**
  * Create a formatter object that takes one argument (of container type)
  * and uses that container to get argument values from.
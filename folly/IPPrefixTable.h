@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/IPAddress.h>
+#include <folly/experimental/AtomicReadMostlyMainPtr.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+namespace detail {
+
+// An address as a 128-bit integer, left-aligned: an IPv4 address takes the
+// most significant 32 bits.
+struct IPPrefixKey {
+  uint64_t hi;
+  uint64_t lo;
+
+  friend bool operator<(const IPPrefixKey& a, const IPPrefixKey& b) {
+    return std::tie(a.hi, a.lo) < std::tie(b.hi, b.lo);
+  }
+  friend bool operator==(const IPPrefixKey& a, const IPPrefixKey& b) {
+    return a.hi == b.hi && a.lo == b.lo;
+  }
+};
+
+inline IPPrefixKey ipPrefixKey(const IPAddressV4& addr) {
+  return {uint64_t(addr.toLongHBO()) << 32, 0};
+}
+
+inline IPPrefixKey ipPrefixKey(const IPAddressV6& addr) {
+  return {
+      Endian::big(loadUnaligned<uint64_t>(addr.bytes())),
+      Endian::big(loadUnaligned<uint64_t>(addr.bytes() + 8))};
+}
+
+// Clear all but the `length` most significant bits.
+inline IPPrefixKey ipPrefixMask(IPPrefixKey key, size_t length) {
+  auto keep = [](size_t n) { return n == 0 ? 0 : ~uint64_t(0) << (64 - n); };
+  key.hi &= keep(std::min<size_t>(length, 64));
+  key.lo &= keep(length > 64 ? length - 64 : 0);
+  return key;
+}
+
+// Each trie node consumes this many bits of the key, so that a node's
+// children and leaves can be indexed by a 64-bit popcount.
+constexpr size_t kIPPrefixStride = 6;
+
+// The kIPPrefixStride bits of key starting at bit `offset`, counting from
+// the most significant; bits past the end of the key are 0.
+inline size_t ipPrefixSlot(const IPPrefixKey& key, size_t offset) {
+  constexpr uint64_t kMask = (uint64_t(1) << kIPPrefixStride) - 1;
+  auto const end = offset + kIPPrefixStride;
+  if (end <= 64) {
+    return size_t((key.hi >> (64 - end)) & kMask);
+  } else if (offset >= 64) {
+    return size_t(
+        (end <= 128 ? key.lo >> (128 - end) : key.lo << (end - 128)) & kMask);
+  } else {
+    return size_t(((key.hi << (end - 64)) | (key.lo >> (128 - end))) & kMask);
+  }
+}
+
+} // namespace detail
+
+/**
+ * An immutable longest-prefix-match table from CIDR networks to values, for
+ * looking up many addresses against many prefixes, e.g. for ACLs or geo
+ * lookups. Build it with IPPrefixTable::Builder.
+ *
+ * IPv4 and IPv6 prefixes are kept apart: an IPv4 address only matches IPv4
+ * networks, and an IPv6 address (even an IPv4-mapped one) IPv6 networks.
+ *
+ * The table is a Poptrie (Asai and Ohara, SIGCOMM 2015): a multibit trie
+ * whose nodes each consume 6 bits of the address, and which store their
+ * children and their leaves contiguously, indexed by the popcount of a
+ * bitmap. Leaves are pushed down to the nodes and runs of equal leaves are
+ * stored once, so a lookup is a few dependent loads, at most 6 nodes for
+ * IPv4, and the table stays compact with hundreds of thousands of prefixes.
+ *
+ * To replace the table while it's being read, see AtomicIPPrefixTable.
+ */
+template <class Value>
+class IPPrefixTable {
+ private:
+  struct Node {
+    // Bit i is set if slot i has a child.
+    uint64_t vector;
+    // Bit i is set if slot i is a leaf with a different value than the
+    // previous leaf.
+    uint64_t leafvec;
+    // Index of the first leaf and of the first child.
+    uint32_t base0;
+    uint32_t base1;
+  };
+
+  struct Trie {
+    std::vector<Node> nodes;
+    // Index in values_ plus one, or 0 for no match.
+    std::vector<uint32_t> leaves;
+  };
+
+ public:
+  class Builder {
+   public:
+    /**
+     * Map `network` to `value`, replacing the value of a previous insert()
+     * of the same network. The host bits of the network address are
+     * ignored. Throws std::invalid_argument if the network address is empty
+     * or if its prefix length is longer than the address.
+     */
+    Builder& insert(const CIDRNetwork& network, Value value) {
+      auto const& addr = network.first;
+      if (addr.empty() || network.second > addr.bitCount()) {
+        throw std::invalid_argument(to<std::string>(
+            "invalid network for IPPrefixTable: ",
+            IPAddress::networkToString(network)));
+      }
+      auto key = addr.isV4() ? detail::ipPrefixKey(addr.asV4())
+                             : detail::ipPrefixKey(addr.asV6());
+      (addr.isV4() ? v4_ : v6_)
+          .push_back(Entry{detail::ipPrefixMask(key, network.second),
+                           network.second,
+                           uint32_t(values_.size())});
+      values_.push_back(std::move(value));
+      return *this;
+    }
+
+    /// Build the table, leaving the Builder empty.
+    IPPrefixTable build() {
+      IPPrefixTable table;
+      table.v4_ = compile(std::move(v4_), table.values_);
+      table.v6_ = compile(std::move(v6_), table.values_);
+      v4_.clear();
+      v6_.clear();
+      values_.clear();
+      return table;
+    }
+
+   private:
+    struct Entry {
+      detail::IPPrefixKey key;
+      size_t length;
+      // Index in values_ while building; in the table's values, plus one,
+      // while compiling.
+      uint32_t value;
+    };
+
+    Trie compile(std::vector<Entry> entries, std::vector<Value>& values) {
+      // Keep the last insert() of each network.
+      std::stable_sort(
+          entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return std::tie(a.key, a.length) < std::tie(b.key, b.length);
+          });
+      std::vector<Entry> unique;
+      for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i + 1].key == entries[i].key &&
+            entries[i + 1].length == entries[i].length) {
+          continue;
+        }
+        unique.push_back(entries[i]);
+        values.push_back(std::move(values_[entries[i].value]));
+        unique.back().value = uint32_t(values.size());
+      }
+
+      uint32_t def = 0;
+      if (!unique.empty() && unique.front().length == 0) {
+        def = unique.front().value;
+        unique.erase(unique.begin());
+      }
+      Trie trie;
+      trie.nodes.resize(1);
+      compileNode(trie, 0, unique, 0, def);
+      return trie;
+    }
+
+    // Compile the node at `index` from the entries longer than `depth`
+    // under it, in order, where `def` is the value of the longest prefix
+    // of at most `depth` bits which covers it.
+    static void compileNode(
+        Trie& trie,
+        size_t index,
+        const std::vector<Entry>& entries,
+        size_t depth,
+        uint32_t def) {
+      constexpr size_t kSlots = size_t(1) << detail::kIPPrefixStride;
+      auto const end = depth + detail::kIPPrefixStride;
+
+      // Expand the prefixes which end in this node onto its slots, shortest
+      // first so that longer ones win.
+      uint32_t slotValues[kSlots];
+      std::fill(slotValues, slotValues + kSlots, def);
+      std::vector<const Entry*> ending;
+      std::vector<Entry> longer;
+      for (auto const& entry : entries) {
+        if (entry.length <= end) {
+          ending.push_back(&entry);
+        } else {
+          longer.push_back(entry);
+        }
+      }
+      std::stable_sort(
+          ending.begin(), ending.end(), [](const Entry* a, const Entry* b) {
+            return a->length < b->length;
+          });
+      for (auto entry : ending) {
+        auto const first = detail::ipPrefixSlot(entry->key, depth);
+        auto const count = size_t(1) << (end - entry->length);
+        std::fill(slotValues + first, slotValues + first + count, entry->value);
+      }
+
+      // Slots with longer prefixes under them get a child; the rest are
+      // leaves, of which each run of equal values is stored once.
+      Node node{0, 0, uint32_t(trie.leaves.size()), uint32_t(0)};
+      std::vector<std::pair<size_t, size_t>> groups; // [begin, end) in longer
+      for (size_t i = 0; i < longer.size();) {
+        auto const slot = detail::ipPrefixSlot(longer[i].key, depth);
+        auto j = i + 1;
+        while (j < longer.size() &&
+               detail::ipPrefixSlot(longer[j].key, depth) == slot) {
+          ++j;
+        }
+        node.vector |= uint64_t(1) << slot;
+        groups.emplace_back(i, j);
+        i = j;
+      }
+      bool first = true;
+      uint32_t last = 0;
+      for (size_t slot = 0; slot < kSlots; ++slot) {
+        if (node.vector & (uint64_t(1) << slot)) {
+          continue;
+        }
+        if (first || slotValues[slot] != last) {
+          node.leafvec |= uint64_t(1) << slot;
+          trie.leaves.push_back(slotValues[slot]);
+          last = slotValues[slot];
+          first = false;
+        }
+      }
+
+      // Children are contiguous, so allocate them all before compiling any.
+      node.base1 = uint32_t(trie.nodes.size());
+      trie.nodes.resize(trie.nodes.size() + groups.size());
+      trie.nodes[index] = node;
+      for (size_t k = 0; k < groups.size(); ++k) {
+        std::vector<Entry> sub(
+            longer.begin() + groups[k].first,
+            longer.begin() + groups[k].second);
+        auto const slot = detail::ipPrefixSlot(sub.front().key, depth);
+        compileNode(trie, node.base1 + k, sub, end, slotValues[slot]);
+      }
+    }
+
+    std::vector<Entry> v4_;
+    std::vector<Entry> v6_;
+    std::vector<Value> values_;
+  };
+
+  /// An empty table, which matches nothing.
+  IPPrefixTable() = default;
+
+  /**
+   * Get the value of the longest network containing `addr`, or nullptr if
+   * none does.
+   */
+  const Value* lookup(const IPAddressV4& addr) const {
+    return lookup(v4_, detail::ipPrefixKey(addr));
+  }
+  const Value* lookup(const IPAddressV6& addr) const {
+    return lookup(v6_, detail::ipPrefixKey(addr));
+  }
+  const Value* lookup(const IPAddress& addr) const {
+    if (addr.isV4()) {
+      return lookup(addr.asV4());
+    } else if (addr.isV6()) {
+      return lookup(addr.asV6());
+    }
+    return nullptr;
+  }
+
+  /// Number of distinct networks in the table.
+  size_t size() const {
+    return values_.size();
+  }
+
+ private:
+  const Value* lookup(const Trie& trie, const detail::IPPrefixKey& key) const {
+    if (trie.nodes.empty()) {
+      return nullptr;
+    }
+    size_t index = 0;
+    for (size_t offset = 0;; offset += detail::kIPPrefixStride) {
+      auto const& node = trie.nodes[index];
+      auto const bit = uint64_t(1) << detail::ipPrefixSlot(key, offset);
+      if (node.vector & bit) {
+        index = node.base1 + popcount(node.vector & (bit - 1));
+        continue;
+      }
+      // (bit << 1) - 1 is all ones for the last slot.
+      auto const rank = popcount(node.leafvec & ((bit << 1) - 1));
+      auto const leaf = trie.leaves[node.base0 + rank - 1];
+      return leaf == 0 ? nullptr : &values_[leaf - 1];
+    }
+  }
+
+  Trie v4_;
+  Trie v6_;
+  std::vector<Value> values_;
+};
+
+/**
+ * An IPPrefixTable which can be replaced while it's being read, e.g. to
+ * reload ACLs. Readers take a snapshot, which keeps the table it refers to
+ * alive, without contending with each other or with update().
+ */
+template <class Value>
+class AtomicIPPrefixTable {
+ public:
+  using Table = IPPrefixTable<Value>;
+
+  explicit AtomicIPPrefixTable(Table table = Table())
+      : table_(std::make_shared<Table>(std::move(table))) {}
+
+  ReadMostlySharedPtr<Table> snapshot() const {
+    return table_.load();
+  }
+
+  void update(Table table) {
+    table_.store(std::make_shared<Table>(std::move(table)));
+  }
+
+ private:
+  AtomicReadMostlyMainPtr<Table> table_;
+};
+
+} // namespace folly
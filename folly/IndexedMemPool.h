@@ -20,6 +20,7 @@
 #include <errno.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <type_traits>
 
 #include <folly/Portability.h>
@@ -143,12 +144,25 @@ using IndexedMemPoolTraitsEagerRecycle = IndexedMemPoolTraits<T, true, true>;
 /// global free list.  This allows items to be efficiently recirculated
 /// from consumers to producers.  AccessSpreader is used to access the
 /// local lists, so there is no performance advantage to having more
-/// local lists than L1 caches.
+/// local lists than L1 caches.  Local lists start with a limit of
+/// LocalListLimit_ / 8 (for limits of at least 16), which is doubled up
+/// to LocalListLimit_ each time a thread using them contends on the
+/// global list, so that few elements are held in local lists unless they
+/// are needed to keep threads off the global list.
 ///
-/// The pool mmap-s the entire necessary address space when the pool is
-/// constructed, but delays element construction.  This means that only
-/// elements that are actually returned to the caller get paged into the
-/// process's resident set (RSS).
+/// There is one global list per last-level cache (up to
+/// kMaxGlobalLists), which usually means per NUMA node, so that elements
+/// are recycled to threads of the node that recycled them; a thread only
+/// takes elements from the global lists of other nodes when that of its
+/// node is empty.
+///
+/// The pool reserves the entire necessary address space when the pool is
+/// constructed, without committing memory for it, and commits it in
+/// geometrically growing chunks as elements are first allocated; element
+/// construction is delayed as well.  This means that only elements that
+/// are actually returned to the caller get paged into the process's
+/// resident set (RSS), by the first threads that use them, and that large
+/// capacities don't count against overcommit limits until they are used.
 template <
     typename T,
     uint32_t NumLocalLists_ = 32,
@@ -170,6 +184,8 @@ struct IndexedMemPool {
     LocalListLimit = LocalListLimit_,
   };
 
+  static constexpr uint32_t kMaxGlobalLists = 8;
+
   static_assert(
       std::is_nothrow_default_constructible<Atom<uint32_t>>::value,
       "Atom must be nothrow default constructible");
@@ -194,18 +210,20 @@ struct IndexedMemPool {
   explicit IndexedMemPool(uint32_t capacity)
       : actualCapacity_(maxIndexForCapacity(capacity)),
         size_(0),
-        globalHead_(TaggedPtr{}) {
+        committed_(0),
+        numGlobalLists_(numGlobalListsForSystem()) {
     const size_t needed = sizeof(Slot) * (actualCapacity_ + 1);
-    size_t pagesize = size_t(sysconf(_SC_PAGESIZE));
-    mmapLength_ = ((needed - 1) & ~(pagesize - 1)) + pagesize;
-    assert(needed <= mmapLength_ && mmapLength_ < needed + pagesize);
-    assert((mmapLength_ % pagesize) == 0);
+    pageSize_ = size_t(sysconf(_SC_PAGESIZE));
+    mmapLength_ = roundUpToPage(needed);
+    assert(needed <= mmapLength_ && mmapLength_ < needed + pageSize_);
+    assert((mmapLength_ % pageSize_) == 0);
 
+    // only reserve the address space, see commit()
     slots_ = static_cast<Slot*>(mmap(
         nullptr,
         mmapLength_,
-        PROT_READ | PROT_WRITE,
-        MAP_PRIVATE | MAP_ANONYMOUS,
+        PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
         -1,
         0));
     if (slots_ == MAP_FAILED) {
@@ -249,7 +267,7 @@ struct IndexedMemPool {
   /// allocated.
   template <typename... Args>
   uint32_t allocIndex(Args&&... args) {
-    auto idx = localPop(localHead());
+    auto idx = localPop(localList());
     if (idx != 0) {
       Slot& s = slot(idx);
       Traits::onAllocate(&s.elem, std::forward<Args>(args)...);
@@ -272,7 +290,7 @@ struct IndexedMemPool {
   /// Gives up ownership previously granted by alloc()
   void recycleIndex(uint32_t idx) {
     assert(isAllocated(idx));
-    localPush(localHead(), idx);
+    localPush(localList(), idx);
   }
 
   /// Provides access to the pooled element referenced by idx
@@ -361,32 +379,50 @@ struct IndexedMemPool {
     }
   };
 
+  static constexpr uint32_t kMinLocalListLimit =
+      LocalListLimit >= 16 ? LocalListLimit / 8 : LocalListLimit;
+
   struct alignas(hardware_destructive_interference_size) LocalList {
     AtomicStruct<TaggedPtr, Atom> head;
+    /// the size above which the list is moved to a global list, between
+    /// kMinLocalListLimit and LocalListLimit
+    Atom<uint32_t> limit;
 
-    LocalList() : head(TaggedPtr{}) {}
+    LocalList() : head(TaggedPtr{}), limit(kMinLocalListLimit) {}
+  };
+
+  struct alignas(hardware_destructive_interference_size) GlobalList {
+    AtomicStruct<TaggedPtr, Atom> head;
+
+    GlobalList() : head(TaggedPtr{}) {}
   };
 
   ////////// fields
 
-  /// the number of bytes allocated from mmap, which is a multiple of
+  /// the number of bytes reserved with mmap, which is a multiple of
   /// the page size of the machine
   size_t mmapLength_;
 
+  size_t pageSize_;
+
   /// the actual number of slots that we will allocate, to guarantee
   /// that we will satisfy the capacity requested at construction time.
   /// They will be numbered 1..actualCapacity_ (note the 1-based counting),
   /// and occupy slots_[1..actualCapacity_].
   uint32_t actualCapacity_;
 
-  /// this records the number of slots that have actually been constructed.
-  /// To allow use of atomic ++ instead of CAS, we let this overflow.
-  /// The actual number of constructed elements is min(actualCapacity_,
-  /// size_)
+  /// this records the number of slots that have actually been constructed,
+  /// which never exceeds actualCapacity_ or committed_
   Atom<uint32_t> size_;
 
-  /// raw storage, only 1..min(size_,actualCapacity_) (inclusive) are
-  /// actually constructed.  Note that slots_[0] is not constructed or used
+  /// the number of slots whose memory has been committed, see commit()
+  Atom<uint32_t> committed_;
+
+  /// the number of global lists in use, see numGlobalListsForSystem()
+  uint32_t numGlobalLists_;
+
+  /// raw storage, only 1..size_ (inclusive) are actually constructed.
+  /// Note that slots_[0] is not constructed or used
   alignas(hardware_destructive_interference_size) Slot* slots_;
 
   /// use AccessSpreader to find your list.  We use stripes instead of
@@ -394,10 +430,12 @@ struct IndexedMemPool {
   /// or join.   These are heads of lists chained with localNext
   LocalList local_[NumLocalLists];
 
-  /// this is the head of a list of node chained by globalNext, that are
-  /// themselves each the head of a list chained by localNext
-  alignas(hardware_destructive_interference_size)
-      AtomicStruct<TaggedPtr, Atom> globalHead_;
+  /// these are the heads of lists of node chained by globalNext, that are
+  /// themselves each the head of a list chained by localNext.  The size of
+  /// a head is that of the first local list, excluding its head; the sizes
+  /// of the following local lists are stored in the globalNext of the
+  /// second node of the preceding local list
+  GlobalList global_[kMaxGlobalLists];
 
   ///////////// private methods
 
@@ -416,21 +454,109 @@ struct IndexedMemPool {
     return slots_[slotIndex(idx)];
   }
 
-  // localHead references a full list chained by localNext.  s should
-  // reference slot(localHead), it is passed as a micro-optimization
-  void globalPush(Slot& s, uint32_t localHead) {
+  static uint32_t numGlobalListsForSystem() {
+    auto const& numCaches = CacheLocality::system<Atom>().numCachesByLevel;
+    size_t n = numCaches.empty() ? 1 : numCaches.back();
+    return uint32_t(std::max<size_t>(1, std::min<size_t>(n, kMaxGlobalLists)));
+  }
+
+  size_t roundUpToPage(size_t bytes) const {
+    return ((bytes - 1) & ~(pageSize_ - 1)) + pageSize_;
+  }
+
+  // Commits the memory of at least the first minSlots slots, and twice as
+  // many as are committed if possible.  Concurrent calls may commit the
+  // same pages, which is harmless.  Returns false if out of memory.
+  bool commit(uint32_t minSlots) {
+    uint32_t committed = committed_.load(std::memory_order_acquire);
+    if (minSlots <= committed) {
+      return true;
+    }
+    uint64_t target = std::min(
+        std::max(uint64_t(minSlots), 2 * uint64_t(committed)),
+        uint64_t(actualCapacity_));
+    size_t begin = (sizeof(Slot) * (size_t(committed) + 1)) & ~(pageSize_ - 1);
+    size_t end =
+        std::min(roundUpToPage(sizeof(Slot) * (target + 1)), mmapLength_);
+    if (mprotect(
+            reinterpret_cast<char*>(slots_) + begin,
+            end - begin,
+            PROT_READ | PROT_WRITE) != 0) {
+      return false;
+    }
+    auto slots = uint32_t(std::min(
+        uint64_t(end / sizeof(Slot) - 1), uint64_t(actualCapacity_)));
+    while (committed < slots &&
+           !committed_.compare_exchange_weak(committed, slots)) {
+    }
+    return true;
+  }
+
+  // Constructs a slot of index size_ + 1, committing its memory first if
+  // needed; returns 0 if the pool is full or out of memory.
+  uint32_t allocSlot() {
+    uint32_t size = size_.load(std::memory_order_relaxed);
+    while (true) {
+      if (size >= actualCapacity_) {
+        return 0;
+      }
+      if (size >= committed_.load(std::memory_order_acquire) &&
+          !commit(size + 1)) {
+        return 0;
+      }
+      if (size_.compare_exchange_weak(size, size + 1)) {
+        break;
+      }
+    }
+    uint32_t idx = size + 1;
+    Slot& s = slot(idx);
+    // Atom is enforced above to be nothrow-default-constructible
+    // As an optimization, use default-initialization (no parens) rather
+    // than direct-initialization (with parens): these locations are
+    // stored-to before they are loaded-from
+    new (&s.localNext) Atom<uint32_t>;
+    new (&s.globalNext) Atom<uint32_t>;
+    Traits::initialize(&s.elem);
+    return idx;
+  }
+
+  // Called when a CAS on a global list fails: lets the local list grow so
+  // that it goes to the global lists less often.
+  void onGlobalContention(LocalList& list) {
+    auto limit = list.limit.load(std::memory_order_relaxed);
+    if (limit < LocalListLimit) {
+      list.limit.store(
+          std::min<uint32_t>(2 * limit, LocalListLimit),
+          std::memory_order_relaxed);
+    }
+  }
+
+  // localHead references a list chained by localNext with size + 1 nodes,
+  // at least 2.  s should reference slot(localHead), it is passed as a
+  // micro-optimization
+  void globalPush(
+      LocalList& list,
+      GlobalList& global,
+      Slot& s,
+      uint32_t localHead,
+      uint32_t size) {
+    Slot& second = slot(s.localNext.load(std::memory_order_relaxed));
     while (true) {
-      TaggedPtr gh = globalHead_.load(std::memory_order_acquire);
+      TaggedPtr gh = global.head.load(std::memory_order_acquire);
       s.globalNext.store(gh.idx, std::memory_order_relaxed);
-      if (globalHead_.compare_exchange_strong(gh, gh.withIdx(localHead))) {
+      second.globalNext.store(gh.size(), std::memory_order_relaxed);
+      if (global.head.compare_exchange_strong(
+              gh, gh.withIdx(localHead).withSize(size))) {
         // success
         return;
       }
+      onGlobalContention(list);
     }
   }
 
   // idx references a single node
-  void localPush(AtomicStruct<TaggedPtr, Atom>& head, uint32_t idx) {
+  void localPush(LocalList& list, uint32_t idx) {
+    auto& head = list.head;
     Slot& s = slot(idx);
     TaggedPtr h = head.load(std::memory_order_acquire);
     bool recycled = false;
@@ -441,11 +567,11 @@ struct IndexedMemPool {
         recycled = true;
       }
 
-      if (h.size() == LocalListLimit) {
+      if (h.size() >= list.limit.load(std::memory_order_relaxed)) {
         // push will overflow local list, steal it instead
         if (head.compare_exchange_strong(h, h.withEmpty())) {
           // steal was successful, put everything in the global list
-          globalPush(s, idx);
+          globalPush(list, global_[globalIndex()], s, idx, h.size());
           return;
         }
       } else {
@@ -459,23 +585,53 @@ struct IndexedMemPool {
     }
   }
 
-  // returns 0 if empty
-  uint32_t globalPop() {
+  // returns the head of a local list and its size excluding the head,
+  // or an empty TaggedPtr if the global list is empty
+  TaggedPtr globalPop(LocalList& list, GlobalList& global) {
     while (true) {
-      TaggedPtr gh = globalHead_.load(std::memory_order_acquire);
-      if (gh.idx == 0 ||
-          globalHead_.compare_exchange_strong(
-              gh,
-              gh.withIdx(
-                  slot(gh.idx).globalNext.load(std::memory_order_relaxed)))) {
-        // global list is empty, or pop was successful
-        return gh.idx;
+      TaggedPtr gh = global.head.load(std::memory_order_acquire);
+      if (gh.idx == 0) {
+        // global list is empty
+        return gh;
+      }
+      Slot& s = slot(gh.idx);
+      auto next = s.globalNext.load(std::memory_order_relaxed);
+      auto second = s.localNext.load(std::memory_order_relaxed);
+      // gh may have been popped, and s reused, since it was loaded: then
+      // second may not be an index, and the CAS below fails anyway
+      if (second == 0 || second > maxAllocatedIndex()) {
+        continue;
+      }
+      auto nextSize = std::min<uint32_t>(
+          slot(second).globalNext.load(std::memory_order_relaxed),
+          LocalListLimit);
+      if (global.head.compare_exchange_strong(
+              gh, gh.withIdx(next).withSize(nextSize))) {
+        // pop was successful
+        return gh;
+      }
+      onGlobalContention(list);
+    }
+  }
+
+  // returns the head of a local list from the global list of this node if
+  // possible, or from that of another node
+  TaggedPtr globalPop(LocalList& list) {
+    auto home = globalIndex();
+    for (uint32_t i = 0; i < numGlobalLists_; ++i) {
+      auto index = home + i < numGlobalLists_ ? home + i
+                                              : home + i - numGlobalLists_;
+      TaggedPtr popped = globalPop(list, global_[index]);
+      if (popped.idx != 0) {
+        return popped;
       }
     }
+    return TaggedPtr{};
   }
 
   // returns 0 if allocation failed
-  uint32_t localPop(AtomicStruct<TaggedPtr, Atom>& head) {
+  uint32_t localPop(LocalList& list) {
+    auto& head = list.head;
     while (true) {
       TaggedPtr h = head.load(std::memory_order_acquire);
       if (h.idx != 0) {
@@ -489,40 +645,34 @@ struct IndexedMemPool {
         continue;
       }
 
-      uint32_t idx = globalPop();
+      TaggedPtr popped = globalPop(list);
+      uint32_t idx = popped.idx;
       if (idx == 0) {
-        // global list is empty, allocate and construct new slot
-        if (size_.load(std::memory_order_relaxed) >= actualCapacity_ ||
-            (idx = ++size_) > actualCapacity_) {
-          // allocation failed
-          return 0;
-        }
-        Slot& s = slot(idx);
-        // Atom is enforced above to be nothrow-default-constructible
-        // As an optimization, use default-initialization (no parens) rather
-        // than direct-initialization (with parens): these locations are
-        // stored-to before they are loaded-from
-        new (&s.localNext) Atom<uint32_t>;
-        new (&s.globalNext) Atom<uint32_t>;
-        Traits::initialize(&s.elem);
-        return idx;
+        // global lists are empty, allocate and construct new slot
+        return allocSlot();
       }
 
       Slot& s = slot(idx);
       auto next = s.localNext.load(std::memory_order_relaxed);
       if (head.compare_exchange_strong(
-              h, h.withIdx(next).withSize(LocalListLimit))) {
+              h, h.withIdx(next).withSize(popped.size()))) {
         // global list moved to local list, keep head for us
         return idx;
       }
       // local bulk push failed, return idx to the global list and try again
-      globalPush(s, idx);
+      globalPush(list, global_[globalIndex()], s, idx, popped.size());
     }
   }
 
-  AtomicStruct<TaggedPtr, Atom>& localHead() {
+  LocalList& localList() {
     auto stripe = AccessSpreader<Atom>::current(NumLocalLists);
-    return local_[stripe].head;
+    return local_[stripe];
+  }
+
+  uint32_t globalIndex() const {
+    return numGlobalLists_ == 1
+        ? 0
+        : uint32_t(AccessSpreader<Atom>::current(numGlobalLists_));
   }
 
   void markAllocated(Slot& slot) {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <utility>
 
 #include <glog/logging.h>
@@ -31,6 +32,29 @@ namespace folly {
 template <class T, size_t Amp>
 class MPMCPipelineStage;
 
+/**
+ * Counters for one stage of an MPMCPipeline, see MPMCPipeline::stageStats().
+ * Elements are counted in the units of the stage's input (reads, queued) or
+ * output (writes, pending).
+ */
+struct MPMCPipelineStageStats {
+  // Elements read by the stage, including blocking reads in progress
+  uint64_t reads{0};
+  // Elements written by the stage
+  uint64_t writes{0};
+  // Elements waiting in the input queue of the stage
+  uint64_t queued{0};
+  // Outputs that the stage still owes for the elements it has read,
+  // i.e. the work in progress in the stage
+  uint64_t pending{0};
+  // Total time threads of the stage spent blocked waiting for input. A
+  // stage that waits a lot has more threads than its input keeps busy.
+  std::chrono::nanoseconds readWait{0};
+  // Total time threads of the stage spent blocked waiting for room in the
+  // next queue, which means that a later stage is the bottleneck.
+  std::chrono::nanoseconds writeWait{0};
+};
+
 /**
  * Multi-Producer, Multi-Consumer pipeline.
  *
@@ -86,6 +110,12 @@ class MPMCPipelineStage;
  * for each input int, the second stage produces 4 ints for each input string,
  * so, overall, the pipeline produces 2*4 = 8 ints for each input int.
  *
+ * stageStats<Stage>() reports, for each stage, how many elements it has
+ * read and written, how many wait for it, and how long its threads were
+ * blocked on either side. Comparing them across stages shows which stage
+ * is the bottleneck. Only blocked time is measured, so the common case
+ * does not read the clock.
+ *
  * Implementation details: we use N+1 MPMCQueue objects; each intermediate
  * queue connects two adjacent stages.  The MPMCQueue implementation is abused;
  * instead of using it as a queue, we insert in the output queue at the
@@ -235,6 +265,28 @@ class MPMCPipeline {
     return true;
   }
 
+  /**
+   * Read up to max elements for stage Stage, with their tickets. Blocks
+   * until at least one element is available, then takes the elements
+   * available without blocking. Returns the number of elements read.
+   * tickets must point to unused (e.g. default-constructed) tickets.
+   */
+  template <size_t Stage>
+  size_t blockingReadStageBulk(
+      Ticket<Stage>* tickets,
+      typename std::tuple_element<Stage, StageTuple>::type::value_type* elems,
+      size_t max) {
+    if (max == 0) {
+      return 0;
+    }
+    tickets[0] = blockingReadStage<Stage>(elems[0]);
+    size_t n = 1;
+    while (n < max && readStage<Stage>(tickets[n], elems[n])) {
+      ++n;
+    }
+    return n;
+  }
+
   /**
    * Complete an element in stage Stage (pushing it for stage Stage+1).
    * Blocking.
@@ -245,6 +297,23 @@ class MPMCPipeline {
         ticket.use(this), std::forward<Args>(args)...);
   }
 
+  /**
+   * Complete n elements in stage Stage, using up each of the n tickets:
+   * values must hold the amplification factor of outputs for each ticket,
+   * in ticket order. Blocking.
+   */
+  template <size_t Stage, class Iter>
+  void
+  blockingWriteStageBulk(Ticket<Stage>* tickets, size_t n, Iter values) {
+    constexpr size_t amplification =
+        std::tuple_element<Stage, StageInfos>::type::kAmplification;
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < amplification; ++j, ++values) {
+        blockingWriteStage<Stage>(tickets[i], *values);
+      }
+    }
+  }
+
   /**
    * Pop an element from (the final stage of) the pipeline. Blocking.
    */
@@ -275,6 +344,31 @@ class MPMCPipeline {
         std::get<sizeof...(Stages)>(stages_).readCount());
   }
 
+  /**
+   * Counters for stage Stage, see MPMCPipelineStageStats. They are
+   * estimates while the pipeline is in use.
+   */
+  template <size_t Stage>
+  MPMCPipelineStageStats stageStats() const noexcept {
+    static_assert(Stage < sizeof...(Stages), "Invalid stage");
+    auto const& in = std::get<Stage>(stages_);
+    auto const& out = std::get<Stage + 1>(stages_);
+    // The input of the first stage is written by blockingWrite(), and
+    // that of the others with tickets.
+    uint64_t const inWrites =
+        Stage == 0 ? in.writeCount() : in.ticketWriteCount();
+    MPMCPipelineStageStats stats;
+    stats.reads = in.readCount();
+    stats.writes = out.ticketWriteCount();
+    stats.queued = inWrites > stats.reads ? inWrites - stats.reads : 0;
+    uint64_t const owed = stats.reads *
+        std::tuple_element<Stage, StageInfos>::type::kAmplification;
+    stats.pending = owed > stats.writes ? owed - stats.writes : 0;
+    stats.readWait = in.readWait();
+    stats.writeWait = out.writeWait();
+    return stats;
+  }
+
  private:
   StageTuple stages_;
 };
@@ -991,6 +991,62 @@ class MPMCQueueBase<Derived<T, Atom, Dynamic>> {
     }
   }
 
+  /// Enqueues up to count elements moved from elems, as many as there is
+  /// room for, and returns how many were enqueued.  The tickets of the
+  /// batch are obtained with a single update of the push ticket dispenser
+  /// instead of one per element.  Like writeIfNotFull, this may wait for
+  /// reads which have linearized but not yet completed.  Not supported by
+  /// dynamic queues.
+  size_t writeBatch(T* elems, size_t count) noexcept {
+    static_assert(!Dynamic, "writeBatch isn't supported by dynamic MPMCQueue");
+    if (count == 0) {
+      return 0;
+    }
+    auto numPushes = pushTicket_.load(std::memory_order_acquire);
+    uint64_t batch;
+    do {
+      const auto numPops = popTicket_.load(std::memory_order_acquire);
+      // n will be negative if pops are pending
+      const int64_t n = int64_t(numPushes - numPops);
+      if (n >= static_cast<ssize_t>(capacity_)) {
+        return 0;
+      }
+      batch = std::min(uint64_t(count), uint64_t(int64_t(capacity_) - n));
+    } while (!pushTicket_.compare_exchange_strong(
+        numPushes, numPushes + batch));
+    for (uint64_t i = 0; i < batch; ++i) {
+      enqueueWithTicketBase(
+          numPushes + i, slots_, capacity_, stride_, std::move(elems[i]));
+    }
+    return size_t(batch);
+  }
+
+  /// Dequeues up to max elements onto out, as many as have been enqueued,
+  /// and returns how many were dequeued.  The tickets of the batch are
+  /// obtained with a single update of the pop ticket dispenser instead of
+  /// one per element.  Like readIfNotEmpty, this may wait for writes which
+  /// have linearized but not yet completed.  Not supported by dynamic
+  /// queues.
+  size_t readBatch(T* out, size_t max) noexcept {
+    static_assert(!Dynamic, "readBatch isn't supported by dynamic MPMCQueue");
+    if (max == 0) {
+      return 0;
+    }
+    auto numPops = popTicket_.load(std::memory_order_acquire);
+    uint64_t batch;
+    do {
+      const auto numPushes = pushTicket_.load(std::memory_order_acquire);
+      if (numPops >= numPushes) {
+        return 0;
+      }
+      batch = std::min(uint64_t(max), numPushes - numPops);
+    } while (!popTicket_.compare_exchange_strong(numPops, numPops + batch));
+    for (uint64_t i = 0; i < batch; ++i) {
+      dequeueWithTicketBase(numPops + i, slots_, capacity_, stride_, out[i]);
+    }
+    return size_t(batch);
+  }
+
  protected:
   enum {
     /// Once every kAdaptationFreq we will spin longer, to try to estimate
@@ -1319,6 +1375,13 @@ class MPMCQueueBase<Derived<T, Atom, Dynamic>> {
         ticket, slots_, capacity_, stride_, std::forward<Args>(args)...);
   }
 
+  // To support measuring write waits in MPMCPipelineStageImpl: returns
+  // true if enqueueWithTicket(ticket, ...) would not block right now
+  bool mayEnqueueWithTicket(uint64_t ticket) noexcept {
+    return slots_[idx(ticket, capacity_, stride_)].mayEnqueue(
+        turn(ticket, capacity_));
+  }
+
   // Given a ticket, dequeues the corresponding element
   void dequeueWithTicketBase(
       uint64_t ticket,
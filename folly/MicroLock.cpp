@@ -18,6 +18,7 @@
 #include <thread>
 
 #include <folly/portability/Asm.h>
+#include <folly/synchronization/LockProfiler.h>
 
 namespace folly {
 
@@ -31,6 +32,8 @@ void MicroLockCore::lockSlowPath(
   unsigned spins = 0;
   uint32_t slotWaitBit = slotHeldBit << 1;
   uint32_t needWaitBit = 0;
+  detail::LockProfilerWait profilerWait;
+  profilerWait.start(wordPtr);
 
 retry:
   if ((oldWord & slotHeldBit) != 0) {
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdlib>
@@ -34,6 +35,11 @@ namespace folly {
 /*
  * ProducerConsumerQueue is a one producer and one consumer queue
  * without locks.
+ *
+ * Each side keeps a private copy of the other side's index and only reloads
+ * the shared atomic when the copy says the queue is full (producer) or empty
+ * (consumer), so in steady state the cache line owned by the other thread is
+ * touched once per batch rather than once per element.
  */
 template <class T>
 struct ProducerConsumerQueue {
@@ -51,7 +57,9 @@ struct ProducerConsumerQueue {
       : size_(size),
         records_(static_cast<T*>(std::malloc(sizeof(T) * size))),
         readIndex_(0),
-        writeIndex_(0) {
+        writeIndexCache_(0),
+        writeIndex_(0),
+        readIndexCache_(0) {
     assert(size >= 2);
     if (!records_) {
       throw std::bad_alloc();
@@ -83,22 +91,60 @@ struct ProducerConsumerQueue {
     if (nextRecord == size_) {
       nextRecord = 0;
     }
-    if (nextRecord != readIndex_.load(std::memory_order_acquire)) {
-      new (&records_[currentWrite]) T(std::forward<Args>(recordArgs)...);
-      writeIndex_.store(nextRecord, std::memory_order_release);
-      return true;
+    if (nextRecord == readIndexCache_) {
+      readIndexCache_ = readIndex_.load(std::memory_order_acquire);
+      if (nextRecord == readIndexCache_) {
+        // queue is full
+        return false;
+      }
     }
+    new (&records_[currentWrite]) T(std::forward<Args>(recordArgs)...);
+    writeIndex_.store(nextRecord, std::memory_order_release);
+    return true;
+  }
 
-    // queue is full
-    return false;
+  // Construct up to n records from the range starting at first (copying;
+  // pass a move iterator to move) and publish them with a single index
+  // update. Returns the number of records written, which is less than n
+  // only if the queue filled up.
+  template <class InputIt>
+  size_t writeBulk(InputIt first, size_t n) {
+    auto const currentWrite = writeIndex_.load(std::memory_order_relaxed);
+    auto avail = freeSlots(currentWrite, readIndexCache_);
+    if (avail < n) {
+      readIndexCache_ = readIndex_.load(std::memory_order_acquire);
+      avail = freeSlots(currentWrite, readIndexCache_);
+    }
+    n = std::min(n, avail);
+
+    size_t index = currentWrite;
+    try {
+      for (size_t i = 0; i < n; ++i, ++first) {
+        new (&records_[index]) T(*first);
+        if (++index == size_) {
+          index = 0;
+        }
+      }
+    } catch (...) {
+      // Publish the records constructed so far so they are not leaked.
+      writeIndex_.store(index, std::memory_order_release);
+      throw;
+    }
+    if (n > 0) {
+      writeIndex_.store(index, std::memory_order_release);
+    }
+    return n;
   }
 
   // move (or copy) the value at the front of the queue to given variable
   bool read(T& record) {
     auto const currentRead = readIndex_.load(std::memory_order_relaxed);
-    if (currentRead == writeIndex_.load(std::memory_order_acquire)) {
-      // queue is empty
-      return false;
+    if (currentRead == writeIndexCache_) {
+      writeIndexCache_ = writeIndex_.load(std::memory_order_acquire);
+      if (currentRead == writeIndexCache_) {
+        // queue is empty
+        return false;
+      }
     }
 
     auto nextRecord = currentRead + 1;
@@ -111,13 +157,43 @@ struct ProducerConsumerQueue {
     return true;
   }
 
+  // Move up to n records from the front of the queue to out and release
+  // their slots with a single index update. Returns the number of records
+  // read, which is less than n only if the queue ran empty.
+  template <class OutputIt>
+  size_t readBulk(OutputIt out, size_t n) {
+    auto const currentRead = readIndex_.load(std::memory_order_relaxed);
+    auto avail = usedSlots(currentRead, writeIndexCache_);
+    if (avail < n) {
+      writeIndexCache_ = writeIndex_.load(std::memory_order_acquire);
+      avail = usedSlots(currentRead, writeIndexCache_);
+    }
+    n = std::min(n, avail);
+
+    size_t index = currentRead;
+    for (size_t i = 0; i < n; ++i, ++out) {
+      *out = std::move(records_[index]);
+      records_[index].~T();
+      if (++index == size_) {
+        index = 0;
+      }
+    }
+    if (n > 0) {
+      readIndex_.store(index, std::memory_order_release);
+    }
+    return n;
+  }
+
   // pointer to the value at the front of the queue (for use in-place) or
   // nullptr if empty.
   T* frontPtr() {
     auto const currentRead = readIndex_.load(std::memory_order_relaxed);
-    if (currentRead == writeIndex_.load(std::memory_order_acquire)) {
-      // queue is empty
-      return nullptr;
+    if (currentRead == writeIndexCache_) {
+      writeIndexCache_ = writeIndex_.load(std::memory_order_acquire);
+      if (currentRead == writeIndexCache_) {
+        // queue is empty
+        return nullptr;
+      }
     }
     return &records_[currentRead];
   }
@@ -174,14 +250,30 @@ struct ProducerConsumerQueue {
  private:
   using AtomicIndex = std::atomic<unsigned int>;
 
+  // Slots the producer at write may fill given the consumer is at read.
+  size_t freeSlots(size_t write, size_t read) const {
+    return read > write ? read - write - 1 : size_ - (write - read) - 1;
+  }
+
+  // Slots the consumer at read may drain given the producer is at write.
+  size_t usedSlots(size_t read, size_t write) const {
+    return write >= read ? write - read : size_ - (read - write);
+  }
+
   char pad0_[hardware_destructive_interference_size];
   const uint32_t size_;
   T* const records_;
 
+  // Consumer-owned line: its index and its view of the producer's index.
   alignas(hardware_destructive_interference_size) AtomicIndex readIndex_;
+  unsigned int writeIndexCache_;
+  // Producer-owned line: its index and its view of the consumer's index.
   alignas(hardware_destructive_interference_size) AtomicIndex writeIndex_;
+  unsigned int readIndexCache_;
 
-  char pad1_[hardware_destructive_interference_size - sizeof(AtomicIndex)];
+  char pad1_
+      [hardware_destructive_interference_size - sizeof(AtomicIndex) -
+       sizeof(unsigned int)];
 };
 
 } // namespace folly
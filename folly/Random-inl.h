@@ -54,6 +54,12 @@ struct StateSize<std::subtract_with_carry_engine<UIntType, w, s, r>> {
   using type = std::integral_constant<size_t, r*((w + 31) / 32)>;
 };
 
+// Philox4x32 is seeded with a 64-bit key and a 64-bit stream id.
+template <>
+struct StateSize<Philox4x32> {
+  using type = std::integral_constant<size_t, 4>;
+};
+
 template <typename RNG>
 using StateSizeT = _t<StateSize<RNG>>;
 
@@ -16,8 +16,10 @@
 
 #include <folly/Random.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstring>
 #include <mutex>
 #include <random>
 
@@ -25,6 +27,7 @@
 #include <folly/FileUtil.h>
 #include <folly/SingletonThreadLocal.h>
 #include <folly/ThreadLocal.h>
+#include <folly/lang/Bits.h>
 #include <folly/portability/SysTime.h>
 #include <folly/portability/Unistd.h>
 #include <folly/synchronization/CallOnce.h>
@@ -34,6 +37,10 @@
 #include <wincrypt.h> // @manual
 #endif
 
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#endif
+
 namespace folly {
 
 namespace {
@@ -169,4 +176,150 @@ ThreadLocalPRNG::result_type ThreadLocalPRNG::operator()() {
   using Single = SingletonThreadLocal<Wrapper, RandomTag>;
   return Single::get().object();
 }
+
+namespace {
+
+constexpr uint32_t kPhiloxM0 = 0xD2511F53;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85;
+
+#if FOLLY_SSE >= 2
+// Lane-wise 32x32->64 bit multiply of four lanes: the low halves of the
+// products go to lo, the high halves to hi.
+FOLLY_ALWAYS_INLINE void
+philoxMulhi(__m128i a, __m128i m, __m128i& lo, __m128i& hi) {
+  __m128i const even = _mm_mul_epu32(a, m);
+  __m128i const odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+  __m128i const lowMask = _mm_set_epi32(0, -1, 0, -1);
+  lo = _mm_or_si128(_mm_and_si128(even, lowMask), _mm_slli_epi64(odd, 32));
+  hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowMask, odd));
+}
+
+// Generate four consecutive blocks starting at counter index, writing 64
+// bytes to out. Lane i of cN holds word N of block i.
+void philoxBlocks4(
+    uint64_t index,
+    uint64_t stream,
+    std::array<uint32_t, 2> key,
+    unsigned char* out) {
+  auto lo32 = [&](uint64_t i) { return int32_t(uint32_t(index + i)); };
+  auto hi32 = [&](uint64_t i) { return int32_t(uint32_t((index + i) >> 32)); };
+  __m128i c0 = _mm_set_epi32(lo32(3), lo32(2), lo32(1), lo32(0));
+  __m128i c1 = _mm_set_epi32(hi32(3), hi32(2), hi32(1), hi32(0));
+  __m128i c2 = _mm_set1_epi32(int32_t(uint32_t(stream)));
+  __m128i c3 = _mm_set1_epi32(int32_t(uint32_t(stream >> 32)));
+  __m128i const m0 = _mm_set1_epi32(int32_t(kPhiloxM0));
+  __m128i const m1 = _mm_set1_epi32(int32_t(kPhiloxM1));
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (size_t r = 0; r < Philox4x32::kRounds; ++r) {
+    __m128i lo0, hi0, lo1, hi1;
+    philoxMulhi(c0, m0, lo0, hi0);
+    philoxMulhi(c2, m1, lo1, hi1);
+    c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(int32_t(k0)));
+    c1 = lo1;
+    c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(int32_t(k1)));
+    c3 = lo0;
+    k0 += kPhiloxW0;
+    k1 += kPhiloxW1;
+  }
+  // Transpose so that each block's four words are contiguous.
+  __m128i const t0 = _mm_unpacklo_epi32(c0, c1);
+  __m128i const t1 = _mm_unpacklo_epi32(c2, c3);
+  __m128i const t2 = _mm_unpackhi_epi32(c0, c1);
+  __m128i const t3 = _mm_unpackhi_epi32(c2, c3);
+  auto dst = reinterpret_cast<__m128i*>(out);
+  _mm_storeu_si128(dst + 0, _mm_unpacklo_epi64(t0, t1));
+  _mm_storeu_si128(dst + 1, _mm_unpackhi_epi64(t0, t1));
+  _mm_storeu_si128(dst + 2, _mm_unpacklo_epi64(t2, t3));
+  _mm_storeu_si128(dst + 3, _mm_unpackhi_epi64(t2, t3));
+}
+#endif
+
+void storeBlock(std::array<uint32_t, 4> const& block, unsigned char* out) {
+  for (size_t i = 0; i < block.size(); ++i) {
+    auto const word = Endian::little(block[i]);
+    std::memcpy(out + i * sizeof(word), &word, sizeof(word));
+  }
+}
+
+} // namespace
+
+std::array<uint32_t, 4> Philox4x32::block(
+    std::array<uint32_t, 4> ctr,
+    std::array<uint32_t, 2> key) {
+  for (size_t r = 0; r < kRounds; ++r) {
+    uint64_t const p0 = uint64_t(kPhiloxM0) * ctr[0];
+    uint64_t const p1 = uint64_t(kPhiloxM1) * ctr[2];
+    ctr = {{uint32_t(p1 >> 32) ^ ctr[1] ^ key[0],
+            uint32_t(p1),
+            uint32_t(p0 >> 32) ^ ctr[3] ^ key[1],
+            uint32_t(p0)}};
+    key[0] += kPhiloxW0;
+    key[1] += kPhiloxW1;
+  }
+  return ctr;
+}
+
+void Philox4x32::discard(uint64_t n) {
+  auto const buffered = uint64_t(kBlockWords - pos_);
+  if (n <= buffered) {
+    pos_ += size_t(n);
+    return;
+  }
+  n -= buffered;
+  counter_ += n / kBlockWords;
+  pos_ = kBlockWords;
+  if (n % kBlockWords != 0) {
+    refill();
+    pos_ = size_t(n % kBlockWords);
+  }
+}
+
+void Philox4x32::fill(void* data, size_t len) {
+  constexpr size_t kWordBytes = sizeof(result_type);
+  constexpr size_t kBlockBytes = kBlockWords * kWordBytes;
+  auto out = static_cast<unsigned char*>(data);
+
+  // Drain whatever is left of the current block first so that the output
+  // continues the operator() sequence.
+  while (pos_ != kBlockWords && len >= kWordBytes) {
+    auto const word = Endian::little(buffer_[pos_++]);
+    std::memcpy(out, &word, kWordBytes);
+    out += kWordBytes;
+    len -= kWordBytes;
+  }
+
+#if FOLLY_SSE >= 2
+  while (len >= 4 * kBlockBytes) {
+    philoxBlocks4(counter_, stream_, key_, out);
+    counter_ += 4;
+    out += 4 * kBlockBytes;
+    len -= 4 * kBlockBytes;
+  }
+#endif
+  while (len >= kBlockBytes) {
+    storeBlock(block(counterAt(counter_++), key_), out);
+    out += kBlockBytes;
+    len -= kBlockBytes;
+  }
+
+  while (len > 0) {
+    auto const word = Endian::little((*this)());
+    auto const n = std::min(len, kWordBytes);
+    std::memcpy(out, &word, n);
+    out += n;
+    len -= n;
+  }
+}
+
+void Random::fill(void* data, size_t len) {
+  struct Wrapper {
+    Philox4x32 object{Random::create<Philox4x32>()};
+  };
+  using Single = SingletonThreadLocal<Wrapper, RandomTag>;
+  Single::get().object.fill(data, len);
+}
+
 } // namespace folly
@@ -45,6 +45,7 @@
 #include <folly/Likely.h>
 #include <folly/Traits.h>
 #include <folly/detail/RangeCommon.h>
+#include <folly/detail/RangeAvx2.h>
 #include <folly/detail/RangeSse42.h>
 
 // Ignore shadowing warnings within this file, so includers can use -Wshadow.
@@ -1354,9 +1355,10 @@ namespace detail {
 inline size_t qfind_first_byte_of(
     const StringPiece haystack,
     const StringPiece needles) {
-  static auto const qfind_first_byte_of_fn = folly::CpuId().sse42()
-      ? qfind_first_byte_of_sse42
-      : qfind_first_byte_of_nosse;
+  static auto const qfind_first_byte_of_fn = folly::CpuId().avx2()
+      ? qfind_first_byte_of_avx2
+      : folly::CpuId().sse42() ? qfind_first_byte_of_sse42
+                               : qfind_first_byte_of_nosse;
   return qfind_first_byte_of_fn(haystack, needles);
 }
 
@@ -30,6 +30,7 @@
 #include <folly/detail/Futex.h>
 #include <folly/portability/Asm.h>
 #include <folly/portability/SysResource.h>
+#include <folly/synchronization/LockProfiler.h>
 #include <folly/synchronization/SanitizeThread.h>
 
 // SharedMutex is a reader-writer lock.  It is small, very fast, scalable
@@ -213,6 +214,15 @@
 // this unnecessary in all but the most extreme cases.  Make sure to check
 // that the increased icache and dcache footprint of the tagged result is
 // worth it.
+//
+// A tag still shares its deferredReaders[] between all of the instances
+// of the type, so two hot locks can collide on a slot and send readers
+// back to the inline count.  SharedMutexReadMostly (PerInstanceDeferredReaders)
+// instead gives each instance its own deferredReaders[], so that readers
+// on different cpus only ever write to different cache lines of their
+// own lock.  It costs 2KB per lock and a longer scan for writers, so it
+// is meant for the few global, read-mostly locks that are hammered by
+// readers on every core.
 
 // SharedMutex's use of thread local storage is an optimization, so
 // for the case where thread local storage is not supported, define it
@@ -262,6 +272,25 @@ namespace detail {
 // Returns a guard that gives permission for the current thread to
 // annotate, and adjust the annotation bits in, the SharedMutex at ptr.
 std::unique_lock<std::mutex> sharedMutexAnnotationGuard(void* ptr);
+
+// Storage for the deferred reader slots of a SharedMutexImpl with
+// PerInstanceDeferredReaders; empty otherwise.  Must match the size of
+// SharedMutexImpl::deferredReaders[].
+template <typename Slot, bool Enabled>
+struct SharedMutexInstanceSlots {
+  Slot* instanceSlots() {
+    return nullptr;
+  }
+};
+
+template <typename Slot>
+struct SharedMutexInstanceSlots<Slot, true> {
+  Slot* instanceSlots() {
+    return slots_;
+  }
+
+  alignas(hardware_destructive_interference_size) Slot slots_[64 * 4] = {};
+};
 } // namespace detail
 
 template <
@@ -269,8 +298,12 @@ template <
     typename Tag_ = void,
     template <typename> class Atom = std::atomic,
     bool BlockImmediately = false,
-    bool AnnotateForThreadSanitizer = kIsSanitizeThread && !ReaderPriority>
-class SharedMutexImpl {
+    bool AnnotateForThreadSanitizer = kIsSanitizeThread && !ReaderPriority,
+    bool PerInstanceDeferredReaders = false>
+class SharedMutexImpl
+    : private detail::SharedMutexInstanceSlots<
+          Atom<uintptr_t>,
+          PerInstanceDeferredReaders> {
  public:
   static constexpr bool kReaderPriority = ReaderPriority;
 
@@ -889,6 +922,9 @@ class SharedMutexImpl {
   static_assert(
       !(kDeferredSearchDistance & (kDeferredSearchDistance - 1)),
       "kDeferredSearchDistance must be a power of 2");
+  static_assert(
+      kMaxDeferredReaders * kDeferredSeparationFactor == 64 * 4,
+      "detail::SharedMutexInstanceSlots must match deferredReaders");
 
   // The number of deferred locks that can be simultaneously acquired
   // by a thread via the token-less methods without performing any heap
@@ -1013,6 +1049,8 @@ class SharedMutexImpl {
       uint32_t goal,
       uint32_t waitMask,
       WaitContext& ctx) {
+    detail::LockProfilerWait profilerWait;
+    profilerWait.start(this);
     uint32_t spinCount = 0;
     while (true) {
       state = state_.load(std::memory_order_acquire);
@@ -1154,7 +1192,9 @@ class SharedMutexImpl {
   }
 
   DeferredReaderSlot* deferredReader(uint32_t slot) {
-    return &deferredReaders[slot * kDeferredSeparationFactor];
+    auto slots =
+        PerInstanceDeferredReaders ? this->instanceSlots() : deferredReaders;
+    return &slots[slot * kDeferredSeparationFactor];
   }
 
   uintptr_t tokenfulSlotValue() {
@@ -1541,6 +1581,14 @@ typedef SharedMutexImpl<false> SharedMutexWritePriority;
 typedef SharedMutexWritePriority SharedMutex;
 typedef SharedMutexImpl<false, void, std::atomic, false, false>
     SharedMutexSuppressTSAN;
+typedef SharedMutexImpl<
+    false,
+    void,
+    std::atomic,
+    false,
+    kIsSanitizeThread,
+    true>
+    SharedMutexReadMostly;
 
 // Prevent the compiler from instantiating these in other translation units.
 // They are instantiated once in SharedMutex.cpp
@@ -1552,19 +1600,22 @@ template <
     typename Tag_,
     template <typename> class Atom,
     bool BlockImmediately,
-    bool AnnotateForThreadSanitizer>
+    bool AnnotateForThreadSanitizer,
+    bool PerInstanceDeferredReaders>
 alignas(hardware_destructive_interference_size) typename SharedMutexImpl<
     ReaderPriority,
     Tag_,
     Atom,
     BlockImmediately,
-    AnnotateForThreadSanitizer>::DeferredReaderSlot
+    AnnotateForThreadSanitizer,
+    PerInstanceDeferredReaders>::DeferredReaderSlot
     SharedMutexImpl<
         ReaderPriority,
         Tag_,
         Atom,
         BlockImmediately,
-        AnnotateForThreadSanitizer>::deferredReaders
+        AnnotateForThreadSanitizer,
+        PerInstanceDeferredReaders>::deferredReaders
         [kMaxDeferredReaders * kDeferredSeparationFactor] = {};
 
 template <
@@ -1572,39 +1623,45 @@ template <
     typename Tag_,
     template <typename> class Atom,
     bool BlockImmediately,
-    bool AnnotateForThreadSanitizer>
+    bool AnnotateForThreadSanitizer,
+    bool PerInstanceDeferredReaders>
 FOLLY_SHAREDMUTEX_TLS uint32_t SharedMutexImpl<
     ReaderPriority,
     Tag_,
     Atom,
     BlockImmediately,
-    AnnotateForThreadSanitizer>::tls_lastTokenlessSlot = 0;
+    AnnotateForThreadSanitizer,
+    PerInstanceDeferredReaders>::tls_lastTokenlessSlot = 0;
 
 template <
     bool ReaderPriority,
     typename Tag_,
     template <typename> class Atom,
     bool BlockImmediately,
-    bool AnnotateForThreadSanitizer>
+    bool AnnotateForThreadSanitizer,
+    bool PerInstanceDeferredReaders>
 FOLLY_SHAREDMUTEX_TLS uint32_t SharedMutexImpl<
     ReaderPriority,
     Tag_,
     Atom,
     BlockImmediately,
-    AnnotateForThreadSanitizer>::tls_lastDeferredReaderSlot = 0;
+    AnnotateForThreadSanitizer,
+    PerInstanceDeferredReaders>::tls_lastDeferredReaderSlot = 0;
 
 template <
     bool ReaderPriority,
     typename Tag_,
     template <typename> class Atom,
     bool BlockImmediately,
-    bool AnnotateForThreadSanitizer>
+    bool AnnotateForThreadSanitizer,
+    bool PerInstanceDeferredReaders>
 bool SharedMutexImpl<
     ReaderPriority,
     Tag_,
     Atom,
     BlockImmediately,
-    AnnotateForThreadSanitizer>::tryUnlockTokenlessSharedDeferred() {
+    AnnotateForThreadSanitizer,
+    PerInstanceDeferredReaders>::tryUnlockTokenlessSharedDeferred() {
   auto bestSlot = tls_lastTokenlessSlot;
   for (uint32_t i = 0; i < kMaxDeferredReaders; ++i) {
     auto slotPtr = deferredReader(bestSlot ^ i);
@@ -1623,14 +1680,16 @@ template <
     typename Tag_,
     template <typename> class Atom,
     bool BlockImmediately,
-    bool AnnotateForThreadSanitizer>
+    bool AnnotateForThreadSanitizer,
+    bool PerInstanceDeferredReaders>
 template <class WaitContext>
 bool SharedMutexImpl<
     ReaderPriority,
     Tag_,
     Atom,
     BlockImmediately,
-    AnnotateForThreadSanitizer>::
+    AnnotateForThreadSanitizer,
+    PerInstanceDeferredReaders>::
     lockSharedImpl(uint32_t& state, Token* token, WaitContext& ctx) {
   while (true) {
     if (UNLIKELY((state & kHasE) != 0) &&
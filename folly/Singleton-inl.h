@@ -86,6 +86,17 @@ void SingletonHolder<T>::registerSingletonMock(CreateFunc c, TeardownFunc t) {
       creationOrder->erase(it);
     }
   }
+  {
+    auto initRecords = vault_.initRecords_.wlock();
+
+    auto it = std::find_if(
+        initRecords->begin(), initRecords->end(), [&](const auto& record) {
+          return record.type == type();
+        });
+    if (it != initRecords->end()) {
+      initRecords->erase(it);
+    }
+  }
 
   std::lock_guard<std::mutex> entry_lock(mutex_);
 
@@ -216,6 +227,9 @@ void SingletonHolder<T>::createInstance() {
     detail::singletonWarnCreateCircularDependencyAndAbort(type());
   }
 
+  // Also times waiting for another thread creating the instance.
+  detail::SingletonInitTracer tracer(type());
+
   std::lock_guard<std::mutex> entry_lock(mutex_);
   if (state_.load(std::memory_order_acquire) == SingletonHolderState::Living) {
     return;
@@ -280,6 +294,7 @@ void SingletonHolder<T>::createInstance() {
   state_.store(SingletonHolderState::Living, std::memory_order_release);
 
   vault_.creationOrder_.wlock()->push_back(type());
+  vault_.initRecords_.wlock()->push_back(tracer.finish());
 }
 
 } // namespace detail
@@ -26,6 +26,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 
 #include <folly/Demangle.h>
 #include <folly/Format.h>
@@ -166,6 +167,33 @@ void singletonPrintDestructionStackTrace(const TypeDescriptor& type) {
 }
 // clang-format on
 
+namespace {
+thread_local SingletonInitTracer* currentInitTracer = nullptr;
+} // namespace
+
+SingletonInitTracer::SingletonInitTracer(const TypeDescriptor& type) noexcept
+    : type_(type),
+      parent_(currentInitTracer),
+      start_(std::chrono::steady_clock::now()) {
+  currentInitTracer = this;
+}
+
+SingletonInitTracer::~SingletonInitTracer() {
+  currentInitTracer = parent_;
+  if (parent_) {
+    parent_->nested_ += std::chrono::steady_clock::now() - start_;
+    auto& deps = parent_->dependencies_;
+    if (std::find(deps.begin(), deps.end(), type_) == deps.end()) {
+      deps.push_back(type_);
+    }
+  }
+}
+
+SingletonInitRecord SingletonInitTracer::finish() {
+  std::chrono::nanoseconds duration = std::chrono::steady_clock::now() - start_;
+  return {type_, duration, duration - nested_, std::move(dependencies_)};
+}
+
 } // namespace detail
 
 namespace {
@@ -228,6 +256,25 @@ void SingletonVault::addEagerInitSingleton(detail::SingletonHolderBase* entry) {
   eagerInitSingletons->insert(entry);
 }
 
+void SingletonVault::addSingletonDependency(
+    detail::SingletonHolderBase* entry,
+    detail::SingletonHolderBase* dependency) {
+  auto state = state_.rlock();
+  state->check(detail::SingletonVaultState::Type::Running);
+
+  if (UNLIKELY(state->registrationComplete)) {
+    LOG(ERROR) << "Adding singleton dependency after registrationComplete().";
+  }
+
+  CHECK_THROW(entry != dependency, std::logic_error);
+
+  auto dependencies = dependencies_.wlock();
+  auto& deps = (*dependencies)[entry];
+  if (std::find(deps.begin(), deps.end(), dependency) == deps.end()) {
+    deps.push_back(dependency);
+  }
+}
+
 void SingletonVault::registrationComplete() {
   std::atexit([]() { SingletonVault::singleton()->destroyInstances(); });
 
@@ -267,6 +314,58 @@ void SingletonVault::doEagerInit() {
   }
 }
 
+namespace {
+
+// The singletons created by doEagerInitVia, and the ones depending on each.
+struct EagerInitGraph {
+  struct Node {
+    detail::SingletonHolderBase* single{nullptr};
+    std::vector<size_t> dependents;
+    // Dependencies not created yet.
+    std::atomic<size_t> pending{0};
+  };
+
+  EagerInitGraph(size_t size, Executor& exe, folly::Baton<>* baton)
+      : nodes(size), countdown(size), executor(exe), done(baton) {}
+
+  std::vector<Node> nodes;
+  std::atomic<size_t> countdown;
+  Executor& executor;
+  folly::Baton<>* done;
+};
+
+void scheduleEagerInit(std::shared_ptr<EagerInitGraph> graph, size_t i) {
+  auto& exe = graph->executor;
+  // graph is retained by shared_ptr, and will be alive until last lambda is
+  // done. The baton and the executor are provided by the caller, and expected
+  // to remain present until then. The SingletonHolderBase pointers are alive
+  // as long as SingletonVault is not being destroyed.
+  exe.add([graph = std::move(graph), i] {
+    auto& node = graph->nodes[i];
+    // schedule dependents and notify if requested, whether initialization
+    // was successful, was skipped (already initialized), or exception thrown.
+    SCOPE_EXIT {
+      for (auto dependent : node.dependents) {
+        if (--graph->nodes[dependent].pending == 0) {
+          scheduleEagerInit(graph, dependent);
+        }
+      }
+      if (--graph->countdown == 0) {
+        if (graph->done != nullptr) {
+          graph->done->post();
+        }
+      }
+    };
+    // if initialization is in progress in another thread, don't try to init
+    // here.  Otherwise the current thread will block on 'createInstance'.
+    if (!node.single->creationStarted()) {
+      node.single->createInstance();
+    }
+  });
+}
+
+} // namespace
+
 void SingletonVault::doEagerInitVia(Executor& exe, folly::Baton<>* done) {
   {
     auto state = state_.rlock();
@@ -276,32 +375,115 @@ void SingletonVault::doEagerInitVia(Executor& exe, folly::Baton<>* done) {
     }
   }
 
-  auto eagerInitSingletons = eagerInitSingletons_.rlock();
-  auto countdown =
-      std::make_shared<std::atomic<size_t>>(eagerInitSingletons->size());
-  for (auto* single : *eagerInitSingletons) {
-    // countdown is retained by shared_ptr, and will be alive until last lambda
-    // is done.  notifyBaton is provided by the caller, and expected to remain
-    // present (if it's non-nullptr).  singletonSet can go out of scope but
-    // its values, which are SingletonHolderBase pointers, are alive as long as
-    // SingletonVault is not being destroyed.
-    exe.add([=] {
-      // decrement counter and notify if requested, whether initialization
-      // was successful, was skipped (already initialized), or exception thrown.
-      SCOPE_EXIT {
-        if (--(*countdown) == 0) {
-          if (done != nullptr) {
-            done->post();
-          }
+  // The eager singletons, and the registered singletons they transitively
+  // depend on.
+  std::vector<detail::SingletonHolderBase*> singles;
+  std::unordered_map<detail::SingletonHolderBase*, size_t> indices;
+  std::vector<std::vector<size_t>> dependencies;
+  {
+    auto eagerInitSingletons = eagerInitSingletons_.rlock();
+    auto allDependencies = dependencies_.rlock();
+    auto singletons = singletons_.rlock();
+    for (auto* single : *eagerInitSingletons) {
+      indices.emplace(single, singles.size());
+      singles.push_back(single);
+    }
+    for (size_t i = 0; i < singles.size(); ++i) {
+      dependencies.emplace_back();
+      auto it = allDependencies->find(singles[i]);
+      if (it == allDependencies->end()) {
+        continue;
+      }
+      for (auto* dependency : it->second) {
+        if (!singletons->count(dependency->type())) {
+          continue;
+        }
+        auto inserted = indices.emplace(dependency, singles.size());
+        if (inserted.second) {
+          singles.push_back(dependency);
+        }
+        dependencies[i].push_back(inserted.first->second);
+      }
+    }
+  }
+
+  auto graph = std::make_shared<EagerInitGraph>(singles.size(), exe, done);
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < singles.size(); ++i) {
+    auto& node = graph->nodes[i];
+    node.single = singles[i];
+    node.pending.store(dependencies[i].size(), std::memory_order_relaxed);
+    if (dependencies[i].empty()) {
+      ready.push_back(i);
+    }
+    for (auto dependency : dependencies[i]) {
+      graph->nodes[dependency].dependents.push_back(i);
+    }
+  }
+
+  // Nothing is scheduled if there is a cycle, as it would never complete.
+  std::vector<size_t> pending(singles.size());
+  for (size_t i = 0; i < singles.size(); ++i) {
+    pending[i] = dependencies[i].size();
+  }
+  auto order = ready;
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (auto dependent : graph->nodes[order[i]].dependents) {
+      if (--pending[dependent] == 0) {
+        order.push_back(dependent);
+      }
+    }
+  }
+  if (order.size() != singles.size()) {
+    // Every singleton left pending depends on another one left pending, so
+    // following those dependencies from any of them runs into a cycle.
+    auto it = std::find_if(
+        pending.begin(), pending.end(), [](size_t n) { return n != 0; });
+    std::vector<size_t> path{size_t(it - pending.begin())};
+    std::vector<bool> visited(singles.size());
+    while (!visited[path.back()]) {
+      visited[path.back()] = true;
+      for (auto dependency : dependencies[path.back()]) {
+        if (pending[dependency] != 0) {
+          path.push_back(dependency);
+          break;
         }
-      };
-      // if initialization is in progress in another thread, don't try to init
-      // here.  Otherwise the current thread will block on 'createInstance'.
-      if (!single->creationStarted()) {
-        single->createInstance();
       }
-    });
+    }
+    std::string cycle;
+    auto start = std::find(path.begin(), path.end(), path.back());
+    for (auto node = start; node != path.end(); ++node) {
+      if (node != start) {
+        cycle += " -> ";
+      }
+      cycle += singles[*node]->type().name();
+    }
+    throw std::logic_error(
+        "Circular dependency between eager singletons: " + cycle);
+  }
+
+  if (singles.empty() && done != nullptr) {
+    done->post();
+  }
+  for (auto i : ready) {
+    scheduleEagerInit(graph, i);
+  }
+}
+
+std::vector<SingletonVault::InitTrace> SingletonVault::initTraces() const {
+  std::vector<InitTrace> traces;
+  auto initRecords = initRecords_.rlock();
+  for (const auto& record : *initRecords) {
+    InitTrace trace;
+    trace.name = record.type.name();
+    trace.duration = record.duration;
+    trace.selfDuration = record.selfDuration;
+    for (const auto& dependency : record.dependencies) {
+      trace.dependencies.push_back(dependency.name());
+    }
+    traces.push_back(std::move(trace));
   }
+  return traces;
 }
 
 void SingletonVault::destroyInstances() {
@@ -346,6 +528,7 @@ void SingletonVault::destroyInstances() {
     auto creationOrder = creationOrder_.wlock();
     creationOrder->clear();
   }
+  initRecords_.wlock()->clear();
 }
 
 void SingletonVault::reenableInstances() {
@@ -137,6 +137,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <list>
@@ -249,6 +250,36 @@ void singletonWarnDestroyInstanceLeak(
 
 void singletonPrintDestructionStackTrace(const TypeDescriptor& type);
 
+struct SingletonInitRecord {
+  TypeDescriptor type;
+  std::chrono::nanoseconds duration;
+  std::chrono::nanoseconds selfDuration;
+  std::vector<TypeDescriptor> dependencies;
+};
+
+// Times the creation of a singleton on the calling thread. Singletons whose
+// creation starts while another one's is being timed on the same thread are
+// recorded as its dependencies, and their time is excluded from its
+// selfDuration.
+class SingletonInitTracer {
+ public:
+  explicit SingletonInitTracer(const TypeDescriptor& type) noexcept;
+  ~SingletonInitTracer();
+
+  SingletonInitTracer(const SingletonInitTracer&) = delete;
+  SingletonInitTracer& operator=(const SingletonInitTracer&) = delete;
+
+  // Called once the singleton was created.
+  SingletonInitRecord finish();
+
+ private:
+  TypeDescriptor type_;
+  SingletonInitTracer* parent_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::nanoseconds nested_{0};
+  std::vector<TypeDescriptor> dependencies_;
+};
+
 [[noreturn]] void singletonThrowNullCreator(const std::type_info& type);
 
 [[noreturn]] void singletonThrowGetInvokedAfterDestruction(
@@ -436,6 +467,14 @@ class SingletonVault {
    */
   void addEagerInitSingleton(detail::SingletonHolderBase* entry);
 
+  /**
+   * Called by `Singleton<T>.dependsOn<U>()` to declare that creating entry
+   * uses dependency, so that `doEagerInitVia` creates dependency first.
+   */
+  void addSingletonDependency(
+      detail::SingletonHolderBase* entry,
+      detail::SingletonHolderBase* dependency);
+
   // Mark registration is complete; no more singletons can be
   // registered at this point.
   void registrationComplete();
@@ -453,6 +492,13 @@ class SingletonVault {
    * If baton ptr is not null, its `post` method is called after all
    * early initialization has completed.
    *
+   * Dependencies declared with `Singleton<T>.dependsOn<U>()` are created
+   * first, even if not eager themselves, and a singleton is only scheduled
+   * once all its dependencies were created. Singletons that do not depend on
+   * each other are created concurrently. The executor must outlive the
+   * initialization when dependencies were declared. Throws std::logic_error
+   * if the declared dependencies have a cycle.
+   *
    * If exceptions are thrown during initialization, this method will still
    * `post` the baton to indicate completion.  The exception will not propagate
    * and future attempts to `try_get` or `get_weak` the failed singleton will
@@ -486,6 +532,27 @@ class SingletonVault {
    */
   bool eagerInitComplete() const;
 
+  /**
+   * How long creating a singleton took, whether eagerly or on first use.
+   */
+  struct InitTrace {
+    std::string name;
+    // Including the time spent creating its dependencies, or waiting for
+    // other threads to create them.
+    std::chrono::nanoseconds duration;
+    // duration, less the time spent on its dependencies.
+    std::chrono::nanoseconds selfDuration;
+    // Singletons whose creation started while this one was being created.
+    std::vector<std::string> dependencies;
+  };
+
+  /**
+   * Traces of the singletons created since the last destroyInstances(), in
+   * creation order. Useful to find what slows down startup, and which
+   * dependencies to declare for doEagerInitVia.
+   */
+  std::vector<InitTrace> initTraces() const;
+
   size_t livingSingletonCount() const {
     auto singletons = singletons_.rlock();
 
@@ -547,8 +614,18 @@ class SingletonVault {
       std::unordered_set<detail::SingletonHolderBase*>,
       SharedMutexSuppressTSAN>
       eagerInitSingletons_;
+  Synchronized<
+      std::unordered_map<
+          detail::SingletonHolderBase*,
+          std::vector<detail::SingletonHolderBase*>>,
+      SharedMutexSuppressTSAN>
+      dependencies_;
   Synchronized<std::vector<detail::TypeDescriptor>, SharedMutexSuppressTSAN>
       creationOrder_;
+  Synchronized<
+      std::vector<detail::SingletonInitRecord>,
+      SharedMutexSuppressTSAN>
+      initRecords_;
 
   // Using SharedMutexReadPriority is important here, because we want to make
   // sure we don't block nested singleton creation happening concurrently with
@@ -662,6 +739,26 @@ class Singleton {
     return *this;
   }
 
+  /**
+   * Declare that creating this singleton uses the singleton of type U with
+   * tag UTag, so that "doEagerInitVia" creates that one first, and does not
+   * tie up an executor thread waiting for it.
+   *
+   * Use like:
+   *   Singleton<Foo> gFooInstance =
+   *       Singleton<Foo>(...).shouldEagerInit().dependsOn<Bar>();
+   *
+   * SingletonVault::initTraces() lists the dependencies found at runtime.
+   */
+  template <typename U, typename UTag = detail::DefaultTag>
+  Singleton& dependsOn() {
+    auto vault = SingletonVault::singleton<VaultTag>();
+    vault->addSingletonDependency(
+        &getEntry(),
+        &detail::SingletonHolder<U>::template singleton<UTag, VaultTag>());
+    return *this;
+  }
+
   /**
    * Construct and inject a mock singleton which should be used only from tests.
    * Unlike regular singletons which are initialized once per process lifetime,
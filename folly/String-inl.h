@@ -33,6 +33,11 @@ namespace detail {
 // an octal escape sequence, or 'P' if the character is printable and
 // should be printed as is.
 extern const std::array<char, 256> cEscapeTable;
+
+// Length of the longest prefix of str made of printable characters, which
+// cEscape() copies as is; checks 16 characters at a time where SSE2 is
+// available.
+size_t cEscapeRegularPrefix(StringPiece str);
 } // namespace detail
 
 template <class String>
@@ -46,12 +51,14 @@ void cEscape(StringPiece str, String& out) {
   // backslash) and copy them in one go; this is faster than calling push_back
   // repeatedly.
   while (p != str.end()) {
+    p += detail::cEscapeRegularPrefix(StringPiece(p, str.end()));
+    if (p == str.end()) {
+      break;
+    }
     char c = *p;
     unsigned char v = static_cast<unsigned char>(c);
     char e = detail::cEscapeTable[v];
-    if (e == 'P') { // printable
-      ++p;
-    } else if (e == 'O') { // octal
+    if (e == 'O') { // octal
       out.append(&*last, size_t(p - last));
       esc[1] = '0' + ((v >> 6) & 7);
       esc[2] = '0' + ((v >> 3) & 7);
@@ -161,6 +168,10 @@ namespace detail {
 // 3 = space, replace with '+' in QUERY mode
 // 4 = percent-encode
 extern const std::array<unsigned char, 256> uriEscapeTable;
+
+// Length of the longest prefix of str made of characters which uriEscape()
+// passes through in the given mode.
+size_t uriEscapeRegularPrefix(StringPiece str, UriEscapeMode mode);
 } // namespace detail
 
 template <class String>
@@ -174,14 +185,15 @@ void uriEscape(StringPiece str, String& out, UriEscapeMode mode) {
   auto last = p; // last regular character
   // We advance over runs of passthrough characters and copy them in one go;
   // this is faster than calling push_back repeatedly.
-  unsigned char minEncode = static_cast<unsigned char>(mode);
   while (p != str.end()) {
+    p += detail::uriEscapeRegularPrefix(StringPiece(p, str.end()), mode);
+    if (p == str.end()) {
+      break;
+    }
     char c = *p;
     unsigned char v = static_cast<unsigned char>(c);
     unsigned char discriminator = detail::uriEscapeTable[v];
-    if (LIKELY(discriminator <= minEncode)) {
-      ++p;
-    } else if (mode == UriEscapeMode::QUERY && discriminator == 3) {
+    if (mode == UriEscapeMode::QUERY && discriminator == 3) {
       out.append(&*last, size_t(p - last));
       out.push_back('+');
       ++p;
@@ -255,12 +267,12 @@ inline size_t delimSize(char) {
 inline size_t delimSize(StringPiece s) {
   return s.size();
 }
-inline bool atDelim(const char* s, char c) {
-  return *s == c;
-}
-inline bool atDelim(const char* s, StringPiece sp) {
-  return !std::memcmp(s, sp.start(), sp.size());
+inline size_t findDelim(StringPiece s, char c) {
+  return qfind(s, c);
 }
+// Finds a delimiter of at least 2 characters by comparing its first and last
+// characters at 16 positions at a time where SSE2 is available.
+size_t findDelim(StringPiece s, StringPiece delim);
 
 // These are used to short-circuit internalSplit() in the case of
 // 1-character strings.
@@ -307,19 +319,14 @@ void internalSplit(
   }
 
   size_t tokenStartPos = 0;
-  size_t tokenSize = 0;
-  for (size_t i = 0; i <= strSize - dSize; ++i) {
-    if (atDelim(&s[i], delim)) {
-      if (!ignoreEmpty || tokenSize > 0) {
-        *out++ = to<OutStringT>(sp.subpiece(tokenStartPos, tokenSize));
-      }
-
-      tokenStartPos = i + dSize;
-      tokenSize = 0;
-      i += dSize - 1;
-    } else {
-      ++tokenSize;
+  size_t tokenSize;
+  while ((tokenSize = findDelim(
+              StringPiece(s + tokenStartPos, s + strSize), delim)) !=
+         std::string::npos) {
+    if (!ignoreEmpty || tokenSize > 0) {
+      *out++ = to<OutStringT>(sp.subpiece(tokenStartPos, tokenSize));
     }
+    tokenStartPos += tokenSize + dSize;
   }
   tokenSize = strSize - tokenStartPos;
   if (!ignoreEmpty || tokenSize > 0) {
@@ -551,18 +558,17 @@ void backslashify(
   }
 }
 
+namespace detail {
+// Number of characters in str which are unprintable or backslashes, and in
+// printablePrefix the number of characters before the first of them.
+size_t countUnprintable(StringPiece str, size_t& printablePrefix);
+} // namespace detail
+
 template <class String1, class String2>
 void humanify(const String1& input, String2& output) {
-  size_t numUnprintable = 0;
   size_t numPrintablePrefix = 0;
-  for (unsigned char c : input) {
-    if (c < 0x20 || c > 0x7e || c == '\\') {
-      ++numUnprintable;
-    }
-    if (numUnprintable == 0) {
-      ++numPrintablePrefix;
-    }
-  }
+  size_t numUnprintable = detail::countUnprintable(
+      StringPiece(input.data(), input.size()), numPrintablePrefix);
 
   // hexlify doubles a string's size; backslashify can potentially
   // explode it by 4x.  Now, the printable range of the ascii
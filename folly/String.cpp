@@ -29,6 +29,11 @@
 #include <folly/Portability.h>
 #include <folly/ScopeGuard.h>
 #include <folly/container/Array.h>
+#include <folly/lang/Bits.h>
+
+#if FOLLY_SSE >= 2
+#include <emmintrin.h>
+#endif
 
 namespace folly {
 
@@ -122,6 +127,142 @@ FOLLY_STORAGE_CONSTEXPR decltype(hexTable) hexTable =
 FOLLY_STORAGE_CONSTEXPR decltype(uriEscapeTable) uriEscapeTable =
     make_array_with<256>(string_table_uri_escape_make_item{});
 
+#if FOLLY_SSE >= 2
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+
+__m128i loadBlock(const char* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+uint32_t bits(__m128i m) {
+  return uint32_t(_mm_movemask_epi8(m));
+}
+
+__m128i eq(__m128i v, char c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+// Bytes are compared as signed, so for ascii bounds bytes >= 0x80 are never
+// in range.
+__m128i inRange(__m128i v, char lo, char hi) {
+  return _mm_and_si128(
+      _mm_cmpgt_epi8(v, _mm_set1_epi8(char(lo - 1))),
+      _mm_cmplt_epi8(v, _mm_set1_epi8(char(hi + 1))));
+}
+
+} // namespace
+
+#endif
+
+size_t cEscapeRegularPrefix(StringPiece str) {
+  size_t i = 0;
+#if FOLLY_SSE >= 2
+  for (; i + kBlockSize <= str.size(); i += kBlockSize) {
+    auto v = loadBlock(str.data() + i);
+    auto special = _mm_or_si128(
+        _mm_or_si128(eq(v, '"'), eq(v, '\\')), eq(v, '?'));
+    auto irregular =
+        ~bits(_mm_andnot_si128(special, inRange(v, 0x20, 0x7e))) & 0xffff;
+    if (irregular) {
+      return i + findFirstSet(irregular) - 1;
+    }
+  }
+#endif
+  while (i < str.size() &&
+         cEscapeTable[static_cast<unsigned char>(str[i])] == 'P') {
+    ++i;
+  }
+  return i;
+}
+
+size_t uriEscapeRegularPrefix(StringPiece str, UriEscapeMode mode) {
+  size_t i = 0;
+#if FOLLY_SSE >= 2
+  for (; i + kBlockSize <= str.size(); i += kBlockSize) {
+    auto v = loadBlock(str.data() + i);
+    auto alnum = _mm_or_si128(
+        _mm_or_si128(inRange(v, '0', '9'), inRange(v, 'A', 'Z')),
+        inRange(v, 'a', 'z'));
+    auto punct = _mm_or_si128(
+        _mm_or_si128(eq(v, '-'), eq(v, '_')),
+        _mm_or_si128(eq(v, '.'), eq(v, '~')));
+    auto regular = _mm_or_si128(alnum, punct);
+    if (mode == UriEscapeMode::PATH) {
+      regular = _mm_or_si128(regular, eq(v, '/'));
+    }
+    auto irregular = ~bits(regular) & 0xffff;
+    if (irregular) {
+      return i + findFirstSet(irregular) - 1;
+    }
+  }
+#endif
+  auto const minEncode = static_cast<unsigned char>(mode);
+  while (i < str.size() &&
+         uriEscapeTable[static_cast<unsigned char>(str[i])] <= minEncode) {
+    ++i;
+  }
+  return i;
+}
+
+size_t findDelim(StringPiece s, StringPiece delim) {
+  auto const n = delim.size();
+  assert(n >= 2);
+  size_t i = 0;
+#if FOLLY_SSE >= 2
+  auto const first = _mm_set1_epi8(delim.front());
+  auto const last = _mm_set1_epi8(delim.back());
+  for (; i + n - 1 + kBlockSize <= s.size(); i += kBlockSize) {
+    auto candidates = bits(_mm_and_si128(
+        _mm_cmpeq_epi8(loadBlock(s.data() + i), first),
+        _mm_cmpeq_epi8(loadBlock(s.data() + i + n - 1), last)));
+    while (candidates) {
+      auto j = i + findFirstSet(candidates) - 1;
+      if (!std::memcmp(s.data() + j + 1, delim.data() + 1, n - 2)) {
+        return j;
+      }
+      candidates &= candidates - 1;
+    }
+  }
+#endif
+  for (; i + n <= s.size(); ++i) {
+    if (!std::memcmp(s.data() + i, delim.data(), n)) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+size_t countUnprintable(StringPiece str, size_t& printablePrefix) {
+  size_t count = 0;
+  size_t i = 0;
+  printablePrefix = str.size();
+#if FOLLY_SSE >= 2
+  for (; i + kBlockSize <= str.size(); i += kBlockSize) {
+    auto v = loadBlock(str.data() + i);
+    auto mask = ~bits(_mm_andnot_si128(eq(v, '\\'), inRange(v, 0x20, 0x7e))) &
+        0xffff;
+    if (mask) {
+      if (count == 0) {
+        printablePrefix = i + findFirstSet(mask) - 1;
+      }
+      count += size_t(popcount(mask));
+    }
+  }
+#endif
+  for (; i < str.size(); ++i) {
+    auto c = static_cast<unsigned char>(str[i]);
+    if (c < 0x20 || c > 0x7e || c == '\\') {
+      if (count++ == 0) {
+        printablePrefix = i;
+      }
+    }
+  }
+  return count;
+}
+
 } // namespace detail
 
 static inline bool is_oddspace(char c) {
@@ -611,6 +752,17 @@ void toLowerAscii32(uint32_t& c) {
   c += rotated;
 }
 
+#if FOLLY_SSE >= 2
+void toLowerAscii128(char* str) {
+  auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+  auto upper = _mm_and_si128(
+      _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+      _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+  v = _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(str), v);
+}
+#endif
+
 void toLowerAscii64(uint64_t& c) {
   // 64-bit version of toLower32
   uint64_t rotated = c & uint64_t(0x7f7f7f7f7f7f7f7fL);
@@ -653,6 +805,14 @@ void toLowerAscii(char* str, size_t length) {
     offset += 4;
   }
 
+#if FOLLY_SSE >= 2
+  // Convert 16 characters at a time
+  while (offset + 16 <= length) {
+    toLowerAscii128(str + offset);
+    offset += 16;
+  }
+#endif
+
   // Convert 8 characters at a time
   while (offset + 8 <= length) {
     toLowerAscii64(*(uint64_t*)(str + offset));
@@ -199,7 +199,25 @@ Subprocess::Subprocess(
   if (!executable) {
     executable = argv[0].c_str();
   }
-  spawn(cloneStrings(argv), executable, options, env);
+  std::unique_ptr<const char*[]> envHolder;
+  if (env) {
+    envHolder = cloneStrings(*env);
+  }
+  spawn(cloneStrings(argv).get(), executable, options, envHolder.get());
+}
+
+Subprocess::Subprocess(
+    const char* const* argv,
+    const Options& options,
+    const char* executable,
+    const char* const* env) {
+  if (!argv || !argv[0]) {
+    throw std::invalid_argument("argv must not be empty");
+  }
+  if (!executable) {
+    executable = argv[0];
+  }
+  spawn(argv, executable, options, env);
 }
 
 Subprocess::Subprocess(
@@ -211,7 +229,12 @@ Subprocess::Subprocess(
   }
 
   std::vector<std::string> argv = {"/bin/sh", "-c", cmd};
-  spawn(cloneStrings(argv), argv[0].c_str(), options, env);
+  std::unique_ptr<const char*[]> envHolder;
+  if (env) {
+    envHolder = cloneStrings(*env);
+  }
+  spawn(
+      cloneStrings(argv).get(), argv[0].c_str(), options, envHolder.get());
 }
 
 Subprocess::~Subprocess() {
@@ -235,6 +258,24 @@ struct ChildErrorInfo {
   _exit(errCode);
 }
 
+// Closes the fds in [first, last], ignoring errors.  Uses a single
+// close_range() call where the kernel supports it (Linux 5.9+), as closing
+// them one by one takes a system call per fd in the fd table.  Runs after
+// vfork(), so it must not touch memory shared with the parent.
+void closeFdRange(int first, int last) {
+  if (first > last) {
+    return;
+  }
+#if defined(__linux__) && defined(__NR_close_range)
+  if (syscall(__NR_close_range, first, last, 0) == 0) {
+    return;
+  }
+#endif
+  for (int fd = last; fd >= first; --fd) {
+    ::close(fd);
+  }
+}
+
 } // namespace
 
 void Subprocess::setAllNonBlocking() {
@@ -248,10 +289,10 @@ void Subprocess::setAllNonBlocking() {
 }
 
 void Subprocess::spawn(
-    std::unique_ptr<const char*[]> argv,
+    const char* const* argv,
     const char* executable,
     const Options& optionsIn,
-    const std::vector<std::string>* env) {
+    const char* const* env) {
   if (optionsIn.usePath_ && env) {
     throw std::invalid_argument(
         "usePath() not allowed when overriding environment");
@@ -290,7 +331,7 @@ void Subprocess::spawn(
 
   // Perform the actual work of setting up pipes then forking and
   // executing the child.
-  spawnInternal(std::move(argv), executable, options, env, errFds[1]);
+  spawnInternal(argv, executable, options, env, errFds[1]);
 
   // After spawnInternal() returns the child is alive.  We have to be very
   // careful about throwing after this point.  We are inside the constructor,
@@ -326,10 +367,10 @@ void Subprocess::spawn(
 FOLLY_PUSH_WARNING
 FOLLY_GCC_DISABLE_WARNING("-Wclobbered")
 void Subprocess::spawnInternal(
-    std::unique_ptr<const char*[]> argv,
+    const char* const* argv,
     const char* executable,
     Options& options,
-    const std::vector<std::string>* env,
+    const char* const* env,
     int errFd) {
   // Parent work, pre-fork: create pipes
   std::vector<int> childFds;
@@ -386,17 +427,10 @@ void Subprocess::spawnInternal(
   // Note that the const casts below are legit, per
   // http://pubs.opengroup.org/onlinepubs/009695399/functions/exec.html
 
-  auto argVec = const_cast<char**>(argv.get());
+  auto argVec = const_cast<char**>(argv);
 
   // Set up environment
-  std::unique_ptr<const char*[]> envHolder;
-  char** envVec;
-  if (env) {
-    envHolder = cloneStrings(*env);
-    envVec = const_cast<char**>(envHolder.get());
-  } else {
-    envVec = environ;
-  }
+  char** envVec = env ? const_cast<char**>(env) : environ;
 
   // Block all signals around vfork; see http://ewontfix.com/7/.
   //
@@ -539,11 +573,16 @@ int Subprocess::prepareChild(
   // any fds in options.fdActions_, and don't touch stdin, stdout, stderr.
   // Ignore errors.
   if (options.closeOtherFds_) {
-    for (int fd = getdtablesize() - 1; fd >= 3; --fd) {
-      if (options.fdActions_.count(fd) == 0) {
-        ::close(fd);
+    // fdActions_ is sorted, so close the ranges between the fds it keeps.
+    int maxFd = getdtablesize() - 1;
+    int first = 3;
+    for (auto& p : options.fdActions_) {
+      if (p.first >= first) {
+        closeFdRange(first, std::min(p.first - 1, maxFd));
+        first = p.first + 1;
       }
     }
+    closeFdRange(first, maxFd);
   }
 
 #if __linux__
@@ -534,6 +534,19 @@ class Subprocess {
       const Options& options = Options(),
       const char* executable = nullptr,
       const std::vector<std::string>* env = nullptr);
+
+  /**
+   * Like the constructor above, but argv and env are null-terminated arrays
+   * of C strings, as execve() takes them.  Programs spawning the same
+   * command many times can build these once and reuse them for every spawn,
+   * instead of having each spawn copy them out of strings.  They only need
+   * to stay valid until the constructor returns.
+   */
+  explicit Subprocess(
+      const char* const* argv,
+      const Options& options = Options(),
+      const char* executable = nullptr,
+      const char* const* env = nullptr);
   ~Subprocess();
 
   /**
@@ -935,15 +948,15 @@ class Subprocess {
   // spawnInternal() returns it reads the error pipe to see if the child
   // encountered any errors.
   void spawn(
-      std::unique_ptr<const char*[]> argv,
+      const char* const* argv,
       const char* executable,
       const Options& options,
-      const std::vector<std::string>* env);
+      const char* const* env);
   void spawnInternal(
-      std::unique_ptr<const char*[]> argv,
+      const char* const* argv,
       const char* executable,
       Options& options,
-      const std::vector<std::string>* env,
+      const char* const* env,
       int errFd);
 
   // Actions to run in child.
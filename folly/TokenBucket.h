@@ -20,6 +20,7 @@
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include <folly/Likely.h>
 #include <folly/Optional.h>
@@ -512,7 +513,226 @@ class BasicTokenBucket {
   double burstSize_;
 };
 
+/**
+ * Token bucket with a fixed rate and burst size for many threads.
+ *
+ * All operations of BasicTokenBucket update one atomic, whose cache line
+ * bounces between the cores of the threads using the bucket. Here, every
+ * core has a shard that caches up to about batchSize tokens, taken from a
+ * central BasicDynamicTokenBucket in batches. Most consume() calls only
+ * touch the shard of the current core, and the central bucket is only
+ * updated once per batch. When the central bucket runs out, the shard
+ * records when it will have enough tokens again, and consume() fails until
+ * then without writing to any shared state.
+ *
+ * The tradeoff is precision: tokens cached in a shard are not available to
+ * the other shards, and do not expire. The burst seen by clients can exceed
+ * burstSize by the tokens cached in shards, approximately the number of
+ * shards (L1 caches) times batchSize, and consume() can fail while other
+ * shards have tokens. Pick batchSize well below burstSize / number of
+ * cores, e.g. the tokens used in a millisecond by one core.
+ *
+ * @tparam Clock Clock type, must be steady i.e. monotonic.
+ */
+template <typename Clock = std::chrono::steady_clock>
+class BasicShardedTokenBucket {
+  static_assert(Clock::is_steady, "clock must be steady");
+
+ private:
+  using Impl = BasicDynamicTokenBucket<Clock>;
+
+ public:
+  /**
+   * @param genRate Number of tokens to generate per second.
+   * @param burstSize Maximum burst size of the central bucket. Must be
+   *                  greater than 0.
+   * @param batchSize Number of tokens a shard takes from the central bucket
+   *                  at once. Must be greater than 0.
+   * @param zeroTime Initial time at which to consider the token bucket
+   *                 starting to fill. Defaults to 0, so by default token
+   *                 bucket is "full" after construction.
+   */
+  BasicShardedTokenBucket(
+      double genRate,
+      double burstSize,
+      double batchSize,
+      double zeroTime = 0)
+      : tokenBucket_(zeroTime),
+        rate_(genRate),
+        burstSize_(burstSize),
+        batchSize_(std::min(batchSize, burstSize)),
+        shards_(CacheLocality::system().numCachesByLevel[0]) {
+    assert(rate_ > 0);
+    assert(burstSize_ > 0);
+    assert(batchSize_ > 0);
+  }
+
+  BasicShardedTokenBucket(const BasicShardedTokenBucket&) = delete;
+  BasicShardedTokenBucket& operator=(const BasicShardedTokenBucket&) = delete;
+
+  /**
+   * Returns the current time in seconds since Epoch.
+   */
+  static double defaultClockNow() noexcept(noexcept(Impl::defaultClockNow())) {
+    return Impl::defaultClockNow();
+  }
+
+  /**
+   * Attempts to consume some number of tokens, from the shard of the current
+   * core if it has enough, otherwise from the central bucket.
+   *
+   * Thread-safe.
+   *
+   * @param toConsume The number of tokens to consume.
+   * @param nowInSeconds Current time in seconds. Should be monotonically
+   *                     increasing from the nowInSeconds specified in
+   *                     this token bucket's constructor.
+   * @return True if the rate limit check passed, false otherwise.
+   */
+  bool consume(double toConsume, double nowInSeconds = defaultClockNow()) {
+    auto& shard = currentShard();
+    if (takeFromShard(shard, toConsume)) {
+      return true;
+    }
+    if (nowInSeconds < shard.denyUntil.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    return consumeSlow(shard, toConsume, nowInSeconds);
+  }
+
+  /**
+   * Returns tokens to the shard of the current core. Whatever the shard
+   * would hold beyond batchSize goes back to the central bucket.
+   *
+   * Thread-safe.
+   */
+  void returnTokens(double tokensToReturn) {
+    assert(tokensToReturn > 0);
+    auto& shard = currentShard();
+    refillShard(shard, tokensToReturn, batchSize_);
+    clearDenyUntil(shard);
+  }
+
+  /**
+   * Returns the number of tokens currently available, in the central bucket
+   * and all shards.
+   *
+   * Thread-safe (but returned value may immediately be outdated).
+   */
+  double available(double nowInSeconds = defaultClockNow()) const {
+    double tokens = tokenBucket_.available(rate_, burstSize_, nowInSeconds);
+    for (auto& shard : shards_) {
+      tokens += shard.tokens.load(std::memory_order_relaxed);
+    }
+    return tokens;
+  }
+
+  double rate() const noexcept {
+    return rate_;
+  }
+
+  double burst() const noexcept {
+    return burstSize_;
+  }
+
+  double batch() const noexcept {
+    return batchSize_;
+  }
+
+ private:
+  struct alignas(hardware_destructive_interference_size) Shard {
+    std::atomic<double> tokens{0};
+    // consume() fails without trying the central bucket before this time
+    std::atomic<double> denyUntil{0};
+  };
+
+  Shard& currentShard() {
+    return shards_[AccessSpreader<>::cachedCurrent(shards_.size())];
+  }
+
+  static bool takeFromShard(Shard& shard, double toConsume) {
+    double tokens = shard.tokens.load(std::memory_order_relaxed);
+    while (tokens >= toConsume) {
+      if (shard.tokens.compare_exchange_weak(
+              tokens, tokens - toConsume, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Adds tokens to the shard, up to maxTokens, and the rest to the central
+  // bucket
+  void refillShard(Shard& shard, double toAdd, double maxTokens) {
+    double tokens = shard.tokens.load(std::memory_order_relaxed);
+    double tokensNew;
+    do {
+      tokensNew = std::min(tokens + toAdd, std::max(tokens, maxTokens));
+    } while (UNLIKELY(!shard.tokens.compare_exchange_weak(
+        tokens, tokensNew, std::memory_order_relaxed)));
+    double excess = tokens + toAdd - tokensNew;
+    if (excess > 0) {
+      tokenBucket_.returnTokens(excess, rate_);
+      // The central bucket may now have the tokens other shards are waiting
+      // for
+      for (auto& other : shards_) {
+        clearDenyUntil(other);
+      }
+    }
+  }
+
+  static void clearDenyUntil(Shard& shard) {
+    if (shard.denyUntil.load(std::memory_order_relaxed) != 0) {
+      shard.denyUntil.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  FOLLY_NOINLINE bool
+  consumeSlow(Shard& shard, double toConsume, double nowInSeconds) {
+    if (UNLIKELY(toConsume > burstSize_)) {
+      return false;
+    }
+    // Reading the central bucket is cheap while it stays unmodified, so find
+    // out whether this can succeed before modifying it
+    double avail = tokenBucket_.available(rate_, burstSize_, nowInSeconds);
+    if (avail + shard.tokens.load(std::memory_order_relaxed) >= toConsume) {
+      double consumed = tokenBucket_.consumeOrDrain(
+          std::min(toConsume + batchSize_, burstSize_),
+          rate_,
+          burstSize_,
+          nowInSeconds);
+      if (consumed >= toConsume) {
+        if (consumed > toConsume) {
+          refillShard(shard, consumed - toConsume, batchSize_);
+        }
+        return true;
+      }
+      // Pool what we got with the shard's tokens
+      if (consumed > 0) {
+        refillShard(shard, consumed, std::max(batchSize_, toConsume));
+      }
+      if (takeFromShard(shard, toConsume)) {
+        return true;
+      }
+      avail = 0;
+    }
+    double missing =
+        toConsume - avail - shard.tokens.load(std::memory_order_relaxed);
+    shard.denyUntil.store(
+        nowInSeconds + std::max(missing, 0.0) / rate_,
+        std::memory_order_relaxed);
+    return false;
+  }
+
+  Impl tokenBucket_;
+  const double rate_;
+  const double burstSize_;
+  const double batchSize_;
+  std::vector<Shard> shards_;
+};
+
 using TokenBucket = BasicTokenBucket<>;
 using DynamicTokenBucket = BasicDynamicTokenBucket<>;
+using ShardedTokenBucket = BasicShardedTokenBucket<>;
 
 } // namespace folly
@@ -15,7 +15,15 @@
  */
 
 #include <folly/Unicode.h>
+
 #include <folly/Conv.h>
+#include <folly/CpuId.h>
+#include <folly/Portability.h>
+#include <folly/lang/Bits.h>
+
+#if FOLLY_X64 && !defined(_MSC_VER)
+#include <immintrin.h>
+#endif
 
 namespace folly {
 
@@ -149,6 +157,324 @@ char32_t utf8ToCodePoint(
   throw std::runtime_error("folly::utf8ToCodePoint encoding length maxed out");
 }
 
+namespace {
+
+constexpr uint64_t kAsciiMask = 0x8080808080808080;
+
+const unsigned char* skipAscii(
+    const unsigned char* p,
+    const unsigned char* const e) {
+  while (e - p >= 8 && !(loadUnaligned<uint64_t>(p) & kAsciiMask)) {
+    p += 8;
+  }
+  while (p != e && *p < 0x80) {
+    ++p;
+  }
+  return p;
+}
+
+// Decode the non-ASCII code point at p, which must be before e, into cp.
+// Returns the length of its sequence, or 0 if the sequence is malformed or
+// truncated.
+size_t decodeUtf8Sequence(
+    const unsigned char* p,
+    const unsigned char* const e,
+    char32_t& cp) {
+  unsigned char const fst = *p;
+  size_t n;
+  if (fst < 0xC2) {
+    // A continuation byte, or an overlong 2-byte sequence.
+    return 0;
+  } else if (fst < 0xE0) {
+    n = 2;
+    cp = fst & 0x1F;
+  } else if (fst < 0xF0) {
+    n = 3;
+    cp = fst & 0x0F;
+  } else if (fst < 0xF5) {
+    n = 4;
+    cp = fst & 0x07;
+  } else {
+    return 0;
+  }
+  if (size_t(e - p) < n) {
+    return 0;
+  }
+  for (size_t i = 1; i != n; ++i) {
+    if ((p[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+    cp = (cp << 6) | (p[i] & 0x3F);
+  }
+  if (n == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) {
+    return 0;
+  }
+  if (n == 4 && (cp < 0x10000 || cp > 0x10FFFF)) {
+    return 0;
+  }
+  return n;
+}
+
+const unsigned char* utf8ValidPrefixScalar(
+    const unsigned char* p,
+    const unsigned char* const e) {
+  while ((p = skipAscii(p, e)) != e) {
+    char32_t cp;
+    auto const n = decodeUtf8Sequence(p, e, cp);
+    if (n == 0) {
+      break;
+    }
+    p += n;
+  }
+  return p;
+}
+
+#if FOLLY_X64 && !defined(_MSC_VER)
+
+// The lookup algorithm from "Validating UTF-8 In Less Than One Instruction
+// Per Byte" (Keiser, Lemire). Every error is a property of a pair of
+// adjacent bytes, found by looking up the high nibble of the first byte, its
+// low nibble and the high nibble of the second in three tables and and-ing
+// the results; only "a 3rd or 4th byte is missing or extra" also depends on
+// the bytes two and three positions back.
+constexpr uint8_t kTooShort = 1 << 0; // lead byte not followed by 10______
+constexpr uint8_t kTooLong = 1 << 1; // ASCII followed by 10______
+constexpr uint8_t kOverlong3 = 1 << 2; // 11100000 100_____
+constexpr uint8_t kTooLarge = 1 << 3; // 11110100 1001____ and above
+constexpr uint8_t kSurrogate = 1 << 4; // 11101101 101_____
+constexpr uint8_t kOverlong2 = 1 << 5; // 1100000_ 10______
+constexpr uint8_t kTooLarge1000 = 1 << 6; // 11110101 1000____ and above
+constexpr uint8_t kOverlong4 = 1 << 6; // 11110000 1000____
+constexpr uint8_t kTwoConts = 1 << 7; // 10______ 10______
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+// Validate whole 16-byte blocks starting at p, until the first one which
+// contains an error or the last one. Returns a code point boundary after
+// which the input is still to be validated.
+FOLLY_TARGET_ATTRIBUTE("ssse3")
+const unsigned char* utf8ValidPrefixSsse3(
+    const unsigned char* const b,
+    const unsigned char* const e) {
+  // clang-format off
+  __m128i const byte1High = _mm_setr_epi8(
+      // 0_______ <ASCII>
+      kTooLong, kTooLong, kTooLong, kTooLong,
+      kTooLong, kTooLong, kTooLong, kTooLong,
+      // 10______ <continuation>
+      char(kTwoConts), char(kTwoConts), char(kTwoConts), char(kTwoConts),
+      // 1100____ <two byte lead>
+      kTooShort | kOverlong2,
+      // 1101____ <two byte lead>
+      kTooShort,
+      // 1110____ <three byte lead>
+      kTooShort | kOverlong3 | kSurrogate,
+      // 1111____ <four byte lead>
+      kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+  __m128i const byte1Low = _mm_setr_epi8(
+      // ____0000
+      char(kCarry | kOverlong3 | kOverlong2 | kOverlong4),
+      // ____0001
+      char(kCarry | kOverlong2),
+      // ____001_
+      char(kCarry), char(kCarry),
+      // ____0100
+      char(kCarry | kTooLarge),
+      // ____0101 and above
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      // ____1101
+      char(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+      char(kCarry | kTooLarge | kTooLarge1000),
+      char(kCarry | kTooLarge | kTooLarge1000));
+  __m128i const byte2High = _mm_setr_epi8(
+      // 0_______ <ASCII>
+      kTooShort, kTooShort, kTooShort, kTooShort,
+      kTooShort, kTooShort, kTooShort, kTooShort,
+      // 1000____
+      char(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+           kOverlong4),
+      // 1001____
+      char(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+      // 101_____
+      char(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+      char(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+      // 11______
+      kTooShort, kTooShort, kTooShort, kTooShort);
+  // Bytes above these in the last 3 positions start a sequence which
+  // continues into the next block.
+  __m128i const incompleteMax = _mm_setr_epi8(
+      char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+      char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+      char(0xFF), char(0xFF), char(0xFF), char(0xFF),
+      char(0xFF), char(0xEF), char(0xDF), char(0xBF));
+  // clang-format on
+  __m128i const nibble = _mm_set1_epi8(0x0F);
+  __m128i const zero = _mm_setzero_si128();
+
+  auto p = b;
+  __m128i prev = zero;
+  bool prevIncomplete = false;
+  for (; e - p >= 16; p += 16) {
+    __m128i const in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    if (_mm_movemask_epi8(in) == 0 && !prevIncomplete) {
+      prev = in;
+      continue;
+    }
+    __m128i const prev1 = _mm_alignr_epi8(in, prev, 15);
+    __m128i const special = _mm_and_si128(
+        _mm_and_si128(
+            _mm_shuffle_epi8(
+                byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+            _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+        _mm_shuffle_epi8(
+            byte2High, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+    // Only 111_____ and 1111____ stay >= 0x80 after these subtractions.
+    __m128i const third =
+        _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8(0x60));
+    __m128i const fourth =
+        _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8(0x70));
+    __m128i const mustBeContinuation =
+        _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(char(0x80)));
+    __m128i const error = _mm_xor_si128(mustBeContinuation, special);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF) {
+      break;
+    }
+    prev = in;
+    prevIncomplete = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                         _mm_subs_epu8(in, incompleteMax), zero)) != 0xFFFF;
+  }
+
+  // Everything before p is valid, except for a sequence which may start in
+  // the last 3 bytes and continue past p; back up to its lead byte.
+  auto boundary = p;
+  while (boundary != b && p - boundary < 3 && (boundary[-1] & 0xC0) == 0x80) {
+    --boundary;
+  }
+  if (boundary != b && boundary[-1] >= 0xC0) {
+    --boundary;
+  }
+  return boundary;
+}
+
+#endif
+
+[[noreturn]] void throwInvalidUtf8(const char* fn, size_t offset) {
+  throw std::runtime_error(
+      to<std::string>(fn, " invalid UTF-8 at offset ", offset));
+}
+
+} // namespace
+
+size_t utf8ValidPrefixLength(StringPiece input) {
+  auto const b = reinterpret_cast<const unsigned char*>(input.begin());
+  auto const e = reinterpret_cast<const unsigned char*>(input.end());
+  auto p = b;
+#if FOLLY_X64 && !defined(_MSC_VER)
+  static bool const hasSsse3 = CpuId().ssse3();
+  if (hasSsse3 && input.size() >= 16) {
+    p = utf8ValidPrefixSsse3(b, e);
+  }
+#endif
+  return size_t(utf8ValidPrefixScalar(p, e) - b);
+}
+
+std::u16string utf8ToUtf16(StringPiece input) {
+  auto const b = reinterpret_cast<const unsigned char*>(input.begin());
+  auto const e = reinterpret_cast<const unsigned char*>(input.end());
+  // Every sequence has at least as many bytes as it has UTF-16 code units.
+  std::u16string result(input.size(), u'\0');
+  auto out = &result[0];
+  auto p = b;
+  while (p != e) {
+    while (e - p >= 8 && !(loadUnaligned<uint64_t>(p) & kAsciiMask)) {
+      for (size_t i = 0; i != 8; ++i) {
+        out[i] = p[i];
+      }
+      p += 8;
+      out += 8;
+    }
+    if (p == e) {
+      break;
+    }
+    if (*p < 0x80) {
+      *out++ = *p++;
+      continue;
+    }
+    char32_t cp;
+    auto const n = decodeUtf8Sequence(p, e, cp);
+    if (n == 0) {
+      throwInvalidUtf8("folly::utf8ToUtf16", size_t(p - b));
+    }
+    p += n;
+    if (cp < 0x10000) {
+      *out++ = static_cast<char16_t>(cp);
+    } else {
+      *out++ = static_cast<char16_t>(0xD800 + ((cp - 0x10000) >> 10));
+      *out++ = static_cast<char16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+    }
+  }
+  result.resize(size_t(out - result.data()));
+  return result;
+}
+
+std::string utf16ToUtf8(Range<const char16_t*> input) {
+  constexpr uint64_t kAsciiUnitsMask = 0xFF80FF80FF80FF80;
+  // Every code unit takes at most 3 bytes, a surrogate pair takes 4.
+  std::string result(input.size() * 3, '\0');
+  auto out = reinterpret_cast<unsigned char*>(&result[0]);
+  auto p = input.begin();
+  auto const e = input.end();
+  while (p != e) {
+    while (e - p >= 4 && !(loadUnaligned<uint64_t>(p) & kAsciiUnitsMask)) {
+      for (size_t i = 0; i != 4; ++i) {
+        out[i] = static_cast<unsigned char>(p[i]);
+      }
+      p += 4;
+      out += 4;
+    }
+    if (p == e) {
+      break;
+    }
+    char32_t cp = *p++;
+    if (cp < 0x80) {
+      *out++ = static_cast<unsigned char>(cp);
+      continue;
+    }
+    if (cp >= 0xD800 && cp <= 0xDFFF) {
+      if (cp >= 0xDC00 || p == e || *p < 0xDC00 || *p > 0xDFFF) {
+        throw std::runtime_error(to<std::string>(
+            "folly::utf16ToUtf8 unpaired surrogate at offset ",
+            p - 1 - input.begin()));
+      }
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (*p++ - 0xDC00);
+    }
+    if (cp < 0x800) {
+      out[0] = static_cast<unsigned char>(0xC0 | (cp >> 6));
+      out[1] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+      out += 2;
+    } else if (cp < 0x10000) {
+      out[0] = static_cast<unsigned char>(0xE0 | (cp >> 12));
+      out[1] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+      out[2] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+      out += 3;
+    } else {
+      out[0] = static_cast<unsigned char>(0xF0 | (cp >> 18));
+      out[1] = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+      out[2] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+      out[3] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+      out += 4;
+    }
+  }
+  result.resize(size_t(out - reinterpret_cast<unsigned char*>(&result[0])));
+  return result;
+}
+
 //////////////////////////////////////////////////////////////////////
 
 } // namespace folly
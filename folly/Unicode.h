@@ -20,6 +20,8 @@
 
 #include <string>
 
+#include <folly/Range.h>
+
 namespace folly {
 
 //////////////////////////////////////////////////////////////////////
@@ -39,6 +41,30 @@ char32_t utf8ToCodePoint(
     const unsigned char* const e,
     bool skipOnError);
 
+/*
+ * Return the length of the longest prefix of `input' which is a sequence of
+ * complete, well-formed UTF-8 code points, as defined by RFC 3629: overlong
+ * encodings, surrogates and code points above U+10FFFF are rejected. This is
+ * input.size() iff the whole input is valid.
+ *
+ * ASCII runs are skipped a word at a time, and on x86-64 CPUs with SSSE3
+ * whole 16-byte blocks of mixed text are validated at once, so this is much
+ * faster than decoding with utf8ToCodePoint().
+ */
+size_t utf8ValidPrefixLength(StringPiece input);
+
+inline bool isValidUtf8(StringPiece input) {
+  return utf8ValidPrefixLength(input) == input.size();
+}
+
+/*
+ * Transcode between UTF-8 and UTF-16, copying ASCII runs without decoding
+ * them. Throws std::runtime_error on malformed UTF-8 (as for
+ * utf8ValidPrefixLength()) or on an unpaired UTF-16 surrogate.
+ */
+std::u16string utf8ToUtf16(StringPiece input);
+std::string utf16ToUtf8(Range<const char16_t*> input);
+
 //////////////////////////////////////////////////////////////////////
 
 } // namespace folly
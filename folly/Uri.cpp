@@ -19,83 +19,150 @@
 #include <algorithm>
 #include <cctype>
 
-#include <boost/regex.hpp>
-
 namespace folly {
 
 namespace {
 
-std::string submatch(const boost::cmatch& m, int idx) {
-  const auto& sub = m[idx];
-  return std::string(sub.first, sub.second);
+bool isSchemeChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '+' ||
+      c == '.' || c == '-';
+}
+
+// Split "[username[:password]@]host[:port]", where host is either an
+// IP-literal in square brackets (e.g. '['+IPv6+']'), or a dotted IPv4
+// address or host name without '[' or ':'. Returns false if authority
+// doesn't match.
+bool parseHostAndPort(
+    StringPiece authority,
+    StringPiece& host,
+    StringPiece& port) {
+  size_t hostEnd;
+  if (!authority.empty() && authority.front() == '[') {
+    hostEnd = authority.find(']');
+    if (hostEnd == StringPiece::npos) {
+      return false;
+    }
+    ++hostEnd;
+  } else {
+    hostEnd = std::min(authority.find('['), authority.find(':'));
+    hostEnd = std::min(hostEnd, authority.size());
+  }
+  host = authority.subpiece(0, hostEnd);
+  port = authority.subpiece(hostEnd);
+  if (port.empty()) {
+    return true;
+  }
+  if (port.front() != ':') {
+    return false;
+  }
+  port.advance(1);
+  return std::all_of(port.begin(), port.end(), [](char c) {
+    return c >= '0' && c <= '9';
+  });
 }
 
 } // namespace
 
-Uri::Uri(StringPiece str) : hasAuthority_(false), port_(0) {
-  static const boost::regex uriRegex(
-      "([a-zA-Z][a-zA-Z0-9+.-]*):" // scheme:
-      "([^?#]*)" // authority and path
-      "(?:\\?([^#]*))?" // ?query
-      "(?:#(.*))?"); // #fragment
-  static const boost::regex authorityAndPathRegex("//([^/]*)(/.*)?");
-
-  boost::cmatch match;
-  if (UNLIKELY(!boost::regex_match(str.begin(), str.end(), match, uriRegex))) {
+UriView::UriView(StringPiece str) {
+  // scheme:authority-and-path[?query][#fragment]
+  auto const schemeEnd = str.find(':');
+  if (UNLIKELY(
+          schemeEnd == StringPiece::npos || schemeEnd == 0 ||
+          !std::isalpha(static_cast<unsigned char>(str.front())) ||
+          !std::all_of(str.begin(), str.begin() + schemeEnd, isSchemeChar))) {
     throw std::invalid_argument(to<std::string>("invalid URI ", str));
   }
+  scheme_ = str.subpiece(0, schemeEnd);
+
+  auto rest = str.subpiece(schemeEnd + 1);
+  auto const pathEnd = std::min(rest.find_first_of("?#"), rest.size());
+  auto authorityAndPath = rest.subpiece(0, pathEnd);
+  rest.advance(pathEnd);
+  if (rest.removePrefix('?')) {
+    auto const queryEnd = std::min(rest.find('#'), rest.size());
+    query_ = rest.subpiece(0, queryEnd);
+    rest.advance(queryEnd);
+  }
+  if (rest.removePrefix('#')) {
+    fragment_ = rest;
+  }
 
-  scheme_ = submatch(match, 1);
-  std::transform(scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
-
-  StringPiece authorityAndPath(match[2].first, match[2].second);
-  boost::cmatch authorityAndPathMatch;
-  if (!boost::regex_match(
-          authorityAndPath.begin(),
-          authorityAndPath.end(),
-          authorityAndPathMatch,
-          authorityAndPathRegex)) {
+  if (!authorityAndPath.removePrefix("//")) {
     // Does not start with //, doesn't have authority
-    hasAuthority_ = false;
-    path_ = authorityAndPath.str();
-  } else {
-    static const boost::regex authorityRegex(
-        "(?:([^@:]*)(?::([^@]*))?@)?" // username, password
-        "(\\[[^\\]]*\\]|[^\\[:]*)" // host (IP-literal (e.g. '['+IPv6+']',
-                                   // dotted-IPv4, or named host)
-        "(?::(\\d*))?"); // port
-
-    const auto authority = authorityAndPathMatch[1];
-    boost::cmatch authorityMatch;
-    if (!boost::regex_match(
-            authority.first,
-            authority.second,
-            authorityMatch,
-            authorityRegex)) {
-      throw std::invalid_argument(to<std::string>(
-          "invalid URI authority ",
-          StringPiece(authority.first, authority.second)));
-    }
+    path_ = authorityAndPath;
+    return;
+  }
 
-    StringPiece port(authorityMatch[4].first, authorityMatch[4].second);
-    if (!port.empty()) {
-      try {
-        port_ = to<uint16_t>(port);
-      } catch (ConversionError const& e) {
-        throw std::invalid_argument(
-            to<std::string>("invalid URI port: ", e.what()));
+  auto const authorityEnd =
+      std::min(authorityAndPath.find('/'), authorityAndPath.size());
+  auto const authority = authorityAndPath.subpiece(0, authorityEnd);
+  path_ = authorityAndPath.subpiece(authorityEnd);
+
+  // The user info ends at the first '@', and its username at the first ':'
+  // before that. If the rest isn't a valid host and port, there may be no
+  // user info, and the '@' is part of the host.
+  StringPiece port;
+  bool parsed = false;
+  auto const at = authority.find('@');
+  if (at != StringPiece::npos) {
+    auto const userInfo = authority.subpiece(0, at);
+    auto const colon = userInfo.find(':');
+    parsed = parseHostAndPort(authority.subpiece(at + 1), host_, port);
+    if (parsed) {
+      username_ = userInfo.subpiece(0, colon);
+      if (colon != StringPiece::npos) {
+        password_ = userInfo.subpiece(colon + 1);
       }
     }
+  }
+  if (!parsed && !parseHostAndPort(authority, host_, port)) {
+    throw std::invalid_argument(
+        to<std::string>("invalid URI authority ", authority));
+  }
 
-    hasAuthority_ = true;
-    username_ = submatch(authorityMatch, 1);
-    password_ = submatch(authorityMatch, 2);
-    host_ = submatch(authorityMatch, 3);
-    path_ = submatch(authorityAndPathMatch, 2);
+  if (!port.empty()) {
+    try {
+      port_ = to<uint16_t>(port);
+    } catch (ConversionError const& e) {
+      throw std::invalid_argument(
+          to<std::string>("invalid URI port: ", e.what()));
+    }
   }
+  hasAuthority_ = true;
+}
 
-  query_ = submatch(match, 3);
-  fragment_ = submatch(match, 4);
+void UriView::QueryParamIterator::advance() {
+  // Parameters are separated by '&'. Those with an empty name, or with more
+  // than one '=', are skipped.
+  while (next_ != nullptr) {
+    auto const segmentEnd = std::find(next_, end_, '&');
+    StringPiece segment(next_, segmentEnd);
+    next_ = segmentEnd == end_ ? nullptr : segmentEnd + 1;
+
+    auto const eq = segment.find('=');
+    auto name = segment.subpiece(0, eq);
+    auto value = eq == StringPiece::npos ? StringPiece(segment.end(), segment.end())
+                                         : segment.subpiece(eq + 1);
+    if (!name.empty() && value.find('=') == StringPiece::npos) {
+      param_ = QueryParam{name, value};
+      return;
+    }
+  }
+  param_ = QueryParam();
+}
+
+Uri::Uri(StringPiece str) : hasAuthority_(false), port_(0) {
+  UriView view(str);
+  scheme_ = view.scheme().str();
+  std::transform(scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
+  hasAuthority_ = view.hasAuthority();
+  username_ = view.username().str();
+  password_ = view.password().str();
+  host_ = view.host().str();
+  port_ = view.port();
+  path_ = view.path().str();
+  query_ = view.query().str();
+  fragment_ = view.fragment().str();
 }
 
 std::string Uri::authority() const {
@@ -128,7 +195,7 @@ std::string Uri::authority() const {
 std::string Uri::hostname() const {
   if (host_.size() > 0 && host_[0] == '[') {
     // If it starts with '[', then it should end with ']', this is ensured by
-    // regex
+    // the parser
     return host_.substr(1, host_.size() - 2);
   }
   return host_;
@@ -136,25 +203,8 @@ std::string Uri::hostname() const {
 
 const std::vector<std::pair<std::string, std::string>>& Uri::getQueryParams() {
   if (!query_.empty() && queryParams_.empty()) {
-    // Parse query string
-    static const boost::regex queryParamRegex(
-        "(^|&)" /*start of query or start of parameter "&"*/
-        "([^=&]*)=?" /*parameter name and "=" if value is expected*/
-        "([^=&]*)" /*parameter value*/
-        "(?=(&|$))" /*forward reference, next should be end of query or
-                      start of next parameter*/);
-    const boost::cregex_iterator paramBeginItr(
-        query_.data(), query_.data() + query_.size(), queryParamRegex);
-    boost::cregex_iterator paramEndItr;
-    for (auto itr = paramBeginItr; itr != paramEndItr; ++itr) {
-      if (itr->length(2) == 0) {
-        // key is empty, ignore it
-        continue;
-      }
-      queryParams_.emplace_back(
-          std::string((*itr)[2].first, (*itr)[2].second), // parameter name
-          std::string((*itr)[3].first, (*itr)[3].second) // parameter value
-      );
+    for (UriView::QueryParamIterator it(query_), end; it != end; ++it) {
+      queryParams_.emplace_back(it->name.str(), it->value.str());
     }
   }
   return queryParams_;
@@ -17,6 +17,7 @@
 #pragma once
 #define FOLLY_URI_H_
 
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,158 @@
 
 namespace folly {
 
+/**
+ * A URI parsed into views of the string it was parsed from: the same
+ * components as Uri below, but as StringPieces, so parsing doesn't allocate.
+ * The string must outlive the UriView.
+ *
+ * Unlike Uri, the scheme is not lower-cased. As with Uri, the components are
+ * NOT percent-decoded, except on request for query parameters.
+ */
+class UriView {
+ public:
+  /**
+   * Parse a URI from a string.  Throws std::invalid_argument on parse error.
+   */
+  explicit UriView(StringPiece str);
+
+  StringPiece scheme() const {
+    return scheme_;
+  }
+  StringPiece username() const {
+    return username_;
+  }
+  StringPiece password() const {
+    return password_;
+  }
+  /**
+   * Get host part of URI. If host is an IPv6 address, square brackets will be
+   * returned, for example: "[::1]".
+   */
+  StringPiece host() const {
+    return host_;
+  }
+  /**
+   * Get host part of URI, without the square brackets of an IPv6 address, as
+   * Uri::hostname() does.
+   */
+  StringPiece hostname() const {
+    if (!host_.empty() && host_.front() == '[') {
+      return host_.subpiece(1, host_.size() - 2);
+    }
+    return host_;
+  }
+  uint16_t port() const {
+    return port_;
+  }
+  StringPiece path() const {
+    return path_;
+  }
+  StringPiece query() const {
+    return query_;
+  }
+  StringPiece fragment() const {
+    return fragment_;
+  }
+  bool hasAuthority() const {
+    return hasAuthority_;
+  }
+
+  /**
+   * A query parameter, see Uri::getQueryParams(). The name and value are
+   * percent-decoded (in UriEscapeMode::QUERY) only when asked for.
+   */
+  struct QueryParam {
+    StringPiece name;
+    StringPiece value;
+
+    std::string decodedName() const {
+      return uriUnescape<std::string>(name, UriEscapeMode::QUERY);
+    }
+    std::string decodedValue() const {
+      return uriUnescape<std::string>(value, UriEscapeMode::QUERY);
+    }
+  };
+
+  /**
+   * Forward iterator over the query parameters, which finds the next one as
+   * it's incremented.
+   */
+  class QueryParamIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = QueryParam;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const QueryParam*;
+    using reference = const QueryParam&;
+
+    /// The end iterator.
+    QueryParamIterator() = default;
+
+    /// An iterator to the first parameter of `query`.
+    explicit QueryParamIterator(StringPiece query)
+        : next_(query.begin()), end_(query.end()) {
+      if (!query.empty()) {
+        advance();
+      }
+    }
+
+    reference operator*() const {
+      return param_;
+    }
+    pointer operator->() const {
+      return &param_;
+    }
+    QueryParamIterator& operator++() {
+      advance();
+      return *this;
+    }
+    QueryParamIterator operator++(int) {
+      auto result = *this;
+      advance();
+      return result;
+    }
+
+    friend bool operator==(
+        const QueryParamIterator& a,
+        const QueryParamIterator& b) {
+      // Parameter names are never empty, and they identify the position.
+      return a.param_.name.begin() == b.param_.name.begin();
+    }
+    friend bool operator!=(
+        const QueryParamIterator& a,
+        const QueryParamIterator& b) {
+      return !(a == b);
+    }
+
+   private:
+    void advance();
+
+    const char* next_ = nullptr;
+    const char* end_ = nullptr;
+    QueryParam param_;
+  };
+
+  /**
+   * The query parameters that Uri::getQueryParams() returns, in the same
+   * order, without copying or decoding them.
+   */
+  Range<QueryParamIterator> queryParams() const {
+    return {QueryParamIterator(query_), QueryParamIterator()};
+  }
+
+ private:
+  StringPiece scheme_;
+  StringPiece username_;
+  StringPiece password_;
+  StringPiece host_;
+  StringPiece path_;
+  StringPiece query_;
+  StringPiece fragment_;
+  uint16_t port_{0};
+  bool hasAuthority_{false};
+};
+
 /**
  * Class representing a URI.
  *
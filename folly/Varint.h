@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <cstring>
+#include <stdexcept>
 #include <type_traits>
 
 #include <folly/Conv.h>
@@ -24,6 +26,10 @@
 #include <folly/Portability.h>
 #include <folly/Range.h>
 
+#if FOLLY_SSE >= 2
+#include <immintrin.h>
+#endif
+
 namespace folly {
 
 /**
@@ -104,8 +110,246 @@ inline int64_t decodeZigZag(uint64_t val) {
   return static_cast<int64_t>((val >> 1) ^ -(val & 1));
 }
 
+/**
+ * Bulk versions of the functions above, for arrays of uint32_t or uint64_t.
+ * The encoding is the same as that of one encodeVarint() call per value.
+ *
+ * encodeVarints() encodes n values to buf, which must have room for
+ * n * kMaxVarintLength64 bytes (n * kMaxVarintLength32 for uint32_t), and
+ * returns the number of bytes used.
+ *
+ * tryDecodeVarints() decodes up to n values into out, advances data past
+ * them, and returns how many it decoded: fewer than n if data ends, or
+ * holds an invalid varint, where data is then left. decodeVarints() throws
+ * like decodeVarint() unless it decodes all n values. Values wider than the
+ * output type are truncated.
+ *
+ * Decoding looks at 16 bytes at a time (32 with AVX2), and converts runs of
+ * values that are encoded in a single byte with a few vector instructions.
+ */
+template <class Int>
+size_t encodeVarints(const Int* values, size_t n, uint8_t* buf);
+
+template <class T, class Int>
+size_t tryDecodeVarints(Range<T*>& data, Int* out, size_t n);
+
+template <class T, class Int>
+void decodeVarints(Range<T*>& data, Int* out, size_t n);
+
+/**
+ * Bulk ZigZag encoding of int32_t or int64_t values, see encodeZigZag().
+ */
+template <class Int>
+size_t encodeZigZagVarints(const Int* values, size_t n, uint8_t* buf);
+
+template <class T, class Int>
+void decodeZigZagVarints(Range<T*>& data, Int* out, size_t n);
+
+/**
+ * Bulk delta encoding of sorted sequences of uint32_t or uint64_t values.
+ * The first value is encoded as is, and every other value as its difference
+ * from the value before it. Each value must therefore be greater than or
+ * equal to the previous one.
+ */
+template <class Int>
+size_t encodeDeltaVarints(const Int* values, size_t n, uint8_t* buf);
+
+template <class T, class Int>
+void decodeDeltaVarints(Range<T*>& data, Int* out, size_t n);
+
 // Implementation below
 
+namespace detail {
+
+[[noreturn]] inline void throwDecodeVarintError(DecodeVarintError error) {
+  throw std::invalid_argument(
+      error == DecodeVarintError::TooManyBytes
+          ? "Invalid varint value: too many bytes."
+          : "Invalid varint value: too few bytes.");
+}
+
+template <class Int>
+inline void checkBulkVarintType() {
+  static_assert(
+      std::is_same<Int, uint32_t>::value || std::is_same<Int, uint64_t>::value,
+      "Only uint32_t and uint64_t values are supported");
+}
+
+// Encodes f(values[i]), calling f once per value, in order
+template <class Src, class F>
+size_t encodeVarintsWith(const Src* values, size_t n, uint8_t* buf, F f) {
+  constexpr size_t kBlock = 8;
+  uint8_t* p = buf;
+  size_t i = 0;
+  for (; i + kBlock <= n; i += kBlock) {
+    uint64_t block[kBlock];
+    uint64_t any = 0;
+    for (size_t j = 0; j < kBlock; ++j) {
+      block[j] = f(values[i + j]);
+      any |= block[j];
+    }
+    if (any < 128) {
+      for (size_t j = 0; j < kBlock; ++j) {
+        p[j] = uint8_t(block[j]);
+      }
+      p += kBlock;
+    } else {
+      for (size_t j = 0; j < kBlock; ++j) {
+        p += encodeVarint(block[j], p);
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    p += encodeVarint(f(values[i]), p);
+  }
+  return size_t(p - buf);
+}
+
+#if FOLLY_SSE >= 2
+#ifdef __AVX2__
+constexpr size_t kVarintBlockSize = 32;
+
+inline uint32_t varintContinuationMask(const uint8_t* p) {
+  return uint32_t(
+      _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)p)));
+}
+
+// Zero-extends kVarintBlockSize bytes from p to out
+inline void widenVarintBlock(const uint8_t* p, uint32_t* out) {
+  for (size_t i = 0; i < kVarintBlockSize; i += 8) {
+    __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p + i)));
+    _mm256_storeu_si256((__m256i*)(out + i), v);
+  }
+}
+
+inline void widenVarintBlock(const uint8_t* p, uint64_t* out) {
+  for (size_t i = 0; i < kVarintBlockSize; i += 4) {
+    uint32_t bytes;
+    std::memcpy(&bytes, p + i, sizeof(bytes));
+    __m256i v = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(int(bytes)));
+    _mm256_storeu_si256((__m256i*)(out + i), v);
+  }
+}
+#else
+constexpr size_t kVarintBlockSize = 16;
+
+inline uint32_t varintContinuationMask(const uint8_t* p) {
+  return uint32_t(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)));
+}
+
+inline void widenVarintBlock(const uint8_t* p, uint32_t* out) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i lo = _mm_unpacklo_epi8(v, zero);
+  __m128i hi = _mm_unpackhi_epi8(v, zero);
+  _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(lo, zero));
+  _mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(lo, zero));
+  _mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(hi, zero));
+  _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(hi, zero));
+}
+
+inline void widenVarintBlock(const uint8_t* p, uint64_t* out) {
+  __m128i zero = _mm_setzero_si128();
+  uint32_t wide[kVarintBlockSize];
+  widenVarintBlock(p, wide);
+  for (size_t i = 0; i < kVarintBlockSize; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(wide + i));
+    _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi32(v, zero));
+    _mm_storeu_si128((__m128i*)(out + i + 2), _mm_unpackhi_epi32(v, zero));
+  }
+}
+#endif
+#endif
+
+template <class Int>
+size_t
+decodeVarintsImpl(const uint8_t*& p, const uint8_t* end, Int* out, size_t n) {
+  size_t i = 0;
+  auto decodeOne = [&] {
+    Range<const uint8_t*> r(p, end);
+    auto val = tryDecodeVarint(r);
+    if (!val) {
+      return false;
+    }
+    out[i++] = Int(*val);
+    p = r.begin();
+    return true;
+  };
+
+#if FOLLY_SSE >= 2
+  while (n - i >= kVarintBlockSize && size_t(end - p) >= kVarintBlockSize) {
+    uint32_t mask = varintContinuationMask(p);
+    if (mask == 0) {
+      widenVarintBlock(p, out + i);
+      p += kVarintBlockSize;
+      i += kVarintBlockSize;
+      continue;
+    }
+    // the values before the first continuation byte take one byte each,
+    // and the next one several
+    size_t k = size_t(__builtin_ctz(mask));
+    for (size_t j = 0; j < k; ++j) {
+      out[i + j] = p[j];
+    }
+    p += k;
+    i += k;
+    if (!decodeOne()) {
+      return i;
+    }
+  }
+#endif
+
+  while (i < n) {
+    if (p != end && *p < 128) {
+      out[i++] = *p++;
+    } else if (!decodeOne()) {
+      break;
+    }
+  }
+  return i;
+}
+
+template <class T>
+const uint8_t* varintDataBegin(const Range<T*>& data) {
+  static_assert(
+      std::is_same<typename std::remove_cv<T>::type, char>::value ||
+          std::is_same<typename std::remove_cv<T>::type, unsigned char>::value,
+      "Only character ranges are supported");
+  return reinterpret_cast<const uint8_t*>(data.begin());
+}
+
+// Running sum of out, in place
+inline void prefixSumVarints(uint32_t* out, size_t n) {
+  size_t i = 0;
+  uint32_t prev = 0;
+#if FOLLY_SSE >= 2
+  __m128i carry = _mm_setzero_si128();
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(out + i));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi32(v, carry);
+    _mm_storeu_si128((__m128i*)(out + i), v);
+    carry = _mm_shuffle_epi32(v, 0xff);
+  }
+  if (i != 0) {
+    prev = out[i - 1];
+  }
+#endif
+  for (; i < n; ++i) {
+    prev = out[i] += prev;
+  }
+}
+
+inline void prefixSumVarints(uint64_t* out, size_t n) {
+  uint64_t prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    prev = out[i] += prev;
+  }
+}
+
+} // namespace detail
+
 inline size_t encodeVarint(uint64_t val, uint8_t* buf) {
   uint8_t* p = buf;
   while (val >= 128) {
@@ -135,10 +379,7 @@ template <class T>
 inline uint64_t decodeVarint(Range<T*>& data) {
   auto expected = tryDecodeVarint(data);
   if (!expected) {
-    throw std::invalid_argument(
-        expected.error() == DecodeVarintError::TooManyBytes
-            ? "Invalid varint value: too many bytes."
-            : "Invalid varint value: too few bytes.");
+    detail::throwDecodeVarintError(expected.error());
   }
   return *expected;
 }
@@ -227,4 +468,66 @@ inline Expected<uint64_t, DecodeVarintError> tryDecodeVarint(Range<T*>& data) {
   return val;
 }
 
+template <class Int>
+inline size_t encodeVarints(const Int* values, size_t n, uint8_t* buf) {
+  detail::checkBulkVarintType<Int>();
+  return detail::encodeVarintsWith(
+      values, n, buf, [](Int val) { return uint64_t(val); });
+}
+
+template <class T, class Int>
+inline size_t tryDecodeVarints(Range<T*>& data, Int* out, size_t n) {
+  detail::checkBulkVarintType<Int>();
+  const uint8_t* begin = detail::varintDataBegin(data);
+  const uint8_t* p = begin;
+  size_t count = detail::decodeVarintsImpl(p, begin + data.size(), out, n);
+  data.uncheckedAdvance(size_t(p - begin));
+  return count;
+}
+
+template <class T, class Int>
+inline void decodeVarints(Range<T*>& data, Int* out, size_t n) {
+  if (tryDecodeVarints(data, out, n) != n) {
+    auto rest = data;
+    detail::throwDecodeVarintError(tryDecodeVarint(rest).error());
+  }
+}
+
+template <class Int>
+inline size_t encodeZigZagVarints(const Int* values, size_t n, uint8_t* buf) {
+  static_assert(
+      std::is_same<Int, int32_t>::value || std::is_same<Int, int64_t>::value,
+      "Only int32_t and int64_t values are supported");
+  return detail::encodeVarintsWith(
+      values, n, buf, [](Int val) { return encodeZigZag(val); });
+}
+
+template <class T, class Int>
+inline void decodeZigZagVarints(Range<T*>& data, Int* out, size_t n) {
+  using Unsigned = typename std::make_unsigned<Int>::type;
+  // signed and unsigned variants of a type may alias
+  auto encoded = reinterpret_cast<Unsigned*>(out);
+  decodeVarints(data, encoded, n);
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<Int>(decodeZigZag(encoded[i]));
+  }
+}
+
+template <class Int>
+inline size_t encodeDeltaVarints(const Int* values, size_t n, uint8_t* buf) {
+  detail::checkBulkVarintType<Int>();
+  Int prev = 0;
+  return detail::encodeVarintsWith(values, n, buf, [&](Int val) {
+    auto delta = uint64_t(Int(val - prev));
+    prev = val;
+    return delta;
+  });
+}
+
+template <class T, class Int>
+inline void decodeDeltaVarints(Range<T*>& data, Int* out, size_t n) {
+  decodeVarints(data, out, n);
+  detail::prefixSumVarints(out, n);
+}
+
 } // namespace folly
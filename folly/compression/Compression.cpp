@@ -55,6 +55,7 @@
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
 #include <folly/Varint.h>
+#include <folly/compression/CompressionContextPoolSingletons.h>
 #include <folly/compression/Utils.h>
 #include <folly/io/Cursor.h>
 #include <folly/lang/Bits.h>
@@ -65,6 +66,8 @@
 using folly::io::compression::detail::dataStartsWithLE;
 using folly::io::compression::detail::prefixToStringLE;
 
+namespace contexts = folly::compression::contexts;
+
 namespace folly {
 namespace io {
 
@@ -210,6 +213,43 @@ std::unique_ptr<IOBuf> Codec::uncompress(
   return result;
 }
 
+void Codec::uncompress(
+    const IOBuf* data,
+    IOBufQueue& out,
+    Optional<uint64_t> uncompressedLength) {
+  if (data == nullptr) {
+    throw std::invalid_argument("Codec: data must not be nullptr");
+  }
+  if (!uncompressedLength) {
+    if (needsUncompressedLength()) {
+      throw std::invalid_argument("Codec: uncompressed length required");
+    }
+  } else if (*uncompressedLength > maxUncompressedLength()) {
+    throw std::runtime_error("Codec: uncompressed length too large");
+  }
+
+  if (data->empty()) {
+    if (uncompressedLength.value_or(0) != 0) {
+      throw std::runtime_error("Codec: invalid uncompressed length");
+    }
+    return;
+  }
+
+  auto const queueLength = [&out] {
+    return out.empty() ? 0 : out.front()->computeChainDataLength();
+  };
+  bool const logging = folly::Random::oneIn(kLoggingRate);
+  folly::Optional<Timer> const timer =
+      logging ? Timer(decompressionMilliseconds_) : folly::Optional<Timer>();
+  size_t const lengthBefore = logging ? queueLength() : 0;
+  doUncompressInto(data, out, uncompressedLength);
+  if (logging) {
+    decompressions_++;
+    bytesBeforeDecompression_ += data->computeChainDataLength();
+    bytesAfterDecompression_ += queueLength() - lengthBefore;
+  }
+}
+
 std::string Codec::uncompress(
     const StringPiece data,
     Optional<uint64_t> uncompressedLength) {
@@ -271,6 +311,13 @@ bool Codec::canUncompress(
   return canUncompress(&buf, uncompressedLength);
 }
 
+void Codec::doUncompressInto(
+    const IOBuf* data,
+    IOBufQueue& out,
+    Optional<uint64_t> uncompressedLength) {
+  out.append(doUncompress(data, uncompressedLength));
+}
+
 std::string Codec::doCompressString(const StringPiece data) {
   const IOBuf inputBuffer{IOBuf::WRAP_BUFFER, data};
   auto outputBuffer = doCompress(&inputBuffer);
@@ -508,6 +555,16 @@ static uint64_t computeBufferLength(
 std::unique_ptr<IOBuf> StreamCodec::doUncompress(
     IOBuf const* data,
     Optional<uint64_t> uncompressedLength) {
+  IOBufQueue queue;
+  doUncompressInto(data, queue, uncompressedLength);
+  auto buffer = queue.move();
+  return buffer ? std::move(buffer) : IOBuf::create(0);
+}
+
+void StreamCodec::doUncompressInto(
+    IOBuf const* data,
+    IOBufQueue& out,
+    Optional<uint64_t> uncompressedLength) {
   auto constexpr kMaxSingleStepLength = uint64_t(64) << 20; // 64 MB
   auto constexpr kBlockSize = uint64_t(128) << 10;
   auto const defaultBufferLength =
@@ -516,17 +573,22 @@ std::unique_ptr<IOBuf> StreamCodec::doUncompress(
   uncompressedLength = getUncompressedLength(data, uncompressedLength);
   resetStream(uncompressedLength);
 
+  // Uses the tailroom of out before allocating any buffer.
   MutableByteRange output;
-  auto buffer = addOutputBuffer(
-      output,
-      (uncompressedLength && *uncompressedLength <= kMaxSingleStepLength
-           ? *uncompressedLength
-           : defaultBufferLength));
+  auto const preallocate = [&](uint64_t length) {
+    auto const space = out.preallocate(1, std::max<uint64_t>(length, 1));
+    output = {static_cast<uint8_t*>(space.first), space.second};
+  };
+  preallocate(
+      uncompressedLength && *uncompressedLength <= kMaxSingleStepLength
+          ? *uncompressedLength
+          : defaultBufferLength);
 
-  // Uncompress the entire IOBuf chain into the IOBuf chain pointed to by buffer
+  // Uncompress the entire IOBuf chain into out
   IOBuf const* current = data;
   ByteRange input{current->data(), current->length()};
   StreamCodec::FlushOp flushOp = StreamCodec::FlushOp::NONE;
+  uint64_t length = 0;
   bool done = false;
   while (!done) {
     while (input.empty() && current->next() != data) {
@@ -538,21 +600,19 @@ std::unique_ptr<IOBuf> StreamCodec::doUncompress(
       flushOp = StreamCodec::FlushOp::END;
     }
     if (output.empty()) {
-      buffer->prependChain(addOutputBuffer(output, defaultBufferLength));
+      preallocate(defaultBufferLength);
     }
+    auto const* const begin = output.data();
     done = uncompressStream(input, output, flushOp);
+    out.postallocate(output.data() - begin);
+    length += output.data() - begin;
   }
   if (!input.empty()) {
     throw std::runtime_error("Codec: Junk after end of data");
   }
-
-  buffer->prev()->trimEnd(output.size());
-  if (uncompressedLength &&
-      *uncompressedLength != buffer->computeChainDataLength()) {
+  if (uncompressedLength && *uncompressedLength != length) {
     throw std::runtime_error("Codec: invalid uncompressed length");
   }
-
-  return buffer;
 }
 
 namespace {
@@ -657,6 +717,10 @@ void lz4_stream_t_deleter(LZ4_stream_t* ctx) {
 void lz4_streamhc_t_deleter(LZ4_streamHC_t* ctx) {
   LZ4_freeStreamHC(ctx);
 }
+
+void lz4f_cdict_deleter(LZ4F_CDict* cdict) {
+  LZ4F_freeCDict(cdict);
+}
 } // namespace
 #endif
 
@@ -839,7 +903,10 @@ std::unique_ptr<IOBuf> LZ4Codec::doUncompress(
 class LZ4FrameCodec final : public Codec {
  public:
   static std::unique_ptr<Codec> create(int level, CodecType type);
-  explicit LZ4FrameCodec(int level, CodecType type);
+  explicit LZ4FrameCodec(
+      int level,
+      CodecType type,
+      std::shared_ptr<std::string const> dictionary = nullptr);
   ~LZ4FrameCodec() override;
 
   std::vector<std::string> validPrefixes() const override;
@@ -858,10 +925,20 @@ class LZ4FrameCodec final : public Codec {
   void resetDCtx();
 
   int level_;
+  std::shared_ptr<std::string const> dictionary_;
+#ifdef FOLLY_USE_LZ4_FAST_RESET
+  // The digested dictionary_, if any.
+  std::unique_ptr<
+      LZ4F_CDict,
+      folly::static_function_deleter<LZ4F_CDict, lz4f_cdict_deleter>>
+      cdict_;
+#endif
+  // Taken from the pools on first use and returned when the codec is
+  // destroyed, unless an error left them in the middle of a frame.
 #ifdef FOLLY_USE_LZ4_FAST_RESET
-  LZ4F_compressionContext_t cctx_{nullptr};
+  contexts::LZ4F_CCtx_Pool::Ref cctx_{contexts::getNULL_LZ4F_CCtx()};
 #endif
-  LZ4F_decompressionContext_t dctx_{nullptr};
+  contexts::LZ4F_DCtx_Pool::Ref dctx_{contexts::getNULL_LZ4F_DCtx()};
   bool dirty_{false};
 };
 
@@ -902,9 +979,9 @@ void LZ4FrameCodec::resetDCtx() {
     return;
   }
   if (dctx_) {
-    LZ4F_freeDecompressionContext(dctx_);
+    contexts::LZ4F_DCtx_Deleter()(dctx_.release());
   }
-  lz4FrameThrowOnError(LZ4F_createDecompressionContext(&dctx_, 100));
+  dctx_ = contexts::getLZ4F_DCtx();
   dirty_ = false;
 }
 
@@ -919,20 +996,31 @@ static int lz4fConvertLevel(int level) {
   return level;
 }
 
-LZ4FrameCodec::LZ4FrameCodec(int level, CodecType type)
-    : Codec(type, lz4fConvertLevel(level)), level_(lz4fConvertLevel(level)) {
+LZ4FrameCodec::LZ4FrameCodec(
+    int level,
+    CodecType type,
+    std::shared_ptr<std::string const> dictionary)
+    : Codec(type, lz4fConvertLevel(level)),
+      level_(lz4fConvertLevel(level)),
+      dictionary_(std::move(dictionary)) {
   DCHECK(type == CodecType::LZ4_FRAME);
+  if (dictionary_) {
+#ifdef FOLLY_USE_LZ4_FAST_RESET
+    cdict_.reset(LZ4F_createCDict(dictionary_->data(), dictionary_->size()));
+    if (!cdict_) {
+      throw std::bad_alloc{};
+    }
+#else
+    throw std::invalid_argument(
+        "LZ4FrameCodec: dictionaries require lz4 >= 1.8.2 static APIs");
+#endif
+  }
 }
 
 LZ4FrameCodec::~LZ4FrameCodec() {
-  if (dctx_) {
-    LZ4F_freeDecompressionContext(dctx_);
-  }
-#ifdef FOLLY_USE_LZ4_FAST_RESET
-  if (cctx_) {
-    LZ4F_freeCompressionContext(cctx_);
+  if (dctx_ && dirty_) {
+    contexts::LZ4F_DCtx_Deleter()(dctx_.release());
   }
-#endif
 }
 
 std::unique_ptr<IOBuf> LZ4FrameCodec::doCompress(const IOBuf* data) {
@@ -945,7 +1033,7 @@ std::unique_ptr<IOBuf> LZ4FrameCodec::doCompress(const IOBuf* data) {
 
 #ifdef FOLLY_USE_LZ4_FAST_RESET
   if (!cctx_) {
-    lz4FrameThrowOnError(LZ4F_createCompressionContext(&cctx_, LZ4F_VERSION));
+    cctx_ = contexts::getLZ4F_CCtx();
   }
 #endif
 
@@ -959,12 +1047,12 @@ std::unique_ptr<IOBuf> LZ4FrameCodec::doCompress(const IOBuf* data) {
   const size_t written = lz4FrameThrowOnError(
 #ifdef FOLLY_USE_LZ4_FAST_RESET
       LZ4F_compressFrame_usingCDict(
-          cctx_,
+          cctx_->ctx,
           buf->writableTail(),
           buf->tailroom(),
           data->data(),
           data->length(),
-          nullptr,
+          cdict_.get(),
           &prefs)
 #else
       LZ4F_compressFrame(
@@ -1023,8 +1111,23 @@ std::unique_ptr<IOBuf> LZ4FrameCodec::doUncompress(
     std::tie(out, outSize) = queue.preallocate(blockSize, growthSize);
     // Decompress
     size_t inSize = in.size();
-    code = lz4FrameThrowOnError(
-        LZ4F_decompress(dctx_, out, &outSize, in.data(), &inSize, &options));
+#ifdef FOLLY_USE_LZ4_FAST_RESET
+    if (dictionary_) {
+      code = lz4FrameThrowOnError(LZ4F_decompress_usingDict(
+          dctx_->ctx,
+          out,
+          &outSize,
+          in.data(),
+          &inSize,
+          dictionary_->data(),
+          dictionary_->size(),
+          &options));
+    } else
+#endif
+    {
+      code = lz4FrameThrowOnError(LZ4F_decompress(
+          dctx_->ctx, out, &outSize, in.data(), &inSize, &options));
+    }
     if (in.empty() && outSize == 0 && code != 0) {
       // We passed no input, no output was produced, and the frame isn't over
       // No more forward progress is possible
@@ -1212,8 +1315,10 @@ class LZMA2StreamCodec final : public StreamCodec {
   bool flushVarintBuffer(MutableByteRange& output);
   void resetVarintBuffer();
 
-  Optional<lzma_stream> cstream_{};
-  Optional<lzma_stream> dstream_{};
+  // Taken from the pools on first use and returned when the codec is
+  // destroyed.
+  contexts::LZMA_Stream_Pool::Ref cstream_{contexts::getNULL_LZMA_Stream()};
+  contexts::LZMA_Stream_Pool::Ref dstream_{contexts::getNULL_LZMA_Stream()};
 
   std::array<uint8_t, kMaxVarintLength64> varintBuffer_;
   ByteRange varintToEncode_;
@@ -1281,16 +1386,7 @@ LZMA2StreamCodec::LZMA2StreamCodec(int level, CodecType type)
   level_ = level;
 }
 
-LZMA2StreamCodec::~LZMA2StreamCodec() {
-  if (cstream_) {
-    lzma_end(cstream_.get_pointer());
-    cstream_.clear();
-  }
-  if (dstream_) {
-    lzma_end(dstream_.get_pointer());
-    dstream_.clear();
-  }
-}
+LZMA2StreamCodec::~LZMA2StreamCodec() = default;
 
 uint64_t LZMA2StreamCodec::doMaxUncompressedLength() const {
   // From lzma/base.h: "Stream is roughly 8 EiB (2^63 bytes)"
@@ -1309,10 +1405,10 @@ void LZMA2StreamCodec::doResetStream() {
 
 void LZMA2StreamCodec::resetCStream() {
   if (!cstream_) {
-    cstream_.assign(LZMA_STREAM_INIT);
+    cstream_ = contexts::getLZMA_EncoderStream();
   }
   lzma_ret const rc =
-      lzma_easy_encoder(cstream_.get_pointer(), level_, LZMA_CHECK_NONE);
+      lzma_easy_encoder(cstream_.get(), level_, LZMA_CHECK_NONE);
   if (rc != LZMA_OK) {
     throw std::runtime_error(folly::to<std::string>(
         "LZMA2StreamCodec: lzma_easy_encoder error: ", rc));
@@ -1321,10 +1417,10 @@ void LZMA2StreamCodec::resetCStream() {
 
 void LZMA2StreamCodec::resetDStream() {
   if (!dstream_) {
-    dstream_.assign(LZMA_STREAM_INIT);
+    dstream_ = contexts::getLZMA_DecoderStream();
   }
   lzma_ret const rc = lzma_auto_decoder(
-      dstream_.get_pointer(), std::numeric_limits<uint64_t>::max(), 0);
+      dstream_.get(), std::numeric_limits<uint64_t>::max(), 0);
   if (rc != LZMA_OK) {
     throw std::runtime_error(folly::to<std::string>(
         "LZMA2StreamCodec: lzma_auto_decoder error: ", rc));
@@ -1411,7 +1507,7 @@ bool LZMA2StreamCodec::doCompressStream(
     output.uncheckedAdvance(output.size() - cstream_->avail_out);
   };
   lzma_ret const rc = lzmaThrowOnError(
-      lzma_code(cstream_.get_pointer(), lzmaTranslateFlush(flushOp)));
+      lzma_code(cstream_.get(), lzmaTranslateFlush(flushOp)));
   switch (flushOp) {
     case StreamCodec::FlushOp::NONE:
       return false;
@@ -1502,10 +1598,10 @@ bool LZMA2StreamCodec::doUncompressStream(
   switch (flushOp) {
     case StreamCodec::FlushOp::NONE:
     case StreamCodec::FlushOp::FLUSH:
-      rc = lzmaThrowOnError(lzma_code(dstream_.get_pointer(), LZMA_RUN));
+      rc = lzmaThrowOnError(lzma_code(dstream_.get(), LZMA_RUN));
       break;
     case StreamCodec::FlushOp::END:
-      rc = lzmaThrowOnError(lzma_code(dstream_.get_pointer(), LZMA_FINISH));
+      rc = lzmaThrowOnError(lzma_code(dstream_.get(), LZMA_FINISH));
       break;
     default:
       throw std::invalid_argument("LZMA2StreamCodec: invalid flush");
@@ -2156,5 +2252,21 @@ std::unique_ptr<Codec> getAutoUncompressionCodec(
   return AutomaticCodec::create(
       std::move(customCodecs), std::move(terminalCodec));
 }
+
+std::unique_ptr<Codec> getLZ4FrameCodecWithDictionary(
+    std::shared_ptr<std::string const> dictionary,
+    int level) {
+  if (!dictionary) {
+    throw std::invalid_argument("LZ4FrameCodec: null dictionary");
+  }
+#if (FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301)
+  return std::make_unique<LZ4FrameCodec>(
+      level, CodecType::LZ4_FRAME, std::move(dictionary));
+#else
+  (void)level;
+  throw std::invalid_argument(to<std::string>(
+      "Compression type ", CodecType::LZ4_FRAME, " not supported"));
+#endif
+}
 } // namespace io
 } // namespace folly
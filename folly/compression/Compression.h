@@ -26,6 +26,7 @@
 #include <folly/Range.h>
 #include <folly/compression/Counters.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 
 /**
  * Compression / decompression over IOBufs
@@ -183,6 +184,21 @@ class Codec {
       const IOBuf* data,
       folly::Optional<uint64_t> uncompressedLength = folly::none);
 
+  /**
+   * Uncompress data, appending the output to `out`. Has the same error
+   * semantics as the version returning an IOBuf, but `out` may hold partial
+   * output if it throws.
+   *
+   * Stream codecs uncompress directly into the tailroom of `out`, and append
+   * buffers to it as they run out of space, so no buffer is ever reallocated
+   * or copied, even when the uncompressed length is unknown. Other codecs
+   * append the output of uncompress().
+   */
+  void uncompress(
+      const IOBuf* data,
+      IOBufQueue& out,
+      folly::Optional<uint64_t> uncompressedLength = folly::none);
+
   /**
    * Uncompresses data. May involve additional copies compared to the overload
    * that takes and returns IOBufs. Has the same error semantics as the IOBuf
@@ -259,6 +275,11 @@ class Codec {
   virtual std::unique_ptr<IOBuf> doUncompress(
       const folly::IOBuf* data,
       folly::Optional<uint64_t> uncompressedLength) = 0;
+  // default: appends the output of doUncompress().
+  virtual void doUncompressInto(
+      const folly::IOBuf* data,
+      IOBufQueue& out,
+      folly::Optional<uint64_t> uncompressedLength);
   // default: an implementation is provided by default to wrap the strings into
   // IOBufs and delegate to the IOBuf methods. This incurs a copy of the output
   // from IOBuf to string. Implementers, at their discretion, can override
@@ -422,6 +443,10 @@ class StreamCodec : public Codec {
   std::unique_ptr<IOBuf> doUncompress(
       const folly::IOBuf* data,
       folly::Optional<uint64_t> uncompressedLength) override;
+  void doUncompressInto(
+      const folly::IOBuf* data,
+      IOBufQueue& out,
+      folly::Optional<uint64_t> uncompressedLength) override;
 
   // default: Returns false
   virtual bool doNeedsDataLength() const;
@@ -547,6 +572,18 @@ bool hasCodec(CodecType type);
  */
 bool hasStreamCodec(CodecType type);
 
+/**
+ * Return an LZ4_FRAME codec which compresses with the raw content
+ * `dictionary`, and decompresses frames compressed with the same dictionary.
+ * LZ4 frames don't identify their dictionary, so both sides must agree on it.
+ * lz4 only uses the last 64 KiB of the dictionary. It is digested when the
+ * codec is created, so reuse the codec. Throws std::invalid_argument if lz4
+ * is too old or was built without its static-linking-only APIs.
+ */
+std::unique_ptr<Codec> getLZ4FrameCodecWithDictionary(
+    std::shared_ptr<std::string const> dictionary,
+    int level = COMPRESSION_LEVEL_DEFAULT);
+
 /**
  * Added here so users of folly can figure out whether the singletons are
  * usable, and therefore whether to even try to include the header.
@@ -16,16 +16,33 @@
 
 #include <folly/compression/CompressionContextPoolSingletons.h>
 
+#include <new>
+
 namespace folly {
 namespace compression {
 namespace contexts {
 
 namespace {
 // These objects have no static dependencies and therefore no SIOF issues.
+#if FOLLY_HAVE_LIBZSTD
 ZSTD_CCtx_Pool zstd_cctx_pool_singleton;
 ZSTD_DCtx_Pool zstd_dctx_pool_singleton;
+#endif
+#if FOLLY_HAVE_LIBZ
+ZLIB_DeflateStream_Pool zlib_deflate_pool_singleton;
+ZLIB_InflateStream_Pool zlib_inflate_pool_singleton;
+#endif
+#if FOLLY_HAVE_LIBLZMA
+LZMA_Stream_Pool lzma_encoder_pool_singleton;
+LZMA_Stream_Pool lzma_decoder_pool_singleton;
+#endif
+#if FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
+LZ4F_CCtx_Pool lz4f_cctx_pool_singleton;
+LZ4F_DCtx_Pool lz4f_dctx_pool_singleton;
+#endif
 } // anonymous namespace
 
+#if FOLLY_HAVE_LIBZSTD
 ZSTD_CCtx* ZSTD_CCtx_Creator::operator()() const noexcept {
   return ZSTD_createCCtx();
 }
@@ -57,6 +74,123 @@ ZSTD_CCtx_Pool::Ref getNULL_ZSTD_CCtx() {
 ZSTD_DCtx_Pool::Ref getNULL_ZSTD_DCtx() {
   return zstd_dctx_pool_singleton.getNull();
 }
+#endif // FOLLY_HAVE_LIBZSTD
+
+#if FOLLY_HAVE_LIBZ
+// The streams are initialized by the codecs, which know their parameters.
+ZLIB_DeflateStream* ZLIB_DeflateStream_Creator::operator()() const noexcept {
+  return new (std::nothrow) ZLIB_DeflateStream();
+}
+
+ZLIB_InflateStream* ZLIB_InflateStream_Creator::operator()() const noexcept {
+  return new (std::nothrow) ZLIB_InflateStream();
+}
+
+void ZLIB_DeflateStream_Deleter::operator()(
+    ZLIB_DeflateStream* stream) const noexcept {
+  if (stream->initialized) {
+    deflateEnd(stream);
+  }
+  delete stream;
+}
+
+void ZLIB_InflateStream_Deleter::operator()(
+    ZLIB_InflateStream* stream) const noexcept {
+  if (stream->initialized) {
+    inflateEnd(stream);
+  }
+  delete stream;
+}
+
+ZLIB_DeflateStream_Pool::Ref getZLIB_DeflateStream() {
+  return zlib_deflate_pool_singleton.get();
+}
+
+ZLIB_InflateStream_Pool::Ref getZLIB_InflateStream() {
+  return zlib_inflate_pool_singleton.get();
+}
+
+ZLIB_DeflateStream_Pool::Ref getNULL_ZLIB_DeflateStream() {
+  return zlib_deflate_pool_singleton.getNull();
+}
+
+ZLIB_InflateStream_Pool::Ref getNULL_ZLIB_InflateStream() {
+  return zlib_inflate_pool_singleton.getNull();
+}
+#endif // FOLLY_HAVE_LIBZ
+
+#if FOLLY_HAVE_LIBLZMA
+lzma_stream* LZMA_Stream_Creator::operator()() const noexcept {
+  lzma_stream const init = LZMA_STREAM_INIT;
+  return new (std::nothrow) lzma_stream(init);
+}
+
+void LZMA_Stream_Deleter::operator()(lzma_stream* stream) const noexcept {
+  lzma_end(stream);
+  delete stream;
+}
+
+LZMA_Stream_Pool::Ref getLZMA_EncoderStream() {
+  return lzma_encoder_pool_singleton.get();
+}
+
+LZMA_Stream_Pool::Ref getLZMA_DecoderStream() {
+  return lzma_decoder_pool_singleton.get();
+}
+
+LZMA_Stream_Pool::Ref getNULL_LZMA_Stream() {
+  return lzma_encoder_pool_singleton.getNull();
+}
+#endif // FOLLY_HAVE_LIBLZMA
+
+#if FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
+LZ4F_CCtx* LZ4F_CCtx_Creator::operator()() const noexcept {
+  auto ctx = new (std::nothrow) LZ4F_CCtx();
+  if (ctx != nullptr &&
+      LZ4F_isError(LZ4F_createCompressionContext(&ctx->ctx, LZ4F_VERSION))) {
+    delete ctx;
+    return nullptr;
+  }
+  return ctx;
+}
+
+LZ4F_DCtx* LZ4F_DCtx_Creator::operator()() const noexcept {
+  auto ctx = new (std::nothrow) LZ4F_DCtx();
+  if (ctx != nullptr &&
+      LZ4F_isError(
+          LZ4F_createDecompressionContext(&ctx->ctx, LZ4F_VERSION))) {
+    delete ctx;
+    return nullptr;
+  }
+  return ctx;
+}
+
+void LZ4F_CCtx_Deleter::operator()(LZ4F_CCtx* ctx) const noexcept {
+  LZ4F_freeCompressionContext(ctx->ctx);
+  delete ctx;
+}
+
+void LZ4F_DCtx_Deleter::operator()(LZ4F_DCtx* ctx) const noexcept {
+  LZ4F_freeDecompressionContext(ctx->ctx);
+  delete ctx;
+}
+
+LZ4F_CCtx_Pool::Ref getLZ4F_CCtx() {
+  return lz4f_cctx_pool_singleton.get();
+}
+
+LZ4F_DCtx_Pool::Ref getLZ4F_DCtx() {
+  return lz4f_dctx_pool_singleton.get();
+}
+
+LZ4F_CCtx_Pool::Ref getNULL_LZ4F_CCtx() {
+  return lz4f_cctx_pool_singleton.getNull();
+}
+
+LZ4F_DCtx_Pool::Ref getNULL_LZ4F_DCtx() {
+  return lz4f_dctx_pool_singleton.getNull();
+}
+#endif // FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
 } // namespace contexts
 } // namespace compression
 } // namespace folly
@@ -16,7 +16,26 @@
 
 #pragma once
 
+#include <folly/portability/Config.h>
+
+#if FOLLY_HAVE_LIBZSTD
 #include <zstd.h>
+#endif
+
+#if FOLLY_HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+#if FOLLY_HAVE_LIBLZMA
+#include <lzma.h>
+#endif
+
+#if FOLLY_HAVE_LIBLZ4
+#include <lz4.h>
+#if LZ4_VERSION_NUMBER >= 10301
+#include <lz4frame.h>
+#endif
+#endif
 
 #include <folly/compression/CompressionCoreLocalContextPool.h>
 
@@ -24,6 +43,7 @@ namespace folly {
 namespace compression {
 namespace contexts {
 
+#if FOLLY_HAVE_LIBZSTD
 struct ZSTD_CCtx_Creator {
   ZSTD_CCtx* operator()() const noexcept;
 };
@@ -58,6 +78,140 @@ ZSTD_DCtx_Pool::Ref getZSTD_DCtx();
 ZSTD_CCtx_Pool::Ref getNULL_ZSTD_CCtx();
 
 ZSTD_DCtx_Pool::Ref getNULL_ZSTD_DCtx();
+#endif // FOLLY_HAVE_LIBZSTD
+
+#if FOLLY_HAVE_LIBZ
+/**
+ * A z_stream which remembers how it was last initialized, so that it is only
+ * reset, rather than freed and allocated again, when it is handed out to a
+ * codec with the same parameters.
+ */
+struct ZLIB_DeflateStream : z_stream {
+  bool initialized{false};
+  int level{0};
+  int windowBits{0};
+  int memLevel{0};
+  int strategy{0};
+};
+
+/**
+ * inflateReset2() can change the window size, so any initialized inflate
+ * stream can be reused.
+ */
+struct ZLIB_InflateStream : z_stream {
+  bool initialized{false};
+};
+
+struct ZLIB_DeflateStream_Creator {
+  ZLIB_DeflateStream* operator()() const noexcept;
+};
+
+struct ZLIB_InflateStream_Creator {
+  ZLIB_InflateStream* operator()() const noexcept;
+};
+
+struct ZLIB_DeflateStream_Deleter {
+  void operator()(ZLIB_DeflateStream* stream) const noexcept;
+};
+
+struct ZLIB_InflateStream_Deleter {
+  void operator()(ZLIB_InflateStream* stream) const noexcept;
+};
+
+using ZLIB_DeflateStream_Pool = CompressionCoreLocalContextPool<
+    ZLIB_DeflateStream,
+    ZLIB_DeflateStream_Creator,
+    ZLIB_DeflateStream_Deleter,
+    4>;
+using ZLIB_InflateStream_Pool = CompressionCoreLocalContextPool<
+    ZLIB_InflateStream,
+    ZLIB_InflateStream_Creator,
+    ZLIB_InflateStream_Deleter,
+    4>;
+
+ZLIB_DeflateStream_Pool::Ref getZLIB_DeflateStream();
+
+ZLIB_InflateStream_Pool::Ref getZLIB_InflateStream();
+
+ZLIB_DeflateStream_Pool::Ref getNULL_ZLIB_DeflateStream();
+
+ZLIB_InflateStream_Pool::Ref getNULL_ZLIB_InflateStream();
+#endif // FOLLY_HAVE_LIBZ
+
+#if FOLLY_HAVE_LIBLZMA
+/**
+ * Encoders and decoders are pooled separately: liblzma reuses the memory of a
+ * stream when it is initialized again with the same kind of coder.
+ */
+struct LZMA_Stream_Creator {
+  lzma_stream* operator()() const noexcept;
+};
+
+struct LZMA_Stream_Deleter {
+  void operator()(lzma_stream* stream) const noexcept;
+};
+
+using LZMA_Stream_Pool = CompressionCoreLocalContextPool<
+    lzma_stream,
+    LZMA_Stream_Creator,
+    LZMA_Stream_Deleter,
+    4>;
+
+LZMA_Stream_Pool::Ref getLZMA_EncoderStream();
+
+LZMA_Stream_Pool::Ref getLZMA_DecoderStream();
+
+LZMA_Stream_Pool::Ref getNULL_LZMA_Stream();
+#endif // FOLLY_HAVE_LIBLZMA
+
+#if FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
+/**
+ * The LZ4F context types are opaque pointers, so they are wrapped to be
+ * pooled.
+ */
+struct LZ4F_CCtx {
+  LZ4F_compressionContext_t ctx{nullptr};
+};
+
+struct LZ4F_DCtx {
+  LZ4F_decompressionContext_t ctx{nullptr};
+};
+
+struct LZ4F_CCtx_Creator {
+  LZ4F_CCtx* operator()() const noexcept;
+};
+
+struct LZ4F_DCtx_Creator {
+  LZ4F_DCtx* operator()() const noexcept;
+};
+
+struct LZ4F_CCtx_Deleter {
+  void operator()(LZ4F_CCtx* ctx) const noexcept;
+};
+
+struct LZ4F_DCtx_Deleter {
+  void operator()(LZ4F_DCtx* ctx) const noexcept;
+};
+
+using LZ4F_CCtx_Pool = CompressionCoreLocalContextPool<
+    LZ4F_CCtx,
+    LZ4F_CCtx_Creator,
+    LZ4F_CCtx_Deleter,
+    4>;
+using LZ4F_DCtx_Pool = CompressionCoreLocalContextPool<
+    LZ4F_DCtx,
+    LZ4F_DCtx_Creator,
+    LZ4F_DCtx_Deleter,
+    4>;
+
+LZ4F_CCtx_Pool::Ref getLZ4F_CCtx();
+
+LZ4F_DCtx_Pool::Ref getLZ4F_DCtx();
+
+LZ4F_CCtx_Pool::Ref getNULL_LZ4F_CCtx();
+
+LZ4F_DCtx_Pool::Ref getNULL_LZ4F_DCtx();
+#endif // FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
 
 } // namespace contexts
 } // namespace compression
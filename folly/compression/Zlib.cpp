@@ -23,12 +23,15 @@
 #include <folly/Range.h>
 #include <folly/ScopeGuard.h>
 #include <folly/compression/Compression.h>
+#include <folly/compression/CompressionContextPoolSingletons.h>
 #include <folly/compression/Utils.h>
 #include <folly/io/Cursor.h>
 
 using folly::io::compression::detail::dataStartsWithLE;
 using folly::io::compression::detail::prefixToStringLE;
 
+namespace contexts = folly::compression::contexts;
+
 namespace folly {
 namespace io {
 namespace zlib {
@@ -104,8 +107,12 @@ class ZlibStreamCodec final : public StreamCodec {
 
   Options options_;
 
-  Optional<z_stream> deflateStream_{};
-  Optional<z_stream> inflateStream_{};
+  // Taken from the pools on first use and returned when the codec is
+  // destroyed, so that short-lived codecs don't allocate the zlib state.
+  contexts::ZLIB_DeflateStream_Pool::Ref deflateStream_{
+      contexts::getNULL_ZLIB_DeflateStream()};
+  contexts::ZLIB_InflateStream_Pool::Ref inflateStream_{
+      contexts::getNULL_ZLIB_InflateStream()};
   int level_;
   bool needReset_{true};
 };
@@ -241,32 +248,17 @@ ZlibStreamCodec::ZlibStreamCodec(Options options, int level)
   }
 }
 
-ZlibStreamCodec::~ZlibStreamCodec() {
-  if (deflateStream_) {
-    deflateEnd(deflateStream_.get_pointer());
-    deflateStream_.clear();
-  }
-  if (inflateStream_) {
-    inflateEnd(inflateStream_.get_pointer());
-    inflateStream_.clear();
-  }
-}
+ZlibStreamCodec::~ZlibStreamCodec() = default;
 
 void ZlibStreamCodec::doResetStream() {
   needReset_ = true;
 }
 
 void ZlibStreamCodec::resetDeflateStream() {
-  if (deflateStream_) {
-    int const rc = deflateReset(deflateStream_.get_pointer());
-    if (rc != Z_OK) {
-      deflateStream_.clear();
-      throw std::runtime_error(
-          to<std::string>("ZlibStreamCodec: deflateReset error: ", rc));
-    }
-    return;
+  if (!deflateStream_) {
+    deflateStream_ = contexts::getZLIB_DeflateStream();
   }
-  deflateStream_ = z_stream{};
+  auto& stream = *deflateStream_;
 
   // The automatic header detection format is only for inflation.
   // Use zlib for deflation if the format is auto.
@@ -275,39 +267,68 @@ void ZlibStreamCodec::resetDeflateStream() {
                                                : options_.format,
       options_.windowSize);
 
+  if (stream.initialized) {
+    // deflateReset() keeps all the parameters, which can't all be changed
+    // afterwards, so a stream last used with other ones is set up again.
+    if (stream.level == level_ && stream.windowBits == windowBits &&
+        stream.memLevel == options_.memLevel &&
+        stream.strategy == options_.strategy) {
+      int const rc = deflateReset(&stream);
+      if (rc != Z_OK) {
+        deflateEnd(&stream);
+        stream.initialized = false;
+        throw std::runtime_error(
+            to<std::string>("ZlibStreamCodec: deflateReset error: ", rc));
+      }
+      return;
+    }
+    deflateEnd(&stream);
+    stream.initialized = false;
+  }
+  static_cast<z_stream&>(stream) = z_stream{};
+
   int const rc = deflateInit2(
-      deflateStream_.get_pointer(),
+      &stream,
       level_,
       Z_DEFLATED,
       windowBits,
       options_.memLevel,
       options_.strategy);
   if (rc != Z_OK) {
-    deflateStream_.clear();
     throw std::runtime_error(
         to<std::string>("ZlibStreamCodec: deflateInit error: ", rc));
   }
+  stream.initialized = true;
+  stream.level = level_;
+  stream.windowBits = windowBits;
+  stream.memLevel = options_.memLevel;
+  stream.strategy = options_.strategy;
 }
 
 void ZlibStreamCodec::resetInflateStream() {
-  if (inflateStream_) {
-    int const rc = inflateReset(inflateStream_.get_pointer());
+  if (!inflateStream_) {
+    inflateStream_ = contexts::getZLIB_InflateStream();
+  }
+  auto& stream = *inflateStream_;
+  int const windowBits = getWindowBits(options_.format, options_.windowSize);
+
+  if (stream.initialized) {
+    int const rc = inflateReset2(&stream, windowBits);
     if (rc != Z_OK) {
-      inflateStream_.clear();
+      inflateEnd(&stream);
+      stream.initialized = false;
       throw std::runtime_error(
           to<std::string>("ZlibStreamCodec: inflateReset error: ", rc));
     }
     return;
   }
-  inflateStream_ = z_stream{};
-  int const rc = inflateInit2(
-      inflateStream_.get_pointer(),
-      getWindowBits(options_.format, options_.windowSize));
+  static_cast<z_stream&>(stream) = z_stream{};
+  int const rc = inflateInit2(&stream, windowBits);
   if (rc != Z_OK) {
-    inflateStream_.clear();
     throw std::runtime_error(
         to<std::string>("ZlibStreamCodec: inflateInit error: ", rc));
   }
+  stream.initialized = true;
 }
 
 static int zlibTranslateFlush(StreamCodec::FlushOp flush) {
@@ -342,7 +363,7 @@ bool ZlibStreamCodec::doCompressStream(
     resetDeflateStream();
     needReset_ = false;
   }
-  DCHECK(deflateStream_.hasValue());
+  DCHECK(deflateStream_);
   // zlib will return Z_STREAM_ERROR if output.data() is null.
   if (output.data() == nullptr) {
     return false;
@@ -356,7 +377,7 @@ bool ZlibStreamCodec::doCompressStream(
     output.uncheckedAdvance(output.size() - deflateStream_->avail_out);
   };
   int const rc = zlibThrowOnError(
-      deflate(deflateStream_.get_pointer(), zlibTranslateFlush(flush)));
+      deflate(deflateStream_.get(), zlibTranslateFlush(flush)));
   switch (flush) {
     case StreamCodec::FlushOp::NONE:
       return false;
@@ -377,7 +398,7 @@ bool ZlibStreamCodec::doUncompressStream(
     resetInflateStream();
     needReset_ = false;
   }
-  DCHECK(inflateStream_.hasValue());
+  DCHECK(inflateStream_);
   // zlib will return Z_STREAM_ERROR if output.data() is null.
   if (output.data() == nullptr) {
     return false;
@@ -391,7 +412,7 @@ bool ZlibStreamCodec::doUncompressStream(
     output.advance(output.size() - inflateStream_->avail_out);
   };
   int const rc = zlibThrowOnError(
-      inflate(inflateStream_.get_pointer(), zlibTranslateFlush(flush)));
+      inflate(inflateStream_.get(), zlibTranslateFlush(flush)));
   return rc == Z_STREAM_END;
 }
 
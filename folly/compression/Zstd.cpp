@@ -18,15 +18,25 @@
 
 #if FOLLY_HAVE_LIBZSTD
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 
+#include <zdict.h>
 #include <zstd.h>
 
 #include <folly/Conv.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/Indestructible.h>
 #include <folly/Range.h>
 #include <folly/ScopeGuard.h>
+#include <folly/compression/CompressionContextPoolSingletons.h>
 #include <folly/compression/Utils.h>
+#include <folly/io/Cursor.h>
+#include <folly/synchronization/Baton.h>
 
 static_assert(
     ZSTD_VERSION_NUMBER >= 10302,
@@ -35,6 +45,8 @@ static_assert(
 using folly::io::compression::detail::dataStartsWithLE;
 using folly::io::compression::detail::prefixToStringLE;
 
+namespace contexts = folly::compression::contexts;
+
 namespace folly {
 namespace io {
 namespace zstd {
@@ -74,14 +86,6 @@ void resetDCtxSessionAndParameters(ZSTD_DCtx* dctx) {
 
 #endif
 
-void zstdFreeCCtx(ZSTD_CCtx* zc) {
-  ZSTD_freeCCtx(zc);
-}
-
-void zstdFreeDCtx(ZSTD_DCtx* zd) {
-  ZSTD_freeDCtx(zd);
-}
-
 size_t zstdThrowIfError(size_t rc) {
   if (!ZSTD_isError(rc)) {
     return rc;
@@ -130,17 +134,18 @@ class ZSTDStreamCodec final : public StreamCodec {
 
   void resetCCtx();
   void resetDCtx();
+  // Reference the dictionary of the frame starting at `input`, if any.
+  void refDDict(ByteRange input);
 
   Options options_;
   bool needReset_{true};
-  std::unique_ptr<
-      ZSTD_CCtx,
-      folly::static_function_deleter<ZSTD_CCtx, &zstdFreeCCtx>>
-      cctx_{nullptr};
-  std::unique_ptr<
-      ZSTD_DCtx,
-      folly::static_function_deleter<ZSTD_DCtx, &zstdFreeDCtx>>
-      dctx_{nullptr};
+  // Keeps the dictionary referenced by dctx_ alive, when it isn't the one in
+  // options_.
+  std::shared_ptr<Dictionary const> registeredDictionary_;
+  // Taken from the pools on first use and returned when the codec is
+  // destroyed.
+  contexts::ZSTD_CCtx_Pool::Ref cctx_{contexts::getNULL_ZSTD_CCtx()};
+  contexts::ZSTD_DCtx_Pool::Ref dctx_{contexts::getNULL_ZSTD_DCtx()};
 };
 
 constexpr uint32_t kZSTDMagicLE = 0xFD2FB528;
@@ -195,14 +200,17 @@ void ZSTDStreamCodec::doResetStream() {
 
 void ZSTDStreamCodec::resetCCtx() {
   if (!cctx_) {
-    cctx_.reset(ZSTD_createCCtx());
-    if (!cctx_) {
-      throw std::bad_alloc{};
-    }
+    cctx_ = contexts::getZSTD_CCtx();
   }
   resetCCtxSessionAndParameters(cctx_.get());
   zstdThrowIfError(
       ZSTD_CCtx_setParametersUsingCCtxParams(cctx_.get(), options_.params()));
+  // Pooled contexts may still reference a dictionary with older zstd
+  // versions, whose reset doesn't clear it, so always set one.
+  auto const& dictionary = options_.dictionary();
+  zstdThrowIfError(ZSTD_CCtx_refCDict(
+      cctx_.get(),
+      dictionary ? dictionary->cdict(options_.level()) : nullptr));
   zstdThrowIfError(ZSTD_CCtx_setPledgedSrcSize(
       cctx_.get(), uncompressedLength().value_or(ZSTD_CONTENTSIZE_UNKNOWN)));
 }
@@ -236,10 +244,7 @@ bool ZSTDStreamCodec::doCompressStream(
 
 void ZSTDStreamCodec::resetDCtx() {
   if (!dctx_) {
-    dctx_.reset(ZSTD_createDCtx());
-    if (!dctx_) {
-      throw std::bad_alloc{};
-    }
+    dctx_ = contexts::getZSTD_DCtx();
   }
   resetDCtxSessionAndParameters(dctx_.get());
   if (options_.maxWindowSize() != 0) {
@@ -248,12 +253,30 @@ void ZSTDStreamCodec::resetDCtx() {
   }
 }
 
+void ZSTDStreamCodec::refDDict(ByteRange input) {
+  registeredDictionary_.reset();
+  auto const* dictionary = options_.dictionary().get();
+  ZSTD_frameHeader zfh;
+  if (ZSTD_getFrameHeader(&zfh, input.data(), input.size()) == 0 &&
+      zfh.dictID != 0 && (!dictionary || zfh.dictID != dictionary->id())) {
+    registeredDictionary_ = getDictionary(zfh.dictID);
+    if (!registeredDictionary_) {
+      throw std::runtime_error(
+          to<std::string>("ZSTD: unknown dictionary ID: ", zfh.dictID));
+    }
+    dictionary = registeredDictionary_.get();
+  }
+  zstdThrowIfError(ZSTD_DCtx_refDDict(
+      dctx_.get(), dictionary ? dictionary->ddict() : nullptr));
+}
+
 bool ZSTDStreamCodec::doUncompressStream(
     ByteRange& input,
     MutableByteRange& output,
     StreamCodec::FlushOp) {
   if (needReset_) {
     resetDCtx();
+    refDDict(input);
     needReset_ = false;
   }
   ZSTD_inBuffer in = {input.data(), input.size(), 0};
@@ -267,8 +290,359 @@ bool ZSTDStreamCodec::doUncompressStream(
   return rc == 0;
 }
 
+folly::Synchronized<
+    std::unordered_map<uint32_t, std::shared_ptr<Dictionary const>>>&
+dictionaryRegistry() {
+  static folly::Indestructible<folly::Synchronized<
+      std::unordered_map<uint32_t, std::shared_ptr<Dictionary const>>>>
+      registry;
+  return *registry;
+}
+
+// The zstd seekable format, see contrib/seekable_format in the zstd
+// repository.
+constexpr uint32_t kSkippableFrameMagicLE = 0x184D2A5E;
+constexpr uint32_t kSeekableMagicLE = 0x8F92EAB1;
+constexpr size_t kSeekTableFooterSize = 9;
+constexpr uint8_t kSeekTableChecksumFlag = 0x80;
+constexpr uint8_t kSeekTableReservedBits = 0x7C;
+
+std::unique_ptr<IOBuf> compressFrame(IOBuf& input, Options const& options) {
+  auto cctx = contexts::getZSTD_CCtx();
+  resetCCtxSessionAndParameters(cctx.get());
+  zstdThrowIfError(
+      ZSTD_CCtx_setParametersUsingCCtxParams(cctx.get(), options.params()));
+  auto const& dictionary = options.dictionary();
+  zstdThrowIfError(ZSTD_CCtx_refCDict(
+      cctx.get(), dictionary ? dictionary->cdict(options.level()) : nullptr));
+  ByteRange const data = input.coalesce();
+  zstdThrowIfError(ZSTD_CCtx_setPledgedSrcSize(cctx.get(), data.size()));
+
+  auto out = IOBuf::create(ZSTD_compressBound(data.size()));
+  ZSTD_inBuffer in = {data.data(), data.size(), 0};
+  ZSTD_outBuffer outBuffer = {out->writableTail(), out->tailroom(), 0};
+  while (zstdThrowIfError(ZSTD_compressStream2(
+             cctx.get(), &outBuffer, &in, ZSTD_e_end)) != 0) {
+  }
+  out->append(outBuffer.pos);
+  return out;
+}
+
+std::unique_ptr<IOBuf> uncompressFrame(
+    ByteRange data,
+    size_t uncompressedSize,
+    Dictionary const* dictionary) {
+  auto dctx = contexts::getZSTD_DCtx();
+  resetDCtxSessionAndParameters(dctx.get());
+  auto out = IOBuf::create(uncompressedSize);
+  size_t const size = zstdThrowIfError(
+      dictionary ? ZSTD_decompress_usingDDict(
+                       dctx.get(),
+                       out->writableTail(),
+                       out->tailroom(),
+                       data.data(),
+                       data.size(),
+                       dictionary->ddict())
+                 : ZSTD_decompressDCtx(
+                       dctx.get(),
+                       out->writableTail(),
+                       out->tailroom(),
+                       data.data(),
+                       data.size()));
+  if (size != uncompressedSize) {
+    throw std::runtime_error("ZSTD: seekable frame has the wrong size");
+  }
+  out->append(size);
+  return out;
+}
+
 } // namespace
 
+Dictionary::Dictionary(std::string content)
+    : content_(std::move(content)),
+      id_(ZSTD_getDictID_fromDict(content_.data(), content_.size())) {}
+
+ZSTD_CDict const* Dictionary::cdict(int level) const {
+  {
+    auto cdicts = cdicts_.rlock();
+    auto it = cdicts->find(level);
+    if (it != cdicts->end()) {
+      return it->second.get();
+    }
+  }
+  auto cdicts = cdicts_.wlock();
+  auto it = cdicts->find(level);
+  if (it == cdicts->end()) {
+    CDictPtr cdict(ZSTD_createCDict(content_.data(), content_.size(), level));
+    if (cdict == nullptr) {
+      throw std::bad_alloc{};
+    }
+    it = cdicts->emplace(level, std::move(cdict)).first;
+  }
+  return it->second.get();
+}
+
+ZSTD_DDict const* Dictionary::ddict() const {
+  folly::call_once(ddictOnce_, [&] {
+    ddict_.reset(ZSTD_createDDict(content_.data(), content_.size()));
+    if (ddict_ == nullptr) {
+      throw std::bad_alloc{};
+    }
+  });
+  return ddict_.get();
+}
+
+/* static */ void Dictionary::freeCDict(ZSTD_CDict* cdict) {
+  ZSTD_freeCDict(cdict);
+}
+
+/* static */ void Dictionary::freeDDict(ZSTD_DDict* ddict) {
+  ZSTD_freeDDict(ddict);
+}
+
+std::shared_ptr<Dictionary const> trainDictionary(
+    std::vector<std::unique_ptr<IOBuf>> const& samples,
+    size_t maxSize) {
+  // zdict wants the samples concatenated.
+  std::string buffer;
+  std::vector<size_t> sizes;
+  sizes.reserve(samples.size());
+  for (auto const& sample : samples) {
+    size_t size = 0;
+    for (ByteRange range : *sample) {
+      buffer.append(reinterpret_cast<char const*>(range.data()), range.size());
+      size += range.size();
+    }
+    sizes.push_back(size);
+  }
+  std::string content(maxSize, '\0');
+  size_t const rc = ZDICT_trainFromBuffer(
+      &content[0],
+      content.size(),
+      buffer.data(),
+      sizes.data(),
+      static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(rc)) {
+    throw std::runtime_error(to<std::string>(
+        "ZSTD: dictionary training failed: ", ZDICT_getErrorName(rc)));
+  }
+  content.resize(rc);
+  return std::make_shared<Dictionary const>(std::move(content));
+}
+
+void registerDictionary(std::shared_ptr<Dictionary const> dictionary) {
+  if (!dictionary || dictionary->id() == 0) {
+    throw std::invalid_argument(
+        "ZSTD: only dictionaries with an ID can be registered");
+  }
+  auto const id = dictionary->id();
+  (*dictionaryRegistry().wlock())[id] = std::move(dictionary);
+}
+
+std::shared_ptr<Dictionary const> getDictionary(uint32_t id) {
+  auto registry = dictionaryRegistry().rlock();
+  auto it = registry->find(id);
+  return it == registry->end() ? nullptr : it->second;
+}
+
+std::unique_ptr<IOBuf> compressSeekable(
+    IOBuf const* data,
+    Options const& options,
+    Executor* executor,
+    size_t frameSize) {
+  if (frameSize == 0 || frameSize > kMaxSeekableFrameSize) {
+    throw std::invalid_argument(
+        to<std::string>("ZSTD: invalid seekable frame size: ", frameSize));
+  }
+  size_t const totalLength = data->computeChainDataLength();
+  size_t remaining = totalLength;
+  size_t const numFrames = (totalLength + frameSize - 1) / frameSize;
+
+  // Frames are claimed one at a time by the executor's tasks and by this
+  // thread, which only waits for the frames that tasks already started.
+  // So this doesn't deadlock when called from a task of a busy executor,
+  // and tasks that run after this returns, or that were never queued, leave
+  // nothing undone; they only keep the state alive.
+  struct State {
+    std::vector<std::unique_ptr<IOBuf>> frames;
+    std::vector<exception_wrapper> errors;
+    Options const* options;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    Baton<> finished;
+
+    void run() {
+      size_t const n = frames.size();
+      size_t i;
+      while ((i = next.fetch_add(1, std::memory_order_relaxed)) < n) {
+        try {
+          frames[i] = compressFrame(*frames[i], *options);
+        } catch (...) {
+          errors[i] = exception_wrapper(std::current_exception());
+        }
+        if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+          finished.post();
+        }
+      }
+    }
+  };
+  auto state = std::make_shared<State>();
+  state->frames.resize(numFrames);
+  state->errors.resize(numFrames);
+  state->options = &options;
+  io::Cursor cursor(data);
+  for (auto& frame : state->frames) {
+    size_t const size = std::min(remaining, frameSize);
+    cursor.clone(frame, size);
+    remaining -= size;
+  }
+
+  if (executor != nullptr) {
+    try {
+      for (size_t i = 1; i < numFrames; ++i) {
+        executor->add([state] { state->run(); });
+      }
+    } catch (...) {
+      // the frames are compressed by the tasks already queued and below
+    }
+  }
+  state->run();
+  if (numFrames != 0) {
+    state->finished.wait();
+  }
+  auto& frames = state->frames;
+  auto& errors = state->errors;
+
+  auto seekTable = IOBuf::create(8 * numFrames + 8 + kSeekTableFooterSize);
+  io::Appender appender(seekTable.get(), 0);
+  appender.writeLE<uint32_t>(kSkippableFrameMagicLE);
+  appender.writeLE<uint32_t>(
+      static_cast<uint32_t>(8 * numFrames + kSeekTableFooterSize));
+  std::unique_ptr<IOBuf> out;
+  for (size_t i = 0; i < numFrames; ++i) {
+    if (errors[i]) {
+      errors[i].throw_exception();
+    }
+    appender.writeLE<uint32_t>(
+        static_cast<uint32_t>(frames[i]->computeChainDataLength()));
+    appender.writeLE<uint32_t>(static_cast<uint32_t>(
+        std::min(frameSize, totalLength - i * frameSize)));
+    if (out) {
+      out->prependChain(std::move(frames[i]));
+    } else {
+      out = std::move(frames[i]);
+    }
+  }
+  appender.writeLE<uint32_t>(static_cast<uint32_t>(numFrames));
+  appender.writeLE<uint8_t>(0);
+  appender.writeLE<uint32_t>(kSeekableMagicLE);
+  if (out) {
+    out->prependChain(std::move(seekTable));
+  } else {
+    out = std::move(seekTable);
+  }
+  return out;
+}
+
+/* static */ SeekTable SeekTable::read(IOBuf const* data) {
+  size_t const length = data->computeChainDataLength();
+  if (length < 8 + kSeekTableFooterSize) {
+    throw std::runtime_error("ZSTD: no seek table");
+  }
+  io::Cursor cursor(data);
+  cursor.skip(length - kSeekTableFooterSize);
+  uint32_t const numFrames = cursor.readLE<uint32_t>();
+  uint8_t const descriptor = cursor.readLE<uint8_t>();
+  if (cursor.readLE<uint32_t>() != kSeekableMagicLE ||
+      (descriptor & kSeekTableReservedBits) != 0) {
+    throw std::runtime_error("ZSTD: no seek table");
+  }
+  size_t const entrySize = (descriptor & kSeekTableChecksumFlag) ? 12 : 8;
+  uint64_t const tableSize =
+      8 + uint64_t(numFrames) * entrySize + kSeekTableFooterSize;
+  if (tableSize > length) {
+    throw std::runtime_error("ZSTD: truncated seek table");
+  }
+
+  cursor = io::Cursor(data);
+  cursor.skip(length - tableSize);
+  if (cursor.readLE<uint32_t>() != kSkippableFrameMagicLE ||
+      cursor.readLE<uint32_t>() != tableSize - 8) {
+    throw std::runtime_error("ZSTD: corrupt seek table");
+  }
+  SeekTable table;
+  table.frames_.reserve(numFrames);
+  uint64_t compressedOffset = 0;
+  uint64_t uncompressedOffset = 0;
+  for (uint32_t i = 0; i < numFrames; ++i) {
+    Frame frame;
+    frame.compressedOffset = compressedOffset;
+    frame.uncompressedOffset = uncompressedOffset;
+    frame.compressedSize = cursor.readLE<uint32_t>();
+    frame.uncompressedSize = cursor.readLE<uint32_t>();
+    if (entrySize == 12) {
+      cursor.skip(4);
+    }
+    compressedOffset += frame.compressedSize;
+    uncompressedOffset += frame.uncompressedSize;
+    table.frames_.push_back(frame);
+  }
+  if (compressedOffset != length - tableSize) {
+    throw std::runtime_error("ZSTD: seek table doesn't match the frames");
+  }
+  return table;
+}
+
+size_t SeekTable::frameIndex(uint64_t offset) const {
+  if (offset >= uncompressedSize()) {
+    throw std::out_of_range("ZSTD: offset past the end of the seekable data");
+  }
+  auto it = std::upper_bound(
+      frames_.begin(),
+      frames_.end(),
+      offset,
+      [](uint64_t value, Frame const& frame) {
+        return value < frame.uncompressedOffset;
+      });
+  return size_t(it - frames_.begin()) - 1;
+}
+
+std::unique_ptr<IOBuf> uncompressSeekable(
+    IOBuf const* data,
+    SeekTable const& table,
+    uint64_t offset,
+    uint64_t length,
+    Dictionary const* dictionary) {
+  if (offset > table.uncompressedSize() ||
+      length > table.uncompressedSize() - offset) {
+    throw std::out_of_range("ZSTD: range past the end of the seekable data");
+  }
+  auto out = IOBuf::create(0);
+  if (length == 0) {
+    return out;
+  }
+  auto const& frames = table.frames();
+  io::Cursor cursor(data);
+  size_t i = table.frameIndex(offset);
+  cursor.skip(frames[i].compressedOffset);
+  for (uint64_t end = offset + length;
+       i < frames.size() && frames[i].uncompressedOffset < end;
+       ++i) {
+    auto const& frame = frames[i];
+    std::unique_ptr<IOBuf> compressed;
+    cursor.clone(compressed, frame.compressedSize);
+    auto uncompressed = uncompressFrame(
+        compressed->coalesce(), frame.uncompressedSize, dictionary);
+    uncompressed->trimStart(
+        std::max(offset, frame.uncompressedOffset) - frame.uncompressedOffset);
+    uncompressed->trimEnd(
+        frame.uncompressedOffset + frame.uncompressedSize -
+        std::min(end, frame.uncompressedOffset + frame.uncompressedSize));
+    out->prependChain(std::move(uncompressed));
+  }
+  return out;
+}
+
 Options::Options(int level) : params_(ZSTD_createCCtxParams()), level_(level) {
   if (params_ == nullptr) {
     throw std::bad_alloc{};
@@ -18,9 +18,18 @@
 
 #include <memory.h>
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Executor.h>
 #include <folly/Memory.h>
 #include <folly/Portability.h>
+#include <folly/Synchronized.h>
 #include <folly/compression/Compression.h>
+#include <folly/synchronization/CallOnce.h>
 
 #if FOLLY_HAVE_LIBZSTD
 
@@ -33,6 +42,77 @@ namespace folly {
 namespace io {
 namespace zstd {
 
+/**
+ * A compression dictionary. The content is either raw, in which case any
+ * bytes prime the compressor, or in the zstd dictionary format, as produced
+ * by trainDictionary(), in which case it carries an ID which zstd writes to
+ * each frame compressed with it.
+ *
+ * The digested ZSTD_CDicts, one per compression level, and the ZSTD_DDict
+ * are built on first use and cached. A Dictionary is immutable and
+ * thread-safe, so a single instance should be shared by every codec using
+ * it.
+ */
+class Dictionary {
+ public:
+  explicit Dictionary(std::string content);
+
+  Dictionary(Dictionary const&) = delete;
+  Dictionary& operator=(Dictionary const&) = delete;
+
+  /// The dictionary ID, or 0 for a raw content dictionary.
+  uint32_t id() const {
+    return id_;
+  }
+
+  ByteRange content() const {
+    return ByteRange(StringPiece(content_));
+  }
+
+  /// Get the digested dictionary for compression at `level`.
+  ZSTD_CDict const* cdict(int level) const;
+
+  /// Get the digested dictionary for decompression.
+  ZSTD_DDict const* ddict() const;
+
+ private:
+  static void freeCDict(ZSTD_CDict* cdict);
+  static void freeDDict(ZSTD_DDict* ddict);
+  using CDictPtr = std::unique_ptr<
+      ZSTD_CDict,
+      folly::static_function_deleter<ZSTD_CDict, &freeCDict>>;
+  using DDictPtr = std::unique_ptr<
+      ZSTD_DDict,
+      folly::static_function_deleter<ZSTD_DDict, &freeDDict>>;
+
+  std::string const content_;
+  uint32_t const id_;
+  mutable folly::Synchronized<std::map<int, CDictPtr>> cdicts_;
+  mutable folly::once_flag ddictOnce_;
+  mutable DDictPtr ddict_;
+};
+
+/**
+ * Train a dictionary of at most `maxSize` bytes on `samples`, which should
+ * be representative of the data it will compress. A few thousand samples
+ * are typically needed. Throws std::runtime_error if zstd fails to train,
+ * for instance because there are too few samples.
+ */
+std::shared_ptr<Dictionary const> trainDictionary(
+    std::vector<std::unique_ptr<IOBuf>> const& samples,
+    size_t maxSize = size_t(110) << 10);
+
+/**
+ * Make `dictionary` available to every zstd codec decompressing a frame
+ * which references its id(). Registering a dictionary with an ID that is
+ * already registered replaces the previous one. Raw content dictionaries
+ * have no ID, and can't be registered.
+ */
+void registerDictionary(std::shared_ptr<Dictionary const> dictionary);
+
+/// Get the dictionary registered with `id`, or nullptr.
+std::shared_ptr<Dictionary const> getDictionary(uint32_t id);
+
 /**
  * Interface for zstd-specific codec initialization.
  */
@@ -61,6 +141,22 @@ class Options {
     maxWindowSize_ = maxWindowSize;
   }
 
+  /**
+   * Compress with `dictionary`, and decompress frames which reference it, or
+   * reference no dictionary, with it. Frames which reference another
+   * dictionary ID are decompressed with the registered dictionary with that
+   * ID, see registerDictionary(). When decompressing a stream, the frame
+   * header must be in the first input for its dictionary ID to be used.
+   */
+  void setDictionary(std::shared_ptr<Dictionary const> dictionary) {
+    dictionary_ = std::move(dictionary);
+  }
+
+  /// Get the dictionary, or nullptr.
+  std::shared_ptr<Dictionary const> const& dictionary() const {
+    return dictionary_;
+  }
+
   /// Get a reference to the ZSTD_CCtx_params.
   ZSTD_CCtx_params const* params() const {
     return params_.get();
@@ -82,6 +178,7 @@ class Options {
       ZSTD_CCtx_params,
       folly::static_function_deleter<ZSTD_CCtx_params, &freeCCtxParams>>
       params_;
+  std::shared_ptr<Dictionary const> dictionary_;
   size_t maxWindowSize_{0};
   int level_;
 };
@@ -91,6 +188,80 @@ std::unique_ptr<Codec> getCodec(Options options);
 /// Get a zstd StreamCodec with the given options.
 std::unique_ptr<StreamCodec> getStreamCodec(Options options);
 
+/**
+ * The largest frame size compressSeekable() accepts, the seekable format
+ * stores 32-bit frame sizes.
+ */
+constexpr size_t kMaxSeekableFrameSize = size_t(1) << 30;
+
+/**
+ * Split `data` into frames of `frameSize` uncompressed bytes, compress them
+ * independently with `options` on `executor`, and append a seek table, in
+ * the zstd seekable format. Compression runs on the calling thread if
+ * `executor` is null, and the calling thread compresses the frames no task
+ * of `executor` has started yet either way, so this may be called from a
+ * task of `executor`. It blocks until every frame is done.
+ *
+ * The output is a series of zstd frames, which zstd and uncompressSeekable()
+ * can decompress, but folly Codecs only decompress single frames. To compress
+ * a single frame on several threads instead, set ZSTD_c_nbWorkers in
+ * `options` and use getCodec().
+ */
+std::unique_ptr<IOBuf> compressSeekable(
+    IOBuf const* data,
+    Options const& options,
+    Executor* executor,
+    size_t frameSize = size_t(4) << 20);
+
+/**
+ * The seek table of a compressSeekable() output, which locates each frame in
+ * the compressed and uncompressed data.
+ */
+class SeekTable {
+ public:
+  struct Frame {
+    uint64_t compressedOffset;
+    uint64_t uncompressedOffset;
+    uint32_t compressedSize;
+    uint32_t uncompressedSize;
+  };
+
+  /**
+   * Read the seek table at the end of `data`. Throws std::runtime_error if
+   * `data` doesn't end with one.
+   */
+  static SeekTable read(IOBuf const* data);
+
+  std::vector<Frame> const& frames() const {
+    return frames_;
+  }
+
+  uint64_t uncompressedSize() const {
+    return frames_.empty()
+        ? 0
+        : frames_.back().uncompressedOffset + frames_.back().uncompressedSize;
+  }
+
+  /// Get the index of the frame containing the uncompressed `offset`.
+  size_t frameIndex(uint64_t offset) const;
+
+ private:
+  std::vector<Frame> frames_;
+};
+
+/**
+ * Decompress the `length` bytes at the uncompressed `offset` of `data`,
+ * which was compressed by compressSeekable() and has the seek table `table`.
+ * Only the frames overlapping the range are decompressed. Throws
+ * std::out_of_range if the range is past the end of the data.
+ */
+std::unique_ptr<IOBuf> uncompressSeekable(
+    IOBuf const* data,
+    SeekTable const& table,
+    uint64_t offset,
+    uint64_t length,
+    Dictionary const* dictionary = nullptr);
+
 } // namespace zstd
 } // namespace io
 } // namespace folly
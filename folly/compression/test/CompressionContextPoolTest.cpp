@@ -261,13 +261,40 @@ TEST_F(CompressionCoreLocalContextPoolTest, testMultithread) {
 }
 
 TEST(CompressionContextPoolSingletonsTest, testSingletons) {
+#if FOLLY_HAVE_LIBZSTD
   EXPECT_NE(contexts::getZSTD_CCtx(), nullptr);
   EXPECT_NE(contexts::getZSTD_DCtx(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBZ
+  EXPECT_NE(contexts::getZLIB_DeflateStream(), nullptr);
+  EXPECT_NE(contexts::getZLIB_InflateStream(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBLZMA
+  EXPECT_NE(contexts::getLZMA_EncoderStream(), nullptr);
+  EXPECT_NE(contexts::getLZMA_DecoderStream(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
+  EXPECT_NE(contexts::getLZ4F_CCtx(), nullptr);
+  EXPECT_NE(contexts::getLZ4F_DCtx(), nullptr);
+#endif
 }
 
 TEST(CompressionContextPoolSingletonsTest, testSingletonsNull) {
+#if FOLLY_HAVE_LIBZSTD
   EXPECT_EQ(contexts::getNULL_ZSTD_CCtx(), nullptr);
   EXPECT_EQ(contexts::getNULL_ZSTD_DCtx(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBZ
+  EXPECT_EQ(contexts::getNULL_ZLIB_DeflateStream(), nullptr);
+  EXPECT_EQ(contexts::getNULL_ZLIB_InflateStream(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBLZMA
+  EXPECT_EQ(contexts::getNULL_LZMA_Stream(), nullptr);
+#endif
+#if FOLLY_HAVE_LIBLZ4 && LZ4_VERSION_NUMBER >= 10301
+  EXPECT_EQ(contexts::getNULL_LZ4F_CCtx(), nullptr);
+  EXPECT_EQ(contexts::getNULL_LZ4F_DCtx(), nullptr);
+#endif
 }
 } // namespace compression
 } // namespace folly
@@ -27,9 +27,12 @@
 
 #include <folly/Random.h>
 #include <folly/Varint.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/hash/Hash.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/test/TestUtils.h>
 
 #if FOLLY_HAVE_LIBZSTD
 #include <zstd.h>
@@ -211,6 +214,8 @@ class CompressionTest
 
   void runSimpleStringTest(const DataHolder& dh);
 
+  void runQueueTest(const DataHolder& dh);
+
  private:
   std::unique_ptr<IOBuf> split(std::unique_ptr<IOBuf> data) const;
 
@@ -258,6 +263,30 @@ void CompressionTest::runSimpleStringTest(const DataHolder& dh) {
   }
 }
 
+void CompressionTest::runQueueTest(const DataHolder& dh) {
+  const auto original = split(IOBuf::wrapBuffer(dh.data(uncompressedLength_)));
+  const auto compressed = split(codec_->compress(original.get()));
+  auto const prefix = StringPiece("prefix");
+  for (bool passLength : {false, true}) {
+    if (!passLength && codec_->needsUncompressedLength()) {
+      continue;
+    }
+    IOBufQueue queue(IOBufQueue::cacheChainLength());
+    // Leave some tailroom for the codec to use.
+    queue.append(IOBuf::create(100));
+    queue.append(prefix);
+    codec_->uncompress(
+        compressed.get(),
+        queue,
+        passLength ? Optional<uint64_t>(uncompressedLength_) : none);
+    EXPECT_EQ(prefix.size() + uncompressedLength_, queue.chainLength());
+    auto uncompressed = queue.move();
+    EXPECT_EQ(prefix, StringPiece(uncompressed->coalesce()).subpiece(0, 6));
+    uncompressed->trimStart(prefix.size());
+    EXPECT_EQ(dh.hash(uncompressedLength_), hashIOBuf(uncompressed.get()));
+  }
+}
+
 // Uniformly split data into (potentially empty) chunks.
 std::unique_ptr<IOBuf> CompressionTest::split(
     std::unique_ptr<IOBuf> data) const {
@@ -300,6 +329,14 @@ TEST_P(CompressionTest, ConstantDataString) {
   runSimpleStringTest(constantDataHolder);
 }
 
+TEST_P(CompressionTest, RandomDataQueue) {
+  runQueueTest(randomDataHolder);
+}
+
+TEST_P(CompressionTest, ConstantDataQueue) {
+  runQueueTest(constantDataHolder);
+}
+
 INSTANTIATE_TEST_CASE_P(
     CompressionTest,
     CompressionTest,
@@ -1507,8 +1544,172 @@ TEST(ZstdTest, NegativeLevels) {
   EXPECT_EQ(original, uncompressed);
 }
 
+namespace {
+// Small messages which share most of their structure, as RPC payloads do.
+std::vector<std::unique_ptr<IOBuf>> dictionarySamples(size_t count) {
+  std::mt19937 rng(count);
+  std::vector<std::unique_ptr<IOBuf>> samples;
+  for (size_t i = 0; i < count; ++i) {
+    samples.push_back(IOBuf::copyBuffer(to<std::string>(
+        "{\"request_id\": ",
+        rng(),
+        ", \"method\": \"getUserProfile\", \"user\": {\"id\": ",
+        rng() % 100000,
+        ", \"locale\": \"en_US\", \"fields\": [\"name\", \"email\", ",
+        "\"picture\"]}, \"timeout_ms\": ",
+        rng() % 1000,
+        "}")));
+  }
+  return samples;
+}
+} // namespace
+
+TEST(ZstdTest, RawDictionary) {
+  auto const samples = dictionarySamples(2);
+  auto const dictionary = std::make_shared<zstd::Dictionary const>(
+      samples[0]->moveToFbString().toStdString());
+  EXPECT_EQ(0, dictionary->id());
+  auto const original = samples[1]->moveToFbString().toStdString();
+
+  zstd::Options options(3);
+  options.setDictionary(dictionary);
+  auto codec = zstd::getCodec(std::move(options));
+  auto const compressed = codec->compress(original);
+  EXPECT_LT(
+      compressed.size(), getCodec(CodecType::ZSTD)->compress(original).size());
+  EXPECT_EQ(original, codec->uncompress(compressed));
+}
+
+TEST(ZstdTest, TrainedDictionary) {
+  auto const dictionary = zstd::trainDictionary(dictionarySamples(2000), 4096);
+  EXPECT_NE(0, dictionary->id());
+  EXPECT_LE(dictionary->content().size(), 4096);
+  EXPECT_EQ(dictionary->cdict(3), dictionary->cdict(3));
+  EXPECT_NE(dictionary->cdict(1), dictionary->cdict(3));
+
+  auto const original =
+      dictionarySamples(2001).back()->moveToFbString().toStdString();
+  zstd::Options options(3);
+  options.setDictionary(dictionary);
+  auto const compressed =
+      zstd::getCodec(std::move(options))->compress(original);
+  EXPECT_LT(
+      compressed.size() * 2,
+      getCodec(CodecType::ZSTD)->compress(original).size());
+
+  // The frame references the dictionary by ID.
+  auto codec = getCodec(CodecType::ZSTD);
+  EXPECT_THROW(codec->uncompress(compressed), std::runtime_error);
+  zstd::registerDictionary(dictionary);
+  EXPECT_EQ(dictionary, zstd::getDictionary(dictionary->id()));
+  EXPECT_EQ(original, codec->uncompress(compressed));
+  EXPECT_EQ(original, getCodec(CodecType::ZSTD)->uncompress(compressed));
+  EXPECT_THROW(
+      zstd::registerDictionary(
+          std::make_shared<zstd::Dictionary const>("raw")),
+      std::invalid_argument);
+}
+
+TEST(ZstdTest, TrainTooFewSamples) {
+  EXPECT_THROW(
+      zstd::trainDictionary(dictionarySamples(1), 4096), std::runtime_error);
+}
+
+TEST(ZstdTest, Seekable) {
+  size_t const frameSize = size_t(64) << 10;
+  size_t const length = 10 * frameSize + 1234;
+  auto const data = IOBuf::wrapBuffer(randomDataHolder.data(length / 2));
+  data->prependChain(IOBuf::wrapBuffer(
+      constantDataHolder.data(length - length / 2)));
+  auto const original = data->cloneCoalescedAsValue();
+
+  CPUThreadPoolExecutor executor(4);
+  auto const compressed = zstd::compressSeekable(
+      data.get(), zstd::Options(3), &executor, frameSize);
+  EXPECT_EQ(
+      compressed->cloneCoalescedAsValue().moveToFbString(),
+      zstd::compressSeekable(data.get(), zstd::Options(3), nullptr, frameSize)
+          ->cloneCoalescedAsValue()
+          .moveToFbString());
+
+  auto const table = zstd::SeekTable::read(compressed.get());
+  EXPECT_EQ(11, table.frames().size());
+  EXPECT_EQ(length, table.uncompressedSize());
+  EXPECT_EQ(0, table.frameIndex(frameSize - 1));
+  EXPECT_EQ(1, table.frameIndex(frameSize));
+  EXPECT_EQ(10, table.frameIndex(length - 1));
+
+  auto check = [&](uint64_t offset, uint64_t size) {
+    auto range =
+        zstd::uncompressSeekable(compressed.get(), table, offset, size);
+    EXPECT_EQ(ByteRange(original.data() + offset, size), range->coalesce());
+  };
+  check(0, length);
+  check(0, 0);
+  check(frameSize - 10, 20);
+  check(3 * frameSize, frameSize);
+  check(length - 100, 100);
+  EXPECT_THROW(
+      zstd::uncompressSeekable(compressed.get(), table, length - 1, 2),
+      std::out_of_range);
+
+  auto const empty = zstd::compressSeekable(
+      IOBuf::create(0).get(), zstd::Options(3), &executor, frameSize);
+  EXPECT_EQ(0, zstd::SeekTable::read(empty.get()).uncompressedSize());
+  EXPECT_THROW(
+      zstd::SeekTable::read(IOBuf::copyBuffer("not a seekable stream").get()),
+      std::runtime_error);
+}
+
+TEST(ZstdTest, SeekableFromExecutor) {
+  // The only thread of the executor compresses every frame itself rather
+  // than waiting for tasks queued behind it.
+  size_t const frameSize = size_t(64) << 10;
+  auto const data = IOBuf::wrapBuffer(randomDataHolder.data(4 * frameSize));
+  CPUThreadPoolExecutor executor(1);
+  std::unique_ptr<IOBuf> compressed;
+  Baton<> done;
+  executor.add([&] {
+    compressed = zstd::compressSeekable(
+        data.get(), zstd::Options(3), &executor, frameSize);
+    done.post();
+  });
+  done.wait();
+  auto const table = zstd::SeekTable::read(compressed.get());
+  EXPECT_EQ(4, table.frames().size());
+  EXPECT_EQ(
+      data->coalesce(),
+      zstd::uncompressSeekable(compressed.get(), table, 0, 4 * frameSize)
+          ->coalesce());
+}
+
 #endif
 
+TEST(LZ4FrameTest, Dictionary) {
+  if (!hasCodec(CodecType::LZ4_FRAME)) {
+    SKIP() << "LZ4_FRAME is not supported";
+  }
+  auto const dictionary = std::make_shared<std::string const>(
+      "{\"method\": \"getUserProfile\", \"user\": {\"locale\": \"en_US\"}}");
+  std::unique_ptr<Codec> codec;
+  try {
+    codec = getLZ4FrameCodecWithDictionary(dictionary);
+  } catch (std::invalid_argument const&) {
+    SKIP() << "lz4 doesn't support dictionaries";
+  }
+  auto const original = std::string(
+      "{\"request_id\": 1, \"method\": \"getUserProfile\", "
+      "\"user\": {\"id\": 1234, \"locale\": \"en_US\"}}");
+  auto const compressed = codec->compress(original);
+  EXPECT_LT(
+      compressed.size(),
+      getCodec(CodecType::LZ4_FRAME)->compress(original).size());
+  EXPECT_EQ(original, codec->uncompress(compressed));
+  EXPECT_EQ(
+      original,
+      getLZ4FrameCodecWithDictionary(dictionary)->uncompress(compressed));
+}
+
 #if FOLLY_HAVE_LIBZ
 
 using ZlibFormat = zlib::Options::Format;
@@ -1565,6 +1766,43 @@ TEST(ZlibTest, DefaultOptions) {
   }
 }
 
+TEST(ZlibTest, PooledStreams) {
+  // Short-lived codecs share pooled streams, which must not carry anything
+  // over from the codecs that used them before.
+  size_t const uncompressedLength = (size_t)1 << 12;
+  auto const original = std::string(
+      reinterpret_cast<const char*>(
+          randomDataHolder.data(uncompressedLength).data()),
+      uncompressedLength / 2) +
+      std::string(uncompressedLength / 2, 'a');
+  std::vector<zlib::Options> options{
+      zlib::Options(ZlibFormat::ZLIB),
+      zlib::Options(ZlibFormat::GZIP),
+      zlib::Options(ZlibFormat::RAW, 9, 1, Z_HUFFMAN_ONLY),
+      zlib::Options(ZlibFormat::ZLIB, 12, 8, Z_RLE),
+  };
+  std::vector<int> levels{1, 9};
+  std::vector<std::string> expected;
+  for (auto const& option : options) {
+    for (int level : levels) {
+      expected.push_back(
+          zlib::getCodec(option, level)->compress(original));
+    }
+  }
+  for (int round = 0; round < 3; ++round) {
+    size_t i = 0;
+    for (auto const& option : options) {
+      for (int level : levels) {
+        auto const compressed =
+            zlib::getStreamCodec(option, level)->compress(original);
+        EXPECT_EQ(expected[i++], compressed);
+        EXPECT_EQ(
+            original, zlib::getStreamCodec(option)->uncompress(compressed));
+      }
+    }
+  }
+}
+
 class ZlibOptionsTest
     : public testing::TestWithParam<std::tuple<ZlibFormat, int, int, int>> {
  protected:
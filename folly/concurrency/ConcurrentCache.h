@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/ThreadCachedInt.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+namespace detail {
+
+/*
+ * Count-min sketch of 4-bit counters estimating how often each hash
+ * was recorded recently. All counters are halved every 10 * capacity
+ * records, so that items that are no longer popular are forgotten.
+ * Concurrent records may be lost; counts are only estimates anyway.
+ */
+class CacheFrequencySketch {
+ public:
+  explicit CacheFrequencySketch(size_t capacity)
+      : mask_(nextPowTwo(std::max<size_t>(capacity, 16)) - 1),
+        sampleSize_(10 * std::max<size_t>(capacity, 1)),
+        counters_(new std::atomic<uint8_t>[kDepth * (mask_ + 1)]) {
+    for (size_t i = 0; i < kDepth * (mask_ + 1); ++i) {
+      counters_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void record(uint64_t hash) {
+    for (size_t row = 0; row < kDepth; ++row) {
+      auto& c = counter(row, hash);
+      auto v = c.load(std::memory_order_relaxed);
+      if (v < kMaxCount) {
+        c.store(v + 1, std::memory_order_relaxed);
+      }
+    }
+    if (additions_.fetch_add(1, std::memory_order_relaxed) + 1 ==
+        sampleSize_) {
+      age();
+    }
+  }
+
+  uint8_t estimate(uint64_t hash) const {
+    uint8_t res = kMaxCount;
+    for (size_t row = 0; row < kDepth; ++row) {
+      res = std::min(res, counter(row, hash).load(std::memory_order_relaxed));
+    }
+    return res;
+  }
+
+ private:
+  static constexpr size_t kDepth = 4;
+  static constexpr uint8_t kMaxCount = 15;
+
+  std::atomic<uint8_t>& counter(size_t row, uint64_t hash) const {
+    auto h = hash::twang_mix64(hash + row);
+    return counters_[row * (mask_ + 1) + (h & mask_)];
+  }
+
+  void age() {
+    for (size_t i = 0; i < kDepth * (mask_ + 1); ++i) {
+      auto v = counters_[i].load(std::memory_order_relaxed);
+      counters_[i].store(v / 2, std::memory_order_relaxed);
+    }
+    additions_.store(sampleSize_ / 2, std::memory_order_relaxed);
+  }
+
+  const size_t mask_;
+  const size_t sampleSize_;
+  std::unique_ptr<std::atomic<uint8_t>[]> counters_;
+  std::atomic<size_t> additions_{0};
+};
+
+} // namespace detail
+
+/*
+ * A thread-safe evicting cache, to use instead of an EvictingCacheMap
+ * behind a lock.
+ *
+ * Entries are kept in a ConcurrentHashMap, so get() is lock-free: a hit
+ * only sets the entry's reference bit, and only if it is not set yet.
+ * Writers lock the shard of their key. Each shard evicts with CLOCK
+ * (second chance): its hand sweeps over the shard's keys in insertion
+ * order, clearing reference bits, and evicts the first entry whose bit
+ * was already clear. Recency is thus approximated at the granularity
+ * of a sweep, without reordering anything on hits.
+ *
+ * With Options::admission, a TinyLFU filter also decides whether a new
+ * entry is worth its victim: each shard keeps a frequency sketch of the
+ * keys that were looked up, and set() rejects a new key that was
+ * requested less often than the entry it would evict. This keeps scans
+ * and one-hit wonders from flushing the cache.
+ *
+ * The capacity is split evenly between the shards.
+ *
+ * get() returns a copy of the value; values that are expensive to copy
+ * should be stored behind a shared_ptr.
+ */
+template <
+    typename KeyType,
+    typename ValueType,
+    typename HashFn = std::hash<KeyType>,
+    typename KeyEqual = std::equal_to<KeyType>>
+class ConcurrentCache {
+ public:
+  struct Options {
+    // rounded up to a power of two
+    size_t numShards{16};
+    // TinyLFU admission of new entries
+    bool admission{false};
+  };
+
+  struct Stats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    // new entries that the admission filter refused
+    uint64_t rejections{0};
+
+    double hitRate() const {
+      auto lookups = hits + misses;
+      return lookups == 0 ? 0.0 : double(hits) / lookups;
+    }
+  };
+
+  explicit ConcurrentCache(size_t capacity, Options options = Options())
+      : options_(options), map_(std::max<size_t>(capacity, 1)) {
+    auto numShards = nextPowTwo(std::max<size_t>(options_.numShards, 1));
+    auto shardCapacity =
+        std::max<size_t>((capacity + numShards - 1) / numShards, 1);
+    shards_.reserve(numShards);
+    for (size_t i = 0; i < numShards; ++i) {
+      shards_.push_back(
+          std::make_unique<Shard>(shardCapacity, options_.admission));
+    }
+    capacity_ = shardCapacity * numShards;
+  }
+
+  ConcurrentCache(const ConcurrentCache&) = delete;
+  ConcurrentCache& operator=(const ConcurrentCache&) = delete;
+
+  /*
+   * Returns the value of key, and marks it as recently used.
+   */
+  Optional<ValueType> get(const KeyType& key) {
+    auto hash = hashOf(key);
+    auto it = map_.find(key);
+    if (it == map_.cend()) {
+      misses_.increment(1);
+      if (options_.admission) {
+        shardOf(hash).sketch->record(hash);
+      }
+      return none;
+    }
+    hits_.increment(1);
+    auto& entry = it->second;
+    if (!entry.referenced.load(std::memory_order_relaxed)) {
+      entry.referenced.store(true, std::memory_order_relaxed);
+      // recorded once per sweep of the hand, which bounds the cost of
+      // hot keys
+      if (options_.admission) {
+        shardOf(hash).sketch->record(hash);
+      }
+    }
+    return entry.value;
+  }
+
+  /*
+   * Doesn't count as a use of key.
+   */
+  bool exists(const KeyType& key) const {
+    return map_.find(key) != map_.cend();
+  }
+
+  /*
+   * Inserts or replaces the value of key, evicting an entry of its shard
+   * if it is full. Returns false if the admission filter rejected key.
+   */
+  bool set(const KeyType& key, ValueType value) {
+    auto hash = hashOf(key);
+    auto& shard = shardOf(hash);
+    std::lock_guard<std::mutex> g(shard.mutex);
+    // Writes of a key are serialized by the lock of its shard.
+    auto it = map_.find(key);
+    if (it != map_.cend()) {
+      map_.insert_or_assign(
+          key, Entry(std::move(value), true, it->second.slot));
+      return true;
+    }
+    if (options_.admission) {
+      shard.sketch->record(hash);
+    }
+    size_t slot;
+    if (!shard.freeSlots.empty()) {
+      slot = shard.freeSlots.back();
+      shard.freeSlots.pop_back();
+      shard.keys[slot] = key;
+    } else if (shard.keys.size() < shard.capacity) {
+      slot = shard.keys.size();
+      shard.keys.push_back(key);
+    } else {
+      auto victim = findVictim(shard);
+      auto& victimKey = shard.keys[victim.first];
+      if (victim.second) {
+        if (options_.admission &&
+            shard.sketch->estimate(hash) <=
+                shard.sketch->estimate(hashOf(victimKey))) {
+          rejections_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        map_.erase(victimKey);
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+      }
+      victimKey = key;
+      slot = victim.first;
+      shard.hand = (victim.first + 1) % shard.keys.size();
+    }
+    map_.insert(key, Entry(std::move(value), false, slot));
+    return true;
+  }
+
+  bool erase(const KeyType& key) {
+    auto& shard = shardOf(hashOf(key));
+    std::lock_guard<std::mutex> g(shard.mutex);
+    auto it = map_.find(key);
+    if (it == map_.cend()) {
+      return false;
+    }
+    // Its slot is reused by the next new key of the shard.
+    shard.freeSlots.push_back(it->second.slot);
+    map_.erase(key);
+    return true;
+  }
+
+  void clear() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> g(shard->mutex);
+      for (auto& key : shard->keys) {
+        map_.erase(key);
+      }
+      shard->keys.clear();
+      shard->freeSlots.clear();
+      shard->hand = 0;
+    }
+  }
+
+  size_t size() const {
+    return map_.size();
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  Stats stats() const {
+    Stats res;
+    res.hits = hits_.readFull();
+    res.misses = misses_.readFull();
+    res.evictions = evictions_.load(std::memory_order_relaxed);
+    res.rejections = rejections_.load(std::memory_order_relaxed);
+    return res;
+  }
+
+ private:
+  struct Entry {
+    Entry(ValueType v, bool ref, size_t s)
+        : value(std::move(v)), referenced(ref), slot(s) {}
+
+    Entry(const Entry& other)
+        : value(other.value),
+          referenced(other.referenced.load(std::memory_order_relaxed)),
+          slot(other.slot) {}
+
+    Entry(Entry&& other) noexcept(
+        std::is_nothrow_move_constructible<ValueType>::value)
+        : value(std::move(other.value)),
+          referenced(other.referenced.load(std::memory_order_relaxed)),
+          slot(other.slot) {}
+
+    ValueType value;
+    mutable std::atomic<bool> referenced;
+    // index of its key in the CLOCK ring of its shard
+    size_t slot;
+  };
+
+  struct alignas(hardware_destructive_interference_size) Shard {
+    Shard(size_t cap, bool admission)
+        : capacity(cap),
+          sketch(
+              admission ? std::make_unique<detail::CacheFrequencySketch>(cap)
+                        : nullptr) {
+      keys.reserve(capacity);
+    }
+
+    std::mutex mutex;
+    const size_t capacity;
+    // The CLOCK ring. Every entry of the shard has a slot; the slots of
+    // erased keys are in freeSlots until they are reused.
+    std::vector<KeyType> keys;
+    std::vector<size_t> freeSlots;
+    size_t hand{0};
+    std::unique_ptr<detail::CacheFrequencySketch> sketch;
+  };
+
+  static uint64_t hashOf(const KeyType& key) {
+    return hash::twang_mix64(HashFn()(key));
+  }
+
+  Shard& shardOf(uint64_t hash) const {
+    return *shards_[(hash >> 32) & (shards_.size() - 1)];
+  }
+
+  // Returns the slot the hand stops at, and whether its key is still
+  // in the map.
+  std::pair<size_t, bool> findVictim(Shard& shard) {
+    auto n = shard.keys.size();
+    auto i = shard.hand;
+    // after one whole sweep only entries that were used meanwhile are
+    // still referenced
+    for (size_t step = 0; step < 2 * n; ++step, i = (i + 1) % n) {
+      auto it = map_.find(shard.keys[i]);
+      if (it == map_.cend()) {
+        return {i, false};
+      }
+      if (!it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+        return {i, true};
+      }
+    }
+    return {i, map_.find(shard.keys[i]) != map_.cend()};
+  }
+
+  const Options options_;
+  size_t capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  ConcurrentHashMap<KeyType, Entry, HashFn, KeyEqual> map_;
+  ThreadCachedInt<uint64_t> hits_;
+  ThreadCachedInt<uint64_t> misses_;
+  std::atomic<uint64_t> evictions_{0};
+  std::atomic<uint64_t> rejections_{0};
+};
+
+} // namespace folly
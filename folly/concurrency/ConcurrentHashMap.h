@@ -19,8 +19,12 @@
 #include <folly/Optional.h>
 #include <folly/concurrency/detail/ConcurrentHashMap-detail.h>
 #include <folly/synchronization/Hazptr.h>
+#include <algorithm>
 #include <atomic>
+#include <iterator>
 #include <mutex>
+#include <numeric>
+#include <vector>
 
 namespace folly {
 
@@ -55,6 +59,10 @@ namespace folly {
  *
  * * The interface adds assign_if_equal, since find() doesn't take a lock.
  *
+ * * The interface adds multi_find and bulk_insert, to look up or insert
+ *   many keys at once for less than the cost of as many find() and
+ *   insert().
+ *
  * * Only const version of find() is supported, and const iterators.
  *   Mutation must use functions provided, like assign().
  *
@@ -250,6 +258,48 @@ class ConcurrentHashMap {
     return res;
   }
 
+  /*
+   * Looks up all the keys of [first, last), calling f(key, item) for each,
+   * where item points to the value_type found or is nullptr.  item is only
+   * protected during the call to f.  Returns the number of keys found.
+   *
+   * Faster than find() for many keys: the segments' buckets for the next
+   * keys are prefetched while looking up the current one, and the whole
+   * batch uses the same hazard pointers.  Since every key is read twice,
+   * KeyIt must be a forward iterator.
+   */
+  template <typename KeyIt, typename F>
+  size_t multi_find(KeyIt first, KeyIt last, F&& f) const {
+    static_assert(
+        std::is_base_of<
+            std::forward_iterator_tag,
+            typename std::iterator_traits<KeyIt>::iterator_category>::value,
+        "multi_find needs forward iterators");
+    constexpr size_t kPrefetchDistance = 8;
+    size_t hashes[kPrefetchDistance];
+    auto ahead = first;
+    for (size_t i = 0; i < kPrefetchDistance && ahead != last; ++i, ++ahead) {
+      hashes[i] = prefetch(*ahead);
+    }
+    typename SegmentT::Iterator it;
+    size_t found = 0;
+    for (size_t i = 0; first != last; ++i, ++first) {
+      auto h = hashes[i % kPrefetchDistance];
+      if (ahead != last) {
+        hashes[i % kPrefetchDistance] = prefetch(*ahead);
+        ++ahead;
+      }
+      const value_type* item = nullptr;
+      auto seg = segments_[h & (NumShards - 1)].load(std::memory_order_acquire);
+      if (seg && seg->find(it, *first, h)) {
+        item = &*it;
+        ++found;
+      }
+      f(*first, item);
+    }
+    return found;
+  }
+
   ConstIterator cend() const noexcept {
     return ConstIterator(NumShards);
   }
@@ -289,6 +339,49 @@ class ConcurrentHashMap {
     return res;
   }
 
+  /*
+   * Inserts copies of the (key, value) pairs of the forward iterator range
+   * [first, last) whose keys aren't in the map yet, as calling insert() on
+   * each in order would, and returns how many were inserted.  The items
+   * are grouped by segment, so that each segment is locked only once.
+   */
+  template <typename ItemIt>
+  size_t bulk_insert(ItemIt first, ItemIt last) {
+    using Item = std::remove_reference_t<decltype(*first)>;
+    std::vector<Item*> items;
+    std::vector<size_t> hashes;
+    for (; first != last; ++first) {
+      items.push_back(&*first);
+      hashes.push_back(HashFn()(first->first));
+    }
+    auto n = items.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return (hashes[a] & (NumShards - 1)) < (hashes[b] & (NumShards - 1));
+    });
+    std::vector<Item*> sortedItems(n);
+    std::vector<size_t> sortedHashes(n);
+    for (size_t i = 0; i < n; ++i) {
+      sortedItems[i] = items[order[i]];
+      sortedHashes[i] = hashes[order[i]];
+    }
+
+    typename SegmentT::Iterator it;
+    size_t inserted = 0;
+    for (size_t begin = 0; begin < n;) {
+      auto segment = sortedHashes[begin] & (NumShards - 1);
+      auto end = begin + 1;
+      while (end < n && (sortedHashes[end] & (NumShards - 1)) == segment) {
+        ++end;
+      }
+      inserted += ensureSegment(segment)->bulk_insert(
+          it, &sortedItems[begin], &sortedHashes[begin], end - begin);
+      begin = end;
+    }
+    return inserted;
+  }
+
   template <typename Key, typename... Args>
   std::pair<ConstIterator, bool> try_emplace(Key&& k, Args&&... args) {
     auto segment = pickSegment(k);
@@ -565,6 +658,16 @@ class ConcurrentHashMap {
     return h & (NumShards - 1);
   }
 
+  // Returns the hash of k, after prefetching its bucket
+  size_t prefetch(const KeyType& k) const {
+    auto h = HashFn()(k);
+    auto seg = segments_[h & (NumShards - 1)].load(std::memory_order_acquire);
+    if (seg) {
+      seg->prefetch(h);
+    }
+    return h;
+  }
+
   SegmentT* ensureSegment(uint64_t i) const {
     SegmentT* seg = segments_[i].load(std::memory_order_acquire);
     if (!seg) {
@@ -616,7 +719,7 @@ class ConcurrentHashMap {
   mutable Atom<hazptr_obj_batch<Atom>*> batch_{nullptr};
 };
 
-#if FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
+#if FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE
 template <
     typename KeyType,
     typename ValueType,
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <memory>
+#include <utility>
 
 #include <folly/concurrency/AtomicSharedPtr.h>
 #include <folly/concurrency/CacheLocality.h>
@@ -95,6 +97,16 @@ class CoreCachedWeakPtr {
  * sharded shared_ptrs will always all be set to the same value.
  * get()s will never see a newer pointer on one core, and an older
  * pointer on another after a subsequent thread migration.
+ *
+ * Like atomic_shared_ptr, it also supports exchange() and
+ * compare_exchange(), so a value can be updated from its current one
+ * (e.g. a config object reloaded by several threads) without a lock.
+ * Updates allocate one control block per slot, so they are much more
+ * expensive than reads: use this for values read far more often than
+ * they are written.
+ *
+ * withPtr() reads the current value without touching any reference
+ * count, under the protection of a hazard pointer only.
  */
 template <class T, size_t kNumSlots = 64>
 class AtomicCoreCachedSharedPtr {
@@ -113,19 +125,50 @@ class AtomicCoreCachedSharedPtr {
   }
 
   void reset(const std::shared_ptr<T>& p = nullptr) {
-    auto newslots = folly::make_unique<Slots>();
-    // Allocate each Holder in a different CoreRawAllocator stripe to
-    // prevent false sharing. Their control blocks will be adjacent
-    // thanks to allocate_shared().
-    for (auto slot : folly::enumerate(newslots->slots_)) {
-      auto alloc = getCoreAllocator<Holder, kNumSlots>(slot.index);
-      auto holder = std::allocate_shared<Holder>(alloc, p);
-      *slot = std::shared_ptr<T>(holder, p.get());
+    exchange(p);
+  }
+
+  /**
+   * Sets the pointer to p, and returns the previous one.
+   */
+  std::shared_ptr<T> exchange(const std::shared_ptr<T>& p) {
+    auto oldslots = slots_.exchange(makeSlots(p).release());
+    if (!oldslots) {
+      return nullptr;
     }
+    auto old = oldslots->ptr_;
+    oldslots->retire();
+    return old;
+  }
 
-    auto oldslots = slots_.exchange(newslots.release());
-    if (oldslots) {
-      oldslots->retire();
+  /**
+   * If the current pointer is equal to expected, sets it to desired and
+   * returns true. Otherwise, loads the current pointer into expected and
+   * returns false. Pointers are compared by address, as with ==.
+   */
+  bool compare_exchange(
+      std::shared_ptr<T>& expected,
+      const std::shared_ptr<T>& desired) {
+    std::unique_ptr<Slots> newslots;
+    folly::hazptr_holder<> hazptr;
+    auto slots = hazptr.get_protected(slots_);
+    while (true) {
+      if (slots->ptr_ != expected) {
+        expected = slots->ptr_;
+        return false;
+      }
+      if (!newslots) {
+        newslots = makeSlots(desired);
+      }
+      auto oldslots = slots;
+      // On failure slots is loaded again, and must be protected before
+      // it is dereferenced.
+      if (slots_.compare_exchange_strong(oldslots, newslots.get())) {
+        newslots.release();
+        slots->retire();
+        return true;
+      }
+      slots = hazptr.get_protected(slots_);
     }
   }
 
@@ -138,11 +181,39 @@ class AtomicCoreCachedSharedPtr {
     return (slots->slots_)[AccessSpreader<>::current(kNumSlots)];
   }
 
+  /**
+   * Calls f with a T* to the current value, which may be null. The value
+   * is kept alive for the duration of the call, but the pointer must not
+   * be retained after f returns.
+   */
+  template <class F>
+  auto withPtr(F&& f) const -> decltype(f(std::declval<T*>())) {
+    folly::hazptr_holder<> hazptr;
+    auto slots = hazptr.get_protected(slots_);
+    return std::forward<F>(f)(slots ? slots->ptr_.get() : nullptr);
+  }
+
  private:
   using Holder = std::shared_ptr<T>;
   struct Slots : folly::hazptr_obj_base<Slots> {
+    std::shared_ptr<T> ptr_;
     std::array<std::shared_ptr<T>, kNumSlots> slots_;
   };
+
+  static std::unique_ptr<Slots> makeSlots(const std::shared_ptr<T>& p) {
+    auto newslots = folly::make_unique<Slots>();
+    newslots->ptr_ = p;
+    // Allocate each Holder in a different CoreRawAllocator stripe to
+    // prevent false sharing. Their control blocks will be adjacent
+    // thanks to allocate_shared().
+    for (auto slot : folly::enumerate(newslots->slots_)) {
+      auto alloc = getCoreAllocator<Holder, kNumSlots>(slot.index);
+      auto holder = std::allocate_shared<Holder>(alloc, p);
+      *slot = std::shared_ptr<T>(holder, p.get());
+    }
+    return newslots;
+  }
+
   std::atomic<Slots*> slots_{nullptr};
 };
 
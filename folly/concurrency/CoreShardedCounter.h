@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include <folly/concurrency/CacheLocality.h>
+
+namespace folly {
+
+/**
+ * Statistics counters and gauges whose values are spread over per-core
+ * shards, to be updated from many threads at little more than the cost
+ * of an uncontended atomic operation.
+ *
+ * Each shard is allocated with getCoreAllocator(), so the shards of
+ * different objects that belong to the same core share cache lines, and
+ * those cache lines are not shared with the other cores. An object
+ * only holds the kNumShards pointers to its shards.
+ *
+ * Unlike ThreadCachedInt, reads do not take any lock nor synchronize
+ * with thread creation and exit: they load each shard once, so reading
+ * never stalls the writers. A read that is concurrent with updates sees
+ * each update either entirely or not at all, but is not a snapshot of
+ * one point in time.
+ */
+
+namespace detail {
+
+template <typename T, size_t kNumShards>
+class CoreShards {
+  static_assert(kNumShards > 0, "kNumShards must be positive");
+
+ public:
+  explicit CoreShards(T initialVal) {
+    for (size_t i = 0; i < kNumShards; ++i) {
+      auto alloc = getCoreAllocator<std::atomic<T>, kNumShards>(i);
+      shards_[i] = new (alloc.allocate(1)) std::atomic<T>(initialVal);
+    }
+  }
+
+  CoreShards(const CoreShards&) = delete;
+  CoreShards& operator=(const CoreShards&) = delete;
+
+  ~CoreShards() {
+    for (size_t i = 0; i < kNumShards; ++i) {
+      auto alloc = getCoreAllocator<std::atomic<T>, kNumShards>(i);
+      shards_[i]->~atomic();
+      alloc.deallocate(shards_[i], 1);
+    }
+  }
+
+  std::atomic<T>& local() const {
+    return *shards_[AccessSpreader<>::cachedCurrent(kNumShards)];
+  }
+
+  std::atomic<T>& operator[](size_t i) const {
+    return *shards_[i];
+  }
+
+ private:
+  std::array<std::atomic<T>*, kNumShards> shards_;
+};
+
+} // namespace detail
+
+/**
+ * A sum, for example of events or bytes. T may be an integral or a
+ * floating point type; integers are updated with fetch_add, floating
+ * point values with a compare-exchange loop.
+ */
+template <typename T, size_t kNumShards = 64>
+class CoreShardedCounter {
+  static_assert(std::is_arithmetic<T>::value, "T must be arithmetic");
+
+ public:
+  explicit CoreShardedCounter(T initialVal = 0) : shards_(T(0)) {
+    shards_[0].store(initialVal, std::memory_order_relaxed);
+  }
+
+  void increment(T inc) {
+    add(shards_.local(), inc, std::is_integral<T>{});
+  }
+
+  void decrement(T dec) {
+    increment(-dec);
+  }
+
+  CoreShardedCounter& operator+=(T inc) {
+    increment(inc);
+    return *this;
+  }
+  CoreShardedCounter& operator-=(T dec) {
+    decrement(dec);
+    return *this;
+  }
+  CoreShardedCounter& operator++() {
+    increment(1);
+    return *this;
+  }
+  CoreShardedCounter& operator--() {
+    decrement(1);
+    return *this;
+  }
+
+  T readFull() const {
+    T ret = 0;
+    for (size_t i = 0; i < kNumShards; ++i) {
+      ret += shards_[i].load(std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  /// Reads and resets the value. No update is lost nor counted twice by
+  /// successive calls, even when they race with the updates.
+  T readFullAndReset() {
+    T ret = 0;
+    for (size_t i = 0; i < kNumShards; ++i) {
+      ret += shards_[i].exchange(0, std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  void set(T newVal) {
+    for (size_t i = 1; i < kNumShards; ++i) {
+      shards_[i].store(0, std::memory_order_relaxed);
+    }
+    shards_[0].store(newVal, std::memory_order_relaxed);
+  }
+
+ private:
+  static void add(std::atomic<T>& shard, T inc, std::true_type) {
+    shard.fetch_add(inc, std::memory_order_relaxed);
+  }
+
+  static void add(std::atomic<T>& shard, T inc, std::false_type) {
+    auto cur = shard.load(std::memory_order_relaxed);
+    while (!shard.compare_exchange_weak(
+        cur, cur + inc, std::memory_order_relaxed)) {
+    }
+  }
+
+  detail::CoreShards<T, kNumShards> shards_;
+};
+
+/**
+ * The extremum of the values it was updated with since it was created
+ * or last reset, for example a high watermark. Compare(a, b) is true if
+ * b should replace a; updates that would not change the local shard do
+ * not write to it, so the steady state is read-only.
+ */
+template <typename T, typename Compare, size_t kNumShards = 64>
+class CoreShardedGauge {
+ public:
+  /// identity is the value of an empty gauge, e.g. the lowest value of T
+  /// for a maximum.
+  explicit CoreShardedGauge(T identity, Compare compare = Compare())
+      : identity_(identity), compare_(compare), shards_(identity) {}
+
+  void update(T val) {
+    auto& shard = shards_.local();
+    auto cur = shard.load(std::memory_order_relaxed);
+    while (compare_(cur, val) &&
+           !shard.compare_exchange_weak(
+               cur, val, std::memory_order_relaxed)) {
+    }
+  }
+
+  T read() const {
+    T ret = identity_;
+    for (size_t i = 0; i < kNumShards; ++i) {
+      auto val = shards_[i].load(std::memory_order_relaxed);
+      if (compare_(ret, val)) {
+        ret = val;
+      }
+    }
+    return ret;
+  }
+
+  /// Reads the value and resets the gauge to identity.
+  T readAndReset() {
+    T ret = identity_;
+    for (size_t i = 0; i < kNumShards; ++i) {
+      auto val = shards_[i].exchange(identity_, std::memory_order_relaxed);
+      if (compare_(ret, val)) {
+        ret = val;
+      }
+    }
+    return ret;
+  }
+
+ private:
+  const T identity_;
+  Compare compare_;
+  detail::CoreShards<T, kNumShards> shards_;
+};
+
+template <typename T, size_t kNumShards = 64>
+class CoreShardedMax : public CoreShardedGauge<T, std::less<T>, kNumShards> {
+ public:
+  explicit CoreShardedMax(T identity = std::numeric_limits<T>::lowest())
+      : CoreShardedGauge<T, std::less<T>, kNumShards>(identity) {}
+};
+
+template <typename T, size_t kNumShards = 64>
+class CoreShardedMin
+    : public CoreShardedGauge<T, std::greater<T>, kNumShards> {
+ public:
+  explicit CoreShardedMin(T identity = std::numeric_limits<T>::max())
+      : CoreShardedGauge<T, std::greater<T>, kNumShards>(identity) {}
+};
+
+} // namespace folly
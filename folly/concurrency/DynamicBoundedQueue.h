@@ -131,6 +131,12 @@ namespace folly {
 ///         Tries to add an element to the end of the queue if
 ///         capacity allows until the expiration of the specified
 ///         duration. Returns true if successful, otherwise false.
+///     void enqueue_batch(Iter first, Iter last);
+///         Adds the elements in [first, last) to the end of the queue,
+///         in order. If their total weight fits in the capacity, it is
+///         added to the debit at once. Otherwise the elements are
+///         enqueued one at a time, waiting as needed. Iter must be a
+///         forward iterator.
 ///
 ///   Consumer functions:
 ///     void dequeue(T&);
@@ -148,6 +154,10 @@ namespace folly {
 ///         if available until the expiration of the specified
 ///         duration.  Returns true if successful. Otherwise Returns
 ///         false.
+///     size_t try_dequeue_batch(T* elems, size_t max);
+///         Extracts up to max elements from the front of the queue
+///         into elems and credits their total weight at once. Returns
+///         the number of elements extracted.
 ///
 ///   Secondary functions:
 ///     void reset_capacity(size_t capacity);
@@ -386,6 +396,22 @@ class DynamicBoundedQueue {
     return tryEnqueueForImpl(std::move(v), duration);
   }
 
+  /** enqueue_batch */
+  template <typename Iter>
+  void enqueue_batch(Iter first, Iter last) {
+    Weight weight = 0;
+    for (auto it = first; it != last; ++it) {
+      weight += WeightFn()(*it);
+    }
+    if (LIKELY(tryAddDebit(weight))) {
+      q_.enqueue_batch(first, last);
+      return;
+    }
+    for (; first != last; ++first) {
+      enqueueImpl(*first);
+    }
+  }
+
   /// Dequeue functions
 
   /** dequeue */
@@ -427,6 +453,19 @@ class DynamicBoundedQueue {
     return false;
   }
 
+  /** try_dequeue_batch */
+  size_t try_dequeue_batch(T* elems, size_t max) {
+    size_t n = q_.try_dequeue_batch(elems, max);
+    if (n > 0) {
+      Weight weight = 0;
+      for (size_t i = 0; i < n; ++i) {
+        weight += WeightFn()(elems[i]);
+      }
+      addCredit(weight);
+    }
+    return n;
+  }
+
   /// Secondary functions
 
   /** reset_capacity */
@@ -21,6 +21,7 @@
 
 #include <folly/concurrency/UnboundedQueue.h>
 #include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
 
 namespace folly {
 
@@ -29,6 +30,13 @@ namespace folly {
 /// A set of per-priority queues, and an interface for accessing them.
 ///
 /// Functions:
+///   Producer operations:
+///     void enqueue(size_t priority, const T&);
+///     void enqueue(size_t priority, T&&);
+///       Adds an element to the backing queue at the given priority, and
+///       marks that priority as non-empty so that consumers find it
+///       without checking every backing queue.
+///
 ///   Consumer operations:
 ///     bool try_dequeue(T&);
 ///     Optional<T> try_dequeue();
@@ -40,6 +48,18 @@ namespace folly {
 ///       SingleConsumer is true.
 ///     Note:
 ///       Queues at lower priority are tried before queues at higher priority.
+///       If an aging interval is set, every agingInterval-th dequeue
+///       instead takes from the first non-empty queue at or after a
+///       cursor that moves on by one priority each time, so that no
+///       non-empty queue waits more than about agingInterval * priorities
+///       dequeues. try_peek() ignores aging.
+///     Note:
+///       Elements added through enqueue() are found through a bitmap of
+///       non-empty priorities. Elements added directly through
+///       at_priority() are only found by a scan of all the queues, after
+///       the bitmap comes up empty, and are not subject to aging. So is,
+///       rarely, an element enqueued while a consumer finds its queue
+///       empty, until the next enqueue at its priority.
 ///
 ///   Secondary functions:
 ///     queue& at_priority(size_t);
@@ -71,7 +91,12 @@ class PriorityUnboundedQueueSet {
       LgAlign,
       Atom>;
 
-  explicit PriorityUnboundedQueueSet(size_t priorities) : queues_(priorities) {}
+  explicit PriorityUnboundedQueueSet(
+      size_t priorities,
+      size_t agingInterval = 0)
+      : queues_(priorities),
+        nonEmpty_((priorities + kBitsPerWord - 1) / kBitsPerWord),
+        agingInterval_(agingInterval) {}
 
   PriorityUnboundedQueueSet(PriorityUnboundedQueueSet const&) = delete;
   PriorityUnboundedQueueSet(PriorityUnboundedQueueSet&&) = delete;
@@ -87,16 +112,33 @@ class PriorityUnboundedQueueSet {
     return queues_.at(priority);
   }
 
+  void enqueue(size_t priority, const T& item) {
+    at_priority(priority).enqueue(item);
+    markNonEmpty(priority);
+  }
+
+  void enqueue(size_t priority, T&& item) {
+    at_priority(priority).enqueue(std::move(item));
+    markNonEmpty(priority);
+  }
+
   bool try_dequeue(T& item) noexcept {
-    for (auto& q : queues_) {
-      if (q.try_dequeue(item)) {
-        return true;
-      }
+    if (auto o = try_dequeue()) {
+      item = std::move(*o);
+      return true;
     }
     return false;
   }
 
   Optional<T> try_dequeue() noexcept {
+    size_t const start = agingStart();
+    for (size_t p = nextNonEmpty(start); p != priorities();
+         p = nextNonEmpty(start)) {
+      if (auto item = queues_[p].try_dequeue()) {
+        return item;
+      }
+      clearIfEmpty(p);
+    }
     for (auto& q : queues_) {
       if (auto item = q.try_dequeue()) {
         return item;
@@ -137,7 +179,76 @@ class PriorityUnboundedQueueSet {
   }
 
  private:
+  static constexpr size_t kBitsPerWord = 64;
+
+  // Producers set the bit of a priority after enqueueing, and consumers
+  // clear it before checking the queue for emptiness. The bit is usually
+  // set already, so producers only load it, and pay for a seq_cst update
+  // when it is clear. A producer that loads the bit just before a consumer
+  // clears it can leave an element unmarked; try_dequeue() still finds it
+  // with its fallback scan, and the next enqueue sets the bit again.
+  void markNonEmpty(size_t priority) noexcept {
+    auto& word = nonEmpty_[priority / kBitsPerWord];
+    uint64_t const bit = uint64_t(1) << (priority % kBitsPerWord);
+    if (!(word.load(std::memory_order_relaxed) & bit)) {
+      word.fetch_or(bit, std::memory_order_seq_cst);
+    }
+  }
+
+  void clearIfEmpty(size_t priority) noexcept {
+    auto& word = nonEmpty_[priority / kBitsPerWord];
+    uint64_t const bit = uint64_t(1) << (priority % kBitsPerWord);
+    word.fetch_and(~bit, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!queues_[priority].empty()) {
+      word.fetch_or(bit, std::memory_order_acq_rel);
+    }
+  }
+
+  // Returns the first priority marked non-empty at or after start,
+  // wrapping around, or priorities() if there is none.
+  size_t nextNonEmpty(size_t start) const noexcept {
+    size_t const words = nonEmpty_.size();
+    if (words == 0) {
+      return priorities();
+    }
+    size_t w = start / kBitsPerWord;
+    uint64_t bits = nonEmpty_[w].load(std::memory_order_acquire) &
+        (~uint64_t(0) << (start % kBitsPerWord));
+    for (size_t i = 0; i < words; ++i) {
+      if (bits) {
+        return w * kBitsPerWord + findFirstSet(bits) - 1;
+      }
+      w = w + 1 == words ? 0 : w + 1;
+      bits = nonEmpty_[w].load(std::memory_order_acquire);
+    }
+    return bits ? w * kBitsPerWord + findFirstSet(bits) - 1 : priorities();
+  }
+
+  size_t agingStart() noexcept {
+    if (agingInterval_ == 0 || queues_.empty()) {
+      return 0;
+    }
+    if (fetchIncrement(dequeues_) % agingInterval_ != agingInterval_ - 1) {
+      return 0;
+    }
+    return fetchIncrement(agingCursor_) % priorities();
+  }
+
+  static size_t fetchIncrement(Atom<size_t>& counter) noexcept {
+    if (SingleConsumer) {
+      size_t const oldval = counter.load(std::memory_order_relaxed);
+      counter.store(oldval + 1, std::memory_order_relaxed);
+      return oldval;
+    }
+    return counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
   std::vector<queue> queues_;
+  std::vector<Atom<uint64_t>> nonEmpty_;
+  size_t const agingInterval_;
+  Atom<size_t> dequeues_{0};
+  Atom<size_t> agingCursor_{0};
 }; // PriorityUnboundedQueueSet
 
 /* Aliases */
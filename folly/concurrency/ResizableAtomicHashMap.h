@@ -0,0 +1,644 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <folly/hash/Hash.h>
+#include <folly/lang/Align.h>
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/AsymmetricMemoryBarrier.h>
+#include <folly/synchronization/Hazptr.h>
+
+namespace folly {
+
+/// ResizableAtomicHashMap is a lock-free open-addressing hash map with
+/// integral keys that grows, and shrinks again after erasures, by
+/// migrating its entries to a new table.
+///
+/// Unlike AtomicHashMap, which grows by chaining more and more submaps
+/// and never reclaims erased slots, lookups only ever go through one
+/// table, except while a resize is in progress.
+///
+/// Template parameters:
+/// - KeyT: trivially copyable key type that can be used with Atom,
+///   usually an integer. One value (Config::emptyKey) is reserved.
+/// - ValueT: value type, which does not need to be copyable or
+///   movable. Values are stored in separately allocated nodes.
+/// - HashFn: hash function of the keys. Its result is mixed with
+///   twang_mix64, so std::hash is fine for integers.
+///
+/// Functions:
+///   std::pair<Accessor, bool> insert(KeyT key, Args&&... args);
+///       Constructs the value of key from args if key is absent.
+///       Returns the value of key and whether it was inserted.
+///   Accessor insert_or_assign(KeyT key, V&& value);
+///       Replaces the value of key.
+///   size_t erase(KeyT key);
+///       Returns the number of erased entries, 0 or 1.
+///   Accessor find(KeyT key) const;
+///   void forEach(F f) const;
+///       Calls f(const KeyT&, ValueT&) on every entry; see below.
+///   size_t size() const;
+///       Number of entries, accurate only if the map is not changed
+///       concurrently.
+///
+/// An Accessor has a hazard pointer to its entry, which is not
+/// reclaimed, even if it is erased or replaced, while the accessor
+/// exists. Values can be updated in place through accessors if they
+/// are themselves thread-safe, e.g. std::atomic counters; this
+/// survives resizes, which move nodes to the new table rather than
+/// copy them.
+///
+/// Resizing:
+///   Each table counts the keys that ever had a slot in it, including
+///   erased ones. When that count reaches capacity * maxLoadFactor, a
+///   new table is allocated, sized for twice the current number of
+///   entries, and every thread that uses the old table, readers
+///   included, migrates a chunk of its slots before going on. Erased
+///   slots are not migrated, which is how they are reclaimed. A slot
+///   is migrated by freezing it, after which writers of its key go to
+///   the new table, and copying its node there. Once all chunks are
+///   migrated the new table replaces the old one, which is reclaimed
+///   through hazard pointers. The migration of a chunk claimed by a
+///   preempted thread delays that replacement but blocks no
+///   operation.
+///
+///   forEach() first migrates what is left to migrate, then iterates
+///   over the newest table. Entries that are present during the whole
+///   iteration are visited exactly once, even if another resize
+///   starts meanwhile; entries inserted or erased concurrently may or
+///   may not be visited.
+///
+/// Usage example:
+/// @code
+///   ResizableAtomicHashMap<int64_t, std::atomic<int64_t>> counters;
+///   auto acc = counters.insert(key, 0).first;
+///   acc.value().fetch_add(1);
+/// @endcode
+template <
+    typename KeyT,
+    typename ValueT,
+    typename HashFn = std::hash<KeyT>,
+    template <typename> class Atom = std::atomic>
+class ResizableAtomicHashMap {
+  static_assert(
+      std::is_trivially_copyable<KeyT>::value,
+      "ResizableAtomicHashMap keys must be trivially copyable");
+
+  class Node;
+  class Table;
+  struct Slot;
+
+ public:
+  struct Config {
+    KeyT emptyKey;
+    double maxLoadFactor;
+
+    Config() : emptyKey(static_cast<KeyT>(-1)), maxLoadFactor(0.8) {}
+  };
+
+  class Accessor {
+   public:
+    Accessor() = default;
+
+    explicit operator bool() const {
+      return node_ != nullptr;
+    }
+
+    const KeyT& key() const {
+      return node_->key_;
+    }
+
+    ValueT& value() const {
+      return node_->value_;
+    }
+
+   private:
+    friend class ResizableAtomicHashMap;
+
+    hazptr_holder<Atom> hazptr_;
+    Node* node_{nullptr};
+  };
+
+  explicit ResizableAtomicHashMap(
+      size_t initialSize = 0,
+      const Config& config = Config())
+      : config_(config) {
+    CHECK_GT(config_.maxLoadFactor, 0.0);
+    CHECK_LT(config_.maxLoadFactor, 1.0);
+    head_.store(
+        new Table(capacityFor(initialSize), 0, config_),
+        std::memory_order_release);
+  }
+
+  ResizableAtomicHashMap(const ResizableAtomicHashMap&) = delete;
+  ResizableAtomicHashMap& operator=(const ResizableAtomicHashMap&) = delete;
+
+  ~ResizableAtomicHashMap() {
+    auto t = head_.load(std::memory_order_relaxed);
+    while (t) {
+      for (size_t i = 0; i < t->capacity_; ++i) {
+        auto v = t->slots_[i].value.load(std::memory_order_relaxed);
+        DCHECK(!isNode(v) || !(v & kFrozen));
+        if (isNode(v)) {
+          delete toNode(v);
+        }
+      }
+      auto next = t->next_.load(std::memory_order_relaxed);
+      delete t;
+      t = next;
+    }
+  }
+
+  template <typename... Args>
+  std::pair<Accessor, bool> insert(KeyT key, Args&&... args) {
+    auto node = new Node(key, std::forward<Args>(args)...);
+    Accessor res;
+    res.hazptr_.reset(node);
+    hazptr_holder<Atom> h;
+    auto old = write(key, WriteOp::kInsert, toValue(node), h);
+    if (isNode(old)) {
+      delete node;
+      res.hazptr_ = std::move(h);
+      res.node_ = toNode(old);
+      return {std::move(res), false};
+    }
+    res.node_ = node;
+    return {std::move(res), true};
+  }
+
+  template <typename V>
+  Accessor insert_or_assign(KeyT key, V&& value) {
+    auto node = new Node(key, std::forward<V>(value));
+    Accessor res;
+    res.hazptr_.reset(node);
+    hazptr_holder<Atom> h;
+    write(key, WriteOp::kAssign, toValue(node), h);
+    res.node_ = node;
+    return res;
+  }
+
+  size_t erase(KeyT key) {
+    hazptr_holder<Atom> h;
+    return isNode(write(key, WriteOp::kErase, kErased, h)) ? 1 : 0;
+  }
+
+  Accessor find(KeyT key) const {
+    DCHECK(key != config_.emptyKey);
+    Accessor res;
+    hazptr_array<3, Atom> hs;
+    auto hash = hashOf(key);
+    auto t = hs[0].get_protected(head_);
+    while (true) {
+      auto next = t->next_.load(std::memory_order_acquire);
+      if (next) {
+        helpResize(t, hs[1], hs[2]);
+      }
+      bool full;
+      auto s = findSlot(t, key, hash, false, full);
+      if (s) {
+        auto v = protect(res.hazptr_, *s);
+        if (isNode(v)) {
+          // a frozen node is still current until its copy is done
+          res.node_ = toNode(v);
+          return res;
+        }
+        if (!(v & kFrozen)) {
+          return res;
+        }
+      } else if (!full) {
+        return res;
+      }
+      // a resize may have started since next_ was loaded
+      next = t->next_.load(std::memory_order_acquire);
+      if (!next) {
+        return res;
+      }
+      if (!protectNext(hs[1], t, next)) {
+        t = hs[0].get_protected(head_);
+        continue;
+      }
+      hs[0].swap(hs[1]);
+      t = next;
+    }
+  }
+
+  template <typename F>
+  void forEach(F f) const {
+    hazptr_array<3, Atom> hs;
+    hazptr_holder<Atom> h;
+    auto t = hs[0].get_protected(head_);
+    // After this the newest table has a slot for every entry.
+    while (auto next = t->next_.load(std::memory_order_acquire)) {
+      for (size_t i = 0; i < t->capacity_; ++i) {
+        migrateSlot(t, t->slots_[i], hs[1], hs[2]);
+      }
+      if (!protectNext(hs[1], t, next)) {
+        t = hs[0].get_protected(head_);
+        continue;
+      }
+      hs[0].swap(hs[1]);
+      t = next;
+    }
+    for (size_t i = 0; i < t->capacity_; ++i) {
+      auto& s = t->slots_[i];
+      auto v = protect(h, s);
+      if (isNode(v)) {
+        auto node = toNode(v);
+        f(node->key_, node->value_);
+      } else if (v == kMoved) {
+        // migrated by a resize that started since
+        auto acc = find(s.key.load(std::memory_order_relaxed));
+        if (acc) {
+          f(acc.key(), acc.value());
+        }
+      }
+    }
+  }
+
+  size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /// Capacity of the newest table.
+  size_t capacity() const {
+    hazptr_holder<Atom> h;
+    auto t = h.get_protected(head_);
+    while (auto next = t->next_.load(std::memory_order_acquire)) {
+      if (!protectNext(h, t, next)) {
+        t = h.get_protected(head_);
+        continue;
+      }
+      t = next;
+    }
+    return t->capacity_;
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kMigrateChunk = 256;
+
+  // Values of slots other than node pointers. A frozen slot is
+  // migrated, or being migrated, to the next table; a frozen node
+  // pointer is the current value of its key until it is copied there.
+  static constexpr uintptr_t kEmpty = 0;
+  static constexpr uintptr_t kErased = 1;
+  static constexpr uintptr_t kFrozen = 2;
+  // frozen before any value was written: the key may be in a later
+  // table only if it was written there
+  static constexpr uintptr_t kMovedEmpty = kFrozen;
+  // frozen after a value was written, and copied if it was a node
+  static constexpr uintptr_t kMoved = kFrozen | kErased;
+
+  class Node : public hazptr_obj_base<Node, Atom> {
+   public:
+    template <typename... Args>
+    explicit Node(KeyT key, Args&&... args)
+        : key_(key), value_(std::forward<Args>(args)...) {}
+
+    const KeyT key_;
+    ValueT value_;
+  };
+
+  static_assert(alignof(Node) > kMoved, "Node pointers need spare bits");
+
+  struct Slot {
+    Atom<KeyT> key;
+    Atom<uintptr_t> value;
+  };
+
+  class Table : public hazptr_obj_base<Table, Atom> {
+   public:
+    Table(size_t capacity, size_t seq, const Config& config)
+        : capacity_(capacity),
+          maxClaims_(std::max<size_t>(1, capacity * config.maxLoadFactor)),
+          seq_(seq),
+          slots_(new Slot[capacity]) {
+      for (size_t i = 0; i < capacity_; ++i) {
+        slots_[i].key.store(config.emptyKey, std::memory_order_relaxed);
+        slots_[i].value.store(kEmpty, std::memory_order_relaxed);
+      }
+    }
+
+    const size_t capacity_;
+    const size_t maxClaims_;
+    // incremented by each resize
+    const size_t seq_;
+    Atom<Table*> next_{nullptr};
+    // keys that were given a slot
+    alignas(hardware_destructive_interference_size) Atom<size_t> claimed_{0};
+    // each migrating thread claims kMigrateChunk slots from migrateIdx_,
+    // and adds them to migrated_ when done
+    alignas(hardware_destructive_interference_size)
+        Atom<size_t> migrateIdx_{0};
+    Atom<size_t> migrated_{0};
+    std::unique_ptr<Slot[]> slots_;
+  };
+
+  enum class WriteOp { kInsert, kAssign, kErase };
+
+  static bool isNode(uintptr_t v) {
+    return (v & ~kMoved) != 0;
+  }
+
+  static Node* toNode(uintptr_t v) {
+    return reinterpret_cast<Node*>(v & ~kFrozen);
+  }
+
+  static uintptr_t toValue(Node* node) {
+    return reinterpret_cast<uintptr_t>(node);
+  }
+
+  static size_t hashOf(KeyT key) {
+    return static_cast<size_t>(hash::twang_mix64(HashFn()(key)));
+  }
+
+  size_t capacityFor(size_t size) const {
+    return nextPowTwo(std::max(
+        kMinCapacity, static_cast<size_t>(size / config_.maxLoadFactor) + 1));
+  }
+
+  // Protects the node of s, if any, with h; returns the value that was
+  // protected.
+  static uintptr_t protect(hazptr_holder<Atom>& h, const Slot& s) {
+    auto v = s.value.load(std::memory_order_acquire);
+    while (isNode(v)) {
+      h.reset(toNode(v));
+      folly::asymmetricLightBarrier();
+      auto w = s.value.load(std::memory_order_acquire);
+      if (w == v) {
+        break;
+      }
+      v = w;
+    }
+    return v;
+  }
+
+  // Protects next, the successor of the protected table t. Fails if next
+  // may have been retired, which is only possible once t was migrated.
+  bool protectNext(hazptr_holder<Atom>& h, const Table* t, Table* next)
+      const {
+    auto seq = t->seq_ + 1;
+    h.reset(next);
+    folly::asymmetricLightBarrier();
+    return headSeq_.load(std::memory_order_acquire) <= seq;
+  }
+
+  // Returns the slot of key in t, claiming an empty one for it if claim
+  // is set, or nullptr. full is set if the whole table was probed.
+  Slot* findSlot(Table* t, KeyT key, size_t hash, bool claim, bool& full)
+      const {
+    full = false;
+    const auto mask = t->capacity_ - 1;
+    auto idx = hash & mask;
+    for (size_t probes = 0; probes < t->capacity_; ++probes) {
+      auto& s = t->slots_[idx];
+      auto k = s.key.load(std::memory_order_acquire);
+      if (k == key) {
+        return &s;
+      }
+      if (k == config_.emptyKey) {
+        if (!claim) {
+          return nullptr;
+        }
+        if (s.key.compare_exchange_strong(k, key, std::memory_order_acq_rel)) {
+          if (t->claimed_.fetch_add(1, std::memory_order_relaxed) + 1 >=
+              t->maxClaims_) {
+            startResize(t);
+          }
+          return &s;
+        }
+        if (k == key) {
+          return &s;
+        }
+      }
+      idx = (idx + 1) & mask;
+    }
+    full = true;
+    return nullptr;
+  }
+
+  // Returns the successor of t, allocating it if there is none yet.
+  Table* startResize(Table* t) const {
+    auto next = t->next_.load(std::memory_order_acquire);
+    if (next) {
+      return next;
+    }
+    auto created = new Table(
+        capacityFor(2 * size_.load(std::memory_order_relaxed)),
+        t->seq_ + 1,
+        config_);
+    if (t->next_.compare_exchange_strong(
+            next, created, std::memory_order_acq_rel)) {
+      return created;
+    }
+    delete created;
+    return next;
+  }
+
+  // Writes key in the newest table that has it, migrating its slots in
+  // the older ones. Returns the previous value of key; its node, if any,
+  // is protected by h.
+  uintptr_t
+  write(KeyT key, WriteOp op, uintptr_t desired, hazptr_holder<Atom>& h) {
+    DCHECK(key != config_.emptyKey);
+    hazptr_array<3, Atom> hs;
+    auto hash = hashOf(key);
+    auto t = hs[0].get_protected(head_);
+    while (true) {
+      bool full;
+      // Keys are given a slot in every table they are written through,
+      // so that finding an empty slot means a key is in no later table.
+      auto s = findSlot(t, key, hash, op != WriteOp::kErase, full);
+      if (!s && !full) {
+        return kEmpty;
+      }
+      auto next = t->next_.load(std::memory_order_acquire);
+      if (s && !next) {
+        auto v = protect(h, *s);
+        while (!(v & kFrozen)) {
+          bool live = isNode(v);
+          if (op == WriteOp::kInsert ? live : op == WriteOp::kErase && !live) {
+            return v;
+          }
+          if (s->value.compare_exchange_weak(
+                  v, desired, std::memory_order_acq_rel)) {
+            if (!live) {
+              size_.fetch_add(1, std::memory_order_acq_rel);
+            } else {
+              if (desired == kErased) {
+                size_.fetch_sub(1, std::memory_order_acq_rel);
+              }
+              toNode(v)->retire();
+            }
+            return v;
+          }
+          v = protect(h, *s);
+        }
+        // a resize started since next_ was loaded
+        next = t->next_.load(std::memory_order_acquire);
+      }
+      if (!next) {
+        next = startResize(t);
+      }
+      if (s) {
+        migrateSlot(t, *s, hs[1], hs[2]);
+      }
+      helpResize(t, hs[1], hs[2]);
+      if (!protectNext(hs[1], t, next)) {
+        t = hs[0].get_protected(head_);
+        continue;
+      }
+      hs[0].swap(hs[1]);
+      t = next;
+    }
+  }
+
+  // Freezes s, a slot of the protected table t, and copies its node, if
+  // any, to the next tables. a and b are scratch hazard pointers.
+  void migrateSlot(
+      Table* t,
+      Slot& s,
+      hazptr_holder<Atom>& a,
+      hazptr_holder<Atom>& b) const {
+    auto v = s.value.load(std::memory_order_acquire);
+    while (true) {
+      if (v == kMovedEmpty || v == kMoved) {
+        return;
+      }
+      if (v & kFrozen) {
+        copy(t, s.key.load(std::memory_order_relaxed), v & ~kFrozen, a, b);
+        s.value.compare_exchange_strong(v, kMoved, std::memory_order_acq_rel);
+        return;
+      }
+      auto frozen = v == kEmpty ? kMovedEmpty : v == kErased ? kMoved
+                                                             : v | kFrozen;
+      if (s.value.compare_exchange_weak(
+              v, frozen, std::memory_order_acq_rel)) {
+        v = frozen;
+      }
+    }
+  }
+
+  // Copies node, the frozen value of key in the protected table t, to
+  // the next tables, unless it was already copied. Nodes are only copied
+  // to slots that nothing was ever written to, which keeps a helper
+  // that copies late from undoing a write made since.
+  void copy(
+      Table* t,
+      KeyT key,
+      uintptr_t node,
+      hazptr_holder<Atom>& a,
+      hazptr_holder<Atom>& b) const {
+    auto hash = hashOf(key);
+    hazptr_holder<Atom>* hs[] = {&a, &b};
+    size_t i = 0;
+    while (true) {
+      auto next = startResize(t);
+      if (!protectNext(*hs[i], t, next)) {
+        // t was migrated, so node was copied
+        return;
+      }
+      t = next;
+      i ^= 1;
+      bool full;
+      auto s = findSlot(t, key, hash, true, full);
+      if (!s) {
+        continue;
+      }
+      auto v = s->value.load(std::memory_order_acquire);
+      while (v == kEmpty &&
+             !s->value.compare_exchange_weak(
+                 v, node, std::memory_order_acq_rel)) {
+      }
+      if (v != kMovedEmpty) {
+        return;
+      }
+    }
+  }
+
+  // Migrates a chunk of the protected table t, if any is left.
+  void helpResize(Table* t, hazptr_holder<Atom>& a, hazptr_holder<Atom>& b)
+      const {
+    if (t->migrateIdx_.load(std::memory_order_relaxed) >= t->capacity_) {
+      return;
+    }
+    auto begin =
+        t->migrateIdx_.fetch_add(kMigrateChunk, std::memory_order_relaxed);
+    if (begin >= t->capacity_) {
+      return;
+    }
+    auto end = std::min(begin + kMigrateChunk, t->capacity_);
+    for (auto i = begin; i < end; ++i) {
+      migrateSlot(t, t->slots_[i], a, b);
+    }
+    if (t->migrated_.fetch_add(end - begin) + (end - begin) == t->capacity_) {
+      promote(t, a);
+    }
+  }
+
+  // Replaces t, which was migrated, by its successor if t is the oldest
+  // table. Otherwise this is done when the older ones are migrated.
+  void promote(Table* t, hazptr_holder<Atom>& h) const {
+    while (true) {
+      auto seq = t->seq_ + 1;
+      auto next = t->next_.load(std::memory_order_acquire);
+      auto expected = t;
+      if (!head_.compare_exchange_strong(expected, next)) {
+        return;
+      }
+      // A promoter of an older table may not have stored its own
+      // headSeq_ yet.
+      auto headSeq = headSeq_.load(std::memory_order_acquire);
+      while (headSeq < seq &&
+             !headSeq_.compare_exchange_weak(
+                 headSeq, seq, std::memory_order_acq_rel)) {
+      }
+      h.reset(next);
+      folly::asymmetricLightBarrier();
+      // next can be promoted and retired by another thread from now on
+      bool protectedNext = headSeq_.load(std::memory_order_acquire) == seq;
+      t->retire();
+      if (!protectedNext || next->migrated_.load() != next->capacity_) {
+        return;
+      }
+      t = next;
+    }
+  }
+
+  Config config_;
+  // oldest table, which is followed by the newer ones while resizing
+  mutable Atom<Table*> head_{nullptr};
+  // seq_ of head_
+  mutable Atom<size_t> headSeq_{0};
+  alignas(hardware_destructive_interference_size) Atom<size_t> size_{0};
+};
+
+} // namespace folly
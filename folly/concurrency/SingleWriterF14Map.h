@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <folly/Portability.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/AsymmetricMemoryBarrier.h>
+#include <folly/synchronization/Hazptr.h>
+
+#if FOLLY_SSE >= 2
+#include <immintrin.h>
+#endif
+
+namespace folly {
+
+/// SingleWriterF14Map is a hash map that any number of threads can read
+/// concurrently with one writer thread, with the chunked layout of
+/// F14: each chunk holds 14 entries and a vector of their 7-bit hash
+/// tags, which a lookup matches in one SIMD compare, and keys that
+/// don't fit in their chunk move on to the next one of a double-hashing
+/// probe.
+///
+/// Unlike SingleWriterFixedHashMap, it grows as needed and works with
+/// any key and value types. Entries are stored in separately allocated
+/// immutable nodes, and chunks hold pointers to them.
+///
+/// Writer-only operations, which must not be called concurrently with
+/// each other:
+///   bool insert(const Key& key, Args&&... args);
+///       Constructs the value of key from args if key is absent.
+///   void insert_or_assign(const Key& key, M&& value);
+///       Replaces the node of key, if any, with a new one.
+///   size_t erase(const Key& key);
+///   void clear();
+///   void reserve(size_t size);
+///
+/// Reader operations, which are wait-free unless the writer resizes
+/// the map meanwhile:
+///   ConstAccessor find(const Key& key) const;
+///   bool contains(const Key& key) const;
+///   void forEach(F f) const;
+///       Calls f(const Key&, const Mapped&) on every entry.
+///   size_t size() const;
+///
+/// A ConstAccessor has a hazard pointer to its node, which is not
+/// reclaimed while the accessor exists even if the writer erases or
+/// replaces it. Replacing a value is therefore atomic for readers,
+/// which see either the old node or the new one.
+///
+/// Resizing:
+///   When an insertion would make the map hold more than 12 entries per
+///   chunk, the writer copies the node pointers into a chunk array of
+///   twice the size, publishes it, clears the old one and retires it
+///   through hazard pointers. A lookup that misses in a table that has
+///   been replaced meanwhile is retried in the new one. forEach()
+///   visits every entry that is present during the whole iteration at
+///   least once; it visits entries once more if the map is resized
+///   during the iteration.
+///
+/// Usage example:
+/// @code
+///   SingleWriterF14Map<std::string, Config> configs;
+///   // on the refresh thread
+///   configs.insert_or_assign(name, loadConfig(name));
+///   // on any thread
+///   if (auto acc = configs.find(name)) {
+///     use(acc.value());
+///   }
+/// @endcode
+template <
+    typename Key,
+    typename Mapped,
+    typename Hasher = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    template <typename> class Atom = std::atomic>
+class SingleWriterF14Map {
+  class Node;
+  struct Chunk;
+  class Table;
+
+ public:
+  using key_type = Key;
+  using mapped_type = Mapped;
+  using value_type = std::pair<const Key, Mapped>;
+  using size_type = std::size_t;
+  using hasher = Hasher;
+  using key_equal = KeyEqual;
+
+  class ConstAccessor {
+   public:
+    ConstAccessor() = default;
+
+    explicit operator bool() const {
+      return node_ != nullptr;
+    }
+
+    const Key& key() const {
+      return node_->item_.first;
+    }
+
+    const Mapped& value() const {
+      return node_->item_.second;
+    }
+
+    const value_type& operator*() const {
+      return node_->item_;
+    }
+
+    const value_type* operator->() const {
+      return &node_->item_;
+    }
+
+   private:
+    friend class SingleWriterF14Map;
+
+    hazptr_holder<Atom> hazptr_;
+    const Node* node_{nullptr};
+  };
+
+  explicit SingleWriterF14Map(size_t initialSize = 0)
+      : table_(new Table(chunkCountFor(initialSize))) {}
+
+  SingleWriterF14Map(const SingleWriterF14Map&) = delete;
+  SingleWriterF14Map& operator=(const SingleWriterF14Map&) = delete;
+
+  ~SingleWriterF14Map() {
+    auto t = table_.load(std::memory_order_relaxed);
+    t->forEachNode([](Node* node, Chunk&, size_t) { delete node; });
+    delete t;
+  }
+
+  /* data-race-free, can be called by readers */
+  size_t size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  ConstAccessor find(const Key& key) const {
+    ConstAccessor res;
+    auto hp = splitHash(hasher()(key));
+    hazptr_holder<Atom> h;
+    auto t = h.get_protected(table_);
+    while (true) {
+      if (findNode(res.hazptr_, t, key, hp, res.node_)) {
+        return res;
+      }
+      auto next = table_.load(std::memory_order_acquire);
+      if (next == t) {
+        return res;
+      }
+      // the lookup may have raced with a resize of t
+      t = h.get_protected(table_);
+    }
+  }
+
+  bool contains(const Key& key) const {
+    return static_cast<bool>(find(key));
+  }
+
+  template <typename F>
+  void forEach(F f) const {
+    hazptr_holder<Atom> h;
+    hazptr_holder<Atom> hnode;
+    auto t = h.get_protected(table_);
+    while (true) {
+      for (size_t c = 0; c <= t->chunkMask_; ++c) {
+        auto& chunk = t->chunks_[c];
+        for (size_t i = 0; i < Chunk::kCapacity; ++i) {
+          if (auto node = protect(hnode, chunk.items_[i])) {
+            f(node->item_.first, node->item_.second);
+          }
+        }
+      }
+      if (table_.load(std::memory_order_acquire) == t) {
+        return;
+      }
+      t = h.get_protected(table_);
+    }
+  }
+
+  /* writer-only */
+  template <typename... Args>
+  bool insert(const Key& key, Args&&... args) {
+    auto hp = splitHash(hasher()(key));
+    if (writerFind(key, hp).first) {
+      return false;
+    }
+    auto node = new Node(key, std::forward<Args>(args)...);
+    reserve(size_.load(std::memory_order_relaxed) + 1);
+    table_.load(std::memory_order_relaxed)->insertNode(node, hp);
+    size_.store(
+        size_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* writer-only */
+  template <typename M>
+  void insert_or_assign(const Key& key, M&& value) {
+    auto hp = splitHash(hasher()(key));
+    auto found = writerFind(key, hp);
+    if (!found.first) {
+      insert(key, std::forward<M>(value));
+      return;
+    }
+    auto node = new Node(key, std::forward<M>(value));
+    found.second->store(node, std::memory_order_release);
+    found.first->retire();
+  }
+
+  /* writer-only */
+  size_t erase(const Key& key) {
+    auto hp = splitHash(hasher()(key));
+    auto t = table_.load(std::memory_order_relaxed);
+    auto found = writerFind(key, hp);
+    if (!found.first) {
+      return 0;
+    }
+    t->eraseNode(found.second, hp);
+    size_.store(
+        size_.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+    found.first->retire();
+    return 1;
+  }
+
+  /* writer-only */
+  void clear() {
+    auto t = table_.load(std::memory_order_relaxed);
+    table_.store(new Table(1), std::memory_order_release);
+    size_.store(0, std::memory_order_release);
+    t->forEachNode([](Node* node, Chunk& chunk, size_t i) {
+      chunk.items_[i].store(nullptr, std::memory_order_relaxed);
+      node->retire();
+    });
+    t->retire();
+  }
+
+  /* writer-only */
+  void reserve(size_t size) {
+    auto t = table_.load(std::memory_order_relaxed);
+    if (size <= t->capacity()) {
+      return;
+    }
+    auto next = new Table(chunkCountFor(size));
+    t->forEachNode([&](Node* node, Chunk&, size_t) {
+      next->insertNode(node, splitHash(hasher()(node->item_.first)));
+    });
+    table_.store(next, std::memory_order_release);
+    // Readers that still use t must not find nodes that may be retired
+    // once they are erased from next.
+    t->forEachNode([](Node*, Chunk& chunk, size_t i) {
+      chunk.items_[i].store(nullptr, std::memory_order_release);
+    });
+    t->retire();
+  }
+
+ private:
+  using HashPair = std::pair<size_t, size_t>;
+
+  class Node : public hazptr_obj_base<Node, Atom> {
+   public:
+    template <typename... Args>
+    explicit Node(const Key& key, Args&&... args)
+        : item_(
+              std::piecewise_construct,
+              std::forward_as_tuple(key),
+              std::forward_as_tuple(std::forward<Args>(args)...)) {}
+
+    value_type item_;
+  };
+
+  // The tags are only written by the writer, and only read by readers
+  // as hints: a reader that sees a stale tag either loads a null item
+  // or a node whose key doesn't match, or misses an entry that is
+  // being inserted concurrently.
+  struct alignas(16) Chunk {
+    static constexpr size_t kCapacity = 14;
+    static constexpr size_t kDesiredCapacity = kCapacity - 2;
+    static constexpr unsigned kFullMask = (1u << kCapacity) - 1;
+
+    std::atomic<uint8_t> tags_[kCapacity];
+    uint8_t unused_{0};
+    // Number of keys that wanted this chunk but were placed in a later
+    // chunk of their probe; saturates at 255 like F14's.
+    std::atomic<uint8_t> outboundOverflowCount_;
+    Atom<Node*> items_[kCapacity];
+
+    Chunk() : outboundOverflowCount_(0) {
+      for (size_t i = 0; i < kCapacity; ++i) {
+        tags_[i].store(0, std::memory_order_relaxed);
+        items_[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    unsigned tagMatchMask(size_t needle) const {
+#if FOLLY_SSE >= 2
+      auto tagV = _mm_load_si128(static_cast<const __m128i*>(
+          static_cast<const void*>(&tags_[0])));
+      auto eqV = _mm_cmpeq_epi8(tagV, _mm_set1_epi8(static_cast<char>(needle)));
+      return static_cast<unsigned>(_mm_movemask_epi8(eqV)) & kFullMask;
+#else
+      unsigned mask = 0;
+      for (size_t i = 0; i < kCapacity; ++i) {
+        if (tags_[i].load(std::memory_order_relaxed) == needle) {
+          mask |= 1u << i;
+        }
+      }
+      return mask;
+#endif
+    }
+
+    unsigned outboundOverflowCount() const {
+      return outboundOverflowCount_.load(std::memory_order_acquire);
+    }
+
+    void adjustOutboundOverflowCount(int delta) {
+      auto count = outboundOverflowCount_.load(std::memory_order_relaxed);
+      if (count != 255) {
+        outboundOverflowCount_.store(
+            static_cast<uint8_t>(count + delta), std::memory_order_release);
+      }
+    }
+  };
+
+  static_assert(sizeof(std::atomic<uint8_t>) == 1, "");
+  static_assert(offsetof(Chunk, items_) == 16, "tags must fill a vector");
+
+  class Table : public hazptr_obj_base<Table, Atom> {
+   public:
+    explicit Table(size_t chunkCount)
+        : chunkMask_(chunkCount - 1), chunks_(new Chunk[chunkCount]) {
+      DCHECK(isPowTwo(chunkCount));
+    }
+
+    size_t capacity() const {
+      return (chunkMask_ + 1) * Chunk::kDesiredCapacity;
+    }
+
+    // Writer-only: node must not be in the table.
+    void insertNode(Node* node, HashPair hp) {
+      auto index = hp.first;
+      auto step = probeDelta(hp);
+      while (true) {
+        auto& chunk = chunks_[index & chunkMask_];
+        for (size_t i = 0; i < Chunk::kCapacity; ++i) {
+          if (chunk.tags_[i].load(std::memory_order_relaxed) == 0) {
+            chunk.items_[i].store(node, std::memory_order_release);
+            chunk.tags_[i].store(
+                static_cast<uint8_t>(hp.second), std::memory_order_release);
+            return;
+          }
+        }
+        chunk.adjustOutboundOverflowCount(1);
+        index += step;
+      }
+    }
+
+    // Writer-only.
+    void eraseNode(Atom<Node*>* item, HashPair hp) {
+      auto index = hp.first;
+      auto step = probeDelta(hp);
+      while (true) {
+        auto& chunk = chunks_[index & chunkMask_];
+        if (item >= &chunk.items_[0] &&
+            item < &chunk.items_[Chunk::kCapacity]) {
+          item->store(nullptr, std::memory_order_release);
+          chunk.tags_[item - &chunk.items_[0]].store(
+              0, std::memory_order_release);
+          return;
+        }
+        chunk.adjustOutboundOverflowCount(-1);
+        index += step;
+      }
+    }
+
+    // Writer-only: calls f(Node*, Chunk&, index) on every node.
+    template <typename F>
+    void forEachNode(F f) {
+      for (size_t c = 0; c <= chunkMask_; ++c) {
+        auto& chunk = chunks_[c];
+        for (size_t i = 0; i < Chunk::kCapacity; ++i) {
+          if (auto node = chunk.items_[i].load(std::memory_order_relaxed)) {
+            f(node, chunk, i);
+          }
+        }
+      }
+    }
+
+    const size_t chunkMask_;
+    std::unique_ptr<Chunk[]> chunks_;
+  };
+
+  static HashPair splitHash(size_t hash) {
+    auto mixed = hash::twang_mix64(hash);
+    return {
+        static_cast<size_t>(mixed), static_cast<size_t>(mixed >> 56) | 0x80};
+  }
+
+  static size_t probeDelta(HashPair hp) {
+    return 2 * hp.second + 1;
+  }
+
+  static size_t chunkCountFor(size_t size) {
+    size_t chunks = 1;
+    while (chunks * Chunk::kDesiredCapacity < size) {
+      chunks *= 2;
+    }
+    return chunks;
+  }
+
+  // Protects the node of item, if any, with h.
+  static const Node* protect(hazptr_holder<Atom>& h, const Atom<Node*>& item) {
+    auto node = item.load(std::memory_order_acquire);
+    while (node) {
+      h.reset(node);
+      folly::asymmetricLightBarrier();
+      auto again = item.load(std::memory_order_acquire);
+      if (again == node) {
+        break;
+      }
+      node = again;
+    }
+    return node;
+  }
+
+  // Looks key up in the protected table t; on success, node is set and
+  // protected by h.
+  bool findNode(
+      hazptr_holder<Atom>& h,
+      const Table* t,
+      const Key& key,
+      HashPair hp,
+      const Node*& node) const {
+    auto index = hp.first;
+    auto step = probeDelta(hp);
+    for (size_t tries = 0; tries <= t->chunkMask_; ++tries) {
+      auto& chunk = t->chunks_[index & t->chunkMask_];
+      auto hits = chunk.tagMatchMask(hp.second);
+      while (hits) {
+        auto i = findFirstSet(hits) - 1;
+        hits &= hits - 1;
+        auto candidate = protect(h, chunk.items_[i]);
+        if (candidate && key_equal()(key, candidate->item_.first)) {
+          node = candidate;
+          return true;
+        }
+      }
+      if (LIKELY(chunk.outboundOverflowCount() == 0)) {
+        break;
+      }
+      index += step;
+    }
+    h.reset();
+    return false;
+  }
+
+  // Writer-only: the node of key and the item that points to it.
+  std::pair<Node*, Atom<Node*>*> writerFind(const Key& key, HashPair hp) {
+    auto t = table_.load(std::memory_order_relaxed);
+    auto index = hp.first;
+    auto step = probeDelta(hp);
+    for (size_t tries = 0; tries <= t->chunkMask_; ++tries) {
+      auto& chunk = t->chunks_[index & t->chunkMask_];
+      auto hits = chunk.tagMatchMask(hp.second);
+      while (hits) {
+        auto i = findFirstSet(hits) - 1;
+        hits &= hits - 1;
+        auto node = chunk.items_[i].load(std::memory_order_relaxed);
+        if (node && key_equal()(key, node->item_.first)) {
+          return {node, &chunk.items_[i]};
+        }
+      }
+      if (chunk.outboundOverflowCount() == 0) {
+        break;
+      }
+      index += step;
+    }
+    return {nullptr, nullptr};
+  }
+
+  Atom<Table*> table_;
+  Atom<size_t> size_{0};
+};
+
+} // namespace folly
@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <iterator>
 #include <memory>
 
 #include <glog/logging.h>
@@ -79,6 +81,10 @@ namespace folly {
 ///     void enqueue(const T&);
 ///     void enqueue(T&&);
 ///         Adds an element to the end of the queue.
+///     void enqueue_batch(Iter first, Iter last);
+///         Adds the elements in [first, last) to the end of the queue,
+///         in order, taking all their tickets at once. The elements
+///         of a batch may be interleaved with those of other producers.
 ///
 ///   Consumer operations:
 ///     void dequeue(T&);
@@ -93,6 +99,12 @@ namespace folly {
 ///     folly::Optional<T> try_dequeue_until(time_point& deadline);
 ///         Tries to extract an element from the front of the queue
 ///         if available until the specified deadline.
+///     size_t try_dequeue_batch(T* items, size_t max);
+///         Extracts up to max elements from the front of the queue
+///         into items, taking all their tickets at once. Returns the
+///         number of elements extracted, which may be zero. Elements
+///         that producers have started but not finished adding are
+///         waited for.
 ///     bool try_dequeue_for(T&, duration&);
 ///     folly::Optional<T> try_dequeue_for(duration&);
 ///         Tries to extract an element from the front of the queue if
@@ -187,6 +199,8 @@ namespace folly {
 /// - MP adds a fetch_add to the critical path of each producer operation.
 /// - MC adds a fetch_add or compare_exchange to the critical path of
 ///   each consumer operation.
+/// - enqueue_batch and try_dequeue_batch pay for these only once per
+///   batch.
 /// - The possibility of consumers blocking, even if they never do,
 ///   adds a compare_exchange to the critical path of each producer
 ///   operation.
@@ -271,6 +285,23 @@ class UnboundedQueue {
     enqueueImpl(std::move(arg));
   }
 
+  /** enqueue_batch */
+  template <typename Iter>
+  void enqueue_batch(Iter first, Iter last) {
+    auto n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) {
+      return;
+    }
+    if (SPSC) {
+      Segment* s = tail();
+      enqueueBatchCommon(s, first, n);
+    } else {
+      hazptr_holder<Atom> hptr;
+      Segment* s = hptr.get_protected(p_.tail);
+      enqueueBatchCommon(s, first, n);
+    }
+  }
+
   /** dequeue */
   FOLLY_ALWAYS_INLINE void dequeue(T& item) noexcept {
     item = dequeueImpl();
@@ -294,6 +325,18 @@ class UnboundedQueue {
     return tryDequeueUntil(std::chrono::steady_clock::time_point::min());
   }
 
+  /** try_dequeue_batch */
+  size_t try_dequeue_batch(T* items, size_t max) noexcept {
+    if (SingleConsumer) {
+      Segment* s = head();
+      return tryDequeueBatchCommon(s, items, max);
+    } else {
+      hazptr_holder<Atom> hptr;
+      Segment* s = hptr.get_protected(c_.head);
+      return tryDequeueBatchCommon(s, items, max);
+    }
+  }
+
   /** try_dequeue_until */
   template <typename Clock, typename Duration>
   FOLLY_ALWAYS_INLINE bool try_dequeue_until(
@@ -397,6 +440,70 @@ class UnboundedQueue {
     }
   }
 
+  /** enqueueBatchCommon */
+  template <typename Iter>
+  void enqueueBatchCommon(Segment* s, Iter first, size_t n) {
+    Ticket t = fetchAddProducerTicket(n);
+    for (Ticket end = t + n; t != end; ++t, ++first) {
+      if (!SingleProducer) {
+        s = findSegment(s, t);
+      }
+      DCHECK_GE(t, s->minTicket());
+      DCHECK_LT(t, s->minTicket() + SegmentSize);
+      Entry& e = s->entry(index(t));
+      e.putItem(*first);
+      if (responsibleForAlloc(t)) {
+        allocNextSegment(s);
+      }
+      if (responsibleForAdvance(t)) {
+        // Read next first, as s may be reclaimed once tail moves on.
+        Segment* next = SingleProducer ? s->nextSegment() : s;
+        DCHECK(next);
+        advanceTail(s);
+        s = next;
+      }
+    }
+  }
+
+  /** tryDequeueBatchCommon */
+  size_t tryDequeueBatchCommon(Segment* s, T* items, size_t max) noexcept {
+    // Only tickets already taken by producers are claimed, so that
+    // their elements are at most being constructed.
+    Ticket t = consumerTicket();
+    size_t n;
+    while (true) {
+      Ticket p = producerTicket();
+      n = p > t ? std::min(size_t(p - t), max) : 0;
+      if (n == 0) {
+        return 0;
+      }
+      if (SingleConsumer) {
+        setConsumerTicket(t + n);
+        break;
+      }
+      if (c_.ticket.compare_exchange_weak(
+              t, t + n, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        break;
+      }
+    }
+    for (Ticket end = t + n; t != end; ++t) {
+      if (!SingleConsumer) {
+        s = findSegment(s, t);
+      }
+      DCHECK_GE(t, s->minTicket());
+      DCHECK_LT(t, s->minTicket() + SegmentSize);
+      Entry& e = s->entry(index(t));
+      *items++ = e.takeItem();
+      if (responsibleForAdvance(t)) {
+        advanceHead(s);
+        if (SingleConsumer) {
+          s = head();
+        }
+      }
+    }
+    return n;
+  }
+
   /** dequeueImpl */
   FOLLY_ALWAYS_INLINE T dequeueImpl() noexcept {
     if (SPSC) {
@@ -751,6 +858,16 @@ class UnboundedQueue {
     }
   }
 
+  FOLLY_ALWAYS_INLINE Ticket fetchAddProducerTicket(Ticket n) noexcept {
+    if (SingleProducer) {
+      Ticket oldval = producerTicket();
+      setProducerTicket(oldval + n);
+      return oldval;
+    } else { // MP
+      return p_.ticket.fetch_add(n, std::memory_order_acq_rel);
+    }
+  }
+
   /**
    *  Entry
    */
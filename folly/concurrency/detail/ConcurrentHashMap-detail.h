@@ -16,15 +16,40 @@
 
 #pragma once
 
+#include <folly/ScopeGuard.h>
+#include <folly/container/detail/F14IntrinsicsAvailability.h>
 #include <folly/container/detail/F14Mask.h>
 #include <folly/lang/Launder.h>
 #include <folly/synchronization/Hazptr.h>
 #include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <vector>
+
+// SIMDTable uses the F14 chunk layout, and is available wherever F14 is
+// vectorized on a 64-bit platform.
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE && (FOLLY_X64 || FOLLY_AARCH64)
+#define FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE 1
+#else
+#define FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE 0
+#endif
 
-#if FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
-#include <nmmintrin.h>
+#if FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE
+#if FOLLY_F14_CRC_INTRINSIC_AVAILABLE
+#if FOLLY_NEON
+#include <arm_acle.h> // __crc32cd
+#else
+#include <nmmintrin.h> // _mm_crc32_u64
+#endif
+#elif defined(_WIN32)
+#include <intrin.h> // _mul128 in fallback bit mixer
+#endif
+
+#if FOLLY_NEON
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
 #endif
 
 namespace folly {
@@ -42,6 +67,17 @@ enum class InsertType {
          // value.
 };
 
+// Only a hint, so prefetching memory which has been freed in the meantime
+// is harmless.
+template <typename T>
+FOLLY_ALWAYS_INLINE void prefetchAddr(T const* ptr) {
+#ifndef _WIN32
+  __builtin_prefetch(static_cast<void const*>(ptr));
+#else
+  (void)ptr;
+#endif
+}
+
 template <
     typename KeyType,
     typename ValueType,
@@ -259,8 +295,10 @@ class alignas(64) BucketTable {
       MatchFunc match,
       hazptr_obj_batch<Atom>* batch,
       Args&&... args) {
+    auto h = HashFn()(k);
+    std::unique_lock<Mutex> g(m_);
     return doInsert(
-        it, k, type, match, nullptr, batch, std::forward<Args>(args)...);
+        g, h, it, k, type, match, nullptr, batch, std::forward<Args>(args)...);
   }
 
   template <typename MatchFunc, typename... Args>
@@ -271,7 +309,38 @@ class alignas(64) BucketTable {
       MatchFunc match,
       Node* cur,
       hazptr_obj_batch<Atom>* batch) {
-    return doInsert(it, k, type, match, cur, batch, cur);
+    auto h = HashFn()(k);
+    std::unique_lock<Mutex> g(m_);
+    return doInsert(g, h, it, k, type, match, cur, batch, cur);
+  }
+
+  // Inserts the nodes whose keys don't exist yet, locking only once, and
+  // sets them to nullptr in nodes.  The caller owns the other nodes.
+  size_t insertNodes(
+      Iterator& it,
+      Node** nodes,
+      const size_t* hashes,
+      size_t count,
+      hazptr_obj_batch<Atom>* batch) {
+    size_t inserted = 0;
+    std::unique_lock<Mutex> g(m_);
+    for (size_t i = 0; i < count; ++i) {
+      auto node = nodes[i];
+      if (doInsert(
+              g,
+              hashes[i],
+              it,
+              node->getItem().first,
+              InsertType::DOES_NOT_EXIST,
+              [](const ValueType&) { return false; },
+              node,
+              batch,
+              node)) {
+        nodes[i] = nullptr;
+        ++inserted;
+      }
+    }
+    return inserted;
   }
 
   // Must hold lock.
@@ -331,10 +400,20 @@ class alignas(64) BucketTable {
     oldbuckets->retire(concurrenthashmap::HazptrTableDeleter(oldcount));
   }
 
+  // Prefetches the bucket of a key with hash h, without protecting it.
+  void prefetch(size_t h) {
+    auto bcount = bucket_count_.load(std::memory_order_relaxed);
+    auto buckets = buckets_.load(std::memory_order_relaxed);
+    concurrenthashmap::prefetchAddr(&buckets->buckets_[getIdx(bcount, h)]);
+  }
+
   bool find(Iterator& res, const KeyType& k) {
+    return find(res, k, HashFn()(k));
+  }
+
+  bool find(Iterator& res, const KeyType& k, size_t h) {
     auto& hazcurr = res.hazptrs_[1];
     auto& haznext = res.hazptrs_[2];
-    auto h = HashFn()(k);
     size_t bcount;
     Buckets* buckets;
     getBucketsAndCount(bcount, buckets, res.hazptrs_[0]);
@@ -607,8 +686,11 @@ class alignas(64) BucketTable {
     DCHECK(buckets);
   }
 
+  // Must hold lock g, which is released early when replacing a node.
   template <typename MatchFunc, typename... Args>
   bool doInsert(
+      std::unique_lock<Mutex>& g,
+      size_t h,
       Iterator& it,
       const KeyType& k,
       InsertType type,
@@ -616,8 +698,6 @@ class alignas(64) BucketTable {
       Node* cur,
       hazptr_obj_batch<Atom>* batch,
       Args&&... args) {
-    auto h = HashFn()(k);
-    std::unique_lock<Mutex> g(m_);
 
     size_t bcount = bucket_count_.load(std::memory_order_relaxed);
     auto buckets = buckets_.load(std::memory_order_relaxed);
@@ -724,7 +804,7 @@ class alignas(64) BucketTable {
 
 } // namespace bucket
 
-#if FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
+#if FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE
 
 namespace simd {
 
@@ -858,6 +938,42 @@ class alignas(64) SIMDTable {
       setNodeAndTag(index, nullptr, 0);
     }
 
+#if FOLLY_NEON
+    ////////
+    // Tag filtering using NEON intrinsics, as in F14Chunk
+
+    SparseMaskIter tagMatchIter(std::size_t needle) const {
+      FOLLY_SAFE_DCHECK(needle >= 0x80 && needle < 0x100, "");
+      uint64_t low = tags_low_.load(std::memory_order_acquire);
+      uint64_t hi = tags_hi_.load(std::memory_order_acquire);
+      auto tagV = vreinterpretq_u8_u64(
+          vcombine_u64(vcreate_u64(low), vcreate_u64(hi)));
+      auto needleV = vdupq_n_u8(static_cast<uint8_t>(needle));
+      auto eqV = vceqq_u8(tagV, needleV);
+      uint8x8_t maskV = vshrn_n_u16(vreinterpretq_u16_u8(eqV), 4);
+      uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
+      return SparseMaskIter(mask);
+    }
+
+    MaskType occupiedMask() const {
+      uint64_t low = tags_low_.load(std::memory_order_relaxed);
+      uint64_t hi = tags_hi_.load(std::memory_order_relaxed);
+      auto tagV = vreinterpretq_u8_u64(
+          vcombine_u64(vcreate_u64(low), vcreate_u64(hi)));
+      // signed shift extends top bit to all bits
+      auto occupiedV =
+          vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(tagV), 7));
+      uint8x8_t maskV = vshrn_n_u16(vreinterpretq_u16_u8(occupiedV), 4);
+      return vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
+    }
+
+    // The NEON DenseMaskIter reads plain tags, which the atomic tags of
+    // this chunk aren't.
+    SparseMaskIter occupiedIter() const {
+      // Currently only invoked when relaxed semantics are sufficient.
+      return SparseMaskIter{occupiedMask()};
+    }
+#else
     ////////
     // Tag filtering using SSE2 intrinsics
 
@@ -883,6 +999,7 @@ class alignas(64) SIMDTable {
       // Currently only invoked when relaxed semantics are sufficient.
       return DenseMaskIter{nullptr /*unused*/, occupiedMask()};
     }
+#endif
 
     FirstEmptyInMask firstEmpty() const {
       return FirstEmptyInMask{occupiedMask() ^ kFullMask};
@@ -1250,14 +1367,69 @@ class alignas(64) SIMDTable {
     return true;
   }
 
+  // Inserts the nodes whose keys don't exist yet, locking only once, and
+  // sets them to nullptr in nodes.  The caller owns the other nodes.
+  size_t insertNodes(
+      Iterator& it,
+      Node** nodes,
+      const size_t* hashes,
+      size_t count,
+      hazptr_obj_batch<Atom>* batch) {
+    size_t inserted = 0;
+    std::lock_guard<Mutex> g(m_);
+    for (size_t i = 0; i < count; ++i) {
+      auto cur = nodes[i];
+      Node* node;
+      Chunks* chunks;
+      size_t ccount, chunk_idx, tag_idx;
+      auto hp = splitHash(hashes[i]);
+      if (!prepare_insert(
+              it,
+              cur->getItem().first,
+              InsertType::DOES_NOT_EXIST,
+              [](const ValueType&) { return false; },
+              batch,
+              chunk_idx,
+              tag_idx,
+              node,
+              chunks,
+              ccount,
+              hp)) {
+        continue;
+      }
+      DCHECK(!node);
+      std::tie(chunk_idx, tag_idx) =
+          findEmptyInsertLocation(chunks, ccount, hp);
+      it.setNode(cur, chunks, ccount, chunk_idx, tag_idx);
+      size_++;
+      Chunk* chunk = chunks->getChunk(chunk_idx, ccount);
+      chunk->setNodeAndTag(tag_idx, cur, hp.second);
+      nodes[i] = nullptr;
+      ++inserted;
+    }
+    return inserted;
+  }
+
   void rehash(size_t size, hazptr_obj_batch<Atom>* batch) {
     size_t new_chunk_count = size == 0 ? 0 : (size - 1) / Chunk::kCapacity + 1;
     rehash_internal(folly::nextPowTwo(new_chunk_count), batch);
   }
 
+  // Prefetches the first chunk probed for a key with hash h, without
+  // protecting it.
+  void prefetch(size_t h) {
+    auto ccount = chunk_count_.load(std::memory_order_relaxed);
+    auto chunks = chunks_.load(std::memory_order_relaxed);
+    concurrenthashmap::prefetchAddr(
+        chunks->getChunk(splitHash(h).first, ccount));
+  }
+
   bool find(Iterator& res, const KeyType& k) {
+    return find(res, k, HashFn()(k));
+  }
+
+  bool find(Iterator& res, const KeyType& k, size_t h) {
     auto& hazz = res.hazptrs_[1];
-    auto h = HashFn()(k);
     auto hp = splitHash(h);
     size_t ccount;
     Chunks* chunks;
@@ -1384,9 +1556,34 @@ class alignas(64) SIMDTable {
 
  private:
   static HashPair splitHash(std::size_t hash) {
+    static_assert(sizeof(std::size_t) == sizeof(uint64_t), "");
+#if FOLLY_F14_CRC_INTRINSIC_AVAILABLE
+#if FOLLY_SSE_PREREQ(4, 2)
     std::size_t c = _mm_crc32_u64(0, hash);
+#else
+    std::size_t c = __crc32cd(0, hash);
+#endif
     size_t tag = (c >> 24) | 0x80;
     hash += c;
+#else
+    // The bit mixer of F14Table's splitHash, without CRC intrinsics
+    auto const kMul = 0xc4ceb9fe1a85ec53ULL;
+#ifdef _WIN32
+    __int64 signedHi;
+    __int64 signedLo = _mul128(
+        static_cast<__int64>(hash), static_cast<__int64>(kMul), &signedHi);
+    auto hi = static_cast<uint64_t>(signedHi);
+    auto lo = static_cast<uint64_t>(signedLo);
+#else
+    auto hi = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(hash) * kMul) >> 64);
+    auto lo = hash * kMul;
+#endif
+    hash = hi ^ lo;
+    hash *= kMul;
+    size_t tag = ((hash >> 15) & 0x7f) | 0x80;
+    hash >>= 22;
+#endif
     return std::make_pair(hash, tag);
   }
 
@@ -1569,7 +1766,7 @@ class alignas(64) SIMDTable {
 };
 } // namespace simd
 
-#endif // FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
+#endif // FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE
 
 } // namespace concurrenthashmap
 
@@ -1784,6 +1981,45 @@ class alignas(64) ConcurrentHashMapSegment {
     return impl_.find(res, k);
   }
 
+  bool find(Iterator& res, const KeyType& k, size_t hash) {
+    return impl_.find(res, k, hash);
+  }
+
+  void prefetch(size_t hash) {
+    impl_.prefetch(hash);
+  }
+
+  // Constructs nodes from items and inserts those whose key doesn't exist
+  // yet under a single lock, returning how many were inserted.
+  template <typename Item>
+  size_t bulk_insert(
+      Iterator& it,
+      Item* const* items,
+      const size_t* hashes,
+      size_t count) {
+    std::vector<Node*> nodes;
+    nodes.reserve(count);
+    SCOPE_EXIT {
+      for (auto node : nodes) {
+        if (node) {
+          node->~Node();
+          Allocator().deallocate((uint8_t*)node, sizeof(Node));
+        }
+      }
+    };
+    for (size_t i = 0; i < count; ++i) {
+      auto node = (Node*)Allocator().allocate(sizeof(Node));
+      try {
+        new (node) Node(batch_, items[i]->first, items[i]->second);
+      } catch (...) {
+        Allocator().deallocate((uint8_t*)node, sizeof(Node));
+        throw;
+      }
+      nodes.push_back(node);
+    }
+    return impl_.insertNodes(it, nodes.data(), hashes, count, batch_);
+  }
+
   // Listed separately because we need a prev pointer.
   size_type erase(const key_type& key) {
     return erase_internal(key, nullptr, [](const ValueType&) { return true; });
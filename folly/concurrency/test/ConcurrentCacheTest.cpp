@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/ConcurrentCache.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using folly::ConcurrentCache;
+
+namespace {
+
+ConcurrentCache<int, int>::Options singleShard(bool admission = false) {
+  ConcurrentCache<int, int>::Options options;
+  options.numShards = 1;
+  options.admission = admission;
+  return options;
+}
+
+} // namespace
+
+TEST(ConcurrentCache, Basic) {
+  ConcurrentCache<int, int> cache(100);
+  EXPECT_EQ(112, cache.capacity());
+  EXPECT_FALSE(cache.get(1));
+  EXPECT_TRUE(cache.set(1, 10));
+  EXPECT_EQ(10, *cache.get(1));
+  EXPECT_TRUE(cache.set(1, 11));
+  EXPECT_EQ(11, *cache.get(1));
+  EXPECT_TRUE(cache.exists(1));
+  EXPECT_EQ(1, cache.size());
+
+  EXPECT_TRUE(cache.erase(1));
+  EXPECT_FALSE(cache.erase(1));
+  EXPECT_FALSE(cache.exists(1));
+  EXPECT_EQ(0, cache.size());
+
+  cache.set(2, 20);
+  cache.set(3, 30);
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_FALSE(cache.get(2));
+
+  auto stats = cache.stats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(0.5, stats.hitRate());
+}
+
+TEST(ConcurrentCache, SecondChance) {
+  ConcurrentCache<int, int> cache(3, singleShard());
+  cache.set(1, 1);
+  cache.set(2, 2);
+  cache.set(3, 3);
+  cache.get(1);
+  cache.get(3);
+  cache.set(4, 4);
+  EXPECT_TRUE(cache.exists(1));
+  EXPECT_FALSE(cache.exists(2));
+  EXPECT_TRUE(cache.exists(3));
+  EXPECT_TRUE(cache.exists(4));
+  EXPECT_EQ(1, cache.stats().evictions);
+
+  // 1 lost its reference bit to the previous sweep, 3 to this one
+  cache.set(5, 5);
+  EXPECT_FALSE(cache.exists(1));
+  EXPECT_TRUE(cache.exists(3));
+  EXPECT_EQ(3, cache.size());
+}
+
+TEST(ConcurrentCache, ErasedSlotsAreReused) {
+  ConcurrentCache<int, int> cache(2, singleShard());
+  cache.set(1, 1);
+  cache.set(2, 2);
+  cache.erase(1);
+  cache.set(3, 3);
+  EXPECT_TRUE(cache.exists(2));
+  EXPECT_TRUE(cache.exists(3));
+  EXPECT_EQ(0, cache.stats().evictions);
+
+  // before the shard is full too
+  cache.clear();
+  cache.set(1, 1);
+  cache.erase(1);
+  cache.set(1, 1);
+  cache.set(2, 2);
+  EXPECT_TRUE(cache.exists(1));
+  EXPECT_TRUE(cache.exists(2));
+  EXPECT_EQ(0, cache.stats().evictions);
+}
+
+TEST(ConcurrentCache, Admission) {
+  ConcurrentCache<int, int> cache(2, singleShard(true));
+  cache.set(1, 1);
+  cache.set(2, 2);
+  cache.get(1);
+  cache.get(2);
+  // requested less often than the entry it would replace
+  EXPECT_FALSE(cache.set(3, 3));
+  EXPECT_FALSE(cache.exists(3));
+  EXPECT_EQ(1, cache.stats().rejections);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FALSE(cache.get(3));
+  }
+  EXPECT_TRUE(cache.set(3, 3));
+  EXPECT_TRUE(cache.exists(3));
+  EXPECT_EQ(1, cache.stats().evictions);
+}
+
+TEST(ConcurrentCache, Concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int kKeys = 4000;
+  constexpr int kOps = 50000;
+  ConcurrentCache<int, int> cache(1000);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      // skewed towards small keys
+      std::geometric_distribution<int> dist(0.002);
+      for (int i = 0; i < kOps; ++i) {
+        auto key = dist(rng) % kKeys;
+        auto value = cache.get(key);
+        if (value) {
+          EXPECT_EQ(key * 2, *value);
+        } else {
+          cache.set(key, key * 2);
+        }
+        if (i % 100 == 0) {
+          cache.erase(key);
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_LE(cache.size(), cache.capacity());
+  auto stats = cache.stats();
+  EXPECT_EQ(kThreads * kOps, stats.hits + stats.misses);
+  EXPECT_GT(stats.hits, 0);
+  EXPECT_GT(stats.evictions, 0);
+}
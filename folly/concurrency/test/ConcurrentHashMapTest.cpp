@@ -328,6 +328,55 @@ TYPED_TEST_P(ConcurrentHashMapTest, EraseIfEqualTest) {
   EXPECT_EQ(foomap.find(1), foomap.cend());
 }
 
+TYPED_TEST_P(ConcurrentHashMapTest, MultiFindTest) {
+  CHM<uint64_t, uint64_t> foomap(3);
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    foomap.insert(i, i * 10);
+  }
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    keys.push_back(i);
+  }
+  size_t calls = 0;
+  auto found = foomap.multi_find(
+      keys.begin(),
+      keys.end(),
+      [&](uint64_t key, const std::pair<const uint64_t, uint64_t>* item) {
+        EXPECT_EQ(keys[calls++], key);
+        if (key % 2 == 0) {
+          ASSERT_NE(nullptr, item);
+          EXPECT_EQ(key, item->first);
+          EXPECT_EQ(key * 10, item->second);
+        } else {
+          EXPECT_EQ(nullptr, item);
+        }
+      });
+  EXPECT_EQ(500, found);
+  EXPECT_EQ(1000, calls);
+
+  CHM<uint64_t, uint64_t> empty;
+  EXPECT_EQ(0, empty.multi_find(keys.begin(), keys.end(), [](auto, auto item) {
+    EXPECT_EQ(nullptr, item);
+  }));
+}
+
+TYPED_TEST_P(ConcurrentHashMapTest, BulkInsertTest) {
+  CHM<uint64_t, uint64_t> foomap(2);
+  foomap.insert(5, 0);
+  std::vector<std::pair<uint64_t, uint64_t>> items;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    items.emplace_back(i, i + 1);
+  }
+  // repeated keys keep their first value
+  items.emplace_back(7, 0);
+  EXPECT_EQ(999, foomap.bulk_insert(items.begin(), items.end()));
+  EXPECT_EQ(1000, foomap.size());
+  for (uint64_t i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i == 5 ? 0 : i + 1, foomap.find(i)->second);
+  }
+  EXPECT_EQ(0, foomap.bulk_insert(items.begin(), items.end()));
+}
+
 TYPED_TEST_P(ConcurrentHashMapTest, CopyIterator) {
   CHM<int, int> map;
   map.insert(0, 0);
@@ -842,6 +891,8 @@ REGISTER_TYPED_TEST_CASE_P(
     MoveIterateAssignIterate,
     MapInsertIteratorValueTest,
     CopyIterator,
+    MultiFindTest,
+    BulkInsertTest,
     Deletion,
     DeletionAssigned,
     DeletionMultiple,
@@ -864,7 +915,7 @@ REGISTER_TYPED_TEST_CASE_P(
 
 using folly::detail::concurrenthashmap::bucket::BucketTable;
 
-#if FOLLY_SSE_PREREQ(4, 2) && !FOLLY_MOBILE
+#if FOLLY_CONCURRENT_HASH_MAP_SIMD_AVAILABLE
 using folly::detail::concurrenthashmap::simd::SIMDTable;
 typedef ::testing::Types<MapFactory<BucketTable>, MapFactory<SIMDTable>>
     MapFactoryTypes;
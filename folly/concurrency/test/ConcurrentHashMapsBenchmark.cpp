@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Lookups from several threads in the maps that support concurrent
+ * readers, over thread counts and hit rates, with the helpers of
+ * folly/container/test/HashMapBenchmarkUtil.h.  Times are per lookup,
+ * summed over all threads, so perfect scaling shows as a time per lookup
+ * that falls in proportion to the number of threads.
+ */
+
+#include <folly/container/test/HashMapBenchmarkUtil.h>
+
+#include <folly/AtomicHashMap.h>
+#include <folly/AtomicUnorderedMap.h>
+#include <folly/Format.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GFlags.h>
+
+using namespace folly;
+using namespace folly::test;
+
+namespace {
+
+constexpr size_t kSize = 1000000;
+constexpr double kLoadFactor = 0.85;
+constexpr size_t kThreads[] = {1, 2, 4, 8, 16};
+constexpr double kHitRates[] = {1.0, 0.5};
+
+template <class Make, class Insert, class Find>
+void addMap(char const* mapName, Make make, Insert insert, Find find) {
+  for (auto hitRate : kHitRates) {
+    for (auto threads : kThreads) {
+      addHashMapLookupBenchmark<uint64_t, uint64_t>(
+          __FILE__,
+          sformat(
+              "find/{}/hit={}%/threads={}",
+              mapName,
+              int(hitRate * 100),
+              threads),
+          kSize,
+          hitRate,
+          threads,
+          make,
+          insert,
+          find);
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  using Alloc = CountingAllocator<std::pair<uint64_t const, uint64_t>>;
+  using F14 = F14FastMap<
+      uint64_t,
+      uint64_t,
+      f14::DefaultHasher<uint64_t>,
+      f14::DefaultKeyEqual<uint64_t>,
+      Alloc>;
+  addMap(
+      "F14FastMap+SharedMutex",
+      [](size_t n) {
+        auto map = std::make_unique<Synchronized<F14, SharedMutex>>();
+        map->wlock()->reserve(size_t(n / kLoadFactor));
+        return map;
+      },
+      [](auto& map, uint64_t key, uint64_t value) {
+        map.wlock()->emplace(key, value);
+      },
+      [](auto const& map, uint64_t key) { return map.rlock()->count(key); });
+
+  addMap(
+      "ConcurrentHashMap",
+      [](size_t n) {
+        using Map = ConcurrentHashMap<
+            uint64_t,
+            uint64_t,
+            std::hash<uint64_t>,
+            std::equal_to<uint64_t>,
+            CountingAllocator<uint8_t>>;
+        return std::make_unique<Map>(size_t(n / kLoadFactor));
+      },
+      [](auto& map, uint64_t key, uint64_t value) { map.emplace(key, value); },
+      [](auto const& map, uint64_t key) {
+        return map.find(key) != map.cend();
+      });
+
+  addMap(
+      "AtomicHashMap",
+      [](size_t n) {
+        using Map = AtomicHashMap<
+            uint64_t,
+            uint64_t,
+            std::hash<uint64_t>,
+            std::equal_to<uint64_t>,
+            CountingAllocator<char>>;
+        typename Map::Config config;
+        config.maxLoadFactor = kLoadFactor;
+        return std::make_unique<Map>(n, config);
+      },
+      [](auto& map, uint64_t key, uint64_t value) { map.insert(key, value); },
+      [](auto const& map, uint64_t key) {
+        return map.find(key) != map.end();
+      });
+
+  addMap(
+      "AtomicUnorderedInsertMap",
+      [](size_t n) {
+        using Map = AtomicUnorderedInsertMap<
+            uint64_t,
+            uint64_t,
+            std::hash<uint64_t>,
+            std::equal_to<uint64_t>,
+            true,
+            std::atomic,
+            uint32_t,
+            CountingAllocator<char>>;
+        return std::make_unique<Map>(n, float(kLoadFactor));
+      },
+      [](auto& map, uint64_t key, uint64_t value) { map.emplace(key, value); },
+      [](auto const& map, uint64_t key) {
+        return map.find(key) != map.cend();
+      });
+
+  addMap(
+      "SingleWriterFixedHashMap",
+      [](size_t n) {
+        return std::make_unique<CountedSingleWriterFixedHashMap>(
+            size_t(n / kLoadFactor));
+      },
+      [](auto& map, uint64_t key, uint64_t value) { map.insert(key, value); },
+      [](auto const& map, uint64_t key) {
+        return map.find(key) != map.end();
+      });
+
+  folly::runBenchmarks();
+  return 0;
+}
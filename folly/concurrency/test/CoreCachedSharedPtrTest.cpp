@@ -52,6 +52,54 @@ TEST(CoreCachedSharedPtr, Basic) {
   ASSERT_TRUE(wp2.expired());
 }
 
+TEST(CoreCachedSharedPtr, AtomicUpdates) {
+  auto p1 = std::make_shared<int>(1);
+  auto p2 = std::make_shared<int>(2);
+  std::weak_ptr<int> wp1(p1);
+
+  folly::AtomicCoreCachedSharedPtr<int> cached(p1);
+  ASSERT_EQ(*cached.get(), 1);
+  ASSERT_EQ(cached.withPtr([](int* p) { return *p; }), 1);
+
+  auto expected = p2;
+  ASSERT_FALSE(cached.compare_exchange(expected, p2));
+  ASSERT_EQ(expected, p1);
+  ASSERT_TRUE(cached.compare_exchange(expected, p2));
+  ASSERT_EQ(*cached.get(), 2);
+
+  auto old = cached.exchange(nullptr);
+  ASSERT_EQ(old, p2);
+  ASSERT_EQ(cached.get(), nullptr);
+  ASSERT_TRUE(cached.withPtr([](int* p) { return p == nullptr; }));
+
+  p1.reset();
+  expected.reset();
+  folly::hazptr_cleanup();
+  ASSERT_TRUE(wp1.expired());
+}
+
+TEST(CoreCachedSharedPtr, AtomicConcurrentIncrements) {
+  folly::AtomicCoreCachedSharedPtr<int> cached(std::make_shared<int>(0));
+  constexpr int kThreads = 4;
+  constexpr int kIncrements = 100;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIncrements; ++i) {
+        auto expected = cached.get();
+        while (!cached.compare_exchange(
+            expected, std::make_shared<int>(*expected + 1))) {
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(*cached.get(), kThreads * kIncrements);
+}
+
 namespace {
 
 template <class Operation>
@@ -108,6 +156,16 @@ void benchmarkAtomicCoreCachedSharedPtrGet(size_t numThreads, size_t iters) {
   parallelRun([&] { return p.get(); }, numThreads, iters);
 }
 
+void benchmarkAtomicCoreCachedSharedPtrWithPtr(
+    size_t numThreads,
+    size_t iters) {
+  folly::AtomicCoreCachedSharedPtr<int> p(std::make_shared<int>(1));
+  parallelRun(
+      [&] { return p.withPtr([](int* v) { return *v; }); },
+      numThreads,
+      iters);
+}
+
 } // namespace
 
 BENCHMARK(SharedPtrSingleThread, n) {
@@ -128,6 +186,9 @@ BENCHMARK(CoreCachedWeakPtrSingleThread, n) {
 BENCHMARK(AtomicCoreCachedSharedPtrSingleThread, n) {
   benchmarkAtomicCoreCachedSharedPtrGet(1, n);
 }
+BENCHMARK(AtomicCoreCachedSharedPtrWithPtrSingleThread, n) {
+  benchmarkAtomicCoreCachedSharedPtrWithPtr(1, n);
+}
 
 BENCHMARK_DRAW_LINE();
 
@@ -170,6 +231,9 @@ BENCHMARK(CoreCachedWeakPtr16Threads, n) {
 BENCHMARK(AtomicCoreCachedSharedPtr16Threads, n) {
   benchmarkAtomicCoreCachedSharedPtrGet(16, n);
 }
+BENCHMARK(AtomicCoreCachedSharedPtrWithPtr16Threads, n) {
+  benchmarkAtomicCoreCachedSharedPtrWithPtr(16, n);
+}
 
 BENCHMARK_DRAW_LINE();
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/CoreShardedCounter.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+TEST(CoreShardedCounter, Basic) {
+  CoreShardedCounter<int64_t> counter(10);
+  EXPECT_EQ(10, counter.readFull());
+  counter += 5;
+  ++counter;
+  counter -= 2;
+  --counter;
+  EXPECT_EQ(13, counter.readFull());
+  EXPECT_EQ(13, counter.readFullAndReset());
+  EXPECT_EQ(0, counter.readFull());
+  counter.set(42);
+  EXPECT_EQ(42, counter.readFull());
+}
+
+TEST(CoreShardedCounter, Double) {
+  CoreShardedCounter<double> sum;
+  sum += 1.5;
+  sum += 2.25;
+  EXPECT_EQ(3.75, sum.readFull());
+}
+
+TEST(CoreShardedCounter, Concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int kIncrements = 100000;
+  CoreShardedCounter<uint64_t> counter;
+  std::atomic<bool> done{false};
+  uint64_t drained = 0;
+  // Reads and resets while the writers run, without losing increments.
+  std::thread reader([&] {
+    while (!done.load()) {
+      drained += counter.readFullAndReset();
+    }
+  });
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; ++t) {
+    writers.emplace_back([&] {
+      for (int i = 0; i < kIncrements; ++i) {
+        ++counter;
+      }
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  done = true;
+  reader.join();
+  EXPECT_EQ(uint64_t(kThreads) * kIncrements, drained + counter.readFull());
+}
+
+TEST(CoreShardedCounter, ManyCounters) {
+  // Shards are small, so many counters can coexist.
+  std::vector<std::unique_ptr<CoreShardedCounter<int64_t, 16>>> counters;
+  for (int i = 0; i < 1000; ++i) {
+    counters.push_back(std::make_unique<CoreShardedCounter<int64_t, 16>>(i));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i, counters[i]->readFull());
+  }
+}
+
+TEST(CoreShardedGauge, MaxMin) {
+  CoreShardedMax<int> max;
+  CoreShardedMin<int> min;
+  EXPECT_EQ(std::numeric_limits<int>::lowest(), max.read());
+  EXPECT_EQ(std::numeric_limits<int>::max(), min.read());
+  for (int v : {3, -7, 12, 5}) {
+    max.update(v);
+    min.update(v);
+  }
+  EXPECT_EQ(12, max.read());
+  EXPECT_EQ(-7, min.read());
+  EXPECT_EQ(12, max.readAndReset());
+  EXPECT_EQ(std::numeric_limits<int>::lowest(), max.read());
+
+  CoreShardedMax<double> watermark(0.0);
+  EXPECT_EQ(0.0, watermark.read());
+  watermark.update(-1.0);
+  EXPECT_EQ(0.0, watermark.read());
+}
+
+TEST(CoreShardedGauge, Concurrent) {
+  constexpr int kThreads = 8;
+  CoreShardedMax<int> max;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 10000; ++i) {
+        max.update(i * kThreads + t);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(10000 * kThreads - 1, max.read());
+}
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
 
 DEFINE_bool(bench, false, "run benchmark");
 DEFINE_int32(reps, 10, "number of reps");
@@ -139,6 +140,43 @@ TEST(DynamicBoundedQueue, move) {
   move_test<DMPMC, true>();
 }
 
+template <template <typename, bool, typename> class Q, bool MayBlock>
+void batch_test() {
+  struct CustomWeightFn {
+    uint64_t operator()(int val) {
+      return val;
+    }
+  };
+
+  Q<int, MayBlock, CustomWeightFn> q(1000);
+  int v[10];
+  ASSERT_EQ(q.try_dequeue_batch(v, 10), 0);
+  std::vector<int> batch = {100, 200, 300};
+  q.enqueue_batch(batch.begin(), batch.end());
+  ASSERT_EQ(q.size(), 3);
+  ASSERT_EQ(q.weight(), 600);
+  ASSERT_FALSE(q.try_enqueue(600));
+  ASSERT_EQ(q.try_dequeue_batch(v, 2), 2);
+  ASSERT_EQ(v[0], 100);
+  ASSERT_EQ(v[1], 200);
+  ASSERT_EQ(q.weight(), 300);
+  ASSERT_EQ(q.try_dequeue_batch(v, 10), 1);
+  ASSERT_EQ(v[0], 300);
+  ASSERT_EQ(q.weight(), 0);
+  ASSERT_TRUE(q.empty());
+}
+
+TEST(DynamicBoundedQueue, batch) {
+  batch_test<DSPSC, false>();
+  batch_test<DMPSC, false>();
+  batch_test<DSPMC, false>();
+  batch_test<DMPMC, false>();
+  batch_test<DSPSC, true>();
+  batch_test<DMPSC, true>();
+  batch_test<DSPMC, true>();
+  batch_test<DMPMC, true>();
+}
+
 template <template <typename, bool, typename> class Q, bool MayBlock>
 void capacity_test() {
   struct CustomWeightFn {
@@ -71,3 +71,35 @@ TEST_F(PriorityUnboundedQueueSetTest, priority_order) {
   EXPECT_EQ(42, q.try_dequeue().value());
   EXPECT_EQ(0, q.size());
 }
+
+TEST_F(PriorityUnboundedQueueSetTest, enqueue) {
+  PriorityUMPMCQueueSet<int, false> q(100);
+  q.enqueue(70, 70);
+  q.enqueue(3, 3);
+  q.at_priority(99).enqueue(99);
+  q.enqueue(64, 64);
+  EXPECT_EQ(4, q.size());
+  EXPECT_EQ(3, q.try_dequeue().value());
+  EXPECT_EQ(64, q.try_dequeue().value());
+  EXPECT_EQ(70, q.try_dequeue().value());
+  // only found by the scan of all the queues
+  EXPECT_EQ(99, q.try_dequeue().value());
+  EXPECT_FALSE(q.try_dequeue().has_value());
+  EXPECT_TRUE(q.empty());
+}
+
+TEST_F(PriorityUnboundedQueueSetTest, aging) {
+  PriorityUSPSCQueueSet<int, false> q(3, /* agingInterval = */ 4);
+  for (int i = 0; i < 100; ++i) {
+    q.enqueue(0, 0);
+  }
+  q.enqueue(2, 2);
+  q.enqueue(1, 1);
+  // every 4th dequeue starts at the next priority in turn: 0, 1, 2
+  std::vector<int> order;
+  for (int i = 0; i < 12; ++i) {
+    order.push_back(q.try_dequeue().value());
+  }
+  EXPECT_EQ(
+      (std::vector<int>{0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 2}), order);
+}
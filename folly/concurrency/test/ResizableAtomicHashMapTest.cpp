@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/ResizableAtomicHashMap.h>
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using folly::ResizableAtomicHashMap;
+
+TEST(ResizableAtomicHashMap, Basic) {
+  ResizableAtomicHashMap<int64_t, int64_t> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.find(1));
+
+  auto res = map.insert(1, 10);
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(1, res.first.key());
+  EXPECT_EQ(10, res.first.value());
+  res = map.insert(1, 11);
+  EXPECT_FALSE(res.second);
+  EXPECT_EQ(10, res.first.value());
+  EXPECT_EQ(1, map.size());
+
+  auto acc = map.insert_or_assign(1, 12);
+  EXPECT_EQ(12, acc.value());
+  EXPECT_EQ(12, map.find(1).value());
+  // the replaced value is still readable through old accessors
+  EXPECT_EQ(10, res.first.value());
+  EXPECT_EQ(1, map.size());
+
+  EXPECT_EQ(1, map.erase(1));
+  EXPECT_EQ(0, map.erase(1));
+  EXPECT_FALSE(map.find(1));
+  EXPECT_EQ(12, acc.value());
+  EXPECT_TRUE(map.empty());
+
+  map.insert_or_assign(2, 20);
+  EXPECT_EQ(20, map.find(2).value());
+  EXPECT_TRUE(map.insert(1, 13).second);
+  EXPECT_EQ(2, map.size());
+}
+
+TEST(ResizableAtomicHashMap, Grow) {
+  constexpr int64_t kNum = 100000;
+  ResizableAtomicHashMap<int64_t, int64_t> map;
+  auto initialCapacity = map.capacity();
+  for (int64_t i = 0; i < kNum; ++i) {
+    EXPECT_TRUE(map.insert(i, i * 2).second);
+  }
+  EXPECT_EQ(kNum, map.size());
+  EXPECT_GT(map.capacity(), initialCapacity);
+  for (int64_t i = 0; i < kNum; ++i) {
+    auto acc = map.find(i);
+    ASSERT_TRUE(acc);
+    EXPECT_EQ(i * 2, acc.value());
+  }
+  EXPECT_FALSE(map.find(kNum));
+}
+
+TEST(ResizableAtomicHashMap, ReclaimErasedSlots) {
+  ResizableAtomicHashMap<int64_t, int64_t> map;
+  // A sliding window of 100 keys: erased slots are dropped by resizes
+  // instead of piling up.
+  for (int64_t i = 0; i < 100000; ++i) {
+    map.insert(i, i);
+    if (i >= 100) {
+      EXPECT_EQ(1, map.erase(i - 100));
+    }
+  }
+  EXPECT_EQ(100, map.size());
+  EXPECT_LE(map.capacity(), 512);
+  for (int64_t i = 100000 - 100; i < 100000; ++i) {
+    EXPECT_EQ(i, map.find(i).value());
+  }
+}
+
+TEST(ResizableAtomicHashMap, ValuesAreReclaimed) {
+  static std::atomic<int> alive{0};
+  struct Value {
+    Value() {
+      ++alive;
+    }
+    ~Value() {
+      --alive;
+    }
+  };
+  {
+    ResizableAtomicHashMap<int, Value> map;
+    for (int i = 0; i < 1000; ++i) {
+      map.insert(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      map.erase(i);
+    }
+    folly::hazptr_cleanup();
+    EXPECT_EQ(500, alive.load());
+  }
+  folly::hazptr_cleanup();
+  EXPECT_EQ(0, alive.load());
+}
+
+TEST(ResizableAtomicHashMap, CountersDuringResize) {
+  constexpr int kThreads = 4;
+  constexpr int kKeys = 64;
+  constexpr int kIncrements = 20000;
+  ResizableAtomicHashMap<int64_t, std::atomic<int64_t>> map;
+  std::atomic<bool> done{false};
+  // keeps the map resizing while the counters are updated
+  std::thread inserter([&] {
+    for (int64_t i = kKeys; !done.load(); ++i) {
+      map.insert(i, 0);
+      if (i >= kKeys + 1000) {
+        map.erase(i - 1000);
+      }
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < kIncrements; ++i) {
+        map.insert(i % kKeys, 0).first.value().fetch_add(1);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  done = true;
+  inserter.join();
+  int64_t total = 0;
+  for (int64_t k = 0; k < kKeys; ++k) {
+    total += map.find(k).value().load();
+  }
+  EXPECT_EQ(kThreads * kIncrements, total);
+}
+
+TEST(ResizableAtomicHashMap, Concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int64_t kKeysPerThread = 20000;
+  ResizableAtomicHashMap<int64_t, int64_t> map;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      auto base = t * kKeysPerThread;
+      for (int64_t i = base; i < base + kKeysPerThread; ++i) {
+        EXPECT_TRUE(map.insert(i, i).second);
+      }
+      for (int64_t i = base; i < base + kKeysPerThread; ++i) {
+        auto acc = map.find(i);
+        ASSERT_TRUE(acc);
+        EXPECT_EQ(i, acc.value());
+        if (i % 2) {
+          EXPECT_EQ(1, map.erase(i));
+        } else {
+          map.insert_or_assign(i, -i);
+        }
+      }
+      for (int64_t i = base; i < base + kKeysPerThread; ++i) {
+        auto acc = map.find(i);
+        if (i % 2) {
+          EXPECT_FALSE(acc);
+        } else {
+          ASSERT_TRUE(acc);
+          EXPECT_EQ(-i, acc.value());
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(kThreads * kKeysPerThread / 2, map.size());
+}
+
+TEST(ResizableAtomicHashMap, ForEachDuringResize) {
+  constexpr int64_t kNum = 10000;
+  ResizableAtomicHashMap<int64_t, int64_t> map;
+  for (int64_t i = 0; i < kNum; ++i) {
+    map.insert(i, i);
+  }
+  std::atomic<bool> done{false};
+  std::thread inserter([&] {
+    for (int64_t i = kNum; i < 20 * kNum; ++i) {
+      map.insert(i, i);
+    }
+    done = true;
+  });
+  do {
+    std::unordered_map<int64_t, int> visits;
+    map.forEach([&](int64_t key, int64_t value) {
+      EXPECT_EQ(key, value);
+      ++visits[key];
+    });
+    for (int64_t i = 0; i < kNum; ++i) {
+      EXPECT_EQ(1, visits[i]);
+    }
+  } while (!done.load());
+  inserter.join();
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/concurrency/SingleWriterF14Map.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+using folly::SingleWriterF14Map;
+
+TEST(SingleWriterF14Map, Basic) {
+  SingleWriterF14Map<std::string, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.find("a"));
+
+  EXPECT_TRUE(map.insert("a", "x"));
+  EXPECT_FALSE(map.insert("a", "y"));
+  auto acc = map.find("a");
+  ASSERT_TRUE(acc);
+  EXPECT_EQ("a", acc.key());
+  EXPECT_EQ("x", acc.value());
+  EXPECT_EQ(1, map.size());
+
+  map.insert_or_assign("a", "z");
+  EXPECT_EQ("z", map.find("a")->second);
+  // the replaced value is still readable through old accessors
+  EXPECT_EQ("x", acc.value());
+  EXPECT_EQ(1, map.size());
+
+  EXPECT_EQ(1, map.erase("a"));
+  EXPECT_EQ(0, map.erase("a"));
+  EXPECT_FALSE(map.contains("a"));
+  EXPECT_TRUE(map.empty());
+
+  map.insert_or_assign("b", "w");
+  EXPECT_EQ("w", map.find("b").value());
+  map.clear();
+  EXPECT_FALSE(map.contains("b"));
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(SingleWriterF14Map, Grow) {
+  SingleWriterF14Map<int, int> map;
+  for (int i = 0; i < 100000; ++i) {
+    EXPECT_TRUE(map.insert(i, i * 2));
+  }
+  EXPECT_EQ(100000, map.size());
+  for (int i = 0; i < 100000; ++i) {
+    auto acc = map.find(i);
+    ASSERT_TRUE(acc);
+    EXPECT_EQ(i * 2, acc.value());
+  }
+  for (int i = 0; i < 100000; i += 2) {
+    EXPECT_EQ(1, map.erase(i));
+  }
+  for (int i = 0; i < 100000; ++i) {
+    EXPECT_EQ(i % 2 == 1, map.contains(i));
+  }
+  size_t visited = 0;
+  map.forEach([&](int key, int value) {
+    EXPECT_EQ(1, key % 2);
+    EXPECT_EQ(key * 2, value);
+    ++visited;
+  });
+  EXPECT_EQ(50000, visited);
+}
+
+TEST(SingleWriterF14Map, Collisions) {
+  // every key wants the same chunk, so lookups follow overflow counts
+  struct BadHash {
+    size_t operator()(int) const {
+      return 0;
+    }
+  };
+  SingleWriterF14Map<int, int, BadHash> map;
+  for (int i = 0; i < 300; ++i) {
+    map.insert(i, i);
+  }
+  for (int i = 0; i < 300; i += 3) {
+    map.erase(i);
+  }
+  for (int i = 0; i < 300; ++i) {
+    EXPECT_EQ(i % 3 != 0, map.contains(i));
+  }
+  for (int i = 0; i < 300; i += 3) {
+    map.insert(i, -i);
+  }
+  for (int i = 0; i < 300; ++i) {
+    EXPECT_EQ(i % 3 ? i : -i, map.find(i).value());
+  }
+}
+
+TEST(SingleWriterF14Map, ValuesAreReclaimed) {
+  static std::atomic<int> alive{0};
+  struct Value {
+    Value() {
+      ++alive;
+    }
+    ~Value() {
+      --alive;
+    }
+  };
+  {
+    SingleWriterF14Map<int, Value> map;
+    for (int i = 0; i < 1000; ++i) {
+      map.insert(i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      map.erase(i);
+    }
+    folly::hazptr_cleanup();
+    EXPECT_EQ(500, alive.load());
+  }
+  folly::hazptr_cleanup();
+  EXPECT_EQ(0, alive.load());
+}
+
+TEST(SingleWriterF14Map, ConcurrentReaders) {
+  constexpr int kReaders = 4;
+  constexpr int64_t kNum = 20000;
+  SingleWriterF14Map<int64_t, std::string> map;
+  // keys below kNum are never erased; their value is always a multiple
+  for (int64_t i = 0; i < kNum; ++i) {
+    map.insert(i, folly::to<std::string>(i));
+  }
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        for (int64_t i = 7; i < kNum; i += 7) {
+          auto acc = map.find(i);
+          ASSERT_TRUE(acc);
+          EXPECT_EQ(0, folly::to<int64_t>(acc.value()) % i);
+        }
+      }
+    });
+  }
+  for (int round = 1; round < 4; ++round) {
+    for (int64_t i = 0; i < kNum; ++i) {
+      map.insert_or_assign(i, folly::to<std::string>(i * round));
+    }
+    // grows, erases and regrows the rest of the map
+    for (int64_t i = kNum; i < 10 * kNum; ++i) {
+      map.insert(i, "");
+    }
+    for (int64_t i = kNum; i < 10 * kNum; ++i) {
+      map.erase(i);
+    }
+  }
+  done = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+  EXPECT_EQ(kNum, map.size());
+}
+
+TEST(SingleWriterF14Map, ForEachDuringResize) {
+  constexpr int64_t kNum = 10000;
+  SingleWriterF14Map<int64_t, int64_t> map;
+  for (int64_t i = 0; i < kNum; ++i) {
+    map.insert(i, i);
+  }
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int64_t i = kNum; i < 20 * kNum; ++i) {
+      map.insert(i, i);
+    }
+    done = true;
+  });
+  do {
+    std::unordered_map<int64_t, int> visits;
+    map.forEach([&](int64_t key, int64_t value) {
+      EXPECT_EQ(key, value);
+      ++visits[key];
+    });
+    for (int64_t i = 0; i < kNum; ++i) {
+      EXPECT_LE(1, visits[i]);
+    }
+  } while (!done.load());
+  writer.join();
+}
@@ -24,7 +24,9 @@
 #include <glog/logging.h>
 
 #include <atomic>
+#include <numeric>
 #include <thread>
+#include <vector>
 
 DEFINE_bool(bench, false, "run benchmark");
 DEFINE_int32(reps, 10, "number of reps");
@@ -395,6 +397,77 @@ TEST(UnboundedQueue, enq_deq) {
   enq_deq_test<false, false, true>(10, 10);
 }
 
+template <bool SingleProducer, bool SingleConsumer, bool MayBlock>
+void batch_test(const int nprod, const int ncons) {
+  int ops = 1000;
+  constexpr size_t kBatch = 37; // crosses segments of 16 elements
+  folly::UnboundedQueue<int, SingleProducer, SingleConsumer, MayBlock, 4> q;
+  std::atomic<uint64_t> sum(0);
+  std::atomic<int> count(0);
+
+  auto prod = [&](int tid) {
+    std::vector<int> batch;
+    for (int i = tid; i < ops; i += nprod) {
+      batch.push_back(i);
+      if (batch.size() == kBatch) {
+        q.enqueue_batch(batch.begin(), batch.end());
+        batch.clear();
+      }
+    }
+    q.enqueue_batch(batch.begin(), batch.end());
+  };
+
+  auto cons = [&](int) {
+    uint64_t mysum = 0;
+    int expected = 0;
+    int items[kBatch];
+    while (count.load() < ops) {
+      size_t n = q.try_dequeue_batch(items, kBatch);
+      for (size_t i = 0; i < n; ++i) {
+        if (nprod == 1 && ncons == 1) {
+          ASSERT_EQ(items[i], expected++);
+        }
+        mysum += items[i];
+      }
+      count.fetch_add(int(n));
+    }
+    sum.fetch_add(mysum);
+  };
+
+  auto endfn = [&] {
+    uint64_t expected = (ops) * (ops - 1) / 2;
+    ASSERT_EQ(expected, sum.load());
+    ASSERT_TRUE(q.empty());
+  };
+  run_once(nprod, ncons, prod, cons, endfn);
+}
+
+TEST(UnboundedQueue, batch) {
+  folly::UMPMCQueue<int, false, 4> q;
+  int items[40];
+  ASSERT_EQ(q.try_dequeue_batch(items, 40), 0);
+  std::vector<int> v(40);
+  std::iota(v.begin(), v.end(), 0);
+  q.enqueue_batch(v.begin(), v.end());
+  q.enqueue_batch(v.begin(), v.begin());
+  ASSERT_EQ(q.size(), 40);
+  ASSERT_EQ(q.try_dequeue_batch(items, 10), 10);
+  ASSERT_EQ(items[9], 9);
+  ASSERT_EQ(q.try_dequeue_batch(items, 40), 30);
+  ASSERT_EQ(items[0], 10);
+  ASSERT_EQ(items[29], 39);
+  ASSERT_TRUE(q.empty());
+
+  batch_test<true, true, false>(1, 1);
+  batch_test<true, true, true>(1, 1);
+  batch_test<false, true, false>(4, 1);
+  batch_test<false, true, true>(4, 1);
+  batch_test<true, false, false>(1, 4);
+  batch_test<true, false, true>(1, 4);
+  batch_test<false, false, false>(4, 4);
+  batch_test<false, false, true>(4, 4);
+}
+
 template <typename RepFunc>
 uint64_t runBench(const std::string& name, int ops, const RepFunc& repFn) {
   uint64_t reps = FLAGS_reps;
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * btree_map and btree_set are ordered associative containers with the
+ * interfaces of std::map and std::set, implemented as B+trees: values
+ * are stored in sorted arrays of about 256 bytes, so that lookups touch
+ * a few cache lines per level of a shallow tree instead of a node per
+ * comparison, and iterating visits consecutive values.
+ *
+ * Integer keys compared with std::less are searched with SIMD compares
+ * within nodes.
+ *
+ * Unlike std::map, inserting and erasing invalidate all iterators,
+ * pointers and references to values, which move between nodes, and
+ * values must be nothrow move constructible.
+ *
+ * Both can be built in linear time from a sorted range without
+ * duplicates, with the sorted_unique constructors, and scan(lo, hi, f)
+ * visits the values whose keys are in [lo, hi) without going through
+ * iterators.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include <folly/Utility.h>
+#include <folly/container/detail/BTree.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+namespace detail {
+namespace btree {
+
+struct SetKeyOfValue {
+  template <typename T>
+  T const& operator()(T const& value) const {
+    return value;
+  }
+};
+
+struct MapKeyOfValue {
+  template <typename P>
+  typename P::first_type const& operator()(P const& value) const {
+    return value.first;
+  }
+};
+
+} // namespace btree
+} // namespace detail
+
+template <
+    typename Key,
+    typename Compare = std::less<Key>,
+    typename Alloc = std::allocator<Key>>
+class btree_set : public detail::btree::BTree<
+                      Key,
+                      Key,
+                      detail::btree::SetKeyOfValue,
+                      Compare,
+                      Alloc> {
+  using Base = detail::btree::
+      BTree<Key, Key, detail::btree::SetKeyOfValue, Compare, Alloc>;
+
+ public:
+  using value_compare = Compare;
+
+  btree_set() = default;
+
+  explicit btree_set(Compare const& comp, Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {}
+
+  explicit btree_set(Alloc const& alloc) : Base(Compare(), alloc) {}
+
+  template <typename It>
+  btree_set(
+      It first,
+      It last,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {
+    this->insert(first, last);
+  }
+
+  btree_set(
+      std::initializer_list<Key> list,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : btree_set(list.begin(), list.end(), comp, alloc) {}
+
+  // The range must be sorted, without duplicates; built in O(n).
+  template <typename It>
+  btree_set(
+      sorted_unique_t,
+      It first,
+      It last,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {
+    this->assignSorted(first, last);
+  }
+
+  btree_set& operator=(std::initializer_list<Key> list) {
+    this->clear();
+    this->insert(list.begin(), list.end());
+    return *this;
+  }
+
+  using Base::insert;
+  void insert(std::initializer_list<Key> list) {
+    this->insert(list.begin(), list.end());
+  }
+
+  value_compare value_comp() const {
+    return this->key_comp();
+  }
+
+  friend bool operator==(btree_set const& a, btree_set const& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+  friend bool operator!=(btree_set const& a, btree_set const& b) {
+    return !(a == b);
+  }
+  friend void swap(btree_set& a, btree_set& b) noexcept {
+    a.swap(b);
+  }
+};
+
+template <
+    typename Key,
+    typename T,
+    typename Compare = std::less<Key>,
+    typename Alloc = std::allocator<std::pair<Key, T>>>
+class btree_map : public detail::btree::BTree<
+                      Key,
+                      std::pair<Key, T>,
+                      detail::btree::MapKeyOfValue,
+                      Compare,
+                      Alloc> {
+  using Base = detail::btree::BTree<
+      Key,
+      std::pair<Key, T>,
+      detail::btree::MapKeyOfValue,
+      Compare,
+      Alloc>;
+  using AllocTraits = std::allocator_traits<Alloc>;
+
+ public:
+  using mapped_type = T;
+  using value_type = typename Base::value_type;
+  using iterator = typename Base::iterator;
+  using const_iterator = typename Base::const_iterator;
+
+  class value_compare {
+   public:
+    bool operator()(value_type const& a, value_type const& b) const {
+      return comp_(a.first, b.first);
+    }
+
+   private:
+    friend class btree_map;
+    explicit value_compare(Compare const& comp) : comp_(comp) {}
+    Compare comp_;
+  };
+
+  btree_map() = default;
+
+  explicit btree_map(Compare const& comp, Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {}
+
+  explicit btree_map(Alloc const& alloc) : Base(Compare(), alloc) {}
+
+  template <typename It>
+  btree_map(
+      It first,
+      It last,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {
+    this->insert(first, last);
+  }
+
+  btree_map(
+      std::initializer_list<value_type> list,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : btree_map(list.begin(), list.end(), comp, alloc) {}
+
+  // The range must be sorted by key, without duplicates; built in O(n).
+  template <typename It>
+  btree_map(
+      sorted_unique_t,
+      It first,
+      It last,
+      Compare const& comp = Compare(),
+      Alloc const& alloc = Alloc())
+      : Base(comp, alloc) {
+    this->assignSorted(first, last);
+  }
+
+  btree_map& operator=(std::initializer_list<value_type> list) {
+    this->clear();
+    this->insert(list.begin(), list.end());
+    return *this;
+  }
+
+  using Base::insert;
+  void insert(std::initializer_list<value_type> list) {
+    this->insert(list.begin(), list.end());
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key const& key, Args&&... args) {
+    return this->insertUnique(key, [&](value_type* slot) {
+      AllocTraits::construct(
+          this->alloc(),
+          slot,
+          std::piecewise_construct,
+          std::forward_as_tuple(key),
+          std::forward_as_tuple(std::forward<Args>(args)...));
+    });
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+    return this->insertUnique(key, [&](value_type* slot) {
+      AllocTraits::construct(
+          this->alloc(),
+          slot,
+          std::piecewise_construct,
+          std::forward_as_tuple(std::move(key)),
+          std::forward_as_tuple(std::forward<Args>(args)...));
+    });
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(Key const& key, M&& mapped) {
+    auto result = try_emplace(key, std::forward<M>(mapped));
+    if (!result.second) {
+      result.first->second = std::forward<M>(mapped);
+    }
+    return result;
+  }
+
+  T& operator[](Key const& key) {
+    return try_emplace(key).first->second;
+  }
+
+  T& operator[](Key&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  T& at(Key const& key) {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw_exception<std::out_of_range>("btree_map::at");
+    }
+    return it->second;
+  }
+
+  T const& at(Key const& key) const {
+    auto it = this->find(key);
+    if (it == this->end()) {
+      throw_exception<std::out_of_range>("btree_map::at");
+    }
+    return it->second;
+  }
+
+  value_compare value_comp() const {
+    return value_compare(this->key_comp());
+  }
+
+  friend bool operator==(btree_map const& a, btree_map const& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  }
+  friend bool operator!=(btree_map const& a, btree_map const& b) {
+    return !(a == b);
+  }
+  friend void swap(btree_map& a, btree_map& b) noexcept {
+    a.swap(b);
+  }
+};
+
+} // namespace folly
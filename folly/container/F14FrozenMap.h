@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * F14FrozenMap is a read-only hash map stored in a single contiguous
+ * image, which can be written to a file and later queried in place
+ * through a MemoryMapping.  Loading it does no work proportional to its
+ * size: the pages are read on demand by the lookups that touch them,
+ * and are shared between all the processes that map the same file.
+ *
+ * The image is an array of F14 chunks after a small header, so lookups
+ * use the same SIMD tag probe as F14ValueMap.  It contains no pointers,
+ * and can be mapped at any address that is aligned to 16 bytes (which
+ * mmap and malloc'ed strings of at least 64 bytes both guarantee).
+ *
+ * Keys and values must be trivially copyable, and the Hasher must return
+ * the same values in the process that freezes the map and in the ones
+ * that read it, which std::hash doesn't promise; folly::hasher does for
+ * integers and strings.  Images use the native byte order and type
+ * layout; the constructor rejects images whose sizes or byte order
+ * don't match, but doesn't check the contents of the chunks.
+ *
+ *   folly::F14ValueMap<uint64_t, Stats> map = ...;
+ *   folly::writeFile(F14FrozenMap<uint64_t, Stats>::freeze(map), path);
+ *   ...
+ *   F14FrozenMap<uint64_t, Stats> frozen{folly::MemoryMapping(path)};
+ *   Stats const* stats = frozen.get_ptr(key);
+ */
+
+#pragma once
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <folly/Bits.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/container/detail/F14Table.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Exception.h>
+#include <folly/system/MemoryMapping.h>
+
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+
+namespace folly {
+
+template <typename Key, typename Mapped>
+struct F14FrozenEntry {
+  Key first;
+  Mapped second;
+};
+
+namespace f14 {
+namespace detail {
+
+struct alignas(kRequiredVectorAlignment) F14FrozenHeader {
+  static constexpr uint64_t kMagic = 0x315a524634314600; // "\0F14FRZ1"
+  static constexpr uint32_t kVersion = 1;
+
+  uint64_t magic;
+  uint32_t version;
+  uint32_t chunkSize;
+  uint32_t keySize;
+  uint32_t mappedSize;
+  uint64_t chunkCount;
+  uint64_t size;
+};
+
+} // namespace detail
+} // namespace f14
+
+template <
+    typename Key,
+    typename Mapped,
+    typename Hasher = folly::hasher<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class F14FrozenMap {
+  static_assert(
+      std::is_trivially_copyable<Key>::value &&
+          std::is_trivially_copyable<Mapped>::value,
+      "F14FrozenMap keys and values must be trivially copyable");
+
+ public:
+  using key_type = Key;
+  using mapped_type = Mapped;
+  using value_type = F14FrozenEntry<Key, Mapped>;
+  using size_type = std::size_t;
+  using hasher = Hasher;
+  using key_equal = KeyEqual;
+
+ private:
+  using Header = f14::detail::F14FrozenHeader;
+  using Chunk = f14::detail::F14Chunk<value_type>;
+
+  static_assert(
+      alignof(value_type) <= alignof(Chunk),
+      "F14FrozenMap entries can't be more aligned than a chunk");
+
+ public:
+  /**
+   * Builds the image of the items of map, which can be any container of
+   * pairs of Key and Mapped with a size(), and is most often an
+   * F14ValueMap or F14VectorMap.  The keys must be unique.
+   */
+  template <typename Map>
+  static std::string freeze(Map const& map) {
+    uint64_t size = map.size();
+    uint64_t chunkCount = 1;
+    while (chunkCount * Chunk::kDesiredCapacity < size) {
+      chunkCount *= 2;
+    }
+
+    std::string image(kChunksOffset + chunkCount * sizeof(Chunk), '\0');
+    Header header{};
+    header.magic = Header::kMagic;
+    header.version = Header::kVersion;
+    header.chunkSize = sizeof(Chunk);
+    header.keySize = sizeof(Key);
+    header.mappedSize = sizeof(Mapped);
+    header.chunkCount = chunkCount;
+    header.size = size;
+    std::memcpy(&image[0], &header, sizeof(header));
+
+    // The chunks are all zero, which is what clear() would leave them as.
+    // std::string's buffer isn't necessarily aligned like a Chunk, so we
+    // build it in an aligned chunk and then copy it into the image.
+    auto chunkAddr = [&](uint64_t index) {
+      return &image[kChunksOffset + index * sizeof(Chunk)];
+    };
+    Chunk chunk;
+    for (auto const& kv : map) {
+      value_type entry{kv.first, kv.second};
+      auto hp = splitHash(hasher{}(entry.first));
+      uint64_t index = hp.first;
+      uint64_t step = probeDelta(hp);
+      for (uint64_t tries = 0;; ++tries) {
+        auto dest = chunkAddr(index & (chunkCount - 1));
+        std::memcpy(static_cast<void*>(&chunk), dest, sizeof(Chunk));
+        auto firstEmpty = chunk.firstEmpty();
+        if (firstEmpty.hasIndex()) {
+          auto i = firstEmpty.index();
+          chunk.setTag(i, hp.second);
+          std::memcpy(
+              static_cast<void*>(chunk.itemAddr(i)), &entry, sizeof(entry));
+          if (tries > 0) {
+            chunk.adjustHostedOverflowCount(Chunk::kIncrHostedOverflowCount);
+          }
+          std::memcpy(dest, static_cast<void*>(&chunk), sizeof(Chunk));
+          break;
+        }
+        chunk.incrOutboundOverflowCount();
+        std::memcpy(dest, static_cast<void*>(&chunk), sizeof(Chunk));
+        index += step;
+      }
+    }
+    return image;
+  }
+
+  /**
+   * Queries an image produced by freeze() in place; the image must
+   * outlive the map.  Throws std::invalid_argument if it isn't a valid
+   * image for this type or isn't aligned.
+   */
+  explicit F14FrozenMap(ByteRange image) {
+    init(image);
+  }
+
+  /**
+   * Queries the image in the mapping, which the map takes ownership of.
+   */
+  explicit F14FrozenMap(MemoryMapping mapping)
+      : mapping_(std::move(mapping)) {
+    init(mapping_->range());
+  }
+
+  F14FrozenMap(F14FrozenMap&&) = default;
+  F14FrozenMap& operator=(F14FrozenMap&&) = default;
+
+  size_type size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  value_type const* find(key_type const& key) const {
+    auto hp = splitHash(hasher{}(key));
+    std::size_t index = hp.first;
+    std::size_t step = probeDelta(hp);
+    for (std::size_t tries = 0; tries <= chunkMask_; ++tries) {
+      Chunk const* chunk = chunks_ + (index & chunkMask_);
+      if (sizeof(Chunk) > 64) {
+        f14::detail::prefetchAddr(chunk->itemAddr(8));
+      }
+      auto hits = chunk->tagMatchIter(hp.second);
+      while (hits.hasNext()) {
+        auto i = hits.next();
+        auto item = chunk->itemAddr(i);
+        if (LIKELY(key_equal{}(key, item->first))) {
+          return item;
+        }
+      }
+      if (LIKELY(chunk->outboundOverflowCount() == 0)) {
+        break;
+      }
+      index += step;
+    }
+    return nullptr;
+  }
+
+  mapped_type const* get_ptr(key_type const& key) const {
+    auto item = find(key);
+    return item ? &item->second : nullptr;
+  }
+
+  mapped_type const& at(key_type const& key) const {
+    auto item = find(key);
+    if (!item) {
+      throw_exception<std::out_of_range>("at() did not find key");
+    }
+    return item->second;
+  }
+
+  size_type count(key_type const& key) const {
+    return find(key) ? 1 : 0;
+  }
+
+  bool contains(key_type const& key) const {
+    return find(key) != nullptr;
+  }
+
+  /**
+   * Invokes f(value_type const&) on every item, in chunk order.
+   */
+  template <typename F>
+  void visit(F&& f) const {
+    for (std::size_t c = 0; c <= chunkMask_; ++c) {
+      auto iter = chunks_[c].occupiedIter();
+      while (iter.hasNext()) {
+        f(*chunks_[c].itemAddr(iter.next()));
+      }
+    }
+  }
+
+ private:
+  static constexpr std::size_t kChunksOffset =
+      (sizeof(Header) + alignof(Chunk) - 1) / alignof(Chunk) * alignof(Chunk);
+
+  using HashPair = std::pair<std::size_t, std::size_t>;
+
+  // F14Table's splitHash depends on the build (it uses CRC when it is
+  // available), so the image needs its own.
+  static HashPair splitHash(std::size_t hash) {
+    uint64_t mixed = hash::twang_mix64(hash);
+    return {
+        static_cast<std::size_t>(mixed),
+        static_cast<std::size_t>((mixed >> 56) | 0x80)};
+  }
+
+  static std::size_t probeDelta(HashPair hp) {
+    return 2 * hp.second + 1;
+  }
+
+  void init(ByteRange image) {
+    Header header;
+    if (image.size() < kChunksOffset) {
+      throw_exception<std::invalid_argument>("F14FrozenMap image too small");
+    }
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (header.magic != Header::kMagic || header.version != Header::kVersion) {
+      throw_exception<std::invalid_argument>("not an F14FrozenMap image");
+    }
+    if (header.chunkSize != sizeof(Chunk) || header.keySize != sizeof(Key) ||
+        header.mappedSize != sizeof(Mapped)) {
+      throw_exception<std::invalid_argument>(
+          "F14FrozenMap image has another key or value type");
+    }
+    if (header.chunkCount == 0 || !isPowTwo(header.chunkCount) ||
+        (image.size() - kChunksOffset) / sizeof(Chunk) != header.chunkCount ||
+        header.size > header.chunkCount * Chunk::kCapacity) {
+      throw_exception<std::invalid_argument>("corrupt F14FrozenMap image");
+    }
+    if (reinterpret_cast<uintptr_t>(image.data()) % alignof(Chunk) != 0) {
+      throw_exception<std::invalid_argument>(
+          "F14FrozenMap image is not aligned");
+    }
+    chunks_ = reinterpret_cast<Chunk const*>(image.data() + kChunksOffset);
+    chunkMask_ = static_cast<std::size_t>(header.chunkCount - 1);
+    size_ = static_cast<std::size_t>(header.size);
+  }
+
+  Optional<MemoryMapping> mapping_;
+  Chunk const* chunks_{nullptr};
+  std::size_t chunkMask_{0};
+  std::size_t size_{0};
+};
+
+} // namespace folly
+
+#endif // FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
@@ -58,6 +58,20 @@ class F14BasicMap {
           K>::value,
       T>;
 
+  template <typename Keys>
+  using BulkKey =
+      remove_cvref_t<decltype(*std::begin(std::declval<Keys const&>()))>;
+
+  template <typename Keys, typename T>
+  using EnableBulkFind = std::enable_if_t<
+      std::is_same<BulkKey<Keys>, typename Policy::Key>::value ||
+          EligibleForHeterogeneousFind<
+              typename Policy::Key,
+              typename Policy::Hasher,
+              typename Policy::KeyEqual,
+              BulkKey<Keys>>::value,
+      T>;
+
   template <typename K, typename T>
   using EnableHeterogeneousInsert = std::enable_if_t<
       EligibleForHeterogeneousInsert<
@@ -645,6 +659,44 @@ class F14BasicMap {
     return !table_.find(token, key).atEnd();
   }
 
+  // bulk_find(keys, out) writes find(k) for each key k of keys to out,
+  // in order, and bulk_visit(keys, func) calls func(i, find(keys[i]))
+  // for each index i of keys.  They are faster than as many calls to
+  // find() for more than a few keys, by hashing and prefetching keys a
+  // batch at a time: the cache misses of a batch overlap instead of
+  // following each other.  keys must be a random access range of
+  // key_type, or of a type for which find() is heterogeneous.
+  template <typename Keys, typename OutputIt>
+  EnableBulkFind<Keys, void> bulk_find(Keys const& keys, OutputIt out) {
+    bulk_visit(keys, [&](std::size_t, iterator iter) { *out++ = iter; });
+  }
+
+  template <typename Keys, typename OutputIt>
+  EnableBulkFind<Keys, void> bulk_find(Keys const& keys, OutputIt out) const {
+    bulk_visit(
+        keys, [&](std::size_t, const_iterator iter) { *out++ = iter; });
+  }
+
+  template <typename Keys, typename F>
+  EnableBulkFind<Keys, void> bulk_visit(Keys const& keys, F&& func) {
+    auto first = std::begin(keys);
+    table_.bulkFind(
+        first,
+        std::distance(first, std::end(keys)),
+        [&](std::size_t i, ItemIter iter) { func(i, table_.makeIter(iter)); });
+  }
+
+  template <typename Keys, typename F>
+  EnableBulkFind<Keys, void> bulk_visit(Keys const& keys, F&& func) const {
+    auto first = std::begin(keys);
+    table_.bulkFind(
+        first,
+        std::distance(first, std::end(keys)),
+        [&](std::size_t i, ItemIter iter) {
+          func(i, table_.makeConstIter(iter));
+        });
+  }
+
   std::pair<iterator, iterator> equal_range(key_type const& key) {
     return equal_range(*this, key);
   }
@@ -1254,6 +1306,36 @@ class F14BasicMap : public std::unordered_map<K, M, H, E, A> {
       visitor(b, b + 1);
     }
   }
+
+  template <typename Keys, typename OutputIt>
+  void bulk_find(Keys const& keys, OutputIt out) {
+    for (auto const& key : keys) {
+      *out++ = this->find(key);
+    }
+  }
+
+  template <typename Keys, typename OutputIt>
+  void bulk_find(Keys const& keys, OutputIt out) const {
+    for (auto const& key : keys) {
+      *out++ = this->find(key);
+    }
+  }
+
+  template <typename Keys, typename F>
+  void bulk_visit(Keys const& keys, F&& func) {
+    std::size_t i = 0;
+    for (auto const& key : keys) {
+      func(i++, this->find(key));
+    }
+  }
+
+  template <typename Keys, typename F>
+  void bulk_visit(Keys const& keys, F&& func) const {
+    std::size_t i = 0;
+    for (auto const& key : keys) {
+      func(i++, this->find(key));
+    }
+  }
 };
 } // namespace detail
 } // namespace f14
@@ -55,6 +55,20 @@ class F14BasicSet {
           K>::value,
       T>;
 
+  template <typename Keys>
+  using BulkKey =
+      remove_cvref_t<decltype(*std::begin(std::declval<Keys const&>()))>;
+
+  template <typename Keys, typename T>
+  using EnableBulkFind = std::enable_if_t<
+      std::is_same<BulkKey<Keys>, typename Policy::Value>::value ||
+          EligibleForHeterogeneousFind<
+              typename Policy::Value,
+              typename Policy::Hasher,
+              typename Policy::KeyEqual,
+              BulkKey<Keys>>::value,
+      T>;
+
   template <typename K, typename T>
   using EnableHeterogeneousInsert = std::enable_if_t<
       EligibleForHeterogeneousInsert<
@@ -504,6 +518,28 @@ class F14BasicSet {
     return !table_.find(token, key).atEnd();
   }
 
+  // bulk_find(keys, out) writes find(k) for each key k of keys to out,
+  // in order, and bulk_visit(keys, func) calls func(i, find(keys[i]))
+  // for each index i of keys.  They are faster than as many calls to
+  // find() for more than a few keys, by hashing and prefetching keys a
+  // batch at a time: the cache misses of a batch overlap instead of
+  // following each other.  keys must be a random access range of
+  // key_type, or of a type for which find() is heterogeneous.
+  template <typename Keys, typename OutputIt>
+  EnableBulkFind<Keys, void> bulk_find(Keys const& keys, OutputIt out) const {
+    bulk_visit(
+        keys, [&](std::size_t, const_iterator iter) { *out++ = iter; });
+  }
+
+  template <typename Keys, typename F>
+  EnableBulkFind<Keys, void> bulk_visit(Keys const& keys, F&& func) const {
+    auto first = std::begin(keys);
+    table_.bulkFind(
+        first,
+        std::distance(first, std::end(keys)),
+        [&](std::size_t i, ItemIter iter) { func(i, table_.makeIter(iter)); });
+  }
+
   std::pair<iterator, iterator> equal_range(key_type const& key) {
     return equal_range(*this, key);
   }
@@ -1074,6 +1110,21 @@ class F14BasicSet : public std::unordered_set<K, H, E, A> {
       visitor(b, b + 1);
     }
   }
+
+  template <typename Keys, typename OutputIt>
+  void bulk_find(Keys const& keys, OutputIt out) const {
+    for (auto const& key : keys) {
+      *out++ = this->find(key);
+    }
+  }
+
+  template <typename Keys, typename F>
+  void bulk_visit(Keys const& keys, F&& func) const {
+    std::size_t i = 0;
+    for (auto const& key : keys) {
+      func(i++, this->find(key));
+    }
+  }
 };
 } // namespace detail
 } // namespace f14
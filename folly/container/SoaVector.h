@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * small_soa_vector<N, Ts...> is a sequence of tuples of Ts... stored as a
+ * "struct of arrays": each field is kept in its own contiguous column, a
+ * small_vector<T, N> with room for N elements inline, so that a loop over
+ * one or two fields of wide records only touches the memory of those
+ * fields.  soa_vector<Ts...> is the variant without inline storage.
+ *
+ * Elements are accessed through proxies: references are std::tuple<T&...>
+ * (and iterators dereference to them), which support std::get<I> and
+ * structured bindings.  Since there is no tuple object in memory, algorithms
+ * that swap elements through iterators, such as std::sort, do not apply.
+ * Iterators hold an index, so unlike references they stay valid when the
+ * columns reallocate.
+ *
+ * column<I>() returns the I-th column as a Range<T*>, e.g. to hand it to a
+ * vectorized kernel:
+ *
+ *   soa_vector<int64_t, double, std::string> v;
+ *   v.emplace_back(1, 0.5, "a");
+ *   double sum = 0;
+ *   for (auto d : v.column<1>()) {
+ *     sum += d;
+ *   }
+ *
+ * Operations that add elements to all columns offer the strong exception
+ * guarantee; erase() requires nothrow move assignment for it.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Utility.h>
+#include <folly/lang/Exception.h>
+#include <folly/small_vector.h>
+
+namespace folly {
+
+template <std::size_t N, class... Ts>
+class small_soa_vector;
+
+namespace detail {
+
+template <class Vector, bool Const>
+class soa_vector_iterator {
+  using Container = typename std::conditional<Const, Vector const, Vector>::
+      type;
+
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename Vector::value_type;
+  using difference_type = std::ptrdiff_t;
+  using reference = typename std::conditional<
+      Const,
+      typename Vector::const_reference,
+      typename Vector::reference>::type;
+  using pointer = void;
+
+  soa_vector_iterator() = default;
+
+  template <bool C = Const, typename std::enable_if<C, int>::type = 0>
+  /* implicit */ soa_vector_iterator(
+      soa_vector_iterator<Vector, false> const& other) noexcept
+      : vector_(other.vector_), index_(other.index_) {}
+
+  reference operator*() const {
+    return (*vector_)[index_];
+  }
+  reference operator[](difference_type n) const {
+    return (*vector_)[index_ + n];
+  }
+
+  soa_vector_iterator& operator++() {
+    ++index_;
+    return *this;
+  }
+  soa_vector_iterator operator++(int) {
+    auto copy = *this;
+    ++index_;
+    return copy;
+  }
+  soa_vector_iterator& operator--() {
+    --index_;
+    return *this;
+  }
+  soa_vector_iterator operator--(int) {
+    auto copy = *this;
+    --index_;
+    return copy;
+  }
+  soa_vector_iterator& operator+=(difference_type n) {
+    index_ += n;
+    return *this;
+  }
+  soa_vector_iterator& operator-=(difference_type n) {
+    index_ -= n;
+    return *this;
+  }
+  friend soa_vector_iterator operator+(
+      soa_vector_iterator it,
+      difference_type n) {
+    return it += n;
+  }
+  friend soa_vector_iterator operator+(
+      difference_type n,
+      soa_vector_iterator it) {
+    return it += n;
+  }
+  friend soa_vector_iterator operator-(
+      soa_vector_iterator it,
+      difference_type n) {
+    return it -= n;
+  }
+  friend difference_type operator-(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return difference_type(a.index_) - difference_type(b.index_);
+  }
+
+  friend bool operator==(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ == b.index_;
+  }
+  friend bool operator!=(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ != b.index_;
+  }
+  friend bool operator<(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ < b.index_;
+  }
+  friend bool operator>(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ > b.index_;
+  }
+  friend bool operator<=(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ <= b.index_;
+  }
+  friend bool operator>=(
+      soa_vector_iterator const& a,
+      soa_vector_iterator const& b) {
+    return a.index_ >= b.index_;
+  }
+
+ private:
+  template <std::size_t, class...>
+  friend class folly::small_soa_vector;
+  friend class soa_vector_iterator<Vector, true>;
+
+  soa_vector_iterator(Container* vector, std::size_t index) noexcept
+      : vector_(vector), index_(index) {}
+
+  Container* vector_{nullptr};
+  std::size_t index_{0};
+};
+
+} // namespace detail
+
+template <std::size_t N, class... Ts>
+class small_soa_vector {
+  static_assert(sizeof...(Ts) > 0, "small_soa_vector needs a column");
+
+  using Columns = std::tuple<small_vector<Ts, N>...>;
+  using Indexes = std::index_sequence_for<Ts...>;
+
+ public:
+  using value_type = std::tuple<Ts...>;
+  using reference = std::tuple<Ts&...>;
+  using const_reference = std::tuple<Ts const&...>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator = detail::soa_vector_iterator<small_soa_vector, false>;
+  using const_iterator = detail::soa_vector_iterator<small_soa_vector, true>;
+
+  small_soa_vector() = default;
+  small_soa_vector(small_soa_vector const&) = default;
+  small_soa_vector(small_soa_vector&&) = default;
+  small_soa_vector& operator=(small_soa_vector const&) = default;
+  small_soa_vector& operator=(small_soa_vector&&) = default;
+
+  small_soa_vector(std::initializer_list<value_type> il) {
+    reserve(il.size());
+    for (auto const& value : il) {
+      push_back(value);
+    }
+  }
+
+  explicit small_soa_vector(size_type n) {
+    resize(n);
+  }
+
+  size_type size() const noexcept {
+    return std::get<0>(columns_).size();
+  }
+  bool empty() const noexcept {
+    return size() == 0;
+  }
+  size_type max_size() const noexcept {
+    return std::get<0>(columns_).max_size();
+  }
+
+  // the number of elements that all columns can hold without reallocating
+  size_type capacity() const noexcept {
+    size_type result = max_size();
+    forEachColumn([&](auto const& column, auto) {
+      result = std::min<size_type>(result, column.capacity());
+    });
+    return result;
+  }
+
+  void reserve(size_type n) {
+    forEachColumn([&](auto& column, auto) { column.reserve(n); });
+  }
+
+  void shrink_to_fit() {
+    forEachColumn([&](auto& column, auto) { column.shrink_to_fit(); });
+  }
+
+  void clear() noexcept {
+    forEachColumn([&](auto& column, auto) { column.clear(); });
+  }
+
+  void resize(size_type n) {
+    auto const oldSize = size();
+    if (n <= oldSize) {
+      forEachColumn([&](auto& column, auto) { column.resize(n); });
+      return;
+    }
+    std::size_t done = 0;
+    auto rollback = makeGuard([&] { truncateColumns(done, oldSize); });
+    forEachColumn([&](auto& column, auto) {
+      column.resize(n);
+      ++done;
+    });
+    rollback.dismiss();
+  }
+
+  /*
+   * Appends an element constructed from one argument per column.
+   */
+  template <class... Us>
+  reference emplace_back(Us&&... fields) {
+    static_assert(
+        sizeof...(Us) == sizeof...(Ts),
+        "emplace_back takes one argument per column");
+    emplaceBackImpl(Indexes{}, std::forward<Us>(fields)...);
+    return back();
+  }
+
+  void push_back(value_type const& value) {
+    pushBackImpl(Indexes{}, value);
+  }
+  void push_back(value_type&& value) {
+    pushBackImpl(Indexes{}, std::move(value));
+  }
+
+  void pop_back() {
+    assert(!empty());
+    forEachColumn([&](auto& column, auto) { column.pop_back(); });
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    forEachColumn([&](auto& column, auto) {
+      column.erase(column.begin() + first.index_, column.begin() + last.index_);
+    });
+    return iterator(this, first.index_);
+  }
+
+  void swap(small_soa_vector& other) noexcept(
+      noexcept(std::declval<Columns&>().swap(std::declval<Columns&>()))) {
+    columns_.swap(other.columns_);
+  }
+
+  reference operator[](size_type i) {
+    assert(i < size());
+    return elementAt(Indexes{}, i);
+  }
+  const_reference operator[](size_type i) const {
+    assert(i < size());
+    return elementAt(Indexes{}, i);
+  }
+
+  reference at(size_type i) {
+    checkIndex(i);
+    return (*this)[i];
+  }
+  const_reference at(size_type i) const {
+    checkIndex(i);
+    return (*this)[i];
+  }
+
+  reference front() {
+    return (*this)[0];
+  }
+  const_reference front() const {
+    return (*this)[0];
+  }
+  reference back() {
+    return (*this)[size() - 1];
+  }
+  const_reference back() const {
+    return (*this)[size() - 1];
+  }
+
+  /*
+   * The values of the I-th field of all elements, in order.  Invalidated,
+   * like references, by operations that add or remove elements.
+   */
+  template <std::size_t I>
+  auto column() noexcept {
+    auto& c = std::get<I>(columns_);
+    return Range<decltype(c.data())>(c.data(), c.size());
+  }
+  template <std::size_t I>
+  auto column() const noexcept {
+    auto& c = std::get<I>(columns_);
+    return Range<decltype(c.data())>(c.data(), c.size());
+  }
+
+  iterator begin() noexcept {
+    return iterator(this, 0);
+  }
+  iterator end() noexcept {
+    return iterator(this, size());
+  }
+  const_iterator begin() const noexcept {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const noexcept {
+    return const_iterator(this, size());
+  }
+  const_iterator cbegin() const noexcept {
+    return begin();
+  }
+  const_iterator cend() const noexcept {
+    return end();
+  }
+
+  friend bool operator==(
+      small_soa_vector const& a,
+      small_soa_vector const& b) {
+    return a.columns_ == b.columns_;
+  }
+  friend bool operator!=(
+      small_soa_vector const& a,
+      small_soa_vector const& b) {
+    return !(a == b);
+  }
+
+ private:
+  template <class F, std::size_t... I>
+  void forEachColumnImpl(F&& f, std::index_sequence<I...>) {
+    (void)std::initializer_list<int>{
+        (f(std::get<I>(columns_), std::integral_constant<std::size_t, I>()),
+         0)...};
+  }
+  template <class F, std::size_t... I>
+  void forEachColumnImpl(F&& f, std::index_sequence<I...>) const {
+    (void)std::initializer_list<int>{
+        (f(std::get<I>(columns_), std::integral_constant<std::size_t, I>()),
+         0)...};
+  }
+
+  // Invokes f(column, std::integral_constant<std::size_t, I>) in order.
+  template <class F>
+  void forEachColumn(F&& f) {
+    forEachColumnImpl(std::forward<F>(f), Indexes{});
+  }
+  template <class F>
+  void forEachColumn(F&& f) const {
+    forEachColumnImpl(std::forward<F>(f), Indexes{});
+  }
+
+  // Shrinks the first `count` columns back to `n` elements, after a failed
+  // operation grew them.
+  void truncateColumns(std::size_t count, size_type n) noexcept {
+    forEachColumn([&](auto& column, auto index) {
+      if (decltype(index)::value < count) {
+        column.erase(column.begin() + n, column.end());
+      }
+    });
+  }
+
+  template <std::size_t... I, class... Us>
+  void emplaceBackImpl(std::index_sequence<I...>, Us&&... fields) {
+    auto const oldSize = size();
+    std::size_t done = 0;
+    auto rollback = makeGuard([&] { truncateColumns(done, oldSize); });
+    (void)std::initializer_list<int>{
+        (std::get<I>(columns_).emplace_back(std::forward<Us>(fields)),
+         ++done,
+         0)...};
+    rollback.dismiss();
+  }
+
+  template <std::size_t... I, class Tuple>
+  void pushBackImpl(std::index_sequence<I...> indexes, Tuple&& value) {
+    emplaceBackImpl(indexes, std::get<I>(std::forward<Tuple>(value))...);
+  }
+
+  template <std::size_t... I>
+  reference elementAt(std::index_sequence<I...>, size_type i) {
+    return reference(std::get<I>(columns_)[i]...);
+  }
+  template <std::size_t... I>
+  const_reference elementAt(std::index_sequence<I...>, size_type i) const {
+    return const_reference(std::get<I>(columns_)[i]...);
+  }
+
+  void checkIndex(size_type i) const {
+    if (i >= size()) {
+      throw_exception<std::out_of_range>("index out of range");
+    }
+  }
+
+  Columns columns_;
+};
+
+template <class... Ts>
+using soa_vector = small_soa_vector<0, Ts...>;
+
+template <std::size_t N, class... Ts>
+void swap(
+    small_soa_vector<N, Ts...>& a,
+    small_soa_vector<N, Ts...>& b) noexcept(noexcept(a.swap(b))) {
+  a.swap(b);
+}
+
+} // namespace folly
@@ -0,0 +1,739 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/iterator/iterator_adaptor.hpp>
+
+#include <folly/IntrusiveList.h>
+#include <folly/Optional.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+/**
+ * An LRU evicting cache like EvictingCacheMap, whose entries can also be
+ * given a time to live (TTL) after which they expire.
+ *
+ * It is an EvictingCacheMap whose values carry their expiry time and a hook
+ * into a timer wheel: a ring of buckets, each covering `resolution` of
+ * time, that holds the entries expiring in that interval (modulo one
+ * revolution of the wheel).  expire() only visits the buckets of the time
+ * elapsed since its last call, instead of scanning the whole cache, and
+ * erases the entries of these buckets that have expired.  It is called by
+ * the mutating operations whenever time has moved on to another bucket, and
+ * can be called explicitly.
+ *
+ * With lazy expiry (the default) lookups also check the expiry time of the
+ * entry they find, and treat expired entries as absent, erasing them unless
+ * the lookup is const.  Without it lookups do not read the clock, and may
+ * return entries that have expired but have not been collected yet; so may
+ * iteration in any case.
+ *
+ * Expired entries are passed to the prune hook, like evicted ones.
+ *
+ * Iterators dereference to a pair of references to the key and the value.
+ *
+ * This is NOT a thread-safe implementation: see
+ * ConcurrentTimedEvictingCacheMap below for one.
+ *
+ * Clock must be a steady clock, such as std::chrono::steady_clock.
+ */
+template <
+    class TKey,
+    class TValue,
+    class THash = std::hash<TKey>,
+    class TKeyEqual = std::equal_to<TKey>,
+    class Clock = std::chrono::steady_clock>
+class TimedEvictingCacheMap {
+ public:
+  typedef std::function<void(TKey, TValue&&)> PruneHookCall;
+  typedef typename Clock::duration Duration;
+  typedef typename Clock::time_point TimePoint;
+
+ private:
+  struct Entry {
+    explicit Entry(TValue&& v) : value(std::move(v)) {}
+    TValue value;
+    // TimePoint::max() if the entry does not expire, and then it is not in
+    // the wheel
+    TimePoint expiry{TimePoint::max()};
+    // the key of the entry, once it is in the wheel
+    const TKey* key{nullptr};
+    // unlinks the entry from the wheel when the map destroys it
+    IntrusiveListHook wheelHook;
+  };
+  typedef EvictingCacheMap<TKey, Entry, THash, TKeyEqual> EntryMap;
+  typedef std::pair<const TKey, Entry> EntryPair;
+  typedef IntrusiveList<Entry, &Entry::wheelHook> WheelBucket;
+  typedef std::pair<const TKey, TValue> TPair;
+
+ public:
+  // iterator base : returns a pair of references to the key and the value
+  // on dereference
+  template <typename Value, typename Reference, typename TIterator>
+  class iterator_base : public boost::iterator_adaptor<
+                            iterator_base<Value, Reference, TIterator>,
+                            TIterator,
+                            Value,
+                            boost::bidirectional_traversal_tag,
+                            Reference> {
+   public:
+    iterator_base() {}
+
+    explicit iterator_base(TIterator it)
+        : iterator_base::iterator_adaptor_(it) {}
+
+    template <
+        typename V,
+        typename R,
+        typename I,
+        std::enable_if_t<
+            std::is_same<V const, Value>::value &&
+                std::is_convertible<I, TIterator>::value,
+            int> = 0>
+    /* implicit */ iterator_base(iterator_base<V, R, I> const& other)
+        : iterator_base::iterator_adaptor_(other.base()) {}
+
+    Reference dereference() const {
+      return Reference(
+          this->base_reference()->first, this->base_reference()->second.value);
+    }
+  };
+
+  // iterators, in MRU to LRU order
+  typedef iterator_base<
+      TPair,
+      std::pair<const TKey&, TValue&>,
+      typename EntryMap::iterator>
+      iterator;
+  typedef iterator_base<
+      const TPair,
+      std::pair<const TKey&, const TValue&>,
+      typename EntryMap::const_iterator>
+      const_iterator;
+
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using hasher = THash;
+
+  static constexpr std::size_t kDefaultWheelBuckets = 256;
+
+  /**
+   * Construct a TimedEvictingCacheMap
+   * @param maxSize maximum size of the cache map, 0 for no limit, as for
+   *     EvictingCacheMap.
+   * @param defaultTtl time to live of entries set without one; zero (the
+   *     default) means that they do not expire.
+   * @param clearSize the number of elements to clear at a time when the
+   *     eviction size is reached.
+   * @param resolution the interval covered by a bucket of the timer wheel;
+   *     entries are collected by expire() at most this late.
+   * @param wheelBuckets the number of buckets of the timer wheel; TTLs
+   *     longer than wheelBuckets * resolution are supported, but their
+   *     entries are visited once per revolution until they expire.
+   */
+  explicit TimedEvictingCacheMap(
+      std::size_t maxSize,
+      Duration defaultTtl = Duration::zero(),
+      std::size_t clearSize = 1,
+      Duration resolution = std::chrono::seconds(1),
+      std::size_t wheelBuckets = kDefaultWheelBuckets,
+      const THash& keyHash = THash(),
+      const TKeyEqual& keyEqual = TKeyEqual())
+      : maxSize_(maxSize),
+        clearSize_(clearSize),
+        defaultTtl_(defaultTtl),
+        resolution_(std::max(resolution, Duration(1))),
+        nWheelBuckets_(std::max(wheelBuckets, std::size_t(1))),
+        wheel_(new WheelBucket[nWheelBuckets_]),
+        lastTick_(tickOf(Clock::now())),
+        map_(maxSize, clearSize, keyHash, keyEqual) {
+    // evictions are done here, once the expiry of a new entry is set
+    map_.setMaxSize(0);
+  }
+
+  TimedEvictingCacheMap(const TimedEvictingCacheMap&) = delete;
+  TimedEvictingCacheMap& operator=(const TimedEvictingCacheMap&) = delete;
+
+  /**
+   * As in EvictingCacheMap.
+   */
+  void setMaxSize(size_t maxSize, PruneHookCall pruneHook = nullptr) {
+    if (maxSize != 0 && maxSize < size()) {
+      // Prune the excess elements with our new constraints.
+      prune(std::max(size() - maxSize, clearSize_), pruneHook);
+    }
+    maxSize_ = maxSize;
+  }
+
+  size_t getMaxSize() const {
+    return maxSize_;
+  }
+
+  void setClearSize(size_t clearSize) {
+    clearSize_ = clearSize;
+  }
+
+  void setDefaultTtl(Duration ttl) {
+    defaultTtl_ = ttl;
+  }
+
+  Duration getDefaultTtl() const {
+    return defaultTtl_;
+  }
+
+  /**
+   * Enable or disable the expiry checks of lookups.
+   */
+  void setLazyExpiry(bool lazyExpiry) {
+    lazyExpiry_ = lazyExpiry;
+  }
+
+  /**
+   * Check for existence of a specific key in the map.  This operation has
+   *     no effect on LRU order.
+   */
+  bool exists(const TKey& key) const {
+    return findWithoutPromotion(key) != end();
+  }
+
+  /**
+   * Get the value associated with a specific key.  This function always
+   *     promotes a found value to the head of the LRU.
+   * @throw std::out_of_range exception of the key does not exist
+   */
+  TValue& get(const TKey& key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw_exception<std::out_of_range>("Key does not exist");
+    }
+    return it->second;
+  }
+
+  /**
+   * Get the iterator associated with a specific key, or end().  This
+   *     function always promotes a found value to the head of the LRU.
+   */
+  iterator find(const TKey& key) {
+    return iterator(checkExpiry(map_.find(key)));
+  }
+
+  /**
+   * Get the value associated with a specific key.  This function never
+   *     promotes a found value to the head of the LRU.
+   * @throw std::out_of_range exception of the key does not exist
+   */
+  const TValue& getWithoutPromotion(const TKey& key) const {
+    auto it = findWithoutPromotion(key);
+    if (it == end()) {
+      throw_exception<std::out_of_range>("Key does not exist");
+    }
+    return it->second;
+  }
+
+  TValue& getWithoutPromotion(const TKey& key) {
+    auto it = findWithoutPromotion(key);
+    if (it == end()) {
+      throw_exception<std::out_of_range>("Key does not exist");
+    }
+    return it->second;
+  }
+
+  /**
+   * Get the iterator associated with a specific key, or end().  This
+   *     function never promotes a found value to the head of the LRU.
+   */
+  const_iterator findWithoutPromotion(const TKey& key) const {
+    auto it = map_.findWithoutPromotion(key);
+    if (it == map_.end() || hasExpiredOnRead(it->second)) {
+      return end();
+    }
+    return const_iterator(it);
+  }
+
+  iterator findWithoutPromotion(const TKey& key) {
+    return iterator(checkExpiry(map_.findWithoutPromotion(key)));
+  }
+
+  /**
+   * The time at which the entry of key expires; TimePoint::max() if it does
+   * not expire, and none if there is no such entry.
+   */
+  Optional<TimePoint> getExpiry(const TKey& key) const {
+    auto it = map_.findWithoutPromotion(key);
+    if (it == map_.end()) {
+      return none;
+    }
+    return it->second.expiry;
+  }
+
+  /**
+   * Erase the key-value pair associated with key if it exists.
+   * @return true if the key existed and was erased, else false
+   */
+  bool erase(const TKey& key) {
+    return map_.erase(key);
+  }
+
+  /**
+   * Erase the key-value pair associated with pos
+   * @return iterator to the following element or end() if pos was the last
+   *     element
+   */
+  iterator erase(const_iterator pos) {
+    return iterator(map_.erase(pos.base()));
+  }
+
+  /**
+   * Set a key-value pair in the dictionary, with the default TTL.
+   * @param promote boolean flag indicating whether or not to move something
+   *     to the front of an LRU.  This only really matters if you're setting
+   *     a value that already exists.
+   * @param pruneHook callback to use on eviction (if it occurs).
+   */
+  void set(
+      const TKey& key,
+      TValue value,
+      bool promote = true,
+      PruneHookCall pruneHook = nullptr) {
+    set(key, std::move(value), defaultTtl_, promote, std::move(pruneHook));
+  }
+
+  /**
+   * Set a key-value pair in the dictionary, expiring after ttl (or never if
+   *     ttl is zero).  Also resets the TTL of an existing entry.
+   */
+  void set(
+      const TKey& key,
+      TValue value,
+      Duration ttl,
+      bool promote = true,
+      PruneHookCall pruneHook = nullptr) {
+    auto const now = Clock::now();
+    maybeExpire(now, pruneHook);
+    auto it = promote ? map_.find(key) : map_.findWithoutPromotion(key);
+    if (it != map_.end()) {
+      it->second.value = std::move(value);
+      setExpiry(*it, now, ttl);
+    } else {
+      insertNew(key, std::move(value), now, ttl, pruneHook);
+    }
+  }
+
+  /**
+   * Insert a new key-value pair in the dictionary if no unexpired element
+   *     exists for key, expiring after ttl (or never if ttl is zero).
+   * @return a pair consisting of an iterator to the inserted element (or to
+   *     the element that prevented the insertion) and a bool denoting whether
+   *     the insertion took place.
+   */
+  std::pair<iterator, bool> insert(
+      const TKey& key,
+      TValue value,
+      Duration ttl,
+      PruneHookCall pruneHook = nullptr) {
+    auto const now = Clock::now();
+    maybeExpire(now, pruneHook);
+    auto it = map_.findWithoutPromotion(key);
+    if (it != map_.end()) {
+      if (!isExpired(it->second, now)) {
+        return std::make_pair(iterator(it), false);
+      }
+      removeExpired(it, pruneHook);
+    }
+    return std::make_pair(
+        insertNew(key, std::move(value), now, ttl, pruneHook), true);
+  }
+
+  std::pair<iterator, bool>
+  insert(const TKey& key, TValue value, PruneHookCall pruneHook = nullptr) {
+    return insert(key, std::move(value), defaultTtl_, std::move(pruneHook));
+  }
+
+  /**
+   * Erase the entries that have expired, visiting the buckets of the timer
+   *     wheel for the time elapsed since the last call.
+   * @return the number of entries erased
+   */
+  std::size_t expire(PruneHookCall pruneHook = nullptr) {
+    return expireAt(Clock::now(), pruneHook);
+  }
+
+  /**
+   * Get the number of elements in the dictionary, including those that
+   *     have expired but have not been collected yet.
+   */
+  std::size_t size() const {
+    return map_.size();
+  }
+
+  bool empty() const {
+    return map_.empty();
+  }
+
+  void clear(PruneHookCall pruneHook = nullptr) {
+    prune(size(), pruneHook);
+  }
+
+  /**
+   * Set the prune hook, which is the function invoked on the key and value
+   *     on each eviction or expiry.  Will throw If the pruneHook throws,
+   *     unless the TimedEvictingCacheMap object is being destroyed in which
+   *     case it will be ignored.
+   */
+  void setPruneHook(PruneHookCall pruneHook) {
+    pruneHook_ = pruneHook;
+    map_.setPruneHook(wrapPruneHook(std::move(pruneHook)));
+  }
+
+  /**
+   * Prune the minimum of pruneSize and size() from the back of the LRU.
+   * Will throw if pruneHook throws.
+   */
+  void prune(std::size_t pruneSize, PruneHookCall pruneHook = nullptr) {
+    map_.prune(pruneSize, wrapPruneHook(std::move(pruneHook)));
+  }
+
+  // Iterators and such
+  iterator begin() {
+    return iterator(map_.begin());
+  }
+  iterator end() {
+    return iterator(map_.end());
+  }
+  const_iterator begin() const {
+    return const_iterator(map_.begin());
+  }
+  const_iterator end() const {
+    return const_iterator(map_.end());
+  }
+  const_iterator cbegin() const {
+    return const_iterator(map_.cbegin());
+  }
+  const_iterator cend() const {
+    return const_iterator(map_.cend());
+  }
+
+ private:
+  // The hook of the entry map, which calls pruneHook on the value of
+  // entries; nullptr for the entry map to fall back on its own.
+  static typename EntryMap::PruneHookCall wrapPruneHook(
+      PruneHookCall pruneHook) {
+    if (!pruneHook) {
+      return nullptr;
+    }
+    return [pruneHook = std::move(pruneHook)](TKey key, Entry&& entry) {
+      pruneHook(std::move(key), std::move(entry.value));
+    };
+  }
+
+  static bool isExpired(const Entry& entry, TimePoint now) {
+    return entry.expiry <= now;
+  }
+
+  // Only reads the clock for the entries that expire.
+  bool hasExpiredOnRead(const Entry& entry) const {
+    return lazyExpiry_ && entry.expiry != TimePoint::max() &&
+        isExpired(entry, Clock::now());
+  }
+
+  // it, or end() if it has expired, with lazy expiry, and was erased.
+  typename EntryMap::iterator checkExpiry(typename EntryMap::iterator it) {
+    if (it != map_.end() && hasExpiredOnRead(it->second)) {
+      removeExpired(it, nullptr);
+      return map_.end();
+    }
+    return it;
+  }
+
+  // Erases the entry of it, then calls the prune hook on its contents.
+  void removeExpired(
+      typename EntryMap::iterator it,
+      PruneHookCall const& pruneHook) {
+    TKey key = it->first;
+    TValue value = std::move(it->second.value);
+    map_.erase(it);
+    auto& ph = (nullptr == pruneHook) ? pruneHook_ : pruneHook;
+    if (ph) {
+      ph(std::move(key), std::move(value));
+    }
+  }
+
+  uint64_t tickOf(TimePoint time) const {
+    return uint64_t(time.time_since_epoch() / resolution_);
+  }
+
+  WheelBucket& bucketOf(uint64_t tick) {
+    return wheel_[tick % nWheelBuckets_];
+  }
+
+  void setExpiry(EntryPair& pr, TimePoint now, Duration ttl) {
+    auto& entry = pr.second;
+    entry.wheelHook.unlink();
+    // a ttl past the end of time saturates to no expiry
+    if (ttl <= Duration::zero() || now > TimePoint::max() - ttl) {
+      entry.expiry = TimePoint::max();
+      return;
+    }
+    entry.expiry = now + ttl;
+    entry.key = &pr.first;
+    bucketOf(tickOf(entry.expiry)).push_back(entry);
+  }
+
+  // Inserts a key known to be absent, then evicts if the map is full.
+  iterator insertNew(
+      const TKey& key,
+      TValue&& value,
+      TimePoint now,
+      Duration ttl,
+      PruneHookCall const& pruneHook) {
+    auto it = map_.insert(key, Entry(std::move(value))).first;
+    setExpiry(*it, now, ttl);
+    // no evictions if maxSize_ is 0 i.e. unlimited capacity
+    if (maxSize_ > 0 && size() > maxSize_) {
+      prune(clearSize_, pruneHook);
+      // the new entry is at the head of the LRU, unless clearSize_ pruned
+      // the whole map
+      return begin();
+    }
+    return iterator(it);
+  }
+
+  // Expire when time has moved on to another bucket since the last time.
+  void maybeExpire(TimePoint now, PruneHookCall const& pruneHook) {
+    if (tickOf(now) != lastTick_) {
+      expireAt(now, pruneHook);
+    }
+  }
+
+  std::size_t expireAt(TimePoint now, PruneHookCall const& pruneHook) {
+    auto const nowTick = tickOf(now);
+    if (nowTick < lastTick_) {
+      return 0;
+    }
+    // the bucket of lastTick_ may have been filled since it was visited
+    auto const numTicks =
+        std::min<uint64_t>(nowTick - lastTick_ + 1, nWheelBuckets_);
+    auto const firstTick = nowTick + 1 - numTicks;
+    std::size_t expired = 0;
+    for (uint64_t tick = firstTick; tick <= nowTick; ++tick) {
+      auto& bucket = bucketOf(tick);
+      for (auto it = bucket.begin(); it != bucket.end();) {
+        auto& entry = *it++;
+        if (isExpired(entry, now)) {
+          // erasing the entry unlinks it from the bucket
+          removeExpired(map_.findWithoutPromotion(*entry.key), pruneHook);
+          ++expired;
+        }
+      }
+    }
+    // only once all buckets were visited, so that those after a throwing
+    // prune hook are visited by the next call
+    lastTick_ = nowTick;
+    return expired;
+  }
+
+  PruneHookCall pruneHook_;
+  std::size_t maxSize_;
+  std::size_t clearSize_;
+  Duration defaultTtl_;
+  Duration resolution_;
+  std::size_t nWheelBuckets_;
+  std::unique_ptr<WheelBucket[]> wheel_;
+  // the last tick visited by expire()
+  uint64_t lastTick_;
+  bool lazyExpiry_{true};
+  // destroyed first, which unlinks its entries from the wheel
+  EntryMap map_;
+};
+
+/**
+ * A thread-safe TimedEvictingCacheMap, made of shards selected by the hash
+ * of the key, each a TimedEvictingCacheMap behind a mutex.  The maximum
+ * size is split evenly between the shards, so the LRU order is per shard.
+ *
+ * Lookups return copies of the values.  Prune hooks are called with the
+ * lock of the shard held, and must not access the cache.
+ */
+template <
+    class TKey,
+    class TValue,
+    class THash = std::hash<TKey>,
+    class TKeyEqual = std::equal_to<TKey>,
+    class Clock = std::chrono::steady_clock>
+class ConcurrentTimedEvictingCacheMap {
+  typedef TimedEvictingCacheMap<TKey, TValue, THash, TKeyEqual, Clock> Shard;
+
+ public:
+  typedef typename Shard::PruneHookCall PruneHookCall;
+  typedef typename Shard::Duration Duration;
+
+  static constexpr std::size_t kDefaultShards = 16;
+
+  /**
+   * @param maxSize maximum size of the whole cache, 0 for no limit.
+   * @param defaultTtl as in TimedEvictingCacheMap.
+   * @param numShards the number of independently locked shards.
+   * @param resolution as in TimedEvictingCacheMap.
+   */
+  explicit ConcurrentTimedEvictingCacheMap(
+      std::size_t maxSize,
+      Duration defaultTtl = Duration::zero(),
+      std::size_t numShards = kDefaultShards,
+      Duration resolution = std::chrono::seconds(1),
+      const THash& keyHash = THash(),
+      const TKeyEqual& keyEqual = TKeyEqual())
+      : keyHash_(keyHash) {
+    numShards = std::max(numShards, std::size_t(1));
+    auto const shardSize = (maxSize + numShards - 1) / numShards;
+    shards_.reserve(numShards);
+    for (std::size_t i = 0; i < numShards; ++i) {
+      shards_.push_back(std::make_unique<Synchronized<Shard, std::mutex>>(
+          in_place,
+          shardSize,
+          defaultTtl,
+          1,
+          resolution,
+          Shard::kDefaultWheelBuckets,
+          keyHash,
+          keyEqual));
+    }
+  }
+
+  /**
+   * A copy of the value of key, promoted to the head of the LRU of its
+   * shard, or none if there is no unexpired entry for key.
+   */
+  Optional<TValue> get(const TKey& key) {
+    return shardOf(key).withLock([&](Shard& shard) -> Optional<TValue> {
+      auto it = shard.find(key);
+      if (it == shard.end()) {
+        return none;
+      }
+      return it->second;
+    });
+  }
+
+  Optional<TValue> getWithoutPromotion(const TKey& key) {
+    return shardOf(key).withLock([&](Shard& shard) -> Optional<TValue> {
+      auto it = shard.findWithoutPromotion(key);
+      if (it == shard.end()) {
+        return none;
+      }
+      return it->second;
+    });
+  }
+
+  bool exists(const TKey& key) {
+    return shardOf(key).withLock(
+        [&](Shard& shard) { return shard.exists(key); });
+  }
+
+  void set(const TKey& key, TValue value) {
+    shardOf(key).withLock(
+        [&](Shard& shard) { shard.set(key, std::move(value)); });
+  }
+
+  void set(const TKey& key, TValue value, Duration ttl) {
+    shardOf(key).withLock(
+        [&](Shard& shard) { shard.set(key, std::move(value), ttl); });
+  }
+
+  /**
+   * Insert key if there is no unexpired entry for it.
+   * @return whether the insertion took place
+   */
+  bool insert(const TKey& key, TValue value) {
+    return shardOf(key).withLock([&](Shard& shard) {
+      return shard.insert(key, std::move(value)).second;
+    });
+  }
+
+  bool insert(const TKey& key, TValue value, Duration ttl) {
+    return shardOf(key).withLock([&](Shard& shard) {
+      return shard.insert(key, std::move(value), ttl).second;
+    });
+  }
+
+  bool erase(const TKey& key) {
+    return shardOf(key).withLock(
+        [&](Shard& shard) { return shard.erase(key); });
+  }
+
+  /**
+   * Erase the expired entries of all shards, locking one at a time.
+   * @return the number of entries erased
+   */
+  std::size_t expire() {
+    std::size_t expired = 0;
+    for (auto& shard : shards_) {
+      expired += shard->lock()->expire();
+    }
+    return expired;
+  }
+
+  void clear() {
+    for (auto& shard : shards_) {
+      shard->lock()->clear();
+    }
+  }
+
+  /**
+   * The sum of the sizes of the shards, each read under its lock.
+   */
+  std::size_t size() const {
+    std::size_t result = 0;
+    for (auto& shard : shards_) {
+      result += shard->lock()->size();
+    }
+    return result;
+  }
+
+  void setPruneHook(PruneHookCall pruneHook) {
+    for (auto& shard : shards_) {
+      shard->lock()->setPruneHook(pruneHook);
+    }
+  }
+
+  void setLazyExpiry(bool lazyExpiry) {
+    for (auto& shard : shards_) {
+      shard->lock()->setLazyExpiry(lazyExpiry);
+    }
+  }
+
+ private:
+  Synchronized<Shard, std::mutex>& shardOf(const TKey& key) {
+    // remix, since the shards use the same hash for their index
+    auto const h = hash::twang_mix64(uint64_t(keyHash_(key)));
+    return *shards_[h % shards_.size()];
+  }
+
+  THash keyHash_;
+  std::vector<std::unique_ptr<Synchronized<Shard, std::mutex>>> shards_;
+};
+
+} // namespace folly
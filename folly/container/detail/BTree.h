@@ -0,0 +1,1213 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <folly/ConstexprMath.h>
+#include <folly/Portability.h>
+#include <folly/Traits.h>
+#include <folly/Utility.h>
+#include <folly/lang/Bits.h>
+#include <folly/small_vector.h>
+
+#if FOLLY_SSE >= 2
+#include <immintrin.h>
+#endif
+
+namespace folly {
+namespace detail {
+namespace btree {
+
+// Nodes are sized to take about this many bytes, i.e. 4 cache lines.
+constexpr std::size_t kNodeTargetSize = 256;
+
+// Keys are searched with SIMD compares, this many lanes at a time, when
+// they are 4 or 8 byte integers compared with std::less. Key arrays are
+// padded to a multiple of it so that the last compare stays in bounds.
+constexpr std::size_t kMaxSimdLanes = 8;
+
+template <typename Key, typename Compare>
+struct IsSimdSearchable
+    : bool_constant<
+          std::is_integral<Key>::value && !std::is_same<Key, bool>::value &&
+          (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+          (std::is_same<Compare, std::less<Key>>::value ||
+           std::is_same<Compare, std::less<void>>::value)> {};
+
+// Number of the first n keys that are greater than key if KeysGreater,
+// or less than key otherwise. keys must be readable up to a multiple
+// of kMaxSimdLanes.
+template <bool KeysGreater, typename Key>
+std::size_t simdCount(Key const* keys, std::size_t n, Key key) {
+  std::size_t count = 0;
+#if FOLLY_SSE >= 2
+  using Signed = std::make_signed_t<Key>;
+  constexpr auto kBias = std::is_signed<Key>::value
+      ? Signed(0)
+      : std::numeric_limits<Signed>::min();
+  auto biased = static_cast<Signed>(key) ^ kBias;
+  if (sizeof(Key) == 4) {
+#ifdef __AVX2__
+    auto needle = _mm256_set1_epi32(static_cast<int32_t>(biased));
+    auto bias = _mm256_set1_epi32(static_cast<int32_t>(kBias));
+    for (std::size_t i = 0; i < n; i += 8) {
+      auto v = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<__m256i const*>(keys + i)),
+          bias);
+      auto m = KeysGreater ? _mm256_cmpgt_epi32(v, needle)
+                           : _mm256_cmpgt_epi32(needle, v);
+      unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+      if (n - i < 8) {
+        mask &= (1u << (n - i)) - 1;
+      }
+      count += popcount(mask);
+    }
+#else
+    auto needle = _mm_set1_epi32(static_cast<int32_t>(biased));
+    auto bias = _mm_set1_epi32(static_cast<int32_t>(kBias));
+    for (std::size_t i = 0; i < n; i += 4) {
+      auto v = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), bias);
+      auto m = KeysGreater ? _mm_cmpgt_epi32(v, needle)
+                           : _mm_cmpgt_epi32(needle, v);
+      unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+      if (n - i < 4) {
+        mask &= (1u << (n - i)) - 1;
+      }
+      count += popcount(mask);
+    }
+#endif
+    return count;
+  }
+#if defined(__AVX2__)
+  auto needle = _mm256_set1_epi64x(static_cast<int64_t>(biased));
+  auto bias = _mm256_set1_epi64x(static_cast<int64_t>(kBias));
+  for (std::size_t i = 0; i < n; i += 4) {
+    auto v = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(keys + i)), bias);
+    auto m = KeysGreater ? _mm256_cmpgt_epi64(v, needle)
+                         : _mm256_cmpgt_epi64(needle, v);
+    unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(m));
+    if (n - i < 4) {
+      mask &= (1u << (n - i)) - 1;
+    }
+    count += popcount(mask);
+  }
+  return count;
+#elif FOLLY_SSE_PREREQ(4, 2)
+  auto needle = _mm_set1_epi64x(static_cast<int64_t>(biased));
+  auto bias = _mm_set1_epi64x(static_cast<int64_t>(kBias));
+  for (std::size_t i = 0; i < n; i += 2) {
+    auto v = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i)), bias);
+    auto m = KeysGreater ? _mm_cmpgt_epi64(v, needle)
+                         : _mm_cmpgt_epi64(needle, v);
+    unsigned mask = _mm_movemask_pd(_mm_castsi128_pd(m));
+    if (n - i < 2) {
+      mask &= 1u;
+    }
+    count += popcount(mask);
+  }
+  return count;
+#endif
+#endif
+  // branch-free, which the compiler can vectorize
+  for (std::size_t i = 0; i < n; ++i) {
+    count += KeysGreater ? keys[i] > key : keys[i] < key;
+  }
+  return count;
+}
+
+template <typename Value>
+using SlotStorage = aligned_storage_for_t<Value>;
+
+template <typename Value>
+constexpr std::size_t slotCount(std::size_t headerSize, std::size_t perSlot) {
+  return constexpr_max(
+      std::size_t(4),
+      (kNodeTargetSize > headerSize ? kNodeTargetSize - headerSize : 0) /
+          perSlot);
+}
+
+constexpr std::size_t padToLanes(std::size_t n) {
+  return (n + kMaxSimdLanes - 1) / kMaxSimdLanes * kMaxSimdLanes;
+}
+
+struct NodeBase {
+  uint16_t count{0};
+  bool leaf;
+
+  explicit NodeBase(bool isLeaf) : leaf(isLeaf) {}
+};
+
+/*
+ * The implementation of btree_map and btree_set: a B+tree whose leaves
+ * hold the values in sorted order and are linked to their neighbours,
+ * and whose inner nodes hold copies of keys, the first key of each of
+ * their children but the first, to find the leaf of a key.
+ *
+ * Nodes don't point to their parents; operations that change the tree
+ * record the path from the root to a leaf instead. Inserting in a full
+ * node splits it in two halves, and erasing from a node that gets less
+ * than half full takes a value from a sibling, or merges it with one.
+ * Separators are not updated when the first key of a node is erased,
+ * since they still separate their children.
+ *
+ * Values are moved when nodes are split or merged, so they must be
+ * nothrow move constructible.
+ */
+template <
+    typename Key,
+    typename Value,
+    typename KeyOfValue,
+    typename Compare,
+    typename Alloc>
+class BTree {
+  static_assert(
+      std::is_nothrow_move_constructible<Value>::value,
+      "btree values are moved between nodes and must not throw when moved");
+
+  using AllocTraits = std::allocator_traits<Alloc>;
+
+  struct Leaf;
+  struct Inner;
+
+  static constexpr std::size_t kLeafHeader =
+      sizeof(NodeBase) + 2 * sizeof(void*);
+  static constexpr bool kSimdSearch = IsSimdSearchable<Key, Compare>::value;
+  // leaf values are only contiguous keys in sets
+  static constexpr bool kSimdLeafSearch =
+      kSimdSearch && std::is_same<Key, Value>::value;
+
+ public:
+  static constexpr std::size_t kLeafSlots =
+      slotCount<Value>(kLeafHeader, sizeof(Value));
+  static constexpr std::size_t kInnerSlots = slotCount<Key>(
+      sizeof(NodeBase) + sizeof(void*),
+      sizeof(Key) + sizeof(void*));
+
+ private:
+  static constexpr std::size_t kMinLeafSlots = kLeafSlots / 2;
+  static constexpr std::size_t kMinInnerSlots = kInnerSlots / 2;
+
+  struct Leaf : NodeBase {
+    Leaf() : NodeBase(true) {}
+
+    Value* slot(std::size_t i) {
+      return reinterpret_cast<Value*>(&slots[i]);
+    }
+    Value const* slot(std::size_t i) const {
+      return reinterpret_cast<Value const*>(&slots[i]);
+    }
+
+    Leaf* prev{nullptr};
+    Leaf* next{nullptr};
+    SlotStorage<Value>
+        slots[kSimdLeafSearch ? padToLanes(kLeafSlots) : kLeafSlots];
+  };
+
+  struct Inner : NodeBase {
+    Inner() : NodeBase(false) {}
+
+    Key* key(std::size_t i) {
+      return reinterpret_cast<Key*>(&keys[i]);
+    }
+    Key const* key(std::size_t i) const {
+      return reinterpret_cast<Key const*>(&keys[i]);
+    }
+
+    // children[i] holds the keys in [key(i - 1), key(i))
+    NodeBase* children[kInnerSlots + 1];
+    SlotStorage<Key> keys[kSimdSearch ? padToLanes(kInnerSlots) : kInnerSlots];
+  };
+
+  using LeafAlloc = typename AllocTraits::template rebind_alloc<Leaf>;
+  using InnerAlloc = typename AllocTraits::template rebind_alloc<Inner>;
+
+  struct PathEntry {
+    Inner* node;
+    std::size_t index;
+  };
+  using Path = small_vector<PathEntry, 8>;
+
+  template <typename K>
+  using EnableHeterogeneous =
+      std::enable_if_t<is_transparent<Compare>::value, K>;
+
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = Compare;
+  using allocator_type = Alloc;
+  using reference = value_type&;
+  using const_reference = value_type const&;
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename BTree::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, Value const*, Value*>;
+    using reference = std::conditional_t<Const, Value const&, Value&>;
+
+    Iterator() = default;
+
+    template <bool C = Const, typename = std::enable_if_t<C>>
+    /* implicit */ Iterator(Iterator<false> const& other)
+        : leaf_(other.leaf_), pos_(other.pos_) {}
+
+    reference operator*() const {
+      return *leaf_->slot(pos_);
+    }
+    pointer operator->() const {
+      return leaf_->slot(pos_);
+    }
+
+    Iterator& operator++() {
+      if (++pos_ == leaf_->count && leaf_->next) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+    Iterator& operator--() {
+      if (pos_ == 0) {
+        leaf_ = leaf_->prev;
+        pos_ = leaf_->count;
+      }
+      --pos_;
+      return *this;
+    }
+    Iterator operator--(int) {
+      auto copy = *this;
+      --*this;
+      return copy;
+    }
+
+    friend bool operator==(Iterator const& a, Iterator const& b) {
+      return a.leaf_ == b.leaf_ && a.pos_ == b.pos_;
+    }
+    friend bool operator!=(Iterator const& a, Iterator const& b) {
+      return !(a == b);
+    }
+
+   private:
+    friend class BTree;
+    template <bool>
+    friend class Iterator;
+
+    Iterator(Leaf* leaf, std::size_t pos) : leaf_(leaf), pos_(pos) {}
+
+    Leaf* leaf_{nullptr};
+    std::size_t pos_{0};
+  };
+
+  using iterator = Iterator<std::is_same<Key, Value>::value>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  explicit BTree(Compare const& comp = Compare(), Alloc const& alloc = Alloc())
+      : comp_(comp), alloc_(alloc) {}
+
+  BTree(BTree const& other)
+      : comp_(other.comp_),
+        alloc_(AllocTraits::select_on_container_copy_construction(
+            other.alloc_)) {
+    bulkLoad(other.begin(), other.end(), other.size());
+  }
+
+  BTree(BTree&& other) noexcept
+      : comp_(std::move(other.comp_)), alloc_(std::move(other.alloc_)) {
+    steal(other);
+  }
+
+  BTree& operator=(BTree const& other) {
+    if (this != &other) {
+      clear();
+      comp_ = other.comp_;
+      bulkLoad(other.begin(), other.end(), other.size());
+    }
+    return *this;
+  }
+
+  BTree& operator=(BTree&& other) noexcept {
+    if (this != &other) {
+      clear();
+      comp_ = std::move(other.comp_);
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~BTree() {
+    clear();
+  }
+
+  /*
+   * Replaces the contents with those of the range, which must be
+   * sorted and without duplicate keys, in O(n): leaves are filled
+   * evenly and all nodes are built bottom up, without any search.
+   */
+  template <typename It>
+  void assignSorted(It first, It last) {
+    clear();
+    bulkLoad(first, last, std::distance(first, last));
+  }
+
+  allocator_type get_allocator() const {
+    return alloc_;
+  }
+  key_compare key_comp() const {
+    return comp_;
+  }
+
+  iterator begin() {
+    return iterator(leftmost_, 0);
+  }
+  const_iterator begin() const {
+    return const_iterator(leftmost_, 0);
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  iterator end() {
+    return iterator(rightmost_, rightmost_ ? rightmost_->count : 0);
+  }
+  const_iterator end() const {
+    return const_iterator(rightmost_, rightmost_ ? rightmost_->count : 0);
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_type size() const {
+    return size_;
+  }
+  size_type max_size() const {
+    return std::numeric_limits<size_type>::max() / sizeof(Value);
+  }
+
+  iterator find(Key const& key) {
+    return findImpl(key);
+  }
+  const_iterator find(Key const& key) const {
+    return const_cast<BTree*>(this)->findImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  iterator find(K const& key) {
+    return findImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  const_iterator find(K const& key) const {
+    return const_cast<BTree*>(this)->findImpl(key);
+  }
+
+  iterator lower_bound(Key const& key) {
+    return lowerBoundImpl(key);
+  }
+  const_iterator lower_bound(Key const& key) const {
+    return const_cast<BTree*>(this)->lowerBoundImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  iterator lower_bound(K const& key) {
+    return lowerBoundImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  const_iterator lower_bound(K const& key) const {
+    return const_cast<BTree*>(this)->lowerBoundImpl(key);
+  }
+
+  iterator upper_bound(Key const& key) {
+    return upperBoundImpl(key);
+  }
+  const_iterator upper_bound(Key const& key) const {
+    return const_cast<BTree*>(this)->upperBoundImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  iterator upper_bound(K const& key) {
+    return upperBoundImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  const_iterator upper_bound(K const& key) const {
+    return const_cast<BTree*>(this)->upperBoundImpl(key);
+  }
+
+  std::pair<iterator, iterator> equal_range(Key const& key) {
+    return equalRangeImpl(key);
+  }
+  std::pair<const_iterator, const_iterator> equal_range(Key const& key) const {
+    return const_cast<BTree*>(this)->equalRangeImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  std::pair<iterator, iterator> equal_range(K const& key) {
+    return equalRangeImpl(key);
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  std::pair<const_iterator, const_iterator> equal_range(K const& key) const {
+    return const_cast<BTree*>(this)->equalRangeImpl(key);
+  }
+
+  size_type count(Key const& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  size_type count(K const& key) const {
+    return find(key) != end() ? 1 : 0;
+  }
+
+  bool contains(Key const& key) const {
+    return find(key) != end();
+  }
+  template <typename K, EnableHeterogeneous<K>* = nullptr>
+  bool contains(K const& key) const {
+    return find(key) != end();
+  }
+
+  /*
+   * Calls f(value) on the values whose keys are in [lo, hi), in order,
+   * a leaf at a time. Stops early if f returns false.
+   */
+  template <typename F>
+  void scan(Key const& lo, Key const& hi, F&& f) const {
+    if (!root_) {
+      return;
+    }
+    auto const* leaf = findLeaf(lo, nullptr);
+    std::size_t pos = leafLowerBound(leaf, lo);
+    while (leaf) {
+      for (; pos < leaf->count; ++pos) {
+        auto const& value = *leaf->slot(pos);
+        if (!comp_(keyOf(value), hi) || !invokeScan(f, value)) {
+          return;
+        }
+      }
+      leaf = leaf->next;
+      pos = 0;
+    }
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    Value value(std::forward<Args>(args)...);
+    return insertUnique(keyOf(value), [&](Value* slot) {
+      AllocTraits::construct(alloc_, slot, std::move(value));
+    });
+  }
+
+  std::pair<iterator, bool> insert(Value const& value) {
+    return insertUnique(keyOf(value), [&](Value* slot) {
+      AllocTraits::construct(alloc_, slot, value);
+    });
+  }
+
+  std::pair<iterator, bool> insert(Value&& value) {
+    return insertUnique(keyOf(value), [&](Value* slot) {
+      AllocTraits::construct(alloc_, slot, std::move(value));
+    });
+  }
+
+  iterator insert(const_iterator /* hint */, Value const& value) {
+    return insert(value).first;
+  }
+
+  iterator insert(const_iterator /* hint */, Value&& value) {
+    return insert(std::move(value)).first;
+  }
+
+  template <typename It>
+  void insert(It first, It last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  size_type erase(Key const& key) {
+    if (!root_) {
+      return 0;
+    }
+    Path path;
+    auto leaf = findLeaf(key, &path);
+    auto pos = leafLowerBound(leaf, key);
+    if (pos == leaf->count || comp_(key, keyOf(*leaf->slot(pos)))) {
+      return 0;
+    }
+    eraseAt(leaf, pos, path);
+    return 1;
+  }
+
+  // Returns the iterator after the erased value.
+  iterator erase(const_iterator it) {
+    Key key = keyOf(*it);
+    erase(key);
+    return lower_bound(key);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    if (last == cend()) {
+      while (first != cend()) {
+        first = erase(first);
+      }
+      return end();
+    }
+    Key lastKey = keyOf(*last);
+    auto it = iterator(first.leaf_, first.pos_);
+    while (comp_(keyOf(*it), lastKey)) {
+      it = erase(it);
+    }
+    return it;
+  }
+
+  void clear() {
+    if (root_) {
+      destroyNode(root_);
+    }
+    root_ = nullptr;
+    leftmost_ = rightmost_ = nullptr;
+    size_ = 0;
+  }
+
+  void swap(BTree& other) noexcept {
+    using std::swap;
+    swap(comp_, other.comp_);
+    swapAllocators(other, typename AllocTraits::propagate_on_container_swap());
+    swap(root_, other.root_);
+    swap(leftmost_, other.leftmost_);
+    swap(rightmost_, other.rightmost_);
+    swap(size_, other.size_);
+  }
+
+  // Number of levels, 0 if empty.
+  std::size_t height() const {
+    std::size_t h = 0;
+    for (auto node = root_; node;
+         node = node->leaf ? nullptr : static_cast<Inner*>(node)->children[0]) {
+      ++h;
+    }
+    return h;
+  }
+
+ protected:
+  Alloc& alloc() {
+    return alloc_;
+  }
+
+  // Finds key, inserting a value built by construct(slot) if absent.
+  template <typename K, typename Construct>
+  std::pair<iterator, bool> insertUnique(K const& key, Construct&& construct) {
+    if (!root_) {
+      auto leaf = newLeaf();
+      root_ = leftmost_ = rightmost_ = leaf;
+    }
+    Path path;
+    auto leaf = findLeaf(key, &path);
+    auto pos = leafLowerBound(leaf, key);
+    if (pos < leaf->count && !comp_(key, keyOf(*leaf->slot(pos)))) {
+      return {iterator(leaf, pos), false};
+    }
+    if (leaf->count == kLeafSlots) {
+      auto right = splitLeaf(leaf, path);
+      if (pos > leaf->count) {
+        pos -= leaf->count;
+        leaf = right;
+      }
+    }
+    shiftRight(leaf->slot(pos), leaf->slot(leaf->count));
+    construct(leaf->slot(pos));
+    ++leaf->count;
+    ++size_;
+    return {iterator(leaf, pos), true};
+  }
+
+ private:
+  static Key const& keyOf(Value const& value) {
+    return KeyOfValue()(value);
+  }
+
+  template <typename F>
+  static bool invokeScan(F& f, Value const& value) {
+    return invokeScanImpl(f, value, std::is_void<decltype(f(value))>());
+  }
+  template <typename F>
+  static bool invokeScanImpl(F& f, Value const& value, std::true_type) {
+    f(value);
+    return true;
+  }
+  template <typename F>
+  static bool invokeScanImpl(F& f, Value const& value, std::false_type) {
+    return f(value);
+  }
+
+  void swapAllocators(BTree& other, std::true_type) {
+    using std::swap;
+    swap(alloc_, other.alloc_);
+  }
+  void swapAllocators(BTree&, std::false_type) {}
+
+  void steal(BTree& other) {
+    root_ = std::exchange(other.root_, nullptr);
+    leftmost_ = std::exchange(other.leftmost_, nullptr);
+    rightmost_ = std::exchange(other.rightmost_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  template <typename K>
+  iterator findImpl(K const& key) {
+    auto it = lowerBoundImpl(key);
+    return it != end() && !comp_(key, keyOf(*it)) ? it : end();
+  }
+
+  template <typename K>
+  iterator lowerBoundImpl(K const& key) {
+    if (!root_) {
+      return end();
+    }
+    auto leaf = findLeaf(key, nullptr);
+    return normalize(leaf, leafLowerBound(leaf, key));
+  }
+
+  template <typename K>
+  iterator upperBoundImpl(K const& key) {
+    if (!root_) {
+      return end();
+    }
+    auto leaf = findLeaf(key, nullptr);
+    return normalize(leaf, leafUpperBound(leaf, key));
+  }
+
+  template <typename K>
+  std::pair<iterator, iterator> equalRangeImpl(K const& key) {
+    auto it = findImpl(key);
+    if (it == end()) {
+      return {it, it};
+    }
+    auto next = it;
+    return {it, ++next};
+  }
+
+  iterator normalize(Leaf* leaf, std::size_t pos) {
+    if (pos == leaf->count && leaf->next) {
+      return iterator(leaf->next, 0);
+    }
+    return iterator(leaf, pos);
+  }
+
+  //////// search
+
+  // Index of the child of inner that holds key. Heterogeneous keys are
+  // compared with comp_, since converting them to Key could change their
+  // order.
+  template <typename K>
+  std::size_t childIndex(Inner const* inner, K const& key) const {
+    return childIndexImpl(
+        inner,
+        key,
+        bool_constant<kSimdSearch && std::is_same<K, Key>::value>());
+  }
+  template <typename K>
+  std::size_t childIndexImpl(Inner const* inner, K const& key, std::true_type)
+      const {
+    return inner->count - simdCount<true>(inner->key(0), inner->count, key);
+  }
+  template <typename K>
+  std::size_t childIndexImpl(Inner const* inner, K const& key, std::false_type)
+      const {
+    // upper bound
+    std::size_t lo = 0;
+    std::size_t hi = inner->count;
+    while (lo < hi) {
+      auto mid = (lo + hi) / 2;
+      if (comp_(key, *inner->key(mid))) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+
+  template <typename K>
+  std::size_t leafLowerBound(Leaf const* leaf, K const& key) const {
+    return leafLowerBoundImpl(
+        leaf,
+        key,
+        bool_constant<kSimdLeafSearch && std::is_same<K, Key>::value>());
+  }
+  template <typename K>
+  std::size_t leafLowerBoundImpl(Leaf const* leaf, K const& key, std::true_type)
+      const {
+    return simdCount<false>(
+        reinterpret_cast<Key const*>(leaf->slot(0)),
+        leaf->count,
+        key);
+  }
+  template <typename K>
+  std::size_t
+  leafLowerBoundImpl(Leaf const* leaf, K const& key, std::false_type) const {
+    std::size_t lo = 0;
+    std::size_t hi = leaf->count;
+    while (lo < hi) {
+      auto mid = (lo + hi) / 2;
+      if (comp_(keyOf(*leaf->slot(mid)), key)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  template <typename K>
+  std::size_t leafUpperBound(Leaf const* leaf, K const& key) const {
+    auto pos = leafLowerBound(leaf, key);
+    if (pos < leaf->count && !comp_(key, keyOf(*leaf->slot(pos)))) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  // Descends to the leaf that holds key, recording the path if asked.
+  template <typename K>
+  Leaf* findLeaf(K const& key, Path* path) const {
+    auto node = root_;
+    while (!node->leaf) {
+      auto inner = static_cast<Inner*>(node);
+      auto index = childIndex(inner, key);
+      if (path) {
+        path->push_back({inner, index});
+      }
+      node = inner->children[index];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  //////// node management
+
+  Leaf* newLeaf() {
+    LeafAlloc alloc(alloc_);
+    auto leaf = std::allocator_traits<LeafAlloc>::allocate(alloc, 1);
+    // padding keys are read by SIMD searches, and must be initialized
+    std::memset(static_cast<void*>(leaf), 0, sizeof(Leaf));
+    return new (leaf) Leaf();
+  }
+
+  Inner* newInner() {
+    InnerAlloc alloc(alloc_);
+    auto inner = std::allocator_traits<InnerAlloc>::allocate(alloc, 1);
+    std::memset(static_cast<void*>(inner), 0, sizeof(Inner));
+    return new (inner) Inner();
+  }
+
+  void freeLeaf(Leaf* leaf) {
+    LeafAlloc alloc(alloc_);
+    leaf->~Leaf();
+    std::allocator_traits<LeafAlloc>::deallocate(alloc, leaf, 1);
+  }
+
+  void freeInner(Inner* inner) {
+    InnerAlloc alloc(alloc_);
+    inner->~Inner();
+    std::allocator_traits<InnerAlloc>::deallocate(alloc, inner, 1);
+  }
+
+  void destroyNode(NodeBase* node) {
+    if (node->leaf) {
+      auto leaf = static_cast<Leaf*>(node);
+      for (std::size_t i = 0; i < leaf->count; ++i) {
+        AllocTraits::destroy(alloc_, leaf->slot(i));
+      }
+      freeLeaf(leaf);
+    } else {
+      auto inner = static_cast<Inner*>(node);
+      for (std::size_t i = 0; i < inner->count; ++i) {
+        inner->key(i)->~Key();
+      }
+      for (std::size_t i = 0; i <= inner->count; ++i) {
+        destroyNode(inner->children[i]);
+      }
+      freeInner(inner);
+    }
+  }
+
+  //////// moving values and keys around
+
+  void relocate(Value* dst, Value* src) {
+    AllocTraits::construct(alloc_, dst, std::move(*src));
+    AllocTraits::destroy(alloc_, src);
+  }
+
+  // keys, and children
+  template <typename T>
+  static void relocate(T* dst, T* src) {
+    new (dst) T(std::move(*src));
+    src->~T();
+  }
+
+  // Moves [first, last) to the uninitialized [dst, dst + (last - first)),
+  // which may overlap it.
+  template <typename T>
+  void relocateRange(T* first, T* last, T* dst) {
+    if (dst < first) {
+      for (; first != last; ++first, ++dst) {
+        relocate(dst, first);
+      }
+    } else {
+      dst += last - first;
+      while (last != first) {
+        relocate(--dst, --last);
+      }
+    }
+  }
+
+  // Makes room for one element at first, which is then uninitialized.
+  template <typename T>
+  void shiftRight(T* first, T* last) {
+    relocateRange(first, last, first + 1);
+  }
+
+  // Closes the uninitialized hole at first.
+  template <typename T>
+  void shiftLeft(T* first, T* last) {
+    relocateRange(first + 1, last, first);
+  }
+
+  //////// insertion
+
+  // Moves the upper half of the full leaf to a new right sibling, whose
+  // first key is inserted as separator in the parent.
+  Leaf* splitLeaf(Leaf* leaf, Path& path) {
+    auto right = newLeaf();
+    std::size_t keep = kLeafSlots / 2;
+    relocateRange(leaf->slot(keep), leaf->slot(leaf->count), right->slot(0));
+    right->count = static_cast<uint16_t>(leaf->count - keep);
+    leaf->count = static_cast<uint16_t>(keep);
+
+    right->next = leaf->next;
+    right->prev = leaf;
+    if (leaf->next) {
+      leaf->next->prev = right;
+    } else {
+      rightmost_ = right;
+    }
+    leaf->next = right;
+
+    insertSeparator(
+        path, path.size(), leaf, Key(keyOf(*right->slot(0))), right);
+    return right;
+  }
+
+  // Inserts key and its right child in the parent of child, which is
+  // path[level - 1], splitting it if it is full.
+  void insertSeparator(
+      Path& path,
+      std::size_t level,
+      NodeBase* child,
+      Key&& key,
+      NodeBase* right) {
+    if (level == 0) {
+      auto root = newInner();
+      new (root->key(0)) Key(std::move(key));
+      root->children[0] = child;
+      root->children[1] = right;
+      root->count = 1;
+      root_ = root;
+      return;
+    }
+    auto inner = path[level - 1].node;
+    auto index = path[level - 1].index;
+    if (inner->count == kInnerSlots) {
+      // The middle key moves up, and the keys and children after it
+      // move to the new right sibling.
+      auto sibling = newInner();
+      std::size_t keep = kInnerSlots / 2;
+      Key middle(std::move(*inner->key(keep)));
+      inner->key(keep)->~Key();
+      relocateRange(
+          inner->key(keep + 1), inner->key(inner->count), sibling->key(0));
+      relocateRange(
+          &inner->children[keep + 1],
+          &inner->children[inner->count + 1],
+          &sibling->children[0]);
+      sibling->count = static_cast<uint16_t>(inner->count - keep - 1);
+      inner->count = static_cast<uint16_t>(keep);
+      if (index > keep) {
+        insertInInner(sibling, index - keep - 1, std::move(key), right);
+      } else {
+        insertInInner(inner, index, std::move(key), right);
+      }
+      insertSeparator(path, level - 1, inner, std::move(middle), sibling);
+      return;
+    }
+    insertInInner(inner, index, std::move(key), right);
+  }
+
+  // Inserts key at index and right after children[index].
+  void
+  insertInInner(Inner* inner, std::size_t index, Key&& key, NodeBase* right) {
+    shiftRight(inner->key(index), inner->key(inner->count));
+    new (inner->key(index)) Key(std::move(key));
+    shiftRight(&inner->children[index + 1], &inner->children[inner->count + 1]);
+    inner->children[index + 1] = right;
+    ++inner->count;
+  }
+
+  //////// erasure
+
+  void eraseAt(Leaf* leaf, std::size_t pos, Path& path) {
+    AllocTraits::destroy(alloc_, leaf->slot(pos));
+    shiftLeft(leaf->slot(pos), leaf->slot(leaf->count));
+    --leaf->count;
+    --size_;
+    if (path.empty()) {
+      if (leaf->count == 0) {
+        clear();
+      }
+      return;
+    }
+    if (leaf->count >= kMinLeafSlots) {
+      return;
+    }
+    auto parent = path.back().node;
+    auto index = path.back().index;
+    if (index > 0) {
+      auto left = static_cast<Leaf*>(parent->children[index - 1]);
+      if (left->count > kMinLeafSlots) {
+        // take the last value of the left sibling
+        shiftRight(leaf->slot(0), leaf->slot(leaf->count));
+        relocate(leaf->slot(0), left->slot(left->count - 1));
+        --left->count;
+        ++leaf->count;
+        *parent->key(index - 1) = keyOf(*leaf->slot(0));
+        return;
+      }
+    }
+    if (index < parent->count) {
+      auto right = static_cast<Leaf*>(parent->children[index + 1]);
+      if (right->count > kMinLeafSlots) {
+        // take the first value of the right sibling
+        relocate(leaf->slot(leaf->count), right->slot(0));
+        shiftLeft(right->slot(0), right->slot(right->count));
+        --right->count;
+        ++leaf->count;
+        *parent->key(index) = keyOf(*right->slot(0));
+        return;
+      }
+      mergeLeaves(leaf, right);
+      eraseFromInner(path, path.size(), index);
+      return;
+    }
+    mergeLeaves(static_cast<Leaf*>(parent->children[index - 1]), leaf);
+    eraseFromInner(path, path.size(), index - 1);
+  }
+
+  // Moves the values of right to the end of left and frees right.
+  void mergeLeaves(Leaf* left, Leaf* right) {
+    relocateRange(
+        right->slot(0), right->slot(right->count), left->slot(left->count));
+    left->count = static_cast<uint16_t>(left->count + right->count);
+    right->count = 0;
+    left->next = right->next;
+    if (right->next) {
+      right->next->prev = left;
+    } else {
+      rightmost_ = left;
+    }
+    freeLeaf(right);
+  }
+
+  // Erases key(index) and children[index + 1], which was merged into
+  // children[index], from path[level - 1], and rebalances it.
+  void eraseFromInner(Path& path, std::size_t level, std::size_t index) {
+    auto inner = path[level - 1].node;
+    inner->key(index)->~Key();
+    shiftLeft(inner->key(index), inner->key(inner->count));
+    shiftLeft(&inner->children[index + 1], &inner->children[inner->count + 1]);
+    --inner->count;
+
+    if (level == 1) {
+      if (inner->count == 0) {
+        root_ = inner->children[0];
+        freeInner(inner);
+      }
+      return;
+    }
+    if (inner->count >= kMinInnerSlots) {
+      return;
+    }
+    auto parent = path[level - 2].node;
+    auto pindex = path[level - 2].index;
+    if (pindex > 0) {
+      auto left = static_cast<Inner*>(parent->children[pindex - 1]);
+      if (left->count > kMinInnerSlots) {
+        // rotate right through the parent's separator
+        shiftRight(inner->key(0), inner->key(inner->count));
+        shiftRight(&inner->children[0], &inner->children[inner->count + 1]);
+        relocate(inner->key(0), parent->key(pindex - 1));
+        inner->children[0] = left->children[left->count];
+        relocate(parent->key(pindex - 1), left->key(left->count - 1));
+        --left->count;
+        ++inner->count;
+        return;
+      }
+    }
+    if (pindex < parent->count) {
+      auto right = static_cast<Inner*>(parent->children[pindex + 1]);
+      if (right->count > kMinInnerSlots) {
+        // rotate left through the parent's separator
+        relocate(inner->key(inner->count), parent->key(pindex));
+        inner->children[inner->count + 1] = right->children[0];
+        relocate(parent->key(pindex), right->key(0));
+        shiftLeft(right->key(0), right->key(right->count));
+        shiftLeft(&right->children[0], &right->children[right->count + 1]);
+        --right->count;
+        ++inner->count;
+        return;
+      }
+      mergeInners(inner, parent, pindex);
+      eraseFromInner(path, level - 1, pindex);
+      return;
+    }
+    mergeInners(
+        static_cast<Inner*>(parent->children[pindex - 1]), parent, pindex - 1);
+    eraseFromInner(path, level - 1, pindex - 1);
+  }
+
+  // Appends a copy of the separator parent->key(index) and the contents
+  // of the right sibling of left to left, and frees the sibling; the
+  // caller then erases the separator from parent.
+  void mergeInners(Inner* left, Inner* parent, std::size_t index) {
+    auto right = static_cast<Inner*>(parent->children[index + 1]);
+    new (left->key(left->count)) Key(*parent->key(index));
+    relocateRange(
+        right->key(0), right->key(right->count), left->key(left->count + 1));
+    relocateRange(
+        &right->children[0],
+        &right->children[right->count + 1],
+        &left->children[left->count + 1]);
+    left->count = static_cast<uint16_t>(left->count + right->count + 1);
+    right->count = 0;
+    freeInner(right);
+  }
+
+  //////// bulk loading
+
+  template <typename It>
+  void bulkLoad(It first, It last, std::size_t n) {
+    if (n == 0) {
+      return;
+    }
+    // the leaves, and the first key of each
+    std::vector<NodeBase*> nodes;
+    std::vector<Key> firstKeys;
+    auto leaves = (n + kLeafSlots - 1) / kLeafSlots;
+    nodes.reserve(leaves);
+    firstKeys.reserve(leaves);
+    Leaf* prev = nullptr;
+    for (std::size_t i = 0; i < leaves; ++i) {
+      // spread the values evenly, so that every leaf is at least half full
+      auto count = n / leaves + (i < n % leaves ? 1 : 0);
+      auto leaf = newLeaf();
+      for (std::size_t j = 0; j < count; ++j, ++first) {
+        AllocTraits::construct(alloc_, leaf->slot(j), *first);
+        leaf->count = static_cast<uint16_t>(j + 1);
+      }
+      leaf->prev = prev;
+      if (prev) {
+        prev->next = leaf;
+      } else {
+        leftmost_ = leaf;
+      }
+      prev = leaf;
+      nodes.push_back(leaf);
+      firstKeys.push_back(keyOf(*leaf->slot(0)));
+      size_ += count;
+    }
+    rightmost_ = prev;
+
+    while (nodes.size() > 1) {
+      auto children = nodes.size();
+      auto inners = (children + kInnerSlots) / (kInnerSlots + 1);
+      std::vector<NodeBase*> parents;
+      std::vector<Key> parentKeys;
+      parents.reserve(inners);
+      parentKeys.reserve(inners);
+      std::size_t c = 0;
+      for (std::size_t i = 0; i < inners; ++i) {
+        auto count = children / inners + (i < children % inners ? 1 : 0);
+        auto inner = newInner();
+        inner->children[0] = nodes[c];
+        parentKeys.push_back(std::move(firstKeys[c]));
+        for (std::size_t j = 1; j < count; ++j) {
+          new (inner->key(j - 1)) Key(std::move(firstKeys[c + j]));
+          inner->children[j] = nodes[c + j];
+        }
+        inner->count = static_cast<uint16_t>(count - 1);
+        c += count;
+        parents.push_back(inner);
+      }
+      nodes = std::move(parents);
+      firstKeys = std::move(parentKeys);
+    }
+    root_ = nodes[0];
+  }
+
+  Compare comp_;
+  Alloc alloc_;
+  NodeBase* root_{nullptr};
+  Leaf* leftmost_{nullptr};
+  Leaf* rightmost_{nullptr};
+  std::size_t size_{0};
+};
+
+} // namespace btree
+} // namespace detail
+} // namespace folly
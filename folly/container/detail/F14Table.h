@@ -451,7 +451,7 @@ struct alignas(kRequiredVectorAlignment) F14Chunk {
   ////////
   // Tag filtering using NEON intrinsics
 
-  SparseMaskIter tagMatchIter(std::size_t needle) const {
+  MaskType tagMatchMask(std::size_t needle) const {
     FOLLY_SAFE_DCHECK(needle >= 0x80 && needle < 0x100, "");
     uint8x16_t tagV = vld1q_u8(&tags_[0]);
     auto needleV = vdupq_n_u8(static_cast<uint8_t>(needle));
@@ -459,8 +459,7 @@ struct alignas(kRequiredVectorAlignment) F14Chunk {
     // get info from every byte into the bottom half of every uint16_t
     // by shifting right 4, then round to get it into a 64-bit vector
     uint8x8_t maskV = vshrn_n_u16(vreinterpretq_u16_u8(eqV), 4);
-    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
-    return SparseMaskIter(mask);
+    return vget_lane_u64(vreinterpret_u64_u8(maskV), 0) & kFullMask;
   }
 
   MaskType occupiedMask() const {
@@ -479,7 +478,7 @@ struct alignas(kRequiredVectorAlignment) F14Chunk {
     return static_cast<TagVector const*>(static_cast<void const*>(&tags_[0]));
   }
 
-  SparseMaskIter tagMatchIter(std::size_t needle) const {
+  MaskType tagMatchMask(std::size_t needle) const {
     FOLLY_SAFE_DCHECK(needle >= 0x80 && needle < 0x100, "");
     auto tagV = _mm_load_si128(tagVector());
 
@@ -501,8 +500,7 @@ struct alignas(kRequiredVectorAlignment) F14Chunk {
     // and also happens to result in slightly more compact assembly.
     auto needleV = _mm_set1_epi8(static_cast<uint8_t>(needle));
     auto eqV = _mm_cmpeq_epi8(tagV, needleV);
-    auto mask = _mm_movemask_epi8(eqV) & kFullMask;
-    return SparseMaskIter{mask};
+    return _mm_movemask_epi8(eqV) & kFullMask;
   }
 
   MaskType occupiedMask() const {
@@ -511,6 +509,10 @@ struct alignas(kRequiredVectorAlignment) F14Chunk {
   }
 #endif
 
+  SparseMaskIter tagMatchIter(std::size_t needle) const {
+    return SparseMaskIter{tagMatchMask(needle)};
+  }
+
   DenseMaskIter occupiedIter() const {
     return DenseMaskIter{&tags_[0], occupiedMask()};
   }
@@ -876,6 +878,18 @@ struct SizeAndPackedBegin<SizeType, ItemIter, false> {
   }
 };
 
+template <typename Hasher, typename K, typename = void>
+struct HasBulkHash : std::false_type {};
+
+template <typename Hasher, typename K>
+struct HasBulkHash<
+    Hasher,
+    K,
+    void_t<decltype(std::declval<Hasher const&>().bulk_hash(
+        std::declval<K const*>(),
+        std::size_t{},
+        std::declval<std::size_t*>()))>> : std::true_type {};
+
 template <typename Policy>
 class F14Table : public Policy {
  public:
@@ -1396,6 +1410,109 @@ class F14Table : public Policy {
     return findImpl(hp, key);
   }
 
+  // Looks up keys[0], ..., keys[n - 1] and calls func(i, ItemIter) for
+  // each of them, in order.  The keys are looked up in batches, a stage
+  // at a time: their hashes are computed and first chunks prefetched,
+  // then for indirect values the value of the first tag match in each
+  // chunk is prefetched, and only then are they probed, so the cache
+  // misses of a batch overlap instead of following each other.  Tables
+  // whose chunks are small enough to stay in the cache are probed one
+  // key at a time, as the stages would only add work.
+  template <typename KeyIter, typename F>
+  void bulkFind(KeyIter keys, std::size_t n, F&& func) const {
+    FOLLY_SAFE_DCHECK(chunks_ != nullptr, "");
+    constexpr std::size_t kBatch = 16;
+    constexpr std::size_t kMinPipelinedBytes = std::size_t{1} << 20;
+    if ((chunkMask_ + 1) * sizeof(Chunk) < kMinPipelinedBytes) {
+      for (std::size_t i = 0; i < n; ++i) {
+        func(i, find(keys[i]));
+      }
+      return;
+    }
+    HashPair hps[kBatch];
+    ChunkPtr firstChunks[kBatch];
+    MaskType masks[kBatch];
+    for (std::size_t base = 0; base < n; base += kBatch) {
+      std::size_t m = std::min(kBatch, n - base);
+      std::size_t hashes[kBatch];
+      computeKeyHashes(keys + base, m, hashes, CanBulkHash<KeyIter>{});
+      for (std::size_t i = 0; i < m; ++i) {
+        hps[i] = splitHash(hashes[i]);
+        firstChunks[i] = chunks_ + (hps[i].first & chunkMask_);
+        prefetchAddr(firstChunks[i]);
+        if (sizeof(Chunk) > 64) {
+          prefetchAddr(firstChunks[i]->itemAddr(8));
+        }
+      }
+      for (std::size_t i = 0; i < m; ++i) {
+        masks[i] = firstChunks[i]->tagMatchMask(hps[i].second);
+      }
+      if (prefetchBeforeRehash()) {
+        for (std::size_t i = 0; i < m; ++i) {
+          auto hits = SparseMaskIter{masks[i]};
+          if (hits.hasNext()) {
+            this->prefetchValue(firstChunks[i]->item(hits.next()));
+          }
+        }
+      }
+      for (std::size_t i = 0; i < m; ++i) {
+        func(base + i, findWithMask(hps[i], keys[base + i], masks[i]));
+      }
+    }
+  }
+
+ private:
+  // Whether the hasher can hash the keys of a batch with one bulk_hash()
+  // call (see folly::Hash), which needs them to be contiguous.
+  template <
+      typename KeyIter,
+      typename K = remove_cvref_t<decltype(*std::declval<KeyIter>())>>
+  using CanBulkHash = bool_constant<
+      HasBulkHash<Hasher, K>::value &&
+      (std::is_pointer<KeyIter>::value ||
+       std::is_same<KeyIter, typename std::vector<K>::iterator>::value ||
+       std::is_same<KeyIter, typename std::vector<K>::const_iterator>::value)>;
+
+  template <typename KeyIter>
+  void computeKeyHashes(
+      KeyIter keys,
+      std::size_t n,
+      std::size_t* hashes,
+      std::true_type) const {
+    this->hasher().bulk_hash(std::addressof(*keys), n, hashes);
+  }
+
+  template <typename KeyIter>
+  void computeKeyHashes(
+      KeyIter keys,
+      std::size_t n,
+      std::size_t* hashes,
+      std::false_type) const {
+    for (std::size_t i = 0; i < n; ++i) {
+      hashes[i] = this->computeKeyHash(keys[i]);
+    }
+  }
+
+  // findImpl(hp, key), given the tag match mask of the first chunk
+  template <typename K>
+  FOLLY_ALWAYS_INLINE ItemIter
+  findWithMask(HashPair hp, K const& key, MaskType mask) const {
+    ChunkPtr chunk = chunks_ + (hp.first & chunkMask_);
+    auto hits = SparseMaskIter{mask};
+    while (hits.hasNext()) {
+      auto i = hits.next();
+      if (LIKELY(this->keyMatchesItem(key, chunk->item(i)))) {
+        return ItemIter{chunk, i};
+      }
+    }
+    if (LIKELY(chunk->outboundOverflowCount() == 0)) {
+      return ItemIter{};
+    }
+    // rare, probes the first chunk again
+    return findImpl(hp, key);
+  }
+
+ public:
   template <typename K>
   FOLLY_ALWAYS_INLINE ItemIter
   find(F14HashToken const& token, K const& key) const {
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***
+ *  A benchmark comparing btree_map to std::map and sorted_vector_map for
+ *  random lookups, random insertions, range scans and building from
+ *  sorted input, with maps that fit in the cache and maps that do not.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/container/BTree.h>
+#include <folly/portability/GFlags.h>
+#include <folly/sorted_vector_types.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace folly;
+
+namespace {
+
+constexpr size_t kKeys = 4096;
+
+template <typename Map>
+struct Fixture {
+  Map map;
+  std::vector<uint64_t> keys;
+
+  explicit Fixture(size_t size) {
+    std::mt19937_64 rng(size);
+    std::vector<uint64_t> all;
+    for (size_t i = 0; i < size; ++i) {
+      all.push_back(rng());
+      map[all.back()] = i;
+    }
+    // half hits, half misses
+    for (size_t i = 0; i < kKeys; ++i) {
+      keys.push_back(i % 2 ? all[rng() % size] : rng());
+    }
+  }
+};
+
+template <typename Map, size_t kSize>
+Fixture<Map>& fixture() {
+  static Fixture<Map> f(kSize);
+  return f;
+}
+
+template <typename Map, size_t kSize>
+void find(size_t iters) {
+  BenchmarkSuspender braces;
+  auto& f = fixture<Map, kSize>();
+  Map const& map = f.map;
+  braces.dismissing([&] {
+    while (iters--) {
+      size_t found = 0;
+      for (auto key : f.keys) {
+        found += map.find(key) != map.end();
+      }
+      doNotOptimizeAway(found);
+    }
+  });
+}
+
+template <typename Map, size_t kSize>
+void insert(size_t iters) {
+  BenchmarkSuspender braces;
+  std::mt19937_64 rng(kSize);
+  std::vector<uint64_t> keys(kSize);
+  for (auto& key : keys) {
+    key = rng();
+  }
+  braces.dismissing([&] {
+    while (iters--) {
+      Map map;
+      for (auto key : keys) {
+        map[key] = key;
+      }
+      doNotOptimizeAway(map.size());
+    }
+  });
+}
+
+// sums the values of 100 consecutive keys, per lookup key
+template <typename Map, size_t kSize>
+void scan(size_t iters) {
+  BenchmarkSuspender braces;
+  auto& f = fixture<Map, kSize>();
+  Map const& map = f.map;
+  braces.dismissing([&] {
+    while (iters--) {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < kKeys; i += 16) {
+        auto it = map.lower_bound(f.keys[i]);
+        for (size_t j = 0; j < 100 && it != map.end(); ++j, ++it) {
+          sum += it->second;
+        }
+      }
+      doNotOptimizeAway(sum);
+    }
+  });
+}
+
+using StdMap = std::map<uint64_t, uint64_t>;
+using SortedVectorMap = sorted_vector_map<uint64_t, uint64_t>;
+using BTreeMap = btree_map<uint64_t, uint64_t>;
+
+template <typename It>
+BTreeMap fromSorted(BTreeMap*, It first, It last) {
+  return BTreeMap(sorted_unique, first, last);
+}
+
+template <typename It>
+SortedVectorMap fromSorted(SortedVectorMap*, It first, It last) {
+  return SortedVectorMap(
+      sorted_unique, SortedVectorMap::container_type(first, last));
+}
+
+template <typename Map, size_t kSize>
+void buildSorted(size_t iters) {
+  BenchmarkSuspender braces;
+  std::vector<std::pair<uint64_t, uint64_t>> values;
+  for (size_t i = 0; i < kSize; ++i) {
+    values.emplace_back(3 * i, i);
+  }
+  braces.dismissing([&] {
+    while (iters--) {
+      auto map =
+          fromSorted(static_cast<Map*>(nullptr), values.begin(), values.end());
+      doNotOptimizeAway(map.size());
+    }
+  });
+}
+
+template <size_t kSize>
+void buildSortedStdMap(size_t iters) {
+  BenchmarkSuspender braces;
+  std::vector<std::pair<uint64_t, uint64_t>> values;
+  for (size_t i = 0; i < kSize; ++i) {
+    values.emplace_back(3 * i, i);
+  }
+  braces.dismissing([&] {
+    while (iters--) {
+      // inserting sorted input with end() as hint is linear too
+      std::map<uint64_t, uint64_t> map;
+      for (auto& value : values) {
+        map.emplace_hint(map.end(), value);
+      }
+      doNotOptimizeAway(map.size());
+    }
+  });
+}
+
+} // namespace
+
+#define BTREE_BENCHMARKS(op, size)                              \
+  BENCHMARK(op##_std_map_##size, iters) {                       \
+    op<StdMap, size>(iters);                                    \
+  }                                                             \
+  BENCHMARK_RELATIVE(op##_sorted_vector_map_##size, iters) {    \
+    op<SortedVectorMap, size>(iters);                           \
+  }                                                             \
+  BENCHMARK_RELATIVE(op##_btree_map_##size, iters) {            \
+    op<BTreeMap, size>(iters);                                  \
+  }
+
+BTREE_BENCHMARKS(find, 1000)
+BTREE_BENCHMARKS(find, 1000000)
+BENCHMARK_DRAW_LINE();
+BTREE_BENCHMARKS(scan, 1000)
+BTREE_BENCHMARKS(scan, 1000000)
+BENCHMARK_DRAW_LINE();
+BENCHMARK(insert_std_map_1000, iters) {
+  insert<StdMap, 1000>(iters);
+}
+BENCHMARK_RELATIVE(insert_btree_map_1000, iters) {
+  insert<BTreeMap, 1000>(iters);
+}
+BENCHMARK(insert_std_map_100000, iters) {
+  insert<StdMap, 100000>(iters);
+}
+BENCHMARK_RELATIVE(insert_btree_map_100000, iters) {
+  insert<BTreeMap, 100000>(iters);
+}
+BENCHMARK_DRAW_LINE();
+BENCHMARK(build_sorted_std_map_100000, iters) {
+  buildSortedStdMap<100000>(iters);
+}
+BENCHMARK_RELATIVE(build_sorted_sorted_vector_map_100000, iters) {
+  buildSorted<SortedVectorMap, 100000>(iters);
+}
+BENCHMARK_RELATIVE(build_sorted_btree_map_100000, iters) {
+  buildSorted<BTreeMap, 100000>(iters);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/BTree.h>
+
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using folly::btree_map;
+using folly::btree_set;
+
+namespace {
+
+template <typename Tree, typename Ref>
+void expectSame(Tree const& tree, Ref const& ref) {
+  // std::map holds pair<const Key, T>
+  std::vector<typename Tree::value_type> expected(ref.begin(), ref.end());
+  ASSERT_EQ(expected.size(), tree.size());
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), tree.begin()));
+  ASSERT_TRUE(std::equal(expected.rbegin(), expected.rend(), tree.rbegin()));
+}
+
+template <typename Key>
+void randomOps(std::size_t n) {
+  std::mt19937 rng(n);
+  std::uniform_int_distribution<int> dist(-int(n), int(n));
+  btree_set<Key> tree;
+  std::set<Key> ref;
+  for (std::size_t i = 0; i < 4 * n; ++i) {
+    auto key = static_cast<Key>(dist(rng));
+    if (rng() % 3 == 0) {
+      EXPECT_EQ(ref.erase(key), tree.erase(key));
+    } else {
+      EXPECT_EQ(ref.insert(key).second, tree.insert(key).second);
+    }
+    if (i % 97 == 0) {
+      expectSame(tree, ref);
+    }
+  }
+  expectSame(tree, ref);
+  for (int k = -int(n) - 1; k <= int(n) + 1; ++k) {
+    auto key = static_cast<Key>(k);
+    EXPECT_EQ(ref.count(key), tree.count(key));
+    auto lb = tree.lower_bound(key);
+    auto rlb = ref.lower_bound(key);
+    EXPECT_EQ(rlb == ref.end(), lb == tree.end());
+    if (rlb != ref.end() && lb != tree.end()) {
+      EXPECT_EQ(*rlb, *lb);
+    }
+    auto ub = tree.upper_bound(key);
+    auto rub = ref.upper_bound(key);
+    EXPECT_EQ(rub == ref.end(), ub == tree.end());
+    if (rub != ref.end() && ub != tree.end()) {
+      EXPECT_EQ(*rub, *ub);
+    }
+  }
+  while (!ref.empty()) {
+    auto key = *std::next(ref.begin(), rng() % ref.size());
+    ref.erase(key);
+    EXPECT_EQ(1, tree.erase(key));
+  }
+  EXPECT_TRUE(tree.empty());
+  EXPECT_EQ(0, tree.height());
+  EXPECT_TRUE(tree.begin() == tree.end());
+}
+
+} // namespace
+
+TEST(BTree, RandomIntSet) {
+  // exercises the SIMD searches, of leaves as well as inner nodes
+  randomOps<int32_t>(5000);
+  randomOps<uint32_t>(5000);
+  randomOps<int64_t>(5000);
+  randomOps<uint64_t>(5000);
+}
+
+TEST(BTree, RandomSmallTrees) {
+  for (std::size_t n : {1, 2, 10, 50, 200}) {
+    randomOps<int64_t>(n);
+  }
+}
+
+TEST(BTree, StringMap) {
+  btree_map<std::string, int> tree;
+  std::map<std::string, int> ref;
+  for (int i = 0; i < 3000; ++i) {
+    auto key = std::to_string(i * 7919 % 3001);
+    tree[key] = i;
+    ref[key] = i;
+  }
+  expectSame(tree, ref);
+  EXPECT_GT(tree.height(), 2);
+
+  EXPECT_EQ(ref.at("42"), tree.at("42"));
+  EXPECT_THROW(tree.at("nope"), std::out_of_range);
+  EXPECT_FALSE(tree.try_emplace("42", -1).second);
+  EXPECT_TRUE(tree.insert_or_assign("42", -1).second == false);
+  EXPECT_EQ(-1, tree.at("42"));
+  ref["42"] = -1;
+
+  // erase every other element through iterators
+  for (auto it = tree.begin(); it != tree.end();) {
+    auto key = it->first;
+    it = tree.erase(it);
+    ref.erase(key);
+    if (it != tree.end()) {
+      ++it;
+    }
+  }
+  expectSame(tree, ref);
+
+  auto first = tree.lower_bound("2");
+  auto last = tree.lower_bound("5");
+  tree.erase(first, last);
+  ref.erase(ref.lower_bound("2"), ref.lower_bound("5"));
+  expectSame(tree, ref);
+}
+
+TEST(BTree, BulkLoad) {
+  for (std::size_t n : {0, 1, 7, 100, 1000, 100000}) {
+    std::vector<std::pair<int64_t, int64_t>> values;
+    for (std::size_t i = 0; i < n; ++i) {
+      values.emplace_back(3 * i, i);
+    }
+    btree_map<int64_t, int64_t> tree(
+        folly::sorted_unique, values.begin(), values.end());
+    expectSame(tree, values);
+    for (std::size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(i, tree.at(3 * i));
+      ASSERT_EQ(0, tree.count(3 * i + 1));
+    }
+    // loaded trees stay valid when modified
+    for (std::size_t i = 0; i < n; i += 2) {
+      ASSERT_EQ(1, tree.erase(3 * i));
+    }
+    for (std::size_t i = 0; i < n; i += 3) {
+      tree.emplace(3 * i + 1, i);
+    }
+    std::map<int64_t, int64_t> ref(values.begin(), values.end());
+    for (std::size_t i = 0; i < n; i += 2) {
+      ref.erase(3 * i);
+    }
+    for (std::size_t i = 0; i < n; i += 3) {
+      ref.emplace(3 * i + 1, i);
+    }
+    expectSame(tree, ref);
+  }
+}
+
+TEST(BTree, Scan) {
+  std::vector<int> keys;
+  for (int i = 0; i < 10000; ++i) {
+    keys.push_back(2 * i);
+  }
+  btree_set<int> tree(folly::sorted_unique, keys.begin(), keys.end());
+
+  std::vector<int> seen;
+  tree.scan(101, 400, [&](int key) { seen.push_back(key); });
+  ASSERT_EQ(149, seen.size());
+  EXPECT_EQ(102, seen.front());
+  EXPECT_EQ(398, seen.back());
+
+  // stops when f returns false
+  seen.clear();
+  tree.scan(0, 20000, [&](int key) {
+    seen.push_back(key);
+    return seen.size() < 10;
+  });
+  EXPECT_EQ(10, seen.size());
+
+  seen.clear();
+  tree.scan(30000, 40000, [&](int key) { seen.push_back(key); });
+  EXPECT_TRUE(seen.empty());
+}
+
+TEST(BTree, CopyMoveSwap) {
+  btree_map<int, std::string> a;
+  for (int i = 0; i < 1000; ++i) {
+    a.emplace(i, std::to_string(i));
+  }
+  auto b = a;
+  EXPECT_TRUE(a == b);
+  b.erase(5);
+  EXPECT_TRUE(a != b);
+
+  auto c = std::move(a);
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(1000, c.size());
+  swap(b, c);
+  EXPECT_EQ(999, c.size());
+  EXPECT_EQ(1000, b.size());
+  a = c;
+  EXPECT_TRUE(a == c);
+  a = {{1, "one"}, {2, "two"}};
+  EXPECT_EQ(2, a.size());
+  EXPECT_EQ("two", a.at(2));
+}
+
+TEST(BTree, Transparent) {
+  btree_map<std::string, int, std::less<>> tree;
+  tree["abc"] = 1;
+  char const* key = "abc";
+  EXPECT_EQ(1, tree.count(key));
+  EXPECT_TRUE(tree.contains(std::string("abc")));
+  EXPECT_FALSE(tree.contains("abd"));
+}
+
+TEST(BTree, TransparentNumeric) {
+  // Keys that don't convert to int exactly are still ordered by std::less<>
+  btree_set<int, std::less<>> tree;
+  for (int i = 0; i < 2000; ++i) {
+    tree.insert(i * 2);
+  }
+  EXPECT_FALSE(tree.contains(10.5));
+  EXPECT_EQ(12, *tree.lower_bound(10.5));
+  EXPECT_EQ(12, *tree.upper_bound(10.5));
+  EXPECT_EQ(0, *tree.lower_bound(-0.5));
+  EXPECT_TRUE(tree.lower_bound(1e10) == tree.end());
+  EXPECT_EQ(3000, *tree.lower_bound(2999.5));
+}
+
+TEST(BTree, DescendingCompare) {
+  btree_set<int64_t, std::greater<int64_t>> tree;
+  std::set<int64_t, std::greater<int64_t>> ref;
+  for (int64_t i = 0; i < 2000; ++i) {
+    tree.insert(i * 37 % 2003);
+    ref.insert(i * 37 % 2003);
+  }
+  expectSame(tree, ref);
+}
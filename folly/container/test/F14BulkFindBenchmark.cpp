@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/***
+ *  A benchmark comparing F14 bulk_find() to as many calls to find(), for
+ *  tables that fit in the cache and tables that do not.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GFlags.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace folly;
+
+namespace {
+
+constexpr size_t kKeys = 4096;
+
+template <typename Map>
+struct Fixture {
+  Map map;
+  std::vector<uint64_t> keys;
+  std::vector<typename Map::const_iterator> found;
+
+  explicit Fixture(size_t size) : found(kKeys) {
+    std::mt19937_64 rng(size);
+    std::vector<uint64_t> all;
+    for (size_t i = 0; i < size; ++i) {
+      all.push_back(rng());
+      map[all.back()] = i;
+    }
+    // half hits, half misses
+    for (size_t i = 0; i < kKeys; ++i) {
+      keys.push_back(i % 2 ? all[rng() % size] : rng());
+    }
+  }
+};
+
+template <typename Map, size_t kSize>
+Fixture<Map>& fixture() {
+  static Fixture<Map> f(kSize);
+  return f;
+}
+
+template <typename Map, size_t kSize>
+void findLoop(size_t iters) {
+  BenchmarkSuspender braces;
+  auto& f = fixture<Map, kSize>();
+  Map const& map = f.map;
+  braces.dismissing([&] {
+    while (iters--) {
+      for (size_t i = 0; i < kKeys; ++i) {
+        f.found[i] = map.find(f.keys[i]);
+      }
+      doNotOptimizeAway(f.found.data());
+    }
+  });
+}
+
+template <typename Map, size_t kSize>
+void bulkFind(size_t iters) {
+  BenchmarkSuspender braces;
+  auto& f = fixture<Map, kSize>();
+  Map const& map = f.map;
+  braces.dismissing([&] {
+    while (iters--) {
+      map.bulk_find(f.keys, f.found.begin());
+      doNotOptimizeAway(f.found.data());
+    }
+  });
+}
+
+} // namespace
+
+#define BULK_FIND_BENCHMARKS(map, size)                         \
+  BENCHMARK(find_##map##_##size, iters) {                       \
+    findLoop<map<uint64_t, uint64_t>, size>(iters);             \
+  }                                                             \
+  BENCHMARK_RELATIVE(bulk_find_##map##_##size, iters) {         \
+    bulkFind<map<uint64_t, uint64_t>, size>(iters);             \
+  }
+
+BULK_FIND_BENCHMARKS(F14ValueMap, 1000)
+BULK_FIND_BENCHMARKS(F14ValueMap, 10000000)
+BENCHMARK_DRAW_LINE();
+BULK_FIND_BENCHMARKS(F14VectorMap, 1000)
+BULK_FIND_BENCHMARKS(F14VectorMap, 10000000)
+BENCHMARK_DRAW_LINE();
+BULK_FIND_BENCHMARKS(F14NodeMap, 1000)
+BULK_FIND_BENCHMARKS(F14NodeMap, 10000000)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/F14FrozenMap.h>
+
+#include <map>
+
+#include <folly/FileUtil.h>
+#include <folly/container/F14Map.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#if FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
+
+using folly::F14FrozenMap;
+using folly::test::TemporaryFile;
+
+namespace {
+struct Point {
+  int32_t x;
+  int32_t y;
+};
+} // namespace
+
+TEST(F14FrozenMap, empty) {
+  folly::F14ValueMap<uint64_t, uint64_t> map;
+  auto image = F14FrozenMap<uint64_t, uint64_t>::freeze(map);
+  F14FrozenMap<uint64_t, uint64_t> frozen{folly::StringPiece(image)};
+  EXPECT_TRUE(frozen.empty());
+  EXPECT_EQ(0, frozen.size());
+  EXPECT_FALSE(frozen.contains(0));
+  EXPECT_EQ(nullptr, frozen.get_ptr(1));
+  EXPECT_THROW(frozen.at(2), std::out_of_range);
+}
+
+template <typename Map>
+void testFreeze(std::size_t n) {
+  using Frozen = F14FrozenMap<uint32_t, Point>;
+  Map map;
+  for (uint32_t i = 0; i < n; ++i) {
+    map[i * 7] = Point{int32_t(i), -int32_t(i)};
+  }
+  auto image = Frozen::freeze(map);
+  Frozen frozen{folly::StringPiece(image)};
+  EXPECT_EQ(map.size(), frozen.size());
+  for (uint32_t i = 0; i < n * 7; ++i) {
+    auto ptr = frozen.get_ptr(i);
+    if (i % 7 == 0) {
+      ASSERT_NE(nullptr, ptr);
+      EXPECT_EQ(i / 7, ptr->x);
+      EXPECT_EQ(-int32_t(i / 7), ptr->y);
+    } else {
+      EXPECT_EQ(nullptr, ptr);
+    }
+  }
+  std::size_t visited = 0;
+  frozen.visit([&](auto const& item) {
+    EXPECT_EQ(0, item.first % 7);
+    EXPECT_EQ(item.first / 7, item.second.x);
+    ++visited;
+  });
+  EXPECT_EQ(n, visited);
+}
+
+TEST(F14FrozenMap, freeze) {
+  testFreeze<folly::F14ValueMap<uint32_t, Point>>(1);
+  testFreeze<folly::F14ValueMap<uint32_t, Point>>(12);
+  testFreeze<folly::F14ValueMap<uint32_t, Point>>(1000);
+  testFreeze<folly::F14VectorMap<uint32_t, Point>>(100000);
+  testFreeze<std::map<uint32_t, Point>>(333);
+}
+
+TEST(F14FrozenMap, collisions) {
+  // all of the keys want the same chunk
+  struct BadHasher {
+    std::size_t operator()(uint64_t) const {
+      return 0;
+    }
+  };
+  using Frozen = F14FrozenMap<uint64_t, uint64_t, BadHasher>;
+  std::map<uint64_t, uint64_t> map;
+  for (uint64_t i = 0; i < 100; ++i) {
+    map[i] = i * i;
+  }
+  auto image = Frozen::freeze(map);
+  Frozen frozen{folly::StringPiece(image)};
+  for (uint64_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * i, frozen.at(i));
+  }
+  EXPECT_FALSE(frozen.contains(100));
+}
+
+TEST(F14FrozenMap, mapped) {
+  using Frozen = F14FrozenMap<uint64_t, double>;
+  folly::F14FastMap<uint64_t, double> map;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    map[i << 20] = i / 2.0;
+  }
+  TemporaryFile file;
+  ASSERT_TRUE(folly::writeFile(Frozen::freeze(map), file.path().c_str()));
+
+  Frozen frozen{folly::MemoryMapping(file.path().c_str())};
+  // the mapping moves with the map
+  auto moved = std::move(frozen);
+  EXPECT_EQ(10000, moved.size());
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_EQ(i / 2.0, moved.at(i << 20));
+    EXPECT_FALSE(moved.contains((i << 20) + 1));
+  }
+}
+
+TEST(F14FrozenMap, invalid) {
+  folly::F14ValueMap<uint32_t, uint32_t> map{{1, 2}, {3, 4}};
+  auto image = F14FrozenMap<uint32_t, uint32_t>::freeze(map);
+  using Wrong = F14FrozenMap<uint32_t, uint64_t>;
+  EXPECT_THROW(Wrong{folly::StringPiece(image)}, std::invalid_argument);
+
+  using Frozen = F14FrozenMap<uint32_t, uint32_t>;
+  EXPECT_THROW(
+      Frozen{folly::StringPiece(image).subpiece(0, 8)}, std::invalid_argument);
+  EXPECT_THROW(
+      Frozen{folly::StringPiece(image).subpiece(0, image.size() - 1)},
+      std::invalid_argument);
+  auto corrupt = image;
+  corrupt[0] ^= 1;
+  EXPECT_THROW(Frozen{folly::StringPiece(corrupt)}, std::invalid_argument);
+}
+
+#endif // FOLLY_F14_VECTOR_INTRINSICS_AVAILABLE
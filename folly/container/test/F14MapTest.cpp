@@ -1927,6 +1927,91 @@ TEST(F14Map, containsWithPrecomputedHash) {
   testContainsWithPrecomputedHash<F14FastMap>();
 }
 
+template <template <class...> class TMap>
+void testBulkFind() {
+  TMap<int, int> m;
+  // large enough to use the pipelined lookups
+  m.reserve(1 << 18);
+  for (int i = 0; i < 1000; i += 2) {
+    m[i] = -i;
+  }
+  // spans several batches, with hits and misses, and is not a multiple
+  // of the batch size
+  std::vector<int> keys;
+  for (int i = 0; i < 101; ++i) {
+    keys.push_back((i * 37) % 1000);
+  }
+  std::vector<typename TMap<int, int>::iterator> found;
+  m.bulk_find(keys, std::back_inserter(found));
+  ASSERT_EQ(keys.size(), found.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(found[i] == m.find(keys[i]));
+  }
+
+  auto const& cm = m;
+  std::size_t visited = 0;
+  cm.bulk_visit(keys, [&](std::size_t i, auto iter) {
+    EXPECT_EQ(visited++, i);
+    if (keys[i] % 2 == 0) {
+      ASSERT_TRUE(iter != cm.end());
+      EXPECT_EQ(-keys[i], iter->second);
+    } else {
+      EXPECT_TRUE(iter == cm.end());
+    }
+  });
+  EXPECT_EQ(keys.size(), visited);
+
+  TMap<int, int> empty;
+  std::vector<typename TMap<int, int>::const_iterator> none(keys.size());
+  static_cast<TMap<int, int> const&>(empty).bulk_find(keys, none.begin());
+  for (auto iter : none) {
+    EXPECT_TRUE(iter == empty.cend());
+  }
+}
+
+TEST(F14Map, bulkFind) {
+  testBulkFind<F14ValueMap>();
+  testBulkFind<F14VectorMap>();
+  testBulkFind<F14NodeMap>();
+  testBulkFind<F14FastMap>();
+}
+
+TEST(F14ValueMap, bulkFindBulkHash) {
+  // folly::Hash hashes contiguous uint64_t keys in bulk.  The table is
+  // large enough for bulk_find() to pipeline its lookups, and the number of
+  // keys is not a multiple of its batch size.
+  constexpr uint64_t kSize = 200000;
+  F14ValueMap<uint64_t, uint64_t, folly::Hash> m;
+  for (uint64_t i = 0; i < kSize; i += 2) {
+    m[i] = i * i;
+  }
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 10007; ++i) {
+    keys.push_back((i * 7919) % kSize);
+  }
+  std::vector<F14ValueMap<uint64_t, uint64_t, folly::Hash>::iterator> found;
+  m.bulk_find(keys, std::back_inserter(found));
+  ASSERT_EQ(keys.size(), found.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(found[i] == m.find(keys[i]));
+  }
+}
+
+TEST(F14ValueMap, heterogeneousBulkFind) {
+  using Hasher = folly::transparent<folly::hasher<folly::StringPiece>>;
+  using KeyEqual = folly::transparent<std::equal_to<folly::StringPiece>>;
+
+  F14ValueMap<std::string, int, Hasher, KeyEqual> map;
+  map.emplace("hello", 1);
+  map.emplace("world", 2);
+  std::vector<StringPiece> keys{"hello"_sp, "buddy"_sp, "world"_sp};
+  std::vector<int> values;
+  map.bulk_visit(keys, [&](std::size_t, auto iter) {
+    values.push_back(iter == map.end() ? 0 : iter->second);
+  });
+  EXPECT_EQ(std::vector<int>({1, 0, 2}), values);
+}
+
 template <template <class...> class TMap>
 void testEraseIf() {
   TMap<int, int> m{{1, 1}, {2, 2}, {3, 3}, {4, 4}};
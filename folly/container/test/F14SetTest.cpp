@@ -1515,6 +1515,43 @@ TEST(F14Set, containsWithPrecomputedHash) {
   testContainsWithPrecomputedHash<F14FastSet>();
 }
 
+template <template <class...> class TSet>
+void testBulkFind() {
+  TSet<int> s;
+  // large enough to use the pipelined lookups
+  s.reserve(1 << 18);
+  for (int i = 0; i < 1000; i += 2) {
+    s.insert(i);
+  }
+  std::vector<int> keys;
+  // not a multiple of the batch size
+  for (int i = 0; i < 101; ++i) {
+    keys.push_back((i * 37) % 1000);
+  }
+  std::vector<typename TSet<int>::const_iterator> found;
+  s.bulk_find(keys, std::back_inserter(found));
+  ASSERT_EQ(keys.size(), found.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(found[i] == s.find(keys[i]));
+  }
+
+  std::size_t hits = 0;
+  s.bulk_visit(keys, [&](std::size_t i, auto iter) {
+    if (iter != s.end()) {
+      EXPECT_EQ(keys[i], *iter);
+      ++hits;
+    }
+  });
+  EXPECT_EQ(51, hits);
+}
+
+TEST(F14Set, bulkFind) {
+  testBulkFind<F14ValueSet>();
+  testBulkFind<F14NodeSet>();
+  testBulkFind<F14VectorSet>();
+  testBulkFind<F14FastSet>();
+}
+
 template <template <class...> class TSet>
 void testEraseIf() {
   TSet<int> s{1, 2, 3, 4};
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Single-threaded comparison of folly's hash maps: lookups over sizes,
+ * load factors and hit rates, and inserts, for several key and value
+ * types.  Run with --bm_regex to select a subset, e.g.
+ * --bm_regex='find_u64_u64/.*\/n=1000000/'.
+ *
+ * See ConcurrentHashMapsBenchmark.cpp for lookups from several threads.
+ */
+
+#include <folly/container/test/HashMapBenchmarkUtil.h>
+
+#include <string>
+#include <unordered_map>
+
+#include <folly/AtomicHashMap.h>
+#include <folly/AtomicUnorderedMap.h>
+#include <folly/Format.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/GFlags.h>
+
+using namespace folly;
+using namespace folly::test;
+
+namespace {
+
+template <class T>
+char const* typeName();
+template <>
+char const* typeName<uint64_t>() {
+  return "u64";
+}
+template <>
+char const* typeName<std::string>() {
+  return "str32";
+}
+template <>
+char const* typeName<Payload<64>>() {
+  return "payload64";
+}
+
+constexpr size_t kSizes[] = {1000, 1000000};
+constexpr double kLoadFactors[] = {0.5, 0.85};
+constexpr double kHitRates[] = {1.0, 0.5, 0.0};
+
+auto const emplaceInto = [](auto& map, auto const& key, auto value) {
+  map.emplace(key, std::move(value));
+};
+auto const findIn = [](auto const& map, auto const& key) {
+  return map.find(key) != map.end();
+};
+
+/*
+ * makeFor(loadFactor) returns the make(n) argument of
+ * addHashMapLookupBenchmark for that load factor.
+ */
+template <class Key, class Value, class MakeFor, class Insert, class Find>
+void addMap(char const* mapName, MakeFor makeFor, Insert insert, Find find) {
+  for (auto n : kSizes) {
+    for (auto lf : kLoadFactors) {
+      for (auto hitRate : kHitRates) {
+        addHashMapLookupBenchmark<Key, Value>(
+            __FILE__,
+            sformat(
+                "find_{}_{}/{}/n={}/lf={}%/hit={}%",
+                typeName<Key>(),
+                typeName<Value>(),
+                mapName,
+                n,
+                int(lf * 100),
+                int(hitRate * 100)),
+            n,
+            hitRate,
+            1,
+            makeFor(lf),
+            insert,
+            find);
+      }
+    }
+  }
+  for (auto n : kSizes) {
+    addHashMapInsertBenchmark<Key, Value>(
+        __FILE__,
+        sformat(
+            "insert_{}_{}/{}/n={}",
+            typeName<Key>(),
+            typeName<Value>(),
+            mapName,
+            n),
+        n,
+        makeFor(0.85),
+        insert);
+  }
+}
+
+template <class Map>
+auto makeReserved(double lf) {
+  return [lf](size_t n) {
+    auto map = std::make_unique<Map>();
+    map->reserve(size_t(n / lf));
+    return map;
+  };
+}
+
+template <class Key, class Value>
+using CountingPairAllocator = CountingAllocator<std::pair<Key const, Value>>;
+
+template <class Key, class Value>
+void addStandardMaps() {
+  using Hash = f14::DefaultHasher<Key>;
+  using Eq = f14::DefaultKeyEqual<Key>;
+  using Alloc = CountingPairAllocator<Key, Value>;
+  addMap<Key, Value>(
+      "F14ValueMap",
+      makeReserved<F14ValueMap<Key, Value, Hash, Eq, Alloc>>,
+      emplaceInto,
+      findIn);
+  addMap<Key, Value>(
+      "F14NodeMap",
+      makeReserved<F14NodeMap<Key, Value, Hash, Eq, Alloc>>,
+      emplaceInto,
+      findIn);
+  addMap<Key, Value>(
+      "F14VectorMap",
+      makeReserved<F14VectorMap<Key, Value, Hash, Eq, Alloc>>,
+      emplaceInto,
+      findIn);
+  addMap<Key, Value>(
+      "std::unordered_map",
+      makeReserved<std::unordered_map<Key, Value, Hash, Eq, Alloc>>,
+      emplaceInto,
+      findIn);
+  addMap<Key, Value>(
+      "ConcurrentHashMap",
+      [](double lf) {
+        return [lf](size_t n) {
+          using Map = ConcurrentHashMap<
+              Key,
+              Value,
+              std::hash<Key>,
+              std::equal_to<Key>,
+              CountingAllocator<uint8_t>>;
+          return std::make_unique<Map>(size_t(n / lf));
+        };
+      },
+      emplaceInto,
+      findIn);
+  addMap<Key, Value>(
+      "AtomicUnorderedInsertMap",
+      [](double lf) {
+        return [lf](size_t n) {
+          using Map = AtomicUnorderedInsertMap<
+              Key,
+              Value,
+              std::hash<Key>,
+              std::equal_to<Key>,
+              std::is_trivially_destructible<Key>::value &&
+                  std::is_trivially_destructible<Value>::value,
+              std::atomic,
+              uint32_t,
+              CountingAllocator<char>>;
+          return std::make_unique<Map>(n, float(lf));
+        };
+      },
+      emplaceInto,
+      [](auto const& map, Key const& key) {
+        return map.find(key) != map.cend();
+      });
+}
+
+// AtomicHashMap only supports integer keys.
+template <class Value>
+void addIntegerKeyMaps() {
+  addMap<uint64_t, Value>(
+      "AtomicHashMap",
+      [](double lf) {
+        return [lf](size_t n) {
+          using Map = AtomicHashMap<
+              uint64_t,
+              Value,
+              std::hash<uint64_t>,
+              std::equal_to<uint64_t>,
+              CountingAllocator<char>>;
+          typename Map::Config config;
+          config.maxLoadFactor = lf;
+          return std::make_unique<Map>(n, config);
+        };
+      },
+      [](auto& map, uint64_t key, Value value) { map.insert(key, value); },
+      findIn);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  addStandardMaps<uint64_t, uint64_t>();
+  addIntegerKeyMaps<uint64_t>();
+  addMap<uint64_t, uint64_t>(
+      "SingleWriterFixedHashMap",
+      [](double lf) {
+        return [lf](size_t n) {
+          return std::make_unique<CountedSingleWriterFixedHashMap>(
+              size_t(n / lf));
+        };
+      },
+      [](auto& map, uint64_t key, uint64_t value) { map.insert(key, value); },
+      [](auto const& map, uint64_t key) {
+        return map.find(key) != map.end();
+      });
+
+  addStandardMaps<uint64_t, Payload<64>>();
+  addIntegerKeyMaps<Payload<64>>();
+
+  addStandardMaps<std::string, uint64_t>();
+
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/*
+ * Shared driver of the hash map comparison benchmarks in
+ * folly/container/test/HashMapBenchmark.cpp (single-threaded, all maps)
+ * and folly/concurrency/test/ConcurrentHashMapsBenchmark.cpp (lookups
+ * from several threads).
+ *
+ * Each benchmark builds its map once, through CountingAllocator where the
+ * map takes an allocator, and reports the bytes allocated per entry as the
+ * "bytes/entry" counter next to the time per operation.  Memory that keys
+ * and values allocate themselves, such as the buffers of long strings, is
+ * not included.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/experimental/SingleWriterFixedHashMap.h>
+#include <folly/hash/Hash.h>
+
+namespace folly {
+namespace test {
+
+inline std::atomic<int64_t>& hashMapBenchmarkAllocatedBytes() {
+  static std::atomic<int64_t> bytes{0};
+  return bytes;
+}
+
+/*
+ * std::allocator that keeps track of the bytes it has outstanding, in
+ * hashMapBenchmarkAllocatedBytes().
+ */
+template <class T>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <class U>
+  /* implicit */ CountingAllocator(CountingAllocator<U> const&) noexcept {}
+
+  T* allocate(size_t n) {
+    hashMapBenchmarkAllocatedBytes() += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, size_t n) {
+    hashMapBenchmarkAllocatedBytes() -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(CountingAllocator const&, CountingAllocator const&) {
+    return true;
+  }
+  friend bool operator!=(CountingAllocator const&, CountingAllocator const&) {
+    return false;
+  }
+};
+
+// A value of N bytes.
+template <size_t N>
+struct Payload {
+  std::array<char, N> bytes{};
+};
+
+template <class T>
+T makeBenchmarkKey(uint64_t i);
+
+// Nonzero pseudo-random keys, below the sentinels of AtomicHashMap.
+template <>
+inline uint64_t makeBenchmarkKey<uint64_t>(uint64_t i) {
+  return (hash::twang_mix64(i) >> 1) + 1;
+}
+
+// 32 characters, which cannot be stored inline in a std::string.
+template <>
+inline std::string makeBenchmarkKey<std::string>(uint64_t i) {
+  auto key = to<std::string>(hash::twang_mix64(i));
+  key.resize(32, 'x');
+  return key;
+}
+
+template <class T>
+T makeBenchmarkValue(uint64_t i) {
+  return T(i);
+}
+
+template <>
+inline Payload<64> makeBenchmarkValue<Payload<64>>(uint64_t i) {
+  Payload<64> value;
+  value.bytes[0] = char(i);
+  return value;
+}
+
+// SingleWriterFixedHashMap allocates its slots with new[], so they are
+// accounted for here.
+class CountedSingleWriterFixedHashMap
+    : public SingleWriterFixedHashMap<uint64_t, uint64_t> {
+ public:
+  explicit CountedSingleWriterFixedHashMap(size_t capacity)
+      : SingleWriterFixedHashMap(capacity) {
+    hashMapBenchmarkAllocatedBytes() += bytes();
+  }
+  ~CountedSingleWriterFixedHashMap() {
+    hashMapBenchmarkAllocatedBytes() -= bytes();
+  }
+
+ private:
+  // the layout of a slot
+  struct Slot {
+    std::atomic<uint8_t> state;
+    uint64_t key;
+    std::atomic<uint64_t> value;
+  };
+
+  size_t bytes() const {
+    return capacity() * sizeof(Slot);
+  }
+};
+
+/*
+ * Registers a benchmark of lookups in a map of n entries, a fraction
+ * hitRate of which find their key, spread over the given number of
+ * threads.
+ *
+ * make(n) returns a std::unique_ptr to an empty map sized for n entries,
+ * insert(map, key, value) inserts into it and find(map, key) returns
+ * whether the key is in it.  The map is built the first time the benchmark
+ * runs, and kept for its later runs.
+ */
+template <class Key, class Value, class Make, class Insert, class Find>
+void addHashMapLookupBenchmark(
+    char const* file,
+    std::string const& name,
+    size_t n,
+    double hitRate,
+    size_t threads,
+    Make make,
+    Insert insert,
+    Find find) {
+  using Map = typename decltype(make(n))::element_type;
+  struct State {
+    std::unique_ptr<Map> map;
+    std::vector<Key> probes;
+    int64_t bytes = 0;
+  };
+  auto state = std::make_shared<State>();
+
+  addBenchmark(
+      file, name.c_str(), [=](UserCounters& counters, unsigned iters) {
+        BenchmarkSuspender braces;
+        if (!state->map) {
+          auto const before = hashMapBenchmarkAllocatedBytes().load();
+          state->map = make(n);
+          for (uint64_t i = 0; i < n; ++i) {
+            insert(
+                *state->map,
+                makeBenchmarkKey<Key>(i),
+                makeBenchmarkValue<Value>(i));
+          }
+          state->bytes = hashMapBenchmarkAllocatedBytes().load() - before;
+
+          size_t const numProbes = std::min<size_t>(n, size_t(1) << 16);
+          std::mt19937_64 rng(n);
+          for (size_t i = 0; i < numProbes; ++i) {
+            bool const hit =
+                std::uniform_real_distribution<>()(rng) < hitRate;
+            state->probes.push_back(makeBenchmarkKey<Key>(
+                hit ? rng() % n : n + rng() % (size_t(1) << 40)));
+          }
+        }
+        if (state->bytes > 0) {
+          counters["bytes/entry"] = state->bytes / int64_t(n);
+        }
+
+        auto const& map = *state->map;
+        auto const& probes = state->probes;
+        auto work = [&](size_t begin, size_t end) {
+          size_t found = 0;
+          for (size_t i = begin; i < end; ++i) {
+            found += find(map, probes[i % probes.size()]);
+          }
+          doNotOptimizeAway(found);
+        };
+        braces.dismissing([&] {
+          if (threads == 1) {
+            work(0, iters);
+            return;
+          }
+          std::vector<std::thread> workers;
+          for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back(
+                work, iters * t / threads, iters * (t + 1) / threads);
+          }
+          for (auto& worker : workers) {
+            worker.join();
+          }
+        });
+        return iters;
+      });
+}
+
+/*
+ * Registers a benchmark of inserting n entries into an empty map made
+ * with make(n); time is per insert.
+ */
+template <class Key, class Value, class Make, class Insert>
+void addHashMapInsertBenchmark(
+    char const* file,
+    std::string const& name,
+    size_t n,
+    Make make,
+    Insert insert) {
+  auto keys = std::make_shared<std::vector<Key>>();
+  addBenchmark(
+      file, name.c_str(), [=](UserCounters& counters, unsigned iters) {
+        BenchmarkSuspender braces;
+        if (keys->empty()) {
+          for (uint64_t i = 0; i < n; ++i) {
+            keys->push_back(makeBenchmarkKey<Key>(i));
+          }
+        }
+        size_t done = 0;
+        while (done < iters) {
+          auto const before = hashMapBenchmarkAllocatedBytes().load();
+          auto map = make(n);
+          size_t const batch = std::min<size_t>(n, iters - done);
+          braces.dismissing([&] {
+            for (size_t i = 0; i < batch; ++i) {
+              insert(*map, (*keys)[i], makeBenchmarkValue<Value>(i));
+            }
+          });
+          auto const bytes = hashMapBenchmarkAllocatedBytes().load() - before;
+          if (bytes > 0) {
+            counters["bytes/entry"] = bytes / int64_t(batch);
+          }
+          done += batch;
+        }
+        return iters;
+      });
+}
+
+} // namespace test
+} // namespace folly
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/SoaVector.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include <folly/portability/GTest.h>
+
+using folly::small_soa_vector;
+using folly::soa_vector;
+
+TEST(SoaVector, basic) {
+  soa_vector<int, std::string, double> v;
+  EXPECT_TRUE(v.empty());
+  v.emplace_back(1, "one", 1.5);
+  v.push_back(std::make_tuple(2, std::string("two"), 2.5));
+  auto ref = v.emplace_back(3, "three", 3.5);
+  EXPECT_EQ(3, std::get<0>(ref));
+
+  ASSERT_EQ(3, v.size());
+  EXPECT_EQ(1, std::get<0>(v[0]));
+  EXPECT_EQ("two", std::get<1>(v[1]));
+  EXPECT_EQ(3.5, std::get<2>(v.back()));
+  EXPECT_EQ("one", std::get<1>(v.front()));
+
+  // references are proxies to the columns
+  std::get<1>(v[2]) = "THREE";
+  EXPECT_EQ("THREE", v.column<1>()[2]);
+  EXPECT_THROW(v.at(3), std::out_of_range);
+
+  auto ints = v.column<0>();
+  EXPECT_EQ(6, std::accumulate(ints.begin(), ints.end(), 0));
+  for (auto& d : v.column<2>()) {
+    d *= 2;
+  }
+  EXPECT_EQ(5.0, std::get<2>(v[1]));
+
+  v.pop_back();
+  EXPECT_EQ(2, v.size());
+  EXPECT_EQ(2, v.column<1>().size());
+  v.clear();
+  EXPECT_TRUE(v.empty());
+}
+
+TEST(SoaVector, iterators) {
+  soa_vector<int, int> v;
+  for (int i = 0; i < 100; ++i) {
+    v.emplace_back(i, -i);
+  }
+  int expected = 0;
+  for (auto [a, b] : v) {
+    EXPECT_EQ(expected, a);
+    EXPECT_EQ(-expected, b);
+    ++expected;
+  }
+  EXPECT_EQ(100, expected);
+  EXPECT_EQ(100, v.end() - v.begin());
+
+  for (auto it = v.begin(); it != v.end(); ++it) {
+    std::get<1>(*it) = 2 * std::get<0>(*it);
+  }
+  auto const& cv = v;
+  soa_vector<int, int>::const_iterator cit = v.begin() + 10;
+  EXPECT_EQ(20, std::get<1>(*cit));
+  EXPECT_EQ(30, std::get<1>(cit[5]));
+  EXPECT_TRUE(cit < cv.end());
+
+  auto it = std::find_if(v.begin(), v.end(), [](auto const& r) {
+    return std::get<0>(r) == 50;
+  });
+  EXPECT_EQ(50, it - v.begin());
+}
+
+TEST(SoaVector, erase) {
+  soa_vector<int, std::unique_ptr<int>> v;
+  for (int i = 0; i < 10; ++i) {
+    v.emplace_back(i, std::make_unique<int>(i));
+  }
+  auto it = v.erase(v.begin() + 2, v.begin() + 5);
+  EXPECT_EQ(2, it - v.begin());
+  it = v.erase(v.begin());
+  EXPECT_EQ(v.begin(), it);
+  ASSERT_EQ(6, v.size());
+  int expected[] = {1, 5, 6, 7, 8, 9};
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(expected[i], v.column<0>()[i]);
+    EXPECT_EQ(expected[i], *std::get<1>(v[i]));
+  }
+}
+
+TEST(SoaVector, inlineCapacity) {
+  small_soa_vector<4, int, char> v;
+  EXPECT_GE(v.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    v.emplace_back(i, char('a' + i));
+  }
+  EXPECT_EQ('d', v.column<1>()[3]);
+  for (int i = 4; i < 100; ++i) {
+    v.emplace_back(i, char('a' + i % 26));
+  }
+  EXPECT_EQ(99, v.column<0>().back());
+  EXPECT_GE(v.capacity(), 100);
+
+  auto copy = v;
+  EXPECT_EQ(v, copy);
+  std::get<0>(copy[0]) = -1;
+  EXPECT_NE(v, copy);
+  swap(v, copy);
+  EXPECT_EQ(-1, std::get<0>(v[0]));
+  EXPECT_EQ(0, std::get<0>(copy[0]));
+}
+
+TEST(SoaVector, resize) {
+  soa_vector<int, std::string> v(3);
+  EXPECT_EQ(0, std::get<0>(v[2]));
+  EXPECT_EQ("", std::get<1>(v[2]));
+  v.reserve(10);
+  EXPECT_GE(v.capacity(), 10);
+  v.resize(1);
+  EXPECT_EQ(1, v.column<1>().size());
+
+  soa_vector<int, std::string> w{{1, "a"}, {2, "b"}};
+  EXPECT_EQ(2, w.size());
+  EXPECT_EQ("b", std::get<1>(w[1]));
+}
+
+namespace {
+struct Thrower {
+  Thrower() = default;
+  explicit Thrower(bool fail) {
+    if (fail) {
+      throw std::runtime_error("fail");
+    }
+  }
+};
+} // namespace
+
+TEST(SoaVector, exceptionSafety) {
+  soa_vector<std::string, Thrower, int> v;
+  v.emplace_back("a", false, 1);
+  EXPECT_THROW(v.emplace_back("b", true, 2), std::runtime_error);
+  EXPECT_EQ(1, v.size());
+  EXPECT_EQ(1, v.column<0>().size());
+  EXPECT_EQ(1, v.column<1>().size());
+  EXPECT_EQ(1, v.column<2>().size());
+  EXPECT_EQ("a", std::get<0>(v[0]));
+}
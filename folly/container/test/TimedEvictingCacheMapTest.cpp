@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/container/TimedEvictingCacheMap.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct FakeClock {
+  using duration = std::chrono::milliseconds;
+  using rep = duration::rep;
+  using period = duration::period;
+  using time_point = std::chrono::time_point<FakeClock>;
+  static constexpr bool is_steady = true;
+
+  static time_point now() {
+    return time_point(duration(nowMs));
+  }
+  static void advance(duration d) {
+    nowMs += d.count();
+  }
+
+  static rep nowMs;
+};
+
+FakeClock::rep FakeClock::nowMs = 1000000;
+
+using Map = TimedEvictingCacheMap<
+    int,
+    int,
+    std::hash<int>,
+    std::equal_to<int>,
+    FakeClock>;
+
+} // namespace
+
+TEST(TimedEvictingCacheMap, SanityTest) {
+  Map map(0);
+  EXPECT_TRUE(map.empty());
+  map.set(1, 1);
+  map.set(2, 2);
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(1, map.get(1));
+  EXPECT_TRUE(map.exists(2));
+  EXPECT_EQ(none, map.getExpiry(3));
+  EXPECT_EQ(FakeClock::time_point::max(), *map.getExpiry(1));
+
+  // without a ttl, entries never expire
+  FakeClock::advance(1h);
+  EXPECT_EQ(0, map.expire());
+  EXPECT_EQ(2, map.get(2));
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.erase(1));
+  EXPECT_THROW(map.get(1), std::out_of_range);
+}
+
+TEST(TimedEvictingCacheMap, LruEviction) {
+  Map map(3, 1h);
+  std::vector<int> pruned;
+  map.setPruneHook([&](int key, int&&) { pruned.push_back(key); });
+  for (int i = 0; i < 3; ++i) {
+    map.set(i, i);
+  }
+  map.get(0);
+  map.set(3, 3);
+  EXPECT_EQ(std::vector<int>{1}, pruned);
+  EXPECT_EQ(3, map.size());
+  EXPECT_FALSE(map.exists(1));
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(4, pruned.size());
+}
+
+TEST(TimedEvictingCacheMap, Expire) {
+  Map map(0, 10s);
+  std::vector<int> pruned;
+  map.setPruneHook([&](int key, int&& value) {
+    EXPECT_EQ(key, value);
+    pruned.push_back(key);
+  });
+  map.set(1, 1);
+  map.set(2, 2, FakeClock::duration(30s));
+  map.set(3, 3, FakeClock::duration::zero());
+  EXPECT_EQ(FakeClock::now() + 30s, *map.getExpiry(2));
+
+  FakeClock::advance(5s);
+  EXPECT_EQ(0, map.expire());
+  FakeClock::advance(5s);
+  EXPECT_EQ(1, map.expire());
+  EXPECT_EQ(std::vector<int>{1}, pruned);
+  EXPECT_EQ(2, map.size());
+
+  FakeClock::advance(30s);
+  EXPECT_EQ(1, map.expire());
+  EXPECT_EQ((std::vector<int>{1, 2}), pruned);
+  EXPECT_EQ(1, map.size());
+  EXPECT_TRUE(map.exists(3));
+}
+
+TEST(TimedEvictingCacheMap, ExpireOnMutation) {
+  Map map(0, 1s);
+  for (int i = 0; i < 100; ++i) {
+    map.set(i, i);
+  }
+  FakeClock::advance(2s);
+  // moving on to another bucket of the wheel collects expired entries
+  map.set(1000, 1000);
+  EXPECT_EQ(1, map.size());
+}
+
+TEST(TimedEvictingCacheMap, ResetTtl) {
+  Map map(0, 10s);
+  map.set(1, 1);
+  FakeClock::advance(8s);
+  map.set(1, 2);
+  FakeClock::advance(8s);
+  EXPECT_EQ(0, map.expire());
+  EXPECT_EQ(2, map.get(1));
+  FakeClock::advance(2s);
+  EXPECT_EQ(1, map.expire());
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TimedEvictingCacheMap, LongTtl) {
+  // 4 buckets of 1s: the ttl spans several revolutions of the wheel
+  Map map(0, 10s, 1, 1s, 4);
+  map.set(1, 1);
+  for (int i = 0; i < 9; ++i) {
+    FakeClock::advance(1s);
+    EXPECT_EQ(0, map.expire());
+  }
+  FakeClock::advance(1s);
+  EXPECT_EQ(1, map.expire());
+
+  // expire() after a long pause visits each bucket once
+  map.set(2, 2);
+  FakeClock::advance(1h);
+  EXPECT_EQ(1, map.expire());
+}
+
+TEST(TimedEvictingCacheMap, HugeTtl) {
+  Map map(0);
+  // now + ttl would overflow: the entry does not expire
+  map.set(1, 1, FakeClock::duration::max());
+  EXPECT_EQ(FakeClock::time_point::max(), *map.getExpiry(1));
+  FakeClock::advance(1h);
+  EXPECT_EQ(0, map.expire());
+  EXPECT_EQ(1, map.get(1));
+}
+
+TEST(TimedEvictingCacheMap, ThrowingPruneHook) {
+  Map map(0, 1s);
+  map.set(1, 1);
+  map.set(2, 2);
+  FakeClock::advance(3s);
+  bool fail = true;
+  map.setPruneHook([&](int, int&&) {
+    if (fail) {
+      throw std::runtime_error("prune");
+    }
+  });
+  EXPECT_THROW(map.expire(), std::runtime_error);
+  EXPECT_EQ(1, map.size());
+  // the buckets left by the failed call are visited again
+  fail = false;
+  EXPECT_EQ(1, map.expire());
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TimedEvictingCacheMap, LazyExpiry) {
+  Map map(0, 10s, 1, 1min);
+  map.set(1, 1);
+  map.set(2, 2);
+  FakeClock::advance(10s);
+  EXPECT_FALSE(map.exists(1));
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(map.end(), map.find(1));
+  // the non-const lookup erased it
+  EXPECT_EQ(1, map.size());
+
+  map.setLazyExpiry(false);
+  EXPECT_TRUE(map.exists(2));
+  EXPECT_EQ(2, map.get(2));
+  map.setLazyExpiry(true);
+  EXPECT_THROW(map.getWithoutPromotion(2), std::out_of_range);
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TimedEvictingCacheMap, InsertOverExpired) {
+  Map map(0, 10s);
+  EXPECT_TRUE(map.insert(1, 1).second);
+  EXPECT_FALSE(map.insert(1, 2).second);
+  EXPECT_EQ(1, map.get(1));
+  FakeClock::advance(10s);
+  auto result = map.insert(1, 3);
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(3, result.first->second);
+  EXPECT_EQ(3, map.get(1));
+}
+
+TEST(ConcurrentTimedEvictingCacheMap, Basic) {
+  ConcurrentTimedEvictingCacheMap<
+      int,
+      std::string,
+      std::hash<int>,
+      std::equal_to<int>,
+      FakeClock>
+      map(0, 10s, 4);
+  map.set(1, "one");
+  EXPECT_TRUE(map.insert(2, "two", 20s));
+  EXPECT_FALSE(map.insert(2, "deux"));
+  EXPECT_EQ("one", *map.get(1));
+  EXPECT_EQ("two", *map.getWithoutPromotion(2));
+  EXPECT_EQ(none, map.get(3));
+  EXPECT_EQ(2, map.size());
+
+  FakeClock::advance(10s);
+  EXPECT_FALSE(map.exists(1));
+  EXPECT_EQ(1, map.expire());
+  EXPECT_EQ(1, map.size());
+  EXPECT_TRUE(map.erase(2));
+  EXPECT_EQ(0, map.size());
+}
+
+TEST(ConcurrentTimedEvictingCacheMap, Threads) {
+  ConcurrentTimedEvictingCacheMap<int, int> map(1000);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 10000; ++i) {
+        int key = (i * 4 + t) % 2000;
+        map.set(key, key);
+        auto value = map.get(key);
+        if (value) {
+          EXPECT_EQ(key, *value);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(map.size(), 1000 + 16);
+}
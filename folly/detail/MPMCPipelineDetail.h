@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+
 #include <folly/MPMCQueue.h>
+#include <folly/lang/Align.h>
 
 namespace folly {
 
@@ -62,6 +66,17 @@ class MPMCPipelineStageImpl {
   /* implicit */ MPMCPipelineStageImpl(size_t capacity) : queue_(capacity) {}
   MPMCPipelineStageImpl() {}
 
+  MPMCPipelineStageImpl(MPMCPipelineStageImpl&& other) noexcept
+      : queue_(std::move(other.queue_)) {
+    counters_.copyFrom(other.counters_);
+  }
+
+  MPMCPipelineStageImpl& operator=(MPMCPipelineStageImpl&& other) noexcept {
+    queue_ = std::move(other.queue_);
+    counters_.copyFrom(other.counters_);
+    return *this;
+  }
+
   // only use on first stage, uses queue_.pushTicket_ instead of existing
   // ticket
   template <class... Args>
@@ -74,14 +89,28 @@ class MPMCPipelineStageImpl {
     return queue_.write(std::forward<Args>(args)...);
   }
 
+  // Only the time spent blocked is measured, so the fast paths don't
+  // read the clock.
   template <class... Args>
   void blockingWriteWithTicket(uint64_t ticket, Args&&... args) noexcept {
-    queue_.enqueueWithTicket(ticket, std::forward<Args>(args)...);
+    if (queue_.mayEnqueueWithTicket(ticket)) {
+      queue_.enqueueWithTicket(ticket, std::forward<Args>(args)...);
+    } else {
+      auto const start = std::chrono::steady_clock::now();
+      queue_.enqueueWithTicket(ticket, std::forward<Args>(args)...);
+      addWaitSince(counters_.writeWaitNanos, start);
+    }
+    counters_.writes.fetch_add(1, std::memory_order_relaxed);
   }
 
   uint64_t blockingRead(T& elem) noexcept {
     uint64_t ticket;
+    if (queue_.readAndGetTicket(ticket, elem)) {
+      return ticket;
+    }
+    auto const start = std::chrono::steady_clock::now();
     queue_.blockingReadWithTicket(ticket, elem);
+    addWaitSince(counters_.readWaitNanos, start);
     return ticket;
   }
 
@@ -103,8 +132,52 @@ class MPMCPipelineStageImpl {
     return queue_.readCount();
   }
 
+  // Number of elements written with a ticket, by the previous stage
+  uint64_t ticketWriteCount() const noexcept {
+    return counters_.writes.load(std::memory_order_relaxed);
+  }
+
+  // Time spent blocked in blockingRead()
+  std::chrono::nanoseconds readWait() const noexcept {
+    return std::chrono::nanoseconds(
+        counters_.readWaitNanos.load(std::memory_order_relaxed));
+  }
+
+  // Time spent blocked in blockingWriteWithTicket()
+  std::chrono::nanoseconds writeWait() const noexcept {
+    return std::chrono::nanoseconds(
+        counters_.writeWaitNanos.load(std::memory_order_relaxed));
+  }
+
  private:
+  struct Counters {
+    std::atomic<uint64_t> writes{0};
+    std::atomic<uint64_t> readWaitNanos{0};
+    std::atomic<uint64_t> writeWaitNanos{0};
+
+    void copyFrom(const Counters& other) noexcept {
+      for (auto p : {&Counters::writes,
+                     &Counters::readWaitNanos,
+                     &Counters::writeWaitNanos}) {
+        (this->*p).store(
+            (other.*p).load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+      }
+    }
+  };
+
+  static void addWaitSince(
+      std::atomic<uint64_t>& counter,
+      std::chrono::steady_clock::time_point start) noexcept {
+    auto const wait = std::chrono::steady_clock::now() - start;
+    counter.fetch_add(
+        uint64_t(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count()),
+        std::memory_order_relaxed);
+  }
+
   MPMCQueue<T> queue_;
+  alignas(hardware_destructive_interference_size) Counters counters_;
 };
 
 // Product of amplifications of a tuple of PipelineStageInfo<X>
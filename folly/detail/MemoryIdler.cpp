@@ -38,6 +38,18 @@ namespace detail {
 AtomicStruct<std::chrono::steady_clock::duration>
     MemoryIdler::defaultIdleTimeout(std::chrono::seconds(5));
 
+namespace {
+std::atomic<uint64_t> mallocCacheFlushes{0};
+std::atomic<uint64_t> stackBytesReleased{0};
+} // namespace
+
+MemoryIdler::Stats MemoryIdler::getStats() {
+  Stats stats;
+  stats.mallocCacheFlushes = mallocCacheFlushes.load(std::memory_order_relaxed);
+  stats.stackBytesReleased = stackBytesReleased.load(std::memory_order_relaxed);
+  return stats;
+}
+
 void MemoryIdler::flushLocalMallocCaches() {
   if (!usingJEMalloc()) {
     return;
@@ -49,7 +61,9 @@ void MemoryIdler::flushLocalMallocCaches() {
 
   try {
     // Not using mallctlCall as this will fail if tcache is disabled.
-    mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+    if (mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0) == 0) {
+      mallocCacheFlushes.fetch_add(1, std::memory_order_relaxed);
+    }
 
     // By default jemalloc has 4 arenas per cpu, and then assigns each
     // thread to one of those arenas.  This means that in any service
@@ -178,9 +192,19 @@ void MemoryIdler::unmapUnusedStack(size_t retain) {
     return;
   }
 
-  size_t len = end - tls_stackLimit;
-  assert((len & (pageSize() - 1)) == 0);
-  if (madvise((void*)tls_stackLimit, len, MADV_DONTNEED) != 0) {
+  releasePages((void*)tls_stackLimit, end - tls_stackLimit);
+}
+
+size_t MemoryIdler::releasePages(void* addr, size_t len) {
+  auto mask = pageSize() - 1;
+  auto begin = (reinterpret_cast<uintptr_t>(addr) + mask) & ~mask;
+  auto end = (reinterpret_cast<uintptr_t>(addr) + len) & ~mask;
+  if (end <= begin) {
+    return 0;
+  }
+
+  len = end - begin;
+  if (madvise((void*)begin, len, MADV_DONTNEED) != 0) {
     // It is likely that the stack vma hasn't been fully grown.  In this
     // case madvise will apply dontneed to the present vmas, then return
     // errno of ENOMEM.
@@ -191,13 +215,22 @@ void MemoryIdler::unmapUnusedStack(size_t retain) {
     // We can also get an EAGAIN, theoretically.
     PLOG_IF(WARNING, kIsDebug && errno == EINVAL) << "madvise failed";
     assert(errno == EAGAIN || errno == ENOMEM || errno == EINVAL);
+    if (errno != ENOMEM) {
+      return 0;
+    }
   }
+  stackBytesReleased.fetch_add(len, std::memory_order_relaxed);
+  return len;
 }
 
 #else
 
 void MemoryIdler::unmapUnusedStack(size_t /* retain */) {}
 
+size_t MemoryIdler::releasePages(void* /* addr */, size_t /* len */) {
+  return 0;
+}
+
 #endif
 
 } // namespace detail
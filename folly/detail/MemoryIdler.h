@@ -56,6 +56,24 @@ struct MemoryIdler {
   /// faults will occur during the next retain bytes of stack allocation
   static void unmapUnusedStack(size_t retain = kDefaultStackToRetain);
 
+  /// Uses madvise to discard the whole pages within [addr, addr + len),
+  /// which must hold no useful data, e.g. the stack of a fiber that isn't
+  /// running.  The pages read as zero when next touched.  Returns the
+  /// number of bytes discarded.
+  static size_t releasePages(void* addr, size_t len);
+
+  /// Process-wide counts of the memory returned to the system, for export
+  /// as counters.  Bytes freed from thread caches aren't known without
+  /// malloc stats, so only the flushes are counted.
+  struct Stats {
+    /// Calls to flushLocalMallocCaches() that flushed a thread cache
+    uint64_t mallocCacheFlushes{0};
+    /// Bytes of thread and fiber stacks discarded with madvise
+    uint64_t stackBytesReleased{0};
+  };
+
+  static Stats getStats();
+
   /// The system-wide default for the amount of time a blocking
   /// thread should wait before reclaiming idle memory.  Set this to
   /// Duration::max() to never wait.  The default value is 5 seconds.
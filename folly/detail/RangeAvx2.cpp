@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/detail/RangeAvx2.h>
+
+#include <folly/Portability.h>
+#include <folly/detail/RangeSse42.h>
+
+#if !(FOLLY_X64 && !defined(_MSC_VER))
+namespace folly {
+namespace detail {
+size_t qfind_first_byte_of_avx2(
+    const StringPieceLite haystack,
+    const StringPieceLite needles) {
+  return qfind_first_byte_of_sse42(haystack, needles);
+}
+} // namespace detail
+} // namespace folly
+#else
+#include <cstdint>
+#include <string>
+
+#include <immintrin.h>
+
+namespace folly {
+namespace detail {
+
+// Compare 32 bytes of haystack against each needle, which is broadcast to
+// every lane, and return the mask of matching bytes.
+template <size_t N>
+FOLLY_TARGET_ATTRIBUTE("avx2")
+static inline uint32_t matchBlock(const char* block, const __m256i* needles) {
+  auto const data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  auto eq = _mm256_cmpeq_epi8(data, needles[0]);
+  for (size_t j = 1; j < N; ++j) {
+    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(data, needles[j]));
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+}
+
+// haystack.size() >= 32 and needles.size() == N
+template <size_t N>
+FOLLY_TARGET_ATTRIBUTE("avx2")
+static size_t qfind_first_byte_of_needlesN(
+    const StringPieceLite haystack,
+    const StringPieceLite needles) {
+  __m256i broadcast[N];
+  for (size_t j = 0; j < N; ++j) {
+    broadcast[j] = _mm256_set1_epi8(needles[j]);
+  }
+
+  size_t i = 0;
+  for (; i + 32 <= haystack.size(); i += 32) {
+    auto const mask = matchBlock<N>(haystack.data() + i, broadcast);
+    if (mask != 0) {
+      return i + size_t(__builtin_ctz(mask));
+    }
+  }
+  if (i < haystack.size()) {
+    // The last block overlaps the previous one, which didn't match, so its
+    // first match is still the first in haystack.
+    i = haystack.size() - 32;
+    auto const mask = matchBlock<N>(haystack.data() + i, broadcast);
+    if (mask != 0) {
+      return i + size_t(__builtin_ctz(mask));
+    }
+  }
+  return std::string::npos;
+}
+
+size_t qfind_first_byte_of_avx2(
+    const StringPieceLite haystack,
+    const StringPieceLite needles) {
+  // pcmpestri compares a block against up to 16 needles at once, which wins
+  // once there are more than a few needles; short haystacks aren't worth a
+  // vector load at all.
+  if (haystack.size() < 32 || needles.size() > kQfindAvx2MaxNeedles) {
+    return qfind_first_byte_of_sse42(haystack, needles);
+  }
+  static_assert(kQfindAvx2MaxNeedles == 4, "");
+  switch (needles.size()) {
+    case 0:
+      return std::string::npos;
+    case 1:
+      return qfind_first_byte_of_needlesN<1>(haystack, needles);
+    case 2:
+      return qfind_first_byte_of_needlesN<2>(haystack, needles);
+    case 3:
+      return qfind_first_byte_of_needlesN<3>(haystack, needles);
+    default:
+      return qfind_first_byte_of_needlesN<4>(haystack, needles);
+  }
+}
+
+} // namespace detail
+} // namespace folly
+#endif
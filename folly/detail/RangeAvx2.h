@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <folly/detail/RangeCommon.h>
+
+namespace folly {
+
+namespace detail {
+
+/**
+ * Find the first byte of haystack which is one of needles with AVX2, for up
+ * to kQfindAvx2MaxNeedles needles. Larger needle sets use
+ * qfind_first_byte_of_sse42(). Only call this if CpuId().avx2().
+ */
+size_t qfind_first_byte_of_avx2(
+    const StringPieceLite haystack,
+    const StringPieceLite needles);
+
+constexpr size_t kQfindAvx2MaxNeedles = 4;
+
+} // namespace detail
+} // namespace folly
@@ -21,11 +21,13 @@
 #include <folly/Portability.h>
 
 //  Essentially, two versions of this file: one with an SSE42 implementation
-//  and one with a fallback implementation. We determine which version to use by
-//  testing for the presence of the required headers.
+//  and one with a fallback implementation. On x86-64 with GCC or Clang the
+//  SSE42 implementation is always built, using a target attribute, so that
+//  binaries built for the baseline ISA still use it on CPUs which support it;
+//  callers check CpuId before calling it.
 //
 //  TODO: Maybe this should be done by the build system....
-#if !FOLLY_SSE_PREREQ(4, 2)
+#if !FOLLY_SSE_PREREQ(4, 2) && !(FOLLY_X64 && !defined(_MSC_VER))
 namespace folly {
 namespace detail {
 size_t qfind_first_byte_of_sse42(
@@ -70,6 +72,7 @@ static inline size_t nextAlignedIndex(const char* arr) {
 }
 
 // helper method for case where needles.size() <= 16
+FOLLY_TARGET_ATTRIBUTE("sse4.2")
 size_t qfind_first_byte_of_needles16(
     const StringPieceLite haystack,
     const StringPieceLite needles) {
@@ -115,6 +118,7 @@ size_t qfind_first_byte_of_needles16(
 // If !HAYSTACK_ALIGNED, then caller must ensure that it is safe to load the
 // block.
 template <bool HAYSTACK_ALIGNED>
+FOLLY_TARGET_ATTRIBUTE("sse4.2")
 size_t scanHaystackBlock(
     const StringPieceLite haystack,
     const StringPieceLite needles,
@@ -163,6 +167,7 @@ size_t qfind_first_byte_of_sse42(
     const StringPieceLite haystack,
     const StringPieceLite needles);
 
+FOLLY_TARGET_ATTRIBUTE("sse4.2")
 size_t qfind_first_byte_of_sse42(
     const StringPieceLite haystack,
     const StringPieceLite needles) {
@@ -17,6 +17,7 @@
 #include <folly/detail/ThreadLocalDetail.h>
 #include <folly/synchronization/CallOnce.h>
 
+#include <algorithm>
 #include <list>
 #include <mutex>
 
@@ -28,6 +29,7 @@ namespace threadlocal_detail {
 
 void ThreadEntryNode::initIfZero(bool locked) {
   if (UNLIKELY(!next)) {
+    parent->pendingDispose = true;
     if (LIKELY(locked)) {
       parent->meta->pushBackLocked(parent, id);
     } else {
@@ -143,20 +145,8 @@ void StaticMetaBase::onThreadExit(void* ptr) {
       // No need to hold the lock any longer; the ThreadEntry is private to this
       // thread now that it's been removed from meta.
     }
-    // NOTE: User-provided deleter / object dtor itself may be using ThreadLocal
-    // with the same Tag, so dispose() calls below may (re)create some of the
-    // elements or even increase elementsCapacity, thus multiple cleanup rounds
-    // may be required.
-    for (bool shouldRun = true; shouldRun;) {
-      shouldRun = false;
-      auto elementsCapacity = threadEntry->getElementsCapacity();
-      FOR_EACH_RANGE (i, 0, elementsCapacity) {
-        if (threadEntry->elements[i].dispose(TLPDestructionMode::THIS_THREAD)) {
-          threadEntry->elements[i].cleanup();
-          shouldRun = true;
-        }
-      }
-    }
+    threadEntry->pendingDispose = true;
+    disposeElementsOnExit(*threadEntry);
     pthread_setspecific(meta.pthreadKey_, nullptr);
   }
 
@@ -169,30 +159,24 @@ void StaticMetaBase::onThreadExit(void* ptr) {
     return;
   }
 
-  // dispose all the elements
+  // Dispose the elements that destructors created in entries whose
+  // onThreadExit already ran, possibly in other entries than their own.
   for (bool shouldRunOuter = true; shouldRunOuter;) {
     shouldRunOuter = false;
-    auto tmp = threadEntryList->head;
-    while (tmp) {
+    for (auto tmp = threadEntryList->head; tmp; tmp = tmp->listNext) {
+      if (!tmp->pendingDispose) {
+        continue;
+      }
       auto& meta = *tmp->meta;
       pthread_setspecific(meta.pthreadKey_, tmp);
       SharedMutex::ReadHolder rlock(nullptr);
       if (meta.strict_) {
         rlock = SharedMutex::ReadHolder(meta.accessAllThreadsLock_);
       }
-      for (bool shouldRunInner = true; shouldRunInner;) {
-        shouldRunInner = false;
-        auto elementsCapacity = tmp->getElementsCapacity();
-        FOR_EACH_RANGE (i, 0, elementsCapacity) {
-          if (tmp->elements[i].dispose(TLPDestructionMode::THIS_THREAD)) {
-            tmp->elements[i].cleanup();
-            shouldRunInner = true;
-            shouldRunOuter = true;
-          }
-        }
+      if (disposeElementsOnExit(*tmp)) {
+        shouldRunOuter = true;
       }
       pthread_setspecific(meta.pthreadKey_, nullptr);
-      tmp = tmp->listNext;
     }
   }
 
@@ -218,6 +202,25 @@ void StaticMetaBase::onThreadExit(void* ptr) {
 #endif
 }
 
+bool StaticMetaBase::disposeElementsOnExit(ThreadEntry& threadEntry) {
+  // NOTE: User-provided deleter / object dtor itself may be using ThreadLocal
+  // with the same Tag, so dispose() calls below may (re)create some of the
+  // elements or even increase elementsCapacity. Any element they set flags
+  // pendingDispose, since nodes are unlinked by now, and takes another round.
+  bool disposed = false;
+  while (threadEntry.pendingDispose) {
+    threadEntry.pendingDispose = false;
+    auto elementsCapacity = threadEntry.getElementsCapacity();
+    FOR_EACH_RANGE (i, 0, elementsCapacity) {
+      if (threadEntry.elements[i].dispose(TLPDestructionMode::THIS_THREAD)) {
+        threadEntry.elements[i].cleanup();
+        disposed = true;
+      }
+    }
+  }
+  return disposed;
+}
+
 uint32_t StaticMetaBase::elementsCapacity() const {
   ThreadEntry* threadEntry = (*threadEntry_)();
 
@@ -327,11 +330,13 @@ ElementWrapper* StaticMetaBase::reallocate(
   auto smallCapacity = static_cast<size_t>((idval + 5) * kSmallGrowthFactor);
   auto bigCapacity = static_cast<size_t>((idval + 5) * kBigGrowthFactor);
 
-  newCapacity =
-      (threadEntry->meta &&
-       (bigCapacity <= threadEntry->meta->head_.getElementsCapacity()))
-      ? bigCapacity
-      : smallCapacity;
+  // Grow fast, but no further than the ids allocated so far (the capacity
+  // of head_), unless that is less than the small growth.
+  newCapacity = smallCapacity;
+  if (threadEntry->meta) {
+    auto headCapacity = threadEntry->meta->head_.getElementsCapacity();
+    newCapacity = std::max(smallCapacity, std::min(bigCapacity, headCapacity));
+  }
 
   assert(newCapacity > prevCapacity);
   ElementWrapper* reallocated = nullptr;
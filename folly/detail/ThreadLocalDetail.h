@@ -216,6 +216,10 @@ struct ThreadEntry {
   ThreadEntry* listNext{nullptr};
   StaticMetaBase* meta{nullptr};
   bool removed_{false};
+  // Set when an element is set while its node is not linked into the per-id
+  // list. At thread exit every node is unlinked, so this flags elements that
+  // destructors of other elements created, which still need disposing.
+  bool pendingDispose{false};
   aligned_storage_for_t<std::thread::id> tid_data{};
 
   size_t getElementsCapacity() const noexcept {
@@ -366,6 +370,10 @@ struct StaticMetaBase {
 
   static void onThreadExit(void* ptr);
 
+  // Disposes the elements of a thread entry at thread exit, again as long as
+  // their destructors set new ones. Returns whether any were disposed.
+  static bool disposeElementsOnExit(ThreadEntry& threadEntry);
+
   // returns the elementsCapacity for the
   // current thread ThreadEntry struct
   uint32_t elementsCapacity() const;
@@ -16,6 +16,7 @@
 
 #include <folly/executors/CPUThreadPoolExecutor.h>
 
+#include <folly/Chrono.h>
 #include <folly/executors/task_queue/PriorityLifoSemMPMCQueue.h>
 #include <folly/executors/task_queue/PriorityUnboundedBlockingQueue.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
@@ -121,13 +122,32 @@ void CPUThreadPoolExecutor::add(
     Func func,
     std::chrono::milliseconds expiration,
     Func expireCallback) {
-  auto result = taskQueue_->add(
-      CPUTask(std::move(func), expiration, std::move(expireCallback)));
+  CPUTask task(std::move(func), expiration, std::move(expireCallback));
+  traceTaskEnqueue(task);
+  auto result = taskQueue_->add(std::move(task));
   if (!result.reusedThread) {
     ensureActiveThreads();
   }
 }
 
+// The tasks are added to the queue at once, and threads are only started
+// for those not taken by idle threads.
+void CPUThreadPoolExecutor::addBatch(Range<Func*> funcs) {
+  std::vector<CPUTask> tasks;
+  tasks.reserve(funcs.size());
+  for (auto& func : funcs) {
+    tasks.emplace_back(std::move(func), std::chrono::milliseconds(0), nullptr);
+    traceTaskEnqueue(tasks.back());
+  }
+  auto result = taskQueue_->addBatch(range(tasks));
+  if (!result.reusedThread) {
+    for (size_t i = 0; i < tasks.size() && numActiveThreads() < numThreads();
+         ++i) {
+      ensureActiveThreads();
+    }
+  }
+}
+
 void CPUThreadPoolExecutor::addWithPriority(Func func, int8_t priority) {
   add(std::move(func), priority, std::chrono::milliseconds(0));
 }
@@ -138,14 +158,29 @@ void CPUThreadPoolExecutor::add(
     std::chrono::milliseconds expiration,
     Func expireCallback) {
   CHECK(getNumPriorities() > 0);
-  auto result = taskQueue_->addWithPriority(
-      CPUTask(std::move(func), expiration, std::move(expireCallback)),
-      priority);
+  CPUTask task(std::move(func), expiration, std::move(expireCallback));
+  traceTaskEnqueue(task);
+  auto result = taskQueue_->addWithPriority(std::move(task), priority);
   if (!result.reusedThread) {
     ensureActiveThreads();
   }
 }
 
+void CPUThreadPoolExecutor::addWithDeadline(
+    Func func,
+    std::chrono::steady_clock::time_point deadline,
+    Func expireCallback) {
+  auto expiration = folly::chrono::ceil<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (expiration <= std::chrono::milliseconds(0)) {
+    if (expireCallback) {
+      expireCallback();
+    }
+    return;
+  }
+  add(std::move(func), expiration, std::move(expireCallback));
+}
+
 uint8_t CPUThreadPoolExecutor::getNumPriorities() const {
   return taskQueue_->getNumPriorities();
 }
@@ -229,4 +264,8 @@ size_t CPUThreadPoolExecutor::getPendingTaskCountImpl() const {
   return taskQueue_->size();
 }
 
+bool CPUThreadPoolExecutor::hasPendingWork(const Thread& /* thread */) const {
+  return taskQueue_->size() > 0;
+}
+
 } // namespace folly
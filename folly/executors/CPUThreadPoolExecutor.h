@@ -29,7 +29,12 @@ namespace folly {
  * Because of this contention can be quite high,
  * since all the worker threads and all the producer threads hit
  * the same queue. MPMC queue excels in this situation but dictates a max queue
- * size.
+ * size. For pools whose tasks add many small tasks, a
+ * WorkStealingBlockingQueue can be passed as the taskQueue instead: it gives
+ * each worker a deque of its own. On multi-socket hosts, a NumaBlockingQueue
+ * together with a NumaThreadFactory keeps tasks on the NUMA node that added
+ * them. An EDFBlockingQueue runs tasks in deadline order and drops those
+ * that would run late.
  *
  * @note The default queue throws when full (folly::QueueBehaviorIfFull::THROW),
  * so add() can fail. Furthermore, join() can also fail if the queue is full,
@@ -102,6 +107,7 @@ class CPUThreadPoolExecutor : public ThreadPoolExecutor {
   ~CPUThreadPoolExecutor() override;
 
   void add(Func func) override;
+  void addBatch(Range<Func*> funcs) override;
   void add(
       Func func,
       std::chrono::milliseconds expiration,
@@ -114,6 +120,16 @@ class CPUThreadPoolExecutor : public ThreadPoolExecutor {
       std::chrono::milliseconds expiration,
       Func expireCallback = nullptr);
 
+  /**
+   * Adds func with an expiration ending at deadline: if it has not
+   * started by then, expireCallback runs instead.  If the deadline has
+   * already passed, expireCallback runs right away on this thread.
+   */
+  void addWithDeadline(
+      Func func,
+      std::chrono::steady_clock::time_point deadline,
+      Func expireCallback = nullptr);
+
   size_t getTaskQueueSize() const;
 
   uint8_t getNumPriorities() const override;
@@ -142,6 +158,7 @@ class CPUThreadPoolExecutor : public ThreadPoolExecutor {
   void threadRun(ThreadPtr thread) override;
   void stopThreads(size_t n) override;
   size_t getPendingTaskCountImpl() const override final;
+  bool hasPendingWork(const Thread& thread) const override;
 
   bool tryDecrToStop();
   bool taskShouldStop(folly::Optional<CPUTask>&);
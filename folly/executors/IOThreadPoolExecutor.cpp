@@ -18,7 +18,8 @@
 
 #include <glog/logging.h>
 
-#include <folly/detail/MemoryIdler.h>
+#include <folly/executors/thread_factory/NumaThreadFactory.h>
+#include <folly/io/async/EventBaseMemoryIdler.h>
 #include <folly/portability/GFlags.h>
 
 DEFINE_bool(
@@ -28,45 +29,6 @@ DEFINE_bool(
 
 namespace folly {
 
-using folly::detail::MemoryIdler;
-
-/* Class that will free jemalloc caches and madvise the stack away
- * if the event loop is unused for some period of time
- */
-class MemoryIdlerTimeout : public AsyncTimeout, public EventBase::LoopCallback {
- public:
-  explicit MemoryIdlerTimeout(EventBase* b) : AsyncTimeout(b), base_(b) {}
-
-  void timeoutExpired() noexcept override {
-    idled = true;
-  }
-
-  void runLoopCallback() noexcept override {
-    if (idled) {
-      MemoryIdler::flushLocalMallocCaches();
-      MemoryIdler::unmapUnusedStack(MemoryIdler::kDefaultStackToRetain);
-
-      idled = false;
-    } else {
-      std::chrono::steady_clock::duration idleTimeout =
-          MemoryIdler::defaultIdleTimeout.load(std::memory_order_acquire);
-
-      idleTimeout = MemoryIdler::getVariationTimeout(idleTimeout);
-
-      scheduleTimeout(static_cast<uint32_t>(
-          std::chrono::duration_cast<std::chrono::milliseconds>(idleTimeout)
-              .count()));
-    }
-
-    // reschedule this callback for the next event loop.
-    base_->runBeforeLoop(this);
-  }
-
- private:
-  EventBase* base_;
-  bool idled{false};
-};
-
 IOThreadPoolExecutor::IOThreadPoolExecutor(
     size_t numThreads,
     std::shared_ptr<ThreadFactory> threadFactory,
@@ -78,6 +40,8 @@ IOThreadPoolExecutor::IOThreadPoolExecutor(
           std::move(threadFactory),
           waitForAll),
       nextThread_(0),
+      numNodes_(NumaThreadFactory::systemNodes()),
+      nodeThreads_(numNodes_),
       eventBaseManager_(ebm) {
   setNumThreads(numThreads);
   registerThreadPoolExecutor(this);
@@ -104,6 +68,7 @@ void IOThreadPoolExecutor::add(
   auto ioThread = pickThread();
 
   auto task = Task(std::move(func), expiration, std::move(expireCallback));
+  traceTaskEnqueue(task);
   auto wrappedFunc = [ioThread, task = std::move(task)]() mutable {
     runTask(ioThread, std::move(task));
     ioThread->pendingTasks--;
@@ -113,10 +78,51 @@ void IOThreadPoolExecutor::add(
   ioThread->eventBase->runInEventBaseThread(std::move(wrappedFunc));
 }
 
+// The batch is split into one contiguous chunk per thread, each enqueued
+// with a single notification of the thread's EventBase.
+void IOThreadPoolExecutor::addBatch(Range<Func*> funcs) {
+  if (funcs.empty()) {
+    return;
+  }
+  ensureActiveThreads();
+  SharedMutex::ReadHolder r{&threadListLock_};
+  if (threadList_.get().empty()) {
+    throw std::runtime_error("No threads available");
+  }
+  auto numChunks = std::min(funcs.size(), threadList_.get().size());
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    auto ioThread = pickThread();
+    auto begin = funcs.begin() + funcs.size() * chunk / numChunks;
+    auto end = funcs.begin() + funcs.size() * (chunk + 1) / numChunks;
+    std::vector<Func> wrappedFuncs;
+    wrappedFuncs.reserve(end - begin);
+    for (auto it = begin; it != end; ++it) {
+      auto task = Task(std::move(*it), std::chrono::milliseconds(0), nullptr);
+      traceTaskEnqueue(task);
+      wrappedFuncs.emplace_back([ioThread, task = std::move(task)]() mutable {
+        runTask(ioThread, std::move(task));
+        ioThread->pendingTasks--;
+      });
+    }
+    ioThread->pendingTasks += wrappedFuncs.size();
+    ioThread->eventBase->addBatch(range(wrappedFuncs));
+  }
+}
+
 std::shared_ptr<IOThreadPoolExecutor::IOThread>
 IOThreadPoolExecutor::pickThread() {
   auto& me = *thisThread_;
   auto& ths = threadList_.get();
+  auto local = selection_.load(std::memory_order_relaxed) ==
+      EventBaseSelection::Local;
+  if (auto pinned = local ? RequestEventBase::get() : nullptr) {
+    for (auto& thread : ths) {
+      auto ioThread = std::static_pointer_cast<IOThread>(thread);
+      if (ioThread->eventBase == pinned) {
+        return ioThread;
+      }
+    }
+  }
   // When new task is added to IOThreadPoolExecutor, a thread is chosen for it
   // to be executed on, thisThread_ is by default chosen, however, if the new
   // task is added by the clean up operations on thread destruction, thisThread_
@@ -136,8 +142,14 @@ IOThreadPoolExecutor::pickThread() {
     // the second case, `!me` so we'll crash anyway.
     return me;
   }
-  auto thread = ths[nextThread_.fetch_add(1, std::memory_order_relaxed) % n];
-  return std::static_pointer_cast<IOThread>(thread);
+  auto next = nextThread_.fetch_add(1, std::memory_order_relaxed);
+  if (local) {
+    auto& nodeThs = nodeThreads_[NumaThreadFactory::currentNode(numNodes_)];
+    if (!nodeThs.empty()) {
+      return nodeThs[next % nodeThs.size()];
+    }
+  }
+  return std::static_pointer_cast<IOThread>(ths[next % n]);
 }
 
 EventBase* IOThreadPoolExecutor::getEventBase() {
@@ -174,9 +186,15 @@ void IOThreadPoolExecutor::threadRun(ThreadPtr thread) {
   const auto ioThread = std::static_pointer_cast<IOThread>(thread);
   ioThread->eventBase = eventBaseManager_->getEventBase();
   thisThread_.reset(new std::shared_ptr<IOThread>(ioThread));
+  // The thread adding us holds threadListLock_ until startupBaton is posted,
+  // so no pickThread() sees nodeThreads_ change.
+  ioThread->node = NumaThreadFactory::currentNode(numNodes_);
+  {
+    std::lock_guard<std::mutex> guard(nodeThreadsMutex_);
+    nodeThreads_[ioThread->node].push_back(ioThread);
+  }
 
-  auto idler = std::make_unique<MemoryIdlerTimeout>(ioThread->eventBase);
-  ioThread->eventBase->runBeforeLoop(idler.get());
+  auto idler = std::make_unique<EventBaseMemoryIdler>(*ioThread->eventBase);
 
   ioThread->eventBase->runInEventBaseThread(
       [thread] { thread->startupBaton.post(); });
@@ -220,10 +238,20 @@ void IOThreadPoolExecutor::stopThreads(size_t n) {
   for (auto thread : stoppedThreads) {
     stoppedThreads_.add(thread);
     threadList_.remove(thread);
+    std::lock_guard<std::mutex> guard(nodeThreadsMutex_);
+    auto& nodeThs =
+        nodeThreads_[static_cast<const IOThread&>(*thread).node];
+    nodeThs.erase(std::find(nodeThs.begin(), nodeThs.end(), thread));
   }
 }
 
 // threadListLock_ is readlocked
+// Only the tasks of the thread's own EventBase wait for it; the running
+// task is one of its pendingTasks.
+bool IOThreadPoolExecutor::hasPendingWork(const Thread& thread) const {
+  return static_cast<const IOThread&>(thread).pendingTasks > 1;
+}
+
 size_t IOThreadPoolExecutor::getPendingTaskCountImpl() const {
   size_t count = 0;
   for (const auto& thread : threadList_.get()) {
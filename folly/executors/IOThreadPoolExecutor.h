@@ -17,6 +17,8 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
+#include <vector>
 
 #include <folly/Portability.h>
 #include <folly/executors/IOExecutor.h>
@@ -49,7 +51,8 @@ FOLLY_MSVC_DISABLE_WARNING(4250)
  * have more IO threads than this, assuming they don't block.
  *
  * @note ::getEventBase() will return an EventBase you can schedule IO work on
- * directly, chosen round-robin.
+ * directly, chosen round-robin. See EventBaseSelection::Local to keep work
+ * on the caller's core or on the EventBase owning a connection instead.
  *
  * @note N.B. For this thread pool, stop() behaves like join() because
  * outstanding tasks belong to the event base and will be executed upon its
@@ -67,6 +70,7 @@ class IOThreadPoolExecutor : public ThreadPoolExecutor, public IOExecutor {
   ~IOThreadPoolExecutor() override;
 
   void add(Func func) override;
+  void addBatch(Range<Func*> funcs) override;
   void add(
       Func func,
       std::chrono::milliseconds expiration,
@@ -78,6 +82,26 @@ class IOThreadPoolExecutor : public ThreadPoolExecutor, public IOExecutor {
 
   folly::EventBaseManager* getEventBaseManager();
 
+  /**
+   * How add() and getEventBase() choose an EventBase.  Both use the
+   * caller's own EventBase when called from one of the pool's threads.
+   *
+   * Local first uses the EventBase the current request is pinned to with
+   * RequestEventBase::set(), for instance the one owning its connection.
+   * Callers outside the pool then get the EventBases of the threads running
+   * on their own NUMA node, round-robin, and any EventBase when that node
+   * has no thread.  Threads are assigned to the node they run on when they
+   * start, so use a NumaThreadFactory to spread them over the nodes.
+   */
+  enum class EventBaseSelection {
+    RoundRobin,
+    Local,
+  };
+
+  void setEventBaseSelection(EventBaseSelection selection) {
+    selection_.store(selection, std::memory_order_relaxed);
+  }
+
  private:
   struct alignas(folly::cacheline_align_v) IOThread : public Thread {
     IOThread(IOThreadPoolExecutor* pool)
@@ -86,6 +110,7 @@ class IOThreadPoolExecutor : public ThreadPoolExecutor, public IOExecutor {
     std::atomic<size_t> pendingTasks;
     folly::EventBase* eventBase;
     std::mutex eventBaseShutdownMutex_;
+    size_t node{0};
   };
 
   ThreadPtr makeThread() override;
@@ -93,8 +118,15 @@ class IOThreadPoolExecutor : public ThreadPoolExecutor, public IOExecutor {
   void threadRun(ThreadPtr thread) override;
   void stopThreads(size_t n) override;
   size_t getPendingTaskCountImpl() const override final;
+  bool hasPendingWork(const Thread& thread) const override;
 
   std::atomic<size_t> nextThread_;
+  std::atomic<EventBaseSelection> selection_{EventBaseSelection::RoundRobin};
+  const size_t numNodes_;
+  // The threads of each node, guarded like threadList_; nodeThreadsMutex_
+  // serializes the threads registering themselves while they start.
+  std::vector<std::vector<std::shared_ptr<IOThread>>> nodeThreads_;
+  std::mutex nodeThreadsMutex_;
   folly::ThreadLocal<std::shared_ptr<IOThread>> thisThread_;
   folly::EventBaseManager* eventBaseManager_;
 };
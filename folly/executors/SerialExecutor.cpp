@@ -22,8 +22,10 @@
 
 namespace folly {
 
-SerialExecutor::SerialExecutor(KeepAlive<Executor> parent)
-    : parent_(std::move(parent)) {}
+SerialExecutor::SerialExecutor(
+    KeepAlive<Executor> parent,
+    size_t maxTasksPerDispatch)
+    : parent_(std::move(parent)), maxTasksPerDispatch_(maxTasksPerDispatch) {}
 
 SerialExecutor::~SerialExecutor() {
   DCHECK(!keepAliveCounter_);
@@ -34,6 +36,14 @@ Executor::KeepAlive<SerialExecutor> SerialExecutor::create(
   return makeKeepAlive<SerialExecutor>(new SerialExecutor(std::move(parent)));
 }
 
+Executor::KeepAlive<SerialExecutor> SerialExecutor::create(
+    KeepAlive<Executor> parent,
+    size_t maxTasksPerDispatch) {
+  CHECK_GT(maxTasksPerDispatch, 0);
+  return makeKeepAlive<SerialExecutor>(
+      new SerialExecutor(std::move(parent), maxTasksPerDispatch));
+}
+
 SerialExecutor::UniquePtr SerialExecutor::createUnique(
     std::shared_ptr<Executor> parent) {
   auto executor = new SerialExecutor(getKeepAliveToken(parent.get()));
@@ -57,11 +67,20 @@ void SerialExecutor::keepAliveRelease() {
 }
 
 void SerialExecutor::add(Func func) {
+  if (maxTasksPerDispatch_ > 0) {
+    addBatched(Task{std::move(func), RequestContext::saveContext()});
+    return;
+  }
   queue_.enqueue(Task{std::move(func), RequestContext::saveContext()});
   parent_->add([keepAlive = getKeepAliveToken(this)] { keepAlive->run(); });
 }
 
 void SerialExecutor::addWithPriority(Func func, int8_t priority) {
+  if (maxTasksPerDispatch_ > 0) {
+    addBatched(Task{
+        std::move(func), RequestContext::saveContext(), true, priority});
+    return;
+  }
   queue_.enqueue(Task{std::move(func), RequestContext::saveContext()});
   parent_->addWithPriority(
       [keepAlive = getKeepAliveToken(this)] { keepAlive->run(); }, priority);
@@ -77,22 +96,61 @@ void SerialExecutor::run() {
   do {
     Task task;
     queue_.dequeue(task);
-
-    try {
-      folly::RequestContextScopeGuard ctxGuard(std::move(task.ctx));
-      auto func = std::move(task.func);
-      func();
-    } catch (std::exception const& ex) {
-      LOG(ERROR) << "SerialExecutor: func threw unhandled exception "
-                 << folly::exceptionStr(ex);
-    } catch (...) {
-      LOG(ERROR) << "SerialExecutor: func threw unhandled non-exception "
-                    "object";
-    }
+    runTask(task);
 
     // We want scheduled_ to guard side-effects of completed tasks, so we can't
     // use std::memory_order_relaxed here.
   } while (scheduled_.fetch_sub(1, std::memory_order_release) > 1);
 }
 
+void SerialExecutor::addBatched(Task task) {
+  auto withPriority = task.withPriority;
+  auto priority = task.priority;
+  queue_.enqueue(std::move(task));
+  // Only the task that makes the queue non-empty is dispatched; the runner
+  // then dispatches itself again for the rest.
+  if (scheduled_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    dispatchBatch(withPriority, priority);
+  }
+}
+
+void SerialExecutor::dispatchBatch(bool withPriority, int8_t priority) {
+  auto func = [keepAlive = getKeepAliveToken(this)] { keepAlive->runBatch(); };
+  if (withPriority) {
+    parent_->addWithPriority(std::move(func), priority);
+  } else {
+    parent_->add(std::move(func));
+  }
+}
+
+void SerialExecutor::runBatch() {
+  for (size_t i = 0; i < maxTasksPerDispatch_; ++i) {
+    Task task;
+    queue_.dequeue(task);
+    runTask(task);
+    if (scheduled_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      return;
+    }
+  }
+  // Give the parent's thread back; the next task is already enqueued since
+  // it was counted in scheduled_.
+  auto next = queue_.try_peek();
+  DCHECK(next);
+  dispatchBatch(next->withPriority, next->priority);
+}
+
+void SerialExecutor::runTask(Task& task) {
+  try {
+    folly::RequestContextScopeGuard ctxGuard(std::move(task.ctx));
+    auto func = std::move(task.func);
+    func();
+  } catch (std::exception const& ex) {
+    LOG(ERROR) << "SerialExecutor: func threw unhandled exception "
+               << folly::exceptionStr(ex);
+  } catch (...) {
+    LOG(ERROR) << "SerialExecutor: func threw unhandled non-exception "
+                  "object";
+  }
+}
+
 } // namespace folly
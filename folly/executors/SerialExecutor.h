@@ -45,6 +45,11 @@ namespace folly {
  * is marked for execution, which means it will either be executed at once,
  * or if a task is currently being executed already, after that.
  *
+ * Created with a maxTasksPerDispatch, it instead submits a single task to the
+ * parent while it has tasks queued, which runs up to maxTasksPerDispatch of
+ * them before submitting itself again, with the priority of the next one.
+ * This trades some fairness for a lot less traffic on the parent's queue.
+ *
  * The SerialExecutor may be deleted at any time. All tasks that have been
  * submitted will still be executed with the same guarantees, as long as the
  * parent executor is executing tasks.
@@ -59,6 +64,9 @@ class SerialExecutor : public SequencedExecutor {
 
   static KeepAlive<SerialExecutor> create(
       KeepAlive<Executor> parent = getKeepAliveToken(getCPUExecutor().get()));
+  static KeepAlive<SerialExecutor> create(
+      KeepAlive<Executor> parent,
+      size_t maxTasksPerDispatch);
 
   class Deleter {
    public:
@@ -109,14 +117,26 @@ class SerialExecutor : public SequencedExecutor {
   struct Task {
     Func func;
     std::shared_ptr<RequestContext> ctx;
+    bool withPriority{false};
+    int8_t priority{MID_PRI};
   };
 
-  explicit SerialExecutor(KeepAlive<Executor> parent);
+  explicit SerialExecutor(
+      KeepAlive<Executor> parent,
+      size_t maxTasksPerDispatch = 0);
   ~SerialExecutor() override;
 
   void run();
 
+  void addBatched(Task task);
+  void dispatchBatch(bool withPriority, int8_t priority);
+  void runBatch();
+  static void runTask(Task& task);
+
   KeepAlive<Executor> parent_;
+  const size_t maxTasksPerDispatch_;
+  // In batched mode, the number of queued tasks, including the one
+  // running.
   std::atomic<std::size_t> scheduled_{0};
   /**
    * Unbounded multi producer single consumer queue where consumers don't block
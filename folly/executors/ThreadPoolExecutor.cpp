@@ -17,7 +17,11 @@
 #include <folly/executors/ThreadPoolExecutor.h>
 
 #include <folly/executors/GlobalThreadPoolList.h>
+#include <folly/executors/TimeSlice.h>
+#include <folly/stats/TDigest.h>
+#include <folly/stats/detail/DigestBuilder.h>
 #include <folly/synchronization/AsymmetricMemoryBarrier.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 namespace folly {
 
@@ -44,6 +48,26 @@ DEFINE_int64(
     60000,
     "Idle time before ThreadPoolExecutor threads are joined");
 
+struct ThreadPoolExecutor::Autoscaler {
+  explicit Autoscaler(const AutoscalingOptions& opts)
+      : options(opts), waits(1000, 100) {}
+
+  // Held by the thread evaluating the pool, and to update the options.
+  std::mutex mutex;
+  AutoscalingOptions options;
+  size_t intervalsBelow{0};
+  std::chrono::steady_clock::time_point lastEvaluation{
+      std::chrono::steady_clock::now()};
+
+  // Waits of the tasks run since the last evaluation, in nanoseconds.
+  detail::DigestBuilder<TDigest> waits;
+  std::atomic<std::chrono::steady_clock::rep> nextEvaluation{0};
+
+  std::atomic<std::chrono::nanoseconds::rep> waitP50{0};
+  std::atomic<std::chrono::nanoseconds::rep> waitP90{0};
+  std::atomic<std::chrono::nanoseconds::rep> waitP99{0};
+};
+
 ThreadPoolExecutor::ThreadPoolExecutor(
     size_t /* maxThreads */,
     size_t minThreads,
@@ -73,18 +97,41 @@ ThreadPoolExecutor::Task::Task(
   enqueueTime_ = std::chrono::steady_clock::now();
 }
 
+void ThreadPoolExecutor::traceTaskEnqueue(const Task& task) {
+  FOLLY_SDT(
+      folly,
+      thread_pool_executor_task_enqueue,
+      this,
+      task.enqueueTime_.time_since_epoch().count());
+}
+
 void ThreadPoolExecutor::runTask(const ThreadPtr& thread, Task&& task) {
   thread->idle = false;
   auto startTime = std::chrono::steady_clock::now();
   task.stats_.waitTime = startTime - task.enqueueTime_;
-  if (task.expiration_ > std::chrono::milliseconds(0) &&
-      task.stats_.waitTime >= task.expiration_) {
+  FOLLY_SDT(
+      folly,
+      thread_pool_executor_task_dequeue,
+      thread->pool,
+      task.enqueueTime_.time_since_epoch().count(),
+      task.stats_.waitTime.count());
+  auto codel =
+      thread->taskStatsCallbacks->codel.load(std::memory_order_acquire);
+  if ((task.expiration_ > std::chrono::milliseconds(0) &&
+       task.stats_.waitTime >= task.expiration_) ||
+      (codel && codel->overloaded(task.stats_.waitTime))) {
     task.stats_.expired = true;
+    FOLLY_SDT(folly, thread_pool_executor_task_expired, thread->pool);
     if (task.expireCallback_ != nullptr) {
       task.expireCallback_();
     }
   } else {
     folly::RequestContextScopeGuard rctx(task.context_);
+    auto hasPendingWork = [&] { return thread->pool->hasPendingWork(*thread); };
+    TimeSlice::Scope slice(
+        thread->pool->timeSlice_.load(std::memory_order_relaxed),
+        hasPendingWork);
+    FOLLY_SDT(folly, thread_pool_executor_task_run, thread->pool);
     try {
       task.func_();
     } catch (const std::exception& e) {
@@ -95,9 +142,22 @@ void ThreadPoolExecutor::runTask(const ThreadPtr& thread, Task&& task) {
                     "object";
     }
     task.stats_.runTime = std::chrono::steady_clock::now() - startTime;
+    FOLLY_SDT(
+        folly,
+        thread_pool_executor_task_done,
+        thread->pool,
+        task.stats_.runTime.count());
   }
   thread->idle = true;
-  thread->lastActiveTime = std::chrono::steady_clock::now();
+  const auto endTime = std::chrono::steady_clock::now();
+  thread->lastActiveTime = endTime;
+  if (auto estimators = thread->taskStatsCallbacks->estimators.load(
+          std::memory_order_acquire)) {
+    estimators->waitTime.addValue(task.stats_.waitTime.count(), startTime);
+    if (!task.stats_.expired) {
+      estimators->runTime.addValue(task.stats_.runTime.count(), endTime);
+    }
+  }
   thread->taskStatsCallbacks->callbackList.withRLock([&](auto& callbacks) {
     *thread->taskStatsCallbacks->inCallback = true;
     SCOPE_EXIT {
@@ -186,6 +246,115 @@ void ThreadPoolExecutor::setNumThreads(size_t numThreads) {
   joinStoppedThreads(numThreadsToJoin);
 }
 
+void ThreadPoolExecutor::setAutoscaling(const AutoscalingOptions& options) {
+  auto opts = options;
+  if (opts.maxThreads == 0) {
+    opts.maxThreads = numThreads();
+  }
+  CHECK_GT(opts.maxThreads, 0);
+  CHECK_LE(opts.minThreads, opts.maxThreads);
+  CHECK_GT(opts.interval.count(), 0);
+
+  bool subscribe = false;
+  {
+    SharedMutex::WriteHolder w{&threadListLock_};
+    if (!autoscaler_) {
+      autoscaler_ = std::make_unique<Autoscaler>(opts);
+      subscribe = true;
+    }
+  }
+  if (!subscribe) {
+    std::lock_guard<std::mutex> guard(autoscaler_->mutex);
+    autoscaler_->options = opts;
+    autoscaler_->intervalsBelow = 0;
+  }
+
+  minThreads_.store(opts.minThreads, std::memory_order_relaxed);
+  threadTimeout_ = opts.idleTimeout;
+  setNumThreads(
+      std::min(std::max(numThreads(), opts.minThreads), opts.maxThreads));
+
+  if (subscribe) {
+    subscribeToTaskStats([this](const TaskStats& stats) { autoscale(stats); });
+  }
+}
+
+// Called by the worker threads after every task.
+void ThreadPoolExecutor::autoscale(const TaskStats& stats) {
+  auto& autoscaler = *autoscaler_;
+  autoscaler.waits.append(
+      std::chrono::duration<double, std::nano>(stats.waitTime).count());
+
+  const auto now = std::chrono::steady_clock::now();
+  if (now.time_since_epoch().count() <
+      autoscaler.nextEvaluation.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(autoscaler.mutex, std::try_to_lock);
+  if (!lock || now.time_since_epoch().count() <
+          autoscaler.nextEvaluation.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const auto& options = autoscaler.options;
+  autoscaler.nextEvaluation.store(
+      (now + options.interval).time_since_epoch().count(),
+      std::memory_order_relaxed);
+  // Intervals in which no task ran had no waits either.
+  auto intervals = std::max<size_t>(
+      1, (now - autoscaler.lastEvaluation) / options.interval);
+  autoscaler.lastEvaluation = now;
+
+  auto digest = autoscaler.waits.build();
+  if (digest.empty()) {
+    return;
+  }
+  auto quantile = [&](double q) {
+    return static_cast<std::chrono::nanoseconds::rep>(
+        digest.estimateQuantile(q));
+  };
+  autoscaler.waitP50.store(quantile(0.5), std::memory_order_relaxed);
+  autoscaler.waitP90.store(quantile(0.9), std::memory_order_relaxed);
+  autoscaler.waitP99.store(quantile(0.99), std::memory_order_relaxed);
+
+  const std::chrono::nanoseconds wait(quantile(options.percentile));
+  const auto current = numThreads();
+  if (wait > options.growAbove) {
+    autoscaler.intervalsBelow = 0;
+    if (current < options.maxThreads) {
+      resizeForAutoscaling(
+          std::min(current + options.growStep, options.maxThreads));
+    }
+  } else if (wait < options.shrinkBelow) {
+    autoscaler.intervalsBelow += intervals;
+    if (autoscaler.intervalsBelow >= options.shrinkAfter &&
+        current > options.minThreads) {
+      autoscaler.intervalsBelow = 0;
+      resizeForAutoscaling(current - 1);
+    }
+  } else {
+    autoscaler.intervalsBelow = 0;
+  }
+}
+
+// Unlike setNumThreads(), never joins threads, since it runs on one of
+// them: the threads above numThreads are stopped once idle for
+// threadTimeout_.
+void ThreadPoolExecutor::resizeForAutoscaling(size_t numThreads) {
+  SharedMutex::WriteHolder w{&threadListLock_};
+  if (maxThreads_.load(std::memory_order_relaxed) == 0) {
+    // stopped or joined
+    return;
+  }
+  maxThreads_.store(numThreads, std::memory_order_relaxed);
+  auto active = activeThreads_.load(std::memory_order_relaxed);
+  if (active < numThreads) {
+    auto numToAdd = std::min<size_t>(
+        getPendingTaskCountImpl(), numThreads - active);
+    ThreadPoolExecutor::addThreads(numToAdd);
+    activeThreads_.store(active + numToAdd, std::memory_order_relaxed);
+  }
+}
+
 // threadListLock_ is writelocked
 void ThreadPoolExecutor::addThreads(size_t n) {
   std::vector<ThreadPtr> newThreads;
@@ -286,9 +455,21 @@ ThreadPoolExecutor::PoolStats ThreadPoolExecutor::getPoolStats() const {
   stats.activeThreadCount =
       activeThreads_.load(std::memory_order_relaxed) - idleAlive;
   stats.idleThreadCount = stats.threadCount - stats.activeThreadCount;
+  if (autoscaler_) {
+    stats.queueWaitP50 = std::chrono::nanoseconds(
+        autoscaler_->waitP50.load(std::memory_order_relaxed));
+    stats.queueWaitP90 = std::chrono::nanoseconds(
+        autoscaler_->waitP90.load(std::memory_order_relaxed));
+    stats.queueWaitP99 = std::chrono::nanoseconds(
+        autoscaler_->waitP99.load(std::memory_order_relaxed));
+  }
   return stats;
 }
 
+bool ThreadPoolExecutor::hasPendingWork(const Thread& /* thread */) const {
+  return getPendingTaskCount() > 0;
+}
+
 size_t ThreadPoolExecutor::getPendingTaskCount() const {
   SharedMutex::ReadHolder r{&threadListLock_};
   return getPendingTaskCountImpl();
@@ -312,6 +493,57 @@ void ThreadPoolExecutor::subscribeToTaskStats(TaskStatsCallback cb) {
   taskStatsCallbacks_->callbackList.wlock()->push_back(std::move(cb));
 }
 
+void ThreadPoolExecutor::enableTaskTimeEstimates(
+    std::chrono::seconds windowDuration,
+    size_t nWindows) {
+  auto& estimators = taskStatsCallbacks_->estimators;
+  if (estimators.load(std::memory_order_acquire)) {
+    return;
+  }
+  auto created = std::make_unique<TaskTimeEstimators>(windowDuration, nWindows);
+  TaskTimeEstimators* expected = nullptr;
+  if (estimators.compare_exchange_strong(
+          expected, created.get(), std::memory_order_acq_rel)) {
+    created.release();
+  }
+}
+
+ThreadPoolExecutor::TaskTimeEstimates
+ThreadPoolExecutor::getTaskTimeEstimates(
+    Range<const double*> quantiles) const {
+  TaskTimeEstimates estimates{};
+  if (auto estimators =
+          taskStatsCallbacks_->estimators.load(std::memory_order_acquire)) {
+    // include the times buffered since the window started
+    estimators->waitTime.flush();
+    estimators->runTime.flush();
+    estimates.waitTime = estimators->waitTime.estimateQuantiles(quantiles);
+    estimates.runTime = estimators->runTime.estimateQuantiles(quantiles);
+  }
+  return estimates;
+}
+
+void ThreadPoolExecutor::enableCodel() {
+  installCodel(std::make_unique<Codel>());
+}
+
+void ThreadPoolExecutor::enableCodel(const Codel::Options& options) {
+  installCodel(std::make_unique<Codel>(options));
+}
+
+void ThreadPoolExecutor::installCodel(std::unique_ptr<Codel> created) {
+  auto& codel = taskStatsCallbacks_->codel;
+  Codel* expected = nullptr;
+  if (codel.compare_exchange_strong(
+          expected, created.get(), std::memory_order_acq_rel)) {
+    created.release();
+  }
+}
+
+Codel* ThreadPoolExecutor::getCodel() const {
+  return taskStatsCallbacks_->codel.load(std::memory_order_acquire);
+}
+
 BlockingQueueAddResult ThreadPoolExecutor::StoppedThreadQueue::add(
     ThreadPoolExecutor::ThreadPtr item) {
   std::lock_guard<std::mutex> guard(mutex_);
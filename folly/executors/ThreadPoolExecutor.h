@@ -23,11 +23,13 @@
 #include <folly/DefaultKeepAliveExecutor.h>
 #include <folly/Memory.h>
 #include <folly/SharedMutex.h>
+#include <folly/executors/Codel.h>
 #include <folly/executors/GlobalThreadPoolList.h>
 #include <folly/executors/task_queue/LifoSemMPMCQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/io/async/Request.h>
 #include <folly/portability/GFlags.h>
+#include <folly/stats/QuantileEstimator.h>
 #include <folly/synchronization/Baton.h>
 
 #include <glog/logging.h>
@@ -114,10 +116,16 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
           activeThreadCount(0),
           pendingTaskCount(0),
           totalTaskCount(0),
-          maxIdleTime(0) {}
+          maxIdleTime(0),
+          queueWaitP50(0),
+          queueWaitP90(0),
+          queueWaitP99(0) {}
     size_t threadCount, idleThreadCount, activeThreadCount;
     uint64_t pendingTaskCount, totalTaskCount;
     std::chrono::nanoseconds maxIdleTime;
+    // Time spent in the queue by the tasks of the last autoscaling
+    // interval; zero without autoscaling.
+    std::chrono::nanoseconds queueWaitP50, queueWaitP90, queueWaitP99;
   };
 
   PoolStats getPoolStats() const;
@@ -134,6 +142,51 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   using TaskStatsCallback = std::function<void(TaskStats)>;
   void subscribeToTaskStats(TaskStatsCallback cb);
 
+  /**
+   * Aggregate the wait and run times of all tasks, over a sliding window
+   * of nWindows windows of windowDuration.  Cheaper than a task stats
+   * callback: times are buffered per cpu and only merged into digests
+   * once per window, or when read.  Does nothing if already enabled.
+   */
+  void enableTaskTimeEstimates(
+      std::chrono::seconds windowDuration = std::chrono::seconds(1),
+      size_t nWindows = 60);
+
+  struct TaskTimeEstimates {
+    // In nanoseconds; expired tasks only count in waitTime.
+    QuantileEstimates waitTime;
+    QuantileEstimates runTime;
+  };
+
+  /**
+   * Estimates of the given quantiles of the task times over the window;
+   * empty if enableTaskTimeEstimates() was not called.
+   */
+  TaskTimeEstimates getTaskTimeEstimates(
+      Range<const double*> quantiles) const;
+
+  /**
+   * Apply CoDel to the time tasks spend in the queue: while the pool is
+   * overloaded, tasks that waited more than twice the target delay are
+   * expired instead of run, as if their expiration had passed (their
+   * expire callback, if any, runs instead).  Without options, they are
+   * taken from the codel_* flags.  Does nothing if already enabled.
+   */
+  void enableCodel();
+  void enableCodel(const Codel::Options& options);
+
+  // nullptr unless enableCodel() was called
+  Codel* getCodel() const;
+
+  /**
+   * Tasks run within a TimeSlice::Scope of this length: past it,
+   * TimeSlice::shouldYield() returns true to a task while other tasks are
+   * waiting for its thread.  Zero disables yielding.
+   */
+  void setTimeSlice(std::chrono::milliseconds slice) {
+    timeSlice_.store(slice, std::memory_order_relaxed);
+  }
+
   /**
    * Base class for threads created with ThreadPoolExecutor.
    * Some subclasses have methods that operate on these
@@ -169,6 +222,43 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
     threadTimeout_ = timeout;
   }
 
+  /**
+   * Options to size the pool by how long its tasks wait in the queue.
+   *
+   * Every interval, the percentile of the waits of the tasks that ran is
+   * compared to two thresholds: above growAbove, numThreads() grows by
+   * growStep; below shrinkBelow for shrinkAfter intervals in a row, it
+   * shrinks by one.  The gap between the thresholds and the delay before
+   * shrinking keep the size from oscillating.
+   *
+   * As for dynamic pools, threads are started when tasks find no idle
+   * thread, up to numThreads(), and stopped once idle for idleTimeout, down
+   * to minThreads.
+   */
+  struct AutoscalingOptions {
+    AutoscalingOptions() {}
+
+    size_t minThreads{1};
+    // 0 for the current numThreads()
+    size_t maxThreads{0};
+    double percentile{0.9};
+    std::chrono::microseconds growAbove{std::chrono::milliseconds(1)};
+    std::chrono::microseconds shrinkBelow{100};
+    size_t growStep{1};
+    size_t shrinkAfter{10};
+    std::chrono::milliseconds interval{100};
+    std::chrono::milliseconds idleTimeout{std::chrono::seconds(10)};
+  };
+
+  /**
+   * Start sizing the pool with these options, or update them.  The pool
+   * is evaluated by its own threads after they run tasks: while no task
+   * runs, it keeps its size but its idle threads are still stopped.
+   *
+   * Meant for CPUThreadPoolExecutor, whose threads only time out when idle.
+   */
+  void setAutoscaling(const AutoscalingOptions& options);
+
  protected:
   // Prerequisite: threadListLock_ writelocked
   void addThreads(size_t n);
@@ -176,10 +266,12 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   void removeThreads(size_t n, bool isJoin);
 
   struct TaskStatsCallbackRegistry;
+  struct Autoscaler;
 
   struct alignas(folly::cacheline_align_v) Thread : public ThreadHandle {
     explicit Thread(ThreadPoolExecutor* pool)
-        : id(nextId++),
+        : pool(pool),
+          id(nextId++),
           handle(),
           idle(true),
           lastActiveTime(std::chrono::steady_clock::now()),
@@ -188,6 +280,7 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
     ~Thread() override = default;
 
     static std::atomic<uint64_t> nextId;
+    ThreadPoolExecutor* pool;
     uint64_t id;
     std::thread handle;
     bool idle;
@@ -213,6 +306,10 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
 
   static void runTask(const ThreadPtr& thread, Task&& task);
 
+  // Fires the task enqueue tracepoint, called by add() before the task is
+  // handed to a thread.
+  void traceTaskEnqueue(const Task& task);
+
   // The function that will be bound to pool threads. It must call
   // thread->startupBaton.post() when it's ready to consume work.
   virtual void threadRun(ThreadPtr thread) = 0;
@@ -239,6 +336,10 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   // Prerequisite: threadListLock_ readlocked or writelocked
   virtual size_t getPendingTaskCountImpl() const = 0;
 
+  // Whether tasks are waiting for the given thread, which is running one;
+  // for TimeSlice::shouldYield().
+  virtual bool hasPendingWork(const Thread& thread) const;
+
   class ThreadList {
    public:
     void add(const ThreadPtr& state) {
@@ -305,9 +406,26 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   StoppedThreadQueue stoppedThreads_;
   std::atomic<bool> isJoin_{false}; // whether the current downsizing is a join
 
+  struct TaskTimeEstimators {
+    TaskTimeEstimators(std::chrono::seconds windowDuration, size_t nWindows)
+        : waitTime(windowDuration, nWindows),
+          runTime(windowDuration, nWindows) {}
+
+    SlidingWindowQuantileEstimator<> waitTime;
+    SlidingWindowQuantileEstimator<> runTime;
+  };
+
   struct TaskStatsCallbackRegistry {
+    ~TaskStatsCallbackRegistry() {
+      delete estimators.load(std::memory_order_relaxed);
+      delete codel.load(std::memory_order_relaxed);
+    }
+
     folly::ThreadLocal<bool> inCallback;
     folly::Synchronized<std::vector<TaskStatsCallback>> callbackList;
+    // Set at most once, by enableTaskTimeEstimates() and enableCodel().
+    std::atomic<TaskTimeEstimators*> estimators{nullptr};
+    std::atomic<Codel*> codel{nullptr};
   };
   std::shared_ptr<TaskStatsCallbackRegistry> taskStatsCallbacks_;
   std::vector<std::shared_ptr<Observer>> observers_;
@@ -319,6 +437,13 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
   bool minActive();
   bool tryTimeoutThread();
 
+  void installCodel(std::unique_ptr<Codel> codel);
+
+  void autoscale(const TaskStats& stats);
+  // Prerequisite: threadListLock_ not held
+  void resizeForAutoscaling(size_t numThreads);
+  std::unique_ptr<Autoscaler> autoscaler_;
+
   // These are only modified while holding threadListLock_, but
   // are read without holding the lock.
   std::atomic<size_t> maxThreads_{0};
@@ -327,6 +452,8 @@ class ThreadPoolExecutor : public DefaultKeepAliveExecutor {
 
   std::atomic<size_t> threadsToJoin_{0};
   std::chrono::milliseconds threadTimeout_{0};
+  std::atomic<std::chrono::milliseconds> timeSlice_{
+      std::chrono::milliseconds(10)};
 
   void joinKeepAliveOnce() {
     if (!std::exchange(keepAliveJoined_, true)) {
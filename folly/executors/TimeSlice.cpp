@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/TimeSlice.h>
+
+namespace folly {
+
+namespace {
+thread_local TimeSlice::Scope* currentScope = nullptr;
+} // namespace
+
+TimeSlice::Scope::Scope(
+    Clock::duration slice,
+    FunctionRef<bool()> hasPendingWork) noexcept
+    : slice_(slice),
+      nextCheck_(Clock::now() + slice),
+      hasPendingWork_(hasPendingWork),
+      prev_(currentScope) {
+  currentScope = this;
+}
+
+TimeSlice::Scope::~Scope() {
+  currentScope = prev_;
+}
+
+bool TimeSlice::shouldYield() {
+  auto scope = currentScope;
+  if (!scope || scope->slice_ <= Clock::duration::zero()) {
+    return false;
+  }
+  auto now = Clock::now();
+  if (now < scope->nextCheck_) {
+    return false;
+  }
+  if (scope->hasPendingWork_()) {
+    return true;
+  }
+  // Nothing is waiting: check again a fraction of a slice later.
+  scope->nextCheck_ = now + scope->slice_ / 8;
+  return false;
+}
+
+} // namespace folly
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include <folly/Function.h>
+
+namespace folly {
+
+/**
+ * Cooperative time slicing for long tasks.
+ *
+ * Executors that support it run each task within a TimeSlice::Scope. A long
+ * task calls TimeSlice::shouldYield() periodically: it returns true once the
+ * task has used up its slice while other work is waiting behind it, and the
+ * task should then reschedule the rest of its work on its executor.
+ * Coroutines can co_await co_maybe_reschedule_on_current_executor and fibers
+ * can call fibers::yieldIfNeeded() to do that.
+ *
+ * Outside of a Scope, shouldYield() is always false.
+ */
+class TimeSlice {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  class Scope {
+   public:
+    // A zero slice never yields. hasPendingWork must outlive the Scope.
+    Scope(Clock::duration slice, FunctionRef<bool()> hasPendingWork) noexcept;
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    friend class TimeSlice;
+
+    Clock::duration slice_;
+    Clock::time_point nextCheck_;
+    FunctionRef<bool()> hasPendingWork_;
+    Scope* prev_;
+  };
+
+  static bool shouldYield();
+};
+
+} // namespace folly
@@ -24,6 +24,7 @@
 
 #include <folly/CPortability.h>
 #include <folly/Optional.h>
+#include <folly/Range.h>
 
 namespace folly {
 
@@ -51,6 +52,17 @@ class BlockingQueue {
   // for dynamically sizing thread pools), false otherwise.  Return false
   // if this feature is not supported.
   virtual BlockingQueueAddResult add(T item) = 0;
+  /*
+   * Adds the items, which are moved from.  The result's reusedThread is
+   * only set if every item was handed to a waiting thread.
+   */
+  virtual BlockingQueueAddResult addBatch(Range<T*> items) {
+    bool reused = true;
+    for (auto& item : items) {
+      reused = add(std::move(item)).reusedThread && reused;
+    }
+    return reused;
+  }
   virtual BlockingQueueAddResult addWithPriority(
       T item,
       int8_t /* priority */) {
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Function.h>
+#include <folly/Indestructible.h>
+#include <folly/executors/task_queue/BlockingQueue.h>
+#include <folly/io/async/Request.h>
+#include <folly/synchronization/LifoSem.h>
+
+namespace folly {
+
+/**
+ * Deadline of the work done in a RequestContext, for EDFBlockingQueue:
+ *
+ *   ShallowCopyRequestContextScopeGuard guard(
+ *       RequestDeadline::token(), std::make_unique<RequestDeadline>(d));
+ */
+class RequestDeadline : public RequestData {
+ public:
+  explicit RequestDeadline(std::chrono::steady_clock::time_point deadline)
+      : deadline_(deadline) {}
+
+  bool hasCallback() override {
+    return false;
+  }
+
+  std::chrono::steady_clock::time_point deadline() const {
+    return deadline_;
+  }
+
+  static const RequestToken& token() {
+    static Indestructible<RequestToken> token("folly::RequestDeadline");
+    return *token;
+  }
+
+  // max() if the context has no deadline
+  static std::chrono::steady_clock::time_point get(const RequestContext* ctx) {
+    auto data = ctx ? ctx->getContextData(token()) : nullptr;
+    return data ? static_cast<const RequestDeadline*>(data)->deadline()
+                : std::chrono::steady_clock::time_point::max();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point deadline_;
+};
+
+/**
+ * Earliest deadline first queue of CPUThreadPoolExecutor tasks.
+ *
+ * The deadline of a task is the end of its expiration, if it has one (see
+ * CPUThreadPoolExecutor::addWithDeadline()), or else the RequestDeadline of
+ * its RequestContext.  Tasks without either run after all the others, in
+ * FIFO order.  Higher priorities come first, each one ordered by deadline;
+ * priorities are mapped as by PriorityLifoSemMPMCQueue.
+ *
+ * Tasks whose deadline has passed when they are dequeued are dropped
+ * rather than run late: onExpired is invoked with them on the consumer
+ * thread, and runs their expire callback by default.
+ */
+template <class T>
+class EDFBlockingQueue : public BlockingQueue<T> {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit EDFBlockingQueue(
+      uint8_t numPriorities = 1,
+      Function<void(T&&)> onExpired = nullptr)
+      : onExpired_(std::move(onExpired)), queues_(numPriorities) {
+    CHECK_GT(numPriorities, 0);
+  }
+
+  uint8_t getNumPriorities() override {
+    return queues_.size();
+  }
+
+  BlockingQueueAddResult add(T item) override {
+    return addWithPriority(std::move(item), Executor::MID_PRI);
+  }
+
+  BlockingQueueAddResult addWithPriority(T item, int8_t priority) override {
+    int mid = getNumPriorities() / 2;
+    size_t queue = priority < 0
+        ? std::max(0, mid + priority)
+        : std::min(getNumPriorities() - 1, mid + priority);
+    auto deadline = deadlineOf(item);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto& heap = queues_[queue];
+      heap.push_back(Entry{deadline, sequence_++, std::move(item)});
+      std::push_heap(heap.begin(), heap.end(), Later());
+      ++size_;
+    }
+    return sem_.post();
+  }
+
+  T take() override {
+    while (true) {
+      sem_.wait();
+      T item;
+      if (pop(item)) {
+        return item;
+      }
+    }
+  }
+
+  folly::Optional<T> try_take_for(std::chrono::milliseconds time) override {
+    auto until = Clock::now() + time;
+    while (true) {
+      auto now = Clock::now();
+      if (!sem_.try_wait_for(
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  until > now ? until - now : Clock::duration(0)))) {
+        return folly::none;
+      }
+      T item;
+      if (pop(item)) {
+        return std::move(item);
+      }
+    }
+  }
+
+  size_t size() override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return size_;
+  }
+
+ private:
+  struct Entry {
+    Clock::time_point deadline;
+    uint64_t sequence;
+    T item;
+  };
+
+  struct Later {
+    bool operator()(const Entry& a, const Entry& b) const {
+      return a.deadline != b.deadline ? a.deadline > b.deadline
+                                      : a.sequence > b.sequence;
+    }
+  };
+
+  static Clock::time_point deadlineOf(const T& item) {
+    if (item.poison) {
+      return Clock::time_point::max();
+    }
+    if (item.expiration_ > std::chrono::milliseconds(0)) {
+      return item.enqueueTime_ + item.expiration_;
+    }
+    return RequestDeadline::get(item.context_.get());
+  }
+
+  // Takes the next task, after a successful wait on sem_; returns false if
+  // it was expired and dropped.
+  bool pop(T& item) {
+    Clock::time_point deadline;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto queue = std::find_if(
+          queues_.rbegin(), queues_.rend(), [](const std::vector<Entry>& q) {
+            return !q.empty();
+          });
+      DCHECK(queue != queues_.rend());
+      std::pop_heap(queue->begin(), queue->end(), Later());
+      deadline = queue->back().deadline;
+      item = std::move(queue->back().item);
+      queue->pop_back();
+      --size_;
+    }
+    if (deadline == Clock::time_point::max() || Clock::now() <= deadline) {
+      return true;
+    }
+    if (onExpired_) {
+      onExpired_(std::move(item));
+    } else if (item.expireCallback_) {
+      item.expireCallback_();
+    }
+    return false;
+  }
+
+  Function<void(T&&)> onExpired_;
+  LifoSem sem_;
+  std::mutex mutex_;
+  uint64_t sequence_{0};
+  size_t size_{0};
+  // one binary heap per priority, earliest deadline on top
+  std::vector<std::vector<Entry>> queues_;
+};
+
+} // namespace folly
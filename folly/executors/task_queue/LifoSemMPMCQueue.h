@@ -42,6 +42,27 @@ class LifoSemMPMCQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  BlockingQueueAddResult addBatch(Range<T*> items) override {
+    // the items written so far are posted before throwing or blocking
+    uint32_t written = 0;
+    for (auto& item : items) {
+      if (!queue_.writeIfNotFull(std::move(item))) {
+        sem_.post(written);
+        written = 0;
+        switch (kBehavior) { // static
+          case QueueBehaviorIfFull::THROW:
+            throw QueueFullException("LifoSemMPMCQueue full, can't add item");
+          case QueueBehaviorIfFull::BLOCK:
+            queue_.blockingWrite(std::move(item));
+            break;
+        }
+      }
+      ++written;
+    }
+    sem_.post(written);
+    return false;
+  }
+
   T take() override {
     T item;
     while (!queue_.readIfNotEmpty(item)) {
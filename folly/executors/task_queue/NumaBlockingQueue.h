@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <folly/concurrency/UnboundedQueue.h>
+#include <folly/executors/task_queue/BlockingQueue.h>
+#include <folly/executors/thread_factory/NumaThreadFactory.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/LifoSem.h>
+
+namespace folly {
+
+// A queue per NUMA node, for a CPUThreadPoolExecutor whose threads are
+// pinned to nodes by a NumaThreadFactory.
+//
+// Tasks are added to the queue of the node the calling thread runs on, and
+// threads take the tasks of their own node first, so that tasks run where
+// their data was produced. A thread whose node has no tasks left steals
+// from the other nodes, oldest first, rather than idling.
+//
+// A single semaphore counts the tasks of all nodes, so the thread that is
+// woken up for a task is not necessarily on its node; it only runs it if
+// the threads of that node are all busy.
+template <class T>
+class NumaBlockingQueue : public BlockingQueue<T> {
+ public:
+  explicit NumaBlockingQueue(
+      size_t numNodes = NumaThreadFactory::systemNodes())
+      : nodes_(std::max<size_t>(numNodes, 1)) {}
+
+  BlockingQueueAddResult add(T item) override {
+    nodes_[NumaThreadFactory::currentNode(nodes_.size())].queue.enqueue(
+        std::move(item));
+    return sem_.post();
+  }
+
+  T take() override {
+    sem_.wait();
+    return dequeue();
+  }
+
+  folly::Optional<T> try_take_for(std::chrono::milliseconds time) override {
+    if (!sem_.try_wait_for(time)) {
+      return folly::none;
+    }
+    return dequeue();
+  }
+
+  size_t size() override {
+    size_t size = 0;
+    for (auto& node : nodes_) {
+      size += node.queue.size();
+    }
+    return size;
+  }
+
+ private:
+  struct alignas(hardware_destructive_interference_size) Node {
+    UMPMCQueue<T, false, 6> queue;
+  };
+
+  // The semaphore guarantees that a task is left for this thread, though
+  // it may have to look again if another thread takes it first.
+  T dequeue() {
+    auto own = NumaThreadFactory::currentNode(nodes_.size());
+    while (true) {
+      for (size_t i = 0; i < nodes_.size(); ++i) {
+        auto item = nodes_[(own + i) % nodes_.size()].queue.try_dequeue();
+        if (item) {
+          return std::move(*item);
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  LifoSem sem_;
+  std::vector<Node> nodes_;
+};
+
+} // namespace folly
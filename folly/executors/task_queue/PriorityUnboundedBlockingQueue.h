@@ -30,8 +30,13 @@ class PriorityUnboundedBlockingQueue : public BlockingQueue<T> {
  public:
   // Note: To use folly::Executor::*_PRI, for numPriorities == 2
   //       MID_PRI and HI_PRI are treated at the same priority level.
-  explicit PriorityUnboundedBlockingQueue(uint8_t numPriorities)
-      : queue_(numPriorities) {}
+  // With a non-zero agingInterval, every agingInterval-th take() serves
+  // priorities in turn rather than the highest non-empty one, so that
+  // lower priorities are not starved under sustained load.
+  explicit PriorityUnboundedBlockingQueue(
+      uint8_t numPriorities,
+      size_t agingInterval = 0)
+      : queue_(numPriorities, agingInterval) {}
 
   uint8_t getNumPriorities() override {
     return queue_.priorities();
@@ -43,7 +48,7 @@ class PriorityUnboundedBlockingQueue : public BlockingQueue<T> {
   }
 
   BlockingQueueAddResult addWithPriority(T item, int8_t priority) override {
-    queue_.at_priority(translatePriority(priority)).enqueue(std::move(item));
+    queue_.enqueue(translatePriority(priority), std::move(item));
     return sem_.post();
   }
 
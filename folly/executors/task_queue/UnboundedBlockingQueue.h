@@ -32,6 +32,14 @@ class UnboundedBlockingQueue : public BlockingQueue<T> {
     return sem_.post();
   }
 
+  BlockingQueueAddResult addBatch(Range<T*> items) override {
+    for (auto& item : items) {
+      queue_.enqueue(std::move(item));
+    }
+    sem_.post(items.size());
+    return false;
+  }
+
   T take() override {
     sem_.wait();
     return queue_.dequeue();
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <folly/SpinLock.h>
+#include <folly/ThreadLocal.h>
+#include <folly/executors/task_queue/BlockingQueue.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/LifoSem.h>
+
+namespace folly {
+
+// A queue with a deque per consumer thread, for thread pools whose tasks
+// add many more tasks.
+//
+// Each thread that takes from the queue is given a deque of its own. The
+// tasks it adds go to that deque, and it takes the newest of them first, so
+// that fan-out tasks run on the thread (and cache) that created them. When
+// its deque is empty, a thread steals the oldest task of another deque.
+// Tasks added by other threads are spread over the deques in turn, so
+// producers and consumers contend on numSlots locks instead of one queue.
+//
+// Consumer threads beyond numSlots share deques. There are no priorities,
+// and tasks are not taken in the order they were added.
+template <class T>
+class WorkStealingBlockingQueue : public BlockingQueue<T> {
+ public:
+  explicit WorkStealingBlockingQueue(
+      size_t numSlots = std::thread::hardware_concurrency())
+      : slots_(std::max<size_t>(numSlots, 1)) {}
+
+  BlockingQueueAddResult add(T item) override {
+    auto& slot = slots_[addSlot()];
+    {
+      std::lock_guard<SpinLock> guard(slot.lock);
+      slot.tasks.push_back(std::move(item));
+      slot.size.store(slot.tasks.size(), std::memory_order_release);
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return sem_.post();
+  }
+
+  T take() override {
+    sem_.wait();
+    return dequeue();
+  }
+
+  folly::Optional<T> try_take_for(std::chrono::milliseconds time) override {
+    if (!sem_.try_wait_for(time)) {
+      return folly::none;
+    }
+    return dequeue();
+  }
+
+  size_t size() override {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(hardware_destructive_interference_size) Slot {
+    SpinLock lock;
+    std::deque<T> tasks;
+    // read without the lock by thieves
+    std::atomic<size_t> size{0};
+  };
+
+  // 0 until the thread takes from the queue, then its slot plus one
+  struct LocalSlot {
+    size_t slot{0};
+  };
+
+  size_t addSlot() {
+    auto local = localSlot_->slot;
+    if (local != 0) {
+      return local - 1;
+    }
+    return nextAddSlot_.fetch_add(1, std::memory_order_relaxed) %
+        slots_.size();
+  }
+
+  size_t takeSlot() {
+    auto& local = localSlot_->slot;
+    if (local == 0) {
+      local = nextTakeSlot_.fetch_add(1, std::memory_order_relaxed) %
+              slots_.size() +
+          1;
+    }
+    return local - 1;
+  }
+
+  folly::Optional<T> tryPop(Slot& slot, bool newest) {
+    if (slot.size.load(std::memory_order_acquire) == 0) {
+      return folly::none;
+    }
+    std::lock_guard<SpinLock> guard(slot.lock);
+    if (slot.tasks.empty()) {
+      return folly::none;
+    }
+    folly::Optional<T> item;
+    if (newest) {
+      item = std::move(slot.tasks.back());
+      slot.tasks.pop_back();
+    } else {
+      item = std::move(slot.tasks.front());
+      slot.tasks.pop_front();
+    }
+    slot.size.store(slot.tasks.size(), std::memory_order_release);
+    return item;
+  }
+
+  // The semaphore guarantees that a task is left for this thread, though
+  // it may have to look again if another thread takes it first.
+  T dequeue() {
+    auto own = takeSlot();
+    while (true) {
+      auto item = tryPop(slots_[own], true);
+      for (size_t i = 1; !item && i < slots_.size(); ++i) {
+        item = tryPop(slots_[(own + i) % slots_.size()], false);
+      }
+      if (item) {
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return std::move(*item);
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  LifoSem sem_;
+  std::vector<Slot> slots_;
+  ThreadLocal<LocalSlot> localSlot_;
+  std::atomic<size_t> nextAddSlot_{0};
+  std::atomic<size_t> nextTakeSlot_{0};
+  std::atomic<size_t> size_{0};
+};
+
+} // namespace folly
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/task_queue/EDFBlockingQueue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+using namespace std::chrono;
+
+using CPUTask = CPUThreadPoolExecutor::CPUTask;
+
+namespace {
+CPUTask makeTask(int value, std::vector<int>& ran, milliseconds expiration) {
+  return CPUTask([&ran, value] { ran.push_back(value); }, expiration, nullptr);
+}
+
+void runAll(EDFBlockingQueue<CPUTask>& q) {
+  while (auto task = q.try_take_for(milliseconds(0))) {
+    task->func_();
+  }
+}
+} // namespace
+
+TEST(EDFBlockingQueue, deadline_order) {
+  EDFBlockingQueue<CPUTask> q;
+  std::vector<int> ran;
+  q.add(makeTask(0, ran, milliseconds(0)));
+  q.add(makeTask(1, ran, seconds(30)));
+  q.add(makeTask(2, ran, seconds(10)));
+  q.add(makeTask(3, ran, milliseconds(0)));
+  q.add(makeTask(4, ran, seconds(20)));
+  EXPECT_EQ(5, q.size());
+  runAll(q);
+  // tasks without deadline last, in FIFO order
+  EXPECT_EQ(std::vector<int>({2, 4, 1, 0, 3}), ran);
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(EDFBlockingQueue, request_deadline) {
+  EDFBlockingQueue<CPUTask> q;
+  std::vector<int> ran;
+  {
+    ShallowCopyRequestContextScopeGuard guard(
+        RequestDeadline::token(),
+        std::make_unique<RequestDeadline>(steady_clock::now() + seconds(20)));
+    q.add(makeTask(0, ran, milliseconds(0)));
+  }
+  q.add(makeTask(1, ran, seconds(30)));
+  q.add(makeTask(2, ran, seconds(10)));
+  runAll(q);
+  EXPECT_EQ(std::vector<int>({2, 0, 1}), ran);
+}
+
+TEST(EDFBlockingQueue, priorities) {
+  EDFBlockingQueue<CPUTask> q(3);
+  std::vector<int> ran;
+  q.addWithPriority(makeTask(0, ran, seconds(10)), Executor::LO_PRI);
+  q.addWithPriority(makeTask(1, ran, seconds(20)), Executor::HI_PRI);
+  q.addWithPriority(makeTask(2, ran, seconds(10)), Executor::MID_PRI);
+  q.addWithPriority(makeTask(3, ran, seconds(10)), Executor::HI_PRI);
+  runAll(q);
+  EXPECT_EQ(std::vector<int>({3, 1, 2, 0}), ran);
+}
+
+TEST(EDFBlockingQueue, expired) {
+  std::vector<int> expired;
+  EDFBlockingQueue<CPUTask> q(1, [&](CPUTask&& task) {
+    task.expireCallback_();
+    expired.push_back(-1);
+  });
+  std::vector<int> ran;
+  q.add(CPUTask(
+      [&] { ran.push_back(0); },
+      milliseconds(1),
+      [&] { expired.push_back(0); }));
+  q.add(makeTask(1, ran, seconds(10)));
+  /* sleep override */ std::this_thread::sleep_for(milliseconds(5));
+  runAll(q);
+  EXPECT_EQ(std::vector<int>({0, -1}), expired);
+  EXPECT_EQ(std::vector<int>({1}), ran);
+}
+
+TEST(EDFBlockingQueue, executor) {
+  CPUThreadPoolExecutor executor(
+      1,
+      std::make_unique<EDFBlockingQueue<CPUTask>>(),
+      std::make_shared<NamedThreadFactory>("EDF"));
+  Baton<> started, blocked;
+  executor.add([&] {
+    started.post();
+    blocked.wait();
+  });
+  started.wait();
+
+  std::vector<int> ran;
+  std::atomic<int> expired{0};
+  auto now = steady_clock::now();
+  executor.addWithDeadline(
+      [&] { ran.push_back(0); }, now + seconds(30), [&] { expired++; });
+  executor.addWithDeadline(
+      [&] { ran.push_back(1); }, now + seconds(10), [&] { expired++; });
+  executor.addWithDeadline(
+      [&] { ran.push_back(2); }, now + milliseconds(5), [&] { expired++; });
+  executor.addWithDeadline(
+      [&] { ran.push_back(3); }, now - seconds(1), [&] { expired++; });
+  // already expired
+  EXPECT_EQ(1, expired);
+
+  /* sleep override */ std::this_thread::sleep_for(milliseconds(20));
+  blocked.post();
+  executor.join();
+  EXPECT_EQ(std::vector<int>({1, 0}), ran);
+  EXPECT_EQ(2, expired);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/task_queue/NumaBlockingQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+TEST(NumaBlockingQueue, push_pop) {
+  NumaBlockingQueue<int> q(2);
+  q.add(42);
+  q.add(43);
+  EXPECT_EQ(2, q.size());
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(43, q.take());
+  EXPECT_EQ(0, q.size());
+  EXPECT_FALSE(q.try_take_for(std::chrono::milliseconds(1)));
+}
+
+TEST(NumaBlockingQueue, concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int kItems = 10000;
+  NumaBlockingQueue<int> q(4);
+  std::vector<std::atomic<int>> seen(kItems);
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; ++t) {
+    consumers.emplace_back([&] {
+      for (int item; (item = q.take()) >= 0;) {
+        seen[item].fetch_add(1);
+      }
+    });
+  }
+  for (int i = 0; i < kItems; ++i) {
+    q.add(i);
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    q.add(-1);
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  for (auto& count : seen) {
+    EXPECT_EQ(1, count.load());
+  }
+}
+
+TEST(NumaThreadFactory, nodes) {
+  auto numNodes = NumaThreadFactory::systemNodes();
+  ASSERT_GE(numNodes, 1);
+  std::vector<bool> cpus(CacheLocality::system().numCpus);
+  for (size_t node = 0; node < numNodes; ++node) {
+    auto nodeCpus = NumaThreadFactory::nodeCpus(node, numNodes);
+    EXPECT_FALSE(nodeCpus.empty());
+    for (auto cpu : nodeCpus) {
+      EXPECT_FALSE(cpus[cpu]);
+      cpus[cpu] = true;
+    }
+  }
+  EXPECT_EQ(cpus.end(), std::find(cpus.begin(), cpus.end(), false));
+  EXPECT_LT(NumaThreadFactory::currentNode(numNodes), numNodes);
+}
+
+TEST(NumaThreadFactory, executor) {
+  CPUThreadPoolExecutor executor(
+      4,
+      std::make_unique<NumaBlockingQueue<CPUThreadPoolExecutor::CPUTask>>(),
+      std::make_shared<NumaThreadFactory>(
+          std::make_shared<NamedThreadFactory>("NumaPool")));
+  std::atomic<int> done{0};
+  Baton<> baton;
+  for (int i = 0; i < 100; ++i) {
+    executor.add([&] {
+      if (++done == 100) {
+        baton.post();
+      }
+    });
+  }
+  baton.wait();
+  executor.join();
+  EXPECT_EQ(100, done.load());
+}
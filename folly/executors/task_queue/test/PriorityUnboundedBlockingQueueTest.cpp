@@ -79,6 +79,23 @@ TEST_F(PriorityUnboundedBlockingQueueTest, priority_order) {
   EXPECT_EQ(0, q.size());
 }
 
+TEST_F(PriorityUnboundedBlockingQueueTest, aging) {
+  PriorityUnboundedBlockingQueue<int> q(3, /* agingInterval = */ 2);
+  q.addWithPriority(1, -1);
+  for (int i = 0; i < 4; ++i) {
+    q.addWithPriority(3, 1);
+  }
+  q.addWithPriority(2, 0);
+  // every 2nd take starts at the next priority in turn
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(2, q.take());
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(1, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
 // Since PriorityUnboundedBlockingQueue implements folly::BlockingQueue<T>,
 // addWithPriority method has to accept priority as int_8. This means invalid
 // values for priority (such as negative or very large numbers) might get
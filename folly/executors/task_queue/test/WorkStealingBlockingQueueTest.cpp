@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/executors/task_queue/WorkStealingBlockingQueue.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+
+TEST(WorkStealingBlockingQueue, push_pop) {
+  WorkStealingBlockingQueue<int> q(4);
+  q.add(42);
+  EXPECT_EQ(1, q.size());
+  EXPECT_EQ(42, q.take());
+  EXPECT_EQ(0, q.size());
+  EXPECT_FALSE(q.try_take_for(std::chrono::milliseconds(1)));
+}
+
+TEST(WorkStealingBlockingQueue, local_lifo_steal_fifo) {
+  WorkStealingBlockingQueue<int> q(4);
+  // taking makes this thread a consumer with a deque of its own
+  q.add(0);
+  EXPECT_EQ(0, q.take());
+  for (int i = 1; i <= 4; ++i) {
+    q.add(i);
+  }
+  EXPECT_EQ(4, q.take());
+
+  std::thread([&] {
+    EXPECT_EQ(1, q.take());
+    EXPECT_EQ(2, q.take());
+  }).join();
+  EXPECT_EQ(3, q.take());
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(WorkStealingBlockingQueue, concurrent) {
+  constexpr int kThreads = 8;
+  constexpr int kItems = 10000;
+  WorkStealingBlockingQueue<int> q(kThreads / 2);
+  std::vector<std::atomic<int>> seen(kItems * 2);
+  std::atomic<int> processed{0};
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; ++t) {
+    consumers.emplace_back([&] {
+      while (true) {
+        auto item = q.take();
+        if (item < 0) {
+          return;
+        }
+        // consumers add more items, which stay local or get stolen
+        if (item < kItems) {
+          q.add(item + kItems);
+        }
+        seen[item].fetch_add(1);
+        ++processed;
+      }
+    });
+  }
+  for (int i = 0; i < kItems; ++i) {
+    q.add(i);
+  }
+  while (processed.load() < kItems * 2) {
+    std::this_thread::yield();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    q.add(-1);
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  for (auto& count : seen) {
+    EXPECT_EQ(1, count.load());
+  }
+}
+
+TEST(WorkStealingBlockingQueue, executor) {
+  CPUThreadPoolExecutor executor(
+      4,
+      std::make_unique<
+          WorkStealingBlockingQueue<CPUThreadPoolExecutor::CPUTask>>(4));
+  std::atomic<int> done{0};
+  Baton<> baton;
+  for (int i = 0; i < 10; ++i) {
+    executor.add([&] {
+      for (int j = 0; j < 100; ++j) {
+        executor.add([&] {
+          if (++done == 1000) {
+            baton.post();
+          }
+        });
+      }
+    });
+  }
+  baton.wait();
+  executor.join();
+  EXPECT_EQ(1000, done.load());
+}
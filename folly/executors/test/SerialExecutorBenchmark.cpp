@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+using folly::SerialExecutor;
+
+namespace {
+
+// Many sessions, each with its own SerialExecutor, adding small tasks to a
+// shared pool.
+void sessions(size_t iters, size_t numSessions, size_t maxTasksPerDispatch) {
+  folly::BenchmarkSuspender suspender;
+  folly::CPUThreadPoolExecutor pool(4);
+  std::vector<folly::Executor::KeepAlive<SerialExecutor>> executors;
+  for (size_t i = 0; i < numSessions; ++i) {
+    auto parent = folly::getKeepAliveToken(&pool);
+    executors.push_back(
+        maxTasksPerDispatch > 0
+            ? SerialExecutor::create(std::move(parent), maxTasksPerDispatch)
+            : SerialExecutor::create(std::move(parent)));
+  }
+  std::atomic<size_t> remaining{iters};
+  folly::Baton<> done;
+  suspender.dismiss();
+
+  for (size_t i = 0; i < iters; ++i) {
+    executors[i % numSessions]->add([&] {
+      if (--remaining == 0) {
+        done.post();
+      }
+    });
+  }
+  if (iters > 0) {
+    done.wait();
+  }
+
+  suspender.rehire();
+  executors.clear();
+  pool.join();
+}
+
+} // namespace
+
+#define SERIAL_BENCHMARKS(numSessions)                             \
+  BENCHMARK(perTask_##numSessions##_sessions, iters) {             \
+    sessions(iters, numSessions, 0);                               \
+  }                                                                \
+  BENCHMARK_RELATIVE(batched16_##numSessions##_sessions, iters) {  \
+    sessions(iters, numSessions, 16);                              \
+  }                                                                \
+  BENCHMARK_RELATIVE(batched256_##numSessions##_sessions, iters) { \
+    sessions(iters, numSessions, 256);                             \
+  }
+
+SERIAL_BENCHMARKS(1)
+BENCHMARK_DRAW_LINE();
+SERIAL_BENCHMARKS(64)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -33,7 +33,18 @@ void burnMs(uint64_t ms) {
 }
 } // namespace
 
-void simpleTest(std::shared_ptr<folly::Executor> const& parent) {
+folly::Executor::KeepAlive<SerialExecutor> createSerialExecutor(
+    std::shared_ptr<folly::Executor> const& parent,
+    size_t maxTasksPerDispatch) {
+  auto keepAlive = folly::getKeepAliveToken(parent.get());
+  return maxTasksPerDispatch > 0
+      ? SerialExecutor::create(std::move(keepAlive), maxTasksPerDispatch)
+      : SerialExecutor::create(std::move(keepAlive));
+}
+
+void simpleTest(
+    std::shared_ptr<folly::Executor> const& parent,
+    size_t maxTasksPerDispatch = 0) {
   class SerialExecutorContextData : public folly::RequestData {
    public:
     static std::string kCtxKey() {
@@ -51,8 +62,7 @@ void simpleTest(std::shared_ptr<folly::Executor> const& parent) {
     const int id_;
   };
 
-  auto executor =
-      SerialExecutor::create(folly::getKeepAliveToken(parent.get()));
+  auto executor = createSerialExecutor(parent, maxTasksPerDispatch);
 
   std::vector<int> values;
   std::vector<int> expected;
@@ -95,6 +105,12 @@ TEST(SerialExecutor, Simple) {
 TEST(SerialExecutor, SimpleInline) {
   simpleTest(std::make_shared<folly::InlineExecutor>());
 }
+TEST(SerialExecutor, SimpleBatched) {
+  simpleTest(std::make_shared<folly::CPUThreadPoolExecutor>(4), 3);
+}
+TEST(SerialExecutor, SimpleInlineBatched) {
+  simpleTest(std::make_shared<folly::InlineExecutor>(), 3);
+}
 
 // The Afterlife test only works with an asynchronous executor (not the
 // InlineExecutor), because we want execution of tasks to happen after we
@@ -136,9 +152,10 @@ TEST(SerialExecutor, Afterlife) {
   EXPECT_EQ(expected, values);
 }
 
-void RecursiveAddTest(std::shared_ptr<folly::Executor> const& parent) {
-  auto executor =
-      SerialExecutor::create(folly::getKeepAliveToken(parent.get()));
+void RecursiveAddTest(
+    std::shared_ptr<folly::Executor> const& parent,
+    size_t maxTasksPerDispatch = 0) {
+  auto executor = createSerialExecutor(parent, maxTasksPerDispatch);
 
   folly::Baton<> finished_baton;
 
@@ -180,6 +197,75 @@ TEST(SerialExecutor, RecursiveAdd) {
 TEST(SerialExecutor, RecursiveAddInline) {
   RecursiveAddTest(std::make_shared<folly::InlineExecutor>());
 }
+TEST(SerialExecutor, RecursiveAddBatched) {
+  RecursiveAddTest(std::make_shared<folly::CPUThreadPoolExecutor>(4), 2);
+}
+TEST(SerialExecutor, RecursiveAddInlineBatched) {
+  RecursiveAddTest(std::make_shared<folly::InlineExecutor>(), 2);
+}
+
+namespace {
+// Runs its tasks when asked, and records the priorities they were added
+// with (MID_PRI for add()).
+class RecordingExecutor : public folly::Executor {
+ public:
+  void add(folly::Func func) override {
+    addWithPriority(std::move(func), MID_PRI);
+  }
+  void addWithPriority(folly::Func func, int8_t priority) override {
+    funcs.push_back(std::move(func));
+    priorities.push_back(priority);
+  }
+  uint8_t getNumPriorities() const override {
+    return 3;
+  }
+
+  void runOne() {
+    auto func = std::move(funcs.front());
+    funcs.erase(funcs.begin());
+    func();
+  }
+
+  std::vector<folly::Func> funcs;
+  std::vector<int8_t> priorities;
+};
+} // namespace
+
+TEST(SerialExecutor, BatchedDispatch) {
+  RecordingExecutor parent;
+  auto executor =
+      SerialExecutor::create(folly::getKeepAliveToken(&parent), 2);
+  std::vector<int> values;
+  for (int i = 0; i < 5; ++i) {
+    executor->addWithPriority(
+        [i, &values] { values.push_back(i); },
+        i < 2 ? folly::Executor::LO_PRI : folly::Executor::HI_PRI);
+  }
+  // a single task in the parent while tasks are queued
+  ASSERT_EQ(1, parent.funcs.size());
+  parent.runOne();
+  EXPECT_EQ(std::vector<int>({0, 1}), values);
+  // dispatched again with the priority of the next task
+  ASSERT_EQ(1, parent.funcs.size());
+  parent.runOne();
+  parent.runOne();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), values);
+  EXPECT_TRUE(parent.funcs.empty());
+  EXPECT_EQ(
+      std::vector<int8_t>(
+          {folly::Executor::LO_PRI,
+           folly::Executor::HI_PRI,
+           folly::Executor::HI_PRI}),
+      parent.priorities);
+
+  // empty again: the next task is dispatched right away
+  executor->add([&values] { values.push_back(5); });
+  ASSERT_EQ(1, parent.funcs.size());
+  executor.reset();
+  parent.runOne();
+  EXPECT_EQ(6, values.size());
+  EXPECT_EQ(folly::Executor::MID_PRI, parent.priorities.back());
+}
 
 TEST(SerialExecutor, ExecutionThrows) {
   auto executor = SerialExecutor::create();
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <thread>
@@ -27,9 +28,11 @@
 #include <folly/executors/FutureExecutor.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/ThreadPoolExecutor.h>
+#include <folly/executors/TimeSlice.h>
 #include <folly/executors/task_queue/LifoSemMPMCQueue.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 #include <folly/executors/thread_factory/InitThreadFactory.h>
+#include <folly/executors/thread_factory/NumaThreadFactory.h>
 #include <folly/executors/thread_factory/PriorityThreadFactory.h>
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/detail/Spin.h>
@@ -291,6 +294,122 @@ TEST(ThreadPoolExecutorTest, EDFTaskStats) {
   taskStats<EDFThreadPoolExecutor>();
 }
 
+template <class TPE>
+static void taskTimeEstimates() {
+  TPE tpe(1);
+  const std::array<double, 2> quantiles{{0.5, 0.99}};
+  auto estimates = tpe.getTaskTimeEstimates(quantiles);
+  EXPECT_EQ(0, estimates.runTime.count);
+  EXPECT_TRUE(estimates.runTime.quantiles.empty());
+
+  tpe.enableTaskTimeEstimates();
+  for (int i = 0; i < 10; i++) {
+    tpe.add(burnMs(1));
+  }
+  tpe.join();
+  estimates = tpe.getTaskTimeEstimates(quantiles);
+  EXPECT_EQ(10, estimates.waitTime.count);
+  EXPECT_EQ(10, estimates.runTime.count);
+  ASSERT_EQ(2, estimates.runTime.quantiles.size());
+  EXPECT_GE(
+      estimates.runTime.quantiles[0].second,
+      duration_cast<nanoseconds>(milliseconds(1)).count());
+  EXPECT_LE(
+      estimates.waitTime.quantiles[0].second,
+      estimates.waitTime.quantiles[1].second);
+  // later tasks waited for the earlier ones
+  EXPECT_GE(
+      estimates.waitTime.quantiles[1].second,
+      duration_cast<nanoseconds>(milliseconds(5)).count());
+}
+
+TEST(ThreadPoolExecutorTest, CPUTaskTimeEstimates) {
+  taskTimeEstimates<CPUThreadPoolExecutor>();
+}
+
+TEST(ThreadPoolExecutorTest, IOTaskTimeEstimates) {
+  taskTimeEstimates<IOThreadPoolExecutor>();
+}
+
+template <class TPE>
+static void addBatch() {
+  TPE tpe(4);
+  std::atomic<int> completed(0);
+  std::vector<Func> funcs;
+  for (int i = 0; i < 100; i++) {
+    funcs.emplace_back([&] { completed++; });
+  }
+  tpe.addBatch(range(funcs));
+  tpe.addBatch(Range<Func*>());
+  tpe.join();
+  EXPECT_EQ(100, completed);
+}
+
+TEST(ThreadPoolExecutorTest, CPUAddBatch) {
+  addBatch<CPUThreadPoolExecutor>();
+}
+
+TEST(ThreadPoolExecutorTest, IOAddBatch) {
+  addBatch<IOThreadPoolExecutor>();
+}
+
+TEST(ThreadPoolExecutorTest, IOLocalEventBaseSelection) {
+  IOThreadPoolExecutor tpe(4);
+  auto pinned = tpe.getEventBase();
+  tpe.setEventBaseSelection(IOThreadPoolExecutor::EventBaseSelection::Local);
+  EXPECT_NE(nullptr, tpe.getEventBase());
+
+  RequestContextScopeGuard guard;
+  RequestEventBase::set(pinned);
+  std::atomic<int> onPinned(0);
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(pinned, tpe.getEventBase());
+    tpe.add([&] {
+      if (EventBaseManager::get()->getExistingEventBase() == pinned) {
+        onPinned++;
+      }
+    });
+  }
+  tpe.join();
+  EXPECT_EQ(8, onPinned);
+}
+
+TEST(ThreadPoolExecutorTest, IOLocalEventBaseSelectionNuma) {
+  IOThreadPoolExecutor tpe(
+      4,
+      std::make_shared<NumaThreadFactory>(
+          std::make_shared<NamedThreadFactory>("IOThreadPool")));
+  tpe.setEventBaseSelection(IOThreadPoolExecutor::EventBaseSelection::Local);
+  for (size_t numThreads : {4, 1, 3}) {
+    tpe.setNumThreads(numThreads);
+    std::atomic<int> ran(0);
+    for (int i = 0; i < 8; i++) {
+      EXPECT_NE(nullptr, tpe.getEventBase());
+      tpe.add([&] { ran++; });
+    }
+    while (ran < 8) {
+      std::this_thread::yield();
+    }
+  }
+  tpe.join();
+}
+
+TEST(ThreadPoolExecutorTest, AddBatchStartsThreads) {
+  CPUThreadPoolExecutor tpe(
+      std::make_pair<size_t, size_t>(4, 0),
+      std::make_shared<NamedThreadFactory>("CPUThreadPool"));
+  EXPECT_EQ(0, tpe.numActiveThreads());
+  boost::barrier barrier{5};
+  std::vector<Func> funcs;
+  for (int i = 0; i < 4; i++) {
+    funcs.emplace_back([&] { barrier.wait(); });
+  }
+  tpe.addBatch(range(funcs));
+  // all four tasks run at the same time
+  barrier.wait();
+  tpe.join();
+}
+
 template <class TPE>
 static void expiration() {
   TPE tpe(1);
@@ -314,6 +433,34 @@ static void expiration() {
   EXPECT_EQ(1, expireCbCount);
 }
 
+template <class TPE>
+static void codel() {
+  TPE tpe(1);
+  EXPECT_EQ(nullptr, tpe.getCodel());
+  tpe.enableCodel(Codel::Options()
+                      .setInterval(milliseconds(5))
+                      .setTargetDelay(milliseconds(1)));
+  ASSERT_NE(nullptr, tpe.getCodel());
+  std::atomic<int> ran(0);
+  std::atomic<int> expired(0);
+  for (int i = 0; i < 100; i++) {
+    tpe.add([&] { burnMs(2)(), ran++; }, seconds(60), [&] { expired++; });
+  }
+  tpe.join();
+  EXPECT_EQ(100, ran + expired);
+  // the standing queue was shed
+  EXPECT_GT(ran, 0);
+  EXPECT_GT(expired, 0);
+}
+
+TEST(ThreadPoolExecutorTest, CPUCodel) {
+  codel<CPUThreadPoolExecutor>();
+}
+
+TEST(ThreadPoolExecutorTest, IOCodel) {
+  codel<IOThreadPoolExecutor>();
+}
+
 TEST(ThreadPoolExecutorTest, CPUExpiration) {
   expiration<CPUThreadPoolExecutor>();
 }
@@ -903,6 +1050,83 @@ TEST(ThreadPoolExecutorTest, DynamicThreadAddRemoveRace) {
   EXPECT_EQ(count, 10000);
 }
 
+TEST(ThreadPoolExecutorTest, Autoscaling) {
+  CPUThreadPoolExecutor e(1);
+  ThreadPoolExecutor::AutoscalingOptions options;
+  options.maxThreads = 4;
+  options.growAbove = std::chrono::milliseconds(1);
+  options.shrinkBelow = std::chrono::milliseconds(1);
+  options.shrinkAfter = 3;
+  options.interval = std::chrono::milliseconds(10);
+  options.idleTimeout = std::chrono::milliseconds(10);
+  e.setAutoscaling(options);
+  EXPECT_EQ(1, e.numThreads());
+
+  // Tasks wait behind each other until the pool has grown.
+  for (int i = 0; i < 200; i++) {
+    e.add(burnMs(2));
+  }
+  auto grown = [&] { return e.numThreads() == 4; };
+  EXPECT_EQ(
+      folly::detail::spin_result::success,
+      folly::detail::spin_yield_until(
+          std::chrono::steady_clock::now() + std::chrono::seconds(5), grown));
+  auto stats = e.getPoolStats();
+  EXPECT_GT(stats.queueWaitP90.count(), 0);
+  EXPECT_LE(stats.queueWaitP50, stats.queueWaitP90);
+  EXPECT_LE(stats.queueWaitP90, stats.queueWaitP99);
+
+  // Tasks that do not wait shrink it back, one thread at a time.
+  auto start = std::chrono::steady_clock::now();
+  while (e.numThreads() > 1 &&
+         std::chrono::steady_clock::now() < start + std::chrono::seconds(5)) {
+    Baton<> b;
+    e.add([&] { b.post(); });
+    b.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(1, e.numThreads());
+  e.join();
+}
+
+template <class TPE>
+static void timeSliceTest() {
+  TPE e(1);
+  e.setTimeSlice(std::chrono::milliseconds(1));
+  EXPECT_FALSE(TimeSlice::shouldYield());
+
+  // Nothing else is waiting for the thread.
+  bool yielded = true;
+  e.add([&] {
+    burnMs(5)();
+    yielded = TimeSlice::shouldYield();
+  });
+  e.join();
+  EXPECT_FALSE(yielded);
+
+  TPE e2(1);
+  e2.setTimeSlice(std::chrono::milliseconds(1));
+  Baton<> added;
+  yielded = false;
+  e2.add([&] {
+    added.wait();
+    burnMs(5)();
+    yielded = TimeSlice::shouldYield();
+  });
+  e2.add([] {});
+  added.post();
+  e2.join();
+  EXPECT_TRUE(yielded);
+}
+
+TEST(ThreadPoolExecutorTest, CPUTimeSlice) {
+  timeSliceTest<CPUThreadPoolExecutor>();
+}
+
+TEST(ThreadPoolExecutorTest, IOTimeSlice) {
+  timeSliceTest<IOThreadPoolExecutor>();
+}
+
 TEST(ThreadPoolExecutorTest, AddPerf) {
   auto queue = std::make_unique<
       UnboundedBlockingQueue<CPUThreadPoolExecutor::CPUTask>>();
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <folly/String.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/executors/thread_factory/ThreadFactory.h>
+#include <folly/portability/Sched.h>
+
+namespace folly {
+
+/**
+ * A ThreadFactory that spreads threads over the NUMA nodes of the system
+ * and pins each thread to the cpus of its node, so that the memory it
+ * allocates and the caches it warms stay local.  Use it with
+ * NumaBlockingQueue to keep the tasks of a CPUThreadPoolExecutor on the
+ * node they were added from.
+ *
+ * Nodes are approximated by the last-level caches that CacheLocality
+ * finds, which on the usual multi-socket hosts means one per socket.  When
+ * CacheLocality cannot read the cache topology, there is a single node.
+ * Threads are only pinned on Linux.
+ */
+class NumaThreadFactory : public ThreadFactory {
+ public:
+  explicit NumaThreadFactory(
+      std::shared_ptr<ThreadFactory> factory,
+      size_t numNodes = systemNodes())
+      : factory_(std::move(factory)),
+        numNodes_(std::max<size_t>(numNodes, 1)) {}
+
+  std::thread newThread(Func&& func) override {
+    auto node = nextNode_.fetch_add(1, std::memory_order_relaxed) % numNodes_;
+    auto cpus = nodeCpus(node, numNodes_);
+    return factory_->newThread(
+        [cpus = std::move(cpus), func = std::move(func)]() mutable {
+          pinToCpus(cpus);
+          func();
+        });
+  }
+
+  static size_t systemNodes() {
+    auto& locality = CacheLocality::system();
+    // a single level is the uniform fallback, one cache per cpu
+    return locality.numCachesByLevel.size() > 1
+        ? locality.numCachesByLevel.back()
+        : 1;
+  }
+
+  /**
+   * Node of the cpu the calling thread runs on, out of numNodes.
+   */
+  static size_t currentNode(size_t numNodes) {
+    return numNodes > 1 ? AccessSpreader<>::cachedCurrent(numNodes) : 0;
+  }
+
+  /**
+   * Cpus of a node, grouped as AccessSpreader does for numNodes stripes.
+   */
+  static std::vector<size_t> nodeCpus(size_t node, size_t numNodes) {
+    auto& locality = CacheLocality::system();
+    std::vector<size_t> cpus;
+    for (size_t cpu = 0; cpu < locality.numCpus; ++cpu) {
+      if (locality.localityIndexByCpu[cpu] * numNodes / locality.numCpus ==
+          node) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+ private:
+  static void pinToCpus(const std::vector<size_t>& cpus) {
+#if defined(__linux__) && !defined(__ANDROID__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (auto cpu : cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &cpuset);
+      }
+    }
+    if (CPU_COUNT(&cpuset) != 0 &&
+        sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+      LOG(ERROR) << "sched_setaffinity failed with error " << errno << ", "
+                 << errnoStr(errno);
+    }
+#else
+    (void)cpus;
+#endif
+  }
+
+  std::shared_ptr<ThreadFactory> factory_;
+  size_t numNodes_;
+  std::atomic<size_t> nextNode_{0};
+};
+
+} // namespace folly
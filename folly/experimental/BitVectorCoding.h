@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 #include <type_traits>
@@ -288,6 +289,38 @@ class BitVectorReader : detail::ForwardPointers<Encoder::forwardQuantum>,
     return setValue(inner);
   }
 
+  /**
+   * Decodes up to n values after the current one into buf, and moves to
+   * the last of them. Returns the number of values decoded, which is less
+   * than n only at the end of the list; if there are none left, the
+   * reader is moved past the end, as by next().
+   */
+  SizeType nextBatch(ValueType* buf, SizeType n) {
+    if (!kUnchecked) {
+      // Also works if position() == -1.
+      if (UNLIKELY(position() + 1 >= size_)) {
+        setDone();
+        return 0;
+      }
+      n = std::min<SizeType>(n, size_ - (position() + 1));
+    }
+    if (n == 0) {
+      return 0;
+    }
+    // All the ones of a block are extracted without reloading it.
+    for (SizeType i = 0; i < n; ++i) {
+      while (block_ == 0) {
+        outer_ += sizeof(uint64_t);
+        block_ = folly::loadUnaligned<uint64_t>(bits_ + outer_);
+      }
+      buf[i] = static_cast<ValueType>(8 * outer_ + Instructions::ctz(block_));
+      block_ = Instructions::blsr(block_);
+    }
+    position_ += n;
+    value_ = buf[n - 1];
+    return n;
+  }
+
   bool skip(SizeType n) {
     if (n == 0) {
       return valid();
@@ -408,6 +408,28 @@ class UpperBitsReader : ForwardPointers<Encoder::forwardQuantum>,
     return setValue(inner);
   }
 
+  // Like n calls to next(), storing the values in buf. The n values must
+  // exist. All the ones of a block are extracted without reloading it.
+  void nextBatch(ValueType* buf, SizeType n) {
+    DCHECK_GT(n, 0);
+    // value = 8 * outer_ + inner - position, for each next position.
+    // position_ is -1 before the first value; it is incremented in SizeType
+    // so that it doesn't wrap in OuterType if SizeType is narrower.
+    OuterType base = 8 * outer_ - OuterType(SizeType(position_ + 1)) + 1;
+    for (SizeType i = 0; i < n; ++i) {
+      while (block_ == 0) {
+        outer_ += sizeof(block_t);
+        base += 8 * sizeof(block_t);
+        block_ = folly::loadUnaligned<block_t>(start_ + outer_);
+      }
+      --base;
+      buf[i] = static_cast<ValueType>(base + Instructions::ctz(block_));
+      block_ = Instructions::blsr(block_);
+    }
+    position_ += n;
+    value_ = buf[n - 1];
+  }
+
   ValueType skip(SizeType n) {
     DCHECK_GT(n, 0);
 
@@ -642,6 +664,33 @@ class EliasFanoReader {
     return true;
   }
 
+  /**
+   * Decodes up to n values after the current one into buf, and moves to
+   * the last of them. Returns the number of values decoded, which is less
+   * than n only at the end of the list; if there are none left, the
+   * reader is moved past the end, as by next().
+   */
+  SizeType nextBatch(ValueType* buf, SizeType n) {
+    // Also works if position() == -1.
+    const SizeType first = position() + 1;
+    if (!kUnchecked) {
+      if (UNLIKELY(first >= size_)) {
+        setDone();
+        return 0;
+      }
+      n = std::min<SizeType>(n, size_ - first);
+    }
+    if (n == 0) {
+      return 0;
+    }
+    upper_.nextBatch(buf, n);
+    for (SizeType i = 0; i < n; ++i) {
+      buf[i] = readLowerPart(first + i) | (buf[i] << numLowerBits_);
+    }
+    value_ = buf[n - 1];
+    return n;
+  }
+
   /**
    * Advances by n elements. n = 0 is allowed and has no effect. Returns false
    * if the end of the list is reached.
@@ -837,5 +886,83 @@ class EliasFanoReader {
   uint8_t numLowerBits_;
 };
 
+/**
+ * Calls f(value) on the values that are in both lists, in order, and
+ * returns their number. The lists must be of distinct values, and the
+ * readers freshly reset; both are consumed.
+ *
+ * The values are decoded kBatch at a time with nextBatch() and merged
+ * without branching on which list is behind; when a buffer runs out, its
+ * list is first skipped to the current value of the other one, so that
+ * runs of values that are only in one list are not decoded.
+ *
+ * Also works with BitVectorReader.
+ */
+template <class ReaderA, class ReaderB, class F>
+size_t intersect(ReaderA& a, ReaderB& b, F&& f) {
+  using ValueType = typename ReaderA::ValueType;
+  static_assert(
+      std::is_same<ValueType, typename ReaderB::ValueType>::value,
+      "intersected lists must have the same value type");
+  constexpr size_t kBatch = 64;
+  ValueType bufA[kBatch];
+  ValueType bufB[kBatch];
+
+  // Skips to target, then fills buf with the values from there on.
+  auto refill = [](auto& reader, ValueType* buf, ValueType target) {
+    if (!reader.skipTo(target)) {
+      return size_t(0);
+    }
+    buf[0] = reader.value();
+    return size_t(1 + reader.nextBatch(buf + 1, kBatch - 1));
+  };
+
+  size_t na = refill(a, bufA, 0);
+  size_t nb = na ? refill(b, bufB, bufA[0]) : 0;
+  if (nb == 0) {
+    return 0;
+  }
+  size_t ia = 0;
+  size_t ib = 0;
+  size_t count = 0;
+  while (true) {
+    while (ia < na && ib < nb) {
+      auto x = bufA[ia];
+      auto y = bufB[ib];
+      if (x == y) {
+        f(x);
+        ++count;
+      }
+      ia += x <= y;
+      ib += y <= x;
+    }
+    // The other list's current value is greater than the last value of
+    // the exhausted buffer, or the other buffer was exhausted too.
+    if (ia == na) {
+      auto last = bufA[na - 1];
+      if (last == std::numeric_limits<ValueType>::max()) {
+        break;
+      }
+      na = refill(a, bufA, ib < nb ? bufB[ib] : last + 1);
+      ia = 0;
+      if (na == 0) {
+        break;
+      }
+    }
+    if (ib == nb) {
+      auto last = bufB[nb - 1];
+      if (last == std::numeric_limits<ValueType>::max()) {
+        break;
+      }
+      nb = refill(b, bufB, std::max<ValueType>(bufA[ia], last + 1));
+      ib = 0;
+      if (nb == 0) {
+        break;
+      }
+    }
+  }
+  return count;
+}
+
 } // namespace compression
 } // namespace folly
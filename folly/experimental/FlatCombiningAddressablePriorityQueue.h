@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/container/F14Map.h>
+#include <folly/experimental/flat_combining/FlatCombining.h>
+#include <glog/logging.h>
+
+namespace folly {
+
+/// Thread-safe priority queue based on flat combining, whose items can be
+/// updated or erased while they are in the queue through the handle that
+/// push() returns. Like std::priority_queue, the highest priority item is
+/// the greatest one according to Compare.
+///
+/// All operations are non-blocking and are run by the combiner as a
+/// single operation on a binary heap, so a batch pop costs one request
+/// for all of its items. Handles stay valid, and are harmlessly rejected
+/// by update() and erase(), once their item has left the queue.
+///
+/// Mutex must meet the standard Lockable requirements. The flat combining
+/// parameters are those of FlatCombiningPriorityQueue.
+///
+/// Usage example:
+/// @code
+///   FlatCombiningAddressablePriorityQueue<int> pq;
+///   auto h = pq.push(1);
+///   pq.push(5);
+///   CHECK(pq.update(h, 10)); // increase the priority of 1 to 10
+///   std::vector<int> batch;
+///   CHECK_EQ(pq.try_pop_batch(batch, 2), 2); // batch == {10, 5}
+///   CHECK(!pq.erase(h));
+/// @endcode
+
+template <
+    typename T,
+    typename Compare = std::less<T>,
+    typename Mutex = std::mutex,
+    template <typename> class Atom = std::atomic>
+class FlatCombiningAddressablePriorityQueue
+    : public folly::FlatCombining<
+          FlatCombiningAddressablePriorityQueue<T, Compare, Mutex, Atom>,
+          Mutex,
+          Atom> {
+  using FCAPQ = FlatCombiningAddressablePriorityQueue<T, Compare, Mutex, Atom>;
+  using FC = folly::FlatCombining<FCAPQ, Mutex, Atom>;
+
+ public:
+  class Handle {
+   public:
+    Handle() = default;
+
+    friend bool operator==(Handle a, Handle b) {
+      return a.id_ == b.id_;
+    }
+    friend bool operator!=(Handle a, Handle b) {
+      return a.id_ != b.id_;
+    }
+
+   private:
+    friend class FlatCombiningAddressablePriorityQueue;
+    explicit Handle(uint64_t id) : id_(id) {}
+
+    // 0 is never used by an item
+    uint64_t id_{0};
+  };
+
+  explicit FlatCombiningAddressablePriorityQueue(
+      // Flat combining parameters
+      const bool dedicated = true,
+      const uint32_t numRecs = 0,
+      const uint32_t maxOps = 0,
+      Compare compare = Compare())
+      : FC(dedicated, numRecs, maxOps), compare_(std::move(compare)) {}
+
+  bool empty() const {
+    bool res;
+    auto fn = [&] { res = heap_.empty(); };
+    const_cast<FCAPQ*>(this)->requestFC(fn);
+    return res;
+  }
+
+  size_t size() const {
+    size_t res;
+    auto fn = [&] { res = heap_.size(); };
+    const_cast<FCAPQ*>(this)->requestFC(fn);
+    return res;
+  }
+
+  /// Inserts val and returns the handle through which it can be updated
+  /// or erased until it is popped.
+  Handle push(T val) {
+    uint64_t id;
+    auto fn = [&] {
+      id = ++lastId_;
+      positions_[id] = heap_.size();
+      heap_.push_back(Item{std::move(val), id});
+      siftUp(heap_.size() - 1);
+    };
+    this->requestFC(fn);
+    return Handle(id);
+  }
+
+  /// Replaces the value of the item of handle h, moving it up or down the
+  /// queue according to its new priority. Returns false if the item is no
+  /// longer in the queue.
+  bool update(Handle h, T val) {
+    bool res;
+    auto fn = [&] {
+      auto it = positions_.find(h.id_);
+      res = it != positions_.end();
+      if (res) {
+        auto pos = it->second;
+        heap_[pos].value = std::move(val);
+        siftDown(siftUp(pos));
+      }
+    };
+    this->requestFC(fn);
+    return res;
+  }
+
+  /// Removes the item of handle h. Returns false if it is no longer in the
+  /// queue.
+  bool erase(Handle h) {
+    bool res;
+    auto fn = [&] {
+      auto it = positions_.find(h.id_);
+      res = it != positions_.end();
+      if (res) {
+        auto pos = it->second;
+        positions_.erase(it);
+        removeAt(pos);
+      }
+    };
+    this->requestFC(fn);
+    return res;
+  }
+
+  /// Non-blocking peek; copies the item with the highest priority.
+  bool try_peek(T& val) {
+    bool res;
+    auto fn = [&] {
+      res = !heap_.empty();
+      if (res) {
+        val = heap_.front().value;
+      }
+    };
+    this->requestFC(fn);
+    return res;
+  }
+
+  /// Non-blocking pop of the item with the highest priority.
+  bool try_pop(T& val) {
+    bool res;
+    auto fn = [&] {
+      res = !heap_.empty();
+      if (res) {
+        val = popTop();
+      }
+    };
+    this->requestFC(fn);
+    return res;
+  }
+
+  folly::Optional<T> try_pop() {
+    T val;
+    if (try_pop(val)) {
+      return std::move(val);
+    }
+    return folly::none;
+  }
+
+  /// Appends up to n of the highest priority items to out, in priority
+  /// order, in a single combined operation, and returns how many were
+  /// popped.
+  size_t try_pop_batch(std::vector<T>& out, size_t n) {
+    return try_pop_batch_if(out, n, [](const T&) { return true; });
+  }
+
+  /// Like try_pop_batch, but stops at the first item for which pred
+  /// returns false, and leaves it in the queue.
+  template <typename Pred>
+  size_t try_pop_batch_if(std::vector<T>& out, size_t n, Pred pred) {
+    size_t res = 0;
+    auto fn = [&] {
+      while (res < n && !heap_.empty() && pred(heap_.front().value)) {
+        out.push_back(popTop());
+        ++res;
+      }
+    };
+    this->requestFC(fn);
+    return res;
+  }
+
+ private:
+  struct Item {
+    T value;
+    uint64_t id;
+  };
+
+  Compare compare_;
+  std::vector<Item> heap_;
+  F14FastMap<uint64_t, size_t> positions_;
+  uint64_t lastId_{0};
+
+  // Whether the item at a should be above the one at b
+  bool above(size_t a, size_t b) const {
+    return compare_(heap_[b].value, heap_[a].value);
+  }
+
+  void place(size_t pos, Item&& item) {
+    positions_[item.id] = pos;
+    heap_[pos] = std::move(item);
+  }
+
+  // Both return the final position of the item.
+  size_t siftUp(size_t pos) {
+    if (pos == 0 || !above(pos, (pos - 1) / 2)) {
+      return pos;
+    }
+    Item item = std::move(heap_[pos]);
+    do {
+      auto parent = (pos - 1) / 2;
+      if (!compare_(heap_[parent].value, item.value)) {
+        break;
+      }
+      place(pos, std::move(heap_[parent]));
+      pos = parent;
+    } while (pos > 0);
+    place(pos, std::move(item));
+    return pos;
+  }
+
+  size_t siftDown(size_t pos) {
+    Item item = std::move(heap_[pos]);
+    while (true) {
+      auto child = 2 * pos + 1;
+      if (child >= heap_.size()) {
+        break;
+      }
+      if (child + 1 < heap_.size() && above(child + 1, child)) {
+        ++child;
+      }
+      if (!compare_(item.value, heap_[child].value)) {
+        break;
+      }
+      place(pos, std::move(heap_[child]));
+      pos = child;
+    }
+    place(pos, std::move(item));
+    return pos;
+  }
+
+  // The item at pos must already be removed from positions_.
+  void removeAt(size_t pos) {
+    auto last = heap_.size() - 1;
+    if (pos != last) {
+      heap_[pos] = std::move(heap_[last]);
+      heap_.pop_back();
+      siftDown(siftUp(pos));
+    } else {
+      heap_.pop_back();
+    }
+  }
+
+  T popTop() {
+    DCHECK(!heap_.empty());
+    T val = std::move(heap_.front().value);
+    positions_.erase(heap_.front().id);
+    removeAt(0);
+    return val;
+  }
+};
+
+} // namespace folly
@@ -21,6 +21,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <folly/Optional.h>
 #include <folly/detail/Futex.h>
@@ -69,7 +70,12 @@ namespace folly {
 ///   pop(v);
 ///   CHECK_EQ(v, 10);
 ///   CHECK(pq.empty());
+///   std::vector<int> batch;
+///   CHECK_EQ(pq.try_pop_batch(batch, 16), 0);
 /// @encode
+///
+/// See FlatCombiningAddressablePriorityQueue for a variant whose items
+/// can be updated or erased while they are in the queue.
 
 template <
     typename T,
@@ -169,6 +175,35 @@ class FlatCombiningPriorityQueue
         val, std::chrono::time_point<std::chrono::steady_clock>::max());
   }
 
+  /// Non-blocking batch pop. Appends up to n of the highest priority
+  /// items to out, in priority order, in a single combined operation,
+  /// and returns how many were popped.
+  size_t try_pop_batch(std::vector<T>& out, size_t n) {
+    return try_pop_batch_if(out, n, [](const T&) { return true; });
+  }
+
+  /// Like try_pop_batch, but stops at the first item for which pred
+  /// returns false, and leaves it in the priority queue. E.g., pops the
+  /// jobs that are due if the highest priority job is the earliest one.
+  template <typename Pred>
+  size_t try_pop_batch_if(std::vector<T>& out, size_t n, Pred pred) {
+    size_t res = 0;
+    bool wake = false;
+    auto fn = [&] {
+      while (res < n && !pq_.empty() && pred(pq_.top())) {
+        out.push_back(pq_.top());
+        pq_.pop();
+        ++res;
+      }
+      wake = res > 0 && futexSignal(full_);
+    };
+    this->requestFC(fn);
+    if (wake) {
+      detail::futexWake(&full_);
+    }
+    return res;
+  }
+
   folly::Optional<T> try_pop() {
     T val;
     if (try_pop(val)) {
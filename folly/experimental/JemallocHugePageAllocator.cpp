@@ -16,10 +16,19 @@
 
 #include <folly/experimental/JemallocHugePageAllocator.h>
 
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
 #include <folly/portability/String.h>
+#include <folly/portability/SysSyscall.h>
+#include <folly/portability/Unistd.h>
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #if defined(MADV_HUGEPAGE) && defined(FOLLY_USE_JEMALLOC) && !FOLLY_SANITIZE
 #include <jemalloc/jemalloc.h>
@@ -67,24 +76,26 @@ static void print_error(int err, const char* msg) {
   errno = cur_errno;
 }
 
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+// Node ids must fit in the single word nodemask passed to mbind
+constexpr size_t kMaxNumaNodes = 64;
+
 class HugePageArena {
  public:
-  int init(int nr_pages);
+  // Uses the max_pages mapped at start, see map_pages()
+  int init(int nr_pages, int max_pages, uintptr_t start, int node);
   void* reserve(size_t size, size_t alignment);
 
-  bool addressInArena(void* address) {
-    auto addr = reinterpret_cast<uintptr_t>(address);
-    return addr >= start_ && addr < end_;
-  }
-
   size_t freeSpace() {
-    return end_ - freePtr_;
+    return limit_ - freePtr_;
   }
 
   unsigned arenaIndex() {
     return arenaIndex_;
   }
 
+  void addStats(JemallocHugePageAllocator::Stats& stats) const;
+
  private:
   static void* allocHook(
       extent_hooks_t* extent,
@@ -95,18 +106,40 @@ class HugePageArena {
       bool* commit,
       unsigned arena_ind);
 
+  bool grow(uintptr_t newFreePtr);
+
+  static void count(std::atomic<size_t>& counter, size_t n = 1) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+
   uintptr_t start_{0};
+  // Pages up to end_ are backed, the arena may grow up to limit_
   uintptr_t end_{0};
+  uintptr_t limit_{0};
   uintptr_t freePtr_{0};
+  size_t growSize_{0};
   extent_alloc_t* originalAlloc_{nullptr};
   extent_hooks_t extentHooks_;
   unsigned arenaIndex_{0};
+
+  std::atomic<size_t> hugePageExtents_{0};
+  std::atomic<size_t> hugePageBytes_{0};
+  std::atomic<size_t> fallbackExtents_{0};
+  std::atomic<size_t> fallbackBytes_{0};
+  std::atomic<size_t> hugePages_{0};
+  std::atomic<size_t> growths_{0};
 };
 
-constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+// One arena per NUMA node, or only the first one
+static HugePageArena arenas[kMaxNumaNodes];
 
-// Singleton arena instance
-static HugePageArena arena;
+// The arenas share a single mapping, so that telling whether an address is
+// in any of them is a range check
+static uintptr_t arenasStart{0};
+static uintptr_t arenasLimit{0};
+
+// mallocx flags of the arena of each NUMA node
+static int nodeFlags[kMaxNumaNodes];
 
 template <typename T, typename U>
 static inline T align_up(T val, U alignment) {
@@ -116,6 +149,7 @@ static inline T align_up(T val, U alignment) {
 
 // mmap enough memory to hold the aligned huge pages, then use madvise
 // to get huge pages. This can be checked in /proc/<pid>/smaps.
+// The pages are only backed once touched, see touch_pages().
 static uintptr_t map_pages(size_t nr_pages) {
   // Initial mmapped area is large enough to contain the aligned huge pages
   size_t alloc_size = nr_pages * kHugePageSize;
@@ -123,7 +157,7 @@ static uintptr_t map_pages(size_t nr_pages) {
       nullptr,
       alloc_size + kHugePageSize,
       PROT_READ | PROT_WRITE,
-      MAP_PRIVATE | MAP_ANONYMOUS,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
       -1,
       0);
 
@@ -142,24 +176,92 @@ static uintptr_t map_pages(size_t nr_pages) {
 
   // Tell the kernel to please give us huge pages for this range
   madvise((void*)first_page, kHugePageSize * nr_pages, MADV_HUGEPAGE);
-  LOG(INFO) << nr_pages << " huge pages at " << (void*)first_page;
-
-  // With THP set to madvise, page faults on these pages will block until a
-  // huge page is found to service it. However, if memory becomes fragmented
-  // before these pages are touched, then we end up blocking for kcompactd to
-  // make a page available. This increases pressure to the point that oomd comes
-  // in and kill us :(. So, preemptively touch these pages to get them backed
-  // as early as possible to prevent stalling due to no available huge pages.
-  //
-  // Note: this does not guarantee we won't be oomd killed here, it's just much
-  // more unlikely given this should be among the very first things an
-  // application does.
-  for (uintptr_t ptr = first_page; ptr < first_page + alloc_size;
-       ptr += kHugePageSize) {
+  return first_page;
+}
+
+// Prefer placing the pages of [start, start + len) on the given NUMA node,
+// falling back to other nodes when it runs out of memory.
+static void bind_pages(uintptr_t start, size_t len, int node) {
+#ifdef SYS_mbind
+  constexpr int kMpolPreferred = 1;
+  unsigned long nodemask = 1UL << node;
+  if (syscall(
+          SYS_mbind,
+          start,
+          len,
+          kMpolPreferred,
+          &nodemask,
+          sizeof(nodemask) * 8 + 1,
+          0) != 0) {
+    PLOG(WARNING) << "Unable to bind huge pages to NUMA node " << node;
+  }
+#else
+  (void)start;
+  (void)len;
+  (void)node;
+#endif
+}
+
+// With THP set to madvise, page faults on these pages will block until a
+// huge page is found to service it. However, if memory becomes fragmented
+// before these pages are touched, then we end up blocking for kcompactd to
+// make a page available. This increases pressure to the point that oomd comes
+// in and kill us :(. So, preemptively touch these pages to get them backed
+// as early as possible to prevent stalling due to no available huge pages.
+//
+// Note: this does not guarantee we won't be oomd killed here, it's just much
+// more unlikely given this should be among the very first things an
+// application does.
+//
+// Also called from HugePageArena::allocHook when growing, so it must not
+// allocate.
+static void touch_pages(uintptr_t begin, uintptr_t end) {
+  for (uintptr_t ptr = begin; ptr < end; ptr += kHugePageSize) {
     memset((void*)ptr, 0, 1);
   }
+}
 
-  return first_page;
+// Nodes listed in /sys/devices/system/node/online, e.g. "0-1,3"
+static std::vector<int> online_numa_nodes() {
+  std::vector<int> nodes;
+  std::string online;
+  if (!readFile("/sys/devices/system/node/online", online)) {
+    return {0};
+  }
+  try {
+    std::vector<StringPiece> ranges;
+    split(',', trimWhitespace(online), ranges);
+    for (auto range : ranges) {
+      StringPiece first;
+      StringPiece last;
+      if (!split('-', range, first, last)) {
+        first = last = range;
+      }
+      for (int node = to<int>(first); node <= to<int>(last); ++node) {
+        if (node < 0 || size_t(node) >= kMaxNumaNodes) {
+          LOG(WARNING) << "Ignoring NUMA node " << node;
+          continue;
+        }
+        nodes.push_back(node);
+      }
+    }
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Unable to parse the online NUMA nodes \"" << online
+               << "\": " << ex.what();
+    return {0};
+  }
+  return nodes.empty() ? std::vector<int>{0} : nodes;
+}
+
+static int current_numa_node() {
+#ifdef SYS_getcpu
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && node < kMaxNumaNodes) {
+    return node;
+  }
+#endif
+  return 0;
 }
 
 // WARNING WARNING WARNING
@@ -180,23 +282,40 @@ void* HugePageArena::allocHook(
     bool* commit,
     unsigned arena_ind) {
   assert((size & (size - 1)) == 0);
+  HugePageArena* arena = &arenas[0];
+  for (auto& a : arenas) {
+    if (&a.extentHooks_ == extent) {
+      arena = &a;
+      break;
+    }
+  }
   void* res = nullptr;
   if (new_addr == nullptr) {
-    res = arena.reserve(size, alignment);
+    res = arena->reserve(size, alignment);
   }
   if (res == nullptr) {
-    res = arena.originalAlloc_(
+    res = arena->originalAlloc_(
         extent, new_addr, size, alignment, zero, commit, arena_ind);
+    if (res != nullptr) {
+      count(arena->fallbackExtents_);
+      count(arena->fallbackBytes_, size);
+    }
   } else {
     if (*zero) {
       memset(res, 0, size);
     }
     *commit = true;
+    count(arena->hugePageExtents_);
+    count(arena->hugePageBytes_, size);
   }
   return res;
 }
 
-int HugePageArena::init(int nr_pages) {
+int HugePageArena::init(
+    int nr_pages,
+    int max_pages,
+    uintptr_t start,
+    int node) {
   DCHECK(start_ == 0);
   DCHECK(usingJEMalloc());
 
@@ -211,8 +330,8 @@ int HugePageArena::init(int nr_pages) {
   // Normally jemalloc asks for maps of increasing size in order to avoid
   // hitting the limit of allowed mmaps per process.
   // Since this arena is backed by a single mmap and is using huge pages,
-  // this is not a concern here.
-  // TODO: Support growth of the huge page arena.
+  // this is not a concern here, and small requests keep the arena from
+  // growing further than needed.
   size_t mib[3];
   size_t miblen = sizeof(mib) / sizeof(size_t);
   std::ostringstream rtl_key;
@@ -285,11 +404,19 @@ int HugePageArena::init(int nr_pages) {
     return 0;
   }
 
-  start_ = freePtr_ = map_pages(nr_pages);
-  if (start_ == 0) {
-    return false;
+  if (node >= 0) {
+    bind_pages(start, max_pages * kHugePageSize, node);
   }
-  end_ = start_ + (nr_pages * kHugePageSize);
+  end_ = start + (nr_pages * kHugePageSize);
+  touch_pages(start, end_);
+  LOG(INFO) << nr_pages << " huge pages at " << (void*)start << ", up to "
+            << max_pages << (node >= 0 ? " on NUMA node " : "")
+            << (node >= 0 ? to<std::string>(node) : "");
+  limit_ = start + (max_pages * kHugePageSize);
+  growSize_ = std::max(nr_pages, 1) * kHugePageSize;
+  count(hugePages_, nr_pages);
+  freePtr_ = start;
+  start_ = start;
   return MALLOCX_ARENA(arenaIndex_) | MALLOCX_TCACHE_NONE;
 }
 
@@ -298,44 +425,133 @@ int HugePageArena::init(int nr_pages) {
 void* HugePageArena::reserve(size_t size, size_t alignment) {
   uintptr_t res = align_up(freePtr_, alignment);
   uintptr_t newFreePtr = res + size;
-  if (newFreePtr > end_) {
+  if (newFreePtr > end_ && !grow(newFreePtr)) {
     return nullptr;
   }
   freePtr_ = newFreePtr;
   return reinterpret_cast<void*>(res);
 }
 
+// Backs the pages up to newFreePtr, and at least growSize_ more, if the
+// arena has room for them.
+// Warning: Check the comments in HugePageArena::allocHook before making any
+// change to this function.
+bool HugePageArena::grow(uintptr_t newFreePtr) {
+  if (newFreePtr > limit_) {
+    return false;
+  }
+  uintptr_t newEnd = std::min(
+      std::max(align_up(newFreePtr, kHugePageSize), end_ + growSize_),
+      limit_);
+  touch_pages(end_, newEnd);
+  count(hugePages_, (newEnd - end_) / kHugePageSize);
+  count(growths_);
+  end_ = newEnd;
+  return true;
+}
+
+void HugePageArena::addStats(JemallocHugePageAllocator::Stats& stats) const {
+  auto load = [](const std::atomic<size_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  };
+  stats.hugePageExtents += load(hugePageExtents_);
+  stats.hugePageBytes += load(hugePageBytes_);
+  stats.fallbackExtents += load(fallbackExtents_);
+  stats.fallbackBytes += load(fallbackBytes_);
+  stats.hugePages += load(hugePages_);
+  stats.growths += load(growths_);
+}
+
 } // namespace
 
 int JemallocHugePageAllocator::flags_{0};
+bool JemallocHugePageAllocator::perNumaNode_{false};
 
 bool JemallocHugePageAllocator::init(int nr_pages) {
+  return init(nr_pages, Options());
+}
+
+bool JemallocHugePageAllocator::init(int nr_pages, const Options& options) {
   if (!usingJEMalloc()) {
     LOG(ERROR) << "Not linked with jemalloc?";
     hugePagesSupported = false;
   }
-  if (hugePagesSupported) {
-    if (flags_ == 0) {
-      flags_ = arena.init(nr_pages);
-    } else {
-      LOG(WARNING) << "Already initialized";
-    }
-  } else {
+  if (!hugePagesSupported) {
     LOG(WARNING) << "Huge Page Allocator not supported";
+    return false;
+  }
+  if (flags_ != 0) {
+    LOG(WARNING) << "Already initialized";
+    return true;
   }
-  return flags_ != 0;
+  int max_pages = std::max(nr_pages, options.maxPages);
+  auto nodes = options.perNumaNode ? online_numa_nodes() : std::vector<int>{};
+  size_t arenaSize = max_pages * kHugePageSize;
+  size_t mapSize = std::max(nodes.size(), size_t(1)) * arenaSize;
+  uintptr_t start = map_pages(mapSize / kHugePageSize);
+  if (start == 0) {
+    return false;
+  }
+  arenasStart = start;
+  arenasLimit = start + mapSize;
+  if (!options.perNumaNode) {
+    flags_ = arenas[0].init(nr_pages, max_pages, start, -1);
+  } else {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      int node = nodes[i];
+      nodeFlags[node] = arenas[node].init(
+          nr_pages, max_pages, start + i * arenaSize, node);
+      if (flags_ == 0) {
+        flags_ = nodeFlags[node];
+      }
+    }
+  }
+  if (flags_ == 0) {
+    munmap(reinterpret_cast<void*>(start), mapSize);
+    arenasStart = arenasLimit = 0;
+    return false;
+  }
+  if (options.perNumaNode) {
+    // Nodes without memory, or whose arena failed, use the first arena
+    for (auto& flags : nodeFlags) {
+      if (flags == 0) {
+        flags = flags_;
+      }
+    }
+    perNumaNode_ = nodes.size() > 1;
+  }
+  return true;
+}
+
+int JemallocHugePageAllocator::numaNodeFlags() {
+  // Threads seldom move across nodes, so only look the node up once
+  static thread_local int flags = nodeFlags[current_numa_node()];
+  return flags;
 }
 
 size_t JemallocHugePageAllocator::freeSpace() {
-  return arena.freeSpace();
+  size_t space = 0;
+  for (auto& arena : arenas) {
+    space += arena.freeSpace();
+  }
+  return space;
 }
 
 bool JemallocHugePageAllocator::addressInArena(void* address) {
-  return arena.addressInArena(address);
+  auto addr = reinterpret_cast<uintptr_t>(address);
+  return addr >= arenasStart && addr < arenasLimit;
+}
+
+JemallocHugePageAllocator::Stats JemallocHugePageAllocator::getStats() {
+  Stats stats;
+  for (auto& arena : arenas) {
+    arena.addStats(stats);
+  }
+  return stats;
 }
 
 unsigned arenaIndex() {
-  return arena.arenaIndex();
+  return arenas[0].arenaIndex();
 }
 
 } // namespace folly
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <folly/CPortability.h>
+#include <folly/Likely.h>
 #include <folly/memory/Malloc.h>
 #include <folly/portability/Config.h>
 #include <folly/portability/Memory.h>
@@ -56,20 +57,54 @@ namespace folly {
  * during the lifetime of the application. If we run out of the free huge pages,
  * then huge page allocator falls back to the 4K regular pages.
  *
+ * When the right size isn't known up front, Options::maxPages lets the arena
+ * grow: address space for maxPages is reserved at init, and more huge pages
+ * are touched, at least nr_pages at a time, when the ones in use run out.
+ * Allocations that grow the arena pay for those page faults. getStats()
+ * tells how much was served from huge pages and how much fell back.
+ *
+ * With Options::perNumaNode, every NUMA node gets its own arena whose pages
+ * are preferably placed on that node, and threads allocate from the arena
+ * of the node they ran on when they first allocated.
+ *
  * 1GB Huge Pages are not supported at this point.
  */
 class JemallocHugePageAllocator {
  public:
+  // for std::allocator_traits, e.g. in Arena<JemallocHugePageAllocator>
+  using value_type = void;
+
+  struct Options {
+    // Number of huge pages the arena may grow to. Values up to nr_pages
+    // disable growth.
+    int maxPages{0};
+    // One arena per NUMA node, nr_pages and maxPages then apply to each node
+    bool perNumaNode{false};
+  };
+
+  struct Stats {
+    // Extents jemalloc took from the huge pages, and their size
+    size_t hugePageExtents{0};
+    size_t hugePageBytes{0};
+    // Extents that didn't fit and fell back to regular pages
+    size_t fallbackExtents{0};
+    size_t fallbackBytes{0};
+    // Huge pages touched so far, and how many times the arenas grew
+    size_t hugePages{0};
+    size_t growths{0};
+  };
+
   static bool init(int nr_pages);
+  static bool init(int nr_pages, const Options& options);
 
   static void* allocate(size_t size) {
     // If uninitialized, flags_ will be 0 and the mallocx behavior
     // will match that of a regular malloc
-    return hugePagesSupported ? mallocx(size, flags_) : malloc(size);
+    return hugePagesSupported ? mallocx(size, flags()) : malloc(size);
   }
 
   static void* reallocate(void* p, size_t size) {
-    return hugePagesSupported ? rallocx(p, size, flags_) : realloc(p, size);
+    return hugePagesSupported ? rallocx(p, size, flags()) : realloc(p, size);
   }
 
   static void deallocate(void* p, size_t = 0) {
@@ -80,11 +115,20 @@ class JemallocHugePageAllocator {
     return flags_ != 0;
   }
 
+  // Includes the space the arenas may still grow into
   static size_t freeSpace();
   static bool addressInArena(void* address);
 
+  static Stats getStats();
+
  private:
+  static int flags() {
+    return FOLLY_LIKELY(!perNumaNode_) ? flags_ : numaNodeFlags();
+  }
+  static int numaNodeFlags();
+
   static int flags_;
+  static bool perNumaNode_;
   static bool hugePagesSupported;
 };
 
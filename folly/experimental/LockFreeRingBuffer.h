@@ -16,14 +16,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cmath>
 #include <cstring>
 #include <memory>
+#include <thread>
 #include <type_traits>
 
 #include <folly/Portability.h>
 #include <folly/Traits.h>
+#include <folly/Utility.h>
 #include <folly/detail/TurnSequencer.h>
 #include <folly/portability/Unistd.h>
 
@@ -52,6 +55,14 @@ class RingBufferSlot;
 /// Cursor that can point anywhere in this stream of writes. Reads from the
 /// "future" can optionally block but reads from the "past" will always fail.
 ///
+/// Each slot is stamped with the turn of its last write, as a seqlock:
+/// readers of trivially copyable elements read them in place and check
+/// that the stamp did not change meanwhile, so tryReadWith() can expose
+/// the slot to a visitor without copying it. Other element types are
+/// also supported, but their readers pin the slot they read, and a
+/// writer that wraps around to a pinned slot waits for its readers, so
+/// guarantee 2 only holds for trivially copyable types.
+///
 
 template <typename T, template <typename> class Atom = std::atomic>
 class LockFreeRingBuffer {
@@ -59,10 +70,6 @@ class LockFreeRingBuffer {
       std::is_nothrow_default_constructible<T>::value,
       "Element type must be nothrow default constructible");
 
-  static_assert(
-      folly::is_trivially_copyable<T>::value,
-      "Element type must be trivially copyable");
-
  public:
   /// Opaque pointer to a past or future write.
   /// Can be moved relative to its current location but not in absolute terms.
@@ -140,6 +147,37 @@ class LockFreeRingBuffer {
     return slots_[idx(cursor.ticket)].waitAndTryRead(dest, turn(cursor.ticket));
   }
 
+  /// Zero-copy read of the value at the cursor: invokes f(const T&) on
+  /// the slot itself. Returns true if the value that f saw was the
+  /// write at the cursor, and remained so while f ran. If the return
+  /// value is false, f may have seen a partially overwritten value and
+  /// whatever it derived from it is to be discarded; f must not rely on
+  /// the value being consistent, e.g. to follow pointers in it. Values
+  /// that are not trivially copyable are never overwritten while f runs,
+  /// and f is only invoked if it returns true.
+  template <typename F>
+  bool tryReadWith(const Cursor& cursor, F&& f) noexcept {
+    auto visit = [&](T& value) { f(as_const(value)); };
+    return slots_[idx(cursor.ticket)].tryVisit(visit, turn(cursor.ticket));
+  }
+
+  /// Batch read of up to n of the latest completed writes, oldest first,
+  /// into [dest, dest + n). Writes that are still in progress, or that
+  /// are overwritten while they are read, are skipped. Returns the number
+  /// of values read.
+  template <typename V>
+  size_t readLatest(V* dest, size_t n) noexcept {
+    uint64_t head = ticket_.load();
+    uint64_t count = std::min<uint64_t>({n, head, capacity_});
+    size_t read = 0;
+    for (uint64_t ticket = head - count; ticket != head; ++ticket) {
+      if (slots_[idx(ticket)].tryRead(dest[read], turn(ticket))) {
+        ++read;
+      }
+    }
+    return read;
+  }
+
   /// Returns a Cursor pointing to the first write that has not occurred yet.
   Cursor currentHead() noexcept {
     return Cursor(ticket_.load());
@@ -185,10 +223,21 @@ class LockFreeRingBuffer {
 namespace detail {
 template <typename T, template <typename> class Atom>
 class RingBufferSlot {
+  // Whether readers pin the slot rather than validate the value they read
+  static constexpr bool kPinned = !folly::is_trivially_copyable<T>::value;
+
   void copy(T& dest, T& src) {
+    copy(dest, src, std::integral_constant<bool, kPinned>{});
+  }
+
+  void copy(T& dest, T& src, std::false_type) {
     memcpy(&dest, &src, sizeof(T));
   }
 
+  void copy(T& dest, T& src, std::true_type) {
+    dest = src;
+  }
+
   template <typename V>
   void copy(V& dest, T& src) {
     dest = src;
@@ -205,6 +254,14 @@ class RingBufferSlot {
     // Change to an odd-numbered turn to indicate write in process
     sequencer_.completeTurn(turn * 2);
 
+    if (kPinned) {
+      // Pairs with the fence in pin()
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (readers_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+    }
+
     data = std::move(value);
     sequencer_.completeTurn(turn * 2 + 1);
     // At (turn + 1) * 2
@@ -218,26 +275,54 @@ class RingBufferSlot {
         TurnSequencer<Atom>::TryWaitResult::SUCCESS) {
       return false;
     }
-    copy(dest, data);
-
-    // if it's still the same turn, we read the value successfully
-    return sequencer_.isTurn(desired_turn);
+    return tryRead(dest, turn);
   }
 
   template <typename V>
   bool tryRead(V& dest, uint32_t turn) noexcept {
+    auto f = [&](T& src) { copy(dest, src); };
+    return tryVisit(f, turn);
+  }
+
+  template <typename F>
+  bool tryVisit(F& f, uint32_t turn) noexcept {
     // The write that started at turn 0 ended at turn 2
-    if (!sequencer_.isTurn((turn + 1) * 2)) {
+    uint32_t desired_turn = (turn + 1) * 2;
+    if (!sequencer_.isTurn(desired_turn)) {
       return false;
     }
-    copy(dest, data);
+    if (kPinned) {
+      if (!pin(desired_turn)) {
+        return false;
+      }
+      f(data);
+      readers_.fetch_sub(1, std::memory_order_release);
+      return true;
+    }
+    f(data);
 
     // if it's still the same turn, we read the value successfully
-    return sequencer_.isTurn((turn + 1) * 2);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequencer_.isTurn(desired_turn);
   }
 
  private:
+  // Prevents writers from overwriting the value of desired_turn, unless
+  // it is already being overwritten, in which case it returns false.
+  bool pin(uint32_t desired_turn) noexcept {
+    readers_.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in write()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sequencer_.isTurn(desired_turn)) {
+      readers_.fetch_sub(1, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
   TurnSequencer<Atom> sequencer_;
+  // Number of readers of a value that is not trivially copyable
+  Atom<uint32_t> readers_{0};
   T data;
 }; // RingBufferSlot
 
@@ -0,0 +1,781 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Partitioned Elias-Fano coding.
+ *
+ * Based on the paper by Giuseppe Ottaviano and Rossano Venturini,
+ * "Partitioned Elias-Fano Indexes" (SIGIR 2014).
+ *
+ * The list is split into partitions, each encoded relative to the last value
+ * of the previous one in the smallest of three ways: nothing at all if the
+ * partition is a run of consecutive values, a bitvector (BitVectorCoding.h)
+ * if it is dense, and Elias-Fano (EliasFanoCoding.h) otherwise. Partition
+ * boundaries are chosen with the (1 + eps)-approximation algorithm of the
+ * paper, which takes linear time. Clustered lists, such as the docIDs of
+ * most inverted indexes, are both smaller and faster to skip through than
+ * with plain Elias-Fano.
+ *
+ * The last values, end positions and byte offsets of the partitions are
+ * themselves stored as Elias-Fano lists with skip and forward pointers.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <folly/Likely.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/experimental/BitVectorCoding.h>
+#include <folly/experimental/EliasFanoCoding.h>
+#include <folly/experimental/Instructions.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+namespace compression {
+
+template <class Pointer>
+struct PartitionedEliasFanoCompressedListBase {
+  PartitionedEliasFanoCompressedListBase() = default;
+
+  PartitionedEliasFanoCompressedListBase(size_t sz, folly::Range<Pointer> d)
+      : size(sz), data(d) {}
+
+  template <class OtherPointer>
+  PartitionedEliasFanoCompressedListBase(
+      const PartitionedEliasFanoCompressedListBase<OtherPointer>& other)
+      : size(other.size), data(other.data) {}
+
+  template <class T = Pointer>
+  auto free() -> decltype(::free(T(nullptr))) {
+    return ::free(data.data());
+  }
+
+  size_t size = 0;
+
+  // WARNING: PartitionedEliasFanoCompressedList has no ownership of data.
+  // The 8 bytes following the last byte should be readable.
+  folly::Range<Pointer> data;
+};
+
+typedef PartitionedEliasFanoCompressedListBase<const uint8_t*>
+    PartitionedEliasFanoCompressedList;
+typedef PartitionedEliasFanoCompressedListBase<uint8_t*>
+    MutablePartitionedEliasFanoCompressedList;
+
+namespace detail {
+
+enum class PartitionKind : uint8_t {
+  // The partition holds all the values of its range, and takes no space.
+  Run,
+  BitVector,
+  EliasFano,
+};
+
+template <class Value>
+struct PartitionCoding {
+  // Partitions are small, so they have neither skip nor forward pointers.
+  typedef EliasFanoEncoderV2<Value, size_t> EliasFanoPartitionEncoder;
+  typedef BitVectorEncoder<Value, size_t> BitVectorPartitionEncoder;
+
+  // Estimated cost in bits of a partition in the directory.
+  static constexpr uint64_t kFixedCost = 64;
+
+  // The encoding of a partition of size values, relative to its base, the
+  // largest of which is universe - 1. The reader derives it the same way.
+  static PartitionKind kind(size_t size, uint64_t universe) {
+    if (universe == size) {
+      return PartitionKind::Run;
+    }
+    return bitVectorBytes(universe) < eliasFanoBytes(size, universe)
+        ? PartitionKind::BitVector
+        : PartitionKind::EliasFano;
+  }
+
+  static size_t bytes(PartitionKind kind, size_t size, uint64_t universe) {
+    switch (kind) {
+      case PartitionKind::Run:
+        return 0;
+      case PartitionKind::BitVector:
+        return bitVectorBytes(universe);
+      case PartitionKind::EliasFano:
+        return eliasFanoBytes(size, universe);
+    }
+    return 0;
+  }
+
+  static uint64_t cost(size_t size, uint64_t universe) {
+    return kFixedCost + 8 * bytes(kind(size, universe), size, universe);
+  }
+
+  static size_t bitVectorBytes(uint64_t universe) {
+    return (universe - 1) / 8 + 1;
+  }
+
+  static size_t eliasFanoBytes(size_t size, uint64_t universe) {
+    return EliasFanoPartitionEncoder::Layout::fromUpperBoundAndSize(
+               universe - 1, size)
+        .bytes();
+  }
+};
+
+/**
+ * Returns the end positions of the partitions of the n strictly increasing
+ * values at begin that minimize the encoded size, within a factor of
+ * (1 + eps1) * (1 + eps2).
+ *
+ * This is the shortest path search of the paper over the graph whose edges
+ * are the partitions: from each position only the longest partitions whose
+ * cost is below each of the bounds F, F (1 + eps2), F (1 + eps2)^2, ...
+ * F / eps1 are considered, and as costs are monotone in both ends of the
+ * partition, the ends of these windows only move forward.
+ */
+template <class Value, class RandomAccessIterator>
+std::vector<size_t> optimalPartition(
+    RandomAccessIterator begin,
+    size_t n,
+    double eps1,
+    double eps2) {
+  using Coding = PartitionCoding<Value>;
+  CHECK_GT(eps1, 0);
+  CHECK_GT(eps2, 0);
+
+  auto cost = [&](size_t i, size_t j) {
+    const uint64_t base = i == 0 ? 0 : uint64_t(begin[i - 1]) + 1;
+    return Coding::cost(j - i, uint64_t(begin[j - 1]) - base + 1);
+  };
+
+  std::vector<uint64_t> bounds;
+  const double maxBound = Coding::kFixedCost / eps1;
+  for (double bound = Coding::kFixedCost;; bound *= 1 + eps2) {
+    bounds.push_back(uint64_t(std::min(bound, maxBound)));
+    if (bound >= maxBound) {
+      break;
+    }
+  }
+
+  std::vector<uint64_t> best(n + 1, std::numeric_limits<uint64_t>::max());
+  std::vector<size_t> from(n + 1);
+  best[0] = 0;
+  auto relax = [&](size_t i, size_t j) {
+    const uint64_t c = best[i] + cost(i, j);
+    if (c < best[j]) {
+      best[j] = c;
+      from[j] = i;
+    }
+  };
+
+  std::vector<size_t> windowEnds(bounds.size(), 0);
+  for (size_t i = 0; i < n; ++i) {
+    relax(i, i + 1);
+    for (size_t k = 0; k < bounds.size(); ++k) {
+      auto& end = windowEnds[k];
+      end = std::max(end, i + 1);
+      while (end < n && cost(i, end + 1) <= bounds[k]) {
+        ++end;
+      }
+      if (end > i + 1) {
+        relax(i, end);
+      }
+    }
+  }
+
+  std::vector<size_t> ends;
+  for (size_t j = n; j > 0; j = from[j]) {
+    ends.push_back(j);
+  }
+  std::reverse(ends.begin(), ends.end());
+  return ends;
+}
+
+// Header, then the last values, end positions and byte offsets of the
+// partitions, then the partitions.
+struct PartitionedEliasFanoDirectory {
+  typedef EliasFanoEncoderV2<uint64_t, uint64_t, 128, 128> Encoder;
+
+  struct Header {
+    uint64_t size = 0;
+    uint64_t numPartitions = 0;
+    uint64_t lastValue = 0;
+    uint64_t lastOffset = 0;
+  };
+
+  static constexpr size_t kHeaderSize = 4 * sizeof(uint64_t);
+
+  static std::array<Encoder::Layout, 3> layouts(const Header& header) {
+    return {{
+        Encoder::Layout::fromUpperBoundAndSize(
+            header.lastValue, header.numPartitions),
+        Encoder::Layout::fromUpperBoundAndSize(
+            header.size, header.numPartitions),
+        Encoder::Layout::fromUpperBoundAndSize(
+            header.lastOffset, header.numPartitions),
+    }};
+  }
+
+  // Each list is padded to a multiple of 8 bytes, as the encoder requires
+  // its skip pointers to be aligned.
+  static size_t listBytes(const Encoder::Layout& layout) {
+    return (layout.bytes() + 7) / 8 * 8;
+  }
+
+  template <class Range>
+  static EliasFanoCompressedListBase<typename Range::iterator> openList(
+      const Encoder::Layout& layout,
+      Range& buf) {
+    auto list = layout.openList(buf);
+    buf.advance(listBytes(layout) - layout.bytes());
+    return list;
+  }
+
+  static void writeHeader(const Header& header, uint8_t* data) {
+    folly::storeUnaligned<uint64_t>(data, header.size);
+    folly::storeUnaligned<uint64_t>(data + 8, header.numPartitions);
+    folly::storeUnaligned<uint64_t>(data + 16, header.lastValue);
+    folly::storeUnaligned<uint64_t>(data + 24, header.lastOffset);
+  }
+
+  static Header readHeader(const uint8_t* data) {
+    Header header;
+    header.size = folly::loadUnaligned<uint64_t>(data);
+    header.numPartitions = folly::loadUnaligned<uint64_t>(data + 8);
+    header.lastValue = folly::loadUnaligned<uint64_t>(data + 16);
+    header.lastOffset = folly::loadUnaligned<uint64_t>(data + 24);
+    return header;
+  }
+
+  Header header;
+  EliasFanoCompressedList lastValues;
+  EliasFanoCompressedList ends;
+  EliasFanoCompressedList offsets;
+  const uint8_t* partitions = nullptr;
+
+  static PartitionedEliasFanoDirectory open(
+      const PartitionedEliasFanoCompressedList& list) {
+    PartitionedEliasFanoDirectory dir;
+    if (list.size == 0) {
+      return dir;
+    }
+    dir.header = readHeader(list.data.data());
+    CHECK_EQ(dir.header.size, list.size);
+    auto buf = list.data.subpiece(kHeaderSize);
+    auto ls = layouts(dir.header);
+    dir.lastValues = openList(ls[0], buf);
+    dir.ends = openList(ls[1], buf);
+    dir.offsets = openList(ls[2], buf);
+    dir.partitions = buf.data();
+    return dir;
+  }
+};
+
+} // namespace detail
+
+template <class Value>
+struct PartitionedEliasFanoEncoder {
+  static_assert(
+      std::is_integral<Value>::value && std::is_unsigned<Value>::value,
+      "Value should be unsigned integral");
+
+  typedef PartitionedEliasFanoCompressedList CompressedList;
+  typedef MutablePartitionedEliasFanoCompressedList MutableCompressedList;
+
+  typedef Value ValueType;
+  typedef uint64_t SkipValueType;
+
+  // Of the directory, which is used to find the partitions.
+  static constexpr size_t skipQuantum =
+      detail::PartitionedEliasFanoDirectory::Encoder::skipQuantum;
+  static constexpr size_t forwardQuantum =
+      detail::PartitionedEliasFanoDirectory::Encoder::forwardQuantum;
+
+  // Requires: input range (begin, end) is strictly increasing (encoding
+  // crashes if it's not).
+  // WARNING: encode() mallocates PartitionedEliasFanoCompressedList::data.
+  // As PartitionedEliasFanoCompressedList has no ownership of it, you need
+  // to call free() explicitly.
+  template <class RandomAccessIterator>
+  static MutableCompressedList encode(
+      RandomAccessIterator begin,
+      RandomAccessIterator end,
+      double eps1 = 0.03,
+      double eps2 = 0.3) {
+    using Coding = detail::PartitionCoding<Value>;
+    using Directory = detail::PartitionedEliasFanoDirectory;
+
+    if (begin == end) {
+      return MutableCompressedList();
+    }
+    const size_t n = size_t(end - begin);
+    for (size_t i = 1; i < n; ++i) {
+      CHECK_LT(begin[i - 1], begin[i])
+          << "PartitionedEliasFanoCoding only supports strictly monotone lists";
+    }
+
+    const auto ends = detail::optimalPartition<Value>(begin, n, eps1, eps2);
+    std::vector<uint64_t> offsets(ends.size());
+    size_t partitionsBytes = 0;
+    for (size_t q = 0; q < ends.size(); ++q) {
+      offsets[q] = partitionsBytes;
+      const size_t first = q == 0 ? 0 : ends[q - 1];
+      const uint64_t base = first == 0 ? 0 : uint64_t(begin[first - 1]) + 1;
+      const size_t size = ends[q] - first;
+      const uint64_t universe = uint64_t(begin[ends[q] - 1]) - base + 1;
+      partitionsBytes +=
+          Coding::bytes(Coding::kind(size, universe), size, universe);
+    }
+
+    Directory::Header header;
+    header.size = n;
+    header.numPartitions = ends.size();
+    header.lastValue = begin[n - 1];
+    header.lastOffset = offsets.back();
+    const auto layouts = Directory::layouts(header);
+    size_t bytes = Directory::kHeaderSize + partitionsBytes;
+    for (const auto& layout : layouts) {
+      bytes += Directory::listBytes(layout);
+    }
+
+    // The 8 bytes following the data are allocated but not included in its
+    // size, as with EliasFanoCompressedList; everything is zeroed so that
+    // the encoding is deterministic.
+    auto data = static_cast<uint8_t*>(calloc(bytes + 8, 1));
+    Directory::writeHeader(header, data);
+    folly::MutableByteRange buf(
+        data + Directory::kHeaderSize, bytes - Directory::kHeaderSize);
+
+    auto encodeDirectory = [&](const Directory::Encoder::Layout& layout,
+                               auto&& valueAt) {
+      Directory::Encoder encoder(Directory::openList(layout, buf));
+      for (size_t q = 0; q < ends.size(); ++q) {
+        encoder.add(valueAt(q));
+      }
+      encoder.finish();
+    };
+    encodeDirectory(layouts[0], [&](size_t q) { return begin[ends[q] - 1]; });
+    encodeDirectory(layouts[1], [&](size_t q) { return ends[q]; });
+    encodeDirectory(layouts[2], [&](size_t q) { return offsets[q]; });
+
+    uint8_t* const partitions = buf.data();
+    for (size_t q = 0; q < ends.size(); ++q) {
+      const size_t first = q == 0 ? 0 : ends[q - 1];
+      const uint64_t base = first == 0 ? 0 : uint64_t(begin[first - 1]) + 1;
+      const size_t size = ends[q] - first;
+      const uint64_t universe = uint64_t(begin[ends[q] - 1]) - base + 1;
+      folly::MutableByteRange part(
+          partitions + offsets[q],
+          Coding::bytes(Coding::kind(size, universe), size, universe));
+      switch (Coding::kind(size, universe)) {
+        case detail::PartitionKind::Run:
+          break;
+        case detail::PartitionKind::BitVector:
+          encodePartition<typename Coding::BitVectorPartitionEncoder>(
+              part, begin + first, size, base, universe);
+          break;
+        case detail::PartitionKind::EliasFano:
+          encodePartition<typename Coding::EliasFanoPartitionEncoder>(
+              part, begin + first, size, base, universe);
+          break;
+      }
+    }
+
+    return MutableCompressedList(n, folly::MutableByteRange(data, bytes));
+  }
+
+ private:
+  template <class Encoder, class RandomAccessIterator>
+  static void encodePartition(
+      folly::MutableByteRange buf,
+      RandomAccessIterator begin,
+      size_t size,
+      uint64_t base,
+      uint64_t universe) {
+    auto layout = Encoder::Layout::fromUpperBoundAndSize(universe - 1, size);
+    Encoder encoder(layout.openList(buf));
+    for (size_t i = 0; i < size; ++i) {
+      encoder.add(static_cast<Value>(begin[i] - base));
+    }
+    encoder.finish();
+  }
+};
+
+/**
+ * Has the interface of EliasFanoReader, without previous() and
+ * previousValue().
+ */
+template <class Encoder, class Instructions = instructions::Default>
+class PartitionedEliasFanoReader {
+ public:
+  typedef Encoder EncoderType;
+  typedef typename Encoder::ValueType ValueType;
+  typedef size_t SizeType;
+
+  explicit PartitionedEliasFanoReader(
+      const typename Encoder::CompressedList& list)
+      : PartitionedEliasFanoReader(
+            detail::PartitionedEliasFanoDirectory::open(list)) {}
+
+  void reset() {
+    position_ = static_cast<SizeType>(-1);
+    value_ = kInvalidValue;
+    partition_ = kNoPartition;
+    partitionEnd_ = 0;
+  }
+
+  bool next() {
+    if (UNLIKELY(position_ + 1 >= size_)) {
+      return setDone();
+    }
+    ++position_;
+    if (position_ == partitionEnd_) {
+      openPartition(partition_ + 1);
+    }
+    value_ = base_ + partitionNext();
+    return true;
+  }
+
+  /**
+   * Decodes up to n values after the current one into buf, and moves to
+   * the last of them. Returns the number of values decoded, which is less
+   * than n only at the end of the list; if there are none left, the
+   * reader is moved past the end, as by next().
+   */
+  SizeType nextBatch(ValueType* buf, SizeType n) {
+    if (UNLIKELY(position_ + 1 >= size_)) {
+      setDone();
+      return 0;
+    }
+    SizeType count = 0;
+    while (count < n && position_ + 1 < size_) {
+      if (position_ + 1 == partitionEnd_) {
+        openPartition(partition_ + 1);
+      }
+      const SizeType k =
+          std::min<SizeType>(n - count, partitionEnd_ - (position_ + 1));
+      partitionNextBatch(buf + count, k);
+      count += k;
+      position_ += k;
+    }
+    if (count != 0) {
+      value_ = buf[count - 1];
+    }
+    return count;
+  }
+
+  /**
+   * Advances by n elements. n = 0 is allowed and has no effect. Returns false
+   * if the end of the list is reached.
+   */
+  bool skip(SizeType n) {
+    if (n == 0) {
+      return valid();
+    }
+    // Also works if position() == -1.
+    if (UNLIKELY(position_ + n >= size_)) {
+      return setDone();
+    }
+    return moveTo(position_ + n);
+  }
+
+  /**
+   * Skips to the first element >= value whose position is greater or equal to
+   * the current position. Requires that value >= value() (or that the reader is
+   * at position -1). Returns false if no such element exists.
+   */
+  bool skipTo(ValueType value) {
+    if (value != kInvalidValue) {
+      DCHECK_GE(value + 1, value_ + 1);
+    }
+    if (UNLIKELY(size_ == 0 || value > lastValue_)) {
+      return setDone();
+    } else if (value == value_) {
+      return true;
+    }
+    if (partition_ == kNoPartition || value > partitionLast_) {
+      lastValues_.jumpTo(value, /* assumeDistinct */ true);
+      openPartition(lastValues_.position());
+    }
+    partitionSkipTo(static_cast<ValueType>(value - base_));
+    return true;
+  }
+
+  /**
+   * Jumps to the element at position n. The reader can be in any state. Returns
+   * false if n >= size().
+   */
+  bool jump(SizeType n) {
+    if (UNLIKELY(n >= size_)) {
+      return setDone();
+    }
+    return moveTo(n);
+  }
+
+  /**
+   * Jumps to the first element >= value. The reader can be in any
+   * state. Returns false if no such element exists.
+   */
+  bool jumpTo(ValueType value) {
+    if (UNLIKELY(size_ == 0 || value > lastValue_)) {
+      return setDone();
+    }
+    if (partition_ == kNoPartition || value > partitionLast_ ||
+        value < base_) {
+      lastValues_.jumpTo(value, /* assumeDistinct */ true);
+      openPartition(lastValues_.position());
+    }
+    partitionJumpTo(static_cast<ValueType>(std::max(value, base_) - base_));
+    return true;
+  }
+
+  ValueType lastValue() const {
+    return lastValue_;
+  }
+
+  SizeType size() const {
+    return size_;
+  }
+
+  bool valid() const {
+    return position() < size(); // Also checks that position() != -1.
+  }
+
+  SizeType position() const {
+    return position_;
+  }
+  ValueType value() const {
+    DCHECK(valid());
+    return value_;
+  }
+
+ private:
+  typedef detail::PartitionCoding<ValueType> Coding;
+  typedef EliasFanoReader<
+      typename Coding::EliasFanoPartitionEncoder,
+      Instructions,
+      /* kUnchecked */ true,
+      SizeType>
+      EliasFanoPartitionReader;
+  typedef BitVectorReader<
+      typename Coding::BitVectorPartitionEncoder,
+      Instructions,
+      /* kUnchecked */ true>
+      BitVectorPartitionReader;
+  typedef EliasFanoReader<
+      detail::PartitionedEliasFanoDirectory::Encoder,
+      Instructions>
+      DirectoryReader;
+
+  // Must hold kInvalidValue + 1 == 0.
+  constexpr static ValueType kInvalidValue = -1;
+  constexpr static SizeType kNoPartition = -1;
+
+  explicit PartitionedEliasFanoReader(
+      const detail::PartitionedEliasFanoDirectory& dir)
+      : lastValues_(dir.lastValues),
+        ends_(dir.ends),
+        offsets_(dir.offsets),
+        partitions_(dir.partitions),
+        size_(dir.header.size),
+        lastValue_(static_cast<ValueType>(dir.header.lastValue)) {
+    DCHECK(Instructions::supported());
+  }
+
+  bool setDone() {
+    value_ = kInvalidValue;
+    position_ = size_;
+    // The next skipTo() or jumpTo() looks the partition up again.
+    partition_ = kNoPartition;
+    partitionEnd_ = 0;
+    return false;
+  }
+
+  bool moveTo(SizeType n) {
+    if (partition_ == kNoPartition || n < partitionBegin_ ||
+        n >= partitionEnd_) {
+      ends_.jumpTo(n + 1, /* assumeDistinct */ true);
+      openPartition(ends_.position());
+    }
+    partitionJump(n - partitionBegin_);
+    return true;
+  }
+
+  void openPartition(SizeType q) {
+    DCHECK_LT(q, lastValues_.size());
+    partition_ = q;
+    lastValues_.jump(q);
+    ends_.jump(q);
+    offsets_.jump(q);
+    partitionLast_ = static_cast<ValueType>(lastValues_.value());
+    base_ = q == 0
+        ? 0
+        : static_cast<ValueType>(lastValues_.previousValue() + 1);
+    partitionEnd_ = ends_.value();
+    partitionBegin_ = q == 0 ? 0 : ends_.previousValue();
+
+    const size_t size = partitionEnd_ - partitionBegin_;
+    const uint64_t universe = uint64_t(partitionLast_) - base_ + 1;
+    kind_ = Coding::kind(size, universe);
+    folly::ByteRange buf(
+        partitions_ + offsets_.value(), Coding::bytes(kind_, size, universe));
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        run_ = static_cast<ValueType>(-1);
+        break;
+      case detail::PartitionKind::BitVector:
+        bitVector_.emplace(
+            Coding::BitVectorPartitionEncoder::Layout::fromUpperBoundAndSize(
+                universe - 1, size)
+                .openList(buf));
+        break;
+      case detail::PartitionKind::EliasFano:
+        eliasFano_.emplace(
+            Coding::EliasFanoPartitionEncoder::Layout::fromUpperBoundAndSize(
+                universe - 1, size)
+                .openList(buf));
+        break;
+    }
+  }
+
+  // The operations on the current partition, whose values are relative to
+  // base_. Partition readers are unchecked, as the partition is always
+  // chosen so that they succeed.
+
+  ValueType partitionNext() {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        return ++run_;
+      case detail::PartitionKind::BitVector:
+        bitVector_->next();
+        return bitVector_->value();
+      case detail::PartitionKind::EliasFano:
+        eliasFano_->next();
+        return eliasFano_->value();
+    }
+    return 0;
+  }
+
+  void partitionNextBatch(ValueType* buf, SizeType n) {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        for (SizeType i = 0; i < n; ++i) {
+          buf[i] = ++run_;
+        }
+        break;
+      case detail::PartitionKind::BitVector:
+        bitVector_->nextBatch(buf, static_cast<ValueType>(n));
+        break;
+      case detail::PartitionKind::EliasFano:
+        eliasFano_->nextBatch(buf, n);
+        break;
+    }
+    for (SizeType i = 0; i < n; ++i) {
+      buf[i] += base_;
+    }
+  }
+
+  void partitionSkipTo(ValueType value) {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        run_ = value;
+        break;
+      case detail::PartitionKind::BitVector:
+        bitVector_->skipTo(value);
+        break;
+      case detail::PartitionKind::EliasFano:
+        eliasFano_->skipTo(value);
+        break;
+    }
+    setPositionAndValue();
+  }
+
+  void partitionJump(SizeType n) {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        run_ = static_cast<ValueType>(n);
+        break;
+      case detail::PartitionKind::BitVector:
+        bitVector_->jump(static_cast<ValueType>(n));
+        break;
+      case detail::PartitionKind::EliasFano:
+        eliasFano_->jump(n);
+        break;
+    }
+    setPositionAndValue();
+  }
+
+  void partitionJumpTo(ValueType value) {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        run_ = value;
+        break;
+      case detail::PartitionKind::BitVector:
+        bitVector_->jumpTo(value);
+        break;
+      case detail::PartitionKind::EliasFano:
+        eliasFano_->jumpTo(value, /* assumeDistinct */ true);
+        break;
+    }
+    setPositionAndValue();
+  }
+
+  void setPositionAndValue() {
+    switch (kind_) {
+      case detail::PartitionKind::Run:
+        position_ = partitionBegin_ + run_;
+        value_ = base_ + run_;
+        break;
+      case detail::PartitionKind::BitVector:
+        position_ = partitionBegin_ + bitVector_->position();
+        value_ = base_ + bitVector_->value();
+        break;
+      case detail::PartitionKind::EliasFano:
+        position_ = partitionBegin_ + eliasFano_->position();
+        value_ = base_ + eliasFano_->value();
+        break;
+    }
+  }
+
+  DirectoryReader lastValues_;
+  DirectoryReader ends_;
+  DirectoryReader offsets_;
+  const uint8_t* partitions_;
+  SizeType size_;
+  ValueType lastValue_;
+
+  SizeType position_ = static_cast<SizeType>(-1);
+  ValueType value_ = kInvalidValue;
+
+  SizeType partition_ = kNoPartition;
+  SizeType partitionBegin_ = 0;
+  SizeType partitionEnd_ = 0;
+  ValueType base_ = 0;
+  ValueType partitionLast_ = 0;
+  detail::PartitionKind kind_ = detail::PartitionKind::Run;
+  ValueType run_ = 0;
+  folly::Optional<BitVectorPartitionReader> bitVector_;
+  folly::Optional<EliasFanoPartitionReader> eliasFano_;
+};
+
+} // namespace compression
+} // namespace folly
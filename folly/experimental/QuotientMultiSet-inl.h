@@ -251,6 +251,40 @@ auto QuotientMultiSet<Instructions>::equalRange(uint64_t key) const
   return range;
 }
 
+template <class Instructions>
+void QuotientMultiSet<Instructions>::equalRanges(
+    Range<const uint64_t*> keys,
+    SlotRange* ranges) const {
+  const size_t n = keys.size();
+  for (size_t i = 0; i < n && i < kPrefetchDistance; ++i) {
+    prefetchBlock(keys[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kPrefetchDistance < n) {
+      prefetchBlock(keys[i + kPrefetchDistance]);
+    }
+    ranges[i] = equalRange(keys[i]);
+  }
+}
+
+template <class Instructions>
+void QuotientMultiSet<Instructions>::prefetchBlock(uint64_t key) const {
+  if (key > maxKey_) {
+    return;
+  }
+  const auto quotient =
+      qms_detail::getQuotientAndRemainder(key, divisor_, fraction_).first;
+  const size_t blockIndex = quotient / kBlockSize;
+  if (FOLLY_UNLIKELY(blockIndex >= numBlocks_)) {
+    return;
+  }
+  const char* block = data_ + blockIndex * blockSize_;
+  __builtin_prefetch(block);
+  // The run of the key usually starts at or shortly after its quotient.
+  __builtin_prefetch(
+      block + sizeof(Block) + (quotient % kBlockSize) * remainderBits_ / 8);
+}
+
 template <class Instructions>
 auto QuotientMultiSet<Instructions>::findRunend(
     uint64_t occupiedRank,
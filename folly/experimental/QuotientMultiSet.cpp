@@ -18,6 +18,8 @@
 
 #include <cmath>
 
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
 #include <folly/Math.h>
 
 #if FOLLY_QUOTIENT_MULTI_SET_SUPPORTED
@@ -181,6 +183,39 @@ void QuotientMultiSetBuilder::close(IOBufQueue& buff) {
   buff.append(IOBuf::takeOwnership(metadata, sizeof(Metadata)));
 }
 
+QuotientMultiSetFileBuilder::QuotientMultiSetFileBuilder(
+    File file,
+    size_t keyBits,
+    size_t expectedElements,
+    double loadFactor)
+    : file_(std::move(file)),
+      builder_(keyBits, expectedElements, loadFactor) {}
+
+bool QuotientMultiSetFileBuilder::insert(uint64_t key) {
+  // Flush before inserting, as setBlockPayload() may need the last block.
+  if (builder_.numReadyBlocks() >= kFlushBlocks) {
+    builder_.flush(buff_);
+    write();
+  }
+  return builder_.insert(key);
+}
+
+void QuotientMultiSetFileBuilder::close() {
+  builder_.close(buff_);
+  write();
+}
+
+void QuotientMultiSetFileBuilder::write() {
+  auto buf = buff_.move();
+  if (!buf) {
+    return;
+  }
+  // Blocks are small, so a single write is much cheaper than one per block.
+  auto data = buf->coalesce();
+  auto written = writeFull(file_.fd(), data.data(), data.size());
+  checkUnixError(written, "write() failed");
+}
+
 } // namespace folly
 
 #endif // FOLLY_QUOTIENT_MULTI_SET_SUPPORTED
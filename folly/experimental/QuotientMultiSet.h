@@ -19,11 +19,14 @@
 #include <deque>
 #include <utility>
 
+#include <folly/File.h>
 #include <folly/Portability.h>
 #include <folly/Range.h>
 #include <folly/experimental/Instructions.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/portability/SysMman.h>
+#include <folly/system/MemoryMapping.h>
 
 // A 128-bit integer type is needed for fast division.
 #define FOLLY_QUOTIENT_MULTI_SET_SUPPORTED FOLLY_HAVE_INT128_T
@@ -105,6 +108,9 @@ using UInt64InverseType = __uint128_t;
  * - Runends bit indicates whether the slot is the end of some run. 1s in
  *   occupieds and runends bits are in 1-1 correspondence: the i-th 1 in the
  *   runends vector marks the run end of the i-th 1 in the occupieds.
+ *
+ * QuotientMultiSet is immutable and only reads the data it was constructed
+ * from, so it can be queried from any number of threads concurrently.
  */
 
 template <class Instructions = compression::instructions::Default>
@@ -133,6 +139,12 @@ class QuotientMultiSet final {
   // Get the position range for the given key.
   SlotRange equalRange(uint64_t key) const;
 
+  // Get the position range of each key of keys into the corresponding
+  // element of ranges. The blocks of the keys a few positions ahead are
+  // prefetched while each key is looked up, which hides most of the memory
+  // latency when the table does not fit in cache.
+  void equalRanges(Range<const uint64_t*> keys, SlotRange* ranges) const;
+
   // Get payload of given block.
   uint64_t getBlockPayload(uint64_t blockIndex) const;
 
@@ -154,6 +166,12 @@ class QuotientMultiSet final {
       uint64_t occupiedRank,
       uint64_t startPos) const;
 
+  // Prefetch the block of the given key, and its slot's remainder.
+  void prefetchBlock(uint64_t key) const;
+
+  // Number of keys looked up ahead by equalRanges().
+  static constexpr size_t kPrefetchDistance = 16;
+
   const Metadata* metadata_;
   const char* data_;
   // Total number of blocks.
@@ -343,6 +361,73 @@ class QuotientMultiSetBuilder final {
   IOBufQueue buff_;
 };
 
+/*
+ * Builds a QuotientMultiSet directly into a file, appending the blocks as
+ * they become ready, so that only a bounded number of them are in memory
+ * regardless of the size of the set. The file can then be loaded with
+ * MappedQuotientMultiSet.
+ */
+class QuotientMultiSetFileBuilder final {
+ public:
+  QuotientMultiSetFileBuilder(
+      File file,
+      size_t keyBits,
+      size_t expectedElements,
+      double loadFactor = QuotientMultiSetBuilder::kDefaultMaxLoadFactor);
+
+  // Same as QuotientMultiSetBuilder::insert().
+  bool insert(uint64_t key);
+
+  // Same as QuotientMultiSetBuilder::setBlockPayload().
+  void setBlockPayload(uint64_t payload) {
+    builder_.setBlockPayload(payload);
+  }
+
+  // Write the remaining blocks and the metadata. The file is not synced.
+  void close();
+
+ private:
+  // Number of ready blocks that are buffered before being written.
+  constexpr static size_t kFlushBlocks = 1024;
+
+  void write();
+
+  File file_;
+  QuotientMultiSetBuilder builder_;
+  IOBufQueue buff_;
+};
+
+/*
+ * A QuotientMultiSet over a memory-mapped file, such as one written by
+ * QuotientMultiSetFileBuilder. The data is not copied: pages are read in
+ * when they are first looked up, and shared through the page cache by all
+ * the processes that map the file.
+ */
+template <class Instructions = compression::instructions::Default>
+class MappedQuotientMultiSet final {
+ public:
+  explicit MappedQuotientMultiSet(File file)
+      : mapping_(std::move(file)), qms_(mapping_.data()) {
+    // Lookups are random, so readahead would only waste memory.
+    mapping_.advise(MADV_RANDOM);
+  }
+
+  explicit MappedQuotientMultiSet(const char* name)
+      : MappedQuotientMultiSet(File(name)) {}
+
+  const QuotientMultiSet<Instructions>& get() const {
+    return qms_;
+  }
+
+  const QuotientMultiSet<Instructions>* operator->() const {
+    return &qms_;
+  }
+
+ private:
+  MemoryMapping mapping_;
+  QuotientMultiSet<Instructions> qms_;
+};
+
 } // namespace folly
 
 #include <folly/experimental/QuotientMultiSet-inl.h>
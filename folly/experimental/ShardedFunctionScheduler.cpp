@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/ShardedFunctionScheduler.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include <folly/Chrono.h>
+#include <folly/Conv.h>
+#include <folly/Optional.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace folly {
+
+struct ShardedFunctionScheduler::Entry
+    : HHWheelTimer::Callback,
+      std::enable_shared_from_this<Entry> {
+  Entry(
+      Shard& s,
+      Function<void()>&& c,
+      IntervalDistributionFunc&& f,
+      StringPiece n,
+      milliseconds delay,
+      bool once)
+      : shard(s),
+        cb(std::move(c)),
+        intervalFunc(std::move(f)),
+        name(n.str()),
+        startDelay(delay),
+        runOnce(once) {}
+
+  void timeoutExpired() noexcept override;
+
+  // Runs cb and returns when it started. May be called on any thread.
+  steady_clock::time_point invoke();
+
+  // Schedules the next run, or removes the entry if it only runs once. Must
+  // be called on the shard thread.
+  void finish(steady_clock::time_point start);
+
+  Shard& shard;
+  Function<void()> cb;
+  // Only called on the shard thread
+  IntervalDistributionFunc intervalFunc;
+  const std::string name;
+  const milliseconds startDelay;
+  const bool runOnce;
+
+  std::atomic<bool> cancelled{false};
+  // Held while cb runs, so that cancelFunctionAndWait() can wait for it
+  std::mutex runMutex;
+
+  // Only accessed on the shard thread: whether a run was handed to the
+  // executor and has not finished yet, and the delay of a timer set in the
+  // meantime, which is started once it finishes.
+  bool inFlight{false};
+  Optional<milliseconds> deferredDelay;
+};
+
+struct ShardedFunctionScheduler::Shard {
+  Shard(Executor::KeepAlive<> ex, StringPiece threadName)
+      : executor(std::move(ex)), thread(threadName) {}
+
+  EventBase& evb() {
+    return *thread.getEventBase();
+  }
+
+  // Must be called on the shard thread
+  void schedule(Entry& entry, milliseconds delay) {
+    if (!running || entry.cancelled.load(std::memory_order_acquire)) {
+      return;
+    }
+    if (entry.inFlight) {
+      // Firing now would only block an executor thread on runMutex
+      entry.deferredDelay = delay;
+      return;
+    }
+    evb().timer().scheduleTimeout(&entry, delay);
+  }
+
+  Executor::KeepAlive<> executor;
+  Synchronized<F14FastMap<std::string, std::shared_ptr<Entry>>, std::mutex>
+      functions;
+  // Only accessed on the shard thread
+  bool running{false};
+
+  // Declared last so that it is destroyed first: runs in progress on the
+  // executor hold a keep-alive on the EventBase, which waits for them when
+  // destroyed, and they use the members above when they complete.
+  ScopedEventBaseThread thread;
+};
+
+void ShardedFunctionScheduler::Entry::timeoutExpired() noexcept {
+  // Keeps the entry alive if it gets removed while running
+  auto self = shared_from_this();
+  if (!shard.executor) {
+    finish(invoke());
+    return;
+  }
+  inFlight = true;
+  try {
+    shard.executor->add(
+        [self, evb = getKeepAliveToken(shard.evb())]() mutable {
+          auto start = self->invoke();
+          evb->runInEventBaseThread(
+              [self = std::move(self), start] { self->finish(start); });
+        });
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Error scheduling the function <" << name
+               << "> on the executor: " << exceptionStr(ex);
+    finish(steady_clock::now());
+  }
+}
+
+steady_clock::time_point ShardedFunctionScheduler::Entry::invoke() {
+  std::lock_guard<std::mutex> g(runMutex);
+  auto start = steady_clock::now();
+  if (cancelled.load(std::memory_order_acquire)) {
+    return start;
+  }
+  try {
+    VLOG(5) << "Now running " << name;
+    cb();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Error running the scheduled function <" << name
+               << ">: " << exceptionStr(ex);
+  }
+  return start;
+}
+
+void ShardedFunctionScheduler::Entry::finish(steady_clock::time_point start) {
+  inFlight = false;
+  if (runOnce) {
+    auto functions = shard.functions.lock();
+    auto it = functions->find(name);
+    if (it != functions->end() && it->second.get() == this) {
+      functions->erase(it);
+    }
+    return;
+  }
+  if (deferredDelay) {
+    auto delay = *std::exchange(deferredDelay, none);
+    shard.schedule(*this, delay);
+    return;
+  }
+  auto delay = chrono::ceil<milliseconds>(
+      start + intervalFunc() - steady_clock::now());
+  shard.schedule(*this, delay);
+}
+
+ShardedFunctionScheduler::ShardedFunctionScheduler()
+    : ShardedFunctionScheduler(Options()) {}
+
+ShardedFunctionScheduler::ShardedFunctionScheduler(Options options)
+    : options_(std::move(options)) {
+  CHECK_GT(options_.numShards, 0u);
+  shards_.reserve(options_.numShards);
+  for (size_t i = 0; i < options_.numShards; ++i) {
+    shards_.push_back(
+        std::make_unique<Shard>(options_.executor, options_.threadName));
+  }
+}
+
+ShardedFunctionScheduler::~ShardedFunctionScheduler() {
+  shutdown();
+}
+
+ShardedFunctionScheduler::Shard& ShardedFunctionScheduler::shardFor(
+    StringPiece nameID) const {
+  return *shards_[Hash()(nameID) % shards_.size()];
+}
+
+void ShardedFunctionScheduler::addFunction(
+    Function<void()>&& cb,
+    milliseconds interval,
+    StringPiece nameID,
+    milliseconds startDelay) {
+  if (interval < milliseconds::zero()) {
+    throw std::invalid_argument(
+        "ShardedFunctionScheduler: time interval must be non-negative");
+  }
+  addFunctionInternal(
+      std::move(cb),
+      [interval] { return interval; },
+      nameID,
+      startDelay,
+      false /*runOnce*/);
+}
+
+void ShardedFunctionScheduler::addFunctionOnce(
+    Function<void()>&& cb,
+    StringPiece nameID,
+    milliseconds startDelay) {
+  addFunctionInternal(
+      std::move(cb), nullptr, nameID, startDelay, true /*runOnce*/);
+}
+
+void ShardedFunctionScheduler::addFunctionGenericDistribution(
+    Function<void()>&& cb,
+    IntervalDistributionFunc&& intervalFunc,
+    StringPiece nameID,
+    milliseconds startDelay) {
+  addFunctionInternal(
+      std::move(cb),
+      std::move(intervalFunc),
+      nameID,
+      startDelay,
+      false /*runOnce*/);
+}
+
+void ShardedFunctionScheduler::addFunctionInternal(
+    Function<void()>&& cb,
+    IntervalDistributionFunc&& intervalFunc,
+    StringPiece nameID,
+    milliseconds startDelay,
+    bool runOnce) {
+  if (!cb) {
+    throw std::invalid_argument(
+        "ShardedFunctionScheduler: Scheduled function must be set");
+  }
+  if (!runOnce && !intervalFunc) {
+    throw std::invalid_argument(
+        "ShardedFunctionScheduler: interval distribution function must be set");
+  }
+  if (startDelay < milliseconds::zero()) {
+    throw std::invalid_argument(
+        "ShardedFunctionScheduler: start delay must be non-negative");
+  }
+
+  auto& shard = shardFor(nameID);
+  auto entry = std::make_shared<Entry>(
+      shard,
+      std::move(cb),
+      std::move(intervalFunc),
+      nameID,
+      startDelay,
+      runOnce);
+  if (!shard.functions.lock()->emplace(nameID.str(), entry).second) {
+    throw std::invalid_argument(to<std::string>(
+        "ShardedFunctionScheduler: a function named \"",
+        nameID,
+        "\" already exists"));
+  }
+  // Not scheduled until start() if the shard isn't running
+  shard.evb().runInEventBaseThread([entry = std::move(entry)] {
+    entry->shard.schedule(*entry, entry->startDelay);
+  });
+}
+
+std::shared_ptr<ShardedFunctionScheduler::Entry>
+ShardedFunctionScheduler::removeFunction(StringPiece nameID) {
+  std::shared_ptr<Entry> entry;
+  {
+    auto functions = shardFor(nameID).functions.lock();
+    auto it = functions->find(nameID);
+    if (it == functions->end()) {
+      return nullptr;
+    }
+    entry = std::move(it->second);
+    functions->erase(it);
+  }
+  entry->cancelled.store(true, std::memory_order_release);
+  return entry;
+}
+
+bool ShardedFunctionScheduler::cancelFunction(StringPiece nameID) {
+  auto entry = removeFunction(nameID);
+  if (!entry) {
+    return false;
+  }
+  auto& evb = entry->shard.evb();
+  evb.runInEventBaseThread([entry = std::move(entry)] {
+    entry->cancelTimeout();
+  });
+  return true;
+}
+
+bool ShardedFunctionScheduler::cancelFunctionAndWait(StringPiece nameID) {
+  auto entry = removeFunction(nameID);
+  if (!entry) {
+    return false;
+  }
+  entry->shard.evb().runImmediatelyOrRunInEventBaseThreadAndWait(
+      [&] { entry->cancelTimeout(); });
+  // Wait for a run in progress on the executor
+  std::lock_guard<std::mutex> g(entry->runMutex);
+  return true;
+}
+
+void ShardedFunctionScheduler::cancelAllFunctions() {
+  for (auto& shard : shards_) {
+    F14FastMap<std::string, std::shared_ptr<Entry>> functions;
+    shard->functions.lock()->swap(functions);
+    for (auto& p : functions) {
+      p.second->cancelled.store(true, std::memory_order_release);
+    }
+    shard->evb().runInEventBaseThread(
+        [functions = std::move(functions)]() mutable {
+          for (auto& p : functions) {
+            p.second->cancelTimeout();
+          }
+        });
+  }
+}
+
+bool ShardedFunctionScheduler::resetFunctionTimer(StringPiece nameID) {
+  std::shared_ptr<Entry> entry;
+  {
+    auto functions = shardFor(nameID).functions.lock();
+    auto it = functions->find(nameID);
+    if (it == functions->end()) {
+      return false;
+    }
+    entry = it->second;
+  }
+  auto& evb = entry->shard.evb();
+  evb.runInEventBaseThread([entry = std::move(entry)] {
+    entry->shard.schedule(*entry, entry->startDelay);
+  });
+  return true;
+}
+
+bool ShardedFunctionScheduler::start() {
+  std::lock_guard<std::mutex> g(runningMutex_);
+  if (running_) {
+    return false;
+  }
+  running_ = true;
+  for (auto& shard : shards_) {
+    shard->evb().runImmediatelyOrRunInEventBaseThreadAndWait([&] {
+      shard->running = true;
+      auto functions = shard->functions.lock();
+      for (auto& p : *functions) {
+        shard->schedule(*p.second, p.second->startDelay);
+      }
+    });
+  }
+  return true;
+}
+
+bool ShardedFunctionScheduler::shutdown() {
+  std::lock_guard<std::mutex> g(runningMutex_);
+  if (!running_) {
+    return false;
+  }
+  running_ = false;
+  for (auto& shard : shards_) {
+    shard->evb().runImmediatelyOrRunInEventBaseThreadAndWait([&] {
+      shard->running = false;
+      auto functions = shard->functions.lock();
+      for (auto& p : *functions) {
+        p.second->cancelTimeout();
+      }
+    });
+  }
+  return true;
+}
+
+size_t ShardedFunctionScheduler::numFunctions() const {
+  size_t n = 0;
+  for (auto& shard : shards_) {
+    n += shard->functions.lock()->size();
+  }
+  return n;
+}
+
+} // namespace folly
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/experimental/FunctionScheduler.h>
+
+namespace folly {
+
+/**
+ * Schedules functions to run at various intervals, like FunctionScheduler,
+ * but for large numbers of functions.
+ *
+ * FunctionScheduler keeps its functions in a heap under a single mutex, and
+ * runs all of them on its one thread. Here, functions are assigned to one of
+ * several shards by name. Each shard has its own thread and keeps the timers
+ * of its functions in the HHWheelTimer of that thread's EventBase, so adding,
+ * cancelling and rescheduling a function are constant time. When an executor
+ * is given, the functions run on it and the shard threads only keep time:
+ *
+ *   ShardedFunctionScheduler::Options options;
+ *   options.numShards = 4;
+ *   options.executor = getKeepAliveToken(cpuExecutor);
+ *   ShardedFunctionScheduler fs(std::move(options));
+ *
+ *   for (auto& tenant : tenants) {
+ *     fs.addFunction([&] { tenant.refresh(); }, seconds(30), tenant.name());
+ *   }
+ *   fs.start();
+ *
+ * Like FunctionScheduler, a function never runs concurrently with itself,
+ * and the interval is counted from the time a run starts. Timers have the
+ * granularity of the HHWheelTimer, 10ms by default.
+ */
+class ShardedFunctionScheduler {
+ public:
+  using IntervalDistributionFunc = FunctionScheduler::IntervalDistributionFunc;
+
+  struct Options {
+    // Number of timer threads, each owning the functions whose names hash to
+    // it
+    size_t numShards{1};
+    // Executor the functions run on. If null, they run on the thread of their
+    // shard, where a slow function delays the other functions of the shard.
+    Executor::KeepAlive<> executor;
+    // Name of the timer threads
+    std::string threadName{"FuncSched"};
+  };
+
+  ShardedFunctionScheduler();
+  explicit ShardedFunctionScheduler(Options options);
+  ~ShardedFunctionScheduler();
+
+  ShardedFunctionScheduler(const ShardedFunctionScheduler&) = delete;
+  ShardedFunctionScheduler& operator=(const ShardedFunctionScheduler&) =
+      delete;
+
+  /**
+   * Adds a function that runs every interval, starting startDelay after
+   * start(), or after now if the scheduler is already running.
+   *
+   * Throws std::invalid_argument if a function with the same name exists.
+   */
+  void addFunction(
+      Function<void()>&& cb,
+      std::chrono::milliseconds interval,
+      StringPiece nameID,
+      std::chrono::milliseconds startDelay = std::chrono::milliseconds(0));
+
+  /**
+   * Adds a function that runs once, after startDelay.
+   */
+  void addFunctionOnce(
+      Function<void()>&& cb,
+      StringPiece nameID,
+      std::chrono::milliseconds startDelay = std::chrono::milliseconds(0));
+
+  /**
+   * Adds a function whose interval is picked by intervalFunc before every
+   * run, see FunctionScheduler::addFunctionGenericDistribution().
+   */
+  void addFunctionGenericDistribution(
+      Function<void()>&& cb,
+      IntervalDistributionFunc&& intervalFunc,
+      StringPiece nameID,
+      std::chrono::milliseconds startDelay = std::chrono::milliseconds(0));
+
+  /**
+   * Cancels the function with the given name. A run that has already started
+   * still completes.
+   *
+   * Returns false if no function exists with the specified name.
+   */
+  bool cancelFunction(StringPiece nameID);
+
+  /**
+   * Like cancelFunction(), but also waits for a run in progress to complete.
+   * Must not be called from the function being cancelled.
+   */
+  bool cancelFunctionAndWait(StringPiece nameID);
+
+  void cancelAllFunctions();
+
+  /**
+   * Restarts the timer of the function with the given name, so that it next
+   * runs after its startDelay. If a run is in progress on the executor, the
+   * timer restarts when it completes.
+   *
+   * Returns false if no function exists with the specified name.
+   */
+  bool resetFunctionTimer(StringPiece nameID);
+
+  /**
+   * Starts running the functions.
+   *
+   * Returns false if the scheduler was already running.
+   */
+  bool start();
+
+  /**
+   * Stops running the functions. Runs in progress on the executor still
+   * complete. The scheduler may be restarted later, and then runs every
+   * function after its startDelay again.
+   *
+   * Returns false if the scheduler was not running.
+   */
+  bool shutdown();
+
+  size_t numFunctions() const;
+
+ private:
+  struct Entry;
+  struct Shard;
+
+  Shard& shardFor(StringPiece nameID) const;
+
+  void addFunctionInternal(
+      Function<void()>&& cb,
+      IntervalDistributionFunc&& intervalFunc,
+      StringPiece nameID,
+      std::chrono::milliseconds startDelay,
+      bool runOnce);
+
+  std::shared_ptr<Entry> removeFunction(StringPiece nameID);
+
+  Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  // Serializes start() and shutdown()
+  std::mutex runningMutex_;
+  bool running_{false};
+};
+
+} // namespace folly
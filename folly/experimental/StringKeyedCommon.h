@@ -24,11 +24,14 @@
 
 namespace folly {
 
+// Through allocator_traits, so that allocators without a nested rebind, such
+// as SysArenaAllocator, can be used to store the keys in an arena.
 template <class Alloc>
 StringPiece stringPieceDup(StringPiece piece, const Alloc& alloc) {
   auto size = piece.size();
   auto keyDup =
-      typename Alloc::template rebind<char>::other(alloc).allocate(size);
+      typename std::allocator_traits<Alloc>::template rebind_alloc<char>(alloc)
+          .allocate(size);
   if (size) {
     memcpy(
         keyDup, piece.data(), size * sizeof(typename StringPiece::value_type));
@@ -38,8 +41,8 @@ StringPiece stringPieceDup(StringPiece piece, const Alloc& alloc) {
 
 template <class Alloc>
 void stringPieceDel(StringPiece piece, const Alloc& alloc) {
-  typename Alloc::template rebind<char>::other(alloc).deallocate(
-      const_cast<char*>(piece.data()), piece.size());
+  typename std::allocator_traits<Alloc>::template rebind_alloc<char>(alloc)
+      .deallocate(const_cast<char*>(piece.data()), piece.size());
 }
 
 } // namespace folly
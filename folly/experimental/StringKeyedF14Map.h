@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <folly/memory/Arena.h>
+
+namespace folly {
+
+/**
+ * F14FastMap<StringPiece, Mapped> that owns copies of its keys, like
+ * StringKeyedUnorderedMap, but stores all of them back to back in a
+ * SysArena rather than in separately allocated strings. This saves the
+ * allocation header and the string object of every key, which for short
+ * keys is most of the memory, and lookups with StringPiece, std::string or
+ * string literals do not construct anything.
+ *
+ * The arena is either owned by the map, or shared by several maps and
+ * other users, which must then outlive them all. As arena memory is only
+ * reclaimed when the arena is destroyed, erased and overwritten keys are
+ * not freed: this is meant for maps that are mostly built then read, such
+ * as dictionaries.
+ *
+ * Like F14FastMap, element references and iterators are invalidated by
+ * insertions; the key bytes themselves never move.
+ */
+template <
+    class Mapped,
+    class Hash = f14::DefaultHasher<StringPiece>,
+    class Eq = f14::DefaultKeyEqual<StringPiece>,
+    class Alloc = f14::DefaultAlloc<std::pair<StringPiece const, Mapped>>>
+class StringKeyedF14Map
+    : private F14FastMap<StringPiece, Mapped, Hash, Eq, Alloc> {
+ private:
+  using Base = F14FastMap<StringPiece, Mapped, Hash, Eq, Alloc>;
+
+ public:
+  typedef typename Base::key_type key_type;
+  typedef typename Base::mapped_type mapped_type;
+  typedef typename Base::value_type value_type;
+  typedef typename Base::size_type size_type;
+  typedef typename Base::difference_type difference_type;
+  typedef typename Base::hasher hasher;
+  typedef typename Base::key_equal key_equal;
+  typedef typename Base::allocator_type allocator_type;
+  typedef typename Base::reference reference;
+  typedef typename Base::const_reference const_reference;
+  typedef typename Base::pointer pointer;
+  typedef typename Base::const_pointer const_pointer;
+  typedef typename Base::iterator iterator;
+  typedef typename Base::const_iterator const_iterator;
+
+  // Key bytes are not aligned, so that short keys are packed.
+  static constexpr size_t kArenaMaxAlign = 1;
+
+  StringKeyedF14Map() : ownedArena_(makeArena()), arena_(ownedArena_.get()) {}
+
+  // The keys are copied into arena, which must outlive the map. They are
+  // only packed if the arena's maxAlign is kArenaMaxAlign.
+  explicit StringKeyedF14Map(SysArena& arena) : arena_(&arena) {}
+
+  StringKeyedF14Map(std::initializer_list<std::pair<StringPiece, Mapped>> il)
+      : StringKeyedF14Map() {
+    insert(il.begin(), il.end());
+  }
+
+  // The copy owns its own arena, unless an arena is given.
+  StringKeyedF14Map(const StringKeyedF14Map& other) : StringKeyedF14Map() {
+    copyFrom(other);
+  }
+
+  StringKeyedF14Map(const StringKeyedF14Map& other, SysArena& arena)
+      : StringKeyedF14Map(arena) {
+    copyFrom(other);
+  }
+
+  // The moved-from map gets an arena of its own when a key is next
+  // inserted into it.
+  StringKeyedF14Map(StringKeyedF14Map&& other) noexcept
+      : Base(std::move(other)),
+        ownedArena_(std::move(other.ownedArena_)),
+        arena_(std::exchange(other.arena_, nullptr)) {}
+
+  StringKeyedF14Map& operator=(const StringKeyedF14Map& other) {
+    if (this != &other) {
+      *this = StringKeyedF14Map(other);
+    }
+    return *this;
+  }
+
+  StringKeyedF14Map& operator=(StringKeyedF14Map&& other) noexcept {
+    if (this != &other) {
+      Base::operator=(std::move(other));
+      ownedArena_ = std::move(other.ownedArena_);
+      arena_ = std::exchange(other.arena_, nullptr);
+    }
+    return *this;
+  }
+
+  using Base::begin;
+  using Base::bucket_count;
+  using Base::cbegin;
+  using Base::cend;
+  using Base::empty;
+  using Base::end;
+  using Base::load_factor;
+  using Base::max_load_factor;
+  using Base::max_size;
+  using Base::reserve;
+  using Base::size;
+
+  using Base::contains;
+  using Base::count;
+  using Base::find;
+
+  mapped_type& at(StringPiece key) {
+    return Base::at(key);
+  }
+
+  mapped_type const& at(StringPiece key) const {
+    return Base::at(key);
+  }
+
+  std::pair<iterator, iterator> equal_range(StringPiece key) {
+    return Base::equal_range(key);
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range(
+      StringPiece key) const {
+    return Base::equal_range(key);
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(StringPiece key, Args&&... args) {
+    auto it = find(key);
+    if (it != end()) {
+      return {it, false};
+    }
+    return Base::try_emplace(dup(key), std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> emplace(StringPiece key, Args&&... args) {
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(std::pair<StringPiece, Mapped> const& p) {
+    return try_emplace(p.first, p.second);
+  }
+
+  std::pair<iterator, bool> insert(std::pair<StringPiece, Mapped>&& p) {
+    return try_emplace(p.first, std::move(p.second));
+  }
+
+  template <class InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      try_emplace(first->first, first->second);
+    }
+  }
+
+  template <class M>
+  std::pair<iterator, bool> insert_or_assign(StringPiece key, M&& obj) {
+    auto ret = try_emplace(key, std::forward<M>(obj));
+    if (!ret.second) {
+      ret.first->second = std::forward<M>(obj);
+    }
+    return ret;
+  }
+
+  mapped_type& operator[](StringPiece key) {
+    return try_emplace(key).first->second;
+  }
+
+  // The bytes of erased keys stay in the arena.
+  using Base::clear;
+  using Base::erase;
+
+  void swap(StringKeyedF14Map& other) noexcept {
+    Base::swap(other);
+    std::swap(ownedArena_, other.ownedArena_);
+    std::swap(arena_, other.arena_);
+  }
+
+  bool operator==(StringKeyedF14Map const& other) const {
+    return static_cast<Base const&>(*this) == static_cast<Base const&>(other);
+  }
+
+  bool operator!=(StringKeyedF14Map const& other) const {
+    return !(*this == other);
+  }
+
+  // Not available on a moved-from map until a key is inserted into it.
+  SysArena& arena() const {
+    return *arena_;
+  }
+
+  // Memory of the table, and of the arena if it is owned by the map.
+  std::size_t getAllocatedMemorySize() const {
+    return Base::getAllocatedMemorySize() +
+        (ownedArena_ ? ownedArena_->totalSize() : 0);
+  }
+
+ private:
+  StringPiece dup(StringPiece key) {
+    if (key.empty()) {
+      return StringPiece();
+    }
+    if (!arena_) {
+      ownedArena_ = makeArena();
+      arena_ = ownedArena_.get();
+    }
+    auto data = static_cast<char*>(arena_->allocate(key.size()));
+    memcpy(data, key.data(), key.size());
+    return StringPiece(data, key.size());
+  }
+
+  static std::unique_ptr<SysArena> makeArena() {
+    return std::make_unique<SysArena>(
+        SysArena::kDefaultMinBlockSize, SysArena::kNoSizeLimit, kArenaMaxAlign);
+  }
+
+  void copyFrom(const StringKeyedF14Map& other) {
+    reserve(other.size());
+    for (auto const& kv : other) {
+      Base::try_emplace(dup(kv.first), kv.second);
+    }
+  }
+
+  std::unique_ptr<SysArena> ownedArena_;
+  SysArena* arena_;
+};
+
+template <class Mapped, class Hash, class Eq, class Alloc>
+void swap(
+    StringKeyedF14Map<Mapped, Hash, Eq, Alloc>& lhs,
+    StringKeyedF14Map<Mapped, Hash, Eq, Alloc>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+} // namespace folly
@@ -16,11 +16,23 @@
 
 #pragma once
 #include <folly/CPortability.h>
+#include <folly/Conv.h>
+#include <folly/FBString.h>
+#include <folly/Likely.h>
 #include <folly/Optional.h>
 #include <folly/dynamic.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/json.h>
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 /* This is an implementation of the BSER binary serialization scheme.
  * BSER was created as a binary, local-system-only representation of
@@ -95,10 +107,524 @@ folly::dynamic parseBser(const folly::IOBuf*);
 // the header, or throws a runtime_error if the header is invalid
 size_t decodePduLength(const folly::IOBuf*);
 
+// Incremental parser for a sequence of BSER pdus, which reports their
+// values to a json::event_handler instead of building dynamics.  Only the
+// enclosing containers, the names of their templates and the value being
+// read are kept in memory.
+// Templated arrays are reported as arrays of objects, with null for the
+// skipped fields, as parseBser() returns them.
+// The parser cannot be used anymore once it has thrown.
+class stream_parser {
+ public:
+  explicit stream_parser(json::event_handler& handler);
+
+  stream_parser(const stream_parser&) = delete;
+  stream_parser& operator=(const stream_parser&) = delete;
+
+  // Parse the next bytes of the stream, which may end anywhere.
+  void feed(folly::ByteRange data);
+  // Same, for all the data in the queue, which is then removed from it.
+  void feed(folly::IOBufQueue& queue);
+
+  // Throws BserDecodeError if the stream ends inside a pdu.
+  void finish();
+
+ private:
+  struct Frame {
+    enum class Kind : uint8_t { Array, Object, TemplateNames, TemplateRows };
+
+    Kind kind;
+    // elements, items, names or rows left
+    int64_t remaining;
+    // objects: the key of the next item was reported
+    bool hasKey{false};
+    // templates: the current row and field
+    bool inRow{false};
+    size_t field{0};
+    std::vector<std::string> names;
+  };
+
+  void parse(folly::ByteRange& data);
+  // Parse the next header, key or value, or end a container; returns
+  // false if more data is needed.
+  bool step(folly::ByteRange& data);
+  // Values of templated objects report their key.
+  bool readValue(folly::ByteRange& data, const std::string* key);
+  void endFrame();
+
+  json::event_handler& handler_;
+  bool header_{true};
+  std::vector<Frame> stack_;
+  // the start of a value that was cut
+  std::string pending_;
+};
+
 folly::fbstring toBser(folly::dynamic const&, const serialization_opts&);
 std::unique_ptr<folly::IOBuf> toBserIOBuf(
     folly::dynamic const&,
     const serialization_opts&);
+
+// Specialize these to encode and decode your own types with writer::write()
+// and reader::read():
+//   template <> struct serializer<Foo> {
+//     static void write(writer& w, const Foo& foo);
+//   };
+//   template <> struct deserializer<Foo> {
+//     static Foo read(reader& r);
+//   };
+// Specializations are provided for bool, integers, floating point values,
+// strings, folly::Optional (null when empty), std::vector, std::map and
+// std::unordered_map with string keys, and folly::dynamic.
+template <class T, class Enable = void>
+struct serializer;
+template <class T, class Enable = void>
+struct deserializer;
+
+// Streaming encoder of one BSER pdu, for values that aren't folly::dynamic.
+// Containers are written as a header with their size, followed by their
+// elements (a key, then a value, for each item of an object).
+class writer {
+ public:
+  explicit writer(const serialization_opts& opts = serialization_opts());
+
+  writer(const writer&) = delete;
+  writer& operator=(const writer&) = delete;
+
+  void writeNull();
+  void writeBool(bool value);
+  void writeInt(int64_t value);
+  void writeDouble(double value);
+  void writeString(folly::StringPiece str);
+  void writeArrayHeader(size_t size);
+  void writeObjectHeader(size_t size);
+  void writeKey(folly::StringPiece key) {
+    writeString(key);
+  }
+  // An array of size objects with the given keys, each written as its
+  // values in the order of names, with writeSkip() for missing ones.
+  void writeTemplateHeader(
+      const std::vector<folly::StringPiece>& names,
+      size_t size);
+  void writeSkip();
+
+  // An array of integers, encoded into contiguous space a chunk at a time.
+  template <class Int>
+  void writeIntArray(const Int* values, size_t size);
+
+  void write(const folly::dynamic& value);
+  template <class T>
+  void write(const T& value) {
+    serializer<T>::write(*this, value);
+  }
+
+  // Returns the pdu, with its header. The writer can't be used afterwards.
+  std::unique_ptr<folly::IOBuf> finish();
+
+ private:
+  serialization_opts opts_;
+  folly::IOBufQueue queue_;
+  folly::io::QueueAppender appender_;
+};
+
+// Pull decoder of one BSER pdu in contiguous memory. Values are read in
+// the order they are encoded. skipValue() steps over a value, containers
+// included, without building anything, so unneeded keys only cost a walk
+// over their bytes. Strings point into the pdu. Errors throw
+// BserDecodeError.
+class reader {
+ public:
+  // data must start with a complete pdu; bytes after it are ignored.
+  explicit reader(folly::ByteRange data);
+
+  // Type of the next value; throws if the pdu has been read entirely.
+  BserType peekType() const;
+  // Whether the pdu has been read entirely
+  bool done() const {
+    return data_.empty();
+  }
+
+  void readNull();
+  bool readBool();
+  int64_t readInt();
+  double readDouble();
+  folly::StringPiece readString();
+  size_t readArrayHeader();
+  size_t readObjectHeader();
+  folly::StringPiece readKey() {
+    return readString();
+  }
+  // Fills names and returns the number of objects of a templated array;
+  // their values follow in the order of names, each possibly a skip
+  // marker (see readSkip()).
+  size_t readTemplateHeader(std::vector<folly::StringPiece>& names);
+  // Reads a skip marker if it comes next.
+  bool readSkip();
+  void skipValue();
+
+  // An array of integers, without going through peekType() for each one.
+  template <class Int, class Alloc>
+  void readIntArray(std::vector<Int, Alloc>& out);
+
+  folly::dynamic readDynamic();
+  template <class T>
+  T read() {
+    return deserializer<T>::read(*this);
+  }
+
+ private:
+  [[noreturn]] void throwTruncated() const;
+  void need(size_t size) const {
+    if (UNLIKELY(data_.size() < size)) {
+      throwTruncated();
+    }
+  }
+
+  folly::ByteRange data_;
+};
+
+template <class T>
+std::unique_ptr<folly::IOBuf> toBserIOBufFrom(
+    const T& value,
+    const serialization_opts& opts = serialization_opts()) {
+  writer w(opts);
+  w.write(value);
+  return w.finish();
+}
+
+template <class T>
+T parseBserAs(folly::ByteRange pdu) {
+  reader r(pdu);
+  return r.read<T>();
+}
+
+// Implementation below
+
+namespace detail {
+
+// Writes the smallest encoding of value to p, which must have room for 9
+// bytes, and returns the end of the encoding.
+inline uint8_t* encodeBserInt(int64_t value, uint8_t* p) {
+  if (value == int8_t(value)) {
+    p[0] = uint8_t(BserType::Int8);
+    p[1] = uint8_t(value);
+    return p + 2;
+  }
+  if (value == int16_t(value)) {
+    p[0] = uint8_t(BserType::Int16);
+    storeUnaligned(p + 1, int16_t(value));
+    return p + 3;
+  }
+  if (value == int32_t(value)) {
+    p[0] = uint8_t(BserType::Int32);
+    storeUnaligned(p + 1, int32_t(value));
+    return p + 5;
+  }
+  p[0] = uint8_t(BserType::Int64);
+  storeUnaligned(p + 1, value);
+  return p + 9;
+}
+
+// Reads an integer at p, or returns false if it isn't one or is cut.
+inline bool
+decodeBserInt(const uint8_t*& p, const uint8_t* end, int64_t& value) {
+  if (p == end) {
+    return false;
+  }
+  switch (BserType(*p)) {
+    case BserType::Int8:
+      if (end - p < 2) {
+        return false;
+      }
+      value = int8_t(p[1]);
+      p += 2;
+      return true;
+    case BserType::Int16:
+      if (end - p < 3) {
+        return false;
+      }
+      value = loadUnaligned<int16_t>(p + 1);
+      p += 3;
+      return true;
+    case BserType::Int32:
+      if (end - p < 5) {
+        return false;
+      }
+      value = loadUnaligned<int32_t>(p + 1);
+      p += 5;
+      return true;
+    case BserType::Int64:
+      if (end - p < 9) {
+        return false;
+      }
+      value = loadUnaligned<int64_t>(p + 1);
+      p += 9;
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <class T>
+using IsBserInt = std::integral_constant<
+    bool,
+    std::is_integral<T>::value && !std::is_same<T, bool>::value>;
+
+[[noreturn]] void throwBserIntTooLarge(uint64_t value);
+[[noreturn]] void throwBserIntOutOfRange(int64_t value);
+
+// BSER integers are signed 64 bits, so the upper half of uint64_t can't be
+// encoded. Throws std::range_error for those values.
+template <class Int>
+inline int64_t toBserInt(Int value) {
+  if (std::is_unsigned<Int>::value && sizeof(Int) >= sizeof(int64_t) &&
+      UNLIKELY(
+          uint64_t(value) > uint64_t(std::numeric_limits<int64_t>::max()))) {
+    throwBserIntTooLarge(uint64_t(value));
+  }
+  return int64_t(value);
+}
+
+// Throws BserDecodeError if T can't represent the decoded value.
+template <class T>
+inline T fromBserInt(int64_t value) {
+  auto result = folly::tryTo<T>(value);
+  if (UNLIKELY(!result)) {
+    throwBserIntOutOfRange(value);
+  }
+  return *result;
+}
+
+} // namespace detail
+
+template <class Int>
+void writer::writeIntArray(const Int* values, size_t size) {
+  static_assert(detail::IsBserInt<Int>::value, "Int must be an integer");
+  constexpr size_t kChunk = 256;
+  constexpr size_t kMaxIntSize = 1 + sizeof(int64_t);
+  writeArrayHeader(size);
+  while (size > 0) {
+    size_t n = std::min(size, kChunk);
+    appender_.ensure(n * kMaxIntSize);
+    uint8_t* start = appender_.writableData();
+    uint8_t* p = start;
+    for (size_t i = 0; i < n; ++i) {
+      p = detail::encodeBserInt(detail::toBserInt(values[i]), p);
+    }
+    appender_.append(size_t(p - start));
+    values += n;
+    size -= n;
+  }
+}
+
+template <class Int, class Alloc>
+void reader::readIntArray(std::vector<Int, Alloc>& out) {
+  static_assert(detail::IsBserInt<Int>::value, "Int must be an integer");
+  size_t size = readArrayHeader();
+  // every integer takes at least two bytes
+  out.reserve(out.size() + std::min(size, data_.size() / 2));
+  const uint8_t* p = data_.begin();
+  for (size_t i = 0; i < size; ++i) {
+    int64_t value;
+    if (UNLIKELY(!detail::decodeBserInt(p, data_.end(), value))) {
+      data_.advance(size_t(p - data_.begin()));
+      // throws the appropriate error
+      value = readInt();
+      p = data_.begin();
+    }
+    out.push_back(detail::fromBserInt<Int>(value));
+  }
+  data_.advance(size_t(p - data_.begin()));
+}
+
+template <>
+struct serializer<folly::dynamic> {
+  static void write(writer& w, const folly::dynamic& value) {
+    w.write(value);
+  }
+};
+
+template <>
+struct deserializer<folly::dynamic> {
+  static folly::dynamic read(reader& r) {
+    return r.readDynamic();
+  }
+};
+
+template <>
+struct serializer<bool> {
+  static void write(writer& w, bool value) {
+    w.writeBool(value);
+  }
+};
+
+template <>
+struct deserializer<bool> {
+  static bool read(reader& r) {
+    return r.readBool();
+  }
+};
+
+template <class T>
+struct serializer<T, std::enable_if_t<detail::IsBserInt<T>::value>> {
+  static void write(writer& w, T value) {
+    w.writeInt(detail::toBserInt(value));
+  }
+};
+
+template <class T>
+struct deserializer<T, std::enable_if_t<detail::IsBserInt<T>::value>> {
+  static T read(reader& r) {
+    return detail::fromBserInt<T>(r.readInt());
+  }
+};
+
+template <class T>
+struct serializer<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static void write(writer& w, T value) {
+    w.writeDouble(double(value));
+  }
+};
+
+template <class T>
+struct deserializer<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static T read(reader& r) {
+    if (r.peekType() == BserType::Real) {
+      return T(r.readDouble());
+    }
+    return detail::fromBserInt<T>(r.readInt());
+  }
+};
+
+template <class T>
+struct serializer<
+    T,
+    std::enable_if_t<
+        std::is_same<T, std::string>::value ||
+        std::is_same<T, folly::fbstring>::value ||
+        std::is_same<T, folly::StringPiece>::value>> {
+  static void write(writer& w, const T& value) {
+    w.writeString(value);
+  }
+};
+
+template <class T>
+struct deserializer<
+    T,
+    std::enable_if_t<
+        std::is_same<T, std::string>::value ||
+        std::is_same<T, folly::fbstring>::value ||
+        std::is_same<T, folly::StringPiece>::value>> {
+  static T read(reader& r) {
+    auto str = r.readString();
+    return T(str.data(), str.size());
+  }
+};
+
+template <class T>
+struct serializer<folly::Optional<T>> {
+  static void write(writer& w, const folly::Optional<T>& value) {
+    if (value) {
+      w.write(*value);
+    } else {
+      w.writeNull();
+    }
+  }
+};
+
+template <class T>
+struct deserializer<folly::Optional<T>> {
+  static folly::Optional<T> read(reader& r) {
+    if (r.peekType() == BserType::Null) {
+      r.readNull();
+      return folly::none;
+    }
+    return r.read<T>();
+  }
+};
+
+template <class T, class Alloc>
+struct serializer<std::vector<T, Alloc>> {
+  static void write(writer& w, const std::vector<T, Alloc>& values) {
+    writeImpl(w, values, detail::IsBserInt<T>());
+  }
+
+ private:
+  static void
+  writeImpl(writer& w, const std::vector<T, Alloc>& values, std::true_type) {
+    w.writeIntArray(values.data(), values.size());
+  }
+
+  static void
+  writeImpl(writer& w, const std::vector<T, Alloc>& values, std::false_type) {
+    w.writeArrayHeader(values.size());
+    for (const auto& value : values) {
+      w.write(value);
+    }
+  }
+};
+
+template <class T, class Alloc>
+struct deserializer<std::vector<T, Alloc>> {
+  static std::vector<T, Alloc> read(reader& r) {
+    std::vector<T, Alloc> values;
+    readImpl(r, values, detail::IsBserInt<T>());
+    return values;
+  }
+
+ private:
+  static void
+  readImpl(reader& r, std::vector<T, Alloc>& values, std::true_type) {
+    r.readIntArray(values);
+  }
+
+  static void
+  readImpl(reader& r, std::vector<T, Alloc>& values, std::false_type) {
+    size_t size = r.readArrayHeader();
+    for (size_t i = 0; i < size; ++i) {
+      values.push_back(r.read<T>());
+    }
+  }
+};
+
+namespace detail {
+
+template <class Map>
+struct BserMapSerializer {
+  static void write(writer& w, const Map& map) {
+    w.writeObjectHeader(map.size());
+    for (const auto& item : map) {
+      w.writeKey(item.first);
+      w.write(item.second);
+    }
+  }
+
+  static Map read(reader& r) {
+    Map map;
+    size_t size = r.readObjectHeader();
+    for (size_t i = 0; i < size; ++i) {
+      auto key = r.readKey();
+      map[typename Map::key_type(key.data(), key.size())] =
+          r.read<typename Map::mapped_type>();
+    }
+    return map;
+  }
+};
+
+} // namespace detail
+
+template <class K, class V, class... Args>
+struct serializer<std::map<K, V, Args...>>
+    : detail::BserMapSerializer<std::map<K, V, Args...>> {};
+template <class K, class V, class... Args>
+struct deserializer<std::map<K, V, Args...>>
+    : detail::BserMapSerializer<std::map<K, V, Args...>> {};
+template <class K, class V, class... Args>
+struct serializer<std::unordered_map<K, V, Args...>>
+    : detail::BserMapSerializer<std::unordered_map<K, V, Args...>> {};
+template <class K, class V, class... Args>
+struct deserializer<std::unordered_map<K, V, Args...>>
+    : detail::BserMapSerializer<std::unordered_map<K, V, Args...>> {};
+
 } // namespace bser
 } // namespace folly
 
@@ -188,24 +188,80 @@ static void bserEncode(
   }
 }
 
-std::unique_ptr<folly::IOBuf> toBserIOBuf(
-    folly::dynamic const& dyn,
-    const serialization_opts& opts) {
-  IOBufQueue q(IOBufQueue::cacheChainLength());
-  uint8_t hdrbuf[sizeof(kMagic) + 1 + sizeof(int64_t)];
+// Room for the magic and the largest encoding of the pdu length
+static constexpr size_t kMaxHeaderSize = sizeof(kMagic) + 1 + sizeof(int64_t);
 
+static std::unique_ptr<IOBuf> headroomBuf(const serialization_opts& opts) {
   // Reserve some headroom for the overall PDU size; we'll fill this in
   // after we've serialized the data and know the length
-  auto firstbuf = IOBuf::create(opts.growth_increment);
-  firstbuf->advance(sizeof(hdrbuf));
-  q.append(std::move(firstbuf));
+  auto buf = IOBuf::create(opts.growth_increment);
+  buf->advance(kMaxHeaderSize);
+  return buf;
+}
+
+writer::writer(const serialization_opts& opts)
+    : opts_(opts),
+      queue_(IOBufQueue::cacheChainLength()),
+      appender_(&queue_, opts.growth_increment) {
+  queue_.append(headroomBuf(opts_));
+  appender_.reset(&queue_, opts_.growth_increment);
+}
+
+void writer::writeNull() {
+  appender_.write((int8_t)BserType::Null);
+}
+
+void writer::writeBool(bool value) {
+  appender_.write((int8_t)(value ? BserType::True : BserType::False));
+}
+
+void writer::writeInt(int64_t value) {
+  bserEncodeInt(value, appender_);
+}
+
+void writer::writeDouble(double value) {
+  appender_.write((int8_t)BserType::Real);
+  appender_.write(value);
+}
+
+void writer::writeString(StringPiece str) {
+  bserEncodeString(str, appender_);
+}
+
+void writer::writeArrayHeader(size_t size) {
+  appender_.write((int8_t)BserType::Array);
+  bserEncodeInt(int64_t(size), appender_);
+}
+
+void writer::writeObjectHeader(size_t size) {
+  appender_.write((int8_t)BserType::Object);
+  bserEncodeInt(int64_t(size), appender_);
+}
 
-  // encode the value
-  QueueAppender appender(&q, opts.growth_increment);
-  bserEncode(dyn, appender, opts);
+void writer::writeTemplateHeader(
+    const std::vector<StringPiece>& names,
+    size_t size) {
+  appender_.write((int8_t)BserType::Template);
+  writeArrayHeader(names.size());
+  for (auto name : names) {
+    writeString(name);
+  }
+  bserEncodeInt(int64_t(size), appender_);
+}
+
+void writer::writeSkip() {
+  appender_.write((int8_t)BserType::Skip);
+}
+
+void writer::write(const dynamic& value) {
+  bserEncode(value, appender_, opts_);
+}
+
+std::unique_ptr<IOBuf> writer::finish() {
+  uint8_t hdrbuf[kMaxHeaderSize];
 
   // compute the length
-  auto len = q.chainLength();
+  auto len = queue_.chainLength();
   if (len > uint64_t(std::numeric_limits<int64_t>::max())) {
     throw std::range_error(folly::to<std::string>(
         "serialized data size ", len, " is too large to represent as BSER"));
@@ -238,15 +294,30 @@ std::unique_ptr<folly::IOBuf> toBserIOBuf(
   }
 
   // and place the data in the headroom
-  q.prepend(hdrbuf, hdrlen);
+  queue_.prepend(hdrbuf, hdrlen);
+
+  return queue_.move();
+}
 
-  return q.move();
+std::unique_ptr<folly::IOBuf> toBserIOBuf(
+    folly::dynamic const& dyn,
+    const serialization_opts& opts) {
+  writer w(opts);
+  w.write(dyn);
+  return w.finish();
 }
 
 fbstring toBser(dynamic const& dyn, const serialization_opts& opts) {
   auto buf = toBserIOBuf(dyn, opts);
   return buf->moveToFbString();
 }
+
+namespace detail {
+void throwBserIntTooLarge(uint64_t value) {
+  throw std::range_error(folly::to<std::string>(
+      "integer ", value, " is too large to represent as BSER"));
+}
+} // namespace detail
 } // namespace bser
 } // namespace folly
 
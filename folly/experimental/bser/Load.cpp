@@ -18,6 +18,7 @@
 
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
 
 using namespace folly;
 using folly::io::Cursor;
@@ -237,6 +238,522 @@ folly::dynamic parseBser(ByteRange str) {
 folly::dynamic parseBser(StringPiece str) {
   return parseBser(ByteRange((uint8_t*)str.data(), str.size()));
 }
+
+// Reads an integer and its encoding; returns false if data is too short.
+static bool readInt(ByteRange& data, int64_t& value) {
+  if (data.empty()) {
+    return false;
+  }
+  auto enc = (BserType)data[0];
+  size_t size;
+  switch (enc) {
+    case BserType::Int8:
+      size = 1;
+      break;
+    case BserType::Int16:
+      size = 2;
+      break;
+    case BserType::Int32:
+      size = 4;
+      break;
+    case BserType::Int64:
+      size = 8;
+      break;
+    default:
+      throw BserDecodeError(folly::to<std::string>(
+          "invalid integer encoding detected (", (int8_t)enc, ")"));
+  }
+  if (data.size() < 1 + size) {
+    return false;
+  }
+  auto p = data.data() + 1;
+  value = size == 1
+      ? (int8_t)*p
+      : size == 2 ? loadUnaligned<int16_t>(p)
+                  : size == 4 ? loadUnaligned<int32_t>(p)
+                              : loadUnaligned<int64_t>(p);
+  data.advance(1 + size);
+  return true;
+}
+
+// Reads the length and bytes of a string.
+static bool readString(ByteRange& data, StringPiece& str) {
+  auto rest = data;
+  int64_t len;
+  if (!readInt(rest, len)) {
+    return false;
+  }
+  if (len < 0) {
+    throw BserDecodeError("string length must not be negative");
+  }
+  if (rest.size() < size_t(len)) {
+    return false;
+  }
+  str = StringPiece(rest.subpiece(0, len));
+  data = rest.subpiece(len);
+  return true;
+}
+
+stream_parser::stream_parser(json::event_handler& handler)
+    : handler_(handler) {}
+
+void stream_parser::feed(ByteRange data) {
+  if (pending_.empty()) {
+    parse(data);
+    pending_.assign(data.begin(), data.end());
+    return;
+  }
+  pending_.append(data.begin(), data.end());
+  auto buffered = ByteRange(StringPiece(pending_));
+  parse(buffered);
+  pending_.erase(0, pending_.size() - buffered.size());
+}
+
+void stream_parser::feed(IOBufQueue& queue) {
+  if (auto buf = queue.front()) {
+    for (auto range : *buf) {
+      feed(range);
+    }
+  }
+  queue.move();
+}
+
+void stream_parser::finish() {
+  if (!header_ || !pending_.empty()) {
+    throw BserDecodeError("bser stream ends inside a pdu");
+  }
+}
+
+void stream_parser::parse(ByteRange& data) {
+  while (step(data)) {
+  }
+}
+
+bool stream_parser::step(ByteRange& data) {
+  if (header_) {
+    if (data.size() < sizeof(kMagic)) {
+      return false;
+    }
+    if (memcmp(data.data(), kMagic, sizeof(kMagic))) {
+      throw BserDecodeError("invalid BSER magic header");
+    }
+    auto rest = data.subpiece(sizeof(kMagic));
+    int64_t length;
+    if (!readInt(rest, length)) {
+      return false;
+    }
+    data = rest;
+    header_ = false;
+    return true;
+  }
+  if (stack_.empty()) {
+    return readValue(data, nullptr);
+  }
+
+  auto depth = stack_.size() - 1;
+  auto& frame = stack_.back();
+  switch (frame.kind) {
+    case Frame::Kind::Array:
+      if (frame.remaining <= 0) {
+        endFrame();
+        handler_.onArrayEnd();
+        return true;
+      }
+      if (!readValue(data, nullptr)) {
+        return false;
+      }
+      --stack_[depth].remaining;
+      return true;
+    case Frame::Kind::Object:
+      if (frame.remaining <= 0) {
+        endFrame();
+        handler_.onObjectEnd();
+        return true;
+      }
+      if (!frame.hasKey) {
+        if (data.empty()) {
+          return false;
+        }
+        if ((BserType)data[0] != BserType::String) {
+          throw BserDecodeError("expected String");
+        }
+        auto rest = data.subpiece(1);
+        StringPiece key;
+        if (!readString(rest, key)) {
+          return false;
+        }
+        data = rest;
+        frame.hasKey = true;
+        handler_.onKey(key);
+        return true;
+      }
+      if (!readValue(data, nullptr)) {
+        return false;
+      }
+      stack_[depth].hasKey = false;
+      --stack_[depth].remaining;
+      return true;
+    case Frame::Kind::TemplateNames: {
+      if (frame.remaining <= 0) {
+        int64_t rows;
+        if (!readInt(data, rows)) {
+          return false;
+        }
+        frame.kind = Frame::Kind::TemplateRows;
+        frame.remaining = rows;
+        handler_.onArrayStart();
+        return true;
+      }
+      if (data.empty()) {
+        return false;
+      }
+      if ((BserType)data[0] != BserType::String) {
+        throw BserDecodeError("expected String for template property name");
+      }
+      auto rest = data.subpiece(1);
+      StringPiece name;
+      if (!readString(rest, name)) {
+        return false;
+      }
+      data = rest;
+      frame.names.push_back(name.str());
+      --frame.remaining;
+      return true;
+    }
+    case Frame::Kind::TemplateRows:
+      if (!frame.inRow) {
+        if (frame.remaining <= 0) {
+          endFrame();
+          handler_.onArrayEnd();
+          return true;
+        }
+        frame.inRow = true;
+        frame.field = 0;
+        handler_.onObjectStart();
+        return true;
+      }
+      if (frame.field == frame.names.size()) {
+        frame.inRow = false;
+        --frame.remaining;
+        handler_.onObjectEnd();
+        return true;
+      }
+      if (!readValue(data, &frame.names[frame.field])) {
+        return false;
+      }
+      ++stack_[depth].field;
+      return true;
+  }
+  return false;
+}
+
+bool stream_parser::readValue(ByteRange& data, const std::string* key) {
+  if (data.empty()) {
+    return false;
+  }
+  auto rest = data.subpiece(1);
+  // the key is gone once a frame is pushed
+  auto start = [&] {
+    data = rest;
+    if (key) {
+      handler_.onKey(*key);
+    }
+  };
+  // a scalar at the top ends its pdu
+  auto end = [&] { header_ = stack_.empty(); };
+  switch ((BserType)data[0]) {
+    case BserType::Int8:
+    case BserType::Int16:
+    case BserType::Int32:
+    case BserType::Int64: {
+      rest = data;
+      int64_t value;
+      if (!readInt(rest, value)) {
+        return false;
+      }
+      start();
+      handler_.onInt(value);
+      end();
+      return true;
+    }
+    case BserType::Real: {
+      if (rest.size() < sizeof(double)) {
+        return false;
+      }
+      auto value = loadUnaligned<double>(rest.data());
+      rest.advance(sizeof(double));
+      start();
+      handler_.onDouble(value);
+      end();
+      return true;
+    }
+    case BserType::True:
+    case BserType::False: {
+      auto value = (BserType)data[0] == BserType::True;
+      start();
+      handler_.onBool(value);
+      end();
+      return true;
+    }
+    case BserType::Null:
+      start();
+      handler_.onNull();
+      end();
+      return true;
+    case BserType::String: {
+      StringPiece str;
+      if (!readString(rest, str)) {
+        return false;
+      }
+      start();
+      handler_.onString(str);
+      end();
+      return true;
+    }
+    case BserType::Array:
+    case BserType::Object: {
+      auto array = (BserType)data[0] == BserType::Array;
+      int64_t size;
+      if (!readInt(rest, size)) {
+        return false;
+      }
+      start();
+      stack_.push_back(
+          {array ? Frame::Kind::Array : Frame::Kind::Object, size});
+      array ? handler_.onArrayStart() : handler_.onObjectStart();
+      return true;
+    }
+    case BserType::Template: {
+      if (rest.empty()) {
+        return false;
+      }
+      if ((BserType)rest[0] != BserType::Array) {
+        throw BserDecodeError("Expected array encoding for property names");
+      }
+      rest.advance(1);
+      int64_t names;
+      if (!readInt(rest, names)) {
+        return false;
+      }
+      start();
+      // the array starts once its names are known
+      stack_.push_back({Frame::Kind::TemplateNames, names});
+      return true;
+    }
+    case BserType::Skip:
+      if (!key) {
+        throw BserDecodeError(
+            "Skip not valid at this location in the bser stream");
+      }
+      start();
+      handler_.onNull();
+      return true;
+    default:
+      throw BserDecodeError("invalid bser encoding");
+  }
+}
+
+void stream_parser::endFrame() {
+  stack_.pop_back();
+  header_ = stack_.empty();
+}
+
+reader::reader(ByteRange data) {
+  if (data.size() < sizeof(kMagic) ||
+      memcmp(data.data(), kMagic, sizeof(kMagic))) {
+    throw BserDecodeError("invalid BSER magic header");
+  }
+  data.advance(sizeof(kMagic));
+  int64_t length;
+  if (!bser::readInt(data, length)) {
+    throw BserDecodeError("bser pdu ends inside its header");
+  }
+  if (length < 0 || data.size() < uint64_t(length)) {
+    throw BserDecodeError(folly::to<std::string>(
+        "bser pdu of ", length, " bytes with ", data.size(), " available"));
+  }
+  data_ = data.subpiece(0, size_t(length));
+}
+
+void reader::throwTruncated() const {
+  throw BserDecodeError("bser pdu ends inside a value");
+}
+
+BserType reader::peekType() const {
+  need(1);
+  return (BserType)data_[0];
+}
+
+void reader::readNull() {
+  if (peekType() != BserType::Null) {
+    throw BserDecodeError("expected Null");
+  }
+  data_.advance(1);
+}
+
+bool reader::readBool() {
+  auto type = peekType();
+  if (type != BserType::True && type != BserType::False) {
+    throw BserDecodeError("expected True or False");
+  }
+  data_.advance(1);
+  return type == BserType::True;
+}
+
+int64_t reader::readInt() {
+  int64_t value;
+  if (!bser::readInt(data_, value)) {
+    throwTruncated();
+  }
+  return value;
+}
+
+double reader::readDouble() {
+  if (peekType() != BserType::Real) {
+    throw BserDecodeError("expected Real");
+  }
+  need(1 + sizeof(double));
+  auto value = loadUnaligned<double>(data_.data() + 1);
+  data_.advance(1 + sizeof(double));
+  return value;
+}
+
+StringPiece reader::readString() {
+  if (peekType() != BserType::String) {
+    throw BserDecodeError("expected String");
+  }
+  auto rest = data_.subpiece(1);
+  StringPiece str;
+  if (!bser::readString(rest, str)) {
+    throwTruncated();
+  }
+  data_ = rest;
+  return str;
+}
+
+size_t reader::readArrayHeader() {
+  if (peekType() != BserType::Array) {
+    throw BserDecodeError("expected Array");
+  }
+  data_.advance(1);
+  auto size = readInt();
+  if (size < 0) {
+    throw BserDecodeError("array size must not be negative");
+  }
+  return size_t(size);
+}
+
+size_t reader::readObjectHeader() {
+  if (peekType() != BserType::Object) {
+    throw BserDecodeError("expected Object");
+  }
+  data_.advance(1);
+  auto size = readInt();
+  if (size < 0) {
+    throw BserDecodeError("object size must not be negative");
+  }
+  return size_t(size);
+}
+
+size_t reader::readTemplateHeader(std::vector<StringPiece>& names) {
+  if (peekType() != BserType::Template) {
+    throw BserDecodeError("expected Template");
+  }
+  data_.advance(1);
+  names.clear();
+  auto count = readArrayHeader();
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(readString());
+  }
+  auto size = readInt();
+  if (size < 0) {
+    throw BserDecodeError("template size must not be negative");
+  }
+  return size_t(size);
+}
+
+bool reader::readSkip() {
+  if (peekType() != BserType::Skip) {
+    return false;
+  }
+  data_.advance(1);
+  return true;
+}
+
+void reader::skipValue() {
+  switch (peekType()) {
+    case BserType::Int8:
+    case BserType::Int16:
+    case BserType::Int32:
+    case BserType::Int64:
+      readInt();
+      return;
+    case BserType::Real:
+      need(1 + sizeof(double));
+      data_.advance(1 + sizeof(double));
+      return;
+    case BserType::True:
+    case BserType::False:
+    case BserType::Null:
+      data_.advance(1);
+      return;
+    case BserType::String:
+      readString();
+      return;
+    case BserType::Array: {
+      auto size = readArrayHeader();
+      for (size_t i = 0; i < size; ++i) {
+        skipValue();
+      }
+      return;
+    }
+    case BserType::Object: {
+      auto size = readObjectHeader();
+      for (size_t i = 0; i < size; ++i) {
+        readKey();
+        skipValue();
+      }
+      return;
+    }
+    case BserType::Template: {
+      data_.advance(1);
+      auto names = readArrayHeader();
+      for (size_t i = 0; i < names; ++i) {
+        readString();
+      }
+      auto size = readInt();
+      for (int64_t row = 0; row < size; ++row) {
+        for (size_t i = 0; i < names; ++i) {
+          if (!readSkip()) {
+            skipValue();
+          }
+        }
+      }
+      return;
+    }
+    case BserType::Skip:
+      throw BserDecodeError(
+          "Skip not valid at this location in the bser stream");
+    default:
+      throw BserDecodeError("invalid bser encoding");
+  }
+}
+
+dynamic reader::readDynamic() {
+  auto start = data_;
+  skipValue();
+  auto value = start.subpiece(0, start.size() - data_.size());
+  auto buf = IOBuf::wrapBuffer(value.data(), value.size());
+  Cursor curs(buf.get());
+  return bser::parseBser(curs);
+}
+
+namespace detail {
+void throwBserIntOutOfRange(int64_t value) {
+  throw BserDecodeError(folly::to<std::string>(
+      "integer ", value, " is out of range of the requested type"));
+}
+} // namespace detail
 } // namespace bser
 } // namespace folly
 
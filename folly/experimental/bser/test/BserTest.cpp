@@ -16,6 +16,9 @@
 
 #include <folly/experimental/bser/Bser.h>
 
+#include <limits>
+
+#include <folly/Memory.h>
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 
@@ -145,5 +148,297 @@ TEST(Bser, CursorLength) {
   }
 }
 
+namespace {
+
+// Logs the events of a stream_parser.
+class EventLog : public folly::json::event_handler {
+ public:
+  void onObjectStart() override {
+    log += "{";
+  }
+  void onKey(folly::StringPiece key) override {
+    log += folly::to<std::string>(key, ":");
+  }
+  void onObjectEnd() override {
+    log += "}";
+  }
+  void onArrayStart() override {
+    log += "[";
+  }
+  void onArrayEnd() override {
+    log += "]";
+  }
+  void onString(folly::StringPiece value) override {
+    log += folly::to<std::string>("\"", value, "\" ");
+  }
+  void onInt(int64_t value) override {
+    log += folly::to<std::string>(value, " ");
+  }
+  void onDouble(double value) override {
+    log += folly::to<std::string>(value, "d ");
+  }
+  void onBool(bool value) override {
+    log += value ? "true " : "false ";
+  }
+  void onNull() override {
+    log += "null ";
+  }
+
+  std::string log;
+};
+
+// The events a value is reported as, in the order toBser() writes it.
+void describe(const dynamic& value, EventLog& log) {
+  switch (value.type()) {
+    case dynamic::ARRAY:
+      log.onArrayStart();
+      for (const auto& element : value) {
+        describe(element, log);
+      }
+      log.onArrayEnd();
+      break;
+    case dynamic::OBJECT:
+      log.onObjectStart();
+      for (const auto& item : value.items()) {
+        log.onKey(item.first.asString());
+        describe(item.second, log);
+      }
+      log.onObjectEnd();
+      break;
+    case dynamic::STRING:
+      log.onString(value.asString());
+      break;
+    case dynamic::INT64:
+      log.onInt(value.asInt());
+      break;
+    case dynamic::DOUBLE:
+      log.onDouble(value.asDouble());
+      break;
+    case dynamic::BOOL:
+      log.onBool(value.asBool());
+      break;
+    case dynamic::NULLT:
+      log.onNull();
+      break;
+  }
+}
+
+} // namespace
+
+TEST(Bser, StreamParser) {
+  folly::fbstring stream;
+  EventLog expected;
+  for (const auto& dyn : roundtrips) {
+    stream += folly::bser::toBser(dyn, folly::bser::serialization_opts());
+    describe(dyn, expected);
+  }
+  stream.append((const char*)template_blob, sizeof(template_blob) - 1);
+  expected.log +=
+      "[{name:\"fred\" age:20 }{name:\"pete\" age:30 }{name:null age:25 }]";
+
+  for (size_t chunk : {1, 3, 1000}) {
+    EventLog log;
+    folly::bser::stream_parser parser(log);
+    folly::IOBufQueue queue;
+    for (size_t i = 0; i < stream.size(); i += chunk) {
+      queue.append(folly::IOBuf::copyBuffer(
+          stream.data() + i, std::min(chunk, stream.size() - i)));
+      parser.feed(queue);
+      EXPECT_TRUE(queue.empty());
+    }
+    parser.finish();
+    EXPECT_EQ(expected.log, log.log) << "in chunks of " << chunk;
+  }
+}
+
+TEST(Bser, StreamParserErrors) {
+  EventLog log;
+  folly::bser::stream_parser truncated(log);
+  truncated.feed(folly::ByteRange(template_blob, 20));
+  EXPECT_THROW(truncated.finish(), folly::bser::BserDecodeError);
+
+  folly::bser::stream_parser magic(log);
+  EXPECT_THROW(
+      magic.feed(folly::StringPiece("\x01\x02\x03\x01\x0a")),
+      folly::bser::BserDecodeError);
+
+  // Skip is only valid in templated objects
+  folly::bser::stream_parser skip(log);
+  EXPECT_THROW(
+      skip.feed(folly::StringPiece("\x00\x01\x03\x01\x0c", 5)),
+      folly::bser::BserDecodeError);
+}
+
+namespace {
+
+struct File {
+  std::string name;
+  int64_t size;
+  folly::Optional<double> mtime;
+  std::vector<int32_t> blocks;
+};
+
+} // namespace
+
+namespace folly {
+namespace bser {
+
+template <>
+struct serializer<File> {
+  static void write(writer& w, const File& file) {
+    w.writeObjectHeader(4);
+    w.writeKey("name");
+    w.write(file.name);
+    w.writeKey("size");
+    w.write(file.size);
+    w.writeKey("mtime");
+    w.write(file.mtime);
+    w.writeKey("blocks");
+    w.write(file.blocks);
+  }
+};
+
+// Only reads name and blocks
+template <>
+struct deserializer<File> {
+  static File read(reader& r) {
+    File file{};
+    auto size = r.readObjectHeader();
+    for (size_t i = 0; i < size; ++i) {
+      auto key = r.readKey();
+      if (key == "name") {
+        file.name = r.read<std::string>();
+      } else if (key == "blocks") {
+        file.blocks = r.read<std::vector<int32_t>>();
+      } else {
+        r.skipValue();
+      }
+    }
+    return file;
+  }
+};
+
+} // namespace bser
+} // namespace folly
+
+TEST(Bser, Traits) {
+  std::vector<File> files = {
+      {"a", 1, 2.5, {1, 200, 70000, -5}},
+      {"b", int64_t(1) << 40, folly::none, {}},
+  };
+  auto buf = folly::bser::toBserIOBufFrom(files);
+
+  // the same bytes as through dynamic
+  dynamic expected = dynamic::array(
+      dynamic::object("name", "a")("size", 1)("mtime", 2.5)(
+          "blocks", dynamic::array(1, 200, 70000, -5)),
+      dynamic::object("name", "b")("size", int64_t(1) << 40)("mtime", nullptr)(
+          "blocks", dynamic::array()));
+  buf->coalesce();
+  EXPECT_EQ(expected, folly::bser::parseBser(buf.get()));
+
+  auto decoded =
+      folly::bser::parseBserAs<std::vector<File>>(buf->coalesce());
+  ASSERT_EQ(2, decoded.size());
+  EXPECT_EQ("a", decoded[0].name);
+  EXPECT_EQ(0, decoded[0].size);
+  EXPECT_EQ(files[0].blocks, decoded[0].blocks);
+  EXPECT_EQ("b", decoded[1].name);
+  EXPECT_TRUE(decoded[1].blocks.empty());
+
+  std::map<std::string, folly::Optional<int>> map = {{"x", 1}, {"y", {}}};
+  buf = folly::bser::toBserIOBufFrom(map);
+  EXPECT_EQ(
+      map,
+      (folly::bser::parseBserAs<std::map<std::string, folly::Optional<int>>>(
+          buf->coalesce())));
+}
+
+TEST(Bser, ReaderSkip) {
+  // skipValue steps over templated arrays and nested containers
+  auto buf = folly::IOBuf::wrapBuffer(template_blob, sizeof(template_blob) - 1);
+  folly::bser::reader r(buf->coalesce());
+  r.skipValue();
+  EXPECT_TRUE(r.done());
+
+  folly::bser::reader templ(buf->coalesce());
+  std::vector<folly::StringPiece> names;
+  EXPECT_EQ(3, templ.readTemplateHeader(names));
+  EXPECT_EQ((std::vector<folly::StringPiece>{"name", "age"}), names);
+  EXPECT_EQ("fred", templ.readString());
+  EXPECT_EQ(20, templ.readInt());
+  templ.skipValue();
+  templ.skipValue();
+  EXPECT_TRUE(templ.readSkip());
+  EXPECT_EQ(25, templ.read<int>());
+  EXPECT_TRUE(templ.done());
+
+  for (const auto& dyn : roundtrips) {
+    auto str = folly::bser::toBser(dyn, folly::bser::serialization_opts());
+    folly::bser::reader r2{folly::StringPiece(str)};
+    EXPECT_EQ(dyn, r2.readDynamic());
+    EXPECT_TRUE(r2.done());
+  }
+
+  // truncated and invalid data
+  EXPECT_THROW(
+      folly::bser::reader{folly::ByteRange(template_blob, 20)},
+      folly::bser::BserDecodeError);
+  folly::bser::reader ints(
+      folly::StringPiece("\x00\x01\x03\x04\x00\x03\x02\x0a", 8));
+  std::vector<int> values;
+  EXPECT_THROW(ints.readIntArray(values), folly::bser::BserDecodeError);
+}
+
+TEST(Bser, IntArrays) {
+  std::vector<int64_t> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back((i % 2 ? -1 : 1) * (int64_t(1) << (i % 63)));
+  }
+  folly::bser::writer w;
+  w.writeIntArray(values.data(), values.size());
+  auto buf = w.finish();
+  dynamic expected = dynamic::array;
+  for (auto value : values) {
+    expected.push_back(value);
+  }
+  EXPECT_EQ(
+      folly::bser::toBser(expected, folly::bser::serialization_opts()),
+      buf->moveToFbString());
+
+  auto str = folly::bser::toBser(expected, folly::bser::serialization_opts());
+  EXPECT_EQ(
+      values,
+      folly::bser::parseBserAs<std::vector<int64_t>>(folly::StringPiece(str)));
+  // values that don't fit
+  EXPECT_THROW(
+      folly::bser::parseBserAs<std::vector<int32_t>>(folly::StringPiece(str)),
+      folly::bser::BserDecodeError);
+  EXPECT_THROW(
+      folly::bser::parseBserAs<uint8_t>(folly::StringPiece(
+          folly::bser::toBser(-1, folly::bser::serialization_opts()))),
+      folly::bser::BserDecodeError);
+
+  // other allocators
+  using Vector = std::vector<int64_t, folly::SysAllocator<int64_t>>;
+  EXPECT_EQ(
+      Vector(values.begin(), values.end()),
+      folly::bser::parseBserAs<Vector>(folly::StringPiece(str)));
+}
+
+TEST(Bser, UnsignedIntegers) {
+  std::vector<uint64_t> values{0, uint64_t(std::numeric_limits<int64_t>::max())};
+  auto buf = folly::bser::toBserIOBufFrom(values);
+  EXPECT_EQ(
+      values, folly::bser::parseBserAs<std::vector<uint64_t>>(buf->coalesce()));
+
+  // BSER integers are signed
+  values.push_back(uint64_t(std::numeric_limits<int64_t>::max()) + 1);
+  EXPECT_THROW(folly::bser::toBserIOBufFrom(values), std::range_error);
+  EXPECT_THROW(
+      folly::bser::toBserIOBufFrom(std::numeric_limits<uint64_t>::max()),
+      std::range_error);
+}
+
 /* vim:ts=2:sw=2:et:
  */
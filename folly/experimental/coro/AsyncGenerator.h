@@ -18,11 +18,13 @@
 
 #include <folly/CancellationToken.h>
 #include <folly/Traits.h>
+#include <folly/experimental/coro/AsyncStack.h>
 #include <folly/experimental/coro/CurrentExecutor.h>
 #include <folly/experimental/coro/Invoke.h>
 #include <folly/experimental/coro/Utils.h>
 #include <folly/experimental/coro/ViaIfAsync.h>
 #include <folly/experimental/coro/WithCancellation.h>
+#include <folly/experimental/coro/detail/AsyncStackAwaiter.h>
 #include <folly/experimental/coro/detail/ManualLifetime.h>
 
 #include <glog/logging.h>
@@ -48,9 +50,16 @@ class AsyncGeneratorPromise {
     }
     std::experimental::coroutine_handle<> await_suspend(
         std::experimental::coroutine_handle<AsyncGeneratorPromise> h) noexcept {
+      frame_ = &h.promise().asyncFrame_;
+      setCurrentAsyncStackFrame(nullptr);
       return h.promise().continuation_;
     }
-    void await_resume() noexcept {}
+    void await_resume() noexcept {
+      setCurrentAsyncStackFrame(frame_);
+    }
+
+   private:
+    AsyncStackFrame* frame_{nullptr};
   };
 
  public:
@@ -62,8 +71,8 @@ class AsyncGeneratorPromise {
 
   AsyncGenerator<Reference, Value> get_return_object() noexcept;
 
-  std::experimental::suspend_always initial_suspend() noexcept {
-    return {};
+  AsyncStackInitialAwaiter initial_suspend() noexcept {
+    return AsyncStackInitialAwaiter{asyncFrame_};
   }
 
   YieldAwaiter final_suspend() noexcept {
@@ -111,10 +120,15 @@ class AsyncGeneratorPromise {
 
   template <typename U>
   auto await_transform(U&& value) {
-    return folly::coro::co_viaIfAsync(
-        executor_.get_alias(),
-        folly::coro::co_withCancellation(
-            cancelToken_, static_cast<U&&>(value)));
+    setAsyncStackParent(value, asyncFrame_);
+    return makeAsyncStackAwaiter(
+        [&]() -> decltype(auto) {
+          return folly::coro::co_viaIfAsync(
+              executor_.get_alias(),
+              folly::coro::co_withCancellation(
+                  cancelToken_, static_cast<U&&>(value)));
+        },
+        asyncFrame_);
   }
 
   auto await_transform(folly::coro::co_current_executor_t) noexcept {
@@ -143,6 +157,10 @@ class AsyncGeneratorPromise {
     continuation_ = continuation;
   }
 
+  void setParentFrame(AsyncStackFrame& parent) noexcept {
+    asyncFrame_.parent = &parent;
+  }
+
   void throwIfException() {
     DCHECK(!hasValue_);
     if (exception_) {
@@ -174,6 +192,7 @@ class AsyncGeneratorPromise {
   }
 
   std::experimental::coroutine_handle<> continuation_;
+  AsyncStackFrame asyncFrame_;
   folly::Executor::KeepAlive<> executor_;
   folly::CancellationToken cancelToken_;
   std::exception_ptr exception_;
@@ -458,6 +477,14 @@ class FOLLY_NODISCARD AsyncGenerator {
       return NextSemiAwaitable{std::exchange(awaitable.coro_, {})};
     }
 
+    friend void co_setAsyncStackParent(
+        NextSemiAwaitable& awaitable,
+        AsyncStackFrame& parent) noexcept {
+      if (awaitable.coro_) {
+        awaitable.coro_.promise().setParentFrame(parent);
+      }
+    }
+
    private:
     friend AsyncGenerator;
 
@@ -495,8 +522,10 @@ namespace detail {
 template <typename Reference, typename Value>
 AsyncGenerator<Reference, Value>
 AsyncGeneratorPromise<Reference, Value>::get_return_object() noexcept {
-  return AsyncGenerator<Reference, Value>{std::experimental::coroutine_handle<
-      AsyncGeneratorPromise<Reference, Value>>::from_promise(*this)};
+  auto coro = std::experimental::coroutine_handle<
+      AsyncGeneratorPromise<Reference, Value>>::from_promise(*this);
+  asyncFrame_.coroutineFrame = coro.address();
+  return AsyncGenerator<Reference, Value>{coro};
 }
 
 } // namespace detail
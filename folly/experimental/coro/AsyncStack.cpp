@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/coro/AsyncStack.h>
+
+namespace folly {
+namespace coro {
+
+namespace {
+thread_local AsyncStackFrame* currentAsyncStackFrame = nullptr;
+} // namespace
+
+AsyncStackFrame* getCurrentAsyncStackFrame() noexcept {
+  return currentAsyncStackFrame;
+}
+
+void setCurrentAsyncStackFrame(AsyncStackFrame* frame) noexcept {
+  currentAsyncStackFrame = frame;
+}
+
+size_t getAsyncStackTrace(uintptr_t* addresses, size_t maxAddresses) noexcept {
+  size_t count = 0;
+  for (auto* frame = currentAsyncStackFrame; frame; frame = frame->parent) {
+    if (count < maxAddresses) {
+      addresses[count] = frame->resumeAddress();
+    }
+    ++count;
+  }
+  return count;
+}
+
+} // namespace coro
+} // namespace folly
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace folly {
+namespace coro {
+
+/**
+ * Async stack frame of a running Task or AsyncGenerator coroutine.
+ *
+ * The parent of a frame is the frame of the coroutine that last awaited it,
+ * which is linked by the co_await expression of that coroutine. The current
+ * frame of a thread is the one of the coroutine it is running, from the
+ * moment the coroutine starts or resumes after a co_await or co_yield, to
+ * the moment it suspends again.
+ *
+ * Walking the frames from the current one gives the chain of coroutines
+ * that led to the code running on this thread, which a sync stack trace
+ * only shows as resume() frames. They can be printed with
+ * symbolizer::getAsyncStackTraceStr(), and are printed by the fatal signal
+ * handler.
+ */
+struct AsyncStackFrame {
+  AsyncStackFrame* parent{nullptr};
+  // address of the frame of the coroutine
+  void* coroutineFrame{nullptr};
+
+  // Address of the function that resumes the coroutine, whose symbol is the
+  // name of the coroutine function.
+  uintptr_t resumeAddress() const noexcept {
+    // Both the Clang and GCC ABIs put it at the start of the frame.
+    return coroutineFrame ? *static_cast<const uintptr_t*>(coroutineFrame)
+                          : 0;
+  }
+};
+
+AsyncStackFrame* getCurrentAsyncStackFrame() noexcept;
+void setCurrentAsyncStackFrame(AsyncStackFrame* frame) noexcept;
+
+/**
+ * Stores the resume addresses of the current async stack frame of this
+ * thread and its ancestors, innermost first, and returns how many there
+ * are, which may be more than maxAddresses.
+ *
+ * Async-signal-safe: a sampling profiler can call it from its SIGPROF
+ * handler to attribute CPU time to coroutine call chains.
+ */
+size_t getAsyncStackTrace(uintptr_t* addresses, size_t maxAddresses) noexcept;
+
+} // namespace coro
+} // namespace folly
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/concurrency/UnboundedQueue.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/fibers/Semaphore.h>
+
+namespace folly {
+namespace coro {
+
+/**
+ * Bounded queue whose producers wait for room by awaiting enqueue() and
+ * consumers wait for elements by awaiting dequeue(), without blocking
+ * their threads.
+ *
+ * Elements are stored in a folly::UnboundedQueue bounded by a
+ * fibers::Semaphore counting free slots, and consumers wait on another one
+ * counting elements. The slot of an element is freed as soon as it is
+ * dequeued, which DynamicBoundedQueue's batched credit transfer doesn't
+ * guarantee.
+ *
+ *   coro::BoundedQueue<int> queue(16);
+ *   co_await queue.enqueue(42);
+ *   int value = co_await queue.dequeue();
+ */
+template <typename T, bool SingleProducer = false, bool SingleConsumer = false>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : slots_(capacity), elements_(0) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * Waits until the queue has room and adds value.
+   */
+  Task<void> enqueue(T value) {
+    co_await slots_.co_wait();
+    queue_.enqueue(std::move(value));
+    elements_.signal();
+  }
+
+  /**
+   * Adds value if the queue has room, without waiting.
+   */
+  template <typename U = T>
+  bool try_enqueue(U&& value) {
+    if (!slots_.try_wait()) {
+      return false;
+    }
+    queue_.enqueue(std::forward<U>(value));
+    elements_.signal();
+    return true;
+  }
+
+  /**
+   * Waits until the queue has an element and removes it.
+   */
+  Task<T> dequeue() {
+    co_await elements_.co_wait();
+    auto value = queue_.dequeue();
+    slots_.signal();
+    co_return std::move(value);
+  }
+
+  /**
+   * Removes an element if there is one, without waiting.
+   */
+  Optional<T> try_dequeue() {
+    if (!elements_.try_wait()) {
+      return none;
+    }
+    Optional<T> value(queue_.dequeue());
+    slots_.signal();
+    return value;
+  }
+
+  /**
+   * Accurate only if there are no concurrent enqueues or dequeues.
+   */
+  size_t size() const noexcept {
+    return queue_.size();
+  }
+
+  bool empty() const noexcept {
+    return queue_.empty();
+  }
+
+  size_t capacity() const {
+    return slots_.getCapacity();
+  }
+
+ private:
+  folly::UnboundedQueue<T, SingleProducer, SingleConsumer, false> queue_;
+  fibers::Semaphore slots_;
+  fibers::Semaphore elements_;
+};
+
+} // namespace coro
+} // namespace folly
@@ -19,6 +19,7 @@
 #include <utility>
 
 #include <folly/Executor.h>
+#include <folly/executors/TimeSlice.h>
 #include <folly/experimental/coro/ViaIfAsync.h>
 #include <folly/io/async/Request.h>
 
@@ -107,6 +108,58 @@ using co_reschedule_on_current_executor_t =
 inline constexpr co_reschedule_on_current_executor_t
     co_reschedule_on_current_executor;
 
+namespace detail {
+
+class co_maybe_reschedule_on_current_executor_ {
+  class Awaiter {
+    folly::Executor::KeepAlive<> executor_;
+
+   public:
+    explicit Awaiter(folly::Executor::KeepAlive<> executor) noexcept
+        : executor_(std::move(executor)) {}
+
+    bool await_ready() {
+      return !TimeSlice::shouldYield();
+    }
+
+    FOLLY_CORO_AWAIT_SUSPEND_NONTRIVIAL_ATTRIBUTES void await_suspend(
+        std::experimental::coroutine_handle<> coro) {
+      executor_->add([coro, ctx = RequestContext::saveContext()]() mutable {
+        RequestContextScopeGuard contextScope{std::move(ctx)};
+        coro.resume();
+      });
+    }
+
+    void await_resume() {}
+  };
+
+  friend Awaiter co_viaIfAsync(
+      folly::Executor::KeepAlive<> executor,
+      co_maybe_reschedule_on_current_executor_) {
+    return Awaiter{std::move(executor)};
+  }
+};
+
+} // namespace detail
+
+using co_maybe_reschedule_on_current_executor_t =
+    detail::co_maybe_reschedule_on_current_executor_;
+
+// Like co_reschedule_on_current_executor, but only reschedules once the
+// time slice of the task running the coroutine is used up and other tasks
+// are waiting for its thread (see TimeSlice::shouldYield()), so it can be
+// awaited often.
+//
+// Example:
+//   folly::coro::Task<void> doCpuIntensiveWorkFairly() {
+//     for (int i = 0; i < 1'000'000; ++i) {
+//       co_await folly::coro::co_maybe_reschedule_on_current_executor;
+//       doSomeWork(i);
+//     }
+//   }
+inline constexpr co_maybe_reschedule_on_current_executor_t
+    co_maybe_reschedule_on_current_executor;
+
 namespace detail {
 struct co_current_cancellation_token_ {
   enum class secret_ { token_ };
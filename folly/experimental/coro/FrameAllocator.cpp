@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/coro/FrameAllocator.h>
+
+#include <atomic>
+
+#include <folly/memory/Malloc.h>
+#include <folly/memory/detail/ThreadLocalFreeLists.h>
+
+namespace folly {
+namespace coro {
+
+namespace {
+
+constexpr std::size_t kFrameSizeGranularity = 64;
+constexpr std::size_t kNumFrameSizeClasses = 16;
+constexpr uint64_t kStatsPublishInterval = 1024;
+
+std::atomic<std::size_t> frameCacheLimit{64};
+
+struct GlobalStats {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> cacheHits{0};
+  std::atomic<uint64_t> deallocations{0};
+  std::atomic<uint64_t> cached{0};
+};
+
+GlobalStats globalStats;
+
+using FrameFreeLists =
+    folly::detail::FreeLists<kFrameSizeGranularity, kNumFrameSizeClasses>;
+
+struct FrameCache {
+  ~FrameCache() {
+    publishStats();
+  }
+
+  void publishStats() noexcept {
+    auto publish = [](std::atomic<uint64_t>& total, uint64_t& count) {
+      total.fetch_add(count, std::memory_order_relaxed);
+      count = 0;
+    };
+    publish(globalStats.allocations, stats.allocations);
+    publish(globalStats.cacheHits, stats.cacheHits);
+    publish(globalStats.deallocations, stats.deallocations);
+    publish(globalStats.cached, stats.cached);
+  }
+
+  FrameFreeLists lists;
+  FrameAllocatorStats stats;
+};
+
+FrameCache* getFrameCache() {
+  return folly::detail::ThreadLocalCache<FrameCache>::get();
+}
+
+} // namespace
+
+void setFrameCacheLimit(std::size_t framesPerSizeClass) noexcept {
+  frameCacheLimit.store(framesPerSizeClass, std::memory_order_relaxed);
+}
+
+std::size_t getFrameCacheLimit() noexcept {
+  return frameCacheLimit.load(std::memory_order_relaxed);
+}
+
+FrameAllocatorStats getFrameAllocatorStats() noexcept {
+  FrameAllocatorStats stats;
+  stats.allocations = globalStats.allocations.load(std::memory_order_relaxed);
+  stats.cacheHits = globalStats.cacheHits.load(std::memory_order_relaxed);
+  stats.deallocations =
+      globalStats.deallocations.load(std::memory_order_relaxed);
+  stats.cached = globalStats.cached.load(std::memory_order_relaxed);
+  return stats;
+}
+
+namespace detail {
+
+void* allocateFrame(std::size_t size) {
+  auto* cache = getFrameCache();
+  if (cache) {
+    if (++cache->stats.allocations == kStatsPublishInterval) {
+      cache->publishStats();
+    }
+  } else {
+    globalStats.allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (!FrameFreeLists::cacheable(size)) {
+    return checkedMalloc(size);
+  }
+  if (cache) {
+    if (auto* frame = cache->lists.pop(size)) {
+      ++cache->stats.cacheHits;
+      return frame;
+    }
+  }
+  return checkedMalloc(FrameFreeLists::roundUp(size));
+}
+
+void deallocateFrame(void* p, std::size_t size) noexcept {
+  auto* cache = getFrameCache();
+  if (!cache) {
+    globalStats.deallocations.fetch_add(1, std::memory_order_relaxed);
+    free(p);
+    return;
+  }
+  ++cache->stats.deallocations;
+  if (FrameFreeLists::cacheable(size) &&
+      cache->lists.push(p, size, getFrameCacheLimit())) {
+    ++cache->stats.cached;
+  } else {
+    free(p);
+  }
+}
+
+} // namespace detail
+} // namespace coro
+} // namespace folly
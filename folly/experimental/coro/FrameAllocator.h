@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace folly {
+namespace coro {
+
+/**
+ * The frames of Task coroutines are allocated from a per-thread cache of
+ * freed frames, with one free list per 64-byte size class up to 1KB;
+ * larger frames come from malloc.
+ *
+ * A frame goes to the cache of the thread that frees it, which need not be
+ * the one that allocated it.
+ */
+
+/**
+ * Sets the maximum number of frames cached per size class and thread; 0
+ * disables the cache. Defaults to 64.
+ */
+void setFrameCacheLimit(std::size_t framesPerSizeClass) noexcept;
+std::size_t getFrameCacheLimit() noexcept;
+
+struct FrameAllocatorStats {
+  // Frames allocated, and how many of them came from a cache.
+  uint64_t allocations{0};
+  uint64_t cacheHits{0};
+  // Frames freed, and how many of them went to a cache.
+  uint64_t deallocations{0};
+  uint64_t cached{0};
+};
+
+/**
+ * Totals over all threads, which publish their counters every 1024
+ * allocations and when they exit.
+ */
+FrameAllocatorStats getFrameAllocatorStats() noexcept;
+
+namespace detail {
+
+void* allocateFrame(std::size_t size);
+void deallocateFrame(void* p, std::size_t size) noexcept;
+
+} // namespace detail
+} // namespace coro
+} // namespace folly
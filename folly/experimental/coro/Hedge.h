@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <folly/Try.h>
+#include <folly/experimental/coro/CurrentExecutor.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/experimental/coro/Traits.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/Hedge.h>
+
+namespace folly {
+namespace coro {
+
+/// Task flavor of futures::hedge(): func(attempt) returns a Task, and each
+/// attempt is started on the awaiting coroutine's executor.
+///
+/// Attempts that lose are cancelled through their CancellationToken.
+/// Cancellation of the awaiting coroutine cancels all attempts, and the
+/// returned task then completes with FutureCancellation.
+template <class F, class T = semi_await_result_t<invoke_result_t<F&, size_t>>>
+Task<T>
+hedge(F func, Duration delay, size_t maxAttempts, Timekeeper* tk = nullptr) {
+  auto executor = folly::getKeepAliveToken(co_await co_current_executor);
+  auto cancelToken = co_await co_current_cancellation_token;
+  auto future = futures::hedge(
+                    [executor, func = std::move(func)](size_t attempt) {
+                      return func(attempt).scheduleOn(executor).start();
+                    },
+                    delay,
+                    maxAttempts,
+                    tk)
+                    .withCancellation(std::move(cancelToken));
+  if constexpr (std::is_void_v<T>) {
+    co_await std::move(future);
+  } else {
+    co_return co_await std::move(future);
+  }
+}
+
+/// Task flavor of folly::collectNAndCancel(): starts the tasks on the
+/// awaiting coroutine's executor and completes with the index and result of
+/// the first n to complete.  The others are cancelled through their
+/// CancellationToken, as are all of them if the awaiting coroutine is
+/// cancelled.
+template <class T>
+Task<std::vector<std::pair<size_t, Try<lift_unit_t<T>>>>> collectNAndCancel(
+    std::vector<Task<T>> tasks,
+    size_t n) {
+  auto executor = folly::getKeepAliveToken(co_await co_current_executor);
+  auto cancelToken = co_await co_current_cancellation_token;
+  std::vector<SemiFuture<lift_unit_t<T>>> futures;
+  futures.reserve(tasks.size());
+  for (auto& task : tasks) {
+    futures.push_back(std::move(task).scheduleOn(executor).start());
+  }
+  co_return co_await folly::collectNAndCancel(futures, n).withCancellation(
+      std::move(cancelToken));
+}
+
+} // namespace coro
+} // namespace folly
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/experimental/coro/ServerSocket.h>
+
+#include <folly/net/NetOps.h>
+
+namespace folly {
+namespace coro {
+
+namespace detail {
+
+void AcceptQueue::connectionAccepted(
+    NetworkSocket fd,
+    const SocketAddress& /* clientAddr */) noexcept {
+  fds.push_back(fd);
+  if (auto* awaiter = std::exchange(waiter, nullptr)) {
+    awaiter->complete();
+  }
+}
+
+void AcceptQueue::acceptError(const std::exception& ex) noexcept {
+  error = make_exception_wrapper<std::runtime_error>(ex.what());
+  if (auto* awaiter = std::exchange(waiter, nullptr)) {
+    awaiter->complete();
+  }
+}
+
+bool AcceptAwaiter::await_suspend(
+    std::experimental::coroutine_handle<> continuation) {
+  beginSuspend(continuation);
+  args_.queue->waiter = this;
+  return endSuspend();
+}
+
+NetworkSocket AcceptAwaiter::await_resume() {
+  auto& queue = *args_.queue;
+  if (queue.waiter == this) {
+    // cancelled
+    queue.waiter = nullptr;
+  }
+  finish();
+  if (queue.fds.empty()) {
+    auto error = std::exchange(queue.error, {});
+    error.throw_exception();
+  }
+  auto fd = queue.fds.front();
+  queue.fds.pop_front();
+  return fd;
+}
+
+} // namespace detail
+
+ServerSocket::ServerSocket(
+    AsyncServerSocket::UniquePtr socket,
+    Optional<SocketAddress> bindAddress,
+    uint32_t listenQueueDepth)
+    : socket_(std::move(socket)),
+      queue_(std::make_unique<detail::AcceptQueue>()) {
+  if (bindAddress) {
+    socket_->bind(*bindAddress);
+  }
+  socket_->listen(listenQueueDepth);
+  socket_->addAcceptCallback(queue_.get(), nullptr);
+  socket_->startAccepting();
+}
+
+ServerSocket::~ServerSocket() {
+  close();
+}
+
+AsyncGenerator<Transport&&> ServerSocket::accept() {
+  auto* eventBase = socket_->getEventBase();
+  while (true) {
+    auto fd = co_await detail::TransportAwaitable<detail::AcceptAwaiter>(
+        detail::AcceptAwaiter::Args{eventBase, queue_.get()});
+    co_yield Transport(
+        eventBase, AsyncTransport::UniquePtr(new AsyncSocket(eventBase, fd)));
+  }
+}
+
+void ServerSocket::close() {
+  if (socket_) {
+    socket_->stopAccepting();
+    socket_.reset();
+  }
+  for (auto fd : queue_->fds) {
+    netops::close(fd);
+  }
+  queue_->fds.clear();
+}
+
+SocketAddress ServerSocket::getLocalAddress() const {
+  return socket_->getAddress();
+}
+
+} // namespace coro
+} // namespace folly
+
+#endif // FOLLY_HAS_COROUTINES
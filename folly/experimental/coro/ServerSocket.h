@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Optional.h>
+#include <folly/SocketAddress.h>
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Transport.h>
+#include <folly/io/async/AsyncServerSocket.h>
+
+namespace folly {
+namespace coro {
+
+namespace detail {
+
+class AcceptAwaiter;
+
+// Connections accepted while no coroutine awaits one.
+struct AcceptQueue : AsyncServerSocket::AcceptCallback {
+  void connectionAccepted(
+      NetworkSocket fd,
+      const SocketAddress& clientAddr) noexcept override;
+  void acceptError(const std::exception& ex) noexcept override;
+
+  std::deque<NetworkSocket> fds;
+  exception_wrapper error;
+  AcceptAwaiter* waiter{nullptr};
+};
+
+class AcceptAwaiter : public TransportAwaiterBase {
+ public:
+  struct Args {
+    EventBase* eventBase;
+    AcceptQueue* queue;
+  };
+
+  // Not resumed inline, from within AsyncServerSocket's accept loop.
+  AcceptAwaiter(
+      Args args,
+      Executor::KeepAlive<> executor,
+      CancellationToken cancelToken) noexcept
+      : TransportAwaiterBase(
+            args.eventBase,
+            std::move(executor),
+            std::move(cancelToken),
+            false),
+        args_(args) {}
+
+  bool await_ready() noexcept {
+    return !args_.queue->fds.empty() || args_.queue->error;
+  }
+  bool await_suspend(std::experimental::coroutine_handle<> continuation);
+  NetworkSocket await_resume();
+
+ private:
+  friend struct AcceptQueue;
+
+  Args args_;
+};
+
+} // namespace detail
+
+/**
+ * Coroutine interface of an AsyncServerSocket: accept() produces the
+ * accepted connections as Transports on the socket's EventBase.
+ *
+ *   ServerSocket server(
+ *       AsyncServerSocket::UniquePtr(new AsyncServerSocket(evb)),
+ *       SocketAddress("::1", 0),
+ *       128);
+ *   auto connections = server.accept();
+ *   while (auto transport = co_await connections.next()) {
+ *     handle(std::move(*transport)).scheduleOn(evb).start();
+ *   }
+ *
+ * Must be constructed, used and destroyed on the EventBase thread, and the
+ * generator consumed from a coroutine running on that EventBase. The
+ * generator throws OperationCancelled when cancelled, and the error of
+ * AsyncServerSocket when accepting fails; connections accepted until then
+ * are produced by the next call to accept().
+ */
+class ServerSocket {
+ public:
+  ServerSocket(
+      AsyncServerSocket::UniquePtr socket,
+      Optional<SocketAddress> bindAddress,
+      uint32_t listenQueueDepth);
+  ~ServerSocket();
+
+  ServerSocket(const ServerSocket&) = delete;
+  ServerSocket& operator=(const ServerSocket&) = delete;
+
+  AsyncGenerator<Transport&&> accept();
+
+  /**
+   * Stops accepting; the connections not yet produced are closed.
+   */
+  void close();
+
+  SocketAddress getLocalAddress() const;
+  AsyncServerSocket* getAsyncServerSocket() const noexcept {
+    return socket_.get();
+  }
+
+ private:
+  AsyncServerSocket::UniquePtr socket_;
+  std::unique_ptr<detail::AcceptQueue> queue_;
+};
+
+} // namespace coro
+} // namespace folly
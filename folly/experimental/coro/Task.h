@@ -27,12 +27,15 @@
 #include <folly/ScopeGuard.h>
 #include <folly/Traits.h>
 #include <folly/Try.h>
+#include <folly/experimental/coro/AsyncStack.h>
 #include <folly/experimental/coro/CurrentExecutor.h>
+#include <folly/experimental/coro/FrameAllocator.h>
 #include <folly/experimental/coro/Invoke.h>
 #include <folly/experimental/coro/Traits.h>
 #include <folly/experimental/coro/Utils.h>
 #include <folly/experimental/coro/ViaIfAsync.h>
 #include <folly/experimental/coro/WithCancellation.h>
+#include <folly/experimental/coro/detail/AsyncStackAwaiter.h>
 #include <folly/experimental/coro/detail/InlineTask.h>
 #include <folly/experimental/coro/detail/Traits.h>
 #include <folly/futures/Future.h>
@@ -60,6 +63,7 @@ class TaskPromiseBase {
     std::experimental::coroutine_handle<> await_suspend(
         std::experimental::coroutine_handle<Promise> coro) noexcept {
       TaskPromiseBase& promise = coro.promise();
+      setCurrentAsyncStackFrame(nullptr);
       return promise.continuation_;
     }
 
@@ -71,9 +75,19 @@ class TaskPromiseBase {
  protected:
   TaskPromiseBase() noexcept {}
 
+  AsyncStackFrame asyncFrame_;
+
  public:
-  std::experimental::suspend_always initial_suspend() noexcept {
-    return {};
+  static void* operator new(std::size_t size) {
+    return detail::allocateFrame(size);
+  }
+
+  static void operator delete(void* ptr, std::size_t size) noexcept {
+    detail::deallocateFrame(ptr, size);
+  }
+
+  AsyncStackInitialAwaiter initial_suspend() noexcept {
+    return AsyncStackInitialAwaiter{asyncFrame_};
   }
 
   FinalAwaiter final_suspend() noexcept {
@@ -82,10 +96,15 @@ class TaskPromiseBase {
 
   template <typename Awaitable>
   auto await_transform(Awaitable&& awaitable) noexcept {
-    return folly::coro::co_viaIfAsync(
-        executor_.get_alias(),
-        folly::coro::co_withCancellation(
-            cancelToken_, static_cast<Awaitable&&>(awaitable)));
+    setAsyncStackParent(awaitable, asyncFrame_);
+    return makeAsyncStackAwaiter(
+        [&]() -> decltype(auto) {
+          return folly::coro::co_viaIfAsync(
+              executor_.get_alias(),
+              folly::coro::co_withCancellation(
+                  cancelToken_, static_cast<Awaitable&&>(awaitable)));
+        },
+        asyncFrame_);
   }
 
   auto await_transform(co_current_executor_t) noexcept {
@@ -224,15 +243,20 @@ class FOLLY_NODISCARD TaskWithExecutor {
 
   // Start execution of this task eagerly and return a folly::SemiFuture<T>
   // that will complete with the result.
+  //
+  // Raising an interrupt on the returned future requests cancellation of
+  // the task.
   auto start() && {
     Promise<lift_unit_t<StorageType>> p;
 
     auto sf = p.getSemiFuture();
+    auto cancelToken = p.getCancellationToken();
 
     std::move(*this).start(
         [promise = std::move(p)](Try<StorageType>&& result) mutable {
           promise.setTry(std::move(result));
-        });
+        },
+        std::move(cancelToken));
 
     return sf;
   }
@@ -406,6 +430,12 @@ class FOLLY_NODISCARD TaskWithExecutor {
     return std::move(task);
   }
 
+  friend void co_setAsyncStackParent(
+      TaskWithExecutor& task,
+      AsyncStackFrame& parent) noexcept {
+    task.coro_.promise().asyncFrame_.parent = &parent;
+  }
+
  private:
   friend class Task<T>;
 
@@ -499,6 +529,12 @@ class FOLLY_NODISCARD Task {
     return std::move(task);
   }
 
+  friend void co_setAsyncStackParent(
+      Task& task,
+      AsyncStackFrame& parent) noexcept {
+    task.coro_.promise().asyncFrame_.parent = &parent;
+  }
+
   template <typename F, typename... A, typename F_, typename... A_>
   friend Task folly_co_invoke(tag_t<Task, F, A...>, F_ f, A_... a) {
     co_return co_await invoke(static_cast<F&&>(f), static_cast<A&&>(a)...);
@@ -554,14 +590,18 @@ class FOLLY_NODISCARD Task {
 
 template <typename T>
 Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
-  return Task<T>{
+  auto coro =
       std::experimental::coroutine_handle<detail::TaskPromise<T>>::from_promise(
-          *this)};
+          *this);
+  asyncFrame_.coroutineFrame = coro.address();
+  return Task<T>{coro};
 }
 
 inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept {
-  return Task<void>{std::experimental::coroutine_handle<
-      detail::TaskPromise<void>>::from_promise(*this)};
+  auto coro = std::experimental::coroutine_handle<
+      detail::TaskPromise<void>>::from_promise(*this);
+  asyncFrame_.coroutineFrame = coro.address();
+  return Task<void>{coro};
 }
 
 } // namespace coro
@@ -14,7 +14,13 @@
  * limitations under the License.
  */
 
+#include <deque>
+#include <memory>
+
+#include <folly/Try.h>
 #include <folly/experimental/coro/Transform.h>
+#include <folly/experimental/coro/UnboundedQueue.h>
+#include <folly/futures/Future.h>
 
 namespace folly {
 namespace coro {
@@ -28,5 +34,80 @@ AsyncGenerator<invoke_result_t<TransformFn&, Reference>> transform(
   }
 }
 
+namespace detail {
+
+// Runs transformFn on a Value pulled from a stream whose Reference it
+// takes.
+template <typename Reference, typename Value, typename TransformFn>
+auto startTransform(
+    folly::Executor::KeepAlive<> executor,
+    std::shared_ptr<TransformFn> transformFn,
+    Value value) {
+  using Arg = std::conditional_t<
+      std::is_lvalue_reference<Reference>::value,
+      Value&,
+      Value&&>;
+  return folly::via(
+      std::move(executor),
+      [transformFn = std::move(transformFn),
+       value = std::move(value)]() mutable {
+        return invoke(*transformFn, static_cast<Arg>(value));
+      });
+}
+
+} // namespace detail
+
+template <typename TransformFn, typename Reference, typename Value>
+AsyncGenerator<remove_cvref_t<invoke_result_t<TransformFn&, Reference>>>
+parallelTransform(
+    AsyncGenerator<Reference, Value> source,
+    folly::Executor::KeepAlive<> executor,
+    size_t maxConcurrency,
+    TransformFn transformFn,
+    TransformOrder order) {
+  using Result = remove_cvref_t<invoke_result_t<TransformFn&, Reference>>;
+  static_assert(
+      !std::is_void<Result>::value,
+      "parallelTransform() requires a transformFn that returns a value");
+  DCHECK_GT(maxConcurrency, 0);
+
+  // Shared with the calls still running if the output stream is destroyed.
+  auto fn = std::make_shared<TransformFn>(std::move(transformFn));
+
+  if (order == TransformOrder::Ordered) {
+    std::deque<Future<Result>> running;
+    while (auto item = co_await source.next()) {
+      running.push_back(detail::startTransform<Reference>(
+          executor, fn, Value(*std::move(item))));
+      if (running.size() == maxConcurrency) {
+        auto result = std::move(running.front());
+        running.pop_front();
+        co_yield co_await std::move(result);
+      }
+    }
+    while (!running.empty()) {
+      auto result = std::move(running.front());
+      running.pop_front();
+      co_yield co_await std::move(result);
+    }
+  } else {
+    auto results = std::make_shared<UnboundedQueue<Try<Result>>>();
+    size_t running = 0;
+    while (auto item = co_await source.next()) {
+      detail::startTransform<Reference>(executor, fn, Value(*std::move(item)))
+          .thenTry([results](Try<Result>&& result) {
+            results->enqueue(std::move(result));
+          });
+      if (++running == maxConcurrency) {
+        --running;
+        co_yield std::move(co_await results->dequeue()).value();
+      }
+    }
+    for (; running > 0; --running) {
+      co_yield std::move(co_await results->dequeue()).value();
+    }
+  }
+}
+
 } // namespace coro
 } // namespace folly
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <folly/Executor.h>
 #include <folly/experimental/coro/AsyncGenerator.h>
 
 namespace folly {
@@ -51,6 +52,37 @@ AsyncGenerator<invoke_result_t<TransformFn&, Reference>> transform(
     AsyncGenerator<Reference, Value> source,
     TransformFn transformFn);
 
+enum class TransformOrder {
+  // Results are produced in the order of the Values they come from.
+  Ordered,
+  // Results are produced as soon as they are ready.
+  Unordered,
+};
+
+// Like transform(), but runs up to maxConcurrency calls of transformFn at a
+// time on the executor, so transformFn must be safe to call concurrently.
+//
+// The next Value is only pulled from the input stream when fewer than
+// maxConcurrency calls are running, or, with TransformOrder::Ordered,
+// waiting for an earlier result to be produced: at most maxConcurrency
+// results are buffered.
+//
+// An exception thrown by transformFn ends the output stream when its result
+// would have been produced; calls already running complete in the
+// background, and their results are dropped.
+//
+// Example:
+//   auto parsed = parallelTransform(
+//       lines(), executor, 16, [](std::string line) { return parse(line); });
+template <typename TransformFn, typename Reference, typename Value>
+AsyncGenerator<remove_cvref_t<invoke_result_t<TransformFn&, Reference>>>
+parallelTransform(
+    AsyncGenerator<Reference, Value> source,
+    folly::Executor::KeepAlive<> executor,
+    size_t maxConcurrency,
+    TransformFn transformFn,
+    TransformOrder order = TransformOrder::Ordered);
+
 } // namespace coro
 } // namespace folly
 
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/experimental/coro/Transport.h>
+
+namespace folly {
+namespace coro {
+
+namespace detail {
+
+void TransportAwaiterBase::beginSuspend(
+    std::experimental::coroutine_handle<> continuation) {
+  eventBase_->dcheckIsInEventBaseThread();
+  continuation_ = continuation;
+  context_ = RequestContext::saveContext();
+  if (cancelToken_.canBeCancelled()) {
+    cancelCallback_.emplace(cancelToken_, [this]() noexcept {
+      // not from within requestCancellation()
+      complete(make_exception_wrapper<OperationCancelled>(), false);
+    });
+  }
+}
+
+bool TransportAwaiterBase::endSuspend() noexcept {
+  auto expected = State::Starting;
+  return state_.compare_exchange_strong(
+      expected, State::Suspended, std::memory_order_acq_rel);
+}
+
+void TransportAwaiterBase::complete(
+    exception_wrapper error,
+    bool mayResumeInline) noexcept {
+  if (completed_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  error_ = std::move(error);
+  if (state_.exchange(State::Completed, std::memory_order_acq_rel) !=
+      State::Suspended) {
+    // still in await_suspend(), which won't suspend
+    return;
+  }
+  auto continuation = continuation_;
+  auto context = std::move(context_);
+  if (resumeInline_ && mayResumeInline &&
+      executor_.get() == static_cast<Executor*>(eventBase_) &&
+      eventBase_->inRunningEventBaseThread()) {
+    RequestContextScopeGuard guard(std::move(context));
+    continuation.resume();
+  } else {
+    executor_->add([continuation, context = std::move(context)]() mutable {
+      RequestContextScopeGuard guard(std::move(context));
+      continuation.resume();
+    });
+  }
+}
+
+void TransportAwaiterBase::finish() {
+  cancelCallback_.reset();
+  if (error_) {
+    error_.throw_exception();
+  }
+}
+
+bool ReadAwaiter::await_suspend(
+    std::experimental::coroutine_handle<> continuation) {
+  beginSuspend(continuation);
+  if (args_.timeout.count() > 0) {
+    eventBase_->timer().scheduleTimeout(this, args_.timeout);
+  }
+  args_.transport->setReadCB(this);
+  return endSuspend();
+}
+
+size_t ReadAwaiter::await_resume() {
+  // After a cancellation, the read callback may still be installed.
+  if (args_.transport->getReadCallback() == this) {
+    args_.transport->setReadCB(nullptr);
+  }
+  cancelTimeout();
+  finish();
+  return bytesRead_;
+}
+
+void ReadAwaiter::getReadBuffer(void** bufReturn, size_t* lenReturn) {
+  if (args_.queue) {
+    std::tie(*bufReturn, *lenReturn) =
+        args_.queue->preallocate(args_.minReadSize, args_.newAllocationSize);
+  } else {
+    *bufReturn = args_.buf.begin();
+    *lenReturn = args_.buf.size();
+  }
+}
+
+void ReadAwaiter::readDataAvailable(size_t len) noexcept {
+  if (args_.queue) {
+    args_.queue->postallocate(len);
+  }
+  args_.transport->setReadCB(nullptr);
+  if (!completed()) {
+    bytesRead_ = len;
+    complete();
+  }
+}
+
+void ReadAwaiter::readEOF() noexcept {
+  complete();
+}
+
+void ReadAwaiter::readErr(const AsyncSocketException& ex) noexcept {
+  complete(make_exception_wrapper<AsyncSocketException>(ex));
+}
+
+void ReadAwaiter::timeoutExpired() noexcept {
+  complete(make_exception_wrapper<AsyncSocketException>(
+      AsyncSocketException::TIMED_OUT, "Timed out waiting for data"));
+}
+
+bool WriteAwaiter::await_suspend(
+    std::experimental::coroutine_handle<> continuation) {
+  beginSuspend(continuation);
+  if (args_.chain) {
+    args_.transport->writeChain(this, std::move(args_.chain), args_.flags);
+  } else {
+    args_.transport->write(
+        this, args_.buf.data(), args_.buf.size(), args_.flags);
+  }
+  return endSuspend();
+}
+
+void WriteAwaiter::await_resume() {
+  finish();
+}
+
+void WriteAwaiter::writeSuccess() noexcept {
+  complete();
+}
+
+void WriteAwaiter::writeErr(
+    size_t /* bytesWritten */,
+    const AsyncSocketException& ex) noexcept {
+  complete(make_exception_wrapper<AsyncSocketException>(ex));
+}
+
+bool ConnectAwaiter::await_suspend(
+    std::experimental::coroutine_handle<> continuation) {
+  beginSuspend(continuation);
+  args_.socket->connect(this, args_.address, args_.timeout.count());
+  return endSuspend();
+}
+
+void ConnectAwaiter::await_resume() {
+  if (args_.socket->connecting()) {
+    // cancelled, fails the connect, which calls connectErr()
+    args_.socket->closeNow();
+  }
+  finish();
+}
+
+void ConnectAwaiter::connectSuccess() noexcept {
+  complete();
+}
+
+void ConnectAwaiter::connectErr(const AsyncSocketException& ex) noexcept {
+  complete(make_exception_wrapper<AsyncSocketException>(ex));
+}
+
+} // namespace detail
+
+Task<Transport> Transport::newConnectedSocket(
+    EventBase* eventBase,
+    const SocketAddress& address,
+    std::chrono::milliseconds connectTimeout) {
+  AsyncSocket::UniquePtr socket(new AsyncSocket(eventBase));
+  co_await detail::TransportAwaitable<detail::ConnectAwaiter>(
+      detail::ConnectAwaiter::Args{socket.get(), address, connectTimeout});
+  co_return Transport(eventBase, std::move(socket));
+}
+
+detail::TransportAwaitable<detail::ReadAwaiter> Transport::read(
+    MutableByteRange buf,
+    std::chrono::milliseconds timeout) {
+  return detail::TransportAwaitable<detail::ReadAwaiter>(
+      detail::ReadAwaiter::Args{transport_.get(), buf, nullptr, 0, 0, timeout});
+}
+
+detail::TransportAwaitable<detail::ReadAwaiter> Transport::read(
+    IOBufQueue& buf,
+    size_t minReadSize,
+    size_t newAllocationSize,
+    std::chrono::milliseconds timeout) {
+  return detail::TransportAwaitable<detail::ReadAwaiter>(
+      detail::ReadAwaiter::Args{transport_.get(),
+                                MutableByteRange(),
+                                &buf,
+                                minReadSize,
+                                newAllocationSize,
+                                timeout});
+}
+
+detail::TransportAwaitable<detail::WriteAwaiter> Transport::write(
+    ByteRange buf,
+    WriteFlags flags) {
+  return detail::TransportAwaitable<detail::WriteAwaiter>(
+      detail::WriteAwaiter::Args{transport_.get(), buf, nullptr, flags});
+}
+
+detail::TransportAwaitable<detail::WriteAwaiter> Transport::write(
+    std::unique_ptr<IOBuf> buf,
+    WriteFlags flags) {
+  return detail::TransportAwaitable<detail::WriteAwaiter>(
+      detail::WriteAwaiter::Args{
+          transport_.get(), ByteRange(), std::move(buf), flags});
+}
+
+SocketAddress Transport::getLocalAddress() const {
+  SocketAddress address;
+  transport_->getLocalAddress(&address);
+  return address;
+}
+
+SocketAddress Transport::getPeerAddress() const {
+  SocketAddress address;
+  transport_->getPeerAddress(&address);
+  return address;
+}
+
+} // namespace coro
+} // namespace folly
+
+#endif // FOLLY_HAS_COROUTINES
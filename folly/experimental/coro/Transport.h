@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <experimental/coroutine>
+#include <memory>
+
+#include <folly/CancellationToken.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/Executor.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/SocketAddress.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTransport.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/Request.h>
+
+namespace folly {
+namespace coro {
+
+namespace detail {
+
+// Common part of the awaiters of the operations of Transport and
+// ServerSocket, which are started and completed on an EventBase thread.
+//
+// The awaiting coroutine is resumed directly from the callback of the
+// transport when it runs on that EventBase, and through its executor
+// otherwise, e.g. after a cancellation requested from another thread.
+class TransportAwaiterBase {
+ public:
+  TransportAwaiterBase(const TransportAwaiterBase&) = delete;
+  TransportAwaiterBase& operator=(const TransportAwaiterBase&) = delete;
+
+  bool await_ready() noexcept {
+    return false;
+  }
+
+ protected:
+  TransportAwaiterBase(
+      EventBase* eventBase,
+      Executor::KeepAlive<> executor,
+      CancellationToken cancelToken,
+      bool resumeInline = true) noexcept
+      : eventBase_(eventBase),
+        executor_(std::move(executor)),
+        cancelToken_(std::move(cancelToken)),
+        resumeInline_(resumeInline) {}
+
+  ~TransportAwaiterBase() = default;
+
+  // Called by await_suspend() before and after starting the operation;
+  // endSuspend() returns whether the coroutine stays suspended, i.e. the
+  // operation did not complete synchronously, so that a loop of operations
+  // that do doesn't grow the stack.
+  void beginSuspend(std::experimental::coroutine_handle<> continuation);
+  bool endSuspend() noexcept;
+
+  // Completes the operation, with an error if there is one, and resumes the
+  // awaiting coroutine, which may destroy this awaiter. Only the first call
+  // does anything.
+  void complete(exception_wrapper error = {}, bool mayResumeInline = true)
+      noexcept;
+
+  bool completed() const noexcept {
+    return completed_.load(std::memory_order_acquire);
+  }
+
+  // Called by await_resume(); throws the error of the operation.
+  void finish();
+
+  EventBase* const eventBase_;
+
+ private:
+  Executor::KeepAlive<> executor_;
+  CancellationToken cancelToken_;
+  Optional<CancellationCallback> cancelCallback_;
+  std::experimental::coroutine_handle<> continuation_;
+  std::shared_ptr<RequestContext> context_;
+  std::atomic<bool> completed_{false};
+  enum class State { Starting, Suspended, Completed };
+  std::atomic<State> state_{State::Starting};
+  exception_wrapper error_;
+  const bool resumeInline_;
+};
+
+// Awaitable of the operations of Transport and ServerSocket: it only holds
+// the parameters of the operation until the awaiting coroutine provides its
+// executor and cancellation token. Only awaitable from a Task or an
+// AsyncGenerator.
+template <class Awaiter>
+class TransportAwaitable {
+ public:
+  using Args = typename Awaiter::Args;
+
+  explicit TransportAwaitable(Args args) noexcept : args_(std::move(args)) {}
+
+  friend TransportAwaitable co_withCancellation(
+      const CancellationToken& cancelToken,
+      TransportAwaitable&& awaitable) noexcept {
+    // Keeps the inner-most token.
+    if (!awaitable.hasCancelToken_) {
+      awaitable.cancelToken_ = cancelToken;
+      awaitable.hasCancelToken_ = true;
+    }
+    return std::move(awaitable);
+  }
+
+  Awaiter viaIfAsync(Executor::KeepAlive<> executor) && noexcept {
+    return Awaiter(
+        std::move(args_), std::move(executor), std::move(cancelToken_));
+  }
+
+ private:
+  Args args_;
+  CancellationToken cancelToken_;
+  bool hasCancelToken_{false};
+};
+
+class ReadAwaiter : public TransportAwaiterBase,
+                    private AsyncTransport::ReadCallback,
+                    private HHWheelTimer::Callback {
+ public:
+  struct Args {
+    AsyncTransport* transport;
+    // either buf, or queue with minReadSize and newAllocationSize
+    MutableByteRange buf;
+    IOBufQueue* queue;
+    size_t minReadSize;
+    size_t newAllocationSize;
+    std::chrono::milliseconds timeout;
+  };
+
+  ReadAwaiter(
+      Args args,
+      Executor::KeepAlive<> executor,
+      CancellationToken cancelToken) noexcept
+      : TransportAwaiterBase(
+            args.transport->getEventBase(),
+            std::move(executor),
+            std::move(cancelToken)),
+        args_(args) {}
+
+  bool await_suspend(std::experimental::coroutine_handle<> continuation);
+  size_t await_resume();
+
+ private:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override;
+  void readDataAvailable(size_t len) noexcept override;
+  void readEOF() noexcept override;
+  void readErr(const AsyncSocketException& ex) noexcept override;
+  void timeoutExpired() noexcept override;
+
+  Args args_;
+  size_t bytesRead_{0};
+};
+
+class WriteAwaiter : public TransportAwaiterBase,
+                     private AsyncTransport::WriteCallback {
+ public:
+  struct Args {
+    AsyncTransport* transport;
+    // either buf or chain
+    ByteRange buf;
+    std::unique_ptr<IOBuf> chain;
+    WriteFlags flags;
+  };
+
+  // Writes are not cancellable: the transport keeps this awaiter as its
+  // WriteCallback until the write completes or fails, so the coroutine must
+  // not be resumed (and the awaiter destroyed) before that.
+  WriteAwaiter(
+      Args args,
+      Executor::KeepAlive<> executor,
+      CancellationToken /* cancelToken */) noexcept
+      : TransportAwaiterBase(
+            args.transport->getEventBase(),
+            std::move(executor),
+            CancellationToken()),
+        args_(std::move(args)) {}
+
+  bool await_suspend(std::experimental::coroutine_handle<> continuation);
+  void await_resume();
+
+ private:
+  void writeSuccess() noexcept override;
+  void writeErr(size_t bytesWritten, const AsyncSocketException& ex) noexcept
+      override;
+
+  Args args_;
+};
+
+class ConnectAwaiter : public TransportAwaiterBase,
+                       private AsyncSocket::ConnectCallback {
+ public:
+  struct Args {
+    AsyncSocket* socket;
+    SocketAddress address;
+    std::chrono::milliseconds timeout;
+  };
+
+  ConnectAwaiter(
+      Args args,
+      Executor::KeepAlive<> executor,
+      CancellationToken cancelToken) noexcept
+      : TransportAwaiterBase(
+            args.socket->getEventBase(),
+            std::move(executor),
+            std::move(cancelToken)),
+        args_(std::move(args)) {}
+
+  bool await_suspend(std::experimental::coroutine_handle<> continuation);
+  void await_resume();
+
+ private:
+  void connectSuccess() noexcept override;
+  void connectErr(const AsyncSocketException& ex) noexcept override;
+
+  Args args_;
+};
+
+} // namespace detail
+
+/**
+ * Coroutine interface of an AsyncTransport, e.g. an AsyncSocket.
+ *
+ * Operations are awaited from a Task or AsyncGenerator whose executor is
+ * the EventBase of the transport, e.g.
+ *
+ *   auto transport = co_await Transport::newConnectedSocket(evb, address);
+ *   co_await transport.write(IOBuf::copyBuffer("ping"));
+ *   char buf[4];
+ *   size_t n = co_await transport.read(MutableByteRange(buf, sizeof(buf)));
+ *
+ * The awaiting coroutine is resumed directly from the transport's callback,
+ * without a Future or an executor in between. Reads can be cancelled, and
+ * throw OperationCancelled then; they throw AsyncSocketException with
+ * TIMED_OUT if the timeout expires first. Writes can't be cancelled, the
+ * transport's send timeout applies to them. Only one read and one write may
+ * be awaited at a time.
+ */
+class Transport {
+ public:
+  Transport(EventBase* eventBase, AsyncTransport::UniquePtr transport)
+      : eventBase_(eventBase), transport_(std::move(transport)) {}
+
+  Transport(Transport&&) = default;
+  Transport& operator=(Transport&&) = default;
+
+  static Task<Transport> newConnectedSocket(
+      EventBase* eventBase,
+      const SocketAddress& address,
+      std::chrono::milliseconds connectTimeout = std::chrono::milliseconds(0));
+
+  /**
+   * Reads some bytes into buf. Completes with the number of bytes read, or
+   * with 0 at the end of the stream. A timeout of 0 means none.
+   */
+  detail::TransportAwaitable<detail::ReadAwaiter> read(
+      MutableByteRange buf,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+  /**
+   * Reads some bytes into buf, allocating with
+   * IOBufQueue::preallocate(minReadSize, newAllocationSize).
+   */
+  detail::TransportAwaitable<detail::ReadAwaiter> read(
+      IOBufQueue& buf,
+      size_t minReadSize,
+      size_t newAllocationSize,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+  /**
+   * Writes all of buf, which must stay valid until the write completes.
+   */
+  detail::TransportAwaitable<detail::WriteAwaiter> write(
+      ByteRange buf,
+      WriteFlags flags = WriteFlags::NONE);
+  detail::TransportAwaitable<detail::WriteAwaiter> write(
+      std::unique_ptr<IOBuf> buf,
+      WriteFlags flags = WriteFlags::NONE);
+
+  void close() {
+    transport_->close();
+  }
+  void closeWithReset() {
+    transport_->closeWithReset();
+  }
+  void shutdownWrite() {
+    transport_->shutdownWrite();
+  }
+
+  EventBase* getEventBase() const noexcept {
+    return eventBase_;
+  }
+  AsyncTransport* getTransport() const noexcept {
+    return transport_.get();
+  }
+  SocketAddress getLocalAddress() const;
+  SocketAddress getPeerAddress() const;
+
+ private:
+  EventBase* eventBase_;
+  AsyncTransport::UniquePtr transport_;
+};
+
+} // namespace coro
+} // namespace folly
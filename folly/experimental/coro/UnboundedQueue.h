@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/concurrency/UnboundedQueue.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/fibers/Semaphore.h>
+
+namespace folly {
+namespace coro {
+
+/**
+ * Unbounded queue whose consumers wait for elements by awaiting dequeue(),
+ * without blocking their thread: a consumer that finds the queue empty
+ * suspends until a producer enqueues an element, and is then resumed on
+ * its executor.
+ *
+ * Elements are stored in a folly::UnboundedQueue, and consumers wait on a
+ * fibers::Semaphore counting them, so that producers and consumers only
+ * contend on the semaphore's waiter list when a consumer has to wait.
+ *
+ *   coro::UnboundedQueue<int> queue;
+ *   queue.enqueue(42);
+ *   int value = co_await queue.dequeue();
+ */
+template <typename T, bool SingleProducer = false, bool SingleConsumer = false>
+class UnboundedQueue {
+ public:
+  UnboundedQueue() = default;
+
+  UnboundedQueue(const UnboundedQueue&) = delete;
+  UnboundedQueue& operator=(const UnboundedQueue&) = delete;
+
+  template <typename U = T>
+  void enqueue(U&& value) {
+    queue_.enqueue(std::forward<U>(value));
+    sem_.signal();
+  }
+
+  /**
+   * Waits until the queue has an element and removes it.
+   */
+  Task<T> dequeue() {
+    co_await sem_.co_wait();
+    co_return queue_.dequeue();
+  }
+
+  /**
+   * Removes an element if there is one, without waiting.
+   */
+  Optional<T> try_dequeue() {
+    if (!sem_.try_wait()) {
+      return none;
+    }
+    return queue_.dequeue();
+  }
+
+  /**
+   * Accurate only if there are no concurrent enqueues or dequeues.
+   */
+  size_t size() const noexcept {
+    return queue_.size();
+  }
+
+  bool empty() const noexcept {
+    return queue_.empty();
+  }
+
+ private:
+  folly::UnboundedQueue<T, SingleProducer, SingleConsumer, false> queue_;
+  fibers::Semaphore sem_{0};
+};
+
+} // namespace coro
+} // namespace folly
@@ -22,6 +22,7 @@
 #include <folly/Executor.h>
 #include <folly/Traits.h>
 #include <folly/experimental/coro/Traits.h>
+#include <folly/experimental/coro/detail/AsyncStackAwaiter.h>
 #include <folly/io/async/Request.h>
 #include <folly/lang/CustomizationPoint.h>
 
@@ -431,6 +432,12 @@ class TrySemiAwaitable {
         co_viaIfAsync(std::move(executor), std::move(self.semiAwaitable_))));
   }
 
+  friend void co_setAsyncStackParent(
+      TrySemiAwaitable& self,
+      AsyncStackFrame& parent) noexcept {
+    setAsyncStackParent(self.semiAwaitable_, parent);
+  }
+
  private:
   SemiAwaitable semiAwaitable_;
 };
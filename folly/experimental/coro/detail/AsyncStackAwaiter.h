@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <experimental/coroutine>
+#include <type_traits>
+
+#include <folly/experimental/coro/AsyncStack.h>
+#include <folly/experimental/coro/Traits.h>
+#include <folly/functional/Invoke.h>
+#include <folly/lang/CustomizationPoint.h>
+
+namespace folly {
+namespace coro {
+namespace detail {
+
+namespace adl {
+
+// Default implementation for awaitables that don't run a coroutine which
+// keeps an async stack frame.
+template <typename Awaitable>
+void co_setAsyncStackParent(Awaitable&, AsyncStackFrame&) noexcept {}
+
+struct SetAsyncStackParentFunction {
+  template <typename Awaitable>
+  void operator()(Awaitable& awaitable, AsyncStackFrame& parent) const
+      noexcept {
+    co_setAsyncStackParent(awaitable, parent);
+  }
+};
+
+} // namespace adl
+
+// Makes parent the parent frame of the coroutine run by awaiting the
+// awaitable, for as long as it is awaited.
+FOLLY_DEFINE_CPO(adl::SetAsyncStackParentFunction, setAsyncStackParent)
+
+// Initial awaiter of the coroutines that keep an async stack frame.
+class AsyncStackInitialAwaiter {
+ public:
+  explicit AsyncStackInitialAwaiter(AsyncStackFrame& frame) noexcept
+      : frame_(frame) {}
+
+  bool await_ready() noexcept {
+    return false;
+  }
+
+  void await_suspend(std::experimental::coroutine_handle<>) noexcept {}
+
+  void await_resume() noexcept {
+    setCurrentAsyncStackFrame(&frame_);
+  }
+
+ private:
+  AsyncStackFrame& frame_;
+};
+
+// Wraps the awaiter of a co_await expression of a coroutine to make its
+// frame the current one when it resumes. The awaitable is constructed in
+// place by the function passed, so that it needn't be movable.
+template <typename Awaitable>
+class AsyncStackAwaiter {
+  using Awaiter = awaiter_type_t<Awaitable>;
+
+ public:
+  template <typename F>
+  AsyncStackAwaiter(F&& makeAwaitable, AsyncStackFrame& frame)
+      : awaitable_(static_cast<F&&>(makeAwaitable)()),
+        awaiter_(get_awaiter(static_cast<Awaitable&&>(awaitable_))),
+        frame_(frame) {}
+
+  AsyncStackAwaiter(const AsyncStackAwaiter&) = delete;
+  AsyncStackAwaiter& operator=(const AsyncStackAwaiter&) = delete;
+
+  decltype(auto) await_ready() noexcept(
+      noexcept(std::declval<Awaiter&>().await_ready())) {
+    return awaiter_.await_ready();
+  }
+
+  template <typename Promise>
+  decltype(auto) await_suspend(
+      std::experimental::coroutine_handle<Promise> continuation) noexcept(
+      noexcept(std::declval<Awaiter&>().await_suspend(continuation))) {
+    setCurrentAsyncStackFrame(nullptr);
+    return awaiter_.await_suspend(continuation);
+  }
+
+  decltype(auto) await_resume() noexcept(
+      noexcept(std::declval<Awaiter&>().await_resume())) {
+    setCurrentAsyncStackFrame(&frame_);
+    return awaiter_.await_resume();
+  }
+
+ private:
+  Awaitable awaitable_;
+  Awaiter awaiter_;
+  AsyncStackFrame& frame_;
+};
+
+template <typename F>
+AsyncStackAwaiter<invoke_result_t<F>> makeAsyncStackAwaiter(
+    F&& makeAwaitable,
+    AsyncStackFrame& frame) {
+  return AsyncStackAwaiter<invoke_result_t<F>>(
+      static_cast<F&&>(makeAwaitable), frame);
+}
+
+} // namespace detail
+} // namespace coro
+} // namespace folly
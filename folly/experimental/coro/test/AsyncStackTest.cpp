@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/AsyncStack.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/CurrentExecutor.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/experimental/symbolizer/Symbolizer.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly::coro;
+
+namespace {
+
+size_t asyncStackDepth() {
+  return getAsyncStackTrace(nullptr, 0);
+}
+
+Task<size_t> leaf() {
+  co_return asyncStackDepth();
+}
+
+Task<size_t> middle() {
+  co_return co_await leaf();
+}
+
+} // namespace
+
+TEST(AsyncStack, Task) {
+  EXPECT_EQ(0, asyncStackDepth());
+  EXPECT_EQ(1, blockingWait(leaf()));
+  EXPECT_EQ(2, blockingWait(middle()));
+  EXPECT_EQ(0, asyncStackDepth());
+}
+
+TEST(AsyncStack, Parent) {
+  blockingWait([]() -> Task<void> {
+    auto* frame = getCurrentAsyncStackFrame();
+    ASSERT_NE(nullptr, frame);
+    EXPECT_EQ(nullptr, frame->parent);
+    EXPECT_NE(0, frame->resumeAddress());
+
+    auto* child = co_await []() -> Task<AsyncStackFrame*> {
+      co_return getCurrentAsyncStackFrame();
+    }();
+    EXPECT_NE(frame, child);
+
+    // The frame is current again after resuming, even on another executor
+    // thread.
+    EXPECT_EQ(frame, getCurrentAsyncStackFrame());
+    co_await co_reschedule_on_current_executor;
+    EXPECT_EQ(frame, getCurrentAsyncStackFrame());
+    EXPECT_EQ(3, co_await middle());
+    EXPECT_EQ(3, (co_await co_awaitTry(middle())).value());
+  }());
+}
+
+TEST(AsyncStack, AsyncGenerator) {
+  auto makeGenerator = []() -> AsyncGenerator<size_t> {
+    co_yield asyncStackDepth();
+    co_yield co_await leaf();
+  };
+  blockingWait([&]() -> Task<void> {
+    auto gen = makeGenerator();
+    auto* frame = getCurrentAsyncStackFrame();
+    EXPECT_EQ(2, *co_await gen.next());
+    EXPECT_EQ(frame, getCurrentAsyncStackFrame());
+    EXPECT_EQ(3, *co_await gen.next());
+    EXPECT_FALSE(co_await gen.next());
+    EXPECT_EQ(frame, getCurrentAsyncStackFrame());
+  }());
+}
+
+TEST(AsyncStack, Str) {
+  EXPECT_EQ("", folly::symbolizer::getAsyncStackTraceStr());
+  auto str = blockingWait(
+      []() -> Task<std::string> {
+        co_return folly::symbolizer::getAsyncStackTraceStr();
+      }());
+  EXPECT_NE("", str);
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/BoundedQueue.h>
+#include <folly/experimental/coro/Collect.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+TEST(BoundedQueue, TryEnqueueDequeue) {
+  coro::BoundedQueue<int> queue(2);
+  EXPECT_EQ(2, queue.capacity());
+  EXPECT_FALSE(queue.try_dequeue());
+  EXPECT_TRUE(queue.try_enqueue(1));
+  EXPECT_TRUE(queue.try_enqueue(2));
+  EXPECT_FALSE(queue.try_enqueue(3));
+  EXPECT_EQ(1, queue.try_dequeue());
+  EXPECT_TRUE(queue.try_enqueue(3));
+  EXPECT_EQ(2, queue.try_dequeue());
+  EXPECT_EQ(3, queue.try_dequeue());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(BoundedQueue, EnqueueWaitsForRoom) {
+  coro::BoundedQueue<int> queue(1);
+  ManualExecutor executor;
+  auto first = queue.enqueue(1).scheduleOn(&executor).start();
+  auto second = queue.enqueue(2).scheduleOn(&executor).start();
+  executor.drain();
+  EXPECT_TRUE(first.isReady());
+  EXPECT_FALSE(second.isReady());
+
+  auto value = queue.dequeue().scheduleOn(&executor).start();
+  executor.drain();
+  EXPECT_EQ(1, std::move(value).get());
+  EXPECT_TRUE(second.isReady());
+  EXPECT_EQ(2, queue.try_dequeue());
+}
+
+TEST(BoundedQueue, Pipeline) {
+  constexpr int kCount = 10000;
+  coro::BoundedQueue<int, true, true> queue(8);
+  CPUThreadPoolExecutor executor(2);
+
+  auto produce = [&]() -> coro::Task<void> {
+    for (int i = 1; i <= kCount; ++i) {
+      co_await queue.enqueue(i);
+    }
+  };
+  auto consume = [&]() -> coro::Task<int64_t> {
+    int64_t sum = 0;
+    for (int i = 0; i < kCount; ++i) {
+      sum += co_await queue.dequeue();
+    }
+    co_return sum;
+  };
+
+  auto result = coro::blockingWait(coro::collectAll(
+      produce().scheduleOn(&executor), consume().scheduleOn(&executor)));
+  EXPECT_EQ(int64_t(kCount) * (kCount + 1) / 2, std::get<1>(result));
+}
+
+#endif // FOLLY_HAS_COROUTINES
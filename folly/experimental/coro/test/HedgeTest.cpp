@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/executors/ManualExecutor.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/experimental/coro/Baton.h>
+#include <folly/experimental/coro/Hedge.h>
+#include <folly/futures/ManualTimekeeper.h>
+#include <folly/portability/GTest.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace folly;
+
+namespace {
+
+// ManualTimekeeper fulfills the timers under its lock, which the callbacks
+// starting the next timers need: queue them until it is released.
+void advance(ManualTimekeeper& tk, Duration dur) {
+  QueuedImmediateExecutor::instance().add([&] { tk.advance(dur); });
+}
+
+// Attempt i waits for batons[i], then fails if fail[i] is set and returns i
+// otherwise.
+struct Attempts {
+  explicit Attempts(size_t n) : batons(n), fail(n), tokens(n) {}
+
+  coro::Task<int> run(size_t attempt) {
+    started++;
+    tokens[attempt] = co_await coro::co_current_cancellation_token;
+    co_await batons[attempt];
+    if (fail[attempt]) {
+      throw std::runtime_error("attempt failed");
+    }
+    co_return int(attempt);
+  }
+
+  void complete(size_t attempt, bool failed = false) {
+    fail[attempt] = failed;
+    batons[attempt].post();
+  }
+
+  std::vector<coro::Baton> batons;
+  std::vector<bool> fail;
+  std::vector<CancellationToken> tokens;
+  size_t started{0};
+};
+
+} // namespace
+
+TEST(HedgeTest, FirstSuccessWins) {
+  ManualExecutor executor;
+  ManualTimekeeper tk;
+  Attempts attempts(3);
+  auto f =
+      coro::hedge([&](size_t i) { return attempts.run(i); }, 10ms, 3, &tk)
+          .scheduleOn(&executor)
+          .start();
+  executor.drain();
+  EXPECT_EQ(1, attempts.started);
+
+  advance(tk, 10ms);
+  executor.drain();
+  EXPECT_EQ(2, attempts.started);
+
+  attempts.complete(1);
+  executor.drain();
+  ASSERT_TRUE(f.isReady());
+  EXPECT_EQ(1, std::move(f).get());
+  // the loser is cancelled, and no more attempts start
+  EXPECT_TRUE(attempts.tokens[0].isCancellationRequested());
+  EXPECT_FALSE(attempts.tokens[1].isCancellationRequested());
+  advance(tk, 10ms);
+  executor.drain();
+  EXPECT_EQ(2, attempts.started);
+
+  attempts.complete(0);
+  executor.drain();
+}
+
+TEST(HedgeTest, AllAttemptsFail) {
+  ManualExecutor executor;
+  ManualTimekeeper tk;
+  Attempts attempts(2);
+  auto f =
+      coro::hedge([&](size_t i) { return attempts.run(i); }, 10ms, 2, &tk)
+          .scheduleOn(&executor)
+          .start();
+  executor.drain();
+  // a failure starts the next attempt right away
+  attempts.complete(0, true);
+  executor.drain();
+  EXPECT_EQ(2, attempts.started);
+  attempts.complete(1, true);
+  executor.drain();
+  ASSERT_TRUE(f.isReady());
+  EXPECT_THROW(std::move(f).get(), std::runtime_error);
+}
+
+TEST(CollectNAndCancelTest, FirstWins) {
+  ManualExecutor executor;
+  Attempts attempts(3);
+  std::vector<coro::Task<int>> tasks;
+  for (size_t i = 0; i < 3; ++i) {
+    tasks.push_back(attempts.run(i));
+  }
+  auto f = coro::collectNAndCancel(std::move(tasks), 1)
+               .scheduleOn(&executor)
+               .start();
+  executor.drain();
+  EXPECT_EQ(3, attempts.started);
+
+  attempts.complete(2);
+  executor.drain();
+  ASSERT_TRUE(f.isReady());
+  auto results = std::move(f).get();
+  ASSERT_EQ(1, results.size());
+  EXPECT_EQ(2, results[0].first);
+  EXPECT_EQ(2, results[0].second.value());
+  // the losers are cancelled
+  EXPECT_TRUE(attempts.tokens[0].isCancellationRequested());
+  EXPECT_TRUE(attempts.tokens[1].isCancellationRequested());
+  EXPECT_FALSE(attempts.tokens[2].isCancellationRequested());
+
+  attempts.complete(0);
+  attempts.complete(1);
+  executor.drain();
+}
+
+TEST(CollectNAndCancelTest, AllFail) {
+  ManualExecutor executor;
+  Attempts attempts(2);
+  std::vector<coro::Task<int>> tasks;
+  for (size_t i = 0; i < 2; ++i) {
+    tasks.push_back(attempts.run(i));
+  }
+  auto f = coro::collectNAndCancel(std::move(tasks), 2)
+               .scheduleOn(&executor)
+               .start();
+  executor.drain();
+  attempts.complete(1, true);
+  attempts.complete(0, true);
+  executor.drain();
+  ASSERT_TRUE(f.isReady());
+  auto results = std::move(f).get();
+  ASSERT_EQ(2, results.size());
+  for (auto& result : results) {
+    EXPECT_TRUE(result.second.hasException<std::runtime_error>());
+  }
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/experimental/coro/Baton.h>
 #include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/FrameAllocator.h>
 #include <folly/experimental/coro/Invoke.h>
 #include <folly/experimental/coro/Mutex.h>
 #include <folly/experimental/coro/SharedMutex.h>
@@ -30,6 +31,7 @@
 #include <folly/futures/Future.h>
 #include <folly/portability/GTest.h>
 
+#include <thread>
 #include <type_traits>
 
 using namespace folly;
@@ -433,4 +435,35 @@ TEST(Task, StartInlineUnsafe) {
   }());
 }
 
+TEST(Task, FrameCache) {
+  auto run = [] {
+    // Published when the thread exits.
+    std::thread([] {
+      for (int i = 0; i < 10; ++i) {
+        folly::coro::blockingWait([]() -> folly::coro::Task<int> {
+          co_return 42;
+        }());
+      }
+    }).join();
+  };
+
+  auto before = folly::coro::getFrameAllocatorStats();
+  run();
+  auto after = folly::coro::getFrameAllocatorStats();
+  EXPECT_GE(after.allocations - before.allocations, 10);
+  EXPECT_GE(after.deallocations - before.deallocations, 10);
+  if (!folly::kIsSanitizeAddress) {
+    EXPECT_GE(after.cacheHits - before.cacheHits, 9);
+  }
+
+  auto limit = folly::coro::getFrameCacheLimit();
+  folly::coro::setFrameCacheLimit(0);
+  before = folly::coro::getFrameAllocatorStats();
+  run();
+  after = folly::coro::getFrameAllocatorStats();
+  EXPECT_EQ(after.cached, before.cached);
+  EXPECT_EQ(after.cacheHits, before.cacheHits);
+  folly::coro::setFrameCacheLimit(limit);
+}
+
 #endif
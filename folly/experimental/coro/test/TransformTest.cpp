@@ -19,6 +19,7 @@
 #if FOLLY_HAS_COROUTINES
 
 #include <folly/CancellationToken.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/experimental/coro/AsyncGenerator.h>
 #include <folly/experimental/coro/Baton.h>
 #include <folly/experimental/coro/BlockingWait.h>
@@ -29,6 +30,10 @@
 
 #include <folly/portability/GTest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 using namespace folly::coro;
 
 TEST(Transform, SimpleStream) {
@@ -140,4 +145,85 @@ TEST(Transform, CancellationTokenPropagatesFromConsumer) {
   }());
 }
 
+namespace {
+
+AsyncGenerator<int> range(int n) {
+  for (int i = 0; i < n; ++i) {
+    co_yield i;
+  }
+}
+
+std::vector<int> parallelDoubles(
+    TransformOrder order,
+    size_t maxConcurrency,
+    std::atomic<size_t>& maxRunning) {
+  folly::CPUThreadPoolExecutor executor(4);
+  std::atomic<size_t> running{0};
+  auto doubled = parallelTransform(
+      range(100),
+      &executor,
+      maxConcurrency,
+      [&](int i) {
+        auto now = ++running;
+        auto prev = maxRunning.load();
+        while (now > prev && !maxRunning.compare_exchange_weak(prev, now)) {
+        }
+        // later values complete first
+        std::this_thread::sleep_for(std::chrono::microseconds(100 - i));
+        --running;
+        return i * 2;
+      },
+      order);
+  return blockingWait([&]() -> Task<std::vector<int>> {
+    std::vector<int> results;
+    while (auto item = co_await doubled.next()) {
+      results.push_back(*item);
+    }
+    co_return results;
+  }());
+}
+
+} // namespace
+
+TEST(Transform, ParallelOrdered) {
+  std::atomic<size_t> maxRunning{0};
+  auto results = parallelDoubles(TransformOrder::Ordered, 8, maxRunning);
+  ASSERT_EQ(100, results.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * 2, results[i]);
+  }
+  EXPECT_LE(maxRunning.load(), 4);
+}
+
+TEST(Transform, ParallelUnordered) {
+  std::atomic<size_t> maxRunning{0};
+  auto results = parallelDoubles(TransformOrder::Unordered, 2, maxRunning);
+  ASSERT_EQ(100, results.size());
+  std::sort(results.begin(), results.end());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i * 2, results[i]);
+  }
+  EXPECT_LE(maxRunning.load(), 2);
+}
+
+TEST(Transform, ParallelError) {
+  struct MyError : std::exception {};
+  folly::CPUThreadPoolExecutor executor(2);
+  auto results = parallelTransform(range(10), &executor, 4, [](int i) {
+    if (i == 3) {
+      throw MyError{};
+    }
+    return i;
+  });
+  EXPECT_THROW(
+      blockingWait([&]() -> Task<void> {
+        for (int i = 0; i < 3; ++i) {
+          auto item = co_await results.next();
+          EXPECT_EQ(i, *item);
+        }
+        co_await results.next();
+      }()),
+      MyError);
+}
+
 #endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/CancellationToken.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Collect.h>
+#include <folly/experimental/coro/Invoke.h>
+#include <folly/experimental/coro/ServerSocket.h>
+#include <folly/experimental/coro/Transport.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+namespace {
+
+coro::Task<void> echo(coro::Transport transport) {
+  char buf[64];
+  while (auto n = co_await transport.read(MutableByteRange(
+             reinterpret_cast<uint8_t*>(buf), sizeof(buf)))) {
+    co_await transport.write(ByteRange(reinterpret_cast<uint8_t*>(buf), n));
+  }
+  transport.close();
+}
+
+} // namespace
+
+TEST(Transport, Echo) {
+  ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  coro::blockingWait(
+      coro::co_invoke([&]() -> coro::Task<void> {
+        coro::ServerSocket server(
+            AsyncServerSocket::UniquePtr(new AsyncServerSocket(evb)),
+            SocketAddress("::1", 0),
+            16);
+
+        auto serve = [&]() -> coro::Task<void> {
+          auto connections = server.accept();
+          auto transport = co_await connections.next();
+          co_await echo(std::move(*transport));
+        };
+
+        auto client = [&]() -> coro::Task<std::string> {
+          auto transport = co_await coro::Transport::newConnectedSocket(
+              evb, server.getLocalAddress(), 1000ms);
+          co_await transport.write(IOBuf::copyBuffer("hello, world"));
+          transport.shutdownWrite();
+          IOBufQueue queue(IOBufQueue::cacheChainLength());
+          while (co_await transport.read(queue, 16, 64, 1000ms)) {
+          }
+          co_return queue.move()->moveToFbString().toStdString();
+        };
+
+        auto [unit, echoed] = co_await coro::collectAll(serve(), client());
+        (void)unit;
+        EXPECT_EQ("hello, world", echoed);
+      }).scheduleOn(evb));
+}
+
+TEST(Transport, ReadTimeout) {
+  ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  coro::blockingWait(
+      coro::co_invoke([&]() -> coro::Task<void> {
+        coro::ServerSocket server(
+            AsyncServerSocket::UniquePtr(new AsyncServerSocket(evb)),
+            SocketAddress("::1", 0),
+            16);
+        auto connections = server.accept();
+        auto transport = co_await coro::Transport::newConnectedSocket(
+            evb, server.getLocalAddress());
+        auto accepted = co_await connections.next();
+        EXPECT_TRUE(accepted);
+
+        char buf[16];
+        try {
+          co_await transport.read(
+              MutableByteRange(reinterpret_cast<uint8_t*>(buf), sizeof(buf)),
+              10ms);
+          ADD_FAILURE();
+        } catch (const AsyncSocketException& ex) {
+          EXPECT_EQ(AsyncSocketException::TIMED_OUT, ex.getType());
+        }
+      }).scheduleOn(evb));
+}
+
+TEST(Transport, ReadCancelled) {
+  ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  CancellationSource cancelSource;
+  coro::blockingWait(
+      coro::co_invoke([&]() -> coro::Task<void> {
+        coro::ServerSocket server(
+            AsyncServerSocket::UniquePtr(new AsyncServerSocket(evb)),
+            SocketAddress("::1", 0),
+            16);
+        auto connections = server.accept();
+        auto transport = co_await coro::Transport::newConnectedSocket(
+            evb, server.getLocalAddress());
+        auto accepted = co_await connections.next();
+        EXPECT_TRUE(accepted);
+
+        char buf[16];
+        evb->runAfterDelay([&] { cancelSource.requestCancellation(); }, 10);
+        EXPECT_THROW(
+            co_await coro::co_withCancellation(
+                cancelSource.getToken(),
+                transport.read(MutableByteRange(
+                    reinterpret_cast<uint8_t*>(buf), sizeof(buf)))),
+            OperationCancelled);
+      }).scheduleOn(evb));
+}
+
+TEST(Transport, WriteIgnoresCancellation) {
+  ScopedEventBaseThread evbThread;
+  auto* evb = evbThread.getEventBase();
+  CancellationSource cancelSource;
+  cancelSource.requestCancellation();
+  coro::blockingWait(
+      coro::co_invoke([&]() -> coro::Task<void> {
+        coro::ServerSocket server(
+            AsyncServerSocket::UniquePtr(new AsyncServerSocket(evb)),
+            SocketAddress("::1", 0),
+            16);
+        auto connections = server.accept();
+        auto transport = co_await coro::Transport::newConnectedSocket(
+            evb, server.getLocalAddress());
+        auto accepted = co_await connections.next();
+        EXPECT_TRUE(accepted);
+
+        // Completes (rather than throwing OperationCancelled) because the
+        // transport owns the write until its callback runs.
+        co_await coro::co_withCancellation(
+            cancelSource.getToken(),
+            transport.write(IOBuf::copyBuffer("hello")));
+        char buf[16];
+        auto n = co_await accepted->read(
+            MutableByteRange(reinterpret_cast<uint8_t*>(buf), sizeof(buf)),
+            1000ms);
+        EXPECT_EQ("hello", std::string(buf, n));
+      }).scheduleOn(evb));
+}
+
+#endif // FOLLY_HAS_COROUTINES
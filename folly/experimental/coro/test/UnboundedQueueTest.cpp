@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Collect.h>
+#include <folly/experimental/coro/UnboundedQueue.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+TEST(UnboundedQueue, TryDequeue) {
+  coro::UnboundedQueue<int> queue;
+  EXPECT_FALSE(queue.try_dequeue());
+  queue.enqueue(1);
+  queue.enqueue(2);
+  EXPECT_EQ(2, queue.size());
+  EXPECT_EQ(1, queue.try_dequeue());
+  EXPECT_EQ(2, queue.try_dequeue());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(UnboundedQueue, DequeueWaits) {
+  coro::UnboundedQueue<std::unique_ptr<int>> queue;
+  ManualExecutor executor;
+  auto f = queue.dequeue().scheduleOn(&executor).start();
+  executor.drain();
+  EXPECT_FALSE(f.isReady());
+
+  queue.enqueue(std::make_unique<int>(42));
+  executor.drain();
+  ASSERT_TRUE(f.isReady());
+  EXPECT_EQ(42, *std::move(f).get());
+}
+
+TEST(UnboundedQueue, ProducersConsumers) {
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+  constexpr int kPerProducer = 1000;
+  coro::UnboundedQueue<int> queue;
+  CPUThreadPoolExecutor executor(kProducers + kConsumers);
+
+  auto produce = [&]() -> coro::Task<void> {
+    for (int i = 1; i <= kPerProducer; ++i) {
+      queue.enqueue(i);
+    }
+    co_return;
+  };
+  auto consume = [&]() -> coro::Task<int64_t> {
+    int64_t sum = 0;
+    for (int i = 0; i < kPerProducer * kProducers / kConsumers; ++i) {
+      sum += co_await queue.dequeue();
+    }
+    co_return sum;
+  };
+
+  std::vector<coro::TaskWithExecutor<void>> producers;
+  std::vector<coro::TaskWithExecutor<int64_t>> consumers;
+  for (int i = 0; i < kProducers; ++i) {
+    producers.push_back(produce().scheduleOn(&executor));
+  }
+  for (int i = 0; i < kConsumers; ++i) {
+    consumers.push_back(consume().scheduleOn(&executor));
+  }
+  auto sums = coro::blockingWait(coro::collectAll(
+      coro::collectAllRange(std::move(producers)),
+      coro::collectAllRange(std::move(consumers))));
+  int64_t total = 0;
+  for (auto sum : std::get<1>(sums)) {
+    total += sum;
+  }
+  EXPECT_EQ(int64_t(kProducers) * kPerProducer * (kPerProducer + 1) / 2, total);
+  EXPECT_TRUE(queue.empty());
+}
+
+#endif // FOLLY_HAS_COROUTINES
@@ -16,12 +16,15 @@
 
 #include <folly/experimental/exception_tracer/ExceptionCounterLib.h>
 
+#include <atomic>
 #include <iosfwd>
 #include <unordered_map>
 
+#include <folly/Random.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
+#include <folly/TokenBucket.h>
 #include <folly/hash/SpookyHashV2.h>
 #include <folly/synchronization/RWSpinLock.h>
 
@@ -40,6 +43,9 @@ using ExceptionId = uint64_t;
 using ExceptionStatsHolderType =
     std::unordered_map<ExceptionId, ExceptionStats>;
 
+using ExceptionTypeCountsType =
+    std::unordered_map<const std::type_info*, uint64_t>;
+
 struct ExceptionStatsStorage {
   void appendTo(ExceptionStatsHolderType& data) {
     ExceptionStatsHolderType tempHolder;
@@ -53,18 +59,56 @@ struct ExceptionStatsStorage {
     }
   }
 
+  void appendTo(ExceptionTypeCountsType& data) {
+    ExceptionTypeCountsType tempCounts;
+    typeCounts.wlock()->swap(tempCounts);
+
+    for (const auto& myData : tempCounts) {
+      data[myData.first] += myData.second;
+    }
+  }
+
   folly::Synchronized<ExceptionStatsHolderType, folly::RWSpinLock> statsHolder;
+  folly::Synchronized<ExceptionTypeCountsType, folly::RWSpinLock> typeCounts;
 };
 
 class Tag {};
 
 folly::ThreadLocal<ExceptionStatsStorage, Tag> gExceptionStats;
 
+std::atomic<uint32_t> gStackSampleRate{1};
+std::atomic<uint32_t> gMaxStacksPerSecond{0};
+folly::DynamicTokenBucket gStackTokenBucket;
+
+bool shouldCaptureStack() {
+  auto sampleRate = gStackSampleRate.load(std::memory_order_relaxed);
+  if (sampleRate != 1 && !folly::Random::oneIn(sampleRate)) {
+    return false;
+  }
+  auto maxPerSecond = gMaxStacksPerSecond.load(std::memory_order_relaxed);
+  return maxPerSecond == 0 ||
+      gStackTokenBucket.consume(1, maxPerSecond, maxPerSecond);
+}
+
 } // namespace
 
 namespace folly {
 namespace exception_tracer {
 
+void setExceptionStatsOptions(const ExceptionStatsOptions& options) {
+  gStackSampleRate.store(options.stackSampleRate, std::memory_order_relaxed);
+  gMaxStacksPerSecond.store(
+      options.maxStacksPerSecond, std::memory_order_relaxed);
+}
+
+ExceptionStatsOptions getExceptionStatsOptions() {
+  ExceptionStatsOptions options;
+  options.stackSampleRate = gStackSampleRate.load(std::memory_order_relaxed);
+  options.maxStacksPerSecond =
+      gMaxStacksPerSecond.load(std::memory_order_relaxed);
+  return options;
+}
+
 std::vector<ExceptionStats> getExceptionStatistics() {
   ExceptionStatsHolderType accumulator;
   for (auto& threadStats : gExceptionStats.accessAllThreads()) {
@@ -87,6 +131,28 @@ std::vector<ExceptionStats> getExceptionStatistics() {
   return result;
 }
 
+std::vector<ExceptionTypeStats> getExceptionTypeStatistics() {
+  ExceptionTypeCountsType accumulator;
+  for (auto& threadStats : gExceptionStats.accessAllThreads()) {
+    threadStats.appendTo(accumulator);
+  }
+
+  std::vector<ExceptionTypeStats> result;
+  result.reserve(accumulator.size());
+  for (auto& item : accumulator) {
+    result.push_back({item.first, item.second});
+  }
+
+  std::sort(
+      result.begin(),
+      result.end(),
+      [](const ExceptionTypeStats& lhs, const ExceptionTypeStats& rhs) {
+        return lhs.count > rhs.count;
+      });
+
+  return result;
+}
+
 std::ostream& operator<<(std::ostream& out, const ExceptionStats& stats) {
   out << "Exception report: \n"
       << "Exception count: " << stats.count << "\n"
@@ -105,6 +171,12 @@ namespace {
  * Information is being stored in thread local storage.
  */
 void throwHandler(void*, std::type_info* exType, void (**)(void*)) noexcept {
+  auto& stats = *gExceptionStats;
+  ++(*stats.typeCounts.wlock())[exType];
+  if (!shouldCaptureStack()) {
+    return;
+  }
+
   // This array contains the exception type and the stack frame
   // pointers so they get all hashed together.
   uintptr_t frames[kMaxFrames + 1];
@@ -120,7 +192,7 @@ void throwHandler(void*, std::type_info* exType, void (**)(void*)) noexcept {
   auto exceptionId =
       folly::hash::SpookyHashV2::Hash64(frames, (n + 1) * sizeof(frames[0]), 0);
 
-  gExceptionStats->statsHolder.withWLock([&](auto& holder) {
+  stats.statsHolder.withWLock([&](auto& holder) {
     auto it = holder.find(exceptionId);
     if (it != holder.end()) {
       ++it->second.count;
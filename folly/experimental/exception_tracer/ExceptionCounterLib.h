@@ -17,6 +17,7 @@
 #pragma once
 
 #include <ostream>
+#include <typeinfo>
 #include <vector>
 
 #include <folly/experimental/exception_tracer/ExceptionTracer.h>
@@ -25,10 +26,40 @@ namespace folly {
 namespace exception_tracer {
 
 struct ExceptionStats {
+  // Number of throws from this stack whose stack trace was captured; see
+  // ExceptionStatsOptions.
   uint64_t count;
   ExceptionInfo info;
 };
 
+struct ExceptionTypeStats {
+  const std::type_info* type;
+  uint64_t count;
+};
+
+/**
+ * Controls how much work is done on each throw. Every throw is counted by
+ * type, which is cheap; capturing the stack trace is not, so under heavy
+ * exception traffic it may be limited to a sample of throws.
+ */
+struct ExceptionStatsOptions {
+  /**
+   * Capture the stack trace of a random one in every stackSampleRate
+   * throws. 1 captures all of them, 0 none.
+   */
+  uint32_t stackSampleRate{1};
+
+  /**
+   * Capture at most this many stack traces per second, across all threads.
+   * 0 means no limit.
+   */
+  uint32_t maxStacksPerSecond{0};
+};
+
+void setExceptionStatsOptions(const ExceptionStatsOptions& options);
+
+ExceptionStatsOptions getExceptionStatsOptions();
+
 /**
  * This function accumulates exception throwing statistics across all threads.
  * Please note, that during call to this function, other threads might block
@@ -37,6 +68,13 @@ struct ExceptionStats {
  */
 std::vector<ExceptionStats> getExceptionStatistics();
 
+/**
+ * Like getExceptionStatistics(), but counts all throws of each exception
+ * type, whether or not their stack trace was captured. Sorted by count.
+ * Resets the per-type counts, independently of the per-stack statistics.
+ */
+std::vector<ExceptionTypeStats> getExceptionTypeStatistics();
+
 std::ostream& operator<<(std::ostream& out, const ExceptionStats& data);
 
 } // namespace exception_tracer
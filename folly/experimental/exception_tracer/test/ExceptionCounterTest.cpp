@@ -131,3 +131,52 @@ TEST(ExceptionCounter, multyThreads) {
     t.join();
   }
 }
+
+TEST(ExceptionCounter, typeStatistics) {
+  getExceptionTypeStatistics();
+
+  throwAndCatch(foo);
+  throwAndCatch(baz);
+  throwAndCatch(bar);
+
+  auto types = getExceptionTypeStatistics();
+  ASSERT_EQ(types.size(), 2);
+  EXPECT_EQ(*(types[0].type), typeid(MyException));
+  EXPECT_EQ(types[0].count, 2);
+  EXPECT_EQ(*(types[1].type), typeid(std::runtime_error));
+  EXPECT_EQ(types[1].count, 1);
+  EXPECT_EQ(getExceptionTypeStatistics().size(), 0);
+
+  getExceptionStatistics();
+}
+
+TEST(ExceptionCounter, limitedStackCapture) {
+  getExceptionTypeStatistics();
+  getExceptionStatistics();
+
+  ExceptionStatsOptions options;
+  options.stackSampleRate = 0;
+  setExceptionStatsOptions(options);
+  for (volatile int i = 0; i < 10; ++i) {
+    throwAndCatch(bar);
+  }
+  EXPECT_EQ(getExceptionStatistics().size(), 0);
+  auto types = getExceptionTypeStatistics();
+  ASSERT_EQ(types.size(), 1);
+  EXPECT_EQ(types[0].count, 10);
+
+  options.stackSampleRate = 1;
+  options.maxStacksPerSecond = 1;
+  setExceptionStatsOptions(options);
+  for (volatile int i = 0; i < 10; ++i) {
+    throwAndCatch(bar);
+  }
+  auto stats = getExceptionStatistics();
+  ASSERT_EQ(stats.size(), 1);
+  // One token to start with, and maybe another if a second went by.
+  EXPECT_GE(stats[0].count, 1);
+  EXPECT_LE(stats[0].count, 2);
+  EXPECT_EQ(getExceptionTypeStatistics()[0].count, 10);
+
+  setExceptionStatsOptions(ExceptionStatsOptions());
+}
@@ -128,6 +128,49 @@ void AsyncBase::submit(Op* op) {
   op->start();
 }
 
+size_t AsyncBase::submit(Range<Op**> ops) {
+  for (auto* op : ops) {
+    CHECK_EQ(op->state(), Op::State::INITIALIZED);
+  }
+  if (ops.empty()) {
+    return 0;
+  }
+  initializeContext(); // on demand
+
+  auto p = pending_.fetch_add(ops.size(), std::memory_order_acq_rel);
+  if (p + ops.size() > capacity_) {
+    pending_.fetch_sub(ops.size(), std::memory_order_acq_rel);
+    throw std::range_error("AsyncBase: too many pending requests");
+  }
+
+  int rc = submitRange(ops);
+
+  if (rc < 0) {
+    pending_.fetch_sub(ops.size(), std::memory_order_acq_rel);
+    throwSystemErrorExplicit(-rc, "AsyncBase: io_submit failed");
+  }
+  auto numSubmitted = static_cast<size_t>(rc);
+  DCHECK_LE(numSubmitted, ops.size());
+  pending_.fetch_sub(ops.size() - numSubmitted, std::memory_order_acq_rel);
+  submitted_ += numSubmitted;
+  for (size_t i = 0; i < numSubmitted; ++i) {
+    ops[i]->start();
+  }
+  return numSubmitted;
+}
+
+int AsyncBase::submitRange(Range<AsyncBase::Op**> ops) {
+  int numSubmitted = 0;
+  for (auto* op : ops) {
+    int rc = submitOne(op);
+    if (rc < 0) {
+      return numSubmitted > 0 ? numSubmitted : rc;
+    }
+    ++numSubmitted;
+  }
+  return numSubmitted;
+}
+
 Range<AsyncBase::Op**> AsyncBase::wait(size_t minRequests) {
   CHECK(isInit());
   CHECK_EQ(pollFd_, -1) << "wait() only allowed on non-pollable object";
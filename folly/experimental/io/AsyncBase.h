@@ -23,6 +23,7 @@
 #include <deque>
 #include <functional>
 #include <iosfwd>
+#include <memory>
 #include <mutex>
 #include <utility>
 #include <vector>
@@ -77,6 +78,13 @@ class AsyncBaseOp {
   }
   virtual void pwritev(int fd, const iovec* iov, int iovcnt, off_t start) = 0;
 
+  /**
+   * Initiate a flush of the file's data and metadata to storage, or of only
+   * the data and the metadata needed to read it back.
+   */
+  virtual void fsync(int fd) = 0;
+  virtual void fdatasync(int fd) = 0;
+
   // we support only these subclasses
   virtual AsyncIOOp* getAsyncIOOp() = 0;
   virtual IoUringOp* getIoUringOp() = 0;
@@ -234,6 +242,20 @@ class AsyncBase {
    */
   void submit(Op* op);
 
+  /**
+   * Submit several ops for execution, with a single system call where the
+   * implementation allows it. Returns the number of ops submitted, which are
+   * the first ones; the others are left untouched, so they can be submitted
+   * again later.
+   */
+  size_t submit(Range<Op**> ops);
+
+  /**
+   * Create an op of the type this implementation submits, for callers that
+   * only know about the AsyncBase interface.
+   */
+  virtual std::unique_ptr<Op> createOp() const = 0;
+
  protected:
   void complete(Op* op, ssize_t result) {
     op->complete(result);
@@ -250,6 +272,8 @@ class AsyncBase {
   void decrementPending();
   virtual void initializeContext() = 0;
   virtual int submitOne(AsyncBase::Op* op) = 0;
+  // returns the number of ops submitted, or -errno if none were
+  virtual int submitRange(Range<AsyncBase::Op**> ops);
 
   enum class WaitType { COMPLETE, CANCEL };
   virtual Range<AsyncBase::Op**> doWait(
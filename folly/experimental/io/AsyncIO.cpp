@@ -119,6 +119,16 @@ void AsyncIOOp::pwritev(int fd, const iovec* iov, int iovcnt, off_t start) {
   io_prep_pwritev(&iocb_, fd, iov, iovcnt, start);
 }
 
+void AsyncIOOp::fsync(int fd) {
+  init();
+  io_prep_fsync(&iocb_, fd);
+}
+
+void AsyncIOOp::fdatasync(int fd) {
+  init();
+  io_prep_fdsync(&iocb_, fd);
+}
+
 void AsyncIOOp::toStream(std::ostream& os) const {
   os << "{" << state_ << ", ";
 
@@ -199,6 +209,28 @@ int AsyncIO::submitOne(AsyncBase::Op* op) {
   return io_submit(ctx_, 1, &cb);
 }
 
+int AsyncIO::submitRange(Range<AsyncBase::Op**> ops) {
+  std::vector<iocb*> cbs;
+  cbs.reserve(ops.size());
+  for (auto* op : ops) {
+    AsyncIOOp* aop = op->getAsyncIOOp();
+    if (!aop) {
+      break;
+    }
+    iocb* cb = &aop->iocb_;
+    cb->data = nullptr; // unused
+    if (pollFd_ != -1) {
+      io_set_eventfd(cb, pollFd_);
+    }
+    cbs.push_back(cb);
+  }
+  if (cbs.empty()) {
+    return -1;
+  }
+
+  return io_submit(ctx_, long(cbs.size()), cbs.data());
+}
+
 Range<AsyncBase::Op**> AsyncIO::doWait(
     WaitType type,
     size_t minRequests,
@@ -44,6 +44,13 @@ class AsyncIOOp : public AsyncBaseOp {
   void pwrite(int fd, const void* buf, size_t size, off_t start) override;
   void pwritev(int fd, const iovec* iov, int iovcnt, off_t start) override;
 
+  /**
+   * Initiate a flush request. Not every filesystem supports these, they
+   * complete with -EINVAL then.
+   */
+  void fsync(int fd) override;
+  void fdatasync(int fd) override;
+
   void reset(NotificationCallback cb = NotificationCallback()) override;
 
   AsyncIOOp* getAsyncIOOp() override {
@@ -78,9 +85,14 @@ class AsyncIO : public AsyncBase {
   AsyncIO& operator=(const AsyncIO&) = delete;
   ~AsyncIO() override;
 
+  std::unique_ptr<AsyncBase::Op> createOp() const override {
+    return std::make_unique<Op>();
+  }
+
  private:
   void initializeContext() override;
   int submitOne(AsyncBase::Op* op) override;
+  int submitRange(Range<AsyncBase::Op**> ops) override;
 
   Range<AsyncBase::Op**> doWait(
       WaitType type,
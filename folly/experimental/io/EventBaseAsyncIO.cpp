@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/io/EventBaseAsyncIO.h>
+
+#include <stdexcept>
+
+#include <folly/ExceptionWrapper.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Baton.h>
+#endif
+
+#include <glog/logging.h>
+
+namespace folly {
+
+struct EventBaseAsyncIO::Waiter {
+  explicit Waiter(AsyncBaseOp* o) : op(o) {}
+
+  AsyncBaseOp* op;
+#if FOLLY_HAS_COROUTINES
+  coro::Baton baton;
+#endif
+  // set if a queued op could not be submitted
+  exception_wrapper ew;
+};
+
+EventBaseAsyncIO::EventBaseAsyncIO(
+    EventBase* evb,
+    std::unique_ptr<AsyncBase> asyncBase)
+    : EventHandler(evb, NetworkSocket::fromFd(asyncBase->pollFd())),
+      evb_(evb),
+      asyncBase_(std::move(asyncBase)) {
+  CHECK_NE(asyncBase_->pollFd(), -1)
+      << "EventBaseAsyncIO requires a POLLABLE AsyncBase";
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [this] { registerInternalHandler(READ | PERSIST); });
+}
+
+EventBaseAsyncIO::~EventBaseAsyncIO() {
+  CHECK(waiting_.empty());
+  evb_->runImmediatelyOrRunInEventBaseThreadAndWait(
+      [this] { unregisterHandler(); });
+}
+
+void EventBaseAsyncIO::handlerReady(uint16_t /* events */) noexcept {
+  // runs the notification callbacks
+  asyncBase_->pollCompleted();
+  maybeDequeue();
+}
+
+void EventBaseAsyncIO::maybeDequeue() noexcept {
+  while (!waiting_.empty() &&
+         asyncBase_->pending() < asyncBase_->capacity()) {
+    auto* waiter = waiting_.front();
+    waiting_.pop_front();
+    try {
+      asyncBase_->submit(waiter->op);
+    } catch (const std::range_error&) {
+      // raced with a submission from another thread
+      waiting_.push_front(waiter);
+      return;
+    } catch (...) {
+      waiter->ew = exception_wrapper(std::current_exception());
+#if FOLLY_HAS_COROUTINES
+      waiter->baton.post();
+#endif
+    }
+  }
+}
+
+#if FOLLY_HAS_COROUTINES
+coro::Task<ssize_t> EventBaseAsyncIO::co_submit(AsyncBaseOp& op) {
+  Waiter waiter(&op);
+  op.setNotificationCallback([&waiter](AsyncBaseOp*) { waiter.baton.post(); });
+  bool submitted = false;
+  try {
+    asyncBase_->submit(&op);
+    submitted = true;
+  } catch (const std::range_error&) {
+  }
+  if (!submitted) {
+    // Wait for a completion to make room. If every pending op completed in
+    // the meantime nothing would dequeue this one, so retry first.
+    evb_->runInEventBaseThread([this, &waiter] {
+      waiting_.push_back(&waiter);
+      maybeDequeue();
+    });
+  }
+  co_await waiter.baton;
+  if (waiter.ew) {
+    waiter.ew.throw_exception();
+  }
+  co_return op.result();
+}
+
+coro::Task<ssize_t>
+EventBaseAsyncIO::co_pread(int fd, void* buf, size_t size, off_t start) {
+  auto op = asyncBase_->createOp();
+  op->pread(fd, buf, size, start);
+  co_return co_await co_submit(*op);
+}
+
+coro::Task<ssize_t> EventBaseAsyncIO::co_preadv(
+    int fd,
+    const iovec* iov,
+    int iovcnt,
+    off_t start) {
+  auto op = asyncBase_->createOp();
+  op->preadv(fd, iov, iovcnt, start);
+  co_return co_await co_submit(*op);
+}
+
+coro::Task<ssize_t> EventBaseAsyncIO::co_pwrite(
+    int fd,
+    const void* buf,
+    size_t size,
+    off_t start) {
+  auto op = asyncBase_->createOp();
+  op->pwrite(fd, buf, size, start);
+  co_return co_await co_submit(*op);
+}
+
+coro::Task<ssize_t> EventBaseAsyncIO::co_pwritev(
+    int fd,
+    const iovec* iov,
+    int iovcnt,
+    off_t start) {
+  auto op = asyncBase_->createOp();
+  op->pwritev(fd, iov, iovcnt, start);
+  co_return co_await co_submit(*op);
+}
+
+coro::Task<ssize_t> EventBaseAsyncIO::co_fsync(int fd) {
+  auto op = asyncBase_->createOp();
+  op->fsync(fd);
+  co_return co_await co_submit(*op);
+}
+
+coro::Task<ssize_t> EventBaseAsyncIO::co_fdatasync(int fd) {
+  auto op = asyncBase_->createOp();
+  op->fdatasync(fd);
+  co_return co_await co_submit(*op);
+}
+#endif
+
+} // namespace folly
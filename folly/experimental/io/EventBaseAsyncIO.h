@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include <folly/Portability.h>
+#include <folly/experimental/io/AsyncBase.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
+
+namespace folly {
+
+/**
+ * Drives a POLLABLE AsyncBase (AsyncIO or IoUring) from an EventBase:
+ * completions are reaped from the loop once pollFd() becomes readable, so
+ * no thread ever blocks in wait(). The notification callbacks of the ops
+ * run in the EventBase thread. Ops may still be submitted to the AsyncBase
+ * directly, from any thread.
+ *
+ * With coroutine support, the co_*() methods submit an op and suspend the
+ * awaiting coroutine until it completes:
+ *
+ *   EventBaseAsyncIO aio(
+ *       &evb, std::make_unique<IoUring>(64, AsyncBase::POLLABLE));
+ *   ssize_t n = co_await aio.co_pread(fd, buf, size, offset);
+ *
+ * The result follows the AsyncBaseOp::result() convention, i.e. -errno on
+ * failure. Ops submitted while the AsyncBase is at capacity wait in FIFO
+ * order instead of failing with std::range_error. Pending ops cannot be
+ * cancelled, so these coroutines ignore cancellation requests.
+ *
+ * The completion handler does not keep EventBase::loop() from returning.
+ * No ops may be pending when this object is destroyed.
+ */
+class EventBaseAsyncIO : private EventHandler {
+ public:
+  EventBaseAsyncIO(EventBase* evb, std::unique_ptr<AsyncBase> asyncBase);
+  ~EventBaseAsyncIO() override;
+
+  EventBaseAsyncIO(const EventBaseAsyncIO&) = delete;
+  EventBaseAsyncIO& operator=(const EventBaseAsyncIO&) = delete;
+
+  EventBase* getEventBase() const {
+    return evb_;
+  }
+
+  AsyncBase* getAsyncBase() const {
+    return asyncBase_.get();
+  }
+
+  /**
+   * Number of ops waiting for the AsyncBase to have room. EventBase thread
+   * only.
+   */
+  size_t queued() const {
+    return waiting_.size();
+  }
+
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Submit an initialized op and wait for it to complete. The op's
+   * notification callback is replaced. Errors submitting the op are
+   * thrown; errors from the op itself are in the result.
+   */
+  coro::Task<ssize_t> co_submit(AsyncBaseOp& op);
+
+  coro::Task<ssize_t> co_pread(int fd, void* buf, size_t size, off_t start);
+  coro::Task<ssize_t>
+  co_preadv(int fd, const iovec* iov, int iovcnt, off_t start);
+  coro::Task<ssize_t>
+  co_pwrite(int fd, const void* buf, size_t size, off_t start);
+  coro::Task<ssize_t>
+  co_pwritev(int fd, const iovec* iov, int iovcnt, off_t start);
+  coro::Task<ssize_t> co_fsync(int fd);
+  coro::Task<ssize_t> co_fdatasync(int fd);
+#endif
+
+ private:
+  struct Waiter;
+
+  void handlerReady(uint16_t events) noexcept override;
+  void maybeDequeue() noexcept;
+
+  EventBase* evb_;
+  std::unique_ptr<AsyncBase> asyncBase_;
+  // ops that found the AsyncBase full, EventBase thread only
+  std::deque<Waiter*> waiting_;
+};
+
+} // namespace folly
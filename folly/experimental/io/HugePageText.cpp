@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/io/HugePageText.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/Range.h>
+#include <folly/String.h>
+#include <folly/portability/SysMman.h>
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE) && defined(MREMAP_FIXED)
+#include <link.h>
+#define FOLLY_HUGEPAGE_TEXT 1
+#else
+#define FOLLY_HUGEPAGE_TEXT 0
+#endif
+
+#if FOLLY_HUGEPAGE_TEXT
+// Defined by BOLT's -hot-text around the hot functions, which it groups
+extern "C" {
+extern char __hot_start __attribute__((__weak__));
+extern char __hot_end __attribute__((__weak__));
+}
+#endif
+
+namespace folly {
+
+#if FOLLY_HUGEPAGE_TEXT
+
+namespace {
+
+constexpr uintptr_t kHugePageSize = uintptr_t(2) << 20;
+
+uintptr_t alignDown(uintptr_t p) {
+  return p & ~(kHugePageSize - 1);
+}
+
+uintptr_t alignUp(uintptr_t p) {
+  return alignDown(p + kHugePageSize - 1);
+}
+
+struct TextRange {
+  uintptr_t begin{0};
+  uintptr_t end{0};
+};
+
+int findTextSegment(dl_phdr_info* info, size_t /* size */, void* data) {
+  // The main executable is always listed first
+  auto& range = *static_cast<TextRange*>(data);
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    auto& phdr = info->dlpi_phdr[i];
+    if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X)) {
+      range.begin = info->dlpi_addr + phdr.p_vaddr;
+      range.end = range.begin + phdr.p_memsz;
+      break;
+    }
+  }
+  return 1;
+}
+
+// Returns the AnonHugePages of the mapping starting at begin, from
+// /proc/self/smaps
+size_t getAnonHugePageBytes(uintptr_t begin) {
+  std::string smaps;
+  if (!readFile("/proc/self/smaps", smaps)) {
+    return 0;
+  }
+  // Addresses are zero-padded to at least 8 digits
+  auto header = sformat("{:08x}-", begin);
+  std::vector<StringPiece> lines;
+  split('\n', smaps, lines);
+  bool found = false;
+  for (auto line : lines) {
+    if (!found) {
+      found = line.startsWith(header);
+    } else if (line.empty() || !std::isupper(line[0])) {
+      // The header of the next mapping
+      break;
+    } else if (line.removePrefix("AnonHugePages:")) {
+      auto kb = tryTo<size_t>(trimWhitespace(line).split_step(' '));
+      return kb.hasValue() ? *kb * 1024 : 0;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+HugePageTextRemap remapTextOnHugePages() {
+  TextRange text;
+  dl_iterate_phdr(findTextSegment, &text);
+  if (&__hot_start != nullptr && &__hot_end != nullptr) {
+    auto hotBegin = reinterpret_cast<uintptr_t>(&__hot_start);
+    auto hotEnd = reinterpret_cast<uintptr_t>(&__hot_end);
+    if (hotBegin >= text.begin && hotEnd <= text.end) {
+      // Widened to whole huge pages, but not past the text segment
+      text.begin = std::max(alignDown(hotBegin), alignUp(text.begin));
+      text.end = std::min(alignUp(hotEnd), alignDown(text.end));
+    }
+  }
+
+  HugePageTextRemap result;
+  auto begin = alignUp(text.begin);
+  auto end = alignDown(text.end);
+  if (end <= begin) {
+    VLOG(1) << "Text too small to be remapped onto huge pages";
+    return result;
+  }
+  size_t len = end - begin;
+
+  // An aligned scratch mapping can be backed by huge pages, and keeps them
+  // when moved to another aligned address
+  auto raw = mmap(
+      nullptr,
+      len + kHugePageSize,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (raw == MAP_FAILED) {
+    PLOG(WARNING) << "mmap failed, text not remapped onto huge pages";
+    return result;
+  }
+  auto rawBegin = reinterpret_cast<uintptr_t>(raw);
+  auto scratch = alignUp(rawBegin);
+  if (scratch != rawBegin) {
+    munmap(raw, scratch - rawBegin);
+  }
+  munmap(
+      reinterpret_cast<void*>(scratch + len),
+      rawBegin + kHugePageSize - scratch);
+  auto scratchPtr = reinterpret_cast<void*>(scratch);
+
+  if (madvise(scratchPtr, len, MADV_HUGEPAGE) != 0) {
+    PLOG(WARNING) << "madvise failed, text not remapped onto huge pages";
+    munmap(scratchPtr, len);
+    return result;
+  }
+  std::memcpy(scratchPtr, reinterpret_cast<void*>(begin), len);
+  if (mprotect(scratchPtr, len, PROT_READ | PROT_EXEC) != 0 ||
+      mremap(
+          scratchPtr,
+          len,
+          len,
+          MREMAP_MAYMOVE | MREMAP_FIXED,
+          reinterpret_cast<void*>(begin)) == MAP_FAILED) {
+    PLOG(WARNING) << "Text not remapped onto huge pages";
+    munmap(scratchPtr, len);
+    return result;
+  }
+
+  result.begin = begin;
+  result.end = end;
+  result.hugePageBytes = getAnonHugePageBytes(begin);
+  return result;
+}
+
+#else
+
+HugePageTextRemap remapTextOnHugePages() {
+  return {};
+}
+
+#endif
+
+} // namespace folly
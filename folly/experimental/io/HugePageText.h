@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace folly {
+
+/**
+ * Result of remapTextOnHugePages().
+ */
+struct HugePageTextRemap {
+  // The remapped range of code, empty if nothing was remapped
+  uintptr_t begin{0};
+  uintptr_t end{0};
+  // How much of the range the kernel backed with huge pages
+  size_t hugePageBytes{0};
+
+  size_t size() const {
+    return end - begin;
+  }
+};
+
+/**
+ * Moves the code of the main executable onto transparent huge pages, to cut
+ * the iTLB misses of large binaries: 2MB pages cover 512 times more code per
+ * iTLB entry than 4KB pages.
+ *
+ * The 2MB-aligned part of the executable segment is copied into an
+ * anonymous mapping advised with MADV_HUGEPAGE, which then replaces the
+ * original mapping with a single mremap(). The copy has the same contents,
+ * so threads running the code are unaffected. If the binary was linked with
+ * hot text markers (BOLT's -hot-text defines __hot_start and __hot_end),
+ * only the hot code is remapped.
+ *
+ * Best called once, early at startup; folly::init() calls it when
+ * --folly_hugepage_text is set. Measure the effect with e.g.
+ * `perf stat -e iTLB-load-misses`. The remapped code is anonymous memory:
+ * it isn't shared with other processes running the same binary, and tools
+ * that read code through file mappings, such as uprobes and the USDT probes
+ * of FOLLY_SDT, no longer see it.
+ *
+ * Returns an empty range if nothing was remapped: on platforms other than
+ * Linux, if the code is smaller than a huge page, or if a system call
+ * failed, in which case the original mapping is left in place. Never
+ * throws.
+ */
+HugePageTextRemap remapTextOnHugePages();
+
+} // namespace folly
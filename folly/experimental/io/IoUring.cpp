@@ -117,6 +117,7 @@ void IoUringOp::reset(NotificationCallback cb) {
   cb_ = std::move(cb);
   state_ = State::UNINITIALIZED;
   result_ = -EINVAL;
+  linked_ = false;
 }
 
 IoUringOp::~IoUringOp() {}
@@ -149,6 +150,18 @@ void IoUringOp::pwritev(int fd, const iovec* iov, int iovcnt, off_t start) {
   io_uring_sqe_set_data(&sqe_, this);
 }
 
+void IoUringOp::fsync(int fd) {
+  init();
+  io_uring_prep_fsync(&sqe_, fd, 0);
+  io_uring_sqe_set_data(&sqe_, this);
+}
+
+void IoUringOp::fdatasync(int fd) {
+  init();
+  io_uring_prep_fsync(&sqe_, fd, IORING_FSYNC_DATASYNC);
+  io_uring_sqe_set_data(&sqe_, this);
+}
+
 void IoUringOp::toStream(std::ostream& os) const {
   os << "{" << state_ << ", ";
 
@@ -218,6 +231,42 @@ void IoUring::initializeContext() {
   }
 }
 
+void IoUring::registerFiles(Range<const int*> fds) {
+  initializeContext();
+  CHECK_EQ(pending_, 0);
+  SharedMutex::WriteHolder lk(submitMutex_);
+  if (!fixedFiles_.empty()) {
+    CHECK_ERR(io_uring_unregister_files(&ioRing_));
+    fixedFiles_.clear();
+  }
+  if (fds.empty()) {
+    return;
+  }
+  int rc = io_uring_register_files(&ioRing_, fds.data(), unsigned(fds.size()));
+  checkKernelError(rc, "IoUring: io_uring_register_files failed");
+  for (size_t i = 0; i < fds.size(); ++i) {
+    fixedFiles_.emplace(fds[i], int(i));
+  }
+}
+
+void IoUring::unregisterFiles() {
+  registerFiles(Range<const int*>());
+}
+
+void IoUring::prepSqe(struct io_uring_sqe* sqe, const IoUringOp* op) const {
+  *sqe = op->getSqe();
+  if (!fixedFiles_.empty()) {
+    auto it = fixedFiles_.find(sqe->fd);
+    if (it != fixedFiles_.end()) {
+      sqe->fd = it->second;
+      sqe->flags |= IOSQE_FIXED_FILE;
+    }
+  }
+  if (op->isLinked()) {
+    sqe->flags |= IOSQE_IO_LINK;
+  }
+}
+
 int IoUring::submitOne(AsyncBase::Op* op) {
   // -1 return here will trigger throw if op isn't an IoUringOp
   IoUringOp* iop = op->getIoUringOp();
@@ -232,7 +281,34 @@ int IoUring::submitOne(AsyncBase::Op* op) {
     return -1;
   }
 
-  *sqe = iop->getSqe();
+  prepSqe(sqe, iop);
+  // a link only spans a batch
+  sqe->flags &= ~IOSQE_IO_LINK;
+
+  return io_uring_submit(&ioRing_);
+}
+
+int IoUring::submitRange(Range<AsyncBase::Op**> ops) {
+  SharedMutex::WriteHolder lk(submitMutex_);
+  struct io_uring_sqe* last = nullptr;
+  for (auto* op : ops) {
+    IoUringOp* iop = op->getIoUringOp();
+    if (!iop) {
+      break;
+    }
+    // the batch is limited by the submission queue, i.e. maxSubmit
+    auto* sqe = io_uring_get_sqe(&ioRing_);
+    if (!sqe) {
+      break;
+    }
+    prepSqe(sqe, iop);
+    last = sqe;
+  }
+  if (!last) {
+    return -1;
+  }
+  // don't link to whatever is submitted next
+  last->flags &= ~IOSQE_IO_LINK;
 
   return io_uring_submit(&ioRing_);
 }
@@ -21,6 +21,7 @@ extern "C" {
 }
 
 #include <folly/SharedMutex.h>
+#include <folly/container/F14Map.h>
 #include <folly/experimental/io/AsyncBase.h>
 
 namespace folly {
@@ -53,6 +54,25 @@ class IoUringOp : public AsyncBaseOp {
   void pwrite(int fd, const void* buf, size_t size, off_t start) override;
   void pwritev(int fd, const iovec* iov, int iovcnt, off_t start) override;
 
+  /**
+   * Initiate a flush request.
+   */
+  void fsync(int fd) override;
+  void fdatasync(int fd) override;
+
+  /**
+   * Make the next op of the same submit() batch start only once this one
+   * has completed successfully (IOSQE_IO_LINK); if it fails, the rest of
+   * the chain completes with -ECANCELED. Call after initiating the request.
+   */
+  void setLinked(bool linked) {
+    linked_ = linked;
+  }
+
+  bool isLinked() const {
+    return linked_;
+  }
+
   void reset(NotificationCallback cb = NotificationCallback()) override;
 
   AsyncIOOp* getAsyncIOOp() override {
@@ -72,6 +92,7 @@ class IoUringOp : public AsyncBaseOp {
  private:
   struct io_uring_sqe sqe_;
   struct iovec iov_[1];
+  bool linked_{false};
 };
 
 std::ostream& operator<<(std::ostream& stream, const IoUringOp& op);
@@ -96,11 +117,30 @@ class IoUring : public AsyncBase {
   IoUring& operator=(const IoUring&) = delete;
   ~IoUring() override;
 
+  std::unique_ptr<AsyncBase::Op> createOp() const override {
+    return std::make_unique<Op>();
+  }
+
   static bool isAvailable();
 
+  /**
+   * Register files with the ring, so that ops on them do not have to look
+   * the file up and take a reference to it (IOSQE_FIXED_FILE). Ops on these
+   * fds use the registered files without any change on the caller's side.
+   * Replaces the previous registration; no ops may be pending.
+   */
+  void registerFiles(Range<const int*> fds);
+  void unregisterFiles();
+
+  size_t numRegisteredFiles() const {
+    return fixedFiles_.size();
+  }
+
  private:
   void initializeContext() override;
   int submitOne(AsyncBase::Op* op) override;
+  int submitRange(Range<AsyncBase::Op**> ops) override;
+  void prepSqe(struct io_uring_sqe* sqe, const IoUringOp* op) const;
 
   Range<AsyncBase::Op**> doWait(
       WaitType type,
@@ -112,6 +152,8 @@ class IoUring : public AsyncBase {
   struct io_uring_params params_;
   struct io_uring ioRing_;
   SharedMutex submitMutex_;
+  // fd -> index in the registered files table
+  F14FastMap<int, int> fixedFiles_;
 };
 
 using IoUringQueue = AsyncBaseQueue;
@@ -14,22 +14,186 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include <folly/experimental/io/IoUringBackend.h>
 #include <folly/Likely.h>
+#include <folly/Memory.h>
 #include <folly/String.h>
 #include <folly/portability/Sockets.h>
 #include <folly/synchronization/CallOnce.h>
 
 #include <glog/logging.h>
 
+// multishot support is newer than some of the kernel headers we build with;
+// older kernels fail such ops with -EINVAL
+#ifndef IORING_CQE_F_MORE
+#define IORING_CQE_F_MORE (1U << 1)
+#endif
+#ifndef IORING_POLL_ADD_MULTI
+#define IORING_POLL_ADD_MULTI (1U << 0)
+#endif
+#ifndef IORING_RECV_MULTISHOT
+#define IORING_RECV_MULTISHOT (1U << 1)
+#endif
+#ifndef IORING_ACCEPT_MULTISHOT
+#define IORING_ACCEPT_MULTISHOT (1U << 0)
+#endif
+#ifndef IORING_SETUP_COOP_TASKRUN
+#define IORING_SETUP_COOP_TASKRUN (1U << 8)
+#endif
+
 namespace folly {
+IoUringBackend::BufferPool::BufferPool(
+    uint16_t groupId,
+    size_t numBuffers,
+    size_t bufferSize)
+    : groupId_(groupId),
+      numBuffers_(numBuffers),
+      bufferSize_(bufferSize),
+      returnedNext_(new int32_t[numBuffers]) {
+  base_ = static_cast<uint8_t*>(
+      folly::aligned_malloc(numBuffers_ * bufferSize_, 4096));
+  if (!base_) {
+    throw std::bad_alloc();
+  }
+}
+
+IoUringBackend::BufferPool::~BufferPool() {
+  folly::aligned_free(base_);
+}
+
+std::unique_ptr<IOBuf> IoUringBackend::BufferPool::wrapBuffer(
+    uint16_t bid,
+    size_t len) {
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  return IOBuf::takeOwnership(
+      getBuffer(bid), bufferSize_, len, &BufferPool::freeFn, this);
+}
+
+std::unique_ptr<IOBuf> IoUringBackend::BufferPool::takeBuffer(
+    int res,
+    uint32_t cqeFlags) {
+  if (!(cqeFlags & IORING_CQE_F_BUFFER)) {
+    return nullptr;
+  }
+
+  auto bid = static_cast<uint16_t>(cqeFlags >> IORING_CQE_BUFFER_SHIFT);
+  removeProvided();
+  if (res > 0) {
+    return wrapBuffer(bid, static_cast<size_t>(res));
+  }
+
+  returnBuffer(bid);
+  return nullptr;
+}
+
+void IoUringBackend::BufferPool::returnBuffer(uint16_t bid) noexcept {
+  auto head = returnedHead_.load(std::memory_order_relaxed);
+  do {
+    returnedNext_[bid] = head;
+  } while (!returnedHead_.compare_exchange_weak(
+      head,
+      static_cast<int32_t>(bid),
+      std::memory_order_release,
+      std::memory_order_relaxed));
+}
+
+void IoUringBackend::BufferPool::drainReturned(std::vector<uint16_t>& bids) {
+  bids.clear();
+  auto head = returnedHead_.exchange(-1, std::memory_order_acquire);
+  while (head >= 0) {
+    bids.push_back(static_cast<uint16_t>(head));
+    head = returnedNext_[head];
+  }
+  std::sort(bids.begin(), bids.end());
+}
+
+void IoUringBackend::BufferPool::detach() noexcept {
+  detached_.store(true, std::memory_order_release);
+}
+
+void IoUringBackend::BufferPool::release() noexcept {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+void IoUringBackend::BufferPool::freeFn(void* buf, void* userData) noexcept {
+  auto* pool = static_cast<BufferPool*>(userData);
+  if (!pool->detached_.load(std::memory_order_acquire)) {
+    auto offset = static_cast<uint8_t*>(buf) - pool->base_;
+    pool->returnBuffer(static_cast<uint16_t>(offset / pool->bufferSize_));
+  }
+  pool->release();
+}
+
+void IoUringBackend::RecvPooledSqe::processActive() {
+  bufCb_(res_, pool_->takeBuffer(res_, cqeFlags_));
+}
+
+void IoUringBackend::MultishotSqe::addCompletion(int res, uint32_t flags) {
+  results_.emplace_back(res, flags);
+  if (!(flags & IORING_CQE_F_MORE)) {
+    completed_ = true;
+  }
+}
+
+void IoUringBackend::MultishotSqe::processActive() {
+  // the callbacks can see more results being queued
+  pending_.swap(results_);
+  for (const auto& result : pending_) {
+    processResult(
+        result.first, result.second, (result.second & IORING_CQE_F_MORE));
+  }
+  pending_.clear();
+}
+
+void IoUringBackend::PollMultishotSqe::prepOp(struct io_uring_sqe* sqe) {
+  ::io_uring_prep_poll_add(sqe, fd_, events_);
+  sqe->len |= IORING_POLL_ADD_MULTI;
+}
+
+void IoUringBackend::AcceptMultishotSqe::prepOp(struct io_uring_sqe* sqe) {
+  ::io_uring_prep_accept(sqe, fd_, nullptr, nullptr, flags_);
+  sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+}
+
+void IoUringBackend::RecvMultishotSqe::prepOp(struct io_uring_sqe* sqe) {
+  // the length comes from the selected buffer
+  ::io_uring_prep_recv(sqe, fd_, nullptr, 0, flags_);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = pool_->getGroupId();
+  sqe->ioprio |= IORING_RECV_MULTISHOT;
+}
+
 IoUringBackend::IoUringBackend(size_t capacity, size_t maxSubmit, size_t maxGet)
-    : PollIoBackend(capacity, maxSubmit, maxGet) {
+    : IoUringBackend(Options()
+                         .setCapacity(capacity)
+                         .setMaxSubmit(maxSubmit)
+                         .setMaxGet(maxGet)) {}
+
+IoUringBackend::IoUringBackend(Options options)
+    : PollIoBackend(options.capacity, options.maxSubmit, options.maxGet),
+      options_(options) {
   ::memset(&ioRing_, 0, sizeof(ioRing_));
   ::memset(&params_, 0, sizeof(params_));
 
   params_.flags |= IORING_SETUP_CQSIZE;
-  params_.cq_entries = capacity;
+  params_.cq_entries = options.capacity;
+
+  if (options.useSQPoll) {
+    params_.flags |= IORING_SETUP_SQPOLL;
+    params_.sq_thread_idle = static_cast<uint32_t>(options.sqIdle.count());
+    if (options.sqCpu >= 0) {
+      params_.flags |= IORING_SETUP_SQ_AFF;
+      params_.sq_thread_cpu = static_cast<uint32_t>(options.sqCpu);
+    }
+  } else if (options.coopTaskRun) {
+    // the kernel rejects it along with SQPOLL
+    params_.flags |= IORING_SETUP_COOP_TASKRUN;
+  }
 
   // allocate entries both for poll add and cancel
   if (::io_uring_queue_init_params(2 * maxSubmit_, &ioRing_, &params_)) {
@@ -65,12 +229,23 @@ IoUringBackend::IoUringBackend(size_t capacity, size_t maxSubmit, size_t maxGet)
     entries_.reset();
     throw std::runtime_error("io_uring_submit error");
   }
+
+  // the held back SQEs must fit in the ring next to a full submitList()
+  submitBatchThreshold_ =
+      std::max<size_t>(1, std::min(options.submitBatchThreshold, maxSubmit_));
 }
 
 IoUringBackend::~IoUringBackend() {
   shuttingDown_ = true;
 
   cleanup();
+
+  // the ring is gone, the kernel does not reference the buffers anymore
+  if (bufferPool_) {
+    bufferPool_->detach();
+    bufferPool_->release();
+    bufferPool_ = nullptr;
+  }
 }
 
 void IoUringBackend::cleanup() {
@@ -100,7 +275,7 @@ void* IoUringBackend::allocSubmissionEntry() {
 }
 
 int IoUringBackend::submitOne(IoCb* /*unused*/) {
-  return submitBusyCheck();
+  return submitOrDefer();
 }
 
 int IoUringBackend::cancelOne(IoCb* ioCb) {
@@ -114,7 +289,7 @@ int IoUringBackend::cancelOne(IoCb* ioCb) {
 
   rentry->prepPollRemove(sqe, ioCb); // prev entry
 
-  int ret = submitBusyCheck();
+  int ret = submitOrDefer();
 
   if (ret < 0) {
     // release the sqe
@@ -124,6 +299,176 @@ int IoUringBackend::cancelOne(IoCb* ioCb) {
   return ret;
 }
 
+void* IoUringBackend::eb_queue_recv(
+    int fd,
+    void* buf,
+    size_t len,
+    int flags,
+    IoCompletionCallback&& cb) {
+  auto* op = new RecvSqe(this, fd, buf, len, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_sendmsg(
+    int fd,
+    const struct iovec* iov,
+    size_t iovCount,
+    int flags,
+    IoCompletionCallback&& cb) {
+  auto* op = new SendmsgSqe(this, fd, iov, iovCount, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_splice(
+    int fdIn,
+    int64_t offIn,
+    int fdOut,
+    int64_t offOut,
+    size_t len,
+    unsigned int flags,
+    IoCompletionCallback&& cb) {
+  auto* op = new SpliceSqe(
+      this, fdIn, offIn, fdOut, offOut, len, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_recv_pooled(
+    int fd,
+    int flags,
+    IoBufCompletionCallback&& cb) {
+  if (!bufferPool_ || bufferPoolFailed_) {
+    return nullptr;
+  }
+
+  auto* op = new RecvPooledSqe(this, bufferPool_, fd, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_poll_multishot(
+    int fd,
+    uint32_t events,
+    MultishotCompletionCallback&& cb) {
+  auto* op = new PollMultishotSqe(this, fd, events, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_accept_multishot(
+    int fd,
+    int flags,
+    MultishotCompletionCallback&& cb) {
+  auto* op = new AcceptMultishotSqe(this, fd, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+void* IoUringBackend::eb_queue_recv_multishot(
+    int fd,
+    int flags,
+    MultishotIoBufCompletionCallback&& cb) {
+  if (!bufferPool_ || bufferPoolFailed_) {
+    return nullptr;
+  }
+
+  auto* op =
+      new RecvMultishotSqe(this, bufferPool_, fd, flags, std::move(cb));
+  queueOp(op);
+  return op;
+}
+
+bool IoUringBackend::setupBufferPool(size_t numBuffers, size_t bufferSize) {
+  // buffer ids are 16 bit
+  if (bufferPool_ || !numBuffers || !bufferSize ||
+      numBuffers > std::numeric_limits<uint16_t>::max() + size_t(1) ||
+      bufferSize > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    return false;
+  }
+
+  bufferPool_ = new BufferPool(0, numBuffers, bufferSize);
+  // provide them in chunks, the op takes a 16 bit count
+  size_t bid = 0;
+  while (bid < numBuffers) {
+    auto num = std::min<size_t>(
+        numBuffers - bid, std::numeric_limits<uint16_t>::max());
+    provideBuffers(static_cast<uint16_t>(bid), static_cast<uint16_t>(num));
+    bid += num;
+  }
+
+  return true;
+}
+
+void IoUringBackend::provideBuffers(uint16_t bid, uint16_t num) {
+  auto* op = new ProvideBuffersSqe(
+      this, bufferPool_, bid, num, [this, num](int res) {
+        if (res < 0) {
+          // most likely a kernel without IORING_OP_PROVIDE_BUFFERS
+          LOG_IF(ERROR, !bufferPoolFailed_)
+              << "IORING_OP_PROVIDE_BUFFERS failed, res = " << res << ":\""
+              << folly::errnoStr(-res) << "\" " << this;
+          bufferPoolFailed_ = true;
+        } else {
+          bufferPool_->addProvided(num);
+        }
+      });
+  queueOp(op);
+}
+
+void IoUringBackend::replenishBufferPool() {
+  bufferPool_->drainReturned(returnedBids_);
+  if (returnedBids_.empty() || bufferPoolFailed_) {
+    return;
+  }
+
+  // each run of consecutive ids goes back with a single op
+  size_t start = 0;
+  for (size_t i = 1; i <= returnedBids_.size(); ++i) {
+    if (i == returnedBids_.size() ||
+        returnedBids_[i] != returnedBids_[i - 1] + 1) {
+      provideBuffers(returnedBids_[start], static_cast<uint16_t>(i - start));
+      start = i;
+    }
+  }
+}
+
+int IoUringBackend::eb_cancel_op(void* op) {
+  auto* ioCb = static_cast<IoOpSqe*>(op);
+  if (ioCb->completed_) {
+    // the callback will run during this loop iteration
+    return 0;
+  }
+
+  if (!ioCb->submitted_) {
+    // still on the submit list - the kernel never saw it
+    ioCb->unlink();
+    ioCb->addCompletion(-ECANCELED, 0);
+    processIoCb(ioCb, -ECANCELED);
+    return 0;
+  }
+
+  auto* rentry = static_cast<IoSqe*>(allocIoCb());
+  if (!rentry) {
+    return -1;
+  }
+
+  auto* sqe = ::io_uring_get_sqe(&ioRing_);
+  CHECK(sqe);
+
+  rentry->prepCancel(sqe, ioCb);
+
+  int ret = submitOrDefer();
+
+  if (ret < 0) {
+    releaseIoCb(rentry);
+    return ret;
+  }
+
+  return 0;
+}
+
 int IoUringBackend::getActiveEvents(bool waitForEvents) {
   size_t i = 0;
   struct io_uring_cqe* cqe = nullptr;
@@ -139,6 +484,9 @@ int IoUringBackend::getActiveEvents(bool waitForEvents) {
     if (FOLLY_UNLIKELY(static_cast<PollIoBackend::IoCb*>(sqe) == timerEntry_)) {
       // just set the flag here
       processTimers_ = true;
+    } else if (!sqe->isPollEntry()) {
+      static_cast<IoOpSqe*>(sqe)->addCompletion(cqe->res, cqe->flags);
+      processIoCb(sqe, cqe->res);
     } else {
       processIoCb(sqe, cqe->res);
     }
@@ -147,48 +495,88 @@ int IoUringBackend::getActiveEvents(bool waitForEvents) {
     ::io_uring_peek_cqe(&ioRing_, &cqe);
   }
 
+  stats_.numGetActiveEvents++;
+  stats_.numCompletions += i;
+  stats_.lastCompletions = i;
+  stats_.maxCompletions = std::max<uint64_t>(stats_.maxCompletions, i);
+  stats_.numCqOverflows = *ioRing_.cq.koverflow;
+
   return static_cast<int>(i);
 }
 
 int IoUringBackend::submitBusyCheck() {
   int num;
+  stats_.numSubmits++;
   while ((num = ::io_uring_submit(&ioRing_)) == -EBUSY) {
+    stats_.numSubmitsBusy++;
     // if we get EBUSY, try to consume some CQ entries
     getActiveEvents(false);
   };
+  if (num > 0) {
+    stats_.numSubmittedSqes += num;
+  }
   return num;
 }
 
 int IoUringBackend::submitBusyCheckAndWait() {
   int num;
+  stats_.numSubmits++;
   while ((num = ::io_uring_submit_and_wait(&ioRing_, 1)) == -EBUSY) {
+    stats_.numSubmitsBusy++;
     // if we get EBUSY, try to consume some CQ entries
     getActiveEvents(false);
   };
+  if (num > 0) {
+    stats_.numSubmittedSqes += num;
+  }
   return num;
 }
 
+int IoUringBackend::submitOrDefer() {
+  if (++numPendingSubmit_ < submitBatchThreshold_) {
+    return 1;
+  }
+
+  numPendingSubmit_ = 0;
+  int num = submitBusyCheck();
+  return (num < 0) ? num : 1;
+}
+
 size_t IoUringBackend::submitList(IoCbList& ioCbs) {
   int i = 0;
   size_t ret = 0;
 
+  // hand the buffers freed since the last iteration back to the kernel
+  if (bufferPool_) {
+    replenishBufferPool();
+  }
+
+  // the held back SQEs go out with the first submit
+  if (ioCbs.empty() && numPendingSubmit_) {
+    numPendingSubmit_ = 0;
+    submitBusyCheck();
+  }
+
   while (!ioCbs.empty()) {
     auto* entry = &ioCbs.front();
     ioCbs.pop_front();
     auto* sqe = ::io_uring_get_sqe(&ioRing_);
     CHECK(sqe); // this should not happen
 
-    auto* ev = entry->event_->getEvent();
-    entry->prepPollAdd(sqe, ev->ev_fd, getPollFlags(ev->ev_events));
+    entry->processSubmit(sqe);
     i++;
     if (ioCbs.empty()) {
-      int num = submitBusyCheckAndWait();
-      CHECK_EQ(num, i);
+      // do not wait if there are already completions to process
+      int num = activeEvents_.empty() ? submitBusyCheckAndWait()
+                                      : submitBusyCheck();
+      CHECK_EQ(num, i + static_cast<int>(numPendingSubmit_));
+      numPendingSubmit_ = 0;
       ret += i;
     } else {
       if (static_cast<size_t>(i) == maxSubmit_) {
         int num = submitBusyCheck();
-        CHECK_EQ(num, i);
+        CHECK_EQ(num, i + static_cast<int>(numPendingSubmit_));
+        numPendingSubmit_ = 0;
         ret += i;
         i = 0;
       }
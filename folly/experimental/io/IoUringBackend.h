@@ -20,23 +20,170 @@ extern "C" {
 #include <liburing.h>
 }
 
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 #include <folly/experimental/io/PollIoBackend.h>
+#include <folly/io/IOBuf.h>
 #include <glog/logging.h>
 
 namespace folly {
 
 class IoUringBackend : public PollIoBackend {
  public:
+  struct Options {
+    Options() = default;
+
+    Options& setCapacity(size_t v) {
+      capacity = v;
+      return *this;
+    }
+
+    Options& setMaxSubmit(size_t v) {
+      maxSubmit = v;
+      return *this;
+    }
+
+    Options& setMaxGet(size_t v) {
+      maxGet = v;
+      return *this;
+    }
+
+    // Have a kernel thread poll the submission queue, so submitting does not
+    // need a syscall while the thread is awake. It goes to sleep after being
+    // idle for sqIdle, and is bound to sqCpu if that is not negative.
+    // Older kernels only allow this for privileged processes.
+    Options& setUseSQPoll(bool v) {
+      useSQPoll = v;
+      return *this;
+    }
+
+    Options& setSQIdle(std::chrono::milliseconds v) {
+      sqIdle = v;
+      return *this;
+    }
+
+    Options& setSQCpu(int v) {
+      sqCpu = v;
+      return *this;
+    }
+
+    // Run completion work when the loop enters the kernel instead of
+    // interrupting it (IORING_SETUP_COOP_TASKRUN). Not used with SQ polling.
+    Options& setCoopTaskRun(bool v) {
+      coopTaskRun = v;
+      return *this;
+    }
+
+    // SQEs prepared outside of the loop's submit pass (event removals,
+    // cancellations, ...) are normally submitted right away. With a threshold
+    // greater than 1 they are held back until that many are pending or the
+    // loop submits. Capped at maxSubmit.
+    Options& setSubmitBatchThreshold(size_t v) {
+      submitBatchThreshold = v;
+      return *this;
+    }
+
+    size_t capacity{0};
+    size_t maxSubmit{128};
+    size_t maxGet{static_cast<size_t>(-1)};
+    bool useSQPoll{false};
+    std::chrono::milliseconds sqIdle{0};
+    int sqCpu{-1};
+    bool coopTaskRun{false};
+    size_t submitBatchThreshold{1};
+  };
+
+  struct Stats {
+    // calls to io_uring_submit*()
+    uint64_t numSubmits{0};
+    // of which got EBUSY back because the completion queue was full
+    uint64_t numSubmitsBusy{0};
+    uint64_t numSubmittedSqes{0};
+    uint64_t numGetActiveEvents{0};
+    uint64_t numCompletions{0};
+    // completions reaped by the last getActiveEvents() call, and the most
+    // seen so far
+    uint64_t lastCompletions{0};
+    uint64_t maxCompletions{0};
+    // completions the kernel could not post to a full completion queue
+    uint64_t numCqOverflows{0};
+  };
+
+  explicit IoUringBackend(Options options);
   explicit IoUringBackend(
       size_t capacity,
       size_t maxSubmit = 128,
       size_t maxGet = static_cast<size_t>(-1));
   ~IoUringBackend() override;
 
+  const Options& getOptions() const {
+    return options_;
+  }
+
+  const Stats& getStats() const {
+    return stats_;
+  }
+
   // returns true if the current Linux kernel version
   // supports the io_uring backend
   static bool isAvailable();
 
+  // from EventBaseBackendBase
+  bool eb_async_io_supported() const override {
+    return true;
+  }
+
+  void* eb_queue_recv(
+      int fd,
+      void* buf,
+      size_t len,
+      int flags,
+      IoCompletionCallback&& cb) override;
+  void* eb_queue_sendmsg(
+      int fd,
+      const struct iovec* iov,
+      size_t iovCount,
+      int flags,
+      IoCompletionCallback&& cb) override;
+  void* eb_queue_splice(
+      int fdIn,
+      int64_t offIn,
+      int fdOut,
+      int64_t offOut,
+      size_t len,
+      unsigned int flags,
+      IoCompletionCallback&& cb) override;
+  void* eb_queue_recv_pooled(
+      int fd,
+      int flags,
+      IoBufCompletionCallback&& cb) override;
+  void* eb_queue_poll_multishot(
+      int fd,
+      uint32_t events,
+      MultishotCompletionCallback&& cb) override;
+  void* eb_queue_accept_multishot(
+      int fd,
+      int flags,
+      MultishotCompletionCallback&& cb) override;
+  void* eb_queue_recv_multishot(
+      int fd,
+      int flags,
+      MultishotIoBufCompletionCallback&& cb) override;
+  int eb_cancel_op(void* op) override;
+
+  // Sets up a pool of numBuffers buffers of bufferSize bytes each that the
+  // kernel picks from when a pooled recv completes (provided buffers, see
+  // IORING_OP_PROVIDE_BUFFERS). Completed reads are handed out as IOBufs
+  // that put their buffer back into the pool when freed, from any thread.
+  // Returns false if a pool was already set up or the arguments are invalid.
+  bool setupBufferPool(size_t numBuffers, size_t bufferSize);
+
+  size_t getBufferPoolAvailable() const {
+    return bufferPool_ ? bufferPool_->getNumProvided() : 0;
+  }
+
  protected:
   // from PollIoBackend
   void* allocSubmissionEntry() override;
@@ -47,6 +194,8 @@ class IoUringBackend : public PollIoBackend {
 
   int submitBusyCheck();
   int submitBusyCheckAndWait();
+  // submits now, or later if below the batch threshold; returns 1 or -errno
+  int submitOrDefer();
 
   struct IoSqe : public PollIoBackend::IoCb {
     explicit IoSqe(PollIoBackend* backend = nullptr, bool poolAlloc = true)
@@ -67,8 +216,357 @@ class IoUringBackend : public PollIoBackend {
       ::io_uring_prep_poll_remove(sqe, user_data);
       ::io_uring_sqe_set_data(sqe, this);
     }
+
+    FOLLY_ALWAYS_INLINE void prepCancel(
+        struct io_uring_sqe* sqe,
+        void* user_data) {
+      CHECK(sqe);
+      ::io_uring_prep_cancel(sqe, user_data, 0);
+      ::io_uring_sqe_set_data(sqe, this);
+    }
+  };
+
+  // base for the completion-based ops - these are always heap allocated
+  // and deleted by releaseIoCb() after the callback runs
+  struct IoOpSqe : public IoSqe {
+    IoOpSqe(PollIoBackend* backend, IoCompletionCallback&& cb)
+        : IoSqe(backend, false), cb_(std::move(cb)) {}
+    ~IoOpSqe() override = default;
+
+    void prepPollAdd(void* /*entry*/, int /*fd*/, uint32_t /*events*/)
+        override {
+      LOG(FATAL) << "prepPollAdd called on an op entry";
+    }
+
+    bool isPollEntry() const override {
+      return false;
+    }
+
+    void processSubmit(void* entry) override {
+      CHECK(entry);
+      struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(entry);
+      prepOp(sqe);
+      ::io_uring_sqe_set_data(sqe, this);
+      submitted_ = true;
+    }
+
+    void processActive() override {
+      cb_(res_);
+    }
+
+    // called for every CQE
+    virtual void addCompletion(int /*res*/, uint32_t flags) {
+      completed_ = true;
+      cqeFlags_ = flags;
+    }
+
+    virtual void prepOp(struct io_uring_sqe* sqe) = 0;
+
+    IoCompletionCallback cb_;
+    uint32_t cqeFlags_{0};
+    bool submitted_{false};
+    bool completed_{false};
+  };
+
+  struct RecvSqe : public IoOpSqe {
+    RecvSqe(
+        PollIoBackend* backend,
+        int fd,
+        void* buf,
+        size_t len,
+        int flags,
+        IoCompletionCallback&& cb)
+        : IoOpSqe(backend, std::move(cb)),
+          fd_(fd),
+          buf_(buf),
+          len_(len),
+          flags_(flags) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override {
+      ::io_uring_prep_recv(sqe, fd_, buf_, len_, flags_);
+    }
+
+    int fd_;
+    void* buf_;
+    size_t len_;
+    int flags_;
+  };
+
+  struct SendmsgSqe : public IoOpSqe {
+    SendmsgSqe(
+        PollIoBackend* backend,
+        int fd,
+        const struct iovec* iov,
+        size_t iovCount,
+        int flags,
+        IoCompletionCallback&& cb)
+        : IoOpSqe(backend, std::move(cb)),
+          fd_(fd),
+          flags_(flags),
+          iov_(iov, iov + iovCount) {
+      ::memset(&msg_, 0, sizeof(msg_));
+      msg_.msg_iov = iov_.data();
+      msg_.msg_iovlen = iov_.size();
+    }
+
+    void prepOp(struct io_uring_sqe* sqe) override {
+      ::io_uring_prep_sendmsg(sqe, fd_, &msg_, flags_);
+    }
+
+    int fd_;
+    int flags_;
+    std::vector<struct iovec> iov_;
+    struct msghdr msg_;
+  };
+
+  struct SpliceSqe : public IoOpSqe {
+    SpliceSqe(
+        PollIoBackend* backend,
+        int fdIn,
+        int64_t offIn,
+        int fdOut,
+        int64_t offOut,
+        size_t len,
+        unsigned int flags,
+        IoCompletionCallback&& cb)
+        : IoOpSqe(backend, std::move(cb)),
+          fdIn_(fdIn),
+          offIn_(offIn),
+          fdOut_(fdOut),
+          offOut_(offOut),
+          len_(len),
+          flags_(flags) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override {
+      ::io_uring_prep_splice(
+          sqe, fdIn_, offIn_, fdOut_, offOut_, unsigned(len_), flags_);
+    }
+
+    int fdIn_;
+    int64_t offIn_;
+    int fdOut_;
+    int64_t offOut_;
+    size_t len_;
+    unsigned int flags_;
+  };
+
+  // A multishot op posts a CQE per result and stays armed as long as the
+  // CQEs have IORING_CQE_F_MORE set. Results that arrive before the
+  // callback runs are queued up, the op is released after the last one.
+  struct MultishotSqe : public IoOpSqe {
+    explicit MultishotSqe(PollIoBackend* backend)
+        : IoOpSqe(backend, nullptr) {}
+
+    void addCompletion(int res, uint32_t flags) override;
+
+    bool isOpDone() const override {
+      return completed_ && results_.empty();
+    }
+
+    void processActive() override;
+
+    virtual void processResult(int res, uint32_t flags, bool more) = 0;
+
+    std::vector<std::pair<int, uint32_t>> results_;
+    std::vector<std::pair<int, uint32_t>> pending_;
+  };
+
+  struct PollMultishotSqe : public MultishotSqe {
+    PollMultishotSqe(
+        PollIoBackend* backend,
+        int fd,
+        uint32_t events,
+        MultishotCompletionCallback&& cb)
+        : MultishotSqe(backend),
+          fd_(fd),
+          events_(events),
+          multishotCb_(std::move(cb)) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override;
+
+    void processResult(int res, uint32_t /*flags*/, bool more) override {
+      multishotCb_(res, more);
+    }
+
+    int fd_;
+    uint32_t events_;
+    MultishotCompletionCallback multishotCb_;
+  };
+
+  struct AcceptMultishotSqe : public MultishotSqe {
+    AcceptMultishotSqe(
+        PollIoBackend* backend,
+        int fd,
+        int flags,
+        MultishotCompletionCallback&& cb)
+        : MultishotSqe(backend),
+          fd_(fd),
+          flags_(flags),
+          multishotCb_(std::move(cb)) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override;
+
+    void processResult(int res, uint32_t /*flags*/, bool more) override {
+      multishotCb_(res, more);
+    }
+
+    int fd_;
+    int flags_;
+    MultishotCompletionCallback multishotCb_;
+  };
+
+  // The buffer memory is shared by the ring and the IOBufs handed out, so it
+  // is refcounted and outlives the backend if IOBufs are still around.
+  class BufferPool {
+   public:
+    BufferPool(uint16_t groupId, size_t numBuffers, size_t bufferSize);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    uint16_t getGroupId() const {
+      return groupId_;
+    }
+
+    size_t getNumBuffers() const {
+      return numBuffers_;
+    }
+
+    size_t getBufferSize() const {
+      return bufferSize_;
+    }
+
+    uint8_t* getBuffer(uint16_t bid) const {
+      return base_ + static_cast<size_t>(bid) * bufferSize_;
+    }
+
+    // buffers currently owned by the kernel
+    size_t getNumProvided() const {
+      return numProvided_;
+    }
+
+    void addProvided(size_t num) {
+      numProvided_ += num;
+    }
+
+    void removeProvided() {
+      DCHECK_GT(numProvided_, 0);
+      --numProvided_;
+    }
+
+    std::unique_ptr<IOBuf> wrapBuffer(uint16_t bid, size_t len);
+
+    // returns the buffer the kernel picked for a completion with the given
+    // result and CQE flags, or nullptr if none was picked or it holds no data
+    std::unique_ptr<IOBuf> takeBuffer(int res, uint32_t cqeFlags);
+
+    // the kernel consumed the buffer without handing it out
+    void returnBuffer(uint16_t bid) noexcept;
+
+    // collects the returned buffer ids, sorted
+    void drainReturned(std::vector<uint16_t>& bids);
+
+    // the backend is going away - stop recycling buffers
+    void detach() noexcept;
+
+    void release() noexcept;
+
+   private:
+    static void freeFn(void* buf, void* userData) noexcept;
+
+    const uint16_t groupId_;
+    const size_t numBuffers_;
+    const size_t bufferSize_;
+    uint8_t* base_{nullptr};
+    size_t numProvided_{0};
+    std::atomic<bool> detached_{false};
+    std::atomic<size_t> refs_{1};
+    // lock free stack of returned buffer ids: producers push one at a time,
+    // the loop thread takes the whole list at once
+    std::atomic<int32_t> returnedHead_{-1};
+    std::unique_ptr<int32_t[]> returnedNext_;
+  };
+
+  struct ProvideBuffersSqe : public IoOpSqe {
+    ProvideBuffersSqe(
+        PollIoBackend* backend,
+        BufferPool* pool,
+        uint16_t bid,
+        uint16_t num,
+        IoCompletionCallback&& cb)
+        : IoOpSqe(backend, std::move(cb)), pool_(pool), bid_(bid), num_(num) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override {
+      ::io_uring_prep_provide_buffers(
+          sqe,
+          pool_->getBuffer(bid_),
+          static_cast<int>(pool_->getBufferSize()),
+          num_,
+          pool_->getGroupId(),
+          bid_);
+    }
+
+    BufferPool* pool_;
+    uint16_t bid_;
+    uint16_t num_;
   };
 
+  struct RecvPooledSqe : public IoOpSqe {
+    RecvPooledSqe(
+        PollIoBackend* backend,
+        BufferPool* pool,
+        int fd,
+        int flags,
+        IoBufCompletionCallback&& cb)
+        : IoOpSqe(backend, nullptr),
+          pool_(pool),
+          fd_(fd),
+          flags_(flags),
+          bufCb_(std::move(cb)) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override {
+      ::io_uring_prep_recv(sqe, fd_, nullptr, pool_->getBufferSize(), flags_);
+      sqe->flags |= IOSQE_BUFFER_SELECT;
+      sqe->buf_group = pool_->getGroupId();
+    }
+
+    void processActive() override;
+
+    BufferPool* pool_;
+    int fd_;
+    int flags_;
+    IoBufCompletionCallback bufCb_;
+  };
+
+  struct RecvMultishotSqe : public MultishotSqe {
+    RecvMultishotSqe(
+        PollIoBackend* backend,
+        BufferPool* pool,
+        int fd,
+        int flags,
+        MultishotIoBufCompletionCallback&& cb)
+        : MultishotSqe(backend),
+          pool_(pool),
+          fd_(fd),
+          flags_(flags),
+          bufCb_(std::move(cb)) {}
+
+    void prepOp(struct io_uring_sqe* sqe) override;
+
+    void processResult(int res, uint32_t flags, bool more) override {
+      bufCb_(res, pool_->takeBuffer(res, flags), more);
+    }
+
+    BufferPool* pool_;
+    int fd_;
+    int flags_;
+    MultishotIoBufCompletionCallback bufCb_;
+  };
+
+  void provideBuffers(uint16_t bid, uint16_t num);
+  void replenishBufferPool();
+
   PollIoBackend::IoCb* allocNewIoCb() override {
     return new IoSqe(this, false);
   }
@@ -77,6 +575,12 @@ class IoUringBackend : public PollIoBackend {
 
   size_t submit_internal();
 
+  Options options_;
+  Stats stats_;
+  size_t submitBatchThreshold_{1};
+  // SQEs in the ring that were not submitted yet
+  size_t numPendingSubmit_{0};
+
   std::unique_ptr<IoSqe[]> entries_;
 
   // io_uring related
@@ -85,5 +589,9 @@ class IoUringBackend : public PollIoBackend {
 
   uint32_t sqRingMask_{0};
   uint32_t cqRingMask_{0};
+
+  BufferPool* bufferPool_{nullptr};
+  bool bufferPoolFailed_{false};
+  std::vector<uint16_t> returnedBids_;
 };
 } // namespace folly
@@ -199,6 +199,15 @@ void PollIoBackend::releaseIoCb(PollIoBackend::IoCb* aioIoCb) {
 }
 
 void PollIoBackend::processIoCb(IoCb* ioCb, int64_t res) noexcept {
+  if (!ioCb->isPollEntry()) {
+    ioCb->res_ = static_cast<int>(res);
+    // a multishot op can complete again before its callback runs
+    if (!ioCb->is_linked()) {
+      activeEvents_.push_back(*ioCb);
+    }
+    return;
+  }
+
   auto* ev = ioCb->event_ ? (ioCb->event_->getEvent()) : nullptr;
   if (ev) {
     if (~event_ref_flags(ev) & EVLIST_INTERNAL) {
@@ -230,6 +239,15 @@ size_t PollIoBackend::processActiveEvents() {
     ioCb = &activeEvents_.front();
     activeEvents_.pop_front();
     ret++;
+    if (!ioCb->isPollEntry()) {
+      ioCb->processActive();
+      if (ioCb->isOpDone()) {
+        DCHECK_GT(numInsertedEvents_, 0);
+        numInsertedEvents_--;
+        releaseIoCb(ioCb);
+      }
+      continue;
+    }
     auto* event = ioCb->event_;
     auto* ev = event ? event->getEvent() : nullptr;
     if (ev) {
@@ -279,7 +297,8 @@ int PollIoBackend::eb_event_base_loop(int flags) {
       eb_poll_loop_pre_hook(&call_time);
     }
 
-    int ret = getActiveEvents();
+    // do not block if cancelled ops are already waiting to be processed
+    int ret = getActiveEvents(activeEvents_.empty());
 
     if (eb_poll_loop_post_hook) {
       eb_poll_loop_post_hook(call_time, ret);
@@ -426,6 +445,12 @@ int PollIoBackend::eb_event_del(Event& event) {
   return -1;
 }
 
+void PollIoBackend::queueOp(IoCb* ioCb) {
+  // pending ops keep the loop running like inserted events do
+  numInsertedEvents_++;
+  submitList_.push_back(*ioCb);
+}
+
 int PollIoBackend::eb_event_modify_inserted(Event& event, IoCb* ioCb) {
   // unlink and append
   ioCb->unlink();
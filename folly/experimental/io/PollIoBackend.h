@@ -60,6 +60,7 @@ class PollIoBackend : public EventBaseBackendBase {
     IoCb* next_{nullptr}; // this is for the free list
     Event* event_{nullptr};
     size_t useCount_{0};
+    int res_{0};
 
     FOLLY_ALWAYS_INLINE void resetEvent() {
       // remove it from the list
@@ -71,6 +72,24 @@ class PollIoBackend : public EventBaseBackendBase {
     }
 
     virtual void prepPollAdd(void* entry, int fd, uint32_t events) = 0;
+
+    // poll entries are driven by an Event; completion-based ops override
+    // this and deliver res_ via processActive() instead
+    virtual bool isPollEntry() const {
+      return true;
+    }
+
+    virtual void processSubmit(void* entry) {
+      auto* ev = event_->getEvent();
+      prepPollAdd(entry, ev->ev_fd, getPollFlags(ev->ev_events));
+    }
+
+    virtual void processActive() {}
+
+    // multishot ops stay alive across several processActive() calls
+    virtual bool isOpDone() const {
+      return true;
+    }
   };
 
   using IoCbList =
@@ -155,6 +174,9 @@ class PollIoBackend : public EventBaseBackendBase {
 
   void processIoCb(IoCb* ioCb, int64_t res) noexcept;
 
+  // completion-based ops
+  void queueOp(IoCb* ioCb);
+
   IoCb* FOLLY_NULLABLE allocIoCb();
   void releaseIoCb(IoCb* aioIoCb);
 
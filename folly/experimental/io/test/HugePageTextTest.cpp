@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/io/HugePageText.h>
+
+#include <folly/CPortability.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+namespace {
+FOLLY_NOINLINE int fib(int n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+} // namespace
+
+TEST(HugePageText, Remap) {
+  auto expected = fib(20);
+  auto remap = remapTextOnHugePages();
+  if (remap.size() != 0) {
+    EXPECT_EQ(0, remap.begin % (2 << 20));
+    EXPECT_EQ(0, remap.end % (2 << 20));
+    EXPECT_LE(remap.hugePageBytes, remap.size());
+  }
+  // The code still runs, wherever it is
+  EXPECT_EQ(expected, fib(20));
+
+  // Remapping again is harmless
+  auto again = remapTextOnHugePages();
+  EXPECT_EQ(remap.begin, again.begin);
+  EXPECT_EQ(remap.end, again.end);
+  EXPECT_EQ(expected, fib(20));
+}
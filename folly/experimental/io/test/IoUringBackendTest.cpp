@@ -19,8 +19,12 @@
 #include <folly/FileUtil.h>
 #include <folly/experimental/io/IoUringBackend.h>
 #include <folly/init/Init.h>
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/EventHandler.h>
+#include <folly/io/async/test/AsyncSocketTest.h>
 #include <folly/io/async/test/EventBaseTestLib.h>
+#include <folly/io/async/test/SocketPair.h>
 #include <folly/portability/GTest.h>
 
 // IoUringBackend specific tests
@@ -128,6 +132,237 @@ TEST(IoUringBackend, Overflow) {
   testOverflow(true);
 }
 
+namespace {
+void testEventFDs(folly::EventBase& evb) {
+  static constexpr size_t kNumEventFds = 32;
+  static constexpr size_t kEventFdCount = 16;
+  uint64_t total = kNumEventFds * kEventFdCount;
+
+  std::vector<std::unique_ptr<EventFD>> eventsVec;
+  for (size_t i = 0; i < kNumEventFds; i++) {
+    eventsVec.emplace_back(
+        std::make_unique<EventFD>(kEventFdCount, total, false, &evb));
+  }
+
+  evb.loopForever();
+
+  for (size_t i = 0; i < kNumEventFds; i++) {
+    CHECK_EQ(eventsVec[i]->getNum(), kEventFdCount);
+  }
+}
+} // namespace
+
+TEST(IoUringBackend, SubmitBatchThreshold) {
+  auto options = folly::IoUringBackend::Options()
+                     .setCapacity(64)
+                     .setMaxSubmit(32)
+                     .setSubmitBatchThreshold(8);
+  auto backend = std::make_unique<folly::IoUringBackend>(options);
+  auto* backendPtr = backend.get();
+  EXPECT_EQ(8, backendPtr->getOptions().submitBatchThreshold);
+  folly::EventBase evb(std::move(backend));
+
+  testEventFDs(evb);
+
+  const auto& stats = backendPtr->getStats();
+  EXPECT_GT(stats.numSubmits, 0);
+  EXPECT_GT(stats.numSubmittedSqes, 0);
+  EXPECT_GT(stats.numGetActiveEvents, 0);
+  EXPECT_GE(stats.numCompletions, 32 * 16);
+  EXPECT_LE(stats.lastCompletions, stats.maxCompletions);
+  EXPECT_EQ(0, stats.numCqOverflows);
+}
+
+TEST(IoUringBackend, SQPoll) {
+  auto options = folly::IoUringBackend::Options()
+                     .setCapacity(64)
+                     .setMaxSubmit(32)
+                     .setUseSQPoll(true)
+                     .setSQIdle(std::chrono::milliseconds(10));
+  std::unique_ptr<folly::IoUringBackend> backend;
+  try {
+    backend = std::make_unique<folly::IoUringBackend>(options);
+  } catch (const std::runtime_error&) {
+    LOG(INFO) << "SQPOLL is not available";
+    return;
+  }
+  folly::EventBase evb(std::move(backend));
+
+  testEventFDs(evb);
+}
+
+namespace {
+void testAsyncSocketAsyncIo(bool bufferPool) {
+  // larger than the socket buffers so the writer has to queue ops
+  static constexpr size_t kDataSize = 8 * 1024 * 1024;
+  static constexpr size_t kNumBuffers = 16;
+
+  auto backend = std::make_unique<folly::IoUringBackend>(64, 32);
+  auto* backendPtr = backend.get();
+  if (bufferPool) {
+    EXPECT_TRUE(backendPtr->setupBufferPool(kNumBuffers, 4096));
+    EXPECT_FALSE(backendPtr->setupBufferPool(kNumBuffers, 4096));
+  }
+  folly::EventBase evb(std::move(backend));
+  folly::SocketPair fds;
+  auto reader =
+      folly::AsyncSocket::newSocket(&evb, fds.extractNetworkSocket0());
+  auto writer =
+      folly::AsyncSocket::newSocket(&evb, fds.extractNetworkSocket1());
+  EXPECT_TRUE(reader->setAsyncIo(true));
+  EXPECT_TRUE(writer->setAsyncIo(true));
+
+  std::string data(kDataSize, '\0');
+  for (size_t i = 0; i < kDataSize; ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+
+  ReadCallback rcb(64 * 1024);
+  WriteCallback wcb;
+  wcb.successCallback = [&]() { writer->close(); };
+  reader->setReadCB(&rcb);
+  writer->writeChain(&wcb, folly::IOBuf::copyBuffer(data));
+
+  evb.loop();
+
+  EXPECT_EQ(STATE_SUCCEEDED, wcb.state);
+  EXPECT_EQ(STATE_SUCCEEDED, rcb.state);
+  EXPECT_EQ(kDataSize, rcb.dataRead());
+  rcb.verifyData(data.data(), data.size());
+
+  if (bufferPool) {
+    // every buffer was copied out and went back to the kernel
+    evb.loopOnce(EVLOOP_NONBLOCK);
+    EXPECT_EQ(kNumBuffers, backendPtr->getBufferPoolAvailable());
+  }
+}
+} // namespace
+
+TEST(IoUringBackend, AsyncSocketAsyncIo) {
+  testAsyncSocketAsyncIo(false);
+}
+
+TEST(IoUringBackend, AsyncSocketAsyncIoBufferPool) {
+  testAsyncSocketAsyncIo(true);
+}
+
+TEST(IoUringBackend, AsyncSocketAsyncIoNotSupported) {
+  folly::EventBase evb;
+  folly::SocketPair fds;
+  auto sock = folly::AsyncSocket::newSocket(&evb, fds.extractNetworkSocket0());
+  EXPECT_FALSE(sock->setAsyncIo(true));
+  EXPECT_FALSE(sock->getAsyncIo());
+}
+
+namespace {
+class CountingAcceptCallback : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  CountingAcceptCallback(folly::AsyncServerSocket* server, size_t expected)
+      : server_(server), expected_(expected) {}
+
+  void connectionAccepted(
+      folly::NetworkSocket fd,
+      const folly::SocketAddress& /*clientAddr*/) noexcept override {
+    folly::netops::close(fd);
+    if (++num_ == expected_) {
+      server_->pauseAccepting();
+    }
+  }
+
+  void acceptError(const std::exception& ex) noexcept override {
+    LOG(ERROR) << "acceptError: " << ex.what();
+    server_->pauseAccepting();
+  }
+
+  size_t getNum() const {
+    return num_;
+  }
+
+ private:
+  folly::AsyncServerSocket* server_;
+  size_t expected_;
+  size_t num_{0};
+};
+} // namespace
+
+TEST(IoUringBackend, AsyncServerSocketMultishotAccept) {
+  static constexpr size_t kNumConns = 32;
+
+  folly::EventBase evb(std::make_unique<folly::IoUringBackend>(64, 32));
+  auto server = folly::AsyncServerSocket::newSocket(&evb);
+  server->bind(folly::SocketAddress("127.0.0.1", 0));
+  server->listen(kNumConns);
+  folly::SocketAddress addr;
+  server->getAddress(&addr);
+
+  CountingAcceptCallback cb(server.get(), kNumConns);
+  server->addAcceptCallback(&cb, nullptr);
+  server->startAccepting();
+
+  // the handshake completes from the backlog
+  std::vector<folly::NetworkSocket> clients;
+  for (size_t i = 0; i < kNumConns; ++i) {
+    auto fd = folly::netops::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(fd, folly::NetworkSocket());
+    sockaddr_storage ss;
+    auto len = addr.getAddress(&ss);
+    ASSERT_EQ(
+        0,
+        folly::netops::connect(
+            fd, reinterpret_cast<const sockaddr*>(&ss), len));
+    clients.push_back(fd);
+  }
+
+  evb.loop();
+
+  EXPECT_EQ(kNumConns, cb.getNum());
+  server->removeAcceptCallback(&cb, nullptr);
+  for (auto fd : clients) {
+    folly::netops::close(fd);
+  }
+}
+
+TEST(IoUringBackend, MultishotPoll) {
+  static constexpr size_t kNumWakeups = 8;
+
+  folly::EventBase evb(std::make_unique<folly::IoUringBackend>(64, 32));
+  auto* backend = evb.getBackend();
+  int fd = ::eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
+  ASSERT_GT(fd, 0);
+
+  uint64_t val = 1;
+  ASSERT_EQ(sizeof(val), folly::writeNoInt(fd, &val, sizeof(val)));
+
+  size_t num = 0;
+  bool done = false;
+  void* op = nullptr;
+  op = backend->eb_queue_poll_multishot(fd, POLLIN, [&](int res, bool more) {
+    if (!more) {
+      done = true;
+    }
+    if (res == -EINVAL || res == -ECANCELED) {
+      return;
+    }
+    EXPECT_TRUE(res & POLLIN);
+    ASSERT_EQ(sizeof(val), folly::readNoInt(fd, &val, sizeof(val)));
+    if (++num == kNumWakeups) {
+      backend->eb_cancel_op(op);
+    } else {
+      ASSERT_EQ(sizeof(val), folly::writeNoInt(fd, &val, sizeof(val)));
+    }
+  });
+  ASSERT_NE(nullptr, op);
+
+  evb.loop();
+
+  EXPECT_TRUE(done);
+  // zero on kernels without multishot poll
+  if (num) {
+    EXPECT_EQ(kNumWakeups, num);
+  }
+  ::close(fd);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   folly::init(&argc, &argv);
@@ -15,9 +15,14 @@
  */
 
 #include <folly/experimental/io/IoUring.h>
+#include <folly/experimental/io/EventBaseAsyncIO.h>
 #include <folly/experimental/io/test/AsyncBaseTestLib.h>
 #include <folly/init/Init.h>
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Collect.h>
+#endif
+
 using folly::IoUring;
 
 namespace folly {
@@ -26,6 +31,104 @@ INSTANTIATE_TYPED_TEST_CASE_P(AsyncTest, AsyncTest, IoUring);
 } // namespace test
 } // namespace folly
 
+TEST(IoUringTest, LinkedWriteFdatasync) {
+  folly::test::TemporaryFile tempFile(folly::test::kAlign);
+  int fd = ::open(tempFile.path().c_str(), O_WRONLY);
+  SKIP_IF(fd == -1) << "Tempfile can't be opened for writing: "
+                    << folly::errnoStr(errno);
+  SCOPE_EXIT {
+    ::close(fd);
+  };
+
+  IoUring ioUring(4, folly::AsyncBase::NOT_POLLABLE, 4);
+  ioUring.registerFiles(folly::range(&fd, &fd + 1));
+  EXPECT_EQ(1u, ioUring.numRegisteredFiles());
+
+  std::string data(128, 'w');
+  IoUring::Op write;
+  write.pwrite(fd, data.data(), data.size(), 0);
+  write.setLinked(true);
+  IoUring::Op sync;
+  sync.fdatasync(fd);
+  folly::AsyncBase::Op* ops[] = {&write, &sync};
+  EXPECT_EQ(2u, ioUring.submit(folly::range(ops)));
+
+  size_t completed = 0;
+  while (completed < 2) {
+    completed += ioUring.wait(1).size();
+  }
+  EXPECT_EQ(ssize_t(data.size()), write.result());
+  EXPECT_EQ(0, sync.result());
+
+  // a failed op cancels the rest of its chain
+  IoUring::Op badWrite;
+  badWrite.pwrite(-1, data.data(), data.size(), 0);
+  badWrite.setLinked(true);
+  IoUring::Op cancelled;
+  cancelled.fsync(fd);
+  folly::AsyncBase::Op* badOps[] = {&badWrite, &cancelled};
+  EXPECT_EQ(2u, ioUring.submit(folly::range(badOps)));
+  completed = 0;
+  while (completed < 2) {
+    completed += ioUring.wait(1).size();
+  }
+  EXPECT_EQ(-EBADF, badWrite.result());
+  EXPECT_EQ(-ECANCELED, cancelled.result());
+
+  ioUring.unregisterFiles();
+  EXPECT_EQ(0u, ioUring.numRegisteredFiles());
+}
+
+#if FOLLY_HAS_COROUTINES
+TEST(IoUringTest, EventBaseAsyncIOCoroutines) {
+  folly::test::TemporaryFile tempFile(folly::test::kAlign);
+  int fd = ::open(tempFile.path().c_str(), O_RDWR);
+  SKIP_IF(fd == -1) << "Tempfile can't be opened: " << folly::errnoStr(errno);
+  SCOPE_EXIT {
+    ::close(fd);
+  };
+
+  folly::EventBase evb;
+  // a capacity of 2 makes some of the reads below wait for room
+  folly::EventBaseAsyncIO aio(
+      &evb, std::make_unique<IoUring>(2, folly::AsyncBase::POLLABLE));
+
+  constexpr size_t kNumBlocks = 8;
+  constexpr size_t kBlockSize = 512;
+  std::string data(kNumBlocks * kBlockSize, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = char('a' + i / kBlockSize);
+  }
+
+  // completions are reaped by the loop that getVia() drives
+  auto test = [&]() -> folly::coro::Task<void> {
+    auto written = co_await aio.co_pwrite(fd, data.data(), data.size(), 0);
+    EXPECT_EQ(ssize_t(data.size()), written);
+    auto synced = co_await aio.co_fdatasync(fd);
+    EXPECT_EQ(0, synced);
+
+    std::vector<std::string> blocks(kNumBlocks, std::string(kBlockSize, 0));
+    std::vector<folly::coro::Task<ssize_t>> reads;
+    for (size_t i = 0; i < kNumBlocks; ++i) {
+      reads.push_back(aio.co_pread(
+          fd, &blocks[i][0], kBlockSize, off_t(i * kBlockSize)));
+    }
+    auto results = co_await folly::coro::collectAllRange(std::move(reads));
+    for (size_t i = 0; i < kNumBlocks; ++i) {
+      EXPECT_EQ(ssize_t(kBlockSize), results[i]);
+      EXPECT_EQ(data.substr(i * kBlockSize, kBlockSize), blocks[i]);
+    }
+
+    char c;
+    auto bad = co_await aio.co_pread(-1, &c, 1, 0);
+    EXPECT_EQ(-EBADF, bad);
+  };
+  test().scheduleOn(&evb).start().getVia(&evb);
+  EXPECT_EQ(0u, aio.queued());
+  EXPECT_EQ(0u, aio.getAsyncBase()->pending());
+}
+#endif
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   folly::init(&argc, &argv);
@@ -163,6 +163,14 @@ class Observer {
     return snapshot.getVersion() < core_->getVersionLastChange();
   }
 
+  /**
+   * How often the observed object was re-computed, and how long its updates
+   * took to propagate.
+   */
+  observer_detail::Core::Stats getStats() const {
+    return core_->getStats();
+  }
+
   CallbackHandle addCallback(folly::Function<void(Snapshot<T>)> callback) const;
 
  private:
@@ -90,6 +90,12 @@ size_t Core::refresh(size_t version) {
     }
 
     try {
+      auto start = std::chrono::steady_clock::now();
+      SCOPE_EXIT {
+        auto stats = stats_.wlock();
+        ++stats->recomputations;
+        stats->recomputeTime += std::chrono::steady_clock::now() - start;
+      };
       VersionedData newData{creator_(), version};
       if (!newData.data) {
         throw std::logic_error("Observer creator returned nullptr.");
@@ -97,6 +103,14 @@ size_t Core::refresh(size_t version) {
       if (data_.copy().data != newData.data) {
         data_.swap(newData);
         versionLastChange_ = version;
+        if (version_ != 0) {
+          std::chrono::nanoseconds latency = std::chrono::steady_clock::now() -
+              ObserverManager::getVersionStartTime();
+          auto stats = stats_.wlock();
+          ++stats->updates;
+          stats->lastUpdateLatency = latency;
+          stats->maxUpdateLatency = std::max(stats->maxUpdateLatency, latency);
+        }
       }
     } catch (...) {
       LOG(ERROR) << "Exception while refreshing Observer: "
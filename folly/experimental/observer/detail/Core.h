@@ -21,6 +21,7 @@
 #include <folly/futures/Future.h>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <unordered_set>
@@ -94,6 +95,27 @@ class Core : public std::enable_shared_from_this<Core> {
    */
   void setForceRefresh();
 
+  /**
+   * How the observed object was re-computed since it was created.
+   */
+  struct Stats {
+    // Number of times the creator was run, including the first.
+    size_t recomputations{0};
+    // Number of times the observed object changed after the first.
+    size_t updates{0};
+    // Total time spent running the creator.
+    std::chrono::nanoseconds recomputeTime{0};
+    // Time from the request of the update that started a version, e.g.
+    // Observable::setValue, until this object changed in that version. For
+    // the last update and for the slowest one.
+    std::chrono::nanoseconds lastUpdateLatency{0};
+    std::chrono::nanoseconds maxUpdateLatency{0};
+  };
+
+  Stats getStats() const {
+    return stats_.copy();
+  }
+
   ~Core();
 
  private:
@@ -113,6 +135,8 @@ class Core : public std::enable_shared_from_this<Core> {
 
   folly::Synchronized<VersionedData> data_;
 
+  folly::Synchronized<Stats> stats_;
+
   folly::Function<std::shared_ptr<const void>()> creator_;
 
   std::mutex refreshMutex_;
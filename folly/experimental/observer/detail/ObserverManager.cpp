@@ -16,6 +16,8 @@
 
 #include <folly/experimental/observer/detail/ObserverManager.h>
 
+#include <algorithm>
+#include <chrono>
 #include <future>
 
 #include <folly/ExceptionString.h>
@@ -38,6 +40,12 @@ DEFINE_int32(
     4,
     "How many internal threads ObserverManager should use");
 
+DEFINE_int32(
+    observer_manager_batch_window_ms,
+    0,
+    "How long ObserverManager waits for more updates after one is requested, "
+    "to propagate them together. Bounds the latency it adds to updates.");
+
 namespace {
 constexpr StringPiece kObserverManagerThreadNamePrefix{"ObserverMngr"};
 constexpr size_t kNextBatchSize{1024};
@@ -103,18 +111,33 @@ class ObserverManager::NextQueue {
       folly::setThreadName(
           folly::sformat("{}NQ", kObserverManagerThreadNamePrefix));
 
-      Core::WeakPtr queueCoreWeak;
+      Update update;
 
       while (true) {
-        queue_.dequeue(queueCoreWeak);
+        queue_.dequeue(update);
         if (stop_) {
           return;
         }
 
         std::vector<Core::Ptr> cores;
-        {
-          if (auto queueCore = queueCoreWeak.lock()) {
+        auto startTime = std::chrono::steady_clock::time_point::max();
+        auto addUpdate = [&](Update& queueUpdate) {
+          if (auto queueCore = queueUpdate.core.lock()) {
             cores.emplace_back(std::move(queueCore));
+            startTime = std::min(startTime, queueUpdate.time);
+          }
+        };
+        addUpdate(update);
+
+        if (!cores.empty() && FLAGS_observer_manager_batch_window_ms > 0) {
+          auto deadline = std::chrono::steady_clock::now() +
+              std::chrono::milliseconds(FLAGS_observer_manager_batch_window_ms);
+          while (cores.size() < kNextBatchSize &&
+                 queue_.try_dequeue_until(update, deadline)) {
+            if (stop_) {
+              return;
+            }
+            addUpdate(update);
           }
         }
 
@@ -123,21 +146,25 @@ class ObserverManager::NextQueue {
 
           // We can't pick more tasks from the queue after we bumped the
           // version, so we have to do this while holding the lock.
-          while (cores.size() < kNextBatchSize &&
-                 queue_.try_dequeue(queueCoreWeak)) {
+          while (cores.size() < kNextBatchSize && queue_.try_dequeue(update)) {
             if (stop_) {
               return;
             }
-            if (auto queueCore = queueCoreWeak.lock()) {
-              cores.emplace_back(std::move(queueCore));
-            }
+            addUpdate(update);
           }
 
+          // Observables updated several times are only refreshed once.
+          std::sort(cores.begin(), cores.end());
+          cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+
           for (auto& corePtr : cores) {
             corePtr->setForceRefresh();
           }
 
           ++manager_.version_;
+          manager_.versionStartTime_.store(
+              cores.empty() ? std::chrono::steady_clock::now() : startTime,
+              std::memory_order_relaxed);
         }
 
         for (auto& core : cores) {
@@ -160,13 +187,13 @@ class ObserverManager::NextQueue {
   }
 
   void add(Core::WeakPtr core) {
-    queue_.enqueue(std::move(core));
+    queue_.enqueue({std::move(core), std::chrono::steady_clock::now()});
   }
 
   ~NextQueue() {
     stop_ = true;
     // Write to the queue to notify the thread.
-    queue_.enqueue(Core::WeakPtr());
+    queue_.enqueue(Update());
     thread_.join();
   }
 
@@ -176,14 +203,20 @@ class ObserverManager::NextQueue {
     emptyWaiters_.wlock()->push_back(std::move(promise));
 
     // Write to the queue to notify the thread.
-    queue_.enqueue(Core::WeakPtr());
+    queue_.enqueue(Update());
 
     future.get();
   }
 
  private:
+  struct Update {
+    Core::WeakPtr core;
+    // When the update was requested.
+    std::chrono::steady_clock::time_point time;
+  };
+
   ObserverManager& manager_;
-  UMPSCQueue<Core::WeakPtr, true> queue_;
+  UMPSCQueue<Update, true> queue_;
   std::thread thread_;
   std::atomic<bool> stop_{false};
   folly::Synchronized<std::vector<std::promise<void>>> emptyWaiters_;
@@ -49,6 +49,12 @@ namespace observer_detail {
  * version is bumped and all updates from the ObserverManager::NextQueue are
  * performed. If leaf Observer gets updated more then once before being picked
  * from the ObserverManager::NextQueue, then only the last update is processed.
+ *
+ * All the updates in one version are propagated together, so an Observer
+ * depending on several of them is only re-computed once. With
+ * --observer_manager_batch_window_ms, the version is only bumped once updates
+ * were batched for that long, so that bursts of updates (e.g. a config push)
+ * are propagated in fewer versions.
  */
 class ObserverManager {
  public:
@@ -62,6 +68,20 @@ class ObserverManager {
     return instance->version_;
   }
 
+  /**
+   * When the first of the updates that started the current version was
+   * requested.
+   */
+  static std::chrono::steady_clock::time_point getVersionStartTime() {
+    auto instance = getInstance();
+
+    if (!instance) {
+      return {};
+    }
+
+    return instance->versionStartTime_.load(std::memory_order_relaxed);
+  }
+
   static bool inManagerThread() {
     return inManagerThread_;
   }
@@ -242,6 +262,7 @@ class ObserverManager {
    */
   SharedMutexReadPriority versionMutex_;
   std::atomic<size_t> version_{1};
+  std::atomic<std::chrono::steady_clock::time_point> versionStartTime_{};
 
   using CycleDetector = GraphCycleDetector<const Core*>;
   folly::Synchronized<CycleDetector, std::mutex> cycleDetector_;
@@ -16,10 +16,18 @@
 
 #include <thread>
 
+#include <folly/ScopeGuard.h>
 #include <folly/experimental/observer/SimpleObservable.h>
+#include <folly/portability/GFlags.h>
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/Baton.h>
 
+namespace folly {
+namespace observer_detail {
+DECLARE_int32(observer_manager_batch_window_ms);
+} // namespace observer_detail
+} // namespace folly
+
 using namespace folly::observer;
 
 TEST(Observer, Observable) {
@@ -432,6 +440,53 @@ TEST(Observer, IgnoreUpdates) {
   EXPECT_EQ(3, callbackCalled);
 }
 
+TEST(Observer, Stats) {
+  folly::observer::SimpleObservable<int> observable(1);
+  auto observer =
+      makeObserver([o = observable.getObserver()] { return **o * 2; });
+  EXPECT_EQ(2, **observer);
+
+  auto stats = observer.getStats();
+  EXPECT_EQ(1, stats.recomputations);
+  EXPECT_EQ(0, stats.updates);
+
+  observable.setValue(2);
+  folly::observer_detail::ObserverManager::waitForAllUpdates();
+  EXPECT_EQ(4, **observer);
+
+  stats = observer.getStats();
+  EXPECT_EQ(2, stats.recomputations);
+  EXPECT_EQ(1, stats.updates);
+  EXPECT_GT(stats.lastUpdateLatency.count(), 0);
+  EXPECT_EQ(stats.maxUpdateLatency, stats.lastUpdateLatency);
+}
+
+TEST(Observer, BatchWindow) {
+  using folly::observer_detail::FLAGS_observer_manager_batch_window_ms;
+  auto batchWindowMs =
+      std::exchange(FLAGS_observer_manager_batch_window_ms, 500);
+  SCOPE_EXIT {
+    FLAGS_observer_manager_batch_window_ms = batchWindowMs;
+  };
+
+  folly::observer::SimpleObservable<int> a(0);
+  folly::observer::SimpleObservable<int> b(0);
+  auto sum = makeObserver(
+      [a = a.getObserver(), b = b.getObserver()] { return **a + **b; });
+  EXPECT_EQ(0, **sum);
+
+  // Updates requested within the window are propagated together.
+  for (int i = 1; i <= 10; ++i) {
+    a.setValue(i);
+    b.setValue(i);
+  }
+  folly::observer_detail::ObserverManager::waitForAllUpdates();
+
+  EXPECT_EQ(20, **sum);
+  EXPECT_EQ(2, sum.getStats().recomputations);
+  EXPECT_EQ(1, sum.getStats().updates);
+}
+
 TEST(Observer, GetSnapshotOnManagerThread) {
   auto observer42 = folly::observer::makeObserver([] { return 42; });
 
@@ -175,8 +175,12 @@ SnapshotBase::~SnapshotBase() {
 } // namespace detail
 
 void Snapshot::publish() {
+  if (snapshotValues_.empty()) {
+    return;
+  }
+  auto version = detail::nextGlobalVersion();
   for (auto& it : snapshotValues_) {
-    it.second.publish();
+    it.second.publish(version);
   }
 }
 
@@ -19,6 +19,7 @@
 #include <functional>
 #include <string>
 
+#include <folly/Likely.h>
 #include <folly/Range.h>
 #include <folly/experimental/settings/SettingsMetadata.h>
 #include <folly/experimental/settings/detail/SettingsImpl.h>
@@ -40,7 +41,10 @@ class SettingWrapper {
    * Returns the setting's current value.
    *
    * As an optimization, returns by value for small types, and by
-   * const& for larger types.  Note that the returned reference is not
+   * const& for larger types.  Small types are the trivially copyable
+   * ones of up to 8 bytes (see IsSmallPOD), which includes types with
+   * non-trivial default constructors, so returning by value does not
+   * mean the type is trivial.  Note that the returned reference is not
    * guaranteed to be long-lived and should not be saved anywhere. In
    * particular, a set() call might invalidate a reference obtained
    * here after some amount of time (on the order of minutes).
@@ -131,13 +135,16 @@ using TypeIdentityT = typename TypeIdentity<T>::type;
       FOLLY_SETTINGS_FUNC__##_project##_##_name();                            \
   FOLLY_ALWAYS_INLINE auto FOLLY_SETTINGS_LOCAL_FUNC__##_project##_##_name(   \
       _overloadType) {                                                        \
-    if (!FOLLY_SETTINGS_CACHE__##_project##_##_name.load()) {                 \
+    auto core = FOLLY_SETTINGS_CACHE__##_project##_##_name.load(              \
+        std::memory_order_acquire);                                           \
+    if (UNLIKELY(!core)) {                                                    \
+      core = &FOLLY_SETTINGS_FUNC__##_project##_##_name();                    \
       FOLLY_SETTINGS_CACHE__##_project##_##_name.store(                       \
-          &FOLLY_SETTINGS_FUNC__##_project##_##_name());                      \
+          core, std::memory_order_release);                                   \
     }                                                                         \
     return folly::settings::detail::                                          \
         SettingWrapper<_Type, &FOLLY_SETTINGS_TRIVIAL__##_project##_##_name>( \
-            *FOLLY_SETTINGS_CACHE__##_project##_##_name.load());              \
+            *core);                                                           \
   }                                                                           \
   /* This is here just to force a semicolon */                                \
   folly::settings::detail::SettingCore<_Type>&                                \
@@ -304,6 +311,10 @@ class Snapshot final : public detail::SnapshotBase {
   /**
    * Apply all settings updates from this snapshot to the global state
    * unconditionally.
+   *
+   * All updated settings are published under a single bump of the global
+   * version, which makes this the preferred way to update many settings
+   * at once.
    */
   void publish() override;
 
@@ -33,13 +33,17 @@ namespace settings {
 namespace detail {
 
 /**
- * Can we store T in a global atomic?
+ * Can we store T in a global atomic? Any trivially copyable type that
+ * fits is read straight from the atomic, without touching the thread
+ * local cache. SettingWrapper::operator*() and value() return these types
+ * by value rather than by const&.
  */
 template <class T>
 struct IsSmallPOD
     : std::integral_constant<
           bool,
-          std::is_trivial<T>::value && sizeof(T) <= sizeof(uint64_t)> {};
+          std::is_trivially_copyable<T>::value &&
+              sizeof(T) <= sizeof(uint64_t)> {};
 
 template <class T>
 struct SettingContents {
@@ -107,9 +111,9 @@ class BoxedValue {
   template <class T>
   BoxedValue(const T& value, StringPiece reason, SettingCore<T>& core)
       : value_(std::make_shared<SettingContents<T>>(reason.str(), value)),
-        publish_([value = value_, &core]() {
+        publish_([value = value_, &core](SettingCoreBase::Version version) {
           auto& contents = BoxedValue::unboxImpl<T>(value.get());
-          core.set(contents.value, contents.updateReason);
+          core.publish(contents.value, contents.updateReason, version);
         }) {}
 
   /**
@@ -121,17 +125,18 @@ class BoxedValue {
   }
 
   /**
-   * Applies the stored value globally
+   * Applies the stored value globally as the given version, see
+   * SettingCore::publish().
    */
-  void publish() {
+  void publish(SettingCoreBase::Version version) {
     if (publish_) {
-      publish_();
+      publish_(version);
     }
   }
 
  private:
   std::shared_ptr<void> value_;
-  std::function<void()> publish_;
+  std::function<void(SettingCoreBase::Version)> publish_;
 
   template <class T>
   static const SettingContents<T>& unboxImpl(void* value) {
@@ -290,10 +295,10 @@ class SettingCore : public SettingCoreBase {
    * SmallPOD version: just read the global atomic
    */
   T getImpl(std::true_type, std::atomic<uint64_t>& trivialStorage) const {
-    uint64_t v = trivialStorage.load();
-    T t;
+    uint64_t v = trivialStorage.load(std::memory_order_relaxed);
+    std::aligned_storage_t<sizeof(T), alignof(T)> t;
     std::memcpy(&t, &v, sizeof(T));
-    return t;
+    return *reinterpret_cast<const T*>(&t);
   }
 
   /**
@@ -314,18 +319,21 @@ class SettingCore : public SettingCoreBase {
     }
 
     SharedMutex::WriteHolder lg(globalLock_);
+    setLocked(t, reason, [] { return nextGlobalVersion(); });
+  }
 
-    if (globalValue_) {
-      saveValueForOutstandingSnapshots(
-          getKey(), *settingVersion_, BoxedValue(*globalValue_));
-    }
-    globalValue_ = std::make_shared<Contents>(reason.str(), t);
-    if (IsSmallPOD<T>::value) {
-      uint64_t v = 0;
-      std::memcpy(&v, &t, sizeof(T));
-      trivialStorage_.store(v);
-    }
-    *settingVersion_ = nextGlobalVersion();
+  /**
+   * Like set(), but publishes the value as the given version, obtained
+   * from nextGlobalVersion() by the caller. Lets Snapshot::publish() apply
+   * any number of settings under a single version bump.
+   */
+  void publish(const T& t, StringPiece reason, Version version) {
+    SharedMutex::WriteHolder lg(globalLock_);
+    setLocked(t, reason, [&] {
+      /* A concurrent set() may have published a newer version since the
+         caller got this one; a setting's version must not go backwards */
+      return version > *settingVersion_ ? version : nextGlobalVersion();
+    });
   }
 
   const T& defaultValue() const {
@@ -363,6 +371,21 @@ class SettingCore : public SettingCoreBase {
   ThreadLocal<CachelinePadded<std::pair<Version, std::shared_ptr<Contents>>>>
       localValue_;
 
+  template <class NextVersion>
+  void setLocked(const T& t, StringPiece reason, NextVersion nextVersion) {
+    if (globalValue_) {
+      saveValueForOutstandingSnapshots(
+          getKey(), *settingVersion_, BoxedValue(*globalValue_));
+    }
+    globalValue_ = std::make_shared<Contents>(reason.str(), t);
+    if (IsSmallPOD<T>::value) {
+      uint64_t v = 0;
+      std::memcpy(&v, &t, sizeof(T));
+      trivialStorage_.store(v, std::memory_order_relaxed);
+    }
+    *settingVersion_ = nextVersion();
+  }
+
   FOLLY_ALWAYS_INLINE const std::shared_ptr<Contents>& tlValue() const {
     auto& value = **localValue_;
     if (LIKELY(value.first == *settingVersion_)) {
@@ -447,3 +447,38 @@ TEST(Settings, snapshot) {
         123);
   }
 }
+
+TEST(Settings, publishBatch) {
+  some_ns::FOLLY_SETTING(follytest, some_flag).set("before");
+  a_ns::FOLLY_SETTING(follytest, public_flag_to_a).set(1);
+  folly::settings::Snapshot before;
+  {
+    folly::settings::Snapshot snapshot;
+    snapshot(some_ns::FOLLY_SETTING(follytest, some_flag)).set("batch");
+    snapshot(a_ns::FOLLY_SETTING(follytest, public_flag_to_a)).set(2);
+    snapshot.publish();
+  }
+  EXPECT_EQ(*some_ns::FOLLY_SETTING(follytest, some_flag), "batch");
+  EXPECT_EQ(*a_ns::FOLLY_SETTING(follytest, public_flag_to_a), 2);
+  EXPECT_EQ(*before(some_ns::FOLLY_SETTING(follytest, some_flag)), "before");
+  EXPECT_EQ(*before(a_ns::FOLLY_SETTING(follytest, public_flag_to_a)), 1);
+
+  // Later updates are still picked up by the thread local caches
+  some_ns::FOLLY_SETTING(follytest, some_flag).set("after");
+  EXPECT_EQ(*some_ns::FOLLY_SETTING(follytest, some_flag), "after");
+  EXPECT_EQ(*before(some_ns::FOLLY_SETTING(follytest, some_flag)), "before");
+}
+
+namespace {
+struct TriviallyCopyable {
+  TriviallyCopyable() : value(1) {}
+  int value;
+};
+} // namespace
+
+TEST(Settings, smallPOD) {
+  using folly::settings::detail::IsSmallPOD;
+  EXPECT_TRUE(IsSmallPOD<int>::value);
+  EXPECT_TRUE(IsSmallPOD<TriviallyCopyable>::value);
+  EXPECT_FALSE(IsSmallPOD<std::string>::value);
+}
@@ -16,7 +16,9 @@
 
 #include <folly/experimental/symbolizer/Dwarf.h>
 
+#include <algorithm>
 #include <array>
+#include <unordered_set>
 
 #include <dwarf.h>
 #include <type_traits>
@@ -386,13 +388,15 @@ void simplifyPath(folly::StringPiece& sp) {
 
 } // namespace
 
-Dwarf::Dwarf(const ElfFile* elf)
+Dwarf::Dwarf(const ElfFile* elf, Index* index)
     : elf_(elf),
+      index_(index),
       debugInfo_(getSection(".debug_info")),
       debugAbbrev_(getSection(".debug_abbrev")),
       debugLine_(getSection(".debug_line")),
       debugStr_(getSection(".debug_str")),
-      debugAranges_(getSection(".debug_aranges")) {
+      debugAranges_(getSection(".debug_aranges")),
+      debugRanges_(getSection(".debug_ranges")) {
   // NOTE: debugAranges_ is for fast address range lookup.
   // If missing .debug_info can be used - but it's much slower (linear scan).
   if (debugInfo_.empty() || debugAbbrev_.empty() || debugLine_.empty() ||
@@ -608,6 +612,86 @@ bool Dwarf::findDebugInfoOffset(
   return false;
 }
 
+bool Dwarf::forEachCompilationUnitRange(
+    const detail::CompilationUnit& cu,
+    folly::FunctionRef<bool(uint64_t, uint64_t)> f) const {
+  detail::Die die = getDieAtOffset(cu, cu.firstDie);
+  uint64_t lowPc = 0;
+  uint64_t highPc = 0;
+  bool hasLowPc = false;
+  bool hasHighPc = false;
+  bool isHighPcAddr = false;
+  bool hasRanges = false;
+  uint64_t rangesOffset = 0;
+  forEachAttribute(cu, die, [&](const detail::Attribute& attr) {
+    switch (attr.spec.name) {
+      case DW_AT_low_pc:
+        lowPc = boost::get<uint64_t>(attr.attrValue);
+        hasLowPc = true;
+        break;
+      case DW_AT_high_pc:
+        // Value of DW_AT_high_pc attribute can be an address
+        // (DW_FORM_addr) or an offset (DW_FORM_data).
+        isHighPcAddr = (attr.spec.form == DW_FORM_addr);
+        highPc = boost::get<uint64_t>(attr.attrValue);
+        hasHighPc = true;
+        break;
+      case DW_AT_ranges:
+        rangesOffset = boost::get<uint64_t>(attr.attrValue);
+        hasRanges = true;
+        break;
+    }
+    return true;
+  });
+
+  if (hasRanges) {
+    if (rangesOffset >= debugRanges_.size()) {
+      return false;
+    }
+    // A list of address pairs, relative to the unit's low pc, ended by a
+    // pair of zeros. A pair whose first address is the largest address
+    // sets a new base.
+    folly::StringPiece sp(debugRanges_);
+    sp.advance(rangesOffset);
+    uint64_t base = lowPc;
+    while (sp.size() >= 2 * sizeof(uintptr_t)) {
+      auto start = read<uintptr_t>(sp);
+      auto end = read<uintptr_t>(sp);
+      if (start == 0 && end == 0) {
+        break;
+      }
+      if (start == std::numeric_limits<uintptr_t>::max()) {
+        base = end;
+        continue;
+      }
+      if (start != end && !f(base + start, base + end)) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  if (hasLowPc && hasHighPc) {
+    auto end = isHighPcAddr ? highPc : lowPc + highPc;
+    if (lowPc != end) {
+      f(lowPc, end);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool Dwarf::mayContainAddress(
+    const detail::CompilationUnit& cu,
+    uint64_t address) const {
+  bool found = false;
+  bool hasRanges = forEachCompilationUnitRange(cu, [&](auto start, auto end) {
+    found = address >= start && address < end;
+    return !found;
+  });
+  return found || !hasRanges;
+}
+
 /**
  * Find the @locationInfo for @address in the compilation unit represented
  * by the @sp .debug_info entry.
@@ -666,8 +750,17 @@ bool Dwarf::findLocation(
   LineNumberVM lineVM(lineSection, compilationDirectory);
 
   // Execute line number VM program to find file and line
-  locationInfo.hasFileAndLine =
-      lineVM.findAddress(address, locationInfo.file, locationInfo.line);
+  if (index_) {
+    uint64_t file = 0;
+    locationInfo.hasFileAndLine =
+        index_->findLine(lineVM, lineOffset, address, file, locationInfo.line);
+    if (locationInfo.hasFileAndLine) {
+      locationInfo.file = lineVM.getPath(file);
+    }
+  } else {
+    locationInfo.hasFileAndLine =
+        lineVM.findAddress(address, locationInfo.file, locationInfo.line);
+  }
 
   // Look up whether inline function.
   if (mode == Dwarf::LocationInfoMode::FULL_WITH_INLINE &&
@@ -741,6 +834,30 @@ bool Dwarf::findAddress(
     return false;
   }
 
+  if (index_) {
+    uint64_t offset = 0;
+    if (index_->findUnit(*this, address, offset)) {
+      auto unit = getCompilationUnit(debugInfo_, offset);
+      findLocation(address, mode, unit, locationInfo, inlineLocationInfo);
+      return locationInfo.hasFileAndLine;
+    }
+    if (mode == LocationInfoMode::FAST && !debugAranges_.empty()) {
+      // As below, FAST mode trusts .debug_aranges when there is one.
+      return false;
+    }
+    // Only the units whose entries have no address ranges are left; without
+    // .debug_aranges this is what the linear scan would find in FAST mode
+    // too.
+    for (auto unitOffset : index_->unitsWithoutRanges(*this)) {
+      auto unit = getCompilationUnit(debugInfo_, unitOffset);
+      findLocation(address, mode, unit, locationInfo, inlineLocationInfo);
+      if (locationInfo.hasFileAndLine) {
+        break;
+      }
+    }
+    return locationInfo.hasFileAndLine;
+  }
+
   if (!debugAranges_.empty()) {
     // Fast path: find the right .debug_info entry by looking up the
     // address in .debug_aranges.
@@ -766,16 +883,169 @@ bool Dwarf::findAddress(
   }
 
   // Slow path (linear scan): Iterate over all .debug_info entries
-  // and look for the address in each compilation unit.
+  // and look for the address in each compilation unit, skipping those
+  // whose address ranges do not contain it without running their line
+  // number programs.
   uint64_t offset = 0;
   while (offset < debugInfo_.size() && !locationInfo.hasFileAndLine) {
     auto unit = getCompilationUnit(debugInfo_, offset);
     offset += unit.size;
-    findLocation(address, mode, unit, locationInfo, inlineLocationInfo);
+    if (mayContainAddress(unit, address)) {
+      findLocation(address, mode, unit, locationInfo, inlineLocationInfo);
+    }
   }
   return locationInfo.hasFileAndLine;
 }
 
+void Dwarf::Index::build(const Dwarf& dwarf) {
+  // Units listed in .debug_aranges.
+  std::unordered_set<uint64_t> arangesUnits;
+  Section arangesSection(dwarf.debugAranges_);
+  folly::StringPiece chunk;
+  while (arangesSection.next(chunk)) {
+    auto version = read<uint16_t>(chunk);
+    FOLLY_SAFE_CHECK(version == 2, "invalid aranges version");
+    auto offset = readOffset(chunk, arangesSection.is64Bit());
+    auto addressSize = read<uint8_t>(chunk);
+    FOLLY_SAFE_CHECK(addressSize == sizeof(uintptr_t), "invalid address size");
+    auto segmentSize = read<uint8_t>(chunk);
+    FOLLY_SAFE_CHECK(segmentSize == 0, "segmented architecture not supported");
+    skipPadding(chunk, dwarf.debugAranges_.data(), 2 * sizeof(uintptr_t));
+    for (;;) {
+      auto start = read<uintptr_t>(chunk);
+      auto length = read<uintptr_t>(chunk);
+      if (start == 0 && length == 0) {
+        break;
+      }
+      if (length != 0) {
+        ranges_.push_back({start, start + length, offset});
+        arangesUnits.insert(offset);
+      }
+    }
+  }
+
+  // Compilers may leave units out of .debug_aranges (or not emit it at
+  // all), so take the ranges of the others from their entries.
+  uint64_t offset = 0;
+  while (offset < dwarf.debugInfo_.size()) {
+    // Skip units of versions we cannot parse, rather than aborting in
+    // getCompilationUnit() on lookups that might never need them.
+    folly::StringPiece header(dwarf.debugInfo_);
+    header.advance(offset);
+    auto initialLength = read<uint32_t>(header);
+    auto is64Bit = (initialLength == (uint32_t)-1);
+    auto size = is64Bit ? read<uint64_t>(header) : initialLength;
+    FOLLY_SAFE_CHECK(size <= header.size(), "invalid chunk size");
+    auto version = read<uint16_t>(header);
+    if (version < 2 || version > 4 || arangesUnits.count(offset)) {
+      offset += size + (is64Bit ? 12 : 4);
+      continue;
+    }
+    auto unit = getCompilationUnit(dwarf.debugInfo_, offset);
+    offset += unit.size;
+    bool hasRanges =
+        dwarf.forEachCompilationUnitRange(unit, [&](auto start, auto end) {
+          ranges_.push_back({start, end, unit.offset});
+          return true;
+        });
+    if (!hasRanges) {
+      unitsWithoutRanges_.push_back(unit.offset);
+    }
+  }
+
+  std::sort(ranges_.begin(), ranges_.end(), [](const auto& a, const auto& b) {
+    return a.start < b.start;
+  });
+  maxEnd_.reserve(ranges_.size());
+  for (auto const& range : ranges_) {
+    maxEnd_.push_back(
+        maxEnd_.empty() ? range.end : std::max(maxEnd_.back(), range.end));
+  }
+}
+
+bool Dwarf::Index::findUnit(
+    const Dwarf& dwarf,
+    uint64_t address,
+    uint64_t& offset) {
+  std::call_once(built_, [&] { build(dwarf); });
+  auto it = std::upper_bound(
+      ranges_.begin(),
+      ranges_.end(),
+      address,
+      [](uint64_t addr, const UnitRange& range) { return addr < range.start; });
+  // Ranges starting at or before address; walk back over any that may
+  // still overlap it. Inline functions merged by the linker can leave
+  // several units covering the same range; pick the first unit, as the
+  // linear scan would.
+  bool found = false;
+  for (auto i = size_t(it - ranges_.begin()); i-- > 0 && maxEnd_[i] > address;) {
+    if (address < ranges_[i].end &&
+        (!found || ranges_[i].unitOffset < offset)) {
+      offset = ranges_[i].unitOffset;
+      found = true;
+    }
+  }
+  return found;
+}
+
+const std::vector<uint64_t>& Dwarf::Index::unitsWithoutRanges(
+    const Dwarf& dwarf) {
+  std::call_once(built_, [&] { build(dwarf); });
+  return unitsWithoutRanges_;
+}
+
+bool Dwarf::Index::findLine(
+    LineNumberVM& vm,
+    uint64_t lineOffset,
+    uint64_t address,
+    uint64_t& file,
+    uint64_t& line) {
+  const LineTable* table = nullptr;
+  {
+    auto tables = lineTables_.rlock();
+    auto it = tables->find(lineOffset);
+    if (it != tables->end()) {
+      table = it->second.get();
+    }
+  }
+  if (!table) {
+    auto rows = std::make_unique<LineTable>();
+    auto sequenceStart = size_t(0);
+    vm.forEachRow([&](uint64_t addr, uint64_t f, uint64_t l) {
+      // Within a sequence addresses only increase, and the last of several
+      // rows at the same address wins; a row at the end address of its
+      // sequence covers nothing.
+      if (rows->size() > sequenceStart && rows->back().address == addr) {
+        rows->pop_back();
+      }
+      rows->push_back({addr, f, l});
+      if (f == 0) {
+        sequenceStart = rows->size();
+      }
+    });
+    // Order sequences by address; at equal addresses, the end of one
+    // sequence comes before the start of the next.
+    std::stable_sort(rows->begin(), rows->end(), [](auto& a, auto& b) {
+      return a.address < b.address ||
+          (a.address == b.address && a.file == 0 && b.file != 0);
+    });
+    auto tables = lineTables_.wlock();
+    table = tables->emplace(lineOffset, std::move(rows)).first->second.get();
+  }
+
+  auto it = std::upper_bound(
+      table->begin(),
+      table->end(),
+      address,
+      [](uint64_t addr, const LineRow& row) { return addr < row.address; });
+  if (it == table->begin() || (--it)->file == 0) {
+    return false;
+  }
+  file = it->file;
+  line = it->line;
+  return true;
+}
+
 detail::Die Dwarf::getDieAtOffset(
     const detail::CompilationUnit& cu,
     uint64_t offset) const {
@@ -1240,6 +1510,19 @@ Dwarf::LineNumberVM::StepResult Dwarf::LineNumberVM::step(
   return CONTINUE;
 }
 
+void Dwarf::LineNumberVM::forEachRow(
+    folly::FunctionRef<void(uint64_t, uint64_t, uint64_t)> f) {
+  folly::StringPiece program = data_;
+  reset();
+  while (!program.empty()) {
+    bool seqEnd = !next(program);
+    f(address_, seqEnd ? 0 : file_, line_);
+    if (seqEnd) {
+      reset();
+    }
+  }
+}
+
 bool Dwarf::LineNumberVM::findAddress(
     uintptr_t target,
     Path& file,
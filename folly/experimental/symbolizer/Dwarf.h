@@ -18,10 +18,16 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <boost/variant.hpp>
 
 #include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
 #include <folly/experimental/symbolizer/Elf.h>
 
 namespace folly {
@@ -77,8 +83,19 @@ class Dwarf {
    * be live for as long as the passed-in ElfFile is live.
    */
  public:
-  /** Create a DWARF parser around an ELF file. */
-  explicit Dwarf(const ElfFile* elf);
+  /**
+   * Lookup tables that speed up findAddress, built lazily and kept across
+   * lookups in the same ELF file.
+   */
+  class Index;
+
+  /**
+   * Create a DWARF parser around an ELF file. If index is not null, it
+   * must have been created for the same file, and lookups use it instead
+   * of interpreting the DWARF records from scratch; note that this
+   * allocates memory.
+   */
+  explicit Dwarf(const ElfFile* elf, Index* index = nullptr);
 
   /**
    * Represent a file path a s collection of three parts (base directory,
@@ -162,6 +179,20 @@ class Dwarf {
   static bool
   findDebugInfoOffset(uintptr_t address, StringPiece aranges, uint64_t& offset);
 
+  /**
+   * Calls f(start, end) for each address range of the compilation unit,
+   * from the DW_AT_low_pc and DW_AT_high_pc or DW_AT_ranges attributes of
+   * its entry, until f returns false. Returns whether the entry has any
+   * such attributes.
+   */
+  bool forEachCompilationUnitRange(
+      const detail::CompilationUnit& cu,
+      folly::FunctionRef<bool(uint64_t, uint64_t)> f) const;
+
+  /** Whether the compilation unit may contain code at the given address. */
+  bool mayContainAddress(const detail::CompilationUnit& cu, uint64_t address)
+      const;
+
   /** Get an ELF section by name. */
   folly::StringPiece getSection(const char* name) const;
 
@@ -197,11 +228,73 @@ class Dwarf {
       folly::FunctionRef<bool(const detail::Attribute& die)> f) const;
 
   const ElfFile* elf_;
+  Index* index_;
   const folly::StringPiece debugInfo_; // .debug_info
   const folly::StringPiece debugAbbrev_; // .debug_abbrev
   const folly::StringPiece debugLine_; // .debug_line
   const folly::StringPiece debugStr_; // .debug_str
   const folly::StringPiece debugAranges_; // .debug_aranges
+  const folly::StringPiece debugRanges_; // .debug_ranges
+};
+
+/**
+ * Address ranges of all compilation units, sorted for binary search, and
+ * the decoded line number table of each compilation unit looked up so
+ * far. Unlike the rest of Dwarf, this allocates memory, so it must not be
+ * used where async-signal-safety is required. MT-safe.
+ */
+class Dwarf::Index {
+ public:
+  Index() = default;
+  Index(const Index&) = delete;
+  Index& operator=(const Index&) = delete;
+
+ private:
+  friend class Dwarf;
+
+  struct UnitRange {
+    uint64_t start;
+    uint64_t end;
+    uint64_t unitOffset;
+  };
+
+  // A row of the line number matrix; file is 0 at the end of a sequence.
+  struct LineRow {
+    uint64_t address;
+    uint64_t file;
+    uint64_t line;
+  };
+  using LineTable = std::vector<LineRow>;
+
+  void build(const Dwarf& dwarf);
+
+  /**
+   * Finds the offset in .debug_info of the compilation unit containing
+   * address. Returns false if there is none, in which case the units in
+   * unitsWithoutRanges() may still contain it.
+   */
+  bool findUnit(const Dwarf& dwarf, uint64_t address, uint64_t& offset);
+
+  const std::vector<uint64_t>& unitsWithoutRanges(const Dwarf& dwarf);
+
+  /**
+   * Looks up address in the line number program at lineOffset in
+   * .debug_line, decoding it on first use. Returns the file index and line.
+   */
+  bool findLine(
+      LineNumberVM& vm,
+      uint64_t lineOffset,
+      uint64_t address,
+      uint64_t& file,
+      uint64_t& line);
+
+  std::once_flag built_;
+  std::vector<UnitRange> ranges_;
+  // maxEnd_[i] is the largest end of ranges_[0..i], to handle overlaps.
+  std::vector<uint64_t> maxEnd_;
+  std::vector<uint64_t> unitsWithoutRanges_;
+  folly::Synchronized<std::unordered_map<uint64_t, std::unique_ptr<LineTable>>>
+      lineTables_;
 };
 
 class Dwarf::Section {
@@ -290,12 +383,30 @@ class Dwarf::LineNumberVM {
 
   bool findAddress(uintptr_t address, Path& file, uint64_t& line);
 
+  /**
+   * Calls f(address, file, line) for each row of the line number matrix,
+   * with file 0 for the row that ends a sequence.
+   */
+  void forEachRow(folly::FunctionRef<void(uint64_t, uint64_t, uint64_t)> f);
+
   /** Gets full file name at given index including directory. */
   Path getFullFileName(uint64_t index) const {
     auto fn = getFileName(index);
     return Path({}, getIncludeDirectory(fn.directoryIndex), fn.relativeName);
   }
 
+  /**
+   * Gets the path of the file at given index, including the compilation
+   * directory.
+   */
+  Path getPath(uint64_t index) const {
+    auto fn = getFileName(index);
+    return Path(
+        compilationDirectory_,
+        getIncludeDirectory(fn.directoryIndex),
+        fn.relativeName);
+  }
+
  private:
   void init();
   void reset();
@@ -91,6 +91,24 @@ std::shared_ptr<ElfFile> SignalSafeElfCache::getFile(StringPiece p) {
 ElfCache::ElfCache(size_t capacity) : capacity_(capacity) {}
 
 std::shared_ptr<ElfFile> ElfCache::getFile(StringPiece p) {
+  auto entry = getEntry(p);
+  return entry ? filePtr(entry) : nullptr;
+}
+
+std::shared_ptr<ElfFile> ElfCache::getFileWithDwarfIndex(
+    StringPiece p,
+    std::shared_ptr<Dwarf::Index>& index) {
+  auto entry = getEntry(p);
+  if (!entry) {
+    index.reset();
+    return nullptr;
+  }
+  // share ownership
+  index = std::shared_ptr<Dwarf::Index>(entry, &entry->dwarfIndex);
+  return filePtr(entry);
+}
+
+std::shared_ptr<ElfCache::Entry> ElfCache::getEntry(StringPiece p) {
   std::lock_guard<std::mutex> lock(mutex_);
 
   auto pos = files_.find(p);
@@ -99,7 +117,7 @@ std::shared_ptr<ElfFile> ElfCache::getFile(StringPiece p) {
     auto& entry = pos->second;
     lruList_.erase(lruList_.iterator_to(*entry));
     lruList_.push_back(*entry);
-    return filePtr(entry);
+    return entry;
   }
 
   auto entry = std::make_shared<Entry>();
@@ -121,7 +139,7 @@ std::shared_ptr<ElfFile> ElfCache::getFile(StringPiece p) {
   files_.emplace(entry->path, entry);
   lruList_.push_back(*entry);
 
-  return filePtr(entry);
+  return entry;
 }
 
 std::shared_ptr<ElfFile> ElfCache::filePtr(const std::shared_ptr<Entry>& e) {
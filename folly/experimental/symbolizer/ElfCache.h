@@ -30,6 +30,7 @@
 #include <glog/logging.h>
 
 #include <folly/Range.h>
+#include <folly/experimental/symbolizer/Dwarf.h>
 #include <folly/experimental/symbolizer/Elf.h>
 #include <folly/hash/Hash.h>
 
@@ -44,6 +45,18 @@ size_t countLoadedElfFiles();
 class ElfCacheBase {
  public:
   virtual std::shared_ptr<ElfFile> getFile(StringPiece path) = 0;
+
+  /**
+   * Like getFile(), but also returns the lookup tables kept to speed up
+   * Dwarf::findAddress in the file, or nullptr if the cache keeps none.
+   */
+  virtual std::shared_ptr<ElfFile> getFileWithDwarfIndex(
+      StringPiece path,
+      std::shared_ptr<Dwarf::Index>& index) {
+    index.reset();
+    return getFile(path);
+  }
+
   virtual ~ElfCacheBase() {}
 };
 
@@ -114,6 +127,8 @@ class SignalSafeElfCache : public ElfCacheBase {
  * General-purpose ELF file cache.
  *
  * LRU of given capacity. MT-safe (uses locking). Not async-signal-safe.
+ * Keeps a Dwarf::Index for each file, so repeated lookups in the same file
+ * do not have to interpret its DWARF records again.
  */
 class ElfCache : public ElfCacheBase {
  public:
@@ -121,6 +136,10 @@ class ElfCache : public ElfCacheBase {
 
   std::shared_ptr<ElfFile> getFile(StringPiece path) override;
 
+  std::shared_ptr<ElfFile> getFileWithDwarfIndex(
+      StringPiece path,
+      std::shared_ptr<Dwarf::Index>& index) override;
+
  private:
   std::mutex mutex_;
 
@@ -129,9 +148,12 @@ class ElfCache : public ElfCacheBase {
   struct Entry {
     std::string path;
     ElfFile file;
+    Dwarf::Index dwarfIndex;
     LruLink lruLink;
   };
 
+  std::shared_ptr<Entry> getEntry(StringPiece path);
+
   static std::shared_ptr<ElfFile> filePtr(const std::shared_ptr<Entry>& e);
 
   size_t capacity_;
@@ -429,6 +429,7 @@ void innerSignalHandler(int signum, siginfo_t* info, void* /* uctx */) {
   dumpTimeInfo();
   dumpSignalInfo(signum, info);
   gStackTracePrinter->printStackTrace(true); // with symbolization
+  gStackTracePrinter->printAsyncStackTrace(true);
 
   // Run user callbacks
   auto callbacks = gFatalSignalCallbackRegistry.load(std::memory_order_acquire);
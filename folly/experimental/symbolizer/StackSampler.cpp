@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/symbolizer/StackSampler.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <folly/Random.h>
+#include <folly/ScopeGuard.h>
+#include <folly/experimental/symbolizer/StackTrace.h>
+#include <folly/hash/Hash.h>
+
+namespace folly {
+namespace symbolizer {
+
+size_t StackTable::add(
+    folly::Range<const uintptr_t*> addresses,
+    uint64_t weight) {
+  for (auto key = hash::hash_range(addresses.begin(), addresses.end());;
+       ++key) {
+    auto result = ids_.try_emplace(key, entries_.size());
+    if (result.second) {
+      entries_.push_back({addresses_.size(), addresses.size(), 1, weight});
+      addresses_.insert(addresses_.end(), addresses.begin(), addresses.end());
+      return result.first->second;
+    }
+    auto& entry = entries_[result.first->second];
+    auto begin = addresses_.begin() + entry.offset;
+    if (entry.size == addresses.size() &&
+        std::equal(addresses.begin(), addresses.end(), begin)) {
+      ++entry.samples;
+      entry.weight += weight;
+      return result.first->second;
+    }
+  }
+}
+
+StackTable::Stack StackTable::stack(size_t id) const {
+  auto const& entry = entries_.at(id);
+  auto begin = addresses_.data() + entry.offset;
+  return {{begin, entry.size}, entry.samples, entry.weight};
+}
+
+std::vector<SymbolizedFrame> StackTable::symbolize(
+    size_t id,
+    Symbolizer& symbolizer) const {
+  auto addresses = stack(id).addresses;
+  std::vector<SymbolizedFrame> frames(addresses.size());
+  symbolizer.symbolize(addresses, folly::range(frames));
+  return frames;
+}
+
+void StackTable::clear() {
+  addresses_.clear();
+  entries_.clear();
+  ids_.clear();
+}
+
+/**
+ * Single-producer single-consumer queue of the samples of one thread. The
+ * producer is the owning thread, including its signal handlers; samples
+ * taken by a handler that interrupted another sample are dropped. The
+ * consumer is collect(), under the lock on rings_.
+ */
+class StackSampler::Ring {
+ public:
+  Ring(const Options& options, uintptr_t stackEnd)
+      : capacity_(std::max<size_t>(options.ringCapacity, 1)),
+        maxFrames_(options.maxFrames),
+        frameCapacity_(
+            std::max<size_t>({options.ringFrames, options.maxFrames, 1})),
+        samplingPeriod_(options.samplingPeriod),
+        stackEnd_(stackEnd),
+        samples_(new Sample[capacity_]),
+        frames_(new uintptr_t[frameCapacity_]),
+        random_(folly::Random::rand64() | 1) {
+    untilNextSample_ = nextSamplingInterval();
+  }
+
+  bool push(const void* frame, uint64_t weight) {
+    if (busy_.exchange(true, std::memory_order_acquire)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    SCOPE_EXIT {
+      busy_.store(false, std::memory_order_release);
+    };
+    return pushLocked(frame, weight);
+  }
+
+  bool maybePush(const void* frame, uint64_t weight) {
+    if (samplingPeriod_ <= 1) {
+      return push(frame, weight);
+    }
+    if (weight == 0) {
+      return false;
+    }
+    if (busy_.exchange(true, std::memory_order_acquire)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    SCOPE_EXIT {
+      busy_.store(false, std::memory_order_release);
+    };
+    if (weight < untilNextSample_) {
+      untilNextSample_ -= weight;
+      return false;
+    }
+    untilNextSample_ = nextSamplingInterval();
+    // Each unit of weight is sampled with probability 1/samplingPeriod, so
+    // an event of weight w is sampled with probability 1 - exp(-w/period).
+    auto const period = double(samplingPeriod_);
+    auto const scaled = weight / -std::expm1(-(weight / period));
+    return pushLocked(frame, uint64_t(std::llround(scaled)));
+  }
+
+  size_t drain(StackTable& table) {
+    auto const head = head_.load(std::memory_order_acquire);
+    auto const tail = tail_.load(std::memory_order_relaxed);
+    for (auto i = tail; i != head; ++i) {
+      auto const& sample = samples_[i % capacity_];
+      auto begin = frames_.get() + sample.start % frameCapacity_;
+      table.add({begin, sample.depth}, sample.weight);
+    }
+    if (head != tail) {
+      auto const& last = samples_[(head - 1) % capacity_];
+      frameTail_.store(last.start + last.depth, std::memory_order_release);
+    }
+    tail_.store(head, std::memory_order_release);
+    return head - tail;
+  }
+
+  std::atomic<bool> exited{false};
+  std::atomic<uint64_t> dropped{0};
+
+ private:
+  struct Sample {
+    uint64_t weight;
+    // position of the first frame in the frames ring
+    uint64_t start;
+    size_t depth;
+  };
+
+  bool pushLocked(const void* frame, uint64_t weight) {
+    auto const head = head_.load(std::memory_order_relaxed);
+    // Room for maxFrames_ frames is needed in one piece, so a sample that
+    // would wrap around starts at the beginning of the frames ring instead.
+    auto start = frameHead_;
+    if (start % frameCapacity_ + maxFrames_ > frameCapacity_) {
+      start += frameCapacity_ - start % frameCapacity_;
+    }
+    // Once the samples before the last skipped end of the ring have been
+    // drained, the frames are free up to the sample after it.
+    auto frameTail = frameTail_.load(std::memory_order_acquire);
+    if (frameTail == gapBegin_) {
+      frameTail = gapEnd_;
+    }
+    if (head - tail_.load(std::memory_order_acquire) == capacity_ ||
+        start + maxFrames_ - frameTail > frameCapacity_) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (start != frameHead_) {
+      gapBegin_ = frameHead_;
+      gapEnd_ = start;
+    }
+    auto& sample = samples_[head % capacity_];
+    auto depth = detail::walkFramePointers(
+        frame,
+        frames_.get() + start % frameCapacity_,
+        maxFrames_,
+        stackEnd_);
+    sample.weight = weight;
+    sample.start = start;
+    sample.depth = depth < 0 ? 0 : size_t(depth);
+    frameHead_ = start + sample.depth;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Exponentially distributed with mean samplingPeriod_, so that samples
+  // form a Poisson process over the total weight.
+  uint64_t nextSamplingInterval() {
+    // xorshift64
+    random_ ^= random_ << 13;
+    random_ ^= random_ >> 7;
+    random_ ^= random_ << 17;
+    auto const uniform = double(random_ >> 11) / double(uint64_t(1) << 53);
+    return uint64_t(-std::log1p(-uniform) * double(samplingPeriod_));
+  }
+
+  const size_t capacity_;
+  const size_t maxFrames_;
+  const size_t frameCapacity_;
+  const uint64_t samplingPeriod_;
+  const uintptr_t stackEnd_;
+  const std::unique_ptr<Sample[]> samples_;
+  // The frames of the samples, one after the other.
+  const std::unique_ptr<uintptr_t[]> frames_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  // Only used by the producer: the end of the frames of the samples pushed,
+  // and the last end of the ring skipped to keep a sample in one piece.
+  uint64_t frameHead_{0};
+  uint64_t gapBegin_{0};
+  uint64_t gapEnd_{0};
+  // End of the frames of the samples drained so far.
+  std::atomic<uint64_t> frameTail_{0};
+  std::atomic<bool> busy_{false};
+  uint64_t random_;
+  uint64_t untilNextSample_;
+};
+
+struct StackSampler::LocalRing {
+  explicit LocalRing(std::shared_ptr<Ring> r) : ring(std::move(r)) {}
+  ~LocalRing() {
+    ring->exited.store(true, std::memory_order_release);
+  }
+
+  const std::shared_ptr<Ring> ring;
+};
+
+StackSampler::StackSampler(Options options)
+    : options_(options), localRing_([this] {
+        auto ring = std::make_shared<Ring>(options_, detail::threadStackEnd());
+        rings_.wlock()->push_back(ring);
+        return new LocalRing(std::move(ring));
+      }) {}
+
+StackSampler::~StackSampler() = default;
+
+StackSampler::Ring& StackSampler::localRing() {
+  return *localRing_->ring;
+}
+
+void StackSampler::registerThread() {
+  localRing();
+}
+
+FOLLY_NOINLINE bool StackSampler::sample(uint64_t weight) {
+  // Taking the frame address also makes sure this function has a frame.
+  return localRing().push(__builtin_frame_address(0), weight);
+}
+
+FOLLY_NOINLINE bool StackSampler::maybeSample(uint64_t weight) {
+  return localRing().maybePush(__builtin_frame_address(0), weight);
+}
+
+size_t StackSampler::collect(StackTable& table) {
+  size_t count = 0;
+  auto rings = rings_.wlock();
+  for (auto it = rings->begin(); it != rings->end();) {
+    auto& ring = **it;
+    // Nothing is pushed after the thread exits, so draining after seeing
+    // the flag collects everything.
+    bool exited = ring.exited.load(std::memory_order_acquire);
+    count += ring.drain(table);
+    if (exited) {
+      droppedByExited_ += ring.dropped.load(std::memory_order_relaxed);
+      it = rings->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return count;
+}
+
+uint64_t StackSampler::dropped() const {
+  auto rings = rings_.rlock();
+  uint64_t count = droppedByExited_.load();
+  for (auto const& ring : *rings) {
+    count += ring->dropped.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+} // namespace symbolizer
+} // namespace folly
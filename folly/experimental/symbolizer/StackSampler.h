@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/container/F14Map.h>
+#include <folly/experimental/symbolizer/Symbolizer.h>
+
+namespace folly {
+namespace symbolizer {
+
+/**
+ * Stack traces deduplicated into ids, each with the number of samples and
+ * total weight added for it. Symbolization is left until the stacks are
+ * read, and only done once per distinct stack.
+ *
+ * Not MT-safe.
+ */
+class StackTable {
+ public:
+  struct Stack {
+    folly::Range<const uintptr_t*> addresses;
+    uint64_t samples;
+    uint64_t weight;
+  };
+
+  /** Add a sample of the given stack trace, and return the stack's id. */
+  size_t add(folly::Range<const uintptr_t*> addresses, uint64_t weight = 1);
+
+  /** Number of distinct stacks; ids are 0 to size() - 1. */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /**
+   * Get the stack with the given id. The addresses are only valid until the
+   * next call to add().
+   */
+  Stack stack(size_t id) const;
+
+  /**
+   * Symbolize the stack with the given id, one frame per address. The result
+   * can be printed with SymbolizePrinter::println.
+   */
+  std::vector<SymbolizedFrame> symbolize(size_t id, Symbolizer& symbolizer)
+      const;
+
+  void clear();
+
+ private:
+  struct Entry {
+    size_t offset;
+    size_t size;
+    uint64_t samples;
+    uint64_t weight;
+  };
+
+  std::vector<uintptr_t> addresses_;
+  std::vector<Entry> entries_;
+  // Stack hash to id. Stacks whose hash collides with a different one take
+  // the next free hash value instead.
+  folly::F14FastMap<uint64_t, size_t> ids_;
+};
+
+/**
+ * Captures sampled stack traces, e.g. of allocations or lock contention,
+ * cheaply enough to stay enabled in production.
+ *
+ * Each thread captures stacks by following frame pointers (see
+ * getStackTraceFramePointers) into its own fixed-size ring buffer, and
+ * collect() moves them into a StackTable from any thread. Samples taken
+ * while a thread's ring is full are dropped and counted.
+ *
+ * sample() and maybeSample() are async-signal-safe once the calling thread
+ * has been registered, which the first call does; call registerThread()
+ * first on threads that sample from signal handlers. All methods are
+ * MT-safe.
+ */
+class StackSampler {
+ public:
+  struct Options {
+    Options() {}
+
+    /** Number of samples each thread can hold until the next collect(). */
+    size_t ringCapacity = 1024;
+
+    /**
+     * Number of frames each thread can hold until the next collect(), over
+     * all of its samples. Samples are dropped once either limit is reached;
+     * the defaults take about 90KB per thread.
+     */
+    size_t ringFrames = 8192;
+
+    /** Maximum number of frames captured per sample. */
+    size_t maxFrames = 64;
+
+    /**
+     * Mean weight between samples taken by maybeSample(), e.g. the number
+     * of bytes between sampled allocations.
+     */
+    uint64_t samplingPeriod = 1;
+  };
+
+  explicit StackSampler(Options options = Options());
+  ~StackSampler();
+
+  StackSampler(const StackSampler&) = delete;
+  StackSampler& operator=(const StackSampler&) = delete;
+
+  /** Allocate the calling thread's ring buffer, if not done already. */
+  void registerThread();
+
+  /**
+   * Capture the current stack trace with the given weight. Returns false if
+   * the sample was dropped.
+   */
+  bool sample(uint64_t weight = 1);
+
+  /**
+   * Capture the current stack trace for an event of the given weight, with
+   * probability such that each unit of weight is sampled once every
+   * samplingPeriod on average. The sample's weight is scaled up so that the
+   * sum of sampled weights estimates the total weight of all events.
+   * Returns whether a sample was taken.
+   */
+  bool maybeSample(uint64_t weight);
+
+  /**
+   * Move the samples captured by all threads into table, and return their
+   * number.
+   */
+  size_t collect(StackTable& table);
+
+  /** Number of samples dropped so far. */
+  uint64_t dropped() const;
+
+ private:
+  class Ring;
+  struct LocalRing;
+
+  Ring& localRing();
+
+  const Options options_;
+  Synchronized<std::vector<std::shared_ptr<Ring>>> rings_;
+  // Drops counted by rings of threads that have since exited.
+  std::atomic<uint64_t> droppedByExited_{0};
+  ThreadLocal<LocalRing, StackSampler> localRing_;
+};
+
+} // namespace symbolizer
+} // namespace folly
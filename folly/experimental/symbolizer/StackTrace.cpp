@@ -24,6 +24,8 @@
 #include <execinfo.h>
 #endif
 
+#include <folly/portability/PThread.h>
+
 namespace folly {
 namespace symbolizer {
 
@@ -90,5 +92,78 @@ ssize_t getStackTraceSafe(uintptr_t* addresses, size_t maxAddresses) {
   }
   return count;
 }
+
+ssize_t getStackTraceFramePointers(uintptr_t* addresses, size_t maxAddresses) {
+  return detail::walkFramePointers(
+      __builtin_frame_address(0),
+      addresses,
+      maxAddresses,
+      detail::threadStackEnd());
+}
+
+namespace detail {
+
+uintptr_t threadStackEnd() {
+  static thread_local bool known = false;
+  static thread_local uintptr_t end = 0;
+  if (known) {
+    return end;
+  }
+#if defined(_GNU_SOURCE) && defined(__linux__)
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+    void* addr;
+    size_t size;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+      end = reinterpret_cast<uintptr_t>(addr) + size;
+    }
+    pthread_attr_destroy(&attr);
+  }
+#endif
+  known = true;
+  return end;
+}
+
+ssize_t walkFramePointers(
+    const void* frame,
+    uintptr_t* addresses,
+    size_t maxAddresses,
+    uintptr_t stackEnd) {
+#if defined(__x86_64__) || defined(__aarch64__)
+  // Both save the caller's frame pointer next to the return address, and
+  // point the frame pointer register at the pair.
+  struct Frame {
+    const Frame* next;
+    uintptr_t returnAddress;
+  };
+  // Without a known end of the stack, stop at frame pointers implausibly
+  // far away; they were most likely not set up by the caller.
+  constexpr uintptr_t kMaxFrameSize = 1 << 20;
+
+  auto current = static_cast<const Frame*>(frame);
+  size_t count = 0;
+  while (current && count < maxAddresses && current->returnAddress) {
+    addresses[count++] = current->returnAddress;
+    auto next = current->next;
+    auto addr = reinterpret_cast<uintptr_t>(next);
+    if (next <= current || addr % alignof(Frame) != 0 ||
+        (stackEnd ? addr + sizeof(Frame) > stackEnd
+                  : addr - reinterpret_cast<uintptr_t>(current) >
+                 kMaxFrameSize)) {
+      break;
+    }
+    current = next;
+  }
+  return count;
+#else
+  (void)frame;
+  (void)addresses;
+  (void)maxAddresses;
+  (void)stackEnd;
+  return -1;
+#endif
+}
+
+} // namespace detail
 } // namespace symbolizer
 } // namespace folly
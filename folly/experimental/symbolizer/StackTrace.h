@@ -44,5 +44,42 @@ ssize_t getStackTrace(uintptr_t* addresses, size_t maxAddresses);
  * Async-signal-safe, but likely slower.
  */
 ssize_t getStackTraceSafe(uintptr_t* addresses, size_t maxAddresses);
+
+/**
+ * Get the current stack trace into addresses, which has room for at least
+ * maxAddresses frames, by following the chain of frame pointers. The trace
+ * ends early at the first function on the stack compiled without frame
+ * pointers (-fno-omit-frame-pointer), and at functions called from it. Only
+ * frames within the calling thread's stack are followed.
+ *
+ * Returns the number of frames written in the array.
+ * Returns -1 if frame pointers are not supported on this platform.
+ *
+ * Much faster than either of the above. The first call on each thread looks
+ * up the bounds of its stack, which may allocate memory; after that, it is
+ * async-signal-safe.
+ */
+ssize_t getStackTraceFramePointers(uintptr_t* addresses, size_t maxAddresses);
+
+namespace detail {
+/**
+ * End of the calling thread's stack, or 0 if unknown. Looked up on the first
+ * call on each thread, which may allocate memory.
+ */
+uintptr_t threadStackEnd();
+
+/**
+ * Follow the chain of frame pointers starting from frame, the value of
+ * __builtin_frame_address(0) in some function; the first address written
+ * is that function's return address. If stackEnd is not zero, only frames
+ * below it are followed, which is safe even if a function without frame
+ * pointers left garbage in the frame pointer register.
+ */
+ssize_t walkFramePointers(
+    const void* frame,
+    uintptr_t* addresses,
+    size_t maxAddresses,
+    uintptr_t stackEnd = 0);
+} // namespace detail
 } // namespace symbolizer
 } // namespace folly
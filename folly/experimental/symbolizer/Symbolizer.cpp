@@ -34,6 +34,7 @@
 #include <folly/Memory.h>
 #include <folly/ScopeGuard.h>
 #include <folly/String.h>
+#include <folly/experimental/coro/AsyncStack.h>
 
 #include <folly/experimental/symbolizer/Dwarf.h>
 #include <folly/experimental/symbolizer/Elf.h>
@@ -66,7 +67,8 @@ void SymbolizedFrame::set(
     const std::shared_ptr<ElfFile>& file,
     uintptr_t address,
     Dwarf::LocationInfoMode mode,
-    folly::Range<Dwarf::LocationInfo*> inlineLocations) {
+    folly::Range<Dwarf::LocationInfo*> inlineLocations,
+    Dwarf::Index* dwarfIndex) {
   clear();
   found = true;
 
@@ -78,7 +80,8 @@ void SymbolizedFrame::set(
   file_ = file;
   name = file->getSymbolName(sym);
 
-  Dwarf(file.get()).findAddress(address, mode, location, inlineLocations);
+  Dwarf(file.get(), dwarfIndex)
+      .findAddress(address, mode, location, inlineLocations);
 }
 
 Symbolizer::Symbolizer(
@@ -134,7 +137,8 @@ void Symbolizer::symbolize(
     // as good as anything.
     auto const objPath = lmap->l_name[0] != '\0' ? lmap->l_name : selfPath;
 
-    auto const elfFile = cache_->getFile(objPath);
+    std::shared_ptr<Dwarf::Index> dwarfIndex;
+    auto const elfFile = cache_->getFileWithDwarfIndex(objPath, dwarfIndex);
     if (!elfFile) {
       continue;
     }
@@ -172,7 +176,8 @@ void Symbolizer::symbolize(
           Dwarf::LocationInfo inlineLocations[maxInline];
           folly::Range<Dwarf::LocationInfo*> inlineLocRange(
               inlineLocations, maxInline);
-          frame.set(elfFile, adjusted, mode_, inlineLocRange);
+          frame.set(
+              elfFile, adjusted, mode_, inlineLocRange, dwarfIndex.get());
 
           // Find out how many LocationInfo were filled in.
           size_t numInlined = std::distance(
@@ -203,7 +208,7 @@ void Symbolizer::symbolize(
           i += numInlined;
           addrCount += numInlined;
         } else {
-          frame.set(elfFile, adjusted, mode_);
+          frame.set(elfFile, adjusted, mode_, {}, dwarfIndex.get());
         }
         --remaining;
         if (symbolCache_ &&
@@ -443,6 +448,29 @@ void StringSymbolizePrinter::doPrint(StringPiece sp) {
   buf_.append(sp.data(), sp.size());
 }
 
+namespace {
+
+template <size_t N>
+bool getAsyncStackTrace(FrameArray<N>& fa) {
+  auto n = coro::getAsyncStackTrace(fa.addresses, N);
+  return detail::fixFrameArray(fa, std::min(n, N)) && fa.frameCount != 0;
+}
+
+} // namespace
+
+std::string getAsyncStackTraceStr() {
+  constexpr size_t kMaxAsyncStackTraceDepth = 100;
+  FrameArray<kMaxAsyncStackTraceDepth> addresses;
+  if (!getAsyncStackTrace(addresses)) {
+    return {};
+  }
+  Symbolizer symbolizer;
+  symbolizer.symbolize(addresses);
+  StringSymbolizePrinter printer;
+  printer.println(addresses);
+  return printer.str();
+}
+
 SafeStackTracePrinter::SafeStackTracePrinter(
     size_t minSignalSafeElfCacheSize,
     int fd)
@@ -497,6 +525,28 @@ void SafeStackTracePrinter::printStackTrace(bool symbolize) {
   }
 }
 
+void SafeStackTracePrinter::printAsyncStackTrace(bool symbolize) {
+  if (!getAsyncStackTrace(*addresses_)) {
+    return;
+  }
+  SCOPE_EXIT {
+    flush();
+  };
+
+  print("*** Async stack trace:\n");
+  if (symbolize) {
+    Symbolizer symbolizer(&elfCache_, Dwarf::LocationInfoMode::FULL);
+    symbolizer.symbolize(*addresses_);
+    printer_.println(*addresses_);
+  } else {
+    AddressFormatter formatter;
+    for (size_t i = 0; i < addresses_->frameCount; ++i) {
+      print(formatter.format(addresses_->addresses[i]));
+      print("\n");
+    }
+  }
+}
+
 FastStackTracePrinter::FastStackTracePrinter(
     std::unique_ptr<SymbolizePrinter> printer,
     size_t elfCacheSize,
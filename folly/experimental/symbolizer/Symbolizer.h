@@ -48,7 +48,8 @@ struct SymbolizedFrame {
       const std::shared_ptr<ElfFile>& file,
       uintptr_t address,
       Dwarf::LocationInfoMode mode,
-      folly::Range<Dwarf::LocationInfo*> inlineLocations = {});
+      folly::Range<Dwarf::LocationInfo*> inlineLocations = {},
+      Dwarf::Index* dwarfIndex = nullptr);
 
   void clear() {
     *this = SymbolizedFrame();
@@ -354,6 +355,12 @@ class StringSymbolizePrinter : public SymbolizePrinter {
   fbstring buf_;
 };
 
+/**
+ * Symbolized async stack trace of the coroutine running on this thread, or
+ * an empty string if there is none.  Not signal-safe.
+ */
+std::string getAsyncStackTraceStr();
+
 /**
  * Use this class to print a stack trace from a signal handler, or other place
  * where you shouldn't allocate memory on the heap, and fsync()ing your file
@@ -388,6 +395,13 @@ class SafeStackTracePrinter {
    */
   FOLLY_NOINLINE void printStackTrace(bool symbolize);
 
+  /**
+   * Print the async stack trace of the coroutine running on this thread, if
+   * any; see folly/experimental/coro/AsyncStack.h.  Same guarantees as
+   * printStackTrace().
+   */
+  void printAsyncStackTrace(bool symbolize);
+
   void print(StringPiece sp) {
     printer_.print(sp);
   }
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/symbolizer/StackSampler.h>
+
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <folly/experimental/symbolizer/StackTrace.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace folly::symbolizer;
+
+namespace {
+
+// Only the first frame, the caller of sample(), is checked by name; the
+// rest depend on whether the test is built with frame pointers. The empty
+// asm statements keep the calls to sample() from being tail calls.
+FOLLY_NOINLINE void sampleFoo(StackSampler& sampler, uint64_t weight = 1) {
+  sampler.sample(weight);
+  asm volatile("");
+}
+
+FOLLY_NOINLINE void sampleBar(StackSampler& sampler) {
+  sampler.sample();
+  asm volatile("");
+}
+
+// Samples taken from different lines of a test have different stacks when
+// it is built with frame pointers.
+uint64_t totalSamples(const StackTable& table) {
+  uint64_t total = 0;
+  for (size_t id = 0; id < table.size(); ++id) {
+    total += table.stack(id).samples;
+  }
+  return total;
+}
+
+std::string topFrameName(const StackTable& table, size_t id) {
+  Symbolizer symbolizer;
+  auto frames = table.symbolize(id, symbolizer);
+  return frames.empty() ? "" : frames[0].demangledName().toStdString();
+}
+
+} // namespace
+
+TEST(StackSampler, FramePointers) {
+  uintptr_t addresses[16];
+  auto n = getStackTraceFramePointers(addresses, 16);
+#if defined(__x86_64__) || defined(__aarch64__)
+  ASSERT_GE(n, 1);
+  EXPECT_EQ(0, getStackTraceFramePointers(addresses, 0));
+#else
+  EXPECT_EQ(-1, n);
+#endif
+}
+
+TEST(StackSampler, DeduplicatesStacks) {
+  StackSampler sampler;
+  for (int i = 0; i < 10; ++i) {
+    sampleFoo(sampler, 3);
+  }
+  sampleBar(sampler);
+
+  StackTable table;
+  EXPECT_EQ(11, sampler.collect(table));
+  ASSERT_EQ(2, table.size());
+  EXPECT_EQ(10, table.stack(0).samples);
+  EXPECT_EQ(30, table.stack(0).weight);
+  EXPECT_EQ(1, table.stack(1).samples);
+  EXPECT_EQ(0, sampler.collect(table));
+
+  EXPECT_NE(std::string::npos, topFrameName(table, 0).find("sampleFoo"));
+  EXPECT_NE(std::string::npos, topFrameName(table, 1).find("sampleBar"));
+
+  table.clear();
+  EXPECT_EQ(0, table.size());
+}
+
+TEST(StackSampler, DropsWhenFull) {
+  StackSampler::Options options;
+  options.ringCapacity = 4;
+  StackSampler sampler(options);
+  for (int i = 0; i < 10; ++i) {
+    sampleFoo(sampler);
+  }
+  StackTable table;
+  EXPECT_EQ(4, sampler.collect(table));
+  EXPECT_EQ(6, sampler.dropped());
+  sampleFoo(sampler);
+  EXPECT_EQ(1, sampler.collect(table));
+  EXPECT_EQ(5, totalSamples(table));
+}
+
+TEST(StackSampler, DropsWhenOutOfFrames) {
+  StackSampler::Options options;
+  options.maxFrames = 4;
+  options.ringFrames = 8;
+  StackSampler sampler(options);
+  // Each sample needs room for maxFrames frames.
+  for (int i = 0; i < 10; ++i) {
+    sampleFoo(sampler);
+  }
+  StackTable table;
+  auto collected = sampler.collect(table);
+  EXPECT_GE(collected, 2);
+  EXPECT_EQ(10, collected + sampler.dropped());
+  // Collecting frees the frames, including across the end of the ring.
+  for (int round = 0; round < 3; ++round) {
+    sampleFoo(sampler);
+    sampleFoo(sampler);
+    EXPECT_EQ(2, sampler.collect(table));
+  }
+  EXPECT_EQ(collected + 6, totalSamples(table));
+}
+
+TEST(StackSampler, CollectsExitedThreads) {
+  constexpr size_t kThreads = 4;
+  constexpr size_t kSamples = 100;
+  StackSampler sampler;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (size_t i = 0; i < kSamples; ++i) {
+        sampleFoo(sampler);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  StackTable table;
+  EXPECT_EQ(kThreads * kSamples, sampler.collect(table));
+  EXPECT_EQ(0, sampler.collect(table));
+  EXPECT_EQ(0, sampler.dropped());
+}
+
+TEST(StackSampler, MaybeSampleEstimatesTotalWeight) {
+  StackSampler::Options options;
+  options.ringCapacity = 1 << 14;
+  options.ringFrames = 1 << 20;
+  options.samplingPeriod = 1000;
+  StackSampler sampler(options);
+  uint64_t total = 0;
+  size_t taken = 0;
+  for (uint64_t i = 0; i < 200000; ++i) {
+    auto weight = 1 + i % 64;
+    total += weight;
+    taken += sampler.maybeSample(weight);
+  }
+  StackTable table;
+  EXPECT_EQ(taken, sampler.collect(table));
+  uint64_t estimate = 0;
+  for (size_t id = 0; id < table.size(); ++id) {
+    estimate += table.stack(id).weight;
+  }
+  // About 6500 samples, so the estimate is within a few percent.
+  EXPECT_NEAR(double(total), double(estimate), 0.1 * total);
+}
+
+namespace {
+StackSampler* signalSampler;
+
+void handler(int /* num */, siginfo_t* /* info */, void* /* ctx */) {
+  signalSampler->sample();
+  asm volatile("");
+}
+} // namespace
+
+TEST(StackSampler, SignalHandler) {
+  StackSampler sampler;
+  signalSampler = &sampler;
+  sampler.registerThread();
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = handler;
+  sa.sa_flags = SA_RESETHAND | SA_SIGINFO;
+  ASSERT_EQ(0, sigaction(SIGUSR1, &sa, nullptr));
+  raise(SIGUSR1);
+
+  StackTable table;
+  EXPECT_EQ(1, sampler.collect(table));
+  EXPECT_NE(std::string::npos, topFrameName(table, 0).find("handler"));
+}
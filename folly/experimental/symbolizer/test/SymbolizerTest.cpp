@@ -114,6 +114,38 @@ TEST_F(ElfCacheTest, SignalSafeElfCache) {
   }
 }
 
+TEST_F(ElfCacheTest, DwarfIndexMatchesLinearScan) {
+  // ElfCache looks up locations through a cached Dwarf::Index,
+  // SignalSafeElfCache through the heap-free scan of .debug_info.
+  ElfCache cache(100);
+  SignalSafeElfCache signalSafeCache(100);
+  for (auto mode :
+       {Dwarf::LocationInfoMode::FAST, Dwarf::LocationInfoMode::FULL}) {
+    Symbolizer indexed(&cache, mode);
+    Symbolizer scanned(&signalSafeCache, mode);
+    // Twice, to also use the line tables cached by the first run.
+    for (size_t run = 0; run < 2; ++run) {
+      FrameArray<100> a = goldenFrames;
+      FrameArray<100> b = goldenFrames;
+      for (size_t i = 0; i < a.frameCount; ++i) {
+        a.frames[i].clear();
+        b.frames[i].clear();
+      }
+      indexed.symbolize(a);
+      scanned.symbolize(b);
+      for (size_t i = 0; i < a.frameCount; ++i) {
+        EXPECT_EQ(
+            b.frames[i].location.hasFileAndLine,
+            a.frames[i].location.hasFileAndLine);
+        EXPECT_EQ(
+            b.frames[i].location.file.toString(),
+            a.frames[i].location.file.toString());
+        EXPECT_EQ(b.frames[i].location.line, a.frames[i].location.line);
+      }
+    }
+  }
+}
+
 TEST(SymbolizerTest, SymbolCache) {
   Symbolizer symbolizer(nullptr, Dwarf::LocationInfoMode::FULL, 100);
 
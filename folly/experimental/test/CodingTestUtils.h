@@ -145,6 +145,34 @@ void testNext(const std::vector<uint64_t>& data, const List& list) {
   EXPECT_EQ(reader.position(), reader.size());
 }
 
+template <class Reader, class List>
+void testNextBatch(const std::vector<uint64_t>& data, const List& list) {
+  for (size_t batch : {1, 7, 64}) {
+    Reader reader(list);
+    std::vector<typename Reader::ValueType> buf(batch);
+    size_t i = 0;
+    while (size_t n = reader.nextBatch(buf.data(), batch)) {
+      ASSERT_LE(i + n, data.size());
+      for (size_t j = 0; j < n; ++j) {
+        EXPECT_EQ(buf[j], data[i + j]);
+      }
+      i += n;
+      EXPECT_TRUE(reader.valid());
+      EXPECT_EQ(reader.value(), data[i - 1]);
+      EXPECT_EQ(reader.position(), i - 1);
+      // interleaved with the other operations
+      if (i < data.size() && i % 3 == 0) {
+        EXPECT_TRUE(reader.next());
+        EXPECT_EQ(reader.value(), data[i]);
+        ++i;
+      }
+    }
+    EXPECT_EQ(i, data.size());
+    EXPECT_FALSE(reader.valid());
+    EXPECT_EQ(reader.position(), reader.size());
+  }
+}
+
 template <class Reader, class List>
 void testSkip(
     const std::vector<uint64_t>& data,
@@ -366,6 +394,7 @@ template <class Reader, class Encoder>
 void testAll(const std::vector<uint64_t>& data) {
   auto list = Encoder::encode(data.begin(), data.end());
   testNext<Reader>(data, list);
+  testNextBatch<Reader>(data, list);
   testSkip<Reader>(data, list);
   testSkipTo<Reader>(data, list);
   testJump<Reader>(data, list);
@@ -389,6 +418,27 @@ void bmNext(const List& list, const std::vector<uint64_t>& data, size_t iters) {
   }
 }
 
+template <class Reader, class List>
+void bmNextBatch(
+    const List& list,
+    const std::vector<uint64_t>& data,
+    size_t iters) {
+  if (data.empty()) {
+    return;
+  }
+
+  constexpr size_t kBatch = 64;
+  typename Reader::ValueType buf[kBatch];
+  Reader reader(list);
+  for (size_t i = 0; i < iters; i += kBatch) {
+    if (LIKELY(reader.nextBatch(buf, kBatch))) {
+      folly::doNotOptimizeAway(buf[0]);
+    } else {
+      reader.reset();
+    }
+  }
+}
+
 template <class Reader, class List>
 void bmSkip(
     const List& list,
@@ -173,6 +173,57 @@ TEST_F(EliasFanoCodingTest, BugLargeGapInUpperBits) { // t16274876
   list.free();
 }
 
+TEST_F(EliasFanoCodingTest, NarrowSizeType) {
+  // SizeType narrower than the 64-bit values and upper bits offsets
+  typedef EliasFanoEncoderV2<uint64_t, uint32_t, 128, 128> Encoder;
+  typedef EliasFanoReader<Encoder, instructions::Default, false> Reader;
+  auto data = generateRandomList(100 * 1000, 10 * 1000 * 1000);
+  for (auto& value : data) {
+    value += uint64_t(1) << 40;
+  }
+  auto list = Encoder::encode(data.begin(), data.end());
+  testNextBatch<Reader>(data, list);
+  list.free();
+}
+
+TEST(EliasFanoCoding, Intersect) {
+  typedef EliasFanoEncoderV2<uint32_t, uint32_t, 128, 128> Encoder;
+  typedef EliasFanoReader<Encoder> Reader;
+  std::mt19937 gen;
+  // dense and dense, dense and sparse, and disjoint ranges
+  std::vector<std::pair<std::vector<uint64_t>, std::vector<uint64_t>>> cases;
+  cases.emplace_back(
+      generateRandomList(10000, 100000, gen),
+      generateRandomList(10000, 100000, gen));
+  cases.emplace_back(
+      generateRandomList(100000, 1000000, gen),
+      generateRandomList(100, 1000000, gen));
+  cases.emplace_back(generateSeqList(1, 1000), generateSeqList(2000, 3000));
+  cases.emplace_back(std::vector<uint64_t>{5}, generateSeqList(1, 10));
+
+  for (auto& c : cases) {
+    std::vector<uint64_t> expected;
+    std::set_intersection(
+        c.first.begin(),
+        c.first.end(),
+        c.second.begin(),
+        c.second.end(),
+        std::back_inserter(expected));
+    auto a = Encoder::encode(c.first.begin(), c.first.end());
+    auto b = Encoder::encode(c.second.begin(), c.second.end());
+    for (bool swapped : {false, true}) {
+      Reader ra(swapped ? b : a);
+      Reader rb(swapped ? a : b);
+      std::vector<uint64_t> found;
+      auto n = intersect(ra, rb, [&](uint32_t v) { found.push_back(v); });
+      EXPECT_EQ(expected.size(), n);
+      EXPECT_EQ(expected, found);
+    }
+    a.free();
+    b.free();
+  }
+}
+
 namespace bm {
 
 typedef EliasFanoEncoderV2<uint32_t, uint32_t, 128, 128> Encoder;
@@ -187,6 +238,9 @@ std::vector<std::pair<size_t, size_t>> numLowerBitsInput;
 
 typename Encoder::MutableCompressedList list;
 
+std::vector<uint64_t> intersectData;
+typename Encoder::MutableCompressedList intersectList;
+
 void init() {
   std::mt19937 gen;
 
@@ -197,6 +251,10 @@ void init() {
   std::iota(order.begin(), order.end(), size_t());
   std::shuffle(order.begin(), order.end(), gen);
 
+  intersectData = generateRandomList(1000 * 1000, 10 * 1000 * 1000, gen);
+  intersectList =
+      Encoder::encode(intersectData.begin(), intersectData.end());
+
   encodeSmallData = generateRandomList(10, 100 * 1000, gen);
   encodeLargeData = generateRandomList(1000 * 1000, 100 * 1000 * 1000, gen);
 
@@ -210,6 +268,7 @@ void init() {
 
 void free() {
   list.free();
+  intersectList.free();
 }
 
 } // namespace bm
@@ -221,6 +280,13 @@ BENCHMARK(Next, iters) {
   });
 }
 
+BENCHMARK(NextBatch, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmNextBatch<EliasFanoReader<bm::Encoder, decltype(instructions)>>(
+        bm::list, bm::data, iters);
+  });
+}
+
 size_t Skip_ForwardQ128(size_t iters, size_t logAvgSkip) {
   dispatchInstructions([&](auto instructions) {
     bmSkip<EliasFanoReader<bm::Encoder, decltype(instructions)>>(
@@ -271,6 +337,36 @@ BENCHMARK(JumpTo_SkipQ128, iters) {
 
 BENCHMARK_DRAW_LINE();
 
+// A list of 100K values with one of 1M values, in the same range, per
+// iteration; compared with a loop of next() and skipTo().
+BENCHMARK(IntersectNextSkipTo, iters) {
+  dispatchInstructions([&](auto instructions) {
+    using Reader = EliasFanoReader<bm::Encoder, decltype(instructions)>;
+    for (size_t i = 0; i < iters; ++i) {
+      Reader a(bm::list);
+      Reader b(bm::intersectList);
+      size_t count = 0;
+      while (a.next() && b.skipTo(a.value())) {
+        count += a.value() == b.value();
+      }
+      folly::doNotOptimizeAway(count);
+    }
+  });
+}
+
+BENCHMARK_RELATIVE(Intersect, iters) {
+  dispatchInstructions([&](auto instructions) {
+    using Reader = EliasFanoReader<bm::Encoder, decltype(instructions)>;
+    for (size_t i = 0; i < iters; ++i) {
+      Reader a(bm::list);
+      Reader b(bm::intersectList);
+      folly::doNotOptimizeAway(intersect(a, b, [](uint32_t) {}));
+    }
+  });
+}
+
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK(Encode_10) {
   auto list = bm::Encoder::encode(
       bm::encodeSmallData.begin(), bm::encodeSmallData.end());
@@ -15,6 +15,7 @@
  */
 
 #include <folly/experimental/FlatCombiningPriorityQueue.h>
+#include <folly/experimental/FlatCombiningAddressablePriorityQueue.h>
 #include <folly/Benchmark.h>
 #include <folly/portability/GTest.h>
 #include <glog/logging.h>
@@ -22,6 +23,9 @@
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include <random>
+#include <set>
+#include <thread>
 
 DEFINE_bool(bench, false, "run benchmark");
 DEFINE_int32(reps, 10, "number of reps");
@@ -269,6 +273,165 @@ TEST(FCPriQueue, push_pop) {
   }
 }
 
+TEST(FCPriQueue, pop_batch) {
+  FCPQ pq;
+  std::vector<int> out;
+  CHECK_EQ(pq.try_pop_batch(out, 4), 0);
+  for (int i = 0; i < 10; ++i) {
+    CHECK(pq.try_push(i));
+  }
+  CHECK_EQ(pq.try_pop_batch(out, 4), 4);
+  EXPECT_EQ(out, std::vector<int>({9, 8, 7, 6}));
+  CHECK_EQ(pq.size(), 6);
+
+  out.clear();
+  CHECK_EQ(pq.try_pop_batch_if(out, 10, [](int v) { return v >= 3; }), 3);
+  EXPECT_EQ(out, std::vector<int>({5, 4, 3}));
+  CHECK_EQ(pq.try_pop_batch(out, 10), 3);
+  EXPECT_EQ(out, std::vector<int>({5, 4, 3, 2, 1, 0}));
+  CHECK(pq.empty());
+}
+
+TEST(FCPriQueue, pop_batch_wakes_pushers) {
+  FCPQ pq(2);
+  pq.push(1);
+  pq.push(2);
+  std::thread pusher([&] {
+    pq.push(3);
+    pq.push(4);
+  });
+  std::vector<int> out;
+  while (out.size() < 4) {
+    pq.try_pop_batch(out, 2);
+  }
+  pusher.join();
+  EXPECT_EQ(out.size(), 4);
+  CHECK(pq.empty());
+}
+
+using FCAPQ = folly::FlatCombiningAddressablePriorityQueue<int>;
+
+TEST(FCAddressablePriQueue, basic) {
+  FCAPQ pq;
+  CHECK(pq.empty());
+  int v;
+  CHECK(!pq.try_pop(v));
+  CHECK(!pq.try_peek(v));
+  EXPECT_FALSE(bool(pq.try_pop()));
+
+  auto h1 = pq.push(1);
+  auto h2 = pq.push(2);
+  auto h3 = pq.push(3);
+  EXPECT_NE(h1, h2);
+  CHECK_EQ(pq.size(), 3);
+  CHECK(pq.try_peek(v));
+  CHECK_EQ(v, 3);
+
+  // increase and decrease keys
+  CHECK(pq.update(h1, 10));
+  CHECK(pq.try_peek(v));
+  CHECK_EQ(v, 10);
+  CHECK(pq.update(h1, 0));
+  CHECK(pq.try_peek(v));
+  CHECK_EQ(v, 3);
+
+  CHECK(pq.erase(h3));
+  CHECK(!pq.erase(h3));
+  CHECK(!pq.update(h3, 5));
+  CHECK_EQ(pq.size(), 2);
+
+  EXPECT_EQ(*pq.try_pop(), 2);
+  CHECK(!pq.update(h2, 5));
+  EXPECT_EQ(*pq.try_pop(), 0);
+  CHECK(pq.empty());
+  CHECK(!pq.erase(h1));
+}
+
+TEST(FCAddressablePriQueue, pop_batch) {
+  FCAPQ pq;
+  for (int i = 0; i < 10; ++i) {
+    pq.push(i);
+  }
+  std::vector<int> out;
+  CHECK_EQ(pq.try_pop_batch_if(out, 10, [](int v) { return v > 6; }), 3);
+  EXPECT_EQ(out, std::vector<int>({9, 8, 7}));
+  CHECK_EQ(pq.try_pop_batch(out, 2), 2);
+  EXPECT_EQ(out, std::vector<int>({9, 8, 7, 6, 5}));
+  CHECK_EQ(pq.size(), 5);
+}
+
+TEST(FCAddressablePriQueue, random_updates) {
+  // Compare against a sorted multiset
+  FCAPQ pq;
+  std::multiset<int> model;
+  std::vector<std::pair<FCAPQ::Handle, int>> items;
+  std::mt19937 rng(0);
+  for (int i = 0; i < 10000; ++i) {
+    auto op = rng() % 4;
+    if (op == 0 || items.empty()) {
+      int v = rng() % 1000;
+      items.emplace_back(pq.push(v), v);
+      model.insert(v);
+    } else {
+      auto idx = rng() % items.size();
+      auto& item = items[idx];
+      if (op == 1) {
+        int v = rng() % 1000;
+        CHECK(pq.update(item.first, v));
+        model.erase(model.find(item.second));
+        model.insert(v);
+        item.second = v;
+      } else {
+        CHECK(pq.erase(item.first));
+        model.erase(model.find(item.second));
+        items.erase(items.begin() + idx);
+      }
+    }
+    CHECK_EQ(pq.size(), model.size());
+    int v;
+    if (pq.try_peek(v)) {
+      CHECK_EQ(v, *model.rbegin());
+    }
+  }
+  std::vector<int> out;
+  pq.try_pop_batch(out, model.size());
+  EXPECT_EQ(out, std::vector<int>(model.rbegin(), model.rend()));
+}
+
+TEST(FCAddressablePriQueue, concurrent) {
+  const int ops = 1000;
+  for (auto n : nthr) {
+    FCAPQ pq;
+    std::atomic<int> popped{0};
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < n; ++tid) {
+      threads.emplace_back([&, tid] {
+        std::vector<int> out;
+        for (int i = tid; i < ops; i += n) {
+          auto h = pq.push(i);
+          // fails if another thread popped the item in the meantime
+          bool present = pq.update(h, i + 1);
+          if (i % 2) {
+            // odd items are never counted as popped
+            if (!present || !pq.erase(h)) {
+              popped -= 1;
+            }
+          } else {
+            popped += pq.try_pop_batch(out, 1);
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    std::vector<int> out;
+    popped += pq.try_pop_batch(out, ops);
+    CHECK(pq.empty());
+    EXPECT_EQ(popped.load(), ops / 2);
+  }
+}
+
 enum Exp {
   NoFC,
   FCNonBlock,
@@ -300,3 +300,60 @@ TEST(JemallocHugePageAllocatorTest, STLAllocator) {
     EXPECT_TRUE(jha::addressInArena(&map1[1][0]));
   }
 }
+
+TEST(JemallocHugePageAllocatorTest, Stats) {
+  bool initialized = jha::init(1);
+  auto before = jha::getStats();
+  if (initialized) {
+    EXPECT_GE(before.hugePages, 1);
+  } else {
+    EXPECT_EQ(0, before.hugePages);
+  }
+
+  // Larger than the arena, so it can only fall back
+  void* ptr = jha::allocate(mb(8));
+  EXPECT_NE(nullptr, ptr);
+  EXPECT_FALSE(jha::addressInArena(ptr));
+  auto after = jha::getStats();
+  if (initialized) {
+    EXPECT_GT(after.fallbackExtents, before.fallbackExtents);
+    EXPECT_GE(after.fallbackBytes, before.fallbackBytes + mb(8));
+  }
+  EXPECT_EQ(before.hugePageExtents, after.hugePageExtents);
+  jha::deallocate(ptr);
+}
+
+TEST(JemallocHugePageAllocatorTest, Growth) {
+  jha::Options options;
+  options.maxPages = 8;
+  bool initialized = jha::init(1, options);
+  if (!initialized) {
+    return;
+  }
+  EXPECT_EQ(mb(16), jha::freeSpace());
+  auto stats = jha::getStats();
+  EXPECT_EQ(1, stats.hugePages);
+  EXPECT_EQ(0, stats.growths);
+
+  // Needs more pages than init() touched
+  void* ptr1 = jha::allocate(mb(3));
+  void* ptr2 = jha::allocate(mb(3));
+  EXPECT_TRUE(jha::addressInArena(ptr1));
+  EXPECT_TRUE(jha::addressInArena(ptr2));
+  stats = jha::getStats();
+  EXPECT_GT(stats.hugePages, 1);
+  EXPECT_LE(stats.hugePages, 8);
+  EXPECT_GE(stats.growths, 1);
+  EXPECT_EQ(0, stats.fallbackExtents);
+
+  // Past maxPages, allocations fall back to regular pages
+  void* ptr3 = jha::allocate(mb(16));
+  EXPECT_FALSE(jha::addressInArena(ptr3));
+  stats = jha::getStats();
+  EXPECT_LE(stats.hugePages, 8);
+  EXPECT_GE(stats.fallbackExtents, 1);
+
+  jha::deallocate(ptr1);
+  jha::deallocate(ptr2);
+  jha::deallocate(ptr3);
+}
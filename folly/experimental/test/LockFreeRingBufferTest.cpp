@@ -15,7 +15,9 @@
  */
 
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <folly/experimental/LockFreeRingBuffer.h>
 #include <folly/portability/GTest.h>
@@ -297,4 +299,98 @@ TEST(LockFreeRingBuffer, writeReadDifferentType) {
   EXPECT_EQ(str, result.data_);
 }
 
+TEST(LockFreeRingBuffer, tryReadWith) {
+  struct Entry {
+    uint64_t id;
+    char payload[256];
+  };
+
+  LockFreeRingBuffer<Entry> rb(4);
+  auto cursor = rb.currentHead();
+  uint64_t id = 0;
+  EXPECT_FALSE(rb.tryReadWith(cursor, [&](const Entry& e) { id = e.id; }));
+
+  for (uint64_t i = 1; i <= 6; ++i) {
+    Entry e;
+    e.id = i;
+    rb.write(e);
+  }
+  // overwritten
+  EXPECT_FALSE(rb.tryReadWith(cursor, [&](const Entry& e) { id = e.id; }));
+
+  cursor = rb.currentTail();
+  const Entry* slot = nullptr;
+  EXPECT_TRUE(rb.tryReadWith(cursor, [&](const Entry& e) {
+    id = e.id;
+    slot = &e;
+  }));
+  EXPECT_EQ(3, id);
+  // the visitor sees the slot itself
+  EXPECT_TRUE(rb.tryReadWith(cursor, [&](const Entry& e) {
+    EXPECT_EQ(slot, &e);
+  }));
+}
+
+TEST(LockFreeRingBuffer, readLatest) {
+  const int capacity = 8;
+  LockFreeRingBuffer<int> rb(capacity);
+  int dest[capacity * 2];
+  EXPECT_EQ(0, rb.readLatest(dest, capacity));
+
+  for (int i = 0; i < 3; ++i) {
+    rb.write(i);
+  }
+  ASSERT_EQ(3, rb.readLatest(dest, capacity));
+  EXPECT_EQ(0, dest[0]);
+  EXPECT_EQ(2, dest[2]);
+  ASSERT_EQ(2, rb.readLatest(dest, 2));
+  EXPECT_EQ(1, dest[0]);
+  EXPECT_EQ(2, dest[1]);
+
+  for (int i = 3; i < 20; ++i) {
+    rb.write(i);
+  }
+  // no more than capacity values are available
+  ASSERT_EQ(capacity, rb.readLatest(dest, capacity * 2));
+  for (int i = 0; i < capacity; ++i) {
+    EXPECT_EQ(20 - capacity + i, dest[i]);
+  }
+}
+
+TEST(LockFreeRingBuffer, nonTriviallyCopyable) {
+  const int capacity = 4;
+  const int writes = 10000;
+  LockFreeRingBuffer<std::string> rb(capacity);
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&] {
+      std::string dest[capacity];
+      while (!done.load()) {
+        auto n = rb.readLatest(dest, capacity);
+        for (size_t i = 0; i < n; ++i) {
+          // every value read is one that was written in full
+          EXPECT_EQ(std::string(100, dest[i][0]), dest[i]);
+        }
+        rb.tryReadWith(rb.currentTail(1.0), [](const std::string& s) {
+          EXPECT_EQ(100, s.size());
+        });
+      }
+    });
+  }
+  for (int i = 0; i < writes; ++i) {
+    std::string value(100, 'a' + i % 26);
+    rb.write(value);
+  }
+  done = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+
+  std::string last;
+  EXPECT_TRUE(rb.tryRead(last, rb.currentTail(1.0)));
+  EXPECT_EQ(std::string(100, 'a' + (writes - 1) % 26), last);
+}
+
 } // namespace folly
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/experimental/EliasFanoCoding.h>
+#include <folly/experimental/PartitionedEliasFanoCoding.h>
+#include <folly/experimental/Select64.h>
+#include <folly/experimental/test/CodingTestUtils.h>
+#include <folly/init/Init.h>
+
+using namespace folly::compression;
+
+namespace {
+
+// Dense clusters of values separated by large gaps, as the docIDs of the
+// terms of an index sorted by URL.
+template <class URNG>
+std::vector<uint64_t> generateClusteredList(size_t n, URNG&& g) {
+  std::uniform_int_distribution<uint64_t> clusterSize(1, 2000);
+  std::uniform_int_distribution<uint64_t> gap(1, 1000000);
+  std::uniform_int_distribution<uint64_t> density(1, 8);
+  std::vector<uint64_t> result;
+  uint64_t value = 0;
+  while (result.size() < n) {
+    value += gap(g);
+    auto size = std::min<uint64_t>(clusterSize(g), n - result.size());
+    std::uniform_int_distribution<uint64_t> step(1, density(g));
+    for (uint64_t i = 0; i < size; ++i) {
+      value += step(g);
+      result.push_back(value);
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+class PartitionedEliasFanoCodingTest : public ::testing::Test {
+ public:
+  template <class Value>
+  void doTestAll() {
+    typedef PartitionedEliasFanoEncoder<Value> Encoder;
+    typedef PartitionedEliasFanoReader<Encoder> Reader;
+    std::mt19937 gen;
+    testAll<Reader, Encoder>(generateRandomList(100 * 1000, 10 * 1000 * 1000));
+    testAll<Reader, Encoder>(generateSeqList(1, 100000, 100));
+    testAll<Reader, Encoder>(generateSeqList(1, 100000));
+    testAll<Reader, Encoder>(generateClusteredList(100 * 1000, gen));
+    testAll<Reader, Encoder>(std::vector<uint64_t>{0});
+  }
+};
+
+TEST_F(PartitionedEliasFanoCodingTest, Empty) {
+  typedef PartitionedEliasFanoEncoder<uint32_t> Encoder;
+  typedef PartitionedEliasFanoReader<Encoder> Reader;
+  testEmpty<Reader, Encoder>();
+}
+
+TEST_F(PartitionedEliasFanoCodingTest, Simple32) {
+  doTestAll<uint32_t>();
+}
+
+TEST_F(PartitionedEliasFanoCodingTest, Simple64) {
+  doTestAll<uint64_t>();
+}
+
+TEST_F(PartitionedEliasFanoCodingTest, Partitions) {
+  // A run followed by a dense and a sparse range. Only the partition of the
+  // run is checked; how the other ranges are split depends on the costs.
+  std::vector<uint64_t> data = generateSeqList(0, 9999);
+  auto dense = generateSeqList(100000, 110000, 2);
+  data.insert(data.end(), dense.begin(), dense.end());
+  auto sparse = generateSeqList(1000000, 100000000, 10000);
+  data.insert(data.end(), sparse.begin(), sparse.end());
+
+  auto ends = folly::compression::detail::optimalPartition<uint64_t>(
+      data.begin(), data.size(), 0.03, 0.3);
+  ASSERT_FALSE(ends.empty());
+  EXPECT_EQ(data.size(), ends.back());
+  EXPECT_TRUE(std::is_sorted(ends.begin(), ends.end()));
+  // The run is a single partition.
+  EXPECT_EQ(10000, ends.front());
+
+  typedef PartitionedEliasFanoEncoder<uint64_t> Encoder;
+  testAll<PartitionedEliasFanoReader<Encoder>, Encoder>(data);
+}
+
+TEST_F(PartitionedEliasFanoCodingTest, SmallerThanEliasFano) {
+  typedef PartitionedEliasFanoEncoder<uint32_t> Encoder;
+  // Without skip and forward pointers, to compare the encodings.
+  typedef EliasFanoEncoderV2<uint32_t, uint32_t> EFEncoder;
+  std::mt19937 gen;
+  auto data = generateClusteredList(1000 * 1000, gen);
+  auto list = Encoder::encode(data.begin(), data.end());
+  auto efList = EFEncoder::encode(data.begin(), data.end());
+  EXPECT_LT(list.data.size(), efList.data.size() * 9 / 10);
+  list.free();
+  efList.free();
+}
+
+TEST_F(PartitionedEliasFanoCodingTest, Intersect) {
+  typedef PartitionedEliasFanoEncoder<uint32_t> Encoder;
+  typedef PartitionedEliasFanoReader<Encoder> Reader;
+  typedef EliasFanoEncoderV2<uint32_t, uint32_t, 128, 128> EFEncoder;
+  typedef EliasFanoReader<EFEncoder> EFReader;
+  std::mt19937 gen;
+  auto first = generateClusteredList(100000, gen);
+  auto second = generateRandomList(100000, first.back(), gen);
+  std::vector<uint64_t> expected;
+  std::set_intersection(
+      first.begin(),
+      first.end(),
+      second.begin(),
+      second.end(),
+      std::back_inserter(expected));
+
+  auto a = Encoder::encode(first.begin(), first.end());
+  auto b = Encoder::encode(second.begin(), second.end());
+  auto efB = EFEncoder::encode(second.begin(), second.end());
+  {
+    Reader ra(a);
+    Reader rb(b);
+    std::vector<uint64_t> found;
+    intersect(ra, rb, [&](uint32_t v) { found.push_back(v); });
+    EXPECT_EQ(expected, found);
+  }
+  {
+    Reader ra(a);
+    EFReader rb(efB);
+    std::vector<uint64_t> found;
+    intersect(ra, rb, [&](uint32_t v) { found.push_back(v); });
+    EXPECT_EQ(expected, found);
+  }
+  a.free();
+  b.free();
+  efB.free();
+}
+
+namespace bm {
+
+typedef PartitionedEliasFanoEncoder<uint32_t> Encoder;
+typedef EliasFanoEncoderV2<uint32_t, uint32_t, 128, 128> EFEncoder;
+
+std::vector<uint64_t> data;
+std::vector<size_t> order;
+
+typename Encoder::MutableCompressedList list;
+typename EFEncoder::MutableCompressedList efList;
+
+void init() {
+  std::mt19937 gen;
+  data = generateClusteredList(1000 * 1000, gen);
+  list = Encoder::encode(data.begin(), data.end());
+  efList = EFEncoder::encode(data.begin(), data.end());
+
+  order.resize(data.size());
+  std::iota(order.begin(), order.end(), size_t());
+  std::shuffle(order.begin(), order.end(), gen);
+}
+
+void free() {
+  list.free();
+  efList.free();
+}
+
+} // namespace bm
+
+BENCHMARK(EliasFanoNext, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmNext<EliasFanoReader<bm::EFEncoder, decltype(instructions)>>(
+        bm::efList, bm::data, iters);
+  });
+}
+
+BENCHMARK_RELATIVE(PartitionedNext, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmNext<PartitionedEliasFanoReader<bm::Encoder, decltype(instructions)>>(
+        bm::list, bm::data, iters);
+  });
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(EliasFanoSkipTo, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmSkipTo<EliasFanoReader<bm::EFEncoder, decltype(instructions)>>(
+        bm::efList, bm::data, 7, iters);
+  });
+}
+
+BENCHMARK_RELATIVE(PartitionedSkipTo, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmSkipTo<PartitionedEliasFanoReader<bm::Encoder, decltype(instructions)>>(
+        bm::list, bm::data, 7, iters);
+  });
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(EliasFanoJumpTo, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmJumpTo<EliasFanoReader<bm::EFEncoder, decltype(instructions)>>(
+        bm::efList, bm::data, bm::order, iters);
+  });
+}
+
+BENCHMARK_RELATIVE(PartitionedJumpTo, iters) {
+  dispatchInstructions([&](auto instructions) {
+    bmJumpTo<PartitionedEliasFanoReader<bm::Encoder, decltype(instructions)>>(
+        bm::list, bm::data, bm::order, iters);
+  });
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  folly::init(&argc, &argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto ret = RUN_ALL_TESTS();
+  if (ret == 0 && FLAGS_benchmark) {
+    bm::init();
+    folly::runBenchmarks();
+    bm::free();
+  }
+
+  return ret;
+}
@@ -230,6 +230,37 @@ BENCHMARK_MULTI(QuotientMultiSetGetRandom) {
   return ret;
 }
 
+template <class Reader>
+size_t benchmarkBatched(const Reader& reader, double hitRate) {
+  auto keys = makeLookupKeys(kRunsPerIteration, hitRate);
+  std::vector<typename Reader::SlotRange> ranges;
+  {
+    folly::BenchmarkSuspender guard;
+    ranges.resize(keys.size());
+  }
+  reader.equalRanges(keys, ranges.data());
+  folly::doNotOptimizeAway(ranges.data());
+  return kRunsPerIteration;
+}
+
+BENCHMARK_MULTI(QuotientMultiSetGetHitsBatched) {
+  size_t ret = 0;
+  folly::compression::dispatchInstructions([&](auto instructions) {
+    auto reader = folly::QuotientMultiSet<decltype(instructions)>(qmsData);
+    ret = benchmarkBatched(reader, /* hitRate */ 1);
+  });
+  return ret;
+}
+
+BENCHMARK_MULTI(QuotientMultiSetGetRandomBatched) {
+  size_t ret = 0;
+  folly::compression::dispatchInstructions([&](auto instructions) {
+    auto reader = folly::QuotientMultiSet<decltype(instructions)>(qmsData);
+    ret = benchmarkBatched(reader, /* hitRate */ 0);
+  });
+  return ret;
+}
+
 BENCHMARK_MULTI(QuotientMultiSetGetHitsSmallWorkingSet) {
   size_t ret = 0;
   folly::compression::dispatchInstructions([&](auto instructions) {
@@ -18,9 +18,11 @@
 
 #include <random>
 
+#include <folly/FileUtil.h>
 #include <folly/Format.h>
 #include <folly/Random.h>
 #include <folly/container/Enumerate.h>
+#include <folly/experimental/TestUtil.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/portability/GTest.h>
 
@@ -287,4 +289,92 @@ TEST_F(QuotientMultiSetTest, RunendRightBeforeFirstOccupiedRunend) {
   buildAndValidate(keys, 8, 0.95);
 }
 
+TEST_F(QuotientMultiSetTest, FileBuilder) {
+  // Enough keys for the file builder to write several times.
+  std::vector<uint64_t> keys;
+  for (size_t idx = 0; idx < 200000; idx++) {
+    keys.push_back(folly::Random::rand32(rng));
+  }
+  std::sort(keys.begin(), keys.end());
+
+  folly::QuotientMultiSetBuilder builder(32, keys.size());
+  folly::IOBufQueue buff;
+  folly::test::TemporaryFile file;
+  folly::QuotientMultiSetFileBuilder fileBuilder(
+      folly::File(file.fd()), 32, keys.size());
+  for (const auto& iter : folly::enumerate(keys)) {
+    if (builder.insert(*iter)) {
+      builder.setBlockPayload(iter.index);
+    }
+    if (fileBuilder.insert(*iter)) {
+      fileBuilder.setBlockPayload(iter.index);
+    }
+  }
+  builder.close(buff);
+  fileBuilder.close();
+
+  std::string expected = buff.move()->coalesce().toString();
+  std::string written;
+  ASSERT_TRUE(folly::readFile(file.path().string().c_str(), written));
+  EXPECT_EQ(expected, written);
+
+  folly::QuotientMultiSet<> reader(expected);
+  folly::MappedQuotientMultiSet<> mapped(file.path().string().c_str());
+  for (size_t idx = 0; idx < 1000; idx++) {
+    uint64_t key = idx % 2 ? keys[folly::Random::rand32(keys.size(), rng)]
+                           : folly::Random::rand32(rng);
+    auto range = reader.equalRange(key);
+    auto mappedRange = mapped->equalRange(key);
+    EXPECT_EQ(bool(range), bool(mappedRange)) << key;
+    if (range) {
+      EXPECT_EQ(range.begin, mappedRange.begin) << key;
+      EXPECT_EQ(range.end, mappedRange.end) << key;
+    }
+  }
+}
+
+TEST_F(QuotientMultiSetTest, EqualRanges) {
+  std::vector<uint64_t> keys;
+  for (size_t idx = 0; idx < 10000; idx++) {
+    keys.push_back(folly::Random::rand32(rng) & 0xffffff);
+  }
+  std::sort(keys.begin(), keys.end());
+  folly::QuotientMultiSetBuilder builder(24, keys.size());
+  folly::IOBufQueue buff;
+  for (const auto key : keys) {
+    builder.insert(key);
+  }
+  builder.close(buff);
+  auto spBuf = buff.move();
+  folly::QuotientMultiSet<> reader(folly::StringPiece(spBuf->coalesce()));
+
+  // Hits, misses and keys out of range, in random order.
+  for (size_t n : {0, 1, 15, 16, 17, 1000}) {
+    std::vector<uint64_t> lookups;
+    for (size_t idx = 0; idx < n; idx++) {
+      switch (idx % 3) {
+        case 0:
+          lookups.push_back(keys[folly::Random::rand32(keys.size(), rng)]);
+          break;
+        case 1:
+          lookups.push_back(folly::Random::rand32(rng) & 0xffffff);
+          break;
+        default:
+          lookups.push_back(folly::Random::rand64(rng) | (1 << 24));
+          break;
+      }
+    }
+    std::vector<folly::QuotientMultiSet<>::SlotRange> ranges(n);
+    reader.equalRanges(lookups, ranges.data());
+    for (size_t idx = 0; idx < n; idx++) {
+      auto range = reader.equalRange(lookups[idx]);
+      EXPECT_EQ(bool(range), bool(ranges[idx])) << lookups[idx];
+      if (range) {
+        EXPECT_EQ(range.begin, ranges[idx].begin) << lookups[idx];
+        EXPECT_EQ(range.end, ranges[idx].end) << lookups[idx];
+      }
+    }
+  }
+}
+
 #endif // FOLLY_QUOTIENT_MULTI_SET_SUPPORTED
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/experimental/ShardedFunctionScheduler.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include <folly/Conv.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace folly;
+using std::chrono::milliseconds;
+
+namespace {
+
+// Waits up to 10s for pred to hold, so that the tests don't depend on exact
+// timing
+template <typename Pred>
+bool waitFor(Pred pred) {
+  for (int i = 0; i < 1000; ++i) {
+    if (pred()) {
+      return true;
+    }
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  return pred();
+}
+
+ShardedFunctionScheduler::Options shardedOptions(
+    size_t numShards,
+    Executor* executor = nullptr) {
+  ShardedFunctionScheduler::Options options;
+  options.numShards = numShards;
+  if (executor) {
+    options.executor = getKeepAliveToken(executor);
+  }
+  return options;
+}
+
+} // namespace
+
+TEST(ShardedFunctionScheduler, RunsAfterStart) {
+  ShardedFunctionScheduler fs(shardedOptions(4));
+  std::array<std::atomic<int>, 100> counts{};
+  for (size_t i = 0; i < counts.size(); ++i) {
+    fs.addFunction(
+        [&, i] { ++counts[i]; }, milliseconds(10), to<std::string>(i));
+  }
+  EXPECT_EQ(100, fs.numFunctions());
+
+  std::this_thread::sleep_for(milliseconds(50));
+  for (auto& count : counts) {
+    EXPECT_EQ(0, count);
+  }
+
+  EXPECT_TRUE(fs.start());
+  EXPECT_FALSE(fs.start());
+  EXPECT_TRUE(waitFor([&] {
+    return std::all_of(counts.begin(), counts.end(), [](auto& c) {
+      return c >= 3;
+    });
+  }));
+
+  EXPECT_TRUE(fs.shutdown());
+  EXPECT_FALSE(fs.shutdown());
+  auto total = [&] {
+    int n = 0;
+    for (auto& count : counts) {
+      n += count;
+    }
+    return n;
+  };
+  auto stopped = total();
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(stopped, total());
+}
+
+TEST(ShardedFunctionScheduler, Once) {
+  CPUThreadPoolExecutor executor(2);
+  ShardedFunctionScheduler fs(shardedOptions(2, &executor));
+  std::atomic<int> count{0};
+  for (int i = 0; i < 10; ++i) {
+    fs.addFunctionOnce([&] { ++count; }, to<std::string>(i), milliseconds(i));
+  }
+  fs.start();
+  EXPECT_TRUE(waitFor([&] { return fs.numFunctions() == 0; }));
+  EXPECT_EQ(10, count);
+
+  // Names can be reused once the function ran
+  Baton<> baton;
+  fs.addFunctionOnce([&] { baton.post(); }, "0");
+  EXPECT_TRUE(baton.try_wait_for(std::chrono::seconds(10)));
+}
+
+TEST(ShardedFunctionScheduler, Executor) {
+  CPUThreadPoolExecutor executor(4);
+  ShardedFunctionScheduler fs(shardedOptions(2, &executor));
+  std::atomic<int> running{0};
+  std::atomic<int> count{0};
+  std::atomic<bool> overlapped{false};
+  // A function never runs concurrently with itself, even with an interval
+  // shorter than its run time
+  fs.addFunction(
+      [&] {
+        if (running++ != 0) {
+          overlapped = true;
+        }
+        std::this_thread::sleep_for(milliseconds(5));
+        --running;
+        ++count;
+      },
+      milliseconds(0),
+      "busy");
+  fs.start();
+  EXPECT_TRUE(waitFor([&] { return count >= 10; }));
+  EXPECT_TRUE(fs.cancelFunctionAndWait("busy"));
+  EXPECT_EQ(0, running);
+  EXPECT_FALSE(overlapped);
+}
+
+TEST(ShardedFunctionScheduler, Cancel) {
+  CPUThreadPoolExecutor executor(1);
+  ShardedFunctionScheduler fs(shardedOptions(2, &executor));
+  fs.addFunction([] {}, milliseconds(10), "a");
+  EXPECT_THROW(
+      fs.addFunction([] {}, milliseconds(10), "a"), std::invalid_argument);
+  EXPECT_THROW(
+      fs.addFunction([] {}, milliseconds(-1), "b"), std::invalid_argument);
+  EXPECT_THROW(
+      fs.addFunction(nullptr, milliseconds(10), "b"), std::invalid_argument);
+
+  EXPECT_TRUE(fs.cancelFunction("a"));
+  EXPECT_FALSE(fs.cancelFunction("a"));
+  EXPECT_FALSE(fs.cancelFunctionAndWait("a"));
+  EXPECT_FALSE(fs.resetFunctionTimer("a"));
+  EXPECT_EQ(0, fs.numFunctions());
+
+  // cancelFunctionAndWait() waits for the run in progress
+  Baton<> started;
+  std::atomic<bool> done{false};
+  fs.addFunction(
+      [&] {
+        started.post();
+        std::this_thread::sleep_for(milliseconds(50));
+        done = true;
+      },
+      milliseconds(1000),
+      "slow");
+  fs.start();
+  started.wait();
+  EXPECT_TRUE(fs.cancelFunctionAndWait("slow"));
+  EXPECT_TRUE(done);
+
+  std::atomic<int> count{0};
+  for (int i = 0; i < 10; ++i) {
+    fs.addFunction([&] { ++count; }, milliseconds(10), to<std::string>(i));
+  }
+  EXPECT_TRUE(waitFor([&] { return count >= 10; }));
+  fs.cancelAllFunctions();
+  EXPECT_EQ(0, fs.numFunctions());
+}
+
+TEST(ShardedFunctionScheduler, ResetFunctionTimer) {
+  ShardedFunctionScheduler fs;
+  std::atomic<int> count{0};
+  fs.addFunction([&] { ++count; }, milliseconds(3600000), "hourly");
+  fs.start();
+  EXPECT_TRUE(waitFor([&] { return count == 1; }));
+  EXPECT_TRUE(fs.resetFunctionTimer("hourly"));
+  EXPECT_TRUE(waitFor([&] { return count == 2; }));
+}
+
+TEST(ShardedFunctionScheduler, ResetFunctionTimerWhileRunning) {
+  CPUThreadPoolExecutor executor(2);
+  ShardedFunctionScheduler fs(shardedOptions(1, &executor));
+  Baton<> started;
+  Baton<> release;
+  std::atomic<int> count{0};
+  fs.addFunction(
+      [&] {
+        if (count++ == 0) {
+          started.post();
+          release.wait();
+        }
+      },
+      milliseconds(3600000),
+      "hourly");
+  fs.start();
+  started.wait();
+  // The timer restarts when the run completes, rather than firing into a
+  // second executor task that waits for it.
+  EXPECT_TRUE(fs.resetFunctionTimer("hourly"));
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1, executor.getPoolStats().totalTaskCount);
+  release.post();
+  EXPECT_TRUE(waitFor([&] { return count == 2; }));
+}
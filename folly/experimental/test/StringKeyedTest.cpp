@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <folly/experimental/StringKeyedF14Map.h>
 #include <folly/experimental/StringKeyedMap.h>
 #include <folly/experimental/StringKeyedSet.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
@@ -24,12 +25,15 @@
 
 #include <glog/logging.h>
 
+#include <folly/Conv.h>
 #include <folly/Range.h>
 #include <folly/hash/Hash.h>
+#include <folly/memory/Arena.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/GTest.h>
 
 using folly::BasicStringKeyedUnorderedSet;
+using folly::StringKeyedF14Map;
 using folly::StringKeyedMap;
 using folly::StringKeyedSetBase;
 using folly::StringKeyedUnorderedMap;
@@ -504,6 +508,134 @@ TEST(StringKeyedMapTest, constructors) {
   EXPECT_EQ(map4.at("key1"), 1);
 }
 
+TEST(StringKeyedMapTest, arenaAllocator) {
+  folly::SysArena arena;
+  using Map = StringKeyedMap<
+      int,
+      std::less<StringPiece>,
+      folly::SysArenaAllocator<std::pair<const StringPiece, int>>>;
+  Map map{Map::allocator_type(arena)};
+  {
+    string s("hello");
+    map.emplace(s, 1);
+    map["world"] = 2;
+  }
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.at("hello"), 1);
+  EXPECT_EQ(map.at("world"), 2);
+  EXPECT_EQ(map.erase("hello"), 1);
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_GT(arena.bytesUsed(), 0);
+}
+
+TEST(StringKeyedF14MapTest, sanity) {
+  StringKeyedF14Map<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.size(), 0);
+
+  {
+    string s("hello");
+    StringPiece piece(s, 3);
+    map.insert({s, 1});
+    EXPECT_FALSE(map.emplace(s, 2).second);
+    EXPECT_TRUE(map.emplace(piece, 3).second);
+    EXPECT_TRUE(map.try_emplace("").second);
+  }
+
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_EQ(map.find("hello")->second, 1);
+  EXPECT_EQ(map.find(string("lo"))->second, 3);
+  EXPECT_EQ(map.at(""), 0);
+  EXPECT_TRUE(map.contains("lo"));
+  EXPECT_EQ(map.count("hell"), 0);
+
+  map.insert_or_assign("lo", 4);
+  EXPECT_EQ(map["lo"], 4);
+  EXPECT_EQ(map["new"], 0);
+  EXPECT_EQ(map.size(), 4);
+
+  map.erase(map.find("hello"));
+  EXPECT_EQ(map.erase("new"), 1);
+  EXPECT_EQ(map.erase("new"), 0);
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(map.find("hello"), map.end());
+}
+
+TEST(StringKeyedF14MapTest, constructors) {
+  StringKeyedF14Map<int> map{
+      {"hello", 1},
+      {"lo", 3},
+  };
+
+  StringKeyedF14Map<int> map2(map);
+  EXPECT_EQ(map2.size(), 2);
+  EXPECT_TRUE(map2 == map);
+  EXPECT_NE(&map.arena(), &map2.arena());
+  EXPECT_NE(map.find("hello")->first.data(), map2.find("hello")->first.data());
+
+  map2.erase("lo");
+  EXPECT_FALSE(map2 == map);
+  map2.clear();
+  EXPECT_TRUE(map2.empty());
+  map2.emplace("key1", 1);
+
+  // The keys stay in the moved arena.
+  auto key = map2.find("key1")->first;
+  StringKeyedF14Map<int> map3(std::move(map2));
+  EXPECT_EQ(map3.size(), 1);
+  EXPECT_EQ(map3.find("key1")->first.data(), key.data());
+  // The moved-from map gets an arena of its own.
+  map2.emplace("key2", 2);
+  EXPECT_NE(&map2.arena(), &map3.arena());
+  EXPECT_FALSE(map3.contains("key2"));
+
+  map3 = map;
+  EXPECT_TRUE(map3 == map);
+  map = std::move(map3);
+  EXPECT_EQ(map.at("lo"), 3);
+  map3.emplace("key3", 3);
+  EXPECT_NE(&map3.arena(), &map.arena());
+
+  StringKeyedF14Map<int> map4{{"a", 1}};
+  swap(map, map4);
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map4.size(), 2);
+  EXPECT_EQ(map4.at("hello"), 1);
+}
+
+TEST(StringKeyedF14MapTest, sharedArena) {
+  folly::SysArena arena(
+      folly::SysArena::kDefaultMinBlockSize,
+      folly::SysArena::kNoSizeLimit,
+      StringKeyedF14Map<int>::kArenaMaxAlign);
+  StringKeyedF14Map<int> map(arena);
+  StringKeyedF14Map<int> map2(arena);
+  for (int i = 0; i < 1000; ++i) {
+    map.emplace(folly::to<string>("key", i), i);
+    map2.emplace(folly::to<string>(i), i);
+  }
+  EXPECT_EQ(&map.arena(), &arena);
+  EXPECT_EQ(&map2.arena(), &arena);
+  // The key bytes are packed, without any per-key overhead.
+  size_t mapKeyBytes = 0;
+  for (auto& kv : map) {
+    mapKeyBytes += kv.first.size();
+  }
+  size_t keyBytes = mapKeyBytes;
+  for (auto& kv : map2) {
+    keyBytes += kv.first.size();
+  }
+  EXPECT_EQ(keyBytes, arena.bytesUsed());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(map.at(folly::to<string>("key", i)), i);
+    EXPECT_EQ(map2.at(folly::to<string>(i)), i);
+  }
+
+  StringKeyedF14Map<int> copy(map, arena);
+  EXPECT_TRUE(copy == map);
+  EXPECT_EQ(keyBytes + mapKeyBytes, arena.bytesUsed());
+}
+
 int main(int argc, char** argv) {
   FLAGS_logtostderr = true;
   google::InitGoogleLogging(argv[0]);
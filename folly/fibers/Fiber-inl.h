@@ -40,6 +40,22 @@ inline void* Fiber::getUserBuffer() {
   return &userBuffer_;
 }
 
+inline detail::FiberLocalStorage& Fiber::fiberLocals() {
+  if (!fiberLocals_) {
+    fiberLocals_ =
+        detail::FiberLocalStorage::inherit(std::move(inheritedFiberLocals_));
+  }
+  return *fiberLocals_;
+}
+
+inline std::shared_ptr<const detail::FiberLocalStorage>
+Fiber::fiberLocalsToInherit() const {
+  if (fiberLocals_) {
+    return fiberLocals_;
+  }
+  return inheritedFiberLocals_;
+}
+
 template <typename T>
 T& Fiber::LocalData::getSlow() {
   dataSize_ = sizeof(T);
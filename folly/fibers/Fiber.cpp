@@ -20,9 +20,11 @@
 #include <algorithm>
 #include <cstring>
 #include <stdexcept>
+#include <utility>
 
 #include <folly/Likely.h>
 #include <folly/Portability.h>
+#include <folly/detail/MemoryIdler.h>
 #include <folly/fibers/FiberManagerInternal.h>
 #include <folly/portability/SysSyscall.h>
 #include <folly/portability/Unistd.h>
@@ -68,20 +70,25 @@ void Fiber::resume() {
   }
 }
 
-Fiber::Fiber(FiberManager& fiberManager)
+Fiber::Fiber(FiberManager& fiberManager, size_t stackSize)
     : fiberManager_(fiberManager),
-      fiberStackSize_(fiberManager_.options_.stackSize),
+      fiberStackSize_(stackSize),
       fiberStackLimit_(fiberManager_.stackAllocator_.allocate(fiberStackSize_)),
       fiberImpl_([this] { fiberFunc(); }, fiberStackLimit_, fiberStackSize_) {
   fiberManager_.allFibers_.push_back(*this);
 }
 
-void Fiber::init(bool recordStackUsed) {
+void Fiber::init(bool recordStackUsed, const void* sampledTaskType) {
 // It is necessary to disable the logic for ASAN because we change
 // the fiber's stack.
 #ifndef FOLLY_SANITIZE_ADDRESS
   recordStackUsed_ = recordStackUsed;
-  if (UNLIKELY(recordStackUsed_ && !stackFilledWithMagic_)) {
+  sampledTaskType_ = sampledTaskType;
+  bool resetContext = std::exchange(stackReleased_, false);
+  // A sample has to measure this task only, so the stack is refilled even
+  // if it already was.
+  if (UNLIKELY(
+          (recordStackUsed_ && !stackFilledWithMagic_) || sampledTaskType_)) {
     CHECK_EQ(
         reinterpret_cast<intptr_t>(fiberStackLimit_) % sizeof(uint64_t), 0u);
     CHECK_EQ(fiberStackSize_ % sizeof(uint64_t), 0u);
@@ -91,7 +98,9 @@ void Fiber::init(bool recordStackUsed) {
         kMagic8Bytes);
 
     stackFilledWithMagic_ = true;
-
+    resetContext = true;
+  }
+  if (UNLIKELY(resetContext)) {
     // newer versions of boost allocate context on fiber stack,
     // need to create a new one
     fiberImpl_ =
@@ -99,6 +108,7 @@ void Fiber::init(bool recordStackUsed) {
   }
 #else
   (void)recordStackUsed;
+  (void)sampledTaskType;
 #endif
 }
 
@@ -112,6 +122,14 @@ Fiber::~Fiber() {
   fiberManager_.stackAllocator_.deallocate(fiberStackLimit_, fiberStackSize_);
 }
 
+void Fiber::releaseStack() {
+#ifndef FOLLY_SANITIZE_ADDRESS
+  folly::detail::MemoryIdler::releasePages(fiberStackLimit_, fiberStackSize_);
+  stackReleased_ = true;
+  stackFilledWithMagic_ = false;
+#endif
+}
+
 void Fiber::recordStackPosition() {
   // For ASAN builds, functions may run on fake stack.
   // So we cannot get meaningful stack position.
@@ -163,6 +181,10 @@ void Fiber::recordStackPosition() {
           fiberManager_.options_.stackSize - 64)
           << "Fiber stack overflow";
     }
+    if (UNLIKELY(sampledTaskType_ != nullptr)) {
+      fiberManager_.recordStackUsage(
+          sampledTaskType_, nonMagicInBytes(fiberStackLimit_, fiberStackSize_));
+    }
 
     state_ = INVALID;
 
@@ -26,6 +26,7 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Portability.h>
 #include <folly/fibers/BoostContextCompatibility.h>
+#include <folly/fibers/detail/FiberLocalStorage.h>
 #include <folly/io/async/Request.h>
 
 namespace folly {
@@ -33,6 +34,8 @@ namespace fibers {
 
 class Baton;
 class FiberManager;
+template <typename T>
+class FiberLocal;
 
 /**
  * @class Fiber
@@ -80,10 +83,16 @@ class Fiber {
 
   friend class Baton;
   friend class FiberManager;
+  template <typename T>
+  friend class FiberLocal;
 
-  explicit Fiber(FiberManager& fiberManager);
+  Fiber(FiberManager& fiberManager, size_t stackSize);
 
-  void init(bool recordStackUsed);
+  /**
+   * @param sampledTaskType  If not null, the stack used by the task is
+   *   measured and recorded for this task type.
+   */
+  void init(bool recordStackUsed, const void* sampledTaskType);
 
   template <typename F>
   void setFunction(F&& func);
@@ -107,6 +116,12 @@ class Fiber {
    */
   void recordStackPosition();
 
+  /**
+   * Gives the pages of the stack back to the system while the fiber sits in
+   * the pool. The fiber context is created again on the next init().
+   */
+  void releaseStack();
+
   FiberManager& fiberManager_; /**< Associated FiberManager */
   size_t fiberStackSize_;
   unsigned char* fiberStackLimit_;
@@ -115,6 +130,12 @@ class Fiber {
   folly::Function<void()> func_; /**< task function */
   bool recordStackUsed_{false};
   bool stackFilledWithMagic_{false};
+  bool stackReleased_{false};
+  /**
+   * Pool resizing period during which the fiber was returned to the pool
+   */
+  size_t pooledPeriod_{0};
+  const void* sampledTaskType_{nullptr};
 
   /**
    * Points to next fiber in remote ready list
@@ -173,6 +194,14 @@ class Fiber {
 
   LocalData localData_;
 
+  // Storage of FiberLocal's, created on first access. Until then this fiber
+  // shares the storage it inherits with the fibers it spawns.
+  detail::FiberLocalStorage& fiberLocals();
+  std::shared_ptr<const detail::FiberLocalStorage> fiberLocalsToInherit() const;
+
+  std::shared_ptr<detail::FiberLocalStorage> fiberLocals_;
+  std::shared_ptr<const detail::FiberLocalStorage> inheritedFiberLocals_;
+
   folly::IntrusiveListHook listHook_; /**< list hook for different FiberManager
                                            queues */
   folly::IntrusiveListHook globalListHook_; /**< list hook for global list */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/fibers/FiberManagerInternal.h>
+#include <folly/fibers/detail/FiberLocalStorage.h>
+
+namespace folly {
+namespace fibers {
+
+/**
+ * @class FiberLocal
+ *
+ * A value per fiber, like folly::ThreadLocal is a value per thread, with
+ * any number of FiberLocal's used by the same fibers. Outside of fibers the
+ * value is per thread.
+ *
+ * Unlike local<T>(), the values a fiber inherits from the fiber which
+ * spawned it are not copied when it is spawned but on first access, so
+ * that spawning fibers which never use some FiberLocal's costs nothing for
+ * them. This means that a fiber may see changes made by its parent after it
+ * was spawned, until it accesses the value. Tasks added with addTaskRemote()
+ * or addTaskStealable() get a copy of all the values instead, made when
+ * they are added.
+ *
+ * Accessing a value is a bounds check and an index once it was accessed by
+ * the fiber. Values are allocated separately, and ids are never reused, so
+ * FiberLocal's are meant to be long-lived, e.g. static.
+ */
+template <typename T>
+class FiberLocal {
+ public:
+  FiberLocal() : id_(detail::FiberLocalStorage::allocateId()) {}
+
+  FiberLocal(const FiberLocal&) = delete;
+  FiberLocal& operator=(const FiberLocal&) = delete;
+
+  T& get() const {
+    auto fm = FiberManager::getFiberManagerUnsafe();
+    if (fm && fm->currentFiber_) {
+      return fm->currentFiber_->fiberLocals().get<T>(id_);
+    }
+    return detail::FiberLocalStorage::threadStorage().get<T>(id_);
+  }
+
+  T* operator->() const {
+    return &get();
+  }
+
+  T& operator*() const {
+    return get();
+  }
+
+ private:
+  size_t id_;
+};
+
+} // namespace fibers
+} // namespace folly
@@ -24,6 +24,7 @@
 #include <glog/logging.h>
 
 #include <folly/fibers/Fiber.h>
+#include <folly/fibers/FiberManagerGroup.h>
 #include <folly/fibers/LoopController.h>
 
 #include <folly/ConstexprMath.h>
@@ -93,11 +94,20 @@ FiberManager::FiberManager(
           std::move(options)) {}
 
 FiberManager::~FiberManager() {
+  if (auto group = group_.load(std::memory_order_acquire)) {
+    group->remove(*this);
+  }
+  DCHECK(stealableTasks_.empty());
+
   loopController_.reset();
 
   while (!fibersPool_.empty()) {
     fibersPool_.pop_front_and_dispose([](Fiber* fiber) { delete fiber; });
   }
+  while (!smallFibersPool_.empty()) {
+    smallFibersPool_.pop_front_and_dispose(
+        [](Fiber* fiber) { delete fiber; });
+  }
   assert(readyFibers_.empty());
   assert(fibersActive_ == 0);
 }
@@ -112,10 +122,87 @@ const LoopController& FiberManager::loopController() const {
 
 bool FiberManager::hasTasks() const {
   return fibersActive_ > 0 || !remoteReadyQueue_.empty() ||
-      !remoteTaskQueue_.empty() || remoteCount_ > 0;
+      !remoteTaskQueue_.empty() || remoteCount_ > 0 ||
+      numStealableTasks_.load(std::memory_order_relaxed) > 0;
 }
 
-Fiber* FiberManager::getFiber() {
+void FiberManager::addStealableTask(std::unique_ptr<RemoteTask> task) {
+  size_t backlog;
+  {
+    std::lock_guard<folly::SpinLock> lg(stealableTasksLock_);
+    stealableTasks_.push_back(std::move(task));
+    backlog = numStealableTasks_.fetch_add(1, std::memory_order_relaxed);
+  }
+  ensureLoopScheduled();
+
+  auto group = group_.load(std::memory_order_acquire);
+  if (!group || backlog == 0) {
+    return;
+  }
+  // Idle managers only run their loop when woken up, so one of them gets a
+  // task, and steals the others once it has run it.
+  group->members_.withRLock([&](auto& members) {
+    for (auto* fm : members) {
+      if (fm == this || fm->localType_ != localType_ ||
+          !fm->idle_.exchange(false, std::memory_order_relaxed)) {
+        continue;
+      }
+      if (auto handedOver = popStealableTask(/* newest= */ true)) {
+        if (fm->remoteTaskQueue_.insertHead(handedOver.release())) {
+          fm->loopController_->scheduleThreadSafe();
+        }
+      }
+      return;
+    }
+  });
+}
+
+std::unique_ptr<FiberManager::RemoteTask> FiberManager::popStealableTask(
+    bool newest) {
+  std::lock_guard<folly::SpinLock> lg(stealableTasksLock_);
+  if (stealableTasks_.empty()) {
+    return nullptr;
+  }
+  std::unique_ptr<RemoteTask> task;
+  if (newest) {
+    task = std::move(stealableTasks_.back());
+    stealableTasks_.pop_back();
+  } else {
+    task = std::move(stealableTasks_.front());
+    stealableTasks_.pop_front();
+  }
+  numStealableTasks_.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+bool FiberManager::runStealableTask() {
+  auto task = popStealableTask(/* newest= */ false);
+  auto group = group_.load(std::memory_order_acquire);
+  if (!task && group) {
+    group->members_.withRLock([&](auto& members) {
+      FiberManager* victim = nullptr;
+      size_t most = 0;
+      for (auto* fm : members) {
+        auto count = fm->numStealableTasks_.load(std::memory_order_relaxed);
+        if (fm != this && fm->localType_ == localType_ && count > most) {
+          victim = fm;
+          most = count;
+        }
+      }
+      if (victim) {
+        // The owner runs its oldest tasks, thieves take the newest.
+        task = victim->popStealableTask(/* newest= */ true);
+      }
+    });
+  }
+  if (!task) {
+    return false;
+  }
+  runRemoteTask(std::move(task));
+  return true;
+}
+
+Fiber* FiberManager::getFiber(const void* taskType) {
   Fiber* fiber = nullptr;
 
   if (options_.fibersPoolResizePeriodMs > 0 && !fibersPoolResizerScheduled_) {
@@ -123,12 +210,23 @@ Fiber* FiberManager::getFiber() {
     fibersPoolResizerScheduled_ = true;
   }
 
-  if (fibersPool_.empty()) {
-    fiber = new Fiber(*this);
+  ++fiberId_;
+  bool recordStack = (options_.recordStackEvery != 0) &&
+      (fiberId_ % options_.recordStackEvery == 0);
+  bool sampleStack = taskType && (options_.sampleStackUsageEvery != 0) &&
+      (fiberId_ % options_.sampleStackUsageEvery == 0);
+  // Sampled tasks always get a large stack, so that they can't overflow a
+  // small one and their samples aren't bounded by its size.
+  bool small = !recordStack && !sampleStack && useSmallStack(taskType);
+
+  auto& pool = small ? smallFibersPool_ : fibersPool_;
+  if (pool.empty()) {
+    fiber = new Fiber(
+        *this, small ? options_.smallStackSize : options_.stackSize);
     ++fibersAllocated_;
   } else {
-    fiber = &fibersPool_.front();
-    fibersPool_.pop_front();
+    fiber = &pool.front();
+    pool.pop_front();
     assert(fibersPoolSize_ > 0);
     --fibersPoolSize_;
   }
@@ -136,13 +234,28 @@ Fiber* FiberManager::getFiber() {
   if (++fibersActive_ > maxFibersActiveLastPeriod_) {
     maxFibersActiveLastPeriod_ = fibersActive_;
   }
-  ++fiberId_;
-  bool recordStack = (options_.recordStackEvery != 0) &&
-      (fiberId_ % options_.recordStackEvery == 0);
-  fiber->init(recordStack);
+  fiber->init(recordStack, sampleStack ? taskType : nullptr);
   return fiber;
 }
 
+bool FiberManager::useSmallStack(const void* taskType) const {
+  if (!taskType || options_.smallStackSize == 0 ||
+      options_.smallStackSize >= options_.stackSize) {
+    return false;
+  }
+  auto it = stackUsage_.find(taskType);
+  return it != stackUsage_.end() &&
+      it->second.samples >= kMinStackUsageSamples &&
+      it->second.maxUsed <= options_.smallStackSize / 2;
+}
+
+void FiberManager::recordStackUsage(const void* taskType, size_t used) {
+  auto& usage = stackUsage_[taskType];
+  ++usage.samples;
+  usage.maxUsed = std::max(usage.maxUsed, used);
+  VLOG(4) << "Sampled stack usage: " << used;
+}
+
 void FiberManager::setExceptionCallback(FiberManager::ExceptionCallback ec) {
   assert(ec);
   exceptionCallback_ = std::move(ec);
@@ -184,15 +297,32 @@ void FiberManager::setPreemptRunner(InlineFunctionRunner* preemptRunner) {
 void FiberManager::doFibersPoolResizing() {
   while (fibersAllocated_ > maxFibersActiveLastPeriod_ &&
          fibersPoolSize_ > options_.maxFibersPoolSize) {
-    auto fiber = &fibersPool_.front();
+    // Large stacks go first.
+    auto& pool = fibersPool_.empty() ? smallFibersPool_ : fibersPool_;
+    auto fiber = &pool.front();
     assert(fiber != nullptr);
-    fibersPool_.pop_front();
+    pool.pop_front();
     delete fiber;
     --fibersPoolSize_;
     --fibersAllocated_;
   }
 
+  // The pools are LIFO, so the fibers that weren't used since the last
+  // period are at the back, behind those whose stacks were already released.
+  for (auto* pool : {&fibersPool_, &smallFibersPool_}) {
+    for (auto it = pool->rbegin(); it != pool->rend(); ++it) {
+      if (it->stackReleased_) {
+        continue;
+      }
+      if (it->pooledPeriod_ == fibersPoolResizePeriods_) {
+        break;
+      }
+      it->releaseStack();
+    }
+  }
+
   maxFibersActiveLastPeriod_ = fibersActive_;
+  ++fibersPoolResizePeriods_;
 }
 
 void FiberManager::FibersPoolResizer::run() {
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/fibers/FiberManagerGroup.h>
+
+#include <algorithm>
+
+#include <folly/fibers/FiberManagerInternal.h>
+
+#include <glog/logging.h>
+
+namespace folly {
+namespace fibers {
+
+FiberManagerGroup::~FiberManagerGroup() {
+  members_.withWLock([](auto& members) {
+    for (auto* fm : members) {
+      fm->group_.store(nullptr, std::memory_order_release);
+    }
+  });
+}
+
+void FiberManagerGroup::add(FiberManager& fm) {
+  members_.withWLock([&](auto& members) {
+    CHECK(!fm.group_.load(std::memory_order_acquire))
+        << "FiberManager is already in a group";
+    members.push_back(&fm);
+    fm.group_.store(this, std::memory_order_release);
+  });
+}
+
+void FiberManagerGroup::remove(FiberManager& fm) {
+  members_.withWLock([&](auto& members) {
+    auto it = std::find(members.begin(), members.end(), &fm);
+    if (it != members.end()) {
+      members.erase(it);
+      fm.group_.store(nullptr, std::memory_order_release);
+    }
+  });
+}
+
+} // namespace fibers
+} // namespace folly
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+
+namespace folly {
+namespace fibers {
+
+class FiberManager;
+
+/**
+ * Group of FiberManagers, usually of the different IO threads of a server,
+ * that run each other's stealable tasks: a manager that runs out of ready
+ * fibers steals the tasks added with FiberManager::addTaskStealable() to
+ * the manager of the group with the most of them pending.  Managers that
+ * have a backlog of stealable tasks also hand one over to an idle member,
+ * which wakes it up to steal the others.
+ *
+ * Only tasks that haven't started are stolen, and only the ones explicitly
+ * added as stealable, since most tasks depend on state that is local to the
+ * EventBase of their manager.  Managers only steal from managers with the
+ * same local type.
+ *
+ * Thread safe.  A manager can't be in more than one group, and is removed
+ * from its group when destroyed; the group must outlive its managers.
+ */
+class FiberManagerGroup {
+ public:
+  FiberManagerGroup() = default;
+  ~FiberManagerGroup();
+
+  FiberManagerGroup(const FiberManagerGroup&) = delete;
+  FiberManagerGroup& operator=(const FiberManagerGroup&) = delete;
+
+  void add(FiberManager& fm);
+  void remove(FiberManager& fm);
+
+ private:
+  friend class FiberManager;
+
+  folly::Synchronized<std::vector<FiberManager*>, folly::SharedMutex>
+      members_;
+};
+
+} // namespace fibers
+} // namespace folly
@@ -31,6 +31,7 @@
 #include <folly/fibers/Fiber.h>
 #include <folly/fibers/LoopController.h>
 #include <folly/fibers/Promise.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 namespace folly {
 namespace fibers {
@@ -42,7 +43,9 @@ inline FiberManager::Options preprocessOptions(FiberManager::Options opts) {
    * Adjust the stack size according to the multiplier config.
    * Typically used with sanitizers, which need a lot of extra stack space.
    */
-  opts.stackSize *= std::exchange(opts.stackSizeMultiplier, 1);
+  auto multiplier = std::exchange(opts.stackSizeMultiplier, 1);
+  opts.stackSize *= multiplier;
+  opts.smallStackSize *= multiplier;
   return opts;
 }
 
@@ -79,7 +82,9 @@ inline void FiberManager::activateFiber(Fiber* fiber) {
 #endif
 
   activeFiber_ = fiber;
+  FOLLY_SDT(folly, fiber_switch_in, this, fiber);
   fiber->fiberImpl_.activate();
+  FOLLY_SDT(folly, fiber_switch_out, this, fiber, int(fiber->state_));
 }
 
 inline void FiberManager::deactivateFiber(Fiber* fiber) {
@@ -167,11 +172,18 @@ inline void FiberManager::runReadyFiber(Fiber* fiber) {
     currentFiber_ = nullptr;
     fiber->rcontext_ = RequestContext::saveContext();
     fiber->localData_.reset();
+    fiber->fiberLocals_.reset();
+    fiber->inheritedFiberLocals_.reset();
     fiber->rcontext_.reset();
 
     if (fibersPoolSize_ < options_.maxFibersPoolSize ||
         options_.fibersPoolResizePeriodMs > 0) {
-      fibersPool_.push_front(*fiber);
+      fiber->pooledPeriod_ = fibersPoolResizePeriods_;
+      if (fiber->fiberStackSize_ == options_.stackSize) {
+        fibersPool_.push_front(*fiber);
+      } else {
+        smallFibersPool_.push_front(*fiber);
+      }
       ++fibersPoolSize_;
     } else {
       delete fiber;
@@ -240,6 +252,11 @@ inline void FiberManager::loopUntilNoReadyImpl() {
       isLoopScheduled_ = false;
     };
 
+    idle_.store(false, std::memory_order_relaxed);
+    SCOPE_EXIT {
+      idle_.store(readyFibers_.empty(), std::memory_order_relaxed);
+    };
+
     bool hadRemote = true;
     while (hadRemote) {
       while (!readyFibers_.empty()) {
@@ -257,18 +274,7 @@ inline void FiberManager::loopUntilNoReadyImpl() {
 
       auto hadRemoteTask =
           remoteTaskQueue_.sweepOnce([this](RemoteTask* taskPtr) {
-            std::unique_ptr<RemoteTask> task(taskPtr);
-            auto fiber = getFiber();
-            if (task->localData) {
-              fiber->localData_ = *task->localData;
-            }
-            fiber->rcontext_ = std::move(task->rcontext);
-
-            fiber->setFunction(std::move(task->func));
-            if (observer_) {
-              observer_->runnable(reinterpret_cast<uintptr_t>(fiber));
-            }
-            runReadyFiber(fiber);
+            runRemoteTask(std::unique_ptr<RemoteTask>(taskPtr));
           });
 
       if (hadRemoteTask) {
@@ -276,10 +282,28 @@ inline void FiberManager::loopUntilNoReadyImpl() {
       }
 
       hadRemote = hadRemoteTask || hadRemoteFiber;
+      if (!hadRemote && readyFibers_.empty()) {
+        hadRemote = runStealableTask();
+      }
     }
   });
 }
 
+inline void FiberManager::runRemoteTask(std::unique_ptr<RemoteTask> task) {
+  auto fiber = getFiber();
+  if (task->localData) {
+    fiber->localData_ = *task->localData;
+  }
+  fiber->inheritedFiberLocals_ = std::move(task->fiberLocals);
+  fiber->rcontext_ = std::move(task->rcontext);
+
+  fiber->setFunction(std::move(task->func));
+  if (observer_) {
+    observer_->runnable(reinterpret_cast<uintptr_t>(fiber));
+  }
+  runReadyFiber(fiber);
+}
+
 inline void FiberManager::runEagerFiber(Fiber* fiber) {
   runInMainContext([&] {
     auto prevCurrentFiber = std::exchange(currentFiber_, fiber);
@@ -337,7 +361,7 @@ template <typename F>
 Fiber* FiberManager::createTask(F&& func) {
   typedef AddTaskHelper<F> Helper;
 
-  auto fiber = getFiber();
+  auto fiber = getFiber(&TaskType<typename std::decay<F>::type>::id);
   initLocalData(*fiber);
 
   if (Helper::allocateInBuffer) {
@@ -380,11 +404,25 @@ void FiberManager::addTaskRemote(F&& func) {
     }
     return std::make_unique<RemoteTask>(std::forward<F>(func));
   }();
+  task->fiberLocals = snapshotFiberLocals();
   if (remoteTaskQueue_.insertHead(task.release())) {
     loopController_->scheduleThreadSafe();
   }
 }
 
+template <typename F>
+void FiberManager::addTaskStealable(F&& func) {
+  std::unique_ptr<RemoteTask> task;
+  if (currentFiber_) {
+    task = std::make_unique<RemoteTask>(
+        std::forward<F>(func), currentFiber_->localData_);
+  } else {
+    task = std::make_unique<RemoteTask>(std::forward<F>(func));
+  }
+  task->fiberLocals = snapshotFiberLocals();
+  addStealableTask(std::move(task));
+}
+
 template <typename X>
 struct IsRvalueRefTry {
   static const bool value = false;
@@ -468,7 +506,7 @@ Fiber* FiberManager::createTaskFinally(F&& func, G&& finally) {
               typename FirstArgOf<G>::type>::type::element_type>::value,
       "finally(Try<T>&&): T must be convertible from func()'s return type");
 
-  auto fiber = getFiber();
+  auto fiber = getFiber(&TaskType<typename std::decay<F>::type>::id);
   initLocalData(*fiber);
 
   typedef AddTaskFinallyHelper<
@@ -533,6 +571,15 @@ invoke_result_t<F> FiberManager::runInMainContext(F&& func) {
   return std::move(result).value();
 }
 
+template <typename F>
+const char FiberManager::TaskType<F>::id = 0;
+
+template <typename F>
+size_t FiberManager::sampledStackUsage() const {
+  auto it = stackUsage_.find(&TaskType<F>::id);
+  return it == stackUsage_.end() ? 0 : it->second.maxUsed;
+}
+
 inline FiberManager& FiberManager::getFiberManager() {
   assert(currentFiberManager_ != nullptr);
   return *currentFiberManager_;
@@ -574,19 +621,33 @@ T& FiberManager::localThread() {
 
 inline void FiberManager::initLocalData(Fiber& fiber) {
   auto fm = getFiberManagerUnsafe();
-  if (fm && fm->currentFiber_ && fm->localType_ == localType_) {
-    fiber.localData_ = fm->currentFiber_->localData_;
+  if (fm && fm->currentFiber_) {
+    if (fm->localType_ == localType_) {
+      fiber.localData_ = fm->currentFiber_->localData_;
+    }
+    fiber.inheritedFiberLocals_ = fm->currentFiber_->fiberLocalsToInherit();
   }
   fiber.rcontext_ = RequestContext::saveContext();
 }
 
+inline std::shared_ptr<const detail::FiberLocalStorage>
+FiberManager::snapshotFiberLocals() {
+  auto fm = getFiberManagerUnsafe();
+  if (fm && fm->currentFiber_) {
+    if (auto storage = fm->currentFiber_->fiberLocalsToInherit()) {
+      return storage->snapshot();
+    }
+  }
+  return nullptr;
+}
+
 template <typename LocalT>
 FiberManager::FiberManager(
     LocalType<LocalT>,
     std::unique_ptr<LoopController> loopController__,
     Options options)
     : loopController_(std::move(loopController__)),
-      stackAllocator_(options.guardPagesPerStack),
+      stackAllocator_(options.guardPagesPerStack, options.useSharedStackPool),
       options_(preprocessOptions(std::move(options))),
       exceptionCallback_([](std::exception_ptr eptr, std::string context) {
         try {
@@ -16,12 +16,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <queue>
 #include <thread>
 #include <type_traits>
 #include <typeindex>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -31,7 +34,9 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Likely.h>
 #include <folly/Portability.h>
+#include <folly/SpinLock.h>
 #include <folly/Try.h>
+#include <folly/executors/TimeSlice.h>
 #include <folly/functional/Invoke.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/io/async/Request.h>
@@ -52,6 +57,9 @@ namespace fibers {
 
 class Baton;
 class Fiber;
+class FiberManagerGroup;
+template <typename T>
+class FiberLocal;
 
 template <typename T>
 class LocalType {};
@@ -104,6 +112,25 @@ class FiberManager : public ::folly::Executor {
      */
     size_t recordStackEvery{0};
 
+    /**
+     * Measure the stack used by one task in this many, per task type (the
+     * type of the functor passed to addTask() and friends).
+     *
+     * Unlike recordStackEvery, the stack is refilled for every sampled task,
+     * so that each sample measures a single task, and an overflow isn't
+     * checked, so this is cheap enough for production.
+     * 0 disables sampling.
+     */
+    size_t sampleStackUsageEvery{0};
+
+    /**
+     * If not 0, tasks of a type that has been sampled kMinStackUsageSamples
+     * times without using more than half of this many bytes of stack run in
+     * fibers with stacks of this size rather than stackSize.  Sampled tasks
+     * always run with stackSize stacks.  Requires sampleStackUsageEvery.
+     */
+    size_t smallStackSize{0};
+
     /**
      * Keep at most this many free fibers in the pool.
      * This way the total number of fibers in the system is always bounded
@@ -116,10 +143,18 @@ class FiberManager : public ::folly::Executor {
      */
     size_t guardPagesPerStack{1};
 
+    /**
+     * Allocate the stacks that aren't guarded from the process-wide
+     * StackPool, so that they are reused across FiberManagers and placed on
+     * the NUMA node of the threads using them; see StackPool.
+     */
+    bool useSharedStackPool{false};
+
     /**
      * Free unnecessary fibers in the fibers pool every fibersPoolResizePeriodMs
-     * milliseconds. If value is 0, periodic resizing of the fibers pool is
-     * disabled.
+     * milliseconds, and give the stacks of the fibers that stayed in the pool
+     * for a whole period back to the system. If value is 0, periodic resizing
+     * of the fibers pool is disabled.
      */
     uint32_t fibersPoolResizePeriodMs{0};
 
@@ -130,8 +165,11 @@ class FiberManager : public ::folly::Executor {
           stackSize,
           stackSizeMultiplier,
           recordStackEvery,
+          sampleStackUsageEvery,
+          smallStackSize,
           maxFibersPoolSize,
           guardPagesPerStack,
+          useSharedStackPool,
           fibersPoolResizePeriodMs);
     }
   };
@@ -286,6 +324,20 @@ class FiberManager : public ::folly::Executor {
   template <typename F>
   void addTaskRemote(F&& func);
 
+  /**
+   * Add a new task to be executed, which an idle FiberManager of the
+   * FiberManagerGroup of this one may steal and run instead.  Stealable
+   * tasks run after the ready fibers of this FiberManager.
+   * Must be called from FiberManager's thread.
+   *
+   * @param func Task function; must have a signature of `void func()` and
+   *             must not depend on state local to the thread or EventBase
+   *             of this FiberManager.
+   *             The object will be destroyed once task execution is complete.
+   */
+  template <typename F>
+  void addTaskStealable(F&& func);
+
   /**
    * Add a new task to be executed and return a future that will be set on
    * return from func. Safe to call from other threads.
@@ -379,6 +431,20 @@ class FiberManager : public ::folly::Executor {
    */
   size_t stackHighWatermark() const;
 
+  /**
+   * Number of samples of a task type needed before it can run with a small
+   * stack; see Options::smallStackSize.
+   */
+  static constexpr size_t kMinStackUsageSamples = 16;
+
+  /**
+   * @return The most stack (in bytes) used by the sampled tasks of type F,
+   * where F is the decayed type of the functor passed to addTask(), or 0 if
+   * none was sampled; see Options::sampleStackUsageEvery.
+   */
+  template <typename F>
+  size_t sampledStackUsage() const;
+
   /**
    * Yield execution of the currently running fiber. Must only be called from a
    * fiber executing on this FiberManager. The calling fiber will be scheduled
@@ -425,6 +491,19 @@ class FiberManager : public ::folly::Executor {
   template <typename F, typename G>
   struct AddTaskFinallyHelper;
 
+  /**
+   * The address of id identifies the task type F.
+   */
+  template <typename F>
+  struct TaskType {
+    static const char id;
+  };
+
+  struct StackUsage {
+    size_t samples{0};
+    size_t maxUsed{0};
+  };
+
   struct RemoteTask {
     template <typename F>
     explicit RemoteTask(F&& f)
@@ -436,13 +515,36 @@ class FiberManager : public ::folly::Executor {
           rcontext(RequestContext::saveContext()) {}
     folly::Function<void()> func;
     std::unique_ptr<Fiber::LocalData> localData;
+    std::shared_ptr<const detail::FiberLocalStorage> fiberLocals;
     std::shared_ptr<RequestContext> rcontext;
     AtomicIntrusiveLinkedListHook<RemoteTask> nextRemoteTask;
   };
 
+  friend class FiberManagerGroup;
+  template <typename T>
+  friend class FiberLocal;
+
+  // Copy of the FiberLocal's of the current fiber, for a remote task
+  static std::shared_ptr<const detail::FiberLocalStorage>
+  snapshotFiberLocals();
+
   template <typename F>
   Fiber* createTask(F&& func);
 
+  void runRemoteTask(std::unique_ptr<RemoteTask> task);
+
+  void addStealableTask(std::unique_ptr<RemoteTask> task);
+
+  /**
+   * Runs a stealable task of this FiberManager or, if there is none, one
+   * stolen from another member of its group.
+   *
+   * @return Whether there was a task to run.
+   */
+  bool runStealableTask();
+
+  std::unique_ptr<RemoteTask> popStealableTask(bool newest);
+
   template <typename F, typename G>
   Fiber* createTaskFinally(F&& func, G&& finally);
 
@@ -469,6 +571,7 @@ class FiberManager : public ::folly::Executor {
   FiberTailQueue* yieldedFibers_{nullptr}; /**< queue of fibers which have
                                       yielded execution */
   FiberTailQueue fibersPool_; /**< pool of uninitialized Fiber objects */
+  FiberTailQueue smallFibersPool_; /**< same, with smallStackSize stacks */
 
   GlobalFiberTailQueue allFibers_; /**< list of all Fiber objects owned */
 
@@ -483,6 +586,11 @@ class FiberManager : public ::folly::Executor {
    */
   size_t maxFibersActiveLastPeriod_{0};
 
+  /**
+   * Number of periods of Options::fibersPoolResizePeriodMs so far.
+   */
+  size_t fibersPoolResizePeriods_{0};
+
   std::unique_ptr<LoopController> loopController_;
   bool isLoopScheduled_{false}; /**< was the ready loop scheduled to run? */
 
@@ -505,6 +613,11 @@ class FiberManager : public ::folly::Executor {
    */
   size_t stackHighWatermark_{0};
 
+  /**
+   * Sampled stack usage by task type.
+   */
+  std::unordered_map<const void*, StackUsage> stackUsage_;
+
   /**
    * Schedules a loop with loopController (unless already scheduled before).
    */
@@ -512,8 +625,14 @@ class FiberManager : public ::folly::Executor {
 
   /**
    * @return An initialized Fiber object from the pool
+   *
+   * @param taskType  Identifies the type of the task the fiber will run, if
+   *   known, for stack usage sampling and adaptive stack sizing.
    */
-  Fiber* getFiber();
+  Fiber* getFiber(const void* taskType = nullptr);
+
+  bool useSmallStack(const void* taskType) const;
+  void recordStackUsage(const void* taskType, size_t used);
 
   /**
    * Sets local data for given fiber if all conditions are met.
@@ -550,6 +669,16 @@ class FiberManager : public ::folly::Executor {
 
   ssize_t remoteCount_{0};
 
+  std::atomic<FiberManagerGroup*> group_{nullptr};
+  folly::SpinLock stealableTasksLock_;
+  std::deque<std::unique_ptr<RemoteTask>> stealableTasks_;
+  std::atomic<size_t> numStealableTasks_{0};
+  /**
+   * Whether the last loop ended without ready fibers; a hint for the other
+   * members of the group.
+   */
+  std::atomic<bool> idle_{true};
+
   /**
    * Number of uncaught exceptions when FiberManager loop was called.
    */
@@ -701,6 +830,17 @@ inline void yield() {
     std::this_thread::yield();
   }
 }
+
+/**
+ * Yields only once the time slice of the task running the fibers is used
+ * up and other tasks are waiting for its thread (see
+ * TimeSlice::shouldYield()), so that it can be called often.
+ */
+inline void yieldIfNeeded() {
+  if (TimeSlice::shouldYield()) {
+    yield();
+  }
+}
 } // namespace fibers
 } // namespace folly
 
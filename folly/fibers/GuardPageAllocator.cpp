@@ -27,6 +27,7 @@
 #include <folly/Singleton.h>
 #include <folly/SpinLock.h>
 #include <folly/Synchronized.h>
+#include <folly/fibers/StackPool.h>
 #include <folly/portability/SysMman.h>
 #include <folly/portability/Unistd.h>
 
@@ -327,8 +328,11 @@ class StackCacheEntry {
   std::unique_ptr<StackCache> stackCache_;
 };
 
-GuardPageAllocator::GuardPageAllocator(size_t guardPagesPerStack)
-    : guardPagesPerStack_(guardPagesPerStack) {
+GuardPageAllocator::GuardPageAllocator(
+    size_t guardPagesPerStack,
+    bool useSharedStackPool)
+    : guardPagesPerStack_(guardPagesPerStack),
+      useSharedStackPool_(useSharedStackPool) {
 #ifndef _WIN32
   installSignalHandler();
 #endif
@@ -348,11 +352,19 @@ unsigned char* GuardPageAllocator::allocate(size_t size) {
       return p;
     }
   }
+  if (useSharedStackPool_) {
+    return StackPool::instance().allocate(size);
+  }
   return fallbackAllocator_.allocate(size);
 }
 
 void GuardPageAllocator::deallocate(unsigned char* limit, size_t size) {
-  if (!(stackCache_ && stackCache_->cache().giveBack(limit, size))) {
+  if (stackCache_ && stackCache_->cache().giveBack(limit, size)) {
+    return;
+  }
+  if (useSharedStackPool_) {
+    StackPool::instance().deallocate(limit, size);
+  } else {
     fallbackAllocator_.deallocate(limit, size);
   }
 }
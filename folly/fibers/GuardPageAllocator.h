@@ -34,8 +34,12 @@ class GuardPageAllocator {
   /**
    * @param guardPagesPerStack  Protect a small number of fiber stacks
    *   with this many guard pages.  If 0, acts as std::allocator.
+   * @param useSharedStackPool  Allocate the stacks without guard pages from
+   *   StackPool::instance() rather than std::allocator.
    */
-  explicit GuardPageAllocator(size_t guardPagesPerStack);
+  explicit GuardPageAllocator(
+      size_t guardPagesPerStack,
+      bool useSharedStackPool = false);
   ~GuardPageAllocator();
 
   /**
@@ -52,6 +56,7 @@ class GuardPageAllocator {
   std::unique_ptr<StackCacheEntry> stackCache_;
   std::allocator<unsigned char> fallbackAllocator_;
   size_t guardPagesPerStack_{0};
+  bool useSharedStackPool_{false};
 };
 } // namespace fibers
 } // namespace folly
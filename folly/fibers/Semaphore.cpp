@@ -89,7 +89,9 @@ void Semaphore::wait() {
       // If waitSlow fails it is because the token is non-zero by the time
       // the lock is taken, so we can just continue round the loop
       if (waitSlow(waitBaton)) {
+        auto start = waitStats_.start();
         waitBaton.wait();
+        waitStats_.record(start);
         return;
       }
       oldVal = tokens_.load(std::memory_order_acquire);
@@ -118,6 +120,20 @@ bool Semaphore::try_wait(Baton& waitBaton) {
   return true;
 }
 
+bool Semaphore::try_wait() {
+  auto oldVal = tokens_.load(std::memory_order_acquire);
+  do {
+    if (oldVal == 0) {
+      return false;
+    }
+  } while (!tokens_.compare_exchange_weak(
+      oldVal,
+      oldVal - 1,
+      std::memory_order_release,
+      std::memory_order_acquire));
+  return true;
+}
+
 #if FOLLY_HAS_COROUTINES
 
 coro::Task<void> Semaphore::co_wait() {
@@ -128,7 +144,9 @@ coro::Task<void> Semaphore::co_wait() {
       // If waitSlow fails it is because the token is non-zero by the time
       // the lock is taken, so we can just continue round the loop
       if (waitSlow(waitBaton)) {
+        auto start = waitStats_.start();
         co_await waitBaton;
+        waitStats_.record(start);
         co_return;
       }
       oldVal = tokens_.load(std::memory_order_acquire);
@@ -18,6 +18,7 @@
 
 #include <folly/Synchronized.h>
 #include <folly/fibers/Baton.h>
+#include <folly/fibers/WaitStats.h>
 #include <folly/futures/Future.h>
 #if FOLLY_HAS_COROUTINES
 #include <folly/experimental/coro/Task.h>
@@ -29,6 +30,10 @@ namespace fibers {
 /*
  * Fiber-compatible semaphore. Will safely block fibers that wait when no
  * tokens are available and wake fibers when signalled.
+ *
+ * A signalled token is handed over directly to the oldest waiter, if there
+ * is one, so that waiters are woken one at a time, in order, and can't be
+ * overtaken by new callers of wait().
  */
 class Semaphore {
  public:
@@ -58,6 +63,12 @@ class Semaphore {
    */
   bool try_wait(Baton& waitBaton);
 
+  /**
+   * Take a token if one is available, without waiting.
+   * Return true on success.
+   */
+  bool try_wait();
+
 #if FOLLY_HAS_COROUTINES
 
   /*
@@ -78,6 +89,21 @@ class Semaphore {
 
   size_t getCapacity() const;
 
+  /*
+   * Enable or disable counting the time spent in wait() and co_wait().
+   */
+  void setWaitStatsEnabled(bool enabled) {
+    waitStats_.setEnabled(enabled);
+  }
+
+  WaitStats getWaitStats() const {
+    return waitStats_.get();
+  }
+
+  void resetWaitStats() {
+    waitStats_.reset();
+  }
+
  private:
   bool waitSlow(folly::fibers::Baton& waitBaton);
   bool signalSlow();
@@ -86,6 +112,7 @@ class Semaphore {
   // Atomic counter
   std::atomic<int64_t> tokens_;
   folly::Synchronized<std::queue<folly::fibers::Baton*>> waitList_;
+  detail::WaitStatsRecorder waitStats_;
 };
 
 } // namespace fibers
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/fibers/StackPool.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include <folly/SpinLock.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/Unistd.h>
+
+#include <glog/logging.h>
+
+DEFINE_int32(
+    folly_fibers_stack_pool_resident_idle_stacks,
+    256,
+    "Idle fiber stacks of each size kept resident by each shard of the "
+    "shared fiber stack pool");
+DEFINE_bool(
+    folly_fibers_stack_pool_huge_pages,
+    false,
+    "Whether the shared fiber stack pool is backed by transparent huge pages");
+
+namespace folly {
+namespace fibers {
+
+constexpr size_t StackPool::kSlabSize;
+
+namespace {
+
+size_t pagesize() {
+  static const auto pagesize = size_t(sysconf(_SC_PAGESIZE));
+  return pagesize;
+}
+
+size_t roundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+void releasePages(unsigned char* base, size_t size) {
+  PCHECK(0 == ::madvise(base, size, MADV_DONTNEED));
+}
+
+} // namespace
+
+struct StackPool::IdleStack {
+  unsigned char* base;
+  // whether its pages may still be resident
+  bool resident;
+};
+
+struct StackPool::Shard {
+  struct Stacks {
+    // most recently released last
+    std::vector<IdleStack> idle;
+    size_t numResident{0};
+  };
+
+  folly::SpinLock lock;
+  // by allocation size
+  std::unordered_map<size_t, Stacks> stacks;
+};
+
+StackPool::StackPool() : StackPool(Options()) {}
+
+StackPool::StackPool(Options options) : options_(options) {
+  auto numShards =
+      std::max<size_t>(CacheLocality::system().numCachesByLevel.back(), 1);
+  for (size_t i = 0; i < numShards; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+StackPool::~StackPool() {
+  DCHECK_EQ(numIdleStacks(), numStacks())
+      << "StackPool destroyed with stacks in use";
+  for (auto& slab : slabs_) {
+    PCHECK(0 == ::munmap(slab.first, slab.second.size));
+  }
+}
+
+StackPool& StackPool::instance() {
+  static auto pool = [] {
+    Options options;
+    options.maxResidentIdleStacks = size_t(
+        std::max(FLAGS_folly_fibers_stack_pool_resident_idle_stacks, 0));
+    options.useHugePages = FLAGS_folly_fibers_stack_pool_huge_pages;
+    return new StackPool(options);
+  }();
+  return *pool;
+}
+
+size_t StackPool::allocSize(size_t size) {
+  return roundUp(size, pagesize());
+}
+
+StackPool::Shard& StackPool::currentShard() {
+  return *shards_[AccessSpreader<>::cachedCurrent(shards_.size())];
+}
+
+StackPool::Shard& StackPool::shardOf(unsigned char* base) {
+  SharedMutex::ReadHolder lock(slabsLock_);
+  auto it = slabs_.upper_bound(base);
+  DCHECK(it != slabs_.begin()) << "stack not allocated by this pool";
+  --it;
+  DCHECK_LT(size_t(base - it->first), it->second.size)
+      << "stack not allocated by this pool";
+  return *it->second.shard;
+}
+
+unsigned char* StackPool::allocate(size_t size) {
+  auto as = allocSize(size);
+  auto& shard = currentShard();
+  {
+    std::lock_guard<folly::SpinLock> lg(shard.lock);
+    auto& stacks = shard.stacks[as];
+    if (!stacks.idle.empty()) {
+      auto stack = stacks.idle.back();
+      stacks.idle.pop_back();
+      if (stack.resident) {
+        --stacks.numResident;
+      }
+      // Stacks grow down, so their top is aligned at the end of the
+      // allocation, as in GuardPageAllocator.
+      return stack.base + as - size;
+    }
+  }
+
+  // Mapped by this thread, so that the pages are first touched, and thus
+  // placed, on its NUMA node.
+  auto slabSize = roundUp(as, kSlabSize);
+  auto slab = mapSlab(slabSize);
+  auto count = slabSize / as;
+  numStacks_.fetch_add(count, std::memory_order_relaxed);
+  {
+    SharedMutex::WriteHolder lock(slabsLock_);
+    slabs_.emplace(slab, Slab{slabSize, &shard});
+  }
+
+  std::lock_guard<folly::SpinLock> lg(shard.lock);
+  auto& stacks = shard.stacks[as];
+  // Never touched, so not resident yet.
+  for (size_t i = count - 1; i > 0; --i) {
+    stacks.idle.push_back({slab + as * i, /* resident= */ false});
+  }
+  return slab + as - size;
+}
+
+unsigned char* StackPool::mapSlab(size_t slabSize) {
+  // Huge pages need the slab to be aligned to their size.
+  auto mapSize = options_.useHugePages ? slabSize + kSlabSize : slabSize;
+  auto p = ::mmap(
+      nullptr,
+      mapSize,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  PCHECK(p != (void*)(-1));
+  auto slab = static_cast<unsigned char*>(p);
+  if (!options_.useHugePages) {
+    return slab;
+  }
+
+  auto begin = reinterpret_cast<uintptr_t>(slab);
+  auto aligned = reinterpret_cast<unsigned char*>(roundUp(begin, kSlabSize));
+  if (aligned != slab) {
+    PCHECK(0 == ::munmap(slab, size_t(aligned - slab)));
+  }
+  auto tail = size_t(slab + mapSize - (aligned + slabSize));
+  if (tail != 0) {
+    PCHECK(0 == ::munmap(aligned + slabSize, tail));
+  }
+#ifdef MADV_HUGEPAGE
+  // Only a hint: not fatal if transparent huge pages are disabled.
+  if (::madvise(aligned, slabSize, MADV_HUGEPAGE) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "madvise(MADV_HUGEPAGE) failed: errno "
+                            << errno;
+  }
+#endif
+  return aligned;
+}
+
+void StackPool::deallocate(unsigned char* limit, size_t size) {
+  auto as = allocSize(size);
+  auto base = limit + size - as;
+  // Back to the shard it was allocated from, whose node its pages are on.
+  release(shardOf(base), base, as);
+}
+
+void StackPool::release(Shard& shard, unsigned char* base, size_t as) {
+  {
+    std::lock_guard<folly::SpinLock> lg(shard.lock);
+    auto& stacks = shard.stacks[as];
+    if (stacks.numResident < options_.maxResidentIdleStacks) {
+      stacks.idle.push_back({base, /* resident= */ true});
+      ++stacks.numResident;
+      return;
+    }
+  }
+
+  // Released before being put back, since it could be reused as soon as it
+  // is.
+  releasePages(base, as);
+  std::lock_guard<folly::SpinLock> lg(shard.lock);
+  shard.stacks[as].idle.push_back({base, /* resident= */ false});
+}
+
+size_t StackPool::trim() {
+  size_t count = 0;
+  for (auto& shard : shards_) {
+    std::vector<std::pair<unsigned char*, size_t>> resident;
+    {
+      std::lock_guard<folly::SpinLock> lg(shard->lock);
+      for (auto& item : shard->stacks) {
+        auto& idle = item.second.idle;
+        auto it = std::stable_partition(
+            idle.begin(), idle.end(), [](auto& stack) {
+              return !stack.resident;
+            });
+        for (auto i = it; i != idle.end(); ++i) {
+          resident.emplace_back(i->base, item.first);
+        }
+        idle.erase(it, idle.end());
+        item.second.numResident = 0;
+      }
+    }
+
+    for (auto& stack : resident) {
+      releasePages(stack.first, stack.second);
+    }
+
+    std::lock_guard<folly::SpinLock> lg(shard->lock);
+    for (auto& stack : resident) {
+      shard->stacks[stack.second].idle.push_back(
+          {stack.first, /* resident= */ false});
+    }
+    count += resident.size();
+  }
+  return count;
+}
+
+size_t StackPool::numIdleStacks() const {
+  size_t count = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<folly::SpinLock> lg(shard->lock);
+    for (auto& item : shard->stacks) {
+      count += item.second.idle.size();
+    }
+  }
+  return count;
+}
+
+} // namespace fibers
+} // namespace folly
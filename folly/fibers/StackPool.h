@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <folly/SharedMutex.h>
+
+namespace folly {
+namespace fibers {
+
+/**
+ * Process-wide pool of fiber stacks, shared by all the FiberManagers that
+ * enable FiberManager::Options::useSharedStackPool.
+ *
+ * The pool is sharded by last-level cache, which is a NUMA node on most
+ * systems: stacks are mapped, first touched and reused by the threads of
+ * the same shard, so their pages stay local to it.  Stacks are carved from
+ * slabs of kSlabSize bytes which, with Options::useHugePages, are aligned
+ * to and advised to be backed by transparent huge pages.
+ *
+ * Stacks are never unmapped.  Instead, idle stacks beyond
+ * Options::maxResidentIdleStacks, and all idle stacks on trim(), have their
+ * pages released with madvise(MADV_DONTNEED), which keeps the resident
+ * memory of the pool bounded by the number of fibers actually running.
+ *
+ * Thread safe.
+ */
+class StackPool {
+ public:
+  static constexpr size_t kSlabSize = 2 * 1024 * 1024;
+
+  struct Options {
+    /**
+     * Idle stacks of each shard and size kept resident.
+     */
+    size_t maxResidentIdleStacks{256};
+
+    /**
+     * Advise slabs to be backed by transparent huge pages.
+     */
+    bool useHugePages{false};
+  };
+
+  StackPool();
+  explicit StackPool(Options options);
+  ~StackPool();
+
+  StackPool(const StackPool&) = delete;
+  StackPool& operator=(const StackPool&) = delete;
+
+  /**
+   * The pool used by FiberManagers, configured by the
+   * --folly_fibers_stack_pool_* flags.
+   */
+  static StackPool& instance();
+
+  /**
+   * @return pointer to the bottom of the allocated stack of `size' bytes.
+   */
+  unsigned char* allocate(size_t size);
+
+  /**
+   * Returns the previous result of an `allocate(size)' call to the shard it
+   * was allocated from, which may not be the one of the calling thread.
+   */
+  void deallocate(unsigned char* limit, size_t size);
+
+  /**
+   * Releases the pages of all idle stacks.
+   *
+   * @return How many stacks were released.
+   */
+  size_t trim();
+
+  /**
+   * @return How many stacks this pool has mapped.
+   */
+  size_t numStacks() const {
+    return numStacks_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return How many of the mapped stacks are idle.
+   */
+  size_t numIdleStacks() const;
+
+ private:
+  struct IdleStack;
+  struct Shard;
+  struct Slab {
+    size_t size;
+    Shard* shard;
+  };
+
+  static size_t allocSize(size_t size);
+
+  Shard& currentShard();
+  Shard& shardOf(unsigned char* base);
+  unsigned char* mapSlab(size_t slabSize);
+  void release(Shard& shard, unsigned char* base, size_t allocSize);
+
+  const Options options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> numStacks_{0};
+  // all the slabs, by address
+  SharedMutex slabsLock_;
+  std::map<unsigned char*, Slab> slabs_;
+};
+
+} // namespace fibers
+} // namespace folly
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <folly/Chrono.h>
+#include <folly/Executor.h>
+#include <folly/Function.h>
+#include <folly/futures/Future.h>
+#include <folly/futures/Promise.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+
+namespace folly {
+namespace fibers {
+
+/**
+ * TimedBatchDispatcher is a thread safe BatchDispatcher: it batches the
+ * values added from any fiber or thread until the batch reaches
+ * maxBatchSize values or the first value of the batch has waited for the
+ * time window, and then calls the dispatch function once for the whole
+ * batch on the executor.
+ *
+ * As with BatchDispatcher, the dispatch function consumes a vector of
+ * values and returns a vector of results in the same order, and add()
+ * returns a future to the result of its value.  With a FiberManager as the
+ * executor, the dispatch function runs in a fiber and may block it.
+ *
+ * The dispatch function may be called concurrently for different batches
+ * if the executor has several threads.
+ *
+ * The time windows are measured by a high resolution timeout of the
+ * EventBase, which must outlive the dispatcher, as must the executor.  The
+ * batch pending when the dispatcher is destroyed is dispatched.
+ */
+template <typename ValueT, typename ResultT>
+class TimedBatchDispatcher {
+ public:
+  using ValueBatchT = std::vector<ValueT>;
+  using ResultBatchT = std::vector<ResultT>;
+  using PromiseBatchT = std::vector<folly::Promise<ResultT>>;
+  using DispatchFunctionT = folly::Function<ResultBatchT(ValueBatchT&&)>;
+
+  struct Options {
+    /**
+     * Number of values that is dispatched without waiting for the window.
+     */
+    size_t maxBatchSize{64};
+
+    /**
+     * How long the first value of a batch waits for others.
+     */
+    std::chrono::microseconds window{200};
+
+    /**
+     * If set, measures the windows instead of the EventBase, rounded up to
+     * milliseconds. Meant for tests, with a ManualTimekeeper. Must outlive
+     * the dispatcher.
+     */
+    Timekeeper* timekeeper{nullptr};
+  };
+
+  TimedBatchDispatcher(
+      folly::Executor::KeepAlive<> executor,
+      folly::EventBase& evb,
+      DispatchFunctionT dispatchFunc,
+      Options options = Options())
+      : state_(std::make_shared<DispatchState>(
+            std::move(executor),
+            evb,
+            std::move(dispatchFunc),
+            options)) {}
+
+  TimedBatchDispatcher(const TimedBatchDispatcher&) = delete;
+  TimedBatchDispatcher& operator=(const TimedBatchDispatcher&) = delete;
+
+  ~TimedBatchDispatcher() {
+    auto& evb = state_->evb;
+    evb.runInEventBaseThread([state = std::move(state_)] {
+      state->timeout.reset();
+      state->executor->add([state] { state->dispatchPending(); });
+    });
+  }
+
+  Future<ResultT> add(ValueT value) {
+    folly::Promise<ResultT> resultPromise;
+    auto resultFuture = resultPromise.getFuture();
+
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->values.emplace_back(std::move(value));
+    state_->promises.emplace_back(std::move(resultPromise));
+    auto generation = state_->generation;
+    if (state_->values.size() >= state_->options.maxBatchSize) {
+      // Taken now, so that the values added meanwhile go to the next batch.
+      ValueBatchT batchValues;
+      PromiseBatchT batchPromises;
+      state_->takeBatch(batchValues, batchPromises);
+      lock.unlock();
+      state_->executor->add(
+          [state = state_,
+           batchValues = std::move(batchValues),
+           batchPromises = std::move(batchPromises)]() mutable {
+            state->dispatchBatch(
+                std::move(batchValues), std::move(batchPromises));
+          });
+    } else if (state_->values.size() == 1) {
+      lock.unlock();
+      state_->startWindow(generation);
+    }
+    return resultFuture;
+  }
+
+ private:
+  struct DispatchState : std::enable_shared_from_this<DispatchState> {
+    DispatchState(
+        folly::Executor::KeepAlive<>&& executor_,
+        folly::EventBase& evb_,
+        DispatchFunctionT&& dispatchFunction,
+        const Options& options_)
+        : executor(std::move(executor_)),
+          evb(evb_),
+          dispatchFunc(std::move(dispatchFunction)),
+          options(options_) {}
+
+    void startWindow(size_t batch) {
+      if (options.timekeeper) {
+        options.timekeeper
+            ->after(folly::chrono::ceil<Duration>(options.window))
+            .via(executor)
+            .thenValue([state = this->shared_from_this(), batch](Unit) {
+              state->dispatch(batch);
+            });
+        return;
+      }
+      evb.runInEventBaseThread([state = this->shared_from_this(), batch] {
+        state->scheduleTimeout(batch);
+      });
+    }
+
+    // Runs on the EventBase thread.
+    void scheduleTimeout(size_t batch) {
+      if (!timeout) {
+        // The state outlives its timeout, which is reset on destruction.
+        timeout = AsyncTimeout::make(evb, [this]() noexcept {
+          executor->add([state = this->shared_from_this(), batch = timedBatch] {
+            state->dispatch(batch);
+          });
+        });
+      }
+      timedBatch = batch;
+      timeout->scheduleTimeoutHighRes(options.window);
+    }
+
+    void dispatchPending() {
+      size_t batch;
+      {
+        std::lock_guard<std::mutex> lg(mutex);
+        batch = generation;
+      }
+      dispatch(batch);
+    }
+
+    // Dispatches the values of the batch, unless it already was.
+    void dispatch(size_t batch) {
+      ValueBatchT batchValues;
+      PromiseBatchT batchPromises;
+      {
+        std::lock_guard<std::mutex> lg(mutex);
+        if (batch != generation || values.empty()) {
+          return;
+        }
+        takeBatch(batchValues, batchPromises);
+      }
+      dispatchBatch(std::move(batchValues), std::move(batchPromises));
+    }
+
+    // Ends the batch being collected. Requires the mutex.
+    void takeBatch(ValueBatchT& batchValues, PromiseBatchT& batchPromises) {
+      ++generation;
+      values.swap(batchValues);
+      promises.swap(batchPromises);
+    }
+
+    void dispatchBatch(
+        ValueBatchT&& batchValues,
+        PromiseBatchT&& batchPromises) {
+      try {
+        auto results = dispatchFunc(std::move(batchValues));
+        if (results.size() != batchPromises.size()) {
+          throw std::logic_error(
+              "Unexpected number of results returned from dispatch function");
+        }
+
+        for (size_t i = 0; i < batchPromises.size(); i++) {
+          batchPromises[i].setValue(std::move(results[i]));
+        }
+      } catch (const std::exception& ex) {
+        for (size_t i = 0; i < batchPromises.size(); i++) {
+          batchPromises[i].setException(
+              exception_wrapper(std::current_exception(), ex));
+        }
+      } catch (...) {
+        for (size_t i = 0; i < batchPromises.size(); i++) {
+          batchPromises[i].setException(
+              exception_wrapper(std::current_exception()));
+        }
+      }
+    }
+
+    const folly::Executor::KeepAlive<> executor;
+    folly::EventBase& evb;
+    const Options options;
+
+    // Only used by the EventBase thread.
+    std::unique_ptr<AsyncTimeout> timeout;
+    size_t timedBatch{0};
+
+    std::mutex mutex;
+    DispatchFunctionT dispatchFunc;
+    ValueBatchT values;
+    PromiseBatchT promises;
+    // of the batch being collected
+    size_t generation{0};
+  };
+
+  std::shared_ptr<DispatchState> state_;
+};
+
+} // namespace fibers
+} // namespace folly
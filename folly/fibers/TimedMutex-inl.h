@@ -26,7 +26,9 @@ namespace fibers {
 //
 
 template <typename WaitFunc>
-TimedMutex::LockResult TimedMutex::lockHelper(WaitFunc&& waitFunc) {
+TimedMutex::LockResult TimedMutex::lockHelper(
+    WaitFunc&& waitFunc,
+    bool stolen) {
   std::unique_lock<folly::SpinLock> ulock(lock_);
   if (!locked_) {
     locked_ = true;
@@ -48,15 +50,19 @@ TimedMutex::LockResult TimedMutex::lockHelper(WaitFunc&& waitFunc) {
   // This makes a huge difference, at least in the benchmarks,
   // when the mutex isn't locked.
   MutexWaiter waiter;
-  if (isOnFiber) {
-    fiberWaiters_.push_back(waiter);
+  auto& waiters = isOnFiber ? fiberWaiters_ : threadWaiters_;
+  if (stolen) {
+    waiters.push_front(waiter);
   } else {
-    threadWaiters_.push_back(waiter);
+    waiters.push_back(waiter);
   }
 
   ulock.unlock();
 
-  if (!waitFunc(waiter)) {
+  auto start = waitStats_.start();
+  auto locked = waitFunc(waiter);
+  waitStats_.record(start);
+  if (!locked) {
     return LockResult::TIMEOUT;
   }
 
@@ -79,18 +85,25 @@ TimedMutex::LockResult TimedMutex::lockHelper(WaitFunc&& waitFunc) {
   return LockResult::SUCCESS;
 }
 
-inline void TimedMutex::lock() {
+inline void TimedMutex::lockImpl(bool stolen) {
   LockResult result;
   do {
-    result = lockHelper([](MutexWaiter& waiter) {
-      waiter.baton.wait();
-      return true;
-    });
+    result = lockHelper(
+        [](MutexWaiter& waiter) {
+          waiter.baton.wait();
+          return true;
+        },
+        stolen);
 
     DCHECK(result != LockResult::TIMEOUT);
+    stolen = true;
   } while (result != LockResult::SUCCESS);
 }
 
+inline void TimedMutex::lock() {
+  lockImpl(false);
+}
+
 template <typename Rep, typename Period>
 bool TimedMutex::try_lock_for(
     const std::chrono::duration<Rep, Period>& timeout) {
@@ -100,22 +113,23 @@ bool TimedMutex::try_lock_for(
 template <typename Clock, typename Duration>
 bool TimedMutex::try_lock_until(
     const std::chrono::time_point<Clock, Duration>& deadline) {
-  auto result = lockHelper([&](MutexWaiter& waiter) {
-    if (!waiter.baton.try_wait_until(deadline)) {
-      // We timed out. Two cases:
-      // 1. We're still in the waiter list and we truly timed out
-      // 2. We're not in the waiter list anymore. This could happen if the baton
-      //    times out but the mutex is unlocked before we reach this code. In
-      //    this
-      //    case we'll pretend we got the lock on time.
-      std::lock_guard<folly::SpinLock> lg(lock_);
-      if (waiter.hook.is_linked()) {
-        waiter.hook.unlink();
-        return false;
-      }
-    }
-    return true;
-  });
+  auto result = lockHelper(
+      [&](MutexWaiter& waiter) {
+        if (!waiter.baton.try_wait_until(deadline)) {
+          // We timed out. Two cases:
+          // 1. We're still in the waiter list and we truly timed out
+          // 2. We're not in the waiter list anymore. This could happen if the
+          //    baton times out but the mutex is unlocked before we reach this
+          //    code. In this case we'll pretend we got the lock on time.
+          std::lock_guard<folly::SpinLock> lg(lock_);
+          if (waiter.hook.is_linked()) {
+            waiter.hook.unlink();
+            return false;
+          }
+        }
+        return true;
+      },
+      false);
 
   switch (result) {
     case LockResult::SUCCESS:
@@ -124,7 +138,7 @@ bool TimedMutex::try_lock_until(
       return false;
     case LockResult::STOLEN:
       // We don't respect the duration if lock was stolen
-      lock();
+      lockImpl(true);
       return true;
   }
   assume_unreachable();
@@ -20,6 +20,7 @@
 #include <folly/Portability.h>
 #include <folly/SpinLock.h>
 #include <folly/fibers/GenericBaton.h>
+#include <folly/fibers/WaitStats.h>
 
 namespace folly {
 namespace fibers {
@@ -28,6 +29,11 @@ namespace fibers {
  * @class TimedMutex
  *
  * Like mutex but allows timed_lock in addition to lock and try_lock.
+ *
+ * Ownership is handed over directly to the first waiter on unlock, so that
+ * waiters are not overtaken by new lockers. The only exception is a thread
+ * locking while a woken fiber hasn't run yet: the thread takes the lock to
+ * avoid a deadlock, and the fiber goes back to the front of the queue.
  **/
 class TimedMutex {
  public:
@@ -65,11 +71,27 @@ class TimedMutex {
   // Unlock the mutex and wake up a waiter if there is one
   void unlock();
 
+  // Enable or disable counting the time spent waiting for this mutex
+  void setWaitStatsEnabled(bool enabled) {
+    waitStats_.setEnabled(enabled);
+  }
+
+  WaitStats getWaitStats() const {
+    return waitStats_.get();
+  }
+
+  void resetWaitStats() {
+    waitStats_.reset();
+  }
+
  private:
   enum class LockResult { SUCCESS, TIMEOUT, STOLEN };
 
+  // A waiter whose lock was stolen is queued at the front.
   template <typename WaitFunc>
-  LockResult lockHelper(WaitFunc&& waitFunc);
+  LockResult lockHelper(WaitFunc&& waitFunc, bool stolen);
+
+  void lockImpl(bool stolen);
 
   // represents a waiter waiting for the lock. The waiter waits on the
   // baton until it is woken up by a post or timeout expires.
@@ -85,6 +107,7 @@ class TimedMutex {
   MutexWaiterList threadWaiters_; //< list of waiters
   MutexWaiterList fiberWaiters_; //< list of waiters
   MutexWaiter* notifiedFiber_{nullptr}; //< Fiber waiter which has been notified
+  detail::WaitStatsRecorder waitStats_;
 };
 
 /**
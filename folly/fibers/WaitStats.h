@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace folly {
+namespace fibers {
+
+/*
+ * Wait-time counters of a fiber lock (TimedMutex, Semaphore). Only waits
+ * which actually blocked are counted.
+ */
+struct WaitStats {
+  uint64_t numWaits{0};
+  std::chrono::nanoseconds totalWaitTime{0};
+  std::chrono::nanoseconds maxWaitTime{0};
+};
+
+namespace detail {
+
+/*
+ * Records WaitStats while enabled. Recording costs a clock read at the
+ * start and the end of a blocking wait, and nothing otherwise.
+ */
+class WaitStatsRecorder {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Start time of a wait, or a default time point if recording is disabled
+  Clock::time_point start() const {
+    return enabled() ? Clock::now() : Clock::time_point();
+  }
+
+  void record(Clock::time_point start) {
+    if (start == Clock::time_point()) {
+      return;
+    }
+    auto ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           Clock::now() - start)
+                           .count());
+    numWaits_.fetch_add(1, std::memory_order_relaxed);
+    totalWaitNs_.fetch_add(ns, std::memory_order_relaxed);
+    auto max = maxWaitNs_.load(std::memory_order_relaxed);
+    while (ns > max &&
+           !maxWaitNs_.compare_exchange_weak(
+               max, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  WaitStats get() const {
+    WaitStats stats;
+    stats.numWaits = numWaits_.load(std::memory_order_relaxed);
+    stats.totalWaitTime = std::chrono::nanoseconds(
+        totalWaitNs_.load(std::memory_order_relaxed));
+    stats.maxWaitTime =
+        std::chrono::nanoseconds(maxWaitNs_.load(std::memory_order_relaxed));
+    return stats;
+  }
+
+  void reset() {
+    numWaits_.store(0, std::memory_order_relaxed);
+    totalWaitNs_.store(0, std::memory_order_relaxed);
+    maxWaitNs_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint64_t> numWaits_{0};
+  std::atomic<uint64_t> totalWaitNs_{0};
+  std::atomic<uint64_t> maxWaitNs_{0};
+};
+
+} // namespace detail
+} // namespace fibers
+} // namespace folly
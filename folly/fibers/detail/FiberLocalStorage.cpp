@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/fibers/detail/FiberLocalStorage.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <folly/ThreadLocal.h>
+
+namespace folly {
+namespace fibers {
+namespace detail {
+
+constexpr size_t FiberLocalStorage::kMaxDepth;
+
+FiberLocalStorage::~FiberLocalStorage() {
+  for (auto& value : values_) {
+    if (value.ptr) {
+      value.destroy(value.ptr);
+    }
+  }
+}
+
+std::shared_ptr<FiberLocalStorage> FiberLocalStorage::inherit(
+    std::shared_ptr<const FiberLocalStorage> parent) {
+  if (parent && parent->depth_ >= kMaxDepth) {
+    return parent->copyAll();
+  }
+  auto storage = std::make_shared<FiberLocalStorage>();
+  if (parent) {
+    storage->depth_ = parent->depth_ + 1;
+    storage->parent_ = std::move(parent);
+  }
+  return storage;
+}
+
+std::shared_ptr<const FiberLocalStorage> FiberLocalStorage::snapshot() const {
+  return copyAll();
+}
+
+std::shared_ptr<FiberLocalStorage> FiberLocalStorage::copyAll() const {
+  size_t numIds = 0;
+  for (auto storage = this; storage; storage = storage->parent_.get()) {
+    numIds = std::max(numIds, storage->values_.size());
+  }
+  auto copy = std::make_shared<FiberLocalStorage>();
+  copy->values_.resize(numIds);
+  for (size_t id = 0; id < numIds; ++id) {
+    if (auto value = find(id)) {
+      auto ptr = value->copy(value->ptr);
+      copy->values_[id] = Value{ptr, value->destroy, value->copy};
+    }
+  }
+  return copy;
+}
+
+const FiberLocalStorage::Value* FiberLocalStorage::find(size_t id) const {
+  for (auto storage = this; storage; storage = storage->parent_.get()) {
+    if (id < storage->values_.size() && storage->values_[id].ptr) {
+      return &storage->values_[id];
+    }
+  }
+  return nullptr;
+}
+
+void FiberLocalStorage::set(size_t id, const Value& value) {
+  if (id >= values_.size()) {
+    values_.resize(id + 1);
+  }
+  values_[id] = value;
+}
+
+size_t FiberLocalStorage::allocateId() {
+  static std::atomic<size_t> nextId{0};
+  return nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+FiberLocalStorage& FiberLocalStorage::threadStorage() {
+  static auto storage = new ThreadLocal<FiberLocalStorage>();
+  return **storage;
+}
+
+} // namespace detail
+} // namespace fibers
+} // namespace folly
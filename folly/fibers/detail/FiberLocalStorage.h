@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <folly/CPortability.h>
+#include <folly/Likely.h>
+
+namespace folly {
+namespace fibers {
+namespace detail {
+
+/*
+ * Values of the FiberLocal's of one fiber, or thread, indexed by the ids of
+ * the FiberLocal's.
+ *
+ * A value missing from the storage is copied on first access from the
+ * storage it inherits from (the one of the fiber which spawned this fiber),
+ * or default-constructed if none of the inherited storages has it. Spawning
+ * a fiber thus only copies a shared_ptr.
+ */
+class FiberLocalStorage {
+ public:
+  FiberLocalStorage() = default;
+  ~FiberLocalStorage();
+
+  FiberLocalStorage(const FiberLocalStorage&) = delete;
+  FiberLocalStorage& operator=(const FiberLocalStorage&) = delete;
+
+  template <typename T>
+  T& get(size_t id) {
+    if (FOLLY_LIKELY(id < values_.size() && values_[id].ptr)) {
+      return *static_cast<T*>(values_[id].ptr);
+    }
+    return getSlow<T>(id);
+  }
+
+  /*
+   * New storage inheriting from parent. Inherited storages are kept alive
+   * by the storages inheriting from them, so past a few levels the values
+   * are copied eagerly instead to keep chains short.
+   */
+  static std::shared_ptr<FiberLocalStorage> inherit(
+      std::shared_ptr<const FiberLocalStorage> parent);
+
+  /*
+   * Copy of all the values visible from this storage which doesn't inherit
+   * from anything, for tasks which may run on another thread.
+   */
+  std::shared_ptr<const FiberLocalStorage> snapshot() const;
+
+  static size_t allocateId();
+
+  // Storage used outside of fibers
+  static FiberLocalStorage& threadStorage();
+
+ private:
+  static constexpr size_t kMaxDepth = 8;
+
+  struct Value {
+    void* ptr{nullptr};
+    void (*destroy)(void*){nullptr};
+    void* (*copy)(const void*){nullptr};
+  };
+
+  template <typename T>
+  FOLLY_NOINLINE T& getSlow(size_t id);
+
+  std::shared_ptr<FiberLocalStorage> copyAll() const;
+
+  // The value of id visible from this storage, if any
+  const Value* find(size_t id) const;
+
+  void set(size_t id, const Value& value);
+
+  template <typename T>
+  static void destroyValue(void* ptr) {
+    delete static_cast<T*>(ptr);
+  }
+
+  template <typename T>
+  static void* copyValue(const void* ptr) {
+    return new T(*static_cast<const T*>(ptr));
+  }
+
+  std::shared_ptr<const FiberLocalStorage> parent_;
+  size_t depth_{0};
+  std::vector<Value> values_;
+};
+
+template <typename T>
+T& FiberLocalStorage::getSlow(size_t id) {
+  auto inherited = parent_ ? parent_->find(id) : nullptr;
+  // T's constructor may itself access fiber-locals, so values_ is only
+  // updated once it is done.
+  std::unique_ptr<T> value(
+      inherited ? new T(*static_cast<const T*>(inherited->ptr)) : new T());
+  set(id, Value{value.get(), &destroyValue<T>, &copyValue<T>});
+  return *value.release();
+}
+
+} // namespace detail
+} // namespace fibers
+} // namespace folly
@@ -16,6 +16,7 @@
 
 #include <array>
 #include <atomic>
+#include <numeric>
 #include <thread>
 #include <vector>
 
@@ -24,21 +25,28 @@
 #include <folly/futures/Future.h>
 
 #include <folly/Conv.h>
+#include <folly/detail/MemoryIdler.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/fibers/AddTasks.h>
 #include <folly/fibers/AtomicBatchDispatcher.h>
 #include <folly/fibers/BatchDispatcher.h>
 #include <folly/fibers/EventBaseLoopController.h>
 #include <folly/fibers/ExecutorLoopController.h>
+#include <folly/fibers/FiberLocal.h>
 #include <folly/fibers/FiberManager.h>
+#include <folly/fibers/FiberManagerGroup.h>
 #include <folly/fibers/FiberManagerMap.h>
 #include <folly/fibers/GenericBaton.h>
 #include <folly/fibers/Semaphore.h>
 #include <folly/fibers/SimpleLoopController.h>
+#include <folly/fibers/StackPool.h>
+#include <folly/fibers/TimedBatchDispatcher.h>
 #include <folly/fibers/TimedMutex.h>
 #include <folly/fibers/WhenN.h>
+#include <folly/futures/ManualTimekeeper.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/Unistd.h>
 
 using namespace folly::fibers;
 
@@ -1300,6 +1308,88 @@ TEST(FiberManager, fiberLocalDestructor) {
   EXPECT_FALSE(fm.hasTasks());
 }
 
+TEST(FiberLocal, lazyInherit) {
+  static FiberLocal<int> value;
+  static FiberLocal<std::string> name;
+  FiberManager fm(std::make_unique<SimpleLoopController>());
+  *value = 1;
+
+  fm.addTask([&] {
+    // not inherited from the thread
+    EXPECT_EQ(0, *value);
+    *value = 2;
+    *name = "parent";
+
+    fm.addTask([&] {
+      EXPECT_EQ(3, *value);
+      *value = 4;
+      fm.addTask([&] {
+        EXPECT_EQ(4, *value);
+        EXPECT_EQ("parent", *name);
+      });
+    });
+    // the child hasn't accessed its value yet
+    *value = 3;
+
+    fm.addTask([&] { fm.addTask([&] { EXPECT_EQ(3, *value); }); });
+  });
+  fm.loopUntilNoReady();
+  EXPECT_FALSE(fm.hasTasks());
+  EXPECT_EQ(1, *value);
+  EXPECT_TRUE(name->empty());
+}
+
+TEST(FiberLocal, remote) {
+  static FiberLocal<int> value;
+  FiberManager fm(std::make_unique<SimpleLoopController>());
+
+  fm.addTask([&] {
+    *value = 1;
+    Baton done;
+    fm.addTaskRemote([&] {
+      EXPECT_EQ(1, *value);
+      *value = 3;
+      done.post();
+    });
+    // remote tasks get a copy
+    *value = 2;
+    done.wait();
+    EXPECT_EQ(2, *value);
+  });
+  fm.loopUntilNoReady();
+  EXPECT_FALSE(fm.hasTasks());
+}
+
+TEST(FiberLocal, deepSpawn) {
+  static int alive = 0;
+  struct Counted {
+    Counted() {
+      ++alive;
+    }
+    Counted(const Counted& other) : depth(other.depth) {
+      ++alive;
+    }
+    ~Counted() {
+      --alive;
+    }
+    int depth{0};
+  };
+  static FiberLocal<Counted> counted;
+  FiberManager fm(std::make_unique<SimpleLoopController>());
+
+  // Every fiber spawns the next one and exits: the storages of finished
+  // fibers must not pile up.
+  folly::Function<void()> spawn = [&] {
+    if (counted->depth++ < 1000) {
+      fm.addTask([&] { spawn(); });
+    }
+  };
+  fm.addTask([&] { spawn(); });
+  fm.loopUntilNoReady();
+  EXPECT_FALSE(fm.hasTasks());
+  EXPECT_EQ(0, alive);
+}
+
 TEST(FiberManager, yieldTest) {
   FiberManager manager(std::make_unique<SimpleLoopController>());
   auto& loopController =
@@ -1477,6 +1567,56 @@ TEST(FiberManager, resizePeriodically) {
   EXPECT_EQ(5, manager.fibersPoolSize());
 }
 
+TEST(FiberManager, releaseIdleStacks) {
+  FiberManager::Options opts;
+  opts.fibersPoolResizePeriodMs = 100;
+
+  FiberManager manager(std::make_unique<EventBaseLoopController>(), opts);
+
+  folly::EventBase evb;
+  dynamic_cast<EventBaseLoopController&>(manager.loopController())
+      .attachEventBase(evb);
+
+  size_t sum = 0;
+  auto addTasks = [&] {
+    for (size_t i = 0; i < 10; ++i) {
+      manager.addTask([i, &sum] {
+        std::array<char, 4096> buf;
+        buf.fill(static_cast<char>(i));
+        folly::fibers::yield();
+        sum += std::accumulate(buf.begin(), buf.end(), size_t(0));
+      });
+    }
+  };
+
+  // The pool resizer keeps the loop alive, so loop() wouldn't return
+  auto runTasks = [&] {
+    addTasks();
+    while (manager.hasTasks()) {
+      evb.loopOnce();
+    }
+  };
+
+  runTasks();
+  EXPECT_EQ(10, manager.fibersPoolSize());
+
+  // The stacks are released once the fibers stayed pooled for a period
+  auto before = folly::detail::MemoryIdler::getStats().stackBytesReleased;
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  evb.loopOnce();
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  evb.loopOnce();
+  if (folly::kIsLinux && folly::kIsArchAmd64 && !folly::kIsSanitizeAddress) {
+    EXPECT_LT(
+        before, folly::detail::MemoryIdler::getStats().stackBytesReleased);
+  }
+
+  // The fibers can still be used
+  runTasks();
+  EXPECT_EQ(2 * 4096 * 45, sum);
+  EXPECT_EQ(10, manager.fibersAllocated());
+}
+
 TEST(FiberManager, batonWaitTimeoutHandler) {
   FiberManager manager(std::make_unique<EventBaseLoopController>());
 
@@ -2324,6 +2464,78 @@ TEST(TimedMutex, ThreadFiberDeadlockRace) {
   EXPECT_EQ(0, fm.hasTasks());
 }
 
+TEST(TimedMutex, waitStats) {
+  folly::EventBase evb;
+  auto& fm = getFiberManager(evb);
+  TimedMutex mutex;
+  mutex.setWaitStatsEnabled(true);
+  std::vector<int> order;
+
+  mutex.lock();
+  mutex.unlock();
+  EXPECT_EQ(0, mutex.getWaitStats().numWaits);
+
+  fm.addTask([&] {
+    std::lock_guard<TimedMutex> lg(mutex);
+    Baton b;
+    b.try_wait_for(std::chrono::milliseconds(5));
+  });
+  for (int i = 0; i < 3; ++i) {
+    fm.addTask([&, i] {
+      std::lock_guard<TimedMutex> lg(mutex);
+      order.push_back(i);
+    });
+  }
+  evb.loop();
+
+  // waiters get the mutex in order
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+  auto stats = mutex.getWaitStats();
+  EXPECT_EQ(3, stats.numWaits);
+  EXPECT_GE(stats.maxWaitTime, std::chrono::milliseconds(4));
+  EXPECT_GE(stats.totalWaitTime, std::chrono::milliseconds(12));
+
+  mutex.resetWaitStats();
+  mutex.setWaitStatsEnabled(false);
+  fm.addTask([&] {
+    std::lock_guard<TimedMutex> lg(mutex);
+    Baton b;
+    b.try_wait_for(std::chrono::milliseconds(1));
+  });
+  fm.addTask([&] { std::lock_guard<TimedMutex> lg(mutex); });
+  evb.loop();
+  EXPECT_EQ(0, mutex.getWaitStats().numWaits);
+}
+
+TEST(Semaphore, waitStats) {
+  folly::EventBase evb;
+  auto& fm = getFiberManager(evb);
+  Semaphore sem(1);
+  sem.setWaitStatsEnabled(true);
+  std::vector<int> order;
+
+  fm.addTask([&] {
+    sem.wait();
+    Baton b;
+    b.try_wait_for(std::chrono::milliseconds(5));
+    sem.signal();
+  });
+  for (int i = 0; i < 3; ++i) {
+    fm.addTask([&, i] {
+      sem.wait();
+      order.push_back(i);
+      sem.signal();
+    });
+  }
+  evb.loop();
+
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+  auto stats = sem.getWaitStats();
+  EXPECT_EQ(3, stats.numWaits);
+  EXPECT_GE(stats.maxWaitTime, std::chrono::milliseconds(4));
+  EXPECT_TRUE(sem.try_wait());
+}
+
 namespace {
 // Checks whether stackHighWatermark is set for non-ASAN builds,
 // and not set for ASAN builds.
@@ -2585,3 +2797,219 @@ TEST(FiberManager, addTaskRemoteFutureTry) {
           .getVia(&evb)
           .value());
 }
+
+TEST(FiberManager, sharedStackPool) {
+  FiberManager::Options opts;
+  opts.guardPagesPerStack = 0;
+  opts.useSharedStackPool = true;
+  auto& pool = StackPool::instance();
+
+  for (int i = 0; i < 2; ++i) {
+    folly::EventBase evb;
+    auto& fm = getFiberManager(evb, opts);
+    size_t count = 0;
+    for (int j = 0; j < 10; ++j) {
+      fm.addTask([&] { ++count; });
+    }
+    evb.loop();
+    EXPECT_EQ(10, count);
+    EXPECT_LE(10, pool.numStacks());
+  }
+  // All the stacks are back in the pool once the managers are destroyed.
+  EXPECT_EQ(pool.numStacks(), pool.numIdleStacks());
+}
+
+TEST(StackPool, reuse) {
+  constexpr size_t kStackSize = 16 * 1024;
+  StackPool::Options options;
+  options.maxResidentIdleStacks = 1;
+  StackPool pool(options);
+
+  auto a = pool.allocate(kStackSize);
+  auto b = pool.allocate(kStackSize);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(StackPool::kSlabSize / kStackSize, pool.numStacks());
+  EXPECT_EQ(pool.numStacks() - 2, pool.numIdleStacks());
+
+  a[0] = 1;
+  b[0] = 1;
+  pool.deallocate(a, kStackSize);
+  // Beyond maxResidentIdleStacks, so its pages are released.
+  pool.deallocate(b, kStackSize);
+  EXPECT_EQ(pool.numStacks(), pool.numIdleStacks());
+
+  auto c = pool.allocate(kStackSize);
+  EXPECT_EQ(b, c);
+  EXPECT_EQ(0, c[0]);
+  pool.deallocate(c, kStackSize);
+
+  EXPECT_EQ(1, pool.trim());
+  EXPECT_EQ(0, pool.trim());
+  EXPECT_EQ(StackPool::kSlabSize / kStackSize, pool.numStacks());
+}
+
+TEST(StackPool, hugePages) {
+  StackPool::Options options;
+  options.useHugePages = true;
+  StackPool pool(options);
+
+  auto stack = pool.allocate(StackPool::kSlabSize + 1);
+  // The slab is aligned to the huge page size, and holds a single stack.
+  EXPECT_EQ(
+      uintptr_t(sysconf(_SC_PAGESIZE) - 1),
+      reinterpret_cast<uintptr_t>(stack) % StackPool::kSlabSize);
+  EXPECT_EQ(1, pool.numStacks());
+  memset(stack, 1, StackPool::kSlabSize + 1);
+  pool.deallocate(stack, StackPool::kSlabSize + 1);
+}
+
+TEST(StackPool, deallocateFromOtherThread) {
+  constexpr size_t kStackSize = 16 * 1024;
+  StackPool pool;
+
+  auto a = pool.allocate(kStackSize);
+  std::thread([&] { pool.deallocate(a, kStackSize); }).join();
+  // Back in the shard of this thread, even if the other one has another.
+  EXPECT_EQ(a, pool.allocate(kStackSize));
+  pool.deallocate(a, kStackSize);
+}
+
+TEST(FiberManager, adaptiveStackSize) {
+  if (folly::kIsSanitizeAddress) {
+    // Stack usage can't be measured with ASAN.
+    return;
+  }
+  FiberManager::Options opts;
+  opts.stackSize = 64 * 1024;
+  opts.stackSizeMultiplier = 1;
+  opts.smallStackSize = 16 * 1024;
+  opts.sampleStackUsageEvery = 3;
+
+  folly::EventBase evb;
+  auto& fm = getFiberManager(evb, opts);
+  auto light = [] {};
+  auto deep = [] {
+    volatile char buf[24 * 1024];
+    buf[0] = 1;
+    buf[sizeof(buf) - 1] = 1;
+  };
+  for (size_t i = 0; i < 4 * FiberManager::kMinStackUsageSamples; ++i) {
+    fm.addTask(light);
+    fm.addTask(deep);
+    evb.loop();
+  }
+
+  EXPECT_LT(0, fm.sampledStackUsage<decltype(light)>());
+  EXPECT_GE(8 * 1024, fm.sampledStackUsage<decltype(light)>());
+  EXPECT_LT(24 * 1024, fm.sampledStackUsage<decltype(deep)>());
+  // Two fibers with large stacks, and one with a small stack for the light
+  // tasks that aren't sampled.
+  EXPECT_EQ(3, fm.fibersAllocated());
+}
+
+TEST(FiberManagerGroup, steal) {
+  folly::ScopedEventBaseThread thread1;
+  folly::ScopedEventBaseThread thread2;
+  auto& fm1 = getFiberManager(*thread1.getEventBase());
+  auto& fm2 = getFiberManager(*thread2.getEventBase());
+  FiberManagerGroup group;
+  group.add(fm1);
+  group.add(fm2);
+
+  constexpr size_t kTasks = 16;
+  std::atomic<size_t> count{0};
+  std::atomic<size_t> stolen{0};
+  Baton done;
+  auto evb2 = thread2.getEventBase();
+  thread1.getEventBase()->runInEventBaseThreadAndWait([&] {
+    for (size_t i = 0; i < kTasks; ++i) {
+      fm1.addTaskStealable([&] {
+        // Keeps fm1 busy, so that fm2 steals the other tasks.
+        /* sleep override */ std::this_thread::sleep_for(
+            std::chrono::milliseconds(10));
+        if (evb2->isInEventBaseThread()) {
+          ++stolen;
+        }
+        if (++count == kTasks) {
+          done.post();
+        }
+      });
+    }
+  });
+  done.wait();
+  EXPECT_LT(0, stolen.load());
+  EXPECT_GT(kTasks, stolen.load());
+}
+
+TEST(TimedBatchDispatcher, sizeAndWindow) {
+  folly::ScopedEventBaseThread evbThread;
+  folly::CPUThreadPoolExecutor executor(2);
+  folly::ManualTimekeeper timekeeper;
+  using Dispatcher = TimedBatchDispatcher<int, std::string>;
+  Dispatcher::Options options;
+  options.maxBatchSize = 4;
+  options.window = std::chrono::milliseconds(20);
+  options.timekeeper = &timekeeper;
+
+  std::mutex mutex;
+  std::vector<size_t> batchSizes;
+  Dispatcher dispatcher(
+      folly::getKeepAliveToken(executor),
+      *evbThread.getEventBase(),
+      [&](std::vector<int>&& values) {
+        std::vector<std::string> results;
+        for (auto value : values) {
+          results.push_back(folly::to<std::string>(value));
+        }
+        std::lock_guard<std::mutex> lg(mutex);
+        batchSizes.push_back(values.size());
+        return results;
+      },
+      options);
+
+  // 6 values from several threads: a batch of 4 is dispatched as soon as it
+  // is full, the other 2 once the window expires.
+  std::vector<std::pair<int, folly::Future<std::string>>> futures;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 2; ++i) {
+        auto value = t * 2 + i;
+        auto future = dispatcher.add(value);
+        std::lock_guard<std::mutex> lg(mutex);
+        futures.emplace_back(value, std::move(future));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  timekeeper.advance(std::chrono::milliseconds(20));
+  for (auto& future : futures) {
+    EXPECT_EQ(
+        folly::to<std::string>(future.first), std::move(future.second).get());
+  }
+  std::lock_guard<std::mutex> lg(mutex);
+  std::sort(batchSizes.begin(), batchSizes.end());
+  EXPECT_EQ((std::vector<size_t>{2, 4}), batchSizes);
+}
+
+TEST(TimedBatchDispatcher, destruction) {
+  folly::ScopedEventBaseThread evbThread;
+  folly::CPUThreadPoolExecutor executor(1);
+  using Dispatcher = TimedBatchDispatcher<int, int>;
+  Dispatcher::Options options;
+  options.window = std::chrono::seconds(60);
+
+  folly::Future<int> future = folly::makeFuture(0);
+  {
+    Dispatcher dispatcher(
+        folly::getKeepAliveToken(executor),
+        *evbThread.getEventBase(),
+        [](std::vector<int>&& values) { return std::move(values); },
+        options);
+    future = dispatcher.add(42);
+  }
+  // Dispatched on destruction rather than after the window.
+  EXPECT_EQ(42, std::move(future).get(std::chrono::seconds(10)));
+}
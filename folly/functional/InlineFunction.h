@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <folly/Function.h>
+#include <folly/Traits.h>
+#include <folly/functional/Invoke.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+/**
+ * InlineFunction is a move-only type-erased callable like folly::Function,
+ * but with the size of its inline storage as a template parameter.
+ *
+ * folly::Function stores callables of up to 6 pointers inline and allocates
+ * anything larger. A lambda capturing a few shared_ptrs and a callback is
+ * already over that, so code that creates many such callables, like task
+ * queues, can pick a capacity that fits them instead:
+ *
+ *   InlineFunction<void(), 96> task = [a, b, c, cob = std::move(cob)] {...};
+ *
+ * Callables that are larger than Capacity, or that may throw when moved, are
+ * stored on the heap unless AllowHeap is false, in which case constructing
+ * the InlineFunction from them does not compile. See InlineTask.
+ *
+ * Only non-const function types are supported, which call a non-const
+ * operator() if the callable has one, same as folly::Function.
+ */
+template <
+    typename FunctionType,
+    std::size_t Capacity = 6 * sizeof(void*),
+    bool AllowHeap = true>
+class InlineFunction;
+
+/**
+ * A move-only task that never allocates: the callable must fit in Capacity
+ * bytes, which is checked at compile time. Meant for executor queues that
+ * want to keep task submission free of allocations. Use toFunction() to pass
+ * one to APIs taking a folly::Function.
+ */
+template <std::size_t Capacity = 8 * sizeof(void*)>
+using InlineTask = InlineFunction<void(), Capacity, false>;
+
+template <
+    typename ReturnType,
+    typename... Args,
+    std::size_t Capacity,
+    bool AllowHeap>
+class InlineFunction<ReturnType(Args...), Capacity, AllowHeap> {
+  static_assert(
+      Capacity >= sizeof(void*),
+      "InlineFunction needs room for at least a pointer");
+
+  template <typename Arg>
+  using CallArg = detail::function::CallArg<Arg>;
+  // Like folly::Function's, with UNWRAP moving the callable into the
+  // Function that dst points to
+  enum class Op { MOVE, NUKE, HEAP, UNWRAP };
+
+  using Storage = std::aligned_storage_t<Capacity, alignof(std::max_align_t)>;
+  using Call = ReturnType (*)(CallArg<Args>..., Storage&);
+  using Exec = std::size_t (*)(Op, Storage*, void*);
+
+  template <typename Fun>
+  using IsInline = bool_constant<
+      sizeof(Fun) <= sizeof(Storage) && alignof(Fun) <= alignof(Storage) &&
+      std::is_nothrow_move_constructible<Fun>::value>;
+
+  template <typename Fun>
+  using EnableIfCallable = std::enable_if_t<
+      !std::is_same<std::decay_t<Fun>, InlineFunction>::value &&
+      is_invocable_r<ReturnType, std::decay_t<Fun>&, Args...>::value>;
+
+  Storage storage_;
+  Call call_{&uninitCall};
+  Exec exec_{nullptr};
+
+  template <typename Fun>
+  static Fun& object(Storage& storage) {
+    return *static_cast<Fun*>(static_cast<void*>(&storage));
+  }
+
+  template <typename Fun>
+  static ReturnType callInline(CallArg<Args>... args, Storage& storage) {
+    return static_cast<ReturnType>(
+        invoke(object<Fun>(storage), static_cast<Args&&>(args)...));
+  }
+
+  template <typename Fun>
+  static ReturnType callHeap(CallArg<Args>... args, Storage& storage) {
+    return static_cast<ReturnType>(
+        invoke(*object<Fun*>(storage), static_cast<Args&&>(args)...));
+  }
+
+  static ReturnType uninitCall(CallArg<Args>..., Storage&) {
+    throw_exception<std::bad_function_call>();
+  }
+
+  template <typename Fun>
+  static std::size_t execInline(Op o, Storage* src, void* dst) {
+    switch (o) {
+      case Op::MOVE:
+        ::new (dst) Fun(std::move(object<Fun>(*src)));
+        object<Fun>(*src).~Fun();
+        break;
+      case Op::UNWRAP:
+        *static_cast<Function<ReturnType(Args...)>*>(dst) =
+            std::move(object<Fun>(*src));
+        FOLLY_FALLTHROUGH;
+      case Op::NUKE:
+        object<Fun>(*src).~Fun();
+        break;
+      case Op::HEAP:
+        break;
+    }
+    return 0U;
+  }
+
+  template <typename Fun>
+  static std::size_t execHeap(Op o, Storage* src, void* dst) {
+    switch (o) {
+      case Op::MOVE:
+        object<Fun*>(*static_cast<Storage*>(dst)) = object<Fun*>(*src);
+        break;
+      case Op::UNWRAP:
+        // Hand over the allocation rather than moving the callable into a
+        // new one
+        *static_cast<Function<ReturnType(Args...)>*>(dst) =
+            [fun = std::unique_ptr<Fun>(object<Fun*>(*src))](
+                Args... args) mutable -> ReturnType {
+          return static_cast<ReturnType>(
+              invoke(*fun, static_cast<Args&&>(args)...));
+        };
+        break;
+      case Op::NUKE:
+        delete object<Fun*>(*src);
+        break;
+      case Op::HEAP:
+        break;
+    }
+    return sizeof(Fun);
+  }
+
+  std::size_t exec(Op o, Storage* src, void* dst) const {
+    if (!exec_) {
+      return 0U;
+    }
+    return exec_(o, src, dst);
+  }
+
+  template <typename Fun>
+  void construct(Fun&& fun, std::true_type) {
+    using FunT = std::decay_t<Fun>;
+    ::new (static_cast<void*>(&storage_)) FunT(static_cast<Fun&&>(fun));
+    call_ = &callInline<FunT>;
+    exec_ = &execInline<FunT>;
+  }
+
+  template <typename Fun>
+  void construct(Fun&& fun, std::false_type) {
+    using FunT = std::decay_t<Fun>;
+    static_assert(
+        AllowHeap,
+        "Callable does not fit in the inline storage of this InlineFunction, "
+        "or may throw when moved");
+    object<FunT*>(storage_) = new FunT(static_cast<Fun&&>(fun));
+    call_ = &callHeap<FunT>;
+    exec_ = &execHeap<FunT>;
+  }
+
+ public:
+  /**
+   * Whether a callable of type Fun is stored inline.
+   */
+  template <typename Fun>
+  static constexpr bool isInline() {
+    return IsInline<std::decay_t<Fun>>::value;
+  }
+
+  InlineFunction() noexcept {}
+
+  /* implicit */ InlineFunction(std::nullptr_t) noexcept {}
+
+  /**
+   * Constructs an InlineFunction from any callable object compatible with
+   * the signature. Stores it inline if it fits, see isInline().
+   */
+  template <typename Fun, typename = EnableIfCallable<Fun>>
+  /* implicit */ InlineFunction(Fun&& fun) noexcept(
+      IsInline<std::decay_t<Fun>>::value&& noexcept(
+          std::decay_t<Fun>(std::declval<Fun>()))) {
+    if (!detail::function::isEmptyFunction(fun)) {
+      construct(static_cast<Fun&&>(fun), IsInline<std::decay_t<Fun>>{});
+    }
+  }
+
+  InlineFunction(const InlineFunction&) = delete;
+  InlineFunction& operator=(const InlineFunction&) = delete;
+
+  InlineFunction(InlineFunction&& that) noexcept
+      : call_(that.call_), exec_(that.exec_) {
+    that.call_ = &uninitCall;
+    that.exec_ = nullptr;
+    exec(Op::MOVE, &that.storage_, &storage_);
+  }
+
+  InlineFunction& operator=(InlineFunction&& that) noexcept {
+    if (&that != this) {
+      exec(Op::NUKE, &storage_, nullptr);
+      call_ = that.call_;
+      exec_ = that.exec_;
+      that.call_ = &uninitCall;
+      that.exec_ = nullptr;
+      exec(Op::MOVE, &that.storage_, &storage_);
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(std::nullptr_t) noexcept {
+    return *this = InlineFunction();
+  }
+
+  ~InlineFunction() {
+    exec(Op::NUKE, &storage_, nullptr);
+  }
+
+  ReturnType operator()(Args... args) {
+    return call_(static_cast<Args&&>(args)..., storage_);
+  }
+
+  /**
+   * Moves the callable into a folly::Function, leaving this empty.
+   *
+   * Prefer this to converting the InlineFunction itself, which wraps all of
+   * its storage and so allocates whenever Capacity is over the 6 pointers
+   * folly::Function stores inline. This only allocates if the callable
+   * itself is too big for folly::Function; a callable that was already on
+   * the heap keeps its allocation.
+   */
+  Function<ReturnType(Args...)> toFunction() && {
+    Function<ReturnType(Args...)> fn;
+    auto e = std::exchange(exec_, nullptr);
+    call_ = &uninitCall;
+    if (e) {
+      e(Op::UNWRAP, &storage_, &fn);
+    }
+    return fn;
+  }
+
+  /**
+   * Returns the number of bytes allocated on the heap for the callable, 0 if
+   * it is stored inline or there is none.
+   */
+  std::size_t heapAllocatedMemory() const noexcept {
+    return exec(Op::HEAP, nullptr, nullptr);
+  }
+
+  explicit operator bool() const noexcept {
+    return exec_ != nullptr;
+  }
+
+  friend bool operator==(const InlineFunction& fn, std::nullptr_t) noexcept {
+    return !fn;
+  }
+  friend bool operator==(std::nullptr_t, const InlineFunction& fn) noexcept {
+    return !fn;
+  }
+  friend bool operator!=(const InlineFunction& fn, std::nullptr_t) noexcept {
+    return !!fn;
+  }
+  friend bool operator!=(std::nullptr_t, const InlineFunction& fn) noexcept {
+    return !!fn;
+  }
+};
+
+} // namespace folly
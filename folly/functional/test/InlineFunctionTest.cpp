@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/functional/InlineFunction.h>
+
+#include <array>
+#include <memory>
+
+#include <folly/portability/GTest.h>
+
+using folly::InlineFunction;
+using folly::InlineTask;
+
+namespace {
+int add(int x, int y) {
+  return x + y;
+}
+
+struct Counted {
+  explicit Counted(std::shared_ptr<int> c) : count(std::move(c)) {}
+  int operator()() {
+    return ++*count;
+  }
+  std::shared_ptr<int> count;
+};
+} // namespace
+
+TEST(InlineFunction, Empty) {
+  InlineFunction<int(int, int)> fn;
+  EXPECT_FALSE(fn);
+  EXPECT_TRUE(fn == nullptr);
+  EXPECT_THROW(fn(1, 2), std::bad_function_call);
+
+  int (*ptr)(int, int) = nullptr;
+  InlineFunction<int(int, int)> fromNull = ptr;
+  EXPECT_FALSE(fromNull);
+}
+
+TEST(InlineFunction, Invoke) {
+  InlineFunction<int(int, int)> fn = add;
+  EXPECT_TRUE(fn);
+  EXPECT_EQ(3, fn(1, 2));
+
+  fn = [](int x, int y) { return x * y; };
+  EXPECT_EQ(6, fn(2, 3));
+
+  auto p = std::make_unique<int>(5);
+  InlineFunction<int(int)> moveOnly = [p = std::move(p)](int x) {
+    return *p + x;
+  };
+  EXPECT_EQ(7, moveOnly(2));
+}
+
+TEST(InlineFunction, Capacity) {
+  auto count = std::make_shared<int>(0);
+  std::array<std::shared_ptr<int>, 6> captures;
+  captures.fill(count);
+  auto lambda = [captures] { return ++*captures[0]; };
+
+  // Too big for folly::Function's inline storage, but not for 128 bytes
+  using Small = InlineFunction<int()>;
+  using Large = InlineFunction<int(), 128>;
+  EXPECT_FALSE(Small::isInline<decltype(lambda)>());
+  EXPECT_TRUE(Large::isInline<decltype(lambda)>());
+
+  Small small = lambda;
+  EXPECT_EQ(sizeof(lambda), small.heapAllocatedMemory());
+  EXPECT_EQ(1, small());
+
+  Large large = lambda;
+  EXPECT_EQ(0, large.heapAllocatedMemory());
+  EXPECT_EQ(2, large());
+
+  // count, then 6 each in captures, lambda, small and large
+  EXPECT_EQ(25, count.use_count());
+  small = nullptr;
+  large = nullptr;
+  EXPECT_EQ(13, count.use_count());
+}
+
+TEST(InlineFunction, Move) {
+  auto count = std::make_shared<int>(0);
+  InlineFunction<int(), 32> a = Counted(count);
+  EXPECT_EQ(1, a());
+  EXPECT_EQ(2, count.use_count());
+
+  auto b = std::move(a);
+  EXPECT_FALSE(a);
+  EXPECT_EQ(2, b());
+  EXPECT_EQ(2, count.use_count());
+
+  InlineFunction<int(), 32> c;
+  c = std::move(b);
+  EXPECT_EQ(3, c());
+  c = std::move(c);
+  c = nullptr;
+  EXPECT_EQ(1, count.use_count());
+}
+
+TEST(InlineFunction, Task) {
+  auto count = std::make_shared<int>(0);
+  std::array<std::shared_ptr<int>, 3> captures;
+  captures.fill(count);
+  InlineTask<> task = [captures, count] { ++*count; };
+  EXPECT_EQ(0, task.heapAllocatedMemory());
+  task();
+  EXPECT_EQ(1, *count);
+
+  // Tasks can be handed to APIs taking folly::Function, which stores the
+  // callable inline if it fits there too
+  InlineTask<> small = [count] { ++*count; };
+  folly::Function<void()> fn = std::move(small).toFunction();
+  EXPECT_FALSE(small);
+  EXPECT_EQ(0, fn.heapAllocatedMemory());
+  fn();
+  EXPECT_EQ(2, *count);
+
+  fn = std::move(task).toFunction();
+  EXPECT_FALSE(task);
+  fn();
+  EXPECT_EQ(3, *count);
+}
+
+TEST(InlineFunction, ToFunctionKeepsHeapAllocation) {
+  auto count = std::make_shared<int>(0);
+  std::array<std::shared_ptr<int>, 6> captures;
+  captures.fill(count);
+  InlineFunction<int(int)> big = [captures](int x) {
+    return *captures[0] += x;
+  };
+  EXPECT_NE(0, big.heapAllocatedMemory());
+
+  // The allocation moves over instead of being copied
+  folly::Function<int(int)> fn = std::move(big).toFunction();
+  EXPECT_EQ(0, fn.heapAllocatedMemory());
+  EXPECT_EQ(2, fn(2));
+  // count, then 6 each in captures and fn
+  EXPECT_EQ(13, count.use_count());
+  fn = nullptr;
+  EXPECT_EQ(7, count.use_count());
+
+  EXPECT_FALSE(InlineFunction<void()>().toFunction());
+}
@@ -367,12 +367,36 @@ FutureBase<T>::thenImplementation(
   static_assert(R::Arg::ArgsSize::value == 2, "Then must take two arguments");
   typedef typename R::ReturnsFuture::Inner B;
 
+  // Fast path: when the result is ready and the continuation would run on
+  // this thread right away anyway, because the future has no executor or
+  // the inline one, or because an inline continuation is added from one
+  // running on the future's executor, run it now.  The returned future is
+  // then the only allocation: no promise, callback or executor task.
+  auto* executor = this->getExecutor();
+  if (this->isReady() && !this->getDeferredExecutor() &&
+      (!executor || executor == &InlineExecutor::instance() ||
+       (allowInline == futures::detail::InlineContinuation::permit &&
+        executor == futures::detail::getContinuationExecutor()))) {
+    using Arg1 = typename R::Arg::ArgList::Tail::FirstArg;
+    auto& t = this->getCore().getTry();
+    Try<B> result = !R::Arg::isTry() && t.hasException()
+        ? Try<B>(std::move(t.exception()))
+        : Try<B>(makeTryWith([&] {
+            return std::forward<F>(func)(
+                getKeepAliveToken(executor),
+                std::move(t).template get<R::Arg::isTry(), Arg1>());
+          }));
+    auto f = Future<B>(futures::detail::Core<B>::make(std::move(result)));
+    f.setExecutor(folly::Executor::KeepAlive<>{executor});
+    return f;
+  }
+
   Promise<B> p;
   p.core_->setInterruptHandlerNoLock(this->getCore().getInterruptHandler());
 
   // grab the Future now before we lose our handle on the Promise
   auto sf = p.getSemiFuture();
-  sf.setExecutor(folly::Executor::KeepAlive<>{this->getExecutor()});
+  sf.setExecutor(folly::Executor::KeepAlive<>{executor});
   auto f = Future<B>(sf.core_);
   sf.core_ = nullptr;
 
@@ -1683,24 +1707,34 @@ collectAnyWithoutException(InputIterator first, InputIterator last) {
 
 // collectN (iterator)
 
+namespace futures {
+namespace detail {
+
+// Calls onCollected once n futures have completed, before fulfilling the
+// promise.
 template <class InputIterator>
 SemiFuture<std::vector<std::pair<
     size_t,
     Try<typename std::iterator_traits<InputIterator>::value_type::value_type>>>>
-collectN(InputIterator first, InputIterator last, size_t n) {
+collectN(
+    InputIterator first,
+    InputIterator last,
+    size_t n,
+    Function<void()> onCollected) {
   using F = typename std::iterator_traits<InputIterator>::value_type;
   using T = typename F::value_type;
   using Result = std::vector<std::pair<size_t, Try<T>>>;
 
   struct Context {
-    explicit Context(size_t numFutures, size_t min_)
-        : v(numFutures), min(min_) {}
+    Context(size_t numFutures, size_t min_, Function<void()> onCollected_)
+        : v(numFutures), min(min_), onCollected(std::move(onCollected_)) {}
 
     std::vector<Optional<Try<T>>> v;
     size_t min;
     std::atomic<size_t> completed = {0}; // # input futures completed
     std::atomic<size_t> stored = {0}; // # output values stored
     Promise<Result> p;
+    Function<void()> onCollected;
   };
 
   assert(n > 0);
@@ -1717,7 +1751,8 @@ collectN(InputIterator first, InputIterator last, size_t n) {
   // for each completed Future, increase count and add to vector, until we
   // have n completed futures at which point we fulfil our Promise with the
   // vector
-  auto ctx = std::make_shared<Context>(size_t(std::distance(first, last)), n);
+  auto ctx = std::make_shared<Context>(
+      size_t(std::distance(first, last)), n, std::move(onCollected));
   for (size_t i = 0; first != last; ++first, ++i) {
     first->setCallback_([i, ctx](Executor::KeepAlive<>&&, Try<T>&& t) {
       // relaxed because this guards control but does not guard data
@@ -1741,6 +1776,9 @@ collectN(InputIterator first, InputIterator last, size_t n) {
           result.emplace_back(j, std::move(entry).value());
         }
       }
+      if (auto onCollected = std::move(ctx->onCollected)) {
+        onCollected();
+      }
       ctx->p.setTry(Try<Result>(std::move(result)));
     });
   }
@@ -1757,6 +1795,37 @@ collectN(InputIterator first, InputIterator last, size_t n) {
   return future;
 }
 
+} // namespace detail
+} // namespace futures
+
+template <class InputIterator>
+SemiFuture<std::vector<std::pair<
+    size_t,
+    Try<typename std::iterator_traits<InputIterator>::value_type::value_type>>>>
+collectN(InputIterator first, InputIterator last, size_t n) {
+  return futures::detail::collectN(first, last, n, nullptr);
+}
+
+// collectNAndCancel (iterator)
+
+template <class InputIterator>
+SemiFuture<std::vector<std::pair<
+    size_t,
+    Try<typename std::iterator_traits<InputIterator>::value_type::value_type>>>>
+collectNAndCancel(InputIterator first, InputIterator last, size_t n) {
+  using F = typename std::iterator_traits<InputIterator>::value_type;
+  // Kept until n futures have completed, to cancel the others.
+  auto inputs = std::make_shared<std::vector<F>>(
+      std::make_move_iterator(first), std::make_move_iterator(last));
+  return futures::detail::collectN(
+      inputs->begin(), inputs->end(), n, [inputs]() mutable {
+        for (auto& future : *inputs) {
+          future.cancel();
+        }
+        inputs.reset();
+      });
+}
+
 // reduce (iterator)
 
 template <class It, class T, class F>
@@ -2090,6 +2159,79 @@ SemiFuture<T> SemiFuture<T>::within(Duration dur, E e, Timekeeper* tk) && {
   return fut;
 }
 
+// withCancellation
+
+template <class T>
+Future<T> Future<T>::withCancellation(CancellationToken token) && {
+  if (this->isReady() || !token.canBeCancelled()) {
+    return std::move(*this);
+  }
+
+  auto* ePtr = this->getExecutor();
+  auto exe =
+      folly::getKeepAliveToken(ePtr ? *ePtr : InlineExecutor::instance());
+  return std::move(*this)
+      .semi()
+      .withCancellation(std::move(token))
+      .via(std::move(exe));
+}
+
+template <class T>
+SemiFuture<T> SemiFuture<T>::withCancellation(CancellationToken token) && {
+  if (this->isReady() || !token.canBeCancelled()) {
+    return std::move(*this);
+  }
+
+  struct Context {
+    SemiFuture<Unit> thisFuture;
+    Promise<T> promise;
+    std::atomic<bool> token{false};
+    Optional<CancellationCallback> callback;
+  };
+
+  auto ctx = std::make_shared<Context>();
+
+  ctx->thisFuture = std::move(*this).defer([ctx](Try<T>&& t) {
+    if (!ctx->token.exchange(true, std::memory_order_relaxed)) {
+      ctx->promise.setTry(std::move(t));
+    }
+    // Only ever destroyed here, so that the callback can run concurrently.
+    ctx->callback.reset();
+  });
+
+  // Properly propagate interrupt values through futures chained after
+  // withCancellation()
+  ctx->promise.setInterruptHandler(
+      [weakCtx = to_weak_ptr(ctx)](const exception_wrapper& ex) {
+        if (auto lockedCtx = weakCtx.lock()) {
+          lockedCtx->thisFuture.raise(ex);
+        }
+      });
+
+  // Construct the future to return before the callback, which may satisfy
+  // the promise right away.
+  auto fut = ctx->promise.getSemiFuture();
+  fut.setExecutor(futures::detail::KeepAliveOrDeferred(
+      futures::detail::DeferredExecutor::create()));
+  std::vector<folly::futures::detail::DeferredWrapper> nestedExecutors;
+  nestedExecutors.emplace_back(ctx->thisFuture.stealDeferredExecutor());
+  futures::detail::getDeferredExecutor(fut)->setNestedExecutors(
+      std::move(nestedExecutors));
+
+  ctx->callback.emplace(
+      std::move(token), [weakCtx = to_weak_ptr(ctx)]() noexcept {
+        auto lockedCtx = weakCtx.lock();
+        if (!lockedCtx) {
+          return;
+        }
+        lockedCtx->thisFuture.raise(FutureCancellation());
+        if (!lockedCtx->token.exchange(true, std::memory_order_relaxed)) {
+          lockedCtx->promise.setException(FutureCancellation());
+        }
+      });
+  return fut;
+}
+
 // delayed
 
 template <class T>
@@ -2537,6 +2679,95 @@ auto ensure(F&& f, Ensure&& ensure) {
       });
 }
 
+namespace detail {
+
+template <class Collection, class F, class Result>
+std::vector<SemiFuture<Result>> mapWindowed(
+    Collection input,
+    size_t maxConcurrency,
+    F func,
+    bool stopOnException) {
+  assert(maxConcurrency > 0);
+  struct MapWindowedContext {
+    MapWindowedContext(Collection&& input_, F&& func_, bool stopOnException_)
+        : input(std::move(input_)),
+          promises(input.size()),
+          func(std::move(func_)),
+          stopOnException(stopOnException_) {}
+    std::atomic<size_t> i{0};
+    std::atomic<bool> failed{false};
+    Collection input;
+    std::vector<Promise<Result>> promises;
+    F func;
+    const bool stopOnException;
+
+    static void spawn(std::shared_ptr<MapWindowedContext> ctx) {
+      size_t i = ctx->i.fetch_add(1, std::memory_order_relaxed);
+      if (i >= ctx->input.size()) {
+        return;
+      }
+      if (ctx->failed.load(std::memory_order_relaxed)) {
+        // Not worth making the remaining calls.
+        for (; i < ctx->input.size();
+             i = ctx->i.fetch_add(1, std::memory_order_relaxed)) {
+          ctx->promises[i].setException(FutureCancellation());
+        }
+        return;
+      }
+      // Use global QueuedImmediateExecutor singleton to avoid stack overflow.
+      auto fut = makeSemiFutureWith(
+                     [&] { return ctx->func(std::move(ctx->input[i])); })
+                     .via(&QueuedImmediateExecutor::instance());
+      fut.setCallback_([ctx = std::move(ctx), i](
+                           Executor::KeepAlive<>&&, Try<Result>&& t) mutable {
+        if (ctx->stopOnException && t.hasException()) {
+          ctx->failed.store(true, std::memory_order_relaxed);
+        }
+        ctx->promises[i].setTry(std::move(t));
+        spawn(std::move(ctx));
+      });
+    }
+  };
+
+  auto ctx = std::make_shared<MapWindowedContext>(
+      std::move(input), std::move(func), stopOnException);
+
+  std::vector<SemiFuture<Result>> futures;
+  futures.reserve(ctx->promises.size());
+  for (auto& promise : ctx->promises) {
+    futures.emplace_back(promise.getSemiFuture());
+  }
+
+  auto max = std::min(maxConcurrency, ctx->input.size());
+  for (size_t i = 0; i < max; ++i) {
+    MapWindowedContext::spawn(ctx);
+  }
+  return futures;
+}
+
+} // namespace detail
+
+template <class Collection, class F, class ItT, class Result>
+std::vector<SemiFuture<Result>>
+mapWindowed(Collection input, size_t maxConcurrency, F func) {
+  return detail::mapWindowed<Collection, F, Result>(
+      std::move(input), maxConcurrency, std::move(func), false);
+}
+
+template <class Collection, class F, class ItT, class Result>
+SemiFuture<std::vector<Try<Result>>>
+collectAllWindowed(Collection input, size_t maxConcurrency, F func) {
+  return collectAll(
+      mapWindowed(std::move(input), maxConcurrency, std::move(func)));
+}
+
+template <class Collection, class F, class ItT, class Result>
+SemiFuture<std::vector<Result>>
+collectWindowed(Collection input, size_t maxConcurrency, F func) {
+  return collect(detail::mapWindowed<Collection, F, Result>(
+      std::move(input), maxConcurrency, std::move(func), true));
+}
+
 } // namespace futures
 
 template <class Clock>
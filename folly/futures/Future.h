@@ -24,6 +24,7 @@
 #include <utility>
 #include <vector>
 
+#include <folly/CancellationToken.h>
 #include <folly/Optional.h>
 #include <folly/Portability.h>
 #include <folly/ScopeGuard.h>
@@ -871,6 +872,23 @@ class SemiFuture : private futures::detail::FutureBase<T> {
   template <class E>
   SemiFuture<T> within(Duration dur, E e, Timekeeper* tk = nullptr) &&;
 
+  /// When cancellation is requested on token before this SemiFuture
+  /// completes, raise FutureCancellation on it, which reaches the producers
+  /// upstream (see `Promise::getCancellationToken()`), and satisfy the
+  /// returned SemiFuture with FutureCancellation right away. Otherwise
+  /// propagate the result.
+  ///
+  /// Preconditions:
+  ///
+  /// - `valid() == true` (else throws FutureInvalid)
+  ///
+  /// Postconditions:
+  ///
+  /// - Calling code should act as if `valid() == false`,
+  ///   i.e., as if `*this` was moved into RESULT.
+  /// - `RESULT.valid() == true`
+  SemiFuture<T> withCancellation(CancellationToken token) &&;
+
   /// Delay the completion of this SemiFuture for at least this duration from
   /// now. The optional Timekeeper is as with futures::sleep().
   ///
@@ -1329,6 +1347,12 @@ class Future : private futures::detail::FutureBase<T> {
   /// execution of func runs on the same executor that func would be executed
   /// on.
   ///
+  /// If this Future is already ready, func runs before thenValue returns
+  /// when the executor is null or the InlineExecutor, and, for the Inline
+  /// versions, when called from a continuation running on this Future's
+  /// executor.  This path allocates only the returned Future's state, which
+  /// is itself recycled through a thread-local free list.
+  ///
   /// A Future for the return type of func is returned.
   ///
   ///   Future<string> f2 = f1.thenValue([](auto&& v) {
@@ -1674,6 +1698,21 @@ class Future : private futures::detail::FutureBase<T> {
   template <class E>
   Future<T> within(Duration dur, E exception, Timekeeper* tk = nullptr) &&;
 
+  /// When cancellation is requested on token before this Future completes,
+  /// raise FutureCancellation on it and satisfy the returned Future with
+  /// FutureCancellation right away; see `SemiFuture::withCancellation()`.
+  ///
+  /// Preconditions:
+  ///
+  /// - `valid() == true` (else throws FutureInvalid)
+  ///
+  /// Postconditions:
+  ///
+  /// - Calling code should act as if `valid() == false`,
+  ///   i.e., as if `*this` was moved into RESULT.
+  /// - `RESULT.valid() == true`
+  Future<T> withCancellation(CancellationToken token) &&;
+
   /// Delay the completion of this Future for at least this duration from
   /// now. The optional Timekeeper is as with futures::sleep().
   ///
@@ -2146,6 +2185,50 @@ SemiFuture<Unit> wait(std::shared_ptr<fibers::Baton> baton);
 template <typename F, class Ensure>
 auto ensure(F&& f, Ensure&& ensure);
 
+/**
+ * Calls func on each element of input, which must return a SemiFuture or a
+ * Future, with at most maxConcurrency of these incomplete at any time, and
+ * returns SemiFutures for their results in the input order, which can be
+ * consumed as they complete. The first maxConcurrency calls are made on
+ * this thread; each later one when an earlier result completes, on a
+ * QueuedImmediateExecutor, as for window().
+ *
+ * This is the SemiFuture counterpart of coro::collectAllWindowed().
+ */
+template <
+    class Collection,
+    class F,
+    class ItT = typename std::iterator_traits<
+        typename Collection::iterator>::value_type,
+    class Result = typename invoke_result_t<F, ItT&&>::value_type>
+std::vector<SemiFuture<Result>>
+mapWindowed(Collection input, size_t maxConcurrency, F func);
+
+/**
+ * collectAll() of mapWindowed(): completes when all the calls have.
+ */
+template <
+    class Collection,
+    class F,
+    class ItT = typename std::iterator_traits<
+        typename Collection::iterator>::value_type,
+    class Result = typename invoke_result_t<F, ItT&&>::value_type>
+SemiFuture<std::vector<Try<Result>>>
+collectAllWindowed(Collection input, size_t maxConcurrency, F func);
+
+/**
+ * collect() of mapWindowed(), which also makes no more calls once one has
+ * failed: the returned SemiFuture fails with the first exception.
+ */
+template <
+    class Collection,
+    class F,
+    class ItT = typename std::iterator_traits<
+        typename Collection::iterator>::value_type,
+    class Result = typename invoke_result_t<F, ItT&&>::value_type>
+SemiFuture<std::vector<Result>>
+collectWindowed(Collection input, size_t maxConcurrency, F func);
+
 } // namespace futures
 
 /**
@@ -2467,6 +2550,23 @@ auto collectN(Collection&& c, size_t n)
   return collectN(c.begin(), c.end(), n);
 }
 
+/** Like collectN, but once n Futures have completed, cancels the others:
+  FutureCancellation is raised on them (see Promise::getCancellationToken)
+  and they are released. The input futures are moved from.
+  */
+template <class InputIterator>
+SemiFuture<std::vector<std::pair<
+    size_t,
+    Try<typename std::iterator_traits<InputIterator>::value_type::value_type>>>>
+collectNAndCancel(InputIterator first, InputIterator last, size_t n);
+
+/// Sugar for the most common case
+template <class Collection>
+auto collectNAndCancel(Collection&& c, size_t n)
+    -> decltype(collectNAndCancel(c.begin(), c.end(), n)) {
+  return collectNAndCancel(c.begin(), c.end(), n);
+}
+
 /** window creates up to n Futures using the values
     in the collection, and then another Future for each Future
     that completes
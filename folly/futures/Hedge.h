@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/functional/Invoke.h>
+#include <folly/futures/Future.h>
+
+namespace folly {
+namespace futures {
+
+/**
+ *  hedge
+ *
+ *  Given a future-factory, calls it with the attempt number 0 and then,
+ *  each time delay passes without a successful result, starts another
+ *  attempt, up to maxAttempts.  A failed attempt starts the next one right
+ *  away.
+ *
+ *  The first attempt to succeed completes the returned SemiFuture, and the
+ *  others are cancelled: FutureCancellation is raised on them, which
+ *  reaches their promises' interrupt handlers and cancellation tokens, and
+ *  the pending timer is cancelled.  If all attempts fail, the returned
+ *  SemiFuture fails with the exception of the last one to fail.  Raising an
+ *  interrupt on the returned SemiFuture, e.g. through within(), raises it
+ *  on all attempts and starts no more.
+ *
+ *  The factory may return a Future or a SemiFuture; the first attempt
+ *  starts right away, and the others on the Timekeeper's thread (or the
+ *  thread of a failed attempt) through a QueuedImmediateExecutor.  The
+ *  optional Timekeeper is as with futures::sleep().
+ */
+template <class FF>
+SemiFuture<typename invoke_result_t<FF, size_t>::value_type>
+hedge(FF&& ff, Duration delay, size_t maxAttempts, Timekeeper* tk = nullptr);
+
+namespace detail {
+
+template <class T, class FF>
+class HedgeContext : public std::enable_shared_from_this<HedgeContext<T, FF>> {
+ public:
+  template <class F>
+  HedgeContext(F&& ff, Duration delay, size_t maxAttempts, Timekeeper* tk)
+      : ff_(std::forward<F>(ff)),
+        delay_(delay),
+        maxAttempts_(maxAttempts),
+        tk_(tk) {
+    attempts_.reserve(maxAttempts);
+  }
+
+  SemiFuture<T> start() {
+    promise_.setInterruptHandler(
+        [weak = std::weak_ptr<HedgeContext>(this->shared_from_this())](
+            const exception_wrapper& e) {
+          if (auto ctx = weak.lock()) {
+            ctx->stop(e);
+          }
+        });
+    auto future = promise_.getSemiFuture();
+    launch();
+    return future;
+  }
+
+ private:
+  void launch() {
+    size_t attempt;
+    SemiFuture<T> semi = SemiFuture<T>::makeEmpty();
+    Future<Unit> previousTimer = Future<Unit>::makeEmpty();
+    {
+      // Also serializes the calls to the factory.
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopped_ || started_ == maxAttempts_) {
+        return;
+      }
+      attempt = started_++;
+      semi = makeSemiFutureWith([&] { return ff_(attempt); });
+      previousTimer = std::move(timer_);
+    }
+    if (previousTimer.valid()) {
+      previousTimer.cancel();
+    }
+
+    auto future = std::move(semi).via(&QueuedImmediateExecutor::instance());
+    future.setCallback_(
+        [ctx = this->shared_from_this()](
+            Executor::KeepAlive<>&&, Try<T>&& t) { ctx->complete(t); });
+
+    Future<Unit> timer = Future<Unit>::makeEmpty();
+    if (attempt + 1 < maxAttempts_) {
+      timer = futures::sleep(delay_, tk_)
+                  .via(&QueuedImmediateExecutor::instance())
+                  .thenValue([ctx = this->shared_from_this()](Unit) {
+                    ctx->launch();
+                  });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      // Completed meanwhile; the cancellation missed these.
+      timer.cancel();
+      future.cancel();
+      return;
+    }
+    attempts_.push_back(std::move(future));
+    if (timer.valid()) {
+      timer_ = std::move(timer);
+    }
+  }
+
+  void complete(Try<T>& t) {
+    bool finished;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (done_) {
+        return;
+      }
+      if (!t.hasValue()) {
+        ++failed_;
+      }
+      // On the first success, or once all the attempts that can be made
+      // have failed.
+      finished = t.hasValue() ||
+          (failed_ == started_ && (stopped_ || started_ == maxAttempts_));
+      done_ = finished;
+    }
+    if (!finished) {
+      // A failed attempt starts the next one right away.
+      launch();
+      return;
+    }
+    stop(FutureCancellation());
+    promise_.setTry(std::move(t));
+  }
+
+  // Cancels the attempts and the timer, and starts no more attempts.
+  void stop(exception_wrapper e) {
+    std::vector<Future<T>> attempts;
+    Future<Unit> timer = Future<Unit>::makeEmpty();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+      attempts = std::move(attempts_);
+      timer = std::move(timer_);
+    }
+    if (timer.valid()) {
+      timer.cancel();
+    }
+    for (auto& attempt : attempts) {
+      attempt.raise(e);
+    }
+  }
+
+  FF ff_;
+  const Duration delay_;
+  const size_t maxAttempts_;
+  Timekeeper* const tk_;
+  Promise<T> promise_;
+
+  std::mutex mutex_;
+  size_t started_{0};
+  size_t failed_{0};
+  bool stopped_{false};
+  bool done_{false};
+  std::vector<Future<T>> attempts_;
+  Future<Unit> timer_{Future<Unit>::makeEmpty()};
+};
+
+} // namespace detail
+
+template <class FF>
+SemiFuture<typename invoke_result_t<FF, size_t>::value_type>
+hedge(FF&& ff, Duration delay, size_t maxAttempts, Timekeeper* tk) {
+  using T = typename invoke_result_t<FF, size_t>::value_type;
+  if (maxAttempts == 0) {
+    return makeSemiFuture<T>(std::invalid_argument("hedge: no attempts"));
+  }
+  return std::make_shared<detail::HedgeContext<T, std::decay_t<FF>>>(
+             std::forward<FF>(ff), delay, maxAttempts, tk)
+      ->start();
+}
+
+} // namespace futures
+} // namespace folly
@@ -124,6 +124,11 @@ void Promise<T>::setInterruptHandler(F&& fn) {
   getCore().setInterruptHandler(std::forward<F>(fn));
 }
 
+template <class T>
+CancellationToken Promise<T>::getCancellationToken() {
+  return getCore().getCancellationToken();
+}
+
 template <class T>
 void Promise<T>::setTry(Try<T>&& t) {
   throwIfFulfilled();
@@ -314,6 +314,17 @@ class Promise {
   template <typename F>
   void setInterruptHandler(F&& fn);
 
+  /// Returns a token for which cancellation is requested when the consumer
+  /// raises an interrupt, under the same conditions as the interrupt handler
+  /// is called (see `setInterruptHandler()`, which may be used as well): when
+  /// the future is cancelled, times out in `within()`, or a token passed to
+  /// `withCancellation()` further down the chain is cancelled.
+  ///
+  /// Like the interrupt handler, it only sees interrupts raised on futures
+  /// chained after this call, so call it before handing out the future.
+  /// Producers can pass it to cancellable work, e.g. a coroutine.
+  CancellationToken getCancellationToken();
+
   /// Fulfills a (logically) void Promise, that is, Promise<Unit>.
   /// (If you want a void-promise, use Promise<Unit>, not Promise<void>.)
   ///
@@ -17,13 +17,31 @@
 #include <folly/futures/ThreadWheelTimekeeper.h>
 
 #include <folly/Singleton.h>
+#include <folly/concurrency/CacheLocality.h>
 #include <folly/futures/Future.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GFlags.h>
 #include <future>
 
+DEFINE_int32(
+    folly_timekeeper_shards,
+    1,
+    "Number of threads of the default Timekeeper, each with its own wheel");
+DEFINE_bool(
+    folly_timekeeper_local_event_base,
+    false,
+    "Whether the default Timekeeper schedules timers on the caller's "
+    "EventBase when called from its loop thread");
+
 namespace folly {
 
 namespace {
-Singleton<ThreadWheelTimekeeper> timekeeperSingleton_;
+Singleton<ThreadWheelTimekeeper> timekeeperSingleton_([] {
+  ThreadWheelTimekeeper::Options options;
+  options.numShards = size_t(std::max(FLAGS_folly_timekeeper_shards, 1));
+  options.useLocalEventBase = FLAGS_folly_timekeeper_local_event_base;
+  return new ThreadWheelTimekeeper(options);
+});
 
 // Our Callback object for HHWheelTimer
 struct WTCallback : public std::enable_shared_from_this<WTCallback>,
@@ -100,17 +118,53 @@ struct WTCallback : public std::enable_shared_from_this<WTCallback>,
   }
 };
 
+SemiFuture<Unit> scheduleTimeout(
+    EventBase& eventBase,
+    HHWheelTimer& wheelTimer,
+    Duration dur) {
+  auto cob = WTCallback::create(&eventBase);
+  auto f = cob->getSemiFuture();
+  if (eventBase.inRunningEventBaseThread()) {
+    wheelTimer.scheduleTimeout(cob.get(), dur);
+    return f;
+  }
+  //
+  // Even shared_ptr of cob is captured in lambda this is still somewhat *racy*
+  // because it will be released once timeout is scheduled. So technically there
+  // is no gurantee that EventBase thread can safely call timeout callback.
+  // However due to fact that we are having circular reference here:
+  // WTCallback->Promise->Core->WTCallbak, so three of them won't go away until
+  // we break the circular reference. The break happens either in
+  // WTCallback::timeoutExpired or WTCallback::interruptHandler. Former means
+  // timeout callback is being safely executed. Latter captures shared_ptr of
+  // WTCallback again in another lambda for canceling timeout. The moment
+  // canceling timeout is executed in EventBase thread, the actual timeout
+  // callback has either been executed, or will never be executed. So we are
+  // fine here.
+  //
+  eventBase.runInEventBaseThread(
+      [&wheelTimer, cob, dur] { wheelTimer.scheduleTimeout(cob.get(), dur); });
+  return f;
+}
+
 } // namespace
 
 ThreadWheelTimekeeper::ThreadWheelTimekeeper()
+    : ThreadWheelTimekeeper(Options()) {}
+
+ThreadWheelTimekeeper::ThreadWheelTimekeeper(Options options)
     : thread_([this] { eventBase_.loopForever(); }),
       wheelTimer_(
-          HHWheelTimer::newTimer(&eventBase_, std::chrono::milliseconds(1))) {
+          HHWheelTimer::newTimer(&eventBase_, std::chrono::milliseconds(1))),
+      useLocalEventBase_(options.useLocalEventBase) {
   eventBase_.waitUntilRunning();
   eventBase_.runInEventBaseThread([this] {
     // 15 characters max
     eventBase_.setName("FutureTimekeepr");
   });
+  for (size_t i = 1; i < options.numShards; ++i) {
+    shards_.push_back(std::make_unique<ThreadWheelTimekeeper>());
+  }
 }
 
 ThreadWheelTimekeeper::~ThreadWheelTimekeeper() {
@@ -122,25 +176,23 @@ ThreadWheelTimekeeper::~ThreadWheelTimekeeper() {
 }
 
 SemiFuture<Unit> ThreadWheelTimekeeper::after(Duration dur) {
-  auto cob = WTCallback::create(&eventBase_);
-  auto f = cob->getSemiFuture();
-  //
-  // Even shared_ptr of cob is captured in lambda this is still somewhat *racy*
-  // because it will be released once timeout is scheduled. So technically there
-  // is no gurantee that EventBase thread can safely call timeout callback.
-  // However due to fact that we are having circular reference here:
-  // WTCallback->Promise->Core->WTCallbak, so three of them won't go away until
-  // we break the circular reference. The break happens either in
-  // WTCallback::timeoutExpired or WTCallback::interruptHandler. Former means
-  // timeout callback is being safely executed. Latter captures shared_ptr of
-  // WTCallback again in another lambda for canceling timeout. The moment
-  // canceling timeout is executed in EventBase thread, the actual timeout
-  // callback has either been executed, or will never be executed. So we are
-  // fine here.
-  //
-  eventBase_.runInEventBaseThread(
-      [this, cob, dur] { wheelTimer_->scheduleTimeout(cob.get(), dur); });
-  return f;
+  if (useLocalEventBase_) {
+    auto* eventBase = EventBaseManager::get()->getExistingEventBase();
+    if (eventBase && eventBase->inRunningEventBaseThread()) {
+      return scheduleTimeout(*eventBase, eventBase->timer(), dur);
+    }
+  }
+  if (!shards_.empty()) {
+    auto shard = AccessSpreader<>::cachedCurrent(shards_.size() + 1);
+    if (shard > 0) {
+      return shards_[shard - 1]->afterOnThisShard(dur);
+    }
+  }
+  return afterOnThisShard(dur);
+}
+
+SemiFuture<Unit> ThreadWheelTimekeeper::afterOnThisShard(Duration dur) {
+  return scheduleTimeout(eventBase_, *wheelTimer_, dur);
 }
 
 namespace detail {
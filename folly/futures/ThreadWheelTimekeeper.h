@@ -19,26 +19,53 @@
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/HHWheelTimer.h>
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace folly {
 
 /// The default Timekeeper implementation which uses a HHWheelTimer on an
 /// EventBase in a dedicated thread. Users needn't deal with this directly, it
 /// is used by default by Future methods that work with timeouts.
+///
+/// With several shards, each has its own thread and wheel, and callers use
+/// the shard of their CPU, so that timers scheduled from many threads don't
+/// all contend on a single EventBase's queue. Timers scheduled from the
+/// thread of a shard skip the queue.
 class ThreadWheelTimekeeper : public Timekeeper {
  public:
+  struct Options {
+    /// Number of threads, each running its own wheel.
+    size_t numShards{1};
+    /// Schedule timers on the HHWheelTimer of the caller's EventBase
+    /// (the one EventBaseManager returns) when called from its loop
+    /// thread. The timers then fire, with that wheel's resolution, and
+    /// their inline continuations run, on that thread; they fail with
+    /// FutureNoTimekeeper if that EventBase is destroyed first.
+    bool useLocalEventBase{false};
+  };
+
   /// But it doesn't *have* to be a singleton.
   ThreadWheelTimekeeper();
+  explicit ThreadWheelTimekeeper(Options options);
   ~ThreadWheelTimekeeper() override;
 
   /// Implement the Timekeeper interface
   SemiFuture<Unit> after(Duration) override;
 
  protected:
+  // The first shard.
   folly::EventBase eventBase_;
   std::thread thread_;
   HHWheelTimer::UniquePtr wheelTimer_;
+
+ private:
+  SemiFuture<Unit> afterOnThisShard(Duration);
+
+  bool useLocalEventBase_{false};
+  // The other shards.
+  std::vector<std::unique_ptr<ThreadWheelTimekeeper>> shards_;
 };
 
 } // namespace folly
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/futures/detail/Core.h>
+
+#include <folly/memory/Malloc.h>
+#include <folly/memory/detail/ThreadLocalFreeLists.h>
+
+namespace folly {
+namespace futures {
+namespace detail {
+
+namespace {
+
+constexpr std::size_t kCoreSizeGranularity = 64;
+constexpr std::size_t kNumCoreSizeClasses = 8;
+constexpr std::size_t kMaxCachedCores = 64;
+
+using CoreFreeLists =
+    folly::detail::FreeLists<kCoreSizeGranularity, kNumCoreSizeClasses>;
+
+thread_local Executor* continuationExecutor = nullptr;
+
+} // namespace
+
+void* allocateCore(std::size_t size) {
+  if (!CoreFreeLists::cacheable(size)) {
+    return checkedMalloc(size);
+  }
+  if (auto* cache = folly::detail::ThreadLocalCache<CoreFreeLists>::get()) {
+    if (auto* core = cache->pop(size)) {
+      return core;
+    }
+  }
+  return checkedMalloc(CoreFreeLists::roundUp(size));
+}
+
+void deallocateCore(void* p, std::size_t size) noexcept {
+  auto* cache = folly::detail::ThreadLocalCache<CoreFreeLists>::get();
+  if (!CoreFreeLists::cacheable(size) || !cache ||
+      !cache->push(p, size, kMaxCachedCores)) {
+    free(p);
+  }
+}
+
+Executor* getContinuationExecutor() noexcept {
+  return continuationExecutor;
+}
+
+ContinuationExecutorGuard::ContinuationExecutorGuard(
+    Executor* executor) noexcept
+    : prev_(std::exchange(continuationExecutor, executor)) {}
+
+ContinuationExecutorGuard::~ContinuationExecutorGuard() {
+  continuationExecutor = prev_;
+}
+
+} // namespace detail
+} // namespace futures
+} // namespace folly
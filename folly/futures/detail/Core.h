@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <mutex>
 #include <stdexcept>
 #include <utility>
@@ -24,6 +25,7 @@
 
 #include <boost/variant.hpp>
 
+#include <folly/CancellationToken.h>
 #include <folly/Executor.h>
 #include <folly/Function.h>
 #include <folly/Optional.h>
@@ -35,6 +37,7 @@
 #include <folly/lang/Exception.h>
 #include <folly/synchronization/AtomicUtil.h>
 #include <folly/synchronization/MicroSpinLock.h>
+#include <folly/tracing/StaticTracepoint.h>
 #include <glog/logging.h>
 
 #include <folly/io/async/Request.h>
@@ -337,6 +340,43 @@ inline KeepAliveOrDeferred KeepAliveOrDeferred::copy() const {
   }
 }
 
+/// Cores are allocated and freed for every continuation, so freed ones are
+/// kept in small thread-local free lists, by size rounded up to 64 bytes,
+/// and reused by the next allocation on the same thread. Cores larger than
+/// 512 bytes, and all cores in sanitized builds, use malloc directly.
+void* allocateCore(std::size_t size);
+void deallocateCore(void* p, std::size_t size) noexcept;
+
+template <bool Cached>
+struct CoreAllocation {};
+
+template <>
+struct CoreAllocation<true> {
+  static void* operator new(std::size_t size) {
+    return allocateCore(size);
+  }
+  static void operator delete(void* p, std::size_t size) noexcept {
+    deallocateCore(p, size);
+  }
+};
+
+/// The executor running the continuation that is executing on this thread,
+/// if it was scheduled through one.
+Executor* getContinuationExecutor() noexcept;
+
+class ContinuationExecutorGuard {
+ public:
+  explicit ContinuationExecutorGuard(Executor* executor) noexcept;
+  ~ContinuationExecutorGuard();
+
+  ContinuationExecutorGuard(ContinuationExecutorGuard const&) = delete;
+  ContinuationExecutorGuard& operator=(ContinuationExecutorGuard const&) =
+      delete;
+
+ private:
+  Executor* prev_;
+};
+
 /// The shared state object for Future and Promise.
 ///
 /// Nomenclature:
@@ -467,7 +507,9 @@ inline KeepAliveOrDeferred KeepAliveOrDeferred::copy() const {
 /// - In general, as long as the user doesn't access a future or promise object
 ///   from more than one thread at a time there won't be any problems.
 template <typename T>
-class Core final {
+class Core final
+    : private CoreAllocation<
+          alignof(Try<T>) <= alignof(std::max_align_t)> {
   static_assert(
       !std::is_void<T>::value,
       "void futures are not supported. Use Unit instead.");
@@ -818,9 +860,36 @@ class Core final {
   void setInterruptHandlerNoLock(
       std::function<void(exception_wrapper const&)> fn) {
     interruptHandlerSet_.store(true, std::memory_order_relaxed);
+    if (cancellationSource_.canBeCancelled()) {
+      fn = [fn = std::move(fn), source = cancellationSource_](
+               exception_wrapper const& e) {
+        source.requestCancellation();
+        if (fn) {
+          fn(e);
+        }
+      };
+    }
     interruptHandler_ = std::move(fn);
   }
 
+  /// Call only from producer thread
+  ///
+  /// Returns a token for which cancellation is requested when an interrupt
+  /// reaches the interrupt handler, whether or not there is one, i.e. under
+  /// the same conditions.
+  CancellationToken getCancellationToken() {
+    std::lock_guard<SpinLock> lock(interruptLock_);
+    if (!cancellationSource_.canBeCancelled()) {
+      cancellationSource_ = CancellationSource();
+      if (interrupt_) {
+        cancellationSource_.requestCancellation();
+      } else if (!hasResult()) {
+        setInterruptHandlerNoLock(std::move(interruptHandler_));
+      }
+    }
+    return cancellationSource_.getToken();
+  }
+
  private:
   Core() : state_(State::Start), attached_(2) {}
 
@@ -937,6 +1006,7 @@ class Core final {
       callbackReferences_.fetch_add(2, std::memory_order_relaxed);
       CoreAndCallbackReference guard_local_scope(this);
       CoreAndCallbackReference guard_lambda(this);
+      FOLLY_SDT(folly, future_callback_enqueue, this);
       try {
         doAdd(
             std::move(completingKA),
@@ -946,7 +1016,10 @@ class Core final {
               auto cr = std::move(core_ref);
               Core* const core = cr.getCore();
               RequestContextScopeGuard rctx(std::move(core->context_));
+              ContinuationExecutorGuard continuationExecutor(ka.get());
+              FOLLY_SDT(folly, future_callback_run, core, ka.get());
               core->callback_(std::move(ka), std::move(core->result_));
+              FOLLY_SDT(folly, future_callback_done, core);
             });
       } catch (const std::exception& e) {
         ew = exception_wrapper(std::current_exception(), e);
@@ -966,7 +1039,9 @@ class Core final {
         detachOne();
       };
       RequestContextScopeGuard rctx(std::move(context_));
+      FOLLY_SDT(folly, future_callback_run, this, completingKA.get());
       callback_(std::move(completingKA), std::move(result_));
+      FOLLY_SDT(folly, future_callback_done, this);
     }
   }
 
@@ -1024,6 +1099,7 @@ class Core final {
   };
   std::unique_ptr<exception_wrapper> interrupt_{};
   std::function<void(exception_wrapper const&)> interruptHandler_{nullptr};
+  CancellationSource cancellationSource_{CancellationSource::invalid()};
 };
 } // namespace detail
 } // namespace futures
@@ -16,6 +16,7 @@
 
 #include <folly/Benchmark.h>
 #include <folly/executors/InlineExecutor.h>
+#include <folly/executors/ManualExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/futures/test/TestExecutor.h>
@@ -123,6 +124,33 @@ BENCHMARK_RELATIVE(hundredThensOnThreadInline) {
   someThensOnThread(100, true);
 }
 
+// An RPC-like chain of continuations: on a ready future they run without
+// allocating anything but the futures' cores, which are recycled.
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(twentyThensPending) {
+  Promise<int> p;
+  auto f = thens(p.getFuture(), 20);
+  p.setValue(42);
+  f.value();
+}
+
+BENCHMARK_RELATIVE(twentyThensReady) {
+  thens(makeFuture<int>(42), 20).value();
+}
+
+BENCHMARK_RELATIVE(twentyThensReadyInlineOnExecutor, iters) {
+  ManualExecutor manual;
+  makeFuture()
+      .via(&manual)
+      .thenValue([&](auto&&) {
+        for (size_t i = 0; i < iters; ++i) {
+          thens(makeFuture<int>(42).via(&manual), 20, true).value();
+        }
+      })
+      .getVia(&manual);
+}
+
 // Lock contention. Although in practice fulfills tend to be temporally
 // separate from then()s, still sometimes they will be concurrent. So the
 // higher this number is, the better.
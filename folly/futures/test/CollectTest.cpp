@@ -701,6 +701,33 @@ TEST(Collect, collectN) {
   EXPECT_TRUE(flag);
 }
 
+TEST(Collect, collectNAndCancel) {
+  std::vector<Promise<int>> promises(5);
+  std::vector<CancellationToken> tokens;
+  std::vector<Future<int>> futures;
+
+  for (auto& p : promises) {
+    tokens.push_back(p.getCancellationToken());
+    futures.push_back(p.getFuture());
+  }
+
+  auto f = collectNAndCancel(futures, 2);
+  promises[3].setValue(3);
+  EXPECT_FALSE(tokens[0].isCancellationRequested());
+  promises[1].setValue(1);
+  EXPECT_TRUE(f.isReady());
+  for (size_t i = 0; i < tokens.size(); i++) {
+    EXPECT_EQ(i != 1 && i != 3, tokens[i].isCancellationRequested());
+  }
+  auto v = std::move(f).get();
+  ASSERT_EQ(2, v.size());
+  std::sort(v.begin(), v.end(), [](auto& a, auto& b) {
+    return a.first < b.first;
+  });
+  EXPECT_EQ(1, v[0].second.value());
+  EXPECT_EQ(3, v[1].second.value());
+}
+
 TEST(Collect, collectNParallel) {
   std::vector<Promise<Unit>> ps(100);
   std::vector<Future<Unit>> futures;
@@ -785,6 +785,32 @@ TEST(Future, ThenValueWithExecutor) {
   std::move(sf).getVia(&executor);
 }
 
+TEST(Future, ThenValueInlineReadyOnSameExecutor) {
+  ManualExecutor executor;
+  bool ranInline = false;
+  auto f = makeFuture(42).via(&executor).thenValue([&](int val) {
+    // Ready, and added from a continuation on the same executor.
+    auto inner = makeFuture(val).via(&executor).thenValueInline(
+        [&](int v) {
+          ranInline = true;
+          return v + 1;
+        });
+    EXPECT_TRUE(ranInline);
+    return std::move(inner).value();
+  });
+  EXPECT_EQ(43, std::move(f).getVia(&executor));
+
+  // Not an inline continuation: it still goes through the executor.
+  ranInline = false;
+  auto f2 = makeFuture(42).via(&executor).thenValue([&](int val) {
+    ranInline = true;
+    return val;
+  });
+  EXPECT_FALSE(ranInline);
+  EXPECT_EQ(42, std::move(f2).getVia(&executor));
+  EXPECT_TRUE(ranInline);
+}
+
 TEST(Future, thenValueFuture) {
   bool flag = false;
   makeFuture<int>(42)
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/futures/Hedge.h>
+
+#include <vector>
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/futures/ManualTimekeeper.h>
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+using namespace folly;
+
+namespace {
+
+// ManualTimekeeper fulfills the timers under its lock, which the callbacks
+// starting the next timers need: queue them until it is released.
+void advance(ManualTimekeeper& tk, Duration dur) {
+  QueuedImmediateExecutor::instance().add([&] { tk.advance(dur); });
+}
+
+struct Attempts {
+  explicit Attempts(size_t n) : promises(n) {
+    for (auto& promise : promises) {
+      tokens.push_back(promise.getCancellationToken());
+    }
+  }
+
+  SemiFuture<int> operator()(size_t attempt) {
+    started++;
+    return promises[attempt].getSemiFuture();
+  }
+
+  std::vector<Promise<int>> promises;
+  std::vector<CancellationToken> tokens;
+  size_t started{0};
+};
+
+} // namespace
+
+TEST(HedgeTest, FirstSuccessWins) {
+  ManualTimekeeper tk;
+  Attempts attempts(3);
+  auto f = futures::hedge(std::ref(attempts), 10ms, 3, &tk);
+  EXPECT_EQ(1, attempts.started);
+
+  advance(tk, 10ms);
+  EXPECT_EQ(2, attempts.started);
+
+  attempts.promises[1].setValue(1);
+  EXPECT_EQ(1, std::move(f).get());
+  EXPECT_TRUE(attempts.tokens[0].isCancellationRequested());
+  EXPECT_FALSE(attempts.tokens[1].isCancellationRequested());
+
+  advance(tk, 10ms);
+  EXPECT_EQ(2, attempts.started);
+}
+
+TEST(HedgeTest, FailureStartsNextAttempt) {
+  ManualTimekeeper tk;
+  Attempts attempts(3);
+  auto f = futures::hedge(std::ref(attempts), 10ms, 3, &tk);
+  attempts.promises[0].setException(std::runtime_error("first"));
+  EXPECT_EQ(2, attempts.started);
+  attempts.promises[1].setValue(2);
+  EXPECT_EQ(2, std::move(f).get());
+}
+
+TEST(HedgeTest, AllAttemptsFail) {
+  ManualTimekeeper tk;
+  Attempts attempts(2);
+  auto f = futures::hedge(std::ref(attempts), 10ms, 2, &tk);
+  advance(tk, 10ms);
+  EXPECT_EQ(2, attempts.started);
+  attempts.promises[1].setException(std::runtime_error("second"));
+  attempts.promises[0].setException(std::logic_error("first"));
+  EXPECT_THROW(std::move(f).get(), std::logic_error);
+}
+
+TEST(HedgeTest, Interrupt) {
+  ManualTimekeeper tk;
+  Attempts attempts(3);
+  auto f = futures::hedge(std::ref(attempts), 10ms, 3, &tk);
+  f.cancel();
+  EXPECT_TRUE(attempts.tokens[0].isCancellationRequested());
+  advance(tk, 10ms);
+  EXPECT_EQ(1, attempts.started);
+  attempts.promises[0].setException(FutureCancellation());
+  EXPECT_THROW(std::move(f).get(), FutureCancellation);
+}
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <folly/CancellationToken.h>
+#include <folly/executors/InlineExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/futures/test/TestExecutor.h>
@@ -92,3 +94,63 @@ TEST(Interrupt, semiFutureWithinTimedOut) {
   // Give it 100ms to time out and call the interrupt handler
   EXPECT_TRUE(done.try_wait_for(std::chrono::milliseconds(100)));
 }
+
+TEST(Interrupt, cancellationToken) {
+  Promise<int> p;
+  bool flag = false;
+  p.setInterruptHandler([&](const exception_wrapper& /* e */) { flag = true; });
+  auto token = p.getCancellationToken();
+  EXPECT_TRUE(token.canBeCancelled());
+  auto f = p.getSemiFuture().deferValue([](int i) { return i; });
+  EXPECT_FALSE(token.isCancellationRequested());
+  f.cancel();
+  EXPECT_TRUE(token.isCancellationRequested());
+  EXPECT_TRUE(flag);
+}
+
+TEST(Interrupt, cancellationTokenAfterInterrupt) {
+  Promise<int> p;
+  p.getFuture().cancel();
+  EXPECT_TRUE(p.getCancellationToken().isCancellationRequested());
+}
+
+TEST(Interrupt, cancellationTokenAfterFulfil) {
+  Promise<int> p;
+  auto f = p.getFuture();
+  p.setValue(42);
+  auto token = p.getCancellationToken();
+  f.cancel();
+  EXPECT_FALSE(token.isCancellationRequested());
+}
+
+TEST(Interrupt, futureWithinTimedOutCancelsToken) {
+  Promise<int> p;
+  auto token = p.getCancellationToken();
+  Baton<> done;
+  CancellationCallback cb(token, [&] { done.post(); });
+  p.getFuture().within(std::chrono::milliseconds(1));
+  EXPECT_TRUE(done.try_wait_for(std::chrono::milliseconds(100)));
+}
+
+TEST(Interrupt, withCancellation) {
+  Promise<int> p;
+  auto token = p.getCancellationToken();
+  CancellationSource source;
+  auto f = p.getSemiFuture()
+               .withCancellation(source.getToken())
+               .via(&InlineExecutor::instance())
+               .thenValue([](int i) { return i + 1; });
+  EXPECT_FALSE(f.isReady());
+  source.requestCancellation();
+  EXPECT_TRUE(token.isCancellationRequested());
+  EXPECT_THROW(std::move(f).get(), FutureCancellation);
+}
+
+TEST(Interrupt, withCancellationCompleted) {
+  Promise<int> p;
+  CancellationSource source;
+  auto f = p.getFuture().withCancellation(source.getToken());
+  p.setValue(42);
+  source.requestCancellation();
+  EXPECT_EQ(42, std::move(f).get());
+}
@@ -19,6 +19,7 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/ThreadWheelTimekeeper.h>
+#include <folly/io/async/EventBaseManager.h>
 #include <folly/portability/GTest.h>
 
 using namespace folly;
@@ -490,3 +491,77 @@ TEST_F(TimekeeperFixture, destruction) {
   EXPECT_TRUE(f.isReady());
   EXPECT_TRUE(f.hasException());
 }
+
+TEST(Timekeeper, shards) {
+  ThreadWheelTimekeeper::Options options;
+  options.numShards = 4;
+  ThreadWheelTimekeeper tk(options);
+
+  std::vector<std::thread> threads;
+  std::atomic<size_t> fired{0};
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      auto t1 = now();
+      std::vector<SemiFuture<Unit>> futures;
+      for (size_t j = 0; j < 16; ++j) {
+        futures.push_back(tk.after(one_ms));
+      }
+      for (auto& f : futures) {
+        std::move(f).get();
+        ++fired;
+      }
+      EXPECT_GE(now() - t1, one_ms);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(8 * 16, fired);
+}
+
+TEST(Timekeeper, shardsDestruction) {
+  ThreadWheelTimekeeper::Options options;
+  options.numShards = 4;
+  folly::Optional<ThreadWheelTimekeeper> tk;
+  tk.emplace(options);
+  std::vector<SemiFuture<Unit>> futures;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      auto f = tk->after(too_long);
+      std::lock_guard<std::mutex> guard(mutex);
+      futures.push_back(std::move(f));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  tk.clear();
+  for (auto& f : futures) {
+    EXPECT_TRUE(f.isReady());
+    EXPECT_TRUE(f.hasException());
+  }
+}
+
+TEST(Timekeeper, localEventBase) {
+  ThreadWheelTimekeeper::Options options;
+  options.useLocalEventBase = true;
+  ThreadWheelTimekeeper tk(options);
+
+  EventBase* eventBase = EventBaseManager::get()->getEventBase();
+  std::thread::id firedOn;
+  eventBase->runInLoop([&] {
+    tk.after(one_ms).toUnsafeFuture().thenValue([&](auto&&) {
+      firedOn = std::this_thread::get_id();
+      eventBase->terminateLoopSoon();
+    });
+  });
+  eventBase->loopForever();
+  EXPECT_EQ(std::this_thread::get_id(), firedOn);
+
+  // not from the loop thread
+  auto t1 = now();
+  tk.after(one_ms).get();
+  EXPECT_GE(now() - t1, one_ms);
+}
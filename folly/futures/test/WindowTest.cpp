@@ -442,3 +442,64 @@ TEST(WindowExecutor, allParallelWithError) {
     }
   }
 }
+
+TEST(Window, mapWindowed) {
+  std::vector<Promise<int>> ps(10);
+  std::vector<int> input;
+  for (size_t i = 0; i < ps.size(); i++) {
+    input.emplace_back(i);
+  }
+  size_t started = 0;
+  auto fs = futures::mapWindowed(input, 3, [&](int i) {
+    started++;
+    return ps[i].getSemiFuture();
+  });
+  ASSERT_EQ(ps.size(), fs.size());
+  EXPECT_EQ(3, started);
+
+  // Completing out of order starts the next one, results stay in order.
+  ps[1].setValue(1);
+  EXPECT_EQ(4, started);
+  EXPECT_TRUE(fs[1].isReady());
+  EXPECT_FALSE(fs[0].isReady());
+  for (size_t i = 0; i < ps.size(); i++) {
+    if (i != 1) {
+      ps[i].setValue(i * 10);
+    }
+  }
+  EXPECT_EQ(10, started);
+  EXPECT_EQ(1, std::move(fs[1]).get());
+  EXPECT_EQ(90, std::move(fs[9]).get());
+}
+
+TEST(Window, collectAllWindowed) {
+  std::vector<int> input = {1, 2, 3, 4, 5};
+  auto f = futures::collectAllWindowed(input, 2, [](int i) {
+    if (i == 3) {
+      return makeSemiFuture<int>(eggs);
+    }
+    return makeSemiFuture(i);
+  });
+  auto results = std::move(f).get();
+  ASSERT_EQ(5, results.size());
+  EXPECT_EQ(1, results[0].value());
+  EXPECT_THROW(results[2].value(), eggs_t);
+  EXPECT_EQ(5, results[4].value());
+}
+
+TEST(Window, collectWindowedStopsOnException) {
+  std::vector<Promise<int>> ps(10);
+  std::vector<int> input;
+  for (size_t i = 0; i < ps.size(); i++) {
+    input.emplace_back(i);
+  }
+  size_t started = 0;
+  auto f = futures::collectWindowed(input, 2, [&](int i) {
+    started++;
+    return ps[i].getSemiFuture();
+  });
+  ps[0].setException(eggs);
+  EXPECT_THROW(std::move(f).get(), eggs_t);
+  ps[1].setValue(1);
+  EXPECT_EQ(2, started);
+}
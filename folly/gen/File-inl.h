@@ -18,9 +18,11 @@
 #error This file may only be included from folly/gen/File.h
 #endif
 
+#include <memory>
 #include <system_error>
 
 #include <folly/gen/String.h>
+#include <folly/system/MemoryMapping.h>
 
 namespace folly {
 namespace gen {
@@ -118,6 +120,87 @@ class FileWriter : public Operator<FileWriter> {
   std::unique_ptr<IOBuf> buffer_;
 };
 
+/**
+ * Lines of a range of a memory mapped file. The lines point directly into
+ * the mapping, which is kept alive by the generator.
+ */
+class MappedLines : public GenImpl<StringPiece, MappedLines> {
+ public:
+  MappedLines() = default;
+  MappedLines(
+      std::shared_ptr<const MemoryMapping> mapping,
+      StringPiece range,
+      char delim)
+      : mapping_(std::move(mapping)), range_(range), delim_(delim) {}
+
+  template <class Body>
+  bool apply(Body&& body) const {
+    auto rest = range_;
+    while (!rest.empty()) {
+      // find() is a memchr(), which is vectorized
+      auto pos = rest.find(delim_);
+      if (pos == StringPiece::npos) {
+        return body(rest);
+      }
+      if (!body(rest.subpiece(0, pos))) {
+        return false;
+      }
+      rest.advance(pos + 1);
+    }
+    return true;
+  }
+
+ private:
+  std::shared_ptr<const MemoryMapping> mapping_;
+  StringPiece range_;
+  char delim_ = '\n';
+};
+
+/**
+ * Splits a memory mapped file into ranges of about chunkSize bytes that end
+ * on a delimiter, producing the lines of each as a MappedLines.
+ */
+class MappedLineChunks : public GenImpl<MappedLines&&, MappedLineChunks> {
+ public:
+  MappedLineChunks(
+      std::shared_ptr<const MemoryMapping> mapping,
+      size_t chunkSize,
+      char delim)
+      : mapping_(std::move(mapping)),
+        chunkSize_(std::max<size_t>(1, chunkSize)),
+        delim_(delim) {}
+
+  template <class Body>
+  bool apply(Body&& body) const {
+    auto rest = mapping_->asRange<char>();
+    while (!rest.empty()) {
+      auto size = rest.size();
+      if (size > chunkSize_) {
+        auto pos = rest.find(delim_, chunkSize_ - 1);
+        if (pos != StringPiece::npos) {
+          size = pos + 1;
+        }
+      }
+      if (!body(MappedLines(mapping_, rest.subpiece(0, size), delim_))) {
+        return false;
+      }
+      rest.advance(size);
+    }
+    return true;
+  }
+
+ private:
+  std::shared_ptr<const MemoryMapping> mapping_;
+  size_t chunkSize_;
+  char delim_;
+};
+
+inline std::shared_ptr<const MemoryMapping> mapForLinearScan(File file) {
+  auto mapping = std::make_shared<MemoryMapping>(std::move(file));
+  mapping->hintLinearScan();
+  return mapping;
+}
+
 inline auto byLineImpl(File file, char delim, bool keepDelimiter) {
   // clang-format off
   return fromFile(std::move(file))
@@ -157,5 +240,43 @@ inline auto byLine(const char* f, char delim = '\n') {
   return byLine(File(f), delim);
 }
 
+/**
+ * Like byLine(), but maps the file into memory instead of reading it, and
+ * produces StringPieces pointing directly into the mapping, which stay valid
+ * for as long as the generator does. Only works on files that can be
+ * mapped, such as regular files.
+ */
+inline detail::MappedLines byLineMapped(File file, char delim = '\n') {
+  auto mapping = detail::mapForLinearScan(std::move(file));
+  auto range = mapping->asRange<char>();
+  return detail::MappedLines(std::move(mapping), range, delim);
+}
+
+inline detail::MappedLines byLineMapped(const char* f, char delim = '\n') {
+  return byLineMapped(File(f), delim);
+}
+
+/**
+ * Maps a file into memory and splits it into chunks of about chunkSize bytes,
+ * each ending at a line boundary. Each chunk is a generator of its lines, as
+ * produced by byLineMapped(). Meant for splitting large files across threads
+ * with 'parallel':
+ *
+ *   auto errors
+ *     = chunkedByLine("/var/log/messages")
+ *     | parallel(concat | filter(isError) | sub(count))
+ *     | sum;
+ */
+inline detail::MappedLineChunks
+chunkedByLine(File file, size_t chunkSize = 1 << 20, char delim = '\n') {
+  return detail::MappedLineChunks(
+      detail::mapForLinearScan(std::move(file)), chunkSize, delim);
+}
+
+inline detail::MappedLineChunks
+chunkedByLine(const char* f, size_t chunkSize = 1 << 20, char delim = '\n') {
+  return chunkedByLine(File(f), chunkSize, delim);
+}
+
 } // namespace gen
 } // namespace folly
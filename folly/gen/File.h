@@ -27,6 +27,8 @@ namespace gen {
 namespace detail {
 class FileReader;
 class FileWriter;
+class MappedLines;
+class MappedLineChunks;
 } // namespace detail
 
 /**
@@ -22,6 +22,10 @@
 #include <folly/ScopeGuard.h>
 #include <folly/experimental/EventCount.h>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
 #include <thread>
 #include <vector>
 
@@ -393,6 +397,277 @@ class Parallel : public Operator<Parallel<Ops>> {
   }
 };
 
+template <class Ops>
+class ExecutorParallel : public Operator<ExecutorParallel<Ops>> {
+  Ops ops_;
+  Executor::KeepAlive<> executor_;
+  ParallelOptions options_;
+
+ public:
+  ExecutorParallel(
+      Ops ops,
+      Executor::KeepAlive<> executor,
+      ParallelOptions options)
+      : ops_(std::move(ops)),
+        executor_(std::move(executor)),
+        options_(options) {}
+
+  template <
+      class Input,
+      class Source,
+      class InputDecayed = typename std::decay<Input>::type,
+      class Composed =
+          decltype(std::declval<Ops>().compose(Empty<InputDecayed&&>())),
+      class Output = typename Composed::ValueType,
+      class OutputDecayed = typename std::decay<Output>::type>
+  class Generator : public GenImpl<
+                        OutputDecayed&&,
+                        Generator<
+                            Input,
+                            Source,
+                            InputDecayed,
+                            Composed,
+                            Output,
+                            OutputDecayed>> {
+    Source source_;
+    Ops ops_;
+    Executor::KeepAlive<> executor_;
+    ParallelOptions options_;
+
+    struct Chunk {
+      size_t index;
+      std::vector<InputDecayed> inputs;
+      std::vector<OutputDecayed> outputs;
+      std::exception_ptr error;
+    };
+
+    class Puller : public GenImpl<InputDecayed&&, Puller> {
+      std::vector<InputDecayed>* inputs_;
+
+     public:
+      explicit Puller(std::vector<InputDecayed>* inputs) : inputs_(inputs) {}
+
+      template <class Handler>
+      bool apply(Handler&& handler) const {
+        for (auto& input : *inputs_) {
+          if (!handler(std::move(input))) {
+            return false;
+          }
+        }
+        return true;
+      }
+    };
+
+    class Pusher : public Operator<Pusher> {
+      std::vector<OutputDecayed>* outputs_;
+
+     public:
+      explicit Pusher(std::vector<OutputDecayed>* outputs)
+          : outputs_(outputs) {}
+
+      template <class Value, class InnerSource>
+      void compose(const GenImpl<Value, InnerSource>& source) const {
+        source.self().foreach([&](Value value) {
+          outputs_->push_back(std::forward<Value>(value));
+        });
+      }
+    };
+
+    /**
+     * Shared with the executor tasks, which may outlive the generator if
+     * they only start after it is done.
+     */
+    struct State {
+      explicit State(const Ops* o) : ops(o) {}
+
+      // Only dereferenced while !done
+      const Ops* ops;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::deque<Chunk> pending;
+      std::map<size_t, Chunk> completed;
+      // Tasks added to the executor that have not exited yet
+      size_t tasks = 0;
+      // Tasks currently running a chunk
+      size_t running = 0;
+      bool done = false;
+    };
+
+    static void process(const Ops& ops, Chunk& chunk) {
+      try {
+        Puller(&chunk.inputs) | ops | Pusher(&chunk.outputs);
+      } catch (...) {
+        chunk.error = std::current_exception();
+      }
+      chunk.inputs.clear();
+    }
+
+    static void work(const std::shared_ptr<State>& state) {
+      std::unique_lock<std::mutex> lock(state->mutex);
+      while (!state->done && !state->pending.empty()) {
+        auto chunk = std::move(state->pending.front());
+        state->pending.pop_front();
+        ++state->running;
+        lock.unlock();
+        process(*state->ops, chunk);
+        lock.lock();
+        --state->running;
+        auto index = chunk.index;
+        state->completed.emplace(index, std::move(chunk));
+        state->cv.notify_all();
+      }
+      --state->tasks;
+    }
+
+    class Runner {
+      const Generator& gen_;
+      std::shared_ptr<State> state_;
+      size_t maxTasks_;
+      // Chunks submitted and emitted so far
+      size_t submitted_ = 0;
+      size_t emitted_ = 0;
+
+      /**
+       * Makes progress: emits the next completed chunk, or runs a pending
+       * chunk on this thread, or waits for a task to complete one. Returns
+       * false if the handler asked to stop.
+       */
+      template <class Handler>
+      bool step(std::unique_lock<std::mutex>& lock, Handler& handler) {
+        auto& completed = state_->completed;
+        auto it = completed.begin();
+        if (it != completed.end() &&
+            (!gen_.options_.ordered || it->first == emitted_)) {
+          auto chunk = std::move(it->second);
+          completed.erase(it);
+          ++emitted_;
+          lock.unlock();
+          SCOPE_EXIT {
+            lock.lock();
+          };
+          if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+          }
+          for (auto& output : chunk.outputs) {
+            if (!handler(std::move(output))) {
+              return false;
+            }
+          }
+          return true;
+        }
+        if (!state_->pending.empty()) {
+          auto chunk = std::move(state_->pending.front());
+          state_->pending.pop_front();
+          lock.unlock();
+          process(gen_.ops_, chunk);
+          lock.lock();
+          auto index = chunk.index;
+          completed.emplace(index, std::move(chunk));
+          return true;
+        }
+        state_->cv.wait(lock);
+        return true;
+      }
+
+     public:
+      explicit Runner(const Generator& gen)
+          : gen_(gen),
+            state_(std::make_shared<State>(&gen.ops_)),
+            maxTasks_(
+                gen.options_.maxTasks
+                    ? gen.options_.maxTasks
+                    : size_t(
+                          std::max<long>(1, sysconf(_SC_NPROCESSORS_CONF)))) {}
+
+      ~Runner() {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->done = true;
+        state_->cv.wait(lock, [&] { return state_->running == 0; });
+      }
+
+      /**
+       * Hands a chunk to the tasks, first emitting results while too many
+       * chunks are in flight.
+       */
+      template <class Handler>
+      bool submit(std::vector<InputDecayed>&& inputs, Handler& handler) {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        while (submitted_ - emitted_ >= 4 * maxTasks_) {
+          if (!step(lock, handler)) {
+            return false;
+          }
+        }
+        state_->pending.push_back(
+            Chunk{submitted_++, std::move(inputs), {}, nullptr});
+        if (state_->tasks >= maxTasks_) {
+          return true;
+        }
+        ++state_->tasks;
+        lock.unlock();
+        gen_.executor_->add([state = state_] { work(state); });
+        return true;
+      }
+
+      template <class Handler>
+      bool finish(Handler& handler) {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        while (emitted_ < submitted_) {
+          if (!step(lock, handler)) {
+            return false;
+          }
+        }
+        return true;
+      }
+    };
+
+   public:
+    Generator(
+        Source source,
+        Ops ops,
+        Executor::KeepAlive<> executor,
+        ParallelOptions options)
+        : source_(std::move(source)),
+          ops_(std::move(ops)),
+          executor_(std::move(executor)),
+          options_(options) {
+      options_.chunkSize = std::max<size_t>(1, options_.chunkSize);
+    }
+
+    template <class Handler>
+    bool apply(Handler&& handler) const {
+      Runner runner(*this);
+      std::vector<InputDecayed> inputs;
+      bool more = source_.apply([&](Input input) {
+        inputs.push_back(std::forward<Input>(input));
+        if (inputs.size() < options_.chunkSize) {
+          return true;
+        }
+        auto chunk = std::move(inputs);
+        inputs.clear();
+        return runner.submit(std::move(chunk), handler);
+      });
+      if (!more) {
+        return false;
+      }
+      if (!inputs.empty() && !runner.submit(std::move(inputs), handler)) {
+        return false;
+      }
+      return runner.finish(handler);
+    }
+  };
+
+  template <class Value, class Source>
+  Generator<Value, Source> compose(const GenImpl<Value, Source>& source) const {
+    return Generator<Value, Source>(source.self(), ops_, executor_, options_);
+  }
+
+  template <class Value, class Source>
+  Generator<Value, Source> compose(GenImpl<Value, Source>&& source) const {
+    return Generator<Value, Source>(
+        std::move(source.self()), ops_, executor_, options_);
+  }
+};
+
 /**
  * ChunkedRangeSource - For slicing up ranges into a sequence of chunks given a
  * maximum chunk size.
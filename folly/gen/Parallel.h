@@ -19,6 +19,7 @@
 
 #include <mutex>
 
+#include <folly/Executor.h>
 #include <folly/gen/Base.h>
 
 namespace folly {
@@ -28,6 +29,9 @@ namespace detail {
 template <class Ops>
 class Parallel;
 
+template <class Ops>
+class ExecutorParallel;
+
 template <class Sink>
 class Sub;
 
@@ -89,6 +93,53 @@ Parallel parallel(Ops ops, size_t threads = 0) {
   return Parallel(std::move(ops), threads);
 }
 
+struct ParallelOptions {
+  /**
+   * Number of input values handed to a task at a time.
+   */
+  size_t chunkSize = 64;
+  /**
+   * Maximum number of tasks running on the executor at once, 0 for the
+   * number of CPUs.
+   */
+  size_t maxTasks = 0;
+  /**
+   * Yield results in input order rather than as soon as they are ready.
+   */
+  bool ordered = false;
+};
+
+/**
+ * parallel(ops, executor) - Like 'parallel(ops)', but runs 'ops' as tasks
+ * on an existing executor, typically the process's CPUThreadPoolExecutor,
+ * instead of on threads of its own.
+ *
+ *   ParallelOptions options;
+ *   options.ordered = true;
+ *   auto scoredResults
+ *     = from(ids)
+ *     | parallel(map(fetchObj) | map(scoreObj), &cpuExecutor, options)
+ *     | as<vector>();
+ *
+ * The input is read on the client thread and split into chunks of
+ * 'chunkSize' values. Up to 'maxTasks' tasks steal chunks as they become
+ * available and exit once there are none left, so they never block the
+ * executor's threads. The client thread also runs chunks itself rather than
+ * wait, so this makes progress even if the executor is saturated or the
+ * client is one of its threads.
+ *
+ * With 'ordered' set, completed chunks are merged back in input order. Sinks
+ * wrapped in 'sub' are applied per chunk. Exceptions thrown by 'ops' are
+ * rethrown on the client thread.
+ */
+template <class Ops, class ExecutorParallel = detail::ExecutorParallel<Ops>>
+ExecutorParallel parallel(
+    Ops ops,
+    Executor::KeepAlive<> executor,
+    ParallelOptions options = {}) {
+  return ExecutorParallel(std::move(ops), std::move(executor), options);
+}
+
 /**
  * sub - For sub-summarization of a sequence.
  *
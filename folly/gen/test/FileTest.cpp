@@ -85,6 +85,39 @@ TEST(FileGen, ByLineFull) {
   }
 }
 
+TEST(FileGen, ByLineMapped) {
+  auto collect = eachTo<std::string>() | as<vector>();
+  const std::string cases[] = {
+      "Hello world\n"
+      "This is the second line\n"
+      "\n"
+      "\n"
+      "a few empty lines above\n"
+      "incomplete last line",
+
+      "complete last line\n",
+
+      "\n",
+
+      "",
+  };
+
+  for (auto& lines : cases) {
+    test::TemporaryFile file("ByLineMapped");
+    EXPECT_EQ(lines.size(), write(file.fd(), lines.data(), lines.size()));
+
+    auto expected = from({lines}) | resplit('\n') | collect;
+    auto found = byLineMapped(file.path().string().c_str()) | collect;
+    EXPECT_EQ(expected, found) << "For Input: '" << lines << "'";
+
+    for (size_t chunkSize : {1, 2, 5, 64}) {
+      auto chunks = chunkedByLine(file.path().string().c_str(), chunkSize);
+      EXPECT_EQ(expected, chunks | concat | collect)
+          << "For Input: '" << lines << "', chunk size " << chunkSize;
+    }
+  }
+}
+
 class FileGenBufferedTest : public ::testing::TestWithParam<int> {};
 
 TEST_P(FileGenBufferedTest, FileWriter) {
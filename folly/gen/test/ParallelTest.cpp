@@ -21,6 +21,8 @@
 
 #include <glog/logging.h>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/futures/Future.h>
 #include <folly/gen/Base.h>
 #include <folly/gen/Parallel.h>
 #include <folly/portability/GFlags.h>
@@ -105,6 +107,68 @@ TEST(ParallelTest, PSum) {
       from(primes) | parallel(map(sleepyWork) | sub(sum)) | sum);
 }
 
+TEST(ParallelTest, Executor) {
+  folly::CPUThreadPoolExecutor executor(4);
+  EXPECT_EQ(
+      seq(1, 10) | map(square) | filter(even) | sum,
+      seq(1, 10) | parallel(map(square) | filter(even), &executor) | sum);
+  int length = 1 << 10;
+  EXPECT_EQ(
+      seq<size_t>(1, length) | heavyWork | sum,
+      seq<size_t>(1, length) | parallel(heavyWork, &executor) | sum);
+  EXPECT_EQ(
+      from(primes) | map(sleepyWork) | sum,
+      from(primes) | parallel(map(sleepyWork) | sub(sum), &executor) | sum);
+}
+
+TEST(ParallelTest, ExecutorOrdered) {
+  folly::CPUThreadPoolExecutor executor(4);
+  ParallelOptions options;
+  options.chunkSize = 7;
+  options.ordered = true;
+  EXPECT_EQ(
+      from(primes) | map(sleepyWork) | as<vector>(),
+      from(primes) | parallel(map(sleepyWork), &executor, options) |
+          as<vector>());
+  EXPECT_EQ(
+      primes.size(),
+      from(primes) | parallel(map(makeUnique), &executor, options) |
+          dereference | count);
+}
+
+TEST(ParallelTest, ExecutorTake) {
+  folly::CPUThreadPoolExecutor executor(4);
+  int length = 1 << 18;
+  int limit = 1 << 14;
+  EXPECT_EQ(
+      seq(1, length) | take(limit) | count,
+      seq(1, length) | parallel(heavyWork, &executor) | take(limit) | count);
+}
+
+TEST(ParallelTest, ExecutorException) {
+  folly::CPUThreadPoolExecutor executor(4);
+  auto thrower = map([](int i) {
+    if (i == 1000) {
+      throw std::runtime_error("1000");
+    }
+    return i;
+  });
+  EXPECT_THROW(
+      seq(1, 1 << 14) | parallel(thrower, &executor) | sum,
+      std::runtime_error);
+}
+
+TEST(ParallelTest, ExecutorSaturated) {
+  // The only thread of the executor runs the pipeline, so the client thread
+  // has to do all the work itself.
+  folly::CPUThreadPoolExecutor executor(1);
+  auto pipeline = [&] {
+    return seq(1, 1 << 12) | parallel(heavyWork, &executor) | sum;
+  };
+  EXPECT_EQ(
+      seq(1, 1 << 12) | heavyWork | sum, folly::via(&executor, pipeline).get());
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
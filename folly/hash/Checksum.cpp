@@ -19,6 +19,7 @@
 #include <folly/CpuId.h>
 #include <folly/hash/detail/ChecksumDetail.h>
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 #if FOLLY_SSE_PREREQ(4, 2)
@@ -133,6 +134,24 @@ uint32_t crc32c(const uint8_t* data, size_t nbytes, uint32_t startingChecksum) {
   }
 }
 
+uint32_t memcpy_crc32c(
+    void* dst,
+    const void* src,
+    size_t nbytes,
+    uint32_t startingChecksum) {
+  if (detail::crc32c_hw_supported()) {
+    return detail::memcpy_crc32c_hw(
+        static_cast<uint8_t*>(dst),
+        static_cast<const uint8_t*>(src),
+        nbytes,
+        startingChecksum);
+  } else {
+    std::memcpy(dst, src, nbytes);
+    return detail::crc32c_sw(
+        static_cast<const uint8_t*>(dst), nbytes, startingChecksum);
+  }
+}
+
 uint32_t crc32(const uint8_t* data, size_t nbytes, uint32_t startingChecksum) {
   if (detail::crc32_hw_supported()) {
     return detail::crc32_hw(data, nbytes, startingChecksum);
@@ -37,6 +37,18 @@ namespace folly {
 uint32_t
 crc32c(const uint8_t* data, size_t nbytes, uint32_t startingChecksum = ~0U);
 
+/**
+ * Copy nbytes from src to dst, which must not overlap, and compute the
+ * CRC-32C checksum of the data in the same pass. The result is the same as
+ * memcpy() followed by crc32c(), but the data is only read once, which
+ * matters when it isn't in cache.
+ */
+uint32_t memcpy_crc32c(
+    void* dst,
+    const void* src,
+    size_t nbytes,
+    uint32_t startingChecksum = ~0U);
+
 /**
  * Compute the CRC-32 checksum of a buffer, using a hardware-accelerated
  * implementation if available or a portable software implementation as
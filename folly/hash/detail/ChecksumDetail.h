@@ -61,6 +61,22 @@ bool crc32c_hw_supported();
 uint32_t
 crc32c_sw(const uint8_t* data, size_t nbytes, uint32_t startingChecksum = ~0U);
 
+/**
+ * Copy a buffer and compute its CRC-32C checksum in the same pass, using a
+ * hardware-accelerated implementation. The buffers must not overlap.
+ *
+ * @note This function is exposed to support special cases where the
+ *       calling code is absolutely certain it ought to invoke a hardware-
+ *       accelerated CRC-32C implementation - unit tests, for example.  For
+ *       all other scenarios, please call memcpy_crc32c() and let it pick an
+ *       implementation based on the capabilities of the underlying CPU.
+ */
+uint32_t memcpy_crc32c_hw(
+    uint8_t* dst,
+    const uint8_t* src,
+    size_t nbytes,
+    uint32_t startingChecksum = ~0U);
+
 /**
  * Compute a CRC-32 checksum of a buffer using a hardware-accelerated
  * implementation.
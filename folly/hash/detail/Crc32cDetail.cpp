@@ -29,8 +29,10 @@
  * other code cleanup
  */
 
+#include <cstring>
 #include <stdexcept>
 
+#include <folly/hash/Checksum.h>
 #include <folly/hash/detail/ChecksumDetail.h>
 
 #include <folly/CppAttributes.h>
@@ -286,6 +288,67 @@ uint32_t crc32c_hw(const uint8_t* buf, size_t len, uint32_t crc) {
   return (uint32_t)crc0;
 }
 
+namespace crc32_detail {
+
+FOLLY_TARGET_ATTRIBUTE("sse4.2")
+uint64_t
+memcpy_crc32c_words(uint8_t* dst, const uint8_t* src, size_t n, uint64_t crc) {
+  for (size_t i = 0; i < n; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, src + i, 8);
+    std::memcpy(dst + i, &word, 8);
+    crc = _mm_crc32_u64(crc, word);
+  }
+  return crc;
+}
+
+} // namespace crc32_detail
+
+/* Copy and compute CRC-32C in one pass, using three interleaved streams. */
+FOLLY_TARGET_ATTRIBUTE("sse4.2")
+uint32_t
+memcpy_crc32c_hw(uint8_t* dst, const uint8_t* src, size_t len, uint32_t crc) {
+  // Like the triplets of crc32c_hw(), the streams hide the latency of the
+  // crc32 instruction. Each one covers a third of the data, and they are
+  // merged with crc32c_combine(), which only pays off for long streams.
+  constexpr size_t kMinStreamLength = 512;
+  size_t const streamLength = (len / 24) * 8;
+  if (streamLength >= kMinStreamLength) {
+    uint64_t crc0 = crc;
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    for (size_t i = 0; i < streamLength; i += 8) {
+      uint64_t word0;
+      uint64_t word1;
+      uint64_t word2;
+      std::memcpy(&word0, src + i, 8);
+      std::memcpy(&word1, src + streamLength + i, 8);
+      std::memcpy(&word2, src + 2 * streamLength + i, 8);
+      std::memcpy(dst + i, &word0, 8);
+      std::memcpy(dst + streamLength + i, &word1, 8);
+      std::memcpy(dst + 2 * streamLength + i, &word2, 8);
+      crc0 = _mm_crc32_u64(crc0, word0);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+    }
+    crc = crc32c_combine(
+        crc32c_combine(uint32_t(crc0), uint32_t(crc1), streamLength),
+        uint32_t(crc2),
+        streamLength);
+    dst += 3 * streamLength;
+    src += 3 * streamLength;
+    len -= 3 * streamLength;
+  }
+
+  size_t const wordsLength = len & ~size_t(7);
+  crc = uint32_t(crc32_detail::memcpy_crc32c_words(dst, src, wordsLength, crc));
+  for (size_t i = wordsLength; i < len; ++i) {
+    dst[i] = src[i];
+    crc = _mm_crc32_u8(crc, src[i]);
+  }
+  return crc;
+}
+
 #else
 
 uint32_t
@@ -293,6 +356,15 @@ crc32c_hw(const uint8_t* /* buf */, size_t /* len */, uint32_t /* crc */) {
   throw std::runtime_error("crc32_hw is not implemented on this platform");
 }
 
+uint32_t memcpy_crc32c_hw(
+    uint8_t* /* dst */,
+    const uint8_t* /* src */,
+    size_t /* len */,
+    uint32_t /* crc */) {
+  throw std::runtime_error(
+      "memcpy_crc32c_hw is not implemented on this platform");
+}
+
 #endif
 
 } // namespace detail
@@ -16,6 +16,9 @@
 
 #include <folly/hash/Checksum.h>
 
+#include <cstring>
+#include <vector>
+
 #include <boost/crc.hpp>
 
 #include <folly/Benchmark.h>
@@ -152,6 +155,23 @@ TEST(Checksum, crc32c_continuation_autodetect) {
   testCRC32CContinuation(folly::crc32c);
 }
 
+TEST(Checksum, memcpy_crc32c) {
+  std::vector<uint8_t> copy(BUFFER_SIZE);
+  auto memcpyCrc32c = [&](const uint8_t* data, size_t nbytes, uint32_t crc) {
+    std::fill(copy.begin(), copy.begin() + nbytes, 0);
+    auto result = folly::memcpy_crc32c(copy.data(), data, nbytes, crc);
+    EXPECT_EQ(0, memcmp(copy.data(), data, nbytes));
+    return result;
+  };
+  testCRC32C(memcpyCrc32c);
+  testCRC32CContinuation(memcpyCrc32c);
+  for (size_t i = 0; i < 4000; i += 7) {
+    EXPECT_EQ(
+        folly::detail::crc32c_sw(buffer + 1, i, 0),
+        memcpyCrc32c(buffer + 1, i, 0));
+  }
+}
+
 TEST(Checksum, crc32) {
   if (folly::detail::crc32c_hw_supported()) {
     // Just check that sw and hw match
@@ -359,6 +379,26 @@ BENCHMARK(crc32_software_512KB_block, iters) {
 
 BENCHMARK_DRAW_LINE();
 
+// Copying and checksumming in two passes reads the data twice.
+BENCHMARK(memcpy_then_crc32c_4MB_block, iters) {
+  std::vector<uint8_t> copy(BUFFER_SIZE);
+  for (unsigned long i = 0; i < iters; i++) {
+    memcpy(copy.data(), buffer, BUFFER_SIZE);
+    auto checksum = folly::crc32c(copy.data(), BUFFER_SIZE);
+    folly::doNotOptimizeAway(checksum);
+  }
+}
+
+BENCHMARK_RELATIVE(memcpy_crc32c_4MB_block, iters) {
+  std::vector<uint8_t> copy(BUFFER_SIZE);
+  for (unsigned long i = 0; i < iters; i++) {
+    auto checksum = folly::memcpy_crc32c(copy.data(), buffer, BUFFER_SIZE);
+    folly::doNotOptimizeAway(checksum);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK(crc32_combine_linear_512KB_block, iters) {
   benchmarkCombineSoftwareLinear(iters, 512 * 1024);
 }
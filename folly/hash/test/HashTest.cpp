@@ -22,6 +22,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/MapUtil.h>
@@ -153,6 +154,43 @@ TEST(Hash, TWang_32From64) {
   EXPECT_EQ(twang_32from64(i2), i2_res);
 }
 
+TEST(Hash, TWang_Mix64Batch) {
+  // not a multiple of the vector width, so the scalar tail runs too
+  std::vector<uint64_t> keys(23);
+  std::vector<uint64_t> lower(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = folly::Random::rand64();
+    lower[i] = folly::Random::rand64();
+  }
+  std::vector<uint64_t> out(keys.size());
+  twang_mix64_batch(keys.data(), out.data(), keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(twang_mix64(keys[i]), out[i]);
+  }
+  hash_128_to_64_batch(keys.data(), lower.data(), out.data(), keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(hash_128_to_64(keys[i], lower[i]), out[i]);
+  }
+}
+
+TEST(Hash, bulkHash) {
+  std::vector<uint64_t> keys64;
+  std::vector<int32_t> keys32;
+  for (int i = 0; i < 19; ++i) {
+    keys64.push_back(folly::Random::rand64());
+    keys32.push_back(int32_t(folly::Random::rand32()));
+  }
+  std::vector<size_t> out(keys64.size());
+  folly::Hash{}.bulk_hash(keys64.data(), keys64.size(), out.data());
+  for (size_t i = 0; i < keys64.size(); ++i) {
+    EXPECT_EQ(folly::Hash{}(keys64[i]), out[i]);
+  }
+  folly::hasher<int32_t>{}.bulk_hash(keys32.data(), keys32.size(), out.data());
+  for (size_t i = 0; i < keys32.size(); ++i) {
+    EXPECT_EQ(folly::hasher<int32_t>{}(keys32[i]), out[i]);
+  }
+}
+
 TEST(Hash, Jenkins_Rev_Mix32) {
   uint32_t i1 = 3805486511ul;
   uint32_t i1_res = 381808021ul;
@@ -19,6 +19,7 @@
 #include <glog/logging.h>
 
 #include <folly/Singleton.h>
+#include <folly/experimental/io/HugePageText.h>
 #include <folly/logging/Init.h>
 #include <folly/portability/Config.h>
 
@@ -28,6 +29,10 @@
 #include <folly/portability/GFlags.h>
 
 DEFINE_string(logging, "", "Logging configuration");
+DEFINE_bool(
+    folly_hugepage_text,
+    false,
+    "Move the code of the executable onto transparent huge pages at startup");
 
 namespace folly {
 
@@ -50,6 +55,12 @@ void init(int* argc, char*** argv, bool removeFlags) {
   auto programName = argc && argv && *argc > 0 ? (*argv)[0] : "unknown";
   google::InitGoogleLogging(programName);
 
+  if (FLAGS_folly_hugepage_text) {
+    auto remap = folly::remapTextOnHugePages();
+    LOG(INFO) << "Remapped " << (remap.size() >> 20) << "MB of text, "
+              << (remap.hugePageBytes >> 20) << "MB of it on huge pages";
+  }
+
 #if FOLLY_USE_SYMBOLIZER
   // Don't use glog's DumpStackTraceAndExit; rely on our signal handler.
   google::InstallFailureFunction(abort);
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/Chunker.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <folly/io/Cursor.h>
+
+namespace folly {
+
+namespace {
+
+const ContentDefinedChunker::Options& validate(
+    const ContentDefinedChunker::Options& options) {
+  if (options.windowSize == 0) {
+    throw std::invalid_argument("ContentDefinedChunker: windowSize is 0");
+  }
+  if (options.minChunkSize < options.windowSize) {
+    throw std::invalid_argument(
+        "ContentDefinedChunker: minChunkSize is smaller than windowSize");
+  }
+  if (options.avgChunkSize == 0 ||
+      (options.avgChunkSize & (options.avgChunkSize - 1)) != 0) {
+    throw std::invalid_argument(
+        "ContentDefinedChunker: avgChunkSize is not a power of two");
+  }
+  if (options.maxChunkSize < options.minChunkSize) {
+    throw std::invalid_argument(
+        "ContentDefinedChunker: maxChunkSize is smaller than minChunkSize");
+  }
+  return options;
+}
+
+} // namespace
+
+ContentDefinedChunker::ContentDefinedChunker()
+    : ContentDefinedChunker(Options()) {}
+
+ContentDefinedChunker::ContentDefinedChunker(const Options& options)
+    : options_(validate(options)),
+      mask_(options.avgChunkSize - 1),
+      rolling_(options.windowSize) {}
+
+void ContentDefinedChunker::update(
+    ByteRange data,
+    std::vector<uint64_t>& boundaries) {
+  // Only the last windowSize bytes before a candidate boundary affect it, and
+  // no boundary comes before minChunkSize, so the start of each chunk need
+  // not be hashed.
+  auto const hashFrom = options_.minChunkSize - options_.windowSize;
+  size_t i = 0;
+  while (i < data.size()) {
+    if (chunkSize_ < hashFrom) {
+      auto const skip = std::min(hashFrom - chunkSize_, data.size() - i);
+      chunkSize_ += skip;
+      i += skip;
+      continue;
+    }
+    rolling_.roll(data[i++]);
+    ++chunkSize_;
+    if (chunkSize_ >= options_.minChunkSize &&
+        ((rolling_.high64() & mask_) == mask_ ||
+         chunkSize_ >= options_.maxChunkSize)) {
+      boundaries.push_back(offset_ + i);
+      chunkSize_ = 0;
+      rolling_.reset();
+    }
+  }
+  offset_ += data.size();
+}
+
+void ContentDefinedChunker::update(
+    const IOBuf& buf,
+    std::vector<uint64_t>& boundaries) {
+  for (auto range : buf) {
+    update(range, boundaries);
+  }
+}
+
+void ContentDefinedChunker::finish(std::vector<uint64_t>& boundaries) {
+  if (chunkSize_ > 0) {
+    boundaries.push_back(offset_);
+  }
+  reset();
+}
+
+void ContentDefinedChunker::reset() {
+  rolling_.reset();
+  offset_ = 0;
+  chunkSize_ = 0;
+}
+
+std::vector<std::unique_ptr<IOBuf>> ContentDefinedChunker::split(
+    const IOBuf& buf,
+    const Options& options) {
+  std::vector<uint64_t> boundaries;
+  ContentDefinedChunker chunker(options);
+  chunker.update(buf, boundaries);
+  chunker.finish(boundaries);
+
+  std::vector<std::unique_ptr<IOBuf>> chunks;
+  chunks.reserve(boundaries.size());
+  io::Cursor cursor(&buf);
+  uint64_t begin = 0;
+  for (auto end : boundaries) {
+    std::unique_ptr<IOBuf> chunk;
+    cursor.clone(chunk, size_t(end - begin));
+    chunks.push_back(std::move(chunk));
+    begin = end;
+  }
+  return chunks;
+}
+
+std::vector<std::unique_ptr<IOBuf>> ContentDefinedChunker::split(
+    const IOBuf& buf) {
+  return split(buf, Options());
+}
+
+} // namespace folly
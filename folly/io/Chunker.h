@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Content-defined chunking: split a byte stream into variable size chunks
+ * whose boundaries depend only on nearby content, so that inserting or
+ * deleting bytes only changes the chunks around the edit. This is the usual
+ * front end of deduplicating storage.
+ *
+ * A boundary is placed after a byte when the rolling Rabin fingerprint of the
+ * preceding windowSize bytes matches a mask, subject to minimum and maximum
+ * chunk sizes. Bytes that cannot influence a boundary (those more than
+ * windowSize before minChunkSize) are skipped without being hashed.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <folly/Fingerprint.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+namespace folly {
+
+class ContentDefinedChunker {
+ public:
+  struct Options {
+    // bytes hashed to decide each boundary
+    size_t windowSize{48};
+    // no chunk other than the last is shorter than this; >= windowSize
+    size_t minChunkSize{2 * 1024};
+    // power of two; chunks average about minChunkSize + avgChunkSize bytes
+    size_t avgChunkSize{8 * 1024};
+    // chunks are cut here if no boundary was found; >= minChunkSize
+    size_t maxChunkSize{64 * 1024};
+  };
+
+  ContentDefinedChunker();
+
+  /**
+   * Throws std::invalid_argument if the options are inconsistent.
+   */
+  explicit ContentDefinedChunker(const Options& options);
+
+  /**
+   * Scan the next part of the stream. For each chunk completed within data,
+   * append the stream offset just past its end to boundaries.
+   */
+  void update(ByteRange data, std::vector<uint64_t>& boundaries);
+
+  /**
+   * Same, for every buffer of an IOBuf chain in order.
+   */
+  void update(const IOBuf& buf, std::vector<uint64_t>& boundaries);
+
+  /**
+   * End of stream: append the end of the final chunk, if it is not empty,
+   * and reset() for a new stream.
+   */
+  void finish(std::vector<uint64_t>& boundaries);
+
+  /**
+   * Start a new stream at offset 0.
+   */
+  void reset();
+
+  /**
+   * Number of bytes scanned since the last reset().
+   */
+  uint64_t offset() const {
+    return offset_;
+  }
+
+  const Options& options() const {
+    return options_;
+  }
+
+  /**
+   * Split an IOBuf chain into chunks. The chunks share the chain's buffers
+   * rather than copying them.
+   */
+  static std::vector<std::unique_ptr<IOBuf>> split(
+      const IOBuf& buf,
+      const Options& options);
+  static std::vector<std::unique_ptr<IOBuf>> split(const IOBuf& buf);
+
+ private:
+  Options options_;
+  uint64_t mask_;
+  RollingFingerprint<64> rolling_;
+  uint64_t offset_{0};
+  size_t chunkSize_{0};
+};
+
+} // namespace folly
@@ -45,23 +45,15 @@ template <class Derived, class BufType>
 std::string CursorBase<Derived, BufType>::readTerminatedString(
     char termChar,
     size_t maxLength) {
-  size_t bytesRead{0};
-  auto keepReading = [&bytesRead, termChar, maxLength](uint8_t byte) {
-    if (byte == termChar) {
-      return false;
+  auto len = findByte(uint8_t(termChar), maxLength);
+  if (len == std::string::npos) {
+    if (canAdvance(maxLength)) {
+      throw_exception<std::length_error>("string overflow");
     }
-    ++bytesRead;
-    if (bytesRead >= maxLength) {
-      throw std::length_error("string overflow");
-    }
-    return true;
-  };
-
-  auto result = readWhile(keepReading);
-  // skip over the terminator character
-  if (isAtEnd()) {
     throw_exception<std::out_of_range>("terminator not found");
   }
+  auto result = readFixedString(len);
+  // skip over the terminator character
   skip(1);
 
   return result;
@@ -105,6 +97,54 @@ void CursorBase<Derived, BufType>::skipWhile(const Predicate& predicate) {
   CursorNoopAppender appender;
   readWhile(predicate, appender);
 }
+
+template <class Derived, class BufType>
+template <typename Find>
+size_t CursorBase<Derived, BufType>::findInChain(
+    const Find& find,
+    size_t maxLength) const {
+  dcheckIntegrity();
+  const BufType* buf = crtBuf_;
+  ByteRange range(crtPos_, crtEnd_);
+  size_t remaining = remainingLen_;
+  size_t offset = 0;
+  while (true) {
+    if (range.size() > maxLength - offset) {
+      range.reset(range.data(), maxLength - offset);
+    }
+    auto pos = find(range);
+    if (pos != std::string::npos) {
+      return offset + pos;
+    }
+    offset += range.size();
+    buf = buf->next();
+    if (offset == maxLength || buf == buffer_ || remaining == 0) {
+      return std::string::npos;
+    }
+    range.reset(buf->data(), std::min(buf->length(), remaining));
+    if (isBounded()) {
+      remaining -= range.size();
+    }
+  }
+}
+
+template <class Derived, class BufType>
+template <typename Output>
+bool CursorBase<Derived, BufType>::readFound(size_t len, Output& out) {
+  if (len == std::string::npos) {
+    return false;
+  }
+  while (len > 0) {
+    auto peeked = peekBytes();
+    if (peeked.size() > len) {
+      peeked.reset(peeked.data(), len);
+    }
+    out.append(peeked);
+    skip(peeked.size());
+    len -= peeked.size();
+  }
+  return true;
+}
 } // namespace detail
 } // namespace io
 } // namespace folly
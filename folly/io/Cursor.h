@@ -409,6 +409,62 @@ class CursorBase {
   template <typename Predicate>
   void skipWhile(const Predicate& predicate);
 
+  /**
+   * Return the distance from the current position to the first occurrence of
+   * the byte, searching across buffer boundaries until the end of the chain
+   * (or the boundary of a bounded Cursor), or std::string::npos if it is not
+   * within the next maxLength bytes. The cursor does not move.
+   *
+   * Each buffer is searched with memchr(), which is vectorized, rather than
+   * one byte at a time as readWhile() does.
+   */
+  size_t findByte(
+      uint8_t byte,
+      size_t maxLength = std::numeric_limits<size_t>::max()) const {
+    return findInChain(
+        [byte](ByteRange range) { return qfind(range, byte); }, maxLength);
+  }
+
+  /**
+   * Like findByte(), for the first byte that is any of the needles. Buffers
+   * are searched with qfind_first_of(), which uses SSE4.2 when available.
+   */
+  size_t findAnyOf(
+      ByteRange needles,
+      size_t maxLength = std::numeric_limits<size_t>::max()) const {
+    return findInChain(
+        [needles](ByteRange range) { return qfind_first_of(range, needles); },
+        maxLength);
+  }
+
+  /**
+   * Read all bytes before the first occurrence of the delimiter, calling
+   * Output::append() with each contiguous chunk, and leave the cursor on the
+   * delimiter.
+   *
+   * Returns false without reading anything if the delimiter is not within
+   * the next maxLength bytes, so that a parser may retry once more data has
+   * been received.
+   */
+  template <typename Output>
+  bool readUntil(
+      uint8_t delimiter,
+      Output& out,
+      size_t maxLength = std::numeric_limits<size_t>::max()) {
+    return readFound(findByte(delimiter, maxLength), out);
+  }
+
+  /**
+   * Like readUntil(), stopping at the first byte that is any of the needles.
+   */
+  template <typename Output>
+  bool readUntilAnyOf(
+      ByteRange needles,
+      Output& out,
+      size_t maxLength = std::numeric_limits<size_t>::max()) {
+    return readFound(findAnyOf(needles, maxLength), out);
+  }
+
   size_t skipAtMost(size_t len) {
     dcheckIntegrity();
     if (LIKELY(crtPos_ + len < crtEnd_)) {
@@ -703,6 +759,12 @@ class CursorBase {
     return static_cast<const Derived&>(*this);
   }
 
+  template <typename Find>
+  size_t findInChain(const Find& find, size_t maxLength) const;
+
+  template <typename Output>
+  bool readFound(size_t len, Output& out);
+
   template <class T>
   FOLLY_NOINLINE T readSlow() {
     T val;
@@ -727,7 +727,9 @@ void IOBuf::coalesceSlow() {
   DCHECK(!isChained());
 }
 
-void IOBuf::coalesceSlow(size_t maxLength) {
+void IOBuf::coalesceSlow(
+    size_t maxLength,
+    const CoalesceAllocator* allocator) {
   // coalesceSlow() should only be called if we are part of a chain of multiple
   // IOBufs.  The caller should have already verified this.
   DCHECK(isChained());
@@ -749,16 +751,40 @@ void IOBuf::coalesceSlow(size_t maxLength) {
     }
   }
 
-  coalesceAndReallocate(newLength, end);
+  coalesceAndReallocate(
+      headroom(), newLength, end, end->prev_->tailroom(), allocator);
   // We should have the requested length now
   DCHECK_GE(length_, maxLength);
 }
 
+void IOBuf::coalescePrefixSlow(
+    size_t length,
+    const CoalesceAllocator* allocator) {
+  DCHECK_LT(length_, length);
+
+  // Find the buffer the prefix ends in
+  std::size_t wholeLength = 0;
+  IOBuf* end = this;
+  do {
+    wholeLength += end->length_;
+    end = end->next_;
+  } while (end != this && wholeLength + end->length_ <= length);
+
+  if (wholeLength < length && end == this) {
+    throw_exception<std::overflow_error>(
+        "attempted to coalesce more data than "
+        "available");
+  }
+  coalesceAndReallocate(headroom(), length, end, 0, allocator);
+  DCHECK_EQ(length_, length);
+}
+
 void IOBuf::coalesceAndReallocate(
     size_t newHeadroom,
     size_t newLength,
     IOBuf* end,
-    size_t newTailroom) {
+    size_t newTailroom,
+    const CoalesceAllocator* allocator) {
   std::size_t newCapacity = newLength + newHeadroom + newTailroom;
 
   // Allocate space for the coalesced buffer.
@@ -767,7 +793,21 @@ void IOBuf::coalesceAndReallocate(
   uint8_t* newBuf;
   SharedInfo* newInfo;
   std::size_t actualCapacity;
-  allocExtBuffer(newCapacity, &newBuf, &newInfo, &actualCapacity);
+  if (allocator) {
+    // The SharedInfo goes at the end of the buffer, as with malloc(), and is
+    // released along with it by the allocator's free function.
+    size_t allocSize = ((newCapacity + 7) & ~size_t(7)) + sizeof(SharedInfo);
+    newBuf = static_cast<uint8_t*>(
+        allocator->allocate(allocSize, allocator->userData));
+    if (!newBuf) {
+      throw_exception<std::bad_alloc>();
+    }
+    initExtBuffer(newBuf, allocSize, &newInfo, &actualCapacity);
+    newInfo->freeFn = allocator->freeFn;
+    newInfo->userData = allocator->userData;
+  } else {
+    allocExtBuffer(newCapacity, &newBuf, &newInfo, &actualCapacity);
+  }
 
   // Copy the data into the new buffer
   uint8_t* newData = newBuf + newHeadroom;
@@ -784,7 +824,12 @@ void IOBuf::coalesceAndReallocate(
     }
     current = current->next_;
   } while (current != end);
-  assert(remaining == 0);
+  // the rest is the start of end
+  size_t partialLength = remaining;
+  if (partialLength > 0) {
+    assert(end != this && partialLength < end->length_);
+    memcpy(p, end->data_, partialLength);
+  }
 
   // Point at the new buffer
   decrementRefcount();
@@ -800,9 +845,12 @@ void IOBuf::coalesceAndReallocate(
   // Separate from the rest of our chain.
   // Since we don't store the unique_ptr returned by separateChain(),
   // this will immediately delete the returned subchain.
-  if (isChained()) {
+  if (isChained() && next_ != end) {
     (void)separateChain(next_, current->prev_);
   }
+  if (partialLength > 0) {
+    end->trimStart(partialLength);
+  }
 }
 
 void IOBuf::decrementRefcount() noexcept {
@@ -1163,6 +1163,45 @@ class IOBuf {
     return ByteRange(data_, length_);
   }
 
+  /**
+   * Where the coalesce(), gather() and coalescePrefix() variants that take
+   * one get the new buffer from, instead of malloc().  For instance, to
+   * keep large coalesced messages on huge pages:
+   *
+   *   IOBuf::CoalesceAllocator hugePages{
+   *       [](size_t size, void*) {
+   *         return JemallocHugePageAllocator::allocate(size);
+   *       },
+   *       [](void* buf, void*) {
+   *         JemallocHugePageAllocator::deallocate(buf);
+   *       }};
+   *
+   * allocate() must return a buffer of at least the requested size, aligned
+   * for any type, or nullptr if it is out of memory.  The buffer is released
+   * with freeFn(buf, userData) once it is no longer referenced.
+   */
+  struct CoalesceAllocator {
+    void* (*allocate)(std::size_t size, void* userData);
+    FreeFunction freeFn;
+    void* userData{nullptr};
+  };
+
+  /**
+   * Same as coalesce(), with the new buffer from the given allocator.  The
+   * IOBuf is left as is if it is not chained.
+   */
+  ByteRange coalesce(const CoalesceAllocator& allocator) {
+    if (isChained()) {
+      coalesceAndReallocate(
+          headroom(),
+          computeChainDataLength(),
+          this,
+          prev()->tailroom(),
+          &allocator);
+    }
+    return ByteRange(data_, length_);
+  }
+
   /**
    * Ensure that this chain has at least maxLength bytes available as a
    * contiguous memory range.
@@ -1189,6 +1228,45 @@ class IOBuf {
     coalesceSlow(maxLength);
   }
 
+  /**
+   * Same as gather(), with the new buffer from the given allocator.
+   */
+  void gather(std::size_t maxLength, const CoalesceAllocator& allocator) {
+    if (!isChained() || length_ >= maxLength) {
+      return;
+    }
+    coalesceSlow(maxLength, &allocator);
+  }
+
+  /**
+   * Make the first length bytes of the chain contiguous, and return them.
+   *
+   * Unlike gather(), which copies whole buffers, only the prefix is copied
+   * into the new buffer: the buffer in which it ends is trimmed rather than
+   * coalesced, so that looking ahead into a large message costs a copy of
+   * the window only.  The new buffer has as much headroom as this one, but
+   * no tailroom is reserved.
+   *
+   * Throws std::bad_alloc or std::overflow_error on error, with the chain
+   * unmodified.  Throws std::overflow_error if length is longer than the
+   * total chain length.
+   */
+  ByteRange coalescePrefix(std::size_t length) {
+    if (length_ < length) {
+      coalescePrefixSlow(length, nullptr);
+    }
+    return ByteRange(data_, length);
+  }
+
+  ByteRange coalescePrefix(
+      std::size_t length,
+      const CoalesceAllocator& allocator) {
+    if (length_ < length) {
+      coalescePrefixSlow(length, &allocator);
+    }
+    return ByteRange(data_, length);
+  }
+
   /**
    * Return a new IOBuf chain sharing the same data as this chain.
    *
@@ -1473,14 +1551,19 @@ class IOBuf {
   void unshareChained();
   void makeManagedChained();
   void coalesceSlow();
-  void coalesceSlow(size_t maxLength);
-  // newLength must be the entire length of the buffers between this and
-  // end (no truncation)
+  void coalesceSlow(
+      size_t maxLength,
+      const CoalesceAllocator* allocator = nullptr);
+  void coalescePrefixSlow(size_t length, const CoalesceAllocator* allocator);
+  // newLength must be at least the entire length of the buffers between this
+  // and end; anything beyond that is copied from the start of end, which is
+  // then trimmed.  allocator is null to use malloc().
   void coalesceAndReallocate(
       size_t newHeadroom,
       size_t newLength,
       IOBuf* end,
-      size_t newTailroom);
+      size_t newTailroom,
+      const CoalesceAllocator* allocator = nullptr);
   void coalesceAndReallocate(size_t newLength, IOBuf* end) {
     coalesceAndReallocate(headroom(), newLength, end, end->prev_->tailroom());
   }
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/IOBufPool.h>
+
+#include <algorithm>
+
+#include <folly/Indestructible.h>
+#include <folly/memory/Malloc.h>
+
+#include <glog/logging.h>
+
+namespace folly {
+
+constexpr size_t IOBufPool::kNumSizeClasses;
+constexpr size_t IOBufPool::kMinSizeClass;
+constexpr size_t IOBufPool::kMaxSizeClass;
+constexpr size_t IOBufPool::kHeaderSize;
+
+struct IOBufPool::Header {
+  IOBufPool* pool;
+  size_t sizeClass;
+
+  void* data() {
+    return reinterpret_cast<uint8_t*>(this) + kHeaderSize;
+  }
+
+  static size_t capacity(size_t sizeClass) {
+    return (kMinSizeClass << sizeClass) - kHeaderSize;
+  }
+};
+
+struct IOBufPool::LocalCache {
+  explicit LocalCache(IOBufPool* pool) : pool(pool) {}
+
+  ~LocalCache() {
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      pool->flush(i, buffers[i], buffers[i].size());
+    }
+  }
+
+  IOBufPool* pool;
+  std::array<std::vector<Header*>, kNumSizeClasses> buffers;
+};
+
+IOBufPool::IOBufPool() : IOBufPool(Options()) {}
+
+IOBufPool::IOBufPool(Options options)
+    : options_(options),
+      local_([this] { return new LocalCache(this); }) {
+  CHECK_GT(options_.transferBatch, 0);
+}
+
+IOBufPool::~IOBufPool() {
+  // Thread caches have to be flushed before the shared lists are freed.
+  for (auto& cache : local_.accessAllThreads()) {
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      flush(i, cache.buffers[i], cache.buffers[i].size());
+    }
+  }
+  trim();
+  DCHECK_EQ(numBuffers(), 0) << "IOBufPool destroyed with buffers in use";
+}
+
+IOBufPool& IOBufPool::instance() {
+  static Indestructible<IOBufPool> pool;
+  return *pool;
+}
+
+size_t IOBufPool::sizeClassFor(size_t capacity) {
+  size_t sizeClass = 0;
+  while (sizeClass < kNumSizeClasses &&
+         Header::capacity(sizeClass) < capacity) {
+    ++sizeClass;
+  }
+  return sizeClass;
+}
+
+std::unique_ptr<IOBuf> IOBufPool::create(std::size_t capacity) {
+  auto sizeClass = sizeClassFor(capacity);
+  if (sizeClass == kNumSizeClasses) {
+    return IOBuf::create(capacity);
+  }
+  auto* header = allocate(sizeClass);
+  // Releases the buffer if allocating the IOBuf fails.
+  return IOBuf::takeOwnership(
+      header->data(),
+      Header::capacity(sizeClass),
+      0,
+      &IOBufPool::freeBuffer,
+      header);
+}
+
+void IOBufPool::freeBuffer(void* /* buf */, void* userData) noexcept {
+  auto* header = static_cast<Header*>(userData);
+  header->pool->release(header);
+}
+
+IOBufPool::Header* IOBufPool::allocate(size_t sizeClass) {
+  static_assert(sizeof(Header) <= kHeaderSize, "IOBufPool header too large");
+  auto& local = local_->buffers[sizeClass];
+  if (local.empty()) {
+    refill(sizeClass, local);
+  }
+  if (!local.empty()) {
+    auto* header = local.back();
+    local.pop_back();
+    return header;
+  }
+  auto* header =
+      static_cast<Header*>(checkedMalloc(kMinSizeClass << sizeClass));
+  header->pool = this;
+  header->sizeClass = sizeClass;
+  numBuffers_.fetch_add(1, std::memory_order_relaxed);
+  return header;
+}
+
+void IOBufPool::release(Header* header) noexcept {
+  auto& local = local_->buffers[header->sizeClass];
+  local.push_back(header);
+  if (local.size() > options_.maxLocalBuffers) {
+    flush(
+        header->sizeClass,
+        local,
+        std::min(local.size(), options_.transferBatch));
+  }
+}
+
+void IOBufPool::refill(size_t sizeClass, std::vector<Header*>& local) {
+  auto& shared = shared_[sizeClass];
+  std::lock_guard<std::mutex> guard(shared.mutex);
+  auto count = std::min(shared.buffers.size(), options_.transferBatch);
+  local.insert(local.end(), shared.buffers.end() - count, shared.buffers.end());
+  shared.buffers.resize(shared.buffers.size() - count);
+}
+
+void IOBufPool::flush(
+    size_t sizeClass,
+    std::vector<Header*>& local,
+    size_t count) {
+  DCHECK_LE(count, local.size());
+  auto begin = local.end() - count;
+  auto& shared = shared_[sizeClass];
+  {
+    std::lock_guard<std::mutex> guard(shared.mutex);
+    auto room = options_.maxSharedBuffers -
+        std::min(options_.maxSharedBuffers, shared.buffers.size());
+    auto kept = std::min(room, count);
+    shared.buffers.insert(shared.buffers.end(), begin, begin + kept);
+    begin += kept;
+  }
+  // the shared list is full
+  for (auto it = begin; it != local.end(); ++it) {
+    deallocate(*it);
+  }
+  local.resize(local.size() - count);
+}
+
+void IOBufPool::deallocate(Header* header) noexcept {
+  numBuffers_.fetch_sub(1, std::memory_order_relaxed);
+  free(header);
+}
+
+size_t IOBufPool::numSharedBuffers() const {
+  size_t count = 0;
+  for (auto& shared : shared_) {
+    std::lock_guard<std::mutex> guard(shared.mutex);
+    count += shared.buffers.size();
+  }
+  return count;
+}
+
+void IOBufPool::flushThreadCache() {
+  auto& cache = *local_;
+  for (size_t i = 0; i < kNumSizeClasses; ++i) {
+    flush(i, cache.buffers[i], cache.buffers[i].size());
+  }
+}
+
+void IOBufPool::trim() {
+  for (auto& shared : shared_) {
+    std::vector<Header*> buffers;
+    {
+      std::lock_guard<std::mutex> guard(shared.mutex);
+      buffers.swap(shared.buffers);
+    }
+    for (auto* header : buffers) {
+      deallocate(header);
+    }
+  }
+}
+
+} // namespace folly
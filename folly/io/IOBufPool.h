@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Align.h>
+
+namespace folly {
+
+/**
+ * Opt-in pool for IOBuf data buffers, for code that creates and frees many
+ * small IOBufs at a high rate.
+ *
+ * Buffers are rounded up to one of a few power of two size classes (64 bytes
+ * to 64KB, including a small header) and freed buffers are kept for reuse
+ * instead of being returned to malloc. Each thread caches freed buffers
+ * privately; buffers freed on another thread than the one that allocated
+ * them simply go to the freeing thread's cache. Threads exchange buffers in
+ * batches with a shared list per size class, so a producer/consumer pair of
+ * threads gets its buffers back without touching malloc either.
+ *
+ * The returned IOBufs are regular ones created with IOBuf::takeOwnership(),
+ * and the pool gets its buffers back through the free function once the
+ * last clone is gone. Only the data buffer is pooled, the IOBuf and its
+ * SharedInfo are still allocated together from malloc.
+ *
+ * The pool must outlive the buffers it created; instance() is never
+ * destroyed.
+ */
+class IOBufPool {
+ public:
+  static constexpr size_t kNumSizeClasses = 11;
+  static constexpr size_t kMinSizeClass = 64;
+  static constexpr size_t kMaxSizeClass = kMinSizeClass
+      << (kNumSizeClasses - 1);
+
+  struct Options {
+    // Freed buffers each thread keeps per size class before handing a batch
+    // over to the shared list.
+    size_t maxLocalBuffers{64};
+    // Buffers that move between a thread and the shared list at once.
+    size_t transferBatch{32};
+    // Buffers kept in the shared list per size class; buffers beyond that
+    // are returned to malloc.
+    size_t maxSharedBuffers{4096};
+  };
+
+  IOBufPool();
+  explicit IOBufPool(Options options);
+  ~IOBufPool();
+
+  IOBufPool(const IOBufPool&) = delete;
+  IOBufPool& operator=(const IOBufPool&) = delete;
+
+  /**
+   * The process wide pool.
+   */
+  static IOBufPool& instance();
+
+  /**
+   * Create an empty IOBuf with room for at least the given capacity.
+   * Capacities above the largest size class are allocated with
+   * IOBuf::create() and are not pooled.
+   */
+  std::unique_ptr<IOBuf> create(std::size_t capacity);
+
+  /**
+   * The largest capacity that is served from the pool.
+   */
+  static constexpr size_t maxPooledCapacity() {
+    return kMaxSizeClass - kHeaderSize;
+  }
+
+  /**
+   * Number of buffers allocated from malloc and not freed yet, whether they
+   * are in use or cached.
+   */
+  size_t numBuffers() const {
+    return numBuffers_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Number of buffers in the shared lists.
+   */
+  size_t numSharedBuffers() const;
+
+  /**
+   * Return the buffers cached by the calling thread to the shared lists.
+   */
+  void flushThreadCache();
+
+  /**
+   * Free the buffers in the shared lists.
+   */
+  void trim();
+
+ private:
+  struct Header;
+  struct LocalCache;
+
+  struct alignas(hardware_destructive_interference_size) SharedList {
+    mutable std::mutex mutex;
+    std::vector<Header*> buffers;
+  };
+
+  // keeps the data max_align_t aligned
+  static constexpr size_t kHeaderSize = alignof(std::max_align_t) > 16
+      ? alignof(std::max_align_t)
+      : 16;
+
+  static size_t sizeClassFor(size_t capacity);
+  static void freeBuffer(void* buf, void* userData) noexcept;
+
+  Header* allocate(size_t sizeClass);
+  void release(Header* header) noexcept;
+  void refill(size_t sizeClass, std::vector<Header*>& local);
+  void flush(size_t sizeClass, std::vector<Header*>& local, size_t count);
+  void deallocate(Header* header) noexcept;
+
+  const Options options_;
+  std::atomic<size_t> numBuffers_{0};
+  std::array<SharedList, kNumSizeClasses> shared_;
+  // destroyed first, returning the cached buffers to shared_
+  ThreadLocal<LocalCache, IOBufPool> local_;
+};
+
+} // namespace folly
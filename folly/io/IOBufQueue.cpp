@@ -20,6 +20,8 @@
 
 #include <stdexcept>
 
+#include <folly/io/IOBufPool.h>
+
 using std::make_pair;
 using std::pair;
 using std::unique_ptr;
@@ -28,9 +30,6 @@ namespace {
 
 using folly::IOBuf;
 
-const size_t MIN_ALLOC_SIZE = 2000;
-const size_t MAX_ALLOC_SIZE = 8000;
-
 /**
  * Convenience function to append chain src to chain dst.
  */
@@ -149,7 +148,7 @@ void IOBufQueue::append(unique_ptr<IOBuf>&& buf, bool pack) {
   if (options_.cacheChainLength) {
     chainLength_ += buf->computeChainDataLength();
   }
-  appendToChain(head_, std::move(buf), pack);
+  appendChain(std::move(buf), pack);
 }
 
 void IOBufQueue::append(const folly::IOBuf& buf, bool pack) {
@@ -202,7 +201,7 @@ void IOBufQueue::append(IOBufQueue& other, bool pack) {
       chainLength_ += other.head_->computeChainDataLength();
     }
   }
-  appendToChain(head_, std::move(other.head_), pack);
+  appendChain(std::move(other.head_), pack);
   other.chainLength_ = 0;
 }
 
@@ -214,8 +213,8 @@ void IOBufQueue::append(const void* buf, size_t len) {
         (head_->prev()->tailroom() == 0)) {
       appendToChain(
           head_,
-          IOBuf::create(
-              std::max(MIN_ALLOC_SIZE, std::min(len, MAX_ALLOC_SIZE))),
+          allocateBuffer(std::max(
+              nextAllocationSize(0), std::min(len, options_.maxAllocSize))),
           false);
     }
     IOBuf* last = head_->prev();
@@ -248,7 +247,7 @@ pair<void*, std::size_t> IOBufQueue::preallocateSlow(
   // Avoid grabbing update guard, since we're manually setting the cache ptrs.
   flushCache();
   // Allocate a new buffer of the requested max size.
-  unique_ptr<IOBuf> newBuf(IOBuf::create(std::max(min, newAllocationSize)));
+  unique_ptr<IOBuf> newBuf(allocateBuffer(std::max(min, newAllocationSize)));
 
   tailStart_ = newBuf->writableTail();
   cachePtr_->cachedRange = std::pair<uint8_t*, uint8_t*>(
@@ -257,6 +256,48 @@ pair<void*, std::size_t> IOBufQueue::preallocateSlow(
   return make_pair(writableTail(), std::min<std::size_t>(max, tailroom()));
 }
 
+size_t IOBufQueue::nextAllocationSize(size_t min) const {
+  size_t size = options_.minAllocSize;
+  if (options_.growthFactor > 1 && head_) {
+    auto capacity = head_->prev()->capacity();
+    size = capacity > options_.maxAllocSize / options_.growthFactor
+        ? options_.maxAllocSize
+        : std::max(size, capacity * options_.growthFactor);
+  }
+  return std::max(min, std::min(size, options_.maxAllocSize));
+}
+
+unique_ptr<IOBuf> IOBufQueue::allocateBuffer(size_t size) {
+  ++buffersAllocated_;
+  return options_.pool ? options_.pool->create(size) : IOBuf::create(size);
+}
+
+void IOBufQueue::appendChain(unique_ptr<IOBuf>&& buf, bool pack) {
+  if (options_.coalesceBelow == 0) {
+    appendToChain(head_, std::move(buf), pack);
+    return;
+  }
+  while (buf) {
+    auto rest = buf->pop();
+    auto n = buf->length();
+    if (n > options_.coalesceBelow) {
+      appendToChain(head_, std::move(buf), pack);
+    } else {
+      if (head_ == nullptr || head_->prev()->isSharedOne() ||
+          head_->prev()->tailroom() < n) {
+        appendToChain(head_, allocateBuffer(nextAllocationSize(n)), false);
+      }
+      IOBuf* tail = head_->prev();
+      if (n > 0) {
+        memcpy(tail->writableTail(), buf->data(), n);
+        tail->append(n);
+      }
+      ++buffersCoalesced_;
+    }
+    buf = std::move(rest);
+  }
+}
+
 unique_ptr<IOBuf> IOBufQueue::split(size_t n, bool throwOnUnderflow) {
   auto guard = updateGuard();
   unique_ptr<IOBuf> result;
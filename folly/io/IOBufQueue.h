@@ -24,6 +24,8 @@
 
 namespace folly {
 
+class IOBufPool;
+
 /**
  * An IOBufQueue encapsulates a chain of IOBufs and provides
  * convenience functions to append data to the back of the chain
@@ -72,13 +74,43 @@ class IOBufQueue {
 
  public:
   struct Options {
-    Options() : cacheChainLength(false) {}
+    Options()
+        : cacheChainLength(false),
+          minAllocSize(2000),
+          maxAllocSize(8000),
+          growthFactor(1),
+          pool(nullptr),
+          coalesceBelow(0) {}
     bool cacheChainLength;
+
+    /**
+     * Sizes of the buffers the queue allocates itself, i.e. by append() of
+     * raw data and by the single argument preallocate(). Each new buffer
+     * is growthFactor times the capacity of the current tail, within
+     * [minAllocSize, maxAllocSize], and never smaller than what the caller
+     * needs. A growthFactor of 1 allocates minAllocSize bytes each time.
+     */
+    size_t minAllocSize;
+    size_t maxAllocSize;
+    size_t growthFactor;
+
+    /**
+     * If set, the buffers the queue allocates itself come from this pool,
+     * which must outlive them.
+     */
+    IOBufPool* pool;
+
+    /**
+     * Buffers of at most this many bytes appended with append(unique_ptr)
+     * or append(IOBufQueue&) are copied into the tail instead of being
+     * chained, allocating a new tail buffer if needed, so that many small
+     * appends do not build a long chain.
+     */
+    size_t coalesceBelow;
   };
 
   /**
-   * Commonly used Options, currently the only possible value other than
-   * the default.
+   * Commonly used Options.
    */
   static Options cacheChainLength() {
     Options options;
@@ -368,6 +400,21 @@ class IOBufQueue {
     return preallocateSlow(min, newAllocationSize, max);
   }
 
+  /**
+   * Like preallocate() above, with the size of a new buffer chosen by the
+   * growth policy of the queue's Options.
+   */
+  std::pair<void*, std::size_t> preallocate(std::size_t min) {
+    dcheckCacheIntegrity();
+
+    if (LIKELY(writableTail() != nullptr && tailroom() >= min)) {
+      return std::make_pair(writableTail(), tailroom());
+    }
+
+    return preallocateSlow(
+        min, nextAllocationSize(min), std::numeric_limits<std::size_t>::max());
+  }
+
   /**
    * Tell the queue that the caller has written data into the first n
    * bytes provided by the previous preallocate() call.
@@ -511,6 +558,28 @@ class IOBufQueue {
     return options_;
   }
 
+  /**
+   * Number of IOBufs in the chain.
+   */
+  size_t countChainElements() const {
+    return head_ ? head_->countChainElements() : 0;
+  }
+
+  /**
+   * Number of buffers this queue allocated itself since it was created.
+   */
+  size_t buffersAllocated() const {
+    return buffersAllocated_;
+  }
+
+  /**
+   * Number of appended buffers that were copied into the tail rather than
+   * chained, because of Options::coalesceBelow.
+   */
+  size_t buffersCoalesced() const {
+    return buffersCoalesced_;
+  }
+
   /**
    * Clear the queue.  Note that this does not release the buffers, it
    * just sets their length to zero; useful if you want to reuse the
@@ -537,6 +606,10 @@ class IOBufQueue {
  private:
   std::unique_ptr<folly::IOBuf> split(size_t n, bool throwOnUnderflow);
 
+  size_t nextAllocationSize(size_t min) const;
+  std::unique_ptr<folly::IOBuf> allocateBuffer(size_t size);
+  void appendChain(std::unique_ptr<folly::IOBuf>&& buf, bool pack);
+
   static const size_t kChainLengthNotCached = (size_t)-1;
   /** Not copyable */
   IOBufQueue(const IOBufQueue&) = delete;
@@ -548,6 +621,8 @@ class IOBufQueue {
   // because doing it unchecked in postallocate() is faster (no (mis)predicted
   // branch)
   mutable size_t chainLength_{0};
+  size_t buffersAllocated_{0};
+  size_t buffersCoalesced_{0};
   /**
    * Everything that has been appended but not yet discarded or moved out
    * Note: anything that needs to operate on a tail should either call
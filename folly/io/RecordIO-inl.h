@@ -41,10 +41,18 @@ class RecordIOReader::Iterator : public detail::IteratorFacade<
     return recordAndPos_;
   }
   bool equal(const Iterator& other) const {
-    return range_ == other.range_;
+    return range_ == other.range_ &&
+        blockRest_.size() == other.blockRest_.size();
   }
   void increment() {
-    size_t skip = recordio_helpers::headerSize() + recordAndPos_.first.size();
+    if (!blockRest_.empty()) {
+      recordAndPos_.first = recordio_helpers::nextBlockRecord(blockRest_);
+      if (!recordAndPos_.first.empty()) {
+        return;
+      }
+    }
+    block_.reset();
+    size_t skip = recordio_helpers::headerSize() + recordLength_;
     recordAndPos_.second += off_t(skip);
     range_.advance(skip);
     advanceToValid();
@@ -53,8 +61,14 @@ class RecordIOReader::Iterator : public detail::IteratorFacade<
   void advanceToValid();
   ByteRange range_;
   uint32_t fileId_ = 0;
+  // of the current record in the file, which may be a block
+  size_t recordLength_ = 0;
   // stored as a pair so we can return by reference in dereference()
   std::pair<ByteRange, off_t> recordAndPos_;
+  // uncompressed block the current record is in, if any, shared by copies
+  std::shared_ptr<IOBuf> block_;
+  // records after the current one in block_
+  ByteRange blockRest_;
 };
 
 inline auto RecordIOReader::cbegin() const -> Iterator {
@@ -73,6 +87,24 @@ inline auto RecordIOReader::seek(off_t pos) const -> Iterator {
   return Iterator(map_.range(), fileId_, pos);
 }
 
+template <class Key, class GetKey, class Compare>
+size_t IndexedRecordIOReader::lowerBound(
+    const Key& key,
+    GetKey getKey,
+    Compare less) const {
+  size_t lo = 0;
+  size_t hi = size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (less(getKey(record(mid).first), key)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
 namespace recordio_helpers {
 
 namespace recordio_detail {
@@ -87,7 +119,7 @@ struct Header {
   uint32_t magic;
   uint8_t version; // backwards incompatible version, currently 0
   uint8_t hashFunction; // 0 = SpookyHashV2
-  uint16_t flags; // reserved (must be 0)
+  uint16_t flags; // 0 or kBlockFlag
   uint32_t fileId; // unique file ID
   uint32_t dataLength;
   std::size_t dataHash;
@@ -24,6 +24,10 @@
 #include <folly/Portability.h>
 #include <folly/ScopeGuard.h>
 #include <folly/String.h>
+#include <folly/hash/Checksum.h>
+#include <folly/lang/Bits.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysUio.h>
 #include <folly/portability/Unistd.h>
 
 namespace folly {
@@ -45,8 +49,57 @@ RecordIOWriter::RecordIOWriter(File file, uint32_t fileId)
   filePos_ = st.st_size;
 }
 
+RecordIOWriter::RecordIOWriter(
+    File file,
+    uint32_t fileId,
+    const BlockOptions& options)
+    : RecordIOWriter(std::move(file), fileId) {
+  if (options.blockSize == 0) {
+    throw std::invalid_argument("RecordIOWriter: invalid block size");
+  }
+  codec_ = io::getCodec(options.codecType, options.compressionLevel);
+  blockSize_ = options.blockSize;
+}
+
+RecordIOWriter::~RecordIOWriter() {
+  try {
+    flush();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "RecordIOWriter: failed to write the last block: "
+               << e.what();
+  }
+}
+
 void RecordIOWriter::write(std::unique_ptr<IOBuf> buf) {
-  size_t totalLength = prependHeader(buf, fileId_);
+  if (!codec_) {
+    writeRecord(std::move(buf), 0);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(blockMutex_);
+  appendToBlock(block_, std::move(buf));
+  if (block_.chainLength() >= blockSize_) {
+    flushBlockLocked();
+  }
+}
+
+void RecordIOWriter::flush() {
+  if (!codec_) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(blockMutex_);
+  flushBlockLocked();
+}
+
+void RecordIOWriter::flushBlockLocked() {
+  if (block_.empty()) {
+    return;
+  }
+  auto block = block_.move();
+  writeRecord(compressBlock(*block, *codec_), kBlockFlag);
+}
+
+void RecordIOWriter::writeRecord(std::unique_ptr<IOBuf> buf, uint16_t flags) {
+  size_t totalLength = prependHeader(buf, fileId_, flags);
   if (totalLength == 0) {
     return; // nothing to do
   }
@@ -86,20 +139,171 @@ RecordIOReader::Iterator::Iterator(ByteRange range, uint32_t fileId, off_t pos)
 }
 
 void RecordIOReader::Iterator::advanceToValid() {
-  ByteRange record = findRecord(range_, fileId_).record;
-  if (record.empty()) {
-    recordAndPos_ = std::make_pair(ByteRange(), off_t(-1));
-    range_.clear(); // at end
-  } else {
+  while (true) {
+    auto info = findRecord(range_, fileId_);
+    ByteRange record = info.record;
+    if (record.empty()) {
+      recordAndPos_ = std::make_pair(ByteRange(), off_t(-1));
+      range_.clear(); // at end
+      return;
+    }
     auto skipped = size_t(record.begin() - range_.begin());
     DCHECK_GE(skipped, headerSize());
     skipped -= headerSize();
     range_.advance(skipped);
-    recordAndPos_.first = record;
     recordAndPos_.second += off_t(skipped);
+    recordLength_ = record.size();
+    if (!(info.flags & kBlockFlag)) {
+      recordAndPos_.first = record;
+      return;
+    }
+    block_ = uncompressBlock(record);
+    if (block_) {
+      blockRest_ = ByteRange(block_->data(), block_->length());
+      recordAndPos_.first = nextBlockRecord(blockRest_);
+      if (!recordAndPos_.first.empty()) {
+        return;
+      }
+      block_.reset();
+    }
+    // invalid or empty block, move on to the next record
+    size_t skip = headerSize() + recordLength_;
+    recordAndPos_.second += off_t(skip);
+    range_.advance(skip);
+  }
+}
+
+namespace {
+
+struct IndexFileHeader {
+  static constexpr uint32_t kMagic = 0x58444952; // "RIDX"
+  uint32_t magic;
+  uint32_t version; // currently 0
+  uint32_t fileId; // of the records that were indexed, 0 for all
+  uint32_t flags; // reserved (must be 0)
+  uint64_t fileSize; // of the indexed file
+};
+
+static_assert(
+    sizeof(IndexFileHeader) % alignof(IndexedRecordIOReader::IndexEntry) == 0,
+    "index entries would be misaligned");
+static_assert(
+    sizeof(IndexedRecordIOReader::IndexEntry) == 16,
+    "invalid index entry layout");
+
+} // namespace
+
+IndexedRecordIOReader::IndexedRecordIOReader(File file, uint32_t fileId)
+    : map_(std::move(file)), fileId_(fileId) {
+  buildIndex();
+  map_.advise(MADV_RANDOM);
+}
+
+IndexedRecordIOReader::IndexedRecordIOReader(
+    File file,
+    File indexFile,
+    uint32_t fileId)
+    : map_(std::move(file)), fileId_(fileId) {
+  if (!loadIndex(std::move(indexFile))) {
+    LOG(WARNING) << "RecordIO index is invalid or stale, rebuilding it";
+    buildIndex();
+  }
+  map_.advise(MADV_RANDOM);
+}
+
+void IndexedRecordIOReader::buildIndex() {
+  map_.advise(MADV_SEQUENTIAL);
+  builtIndex_.clear();
+  ByteRange whole = map_.range();
+  ByteRange rest = whole;
+  while (true) {
+    auto info = findRecord(rest, whole, fileId_);
+    if (info.record.empty()) {
+      break;
+    }
+    auto offset = size_t(info.record.begin() - whole.begin()) - headerSize();
+    builtIndex_.push_back(
+        {offset, info.fileId, uint32_t(info.record.size())});
+    rest = ByteRange(info.record.end(), whole.end());
+  }
+  index_ = Range<const IndexEntry*>(builtIndex_.data(), builtIndex_.size());
+}
+
+bool IndexedRecordIOReader::loadIndex(File indexFile) {
+  MemoryMapping map(std::move(indexFile));
+  ByteRange range = map.range();
+  if (range.size() < sizeof(IndexFileHeader)) {
+    return false;
+  }
+  IndexFileHeader header;
+  memcpy(&header, range.data(), sizeof(header));
+  range.advance(sizeof(header));
+  if (header.magic != IndexFileHeader::kMagic || header.version != 0 ||
+      header.flags != 0 || header.fileId != fileId_ ||
+      header.fileSize != map_.range().size() ||
+      range.size() % sizeof(IndexEntry) != 0) {
+    return false;
+  }
+  index_ = Range<const IndexEntry*>(
+      reinterpret_cast<const IndexEntry*>(range.data()),
+      range.size() / sizeof(IndexEntry));
+  indexMap_ = std::make_unique<MemoryMapping>(std::move(map));
+  return true;
+}
+
+auto IndexedRecordIOReader::record(size_t n) const -> value_type {
+  if (n >= index_.size()) {
+    throw_exception<std::out_of_range>("RecordIO record index out of range");
+  }
+  const auto& entry = index_[n];
+  ByteRange range = map_.range();
+  RecordInfo info{0, {}};
+  if (entry.offset < range.size()) {
+    range.advance(size_t(entry.offset));
+    info = validateRecord(range, fileId_);
+  }
+  if (info.record.size() != entry.size || info.fileId != entry.fileId) {
+    throw_exception<std::runtime_error>(
+        "RecordIO record does not match the index");
+  }
+  return value_type(info.record, off_t(entry.offset));
+}
+
+void IndexedRecordIOReader::prefetch(size_t first, size_t count) const {
+  if (count == 0 || first >= index_.size()) {
+    return;
+  }
+  count = std::min(count, index_.size() - first);
+  const auto& last = index_[first + count - 1];
+  size_t mapLength = map_.range().size();
+  size_t begin = size_t(index_[first].offset);
+  size_t end = size_t(last.offset) + headerSize() + last.size;
+  // MemoryMapping::advise() leaves out the last page if it is partial
+  auto pageSize = size_t(sysconf(_SC_PAGESIZE));
+  end = std::min(mapLength, (end + pageSize - 1) / pageSize * pageSize);
+  if (begin < end) {
+    map_.advise(MADV_WILLNEED, begin, end - begin);
   }
 }
 
+void IndexedRecordIOReader::writeIndex(const File& indexFile) const {
+  IndexFileHeader header;
+  header.magic = IndexFileHeader::kMagic;
+  header.version = 0;
+  header.fileId = fileId_;
+  header.flags = 0;
+  header.fileSize = map_.range().size();
+
+  iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<IndexEntry*>(index_.data());
+  iov[1].iov_len = index_.size() * sizeof(IndexEntry);
+  checkUnixError(ftruncateNoInt(indexFile.fd(), 0), "ftruncate() failed");
+  auto bytes = pwritevFull(indexFile.fd(), iov, 2, 0);
+  checkUnixError(bytes, "pwritev() failed");
+}
+
 namespace recordio_helpers {
 
 using recordio_detail::Header;
@@ -108,6 +312,25 @@ namespace {
 
 constexpr uint32_t kHashSeed = 0xdeadbeef; // for mcurtiss
 
+// Data of a block record, followed by the compressed records.  Records are
+// stored as a 32-bit length followed by the record.
+FOLLY_PACK_PUSH
+struct BlockHeader {
+  uint8_t codecType; // io::CodecType
+  uint8_t reserved[3]; // must be 0
+  uint32_t uncompressedLength;
+  uint32_t checksum; // CRC-32C of the uncompressed records
+} FOLLY_PACK_ATTR;
+FOLLY_PACK_POP
+
+uint32_t blockChecksum(const IOBuf& block) {
+  uint32_t crc = ~0U;
+  for (auto br : block) {
+    crc = crc32c(br.data(), br.size(), crc);
+  }
+  return crc;
+}
+
 uint32_t headerHash(const Header& header) {
   return hash::SpookyHashV2::Hash32(
       &header, offsetof(Header, headerHash), kHashSeed);
@@ -136,7 +359,8 @@ std::size_t dataHash(ByteRange range) {
 
 } // namespace
 
-size_t prependHeader(std::unique_ptr<IOBuf>& buf, uint32_t fileId) {
+size_t
+prependHeader(std::unique_ptr<IOBuf>& buf, uint32_t fileId, uint16_t flags) {
   if (fileId == 0) {
     throw std::invalid_argument("invalid file id");
   }
@@ -159,6 +383,7 @@ size_t prependHeader(std::unique_ptr<IOBuf>& buf, uint32_t fileId) {
   auto header = reinterpret_cast<Header*>(buf->writableData());
   memset(header, 0, sizeof(Header));
   header->magic = Header::kMagic;
+  header->flags = flags;
   header->fileId = fileId;
   header->dataLength = uint32_t(lengthAndHash.first);
   header->dataHash = lengthAndHash.second;
@@ -173,7 +398,7 @@ bool validateRecordHeader(ByteRange range, uint32_t fileId) {
   }
   auto header = reinterpret_cast<const Header*>(range.begin());
   if (header->magic != Header::kMagic || header->version != 0 ||
-      header->hashFunction != 0 || header->flags != 0 ||
+      header->hashFunction != 0 || (header->flags & ~kBlockFlag) != 0 ||
       (fileId != 0 && header->fileId != fileId)) {
     return false;
   }
@@ -196,7 +421,7 @@ RecordInfo validateRecordData(ByteRange range) {
   if (dataHash(range) != header->dataHash) {
     return {0, {}};
   }
-  return {header->fileId, range};
+  return {header->fileId, range, header->flags};
 }
 
 RecordInfo validateRecord(ByteRange range, uint32_t fileId) {
@@ -238,6 +463,97 @@ findRecord(ByteRange searchRange, ByteRange wholeRange, uint32_t fileId) {
   return {0, {}};
 }
 
+void appendToBlock(IOBufQueue& block, std::unique_ptr<IOBuf> record) {
+  auto length = record->computeChainDataLength();
+  if (length == 0) {
+    return; // no zero-length records, as for unblocked ones
+  }
+  if (length >= std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Record length must fit in 32 bits");
+  }
+  auto prefix = Endian::little(uint32_t(length));
+  block.append(&prefix, sizeof(prefix));
+  block.append(std::move(record));
+}
+
+std::unique_ptr<IOBuf> compressBlock(const IOBuf& block, io::Codec& codec) {
+  auto length = block.computeChainDataLength();
+  if (length >= std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Block length must fit in 32 bits");
+  }
+  BlockHeader header;
+  memset(&header, 0, sizeof(header));
+  header.codecType = uint8_t(codec.type());
+  header.uncompressedLength = uint32_t(length);
+  header.checksum = blockChecksum(block);
+
+  auto buf = IOBuf::create(headerSize() + sizeof(header));
+  buf->advance(headerSize()); // room for prependHeader()
+  memcpy(buf->writableTail(), &header, sizeof(header));
+  buf->append(sizeof(header));
+  buf->prependChain(codec.compress(&block));
+  return buf;
+}
+
+std::unique_ptr<IOBuf> uncompressBlock(ByteRange data) {
+  BlockHeader header;
+  if (data.size() < sizeof(header)) {
+    return nullptr;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  data.advance(sizeof(header));
+  if (header.reserved[0] != 0 || header.reserved[1] != 0 ||
+      header.reserved[2] != 0) {
+    return nullptr;
+  }
+  std::unique_ptr<IOBuf> block;
+  try {
+    auto compressed = IOBuf::wrapBufferAsValue(data);
+    block = io::getCodec(io::CodecType(header.codecType))
+                ->uncompress(&compressed, header.uncompressedLength);
+  } catch (const std::exception&) {
+    return nullptr; // unknown codec or corrupt data
+  }
+  if (block->computeChainDataLength() != header.uncompressedLength) {
+    return nullptr;
+  }
+  uint32_t checksum = ~0U;
+  if (block->isChained()) {
+    // Coalesce and checksum in a single pass over the data.
+    auto coalesced = IOBuf::create(header.uncompressedLength);
+    for (auto br : *block) {
+      checksum = memcpy_crc32c(
+          coalesced->writableTail(), br.data(), br.size(), checksum);
+      coalesced->append(br.size());
+    }
+    block = std::move(coalesced);
+  } else {
+    checksum = blockChecksum(*block);
+  }
+  if (checksum != header.checksum) {
+    return nullptr;
+  }
+  return block;
+}
+
+ByteRange nextBlockRecord(ByteRange& block) {
+  uint32_t length;
+  if (block.size() < sizeof(length)) {
+    block.clear();
+    return {};
+  }
+  memcpy(&length, block.data(), sizeof(length));
+  length = Endian::little(length);
+  block.advance(sizeof(length));
+  if (length == 0 || length > block.size()) {
+    block.clear();
+    return {};
+  }
+  ByteRange record(block.data(), length);
+  block.advance(length);
+  return record;
+}
+
 } // namespace recordio_helpers
 
 } // namespace folly
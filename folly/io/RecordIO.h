@@ -27,12 +27,16 @@
 #define FOLLY_IO_RECORDIO_H_
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <folly/compression/Compression.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/system/MemoryMapping.h>
 
 namespace folly {
@@ -44,6 +48,18 @@ namespace folly {
  */
 class RecordIOWriter {
  public:
+  /**
+   * In block mode, records are buffered and written as blocks of records
+   * compressed together, each with a CRC-32C of its uncompressed content.
+   * RecordIOReader decompresses blocks as it reaches them.
+   */
+  struct BlockOptions {
+    io::CodecType codecType{io::CodecType::ZSTD};
+    int compressionLevel{io::COMPRESSION_LEVEL_DEFAULT};
+    // a block is written once its records add up to this many bytes
+    size_t blockSize{64 * 1024};
+  };
+
   /**
    * Create a RecordIOWriter around a file; will append to the end of
    * file if it exists.
@@ -59,29 +75,62 @@ class RecordIOWriter {
    */
   explicit RecordIOWriter(File file, uint32_t fileId = 1);
 
+  /**
+   * Create a RecordIOWriter in block mode.
+   */
+  RecordIOWriter(File file, uint32_t fileId, const BlockOptions& options);
+
+  /**
+   * Writes the pending block, if any.
+   */
+  ~RecordIOWriter();
+
   /**
    * Write a record.  We will use at most headerSize() bytes of headroom,
    * you might want to arrange that before copying your data into it.
+   *
+   * In block mode the record is only added to the pending block.
    */
   void write(std::unique_ptr<IOBuf> buf);
 
+  /**
+   * In block mode, write the pending block now.  Does nothing otherwise.
+   */
+  void flush();
+
   /**
    * Return the position in the file where the next byte will be written.
    * Conservative, as stuff can be written at any time from another thread.
+   * Does not account for records in the pending block.
    */
   off_t filePos() const {
     return filePos_;
   }
 
  private:
+  void writeRecord(std::unique_ptr<IOBuf> buf, uint16_t flags);
+  void flushBlockLocked();
+
   File file_;
   uint32_t fileId_;
   std::unique_lock<File> writeLock_;
   std::atomic<off_t> filePos_;
+
+  // block mode only
+  std::unique_ptr<io::Codec> codec_;
+  size_t blockSize_{0};
+  std::mutex blockMutex_;
+  IOBufQueue block_{IOBufQueue::cacheChainLength()};
 };
 
 /**
  * Class to read from a RecordIO file.  Will skip invalid records.
+ *
+ * Blocks written in block mode are decompressed when the iterator reaches
+ * them and their records returned in turn, all with the position of the
+ * block.  Records from a block are only valid until the iterator (and its
+ * copies) leave the block; records that are not in a block are valid as
+ * long as the reader.
  */
 class RecordIOReader {
  public:
@@ -121,6 +170,100 @@ class RecordIOReader {
   uint32_t fileId_;
 };
 
+/**
+ * Random access reader for RecordIO files that are no longer being written.
+ *
+ * The positions of the valid records are kept in an index, which is either
+ * read from a sidecar file previously written by writeIndex(), or built by
+ * scanning the file once if there is none or it is stale.  Record n is then
+ * found without scanning, and the records of a file sorted by some key can
+ * be binary searched with lowerBound().
+ *
+ * The file is mapped with MADV_RANDOM; use prefetch() before reading a run
+ * of consecutive records.
+ *
+ * Blocks written in block mode are indexed as single records, and returned
+ * as is; use recordio_helpers::uncompressBlock() to read their records.
+ */
+class IndexedRecordIOReader {
+ public:
+  typedef std::pair<ByteRange, off_t> value_type;
+
+  struct IndexEntry {
+    // position of the record, including its header
+    uint64_t offset;
+    uint32_t fileId;
+    // length of the record data
+    uint32_t size;
+  };
+
+  /**
+   * Build the index by scanning the file.  As with RecordIOReader, a fileId
+   * of 0 indexes all records.
+   */
+  explicit IndexedRecordIOReader(File file, uint32_t fileId = 0);
+
+  /**
+   * Use the index in indexFile if it was written for this file and fileId,
+   * otherwise build it by scanning the file.
+   */
+  IndexedRecordIOReader(File file, File indexFile, uint32_t fileId = 0);
+
+  size_t size() const {
+    return index_.size();
+  }
+
+  bool empty() const {
+    return index_.empty();
+  }
+
+  /**
+   * Return the data of record n and the position of its header in the file.
+   * Throws std::out_of_range if n is out of bounds, and std::runtime_error
+   * if the record does not match the index.
+   */
+  value_type record(size_t n) const;
+
+  value_type operator[](size_t n) const {
+    return record(n);
+  }
+
+  /**
+   * For records sorted by getKey(record data), return the index of the first
+   * one whose key is not less than key, or size() if there is none.  Reads
+   * O(log size()) records.
+   */
+  template <class Key, class GetKey, class Compare = std::less<>>
+  size_t lowerBound(const Key& key, GetKey getKey, Compare less = Compare())
+      const;
+
+  /**
+   * Ask the kernel to read records [first, first + count) ahead of time
+   * with MADV_WILLNEED.
+   */
+  void prefetch(size_t first, size_t count) const;
+
+  Range<const IndexEntry*> index() const {
+    return index_;
+  }
+
+  /**
+   * Write the index, so that it does not have to be rebuilt next time.
+   */
+  void writeIndex(const File& indexFile) const;
+
+ private:
+  void buildIndex();
+  bool loadIndex(File indexFile);
+
+  MemoryMapping map_;
+  uint32_t fileId_;
+  std::vector<IndexEntry> builtIndex_;
+  // set if the index was read from a sidecar file
+  std::unique_ptr<MemoryMapping> indexMap_;
+  Range<const IndexEntry*> index_;
+};
+
 namespace recordio_helpers {
 
 // We're exposing the guts of the RecordIO implementation for two reasons:
@@ -144,7 +287,16 @@ constexpr size_t headerSize(); // defined in RecordIO-inl.h
  * file stored as a record inside another RecordIO file).  The fileId may
  * not be 0.
  */
-size_t prependHeader(std::unique_ptr<IOBuf>& buf, uint32_t fileId = 1);
+size_t prependHeader(
+    std::unique_ptr<IOBuf>& buf,
+    uint32_t fileId = 1,
+    uint16_t flags = 0);
+
+/**
+ * Header flag of records that contain a block of records, written by
+ * RecordIOWriter in block mode.
+ */
+constexpr uint16_t kBlockFlag = 1;
 
 /**
  * Search for the first valid record that begins in searchRange (which must be
@@ -158,6 +310,7 @@ size_t prependHeader(std::unique_ptr<IOBuf>& buf, uint32_t fileId = 1);
 struct RecordInfo {
   uint32_t fileId;
   ByteRange record;
+  uint16_t flags{0};
 };
 RecordInfo
 findRecord(ByteRange searchRange, ByteRange wholeRange, uint32_t fileId);
@@ -192,6 +345,30 @@ RecordInfo validateRecordData(ByteRange range);
  */
 RecordInfo validateRecord(ByteRange range, uint32_t fileId);
 
+/**
+ * Append a record to the uncompressed content of a block.
+ */
+void appendToBlock(IOBufQueue& block, std::unique_ptr<IOBuf> record);
+
+/**
+ * Compress the content of a block into the data of a block record, leaving
+ * headroom for prependHeader().
+ */
+std::unique_ptr<IOBuf> compressBlock(const IOBuf& block, io::Codec& codec);
+
+/**
+ * Decompress and verify the data of a block record.  Returns nullptr if the
+ * block is invalid.  The result is coalesced; use nextBlockRecord() to read
+ * its records.
+ */
+std::unique_ptr<IOBuf> uncompressBlock(ByteRange data);
+
+/**
+ * Pop the next record from the front of block, which is left empty if it is
+ * truncated.
+ */
+ByteRange nextBlockRecord(ByteRange& block);
+
 } // namespace recordio_helpers
 
 } // namespace folly
@@ -0,0 +1,708 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncDNSResolver.h>
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <limits>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/AsyncTimeout.h>
+
+#include <glog/logging.h>
+
+namespace folly {
+
+namespace {
+
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kTypeCNAME = 5;
+constexpr uint16_t kTypeAAAA = 28;
+constexpr uint16_t kClassIN = 1;
+
+constexpr uint8_t kRcodeNoError = 0;
+constexpr uint8_t kRcodeNXDomain = 3;
+
+constexpr size_t kHeaderSize = 12;
+constexpr size_t kMaxNameLength = 255;
+constexpr size_t kMaxLabelLength = 63;
+constexpr uint16_t kDNSPort = 53;
+
+// Lowercases the name and strips the trailing dot. Returns false if the name
+// is empty, has an empty label or is too long.
+bool normalizeName(StringPiece host, std::string& name) {
+  host.removeSuffix(".");
+  if (host.empty() || host.size() + 2 > kMaxNameLength) {
+    return false;
+  }
+  name.clear();
+  name.reserve(host.size());
+  size_t labelLength = 0;
+  for (char c : host) {
+    if (c == '.') {
+      if (labelLength == 0) {
+        return false;
+      }
+      labelLength = 0;
+    } else if (++labelLength > kMaxLabelLength) {
+      return false;
+    }
+    name.push_back(char(std::tolower(static_cast<unsigned char>(c))));
+  }
+  return labelLength > 0;
+}
+
+std::unique_ptr<IOBuf>
+buildQuery(uint16_t id, StringPiece name, uint16_t qtype) {
+  auto buf = IOBuf::create(kHeaderSize + name.size() + 2 + 4);
+  io::Appender appender(buf.get(), 0);
+  appender.writeBE<uint16_t>(id);
+  // recursion desired
+  appender.writeBE<uint16_t>(0x0100);
+  // one question, no records
+  appender.writeBE<uint16_t>(1);
+  appender.writeBE<uint16_t>(0);
+  appender.writeBE<uint16_t>(0);
+  appender.writeBE<uint16_t>(0);
+  while (!name.empty()) {
+    auto label = name.split_step('.');
+    appender.writeBE<uint8_t>(uint8_t(label.size()));
+    appender.push(ByteRange(label));
+  }
+  appender.writeBE<uint8_t>(0);
+  appender.writeBE<uint16_t>(qtype);
+  appender.writeBE<uint16_t>(kClassIN);
+  return buf;
+}
+
+uint16_t readU16(const uint8_t* p) {
+  return uint16_t((p[0] << 8) | p[1]);
+}
+
+uint32_t readU32(const uint8_t* p) {
+  return (uint32_t(readU16(p)) << 16) | readU16(p + 2);
+}
+
+// Reads a possibly compressed name starting at pos, and moves pos past it.
+bool readName(ByteRange msg, size_t& pos, std::string& name) {
+  name.clear();
+  size_t p = pos;
+  bool jumped = false;
+  // bounds the work done for pointer loops
+  for (size_t jumps = 0; jumps < kMaxNameLength;) {
+    if (p >= msg.size()) {
+      return false;
+    }
+    uint8_t length = msg[p];
+    if ((length & 0xc0) == 0xc0) {
+      if (p + 1 >= msg.size()) {
+        return false;
+      }
+      if (!jumped) {
+        pos = p + 2;
+        jumped = true;
+      }
+      p = (size_t(length & 0x3f) << 8) | msg[p + 1];
+      ++jumps;
+      continue;
+    }
+    if (length & 0xc0) {
+      // reserved label types
+      return false;
+    }
+    if (length == 0) {
+      if (!jumped) {
+        pos = p + 1;
+      }
+      return true;
+    }
+    if (p + 1 + length > msg.size() ||
+        name.size() + length + 2 > kMaxNameLength) {
+      return false;
+    }
+    if (!name.empty()) {
+      name.push_back('.');
+    }
+    for (size_t i = 1; i <= length; ++i) {
+      name.push_back(char(std::tolower(msg[p + i])));
+    }
+    p += 1 + length;
+  }
+  return false;
+}
+
+struct Answer {
+  uint16_t id{0};
+  uint8_t rcode{kRcodeNoError};
+  uint16_t qtype{0};
+  std::string qname;
+  std::vector<IPAddress> addresses;
+  // smallest TTL of the records used
+  uint32_t ttl{std::numeric_limits<uint32_t>::max()};
+};
+
+// Returns false if the message is not a well formed response. The addresses
+// are those of the question name, following CNAMEs.
+bool parseAnswer(ByteRange msg, Answer& answer) {
+  if (msg.size() < kHeaderSize) {
+    return false;
+  }
+  answer.id = readU16(&msg[0]);
+  uint16_t flags = readU16(&msg[2]);
+  if (!(flags & 0x8000)) {
+    return false;
+  }
+  answer.rcode = uint8_t(flags & 0xf);
+  uint16_t numQuestions = readU16(&msg[4]);
+  uint16_t numAnswers = readU16(&msg[6]);
+  if (numQuestions != 1) {
+    return false;
+  }
+
+  size_t pos = kHeaderSize;
+  if (!readName(msg, pos, answer.qname) || pos + 4 > msg.size()) {
+    return false;
+  }
+  answer.qtype = readU16(&msg[pos]);
+  pos += 4;
+
+  std::vector<std::string> owners{answer.qname};
+  std::string owner;
+  std::string target;
+  for (uint16_t i = 0; i < numAnswers; ++i) {
+    if (!readName(msg, pos, owner) || pos + 10 > msg.size()) {
+      return false;
+    }
+    uint16_t type = readU16(&msg[pos]);
+    uint16_t cls = readU16(&msg[pos + 2]);
+    uint32_t ttl = readU32(&msg[pos + 4]);
+    uint16_t length = readU16(&msg[pos + 8]);
+    pos += 10;
+    if (pos + length > msg.size()) {
+      return false;
+    }
+    // RFC 2181: TTLs with the top bit set mean zero
+    if (ttl > uint32_t(std::numeric_limits<int32_t>::max())) {
+      ttl = 0;
+    }
+    bool relevant = cls == kClassIN &&
+        std::find(owners.begin(), owners.end(), owner) != owners.end();
+    if (relevant && type == kTypeCNAME) {
+      size_t targetPos = pos;
+      if (!readName(msg, targetPos, target)) {
+        return false;
+      }
+      owners.push_back(target);
+      answer.ttl = std::min(answer.ttl, ttl);
+    } else if (
+        relevant && type == answer.qtype &&
+        length == (type == kTypeA ? 4 : 16)) {
+      answer.addresses.push_back(
+          IPAddress::fromBinary(ByteRange(&msg[pos], length)));
+      answer.ttl = std::min(answer.ttl, ttl);
+    }
+    pos += length;
+  }
+  return true;
+}
+
+std::vector<SocketAddress> toSocketAddresses(
+    const std::vector<IPAddress>& addresses,
+    uint16_t port) {
+  std::vector<SocketAddress> result;
+  result.reserve(addresses.size());
+  for (const auto& address : addresses) {
+    result.emplace_back(address, port);
+  }
+  return result;
+}
+
+} // namespace
+
+constexpr size_t DNSCache::kDefaultMaxEntries;
+constexpr size_t DNSCache::kDefaultNumShards;
+
+DNSCache::DNSCache(size_t maxEntries, size_t numShards) {
+  CHECK_GT(numShards, 0);
+  auto maxEntriesPerShard = std::max<size_t>(1, maxEntries / numShards);
+  shards_.reserve(numShards);
+  for (size_t i = 0; i < numShards; ++i) {
+    shards_.push_back(std::make_unique<Shard>(maxEntriesPerShard));
+  }
+}
+
+DNSCache::Shard& DNSCache::getShard(StringPiece name) const {
+  return *shards_[hasher<StringPiece>()(name) % shards_.size()];
+}
+
+Optional<std::vector<IPAddress>> DNSCache::get(
+    StringPiece name,
+    Clock::time_point now) {
+  auto& shard = getShard(name);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.entries.find(name.str());
+  if (it == shard.entries.end()) {
+    return none;
+  }
+  if (it->second.expiry <= now) {
+    shard.entries.erase(it);
+    return none;
+  }
+  return it->second.addresses;
+}
+
+void DNSCache::put(
+    StringPiece name,
+    std::vector<IPAddress> addresses,
+    std::chrono::seconds ttl,
+    Clock::time_point now) {
+  if (ttl.count() <= 0) {
+    return;
+  }
+  auto& shard = getShard(name);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  shard.entries.set(name.str(), Entry{std::move(addresses), now + ttl});
+}
+
+void DNSCache::remove(StringPiece name) {
+  auto& shard = getShard(name);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  shard.entries.erase(name.str());
+}
+
+void DNSCache::clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    shard->entries.clear();
+  }
+}
+
+size_t DNSCache::size() const {
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    size += shard->entries.size();
+  }
+  return size;
+}
+
+class AsyncDNSResolver::Query : public AsyncTimeout {
+ public:
+  Query(AsyncDNSResolver* resolver, Lookup* lookup, uint16_t qtype)
+      : AsyncTimeout(resolver->evb_),
+        resolver(resolver),
+        lookup(lookup),
+        qtype(qtype) {}
+
+  void timeoutExpired() noexcept override {
+    resolver->queryTimedOut(this);
+  }
+
+  AsyncDNSResolver* const resolver;
+  Lookup* const lookup;
+  const uint16_t qtype;
+  uint16_t id{0};
+  size_t attempt{0};
+  SocketAddress server;
+  // what went wrong with the last attempt, none once answered
+  Optional<DNSResolverException::Type> error{
+      DNSResolverException::TIMED_OUT};
+  std::vector<IPAddress> addresses;
+  uint32_t ttl{std::numeric_limits<uint32_t>::max()};
+};
+
+struct AsyncDNSResolver::Lookup {
+  struct Waiter {
+    Callback* callback;
+    uint16_t port;
+  };
+
+  std::string name;
+  std::deque<Waiter> waiters;
+  std::vector<std::unique_ptr<Query>> queries;
+  size_t pendingQueries{0};
+};
+
+AsyncDNSResolver::AsyncDNSResolver(EventBase* evb)
+    : AsyncDNSResolver(evb, Options()) {}
+
+AsyncDNSResolver::AsyncDNSResolver(EventBase* evb, Options options)
+    : evb_(evb), options_(std::move(options)) {
+  if (options_.nameservers.empty()) {
+    options_.nameservers = systemNameservers();
+  }
+  CHECK_GT(options_.attempts, 0);
+}
+
+AsyncDNSResolver::~AsyncDNSResolver() {
+  std::vector<Callback*> callbacks;
+  auto takeWaiters = [&](Lookup& lookup) {
+    for (auto& waiter : lookup.waiters) {
+      callbacks.push_back(waiter.callback);
+    }
+    lookup.waiters.clear();
+  };
+  if (completing_) {
+    takeWaiters(*completing_);
+  }
+  for (auto& entry : lookups_) {
+    takeWaiters(*entry.second);
+  }
+  queries_.clear();
+  lookups_.clear();
+
+  DNSResolverException ex(
+      DNSResolverException::CANCELLED, "AsyncDNSResolver destroyed");
+  for (auto* callback : callbacks) {
+    callback->resolveError(ex);
+  }
+}
+
+std::vector<SocketAddress> AsyncDNSResolver::systemNameservers() {
+  std::vector<SocketAddress> nameservers;
+  std::string contents;
+  if (readFile("/etc/resolv.conf", contents)) {
+    std::vector<StringPiece> lines;
+    split('\n', contents, lines);
+    for (auto line : lines) {
+      line = trimWhitespace(line);
+      if (!line.removePrefix("nameserver")) {
+        continue;
+      }
+      auto address = IPAddress::tryFromString(trimWhitespace(line));
+      if (address.hasValue()) {
+        nameservers.emplace_back(*address, kDNSPort);
+      }
+    }
+  }
+  if (nameservers.empty()) {
+    nameservers.emplace_back(IPAddress("127.0.0.1"), kDNSPort);
+  }
+  return nameservers;
+}
+
+void AsyncDNSResolver::resolve(
+    Callback* callback,
+    StringPiece host,
+    uint16_t port) {
+  evb_->dcheckIsInEventBaseThread();
+  if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+    host = host.subpiece(1, host.size() - 2);
+  }
+  auto literal = IPAddress::tryFromString(host);
+  if (literal.hasValue()) {
+    callback->resolveSuccess({SocketAddress(*literal, port)});
+    return;
+  }
+
+  std::string name;
+  if (!normalizeName(host, name)) {
+    callback->resolveError(DNSResolverException(
+        DNSResolverException::INVALID_NAME,
+        to<std::string>("invalid host name: ", host)));
+    return;
+  }
+
+  Optional<std::vector<IPAddress>> known;
+  if (name == "localhost") {
+    known.emplace();
+    if (options_.family != Family::V4_ONLY) {
+      known->push_back(IPAddress("::1"));
+    }
+    if (options_.family != Family::V6_ONLY) {
+      known->push_back(IPAddress("127.0.0.1"));
+    }
+    if (!options_.preferIPv6) {
+      std::reverse(known->begin(), known->end());
+    }
+  } else if (options_.cache) {
+    known = options_.cache->get(name);
+  }
+  if (known) {
+    if (known->empty()) {
+      callback->resolveError(DNSResolverException(
+          DNSResolverException::NOT_FOUND,
+          to<std::string>("no addresses for ", name)));
+    } else {
+      callback->resolveSuccess(toSocketAddresses(*known, port));
+    }
+    return;
+  }
+
+  startLookup(callback, std::move(name), port);
+}
+
+void AsyncDNSResolver::cancel(Callback* callback) {
+  auto removeWaiters = [callback](Lookup& lookup) {
+    auto& waiters = lookup.waiters;
+    waiters.erase(
+        std::remove_if(
+            waiters.begin(),
+            waiters.end(),
+            [callback](const Lookup::Waiter& waiter) {
+              return waiter.callback == callback;
+            }),
+        waiters.end());
+  };
+  if (completing_) {
+    removeWaiters(*completing_);
+  }
+  for (auto& entry : lookups_) {
+    removeWaiters(*entry.second);
+  }
+}
+
+void AsyncDNSResolver::startLookup(
+    Callback* callback,
+    std::string name,
+    uint16_t port) {
+  auto it = lookups_.find(name);
+  if (it != lookups_.end()) {
+    it->second->waiters.push_back({callback, port});
+    return;
+  }
+
+  auto lookup = std::make_unique<Lookup>();
+  lookup->name = name;
+  lookup->waiters.push_back({callback, port});
+  if (options_.family != Family::V4_ONLY) {
+    lookup->queries.push_back(
+        std::make_unique<Query>(this, lookup.get(), kTypeAAAA));
+  }
+  if (options_.family != Family::V6_ONLY) {
+    lookup->queries.push_back(
+        std::make_unique<Query>(this, lookup.get(), kTypeA));
+  }
+  lookup->pendingQueries = lookup->queries.size();
+  auto* raw = lookup.get();
+  lookups_.emplace(std::move(name), std::move(lookup));
+  // never completes the lookup synchronously
+  for (auto& query : raw->queries) {
+    sendQuery(query.get());
+  }
+}
+
+AsyncUDPSocket& AsyncDNSResolver::getSocket(sa_family_t family) {
+  auto& socket = family == AF_INET6 ? socketV6_ : socketV4_;
+  if (!socket) {
+    auto newSocket = std::make_unique<AsyncUDPSocket>(evb_);
+    SocketAddress any;
+    any.setFromIpPort(family == AF_INET6 ? "::" : "0.0.0.0", 0);
+    newSocket->bind(any);
+    socket = std::move(newSocket);
+  }
+  return *socket;
+}
+
+void AsyncDNSResolver::sendQuery(Query* query) {
+  const auto& nameservers = options_.nameservers;
+  query->server = nameservers[query->attempt % nameservers.size()];
+  do {
+    query->id = uint16_t(Random::rand32());
+  } while (queries_.count(query->id));
+
+  bool sent = false;
+  try {
+    auto& socket = getSocket(query->server.getFamily());
+    sent = socket.write(
+               query->server,
+               buildQuery(query->id, query->lookup->name, query->qtype)) > 0;
+  } catch (const std::exception& ex) {
+    VLOG(4) << "failed to send DNS query to " << query->server << ": "
+            << ex.what();
+  }
+
+  if (sent) {
+    queries_.emplace(query->id, query);
+    updateReading();
+    query->error = DNSResolverException::TIMED_OUT;
+    query->scheduleTimeout(uint32_t(options_.timeout.count()));
+  } else {
+    // moves on to the next attempt from the loop
+    query->error = DNSResolverException::NETWORK_ERROR;
+    query->scheduleTimeout(0);
+  }
+}
+
+void AsyncDNSResolver::queryTimedOut(Query* query) {
+  queries_.erase(query->id);
+  retryOrFinishQuery(query);
+}
+
+void AsyncDNSResolver::retryOrFinishQuery(Query* query) {
+  if (++query->attempt < options_.attempts) {
+    sendQuery(query);
+    return;
+  }
+  updateReading();
+  queryDone(query);
+}
+
+void AsyncDNSResolver::queryDone(Query* query) {
+  auto* lookup = query->lookup;
+  DCHECK_GT(lookup->pendingQueries, 0);
+  if (--lookup->pendingQueries == 0) {
+    finishLookup(lookup);
+  }
+}
+
+void AsyncDNSResolver::finishLookup(Lookup* lookup) {
+  std::vector<IPAddress> addresses;
+  uint32_t ttl = std::numeric_limits<uint32_t>::max();
+  Optional<DNSResolverException::Type> error;
+  for (auto& query : lookup->queries) {
+    if (!query->error) {
+      addresses.insert(
+          addresses.end(), query->addresses.begin(), query->addresses.end());
+      ttl = std::min(ttl, query->ttl);
+    } else if (!error || *error == DNSResolverException::NOT_FOUND) {
+      error = query->error;
+    }
+  }
+  if (!options_.preferIPv6) {
+    // the AAAA query comes first
+    std::stable_partition(
+        addresses.begin(), addresses.end(), [](const IPAddress& address) {
+          return address.isV4();
+        });
+  }
+
+  Optional<DNSResolverException> ex;
+  if (addresses.empty()) {
+    if (!error) {
+      // the name exists, without addresses
+      error = DNSResolverException::NOT_FOUND;
+    }
+    if (*error == DNSResolverException::NOT_FOUND) {
+      if (options_.cache) {
+        options_.cache->put(lookup->name, {}, options_.negativeTTL);
+      }
+      ex.emplace(*error, to<std::string>("no addresses for ", lookup->name));
+    } else if (*error == DNSResolverException::TIMED_OUT) {
+      ex.emplace(*error, to<std::string>("timed out resolving ", lookup->name));
+    } else {
+      ex.emplace(*error, to<std::string>("failed to resolve ", lookup->name));
+    }
+  } else if (options_.cache) {
+    auto cacheTTL = std::chrono::seconds(ttl);
+    cacheTTL = std::max(options_.minTTL, std::min(options_.maxTTL, cacheTTL));
+    options_.cache->put(lookup->name, addresses, cacheTTL);
+  }
+
+  auto it = lookups_.find(lookup->name);
+  DCHECK(it != lookups_.end());
+  auto owned = std::move(it->second);
+  lookups_.erase(it);
+
+  // The callbacks may cancel each other, start new lookups or destroy the
+  // resolver.
+  completing_ = lookup;
+  DestructorCheck::Safety safety(*this);
+  while (!lookup->waiters.empty()) {
+    auto waiter = lookup->waiters.front();
+    lookup->waiters.pop_front();
+    if (ex) {
+      waiter.callback->resolveError(*ex);
+    } else {
+      waiter.callback->resolveSuccess(
+          toSocketAddresses(addresses, waiter.port));
+    }
+    if (safety.destroyed()) {
+      return;
+    }
+  }
+  completing_ = nullptr;
+}
+
+void AsyncDNSResolver::getReadBuffer(void** buf, size_t* len) noexcept {
+  *buf = readBuf_.data();
+  *len = readBuf_.size();
+}
+
+void AsyncDNSResolver::onDataAvailable(
+    const SocketAddress& client,
+    size_t len,
+    bool /* truncated */) noexcept {
+  Answer answer;
+  if (!parseAnswer(ByteRange(readBuf_.data(), len), answer)) {
+    // the query times out if no valid answer arrives
+    VLOG(4) << "malformed DNS response from " << client;
+    return;
+  }
+  auto it = queries_.find(answer.id);
+  if (it == queries_.end()) {
+    return;
+  }
+  auto* query = it->second;
+  if (client != query->server || answer.qtype != query->qtype ||
+      answer.qname != query->lookup->name) {
+    return;
+  }
+  queries_.erase(it);
+  query->cancelTimeout();
+
+  switch (answer.rcode) {
+    case kRcodeNoError:
+      query->error = none;
+      query->addresses = std::move(answer.addresses);
+      query->ttl = answer.ttl;
+      updateReading();
+      queryDone(query);
+      break;
+    case kRcodeNXDomain:
+      query->error = DNSResolverException::NOT_FOUND;
+      updateReading();
+      queryDone(query);
+      break;
+    default:
+      query->error = DNSResolverException::SERVER_FAILURE;
+      retryOrFinishQuery(query);
+      break;
+  }
+}
+
+void AsyncDNSResolver::onReadError(const AsyncSocketException& ex) noexcept {
+  VLOG(2) << "AsyncDNSResolver read error: " << ex.what();
+  if (ex.getType() == AsyncSocketException::NOT_OPEN) {
+    return;
+  }
+  // AsyncUDPSocket stops reading after an error
+  updateReading();
+}
+
+void AsyncDNSResolver::updateReading() {
+  bool reading = !queries_.empty();
+  for (auto* socket : {socketV4_.get(), socketV6_.get()}) {
+    if (!socket || socket->isReading() == reading) {
+      continue;
+    }
+    if (reading) {
+      socket->resumeRead(this);
+    } else {
+      socket->pauseRead();
+    }
+  }
+}
+
+} // namespace folly
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/SocketAddress.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/async/AsyncUDPSocket.h>
+#include <folly/io/async/DestructorCheck.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/lang/Align.h>
+
+namespace folly {
+
+class DNSResolverException : public std::runtime_error {
+ public:
+  enum Type {
+    // the name does not exist, or has no address of the requested family
+    NOT_FOUND,
+    // the nameserver failed or refused to answer
+    SERVER_FAILURE,
+    TIMED_OUT,
+    INVALID_NAME,
+    // the query could not be sent, or the answer could not be parsed
+    NETWORK_ERROR,
+    // the lookup was abandoned because the resolver was destroyed
+    CANCELLED,
+  };
+
+  DNSResolverException(Type type, const std::string& message)
+      : std::runtime_error(message), type_(type) {}
+
+  Type getType() const noexcept {
+    return type_;
+  }
+
+ private:
+  Type type_;
+};
+
+/**
+ * Cache of resolved names that may be shared by resolvers on any number of
+ * threads. Entries live for the TTL they were added with and the least
+ * recently used ones are evicted once a shard is full. Names are hashed to
+ * one of several independently locked shards so that lookups from different
+ * IO threads rarely contend.
+ *
+ * A name may be cached with no addresses, meaning it is known not to exist.
+ */
+class DNSCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kDefaultMaxEntries = 16384;
+  static constexpr size_t kDefaultNumShards = 16;
+
+  explicit DNSCache(
+      size_t maxEntries = kDefaultMaxEntries,
+      size_t numShards = kDefaultNumShards);
+
+  /**
+   * Returns none if the name is not cached or its entry has expired.
+   */
+  Optional<std::vector<IPAddress>> get(
+      StringPiece name,
+      Clock::time_point now = Clock::now());
+
+  void put(
+      StringPiece name,
+      std::vector<IPAddress> addresses,
+      std::chrono::seconds ttl,
+      Clock::time_point now = Clock::now());
+
+  void remove(StringPiece name);
+  void clear();
+
+  /**
+   * Number of entries, including the expired ones that have not been
+   * evicted yet.
+   */
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::vector<IPAddress> addresses;
+    Clock::time_point expiry;
+  };
+
+  struct alignas(hardware_destructive_interference_size) Shard {
+    explicit Shard(size_t maxEntries) : entries(maxEntries) {}
+
+    mutable std::mutex mutex;
+    EvictingCacheMap<std::string, Entry> entries;
+  };
+
+  Shard& getShard(StringPiece name) const;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+/**
+ * Nonblocking stub resolver for A and AAAA records, driven by an EventBase.
+ *
+ * Queries are sent over UDP to the configured nameservers, one at a time,
+ * moving to the next nameserver after each timeout. Concurrent lookups of
+ * the same name share a single set of queries, and answers are kept in a
+ * DNSCache for their TTL when one is configured.
+ *
+ * Names are resolved as given: there are no search domains and /etc/hosts
+ * is not consulted, except that "localhost" always resolves to the loopback
+ * addresses. IP literals resolve to themselves. Truncated answers are used
+ * as is, there is no fallback to TCP.
+ *
+ * Must be used from the EventBase thread only. The resolver may be
+ * destroyed from a callback; lookups still pending fail with CANCELLED.
+ */
+class AsyncDNSResolver : private AsyncUDPSocket::ReadCallback,
+                         public DestructorCheck {
+ public:
+  enum class Family {
+    ANY,
+    V4_ONLY,
+    V6_ONLY,
+  };
+
+  struct Options {
+    // empty to use the ones from /etc/resolv.conf
+    std::vector<SocketAddress> nameservers;
+    // per attempt
+    std::chrono::milliseconds timeout{1000};
+    // attempts per query, each one to the next nameserver
+    size_t attempts{2};
+    Family family{Family::ANY};
+    // IPv6 addresses are listed first when both families are resolved
+    bool preferIPv6{true};
+    // bounds on the TTLs that answers are cached for
+    std::chrono::seconds minTTL{0};
+    std::chrono::seconds maxTTL{3600};
+    // how long names that do not exist are cached for
+    std::chrono::seconds negativeTTL{30};
+    // nullptr to disable caching; resolvers sharing a cache should resolve
+    // the same families
+    std::shared_ptr<DNSCache> cache;
+  };
+
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+
+    /**
+     * Invoked with at least one address; every address has the port that
+     * was passed to resolve().
+     */
+    virtual void resolveSuccess(
+        std::vector<SocketAddress> addresses) noexcept = 0;
+
+    virtual void resolveError(const DNSResolverException& ex) noexcept = 0;
+  };
+
+  explicit AsyncDNSResolver(EventBase* evb);
+  AsyncDNSResolver(EventBase* evb, Options options);
+  ~AsyncDNSResolver() override;
+
+  AsyncDNSResolver(const AsyncDNSResolver&) = delete;
+  AsyncDNSResolver& operator=(const AsyncDNSResolver&) = delete;
+
+  /**
+   * Resolve a host name. The callback is invoked before resolve() returns
+   * if the answer is known without a query, i.e. for IP literals, invalid
+   * names and cache hits.
+   */
+  void resolve(Callback* callback, StringPiece host, uint16_t port = 0);
+
+  /**
+   * Stop delivering results to the callback. Its lookups still complete
+   * and fill the cache.
+   */
+  void cancel(Callback* callback);
+
+  /**
+   * Number of names being looked up by the nameservers.
+   */
+  size_t pendingLookups() const {
+    return lookups_.size();
+  }
+
+  EventBase* getEventBase() const {
+    return evb_;
+  }
+
+  const Options& getOptions() const {
+    return options_;
+  }
+
+  /**
+   * The nameservers listed in /etc/resolv.conf, or 127.0.0.1 if there are
+   * none.
+   */
+  static std::vector<SocketAddress> systemNameservers();
+
+ private:
+  class Query;
+  struct Lookup;
+
+  void startLookup(Callback* callback, std::string name, uint16_t port);
+  void sendQuery(Query* query);
+  void queryTimedOut(Query* query);
+  void retryOrFinishQuery(Query* query);
+  void queryDone(Query* query);
+  void finishLookup(Lookup* lookup);
+  AsyncUDPSocket& getSocket(sa_family_t family);
+  // Sockets only read while queries are outstanding, so that an idle
+  // resolver does not keep EventBase::loop() running.
+  void updateReading();
+
+  // AsyncUDPSocket::ReadCallback
+  void getReadBuffer(void** buf, size_t* len) noexcept override;
+  void onDataAvailable(
+      const SocketAddress& client,
+      size_t len,
+      bool truncated) noexcept override;
+  void onReadError(const AsyncSocketException& ex) noexcept override;
+  void onReadClosed() noexcept override {}
+
+  EventBase* evb_;
+  Options options_;
+  std::unique_ptr<AsyncUDPSocket> socketV4_;
+  std::unique_ptr<AsyncUDPSocket> socketV6_;
+  // by lowercase name
+  F14NodeMap<std::string, std::unique_ptr<Lookup>> lookups_;
+  // by query id
+  F14FastMap<uint16_t, Query*> queries_;
+  // lookup whose callbacks are being invoked
+  Lookup* completing_{nullptr};
+  std::array<uint8_t, 4096> readBuf_;
+};
+
+} // namespace folly
@@ -19,6 +19,7 @@
 #include <folly/FileUtil.h>
 #include <folly/detail/FileUtilDetail.h>
 #include <folly/io/async/AsyncSocketException.h>
+#include <folly/portability/SysUio.h>
 
 using folly::IOBuf;
 using folly::IOBufQueue;
@@ -255,7 +256,6 @@ void AsyncPipeWriter::handleWrite() {
     auto& front = queue_.front();
     folly::IOBufQueue& curQueue = front.first;
     DCHECK(!curQueue.empty());
-    // someday, support writev.  The logic for partial writes is a bit complex
     const IOBuf* head = curQueue.front();
     CHECK(head->length());
 #ifdef _WIN32
@@ -263,7 +263,21 @@ void AsyncPipeWriter::handleWrite() {
     ssize_t rc = folly::fileutil_detail::wrapNoInt(
         send_internal, fd_, head->data(), head->length());
 #else
-    ssize_t rc = folly::writeNoInt(fd_.toFd(), head->data(), head->length());
+    // Write as much of the chain as possible at once; partial writes are
+    // handled by trimming the queue below.
+    constexpr int kMaxWriteIovecs = 64;
+    iovec iov[kMaxWriteIovecs];
+    int count = 0;
+    const IOBuf* buf = head;
+    do {
+      if (buf->length() > 0) {
+        iov[count].iov_base = const_cast<uint8_t*>(buf->data());
+        iov[count].iov_len = buf->length();
+        ++count;
+      }
+      buf = buf->next();
+    } while (buf != head && count < kMaxWriteIovecs);
+    ssize_t rc = folly::writevNoInt(fd_.toFd(), iov, count);
 #endif
     if (rc < 0) {
       if (errno == EAGAIN || errno == EWOULDBLOCK) {
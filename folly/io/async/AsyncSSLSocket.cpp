@@ -21,6 +21,7 @@
 
 #include <fcntl.h>
 #include <sys/types.h>
+#include <array>
 #include <cerrno>
 #include <chrono>
 #include <memory>
@@ -35,6 +36,23 @@
 #include <folly/lang/Bits.h>
 #include <folly/portability/OpenSSL.h>
 
+#if defined(__linux__) && FOLLY_OPENSSL_IS_110 && !defined(OPENSSL_IS_BORINGSSL)
+#define FOLLY_SSL_KTLS 1
+#include <linux/tls.h>
+#include <openssl/kdf.h>
+#else
+#define FOLLY_SSL_KTLS 0
+#endif
+
+#if FOLLY_SSL_KTLS
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
 using folly::SocketAddress;
 using folly::SSLContext;
 using std::shared_ptr;
@@ -67,6 +85,12 @@ static SpinLock dummyCtxLock;
 // stack, otherwise it is allocated on heap
 const size_t MAX_STACK_BUF_SIZE = 2048;
 
+// The largest TLS record payload
+constexpr size_t kMaxRecordSize = 16384;
+// Batched records are sent once they add up to this
+constexpr size_t kRecordBatchSize = 64 * 1024;
+constexpr size_t kMaxRecordIovecs = 16;
+
 // This converts "illegal" shutdowns into ZERO_RETURN
 inline bool zero_return(int error, int rc, int errno_copy) {
   if (error == SSL_ERROR_ZERO_RETURN || (rc == 0 && errno_copy == 0)) {
@@ -212,6 +236,100 @@ void* initsslBioMethod() {
   return nullptr;
 }
 
+#if FOLLY_SSL_KTLS
+// TLS record content types and the close_notify alert (RFC 5246)
+constexpr uint8_t kTLSRecordAlert = 21;
+constexpr uint8_t kTLSRecordApplicationData = 23;
+constexpr uint8_t kTLSAlertWarning = 1;
+constexpr uint8_t kTLSAlertCloseNotify = 0;
+
+// Computes the TLS 1.2 key block (RFC 5246 section 6.3). AEAD ciphers have
+// no MAC keys, so it holds the client and server write keys followed by the
+// client and server implicit nonces.
+bool deriveTLS12KeyBlock(
+    SSL* ssl,
+    const EVP_MD* md,
+    uint8_t* out,
+    size_t len) {
+  std::array<uint8_t, SSL_MAX_MASTER_KEY_LENGTH> master;
+  auto masterLen = SSL_SESSION_get_master_key(
+      SSL_get_session(ssl), master.data(), master.size());
+  std::array<uint8_t, 2 * SSL3_RANDOM_SIZE> seed;
+  SSL_get_server_random(ssl, seed.data(), SSL3_RANDOM_SIZE);
+  SSL_get_client_random(ssl, seed.data() + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+  static const char kLabel[] = "key expansion";
+
+  EvpPkeyCtxUniquePtr pctx(EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr));
+  bool ok = pctx && EVP_PKEY_derive_init(pctx.get()) > 0 &&
+      EVP_PKEY_CTX_set_tls1_prf_md(pctx.get(), md) > 0 &&
+      EVP_PKEY_CTX_set1_tls1_prf_secret(
+          pctx.get(), master.data(), int(masterLen)) > 0 &&
+      EVP_PKEY_CTX_add1_tls1_prf_seed(
+          pctx.get(),
+          reinterpret_cast<const unsigned char*>(kLabel),
+          int(sizeof(kLabel) - 1)) > 0 &&
+      EVP_PKEY_CTX_add1_tls1_prf_seed(
+          pctx.get(), seed.data(), int(seed.size())) > 0 &&
+      EVP_PKEY_derive(pctx.get(), out, &len) > 0;
+  OPENSSL_cleanse(master.data(), master.size());
+  return ok;
+}
+
+template <typename CryptoInfo>
+void fillKTLSCryptoInfo(
+    CryptoInfo& info,
+    uint16_t cipherType,
+    const uint8_t* key,
+    const uint8_t* salt) {
+  memset(&info, 0, sizeof(info));
+  info.info.version = TLS_1_2_VERSION;
+  info.info.cipher_type = cipherType;
+  memcpy(info.key, key, sizeof(info.key));
+  memcpy(info.salt, salt, sizeof(info.salt));
+  // Finished is the only record protected by these keys so far in either
+  // direction. OpenSSL uses the sequence number as the explicit nonce.
+  info.rec_seq[sizeof(info.rec_seq) - 1] = 1;
+  memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+}
+
+// Installs the write keys and, if the kernel supports it, the read keys.
+// Returns false if not even the write keys could be installed.
+template <typename CryptoInfo>
+bool installKTLSKeys(
+    folly::NetworkSocket fd,
+    bool server,
+    uint16_t cipherType,
+    const uint8_t* keyBlock,
+    bool* rxInstalled) {
+  constexpr size_t keyLen = sizeof(CryptoInfo::key);
+  constexpr size_t saltLen = sizeof(CryptoInfo::salt);
+  const uint8_t* clientKey = keyBlock;
+  const uint8_t* serverKey = clientKey + keyLen;
+  const uint8_t* clientSalt = serverKey + keyLen;
+  const uint8_t* serverSalt = clientSalt + saltLen;
+
+  CryptoInfo tx;
+  CryptoInfo rx;
+  fillKTLSCryptoInfo(
+      tx, cipherType, server ? serverKey : clientKey,
+      server ? serverSalt : clientSalt);
+  fillKTLSCryptoInfo(
+      rx, cipherType, server ? clientKey : serverKey,
+      server ? clientSalt : serverSalt);
+  SCOPE_EXIT {
+    OPENSSL_cleanse(&tx, sizeof(tx));
+    OPENSSL_cleanse(&rx, sizeof(rx));
+  };
+
+  if (folly::netops::setsockopt(fd, SOL_TLS, TLS_TX, &tx, sizeof(tx)) != 0) {
+    return false;
+  }
+  *rxInstalled =
+      folly::netops::setsockopt(fd, SOL_TLS, TLS_RX, &rx, sizeof(rx)) == 0;
+  return true;
+}
+#endif // FOLLY_SSL_KTLS
+
 } // namespace
 
 namespace folly {
@@ -327,12 +445,18 @@ void AsyncSSLSocket::init() {
 void AsyncSSLSocket::closeNow() {
   // Close the SSL connection.
   if (ssl_ != nullptr && fd_ != NetworkSocket() && !waitingOnAccept_) {
-    int rc = SSL_shutdown(ssl_.get());
-    if (rc == 0) {
-      rc = SSL_shutdown(ssl_.get());
-    }
-    if (rc < 0) {
-      ERR_clear_error();
+    if (ktlsTx_) {
+      // OpenSSL's write keys are stale, the kernel has to send the alert
+      sendKTLSCloseNotify();
+      SSL_set_shutdown(ssl_.get(), SSL_SENT_SHUTDOWN);
+    } else {
+      int rc = SSL_shutdown(ssl_.get());
+      if (rc == 0) {
+        rc = SSL_shutdown(ssl_.get());
+      }
+      if (rc < 0) {
+        ERR_clear_error();
+      }
     }
   }
 
@@ -680,6 +804,138 @@ void AsyncSSLSocket::invokeHandshakeCB() {
   }
 }
 
+void AsyncSSLSocket::enableKTLS() noexcept {
+#if FOLLY_SSL_KTLS
+  // Records OpenSSL has already read cannot be handed to the kernel.
+  if (SSL_version(ssl_.get()) != TLS1_2_VERSION ||
+      SSL_has_pending(ssl_.get())) {
+    return;
+  }
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl_.get());
+  if (cipher == nullptr) {
+    return;
+  }
+  // The TLS 1.2 AES-128-GCM suites use SHA-256 for the PRF, the AES-256-GCM
+  // ones SHA-384.
+  auto nid = SSL_CIPHER_get_cipher_nid(cipher);
+  if (nid != NID_aes_128_gcm && nid != NID_aes_256_gcm) {
+    return;
+  }
+  bool aes128 = nid == NID_aes_128_gcm;
+  size_t keyLen = aes128 ? TLS_CIPHER_AES_GCM_128_KEY_SIZE
+                         : TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+  std::array<
+      uint8_t,
+      2 * (TLS_CIPHER_AES_GCM_256_KEY_SIZE + TLS_CIPHER_AES_GCM_256_SALT_SIZE)>
+      keyBlock;
+  SCOPE_EXIT {
+    OPENSSL_cleanse(keyBlock.data(), keyBlock.size());
+  };
+  if (!deriveTLS12KeyBlock(
+          ssl_.get(),
+          aes128 ? EVP_sha256() : EVP_sha384(),
+          keyBlock.data(),
+          2 * (keyLen + TLS_CIPHER_AES_GCM_128_SALT_SIZE))) {
+    ERR_clear_error();
+    return;
+  }
+
+  static const char kULP[] = "tls";
+  if (netops::setsockopt(fd_, IPPROTO_TCP, TCP_ULP, kULP, sizeof(kULP)) != 0) {
+    VLOG(4) << "AsyncSSLSocket(this=" << this << ", fd=" << fd_
+            << "): kernel TLS unavailable, errno=" << errno;
+    return;
+  }
+  ktlsTx_ = aes128
+      ? installKTLSKeys<tls12_crypto_info_aes_gcm_128>(
+            fd_,
+            server_,
+            TLS_CIPHER_AES_GCM_128,
+            keyBlock.data(),
+            &ktlsRx_)
+      : installKTLSKeys<tls12_crypto_info_aes_gcm_256>(
+            fd_,
+            server_,
+            TLS_CIPHER_AES_GCM_256,
+            keyBlock.data(),
+            &ktlsRx_);
+  VLOG(3) << "AsyncSSLSocket(this=" << this << ", fd=" << fd_
+          << "): kernel TLS tx=" << ktlsTx_ << ", rx=" << ktlsRx_;
+#endif // FOLLY_SSL_KTLS
+}
+
+void AsyncSSLSocket::sendKTLSCloseNotify() noexcept {
+#if FOLLY_SSL_KTLS
+  uint8_t alert[2] = {kTLSAlertWarning, kTLSAlertCloseNotify};
+  iovec iov;
+  iov.iov_base = alert;
+  iov.iov_len = sizeof(alert);
+  char control[CMSG_SPACE(sizeof(uint8_t))] = {};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = kTLSRecordAlert;
+  // like SSL_shutdown() failures, this is best effort
+  netops::sendmsg(fd_, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif // FOLLY_SSL_KTLS
+}
+
+AsyncSocket::ReadResult
+AsyncSSLSocket::performKTLSRead(void** buf, size_t* buflen, size_t* offset) {
+  auto result = AsyncSocket::performRead(buf, buflen, offset);
+#if FOLLY_SSL_KTLS
+  if (result.readReturn != READ_ERROR || errno != EIO) {
+    return result;
+  }
+
+  // The next record is not application data, read it along with its type.
+  iovec iov;
+  iov.iov_base = *buf;
+  iov.iov_len = *buflen;
+  char control[CMSG_SPACE(sizeof(uint8_t))] = {};
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto bytes = netops::recvmsg(fd_, &msg, MSG_DONTWAIT);
+  if (bytes < 0) {
+    return ReadResult(
+        errno == EAGAIN || errno == EWOULDBLOCK ? READ_BLOCKING : READ_ERROR);
+  }
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == nullptr || cmsg->cmsg_level != SOL_TLS ||
+      cmsg->cmsg_type != TLS_GET_RECORD_TYPE) {
+    appBytesReceived_ += bytes;
+    return ReadResult(bytes);
+  }
+  auto recordType = *CMSG_DATA(cmsg);
+  if (recordType == kTLSRecordApplicationData) {
+    appBytesReceived_ += bytes;
+    return ReadResult(bytes);
+  }
+  auto data = static_cast<const uint8_t*>(*buf);
+  if (recordType == kTLSRecordAlert && bytes >= 2 &&
+      data[1] == kTLSAlertCloseNotify) {
+    return ReadResult(READ_EOF);
+  }
+  VLOG(3) << "AsyncSSLSocket(this=" << this << ", fd=" << fd_
+          << "): unexpected kernel TLS record type " << int(recordType);
+  return ReadResult(
+      READ_ERROR, std::make_unique<SSLException>(SSLError::SSL_ERROR));
+#else
+  return result;
+#endif // FOLLY_SSL_KTLS
+}
+
 void AsyncSSLSocket::connect(
     ConnectCallback* callback,
     const folly::SocketAddress& address,
@@ -1163,13 +1419,24 @@ void AsyncSSLSocket::handleAccept() noexcept {
   DCHECK(ctx_->sslAcceptRunner());
   updateEventRegistration(
       EventHandler::NONE, EventHandler::READ | EventHandler::WRITE);
+  // The runner may call back from another thread. The guard and the keep
+  // alive live in finallyFunc, and are only released in our thread.
   DelayedDestruction::DestructorGuard dg(this);
   ctx_->sslAcceptRunner()->run(
-      [this, dg]() {
+      [this]() {
         waitingOnAccept_ = true;
         return SSL_accept(ssl_.get());
       },
-      [this, dg](int ret) {
+      [this, dg = std::move(dg), ka = getKeepAliveToken(eventBase_)](
+          int ret) mutable {
+        if (!eventBase_->isInEventBaseThread()) {
+          eventBase_->runInEventBaseThread(
+              [this, dg = std::move(dg), ka = std::move(ka), ret]() {
+                waitingOnAccept_ = false;
+                handleReturnFromSSLAccept(ret);
+              });
+          return;
+        }
         waitingOnAccept_ = false;
         handleReturnFromSSLAccept(ret);
       });
@@ -1201,6 +1468,10 @@ void AsyncSSLSocket::handleReturnFromSSLAccept(int ret) {
   // STATE_ACCEPTING.
   sslState_ = STATE_ESTABLISHED;
 
+  if (ktlsEnabled_) {
+    enableKTLS();
+  }
+
   VLOG(3) << "AsyncSSLSocket " << this << ": fd " << fd_
           << " successfully accepted; state=" << int(state_)
           << ", sslState=" << sslState_ << ", events=" << eventFlags_;
@@ -1272,6 +1543,10 @@ void AsyncSSLSocket::handleConnect() noexcept {
   // STATE_CONNECTING.
   sslState_ = STATE_ESTABLISHED;
 
+  if (ktlsEnabled_) {
+    enableKTLS();
+  }
+
   VLOG(3) << "AsyncSSLSocket " << this << ": "
           << "fd " << fd_ << " successfully connected; "
           << "state=" << int(state_) << ", sslState=" << sslState_
@@ -1378,6 +1653,9 @@ AsyncSSLSocket::performRead(void** buf, size_t* buflen, size_t* offset) {
   if (sslState_ == STATE_UNENCRYPTED) {
     return AsyncSocket::performRead(buf, buflen, offset);
   }
+  if (ktlsRx_) {
+    return performKTLSRead(buf, buflen, offset);
+  }
 
   int numToRead = 0;
   if (*buflen > std::numeric_limits<int>::max()) {
@@ -1488,13 +1766,24 @@ AsyncSocket::WriteResult AsyncSSLSocket::interpretSSLError(int rc, int error) {
   }
 }
 
+AsyncSocket::WriteResult AsyncSSLSocket::performFileWrite(
+    int fd,
+    off_t offset,
+    size_t length,
+    WriteFlags flags) {
+  if (sslState_ == STATE_UNENCRYPTED || ktlsTx_) {
+    return AsyncSocket::performFileWrite(fd, offset, length, flags);
+  }
+  return performFileWriteCopy(fd, offset, length, flags);
+}
+
 AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
     const iovec* vec,
     uint32_t count,
     WriteFlags flags,
     uint32_t* countWritten,
     uint32_t* partialWritten) {
-  if (sslState_ == STATE_UNENCRYPTED) {
+  if (sslState_ == STATE_UNENCRYPTED || ktlsTx_) {
     return AsyncSocket::performWrite(
         vec, count, flags, countWritten, partialWritten);
   }
@@ -1519,6 +1808,14 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
     }
   };
 
+  // Each SSL_write() below produces a single record, so that the last one
+  // is known, and the records before it can be batched
+  const size_t recordSize = nextRecordSize();
+  const size_t minWriteSize = std::min(minWriteSize_, recordSize);
+  SCOPE_EXIT {
+    batchCurrentWrite_ = false;
+  };
+
   *countWritten = 0;
   *partialWritten = 0;
   ssize_t totalWritten = 0;
@@ -1538,7 +1835,7 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
     ssize_t bytes;
     uint32_t buffersStolen = 0;
     auto sslWriteBuf = buf;
-    if ((len < minWriteSize_) && ((i + 1) < count)) {
+    if ((len < minWriteSize) && ((i + 1) < count)) {
       // Combine this buffer with part or all of the next buffers in
       // order to avoid really small-grained calls to SSL_write().
       // Each call to SSL_write() produces a separate record in
@@ -1565,7 +1862,7 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
         // INVARIANT: i + buffersStolen == complete chunks serialized
         uint32_t nextIndex = i + buffersStolen + 1;
         bytesStolenFromNextBuffer =
-            std::min(vec[nextIndex].iov_len, minWriteSize_ - len);
+            std::min(vec[nextIndex].iov_len, minWriteSize - len);
         if (bytesStolenFromNextBuffer > 0) {
           assert(vec[nextIndex].iov_base != nullptr);
           ::memcpy(
@@ -1581,11 +1878,18 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
           bytesStolenFromNextBuffer = 0;
           buffersStolen++;
         }
-      } while ((i + buffersStolen + 1) < count && (len < minWriteSize_));
+      } while ((i + buffersStolen + 1) < count && (len < minWriteSize));
+    }
+
+    // Split buffers larger than a record, combined ones never are
+    bool splitBuffer = false;
+    if (len > recordSize) {
+      len = recordSize;
+      splitBuffer = true;
     }
 
     // Advance any empty buffers immediately after.
-    if (bytesStolenFromNextBuffer == 0) {
+    if (!splitBuffer && bytesStolenFromNextBuffer == 0) {
       while ((i + buffersStolen + 1) < count &&
              vec[i + buffersStolen + 1].iov_len == 0) {
         buffersStolen++;
@@ -1594,30 +1898,38 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
 
     // cork the current write if the original flags included CORK or if there
     // are remaining iovec to write
-    corkCurrentWrite_ =
-        isSet(flags, WriteFlags::CORK) || (i + buffersStolen + 1 < count);
+    bool moreRecords = splitBuffer || (i + buffersStolen + 1 < count);
+    corkCurrentWrite_ = isSet(flags, WriteFlags::CORK) || moreRecords;
+    batchCurrentWrite_ = batchRecordWrites_ && moreRecords;
 
     // track the EoR if:
     //  (1) there are write flags that require EoR tracking (EOR / TIMESTAMP_TX)
     //  (2) if the buffer includes the EOR byte
     appEorByteWriteFlags_ = flags & kEorRelevantWriteFlags;
     bool trackEor = appEorByteWriteFlags_ != folly::WriteFlags::NONE &&
-        (i + buffersStolen + 1 == count);
+        !moreRecords;
     bytes = eorAwareSSLWrite(ssl_, sslWriteBuf, int(len), trackEor);
 
     if (bytes <= 0) {
       int error = SSL_get_error(ssl_.get(), int(bytes));
       if (error == SSL_ERROR_WANT_WRITE) {
         // The caller will register for write event if not already.
+        // OpenSSL must be retried with the same record.
         *partialWritten = uint32_t(offset);
+        pendingRecordSize_ = recordSize;
         return WriteResult(totalWritten);
       }
       return interpretSSLError(int(bytes), error);
     }
 
+    pendingRecordSize_ = 0;
     totalWritten += bytes;
 
-    if (bytes == (ssize_t)len) {
+    if (bytes == (ssize_t)len && splitBuffer) {
+      // write the rest of this iovec next
+      bytesStolenFromNextBuffer = offset + len;
+      --i;
+    } else if (bytes == (ssize_t)len) {
       // The full iovec is written.
       (*countWritten) += 1 + buffersStolen;
       i += buffersStolen;
@@ -1640,6 +1952,30 @@ AsyncSocket::WriteResult AsyncSSLSocket::performWrite(
   return WriteResult(totalWritten);
 }
 
+size_t AsyncSSLSocket::nextRecordSize() {
+  if (pendingRecordSize_ != 0) {
+    // a retried SSL_write() must have the same length
+    return pendingRecordSize_;
+  }
+  if (!dynamicRecordSizing_) {
+    return kMaxRecordSize;
+  }
+  auto now = std::chrono::steady_clock::now();
+  // Not idle while writes wait for the socket to be writable
+  if (writeReqHead_ == nullptr &&
+      now - lastWriteTime_ > dynamicRecordSizing_->idleTimeout) {
+    // the congestion window may have shrunk while idle
+    dynamicRecordBytes_ = 0;
+  }
+  lastWriteTime_ = now;
+  if (dynamicRecordBytes_ >= dynamicRecordSizing_->threshold) {
+    return kMaxRecordSize;
+  }
+  return std::max(
+      size_t(1),
+      std::min(dynamicRecordSizing_->smallRecordSize, kMaxRecordSize));
+}
+
 int AsyncSSLSocket::eorAwareSSLWrite(
     const ssl::SSLUniquePtr& ssl,
     const void* buf,
@@ -1724,6 +2060,19 @@ int AsyncSSLSocket::bioWrite(BIO* b, const char* in, int inl) {
     flags |= WriteFlags::CORK;
   }
 
+  bool batch = tsslSock->batchCurrentWrite_;
+  auto& pendingRecords = tsslSock->pendingRecords_;
+  if (batch || !pendingRecords.empty()) {
+    // OpenSSL reuses its buffer for the next record
+    auto room = pendingRecords.preallocate(size_t(inl), kRecordBatchSize);
+    memcpy(room.first, in, size_t(inl));
+    pendingRecords.postallocate(size_t(inl));
+    if (batch && pendingRecords.chainLength() < kRecordBatchSize) {
+      BIO_clear_retry_flags(b);
+      return inl;
+    }
+  }
+
   int msg_flags = tsslSock->getSendMsgParamsCB()->getFlags(
       flags, false /*zeroCopyEnabled*/);
   msg.msg_controllen =
@@ -1736,9 +2085,16 @@ int AsyncSSLSocket::bioWrite(BIO* b, const char* in, int inl) {
     tsslSock->getSendMsgParamsCB()->getAncillaryData(flags, msg.msg_control);
   }
 
+  if (!pendingRecords.empty()) {
+    return tsslSock->flushRecords(b, inl, msg_flags, msg);
+  }
+
   auto result =
       tsslSock->sendSocketMessage(OpenSSLUtils::getBioFd(b), &msg, msg_flags);
   BIO_clear_retry_flags(b);
+  if (result.writeReturn > 0) {
+    tsslSock->dynamicRecordBytes_ += size_t(result.writeReturn);
+  }
   if (!result.exception && result.writeReturn <= 0) {
     if (OpenSSLUtils::getBioShouldRetryWrite(int(result.writeReturn))) {
       BIO_set_retry_write(b);
@@ -1747,6 +2103,56 @@ int AsyncSSLSocket::bioWrite(BIO* b, const char* in, int inl) {
   return int(result.writeReturn);
 }
 
+int AsyncSSLSocket::flushRecords(
+    BIO* b,
+    int inl,
+    int msgFlags,
+    const msghdr& control) {
+  iovec iov[kMaxRecordIovecs];
+  size_t iovCount = 0;
+  const IOBuf* head = pendingRecords_.front();
+  const IOBuf* buf = head;
+  do {
+    if (buf->length() != 0) {
+      iov[iovCount].iov_base = const_cast<uint8_t*>(buf->data());
+      iov[iovCount].iov_len = buf->length();
+      ++iovCount;
+    }
+    buf = buf->next();
+  } while (buf != head && iovCount < kMaxRecordIovecs);
+
+  msghdr msg = control;
+  msg.msg_iov = iov;
+  msg.msg_iovlen = iovCount;
+  auto result =
+      sendSocketMessage(OpenSSLUtils::getBioFd(b), &msg, msgFlags);
+  BIO_clear_retry_flags(b);
+  if (result.writeReturn < 0) {
+    // OpenSSL retries the last record, the others are ours to send
+    pendingRecords_.trimEnd(size_t(inl));
+    if (!result.exception &&
+        OpenSSLUtils::getBioShouldRetryWrite(int(result.writeReturn))) {
+      BIO_set_retry_write(b);
+    }
+    return int(result.writeReturn);
+  }
+
+  dynamicRecordBytes_ += size_t(result.writeReturn);
+  pendingRecords_.trimStart(size_t(result.writeReturn));
+  size_t unsent = pendingRecords_.chainLength();
+  if (unsent == 0) {
+    return inl;
+  }
+  if (unsent < size_t(inl)) {
+    // everything before the last record was sent
+    pendingRecords_.trimEnd(unsent);
+    return inl - int(unsent);
+  }
+  pendingRecords_.trimEnd(size_t(inl));
+  BIO_set_retry_write(b);
+  return -1;
+}
+
 int AsyncSSLSocket::bioRead(BIO* b, char* out, int outl) {
   if (!out) {
     return 0;
@@ -1771,6 +2177,8 @@ int AsyncSSLSocket::bioRead(BIO* b, char* out, int outl) {
     return static_cast<int>(len);
   } else {
     auto result = int(netops::recv(OpenSSLUtils::getBioFd(b), out, outl, 0));
+    sslSock->recordRead(
+        result, result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
     if (result <= 0 && OpenSSLUtils::getBioShouldRetryWrite(result)) {
       BIO_set_retry_read(b);
     }
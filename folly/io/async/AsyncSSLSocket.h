@@ -22,6 +22,7 @@
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncPipe.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTimeout.h>
@@ -728,6 +729,67 @@ class AsyncSSLSocket : public virtual AsyncSocket {
     return minWriteSize_;
   }
 
+  /**
+   * Sizes of the TLS records that application data is split into.
+   *
+   * A record can only be decrypted once all of it has arrived, so while the
+   * TCP congestion window is small, a 16KB record spanning several round
+   * trips delays the first bytes the peer can use. With dynamic record
+   * sizing, records fit in a single TCP segment until threshold bytes have
+   * been sent to the socket, and again after no write was pending for
+   * idleTimeout, and are as large as TLS allows otherwise.
+   */
+  struct DynamicRecordSizing {
+    // Fits a 1500 byte MTU with the IPv6, TCP (with timestamps) and TLS
+    // overhead
+    size_t smallRecordSize{1369};
+    size_t threshold{1024 * 1024};
+    std::chrono::milliseconds idleTimeout{1000};
+  };
+
+  void setDynamicRecordSizing(Optional<DynamicRecordSizing> sizing) {
+    dynamicRecordSizing_ = std::move(sizing);
+    dynamicRecordBytes_ = 0;
+  }
+
+  const Optional<DynamicRecordSizing>& getDynamicRecordSizing() const {
+    return dynamicRecordSizing_;
+  }
+
+  /**
+   * Whether the records encrypted by one write are sent to the socket with
+   * a single sendmsg(), instead of one sendmsg() per record. On by default.
+   */
+  void setBatchRecordWrites(bool batch) {
+    batchRecordWrites_ = batch;
+  }
+
+  bool getBatchRecordWrites() const {
+    return batchRecordWrites_;
+  }
+
+  /**
+   * Hand the record layer to kernel TLS once the handshake completes.
+   *
+   * The negotiated keys are installed with TLS_TX/TLS_RX and application
+   * data then goes through the plain AsyncSocket read and write paths, so
+   * MSG_ZEROCOPY writes work and no copy is made to encrypt in userspace.
+   * Only TLS 1.2 AES-GCM connections on Linux can be offloaded; otherwise
+   * (or if the kernel refuses) the socket keeps using OpenSSL. Must be set
+   * before the handshake starts.
+   */
+  void setKTLSEnabled(bool enabled) {
+    ktlsEnabled_ = enabled;
+  }
+
+  /**
+   * Whether the record layer is handled by kernel TLS. Old kernels can only
+   * offload writes, in which case reads still go through OpenSSL.
+   */
+  bool isKTLSActive() const {
+    return ktlsTx_;
+  }
+
   const AsyncTransportCertificate* getPeerCertificate() const override;
   const AsyncTransportCertificate* getSelfCertificate() const override;
 
@@ -819,6 +881,18 @@ class AsyncSSLSocket : public virtual AsyncSocket {
       uint32_t* countWritten,
       uint32_t* partialWritten) override;
 
+  // without kernel TLS the file has to be encrypted by OpenSSL
+  WriteResult performFileWrite(
+      int fd,
+      off_t offset,
+      size_t length,
+      WriteFlags flags) override;
+
+  // the bytes on the wire are TLS records, not the application data
+  bool asyncIoDataPassthrough() const override {
+    return false;
+  }
+
   ssize_t performWriteIovec(
       const iovec* vec,
       uint32_t count,
@@ -875,10 +949,29 @@ class AsyncSSLSocket : public virtual AsyncSocket {
 
   void startSSLConnect();
 
+  // Moves the record layer to kernel TLS, see setKTLSEnabled().
+  void enableKTLS() noexcept;
+  ReadResult performKTLSRead(void** buf, size_t* buflen, size_t* offset);
+  void sendKTLSCloseNotify() noexcept;
+
   static void sslInfoCallback(const SSL* ssl, int type, int val);
 
+  // Size of the records of the next write, see DynamicRecordSizing
+  size_t nextRecordSize();
+  // Sends the batched records, ending with the one OpenSSL is writing, see
+  // bioWrite()
+  int flushRecords(BIO* b, int inl, int msgFlags, const msghdr& control);
+
   // Whether the current write to the socket should use MSG_MORE.
   bool corkCurrentWrite_{false};
+  // Whether more records of the current performWrite() follow, so that the
+  // current one can wait in pendingRecords_
+  bool batchCurrentWrite_{false};
+  bool batchRecordWrites_{true};
+  // Records OpenSSL considers written but that have not been sent yet: those
+  // batched by the current performWrite(), or the unsent part of earlier
+  // ones while OpenSSL retries the write of the last one.
+  IOBufQueue pendingRecords_{IOBufQueue::cacheChainLength()};
   // SSL related members.
   bool server_{false};
   // Used to prevent client-initiated renegotiation.  Note that AsyncSSLSocket
@@ -917,6 +1010,13 @@ class AsyncSSLSocket : public virtual AsyncSocket {
   // It doesn't take effect when it is 0.
   size_t minWriteSize_{1500};
 
+  Optional<DynamicRecordSizing> dynamicRecordSizing_;
+  // Bytes sent to the socket (records included) since the last reset
+  size_t dynamicRecordBytes_{0};
+  std::chrono::steady_clock::time_point lastWriteTime_;
+  // Record size of the SSL_write() that OpenSSL is waiting to retry, or 0
+  size_t pendingRecordSize_{0};
+
   // When openssl is about to sendmsg() across the minEorRawBytesNo_,
   // it will trigger logic to include an application defined control message.
   //
@@ -957,6 +1057,10 @@ class AsyncSSLSocket : public virtual AsyncSocket {
   std::unique_ptr<ReadCallback> asyncOperationFinishCallback_;
   // Whether this socket is currently waiting on SSL_accept
   bool waitingOnAccept_{false};
+  bool ktlsEnabled_{false};
+  // Directions whose records are processed by the kernel.
+  bool ktlsTx_{false};
+  bool ktlsRx_{false};
 };
 
 } // namespace folly
@@ -34,6 +34,11 @@
 #include <sys/types.h>
 #include <cerrno>
 #include <cstring>
+#include <limits>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
 
 namespace folly {
 
@@ -45,6 +50,10 @@ namespace folly {
 #define TCP_SAVED_SYN 28
 #endif
 
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
 static constexpr bool msgErrQueueSupported =
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
     true;
@@ -189,7 +198,7 @@ int AsyncServerSocket::stopAccepting(int shutdownFlags) {
   // second because it hasn't been closed yet.
   for (; !sockets_.empty(); sockets_.pop_back()) {
     auto& handler = sockets_.back();
-    handler.unregisterHandler();
+    unregisterAcceptHandler(handler);
     if (const auto shutdownSocketSet = wShutdownSocketSet_.lock()) {
       shutdownSocketSet->close(handler.socket_);
     } else if (shutdownFlags >= 0) {
@@ -203,6 +212,8 @@ int AsyncServerSocket::stopAccepting(int shutdownFlags) {
   // Destroy the backoff timout.  This will cancel it if it is running.
   delete backoffTimeout_;
   backoffTimeout_ = nullptr;
+  overloaded_ = false;
+  overloadTimeout_.reset();
 
   // Close all of the callback queues to notify them that they are being
   // destroyed.  No one should access the AsyncServerSocket any more once
@@ -675,7 +686,7 @@ void AsyncServerSocket::removeAcceptCallback(
   // was removed, unregister for events until a callback is added.
   if (accepting_ && callbacks_.empty()) {
     for (auto& handler : sockets_) {
-      handler.unregisterHandler();
+      unregisterAcceptHandler(handler);
     }
   }
 }
@@ -691,9 +702,13 @@ void AsyncServerSocket::startAccepting() {
     // Wait until a callback is added to start accepting.
     return;
   }
+  if (overloaded_) {
+    // overloadTimeoutExpired() re-registers once the callbacks catch up
+    return;
+  }
 
   for (auto& handler : sockets_) {
-    if (!handler.registerHandler(EventHandler::READ | EventHandler::PERSIST)) {
+    if (!registerAcceptHandler(handler)) {
       throw std::runtime_error("failed to register for accept events");
     }
   }
@@ -705,13 +720,16 @@ void AsyncServerSocket::pauseAccepting() {
   }
   accepting_ = false;
   for (auto& handler : sockets_) {
-    handler.unregisterHandler();
+    unregisterAcceptHandler(handler);
   }
 
   // If we were in the accept backoff state, disable the backoff timeout
   if (backoffTimeout_) {
     backoffTimeout_->cancelTimeout();
   }
+  // Same for the overload state; this one is bound to the EventBase
+  overloaded_ = false;
+  overloadTimeout_.reset();
 }
 
 NetworkSocket AsyncServerSocket::createSocket(int family) {
@@ -758,6 +776,55 @@ void AsyncServerSocket::setTosReflect(bool enable) {
   tosReflect_ = true;
 }
 
+void AsyncServerSocket::setReusePortCpuRouting(uint32_t groupSize) {
+  if (groupSize == 0) {
+    throw std::invalid_argument("reuse port group size must be positive");
+  }
+  if (!reusePortEnabled_) {
+    throw std::logic_error("CPU routing requires SO_REUSEPORT");
+  }
+#ifdef __linux__
+  // A = cpu % groupSize; return A
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, groupSize},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+
+  for (auto& handler : sockets_) {
+    if (handler.socket_ == NetworkSocket()) {
+      continue;
+    }
+    if (netops::setsockopt(
+            handler.socket_,
+            SOL_SOCKET,
+            SO_ATTACH_REUSEPORT_CBPF,
+            &prog,
+            sizeof(prog)) != 0) {
+      folly::throwSystemError(errno, "failed to attach reuse port program");
+    }
+  }
+#else
+  folly::throwSystemErrorExplicit(
+      ENOTSUP, "reuse port CPU routing is not supported on this platform");
+#endif
+}
+
+void AsyncServerSocket::setOverloadLimits(
+    std::chrono::microseconds maxLoopTime,
+    uint32_t maxQueueDepth,
+    std::chrono::milliseconds checkInterval) {
+  if (eventBase_) {
+    eventBase_->dcheckIsInEventBaseThread();
+  }
+  overloadMaxLoopTime_ = maxLoopTime;
+  overloadMaxQueueDepth_ = maxQueueDepth;
+  overloadCheckInterval_ = checkInterval;
+}
+
 void AsyncServerSocket::setupSocket(NetworkSocket fd, int family) {
   // Put the socket in non-blocking mode
   if (netops::set_socket_non_blocking(fd) != 0) {
@@ -844,6 +911,117 @@ void AsyncServerSocket::setupSocket(NetworkSocket fd, int family) {
   }
 }
 
+bool AsyncServerSocket::registerAcceptHandler(ServerEventHandler& handler) {
+  if (startAsyncAccept(handler)) {
+    return true;
+  }
+  return handler.registerHandler(EventHandler::READ | EventHandler::PERSIST);
+}
+
+void AsyncServerSocket::unregisterAcceptHandler(ServerEventHandler& handler) {
+  if (handler.asyncAccept_) {
+    // connections the op still completes with are closed
+    auto state = std::move(handler.asyncAccept_);
+    state->parent = nullptr;
+    if (state->op) {
+      eventBase_->getBackend()->eb_cancel_op(state->op);
+    }
+  }
+  handler.unregisterHandler();
+}
+
+bool AsyncServerSocket::startAsyncAccept(ServerEventHandler& handler) {
+  if (handler.asyncAccept_) {
+    return true;
+  }
+
+  auto* backend = eventBase_ ? eventBase_->getBackend() : nullptr;
+  if (!asyncAcceptSupported_ || !backend ||
+      !backend->eb_async_io_supported()) {
+    return false;
+  }
+
+#if FOLLY_HAVE_ACCEPT4
+  int flags = SOCK_NONBLOCK;
+#else
+  int flags = 0;
+#endif
+  auto state = std::make_shared<AsyncAcceptState>();
+  state->parent = this;
+  state->socket = handler.socket_;
+  state->op = backend->eb_queue_accept_multishot(
+      handler.socket_.toFd(), flags, [state](int res, bool more) {
+        if (!more) {
+          state->op = nullptr;
+        }
+        if (state->parent) {
+          state->parent->asyncAcceptReady(*state, res, more);
+        } else if (res >= 0) {
+          closeNoInt(NetworkSocket::fromFd(res));
+        }
+      });
+  if (!state->op) {
+    return false;
+  }
+
+  handler.asyncAccept_ = std::move(state);
+  return true;
+}
+
+void AsyncServerSocket::asyncAcceptReady(
+    AsyncAcceptState& state,
+    int res,
+    bool more) noexcept {
+  DestructorGuard dg(this);
+
+  ServerEventHandler* handler = nullptr;
+  for (auto& h : sockets_) {
+    if (h.asyncAccept_.get() == &state) {
+      handler = &h;
+      break;
+    }
+  }
+  if (!handler) {
+    if (res >= 0) {
+      closeNoInt(NetworkSocket::fromFd(res));
+    }
+    return;
+  }
+
+  if (res == -EINVAL && !more && !state.accepted) {
+    // the kernel does not support multishot accept
+    VLOG(4) << "multishot accept not supported, falling back to accept()";
+    asyncAcceptSupported_ = false;
+  } else if (res != -ECANCELED) {
+    SocketAddress address;
+    NetworkSocket clientSocket;
+    int acceptErrno = 0;
+    if (res >= 0) {
+      state.accepted = true;
+      clientSocket = NetworkSocket::fromFd(res);
+      try {
+        address.setFromPeerAddress(clientSocket);
+      } catch (const std::system_error&) {
+        // the peer is already gone, let the callback find out
+      }
+    } else {
+      acceptErrno = -res;
+    }
+    processAccept(clientSocket, acceptErrno, address, handler->addressFamily_);
+  }
+
+  // the op ended while we still want to accept - start over; this might
+  // have been unregistered by the callbacks, or by an accept error
+  if (!more && state.parent) {
+    state.parent = nullptr;
+    handler->asyncAccept_.reset();
+    if (accepting_ && !callbacks_.empty() &&
+        !registerAcceptHandler(*handler)) {
+      dispatchError("failed to register for accept events", errno);
+    }
+  }
+}
+
 void AsyncServerSocket::handlerReady(
     uint16_t /* events */,
     NetworkSocket fd,
@@ -873,126 +1051,163 @@ void AsyncServerSocket::handlerReady(
 #else
     auto clientSocket = netops::accept(fd, saddr, &addrLen);
 #endif
+    int acceptErrno = errno;
 
     address.setFromSockaddr(saddr, addrLen);
 
-    if (clientSocket != NetworkSocket() && connectionEventCallback_) {
-      connectionEventCallback_->onConnectionAccepted(clientSocket, address);
+    if (!processAccept(clientSocket, acceptErrno, address, addressFamily)) {
+      break;
     }
+  }
+}
 
-    // Connection accepted, get the SYN packet from the client if
-    // TOS reflect is enabled
-    if (kIsLinux && clientSocket != NetworkSocket() && tosReflect_) {
-      std::array<uint32_t, 64> buffer;
-      socklen_t len = sizeof(buffer);
-      int ret = netops::getsockopt(
-          clientSocket, IPPROTO_TCP, TCP_SAVED_SYN, &buffer, &len);
-
-      if (ret == 0) {
-        uint32_t tosWord = folly::Endian::big(buffer[0]);
-        if (addressFamily == AF_INET6) {
-          tosWord = (tosWord & 0x0FC00000) >> 20;
-          // Set the TOS on the return socket only if it is non-zero
-          if (tosWord) {
-            ret = netops::setsockopt(
-                clientSocket,
-                IPPROTO_IPV6,
-                IPV6_TCLASS,
-                &tosWord,
-                sizeof(tosWord));
-          }
-        } else if (addressFamily == AF_INET) {
-          tosWord = (tosWord & 0x00FC0000) >> 16;
-          if (tosWord) {
-            ret = netops::setsockopt(
-                clientSocket, IPPROTO_IP, IP_TOS, &tosWord, sizeof(tosWord));
-          }
-        }
+bool AsyncServerSocket::processAccept(
+    NetworkSocket clientSocket,
+    int acceptErrno,
+    SocketAddress& address,
+    sa_family_t addressFamily) noexcept {
+  if (clientSocket != NetworkSocket() && connectionEventCallback_) {
+    connectionEventCallback_->onConnectionAccepted(clientSocket, address);
+  }
 
-        if (ret != 0) {
-          LOG(ERROR) << "Unable to set TOS for accepted socket "
-                     << clientSocket;
+  // Connection accepted, get the SYN packet from the client if
+  // TOS reflect is enabled
+  if (kIsLinux && clientSocket != NetworkSocket() && tosReflect_) {
+    std::array<uint32_t, 64> buffer;
+    socklen_t len = sizeof(buffer);
+    int ret = netops::getsockopt(
+        clientSocket, IPPROTO_TCP, TCP_SAVED_SYN, &buffer, &len);
+
+    if (ret == 0) {
+      uint32_t tosWord = folly::Endian::big(buffer[0]);
+      if (addressFamily == AF_INET6) {
+        tosWord = (tosWord & 0x0FC00000) >> 20;
+        // Set the TOS on the return socket only if it is non-zero
+        if (tosWord) {
+          ret = netops::setsockopt(
+              clientSocket,
+              IPPROTO_IPV6,
+              IPV6_TCLASS,
+              &tosWord,
+              sizeof(tosWord));
+        }
+      } else if (addressFamily == AF_INET) {
+        tosWord = (tosWord & 0x00FC0000) >> 16;
+        if (tosWord) {
+          ret = netops::setsockopt(
+              clientSocket, IPPROTO_IP, IP_TOS, &tosWord, sizeof(tosWord));
         }
-      } else {
-        LOG(ERROR) << "Unable to get SYN packet for accepted socket "
-                   << clientSocket;
       }
+
+      if (ret != 0) {
+        LOG(ERROR) << "Unable to set TOS for accepted socket " << clientSocket;
+      }
+    } else {
+      LOG(ERROR) << "Unable to get SYN packet for accepted socket "
+                 << clientSocket;
     }
+  }
 
-    std::chrono::time_point<std::chrono::steady_clock> nowMs =
-        std::chrono::steady_clock::now();
-    auto timeSinceLastAccept = std::max<int64_t>(
-        0,
-        nowMs.time_since_epoch().count() -
-            lastAccepTimestamp_.time_since_epoch().count());
-    lastAccepTimestamp_ = nowMs;
-    if (acceptRate_ < 1) {
-      acceptRate_ *= 1 + acceptRateAdjustSpeed_ * timeSinceLastAccept;
-      if (acceptRate_ >= 1) {
-        acceptRate_ = 1;
-      } else if (rand() > acceptRate_ * RAND_MAX) {
-        ++numDroppedConnections_;
-        if (clientSocket != NetworkSocket()) {
-          closeNoInt(clientSocket);
-          if (connectionEventCallback_) {
-            connectionEventCallback_->onConnectionDropped(
-                clientSocket, address);
-          }
+  std::chrono::time_point<std::chrono::steady_clock> nowMs =
+      std::chrono::steady_clock::now();
+  auto timeSinceLastAccept = std::max<int64_t>(
+      0,
+      nowMs.time_since_epoch().count() -
+          lastAccepTimestamp_.time_since_epoch().count());
+  lastAccepTimestamp_ = nowMs;
+  if (acceptRate_ < 1) {
+    acceptRate_ *= 1 + acceptRateAdjustSpeed_ * timeSinceLastAccept;
+    if (acceptRate_ >= 1) {
+      acceptRate_ = 1;
+    } else if (rand() > acceptRate_ * RAND_MAX) {
+      ++numDroppedConnections_;
+      if (clientSocket != NetworkSocket()) {
+        closeNoInt(clientSocket);
+        if (connectionEventCallback_) {
+          connectionEventCallback_->onConnectionDropped(clientSocket, address);
         }
-        continue;
       }
+      return true;
     }
+  }
 
-    if (clientSocket == NetworkSocket()) {
-      if (errno == EAGAIN) {
-        // No more sockets to accept right now.
-        // Check for this code first, since it's the most common.
-        return;
-      } else if (errno == EMFILE || errno == ENFILE) {
-        // We're out of file descriptors.  Perhaps we're accepting connections
-        // too quickly. Pause accepting briefly to back off and give the server
-        // a chance to recover.
-        LOG(ERROR) << "accept failed: out of file descriptors; entering accept "
-                      "back-off state";
-        enterBackoff();
-
-        // Dispatch the error message
-        dispatchError("accept() failed", errno);
-      } else {
-        dispatchError("accept() failed", errno);
-      }
-      if (connectionEventCallback_) {
-        connectionEventCallback_->onConnectionAcceptError(errno);
-      }
-      return;
+  if (clientSocket == NetworkSocket()) {
+    if (acceptErrno == EAGAIN) {
+      // No more sockets to accept right now.
+      // Check for this code first, since it's the most common.
+      return false;
+    } else if (acceptErrno == EMFILE || acceptErrno == ENFILE) {
+      // We're out of file descriptors.  Perhaps we're accepting connections
+      // too quickly. Pause accepting briefly to back off and give the server
+      // a chance to recover.
+      LOG(ERROR) << "accept failed: out of file descriptors; entering accept "
+                    "back-off state";
+      enterBackoff();
+
+      // Dispatch the error message
+      dispatchError("accept() failed", acceptErrno);
+    } else {
+      dispatchError("accept() failed", acceptErrno);
+    }
+    if (connectionEventCallback_) {
+      connectionEventCallback_->onConnectionAcceptError(acceptErrno);
     }
+    return false;
+  }
 
 #if !FOLLY_HAVE_ACCEPT4
-    // Explicitly set the new connection to non-blocking mode
-    if (netops::set_socket_non_blocking(clientSocket) != 0) {
-      closeNoInt(clientSocket);
-      dispatchError(
-          "failed to set accepted socket to non-blocking mode", errno);
-      if (connectionEventCallback_) {
-        connectionEventCallback_->onConnectionDropped(clientSocket, address);
-      }
-      return;
+  // Explicitly set the new connection to non-blocking mode
+  if (netops::set_socket_non_blocking(clientSocket) != 0) {
+    closeNoInt(clientSocket);
+    dispatchError("failed to set accepted socket to non-blocking mode", errno);
+    if (connectionEventCallback_) {
+      connectionEventCallback_->onConnectionDropped(clientSocket, address);
     }
+    return false;
+  }
 #endif
 
-    // Inform the callback about the new connection
-    dispatchSocket(clientSocket, std::move(address));
+  // Inform the callback about the new connection
+  dispatchSocket(clientSocket, std::move(address));
 
-    // If we aren't accepting any more, break out of the loop
-    if (!accepting_ || callbacks_.empty()) {
-      break;
+  // If we aren't accepting any more, break out of the loop
+  return accepting_ && !overloaded_ && !callbacks_.empty();
+}
+
+uint32_t AsyncServerSocket::pickCallbackIndex() const {
+  // Scan from the round-robin position so that ties rotate.
+  uint32_t best = callbackIndex_;
+  uint64_t bestLoad = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 0; i < callbacks_.size(); ++i) {
+    auto idx = uint32_t((callbackIndex_ + i) % callbacks_.size());
+    const auto& info = callbacks_[idx];
+    uint64_t load = info.consumer ? info.consumer->getQueue()->size() : 0;
+    if (dispatchPolicy_ == DispatchPolicy::LEAST_CONNECTIONS) {
+      load += info.callback->getActiveConnectionCount();
+    }
+    if (load < bestLoad) {
+      best = idx;
+      bestLoad = load;
+      if (load == 0) {
+        break;
+      }
     }
   }
+  return best;
 }
 
 void AsyncServerSocket::dispatchSocket(
     NetworkSocket socket,
     SocketAddress&& address) {
+  if (dispatchPolicy_ != DispatchPolicy::ROUND_ROBIN) {
+    callbackIndex_ = pickCallbackIndex();
+  }
+  // This connection is still handed out; the following ones wait in the
+  // listen backlog until the callbacks catch up.
+  if ((overloadMaxLoopTime_.count() > 0 || overloadMaxQueueDepth_ > 0) &&
+      allCallbacksOverloaded()) {
+    enterOverload();
+  }
   uint32_t startingIndex = callbackIndex_;
 
   // Short circuit if the callback is in the primary EventBase thread
@@ -1132,13 +1347,81 @@ void AsyncServerSocket::enterBackoff() {
   // Go ahead and disable accepts for now.  We leave accepting_ set to true,
   // since that tracks the desired state requested by the user.
   for (auto& handler : sockets_) {
-    handler.unregisterHandler();
+    unregisterAcceptHandler(handler);
   }
   if (connectionEventCallback_) {
     connectionEventCallback_->onBackoffStarted();
   }
 }
 
+bool AsyncServerSocket::isOverloaded(const CallbackInfo& info) const {
+  if (overloadMaxQueueDepth_ > 0 && info.consumer &&
+      info.consumer->getQueue()->size() > overloadMaxQueueDepth_) {
+    return true;
+  }
+  auto* evb = info.eventBase ? info.eventBase : eventBase_;
+  return overloadMaxLoopTime_.count() > 0 && evb &&
+      evb->getAvgLoopTimeRelaxed() > double(overloadMaxLoopTime_.count());
+}
+
+bool AsyncServerSocket::allCallbacksOverloaded() const {
+  for (const auto& info : callbacks_) {
+    if (!isOverloaded(info)) {
+      return false;
+    }
+  }
+  return !callbacks_.empty();
+}
+
+void AsyncServerSocket::enterOverload() {
+  if (overloaded_) {
+    return;
+  }
+  if (!overloadTimeout_) {
+    overloadTimeout_ = AsyncTimeout::make(
+        *eventBase_, [this]() noexcept { overloadTimeoutExpired(); });
+  }
+  overloadTimeout_->scheduleTimeout(overloadCheckInterval_);
+  overloaded_ = true;
+
+  // As with the backoff state, accepting_ stays set.
+  for (auto& handler : sockets_) {
+    unregisterAcceptHandler(handler);
+  }
+  if (connectionEventCallback_) {
+    connectionEventCallback_->onOverloadStarted();
+  }
+}
+
+void AsyncServerSocket::overloadTimeoutExpired() {
+  assert(accepting_);
+  assert(eventBase_ != nullptr);
+  eventBase_->dcheckIsInEventBaseThread();
+
+  if (allCallbacksOverloaded()) {
+    overloadTimeout_->scheduleTimeout(overloadCheckInterval_);
+    return;
+  }
+  overloaded_ = false;
+
+  // Leave it to the backoff timeout if it is still pending, and to
+  // addAcceptCallback() if there are no callbacks left.
+  bool inBackoff = backoffTimeout_ && backoffTimeout_->isScheduled();
+  if (!inBackoff && !callbacks_.empty()) {
+    for (auto& handler : sockets_) {
+      if (!registerAcceptHandler(handler)) {
+        // see backoffTimeoutExpired()
+        LOG(ERROR) << "failed to re-enable AsyncServerSocket accepts after "
+                   << "overload; crashing now";
+        abort();
+      }
+    }
+  }
+  if (connectionEventCallback_) {
+    connectionEventCallback_->onOverloadEnded();
+  }
+}
+
 void AsyncServerSocket::backoffTimeoutExpired() {
   // accepting_ should still be true.
   // If pauseAccepting() was called while in the backoff state it will cancel
@@ -1158,7 +1441,7 @@ void AsyncServerSocket::backoffTimeoutExpired() {
 
   // Register the handler.
   for (auto& handler : sockets_) {
-    if (!handler.registerHandler(EventHandler::READ | EventHandler::PERSIST)) {
+    if (!registerAcceptHandler(handler)) {
       // We're hosed.  We could just re-schedule backoffTimeout_ to
       // re-try again after a little bit.  However, we don't want to
       // loop retrying forever if we can't re-enable accepts.  Just
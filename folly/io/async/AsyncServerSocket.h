@@ -135,6 +135,19 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
      * onBackoffError is called when there is an error entering backoff
      */
     virtual void onBackoffError() noexcept = 0;
+
+    /**
+     * onOverloadStarted is called when the socket stops accepting because
+     * the EventBases of all accept callbacks are over the overload limits.
+     * See setOverloadLimits().
+     */
+    virtual void onOverloadStarted() noexcept {}
+
+    /**
+     * onOverloadEnded is called when one of them is below the limits again
+     * and accepting resumes.
+     */
+    virtual void onOverloadEnded() noexcept {}
   };
 
   class AcceptCallback {
@@ -204,6 +217,32 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
      * after acceptStopped() is invoked.
      */
     virtual void acceptStopped() noexcept {}
+
+    /**
+     * Number of connections this callback is currently serving, used by the
+     * LEAST_CONNECTIONS dispatch policy.
+     *
+     * This is called from the AsyncServerSocket's primary EventBase thread,
+     * not the callback's, so it must be thread-safe.
+     */
+    virtual uint64_t getActiveConnectionCount() const noexcept {
+      return 0;
+    }
+  };
+
+  /**
+   * How accepted connections are spread across the accept callbacks.
+   *
+   * Whatever the policy, a connection that cannot be enqueued for the chosen
+   * callback goes to the next one in round-robin order.
+   */
+  enum class DispatchPolicy {
+    // Each connection goes to the next callback.
+    ROUND_ROBIN,
+    // Fewest getActiveConnectionCount() plus connections still queued.
+    LEAST_CONNECTIONS,
+    // Fewest connections waiting in the callback's notification queue.
+    QUEUE_DEPTH,
   };
 
   static const uint32_t kDefaultMaxAcceptAtOnce = 30;
@@ -406,11 +445,11 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
    * Add an AcceptCallback.
    *
    * When a new socket is accepted, one of the AcceptCallbacks will be invoked
-   * with the new socket.  The AcceptCallbacks are invoked in a round-robin
-   * fashion.  This allows the accepted sockets to be distributed among a pool
-   * of threads, each running its own EventBase object.  This is a common model,
-   * since most asynchronous-style servers typically run one EventBase thread
-   * per CPU.
+   * with the new socket.  By default the AcceptCallbacks are invoked in a
+   * round-robin fashion, see setDispatchPolicy().  This allows the accepted
+   * sockets to be distributed among a pool of threads, each running its own
+   * EventBase object.  This is a common model, since most asynchronous-style
+   * servers typically run one EventBase thread per CPU.
    *
    * The EventBase object associated with each AcceptCallback must be running
    * its loop.  If the EventBase loop is not running, sockets will still be
@@ -565,6 +604,43 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
     maxNumMsgsInQueue_ = num;
   }
 
+  /**
+   * Set how accepted connections are distributed among the callbacks. Ties
+   * are broken round-robin.
+   *
+   * The non-default policies look at every callback for each connection.
+   */
+  void setDispatchPolicy(DispatchPolicy policy) {
+    dispatchPolicy_ = policy;
+  }
+
+  DispatchPolicy getDispatchPolicy() const {
+    return dispatchPolicy_;
+  }
+
+  /**
+   * Stop accepting while the EventBase of every accept callback is
+   * overloaded: its average loop time (see
+   * EventBase::getAvgLoopTimeRelaxed(), which requires time measurement)
+   * is above maxLoopTime, or more than maxQueueDepth accepted connections
+   * are waiting for it. New connections then stay in the listen backlog.
+   *
+   * While overloaded the EventBases are checked every checkInterval, and
+   * accepting resumes as soon as one of them is below both limits. A zero
+   * limit disables that check; both zero turns this off.
+   */
+  void setOverloadLimits(
+      std::chrono::microseconds maxLoopTime,
+      uint32_t maxQueueDepth,
+      std::chrono::milliseconds checkInterval = std::chrono::milliseconds(10));
+
+  /**
+   * Whether accepting is currently paused by the overload limits.
+   */
+  bool isOverloaded() const {
+    return overloaded_;
+  }
+
   /**
    * Get the speed of adjusting connection accept rate.
    */
@@ -680,6 +756,20 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
     return reusePortEnabled_;
   }
 
+  /**
+   * Route each new connection of the SO_REUSEPORT group to the socket whose
+   * index matches the CPU that received it, modulo groupSize. The index is
+   * the order in which the group's sockets were bound, so binding one
+   * AsyncServerSocket per IO thread in CPU order, with each thread pinned to
+   * its CPU, makes connections land on the core that processed their
+   * packets.
+   *
+   * This attaches a classic BPF program to the group (Linux 4.5+) and
+   * applies to every socket in it. Must be called after bind(); reuse port
+   * must be enabled. Throws on error.
+   */
+  void setReusePortCpuRouting(uint32_t groupSize);
+
   /**
    * Set whether or not the socket should close during exec() (FD_CLOEXEC). By
    * default, this is enabled
@@ -807,6 +897,14 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
       NetworkSocket socket,
       sa_family_t family) noexcept;
 
+  // Returns false if the caller should stop accepting for now. acceptErrno
+  // is only looked at if the accept failed.
+  bool processAccept(
+      NetworkSocket clientSocket,
+      int acceptErrno,
+      SocketAddress& address,
+      sa_family_t addressFamily) noexcept;
+
   NetworkSocket createSocket(int family);
   void setupSocket(NetworkSocket fd, int family);
   void bindSocket(
@@ -817,6 +915,13 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
   void dispatchError(const char* msg, int errnoValue);
   void enterBackoff();
   void backoffTimeoutExpired();
+  bool isOverloaded(const CallbackInfo& info) const;
+  bool allCallbacksOverloaded() const;
+  void enterOverload();
+  void overloadTimeoutExpired();
+
+  // Index of the callback the dispatch policy picks for a new connection.
+  uint32_t pickCallbackIndex() const;
 
   CallbackInfo* nextCallback() {
     CallbackInfo* info = &callbacks_[callbackIndex_];
@@ -829,6 +934,24 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
     return info;
   }
 
+  // State of a multishot accept op on a listening socket. It is shared with
+  // the op, which can still complete after the socket was unregistered.
+  struct AsyncAcceptState {
+    AsyncServerSocket* parent{nullptr};
+    NetworkSocket socket;
+    void* op{nullptr};
+    bool accepted{false};
+  };
+
+  struct ServerEventHandler;
+
+  // Accept through the EventBase backend when it supports multishot accept,
+  // fall back to accept() on readiness otherwise.
+  bool registerAcceptHandler(ServerEventHandler& handler);
+  void unregisterAcceptHandler(ServerEventHandler& handler);
+  bool startAsyncAccept(ServerEventHandler& handler);
+  void asyncAcceptReady(AsyncAcceptState& state, int res, bool more) noexcept;
+
   struct ServerEventHandler : public EventHandler {
     ServerEventHandler(
         EventBase* eventBase,
@@ -846,7 +969,8 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
           eventBase_(other.eventBase_),
           socket_(other.socket_),
           parent_(other.parent_),
-          addressFamily_(other.addressFamily_) {}
+          addressFamily_(other.addressFamily_),
+          asyncAccept_(other.asyncAccept_) {}
 
     ServerEventHandler& operator=(const ServerEventHandler& other) {
       if (this != &other) {
@@ -854,6 +978,7 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
         socket_ = other.socket_;
         parent_ = other.parent_;
         addressFamily_ = other.addressFamily_;
+        asyncAccept_ = other.asyncAccept_;
 
         detachEventBase();
         attachEventBase(other.eventBase_);
@@ -871,6 +996,7 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
     NetworkSocket socket_;
     AsyncServerSocket* parent_;
     sa_family_t addressFamily_;
+    std::shared_ptr<AsyncAcceptState> asyncAccept_;
   };
 
   EventBase* eventBase_;
@@ -884,6 +1010,7 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
   std::chrono::time_point<std::chrono::steady_clock> lastAccepTimestamp_;
   std::size_t numDroppedConnections_;
   uint32_t callbackIndex_;
+  DispatchPolicy dispatchPolicy_{DispatchPolicy::ROUND_ROBIN};
   BackoffTimeout* backoffTimeout_;
   std::vector<CallbackInfo> callbacks_;
   bool keepAliveEnabled_;
@@ -896,6 +1023,13 @@ class AsyncServerSocket : public DelayedDestruction, public AsyncSocketBase {
   ConnectionEventCallback* connectionEventCallback_{nullptr};
   bool tosReflect_{false};
   bool zeroCopyVal_{false};
+  std::chrono::microseconds overloadMaxLoopTime_{0};
+  uint32_t overloadMaxQueueDepth_{0};
+  std::chrono::milliseconds overloadCheckInterval_{10};
+  bool overloaded_{false};
+  std::unique_ptr<AsyncTimeout> overloadTimeout_;
+  // cleared if the kernel turns out not to support multishot accept
+  bool asyncAcceptSupported_{true};
 };
 
 } // namespace folly
@@ -24,13 +24,17 @@
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBaseBackendBase.h>
+#include <folly/io/async/EventBaseLocal.h>
 #include <folly/portability/Fcntl.h>
 #include <folly/portability/Sockets.h>
+#include <folly/portability/SysMman.h>
 #include <folly/portability/SysUio.h>
 #include <folly/portability/Unistd.h>
 
 #include <boost/preprocessor/control/if.hpp>
 #include <sys/types.h>
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <sstream>
@@ -39,6 +43,11 @@
 #if __linux__
 #include <linux/sockios.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
+
+#ifndef TCP_ZEROCOPY_RECEIVE
+#define TCP_ZEROCOPY_RECEIVE 35
+#endif
 #endif
 
 #if FOLLY_HAVE_VLA
@@ -71,6 +80,47 @@ const AsyncSocketException socketShutdownForWritesEx(
     AsyncSocketException::END_OF_FILE,
     "socket shutdown for writes");
 
+/* State for the completion-based I/O path (see AsyncSocket::setAsyncIo())
+ *
+ * The in-flight operations hold a reference to this, so they can tell
+ * whether the socket is still around when they complete.
+ */
+struct AsyncSocket::AsyncIoState {
+  AsyncIoState(AsyncSocket* sock, size_t bufSize)
+      : socket(sock), readBufferSize(bufSize) {}
+
+  ~AsyncIoState() {
+    closePipe();
+  }
+
+  // Drops the splice pipe along with anything left in it; the next file
+  // write creates a new one.
+  void closePipe() {
+    if (pipeFds[0] >= 0) {
+      ::close(pipeFds[0]);
+      ::close(pipeFds[1]);
+      pipeFds[0] = pipeFds[1] = -1;
+    }
+    pipeBytes = pipeBytesTotal = 0;
+  }
+
+  AsyncSocket* socket;
+  size_t readBufferSize;
+  EventBaseBackendBase* backend{nullptr}; ///< backend the ops were queued on
+  void* readOp{nullptr};
+  void* writeOp{nullptr};
+  bool readCancelled{false};
+  bool bufferPoolExhausted{false};
+  // result of the last write op, returned by the next sendSocketMessage()
+  bool hasWriteResult{false};
+  int writeResult{0};
+  // file writes are spliced from the file into this pipe, then to the
+  // socket; pipeBytes is what the current file write op left in it
+  int pipeFds[2]{-1, -1};
+  size_t pipeBytes{0};
+  size_t pipeBytesTotal{0};
+};
+
 // TODO: It might help performance to provide a version of BytesWriteRequest
 // that users could derive from, so we can avoid the extra allocation for each
 // call to write()/writev().
@@ -155,6 +205,27 @@ class AsyncSocket::BytesWriteRequest : public AsyncSocket::WriteRequest {
     return opsWritten_ == getOpCount();
   }
 
+  bool getAsyncWriteOps(
+      const iovec** ops,
+      uint32_t* opCount,
+      WriteFlags* flags,
+      unique_ptr<IOBuf>* keepAlive) override {
+    // we can only hand off buffers we own, and zerocopy notifications are
+    // tied to the error queue processing of the synchronous path
+    if (!ioBuf_ || socket_->isZeroCopyRequest(flags_)) {
+      return false;
+    }
+
+    *ops = getOps();
+    *opCount = getOpCount();
+    *flags = flags_;
+    if (getNext() != nullptr) {
+      *flags |= WriteFlags::CORK;
+    }
+    *keepAlive = ioBuf_->clone();
+    return true;
+  }
+
   void consume() override {
     // Advance opIndex_ forward by opsWritten_
     opIndex_ += opsWritten_;
@@ -229,6 +300,68 @@ class AsyncSocket::BytesWriteRequest : public AsyncSocket::WriteRequest {
   struct iovec writeOps_[]; ///< write operation(s) list
 };
 
+/* The WriteRequest used for writeFile()
+ */
+class AsyncSocket::FileWriteRequest : public AsyncSocket::WriteRequest {
+ public:
+  FileWriteRequest(
+      AsyncSocket* socket,
+      WriteCallback* callback,
+      int fd,
+      off_t offset,
+      size_t length,
+      WriteFlags flags)
+      : AsyncSocket::WriteRequest(socket, callback),
+        fd_(fd),
+        offset_(offset),
+        remaining_(length),
+        flags_(flags) {}
+
+  void destroy() override {
+    delete this;
+  }
+
+  WriteResult performWrite() override {
+    WriteFlags writeFlags = flags_;
+    if (getNext() != nullptr) {
+      writeFlags |= WriteFlags::CORK;
+    }
+    auto writeResult =
+        socket_->performFileWrite(fd_, offset_, remaining_, writeFlags);
+    bytesWritten_ = writeResult.writeReturn > 0 ? writeResult.writeReturn : 0;
+    return writeResult;
+  }
+
+  bool isComplete() override {
+    return size_t(bytesWritten_) == remaining_;
+  }
+
+  bool getAsyncFileWriteOp(int* fd, off_t* offset, size_t* length) override {
+    *fd = fd_;
+    *offset = offset_;
+    *length = remaining_;
+    return true;
+  }
+
+  void consume() override {
+    assert(size_t(bytesWritten_) <= remaining_);
+    offset_ += bytesWritten_;
+    remaining_ -= size_t(bytesWritten_);
+    totalBytesWritten_ += uint32_t(bytesWritten_);
+    bytesWritten_ = 0;
+  }
+
+ private:
+  // private destructor, to ensure callers use destroy()
+  ~FileWriteRequest() override = default;
+
+  int fd_;
+  off_t offset_;
+  size_t remaining_; ///< bytes still to be written
+  WriteFlags flags_;
+  ssize_t bytesWritten_{0}; ///< bytes written by the last performWrite()
+};
+
 int AsyncSocket::SendMsgParamsCallback::getDefaultFlags(
     folly::WriteFlags flags,
     bool zeroCopyEnabled) noexcept {
@@ -282,13 +415,159 @@ void disableTransparentFunctions(
 #endif
 }
 
+#if __linux__
+// struct tcp_zerocopy_receive as introduced in 4.18; newer kernels append
+// fields but accept the original size
+struct ZeroCopyReceive {
+  uint64_t address;
+  uint32_t length;
+  uint32_t recvSkipHint;
+};
+
+void zeroCopyReceiveFreeFn(void* buf, void* userData) {
+  ::munmap(buf, reinterpret_cast<size_t>(userData));
+}
+#endif
+
 } // namespace
 
+struct AsyncSocket::EventBaseIOStats {
+  IOStats totals;
+  std::shared_ptr<IOStatsObserver> observer;
+
+  static EventBaseLocal<EventBaseIOStats>& local() {
+    // leaked, sockets may be closed during static destruction
+    static auto& local = *new EventBaseLocal<EventBaseIOStats>();
+    return local;
+  }
+};
+
+AsyncSocket::IOStats& AsyncSocket::IOStats::operator+=(const IOStats& other) {
+  bytesRead += other.bytesRead;
+  bytesWritten += other.bytesWritten;
+  readCalls += other.readCalls;
+  writeCalls += other.writeCalls;
+  readsBlocked += other.readsBlocked;
+  writesBlocked += other.writesBlocked;
+  zeroCopyFallbacks += other.zeroCopyFallbacks;
+  return *this;
+}
+
+void AsyncSocket::addIOStatsObserver(IOStatsObserver* observer) {
+  ioStatsObservers_.push_back(observer);
+}
+
+bool AsyncSocket::removeIOStatsObserver(IOStatsObserver* observer) {
+  auto it = std::find(
+      ioStatsObservers_.begin(), ioStatsObservers_.end(), observer);
+  if (it == ioStatsObservers_.end()) {
+    return false;
+  }
+  ioStatsObservers_.erase(it);
+  return true;
+}
+
+AsyncSocket::IOStats AsyncSocket::getEventBaseIOStats(EventBase& evb) {
+  evb.dcheckIsInEventBaseThread();
+  auto stats = EventBaseIOStats::local().get(evb);
+  return stats ? stats->totals : IOStats();
+}
+
+void AsyncSocket::setEventBaseIOStatsObserver(
+    EventBase& evb,
+    std::shared_ptr<IOStatsObserver> observer) {
+  evb.dcheckIsInEventBaseThread();
+  EventBaseIOStats::local().getOrCreate(evb).observer = std::move(observer);
+}
+
+AsyncSocket::EventBaseIOStats* AsyncSocket::evbIOStats() {
+  if (!evbIOStats_ && eventBase_) {
+    auto errnoCopy = errno;
+    evbIOStats_ = &EventBaseIOStats::local().getOrCreate(*eventBase_);
+    errno = errnoCopy;
+  }
+  return evbIOStats_;
+}
+
+namespace {
+void recordIO(
+    AsyncSocket::IOStats& stats,
+    uint64_t AsyncSocket::IOStats::*bytes,
+    uint64_t AsyncSocket::IOStats::*calls,
+    uint64_t AsyncSocket::IOStats::*blockedCalls,
+    ssize_t rc,
+    bool blocked) {
+  ++(stats.*calls);
+  if (rc > 0) {
+    stats.*bytes += uint64_t(rc);
+  } else if (blocked) {
+    ++(stats.*blockedCalls);
+  }
+}
+} // namespace
+
+void AsyncSocket::recordRead(ssize_t rc, bool blocked) {
+  using S = IOStats;
+  recordIO(
+      ioStats_, &S::bytesRead, &S::readCalls, &S::readsBlocked, rc, blocked);
+  if (auto evbStats = evbIOStats()) {
+    recordIO(
+        evbStats->totals,
+        &S::bytesRead,
+        &S::readCalls,
+        &S::readsBlocked,
+        rc,
+        blocked);
+  }
+}
+
+void AsyncSocket::recordWrite(ssize_t rc, bool blocked) {
+  using S = IOStats;
+  recordIO(
+      ioStats_,
+      &S::bytesWritten,
+      &S::writeCalls,
+      &S::writesBlocked,
+      rc,
+      blocked);
+  if (auto evbStats = evbIOStats()) {
+    recordIO(
+        evbStats->totals,
+        &S::bytesWritten,
+        &S::writeCalls,
+        &S::writesBlocked,
+        rc,
+        blocked);
+  }
+}
+
+void AsyncSocket::recordZeroCopyFallbacks(uint64_t n) {
+  ioStats_.zeroCopyFallbacks += n;
+  if (auto evbStats = evbIOStats()) {
+    evbStats->totals.zeroCopyFallbacks += n;
+  }
+}
+
+void AsyncSocket::finishIOStats() {
+  // an observer may remove itself
+  auto observers = ioStatsObservers_;
+  for (auto observer : observers) {
+    observer->ioStatsFinished(*this, ioStats_);
+  }
+  auto evbStats = evbIOStats();
+  if (evbStats && evbStats->observer) {
+    // keeps the observer alive if it replaces itself
+    auto observer = evbStats->observer;
+    observer->ioStatsFinished(*this, ioStats_);
+  }
+}
+
 AsyncSocket::AsyncSocket()
     : eventBase_(nullptr),
       writeTimeout_(this, nullptr),
       ioHandler_(this, nullptr),
-      immediateReadHandler_(this) {
+      immediateReadHandler_(this),
+      deferredWriteHandler_(this) {
   VLOG(5) << "new AsyncSocket()";
   init();
 }
@@ -297,7 +576,8 @@ AsyncSocket::AsyncSocket(EventBase* evb)
     : eventBase_(evb),
       writeTimeout_(this, evb),
       ioHandler_(this, evb),
-      immediateReadHandler_(this) {
+      immediateReadHandler_(this),
+      deferredWriteHandler_(this) {
   VLOG(5) << "new AsyncSocket(" << this << ", evb=" << evb << ")";
   init();
 }
@@ -331,7 +611,8 @@ AsyncSocket::AsyncSocket(
       eventBase_(evb),
       writeTimeout_(this, evb),
       ioHandler_(this, evb, fd),
-      immediateReadHandler_(this) {
+      immediateReadHandler_(this),
+      deferredWriteHandler_(this) {
   VLOG(5) << "new AsyncSocket(" << this << ", evb=" << evb << ", fd=" << fd
           << ", zeroCopyBufId=" << zeroCopyBufId << ")";
   init();
@@ -377,6 +658,11 @@ AsyncSocket::~AsyncSocket() {
   VLOG(7) << "actual destruction of AsyncSocket(this=" << this
           << ", evb=" << eventBase_ << ", fd=" << fd_ << ", state=" << state_
           << ")";
+  if (asyncIo_) {
+    // any op still in flight will drop its result
+    asyncIo_->socket = nullptr;
+  }
+  releaseZeroCopyReceiveMap();
 }
 
 void AsyncSocket::destroy() {
@@ -399,6 +685,12 @@ NetworkSocket AsyncSocket::detachNetworkSocket() {
   if (const auto socketSet = wShutdownSocketSet_.lock()) {
     socketSet->remove(fd_);
   }
+  // The ops reference the fd, and closeNow() will not see it anymore
+  cancelAsyncIo();
+  releaseZeroCopyReceiveMap();
+  if (fd_ != NetworkSocket()) {
+    finishIOStats();
+  }
   auto fd = fd_;
   fd_ = NetworkSocket();
   // Call closeNow() to invoke all pending callbacks with an error.
@@ -915,6 +1207,25 @@ bool AsyncSocket::setZeroCopy(bool enable) {
   return false;
 }
 
+bool AsyncSocket::setZeroCopyReceive(bool enable, size_t mapSize) {
+  releaseZeroCopyReceiveMap();
+  if (!enable) {
+    zeroCopyReceiveSize_ = 0;
+    return true;
+  }
+#if __linux__
+  if (mapSize == 0 || !asyncIoDataPassthrough()) {
+    return false;
+  }
+  auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  zeroCopyReceiveSize_ = (mapSize + pageSize - 1) / pageSize * pageSize;
+  return true;
+#else
+  (void)mapSize;
+  return false;
+#endif
+}
+
 void AsyncSocket::setZeroCopyEnableFunc(AsyncWriter::ZeroCopyEnableFunc func) {
   zeroCopyEnableFunc_ = func;
 }
@@ -923,6 +1234,52 @@ void AsyncSocket::setZeroCopyReenableThreshold(size_t threshold) {
   zeroCopyReenableThreshold_ = threshold;
 }
 
+bool AsyncSocket::setZeroCopyAuto(bool enable) {
+  if (!enable) {
+    zeroCopyAuto_ = false;
+    return true;
+  }
+  if (!setZeroCopy(true)) {
+    return false;
+  }
+  zeroCopyAuto_ = true;
+  auto threshold = eventBase_ ? eventBase_->getZeroCopyAutoThreshold()
+                              : kDefaultZeroCopyAutoThreshold;
+  threshold = std::min(
+      std::max(threshold, size_t(kZeroCopyAutoMinThreshold)),
+      size_t(kZeroCopyAutoMaxThreshold));
+  zeroCopyAutoStats_.threshold = threshold;
+  zeroCopyAutoCostNs_ = double(threshold) / kZeroCopyAutoCopyBytesPerNs;
+  zeroCopyAutoStats_.completionCost =
+      std::chrono::nanoseconds(int64_t(zeroCopyAutoCostNs_));
+  return true;
+}
+
+void AsyncSocket::updateZeroCopyAutoCost(
+    std::chrono::nanoseconds elapsed,
+    uint64_t completions,
+    uint64_t copiedCompletions) {
+  if (completions == 0) {
+    return;
+  }
+  // a copied write bought nothing, so charge it as much as the largest
+  // threshold allows
+  constexpr double kCopiedCostNs =
+      double(kZeroCopyAutoMaxThreshold) / kZeroCopyAutoCopyBytesPerNs;
+  double sample = (double(elapsed.count()) +
+                   double(copiedCompletions) * kCopiedCostNs) /
+      double(completions);
+  // exponentially-weighted, 1/8 per notification
+  zeroCopyAutoCostNs_ += (sample - zeroCopyAutoCostNs_) / 8;
+
+  auto threshold = size_t(zeroCopyAutoCostNs_ * kZeroCopyAutoCopyBytesPerNs);
+  zeroCopyAutoStats_.threshold = std::min(
+      std::max(threshold, size_t(kZeroCopyAutoMinThreshold)),
+      size_t(kZeroCopyAutoMaxThreshold));
+  zeroCopyAutoStats_.completionCost =
+      std::chrono::nanoseconds(int64_t(zeroCopyAutoCostNs_));
+}
+
 bool AsyncSocket::isZeroCopyRequest(WriteFlags flags) {
   return (zeroCopyEnabled_ && isSet(flags, WriteFlags::WRITE_MSG_ZEROCOPY));
 }
@@ -1005,8 +1362,15 @@ void AsyncSocket::processZeroCopyMsg(const cmsghdr& cmsg) {
       reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(&cmsg));
   uint32_t hi = serr->ee_data;
   uint32_t lo = serr->ee_info;
-  // disable zero copy if the buffer was actually copied
-  if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && zeroCopyEnabled_) {
+  bool copied = (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+  zeroCopyAutoStats_.completions += uint64_t(hi - lo) + 1;
+  if (copied) {
+    zeroCopyAutoStats_.copiedCompletions += uint64_t(hi - lo) + 1;
+    recordZeroCopyFallbacks(uint64_t(hi - lo) + 1);
+  }
+  // disable zero copy if the buffer was actually copied, unless the
+  // automatic threshold is taking care of that
+  if (copied && zeroCopyEnabled_ && !zeroCopyAuto_) {
     VLOG(2) << "AsyncSocket::processZeroCopyMsg(): setting "
             << "zeroCopyEnabled_ = false due to SO_EE_CODE_ZEROCOPY_COPIED "
             << "on " << fd_;
@@ -1056,6 +1420,18 @@ void AsyncSocket::writeChain(
     flags |= WriteFlags::WRITE_MSG_ZEROCOPY;
   }
 
+  if (zeroCopyAuto_) {
+    zeroCopyAutoStats_.writes++;
+    if (zeroCopyEnabled_ && !isSet(flags, WriteFlags::WRITE_MSG_ZEROCOPY)) {
+      auto len = buf->computeChainDataLength();
+      if (len >= zeroCopyAutoStats_.threshold) {
+        flags |= WriteFlags::WRITE_MSG_ZEROCOPY;
+        zeroCopyAutoStats_.zeroCopyWrites++;
+        zeroCopyAutoStats_.zeroCopyBytes += len;
+      }
+    }
+  }
+
   constexpr size_t kSmallSizeMax = 64;
   size_t count = buf->countChainElements();
   if (count <= kSmallSizeMax) {
@@ -1115,9 +1491,15 @@ void AsyncSocket::writeImpl(
   uint32_t partialWritten = 0;
   ssize_t bytesWritten = 0;
   bool mustRegister = false;
+  bool deferWrite = false;
   if ((state_ == StateEnum::ESTABLISHED || state_ == StateEnum::FAST_OPEN) &&
       !connecting()) {
-    if (writeReqHead_ == nullptr) {
+    if (writeReqHead_ == nullptr && state_ == StateEnum::ESTABLISHED &&
+        eventBase_->getDeferWrites()) {
+      // Queue it, the EventBase flushes it along with the other writes
+      // issued during this loop iteration
+      deferWrite = true;
+    } else if (writeReqHead_ == nullptr) {
       // If we are established and there are no other writes pending,
       // we can attempt to perform the write immediately.
       assert(writeReqTail_ == nullptr);
@@ -1186,6 +1568,13 @@ void AsyncSocket::writeImpl(
     return failWrite(__func__, callback, size_t(bytesWritten), tex);
   }
   req->consume();
+  queueWriteRequest(req, mustRegister, deferWrite);
+}
+
+void AsyncSocket::queueWriteRequest(
+    WriteRequest* req,
+    bool mustRegister,
+    bool deferWrite) {
   if (writeReqTail_ == nullptr) {
     assert(writeReqHead_ == nullptr);
     writeReqHead_ = writeReqTail_ = req;
@@ -1198,6 +1587,11 @@ void AsyncSocket::writeImpl(
     bufferCallback_->onEgressBuffered();
   }
 
+  if (deferWrite) {
+    eventBase_->runBeforePoll(&deferredWriteHandler_);
+    return;
+  }
+
   // Register for write events if are established and not currently
   // waiting on write events
   if (mustRegister) {
@@ -1219,6 +1613,98 @@ void AsyncSocket::writeImpl(
   }
 }
 
+void AsyncSocket::writeFile(
+    WriteCallback* callback,
+    int fd,
+    off_t offset,
+    size_t length,
+    WriteFlags flags) {
+  VLOG(6) << "AsyncSocket::writeFile() this=" << this << ", fd=" << fd_
+          << ", callback=" << callback << ", file=" << fd
+          << ", offset=" << offset << ", length=" << length
+          << ", state=" << state_;
+  DestructorGuard dg(this);
+  eventBase_->dcheckIsInEventBaseThread();
+
+  totalAppBytesScheduledForWrite_ += length;
+
+  if (shutdownFlags_ & (SHUT_WRITE | SHUT_WRITE_PENDING)) {
+    // see writeImpl()
+    return invalidState(callback);
+  }
+
+  // the pages are not ours, there is nothing to hand to MSG_ZEROCOPY
+  flags = unSet(flags, WriteFlags::WRITE_MSG_ZEROCOPY);
+  auto* req = new FileWriteRequest(this, callback, fd, offset, length, flags);
+
+  bool mustRegister = false;
+  bool deferWrite = false;
+  if ((state_ == StateEnum::ESTABLISHED || state_ == StateEnum::FAST_OPEN) &&
+      !connecting()) {
+    if (writeReqHead_ == nullptr && state_ == StateEnum::ESTABLISHED &&
+        eventBase_->getDeferWrites()) {
+      deferWrite = true;
+    } else if (writeReqHead_ == nullptr) {
+      auto writeResult = req->performWrite();
+      if (writeResult.writeReturn < 0) {
+        auto errnoCopy = errno;
+        req->destroy();
+        if (writeResult.exception) {
+          return failWrite(__func__, callback, 0, *writeResult.exception);
+        }
+        AsyncSocketException ex(
+            AsyncSocketException::INTERNAL_ERROR,
+            withAddr("sendfile failed"),
+            errnoCopy);
+        return failWrite(__func__, callback, 0, ex);
+      } else if (req->isComplete()) {
+        req->destroy();
+        if (callback) {
+          callback->writeSuccess();
+        }
+        return;
+      }
+      req->consume();
+      mustRegister = !connecting();
+    }
+  } else if (!connecting()) {
+    req->destroy();
+    return invalidState(callback);
+  }
+
+  queueWriteRequest(req, mustRegister, deferWrite);
+}
+
+void AsyncSocket::flushDeferredWrites() noexcept {
+  // The queue may have failed, or be waiting for write events already
+  if (state_ != StateEnum::ESTABLISHED || writeReqHead_ == nullptr ||
+      (eventFlags_ & EventHandler::WRITE)) {
+    return;
+  }
+
+  if (!asyncIo_) {
+    // the same writes writeImpl() would have issued, without the handshake
+    // handling subclasses add to handleWrite()
+    AsyncSocket::handleWrite();
+    return;
+  }
+
+  // Completion-based writes are started by the registration, and submitted
+  // together with those of the other sockets
+  if (!updateEventRegistration(EventHandler::WRITE, 0)) {
+    assert(state_ == StateEnum::ERROR);
+    return;
+  }
+  if (sendTimeout_ > 0) {
+    if (!writeTimeout_.scheduleTimeout(sendTimeout_)) {
+      AsyncSocketException ex(
+          AsyncSocketException::INTERNAL_ERROR,
+          withAddr("failed to schedule send timeout"));
+      return failWrite(__func__, ex);
+    }
+  }
+}
+
 void AsyncSocket::writeRequest(WriteRequest* req) {
   if (writeReqTail_ == nullptr) {
     assert(writeReqHead_ == nullptr);
@@ -1292,6 +1778,8 @@ void AsyncSocket::closeNow() {
   if (eventBase_) {
     eventBase_->dcheckIsInEventBaseThread();
   }
+  // the mapping holds a reference to the socket
+  releaseZeroCopyReceiveMap();
 
   switch (state_) {
     case StateEnum::ESTABLISHED:
@@ -1541,9 +2029,15 @@ void AsyncSocket::attachEventBase(EventBase* eventBase) {
   eventBase->dcheckIsInEventBaseThread();
 
   eventBase_ = eventBase;
+  evbIOStats_ = nullptr;
   ioHandler_.attachEventBase(eventBase);
 
   updateEventRegistration();
+  if (state_ == StateEnum::ESTABLISHED && writeReqHead_ != nullptr &&
+      (eventFlags_ & EventHandler::WRITE) == 0) {
+    // the deferred writes were not flushed before the detach
+    eventBase->runBeforePoll(&deferredWriteHandler_);
+  }
 
   writeTimeout_.attachEventBase(eventBase);
   if (evbChangeCb_) {
@@ -1559,7 +2053,9 @@ void AsyncSocket::detachEventBase() {
   eventBase_->dcheckIsInEventBaseThread();
 
   eventBase_ = nullptr;
+  evbIOStats_ = nullptr;
 
+  deferredWriteHandler_.cancelLoopCallback();
   ioHandler_.unregisterHandler();
 
   ioHandler_.detachEventBase();
@@ -1573,6 +2069,11 @@ bool AsyncSocket::isDetachable() const {
   DCHECK(eventBase_ != nullptr);
   eventBase_->dcheckIsInEventBaseThread();
 
+  if (asyncIo_ && (asyncIo_->readOp || asyncIo_->writeOp)) {
+    // the ops are tied to the current EventBase backend
+    return false;
+  }
+
   return !writeTimeout_.isScheduled();
 }
 
@@ -1870,6 +2371,7 @@ AsyncSocket::performRead(void** buf, size_t* buflen, size_t* /* offset */) {
   }
 
   ssize_t bytes = netops::recv(fd_, *buf, *buflen, MSG_DONTWAIT);
+  recordRead(bytes, bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
   if (bytes < 0) {
     if (errno == EAGAIN || errno == EWOULDBLOCK) {
       // No more data to read right now.
@@ -1883,6 +2385,78 @@ AsyncSocket::performRead(void** buf, size_t* buflen, size_t* /* offset */) {
   }
 }
 
+void AsyncSocket::releaseZeroCopyReceiveMap() {
+#if __linux__
+  if (zeroCopyReceiveMap_) {
+    ::munmap(zeroCopyReceiveMap_, zeroCopyReceiveSize_);
+    zeroCopyReceiveMap_ = nullptr;
+  }
+#endif
+}
+
+std::unique_ptr<IOBuf> AsyncSocket::performZeroCopyRead() {
+#if __linux__
+  auto mapSize = zeroCopyReceiveSize_;
+  // Most attempts find less than a page; keep the mapping of such attempts
+  // for the next one rather than paying for mmap()/munmap() every time.
+  void* addr = std::exchange(zeroCopyReceiveMap_, nullptr);
+  if (!addr) {
+    addr = ::mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd_.toFd(), 0);
+    if (addr == MAP_FAILED) {
+      VLOG(4) << "AsyncSocket::performZeroCopyRead() this=" << this
+              << ", mmap() failed, errno=" << errno
+              << ", disabling zero-copy receive";
+      zeroCopyReceiveSize_ = 0;
+      return nullptr;
+    }
+  }
+
+  ZeroCopyReceive zc;
+  memset(&zc, 0, sizeof(zc));
+  zc.address = reinterpret_cast<uintptr_t>(addr);
+  zc.length = static_cast<uint32_t>(mapSize);
+  socklen_t zcLen = sizeof(zc);
+  int ret = netops::getsockopt(
+      fd_, IPPROTO_TCP, TCP_ZEROCOPY_RECEIVE, &zc, &zcLen);
+  if (ret == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+    recordRead(ret == 0 ? ssize_t(zc.length) : -1, ret != 0);
+  }
+  if (ret != 0 || zc.length == 0) {
+    auto errnoCopy = errno;
+    if (ret != 0 &&
+        (errnoCopy == ENOPROTOOPT || errnoCopy == EINVAL ||
+         errnoCopy == EOPNOTSUPP)) {
+      VLOG(4) << "AsyncSocket::performZeroCopyRead() this=" << this
+              << ", TCP_ZEROCOPY_RECEIVE not supported, errno=" << errnoCopy;
+      ::munmap(addr, mapSize);
+      zeroCopyReceiveSize_ = 0;
+    } else {
+      // nothing mapped (or a socket error, which the regular read that
+      // follows reports); keep the mapping for the next attempt
+      zeroCopyReceiveMap_ = addr;
+    }
+    return nullptr;
+  }
+
+  VLOG(5) << "AsyncSocket::performZeroCopyRead() this=" << this << ", mapped "
+          << zc.length << " bytes, skip hint=" << zc.recvSkipHint;
+  appBytesReceived_ += zc.length;
+  zeroCopyReceiveBytes_ += zc.length;
+  // the capacity is the mapped payload only, so there is no (read-only)
+  // tailroom to write to; marking it shared makes consumers that modify
+  // data in place (e.g. after unshare() checks) copy it first
+  auto buf = IOBuf::takeOwnership(
+      addr,
+      zc.length,
+      zeroCopyReceiveFreeFn,
+      reinterpret_cast<void*>(mapSize));
+  buf->markExternallySharedOne();
+  return buf;
+#else
+  return nullptr;
+#endif
+}
+
 void AsyncSocket::prepareReadBuffer(void** buf, size_t* buflen) {
   // no matter what, buffer should be preapared for non-ssl socket
   CHECK(readCallback_);
@@ -1920,6 +2494,13 @@ size_t AsyncSocket::handleErrMessages() noexcept {
   size_t num = 0;
   // the socket may be closed by errMessage callback, so check on each iteration
   while (fd_ != NetworkSocket()) {
+    // time reaping zerocopy notifications for the automatic threshold
+    auto completions = zeroCopyAutoStats_.completions;
+    auto copiedCompletions = zeroCopyAutoStats_.copiedCompletions;
+    std::chrono::steady_clock::time_point start;
+    if (zeroCopyAuto_) {
+      start = std::chrono::steady_clock::now();
+    }
     ret = netops::recvmsg(fd_, &msg, MSG_ERRQUEUE);
     VLOG(5) << "AsyncSocket::handleErrMessages(): recvmsg returned " << ret;
 
@@ -1950,6 +2531,13 @@ size_t AsyncSocket::handleErrMessages() noexcept {
         }
       }
     }
+    if (zeroCopyAuto_ && zeroCopyAutoStats_.completions != completions) {
+      updateZeroCopyAutoCost(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start),
+          zeroCopyAutoStats_.completions - completions,
+          zeroCopyAutoStats_.copiedCompletions - copiedCompletions);
+    }
   }
   return num;
 #else
@@ -1997,6 +2585,24 @@ void AsyncSocket::handleRead() noexcept {
   uint16_t numReads = 0;
   EventBase* originalEventBase = eventBase_;
   while (readCallback_ && eventBase_ == originalEventBase) {
+    // Whole pages can be mapped instead of copied; partial pages, EOF and
+    // errors are left to the regular read below.
+    if (zeroCopyReceiveSize_ != 0 && !isBufferMovable_ &&
+        (!preReceivedData_ || preReceivedData_->empty()) &&
+        readCallback_->isBufferMovable()) {
+      auto zcBuf = performZeroCopyRead();
+      if (zcBuf) {
+        readCallback_->readBufferAvailable(std::move(zcBuf));
+        if (maxReadsPerEvent_ && (++numReads >= maxReadsPerEvent_)) {
+          if (readCallback_ != nullptr) {
+            scheduleImmediateRead();
+          }
+          return;
+        }
+        continue;
+      }
+    }
+
     // Get the buffer to read into.
     void* buf = nullptr;
     size_t buflen = 0, offset = 0;
@@ -2121,6 +2727,11 @@ void AsyncSocket::handleWrite() noexcept {
   assert((shutdownFlags_ & SHUT_WRITE) == 0);
   assert(writeReqHead_ != nullptr);
 
+  // The head request is owned by the backend until the op completes
+  if (asyncIo_ && asyncIo_->writeOp) {
+    return;
+  }
+
   // Loop until we run out of write requests,
   // or until this socket is moved to another EventBase.
   // (See the comment in handleRead() explaining how this can happen.)
@@ -2412,6 +3023,16 @@ AsyncSocket::WriteResult AsyncSocket::sendSocketMessage(
     NetworkSocket fd,
     struct msghdr* msg,
     int msg_flags) {
+  if (asyncIo_ && asyncIo_->hasWriteResult) {
+    // the backend already performed this write for us
+    asyncIo_->hasWriteResult = false;
+    if (asyncIo_->writeResult < 0) {
+      errno = -asyncIo_->writeResult;
+      return WriteResult(-1);
+    }
+    return WriteResult(asyncIo_->writeResult);
+  }
+
   ssize_t totalWritten = 0;
   if (state_ == StateEnum::FAST_OPEN) {
     sockaddr_storage addr;
@@ -2419,6 +3040,7 @@ AsyncSocket::WriteResult AsyncSocket::sendSocketMessage(
     msg->msg_name = &addr;
     msg->msg_namelen = len;
     totalWritten = tfoSendMsg(fd_, msg, msg_flags);
+    recordWrite(totalWritten, totalWritten < 0 && errno == EAGAIN);
     if (totalWritten >= 0) {
       tfoFinished_ = true;
       state_ = StateEnum::ESTABLISHED;
@@ -2473,6 +3095,7 @@ AsyncSocket::WriteResult AsyncSocket::sendSocketMessage(
     }
   } else {
     totalWritten = netops::sendmsg(fd, msg, msg_flags);
+    recordWrite(totalWritten, totalWritten < 0 && errno == EAGAIN);
   }
   return WriteResult(totalWritten);
 }
@@ -2513,6 +3136,7 @@ AsyncSocket::WriteResult AsyncSocket::performWrite(
     // memlock value - see ulimit -l
     zeroCopyEnabled_ = false;
     zeroCopyReenableCounter_ = zeroCopyReenableThreshold_;
+    recordZeroCopyFallbacks(1);
     msg_flags = sendMsgParamCallback_->getFlags(flags, zeroCopyEnabled_);
     writeResult = sendSocketMessage(fd_, &msg, msg_flags);
     totalWritten = writeResult.writeReturn;
@@ -2561,6 +3185,91 @@ AsyncSocket::WriteResult AsyncSocket::performWrite(
   return WriteResult(totalWritten);
 }
 
+namespace {
+std::unique_ptr<AsyncSocketException> fileEndedException() {
+  return std::make_unique<AsyncSocketException>(
+      AsyncSocketException::END_OF_FILE,
+      "file ended before the requested length was written");
+}
+} // namespace
+
+AsyncSocket::WriteResult AsyncSocket::performFileWrite(
+    int fd,
+    off_t offset,
+    size_t length,
+    WriteFlags flags) {
+  if (asyncIo_ && asyncIo_->hasWriteResult) {
+    // the backend already spliced the file for us
+    asyncIo_->hasWriteResult = false;
+    if (asyncIo_->writeResult < 0) {
+      errno = -asyncIo_->writeResult;
+      return WriteResult(-1);
+    }
+    if (asyncIo_->writeResult == 0 && length != 0) {
+      return WriteResult(WRITE_ERROR, fileEndedException());
+    }
+    appBytesWritten_ += size_t(asyncIo_->writeResult);
+    return WriteResult(asyncIo_->writeResult);
+  }
+  if (length == 0) {
+    return WriteResult(0);
+  }
+
+#if __linux__
+  // TFO sockets are not connected until the first sendmsg()
+  if (state_ != StateEnum::FAST_OPEN) {
+    off_t off = offset;
+    ssize_t totalWritten = ::sendfile(fd_.toFd(), fd, &off, length);
+    if (totalWritten >= 0 || errno == EAGAIN) {
+      recordWrite(totalWritten, totalWritten < 0);
+    }
+    if (totalWritten > 0) {
+      appBytesWritten_ += size_t(totalWritten);
+      return WriteResult(totalWritten);
+    } else if (totalWritten == 0) {
+      return WriteResult(WRITE_ERROR, fileEndedException());
+    } else if (errno == EAGAIN) {
+      return WriteResult(0);
+    } else if (errno != EINVAL && errno != ENOSYS) {
+      return WriteResult(WRITE_ERROR);
+    }
+    // the file cannot be read with sendfile(), copy it instead
+  }
+#endif
+  return performFileWriteCopy(fd, offset, length, flags);
+}
+
+AsyncSocket::WriteResult AsyncSocket::performFileWriteCopy(
+    int fd,
+    off_t offset,
+    size_t length,
+    WriteFlags flags) {
+  if (length == 0) {
+    return WriteResult(0);
+  }
+  constexpr size_t kMaxCopySize = 64 * 1024;
+  auto size = std::min(length, kMaxCopySize);
+  auto buf = std::make_unique<uint8_t[]>(size);
+  ssize_t bytesRead;
+  do {
+    bytesRead = ::pread(fd, buf.get(), size, offset);
+  } while (bytesRead < 0 && errno == EINTR);
+  if (bytesRead < 0) {
+    return WriteResult(WRITE_ERROR);
+  } else if (bytesRead == 0) {
+    return WriteResult(WRITE_ERROR, fileEndedException());
+  }
+
+  // A partial write is retried with the same bytes, read again from the
+  // file, which is what SSL_write() needs.
+  iovec vec;
+  vec.iov_base = buf.get();
+  vec.iov_len = size_t(bytesRead);
+  uint32_t countWritten = 0;
+  uint32_t partialWritten = 0;
+  return performWrite(&vec, 1, flags, &countWritten, &partialWritten);
+}
+
 /**
  * Re-register the EventHandler after eventFlags_ has changed.
  *
@@ -2574,7 +3283,10 @@ bool AsyncSocket::updateEventRegistration() {
   VLOG(5) << "AsyncSocket::updateEventRegistration(this=" << this
           << ", fd=" << fd_ << ", evb=" << eventBase_ << ", state=" << state_
           << ", events=" << std::hex << eventFlags_;
-  if (eventFlags_ == EventHandler::NONE) {
+  // Events serviced by completion-based ops do not need a registration
+  uint16_t eventFlags =
+      asyncIo_ ? adjustEventFlagsForAsyncIo(eventFlags_) : eventFlags_;
+  if (eventFlags == EventHandler::NONE) {
     if (ioHandler_.isHandlerRegistered()) {
       DCHECK(eventBase_ != nullptr);
       eventBase_->dcheckIsInEventBaseThread();
@@ -2588,7 +3300,7 @@ bool AsyncSocket::updateEventRegistration() {
   // Always register for persistent events, so we don't have to re-register
   // after being called back.
   if (!ioHandler_.registerHandler(
-          uint16_t(eventFlags_ | EventHandler::PERSIST))) {
+          uint16_t(eventFlags | EventHandler::PERSIST))) {
     eventFlags_ = EventHandler::NONE; // we're not registered after error
     AsyncSocketException ex(
         AsyncSocketException::INTERNAL_ERROR,
@@ -2600,6 +3312,364 @@ bool AsyncSocket::updateEventRegistration() {
   return true;
 }
 
+bool AsyncSocket::setAsyncIo(bool enable, size_t readBufferSize) {
+  if (!enable) {
+    if (asyncIo_) {
+      if (asyncIo_->readOp || asyncIo_->writeOp) {
+        return false;
+      }
+      asyncIo_->socket = nullptr;
+      asyncIo_.reset();
+      if (eventFlags_ != EventHandler::NONE) {
+        // switch back to readiness notifications
+        return updateEventRegistration();
+      }
+    }
+    return true;
+  }
+
+  if (!eventBase_ || !eventBase_->getBackend() ||
+      !eventBase_->getBackend()->eb_async_io_supported()) {
+    return false;
+  }
+  eventBase_->dcheckIsInEventBaseThread();
+
+  if (!asyncIo_) {
+    asyncIo_ = std::make_shared<AsyncIoState>(this, readBufferSize);
+  } else {
+    asyncIo_->readBufferSize = readBufferSize;
+  }
+
+  if (eventFlags_ != EventHandler::NONE) {
+    return updateEventRegistration();
+  }
+  return true;
+}
+
+EventBaseBackendBase* AsyncSocket::getAsyncIoBackend() const {
+  if (!eventBase_ || fd_ == NetworkSocket()) {
+    return nullptr;
+  }
+  auto* backend = eventBase_->getBackend();
+  return (backend && backend->eb_async_io_supported()) ? backend : nullptr;
+}
+
+uint16_t AsyncSocket::adjustEventFlagsForAsyncIo(uint16_t eventFlags) {
+  // connect completion is still detected via write readiness
+  if (state_ != StateEnum::ESTABLISHED) {
+    return eventFlags;
+  }
+
+  if (eventFlags & EventHandler::READ) {
+    if (startAsyncRead()) {
+      eventFlags &= ~EventHandler::READ;
+    }
+  } else if (asyncIo_->readOp && !asyncIo_->readCancelled) {
+    // Stop pulling data in; anything that already arrived is kept as
+    // pre-received data.
+    asyncIo_->readCancelled = true;
+    asyncIo_->backend->eb_cancel_op(asyncIo_->readOp);
+  }
+
+  if (eventFlags & EventHandler::WRITE) {
+    if (startAsyncWrite()) {
+      eventFlags &= ~EventHandler::WRITE;
+    }
+  }
+
+  return eventFlags;
+}
+
+bool AsyncSocket::startAsyncRead() {
+  if (asyncIo_->readOp) {
+    // Data from a read that is being cancelled may still arrive, so keep
+    // readiness notifications off until it completes and re-evaluates the
+    // registration.
+    return true;
+  }
+
+  auto* backend = getAsyncIoBackend();
+  if (!backend) {
+    return false;
+  }
+
+  // Prefer the backend's buffer pool, so idle sockets do not hold a buffer.
+  // If the pool ran dry last time, read into our own buffer once.
+  if (!asyncIo_->bufferPoolExhausted) {
+    asyncIo_->readOp = backend->eb_queue_recv_pooled(
+        fd_.toFd(), 0, [state = asyncIo_](int res, unique_ptr<IOBuf> buf) {
+          if (state->socket) {
+            state->bufferPoolExhausted = (res == -ENOBUFS);
+            state->socket->asyncReadComplete(res, std::move(buf));
+          }
+        });
+  }
+
+  if (!asyncIo_->readOp) {
+    auto buf = IOBuf::create(asyncIo_->readBufferSize);
+    void* data = buf->writableTail();
+    size_t len = buf->tailroom();
+    asyncIo_->readOp = backend->eb_queue_recv(
+        fd_.toFd(),
+        data,
+        len,
+        0,
+        [state = asyncIo_, buf = std::move(buf)](int res) mutable {
+          if (state->socket) {
+            state->bufferPoolExhausted = false;
+            if (res > 0) {
+              buf->append(size_t(res));
+            }
+            state->socket->asyncReadComplete(res, std::move(buf));
+          }
+        });
+  }
+  if (!asyncIo_->readOp) {
+    return false;
+  }
+  asyncIo_->backend = backend;
+  asyncIo_->readCancelled = false;
+  return true;
+}
+
+bool AsyncSocket::startAsyncWrite() {
+  if (asyncIo_->writeOp) {
+    return true;
+  }
+
+  auto* backend = getAsyncIoBackend();
+  if (!backend || !writeReqHead_ || !asyncIoDataPassthrough()) {
+    return false;
+  }
+
+  int fileFd;
+  off_t fileOffset;
+  size_t fileLength;
+  if (writeReqHead_->getAsyncFileWriteOp(&fileFd, &fileOffset, &fileLength)) {
+    return startAsyncFileWrite(backend, fileFd, fileOffset, fileLength);
+  }
+
+  const iovec* ops = nullptr;
+  uint32_t opCount = 0;
+  WriteFlags flags = WriteFlags::NONE;
+  unique_ptr<IOBuf> keepAlive;
+  if (!writeReqHead_->getAsyncWriteOps(&ops, &opCount, &flags, &keepAlive) ||
+      sendMsgParamCallback_->getAncillaryDataSize(flags) != 0) {
+    return false;
+  }
+
+  // the backend waits for the socket to become writable for us
+  int msgFlags = sendMsgParamCallback_->getFlags(flags, zeroCopyEnabled_) &
+      ~MSG_DONTWAIT;
+  asyncIo_->writeOp = backend->eb_queue_sendmsg(
+      fd_.toFd(),
+      ops,
+      std::min<size_t>(opCount, kIovMax),
+      msgFlags,
+      [state = asyncIo_, keepAlive = std::move(keepAlive)](int res) {
+        if (state->socket) {
+          state->socket->asyncWriteComplete(res);
+        }
+      });
+  if (!asyncIo_->writeOp) {
+    return false;
+  }
+  asyncIo_->backend = backend;
+  return true;
+}
+
+bool AsyncSocket::startAsyncFileWrite(
+    EventBaseBackendBase* backend,
+    int fd,
+    off_t offset,
+    size_t length) {
+#if __linux__
+  if (length == 0) {
+    return false;
+  }
+  if (asyncIo_->pipeFds[0] < 0) {
+    // blocking, so that the backend rather than we waits for room
+    if (::pipe2(asyncIo_->pipeFds, O_CLOEXEC) != 0) {
+      asyncIo_->pipeFds[0] = asyncIo_->pipeFds[1] = -1;
+      return false;
+    }
+  }
+
+  // a pipe holds 64KiB by default
+  constexpr size_t kMaxSpliceSize = 64 * 1024;
+  asyncIo_->writeOp = backend->eb_queue_splice(
+      fd,
+      offset,
+      asyncIo_->pipeFds[1],
+      -1,
+      std::min(length, kMaxSpliceSize),
+      SPLICE_F_MOVE,
+      [state = asyncIo_](int res) {
+        if (state->socket) {
+          state->socket->asyncFileSpliceComplete(res, false);
+        }
+      });
+  if (!asyncIo_->writeOp) {
+    return false;
+  }
+  asyncIo_->backend = backend;
+  asyncIo_->pipeBytes = 0;
+  asyncIo_->pipeBytesTotal = 0;
+  return true;
+#else
+  (void)backend;
+  (void)fd;
+  (void)offset;
+  (void)length;
+  return false;
+#endif
+}
+
+void AsyncSocket::asyncFileSpliceComplete(int res, bool toSocket) {
+#if __linux__
+  VLOG(5) << "AsyncSocket::asyncFileSpliceComplete() this=" << this
+          << ", fd=" << fd_ << ", res=" << res << ", toSocket=" << toSocket
+          << ", state=" << state_;
+  if (res == -ECANCELED || state_ != StateEnum::ESTABLISHED ||
+      writeReqHead_ == nullptr || res <= 0) {
+    // Report errors, and a file that ended early, to the write request.
+    // Whatever the failed op left in the pipe must not leak into the next
+    // file write.
+    asyncIo_->closePipe();
+    return asyncWriteComplete(res);
+  }
+
+  if (toSocket) {
+    asyncIo_->pipeBytes -= size_t(res);
+  } else {
+    asyncIo_->pipeBytes = asyncIo_->pipeBytesTotal = size_t(res);
+  }
+  if (asyncIo_->pipeBytes == 0) {
+    // the result performFileWrite() picks up
+    return asyncWriteComplete(int(asyncIo_->pipeBytesTotal));
+  }
+
+  // Drain the pipe before completing the op; its contents belong to this
+  // request, so nothing else may be written in between.
+  asyncIo_->writeOp = asyncIo_->backend->eb_queue_splice(
+      asyncIo_->pipeFds[0],
+      -1,
+      fd_.toFd(),
+      -1,
+      asyncIo_->pipeBytes,
+      SPLICE_F_MOVE,
+      [state = asyncIo_](int spliced) {
+        if (state->socket) {
+          state->socket->asyncFileSpliceComplete(spliced, true);
+        }
+      });
+  if (!asyncIo_->writeOp) {
+    asyncIo_->closePipe();
+    asyncWriteComplete(-ENOMEM);
+  }
+#else
+  asyncWriteComplete(res);
+#endif
+}
+
+void AsyncSocket::asyncReadComplete(int res, unique_ptr<IOBuf> buf) {
+  VLOG(5) << "AsyncSocket::asyncReadComplete() this=" << this
+          << ", fd=" << fd_ << ", res=" << res << ", state=" << state_;
+  DestructorGuard dg(this);
+  asyncIo_->readOp = nullptr;
+  asyncIo_->readCancelled = false;
+  if (res != -ECANCELED) {
+    recordRead(res, res == -EAGAIN);
+  }
+
+  EventBase* originalEventBase = eventBase_;
+  bool delivered = false;
+  if (res > 0 && readCallback_ && readCallback_->isBufferMovable() &&
+      asyncIoDataPassthrough() && state_ == StateEnum::ESTABLISHED &&
+      (eventFlags_ & EventHandler::READ) &&
+      (!preReceivedData_ || preReceivedData_->empty())) {
+    // nothing to merge with, hand the buffer over without copying
+    appBytesReceived_ += size_t(res);
+    delivered = true;
+    readCallback_->readBufferAvailable(std::move(buf));
+  } else if (res > 0) {
+    if (preReceivedData_) {
+      preReceivedData_->prependChain(std::move(buf));
+    } else {
+      preReceivedData_ = std::move(buf);
+    }
+  } else if (
+      res < 0 && res != -ECANCELED && res != -EAGAIN && res != -EINTR &&
+      res != -ENOBUFS) {
+    if (readCallback_ && state_ == StateEnum::ESTABLISHED) {
+      readErr_ = READ_ERROR;
+      AsyncSocketException ex(
+          AsyncSocketException::INTERNAL_ERROR,
+          withAddr("recv() failed"),
+          -res);
+      return failRead(__func__, ex);
+    }
+  }
+
+  // On EOF handleRead() drains the pre-received data and then sees the
+  // EOF through a regular recv().
+  if (!delivered && res >= 0 && state_ == StateEnum::ESTABLISHED &&
+      (eventFlags_ & EventHandler::READ) && !(shutdownFlags_ & SHUT_READ)) {
+    handleRead();
+  }
+
+  if (asyncIo_ && eventBase_ == originalEventBase &&
+      state_ == StateEnum::ESTABLISHED) {
+    // queue the next read, or fall back to readiness notifications
+    updateEventRegistration();
+  }
+}
+
+void AsyncSocket::asyncWriteComplete(int res) {
+  VLOG(5) << "AsyncSocket::asyncWriteComplete() this=" << this
+          << ", fd=" << fd_ << ", res=" << res << ", state=" << state_;
+  DestructorGuard dg(this);
+  asyncIo_->writeOp = nullptr;
+  if (res != -ECANCELED) {
+    recordWrite(res, res == -EAGAIN);
+  }
+
+  // only cancelled when the socket is being closed
+  if (res == -ECANCELED || state_ != StateEnum::ESTABLISHED ||
+      writeReqHead_ == nullptr) {
+    return;
+  }
+
+  // handleWrite() picks the result up through sendSocketMessage()
+  asyncIo_->hasWriteResult = true;
+  asyncIo_->writeResult = (res == -EAGAIN) ? 0 : res;
+  EventBase* originalEventBase = eventBase_;
+  handleWrite();
+  if (!asyncIo_) {
+    return;
+  }
+  asyncIo_->hasWriteResult = false;
+
+  if (eventBase_ == originalEventBase && state_ == StateEnum::ESTABLISHED &&
+      (eventFlags_ & EventHandler::WRITE)) {
+    // queue the rest, or fall back to readiness notifications
+    updateEventRegistration();
+  }
+}
+
+void AsyncSocket::cancelAsyncIo() {
+  if (!asyncIo_ || !asyncIo_->backend) {
+    return;
+  }
+  if (asyncIo_->readOp && !asyncIo_->readCancelled) {
+    asyncIo_->readCancelled = true;
+    asyncIo_->backend->eb_cancel_op(asyncIo_->readOp);
+  }
+  if (asyncIo_->writeOp) {
+    asyncIo_->backend->eb_cancel_op(asyncIo_->writeOp);
+  }
+}
+
 bool AsyncSocket::updateEventRegistration(uint16_t enable, uint16_t disable) {
   uint16_t oldFlags = eventFlags_;
   eventFlags_ |= enable;
@@ -2624,6 +3694,7 @@ void AsyncSocket::startFail() {
   if (immediateReadHandler_.isLoopCallbackScheduled()) {
     immediateReadHandler_.cancelLoopCallback();
   }
+  deferredWriteHandler_.cancelLoopCallback();
 
   if (eventFlags_ != EventHandler::NONE) {
     eventFlags_ = EventHandler::NONE;
@@ -2892,6 +3963,9 @@ void AsyncSocket::doClose() {
   if (fd_ == NetworkSocket()) {
     return;
   }
+  // closing the fd does not cancel the ops that reference it
+  cancelAsyncIo();
+  finishIOStats();
   if (const auto shutdownSocketSet = wShutdownSocketSet_.lock()) {
     shutdownSocketSet->close(fd_);
   } else {
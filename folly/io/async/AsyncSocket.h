@@ -33,9 +33,12 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace folly {
 
+class EventBaseBackendBase;
+
 /**
  * A class for performing asynchronous I/O on a socket.
  *
@@ -544,6 +547,101 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
 
   void setZeroCopyReenableThreshold(size_t threshold);
 
+  // bounds and default for the automatic zerocopy threshold
+  static constexpr size_t kZeroCopyAutoMinThreshold = 8 * 1024;
+  static constexpr size_t kZeroCopyAutoMaxThreshold = 1024 * 1024;
+  static constexpr size_t kDefaultZeroCopyAutoThreshold = 32 * 1024;
+  // copy throughput the notification cost is weighed against
+  static constexpr size_t kZeroCopyAutoCopyBytesPerNs = 8;
+
+  struct ZeroCopyAutoStats {
+    // writeChain() calls considered, and those sent with MSG_ZEROCOPY
+    uint64_t writes{0};
+    uint64_t zeroCopyWrites{0};
+    uint64_t zeroCopyBytes{0};
+    // completed zerocopy writes, and those the kernel copied anyway
+    uint64_t completions{0};
+    uint64_t copiedCompletions{0};
+    // running estimate of the completion notification cost per write
+    std::chrono::nanoseconds completionCost{0};
+    // current payload size from which writes use MSG_ZEROCOPY
+    size_t threshold{0};
+  };
+
+  /**
+   * Automatic zerocopy: instead of relying on WriteFlags::WRITE_MSG_ZEROCOPY
+   * or a ZeroCopyEnableFunc, writeChain() sends every chain of at least
+   * getZeroCopyAutoThreshold() bytes with MSG_ZEROCOPY.
+   *
+   * The threshold follows a running estimate of what reaping the completion
+   * notifications costs per write, converted to the number of bytes that
+   * copying would handle in the same time. Writes the kernel reports as
+   * copied anyway raise the estimate instead of turning zerocopy off. The
+   * estimate starts from EventBase::getZeroCopyAutoThreshold().
+   *
+   * Enables zerocopy on the socket; returns false if that fails.
+   */
+  bool setZeroCopyAuto(bool enable);
+  bool getZeroCopyAuto() const {
+    return zeroCopyAuto_;
+  }
+
+  size_t getZeroCopyAutoThreshold() const {
+    return zeroCopyAutoStats_.threshold;
+  }
+
+  const ZeroCopyAutoStats& getZeroCopyAutoStats() const {
+    return zeroCopyAutoStats_;
+  }
+
+  static constexpr size_t kDefaultAsyncIoReadBufferSize = 16 * 1024;
+
+  /**
+   * Submit reads and writes to the EventBase backend as completion-based
+   * operations instead of waiting for readiness and then calling
+   * recv()/sendmsg().
+   *
+   * This requires a backend that supports it (e.g. IoUringBackend); returns
+   * false otherwise, or when disabling while operations are in flight.
+   * Completed reads land in a buffer taken from the backend's buffer pool if
+   * it has one, or else in a socket-owned buffer of readBufferSize bytes, and
+   * are handed to the read callback through the pre-received data path.
+   */
+  bool setAsyncIo(
+      bool enable,
+      size_t readBufferSize = kDefaultAsyncIoReadBufferSize);
+  bool getAsyncIo() const {
+    return asyncIo_ != nullptr;
+  }
+
+  static constexpr size_t kDefaultZeroCopyReceiveSize = 256 * 1024;
+
+  /**
+   * Zero-copy receive (TCP_ZEROCOPY_RECEIVE): map the pages holding received
+   * payload into our address space instead of copying them out of the
+   * socket. Each mapping covers up to mapSize bytes (rounded up to the page
+   * size) and is handed to the read callback as a read-only IOBuf which
+   * unmaps it when freed.
+   *
+   * Only used while the read callback's isBufferMovable() returns true.
+   * Data that does not fill a whole page is still read with recv(), as are
+   * all reads once the kernel refuses the mapping. Returns false if the
+   * platform or the transport (e.g. TLS) does not support it.
+   */
+  bool setZeroCopyReceive(
+      bool enable,
+      size_t mapSize = kDefaultZeroCopyReceiveSize);
+  bool getZeroCopyReceive() const {
+    return zeroCopyReceiveSize_ != 0;
+  }
+
+  /**
+   * Number of bytes received through zero-copy mappings.
+   */
+  size_t getZeroCopyReceiveBytes() const {
+    return zeroCopyReceiveBytes_;
+  }
+
   void write(
       WriteCallback* callback,
       const void* buf,
@@ -559,6 +657,21 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
       std::unique_ptr<folly::IOBuf>&& buf,
       WriteFlags flags = WriteFlags::NONE) override;
 
+  /**
+   * Write length bytes of the file fd, starting at offset, without copying
+   * them through userspace: sendfile() on the readiness path, and spliced
+   * through a pipe when writes are completion-based (see setAsyncIo()).
+   * Ordered with the other writes like writeChain(). fd must stay open until
+   * the callback is invoked; it fails if the file ends early. Sockets that
+   * transform the data, e.g. SSL without kernel TLS, copy the file instead.
+   */
+  void writeFile(
+      WriteCallback* callback,
+      int fd,
+      off_t offset,
+      size_t length,
+      WriteFlags flags = WriteFlags::NONE);
+
   class WriteRequest;
   virtual void writeRequest(WriteRequest* req);
   void writeRequestReady() {
@@ -632,6 +745,77 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
     return getAppBytesBuffered();
   }
 
+  /**
+   * Counters of the I/O done on a socket, to find connections made
+   * inefficient by tiny writes or fragmented reads.
+   *
+   * Calls are recv(), sendmsg() and sendfile() calls, or reads and writes
+   * completed by an async I/O backend. Bytes are counted as they cross the
+   * socket, so TLS records count with their overhead.
+   */
+  struct IOStats {
+    uint64_t bytesRead{0};
+    uint64_t bytesWritten{0};
+    uint64_t readCalls{0};
+    uint64_t writeCalls{0};
+    // Calls that failed with EAGAIN
+    uint64_t readsBlocked{0};
+    uint64_t writesBlocked{0};
+    // Zero-copy writes the kernel copied anyway, or that were retried
+    // without zero-copy for lack of locked memory
+    uint64_t zeroCopyFallbacks{0};
+
+    double bytesPerRead() const {
+      return readCalls ? double(bytesRead) / double(readCalls) : 0;
+    }
+    double bytesPerWrite() const {
+      return writeCalls ? double(bytesWritten) / double(writeCalls) : 0;
+    }
+
+    IOStats& operator+=(const IOStats& other);
+  };
+
+  /**
+   * Notified with the final IOStats of sockets as they close their file
+   * descriptor, or detach it.
+   */
+  class IOStatsObserver {
+   public:
+    virtual ~IOStatsObserver() = default;
+
+    /**
+     * Must not close, destroy or detach the socket.
+     */
+    virtual void ioStatsFinished(
+        const AsyncSocket& socket,
+        const IOStats& stats) noexcept = 0;
+  };
+
+  const IOStats& getIOStats() const {
+    return ioStats_;
+  }
+
+  /**
+   * Observers are not owned, and must outlive the socket or be removed.
+   */
+  void addIOStatsObserver(IOStatsObserver* observer);
+  bool removeIOStatsObserver(IOStatsObserver* observer);
+
+  /**
+   * Totals of the IOStats of all sockets of an EventBase, including those
+   * still open. Must be called in the EventBase thread.
+   */
+  static IOStats getEventBaseIOStats(EventBase& evb);
+
+  /**
+   * Sets an observer notified about every socket of an EventBase, in
+   * addition to their own observers. Must be called in the EventBase
+   * thread.
+   */
+  static void setEventBaseIOStatsObserver(
+      EventBase& evb,
+      std::shared_ptr<IOStatsObserver> observer);
+
   std::chrono::nanoseconds getConnectTime() const {
     return connectEndTime_ - connectStartTime_;
   }
@@ -956,6 +1140,30 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
 
     virtual bool isComplete() = 0;
 
+    /**
+     * Returns the iovecs still to be written along with a buffer chain that
+     * keeps their memory alive, so that the remainder can be handed to a
+     * completion-based backend.  Returns false if the request cannot be
+     * written that way.
+     */
+    virtual bool getAsyncWriteOps(
+        const iovec** /*ops*/,
+        uint32_t* /*opCount*/,
+        WriteFlags* /*flags*/,
+        std::unique_ptr<IOBuf>* /*keepAlive*/) {
+      return false;
+    }
+
+    /**
+     * Like getAsyncWriteOps(), for requests writing a range of a file.
+     */
+    virtual bool getAsyncFileWriteOp(
+        int* /*fd*/,
+        off_t* /*offset*/,
+        size_t* /*length*/) {
+      return false;
+    }
+
     WriteRequest* getNext() const {
       return next_;
     }
@@ -1037,6 +1245,7 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   };
 
   class BytesWriteRequest;
+  class FileWriteRequest;
 
   class WriteTimeout : public AsyncTimeout {
    public:
@@ -1080,6 +1289,21 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
     AsyncSocket* socket_;
   };
 
+  class DeferredWriteCB : public folly::EventBase::LoopCallback {
+   public:
+    explicit DeferredWriteCB(AsyncSocket* socket) : socket_(socket) {}
+    void runLoopCallback() noexcept override {
+      DestructorGuard dg(socket_);
+      socket_->flushDeferredWrites();
+    }
+
+   private:
+    AsyncSocket* socket_;
+  };
+
+  // Write out the requests queued while EventBase::getDeferWrites() is set
+  void flushDeferredWrites() noexcept;
+
   /**
    * Schedule checkForImmediateRead to be executed in the next loop
    * iteration.
@@ -1125,6 +1349,15 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
    */
   virtual ReadResult performRead(void** buf, size_t* buflen, size_t* offset);
 
+  /**
+   * Attempt a zero-copy receive, see setZeroCopyReceive(). Returns nullptr
+   * if no whole page is available, in which case a regular read follows.
+   */
+  std::unique_ptr<IOBuf> performZeroCopyRead();
+
+  // Unmap the spare zero-copy receive mapping, if any.
+  void releaseZeroCopyReceiveMap();
+
   /**
    * Populate an iovec array from an IOBuf and attempt to write it.
    *
@@ -1189,6 +1422,22 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
       uint32_t* countWritten,
       uint32_t* partialWritten);
 
+  /**
+   * Attempt to write up to length bytes of a file to the socket, see
+   * writeFile().
+   *
+   * @return Returns a WriteResult. See WriteResult for more details.
+   */
+  virtual WriteResult
+  performFileWrite(int fd, off_t offset, size_t length, WriteFlags flags);
+
+  // performFileWrite() for when the bytes have to go through performWrite()
+  WriteResult
+  performFileWriteCopy(int fd, off_t offset, size_t length, WriteFlags flags);
+
+  // Queues a request writeImpl() or writeFile() could not finish right away.
+  void queueWriteRequest(WriteRequest* req, bool mustRegister, bool deferWrite);
+
   /**
    * Sends the message over the socket using sendmsg
    *
@@ -1208,6 +1457,29 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
 
   bool updateEventRegistration();
 
+  // completion-based I/O, see setAsyncIo()
+  struct AsyncIoState;
+  EventBaseBackendBase* getAsyncIoBackend() const;
+  uint16_t adjustEventFlagsForAsyncIo(uint16_t eventFlags);
+  bool startAsyncRead();
+  bool startAsyncWrite();
+  bool startAsyncFileWrite(
+      EventBaseBackendBase* backend,
+      int fd,
+      off_t offset,
+      size_t length);
+  void asyncFileSpliceComplete(int res, bool toSocket);
+  void asyncReadComplete(int res, std::unique_ptr<IOBuf> buf);
+  void asyncWriteComplete(int res);
+  void cancelAsyncIo();
+
+  // Whether the bytes on the wire are the application bytes. Subclasses that
+  // transform the data cannot hand writes to the backend or pass completed
+  // read buffers straight to the read callback.
+  virtual bool asyncIoDataPassthrough() const {
+    return true;
+  }
+
   /**
    * Update event registration.
    *
@@ -1225,6 +1497,16 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   // accidentally close it again.
   void doClose();
 
+  // Count a read or write call that returned rc, blocked if it failed
+  // with EAGAIN. Preserves errno.
+  void recordRead(ssize_t rc, bool blocked);
+  void recordWrite(ssize_t rc, bool blocked);
+  void recordZeroCopyFallbacks(uint64_t n);
+  // Reports the IOStats to the observers, before the fd goes away
+  void finishIOStats();
+  struct EventBaseIOStats;
+  EventBaseIOStats* evbIOStats();
+
   // error handling methods
   void startFail();
   void finishFail();
@@ -1267,6 +1549,10 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   void setZeroCopyBuf(std::unique_ptr<folly::IOBuf>&& buf);
   bool containsZeroCopyBuf(folly::IOBuf* ptr);
   void releaseZeroCopyBuf(uint32_t id);
+  void updateZeroCopyAutoCost(
+      std::chrono::nanoseconds elapsed,
+      uint64_t completions,
+      uint64_t copiedCompletions);
 
   AsyncWriter::ZeroCopyEnableFunc zeroCopyEnableFunc_;
 
@@ -1302,6 +1588,7 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   WriteTimeout writeTimeout_; ///< A timeout for connect and write
   IoHandler ioHandler_; ///< A EventHandler to monitor the fd
   ImmediateReadCB immediateReadHandler_; ///< LoopCallback for checking read
+  DeferredWriteCB deferredWriteHandler_; ///< LoopCallback for deferred writes
 
   ConnectCallback* connectCallback_; ///< ConnectCallback
   ErrMessageCallback* errMessageCallback_; ///< TimestampCallback
@@ -1321,6 +1608,9 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   // socket.
   std::unique_ptr<IOBuf> preReceivedData_;
 
+  // Completion-based I/O state, shared with the in-flight operations
+  std::shared_ptr<AsyncIoState> asyncIo_;
+
   std::chrono::steady_clock::time_point connectStartTime_;
   std::chrono::steady_clock::time_point connectEndTime_;
 
@@ -1336,8 +1626,24 @@ class AsyncSocket : virtual public AsyncTransportWrapper {
   bool noTSocks_{false};
   // Whether to track EOR or not.
   bool trackEor_{false};
+  // automatic zerocopy, see setZeroCopyAuto()
+  bool zeroCopyAuto_{false};
+  double zeroCopyAutoCostNs_{0};
+  ZeroCopyAutoStats zeroCopyAutoStats_;
+  // zero-copy receive mapping size; 0 if disabled
+  size_t zeroCopyReceiveSize_{0};
+  size_t zeroCopyReceiveBytes_{0};
+  // mapping of zeroCopyReceiveSize_ bytes left over from an attempt that
+  // received nothing, reused by the next attempt
+  void* zeroCopyReceiveMap_{nullptr};
   bool zeroCopyEnabled_{false};
   bool zeroCopyVal_{false};
+
+  IOStats ioStats_;
+  std::vector<IOStatsObserver*> ioStatsObservers_;
+  // Totals of the EventBase, looked up on first use
+  EventBaseIOStats* evbIOStats_{nullptr};
+
   // zerocopy re-enable logic
   size_t zeroCopyReenableThreshold_{0};
   size_t zeroCopyReenableCounter_{0};
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncSplicer.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#endif
+
+namespace folly {
+
+#ifdef __linux__
+
+namespace {
+
+// Largest chunk moved at once, so that one splicer can't hog the loop
+constexpr size_t kMaxSpliceBytes = 1 << 20;
+
+bool isPipe(NetworkSocket fd) {
+  struct stat st;
+  return fstat(fd.toFd(), &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// Whether fd has data to read, telling which side of a splice() that failed
+// with EAGAIN was blocked
+bool hasData(int fd) {
+  int n = 0;
+  return ioctl(fd, FIONREAD, &n) == 0 && n > 0;
+}
+
+ssize_t spliceSome(int in, int out, size_t bytes) {
+  ssize_t rc;
+  do {
+    rc = splice(
+        in,
+        nullptr,
+        out,
+        nullptr,
+        std::min(bytes, kMaxSpliceBytes),
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  } while (rc < 0 && errno == EINTR);
+  return rc;
+}
+
+} // namespace
+
+bool AsyncSplicer::isSupported() {
+  return true;
+}
+
+#else // __linux__
+
+bool AsyncSplicer::isSupported() {
+  return false;
+}
+
+#endif // __linux__
+
+AsyncSplicer::AsyncSplicer(
+    EventBase* evb,
+    NetworkSocket in,
+    NetworkSocket out)
+    : in_(in),
+      out_(out),
+      inHandler_(*this, evb, in),
+      outHandler_(*this, evb, out) {}
+
+AsyncSplicer::~AsyncSplicer() {
+  stop();
+}
+
+void AsyncSplicer::start(Callback* callback, size_t maxBytes) {
+  DCHECK(!running()) << "AsyncSplicer already running";
+  callback_ = callback;
+  maxBytes_ = maxBytes;
+  bytes_ = 0;
+  inEof_ = false;
+#ifdef __linux__
+  if (!pipeIn_ && !isPipe(in_) && !isPipe(out_)) {
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+      fail(AsyncSocketException(
+          AsyncSocketException::INTERNAL_ERROR, "pipe2 failed", errno));
+      return;
+    }
+    pipeOut_ = File(fds[0], true);
+    pipeIn_ = File(fds[1], true);
+  }
+  pump();
+#else
+  fail(AsyncSocketException(
+      AsyncSocketException::NOT_SUPPORTED, "splice is not supported"));
+#endif
+}
+
+void AsyncSplicer::stop() {
+  inHandler_.unregisterHandler();
+  outHandler_.unregisterHandler();
+  callback_ = nullptr;
+}
+
+void AsyncSplicer::finish() {
+  auto callback = std::exchange(callback_, nullptr);
+  inHandler_.unregisterHandler();
+  outHandler_.unregisterHandler();
+  callback->spliceDone(bytes_);
+}
+
+void AsyncSplicer::fail(const AsyncSocketException& ex) {
+  VLOG(4) << "AsyncSplicer(this=" << this << ", in=" << in_
+          << ", out=" << out_ << "): " << ex.what();
+  auto callback = std::exchange(callback_, nullptr);
+  inHandler_.unregisterHandler();
+  outHandler_.unregisterHandler();
+  callback->spliceErr(bytes_, ex);
+}
+
+void AsyncSplicer::pump() noexcept {
+#ifdef __linux__
+  DestructorGuard dg(this);
+  bool waitIn = false;
+  bool waitOut = false;
+  while (running()) {
+    // After a restart with a smaller maxBytes, more than it may already be
+    // in the pipe; the rest stays there for the next start().
+    if (bytes_ == maxBytes_ || (inEof_ && buffered_ == 0)) {
+      finish();
+      return;
+    }
+
+    if (!pipeIn_) {
+      auto rc = spliceSome(in_.toFd(), out_.toFd(), maxBytes_ - bytes_);
+      if (rc > 0) {
+        bytes_ += size_t(rc);
+      } else if (rc == 0) {
+        inEof_ = true;
+      } else if (errno == EAGAIN) {
+        (hasData(in_.toFd()) ? waitOut : waitIn) = true;
+        break;
+      } else {
+        fail(AsyncSocketException(
+            AsyncSocketException::INTERNAL_ERROR, "splice failed", errno));
+        return;
+      }
+      continue;
+    }
+
+    // Fill the pipe from in_, then drain it into out_
+    bool progress = false;
+    size_t left = maxBytes_ - bytes_;
+    size_t wanted = left > buffered_ ? left - buffered_ : 0;
+    if (!inEof_ && wanted > 0) {
+      auto rc = spliceSome(in_.toFd(), pipeIn_.fd(), wanted);
+      if (rc > 0) {
+        buffered_ += size_t(rc);
+        progress = true;
+      } else if (rc == 0) {
+        inEof_ = true;
+        progress = true;
+      } else if (errno != EAGAIN) {
+        fail(AsyncSocketException(
+            AsyncSocketException::INTERNAL_ERROR, "splice failed", errno));
+        return;
+      } else if (!hasData(in_.toFd())) {
+        waitIn = true;
+      }
+    }
+    if (buffered_ > 0) {
+      auto rc =
+          spliceSome(pipeOut_.fd(), out_.toFd(), std::min(buffered_, left));
+      if (rc > 0) {
+        buffered_ -= size_t(rc);
+        bytes_ += size_t(rc);
+        progress = true;
+      } else if (rc < 0 && errno == EAGAIN) {
+        waitOut = true;
+      } else {
+        fail(AsyncSocketException(
+            AsyncSocketException::INTERNAL_ERROR, "splice failed", errno));
+        return;
+      }
+    }
+    if (!progress) {
+      break;
+    }
+    waitIn = waitOut = false;
+  }
+  if (!running()) {
+    return;
+  }
+  if (!waitIn && !waitOut) {
+    waitIn = true;
+  }
+  if (waitIn) {
+    inHandler_.registerHandler(EventHandler::READ);
+  } else {
+    inHandler_.unregisterHandler();
+  }
+  if (waitOut) {
+    outHandler_.registerHandler(EventHandler::WRITE);
+  } else {
+    outHandler_.unregisterHandler();
+  }
+#endif
+}
+
+} // namespace folly
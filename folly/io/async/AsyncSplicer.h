@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <limits>
+#include <memory>
+
+#include <folly/File.h>
+#include <folly/io/async/AsyncSocketException.h>
+#include <folly/io/async/DelayedDestruction.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <folly/net/NetworkSocket.h>
+
+namespace folly {
+
+/**
+ * Moves data from one file descriptor to another from an EventBase loop
+ * with splice(2), so that it never gets copied to user space.
+ *
+ * splice() needs a pipe on one side: data from a pipe (e.g. the output of a
+ * Subprocess, or the read end of an AsyncPipeWriter's pipe) goes straight
+ * to a socket, and data from a socket straight into a pipe. Between two
+ * sockets, it goes through a pipe owned by the splicer.
+ *
+ *   auto splicer = AsyncSplicer::newSplicer(
+ *       &evb,
+ *       NetworkSocket::fromFd(proc.stdoutFd()),
+ *       socket->getNetworkSocket());
+ *   splicer->start(&callback);
+ *
+ * Both descriptors must be non-blocking, and are neither owned nor closed
+ * by the splicer. While it runs, nothing else may read from the source or
+ * write to the destination, so an AsyncSocket being spliced must not have
+ * a read callback nor pending writes. As with AsyncPipeWriter, SIGPIPE must
+ * be ignored to get EPIPE errors when the destination is closed.
+ *
+ * splice() is Linux specific; elsewhere start() fails with NOT_SUPPORTED.
+ */
+class AsyncSplicer : public DelayedDestruction {
+ public:
+  using UniquePtr = std::unique_ptr<AsyncSplicer, Destructor>;
+
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+
+    /**
+     * The source reached EOF, or maxBytes were moved.
+     */
+    virtual void spliceDone(size_t bytes) noexcept = 0;
+
+    /**
+     * Splicing failed after moving the given number of bytes.
+     */
+    virtual void spliceErr(
+        size_t bytes,
+        const AsyncSocketException& ex) noexcept = 0;
+  };
+
+  static UniquePtr
+  newSplicer(EventBase* evb, NetworkSocket in, NetworkSocket out) {
+    return UniquePtr(new AsyncSplicer(evb, in, out));
+  }
+
+  AsyncSplicer(EventBase* evb, NetworkSocket in, NetworkSocket out);
+
+  /**
+   * Starts moving up to maxBytes from the source to the destination, and
+   * calls back once done. May be called again after the callback ran, to
+   * move more.
+   */
+  void start(
+      Callback* callback,
+      size_t maxBytes = std::numeric_limits<size_t>::max());
+
+  /**
+   * Stops without calling back. Data already taken from a socket source may
+   * remain in the splicer's pipe, and is moved first if restarted; it counts
+   * towards the maxBytes of that start(), and what exceeds them stays in the
+   * pipe.
+   */
+  void stop();
+
+  bool running() const {
+    return callback_ != nullptr;
+  }
+
+  /**
+   * Bytes moved to the destination since the last start().
+   */
+  size_t bytesSpliced() const {
+    return bytes_;
+  }
+
+  static bool isSupported();
+
+ protected:
+  ~AsyncSplicer() override;
+
+ private:
+  class Handler : public EventHandler {
+   public:
+    Handler(AsyncSplicer& splicer, EventBase* evb, NetworkSocket fd)
+        : EventHandler(evb, fd), splicer_(splicer) {}
+
+    void handlerReady(uint16_t) noexcept override {
+      splicer_.pump();
+    }
+
+   private:
+    AsyncSplicer& splicer_;
+  };
+
+  void pump() noexcept;
+  void finish();
+  void fail(const AsyncSocketException& ex);
+
+  NetworkSocket in_;
+  NetworkSocket out_;
+  Handler inHandler_;
+  Handler outHandler_;
+  // Between in_ and out_ when neither of them is a pipe
+  File pipeIn_;
+  File pipeOut_;
+  size_t buffered_{0};
+  bool inEof_{false};
+
+  Callback* callback_{nullptr};
+  size_t maxBytes_{0};
+  size_t bytes_{0};
+};
+
+} // namespace folly
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncSubprocessWaiter.h>
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <folly/Exception.h>
+#include <folly/portability/SysSyscall.h>
+#include <folly/portability/Unistd.h>
+
+namespace folly {
+
+namespace {
+
+// pidfd_open(2) has no wrapper in older C libraries
+int pidfdOpen(pid_t pid) {
+#if defined(__linux__) && defined(__NR_pidfd_open)
+  return static_cast<int>(syscall(__NR_pidfd_open, pid, 0));
+#else
+  (void)pid;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+} // namespace
+
+AsyncSubprocessWaiter::AsyncSubprocessWaiter(
+    EventBase* evb,
+    Subprocess& proc,
+    Callback callback)
+    : EventHandler(evb), proc_(proc), callback_(std::move(callback)) {
+  if (proc_.returnCode().state() != ProcessReturnCode::RUNNING) {
+    throw std::logic_error("AsyncSubprocessWaiter: process is not running");
+  }
+  int fd = pidfdOpen(proc_.pid());
+  if (fd == -1) {
+    throwSystemError("AsyncSubprocessWaiter: pidfd_open failed");
+  }
+  pidfd_ = File(fd, /*ownsFd=*/true);
+  changeHandlerFD(NetworkSocket::fromFd(fd));
+  registerHandler(EventHandler::READ | EventHandler::PERSIST);
+}
+
+AsyncSubprocessWaiter::~AsyncSubprocessWaiter() {
+  unregisterHandler();
+}
+
+bool AsyncSubprocessWaiter::isSupported() {
+  static const bool supported = [] {
+    int fd = pidfdOpen(getpid());
+    if (fd == -1) {
+      return false;
+    }
+    ::close(fd);
+    return true;
+  }();
+  return supported;
+}
+
+void AsyncSubprocessWaiter::handlerReady(uint16_t /* events */) noexcept {
+  // The process may have been reaped through the Subprocess meanwhile
+  auto rc = proc_.returnCode();
+  if (rc.running()) {
+    rc = proc_.poll();
+    if (rc.running()) {
+      return;
+    }
+  }
+  unregisterHandler();
+  // The callback may destroy this
+  auto callback = std::move(callback_);
+  callback(rc);
+}
+
+} // namespace folly
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <folly/Subprocess.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+
+namespace folly {
+
+/**
+ * Waits for a Subprocess to exit from an EventBase loop, without blocking
+ * the loop, polling, or handling SIGCHLD.
+ *
+ * The process is watched through a pidfd, which becomes readable once the
+ * process exits, so this works with any EventBase backend (libevent,
+ * io_uring, ...).  pidfds require Linux 5.3 or later.
+ *
+ *   Subprocess proc(argv);
+ *   AsyncSubprocessWaiter waiter(&evb, proc, [&](ProcessReturnCode rc) {
+ *     LOG(INFO) << "child " << rc.str();
+ *   });
+ *
+ * The callback runs in the EventBase thread once the process was reaped
+ * with Subprocess::poll(), and may destroy the waiter.  Destroying the
+ * waiter before then stops waiting, leaving the Subprocess to be reaped in
+ * another way.  The waiter must be created and destroyed in the EventBase
+ * thread.
+ */
+class AsyncSubprocessWaiter : private EventHandler {
+ public:
+  using Callback = Function<void(ProcessReturnCode)>;
+
+  /**
+   * Throws std::system_error if the process can't be watched, e.g. on
+   * kernels without pidfds, and std::logic_error if it was already reaped.
+   */
+  AsyncSubprocessWaiter(EventBase* evb, Subprocess& proc, Callback callback);
+  ~AsyncSubprocessWaiter() override;
+
+  /**
+   * Whether the system supports watching processes, i.e. has pidfds.
+   */
+  static bool isSupported();
+
+ private:
+  void handlerReady(uint16_t events) noexcept override;
+
+  Subprocess& proc_;
+  Callback callback_;
+  File pidfd_;
+};
+
+} // namespace folly
@@ -168,6 +168,8 @@ void AsyncTimeout::libeventCallback(libevent_fd_t fd, short events, void* arg) {
 
   RequestContextScopeGuard rctx(timeout->context_);
 
+  EventBase::LoopPhaseGuard phase(
+      timeout->event_.eb_ev_base(), EventBaseLoopPhaseTimes::TIMERS);
   timeout->timeoutExpired();
 }
 
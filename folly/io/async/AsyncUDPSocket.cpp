@@ -41,6 +41,35 @@ namespace fsp = folly::portability::sockets;
 
 namespace folly {
 
+void AsyncUDPSocket::ReadCallback::onDataAvailableBatch(
+    ReadPacket* packets,
+    size_t num) noexcept {
+  for (size_t i = 0; i < num; ++i) {
+    auto& packet = packets[i];
+    const uint8_t* data = packet.buf->data();
+    size_t left = packet.buf->length();
+    // split up the coalesced datagrams
+    while (left > 0) {
+      size_t len = packet.groSegmentSize
+          ? std::min(left, packet.groSegmentSize)
+          : left;
+      void* buf = nullptr;
+      size_t bufLen = 0;
+      getReadBuffer(&buf, &bufLen);
+      if (buf == nullptr || bufLen == 0) {
+        return;
+      }
+
+      size_t copyLen = std::min(len, bufLen);
+      memcpy(buf, data, copyLen);
+      onDataAvailable(
+          packet.client, copyLen, packet.truncated || copyLen < len);
+      data += len;
+      left -= len;
+    }
+  }
+}
+
 AsyncUDPSocket::AsyncUDPSocket(EventBase* evb)
     : EventHandler(CHECK_NOTNULL(evb)),
       readCallback_(nullptr),
@@ -294,11 +323,36 @@ ssize_t AsyncUDPSocket::write(
   return writeGSO(address, buf, 0);
 }
 
+ssize_t AsyncUDPSocket::writeWithOptions(
+    const folly::SocketAddress& address,
+    const std::unique_ptr<folly::IOBuf>& buf,
+    const WriteOptions& options) {
+  iovec vec[16];
+  size_t iovec_len = buf->fillIov(vec, sizeof(vec) / sizeof(vec[0])).numIovecs;
+  if (UNLIKELY(iovec_len == 0)) {
+    buf->coalesce();
+    vec[0].iov_base = const_cast<uint8_t*>(buf->data());
+    vec[0].iov_len = buf->length();
+    iovec_len = 1;
+  }
+
+  return writevImpl(address, vec, iovec_len, options);
+}
+
 ssize_t AsyncUDPSocket::writev(
     const folly::SocketAddress& address,
     const struct iovec* vec,
     size_t iovec_len,
     int gso) {
+  return writevImpl(
+      address, vec, iovec_len, WriteOptions(gso, std::chrono::microseconds(0)));
+}
+
+ssize_t AsyncUDPSocket::writevImpl(
+    const folly::SocketAddress& address,
+    const struct iovec* vec,
+    size_t iovec_len,
+    const WriteOptions& options) {
   CHECK_NE(NetworkSocket(), fd_) << "Socket not yet bound";
   sockaddr_storage addrStorage;
   address.getAddress(&addrStorage);
@@ -317,30 +371,82 @@ ssize_t AsyncUDPSocket::writev(
   }
   msg.msg_iov = const_cast<struct iovec*>(vec);
   msg.msg_iovlen = iovec_len;
+  msg.msg_flags = 0;
+
+  char control[kWriteControlSize];
+  if (!fillWriteControl(
+          msg,
+          control,
+          options,
+          options.txTime.count() > 0 ? getTXTimeNow() : 0)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return sendmsg(fd_, &msg, 0);
+}
+
+bool AsyncUDPSocket::fillWriteControl(
+    struct msghdr& msg,
+    char* control,
+    const WriteOptions& options,
+    uint64_t nowNs) {
   msg.msg_control = nullptr;
   msg.msg_controllen = 0;
-  msg.msg_flags = 0;
+  bool txTime = options.txTime.count() > 0;
+  if (txTime && !txTime_) {
+    return false;
+  }
 
 #ifdef FOLLY_HAVE_MSG_ERRQUEUE
-  if (gso > 0) {
-    char control[CMSG_SPACE(sizeof(uint16_t))];
-    msg.msg_control = control;
-    msg.msg_controllen = sizeof(control);
+  size_t len = 0;
+  if (options.gso > 0) {
+    len += CMSG_SPACE(sizeof(uint16_t));
+  }
+  if (txTime) {
+    len += CMSG_SPACE(sizeof(uint64_t));
+  }
+  if (!len) {
+    return true;
+  }
 
-    struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+  DCHECK_LE(len, kWriteControlSize);
+  memset(control, 0, len);
+  msg.msg_control = control;
+  msg.msg_controllen = len;
+
+  struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+  if (options.gso > 0) {
     cm->cmsg_level = SOL_UDP;
     cm->cmsg_type = UDP_SEGMENT;
     cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
-    auto gso_len = static_cast<uint16_t>(gso);
+    auto gso_len = static_cast<uint16_t>(options.gso);
     memcpy(CMSG_DATA(cm), &gso_len, sizeof(gso_len));
-
-    return sendmsg(fd_, &msg, 0);
+    cm = CMSG_NXTHDR(&msg, cm);
+  }
+  if (txTime) {
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_TXTIME;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    uint64_t ts = nowNs +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(options.txTime)
+            .count();
+    memcpy(CMSG_DATA(cm), &ts, sizeof(ts));
   }
 #else
-  CHECK_LT(gso, 1) << "GSO not supported";
+  (void)control;
+  (void)nowNs;
+  CHECK_LT(options.gso, 1) << "GSO not supported";
 #endif
 
-  return sendmsg(fd_, &msg, 0);
+  return true;
+}
+
+uint64_t AsyncUDPSocket::getTXTimeNow() const {
+  struct timespec ts;
+  clock_gettime(txTime_ ? txTime_->clockid : CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+      static_cast<uint64_t>(ts.tv_nsec);
 }
 
 ssize_t AsyncUDPSocket::writev(
@@ -375,6 +481,50 @@ int AsyncUDPSocket::writem(
   return ret;
 }
 
+int AsyncUDPSocket::writemWithOptions(
+    const folly::SocketAddress& address,
+    const std::unique_ptr<folly::IOBuf>* bufs,
+    size_t count,
+    const WriteOptions* options) {
+  CHECK_NE(NetworkSocket(), fd_) << "Socket not yet bound";
+  sockaddr_storage addrStorage;
+  address.getAddress(&addrStorage);
+
+  size_t iov_count = 0;
+  bool txTime = false;
+  for (size_t i = 0; i < count; i++) {
+    iov_count += bufs[i]->countChainElements();
+    txTime = txTime || options[i].txTime.count() > 0;
+  }
+
+  std::unique_ptr<mmsghdr[]> msgvec(new mmsghdr[count]);
+  std::unique_ptr<iovec[]> iov(new iovec[iov_count]);
+  std::unique_ptr<char[]> control(new char[count * kWriteControlSize]);
+  fillMsgVec(
+      &addrStorage,
+      address.getActualSize(),
+      bufs,
+      count,
+      msgvec.get(),
+      iov.get(),
+      iov_count);
+
+  // all the departure times are relative to the same now
+  uint64_t nowNs = txTime ? getTXTimeNow() : 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!fillWriteControl(
+            msgvec[i].msg_hdr,
+            &control[i * kWriteControlSize],
+            options[i],
+            nowNs)) {
+      errno = EINVAL;
+      return -1;
+    }
+  }
+
+  return sendmmsg(fd_, msgvec.get(), count, 0);
+}
+
 void AsyncUDPSocket::fillMsgVec(
     sockaddr_storage* addr,
     socklen_t addr_len,
@@ -455,6 +605,24 @@ ssize_t AsyncUDPSocket::recvmsg(struct msghdr* msg, int flags) {
   return netops::recvmsg(fd_, msg, flags);
 }
 
+int AsyncUDPSocket::recvmmsg(
+    struct mmsghdr* msgvec,
+    unsigned int vlen,
+    unsigned int flags,
+    struct timespec* timeout) {
+  return netops::recvmmsg(fd_, msgvec, vlen, flags, timeout);
+}
+
+void AsyncUDPSocket::setReadBatch(size_t numPackets, size_t bufferSize) {
+  CHECK_GT(bufferSize, 0);
+  readBatchSize_ = std::max<size_t>(numPackets, 1);
+  if (bufferSize != readBatchBufferSize_) {
+    readBatchBufferSize_ = bufferSize;
+    readBatchBufs_.clear();
+  }
+  readBatchBufs_.resize(readBatchSize_ > 1 ? readBatchSize_ : 0);
+}
+
 void AsyncUDPSocket::resumeRead(ReadCallback* cob) {
   CHECK(!readCallback_) << "Another read callback already installed";
   CHECK_NE(NetworkSocket(), fd_)
@@ -598,6 +766,10 @@ void AsyncUDPSocket::handleRead() noexcept {
     return readCallback_->onNotifyDataAvailable();
   }
 
+  if (readBatchSize_ > 1) {
+    return handleReadBatch();
+  }
+
   readCallback_->getReadBuffer(&buf, &len);
   if (buf == nullptr || len == 0) {
     AsyncSocketException ex(
@@ -653,6 +825,101 @@ void AsyncUDPSocket::handleRead() noexcept {
   }
 }
 
+void AsyncUDPSocket::handleReadBatch() noexcept {
+  const size_t num = readBatchSize_;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  const bool gro = gro_.hasValue() && gro_.value() > 0;
+  const size_t ctrlSize = CMSG_SPACE(sizeof(int));
+#else
+  const bool gro = false;
+  const size_t ctrlSize = 0;
+#endif
+
+  readBatchBufs_.resize(num);
+  readBatchMsgs_.resize(num);
+  readBatchIovs_.resize(num);
+  readBatchAddrs_.resize(num);
+  readBatchCtrl_.resize(gro ? num * ctrlSize : 0);
+  for (size_t i = 0; i < num; ++i) {
+    if (!readBatchBufs_[i]) {
+      readBatchBufs_[i] = IOBuf::create(readBatchBufferSize_);
+    }
+    readBatchIovs_[i].iov_base = readBatchBufs_[i]->writableData();
+    readBatchIovs_[i].iov_len = readBatchBufferSize_;
+
+    auto& msg = readBatchMsgs_[i].msg_hdr;
+    msg.msg_name = reinterpret_cast<void*>(&readBatchAddrs_[i]);
+    msg.msg_namelen = sizeof(sockaddr_storage);
+    msg.msg_iov = &readBatchIovs_[i];
+    msg.msg_iovlen = 1;
+    msg.msg_control = gro ? &readBatchCtrl_[i * ctrlSize] : nullptr;
+    msg.msg_controllen = gro ? ctrlSize : 0;
+    msg.msg_flags = 0;
+    readBatchMsgs_[i].msg_len = 0;
+  }
+
+  int ret = recvmmsg(
+      readBatchMsgs_.data(), static_cast<unsigned int>(num), 0, nullptr);
+  if (ret < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      // No data could be read without blocking the socket
+      return;
+    }
+
+    AsyncSocketException ex(
+        AsyncSocketException::INTERNAL_ERROR, "::recvmmsg() failed", errno);
+
+    // In case of UDP we can continue reading from the socket
+    // even if the current request fails.
+    auto cob = readCallback_;
+    readCallback_ = nullptr;
+
+    cob->onReadError(ex);
+    updateRegistration();
+    return;
+  }
+
+  auto numRead = static_cast<size_t>(ret);
+  readBatchPackets_.resize(numRead);
+  for (size_t i = 0; i < numRead; ++i) {
+    auto& msg = readBatchMsgs_[i].msg_hdr;
+    auto& packet = readBatchPackets_[i];
+    packet.buf = std::move(readBatchBufs_[i]);
+    packet.buf->append(
+        std::min<size_t>(readBatchMsgs_[i].msg_len, readBatchBufferSize_));
+    packet.client.setFromSockaddr(
+        reinterpret_cast<sockaddr*>(msg.msg_name), msg.msg_namelen);
+    packet.truncated = (msg.msg_flags & MSG_TRUNC);
+    packet.groSegmentSize = 0;
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+    if (gro) {
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int segSize;
+          memcpy(&segSize, CMSG_DATA(cmsg), sizeof(segSize));
+          packet.groSegmentSize = static_cast<size_t>(segSize);
+          break;
+        }
+      }
+    }
+#endif
+  }
+
+  readCallback_->onDataAvailableBatch(readBatchPackets_.data(), numRead);
+
+  // reuse the buffers the callback did not take
+  for (size_t i = 0; i < numRead; ++i) {
+    auto& buf = readBatchPackets_[i].buf;
+    if (buf && !buf->isShared() && i < readBatchBufs_.size() &&
+        buf->capacity() >= readBatchBufferSize_) {
+      buf->clear();
+      readBatchBufs_[i] = std::move(buf);
+    }
+  }
+  readBatchPackets_.clear();
+}
+
 bool AsyncUDPSocket::updateRegistration() noexcept {
   uint16_t flags = NONE;
 
@@ -676,6 +943,39 @@ bool AsyncUDPSocket::setGSO(int val) {
 #endif
 }
 
+bool AsyncUDPSocket::setGRO(bool bVal) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  int val = bVal ? 1 : 0;
+  int ret = netops::setsockopt(fd_, SOL_UDP, UDP_GRO, &val, sizeof(val));
+
+  gro_ = ret ? -1 : val;
+
+  return !ret;
+#else
+  (void)bVal;
+  return false;
+#endif
+}
+
+int AsyncUDPSocket::getGRO() {
+  // check if we can return the cached value
+  if (FOLLY_UNLIKELY(!gro_.hasValue())) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+    int gro = -1;
+    socklen_t optlen = sizeof(gro);
+    if (!netops::getsockopt(fd_, SOL_UDP, UDP_GRO, &gro, &optlen)) {
+      gro_ = gro;
+    } else {
+      gro_ = -1;
+    }
+#else
+    gro_ = -1;
+#endif
+  }
+
+  return gro_.value();
+}
+
 int AsyncUDPSocket::getGSO() {
   // check if we can return the cached value
   if (FOLLY_UNLIKELY(!gso_.hasValue())) {
@@ -703,6 +1003,61 @@ void AsyncUDPSocket::setTrafficClass(int tclass) {
   }
 }
 
+bool AsyncUDPSocket::setTXTime(TXTime txTime) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  // struct sock_txtime, which older kernel headers do not have
+  struct {
+    clockid_t clockid;
+    uint32_t flags;
+  } val;
+  val.clockid = txTime.clockid;
+  val.flags = txTime.deadline ? (1U << 0) /* SOF_TXTIME_DEADLINE_MODE */ : 0;
+  if (netops::setsockopt(fd_, SOL_SOCKET, SO_TXTIME, &val, sizeof(val))) {
+    return false;
+  }
+
+  txTime_ = txTime;
+  return true;
+#else
+  (void)txTime;
+  return false;
+#endif
+}
+
+bool AsyncUDPSocket::setTimestamping(int flags) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  return !netops::setsockopt(
+      fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+#else
+  (void)flags;
+  return false;
+#endif
+}
+
+folly::Optional<AsyncUDPSocket::Timestamps> AsyncUDPSocket::parseTimestamps(
+    const cmsghdr& cmsg) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  // struct scm_timestamping: software, deprecated, raw hardware
+  struct timespec ts[3];
+  if (cmsg.cmsg_level != SOL_SOCKET || cmsg.cmsg_type != SCM_TIMESTAMPING ||
+      cmsg.cmsg_len < CMSG_LEN(sizeof(ts))) {
+    return folly::none;
+  }
+
+  memcpy(ts, CMSG_DATA(&cmsg), sizeof(ts));
+  auto toNs = [](const struct timespec& t) {
+    return std::chrono::seconds(t.tv_sec) + std::chrono::nanoseconds(t.tv_nsec);
+  };
+  Timestamps timestamps;
+  timestamps.software = toNs(ts[0]);
+  timestamps.hardware = toNs(ts[2]);
+  return timestamps;
+#else
+  (void)cmsg;
+  return folly::none;
+#endif
+}
+
 void AsyncUDPSocket::detachEventBase() {
   DCHECK(eventBase_ && eventBase_->isInEventBaseThread());
   registerHandler(uint16_t(NONE));
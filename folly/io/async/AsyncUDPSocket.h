@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include <folly/ScopeGuard.h>
 #include <folly/SocketAddress.h>
@@ -27,6 +29,7 @@
 #include <folly/io/async/EventHandler.h>
 #include <folly/net/NetOps.h>
 #include <folly/net/NetworkSocket.h>
+#include <folly/portability/Time.h>
 
 namespace folly {
 
@@ -77,6 +80,29 @@ class AsyncUDPSocket : public EventHandler {
       return false;
     }
 
+    /**
+     * A datagram read in batched mode, see AsyncUDPSocket::setReadBatch().
+     * With GRO enabled, `buf` can hold several datagrams from the same peer,
+     * each of `groSegmentSize` bytes except for the last one, which may be
+     * shorter. `groSegmentSize` is 0 if the buffer holds a single datagram.
+     */
+    struct ReadPacket {
+      std::unique_ptr<folly::IOBuf> buf;
+      folly::SocketAddress client;
+      bool truncated{false};
+      size_t groSegmentSize{0};
+    };
+
+    /**
+     * Invoked in batched mode with the packets read by one recvmmsg() call.
+     * The callback can take ownership of the buffers.
+     *
+     * The default implementation copies each datagram into the buffer from
+     * getReadBuffer() and calls onDataAvailable(). It does not stop if
+     * reading is paused halfway through a batch.
+     */
+    virtual void onDataAvailableBatch(ReadPacket* packets, size_t num) noexcept;
+
     /**
      * Invoked when there is an error reading from the socket.
      *
@@ -181,6 +207,37 @@ class AsyncUDPSocket : public EventHandler {
       const std::unique_ptr<folly::IOBuf>& buf,
       int gso);
 
+  struct WriteOptions {
+    WriteOptions() = default;
+    WriteOptions(int gsoVal, std::chrono::microseconds txTimeVal)
+        : gso(gsoVal), txTime(txTimeVal) {}
+
+    // generic segmentation offload value, see writeGSO()
+    int gso{0};
+    // earliest departure time, relative to now; 0 sends right away
+    // requires setTXTime()
+    std::chrono::microseconds txTime{0};
+  };
+
+  /**
+   * Like writeGSO(), with an optional departure time.
+   */
+  virtual ssize_t writeWithOptions(
+      const folly::SocketAddress& address,
+      const std::unique_ptr<folly::IOBuf>& buf,
+      const WriteOptions& options);
+
+  /**
+   * Like writem(), with per buffer options. Combined with setTXTime() this
+   * hands a paced burst to the kernel in a single ::sendmmsg call.
+   * options is an array of size num.
+   */
+  virtual int writemWithOptions(
+      const folly::SocketAddress& address,
+      const std::unique_ptr<folly::IOBuf>* bufs,
+      size_t num,
+      const WriteOptions* options);
+
   /**
    * Send data in iovec to destination. Returns the return code from sendmsg.
    */
@@ -197,6 +254,35 @@ class AsyncUDPSocket : public EventHandler {
 
   virtual ssize_t recvmsg(struct msghdr* msg, int flags);
 
+  virtual int recvmmsg(
+      struct mmsghdr* msgvec,
+      unsigned int vlen,
+      unsigned int flags,
+      struct timespec* timeout);
+
+  static constexpr size_t kDefaultReadBatchBufferSize = 2048;
+
+  /**
+   * Batched reads: drain up to numPackets datagrams per read event with a
+   * single recvmmsg() call into buffers of bufferSize bytes owned by the
+   * socket, and pass them to ReadCallback::onDataAvailableBatch().
+   * numPackets <= 1 turns it off. The buffer size should be raised to
+   * 64KB along with setGRO().
+   */
+  void setReadBatch(
+      size_t numPackets,
+      size_t bufferSize = kDefaultReadBatchBufferSize);
+
+  size_t getReadBatchSize() const {
+    return readBatchSize_;
+  }
+
+  // generic receive offload get/set, only useful with batched reads
+  // negative return value means GRO is not available
+  int getGRO();
+
+  bool setGRO(bool bVal);
+
   /**
    * Start reading datagrams
    */
@@ -327,6 +413,39 @@ class AsyncUDPSocket : public EventHandler {
 
   void setTrafficClass(int tclass);
 
+  struct TXTime {
+    clockid_t clockid{CLOCK_MONOTONIC};
+    // drop datagrams that miss their departure time
+    bool deadline{false};
+  };
+
+  /**
+   * Enables departure times (SO_TXTIME) on writes, see WriteOptions. They
+   * are only honored by qdiscs that support it (fq, etf), fq requires
+   * CLOCK_MONOTONIC. Returns false if not supported.
+   */
+  bool setTXTime(TXTime txTime);
+
+  folly::Optional<TXTime> getTXTime() const {
+    return txTime_;
+  }
+
+  /**
+   * Asks the kernel to timestamp sent datagrams (SO_TIMESTAMPING with the
+   * given SOF_TIMESTAMPING_* flags). The timestamps are read back from the
+   * error queue while reading, and passed to the ErrMessageCallback; use
+   * parseTimestamps() on them. Returns false if not supported.
+   */
+  bool setTimestamping(int flags);
+
+  struct Timestamps {
+    std::chrono::nanoseconds software{0};
+    std::chrono::nanoseconds hardware{0};
+  };
+
+  // returns the timestamps carried by an SCM_TIMESTAMPING message
+  static folly::Optional<Timestamps> parseTimestamps(const cmsghdr& cmsg);
+
  protected:
   virtual ssize_t
   sendmsg(NetworkSocket socket, const struct msghdr* message, int flags) {
@@ -371,6 +490,24 @@ class AsyncUDPSocket : public EventHandler {
   void handlerReady(uint16_t events) noexcept override;
 
   void handleRead() noexcept;
+  void handleReadBatch() noexcept;
+
+  ssize_t writevImpl(
+      const folly::SocketAddress& address,
+      const struct iovec* vec,
+      size_t veclen,
+      const WriteOptions& options);
+
+  // room for the control messages of a single datagram
+  static constexpr size_t kWriteControlSize = 64;
+
+  // returns false if the options can not be applied
+  bool fillWriteControl(
+      struct msghdr& msg,
+      char* control,
+      const WriteOptions& options,
+      uint64_t nowNs);
+  uint64_t getTXTimeNow() const;
   bool updateRegistration() noexcept;
 
   EventBase* eventBase_;
@@ -396,6 +533,22 @@ class AsyncUDPSocket : public EventHandler {
   // See https://lwn.net/Articles/188489/ for more details
   folly::Optional<int> gso_;
 
+  // generic receive offload value, if available
+  folly::Optional<int> gro_;
+
+  folly::Optional<TXTime> txTime_;
+
+  // batched reads, the buffers are allocated on demand and reused until the
+  // read callback takes them
+  size_t readBatchSize_{1};
+  size_t readBatchBufferSize_{kDefaultReadBatchBufferSize};
+  std::vector<std::unique_ptr<folly::IOBuf>> readBatchBufs_;
+  std::vector<struct mmsghdr> readBatchMsgs_;
+  std::vector<struct iovec> readBatchIovs_;
+  std::vector<sockaddr_storage> readBatchAddrs_;
+  std::vector<char> readBatchCtrl_;
+  std::vector<ReadCallback::ReadPacket> readBatchPackets_;
+
   ErrMessageCallback* errMessageCallback_{nullptr};
 };
 
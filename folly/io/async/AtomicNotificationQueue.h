@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <folly/io/async/Request.h>
+#include <folly/lang/Align.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/Unistd.h>
+
+#include <glog/logging.h>
+
+#if __linux__ && !__ANDROID__
+#include <folly/io/async/EventFDWrapper.h>
+#endif
+
+namespace folly {
+
+/**
+ * A multi-producer single-consumer queue of tasks for one EventBase thread.
+ *
+ * Unlike NotificationQueue, producers never take a lock: a task is pushed
+ * onto an intrusive stack with a single compare-and-swap, and the consumer
+ * takes the whole stack at once and runs it in FIFO order. The eventfd (or
+ * pipe) is only written when the consumer has "armed" the queue, which it
+ * does after finding it empty, right before going back to wait for events.
+ * While the consumer is busy, producers do not make any syscalls.
+ *
+ * Consumer must be callable as consumer(Task&&) noexcept; the task runs with
+ * the RequestContext that was current when it was enqueued.
+ */
+template <typename Task, typename Consumer>
+class AtomicNotificationQueue : private EventHandler {
+ public:
+  enum : uint32_t { kDefaultMaxReadAtOnce = 10 };
+
+  explicit AtomicNotificationQueue(Consumer&& consumer = Consumer())
+      : consumer_(std::move(consumer)) {
+#if __linux__ && !__ANDROID__
+    eventfd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventfd_ == -1 && errno != ENOSYS && errno != EINVAL) {
+      folly::throwSystemError("Failed to create eventfd");
+    }
+#endif
+    if (eventfd_ == -1) {
+      if (pipe(pipeFds_)) {
+        folly::throwSystemError("Failed to create pipe");
+      }
+      if (fcntl(pipeFds_[0], F_SETFL, O_RDONLY | O_NONBLOCK) != 0 ||
+          fcntl(pipeFds_[1], F_SETFL, O_WRONLY | O_NONBLOCK) != 0) {
+        auto errnoCopy = errno;
+        ::close(pipeFds_[0]);
+        ::close(pipeFds_[1]);
+        folly::throwSystemError("Failed to make pipe non-blocking", errnoCopy);
+      }
+    }
+  }
+
+  ~AtomicNotificationQueue() override {
+    stopConsuming();
+    freeList(local_);
+    freeList(takeAll());
+    if (eventfd_ >= 0) {
+      ::close(eventfd_);
+    }
+    if (pipeFds_[0] >= 0) {
+      ::close(pipeFds_[0]);
+      ::close(pipeFds_[1]);
+    }
+  }
+
+  /**
+   * Enqueue a task. Thread-safe.
+   */
+  template <typename T>
+  void putMessage(T&& task) {
+    auto* node = new Node(std::forward<T>(task), RequestContext::saveContext());
+    size_.fetch_add(1, std::memory_order_relaxed);
+    auto* head = head_.load(std::memory_order_relaxed);
+    do {
+      node->next = head == armed() ? nullptr : head;
+    } while (!head_.compare_exchange_weak(
+        head, node, std::memory_order_release, std::memory_order_relaxed));
+    if (head == armed()) {
+      // the consumer is (about to be) waiting for the fd
+      notifyFd();
+    }
+  }
+
+  /**
+   * Enqueue the tasks of [first, last) in order, with the cost of a single
+   * putMessage(). Thread-safe.
+   */
+  template <typename InputIt>
+  void putMessages(InputIt first, InputIt last) {
+    Node* top = nullptr;
+    Node* bottom = nullptr;
+    ssize_t count = 0;
+    auto rctx = RequestContext::saveContext();
+    try {
+      for (; first != last; ++first) {
+        auto* node = new Node(*first, rctx);
+        node->next = top;
+        top = node;
+        if (!bottom) {
+          bottom = node;
+        }
+        ++count;
+      }
+    } catch (...) {
+      freeList(top);
+      throw;
+    }
+    if (!top) {
+      return;
+    }
+    size_.fetch_add(count, std::memory_order_relaxed);
+    auto* head = head_.load(std::memory_order_relaxed);
+    do {
+      bottom->next = head == armed() ? nullptr : head;
+    } while (!head_.compare_exchange_weak(
+        head, top, std::memory_order_release, std::memory_order_relaxed));
+    if (head == armed()) {
+      notifyFd();
+    }
+  }
+
+  /**
+   * Number of tasks that have not started running yet. Approximate while
+   * tasks are being added.
+   */
+  size_t size() const {
+    auto size = size_.load(std::memory_order_relaxed);
+    return size > 0 ? size_t(size) : 0;
+  }
+
+  /**
+   * Maximum number of tasks run per wakeup, 0 for no limit. The consumer
+   * wakes itself up again if it stops early.
+   */
+  void setMaxReadAtOnce(uint32_t maxAtOnce) {
+    maxReadAtOnce_ = maxAtOnce;
+  }
+
+  /**
+   * Start running tasks from the given EventBase's loop. An internal
+   * registration does not keep EventBase::loop() from returning.
+   */
+  void startConsuming(EventBase* evb) {
+    startConsumingImpl(evb, false);
+  }
+  void startConsumingInternal(EventBase* evb) {
+    startConsumingImpl(evb, true);
+  }
+
+  void stopConsuming() {
+    if (!evb_) {
+      return;
+    }
+    unregisterHandler();
+    detachEventBase();
+    evb_ = nullptr;
+  }
+
+  /**
+   * Run a batch of tasks, as if the fd had become readable. Consumer thread
+   * only.
+   */
+  void drive() noexcept {
+    handlerReady(EventHandler::READ);
+  }
+
+  /**
+   * Run tasks until the queue is empty, ignoring the maxReadAtOnce limit.
+   * Consumer thread only.
+   */
+  void drain() noexcept {
+    drainFd();
+    do {
+      runTasks(0);
+    } while (!arm());
+  }
+
+ private:
+  struct Node {
+    template <typename T>
+    Node(T&& t, std::shared_ptr<RequestContext> ctx)
+        : task(std::forward<T>(t)), rctx(std::move(ctx)) {}
+
+    Task task;
+    std::shared_ptr<RequestContext> rctx;
+    Node* next{nullptr};
+  };
+
+  // head_ value of an empty queue whose consumer wants to be notified
+  static Node* armed() {
+    return reinterpret_cast<Node*>(uintptr_t(1));
+  }
+
+  void startConsumingImpl(EventBase* evb, bool internal) {
+    evb->dcheckIsInEventBaseThread();
+    DCHECK(!evb_);
+    evb_ = evb;
+    initHandler(
+        evb, NetworkSocket::fromFd(eventfd_ >= 0 ? eventfd_ : pipeFds_[0]));
+    if (internal) {
+      registerInternalHandler(READ | PERSIST);
+    } else {
+      registerHandler(READ | PERSIST);
+    }
+  }
+
+  void handlerReady(uint16_t) noexcept override {
+    drainFd();
+    uint32_t numRun = 0;
+    for (;;) {
+      if (maxReadAtOnce_ != 0) {
+        numRun += runTasks(maxReadAtOnce_ - numRun);
+        if (numRun >= maxReadAtOnce_) {
+          // let other events run before the rest
+          notifyFd();
+          return;
+        }
+      } else {
+        runTasks(0);
+      }
+      if (arm()) {
+        return;
+      }
+      // more tasks arrived in the meantime
+    }
+  }
+
+  // Declares that the consumer is going to wait for the fd; fails if the
+  // queue is not empty.
+  bool arm() {
+    Node* expected = nullptr;
+    return head_.compare_exchange_strong(
+               expected, armed(), std::memory_order_relaxed) ||
+        expected == armed();
+  }
+
+  // Runs up to maxTasks (0 means all available) tasks; returns the number
+  // run.
+  uint32_t runTasks(uint32_t maxTasks) noexcept {
+    uint32_t numRun = 0;
+    while (maxTasks == 0 || numRun < maxTasks) {
+      if (!local_) {
+        local_ = takeAll();
+        if (!local_) {
+          break;
+        }
+      }
+      auto* node = local_;
+      local_ = node->next;
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      {
+        RequestContextScopeGuard rctx(std::move(node->rctx));
+        consumer_(std::move(node->task));
+      }
+      delete node;
+      ++numRun;
+    }
+    return numRun;
+  }
+
+  // Takes every pushed task, oldest first.
+  Node* takeAll() {
+    auto* head = head_.load(std::memory_order_relaxed);
+    if (head == nullptr || head == armed()) {
+      return nullptr;
+    }
+    head = head_.exchange(nullptr, std::memory_order_acquire);
+    Node* list = nullptr;
+    while (head) {
+      auto* next = head->next;
+      head->next = list;
+      list = head;
+      head = next;
+    }
+    return list;
+  }
+
+  static void freeList(Node* list) {
+    while (list) {
+      auto* next = list->next;
+      delete list;
+      list = next;
+    }
+  }
+
+  void notifyFd() {
+    ssize_t bytesWritten;
+    if (eventfd_ >= 0) {
+      // eventfd(2) dictates that we must write a 64-bit integer
+      uint64_t signal = 1;
+      bytesWritten = writeNoInt(eventfd_, &signal, sizeof(signal));
+    } else {
+      uint8_t signal = 1;
+      bytesWritten = writeNoInt(pipeFds_[1], &signal, sizeof(signal));
+    }
+    // a full pipe is already readable
+    if (bytesWritten < 0 && errno != EAGAIN) {
+      folly::throwSystemError("failed to signal AtomicNotificationQueue");
+    }
+  }
+
+  void drainFd() {
+    if (eventfd_ >= 0) {
+      uint64_t message;
+      auto bytesRead = readNoInt(eventfd_, &message, sizeof(message));
+      CHECK(bytesRead != -1 || errno == EAGAIN);
+    } else {
+      uint8_t message[32];
+      while (readNoInt(pipeFds_[0], &message, sizeof(message)) > 0) {
+      }
+    }
+  }
+
+  // written by producers
+  alignas(hardware_destructive_interference_size) std::atomic<Node*> head_{
+      armed()};
+  std::atomic<ssize_t> size_{0};
+
+  // consumer state
+  alignas(hardware_destructive_interference_size) Node* local_{nullptr};
+  Consumer consumer_;
+  EventBase* evb_{nullptr};
+  uint32_t maxReadAtOnce_{kDefaultMaxReadAtOnce};
+  int eventfd_{-1};
+  int pipeFds_[2]{-1, -1};
+};
+
+} // namespace folly
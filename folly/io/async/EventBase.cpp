@@ -28,12 +28,14 @@
 
 #include <folly/Memory.h>
 #include <folly/String.h>
+#include <folly/io/async/AtomicNotificationQueue.h>
 #include <folly/io/async/EventBaseBackendBase.h>
-#include <folly/io/async/NotificationQueue.h>
 #include <folly/io/async/VirtualEventBase.h>
 #include <folly/portability/Unistd.h>
+#include <folly/stats/Histogram.h>
 #include <folly/synchronization/Baton.h>
 #include <folly/system/ThreadName.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 namespace {
 class EventBaseBackend : public folly::EventBaseBackendBase {
@@ -128,25 +130,51 @@ namespace folly {
  * EventBase::FunctionRunner
  */
 
-class EventBase::FunctionRunner
-    : public NotificationQueue<EventBase::Func>::Consumer {
+class EventBase::FunctionRunner {
  public:
-  void messageAvailable(Func&& msg) noexcept override {
+  explicit FunctionRunner(EventBase* evb) : evb_(evb) {}
+
+  void operator()(Func&& msg) noexcept {
     // In libevent2, internal events do not break the loop.
     // Most users would expect loop(), followed by runInEventBaseThread(),
     // to break the loop and check if it should exit or not.
     // To have similar bejaviour to libevent1.4, tell the loop to break here.
     // Note that loop() may still continue to loop, but it will also check the
     // stop_ flag as well as runInLoop callbacks, etc.
-    getEventBase()->getBackend()->eb_event_base_loopbreak();
+    evb_->getBackend()->eb_event_base_loopbreak();
 
     if (!msg) {
       // terminateLoopSoon() sends a null message just to
       // wake up the loop.  We can ignore these messages.
       return;
     }
+    EventBase::LoopPhaseGuard phase(
+        evb_, EventBaseLoopPhaseTimes::NOTIFICATION_QUEUE);
     msg();
   }
+
+ private:
+  EventBase* evb_;
+};
+
+struct EventBase::LoopPhaseState {
+  LoopPhaseState(
+      std::shared_ptr<EventBaseLoopPhaseObserver> obs,
+      int64_t bucketSize,
+      int64_t max)
+      : observer(std::move(obs)) {
+    histograms.reserve(EventBaseLoopPhaseTimes::NUM_PHASES);
+    for (size_t i = 0; i < EventBaseLoopPhaseTimes::NUM_PHASES; ++i) {
+      histograms.emplace_back(bucketSize, 0, max);
+    }
+  }
+
+  std::shared_ptr<EventBaseLoopPhaseObserver> observer;
+  std::vector<Histogram<int64_t>> histograms;
+  EventBaseLoopPhaseTimes times;
+  EventBaseLoopPhaseTimes::Phase phase{EventBaseLoopPhaseTimes::POLL};
+  std::chrono::steady_clock::time_point phaseStart{
+      std::chrono::steady_clock::now()};
 };
 
 /*
@@ -158,7 +186,6 @@ EventBase::EventBase(bool enableTimeMeasurement)
       stop_(false),
       loopThread_(),
       queue_(nullptr),
-      fnRunner_(nullptr),
       maxLatency_(0),
       avgLoopTime_(std::chrono::seconds(2)),
       maxLatencyLoopTime_(avgLoopTime_),
@@ -191,7 +218,6 @@ EventBase::EventBase(
       stop_(false),
       loopThread_(),
       queue_(nullptr),
-      fnRunner_(nullptr),
       maxLatency_(0),
       avgLoopTime_(std::chrono::seconds(2)),
       maxLatencyLoopTime_(avgLoopTime_),
@@ -241,14 +267,13 @@ EventBase::~EventBase() {
 
   DCHECK_EQ(0u, runBeforeLoopCallbacks_.size());
 
+  (void)runBeforePollCallbacks();
   (void)runLoopCallbacks();
 
-  if (!fnRunner_->consumeUntilDrained()) {
-    LOG(ERROR) << "~EventBase(): Unable to drain notification queue";
-  }
+  queue_->drain();
 
-  // Stop consumer before deleting NotificationQueue
-  fnRunner_->stopConsuming();
+  // Stop consumer before deleting the backend
+  queue_->stopConsuming();
   evb_.reset();
 
   for (auto storage : localStorageToDtor_) {
@@ -267,7 +292,60 @@ size_t EventBase::getNotificationQueueSize() const {
 }
 
 void EventBase::setMaxReadAtOnce(uint32_t maxAtOnce) {
-  fnRunner_->setMaxReadAtOnce(maxAtOnce);
+  queue_->setMaxReadAtOnce(maxAtOnce);
+}
+
+void EventBase::enableLoopPhaseTracking(
+    std::shared_ptr<EventBaseLoopPhaseObserver> observer,
+    std::chrono::microseconds bucketSize,
+    std::chrono::microseconds max) {
+  dcheckIsInEventBaseThread();
+  loopPhases_ = std::make_unique<LoopPhaseState>(
+      std::move(observer), bucketSize.count(), max.count());
+}
+
+void EventBase::disableLoopPhaseTracking() {
+  dcheckIsInEventBaseThread();
+  loopPhases_.reset();
+}
+
+const Histogram<int64_t>& EventBase::getLoopPhaseHistogram(
+    EventBaseLoopPhaseTimes::Phase phase) const {
+  CHECK(loopPhases_) << "loop phase tracking is not enabled";
+  return loopPhases_->histograms[phase];
+}
+
+EventBaseLoopPhaseTimes::Phase EventBase::switchLoopPhase(
+    EventBaseLoopPhaseTimes::Phase phase) {
+  if (!loopPhases_) {
+    // disabled by a callback
+    return phase;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto& state = *loopPhases_;
+  state.times[state.phase] += now - state.phaseStart;
+  state.phaseStart = now;
+  return std::exchange(state.phase, phase);
+}
+
+void EventBase::startLoopPhases() {
+  auto& state = *loopPhases_;
+  state.times = EventBaseLoopPhaseTimes();
+  state.phase = EventBaseLoopPhaseTimes::POLL;
+  state.phaseStart = std::chrono::steady_clock::now();
+}
+
+void EventBase::finishLoopPhases() {
+  switchLoopPhase(EventBaseLoopPhaseTimes::POLL);
+  auto& state = *loopPhases_;
+  for (size_t i = 0; i < EventBaseLoopPhaseTimes::NUM_PHASES; ++i) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        state.times.times[i]);
+    state.histograms[i].addValue(us.count());
+  }
+  if (state.observer) {
+    state.observer->loopPhaseSample(state.times);
+  }
 }
 
 void EventBase::checkIsInEventBaseThread() const {
@@ -304,6 +382,7 @@ void EventBase::resetLoadAvg(double value) {
   assert(enableTimeMeasurement_);
   avgLoopTime_.reset(value);
   maxLatencyLoopTime_.reset(value);
+  avgLoopTimeRelaxed_.store(value, std::memory_order_relaxed);
 }
 
 static std::chrono::milliseconds getTimeDelta(
@@ -329,8 +408,8 @@ bool EventBase::loopIgnoreKeepAlive() {
   if (loopKeepAliveActive_) {
     // Make sure NotificationQueue is not counted as one of the readers
     // (otherwise loopBody won't return until terminateLoopSoon is called).
-    fnRunner_->stopConsuming();
-    fnRunner_->startConsumingInternal(this, queue_.get());
+    queue_->stopConsuming();
+    queue_->startConsumingInternal(this);
     loopKeepAliveActive_ = false;
   }
   return loopBody(0, true);
@@ -390,26 +469,49 @@ bool EventBase::loopBody(int flags, bool ignoreKeepAlive) {
       applyLoopKeepAlive();
     }
     ++nextLoopCnt_;
+    FOLLY_SDT(folly, event_base_loop_begin, this, nextLoopCnt_);
+
+    if (loopPhases_) {
+      startLoopPhases();
+    }
 
-    // Run the before loop callbacks
-    LoopCallbackList callbacks;
-    callbacks.swap(runBeforeLoopCallbacks_);
+    {
+      LoopPhaseGuard phase(this, EventBaseLoopPhaseTimes::LOOP_CALLBACKS);
 
-    while (!callbacks.empty()) {
-      auto* item = &callbacks.front();
-      callbacks.pop_front();
-      item->runLoopCallback();
+      // Run the before loop callbacks
+      LoopCallbackList callbacks;
+      callbacks.swap(runBeforeLoopCallbacks_);
+
+      while (!callbacks.empty()) {
+        auto* item = &callbacks.front();
+        callbacks.pop_front();
+        item->runLoopCallback();
+      }
+
+      (void)runBeforePollCallbacks();
     }
 
     // nobody can add loop callbacks from within this thread if
     // we don't have to handle anything to start with...
-    if (blocking && loopCallbacks_.empty()) {
+    if (blocking && loopCallbacks_.empty() &&
+        runBeforePollCallbacks_.empty()) {
+      FOLLY_SDT(folly, event_base_poll_begin, this, 1);
       res = evb_->eb_event_base_loop(EVLOOP_ONCE);
     } else {
+      FOLLY_SDT(folly, event_base_poll_begin, this, 0);
       res = evb_->eb_event_base_loop(EVLOOP_ONCE | EVLOOP_NONBLOCK);
     }
+    FOLLY_SDT(folly, event_base_poll_end, this, res);
+
+    {
+      LoopPhaseGuard phase(this, EventBaseLoopPhaseTimes::LOOP_CALLBACKS);
+      ranLoopCallbacks = runLoopCallbacks();
+    }
+    FOLLY_SDT(folly, event_base_loop_end, this, nextLoopCnt_);
 
-    ranLoopCallbacks = runLoopCallbacks();
+    if (loopPhases_) {
+      finishLoopPhases();
+    }
 
     if (enableTimeMeasurement_) {
       auto now = std::chrono::steady_clock::now();
@@ -421,6 +523,8 @@ bool EventBase::loopBody(int flags, bool ignoreKeepAlive) {
 
       avgLoopTime_.addSample(loop_time, busy);
       maxLatencyLoopTime_.addSample(loop_time, busy);
+      avgLoopTimeRelaxed_.store(
+          avgLoopTime_.get(), std::memory_order_relaxed);
 
       if (observer_) {
         if (observerSampleCount_++ == observer_->getSampleRate()) {
@@ -462,8 +566,8 @@ bool EventBase::loopBody(int flags, bool ignoreKeepAlive) {
       // run.  Run them manually if so, and continue looping.
       //
       if (getNotificationQueueSize() > 0) {
-        fnRunner_->handlerReady(0);
-      } else if (!ranLoopCallbacks) {
+        queue_->drive();
+      } else if (!ranLoopCallbacks && runBeforePollCallbacks_.empty()) {
         // If there were no more events and we also didn't have any loop
         // callbacks to run, there is nothing left to do.
         break;
@@ -479,6 +583,9 @@ bool EventBase::loopBody(int flags, bool ignoreKeepAlive) {
       break;
     }
   }
+  // Don't hold back what the last iteration batched up
+  (void)runBeforePollCallbacks();
+
   // Reset stop_ so loop() can be called again
   stop_.store(false, std::memory_order_relaxed);
 
@@ -517,15 +624,15 @@ void EventBase::applyLoopKeepAlive() {
 
   if (loopKeepAliveActive_ && keepAliveCount == 0) {
     // Restore the notification queue internal flag
-    fnRunner_->stopConsuming();
-    fnRunner_->startConsumingInternal(this, queue_.get());
+    queue_->stopConsuming();
+    queue_->startConsumingInternal(this);
     loopKeepAliveActive_ = false;
   } else if (!loopKeepAliveActive_ && keepAliveCount > 0) {
     // Update the notification queue event to treat it as a normal
     // (non-internal) event.  The notification queue event always remains
     // installed, and the main loop won't exit with it installed.
-    fnRunner_->stopConsuming();
-    fnRunner_->startConsuming(this, queue_.get());
+    queue_->stopConsuming();
+    queue_->startConsuming(this);
     loopKeepAliveActive_ = true;
   }
 }
@@ -637,6 +744,12 @@ void EventBase::runBeforeLoop(LoopCallback* callback) {
   runBeforeLoopCallbacks_.push_back(*callback);
 }
 
+void EventBase::runBeforePoll(LoopCallback* callback) {
+  dcheckIsInEventBaseThread();
+  callback->cancelLoopCallback();
+  runBeforePollCallbacks_.push_back(*callback);
+}
+
 void EventBase::runInEventBaseThread(Func fn) noexcept {
   // Send the message.
   // It will be received by the FunctionRunner in the EventBase's thread.
@@ -657,6 +770,17 @@ void EventBase::runInEventBaseThread(Func fn) noexcept {
   queue_->putMessage(std::move(fn));
 }
 
+void EventBase::addBatch(Range<Func*> fns) {
+  if (inRunningEventBaseThread()) {
+    for (auto& fn : fns) {
+      runInLoop(std::move(fn));
+    }
+    return;
+  }
+  queue_->putMessages(
+      std::make_move_iterator(fns.begin()), std::make_move_iterator(fns.end()));
+}
+
 void EventBase::runInEventBaseThreadAlwaysEnqueue(Func fn) noexcept {
   // Send the message.
   // It will be received by the FunctionRunner in the EventBase's thread.
@@ -726,14 +850,25 @@ bool EventBase::runLoopCallbacks() {
   return false;
 }
 
+bool EventBase::runBeforePollCallbacks() {
+  if (runBeforePollCallbacks_.empty()) {
+    return false;
+  }
+  // Callbacks added while running these wait for the next poll
+  LoopCallbackList callbacks;
+  callbacks.swap(runBeforePollCallbacks_);
+  while (!callbacks.empty()) {
+    auto* callback = &callbacks.front();
+    callbacks.pop_front();
+    callback->runLoopCallback();
+  }
+  return true;
+}
+
 void EventBase::initNotificationQueue() {
   // Infinite size queue
-  queue_ = std::make_unique<NotificationQueue<Func>>();
-
-  // We allocate fnRunner_ separately, rather than declaring it directly
-  // as a member of EventBase solely so that we don't need to include
-  // NotificationQueue.h from EventBase.h
-  fnRunner_ = std::make_unique<FunctionRunner>();
+  queue_ = std::make_unique<AtomicNotificationQueue<Func, FunctionRunner>>(
+      FunctionRunner(this));
 
   // Mark this as an internal event, so event_base_loop() will return if
   // there are no other events besides this one installed.
@@ -744,7 +879,7 @@ void EventBase::initNotificationQueue() {
   // Users can use loopForever() if they do care about the notification queue.
   // (This is useful for EventBase threads that do nothing but process
   // runInEventBaseThread() notifications.)
-  fnRunner_->startConsumingInternal(this, queue_.get());
+  queue_->startConsumingInternal(this);
 }
 
 void EventBase::SmoothLoopTime::setTimeInterval(
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cerrno>
 #include <cmath>
 #include <cstdlib>
@@ -56,6 +58,8 @@ class EventBaseBackendBase;
 using Cob = Func; // defined in folly/Executor.h
 template <typename MessageT>
 class NotificationQueue;
+template <typename Task, typename Consumer>
+class AtomicNotificationQueue;
 
 namespace detail {
 class EventBaseLocalBase;
@@ -78,6 +82,44 @@ class EventBaseObserver {
   virtual void loopSample(int64_t busyTime, int64_t idleTime) = 0;
 };
 
+template <typename T>
+class Histogram;
+
+// Where one EventBase loop iteration spent its time, see
+// EventBase::enableLoopPhaseTracking().
+struct EventBaseLoopPhaseTimes {
+  enum Phase : size_t {
+    // waiting in and dispatching from the backend, minus the callbacks below
+    POLL,
+    // EventHandler callbacks, i.e. fd readiness
+    HANDLERS,
+    // runInLoop(), runBeforeLoop() and runBeforePoll() callbacks
+    LOOP_CALLBACKS,
+    // functions from runInEventBaseThread() and friends
+    NOTIFICATION_QUEUE,
+    // AsyncTimeout and HHWheelTimer expiry
+    TIMERS,
+    NUM_PHASES,
+  };
+
+  std::chrono::nanoseconds& operator[](Phase phase) {
+    return times[phase];
+  }
+  const std::chrono::nanoseconds& operator[](Phase phase) const {
+    return times[phase];
+  }
+
+  std::array<std::chrono::nanoseconds, NUM_PHASES> times{};
+};
+
+class EventBaseLoopPhaseObserver {
+ public:
+  virtual ~EventBaseLoopPhaseObserver() = default;
+
+  // Called at the end of every loop iteration
+  virtual void loopPhaseSample(const EventBaseLoopPhaseTimes& times) = 0;
+};
+
 // Helper class that sets and retrieves the EventBase associated with a given
 // request via RequestContext. See Request.h for that mechanism.
 class RequestEventBase : public RequestData {
@@ -478,6 +520,28 @@ class EventBase : public TimeoutManager,
    */
   void runBeforeLoop(LoopCallback* callback);
 
+  /**
+   * Adds a callback that will run right before the backend next polls for
+   * events. Pending callbacks keep the loop from blocking or exiting, and the
+   * ones added during the last iteration still run before loop() returns.
+   * Used to flush work batched up while handling the previous events, see
+   * setDeferWrites().
+   */
+  void runBeforePoll(LoopCallback* callback);
+
+  /**
+   * Defer writes that sockets on this EventBase would issue immediately and
+   * flush them all right before polling, so that the writes triggered by one
+   * round of events leave in a single pass: one write per socket instead of
+   * one per write call, or one submission when the backend performs the I/O.
+   */
+  void setDeferWrites(bool deferWrites) {
+    deferWrites_ = deferWrites;
+  }
+  bool getDeferWrites() const {
+    return deferWrites_;
+  }
+
   /**
    * Run the specified function in the EventBase's thread.
    *
@@ -622,6 +686,15 @@ class EventBase : public TimeoutManager,
     return avgLoopTime_.get();
   }
 
+  /**
+   * Like getAvgLoopTime(), but may be called from any thread. The value is
+   * published once per loop iteration, and is 0 if time measurement is
+   * disabled.
+   */
+  double getAvgLoopTimeRelaxed() const {
+    return avgLoopTimeRelaxed_.load(std::memory_order_relaxed);
+  }
+
   /**
    * check if the event base loop is running.
    */
@@ -638,6 +711,67 @@ class EventBase : public TimeoutManager,
 
   void setMaxReadAtOnce(uint32_t maxAtOnce);
 
+  /**
+   * Loop phase instrumentation: break the time of every loop iteration down
+   * into the phases of EventBaseLoopPhaseTimes, keep a histogram of each (in
+   * microseconds) and pass the times to the observer, if any.
+   *
+   * This costs a clock read around every callback while enabled.
+   */
+  void enableLoopPhaseTracking(
+      std::shared_ptr<EventBaseLoopPhaseObserver> observer = nullptr,
+      std::chrono::microseconds bucketSize = std::chrono::microseconds(10),
+      std::chrono::microseconds max = std::chrono::milliseconds(10));
+  void disableLoopPhaseTracking();
+  bool isLoopPhaseTrackingEnabled() const {
+    return loopPhases_ != nullptr;
+  }
+
+  /**
+   * Per-iteration time spent in the phase, in microseconds. Only valid while
+   * loop phase tracking is enabled.
+   */
+  const Histogram<int64_t>& getLoopPhaseHistogram(
+      EventBaseLoopPhaseTimes::Phase phase) const;
+
+  /**
+   * Attributes the time until destruction to the given phase, used by the
+   * code that dispatches callbacks. A no-op unless loop phase tracking is
+   * enabled.
+   */
+  class LoopPhaseGuard {
+   public:
+    LoopPhaseGuard(EventBase* evb, EventBaseLoopPhaseTimes::Phase phase)
+        : evb_(evb && evb->loopPhases_ ? evb : nullptr) {
+      if (evb_) {
+        prev_ = evb_->switchLoopPhase(phase);
+      }
+    }
+    ~LoopPhaseGuard() {
+      if (evb_) {
+        evb_->switchLoopPhase(prev_);
+      }
+    }
+
+    LoopPhaseGuard(const LoopPhaseGuard&) = delete;
+    LoopPhaseGuard& operator=(const LoopPhaseGuard&) = delete;
+
+   private:
+    EventBase* evb_;
+    EventBaseLoopPhaseTimes::Phase prev_{EventBaseLoopPhaseTimes::POLL};
+  };
+
+  /**
+   * Initial zerocopy threshold for sockets on this EventBase that enable
+   * automatic zerocopy, see AsyncSocket::setZeroCopyAuto().
+   */
+  void setZeroCopyAutoThreshold(size_t threshold) {
+    zeroCopyAutoThreshold_ = threshold;
+  }
+  size_t getZeroCopyAutoThreshold() const {
+    return zeroCopyAutoThreshold_;
+  }
+
   /**
    * Verify that current thread is the EventBase thread, if the EventBase is
    * running.
@@ -768,6 +902,9 @@ class EventBase : public TimeoutManager,
     runInEventBaseThread(std::move(fn));
   }
 
+  /// Enqueues all the functions with a single notification
+  void addBatch(Range<Cob*> fns) override;
+
   /// Implements the DrivableExecutor interface
   void drive() override {
     ++loopKeepAliveCount_;
@@ -846,8 +983,19 @@ class EventBase : public TimeoutManager,
   // executes any callbacks queued by runInLoop(); returns false if none found
   bool runLoopCallbacks();
 
+  // executes the callbacks queued by runBeforePoll(); returns false if none
+  // found
+  bool runBeforePollCallbacks();
+
   void initNotificationQueue();
 
+  // loop phase tracking, see enableLoopPhaseTracking()
+  struct LoopPhaseState;
+  EventBaseLoopPhaseTimes::Phase switchLoopPhase(
+      EventBaseLoopPhaseTimes::Phase phase);
+  void startLoopPhases();
+  void finishLoopPhases();
+
   // Tick granularity to wheelTimer_
   std::chrono::milliseconds intervalDuration_{
       HHWheelTimer::DEFAULT_TICK_INTERVAL};
@@ -856,6 +1004,7 @@ class EventBase : public TimeoutManager,
 
   LoopCallbackList loopCallbacks_;
   LoopCallbackList runBeforeLoopCallbacks_;
+  LoopCallbackList runBeforePollCallbacks_;
   Synchronized<OnDestructionCallback::List> onDestructionCallbacks_;
 
   // This will be null most of the time, but point to currentCallbacks
@@ -874,8 +1023,7 @@ class EventBase : public TimeoutManager,
 
   // A notification queue for runInEventBaseThread() to use
   // to send function requests to the EventBase thread.
-  std::unique_ptr<NotificationQueue<Func>> queue_;
-  std::unique_ptr<FunctionRunner> fnRunner_;
+  std::unique_ptr<AtomicNotificationQueue<Func, FunctionRunner>> queue_;
   ssize_t loopKeepAliveCount_{0};
   std::atomic<ssize_t> loopKeepAliveCountAtomic_{0};
   bool loopKeepAliveActive_{false};
@@ -886,6 +1034,9 @@ class EventBase : public TimeoutManager,
   // exponentially-smoothed average loop time for latency-limiting
   SmoothLoopTime avgLoopTime_;
 
+  // copy of avgLoopTime_ for other threads
+  std::atomic<double> avgLoopTimeRelaxed_{0.0};
+
   // smoothed loop time used to invoke latency callbacks; differs from
   // avgLoopTime_ in that it's scaled down after triggering a callback
   // to reduce spamminess
@@ -919,6 +1070,14 @@ class EventBase : public TimeoutManager,
   // Name of the thread running this EventBase
   std::string name_;
 
+  // see setDeferWrites()
+  bool deferWrites_{false};
+
+  std::unique_ptr<LoopPhaseState> loopPhases_;
+
+  // see setZeroCopyAutoThreshold()
+  size_t zeroCopyAutoThreshold_{32 * 1024};
+
   // see EventBaseLocal
   friend class detail::EventBaseLocalBase;
   template <typename T>
@@ -18,11 +18,14 @@
 
 #include <memory>
 
+#include <folly/Function.h>
 #include <folly/io/async/EventUtil.h>
 #include <folly/portability/Event.h>
+#include <folly/portability/SysUio.h>
 
 namespace folly {
 class EventBase;
+class IOBuf;
 
 class EventBaseEvent {
  public:
@@ -117,6 +120,105 @@ class EventBaseBackendBase {
 
   virtual int eb_event_add(Event& event, const struct timeval* timeout) = 0;
   virtual int eb_event_del(Event& event) = 0;
+
+  // Completion-based I/O.
+  //
+  // Backends that can perform socket I/O on behalf of the caller (e.g.
+  // io_uring) override these. The callback is invoked from the loop with the
+  // syscall-style result (bytes transferred or -errno); -ECANCELED is passed
+  // if the op was cancelled. The returned handle is valid until the callback
+  // runs. The default implementations report the feature as unavailable.
+  using IoCompletionCallback = folly::Function<void(int)>;
+
+  virtual bool eb_async_io_supported() const {
+    return false;
+  }
+
+  // The buffer must stay valid until the callback is invoked.
+  virtual void* eb_queue_recv(
+      int /*fd*/,
+      void* /*buf*/,
+      size_t /*len*/,
+      int /*flags*/,
+      IoCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // The iovec array is copied; the memory it points to must stay valid
+  // until the callback is invoked.
+  virtual void* eb_queue_sendmsg(
+      int /*fd*/,
+      const struct iovec* /*iov*/,
+      size_t /*iovCount*/,
+      int /*flags*/,
+      IoCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // splice(2): one of the fds must be a pipe, whose offset must be -1. The
+  // flags are the SPLICE_F_* ones.
+  virtual void* eb_queue_splice(
+      int /*fdIn*/,
+      int64_t /*offIn*/,
+      int /*fdOut*/,
+      int64_t /*offOut*/,
+      size_t /*len*/,
+      unsigned int /*flags*/,
+      IoCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // Like eb_queue_recv(), but the backend picks the buffer from a pool it
+  // owns and passes it to the callback along with the result. The buffer
+  // goes back to the pool once the IOBuf is freed. Returns nullptr if the
+  // backend has no buffer pool.
+  using IoBufCompletionCallback =
+      folly::Function<void(int, std::unique_ptr<IOBuf>)>;
+
+  virtual void* eb_queue_recv_pooled(
+      int /*fd*/,
+      int /*flags*/,
+      IoBufCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // Multishot ops stay armed and invoke the callback once per result; "more"
+  // is false for the last invocation, after which the handle is invalid. An
+  // op ends on cancellation or on the first error, e.g. -EINVAL on kernels
+  // without multishot support.
+  using MultishotCompletionCallback = folly::Function<void(int, bool)>;
+  using MultishotIoBufCompletionCallback =
+      folly::Function<void(int, std::unique_ptr<IOBuf>, bool)>;
+
+  // The result is the revents mask.
+  virtual void* eb_queue_poll_multishot(
+      int /*fd*/,
+      uint32_t /*events*/,
+      MultishotCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // The result is the accepted fd, which the callback owns. The flags are
+  // the accept4() ones.
+  virtual void* eb_queue_accept_multishot(
+      int /*fd*/,
+      int /*flags*/,
+      MultishotCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  // Requires a buffer pool, see eb_queue_recv_pooled(). The op ends with
+  // -ENOBUFS if the pool runs dry.
+  virtual void* eb_queue_recv_multishot(
+      int /*fd*/,
+      int /*flags*/,
+      MultishotIoBufCompletionCallback&& /*cb*/) {
+    return nullptr;
+  }
+
+  virtual int eb_cancel_op(void* /*op*/) {
+    return -1;
+  }
 };
 
 } // namespace folly
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/EventBaseMemoryIdler.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <folly/detail/MemoryIdler.h>
+
+using folly::detail::MemoryIdler;
+using std::chrono::steady_clock;
+
+namespace folly {
+
+namespace detail {
+
+steady_clock::duration IdleTimeoutScaler::workArrived(
+    steady_clock::time_point now,
+    steady_clock::duration idleTimeout) {
+  if (releasedAt_ != steady_clock::time_point{}) {
+    // First work since the memory was released
+    auto idleFor = now - releasedAt_;
+    if (idleFor < idleTimeout) {
+      scale_ = std::min(scale_ * 2, kMaxScale);
+    } else if (idleFor / scale_ >= idleTimeout) {
+      scale_ = std::max(scale_ / 2, uint32_t(1));
+    }
+    releasedAt_ = {};
+  }
+
+  if (idleTimeout <= steady_clock::duration::max() / kMaxScale) {
+    idleTimeout *= scale_;
+  }
+  return idleTimeout;
+}
+
+} // namespace detail
+
+EventBaseMemoryIdler::EventBaseMemoryIdler(EventBase& evb)
+    : AsyncTimeout(&evb), evb_(evb) {
+  evb_.runBeforeLoop(this);
+}
+
+EventBaseMemoryIdler::~EventBaseMemoryIdler() {
+  cancelLoopCallback();
+}
+
+void EventBaseMemoryIdler::timeoutExpired() noexcept {
+  idled_ = true;
+}
+
+void EventBaseMemoryIdler::runLoopCallback() noexcept {
+  if (idled_) {
+    MemoryIdler::flushLocalMallocCaches();
+    MemoryIdler::unmapUnusedStack(MemoryIdler::kDefaultStackToRetain);
+
+    idled_ = false;
+    scaler_.released(steady_clock::now());
+    ++numReleases_;
+  } else {
+    auto idleTimeout = scaler_.workArrived(
+        steady_clock::now(),
+        MemoryIdler::defaultIdleTimeout.load(std::memory_order_acquire));
+    idleTimeout = MemoryIdler::getVariationTimeout(idleTimeout);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(idleTimeout)
+                  .count();
+    scheduleTimeout(static_cast<uint32_t>(
+        std::min<int64_t>(ms, std::numeric_limits<uint32_t>::max())));
+  }
+
+  // reschedule this callback for the next event loop.
+  evb_.runBeforeLoop(this);
+}
+
+} // namespace folly
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+
+namespace folly {
+
+namespace detail {
+
+/**
+ * How much EventBaseMemoryIdler scales its idle timeout, from when it
+ * released the memory and when work arrived. Takes the time as arguments so
+ * that it can be tested with a manual clock.
+ */
+class IdleTimeoutScaler {
+ public:
+  static constexpr uint32_t kMaxScale = 16;
+
+  // The memory was released at now
+  void released(std::chrono::steady_clock::time_point now) {
+    releasedAt_ = now;
+  }
+
+  // Work arrived at now. Returns idleTimeout, scaled for the load.
+  std::chrono::steady_clock::duration workArrived(
+      std::chrono::steady_clock::time_point now,
+      std::chrono::steady_clock::duration idleTimeout);
+
+  uint32_t scale() const {
+    return scale_;
+  }
+
+ private:
+  // When the memory was last released, if no work arrived since
+  std::chrono::steady_clock::time_point releasedAt_{};
+  uint32_t scale_{1};
+};
+
+} // namespace detail
+
+/**
+ * Gives the memory cached by the thread of an EventBase back to the system,
+ * with detail::MemoryIdler, once the loop has waited in its backend (epoll,
+ * io_uring, ...) for MemoryIdler::defaultIdleTimeout.
+ *
+ * The timeout adapts to the load of the loop: when work arrives shortly
+ * after the memory was released, the thread is busy enough to fault it all
+ * back in, so the timeout is doubled, up to kMaxTimeoutScale times the
+ * default. It is halved again whenever the loop then stays idle for longer
+ * than the timeout.
+ *
+ * Must be created and destroyed in the thread of the EventBase, before it
+ * loops and after it stops looping.
+ */
+class EventBaseMemoryIdler : private AsyncTimeout,
+                             private EventBase::LoopCallback {
+ public:
+  static constexpr uint32_t kMaxTimeoutScale =
+      detail::IdleTimeoutScaler::kMaxScale;
+
+  explicit EventBaseMemoryIdler(EventBase& evb);
+  ~EventBaseMemoryIdler() override;
+
+  EventBaseMemoryIdler(const EventBaseMemoryIdler&) = delete;
+  EventBaseMemoryIdler& operator=(const EventBaseMemoryIdler&) = delete;
+
+  // Multiplier currently applied to MemoryIdler::defaultIdleTimeout
+  uint32_t timeoutScale() const {
+    return scaler_.scale();
+  }
+
+  // Number of times the memory was released
+  uint64_t numReleases() const {
+    return numReleases_;
+  }
+
+ private:
+  void timeoutExpired() noexcept override;
+  void runLoopCallback() noexcept override;
+
+  EventBase& evb_;
+  bool idled_{false};
+  detail::IdleTimeoutScaler scaler_;
+  uint64_t numReleases_{0};
+};
+
+} // namespace folly
@@ -155,7 +155,11 @@ void EventHandler::libeventCallback(libevent_fd_t fd, short events, void* arg) {
   // this can't possibly fire if handler->eventBase_ is nullptr
   handler->eventBase_->bumpHandlingTime();
 
-  handler->handlerReady(uint16_t(events));
+  {
+    EventBase::LoopPhaseGuard phase(
+        handler->eventBase_, EventBaseLoopPhaseTimes::HANDLERS);
+    handler->handlerReady(uint16_t(events));
+  }
 
   if (observer) {
     observer->stopped(reinterpret_cast<uintptr_t>(handler));
@@ -84,6 +84,7 @@ void HHWheelTimerBase<Duration>::Callback::cancelTimeoutImpl() {
 
   wheel_ = nullptr;
   expiration_ = {};
+  deferred_ = false;
 }
 
 template <class Duration>
@@ -204,6 +205,21 @@ void HHWheelTimerBase<Duration>::scheduleTimeout(Callback* callback) {
   scheduleTimeout(callback, defaultTimeout_);
 }
 
+template <class Duration>
+void HHWheelTimerBase<Duration>::rescheduleTimeout(
+    Callback* callback,
+    Duration timeout) {
+  timeout = std::max(timeout, Duration::zero());
+  auto deadline = getCurTime() + timeout;
+  if (callback->wheel_ != this || deadline < callback->expiration_) {
+    scheduleTimeout(callback, timeout);
+    return;
+  }
+  callback->requestContext_ = RequestContext::saveContext();
+  callback->expiration_ = deadline;
+  callback->deferred_ = true;
+}
+
 template <class Duration>
 bool HHWheelTimerBase<Duration>::cascadeTimers(
     int bucket,
@@ -215,6 +231,9 @@ bool HHWheelTimerBase<Duration>::cascadeTimers(
   while (!cbs.empty()) {
     auto* cb = &cbs.front();
     cbs.pop_front();
+    // The slot is computed from the current deadline, so any pending
+    // reschedule is applied here.
+    cb->deferred_ = false;
     scheduleTimeoutImpl(
         cb,
         nextTick + timeToWheelTicks(cb->getTimeRemaining(curTime)),
@@ -271,17 +290,22 @@ void HHWheelTimerBase<Duration>::timeoutExpired() noexcept {
     *(bi + idx) = false;
 
     expireTick_++;
-    CallbackList* cbs = &buckets_[0][idx];
-    while (!cbs->empty()) {
-      auto* cb = &cbs->front();
-      cbs->pop_front();
-      timeoutsToRunNow_.push_back(*cb);
-    }
+    timeoutsToRunNow_.splice(timeoutsToRunNow_.end(), buckets_[0][idx]);
   }
 
   while (!timeoutsToRunNow_.empty()) {
     auto* cb = &timeoutsToRunNow_.front();
     timeoutsToRunNow_.pop_front();
+    if (cb->deferred_) {
+      // Pushed back by rescheduleTimeout(); move it instead of running it,
+      // unless the new deadline is within this tick as well.
+      cb->deferred_ = false;
+      auto ticks = timeToWheelTicks(cb->getTimeRemaining(curTime));
+      if (ticks > 0) {
+        scheduleTimeoutImpl(cb, nextTick + ticks, expireTick_, nextTick);
+        continue;
+      }
+    }
     count_--;
     cb->wheel_ = nullptr;
     cb->expiration_ = {};
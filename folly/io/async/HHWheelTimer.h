@@ -66,6 +66,11 @@ struct HHWheelTimerDurationConst<std::chrono::microseconds> {
  * Unlike the original timer wheel paper, this implementation does
  * *not* tick constantly, and instead calculates the exact next wakeup
  * time.
+ *
+ * Timeouts that are pushed back over and over (e.g. idle timeouts that are
+ * reset on every read) can use rescheduleTimeout(), which only records the
+ * new deadline. The callback is moved when its old slot comes up, so most
+ * pushes never touch the wheel.
  */
 template <class Duration>
 class HHWheelTimerBase : private folly::AsyncTimeout,
@@ -147,6 +152,8 @@ class HHWheelTimerBase : private folly::AsyncTimeout,
     HHWheelTimerBase* wheel_{nullptr};
     std::chrono::steady_clock::time_point expiration_{};
     int bucket_{-1};
+    // expiration_ was pushed back without moving the callback to its new slot
+    bool deferred_{false};
 
     typedef boost::intrusive::
         list<Callback, boost::intrusive::constant_time_size<false>>
@@ -228,6 +235,15 @@ class HHWheelTimerBase : private folly::AsyncTimeout,
    */
   void scheduleTimeout(Callback* callback);
 
+  /**
+   * Like scheduleTimeout(), but cheaper for a callback that is already
+   * scheduled and whose deadline only moves later: the new deadline is
+   * recorded and the callback stays where it is until its old slot expires,
+   * at which point it is put in the right slot. Earlier deadlines take the
+   * scheduleTimeout() path.
+   */
+  void rescheduleTimeout(Callback* callback, Duration timeout);
+
   template <class F>
   void scheduleTimeoutFn(F fn, Duration timeout) {
     struct Wrapper : Callback {
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/HappyEyeballsConnector.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <folly/Conv.h>
+
+#include <glog/logging.h>
+
+namespace folly {
+
+constexpr std::chrono::milliseconds
+    HappyEyeballsConnector::kDefaultAttemptDelay;
+
+class HappyEyeballsConnector::Attempt : public AsyncSocket::ConnectCallback {
+ public:
+  Attempt(HappyEyeballsConnector* connector, EventBase* evb)
+      : connector(connector), socket(new AsyncSocket(evb)) {}
+
+  void connectSuccess() noexcept override {
+    if (connector) {
+      connector->attemptSucceeded(this);
+    }
+  }
+
+  void connectErr(const AsyncSocketException& ex) noexcept override {
+    if (connector) {
+      connector->attemptFailed(this, ex);
+    }
+  }
+
+  // cleared once the attempt is abandoned
+  HappyEyeballsConnector* connector;
+  AsyncSocket::UniquePtr socket;
+};
+
+HappyEyeballsConnector::HappyEyeballsConnector(EventBase* evb)
+    : AsyncTimeout(evb), evb_(evb) {}
+
+HappyEyeballsConnector::~HappyEyeballsConnector() {
+  cancel();
+}
+
+std::vector<SocketAddress> HappyEyeballsConnector::interleaveFamilies(
+    std::vector<SocketAddress> addresses) {
+  if (addresses.empty()) {
+    return addresses;
+  }
+  auto firstFamily = addresses.front().getFamily();
+  std::vector<SocketAddress> first;
+  std::vector<SocketAddress> second;
+  for (auto& address : addresses) {
+    (address.getFamily() == firstFamily ? first : second)
+        .push_back(std::move(address));
+  }
+  std::vector<SocketAddress> result;
+  result.reserve(first.size() + second.size());
+  for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+    if (i < first.size()) {
+      result.push_back(std::move(first[i]));
+    }
+    if (i < second.size()) {
+      result.push_back(std::move(second[i]));
+    }
+  }
+  return result;
+}
+
+void HappyEyeballsConnector::connect(
+    Callback* callback,
+    std::vector<SocketAddress> addresses,
+    std::chrono::milliseconds timeout,
+    const AsyncSocket::OptionMap& options) {
+  evb_->dcheckIsInEventBaseThread();
+  CHECK(!callback_) << "HappyEyeballsConnector is already connecting";
+  callback_ = callback;
+  timeout_ = timeout;
+  options_ = options;
+  startAttempts(std::move(addresses));
+}
+
+void HappyEyeballsConnector::connect(
+    Callback* callback,
+    AsyncDNSResolver* resolver,
+    StringPiece host,
+    uint16_t port,
+    std::chrono::milliseconds timeout,
+    const AsyncSocket::OptionMap& options) {
+  evb_->dcheckIsInEventBaseThread();
+  CHECK(!callback_) << "HappyEyeballsConnector is already connecting";
+  callback_ = callback;
+  timeout_ = timeout;
+  options_ = options;
+  resolver_ = resolver;
+  resolver->resolve(this, host, port);
+}
+
+void HappyEyeballsConnector::cancel() {
+  if (resolver_) {
+    resolver_->cancel(this);
+    resolver_ = nullptr;
+  }
+  closeAttempts();
+  callback_ = nullptr;
+}
+
+void HappyEyeballsConnector::resolveSuccess(
+    std::vector<SocketAddress> addresses) noexcept {
+  resolver_ = nullptr;
+  startAttempts(std::move(addresses));
+}
+
+void HappyEyeballsConnector::resolveError(
+    const DNSResolverException& ex) noexcept {
+  resolver_ = nullptr;
+  fail(AsyncSocketException(
+      AsyncSocketException::NOT_OPEN,
+      to<std::string>("failed to resolve host: ", ex.what())));
+}
+
+void HappyEyeballsConnector::startAttempts(
+    std::vector<SocketAddress> addresses) {
+  addresses_ = interleaveFamilies(std::move(addresses));
+  nextAddress_ = 0;
+  lastError_ = none;
+  if (addresses_.empty()) {
+    fail(AsyncSocketException(
+        AsyncSocketException::BAD_ARGS, "no addresses to connect to"));
+    return;
+  }
+  startNextAttempt();
+}
+
+void HappyEyeballsConnector::startNextAttempt() {
+  DCHECK_LT(nextAddress_, addresses_.size());
+  auto address = addresses_[nextAddress_++];
+  attempts_.push_back(std::make_unique<Attempt>(this, evb_));
+  auto* attempt = attempts_.back().get();
+  if (nextAddress_ < addresses_.size()) {
+    scheduleTimeout(uint32_t(attemptDelay_.count()));
+  } else {
+    cancelTimeout();
+  }
+  // May fail synchronously, and this may be destroyed by then.
+  attempt->socket->connect(attempt, address, int(timeout_.count()), options_);
+}
+
+void HappyEyeballsConnector::timeoutExpired() noexcept {
+  startNextAttempt();
+}
+
+void HappyEyeballsConnector::attemptSucceeded(Attempt* attempt) {
+  auto socket = std::move(attempt->socket);
+  closeAttempts();
+  auto* callback = std::exchange(callback_, nullptr);
+  callback->connectSuccess(std::move(socket));
+}
+
+void HappyEyeballsConnector::attemptFailed(
+    Attempt* attempt,
+    const AsyncSocketException& ex) {
+  VLOG(4) << "HappyEyeballsConnector attempt failed: " << ex.what();
+  lastError_ = ex;
+  attempts_.erase(std::find_if(
+      attempts_.begin(), attempts_.end(), [attempt](const auto& other) {
+        return other.get() == attempt;
+      }));
+  if (nextAddress_ < addresses_.size()) {
+    // no need to wait for the delay
+    startNextAttempt();
+  } else if (attempts_.empty()) {
+    auto error = *lastError_;
+    fail(error);
+  }
+}
+
+void HappyEyeballsConnector::closeAttempts() {
+  cancelTimeout();
+  auto attempts = std::move(attempts_);
+  attempts_.clear();
+  for (auto& attempt : attempts) {
+    attempt->connector = nullptr;
+    if (attempt->socket) {
+      attempt->socket->closeNow();
+    }
+  }
+}
+
+void HappyEyeballsConnector::fail(const AsyncSocketException& ex) {
+  closeAttempts();
+  auto* callback = std::exchange(callback_, nullptr);
+  callback->connectErr(ex);
+}
+
+} // namespace folly
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/SocketAddress.h>
+#include <folly/io/async/AsyncDNSResolver.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
+
+namespace folly {
+
+/**
+ * Connects an AsyncSocket to the first of several addresses that accepts
+ * the connection, as described by RFC 8305 ("Happy Eyeballs"): attempts
+ * alternate between IPv6 and IPv4 addresses, and each one starts once the
+ * previous one failed or has been running for the attempt delay, so a
+ * broken path costs the delay rather than a full connect timeout. The
+ * first socket to connect wins and the other attempts are closed.
+ *
+ * Must be used from the EventBase thread only. One connection at a time;
+ * destroying the connector cancels it without invoking the callback.
+ */
+class HappyEyeballsConnector : private AsyncTimeout,
+                               private AsyncDNSResolver::Callback {
+ public:
+  static constexpr std::chrono::milliseconds kDefaultAttemptDelay{250};
+
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+
+    virtual void connectSuccess(AsyncSocket::UniquePtr socket) noexcept = 0;
+
+    /**
+     * Invoked with the error of the last attempt once all of them failed,
+     * or with a NOT_OPEN error if the host could not be resolved.
+     */
+    virtual void connectErr(const AsyncSocketException& ex) noexcept = 0;
+  };
+
+  explicit HappyEyeballsConnector(EventBase* evb);
+  ~HappyEyeballsConnector() override;
+
+  HappyEyeballsConnector(const HappyEyeballsConnector&) = delete;
+  HappyEyeballsConnector& operator=(const HappyEyeballsConnector&) = delete;
+
+  void setAttemptDelay(std::chrono::milliseconds delay) {
+    attemptDelay_ = delay;
+  }
+
+  /**
+   * Connect to one of the addresses; the order within each family is kept.
+   * The timeout applies to each attempt, 0 for none.
+   */
+  void connect(
+      Callback* callback,
+      std::vector<SocketAddress> addresses,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+      const AsyncSocket::OptionMap& options = AsyncSocket::emptyOptionMap);
+
+  /**
+   * Resolve the host, then connect to one of its addresses.
+   */
+  void connect(
+      Callback* callback,
+      AsyncDNSResolver* resolver,
+      StringPiece host,
+      uint16_t port,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(0),
+      const AsyncSocket::OptionMap& options = AsyncSocket::emptyOptionMap);
+
+  /**
+   * Abandon the connection in progress, if any, without invoking the
+   * callback.
+   */
+  void cancel();
+
+  bool connecting() const {
+    return callback_ != nullptr;
+  }
+
+  /**
+   * Reorders the addresses to alternate between families, starting with
+   * the family of the first one.
+   */
+  static std::vector<SocketAddress> interleaveFamilies(
+      std::vector<SocketAddress> addresses);
+
+ private:
+  class Attempt;
+
+  void startAttempts(std::vector<SocketAddress> addresses);
+  void startNextAttempt();
+  void attemptSucceeded(Attempt* attempt);
+  void attemptFailed(Attempt* attempt, const AsyncSocketException& ex);
+  void closeAttempts();
+  void fail(const AsyncSocketException& ex);
+
+  // AsyncTimeout
+  void timeoutExpired() noexcept override;
+
+  // AsyncDNSResolver::Callback
+  void resolveSuccess(std::vector<SocketAddress> addresses) noexcept override;
+  void resolveError(const DNSResolverException& ex) noexcept override;
+
+  EventBase* evb_;
+  std::chrono::milliseconds attemptDelay_{kDefaultAttemptDelay};
+  Callback* callback_{nullptr};
+  AsyncDNSResolver* resolver_{nullptr};
+  std::vector<SocketAddress> addresses_;
+  size_t nextAddress_{0};
+  std::chrono::milliseconds timeout_{0};
+  AsyncSocket::OptionMap options_;
+  std::vector<std::unique_ptr<Attempt>> attempts_;
+  Optional<AsyncSocketException> lastError_;
+};
+
+} // namespace folly
@@ -482,24 +482,49 @@ RequestContext::RequestContext(const RequestContext& ctx, ChildTag)
   return std::make_shared<RequestContext>(ctx, ChildTag{});
 }
 
+/* static */ std::shared_ptr<RequestContext::State>
+RequestContext::unshareState(std::shared_ptr<State>& state) {
+  if (!state) {
+    state = std::make_shared<State>();
+    return nullptr;
+  }
+  if (state.use_count() == 1) {
+    // Pairs with the release by the last other owner, so that its reads of
+    // the state happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return nullptr;
+  }
+  auto prev = std::move(state);
+  state = std::make_shared<State>(*prev);
+  return prev;
+}
+
 bool RequestContext::doSetContextDataLock(
     const RequestToken& token,
     std::unique_ptr<RequestData>& data,
     DoSetBehaviour behaviour) {
+  RequestData::SharedPtr prevData;
+  std::shared_ptr<State> prevState;
+  // Declared before the wlock, so that the replaced data and state are
+  // released after giving it up, in case one of the RequestData destructors
+  // tries to grab the lock again.
   auto wlock = state_.wlock();
-  auto& state = *wlock;
+  if (behaviour == DoSetBehaviour::SET_IF_ABSENT && *wlock &&
+      (*wlock)->requestData_.count(token)) {
+    return false;
+  }
+  prevState = unshareState(*wlock);
+  auto& state = **wlock;
 
   auto it = state.requestData_.find(token);
   if (it != state.requestData_.end()) {
-    if (behaviour == DoSetBehaviour::SET_IF_ABSENT) {
-      return false;
-    }
+    DCHECK(behaviour != DoSetBehaviour::SET_IF_ABSENT);
     if (it->second) {
       if (it->second->hasCallback()) {
         it->second->onUnset();
         state.callbackData_.erase(it->second.get());
       }
-      it->second.reset(nullptr);
+      prevData = std::move(it->second);
     }
     if (behaviour == DoSetBehaviour::SET) {
       LOG_FIRST_N(WARNING, 1)
@@ -560,7 +585,8 @@ bool RequestContext::hasContextData(const RequestToken& val) const {
   if (useHazptr()) {
     return stateHazptr_.hasContextData(val);
   }
-  return state_.rlock()->requestData_.count(val);
+  auto rlock = state_.rlock();
+  return *rlock && (*rlock)->requestData_.count(val);
 }
 
 RequestData* FOLLY_NULLABLE
@@ -568,8 +594,12 @@ RequestContext::getContextData(const RequestToken& val) {
   if (useHazptr()) {
     return stateHazptr_.getContextData(val);
   }
+  auto rlock = state_.rlock();
+  if (!*rlock) {
+    return nullptr;
+  }
   const RequestData::SharedPtr dflt{nullptr};
-  return get_ref_default(state_.rlock()->requestData_, val, dflt).get();
+  return get_ref_default((*rlock)->requestData_, val, dflt).get();
 }
 
 const RequestData* FOLLY_NULLABLE
@@ -577,8 +607,12 @@ RequestContext::getContextData(const RequestToken& val) const {
   if (useHazptr()) {
     return stateHazptr_.getContextData(val);
   }
+  auto rlock = state_.rlock();
+  if (!*rlock) {
+    return nullptr;
+  }
   const RequestData::SharedPtr dflt{nullptr};
-  return get_ref_default(state_.rlock()->requestData_, val, dflt).get();
+  return get_ref_default((*rlock)->requestData_, val, dflt).get();
 }
 
 void RequestContext::onSet() {
@@ -587,7 +621,10 @@ void RequestContext::onSet() {
     return;
   }
   auto rlock = state_.rlock();
-  for (const auto& data : rlock->callbackData_) {
+  if (!*rlock) {
+    return;
+  }
+  for (const auto& data : (*rlock)->callbackData_) {
     data->onSet();
   }
 }
@@ -598,7 +635,10 @@ void RequestContext::onUnset() {
     return;
   }
   auto rlock = state_.rlock();
-  for (const auto& data : rlock->callbackData_) {
+  if (!*rlock) {
+    return;
+  }
+  for (const auto& data : (*rlock)->callbackData_) {
     data->onUnset();
   }
 }
@@ -609,25 +649,26 @@ void RequestContext::clearContextData(const RequestToken& val) {
     return;
   }
   RequestData::SharedPtr requestData;
+  std::shared_ptr<State> prevState;
   // Delete the RequestData after giving up the wlock just in case one of the
   // RequestData destructors will try to grab the lock again.
   {
     auto ulock = state_.ulock();
-    // Need non-const iterators to use under write lock.
-    auto& state = ulock.asNonConstUnsafe();
-    auto it = state.requestData_.find(val);
-    if (it == state.requestData_.end()) {
+    if (!*ulock || !(*ulock)->requestData_.count(val)) {
       return;
     }
 
     auto wlock = ulock.moveFromUpgradeToWrite();
+    prevState = unshareState(*wlock);
+    auto& state = **wlock;
+    auto it = state.requestData_.find(val);
     if (it->second && it->second->hasCallback()) {
       it->second->onUnset();
-      wlock->callbackData_.erase(it->second.get());
+      state.callbackData_.erase(it->second.get());
     }
 
     requestData = std::move(it->second);
-    wlock->requestData_.erase(it);
+    state.requestData_.erase(it);
   }
 }
 
@@ -694,34 +735,39 @@ FOLLY_ALWAYS_INLINE
 /* static */ std::shared_ptr<RequestContext> RequestContext::setContextLock(
     std::shared_ptr<RequestContext>& newCtx,
     StaticContext& staticCtx) {
-  auto curCtx = staticCtx;
-  if (newCtx && curCtx.first) {
+  // The contexts are moved rather than copied, so that switching does not
+  // touch their reference counts.
+  auto& curCtx = staticCtx.first;
+  std::shared_ptr<RequestContext> prevCtx;
+  if (newCtx && curCtx) {
     // Only call set/unset for all request data that differs
     auto ret = folly::acquireLocked(
-        as_const(newCtx->state_), as_const(curCtx.first->state_));
+        as_const(newCtx->state_), as_const(curCtx->state_));
     auto& newLock = std::get<0>(ret);
     auto& curLock = std::get<1>(ret);
-    auto& newData = newLock->callbackData_;
-    auto& curData = curLock->callbackData_;
+    // Empty, so constructing it does not allocate.
+    const decltype(State::callbackData_) noCallbacks;
+    auto& newData = *newLock ? (*newLock)->callbackData_ : noCallbacks;
+    auto& curData = *curLock ? (*curLock)->callbackData_ : noCallbacks;
     exec_set_difference(
         curData, newData, [](RequestData* data) { data->onUnset(); });
-    staticCtx.first = newCtx;
-    staticCtx.second = newCtx->rootId_;
+    prevCtx = std::exchange(curCtx, std::move(newCtx));
+    staticCtx.second = curCtx->rootId_;
     exec_set_difference(
         newData, curData, [](RequestData* data) { data->onSet(); });
   } else {
-    if (curCtx.first) {
-      curCtx.first->onUnset();
+    if (curCtx) {
+      curCtx->onUnset();
     }
-    staticCtx.first = newCtx;
-    if (newCtx) {
-      staticCtx.second = newCtx->rootId_;
-      newCtx->onSet();
+    prevCtx = std::exchange(curCtx, std::move(newCtx));
+    if (curCtx) {
+      staticCtx.second = curCtx->rootId_;
+      curCtx->onSet();
     } else {
       staticCtx.second = 0;
     }
   }
-  return curCtx.first;
+  return prevCtx;
 }
 
 FOLLY_ALWAYS_INLINE
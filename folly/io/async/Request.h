@@ -341,6 +341,11 @@ class RequestContext {
 
   // State immplementation with sequential data structures protected by a
   // read-write locks.
+  //
+  // The state is copy-on-write: copies of a context, e.g. the ones made by
+  // ShallowCopyRequestContextScopeGuard, share it in O(1) and a shared state
+  // is never modified. A writer first clones it, unless it is the only owner.
+  // A null state is empty.
   struct State {
     // This must be optimized for lookup, its hot path is getContextData
     // Efficiency of copying the container also matters in setShallowCopyContext
@@ -350,7 +355,12 @@ class RequestContext {
     // the difference with previous context
     sorted_vector_set<RequestData*> callbackData_;
   };
-  folly::Synchronized<State> state_;
+  folly::Synchronized<std::shared_ptr<State>> state_;
+
+  // Make state safe to modify, allocating it if null and cloning it if it is
+  // shared. Returns the state it replaced, so that callers can release it
+  // after unlocking.
+  static std::shared_ptr<State> unshareState(std::shared_ptr<State>& state);
 
   // State implementation with single-writer multi-reader data
   // structures protected by hazard pointers for readers and a lock
@@ -21,6 +21,7 @@
 #include <folly/Random.h>
 #include <folly/SharedMutex.h>
 #include <folly/SpinLock.h>
+#include <folly/io/async/SSLSessionCache.h>
 #include <folly/ssl/Init.h>
 #include <folly/system/ThreadId.h>
 
@@ -32,6 +33,55 @@ namespace folly {
 // For OpenSSL portability API
 using namespace folly::ssl;
 
+namespace {
+int getSSLContextExDataIndex() {
+  static auto index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+SSLContext* getSSLContextFromSSL(SSL* ssl) {
+  return static_cast<SSLContext*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), getSSLContextExDataIndex()));
+}
+
+int newSessionCallback(SSL* ssl, SSL_SESSION* session) {
+  auto* context = getSSLContextFromSSL(ssl);
+  if (context && context->getSessionCache()) {
+    context->getSessionCache()->add(session);
+  }
+  // we did not keep a reference to the session
+  return 0;
+}
+
+#if FOLLY_OPENSSL_IS_110
+SSL_SESSION*
+getSessionCallback(SSL* ssl, const unsigned char* id, int len, int* copy) {
+#else
+SSL_SESSION*
+getSessionCallback(SSL* ssl, unsigned char* id, int len, int* copy) {
+#endif
+  *copy = 0;
+  auto* context = getSSLContextFromSSL(ssl);
+  if (!context || !context->getSessionCache()) {
+    return nullptr;
+  }
+  return context->getSessionCache()->get(ByteRange(id, size_t(len))).release();
+}
+
+void removeSessionCallback(SSL_CTX* ctx, SSL_SESSION* session) {
+  auto* context = static_cast<SSLContext*>(
+      SSL_CTX_get_ex_data(ctx, getSSLContextExDataIndex()));
+  if (context && context->getSessionCache()) {
+    unsigned int len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &len);
+    context->getSessionCache()->remove(ByteRange(id, len));
+  }
+}
+} // namespace
+
+constexpr size_t SSLContext::kTicketKeyLength;
+
 // SSLContext implementation
 SSLContext::SSLContext(SSLVersion version) {
   folly::ssl::init();
@@ -79,6 +129,8 @@ SSLContext::SSLContext(SSLVersion version) {
 
   sslAcceptRunner_ = std::make_unique<SSLAcceptRunner>();
 
+  SSL_CTX_set_ex_data(ctx_, getSSLContextExDataIndex(), this);
+
 #if FOLLY_OPENSSL_HAS_SNI
   SSL_CTX_set_tlsext_servername_callback(ctx_, baseServerNameOpenSSLCallback);
   SSL_CTX_set_tlsext_servername_arg(ctx_, this);
@@ -567,6 +619,101 @@ void SSLContext::setSessionCacheContext(const std::string& context) {
           static_cast<unsigned int>(context.length()), SSL_MAX_SID_CTX_LENGTH));
 }
 
+void SSLContext::setSessionCache(std::shared_ptr<SSLSessionCache> cache) {
+  sessionCache_ = std::move(cache);
+  if (sessionCache_) {
+    SSL_CTX_set_session_cache_mode(
+        ctx_, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx_, newSessionCallback);
+    SSL_CTX_sess_set_get_cb(ctx_, getSessionCallback);
+    SSL_CTX_sess_set_remove_cb(ctx_, removeSessionCallback);
+  } else {
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_new_cb(ctx_, nullptr);
+    SSL_CTX_sess_set_get_cb(ctx_, nullptr);
+    SSL_CTX_sess_set_remove_cb(ctx_, nullptr);
+  }
+}
+
+void SSLContext::setTicketKeys(const std::vector<std::string>& keys) {
+  for (const auto& key : keys) {
+    if (key.size() != kTicketKeyLength) {
+      throw std::invalid_argument("invalid session ticket key length");
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(ticketKeysMutex_);
+    ticketKeys_ = keys.empty()
+        ? nullptr
+        : std::make_shared<const std::vector<std::string>>(keys);
+  }
+  if (keys.empty()) {
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx_, nullptr);
+  } else {
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx_, ticketKeyCallback);
+  }
+}
+
+int SSLContext::ticketKeyCallback(
+    SSL* ssl,
+    unsigned char* keyName,
+    unsigned char* iv,
+    EVP_CIPHER_CTX* cipherCtx,
+    HMAC_CTX* hmacCtx,
+    int encrypt) {
+  constexpr size_t kNameLength = 16;
+  constexpr size_t kSecretLength = 16;
+
+  auto* context = getSSLContextFromSSL(ssl);
+  std::shared_ptr<const std::vector<std::string>> keys;
+  if (context) {
+    std::lock_guard<std::mutex> guard(context->ticketKeysMutex_);
+    keys = context->ticketKeys_;
+  }
+  if (!keys) {
+    // no ticket, or a full handshake for the one we got
+    return 0;
+  }
+
+  const std::string* key = nullptr;
+  if (encrypt) {
+    key = &keys->front();
+    std::memcpy(keyName, key->data(), kNameLength);
+    if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_128_cbc())) != 1) {
+      return -1;
+    }
+  } else {
+    for (const auto& k : *keys) {
+      if (std::memcmp(keyName, k.data(), kNameLength) == 0) {
+        key = &k;
+        break;
+      }
+    }
+    if (!key) {
+      return 0;
+    }
+  }
+
+  auto* secrets = reinterpret_cast<const unsigned char*>(key->data());
+  if (HMAC_Init_ex(
+          hmacCtx,
+          secrets + kNameLength,
+          int(kSecretLength),
+          EVP_sha256(),
+          nullptr) != 1) {
+    return -1;
+  }
+  auto* aesKey = secrets + kNameLength + kSecretLength;
+  int rc = encrypt
+      ? EVP_EncryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv)
+      : EVP_DecryptInit_ex(cipherCtx, EVP_aes_128_cbc(), nullptr, aesKey, iv);
+  if (rc != 1) {
+    return -1;
+  }
+  // ask for a new ticket if this one was not made with the current key
+  return (encrypt || key == &keys->front()) ? 1 : 2;
+}
+
 /**
  * Match a name with a pattern. The pattern may include wildcard. A single
  * wildcard "*" can match up to one component in the domain name.
@@ -26,6 +26,7 @@
 
 #include <glog/logging.h>
 
+#include <folly/Executor.h>
 #include <folly/Function.h>
 #include <folly/Portability.h>
 #include <folly/Range.h>
@@ -71,7 +72,9 @@ class SSLAcceptRunner {
   /**
    * This is expected to run the first function and provide its return
    * value to the second function. This can be used to run the SSL_accept
-   * in different contexts.
+   * in different contexts. Both may be called from any thread; the socket
+   * does not touch the SSL object until the second one is called, and then
+   * continues in its EventBase thread.
    */
   virtual void run(Function<int()> acceptFunc, Function<void(int)> finallyFunc)
       const {
@@ -79,6 +82,33 @@ class SSLAcceptRunner {
   }
 };
 
+/**
+ * Runs SSL_accept on an executor, e.g. a CPUThreadPoolExecutor, so that the
+ * private key operations of full handshakes do not stall the other
+ * connections of the socket's EventBase.
+ *
+ * OpenSSL's error queue is thread-local, so handshake failures are reported
+ * with less detail than when SSL_accept runs in the EventBase thread.
+ */
+class ExecutorSSLAcceptRunner : public SSLAcceptRunner {
+ public:
+  explicit ExecutorSSLAcceptRunner(Executor::KeepAlive<> executor)
+      : executor_(std::move(executor)) {}
+
+  void run(Function<int()> acceptFunc, Function<void(int)> finallyFunc)
+      const override {
+    executor_->add([acceptFunc = std::move(acceptFunc),
+                    finallyFunc = std::move(finallyFunc)]() mutable {
+      finallyFunc(acceptFunc());
+    });
+  }
+
+ private:
+  Executor::KeepAlive<> executor_;
+};
+
+class SSLSessionCache;
+
 /**
  * Wrap OpenSSL SSL_CTX into a class.
  */
@@ -447,6 +477,37 @@ class SSLContext {
    */
   void setSessionCacheContext(const std::string& context);
 
+  /**
+   * Keep the server-side sessions of this context in the given cache instead
+   * of OpenSSL's internal one. The cache may be shared by several contexts;
+   * pass nullptr to go back to the internal cache.
+   *
+   * With SNI, the cache of the context picked by the ServerNameCallback is
+   * used.
+   */
+  void setSessionCache(std::shared_ptr<SSLSessionCache> cache);
+
+  const std::shared_ptr<SSLSessionCache>& getSessionCache() const {
+    return sessionCache_;
+  }
+
+  /**
+   * Length of a session ticket key: a 16 byte key name followed by 16 byte
+   * HMAC-SHA256 and AES-128 keys.
+   */
+  static constexpr size_t kTicketKeyLength = 48;
+
+  /**
+   * Set the keys used for TLS session tickets, e.g. to share them across
+   * servers and rotate them. New tickets are encrypted with the first key;
+   * tickets encrypted with the others are still accepted, and are replaced
+   * with a ticket from the first key. Thread-safe; an empty list goes back
+   * to OpenSSL's per-context random key.
+   *
+   * Throws std::invalid_argument if a key is not kTicketKeyLength bytes.
+   */
+  void setTicketKeys(const std::vector<std::string>& keys);
+
   /**
    * Set the options on the SSL_CTX object.
    */
@@ -608,6 +669,19 @@ class SSLContext {
 
   static int passwordCallback(char* password, int size, int, void* data);
 
+  static int ticketKeyCallback(
+      SSL* ssl,
+      unsigned char* keyName,
+      unsigned char* iv,
+      EVP_CIPHER_CTX* cipherCtx,
+      HMAC_CTX* hmacCtx,
+      int encrypt);
+
+  std::shared_ptr<SSLSessionCache> sessionCache_;
+
+  mutable std::mutex ticketKeysMutex_;
+  std::shared_ptr<const std::vector<std::string>> ticketKeys_;
+
 #if FOLLY_OPENSSL_HAS_SNI
   /**
    * The function that will be called directly from openssl
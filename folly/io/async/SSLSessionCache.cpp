@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/SSLSessionCache.h>
+
+namespace folly {
+
+constexpr size_t SSLSessionCache::kDefaultMaxSessions;
+
+bool SSLSessionCache::add(SSL_SESSION* session) {
+  unsigned int idLen = 0;
+  const unsigned char* id = SSL_SESSION_get_id(session, &idLen);
+  if (idLen == 0) {
+    return false;
+  }
+
+  int len = i2d_SSL_SESSION(session, nullptr);
+  if (len <= 0) {
+    return false;
+  }
+  std::string data(size_t(len), '\0');
+  auto* p = reinterpret_cast<unsigned char*>(&data[0]);
+  if (i2d_SSL_SESSION(session, &p) != len) {
+    return false;
+  }
+
+  if (maxSessions_ > 0 && sessions_.size() >= maxSessions_) {
+    auto it = sessions_.cbegin();
+    if (it != sessions_.cend()) {
+      sessions_.erase(it->first);
+    }
+  }
+  sessions_.insert_or_assign(
+      std::string(reinterpret_cast<const char*>(id), idLen), std::move(data));
+  return true;
+}
+
+ssl::SSLSessionUniquePtr SSLSessionCache::get(ByteRange sessionId) const {
+  auto it = sessions_.find(sessionId.str());
+  if (it == sessions_.cend()) {
+    return nullptr;
+  }
+  auto* p = reinterpret_cast<const unsigned char*>(it->second.data());
+  return ssl::SSLSessionUniquePtr(
+      d2i_SSL_SESSION(nullptr, &p, long(it->second.size())));
+}
+
+void SSLSessionCache::remove(ByteRange sessionId) {
+  sessions_.erase(sessionId.str());
+}
+
+} // namespace folly
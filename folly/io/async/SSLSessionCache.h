@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/portability/OpenSSL.h>
+#include <folly/ssl/OpenSSLPtrTypes.h>
+
+namespace folly {
+
+/**
+ * Server-side TLS session cache that may be shared by any number of
+ * SSLContexts and IO threads, see SSLContext::setSessionCache().
+ *
+ * Sessions are stored serialized in a ConcurrentHashMap keyed by session id,
+ * so handshakes on different threads do not contend on a global lock the way
+ * OpenSSL's internal cache does. When the cache is full an arbitrary session
+ * is evicted. Expiration is left to OpenSSL, which checks the timeout of a
+ * session it got from the cache and removes it if it is stale.
+ */
+class SSLSessionCache {
+ public:
+  static constexpr size_t kDefaultMaxSessions = 20480;
+
+  explicit SSLSessionCache(size_t maxSessions = kDefaultMaxSessions)
+      : maxSessions_(maxSessions) {}
+
+  /**
+   * Store a session under its id. Returns false if it could not be
+   * serialized.
+   */
+  bool add(SSL_SESSION* session);
+
+  /**
+   * Look up a session by id; returns nullptr if there is none.
+   */
+  ssl::SSLSessionUniquePtr get(ByteRange sessionId) const;
+
+  void remove(ByteRange sessionId);
+
+  size_t size() const {
+    return sessions_.size();
+  }
+
+ private:
+  size_t maxSessions_;
+  ConcurrentHashMap<std::string, std::string> sessions_;
+};
+
+} // namespace folly
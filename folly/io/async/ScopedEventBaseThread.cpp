@@ -21,6 +21,7 @@
 #include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/EventBaseMemoryIdler.h>
 #include <folly/system/ThreadName.h>
 
 using namespace std;
@@ -37,7 +38,10 @@ static void run(
   }
 
   ebm->setEventBase(eb, false);
-  eb->loopForever();
+  {
+    EventBaseMemoryIdler idler(*eb);
+    eb->loopForever();
+  }
 
   // must destruct in io thread for on-destruction callbacks
   eb->runOnDestruction([=] { ebm->clearEventBase(); });
@@ -22,12 +22,22 @@ VirtualEventBase::VirtualEventBase(EventBase& evb)
     : evb_(getKeepAliveToken(evb)) {}
 
 std::future<void> VirtualEventBase::destroy() {
+  // With destroyAsync() this object may be deleted as soon as the callback
+  // below is queued, so take the future first.
+  auto future = std::move(destroyFuture_);
   evb_->runInEventBaseThread([this] { loopKeepAlive_.reset(); });
 
-  return std::move(destroyFuture_);
+  return future;
+}
+
+std::future<void> VirtualEventBase::destroyAsync(
+    std::unique_ptr<VirtualEventBase> veb) {
+  veb->deleteOnDestroy_ = true;
+  return veb.release()->destroy();
 }
 
 void VirtualEventBase::destroyImpl() {
+  std::exception_ptr ex;
   try {
     {
       // After destroyPromise_ is posted this object may be destroyed, so make
@@ -50,10 +60,20 @@ void VirtualEventBase::destroyImpl() {
         }
       }
     }
-
-    destroyPromise_.set_value();
   } catch (...) {
-    destroyPromise_.set_exception(std::current_exception());
+    ex = std::current_exception();
+  }
+
+  // Once the promise is fulfilled (or, with destroyAsync(), once we delete
+  // ourselves) this object must no longer be touched.
+  auto promise = std::move(destroyPromise_);
+  if (deleteOnDestroy_) {
+    delete this;
+  }
+  if (ex) {
+    promise.set_exception(std::move(ex));
+  } else {
+    promise.set_value();
   }
 }
 
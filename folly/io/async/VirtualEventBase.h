@@ -17,6 +17,7 @@
 #pragma once
 
 #include <future>
+#include <memory>
 
 #include <folly/Executor.h>
 #include <folly/Function.h>
@@ -36,7 +37,8 @@ namespace folly {
  *
  * VirtualEventBase destructor blocks until all its KeepAliveTokens are released
  * and all tasks scheduled through it are complete. EventBase destructor also
- * blocks until all VirtualEventBases backed by it are released.
+ * blocks until all VirtualEventBases backed by it are released. Use
+ * destroyAsync() to tear a VirtualEventBase down without blocking.
  */
 class VirtualEventBase : public folly::Executor, public folly::TimeoutManager {
  public:
@@ -47,6 +49,17 @@ class VirtualEventBase : public folly::Executor, public folly::TimeoutManager {
 
   ~VirtualEventBase() override;
 
+  /**
+   * Non-blocking alternative to the destructor: takes ownership of veb and
+   * deletes it from the EventBase thread once all its KeepAliveTokens are
+   * released and its on-destruction callbacks have run. The returned future
+   * is fulfilled after veb has been deleted.
+   *
+   * Unlike the destructor this may be called from any thread, including the
+   * EventBase thread.
+   */
+  static std::future<void> destroyAsync(std::unique_ptr<VirtualEventBase> veb);
+
   EventBase& getEventBase() {
     return *evb_;
   }
@@ -133,19 +146,29 @@ class VirtualEventBase : public folly::Executor, public folly::TimeoutManager {
     return true;
   }
 
-  void keepAliveReleaseEvb() {
+  void keepAliveReleaseEvb(ssize_t count = 1) {
     if (loopKeepAliveCountAtomic_.load()) {
       loopKeepAliveCount_ += loopKeepAliveCountAtomic_.exchange(0);
     }
-    DCHECK(loopKeepAliveCount_ > 0);
-    if (--loopKeepAliveCount_ == 0) {
+    DCHECK(loopKeepAliveCount_ >= count);
+    loopKeepAliveCount_ -= count;
+    if (loopKeepAliveCount_ == 0) {
       destroyImpl();
     }
   }
 
   void keepAliveRelease() override {
     if (!evb_->inRunningEventBaseThread()) {
-      evb_->add([=] { keepAliveReleaseEvb(); });
+      // Releases from other threads are batched: only the first release
+      // since the last drain schedules a callback on the EventBase. The
+      // released token is still counted until that callback runs, so this
+      // object stays alive until evb_->add() returns.
+      if (pendingReleaseCount_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        evb_->add([this] {
+          keepAliveReleaseEvb(
+              pendingReleaseCount_.exchange(0, std::memory_order_acq_rel));
+        });
+      }
       return;
     }
 
@@ -171,6 +194,10 @@ class VirtualEventBase : public folly::Executor, public folly::TimeoutManager {
 
   ssize_t loopKeepAliveCount_{1};
   std::atomic<ssize_t> loopKeepAliveCountAtomic_{0};
+  // Releases from other threads not yet applied to loopKeepAliveCount_.
+  std::atomic<ssize_t> pendingReleaseCount_{0};
+  // Set by destroyAsync(): destroyImpl() deletes this object.
+  bool deleteOnDestroy_{false};
   std::promise<void> destroyPromise_;
   std::future<void> destroyFuture_{destroyPromise_.get_future()};
   KeepAlive<VirtualEventBase> loopKeepAlive_{
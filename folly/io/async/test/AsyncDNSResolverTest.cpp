@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncDNSResolver.h>
+
+#include <map>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HappyEyeballsConnector.h>
+#include <folly/io/async/test/AsyncSocketTest.h>
+#include <folly/io/async/test/ScopedBoundPort.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Answers A and AAAA queries from a table; unknown names get NXDOMAIN.
+class FakeNameserver : public AsyncUDPSocket::ReadCallback {
+ public:
+  struct Records {
+    std::vector<IPAddress> addresses;
+    uint32_t ttl{60};
+    uint8_t rcode{0};
+  };
+
+  explicit FakeNameserver(EventBase* evb) : socket_(evb) {
+    socket_.bind(SocketAddress("127.0.0.1", 0));
+    socket_.resumeRead(this);
+  }
+
+  SocketAddress address() const {
+    return socket_.address();
+  }
+
+  std::map<std::string, Records> records;
+  bool drop{false};
+  size_t numQueries{0};
+
+ private:
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buf_.data();
+    *len = buf_.size();
+  }
+
+  void onDataAvailable(
+      const SocketAddress& client,
+      size_t len,
+      bool /* truncated */) noexcept override {
+    ++numQueries;
+    if (drop) {
+      return;
+    }
+    size_t pos = 12;
+    std::string name;
+    while (pos < len && buf_[pos] != 0) {
+      if (!name.empty()) {
+        name.push_back('.');
+      }
+      name.append(reinterpret_cast<const char*>(&buf_[pos + 1]), buf_[pos]);
+      pos += 1 + buf_[pos];
+    }
+    uint16_t qtype = uint16_t((buf_[pos + 1] << 8) | buf_[pos + 2]);
+    size_t questionEnd = pos + 5;
+
+    auto it = records.find(name);
+    uint8_t rcode = it == records.end() ? 3 : it->second.rcode;
+    std::vector<IPAddress> answers;
+    if (it != records.end() && rcode == 0) {
+      for (const auto& address : it->second.addresses) {
+        if (address.isV4() == (qtype == 1)) {
+          answers.push_back(address);
+        }
+      }
+    }
+
+    auto response = IOBuf::create(512);
+    io::Appender appender(response.get(), 512);
+    appender.push(buf_.data(), 2);
+    appender.writeBE<uint16_t>(uint16_t(0x8180 | rcode));
+    appender.writeBE<uint16_t>(1);
+    appender.writeBE<uint16_t>(uint16_t(answers.size()));
+    appender.writeBE<uint16_t>(0);
+    appender.writeBE<uint16_t>(0);
+    appender.push(&buf_[12], questionEnd - 12);
+    for (const auto& address : answers) {
+      // a pointer to the question name
+      appender.writeBE<uint16_t>(0xc00c);
+      appender.writeBE<uint16_t>(qtype);
+      appender.writeBE<uint16_t>(1);
+      appender.writeBE<uint32_t>(it->second.ttl);
+      appender.writeBE<uint16_t>(uint16_t(address.byteCount()));
+      appender.push(address.bytes(), address.byteCount());
+    }
+    socket_.write(client, response);
+  }
+
+  void onReadError(const AsyncSocketException&) noexcept override {}
+  void onReadClosed() noexcept override {}
+
+  AsyncUDPSocket socket_;
+  std::array<uint8_t, 512> buf_;
+};
+
+class ResolveCallback : public AsyncDNSResolver::Callback {
+ public:
+  void resolveSuccess(std::vector<SocketAddress> result) noexcept override {
+    ++numCalls;
+    addresses = std::move(result);
+  }
+
+  void resolveError(const DNSResolverException& ex) noexcept override {
+    ++numCalls;
+    error = ex.getType();
+  }
+
+  size_t numCalls{0};
+  std::vector<SocketAddress> addresses;
+  Optional<DNSResolverException::Type> error;
+};
+
+class AsyncDNSResolverTest : public ::testing::Test {
+ protected:
+  AsyncDNSResolver::Options options() {
+    AsyncDNSResolver::Options options;
+    options.nameservers = {server.address()};
+    options.timeout = 20ms;
+    options.cache = cache;
+    return options;
+  }
+
+  // The fake nameserver keeps EventBase::loop() from returning.
+  template <typename Predicate>
+  void loopUntil(Predicate predicate) {
+    while (!predicate()) {
+      evb.loopOnce();
+    }
+  }
+
+  EventBase evb;
+  FakeNameserver server{&evb};
+  std::shared_ptr<DNSCache> cache = std::make_shared<DNSCache>();
+};
+
+} // namespace
+
+TEST_F(AsyncDNSResolverTest, Resolve) {
+  server.records["example.com"].addresses = {
+      IPAddress("10.0.0.1"), IPAddress("::2"), IPAddress("10.0.0.3")};
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback callback;
+  resolver.resolve(&callback, "example.com", 80);
+  EXPECT_EQ(1u, resolver.pendingLookups());
+  loopUntil([&] { return callback.numCalls > 0; });
+  EXPECT_EQ(1u, callback.numCalls);
+  EXPECT_FALSE(callback.error);
+  EXPECT_EQ(
+      std::vector<SocketAddress>(
+          {SocketAddress("::2", 80),
+           SocketAddress("10.0.0.1", 80),
+           SocketAddress("10.0.0.3", 80)}),
+      callback.addresses);
+  EXPECT_EQ(2u, server.numQueries);
+  EXPECT_EQ(0u, resolver.pendingLookups());
+}
+
+TEST_F(AsyncDNSResolverTest, CoalesceAndCache) {
+  server.records["example.com"].addresses = {IPAddress("10.0.0.1")};
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback first;
+  ResolveCallback second;
+  resolver.resolve(&first, "example.com", 80);
+  resolver.resolve(&second, "Example.COM.", 443);
+  EXPECT_EQ(1u, resolver.pendingLookups());
+  loopUntil([&] { return second.numCalls > 0; });
+  EXPECT_EQ(2u, server.numQueries);
+  EXPECT_EQ(
+      std::vector<SocketAddress>({SocketAddress("10.0.0.1", 80)}),
+      first.addresses);
+  EXPECT_EQ(
+      std::vector<SocketAddress>({SocketAddress("10.0.0.1", 443)}),
+      second.addresses);
+
+  // answered by the cache, before resolve() returns
+  ResolveCallback cached;
+  resolver.resolve(&cached, "example.com", 8080);
+  EXPECT_EQ(1u, cached.numCalls);
+  EXPECT_EQ(
+      std::vector<SocketAddress>({SocketAddress("10.0.0.1", 8080)}),
+      cached.addresses);
+  EXPECT_EQ(2u, server.numQueries);
+  EXPECT_EQ(1u, cache->size());
+}
+
+TEST_F(AsyncDNSResolverTest, NotFound) {
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback callback;
+  resolver.resolve(&callback, "missing.example.com");
+  loopUntil([&] { return callback.numCalls > 0; });
+  ASSERT_TRUE(callback.error);
+  EXPECT_EQ(DNSResolverException::NOT_FOUND, *callback.error);
+
+  // negatively cached
+  ResolveCallback cached;
+  resolver.resolve(&cached, "missing.example.com");
+  ASSERT_TRUE(cached.error);
+  EXPECT_EQ(DNSResolverException::NOT_FOUND, *cached.error);
+  EXPECT_EQ(2u, server.numQueries);
+}
+
+TEST_F(AsyncDNSResolverTest, Timeout) {
+  server.drop = true;
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback callback;
+  resolver.resolve(&callback, "example.com");
+  loopUntil([&] { return callback.numCalls > 0; });
+  ASSERT_TRUE(callback.error);
+  EXPECT_EQ(DNSResolverException::TIMED_OUT, *callback.error);
+  // two attempts for each of A and AAAA
+  EXPECT_EQ(4u, server.numQueries);
+  EXPECT_EQ(0u, cache->size());
+}
+
+TEST_F(AsyncDNSResolverTest, WithoutQuery) {
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback literal;
+  resolver.resolve(&literal, "[::1]", 80);
+  EXPECT_EQ(
+      std::vector<SocketAddress>({SocketAddress("::1", 80)}),
+      literal.addresses);
+
+  ResolveCallback localhost;
+  resolver.resolve(&localhost, "localhost", 80);
+  EXPECT_EQ(
+      std::vector<SocketAddress>(
+          {SocketAddress("::1", 80), SocketAddress("127.0.0.1", 80)}),
+      localhost.addresses);
+
+  ResolveCallback invalid;
+  resolver.resolve(&invalid, "a..b");
+  ASSERT_TRUE(invalid.error);
+  EXPECT_EQ(DNSResolverException::INVALID_NAME, *invalid.error);
+
+  EXPECT_EQ(0u, server.numQueries);
+}
+
+TEST_F(AsyncDNSResolverTest, Cancel) {
+  server.records["example.com"].addresses = {IPAddress("10.0.0.1")};
+  AsyncDNSResolver resolver(&evb, options());
+
+  ResolveCallback callback;
+  resolver.resolve(&callback, "example.com");
+  resolver.cancel(&callback);
+  loopUntil([&] { return resolver.pendingLookups() == 0; });
+  EXPECT_EQ(0u, callback.numCalls);
+  // the lookup still completed
+  EXPECT_EQ(1u, cache->size());
+}
+
+TEST_F(AsyncDNSResolverTest, Destroy) {
+  server.drop = true;
+  ResolveCallback callback;
+  {
+    AsyncDNSResolver resolver(&evb, options());
+    resolver.resolve(&callback, "example.com");
+  }
+  EXPECT_EQ(1u, callback.numCalls);
+  ASSERT_TRUE(callback.error);
+  EXPECT_EQ(DNSResolverException::CANCELLED, *callback.error);
+}
+
+TEST(DNSCacheTest, Expiry) {
+  DNSCache cache(16, 4);
+  auto now = DNSCache::Clock::now();
+  cache.put("example.com", {IPAddress("10.0.0.1")}, 10s, now);
+  cache.put("missing.example.com", {}, 10s, now);
+  // zero TTLs are not cached
+  cache.put("uncached.example.com", {IPAddress("10.0.0.2")}, 0s, now);
+
+  auto hit = cache.get("example.com", now + 9s);
+  ASSERT_TRUE(hit);
+  EXPECT_EQ(std::vector<IPAddress>({IPAddress("10.0.0.1")}), *hit);
+  auto negative = cache.get("missing.example.com", now);
+  ASSERT_TRUE(negative);
+  EXPECT_TRUE(negative->empty());
+  EXPECT_FALSE(cache.get("uncached.example.com", now));
+  EXPECT_EQ(2u, cache.size());
+
+  EXPECT_FALSE(cache.get("example.com", now + 10s));
+  EXPECT_EQ(1u, cache.size());
+  cache.clear();
+  EXPECT_EQ(0u, cache.size());
+}
+
+namespace {
+class HappyEyeballsCallback : public HappyEyeballsConnector::Callback {
+ public:
+  void connectSuccess(AsyncSocket::UniquePtr sock) noexcept override {
+    socket = std::move(sock);
+  }
+
+  void connectErr(const AsyncSocketException& ex) noexcept override {
+    error = ex.getType();
+  }
+
+  AsyncSocket::UniquePtr socket;
+  Optional<AsyncSocketException::AsyncSocketExceptionType> error;
+};
+} // namespace
+
+TEST(HappyEyeballsConnectorTest, InterleaveFamilies) {
+  auto sorted = HappyEyeballsConnector::interleaveFamilies(
+      {SocketAddress("::1", 1),
+       SocketAddress("::2", 1),
+       SocketAddress("::3", 1),
+       SocketAddress("10.0.0.1", 1)});
+  EXPECT_EQ(
+      std::vector<SocketAddress>(
+          {SocketAddress("::1", 1),
+           SocketAddress("10.0.0.1", 1),
+           SocketAddress("::2", 1),
+           SocketAddress("::3", 1)}),
+      sorted);
+}
+
+TEST(HappyEyeballsConnectorTest, FirstAddressRefused) {
+  EventBase evb;
+  ScopedBoundPort closed(IPAddress("127.0.0.1"));
+  TestServer server;
+
+  HappyEyeballsConnector connector(&evb);
+  // the refused attempt starts the next one without waiting for the delay
+  connector.setAttemptDelay(10s);
+  HappyEyeballsCallback callback;
+  connector.connect(
+      &callback, {closed.getAddress(), server.getAddress()}, 1000ms);
+  evb.loop();
+  ASSERT_TRUE(callback.socket);
+  EXPECT_FALSE(callback.error);
+  SocketAddress peer;
+  callback.socket->getPeerAddress(&peer);
+  EXPECT_EQ(server.getAddress(), peer);
+  EXPECT_FALSE(connector.connecting());
+}
+
+TEST(HappyEyeballsConnectorTest, AllRefused) {
+  EventBase evb;
+  ScopedBoundPort closed(IPAddress("127.0.0.1"));
+
+  HappyEyeballsConnector connector(&evb);
+  HappyEyeballsCallback callback;
+  connector.connect(&callback, {closed.getAddress(), closed.getAddress()});
+  evb.loop();
+  EXPECT_FALSE(callback.socket);
+  ASSERT_TRUE(callback.error);
+  EXPECT_EQ(AsyncSocketException::NOT_OPEN, *callback.error);
+}
+
+TEST_F(AsyncDNSResolverTest, HappyEyeballsResolve) {
+  TestServer tcpServer;
+  server.records["example.com"].addresses = {
+      tcpServer.getAddress().getIPAddress()};
+  AsyncDNSResolver resolver(&evb, options());
+
+  HappyEyeballsConnector connector(&evb);
+  HappyEyeballsCallback callback;
+  connector.connect(
+      &callback, &resolver, "example.com", tcpServer.getAddress().getPort());
+  loopUntil([&] { return !connector.connecting(); });
+  ASSERT_TRUE(callback.socket);
+  SocketAddress peer;
+  callback.socket->getPeerAddress(&peer);
+  EXPECT_EQ(tcpServer.getAddress(), peer);
+}
@@ -181,3 +181,22 @@ TEST_F(AsyncPipeTest, writeOnClose) {
     EXPECT_TRUE(writeCallback_.error_);
   }
 }
+
+TEST_F(AsyncPipeTest, writeChain) {
+  reset(false);
+  reader_->setReadCB(&readCallback_);
+  // More buffers than one writev() takes, and more data than the pipe holds
+  auto chain = getBuf("");
+  std::string expected;
+  for (int i = 0; i < 200; ++i) {
+    auto data = std::string(1000, char('a' + i % 26));
+    chain->prependChain(getBuf(data));
+    expected += data;
+  }
+  writer_->write(std::move(chain), &writeCallback_);
+  writer_->closeOnEmpty();
+  eventBase_.loop();
+  EXPECT_EQ(readCallback_.getData(), expected);
+  EXPECT_EQ(writeCallback_.writes_, 1);
+  EXPECT_FALSE(writeCallback_.error_);
+}
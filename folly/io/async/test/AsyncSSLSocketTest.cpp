@@ -259,6 +259,202 @@ TEST(AsyncSSLSocketTest, ConnectWriteReadLargeClose) {
   EXPECT_EQ(socket->getSSLSocket()->getTotalConnectTimeout().count(), 10000);
 }
 
+/**
+ * Same as above simple test, but the client hands the records to kernel TLS
+ * after the handshake, if the kernel supports it.
+ */
+TEST(AsyncSSLSocketTest, ConnectWriteReadCloseKTLS) {
+  // Start listening on a local port
+  WriteCallbackBase writeCallback;
+  ReadCallback readCallback(&writeCallback);
+  HandshakeCallback handshakeCallback(&readCallback);
+  SSLServerAcceptCallback acceptCallback(&handshakeCallback);
+  TestSSLServer server(&acceptCallback);
+
+  // kernel TLS only takes TLS 1.2 AES-GCM
+  auto sslContext = std::make_shared<SSLContext>();
+  sslContext->ciphers("ECDHE-RSA-AES128-GCM-SHA256");
+#if FOLLY_OPENSSL_IS_110
+  SSL_CTX_set_max_proto_version(sslContext->getSSLCtx(), TLS1_2_VERSION);
+#endif
+
+  auto socket =
+      std::make_shared<BlockingSocket>(server.getAddress(), sslContext);
+  socket->getSSLSocket()->setKTLSEnabled(true);
+  socket->open(std::chrono::milliseconds(10000));
+  if (!socket->getSSLSocket()->isKTLSActive()) {
+    LOG(INFO) << "kernel TLS not available, using OpenSSL";
+  }
+
+  std::array<uint8_t, 128> buf;
+  memset(buf.data(), 'a', buf.size());
+  socket->write(buf.data(), buf.size());
+
+  std::array<uint8_t, 128> readbuf;
+  uint32_t bytesRead = socket->readAll(readbuf.data(), readbuf.size());
+  EXPECT_EQ(bytesRead, 128);
+  EXPECT_EQ(memcmp(buf.data(), readbuf.data(), bytesRead), 0);
+
+  socket->close();
+}
+
+namespace {
+class CountingReadCallback : public AsyncTransportWrapper::ReadCallback {
+ public:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    *bufReturn = buf_.data();
+    *lenReturn = buf_.size();
+  }
+  void readDataAvailable(size_t len) noexcept override {
+    data.append(buf_.data(), len);
+  }
+  void readEOF() noexcept override {}
+  void readErr(const AsyncSocketException& ex) noexcept override {
+    ADD_FAILURE() << "read error: " << ex.what();
+  }
+
+  std::string data;
+
+ private:
+  std::array<char, 64 * 1024> buf_;
+};
+
+// Writes data and returns the number of sendmsg() calls that took bytes
+size_t writeAndCount(
+    EventBase& evb,
+    AsyncSSLSocket& writer,
+    AsyncSSLSocket& reader,
+    const std::string& data) {
+  auto before = writer.getIOStats();
+  CountingReadCallback readCallback;
+  reader.setReadCB(&readCallback);
+  writer.writeChain(nullptr, IOBuf::copyBuffer(data));
+  while (readCallback.data.size() < data.size()) {
+    evb.loopOnce();
+  }
+  reader.setReadCB(nullptr);
+  EXPECT_EQ(data, readCallback.data);
+  const auto& after = writer.getIOStats();
+  return (after.writeCalls - after.writesBlocked) -
+      (before.writeCalls - before.writesBlocked);
+}
+} // namespace
+
+/**
+ * Test that the records of a write are sent together, and their sizes.
+ */
+TEST(AsyncSSLSocketTest, RecordWrites) {
+  EventBase eventBase;
+  AsyncSSLSocket::UniquePtr clientSock, serverSock;
+  sslsocketpair(&eventBase, &clientSock, &serverSock);
+  SSLHandshakeClientNoVerify client(std::move(clientSock), false, false);
+  SSLHandshakeServer server(std::move(serverSock), false, false);
+  eventBase.loop();
+  ASSERT_TRUE(client.handshakeSuccess_);
+  ASSERT_TRUE(server.handshakeSuccess_);
+  auto cliSocket = std::move(client).moveSocket();
+  auto srvSocket = std::move(server).moveSocket();
+
+  std::string data(100 * 1024, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = char(i % 251);
+  }
+
+  // one record, and one sendmsg(), per 16KB
+  EXPECT_TRUE(cliSocket->getBatchRecordWrites());
+  cliSocket->setBatchRecordWrites(false);
+  EXPECT_EQ(7u, writeAndCount(eventBase, *cliSocket, *srvSocket, data));
+
+  // batches of up to 64KB
+  cliSocket->setBatchRecordWrites(true);
+  EXPECT_EQ(2u, writeAndCount(eventBase, *cliSocket, *srvSocket, data));
+
+  AsyncSSLSocket::DynamicRecordSizing sizing;
+  sizing.smallRecordSize = 1000;
+  sizing.threshold = 10000;
+  sizing.idleTimeout = std::chrono::milliseconds(50);
+  cliSocket->setDynamicRecordSizing(sizing);
+  cliSocket->setBatchRecordWrites(false);
+  // small records until the threshold is reached, large ones after
+  EXPECT_EQ(
+      20u,
+      writeAndCount(eventBase, *cliSocket, *srvSocket, data.substr(0, 20000)));
+  EXPECT_EQ(
+      2u,
+      writeAndCount(eventBase, *cliSocket, *srvSocket, data.substr(0, 20000)));
+  // and small ones again after the connection was idle
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(
+      3u,
+      writeAndCount(eventBase, *cliSocket, *srvSocket, data.substr(0, 3000)));
+
+  cliSocket->setDynamicRecordSizing(none);
+  EXPECT_FALSE(cliSocket->getDynamicRecordSizing());
+
+  // batches that don't fit in the socket buffer are sent partially
+  cliSocket->setBatchRecordWrites(true);
+  std::string large;
+  for (int i = 0; i < 40; ++i) {
+    large += data;
+  }
+  EXPECT_GT(writeAndCount(eventBase, *cliSocket, *srvSocket, large), 0u);
+}
+
+/**
+ * Test that a write blocked for longer than the idle timeout keeps its
+ * record size, as OpenSSL requires retrying with the same record.
+ */
+TEST(AsyncSSLSocketTest, DynamicRecordSizingBlockedWrite) {
+  EventBase eventBase;
+  AsyncSSLSocket::UniquePtr clientSock, serverSock;
+  sslsocketpair(&eventBase, &clientSock, &serverSock);
+  SSLHandshakeClientNoVerify client(std::move(clientSock), false, false);
+  SSLHandshakeServer server(std::move(serverSock), false, false);
+  eventBase.loop();
+  ASSERT_TRUE(client.handshakeSuccess_);
+  ASSERT_TRUE(server.handshakeSuccess_);
+  auto cliSocket = std::move(client).moveSocket();
+  auto srvSocket = std::move(server).moveSocket();
+
+  AsyncSSLSocket::DynamicRecordSizing sizing;
+  sizing.smallRecordSize = 1000;
+  sizing.threshold = 10000;
+  sizing.idleTimeout = std::chrono::milliseconds(50);
+  cliSocket->setDynamicRecordSizing(sizing);
+  std::string data(20000, 'a');
+  writeAndCount(eventBase, *cliSocket, *srvSocket, data);
+
+  class Callback : public AsyncTransportWrapper::WriteCallback {
+   public:
+    void writeSuccess() noexcept override {
+      succeeded = true;
+    }
+    void writeErr(size_t, const AsyncSocketException& ex) noexcept override {
+      ADD_FAILURE() << "write error: " << ex.what();
+    }
+    bool succeeded{false};
+  } writeCallback;
+
+  // large records now, until the socket buffer is full
+  std::string large(8 * 1024 * 1024, 'b');
+  cliSocket->writeChain(&writeCallback, IOBuf::copyBuffer(large));
+  eventBase.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_FALSE(writeCallback.succeeded);
+  ASSERT_GT(cliSocket->getAppBytesBuffered(), 0u);
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  CountingReadCallback readCallback;
+  srvSocket->setReadCB(&readCallback);
+  while (readCallback.data.size() < large.size()) {
+    eventBase.loopOnce();
+  }
+  srvSocket->setReadCB(nullptr);
+  EXPECT_TRUE(writeCallback.succeeded);
+  EXPECT_EQ(large, readCallback.data);
+}
+
 /**
  * Test reading after server close.
  */
@@ -2154,6 +2350,42 @@ TEST(AsyncSSLSocketTest, SSLAcceptRunnerFiber) {
   EXPECT_FALSE(server.handshakeError_);
 }
 
+TEST(AsyncSSLSocketTest, SSLAcceptRunnerExecutor) {
+  EventBase eventBase;
+  ScopedEventBaseThread worker;
+  auto clientCtx = std::make_shared<SSLContext>();
+  auto serverCtx = std::make_shared<SSLContext>();
+  serverCtx->ciphers("ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+  serverCtx->loadPrivateKey(kTestKey);
+  serverCtx->loadCertificate(kTestCert);
+
+  clientCtx->setVerificationOption(SSLContext::SSLVerifyPeerEnum::VERIFY);
+  clientCtx->ciphers("ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+  clientCtx->loadTrustedCertificates(kTestCA);
+
+  NetworkSocket fds[2];
+  getfds(fds);
+
+  AsyncSSLSocket::UniquePtr clientSock(
+      new AsyncSSLSocket(clientCtx, &eventBase, fds[0], false));
+  AsyncSSLSocket::UniquePtr serverSock(
+      new AsyncSSLSocket(serverCtx, &eventBase, fds[1], true));
+
+  SSLHandshakeClient client(std::move(clientSock), true, true);
+  SSLHandshakeServer server(std::move(serverSock), true, true);
+
+  serverCtx->sslAcceptRunner(std::make_unique<ExecutorSSLAcceptRunner>(
+      getKeepAliveToken(worker.getEventBase())));
+
+  // the loop must not exit while the handshake is on the worker
+  eventBase.loop();
+
+  EXPECT_TRUE(client.handshakeSuccess_);
+  EXPECT_FALSE(client.handshakeError_);
+  EXPECT_TRUE(server.handshakeSuccess_);
+  EXPECT_FALSE(server.handshakeError_);
+}
+
 static int newCloseCb(SSL* ssl, SSL_SESSION*) {
   AsyncSSLSocket::getFromSSL(ssl)->closeNow();
   return 1;
@@ -25,6 +25,7 @@
 
 #include <folly/experimental/TestUtil.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/io/async/test/AsyncSocketTest.h>
 #include <folly/io/async/test/Util.h>
 #include <folly/portability/GMock.h>
@@ -1311,6 +1312,66 @@ TEST(AsyncSocketTest, WriteIOBuf) {
   ASSERT_FALSE(socket->isClosedByPeer());
 }
 
+TEST(AsyncSocketTest, WriteFile) {
+  TestServer server;
+
+  EventBase evb;
+  std::shared_ptr<AsyncSocket> socket = AsyncSocket::newSocket(&evb);
+  ConnCallback ccb;
+  socket->connect(&ccb, server.getAddress(), 30);
+
+  std::shared_ptr<AsyncSocket> acceptedSocket = server.acceptAsync(&evb);
+  ReadCallback rcb;
+  acceptedSocket->setReadCB(&rcb);
+
+  // large enough to take several writes
+  TemporaryFile file(
+      StringPiece(), fs::path(), TemporaryFile::Scope::UNLINK_IMMEDIATELY);
+  std::string contents(1024 * 1024, 'f');
+  for (size_t i = 0; i < contents.size(); i += 4096) {
+    contents[i] = char('a' + (i / 4096) % 26);
+  }
+  ASSERT_EQ(
+      write(file.fd(), contents.data(), contents.size()),
+      ssize_t(contents.size()));
+  constexpr size_t kOffset = 100;
+
+  // the file is sent between the other writes
+  WriteCallback wcb1;
+  socket->write(&wcb1, "head", 4);
+  WriteCallback wcb2;
+  socket->writeFile(&wcb2, file.fd(), kOffset, contents.size() - kOffset);
+  WriteCallback wcb3;
+  socket->writeChain(&wcb3, IOBuf::copyBuffer("tail"));
+  socket->shutdownWrite();
+
+  evb.loop();
+
+  ASSERT_EQ(wcb1.state, STATE_SUCCEEDED);
+  ASSERT_EQ(wcb2.state, STATE_SUCCEEDED);
+  ASSERT_EQ(wcb3.state, STATE_SUCCEEDED);
+  ASSERT_EQ(rcb.state, STATE_SUCCEEDED);
+  std::string received;
+  for (const auto& buf : rcb.buffers) {
+    received.append(buf.buffer, buf.length);
+  }
+  EXPECT_EQ("head" + contents.substr(kOffset) + "tail", received);
+
+  // a file that is shorter than requested fails the write
+  WriteCallback wcb4;
+  socket = AsyncSocket::newSocket(&evb);
+  socket->connect(&ccb, server.getAddress(), 30);
+  acceptedSocket = server.acceptAsync(&evb);
+  ReadCallback rcb2;
+  acceptedSocket->setReadCB(&rcb2);
+  socket->writeFile(&wcb4, file.fd(), 0, contents.size() + 1);
+  evb.loop();
+  EXPECT_EQ(wcb4.state, STATE_FAILED);
+
+  acceptedSocket->close();
+  socket->close();
+}
+
 TEST(AsyncSocketTest, WriteIOBufCorked) {
   TestServer server;
 
@@ -1855,6 +1916,143 @@ TEST(AsyncSocketTest, RemoveAcceptCallback) {
   ASSERT_EQ(cb7.getEvents()->at(2).type, TestAcceptCallback::TYPE_STOP);
 }
 
+namespace {
+class CountingAcceptCallback : public TestAcceptCallback {
+ public:
+  uint64_t getActiveConnectionCount() const noexcept override {
+    return active;
+  }
+
+  std::atomic<uint64_t> active{0};
+};
+} // namespace
+
+/**
+ * Test the LEAST_CONNECTIONS dispatch policy
+ */
+TEST(AsyncSocketTest, DispatchLeastConnections) {
+  EventBase eventBase;
+  std::shared_ptr<AsyncServerSocket> serverSocket(
+      AsyncServerSocket::newSocket(&eventBase));
+  serverSocket->bind(0);
+  serverSocket->listen(16);
+  folly::SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+  serverSocket->setDispatchPolicy(
+      AsyncServerSocket::DispatchPolicy::LEAST_CONNECTIONS);
+
+  CountingAcceptCallback cb1;
+  CountingAcceptCallback cb2;
+  cb1.active = 2;
+  int numAccepted = 0;
+  auto onAccept = [&](CountingAcceptCallback& cb) {
+    ++cb.active;
+    if (++numAccepted == 4) {
+      serverSocket->removeAcceptCallback(&cb1, nullptr);
+      serverSocket->removeAcceptCallback(&cb2, nullptr);
+    }
+  };
+  cb1.setConnectionAcceptedFn(
+      [&](NetworkSocket /* fd */, const folly::SocketAddress& /* addr */) {
+        onAccept(cb1);
+      });
+  cb2.setConnectionAcceptedFn(
+      [&](NetworkSocket /* fd */, const folly::SocketAddress& /* addr */) {
+        onAccept(cb2);
+      });
+  serverSocket->addAcceptCallback(&cb1, nullptr);
+  serverSocket->addAcceptCallback(&cb2, nullptr);
+  serverSocket->startAccepting();
+
+  std::vector<std::shared_ptr<AsyncSocket>> sockets;
+  for (int i = 0; i < 4; ++i) {
+    sockets.push_back(AsyncSocket::newSocket(&eventBase, serverAddress));
+  }
+  eventBase.loop();
+
+  // cb2 catches up with cb1 first, then they alternate
+  EXPECT_EQ(3u, cb1.active);
+  EXPECT_EQ(3u, cb2.active);
+  // start, accept(s), stop
+  ASSERT_EQ(cb1.getEvents()->size(), 3);
+  ASSERT_EQ(cb2.getEvents()->size(), 5);
+}
+
+/**
+ * Test that accepting pauses while the acceptor's queue is over the overload
+ * limit, and resumes once it drains.
+ */
+TEST(AsyncSocketTest, OverloadLimits) {
+  EventBase eventBase;
+  EventBase acceptorEvb;
+  std::shared_ptr<AsyncServerSocket> serverSocket(
+      AsyncServerSocket::newSocket(&eventBase));
+  serverSocket->bind(0);
+  serverSocket->listen(16);
+  folly::SocketAddress serverAddress;
+  serverSocket->getAddress(&serverAddress);
+  serverSocket->setOverloadLimits(
+      std::chrono::microseconds(0), 2, std::chrono::milliseconds(5));
+
+  // acceptorEvb does not loop until later, so connections pile up.
+  TestAcceptCallback cb;
+  serverSocket->addAcceptCallback(&cb, &acceptorEvb);
+  serverSocket->startAccepting();
+
+  std::vector<std::shared_ptr<AsyncSocket>> sockets;
+  for (int i = 0; i < 5; ++i) {
+    sockets.push_back(AsyncSocket::newSocket(&eventBase, serverAddress));
+  }
+  while (!serverSocket->isOverloaded()) {
+    eventBase.loopOnce();
+  }
+  // the connection that found the queue over the limit was still queued
+  EXPECT_EQ(4, serverSocket->getNumPendingMessagesInQueue());
+
+  // stays paused while the queue is full
+  eventBase.loopOnce();
+  EXPECT_TRUE(serverSocket->isOverloaded());
+  EXPECT_EQ(4, serverSocket->getNumPendingMessagesInQueue());
+
+  auto numAccepted = [&] {
+    return std::count_if(
+        cb.getEvents()->begin(), cb.getEvents()->end(), [](const auto& e) {
+          return e.type == TestAcceptCallback::TYPE_ACCEPT;
+        });
+  };
+  while (numAccepted() < 5) {
+    acceptorEvb.loopOnce(EVLOOP_NONBLOCK);
+    eventBase.loopOnce(EVLOOP_NONBLOCK);
+  }
+  EXPECT_FALSE(serverSocket->isOverloaded());
+
+  serverSocket->removeAcceptCallback(&cb, &acceptorEvb);
+  acceptorEvb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(cb.getEvents()->back().type, TestAcceptCallback::TYPE_STOP);
+}
+
+/**
+ * Test attaching the CPU routing program to a reuse port group
+ */
+TEST(AsyncSocketTest, ReusePortCpuRouting) {
+  EventBase eventBase;
+  std::shared_ptr<AsyncServerSocket> plainSocket(
+      AsyncServerSocket::newSocket(&eventBase));
+  plainSocket->bind(0);
+  EXPECT_THROW(plainSocket->setReusePortCpuRouting(1), std::logic_error);
+
+  std::shared_ptr<AsyncServerSocket> serverSocket(
+      AsyncServerSocket::newSocket(&eventBase));
+  serverSocket->setReusePortEnabled(true);
+  serverSocket->bind(0);
+  EXPECT_THROW(
+      serverSocket->setReusePortCpuRouting(0), std::invalid_argument);
+#ifdef __linux__
+  serverSocket->setReusePortCpuRouting(4);
+  serverSocket->listen(16);
+#endif
+}
+
 /**
  * Test AsyncServerSocket::removeAcceptCallback()
  */
@@ -3386,6 +3584,234 @@ TEST(AsyncSocket, PreReceivedDataTakeover) {
   evb.loop();
 }
 
+namespace {
+class MovableReadCallback : public AsyncTransportWrapper::ReadCallback {
+ public:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    auto res = queue.preallocate(4000, 65536);
+    *bufReturn = res.first;
+    *lenReturn = res.second;
+  }
+
+  void readDataAvailable(size_t len) noexcept override {
+    queue.postallocate(len);
+  }
+
+  bool isBufferMovable() noexcept override {
+    return true;
+  }
+
+  void readBufferAvailable(std::unique_ptr<IOBuf> buf) noexcept override {
+    queue.append(std::move(buf));
+  }
+
+  void readEOF() noexcept override {
+    eof = true;
+  }
+
+  void readErr(const AsyncSocketException&) noexcept override {
+    error = true;
+  }
+
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  bool eof{false};
+  bool error{false};
+};
+} // namespace
+
+TEST(AsyncSocket, ZeroCopyReceive) {
+  TestServer server;
+
+  EventBase evb;
+  std::shared_ptr<AsyncSocket> socket = AsyncSocket::newSocket(&evb);
+  socket->connect(nullptr, server.getAddress(), 30);
+  evb.loop();
+
+  auto acceptedSocket = server.acceptAsync(&evb);
+  if (!acceptedSocket->setZeroCopyReceive(true)) {
+    LOG(INFO) << "zero-copy receive not supported, skipping";
+    return;
+  }
+  EXPECT_TRUE(acceptedSocket->getZeroCopyReceive());
+
+  // whether the pages get mapped depends on the kernel and the device,
+  // either way the data has to arrive intact
+  std::string data(1024 * 1024, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+  socket->writeChain(nullptr, IOBuf::copyBuffer(data));
+  socket->shutdownWrite();
+
+  MovableReadCallback readCallback;
+  acceptedSocket->setReadCB(&readCallback);
+  evb.loop();
+
+  EXPECT_TRUE(readCallback.eof);
+  EXPECT_FALSE(readCallback.error);
+  auto received = readCallback.queue.move();
+  ASSERT_NE(received, nullptr);
+  EXPECT_EQ(data, received->moveToFbString().toStdString());
+  EXPECT_LE(acceptedSocket->getZeroCopyReceiveBytes(), data.size());
+
+  EXPECT_TRUE(acceptedSocket->setZeroCopyReceive(false));
+  EXPECT_FALSE(acceptedSocket->getZeroCopyReceive());
+}
+
+TEST(AsyncSocket, ZeroCopyAuto) {
+  TestServer server;
+
+  EventBase evb;
+  evb.setZeroCopyAutoThreshold(16 * 1024);
+  std::shared_ptr<AsyncSocket> socket = AsyncSocket::newSocket(&evb);
+  socket->connect(nullptr, server.getAddress(), 30);
+  evb.loop();
+
+  if (!socket->setZeroCopyAuto(true)) {
+    LOG(INFO) << "zerocopy not supported, skipping";
+    return;
+  }
+  EXPECT_TRUE(socket->getZeroCopyAuto());
+  EXPECT_EQ(16u * 1024, socket->getZeroCopyAutoThreshold());
+
+  socket->writeChain(nullptr, IOBuf::copyBuffer(std::string(100, 'a')));
+  socket->writeChain(nullptr, IOBuf::copyBuffer(std::string(64 * 1024, 'b')));
+
+  const auto& stats = socket->getZeroCopyAutoStats();
+  EXPECT_EQ(2u, stats.writes);
+  EXPECT_EQ(1u, stats.zeroCopyWrites);
+  EXPECT_EQ(64u * 1024, stats.zeroCopyBytes);
+
+  EXPECT_TRUE(socket->setZeroCopyAuto(false));
+  socket->writeChain(nullptr, IOBuf::copyBuffer(std::string(64 * 1024, 'c')));
+  EXPECT_EQ(1u, stats.zeroCopyWrites);
+
+  socket->closeNow();
+}
+
+TEST(AsyncSocket, DeferWrites) {
+  TestServer server;
+
+  EventBase evb;
+  std::shared_ptr<AsyncSocket> socket1 = AsyncSocket::newSocket(&evb);
+  std::shared_ptr<AsyncSocket> socket2 = AsyncSocket::newSocket(&evb);
+  socket1->connect(nullptr, server.getAddress(), 30);
+  socket2->connect(nullptr, server.getAddress(), 30);
+  evb.loop();
+  auto accepted1 = server.accept();
+  auto accepted2 = server.accept();
+
+  evb.setDeferWrites(true);
+  WriteCallback wcb1;
+  WriteCallback wcb2;
+  WriteCallback wcb3;
+  socket1->write(&wcb1, "hello", 5);
+  socket1->write(&wcb2, " world", 6);
+  socket2->writeChain(&wcb3, IOBuf::copyBuffer("deferred"));
+
+  // nothing goes out until the loop is about to poll
+  EXPECT_EQ(STATE_WAITING, wcb1.state);
+  EXPECT_EQ(STATE_WAITING, wcb2.state);
+  EXPECT_EQ(STATE_WAITING, wcb3.state);
+
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(STATE_SUCCEEDED, wcb1.state);
+  EXPECT_EQ(STATE_SUCCEEDED, wcb2.state);
+  EXPECT_EQ(STATE_SUCCEEDED, wcb3.state);
+
+  uint8_t buf[11];
+  accepted1->readAll(buf, sizeof(buf));
+  EXPECT_EQ("hello world", std::string((char*)buf, sizeof(buf)));
+  accepted2->readAll(buf, 8);
+  EXPECT_EQ("deferred", std::string((char*)buf, 8));
+
+  // a socket closed before the flush still delivers its writes
+  WriteCallback wcb4;
+  socket1->write(&wcb4, "bye", 3);
+  socket1->close();
+  evb.loop();
+  EXPECT_EQ(STATE_SUCCEEDED, wcb4.state);
+  accepted1->readAll(buf, 3);
+  EXPECT_EQ("bye", std::string((char*)buf, 3));
+
+  socket2->closeNow();
+}
+
+namespace {
+class IOStatsObserver : public AsyncSocket::IOStatsObserver {
+ public:
+  void ioStatsFinished(
+      const AsyncSocket& socket,
+      const AsyncSocket::IOStats& stats) noexcept override {
+    sockets.push_back(&socket);
+    last = stats;
+  }
+
+  std::vector<const AsyncSocket*> sockets;
+  AsyncSocket::IOStats last;
+};
+} // namespace
+
+TEST(AsyncSocket, IOStats) {
+  TestServer server;
+
+  EventBase evb;
+  auto evbObserver = std::make_shared<IOStatsObserver>();
+  AsyncSocket::setEventBaseIOStatsObserver(evb, evbObserver);
+  std::shared_ptr<AsyncSocket> socket = AsyncSocket::newSocket(&evb);
+  socket->connect(nullptr, server.getAddress(), 30);
+  evb.loop();
+  auto acceptedSocket = server.acceptAsync(&evb);
+
+  IOStatsObserver observer;
+  socket->addIOStatsObserver(&observer);
+  socket->write(nullptr, "hello", 5);
+  socket->write(nullptr, " world", 6);
+  socket->shutdownWrite();
+
+  MovableReadCallback readCallback;
+  acceptedSocket->setReadCB(&readCallback);
+  evb.loop();
+  EXPECT_TRUE(readCallback.eof);
+
+  const auto& written = socket->getIOStats();
+  EXPECT_EQ(11u, written.bytesWritten);
+  EXPECT_EQ(2u, written.writeCalls);
+  EXPECT_EQ(5.5, written.bytesPerWrite());
+  EXPECT_EQ(0u, written.readCalls);
+
+  // the data, possibly in several reads, then the EOF
+  const auto& read = acceptedSocket->getIOStats();
+  EXPECT_EQ(11u, read.bytesRead);
+  EXPECT_GE(read.readCalls, 2u);
+  EXPECT_EQ(0u, read.writeCalls);
+
+  auto totals = written;
+  totals += read;
+  auto evbStats = AsyncSocket::getEventBaseIOStats(evb);
+  EXPECT_EQ(totals.bytesRead, evbStats.bytesRead);
+  EXPECT_EQ(totals.bytesWritten, evbStats.bytesWritten);
+  EXPECT_EQ(totals.readCalls, evbStats.readCalls);
+  EXPECT_EQ(totals.writeCalls, evbStats.writeCalls);
+  EXPECT_EQ(totals.readsBlocked, evbStats.readsBlocked);
+
+  socket->closeNow();
+  ASSERT_EQ(1u, observer.sockets.size());
+  EXPECT_EQ(socket.get(), observer.sockets[0]);
+  EXPECT_EQ(11u, observer.last.bytesWritten);
+  ASSERT_EQ(1u, evbObserver->sockets.size());
+  EXPECT_EQ(socket.get(), evbObserver->sockets[0]);
+
+  // detaching the fd also finishes the stats, and only once
+  EXPECT_FALSE(acceptedSocket->removeIOStatsObserver(&observer));
+  auto fd = acceptedSocket->detachNetworkSocket();
+  acceptedSocket->closeNow();
+  netops::close(fd);
+  ASSERT_EQ(2u, evbObserver->sockets.size());
+  EXPECT_EQ(acceptedSocket.get(), evbObserver->sockets[1]);
+  EXPECT_EQ(11u, evbObserver->last.bytesRead);
+}
+
 #ifdef MSG_NOSIGNAL
 TEST(AsyncSocketTest, SendMessageFlags) {
   TestServer server;
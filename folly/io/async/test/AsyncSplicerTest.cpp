@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncSplicer.h>
+
+#include <csignal>
+#include <string>
+
+#include <folly/io/async/AsyncPipe.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Sockets.h>
+#include <folly/portability/Unistd.h>
+
+using namespace folly;
+
+namespace {
+
+class SpliceCallback : public AsyncSplicer::Callback {
+ public:
+  void spliceDone(size_t n) noexcept override {
+    done = true;
+    bytes = n;
+  }
+  void spliceErr(size_t n, const AsyncSocketException& ex) noexcept override {
+    bytes = n;
+    error = ex.getErrno();
+  }
+
+  bool done{false};
+  size_t bytes{0};
+  int error{0};
+};
+
+class ReadCallback : public AsyncReader::ReadCallback {
+ public:
+  void getReadBuffer(void** buf, size_t* len) noexcept override {
+    *buf = buffer;
+    *len = sizeof(buffer);
+  }
+  void readDataAvailable(size_t len) noexcept override {
+    data.append(buffer, len);
+  }
+  void readEOF() noexcept override {
+    eof = true;
+  }
+  void readErr(const AsyncSocketException&) noexcept override {}
+
+  char buffer[4096];
+  std::string data;
+  bool eof{false};
+};
+
+NetworkSocket nonBlocking(int fd) {
+  EXPECT_EQ(0, fcntl(fd, F_SETFL, O_NONBLOCK));
+  return NetworkSocket::fromFd(fd);
+}
+
+std::string makeData(size_t size) {
+  std::string data(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = char('a' + i % 26);
+  }
+  return data;
+}
+
+class AsyncSplicerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!AsyncSplicer::isSupported()) {
+      GTEST_SKIP() << "splice() is not supported";
+    }
+    signal(SIGPIPE, SIG_IGN);
+  }
+
+  // Writes data to in, and reads what comes out of out
+  void run(
+      NetworkSocket in,
+      NetworkSocket inWrite,
+      NetworkSocket out,
+      NetworkSocket outRead,
+      const std::string& data) {
+    auto writer = AsyncPipeWriter::newWriter(&evb_, inWrite);
+    writer->write(IOBuf::copyBuffer(data));
+    writer->closeOnEmpty();
+    auto reader = AsyncPipeReader::newReader(&evb_, outRead);
+    reader->setReadCB(&readCallback_);
+
+    auto splicer = AsyncSplicer::newSplicer(&evb_, in, out);
+    splicer->start(&spliceCallback_);
+    while (!spliceCallback_.done && spliceCallback_.error == 0) {
+      evb_.loopOnce();
+    }
+    EXPECT_TRUE(spliceCallback_.done);
+    EXPECT_EQ(data.size(), spliceCallback_.bytes);
+    netops::close(out);
+    while (!readCallback_.eof) {
+      evb_.loopOnce();
+    }
+    EXPECT_EQ(data, readCallback_.data);
+    netops::close(in);
+  }
+
+  EventBase evb_;
+  SpliceCallback spliceCallback_;
+  ReadCallback readCallback_;
+};
+
+} // namespace
+
+TEST_F(AsyncSplicerTest, PipeToSocket) {
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  NetworkSocket sockets[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  run(nonBlocking(pipeFds[0]),
+      nonBlocking(pipeFds[1]),
+      nonBlocking(sockets[0].toFd()),
+      nonBlocking(sockets[1].toFd()),
+      makeData(4 << 20));
+}
+
+TEST_F(AsyncSplicerTest, SocketToPipe) {
+  NetworkSocket sockets[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  run(nonBlocking(sockets[0].toFd()),
+      nonBlocking(sockets[1].toFd()),
+      nonBlocking(pipeFds[1]),
+      nonBlocking(pipeFds[0]),
+      makeData(4 << 20));
+}
+
+TEST_F(AsyncSplicerTest, SocketToSocket) {
+  NetworkSocket in[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+  NetworkSocket out[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+  run(nonBlocking(in[0].toFd()),
+      nonBlocking(in[1].toFd()),
+      nonBlocking(out[0].toFd()),
+      nonBlocking(out[1].toFd()),
+      makeData(4 << 20));
+}
+
+TEST_F(AsyncSplicerTest, MaxBytes) {
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  NetworkSocket sockets[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  auto in = nonBlocking(pipeFds[0]);
+  auto out = nonBlocking(sockets[0].toFd());
+  ASSERT_EQ(3000, write(pipeFds[1], makeData(3000).data(), 3000));
+
+  auto splicer = AsyncSplicer::newSplicer(&evb_, in, out);
+  splicer->start(&spliceCallback_, 1000);
+  EXPECT_TRUE(spliceCallback_.done);
+  EXPECT_EQ(1000, spliceCallback_.bytes);
+  EXPECT_FALSE(splicer->running());
+
+  // The rest comes on the next start(), up to EOF
+  spliceCallback_.done = false;
+  splicer->start(&spliceCallback_);
+  EXPECT_EQ(2000, splicer->bytesSpliced());
+  EXPECT_FALSE(spliceCallback_.done);
+  close(pipeFds[1]);
+  evb_.loopOnce();
+  EXPECT_TRUE(spliceCallback_.done);
+  EXPECT_EQ(2000, spliceCallback_.bytes);
+
+  char buf[4000];
+  EXPECT_EQ(3000, read(sockets[1].toFd(), buf, sizeof(buf)));
+  EXPECT_EQ(makeData(3000), std::string(buf, 3000));
+  close(pipeFds[0]);
+  netops::close(sockets[0]);
+  netops::close(sockets[1]);
+}
+
+TEST_F(AsyncSplicerTest, RestartWithLessThanBuffered) {
+  NetworkSocket in[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, in));
+  NetworkSocket out[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, out));
+  for (auto fd : {in[0], in[1], out[0], out[1]}) {
+    nonBlocking(fd.toFd());
+  }
+  // Fill the destination, so that what the splicer takes from the source
+  // stays in its pipe.
+  auto chunk = makeData(4096);
+  size_t filled = 0;
+  ssize_t rc;
+  while ((rc = write(out[0].toFd(), chunk.data(), chunk.size())) > 0) {
+    filled += size_t(rc);
+  }
+  size_t sent = 0;
+  while (sent < (64 << 10) &&
+         (rc = write(in[1].toFd(), chunk.data(), chunk.size())) > 0) {
+    sent += size_t(rc);
+  }
+
+  auto splicer = AsyncSplicer::newSplicer(&evb_, in[0], out[0]);
+  splicer->start(&spliceCallback_);
+  EXPECT_EQ(0, splicer->bytesSpliced());
+  splicer->stop();
+
+  size_t received = 0;
+  auto drain = [&] {
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(out[1].toFd(), buf, sizeof(buf))) > 0) {
+      received += size_t(n);
+    }
+  };
+  splicer->start(&spliceCallback_, 10);
+  while (!spliceCallback_.done && spliceCallback_.error == 0) {
+    drain();
+    evb_.loopOnce(EVLOOP_NONBLOCK);
+  }
+  EXPECT_EQ(10, spliceCallback_.bytes);
+
+  // The rest, including what was left in the pipe, comes on the next start()
+  spliceCallback_.done = false;
+  netops::close(in[1]);
+  splicer->start(&spliceCallback_);
+  while (!spliceCallback_.done && spliceCallback_.error == 0) {
+    drain();
+    evb_.loopOnce(EVLOOP_NONBLOCK);
+  }
+  EXPECT_EQ(sent - 10, spliceCallback_.bytes);
+  drain();
+  EXPECT_EQ(filled + sent, received);
+  netops::close(in[0]);
+  netops::close(out[0]);
+  netops::close(out[1]);
+}
+
+TEST_F(AsyncSplicerTest, Error) {
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  NetworkSocket sockets[2];
+  ASSERT_EQ(0, netops::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+  ASSERT_EQ(100, write(pipeFds[1], makeData(100).data(), 100));
+  netops::close(sockets[1]);
+
+  auto splicer = AsyncSplicer::newSplicer(
+      &evb_, nonBlocking(pipeFds[0]), nonBlocking(sockets[0].toFd()));
+  splicer->start(&spliceCallback_);
+  EXPECT_FALSE(spliceCallback_.done);
+  EXPECT_EQ(EPIPE, spliceCallback_.error);
+  close(pipeFds[0]);
+  close(pipeFds[1]);
+  netops::close(sockets[0]);
+}
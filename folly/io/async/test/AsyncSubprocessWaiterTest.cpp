@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AsyncSubprocessWaiter.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+
+using namespace folly;
+
+TEST(AsyncSubprocessWaiter, Exit) {
+  SKIP_IF(!AsyncSubprocessWaiter::isSupported()) << "No pidfd support";
+  EventBase evb;
+  std::vector<Subprocess> procs;
+  std::vector<int> statuses;
+  std::vector<std::unique_ptr<AsyncSubprocessWaiter>> waiters;
+  for (int i = 0; i < 10; ++i) {
+    procs.emplace_back(std::vector<std::string>{
+        "/bin/sh", "-c", "exit " + std::to_string(i)});
+  }
+  for (auto& proc : procs) {
+    waiters.push_back(std::make_unique<AsyncSubprocessWaiter>(
+        &evb, proc, [&](ProcessReturnCode rc) {
+          statuses.push_back(rc.exitStatus());
+        }));
+  }
+  evb.loop();
+
+  ASSERT_EQ(10, statuses.size());
+  std::sort(statuses.begin(), statuses.end());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, statuses[i]);
+    EXPECT_FALSE(procs[i].returnCode().running());
+  }
+}
+
+TEST(AsyncSubprocessWaiter, Kill) {
+  SKIP_IF(!AsyncSubprocessWaiter::isSupported()) << "No pidfd support";
+  EventBase evb;
+  Subprocess proc(std::vector<std::string>{"/bin/sleep", "10"});
+  std::unique_ptr<AsyncSubprocessWaiter> waiter;
+  bool killed = false;
+  // The callback may destroy the waiter
+  waiter = std::make_unique<AsyncSubprocessWaiter>(
+      &evb, proc, [&](ProcessReturnCode rc) {
+        killed = rc.killed() && rc.killSignal() == SIGKILL;
+        waiter.reset();
+      });
+  evb.runInLoop([&] { proc.kill(); });
+  evb.loop();
+  EXPECT_TRUE(killed);
+  EXPECT_FALSE(waiter);
+}
+
+TEST(AsyncSubprocessWaiter, Cancel) {
+  SKIP_IF(!AsyncSubprocessWaiter::isSupported()) << "No pidfd support";
+  EventBase evb;
+  Subprocess proc(std::vector<std::string>{"/bin/true"});
+  {
+    AsyncSubprocessWaiter waiter(
+        &evb, proc, [](ProcessReturnCode) { ADD_FAILURE(); });
+  }
+  evb.loop();
+  EXPECT_EQ(0, proc.wait().exitStatus());
+  EXPECT_THROW(
+      AsyncSubprocessWaiter(&evb, proc, [](ProcessReturnCode) {}),
+      std::logic_error);
+}
@@ -727,3 +727,148 @@ TEST_F(AsyncUDPSocketTest, TestDetachAttach) {
   t.join();
   EXPECT_EQ(packetsRecvd, 2);
 }
+
+TEST_F(AsyncUDPSocketTest, TestReadBatch) {
+  static constexpr size_t kNumPackets = 8;
+
+  class BatchReadCallback : public MockUDPReadCallback {
+   public:
+    void onDataAvailableBatch(ReadPacket* packets, size_t num) noexcept
+        override {
+      ++numBatches;
+      for (size_t i = 0; i < num; ++i) {
+        EXPECT_FALSE(packets[i].truncated);
+        bufs.emplace_back(std::move(packets[i].buf));
+      }
+    }
+
+    size_t numBatches{0};
+    std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  };
+
+  auto writeSocket = std::make_shared<folly::AsyncUDPSocket>(&evb_);
+  writeSocket->bind(folly::SocketAddress("127.0.0.1", 0));
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    writeSocket->write(
+        socket_->address(),
+        folly::IOBuf::copyBuffer(folly::to<std::string>(i)));
+  }
+
+  BatchReadCallback batchCb;
+  socket_->setReadBatch(kNumPackets * 2);
+  EXPECT_EQ(kNumPackets * 2, socket_->getReadBatchSize());
+  socket_->resumeRead(&batchCb);
+  while (batchCb.bufs.size() < kNumPackets) {
+    evb_.loopOnce();
+  }
+
+  EXPECT_LE(batchCb.numBatches, kNumPackets);
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(
+        folly::to<std::string>(i),
+        batchCb.bufs[i]->moveToFbString().toStdString());
+  }
+  socket_->pauseRead();
+}
+
+TEST_F(AsyncUDPSocketTest, TestReadBatchDefaultCallback) {
+  auto writeSocket = std::make_shared<folly::AsyncUDPSocket>(&evb_);
+  writeSocket->bind(folly::SocketAddress("127.0.0.1", 0));
+  writeSocket->write(socket_->address(), folly::IOBuf::copyBuffer("hello"));
+
+  // the batch goes through getReadBuffer() and onDataAvailable()
+  std::array<uint8_t, 1024> data;
+  bool received = false;
+  EXPECT_CALL(readCb, shouldOnlyNotify()).WillRepeatedly(Return(false));
+  EXPECT_CALL(readCb, getReadBuffer_(_, _))
+      .WillRepeatedly(Invoke([&](void** buf, size_t* len) {
+        *buf = data.data();
+        *len = data.size();
+      }));
+  EXPECT_CALL(readCb, onDataAvailable_(_, 5, false))
+      .WillOnce(Invoke([&](const folly::SocketAddress& client, size_t, bool) {
+        EXPECT_EQ(writeSocket->address(), client);
+        received = true;
+      }));
+  socket_->setReadBatch(4);
+  socket_->resumeRead(&readCb);
+  while (!received) {
+    evb_.loopOnce();
+  }
+  EXPECT_EQ(0, memcmp(data.data(), "hello", 5));
+  socket_->pauseRead();
+}
+
+TEST_F(AsyncUDPSocketTest, TestTXTime) {
+  static constexpr size_t kNumPackets = 4;
+
+  auto writeSocket = std::make_shared<folly::AsyncUDPSocket>(&evb_);
+  writeSocket->bind(folly::SocketAddress("127.0.0.1", 0));
+
+  // departure times need SO_TXTIME
+  AsyncUDPSocket::WriteOptions options(0, std::chrono::microseconds(100));
+  EXPECT_EQ(
+      -1,
+      writeSocket->writeWithOptions(
+          socket_->address(), folly::IOBuf::copyBuffer("hello"), options));
+  EXPECT_EQ(EINVAL, errno);
+
+  if (!writeSocket->setTXTime(AsyncUDPSocket::TXTime())) {
+    LOG(INFO) << "SO_TXTIME is not supported";
+    return;
+  }
+  EXPECT_TRUE(writeSocket->getTXTime().hasValue());
+
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  std::vector<AsyncUDPSocket::WriteOptions> optionsVec;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    bufs.emplace_back(folly::IOBuf::copyBuffer("hello"));
+    optionsVec.emplace_back(0, std::chrono::microseconds(100 * i));
+  }
+  EXPECT_EQ(
+      static_cast<int>(kNumPackets),
+      writeSocket->writemWithOptions(
+          socket_->address(), bufs.data(), bufs.size(), optionsVec.data()));
+
+  std::array<uint8_t, 1024> data;
+  size_t packetsRecvd = 0;
+  EXPECT_CALL(readCb, getReadBuffer_(_, _))
+      .WillRepeatedly(Invoke([&](void** buf, size_t* len) {
+        *buf = data.data();
+        *len = data.size();
+      }));
+  EXPECT_CALL(readCb, onDataAvailable_(_, 5, false))
+      .WillRepeatedly(Invoke(
+          [&](const folly::SocketAddress&, size_t, bool) { packetsRecvd++; }));
+  socket_->resumeRead(&readCb);
+  while (packetsRecvd != kNumPackets) {
+    evb_.loopOnce();
+  }
+  socket_->pauseRead();
+}
+
+TEST_F(AsyncUDPSocketTest, TestParseTimestamps) {
+#ifdef FOLLY_HAVE_MSG_ERRQUEUE
+  struct timespec ts[3] = {{1, 2}, {0, 0}, {3, 4}};
+  char control[CMSG_SPACE(sizeof(ts))] = {};
+  struct msghdr msg = {};
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_TIMESTAMPING;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(ts));
+  memcpy(CMSG_DATA(cmsg), ts, sizeof(ts));
+
+  auto timestamps = AsyncUDPSocket::parseTimestamps(*cmsg);
+  ASSERT_TRUE(timestamps.hasValue());
+  EXPECT_EQ(std::chrono::nanoseconds(1000000002), timestamps->software);
+  EXPECT_EQ(std::chrono::nanoseconds(3000000004), timestamps->hardware);
+
+  cmsg->cmsg_type = SCM_TXTIME;
+  EXPECT_FALSE(AsyncUDPSocket::parseTimestamps(*cmsg).hasValue());
+
+  EXPECT_TRUE(socket_->setTimestamping(
+      SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE));
+#endif
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/AtomicNotificationQueue.h>
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+namespace {
+struct IntConsumer {
+  explicit IntConsumer(std::vector<int>* v) : values(v) {}
+
+  void operator()(int&& value) noexcept {
+    values->push_back(value);
+    if (onValue) {
+      onValue(value);
+    }
+  }
+
+  std::vector<int>* values;
+  std::function<void(int)> onValue;
+};
+
+using IntQueue = AtomicNotificationQueue<int, IntConsumer>;
+} // namespace
+
+TEST(AtomicNotificationQueueTest, Basic) {
+  EventBase evb;
+  std::vector<int> values;
+  IntQueue queue{IntConsumer(&values)};
+  queue.startConsuming(&evb);
+
+  for (int i = 0; i < 5; ++i) {
+    queue.putMessage(i);
+  }
+  EXPECT_EQ(5u, queue.size());
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), values);
+  EXPECT_EQ(0u, queue.size());
+
+  // armed again after the queue ran dry
+  queue.putMessage(5);
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(6u, values.size());
+
+  queue.stopConsuming();
+}
+
+TEST(AtomicNotificationQueueTest, PutMessages) {
+  EventBase evb;
+  std::vector<int> values;
+  IntQueue queue{IntConsumer(&values)};
+  queue.startConsuming(&evb);
+
+  queue.putMessage(0);
+  std::vector<int> batch{1, 2, 3};
+  queue.putMessages(batch.begin(), batch.end());
+  queue.putMessages(batch.end(), batch.end());
+  queue.putMessage(4);
+  EXPECT_EQ(5u, queue.size());
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), values);
+
+  queue.stopConsuming();
+}
+
+TEST(AtomicNotificationQueueTest, MaxReadAtOnce) {
+  EventBase evb;
+  std::vector<int> values;
+  IntQueue queue{IntConsumer(&values)};
+  queue.setMaxReadAtOnce(10);
+  queue.startConsuming(&evb);
+
+  for (int i = 0; i < 25; ++i) {
+    queue.putMessage(i);
+  }
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(10u, values.size());
+  EXPECT_EQ(15u, queue.size());
+
+  // the consumer woke itself up for the rest
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(25u, values.size());
+  for (int i = 0; i < 25; ++i) {
+    EXPECT_EQ(i, values[size_t(i)]);
+  }
+
+  queue.stopConsuming();
+}
+
+TEST(AtomicNotificationQueueTest, RequestContext) {
+  EventBase evb;
+  std::vector<int> values;
+  IntConsumer consumer(&values);
+  std::shared_ptr<RequestContext> seen;
+  consumer.onValue = [&](int) { seen = RequestContext::saveContext(); };
+  IntQueue queue{std::move(consumer)};
+  queue.startConsuming(&evb);
+
+  std::shared_ptr<RequestContext> ctx;
+  {
+    RequestContextScopeGuard guard;
+    ctx = RequestContext::saveContext();
+    queue.putMessage(1);
+  }
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(1u, values.size());
+  EXPECT_EQ(ctx, seen);
+
+  queue.stopConsuming();
+}
+
+TEST(AtomicNotificationQueueTest, MultipleProducers) {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 10000;
+
+  EventBase evb;
+  std::vector<int> values;
+  IntConsumer consumer(&values);
+  consumer.onValue = [&](int) {
+    if (values.size() == size_t(kProducers * kPerProducer)) {
+      evb.terminateLoopSoon();
+    }
+  };
+  IntQueue queue{std::move(consumer)};
+  queue.setMaxReadAtOnce(0);
+  queue.startConsuming(&evb);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        queue.putMessage(p * kPerProducer + i);
+      }
+    });
+  }
+  evb.loopForever();
+  for (auto& t : producers) {
+    t.join();
+  }
+
+  // each producer's tasks run in the order they were added
+  std::vector<int> last(kProducers, -1);
+  for (auto v : values) {
+    auto p = v / kPerProducer;
+    EXPECT_LT(last[p], v);
+    last[p] = v;
+  }
+  EXPECT_EQ(0u, queue.size());
+
+  queue.stopConsuming();
+}
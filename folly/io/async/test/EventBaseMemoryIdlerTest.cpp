@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/async/EventBaseMemoryIdler.h>
+
+#include <chrono>
+
+#include <folly/ScopeGuard.h>
+#include <folly/detail/MemoryIdler.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using folly::detail::MemoryIdler;
+using std::chrono::milliseconds;
+
+namespace {
+
+// Makes the idle timeout short enough for the tests
+auto setIdleTimeout(milliseconds timeout) {
+  auto old = MemoryIdler::defaultIdleTimeout.load();
+  MemoryIdler::defaultIdleTimeout.store(timeout);
+  return makeGuard([old] { MemoryIdler::defaultIdleTimeout.store(old); });
+}
+
+// Runs the loop of evb for the given time, with work every period if it is
+// set
+void loopFor(EventBase& evb, milliseconds time, milliseconds period = {}) {
+  auto deadline = std::chrono::steady_clock::now() + time;
+  Function<void()> work = [&] {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      evb.terminateLoopSoon();
+      return;
+    }
+    auto delay = period.count()
+        ? period
+        : std::chrono::duration_cast<milliseconds>(deadline - now) +
+            milliseconds(1);
+    evb.runAfterDelay([&] { work(); }, delay.count());
+  };
+  evb.runInEventBaseThread([&] { work(); });
+  evb.loopForever();
+}
+
+} // namespace
+
+TEST(EventBaseMemoryIdler, ReleasesWhenIdle) {
+  auto guard = setIdleTimeout(milliseconds(40));
+  EventBase evb;
+  EventBaseMemoryIdler idler(evb);
+
+  loopFor(evb, milliseconds(500));
+  EXPECT_EQ(1, idler.numReleases());
+  EXPECT_EQ(1, idler.timeoutScale());
+}
+
+TEST(EventBaseMemoryIdler, ScalesWithLoad) {
+  const milliseconds timeout(40);
+  detail::IdleTimeoutScaler scaler;
+  std::chrono::steady_clock::time_point now{std::chrono::hours(1)};
+  EXPECT_EQ(timeout, scaler.workArrived(now, timeout));
+
+  // Work arrives shortly after every release, so the memory would be
+  // faulted back in right away
+  for (uint32_t scale = 2; scale <= 4; scale *= 2) {
+    scaler.released(now);
+    now += milliseconds(10);
+    EXPECT_EQ(scale * timeout, scaler.workArrived(now, timeout));
+    EXPECT_EQ(scale, scaler.scale());
+  }
+
+  // Up to a limit
+  for (int i = 0; i < 10; ++i) {
+    scaler.released(now);
+    scaler.workArrived(now, timeout);
+  }
+  EXPECT_EQ(EventBaseMemoryIdler::kMaxTimeoutScale, scaler.scale());
+
+  // Idle periods longer than the scaled timeout bring it back down
+  scaler.released(now);
+  now += EventBaseMemoryIdler::kMaxTimeoutScale * timeout;
+  EXPECT_EQ(8 * timeout, scaler.workArrived(now, timeout));
+  scaler.released(now);
+  now += 7 * timeout;
+  EXPECT_EQ(8 * timeout, scaler.workArrived(now, timeout));
+
+  // Without a release in between, the scale stays
+  now += 100 * timeout;
+  EXPECT_EQ(8 * timeout, scaler.workArrived(now, timeout));
+}
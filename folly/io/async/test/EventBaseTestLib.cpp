@@ -20,10 +20,12 @@
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
+#include <folly/io/async/VirtualEventBase.h>
 #include <folly/io/async/test/SocketPair.h>
 #include <folly/io/async/test/Util.h>
 #include <folly/portability/Stdlib.h>
 #include <folly/portability/Unistd.h>
+#include <folly/stats/Histogram.h>
 
 #include <folly/futures/Promise.h>
 
@@ -1321,6 +1323,24 @@ TEST_F(EventBaseTest, RunInEventBaseThreadAndWait) {
   EXPECT_EQ(c, sum);
 }
 
+TEST_F(EventBaseTest, AddBatch) {
+  BackendEventBase eb;
+  vector<int> order;
+  auto makeFuncs = [&](int first) {
+    vector<Func> funcs;
+    for (int i = first; i < first + 3; ++i) {
+      funcs.emplace_back([&order, i] { order.push_back(i); });
+    }
+    return funcs;
+  };
+  auto funcs = makeFuncs(0);
+  auto inLoopFuncs = makeFuncs(3);
+  thread([&] { eb.addBatch(range(funcs)); }).join();
+  eb.runInEventBaseThread([&] { eb.addBatch(range(inLoopFuncs)); });
+  eb.loop();
+  EXPECT_EQ(vector<int>({0, 1, 2, 3, 4, 5}), order);
+}
+
 TEST_F(EventBaseTest, RunImmediatelyOrRunInEventBaseThreadAndWaitCross) {
   BackendEventBase eb;
   thread th(&EventBase::loopForever, &eb);
@@ -1856,6 +1876,62 @@ TEST_F(EventBaseTest, RunBeforeLoopWait) {
   ASSERT_EQ(cb.getCount(), 0);
 }
 
+TEST_F(EventBaseTest, RunBeforePoll) {
+  BackendEventBase base;
+  int ran = 0;
+  // pending callbacks keep loop() going although nothing is registered, and
+  // ones added by a callback wait for the next iteration
+  base.runBeforePoll(new EventBase::FunctionLoopCallback([&]() {
+    ++ran;
+    base.runBeforePoll(
+        new EventBase::FunctionLoopCallback([&]() { ran += 10; }));
+    ASSERT_EQ(1, ran);
+  }));
+  base.loop();
+  ASSERT_EQ(11, ran);
+}
+
+namespace {
+class TestLoopPhaseObserver : public EventBaseLoopPhaseObserver {
+ public:
+  void loopPhaseSample(const EventBaseLoopPhaseTimes& times) override {
+    for (size_t i = 0; i < EventBaseLoopPhaseTimes::NUM_PHASES; ++i) {
+      total.times[i] += times.times[i];
+    }
+    ++samples;
+  }
+
+  EventBaseLoopPhaseTimes total;
+  uint64_t samples{0};
+};
+} // namespace
+
+TEST_F(EventBaseTest, LoopPhaseTracking) {
+  BackendEventBase base;
+  auto observer = std::make_shared<TestLoopPhaseObserver>();
+  base.enableLoopPhaseTracking(observer);
+  ASSERT_TRUE(base.isLoopPhaseTrackingEnabled());
+
+  base.runInLoop([] { std::this_thread::sleep_for(5ms); });
+  base.runInEventBaseThread([] { std::this_thread::sleep_for(5ms); });
+  base.tryRunAfterDelay([] { std::this_thread::sleep_for(5ms); }, 1);
+  base.loop();
+
+  ASSERT_GT(observer->samples, 0);
+  ASSERT_GE(observer->total[EventBaseLoopPhaseTimes::LOOP_CALLBACKS], 5ms);
+  ASSERT_GE(observer->total[EventBaseLoopPhaseTimes::NOTIFICATION_QUEUE], 5ms);
+  ASSERT_GE(observer->total[EventBaseLoopPhaseTimes::TIMERS], 5ms);
+  for (size_t i = 0; i < EventBaseLoopPhaseTimes::NUM_PHASES; ++i) {
+    ASSERT_EQ(
+        observer->samples,
+        base.getLoopPhaseHistogram(EventBaseLoopPhaseTimes::Phase(i))
+            .computeTotalCount());
+  }
+
+  base.disableLoopPhaseTracking();
+  ASSERT_FALSE(base.isLoopPhaseTrackingEnabled());
+}
+
 namespace {
 class PipeHandler : public EventHandler {
  public:
@@ -2206,3 +2282,74 @@ TEST_F(EventBaseTest, RunOnDestructionAddCallbackWithinCallback) {
   }
   EXPECT_EQ(2, callbacksCalled);
 }
+
+TEST_F(EventBaseTest, VirtualEventBaseBatchedKeepAliveRelease) {
+  BackendEventBase evb;
+  std::thread evbThread([&] { evb.loopForever(); });
+  SCOPE_EXIT {
+    evb.terminateLoopSoon();
+    evbThread.join();
+  };
+
+  auto veb = std::make_unique<VirtualEventBase>(evb);
+  bool destroyed = false;
+  veb->runOnDestruction([&] { destroyed = true; });
+
+  static constexpr size_t kNumThreads = 8;
+  static constexpr size_t kNumTasks = 1000;
+  std::atomic<size_t> done{0};
+  std::vector<std::thread> ts;
+  for (size_t i = 0; i < kNumThreads; ++i) {
+    ts.emplace_back([vebPtr = veb.get(), &done] {
+      std::vector<Executor::KeepAlive<VirtualEventBase>> keepAlives;
+      for (size_t j = 0; j < kNumTasks; ++j) {
+        keepAlives.emplace_back(getKeepAliveToken(vebPtr));
+        vebPtr->runInEventBaseThread([&done] { ++done; });
+      }
+      // Released off the EventBase thread.
+      keepAlives.clear();
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+
+  VirtualEventBase::destroyAsync(std::move(veb)).get();
+  EXPECT_TRUE(destroyed);
+  EXPECT_EQ(kNumThreads * kNumTasks, done.load());
+}
+
+TEST_F(EventBaseTest, VirtualEventBaseDestroyAsync) {
+  BackendEventBase evb;
+  auto veb = std::make_unique<VirtualEventBase>(evb);
+  auto keepAlive = getKeepAliveToken(veb.get());
+  bool destroyed = false;
+  veb->runOnDestruction([&] { destroyed = true; });
+
+  // Does not block even though a keep-alive token is outstanding.
+  auto future = VirtualEventBase::destroyAsync(std::move(veb));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_FALSE(destroyed);
+  EXPECT_EQ(std::future_status::timeout, future.wait_for(0ms));
+
+  evb.runInEventBaseThread([keepAlive = std::move(keepAlive)] {});
+  evb.loop();
+  EXPECT_TRUE(destroyed);
+  EXPECT_EQ(std::future_status::ready, future.wait_for(0ms));
+  future.get();
+}
+
+TEST_F(EventBaseTest, VirtualEventBaseDestroyAsyncInEventBaseThread) {
+  BackendEventBase evb;
+  auto veb = std::make_unique<VirtualEventBase>(evb);
+  bool destroyed = false;
+  veb->runOnDestruction([&] { destroyed = true; });
+
+  std::future<void> future;
+  evb.runInEventBaseThread([&] {
+    future = VirtualEventBase::destroyAsync(std::move(veb));
+  });
+  evb.loop();
+  EXPECT_TRUE(destroyed);
+  future.get();
+}
@@ -517,3 +517,57 @@ TEST_F(HHWheelTimerTest, NegativeTimeout) {
   ASSERT_EQ(tt2.timestamps.size(), 1);
   T_CHECK_TIMEOUT(start, end, milliseconds(1));
 }
+
+/*
+ * Test pushing a timeout back with rescheduleTimeout(), both within the
+ * same wheel level and across a cascade.
+ */
+TEST_F(HHWheelTimerTest, RescheduleTimeout) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  TestTimeout t1;
+  TestTimeout t2;
+  TestTimeout t3;
+
+  t.scheduleTimeout(&t1, milliseconds(10));
+  t.scheduleTimeout(&t2, milliseconds(100));
+  // not scheduled yet, same as scheduleTimeout()
+  t.rescheduleTimeout(&t3, milliseconds(300));
+  ASSERT_EQ(t.count(), 3);
+
+  TimePoint start;
+  // t1 moves within level 0, t3 out of level 0; t2 moves earlier.
+  t.rescheduleTimeout(&t1, milliseconds(20));
+  t.rescheduleTimeout(&t1, milliseconds(30));
+  t.rescheduleTimeout(&t2, milliseconds(50));
+  t.rescheduleTimeout(&t3, milliseconds(400));
+  ASSERT_EQ(t.count(), 3);
+  eventBase.loop();
+
+  ASSERT_EQ(t.count(), 0);
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, t1.timestamps[0], milliseconds(30));
+  T_CHECK_TIMEOUT(start, t2.timestamps[0], milliseconds(50));
+  T_CHECK_TIMEOUT(start, t3.timestamps[0], milliseconds(400));
+}
+
+/*
+ * Test pushing a timeout back from a callback that runs in the same tick.
+ */
+TEST_F(HHWheelTimerTest, RescheduleTimeoutWithinCallback) {
+  StackWheelTimer t(&eventBase, milliseconds(1));
+  TestTimeout t1;
+  TestTimeout t2;
+
+  t.scheduleTimeout(&t1, milliseconds(5));
+  t.scheduleTimeout(&t2, milliseconds(5));
+  t1.fn = [&] { t.rescheduleTimeout(&t2, milliseconds(20)); };
+
+  TimePoint start;
+  eventBase.loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  T_CHECK_TIMEOUT(start, t2.timestamps[0], milliseconds(20));
+}
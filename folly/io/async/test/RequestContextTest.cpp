@@ -355,6 +355,25 @@ TEST_F(RequestContextTest, ShallowCopyClear) {
   EXPECT_EQ(1, getData().unset_);
 }
 
+TEST_F(RequestContextTest, ShallowCopyCopyOnWrite) {
+  RequestContextScopeGuard g0;
+  setData(123);
+  auto refCount = [&] { return getContext().getContextData("test")->refCount(); };
+  EXPECT_EQ(1, refCount());
+  {
+    ShallowCopyRequestContextScopeGuard g1;
+    // The copy shares its parent's data until either is modified.
+    EXPECT_EQ(1, refCount());
+    setData(456, "other");
+    EXPECT_EQ(2, refCount());
+    EXPECT_EQ(123, getData().data_);
+    EXPECT_EQ(456, getData("other").data_);
+  }
+  EXPECT_EQ(1, refCount());
+  EXPECT_FALSE(hasData("other"));
+  EXPECT_EQ(123, getData().data_);
+}
+
 TEST_F(RequestContextTest, RootIdOnCopy) {
   auto ctxBase = std::make_shared<RequestContext>();
   EXPECT_EQ(reinterpret_cast<intptr_t>(ctxBase.get()), ctxBase->getRootId());
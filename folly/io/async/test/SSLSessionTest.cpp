@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <folly/io/async/SSLSessionCache.h>
 #include <folly/ssl/SSLSession.h>
 #include <folly/io/async/test/AsyncSSLSocketTest.h>
 #include <folly/net/NetOps.h>
@@ -252,4 +253,80 @@ TEST_F(SSLSessionTest, ServerAuth_MismatchedServerName) {
   ASSERT_FALSE(client.handshakeSuccess_);
   ASSERT_TRUE(client.handshakeError_);
 }
+
+namespace {
+// Handshakes with serverCtx, resuming session if it is set. Returns the
+// client's session and whether it was resumed.
+std::pair<std::unique_ptr<SSLSession>, bool> handshake(
+    EventBase& eventBase,
+    const std::shared_ptr<SSLContext>& clientCtx,
+    const std::shared_ptr<SSLContext>& serverCtx,
+    SSLSession* session) {
+  NetworkSocket fds[2];
+  getfds(fds);
+  AsyncSSLSocket::UniquePtr clientSock(
+      new AsyncSSLSocket(clientCtx, &eventBase, fds[0], false));
+  auto clientPtr = clientSock.get();
+  if (session) {
+    clientSock->setSSLSession(session->getRawSSLSessionDangerous(), true);
+  }
+  AsyncSSLSocket::UniquePtr serverSock(
+      new AsyncSSLSocket(serverCtx, &eventBase, fds[1], true));
+  SSLHandshakeClient client(std::move(clientSock), false, false);
+  SSLHandshakeServer server(std::move(serverSock), false, false);
+
+  eventBase.loop();
+  EXPECT_TRUE(client.handshakeSuccess_);
+  return {std::make_unique<SSLSession>(clientPtr->getSSLSession()),
+          clientPtr->getSSLSessionReused()};
+}
+} // namespace
+
+TEST_F(SSLSessionTest, SharedSessionCache) {
+  auto cache = std::make_shared<SSLSessionCache>();
+  auto otherServerCtx = std::make_shared<SSLContext>();
+  getctx(clientCtx, otherServerCtx);
+  for (auto& ctx : {dfServerCtx, otherServerCtx}) {
+    ctx->setOptions(SSL_OP_NO_TICKET);
+    ctx->setSessionCache(cache);
+  }
+
+  auto first = handshake(eventBase, clientCtx, dfServerCtx, nullptr);
+  EXPECT_FALSE(first.second);
+  EXPECT_EQ(1u, cache->size());
+
+  // resumed through a context that never saw the session
+  auto second =
+      handshake(eventBase, clientCtx, otherServerCtx, first.first.get());
+  EXPECT_TRUE(second.second);
+
+  cache->remove(StringPiece(first.first->getSessionID()));
+  EXPECT_EQ(0u, cache->size());
+  auto third = handshake(eventBase, clientCtx, dfServerCtx, first.first.get());
+  EXPECT_FALSE(third.second);
+}
+
+TEST_F(SSLSessionTest, TicketKeyRotation) {
+  const std::string oldKey(SSLContext::kTicketKeyLength, 'a');
+  const std::string newKey(SSLContext::kTicketKeyLength, 'b');
+  dfServerCtx->setTicketKeys({oldKey});
+  auto first = handshake(eventBase, clientCtx, dfServerCtx, nullptr);
+  EXPECT_FALSE(first.second);
+
+  // still accepted after rotation, as long as the old key is kept
+  auto rotatedCtx = std::make_shared<SSLContext>();
+  getctx(clientCtx, rotatedCtx);
+  rotatedCtx->setTicketKeys({newKey, oldKey});
+  auto second = handshake(eventBase, clientCtx, rotatedCtx, first.first.get());
+  EXPECT_TRUE(second.second);
+
+  rotatedCtx->setTicketKeys({newKey});
+  auto third = handshake(eventBase, clientCtx, rotatedCtx, first.first.get());
+  EXPECT_FALSE(third.second);
+  // the renewed ticket from the second handshake uses the new key
+  auto fourth = handshake(eventBase, clientCtx, rotatedCtx, second.first.get());
+  EXPECT_TRUE(fourth.second);
+
+  EXPECT_THROW(dfServerCtx->setTicketKeys({"short"}), std::invalid_argument);
+}
 } // namespace folly
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/Chunker.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/io/IOBufQueue.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+namespace {
+
+std::string randomString(size_t size, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::string str(size, '\0');
+  for (auto& c : str) {
+    c = char(rng());
+  }
+  return str;
+}
+
+std::vector<uint64_t> chunk(
+    StringPiece data,
+    const ContentDefinedChunker::Options& options) {
+  std::vector<uint64_t> boundaries;
+  ContentDefinedChunker chunker(options);
+  chunker.update(ByteRange(data), boundaries);
+  chunker.finish(boundaries);
+  return boundaries;
+}
+
+ContentDefinedChunker::Options smallOptions() {
+  ContentDefinedChunker::Options options;
+  options.windowSize = 32;
+  options.minChunkSize = 256;
+  options.avgChunkSize = 1024;
+  options.maxChunkSize = 4096;
+  return options;
+}
+
+} // namespace
+
+TEST(ContentDefinedChunker, InvalidOptions) {
+  auto options = smallOptions();
+  options.avgChunkSize = 1000;
+  EXPECT_THROW(ContentDefinedChunker{options}, std::invalid_argument);
+  options = smallOptions();
+  options.minChunkSize = options.windowSize - 1;
+  EXPECT_THROW(ContentDefinedChunker{options}, std::invalid_argument);
+  options = smallOptions();
+  options.maxChunkSize = options.minChunkSize - 1;
+  EXPECT_THROW(ContentDefinedChunker{options}, std::invalid_argument);
+}
+
+TEST(ContentDefinedChunker, Sizes) {
+  auto const options = smallOptions();
+  auto const data = randomString(1 << 20, 1);
+  auto const boundaries = chunk(data, options);
+
+  ASSERT_FALSE(boundaries.empty());
+  EXPECT_EQ(data.size(), boundaries.back());
+  uint64_t begin = 0;
+  for (size_t i = 0; i < boundaries.size(); i++) {
+    auto const size = boundaries[i] - begin;
+    if (i + 1 < boundaries.size()) {
+      EXPECT_GE(size, options.minChunkSize);
+    }
+    EXPECT_LE(size, options.maxChunkSize);
+    begin = boundaries[i];
+  }
+  auto const average = double(data.size()) / boundaries.size();
+  auto const expected = double(options.minChunkSize + options.avgChunkSize);
+  EXPECT_GT(average, expected * 0.75);
+  EXPECT_LT(average, expected * 1.25);
+
+  EXPECT_TRUE(chunk("", options).empty());
+}
+
+TEST(ContentDefinedChunker, Streaming) {
+  // Boundaries do not depend on how the stream is fed.
+  auto const options = smallOptions();
+  auto const data = randomString(100000, 2);
+  auto const expected = chunk(data, options);
+
+  std::vector<uint64_t> boundaries;
+  ContentDefinedChunker chunker(options);
+  size_t pos = 0;
+  for (size_t step = 1; pos < data.size(); step = step * 3 % 1021 + 1) {
+    auto const n = std::min(step, data.size() - pos);
+    chunker.update(ByteRange(StringPiece(data).subpiece(pos, n)), boundaries);
+    pos += n;
+  }
+  EXPECT_EQ(data.size(), chunker.offset());
+  chunker.finish(boundaries);
+  EXPECT_EQ(expected, boundaries);
+  EXPECT_EQ(0, chunker.offset());
+
+  // Same for a fragmented IOBuf chain.
+  IOBufQueue queue;
+  for (pos = 0; pos < data.size(); pos += 777) {
+    queue.append(IOBuf::copyBuffer(
+        data.data() + pos, std::min<size_t>(777, data.size() - pos)));
+  }
+  auto chain = queue.move();
+  boundaries.clear();
+  chunker.update(*chain, boundaries);
+  chunker.finish(boundaries);
+  EXPECT_EQ(expected, boundaries);
+}
+
+TEST(ContentDefinedChunker, ResynchronizesAfterEdit) {
+  auto const options = smallOptions();
+  auto const data = randomString(200000, 3);
+  auto edited = data;
+  edited.insert(1000, "inserted bytes");
+  auto const a = chunk(data, options);
+  auto const b = chunk(edited, options);
+
+  // Every boundary well past the edit shows up, shifted by the insertion.
+  std::vector<uint64_t> shifted;
+  for (auto boundary : b) {
+    if (boundary > 1000 + 2 * options.maxChunkSize) {
+      shifted.push_back(boundary - 14);
+    }
+  }
+  ASSERT_FALSE(shifted.empty());
+  auto it = std::find(a.begin(), a.end(), shifted.front());
+  ASSERT_NE(a.end(), it);
+  EXPECT_TRUE(std::equal(shifted.begin(), shifted.end(), it));
+}
+
+TEST(ContentDefinedChunker, Split) {
+  auto const options = smallOptions();
+  auto const data = randomString(50000, 4);
+  IOBufQueue queue;
+  for (size_t pos = 0; pos < data.size(); pos += 3000) {
+    queue.append(IOBuf::copyBuffer(
+        data.data() + pos, std::min<size_t>(3000, data.size() - pos)));
+  }
+  auto chain = queue.move();
+
+  auto const chunks = ContentDefinedChunker::split(*chain, options);
+  auto const boundaries = chunk(data, options);
+  ASSERT_EQ(boundaries.size(), chunks.size());
+  std::string joined;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    joined += chunks[i]->moveToFbString().toStdString();
+    EXPECT_EQ(boundaries[i], joined.size());
+  }
+  EXPECT_EQ(data, joined);
+}
@@ -147,6 +147,43 @@ BENCHMARK_RELATIVE(prefix, iters) {
   }
 }
 
+// Header lines spread over 1500 byte fragments, as received from a socket.
+unique_ptr<IOBuf> makeLines() {
+  std::string data;
+  while (data.size() < 16 * 1024) {
+    data += "X-Some-Header: some moderately long header value\r\n";
+  }
+  auto chain = IOBuf::create(0);
+  for (size_t pos = 0; pos < data.size(); pos += 1500) {
+    auto len = std::min<size_t>(1500, data.size() - pos);
+    chain->prependChain(IOBuf::copyBuffer(data.data() + pos, len));
+  }
+  return chain;
+}
+
+BENCHMARK(readLinesWhile, iters) {
+  auto chain = makeLines();
+  while (iters--) {
+    Cursor c(chain.get());
+    while (!c.isAtEnd()) {
+      detail::CursorNoopAppender out;
+      c.readWhile([](uint8_t ch) { return ch != '\n'; }, out);
+      c.skip(1);
+    }
+  }
+}
+
+BENCHMARK_RELATIVE(readLinesUntil, iters) {
+  auto chain = makeLines();
+  while (iters--) {
+    Cursor c(chain.get());
+    detail::CursorNoopAppender out;
+    while (c.readUntil('\n', out)) {
+      c.skip(1);
+    }
+  }
+}
+
 /**
  * ============================================================================
  * folly/io/test/IOBufCursorBenchmark.cpp          relative  time/iter  iters/s
@@ -959,6 +959,61 @@ TEST(IOBuf, ReadWhileTrue) {
   }
 }
 
+namespace {
+struct ChunkCollector {
+  void append(ByteRange bytes) {
+    chunks.push_back(StringPiece(bytes).str());
+  }
+  std::vector<std::string> chunks;
+};
+} // namespace
+
+TEST(IOBuf, FindAndReadUntil) {
+  std::unique_ptr<IOBuf> chain(IOBuf::create(10));
+  append(chain, "GET / HT");
+  chain->prependChain(IOBuf::create(10));
+  std::unique_ptr<IOBuf> buf(IOBuf::create(10));
+  append(buf, "TP/1.1\r");
+  chain->prependChain(std::move(buf));
+  buf = IOBuf::create(20);
+  append(buf, "\nHost: a\r\n");
+  chain->prependChain(std::move(buf));
+
+  Cursor curs(chain.get());
+  EXPECT_EQ(3, curs.findByte(' '));
+  EXPECT_EQ(15, curs.findByte('\n'));
+  EXPECT_EQ(std::string::npos, curs.findByte('\n', 15));
+  EXPECT_EQ(15, curs.findByte('\n', 16));
+  EXPECT_EQ(std::string::npos, curs.findByte('x'));
+  EXPECT_EQ(14, curs.findAnyOf(StringPiece("\r\n")));
+  EXPECT_EQ(std::string::npos, curs.findAnyOf(StringPiece("xyz")));
+  // nothing moved
+  EXPECT_EQ(0, curs.getCurrentPosition());
+
+  ChunkCollector line;
+  EXPECT_FALSE(curs.readUntil('\n', line, 10));
+  EXPECT_TRUE(line.chunks.empty());
+  EXPECT_TRUE(curs.readUntilAnyOf(StringPiece("\r\n"), line));
+  EXPECT_EQ((std::vector<std::string>{"GET / HT", "TP/1.1"}), line.chunks);
+  EXPECT_EQ(14, curs.getCurrentPosition());
+  EXPECT_EQ(0, curs.findByte('\r'));
+  curs.skip(2);
+
+  ChunkCollector header;
+  EXPECT_TRUE(curs.readUntil(':', header));
+  EXPECT_EQ((std::vector<std::string>{"Host"}), header.chunks);
+  EXPECT_EQ(4, curs.findByte('\n'));
+  EXPECT_EQ(std::string::npos, curs.findByte(' ', 1));
+
+  // bounded cursors do not search past their end
+  Cursor bounded(chain.get(), 15);
+  EXPECT_EQ(14, bounded.findByte('\r'));
+  EXPECT_EQ(std::string::npos, bounded.findByte('\n'));
+  EXPECT_EQ(std::string::npos, bounded.findAnyOf(StringPiece(":")));
+  bounded.skip(9);
+  EXPECT_EQ(5, bounded.findByte('\r'));
+}
+
 TEST(IOBuf, TestAdvanceToEndSingle) {
   std::unique_ptr<IOBuf> chain(IOBuf::create(10));
   chain->append(10);
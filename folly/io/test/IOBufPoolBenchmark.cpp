@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/MPMCQueue.h>
+#include <folly/io/IOBufPool.h>
+#include <folly/portability/GFlags.h>
+
+using folly::IOBuf;
+using folly::IOBufPool;
+
+namespace {
+
+// Keeps a few buffers alive at a time, as a server handling several
+// requests would.
+constexpr size_t kLive = 16;
+
+template <typename Create>
+void createAndDestroy(size_t iters, size_t size, Create create) {
+  std::vector<std::unique_ptr<IOBuf>> bufs(kLive);
+  for (size_t i = 0; i < iters; ++i) {
+    bufs[i % kLive] = create(size);
+    folly::doNotOptimizeAway(bufs[i % kLive]->writableData());
+  }
+}
+
+// Buffers are created on this thread and freed on another one.
+template <typename Create>
+void producerConsumer(size_t iters, size_t size, Create create) {
+  folly::MPMCQueue<std::unique_ptr<IOBuf>> queue(1024);
+  std::thread consumer([&] {
+    for (size_t i = 0; i < iters; ++i) {
+      std::unique_ptr<IOBuf> buf;
+      queue.blockingRead(buf);
+    }
+  });
+  for (size_t i = 0; i < iters; ++i) {
+    queue.blockingWrite(create(size));
+  }
+  consumer.join();
+}
+
+std::unique_ptr<IOBuf> createMalloc(size_t size) {
+  return IOBuf::create(size);
+}
+
+std::unique_ptr<IOBuf> createPooled(size_t size) {
+  return IOBufPool::instance().create(size);
+}
+
+} // namespace
+
+#define POOL_BENCHMARKS(name, size)                 \
+  BENCHMARK(name##_malloc_##size, iters) {          \
+    name(iters, size, createMalloc);                \
+  }                                                 \
+  BENCHMARK_RELATIVE(name##_pooled_##size, iters) { \
+    name(iters, size, createPooled);                \
+  }
+
+POOL_BENCHMARKS(createAndDestroy, 64)
+POOL_BENCHMARKS(createAndDestroy, 512)
+POOL_BENCHMARKS(createAndDestroy, 4000)
+POOL_BENCHMARKS(createAndDestroy, 16000)
+BENCHMARK_DRAW_LINE();
+POOL_BENCHMARKS(producerConsumer, 64)
+POOL_BENCHMARKS(producerConsumer, 4000)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/io/IOBufPool.h>
+
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+
+using folly::IOBuf;
+using folly::IOBufPool;
+
+TEST(IOBufPool, SizeClasses) {
+  IOBufPool pool;
+  for (size_t capacity : {0, 1, 48, 49, 1000, 4096, 65000}) {
+    auto buf = pool.create(capacity);
+    EXPECT_GE(buf->capacity(), capacity);
+    EXPECT_LT(buf->capacity(), std::max<size_t>(capacity, 32) * 2 + 16);
+    EXPECT_EQ(0, buf->length());
+    EXPECT_EQ(0, buf->headroom());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf->data()) % 16);
+  }
+  EXPECT_EQ(5, pool.numBuffers());
+
+  // too large to be pooled
+  auto buf = pool.create(IOBufPool::maxPooledCapacity() + 1);
+  EXPECT_GT(buf->capacity(), IOBufPool::maxPooledCapacity());
+  EXPECT_EQ(5, pool.numBuffers());
+}
+
+TEST(IOBufPool, Reuse) {
+  IOBufPool pool;
+  auto buf = pool.create(100);
+  auto* data = buf->data();
+  auto clone = buf->clone();
+  buf.reset();
+  EXPECT_EQ(1, pool.numBuffers());
+
+  // still used by the clone
+  buf = pool.create(100);
+  EXPECT_NE(data, buf->data());
+  EXPECT_EQ(2, pool.numBuffers());
+
+  clone.reset();
+  auto other = pool.create(100);
+  EXPECT_EQ(data, other->data());
+  EXPECT_EQ(2, pool.numBuffers());
+}
+
+TEST(IOBufPool, CrossThread) {
+  IOBufPool::Options options;
+  options.maxLocalBuffers = 8;
+  options.transferBatch = 4;
+  IOBufPool pool(options);
+
+  std::vector<std::unique_ptr<IOBuf>> bufs;
+  for (size_t i = 0; i < 32; ++i) {
+    bufs.push_back(pool.create(512));
+  }
+  EXPECT_EQ(32, pool.numBuffers());
+
+  // Freed on another thread, the buffers end up in the shared list when
+  // that thread exits.
+  std::thread([&] { bufs.clear(); }).join();
+  EXPECT_EQ(32, pool.numSharedBuffers());
+
+  for (size_t i = 0; i < 32; ++i) {
+    bufs.push_back(pool.create(512));
+  }
+  EXPECT_EQ(32, pool.numBuffers());
+  EXPECT_EQ(0, pool.numSharedBuffers());
+}
+
+TEST(IOBufPool, Limits) {
+  IOBufPool::Options options;
+  options.maxLocalBuffers = 4;
+  options.transferBatch = 2;
+  options.maxSharedBuffers = 6;
+  IOBufPool pool(options);
+
+  std::vector<std::unique_ptr<IOBuf>> bufs;
+  for (size_t i = 0; i < 16; ++i) {
+    bufs.push_back(pool.create(64));
+  }
+  bufs.clear();
+  // 4 cached by this thread and 6 in the shared list
+  EXPECT_EQ(10, pool.numBuffers());
+  EXPECT_EQ(6, pool.numSharedBuffers());
+
+  pool.trim();
+  EXPECT_EQ(4, pool.numBuffers());
+  pool.flushThreadCache();
+  EXPECT_EQ(4, pool.numSharedBuffers());
+  pool.trim();
+  EXPECT_EQ(0, pool.numBuffers());
+}
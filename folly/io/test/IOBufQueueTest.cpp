@@ -21,6 +21,7 @@
 #include <stdexcept>
 
 #include <folly/Range.h>
+#include <folly/io/IOBufPool.h>
 #include <folly/portability/GTest.h>
 
 using folly::IOBuf;
@@ -529,3 +530,87 @@ TEST(IOBufQueue, Gather) {
       queue.front()->length());
   EXPECT_EQ("hello world", s);
 }
+
+TEST(IOBufQueue, GrowthPolicy) {
+  IOBufQueue::Options options;
+  options.minAllocSize = 100;
+  options.maxAllocSize = 1000;
+  std::string data(5000, 'x');
+
+  IOBufQueue fixed(options);
+  for (size_t i = 0; i < data.size(); i += 10) {
+    fixed.append(data.data() + i, 10);
+  }
+  EXPECT_GE(fixed.countChainElements(), 40);
+  EXPECT_EQ(fixed.countChainElements(), fixed.buffersAllocated());
+
+  options.growthFactor = 2;
+  IOBufQueue geometric(options);
+  for (size_t i = 0; i < data.size(); i += 10) {
+    geometric.append(data.data() + i, 10);
+  }
+  EXPECT_LE(geometric.countChainElements(), 10);
+  EXPECT_EQ(geometric.countChainElements(), geometric.buffersAllocated());
+  EXPECT_EQ(data, queueToString(geometric));
+
+  const IOBuf* buf = geometric.front();
+  while (buf->next() != geometric.front()) {
+    EXPECT_GE(
+        buf->next()->capacity(), std::min<size_t>(buf->capacity() * 2, 1000));
+    buf = buf->next();
+  }
+
+  // the single argument preallocate() follows the policy too
+  IOBufQueue queue(options);
+  EXPECT_GE(queue.preallocate(10).second, 100);
+  queue.postallocate(10);
+  // fits in the tail
+  EXPECT_GE(queue.preallocate(50).second, 50);
+  EXPECT_EQ(1, queue.buffersAllocated());
+  EXPECT_GE(queue.preallocate(500).second, 500);
+  EXPECT_EQ(2, queue.buffersAllocated());
+}
+
+TEST(IOBufQueue, CoalesceSmallBuffers) {
+  IOBufQueue::Options options = clOptions;
+  options.coalesceBelow = 64;
+  IOBufQueue queue(options);
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    queue.append(stringToIOBuf(SCL("0123456789")));
+    expected += "0123456789";
+  }
+  checkConsistency(queue);
+  EXPECT_EQ(1, queue.countChainElements());
+  EXPECT_EQ(100, queue.buffersCoalesced());
+  EXPECT_EQ(expected, queueToString(queue));
+
+  // large buffers are chained as is, small ones around them still copied
+  std::string large(1000, 'x');
+  auto chain = stringToIOBuf(SCL("abc"));
+  chain->prependChain(stringToIOBuf(large.data(), large.size()));
+  chain->prependChain(stringToIOBuf(SCL("def")));
+  IOBufQueue other;
+  other.append(std::move(chain));
+  queue.append(other);
+  expected += "abc" + large + "def";
+  checkConsistency(queue);
+  EXPECT_LE(queue.countChainElements(), 3);
+  EXPECT_EQ(102, queue.buffersCoalesced());
+  EXPECT_EQ(expected, queueToString(queue));
+}
+
+TEST(IOBufQueue, Pool) {
+  folly::IOBufPool pool;
+  IOBufQueue::Options options;
+  options.pool = &pool;
+  {
+    IOBufQueue queue(options);
+    queue.append(SCL("hello"));
+    queue.preallocate(100000);
+    EXPECT_EQ(2, queue.buffersAllocated());
+    // too large to be pooled
+    EXPECT_EQ(1, pool.numBuffers());
+  }
+  EXPECT_EQ(1, pool.numBuffers());
+}
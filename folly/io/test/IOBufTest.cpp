@@ -1513,6 +1513,111 @@ TEST(IOBuf, CoalesceEmptyBuffers) {
   EXPECT_TRUE(ByteRange(StringPiece("hello")) == br);
 }
 
+namespace {
+size_t allocatorBytes = 0;
+
+// malloc(), keeping track of the bytes in use
+IOBuf::CoalesceAllocator countingAllocator() {
+  return IOBuf::CoalesceAllocator{
+      [](size_t size, void* userData) {
+        allocatorBytes += size;
+        void* buf = malloc(sizeof(size_t) * 2 + size);
+        *static_cast<size_t*>(buf) = size;
+        EXPECT_EQ(&allocatorBytes, userData);
+        return static_cast<void*>(static_cast<size_t*>(buf) + 2);
+      },
+      [](void* buf, void* /* userData */) {
+        auto* start = static_cast<size_t*>(buf) - 2;
+        allocatorBytes -= *start;
+        free(start);
+      },
+      &allocatorBytes};
+}
+
+std::unique_ptr<IOBuf> makeChain(std::initializer_list<StringPiece> parts) {
+  std::unique_ptr<IOBuf> chain;
+  for (auto part : parts) {
+    auto buf = IOBuf::copyBuffer(part);
+    if (chain) {
+      chain->prependChain(std::move(buf));
+    } else {
+      chain = std::move(buf);
+    }
+  }
+  return chain;
+}
+} // namespace
+
+TEST(IOBuf, CoalesceWithAllocator) {
+  auto allocator = countingAllocator();
+  {
+    auto chain = makeChain({"hello", " ", "world"});
+    auto clone = chain->clone();
+    EXPECT_EQ("hello world", StringPiece(chain->coalesce(allocator)));
+    EXPECT_FALSE(chain->isChained());
+    EXPECT_GE(allocatorBytes, 11);
+    // the clone keeps the original buffers
+    EXPECT_EQ(3, clone->countChainElements());
+
+    // no copy of a single buffer
+    auto before = allocatorBytes;
+    chain->coalesce(allocator);
+    EXPECT_EQ(before, allocatorBytes);
+  }
+  EXPECT_EQ(0, allocatorBytes);
+
+  {
+    auto chain = makeChain({"ab", "cd", "ef", "gh"});
+    chain->gather(3, allocator);
+    EXPECT_EQ("abcdefgh", StringPiece(chain->coalesce()));
+    EXPECT_EQ(0, allocatorBytes);
+  }
+
+  {
+    auto chain = makeChain({"ab", "cd", "ef", "gh"});
+    chain->gather(3, allocator);
+    EXPECT_EQ(3, chain->countChainElements());
+    EXPECT_EQ("abcd", StringPiece(ByteRange(chain->data(), chain->length())));
+    EXPECT_GT(allocatorBytes, 0);
+  }
+  EXPECT_EQ(0, allocatorBytes);
+}
+
+TEST(IOBuf, CoalescePrefix) {
+  auto chain = makeChain({"ab", "cdefgh", "ij", "klmnop"});
+
+  // already contiguous
+  EXPECT_EQ("a", StringPiece(chain->coalescePrefix(1)));
+  EXPECT_EQ(4, chain->countChainElements());
+
+  // ends within the second buffer, which is trimmed
+  EXPECT_EQ("abcd", StringPiece(chain->coalescePrefix(4)));
+  EXPECT_EQ(4, chain->countChainElements());
+  EXPECT_EQ(4, chain->length());
+  EXPECT_EQ("efgh", StringPiece(ByteRange(chain->next()->data(), 4)));
+
+  // ends at a buffer boundary
+  EXPECT_EQ("abcdefghij", StringPiece(chain->coalescePrefix(10)));
+  EXPECT_EQ(2, chain->countChainElements());
+
+  // the buffer that ends the prefix is not copied whole
+  EXPECT_EQ("abcdefghijk", StringPiece(chain->coalescePrefix(11)));
+  EXPECT_EQ(2, chain->countChainElements());
+  EXPECT_EQ("lmnop", StringPiece(ByteRange(chain->next()->data(), 5)));
+
+  EXPECT_THROW(chain->coalescePrefix(17), std::overflow_error);
+  EXPECT_EQ(2, chain->countChainElements());
+  EXPECT_EQ(16, chain->computeChainDataLength());
+
+  auto allocator = countingAllocator();
+  EXPECT_EQ(
+      "abcdefghijklmnop", StringPiece(chain->coalescePrefix(16, allocator)));
+  EXPECT_FALSE(chain->isChained());
+  EXPECT_GT(allocatorBytes, 0);
+  chain.reset();
+  EXPECT_EQ(0, allocatorBytes);
+}
+
 TEST(IOBuf, CloneCoalescedChain) {
   auto b = IOBuf::createChain(1000, 100);
   b->advance(10);
@@ -24,6 +24,7 @@
 
 #include <folly/Conv.h>
 #include <folly/FBString.h>
+#include <folly/Format.h>
 #include <folly/Random.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/io/IOBufQueue.h>
@@ -328,6 +329,172 @@ TEST(RecordIOTest, validateRecordAPI) {
   }
 }
 
+TEST(RecordIOTest, IndexedReader) {
+  TemporaryFile file;
+  {
+    RecordIOWriter writer(File(file.fd()));
+    for (int i = 0; i < 100; ++i) {
+      writer.write(IOBuf::copyBuffer(sformat("key{:03d}", i)));
+    }
+  }
+  {
+    // records with another file id are not indexed
+    RecordIOWriter writer(File(file.fd()), 2);
+    writer.write(IOBuf::copyBuffer("other"));
+  }
+  TemporaryFile indexFile;
+  {
+    IndexedRecordIOReader reader(File(file.fd()), 1);
+    ASSERT_EQ(100, reader.size());
+    EXPECT_EQ("key000", sp(reader[0].first));
+    EXPECT_EQ(0, reader[0].second);
+    EXPECT_EQ("key042", sp(reader.record(42).first));
+    EXPECT_EQ(
+        off_t(42 * (recordio_helpers::headerSize() + 6)),
+        reader.record(42).second);
+    EXPECT_THROW(reader.record(100), std::out_of_range);
+
+    auto key = [](ByteRange record) { return sp(record); };
+    EXPECT_EQ(50, reader.lowerBound(StringPiece("key05"), key));
+    EXPECT_EQ(50, reader.lowerBound(StringPiece("key050"), key));
+    EXPECT_EQ(0, reader.lowerBound(StringPiece("a"), key));
+    EXPECT_EQ(100, reader.lowerBound(StringPiece("z"), key));
+
+    reader.prefetch(10, 20);
+    reader.prefetch(90, 100);
+    reader.writeIndex(File(indexFile.fd()));
+  }
+  {
+    IndexedRecordIOReader reader(
+        File(file.fd()), File(indexFile.fd()), 1);
+    ASSERT_EQ(100, reader.size());
+    EXPECT_EQ("key099", sp(reader[99].first));
+  }
+  {
+    // written for another file id
+    IndexedRecordIOReader reader(File(file.fd()), File(indexFile.fd()));
+    ASSERT_EQ(101, reader.size());
+    EXPECT_EQ("other", sp(reader[100].first));
+  }
+  {
+    RecordIOWriter writer(File(file.fd()));
+    writer.write(IOBuf::copyBuffer("key100"));
+  }
+  {
+    // stale, rebuilt
+    IndexedRecordIOReader reader(
+        File(file.fd()), File(indexFile.fd()), 1);
+    ASSERT_EQ(101, reader.size());
+    EXPECT_EQ("key100", sp(reader[100].first));
+  }
+}
+
+TEST(RecordIOTest, Blocks) {
+  for (auto type : {io::CodecType::NO_COMPRESSION, io::CodecType::ZSTD}) {
+    if (!io::hasCodec(type)) {
+      continue;
+    }
+    SCOPED_TRACE(to<std::string>("codec ", type));
+    TemporaryFile file;
+    {
+      RecordIOWriter writer(File(file.fd()));
+      writer.write(iobufs({"first"}));
+    }
+    {
+      RecordIOWriter::BlockOptions options;
+      options.codecType = type;
+      options.blockSize = 16;
+      RecordIOWriter writer(File(file.fd()), 1, options);
+      writer.write(iobufs({"hello ", "world"}));
+      writer.write(iobufs({""}));
+      // makes the block larger than blockSize
+      writer.write(iobufs({"goodbye"}));
+      // written when the writer is destroyed
+      writer.write(iobufs({"meow"}));
+    }
+    {
+      RecordIOWriter writer(File(file.fd()));
+      writer.write(iobufs({"last"}));
+    }
+    off_t block1;
+    off_t block2;
+    {
+      RecordIOReader reader(File(file.fd()));
+      auto it = reader.begin();
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("first", sp(it->first));
+      ++it;
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("hello world", sp(it->first));
+      block1 = it->second;
+      EXPECT_EQ(off_t(recordio_helpers::headerSize() + 5), block1);
+      ++it;
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("goodbye", sp(it->first));
+      EXPECT_EQ(block1, it->second);
+      ++it;
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("meow", sp(it->first));
+      block2 = it->second;
+      EXPECT_GT(block2, block1);
+      ++it;
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("last", sp(it->first));
+      ++it;
+      EXPECT_TRUE(it == reader.end());
+
+      it = reader.seek(block1 + 1);
+      ASSERT_FALSE(it == reader.end());
+      EXPECT_EQ("meow", sp(it->first));
+      it = reader.seek(block1);
+      auto copy = it++;
+      EXPECT_EQ("hello world", sp(copy->first));
+      EXPECT_EQ("goodbye", sp(it->first));
+      EXPECT_FALSE(copy == it);
+    }
+    {
+      // corrupt the first block, which is skipped
+      char c;
+      auto pos = block1 + off_t(recordio_helpers::headerSize() + 13);
+      ASSERT_EQ(1, pread(file.fd(), &c, 1, pos));
+      c ^= 1;
+      ASSERT_EQ(1, pwrite(file.fd(), &c, 1, pos));
+      RecordIOReader reader(File(file.fd()));
+      auto it = reader.begin();
+      EXPECT_EQ("first", sp((it++)->first));
+      EXPECT_EQ("meow", sp(it->first));
+      EXPECT_EQ(block2, (it++)->second);
+      EXPECT_EQ("last", sp((it++)->first));
+      EXPECT_TRUE(it == reader.end());
+    }
+  }
+}
+
+TEST(RecordIOTest, BlockChecksum) {
+  auto codec = io::getCodec(io::CodecType::NO_COMPRESSION);
+  IOBufQueue block;
+  recordio_helpers::appendToBlock(block, iobufs({"hello"}));
+  recordio_helpers::appendToBlock(block, iobufs({"world"}));
+  auto data = recordio_helpers::compressBlock(*block.move(), *codec);
+  data->coalesce();
+
+  auto uncompressed = recordio_helpers::uncompressBlock(data->coalesce());
+  ASSERT_NE(nullptr, uncompressed);
+  ByteRange rest = uncompressed->coalesce();
+  EXPECT_EQ("hello", sp(recordio_helpers::nextBlockRecord(rest)));
+  EXPECT_EQ("world", sp(recordio_helpers::nextBlockRecord(rest)));
+  EXPECT_TRUE(rest.empty());
+  EXPECT_TRUE(recordio_helpers::nextBlockRecord(rest).empty());
+
+  // the record hash does not cover a mismatch between the checksum and
+  // the uncompressed records
+  data->writableData()[8] ^= 1;
+  EXPECT_EQ(nullptr, recordio_helpers::uncompressBlock(data->coalesce()));
+  data->writableData()[8] ^= 1;
+  data->writableData()[data->length() - 1] ^= 1;
+  EXPECT_EQ(nullptr, recordio_helpers::uncompressBlock(data->coalesce()));
+}
+
 } // namespace test
 } // namespace folly
 
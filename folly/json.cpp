@@ -25,10 +25,15 @@
 #include <glog/logging.h>
 
 #include <folly/Conv.h>
+#include <folly/Indestructible.h>
 #include <folly/Portability.h>
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <folly/Unicode.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/lang/Assume.h>
 #include <folly/lang/Bits.h>
 #include <folly/portability/Constexpr.h>
 
@@ -52,9 +57,95 @@ parse_error make_parse_error(
       expected));
 }
 
+// Output for Printer and escapeString that writes through an io::Appender
+// or io::QueueAppender, with the subset of the std::string interface they
+// use.
+template <class Appender>
+class AppenderOutput {
+ public:
+  explicit AppenderOutput(Appender& appender) : appender_(appender) {}
+
+  void push_back(char c) {
+    appender_.write(c);
+  }
+
+  void append(const char* data, size_t size) {
+    appender_.push(reinterpret_cast<const uint8_t*>(data), size);
+  }
+
+  void append(const char* str) {
+    append(str, strlen(str));
+  }
+
+  void append(size_t count, char c) {
+    while (count > 0) {
+      appender_.ensure(1);
+      auto n = std::min(count, appender_.length());
+      memset(appender_.writableData(), c, n);
+      appender_.append(n);
+      count -= n;
+    }
+  }
+
+  AppenderOutput& operator+=(char c) {
+    push_back(c);
+    return *this;
+  }
+
+  AppenderOutput& operator+=(const char* str) {
+    append(str);
+    return *this;
+  }
+
+  // for the toAppend() overloads, which only take strings
+  std::string& scratch() {
+    scratch_.clear();
+    return scratch_;
+  }
+
+ private:
+  Appender& appender_;
+  std::string scratch_;
+};
+
+void appendInt(std::string& out, int64_t value) {
+  toAppend(value, &out);
+}
+
+template <class Appender>
+void appendInt(AppenderOutput<Appender>& out, int64_t value) {
+  auto& scratch = out.scratch();
+  toAppend(value, &scratch);
+  out.append(scratch.data(), scratch.size());
+}
+
+void appendDouble(
+    std::string& out,
+    double value,
+    serialization_opts const& opts) {
+  toAppend(value, &out, opts.double_mode, opts.double_num_digits);
+}
+
+template <class Appender>
+void appendDouble(
+    AppenderOutput<Appender>& out,
+    double value,
+    serialization_opts const& opts) {
+  auto& scratch = out.scratch();
+  toAppend(value, &scratch, opts.double_mode, opts.double_num_digits);
+  out.append(scratch.data(), scratch.size());
+}
+
+template <class Output>
+void escapeStringTo(
+    StringPiece input,
+    Output& out,
+    const serialization_opts& opts);
+
+template <class Output>
 struct Printer {
   explicit Printer(
-      std::string& out,
+      Output& out,
       unsigned* indentLevel,
       serialization_opts const* opts)
       : out_(out), indentLevel_(indentLevel), opts_(*opts) {}
@@ -68,8 +159,7 @@ struct Printer {
               "folly::toJson: JSON object value was a "
               "NaN or INF");
         }
-        toAppend(
-            v.asDouble(), &out_, opts_.double_mode, opts_.double_num_digits);
+        appendDouble(out_, v.asDouble(), opts_);
         break;
       case dynamic::INT64: {
         auto intval = v.asInt();
@@ -78,7 +168,7 @@ struct Printer {
           // as a double without loss of precision.
           intval = int64_t(to<double>(intval));
         }
-        toAppend(intval, &out_);
+        appendInt(out_, intval);
         break;
       }
       case dynamic::BOOL:
@@ -88,7 +178,7 @@ struct Printer {
         out_ += "null";
         break;
       case dynamic::STRING:
-        escapeString(v.asString(), out_, opts_);
+        escapeStringTo(v.asString(), out_, opts_);
         break;
       case dynamic::OBJECT:
         printObject(v);
@@ -190,7 +280,8 @@ struct Printer {
 
   void newline() const {
     if (indentLevel_) {
-      out_ += to<std::string>('\n', std::string(*indentLevel_ * 2, ' '));
+      out_ += '\n';
+      out_.append(*indentLevel_ * 2, ' ');
     }
   }
 
@@ -199,7 +290,7 @@ struct Printer {
   }
 
  private:
-  std::string& out_;
+  Output& out_;
   unsigned* const indentLevel_;
   serialization_opts const& opts_;
 };
@@ -207,9 +298,27 @@ struct Printer {
 //////////////////////////////////////////////////////////////////////
 
 // Wraps our input buffer with some helper functions.
+//
+// The input may also be an IOBuf chain, which is read one buffer at a time.
+// Ranges returned by skipWhile() and friends then end at buffer
+// boundaries, except for numbers, which parseNumber() makes contiguous
+// with joinWhile().
 struct Input {
-  explicit Input(StringPiece range, json::serialization_opts const* opts)
-      : range_(range), opts_(*opts), lineNum_(0) {
+  explicit Input(
+      StringPiece range,
+      json::serialization_opts const* opts,
+      unsigned lineNum = 0)
+      : range_(range), opts_(*opts), lineNum_(lineNum) {
+    storeCurrent();
+  }
+
+  explicit Input(IOBuf const& buf, json::serialization_opts const* opts)
+      : range_(StringPiece(ByteRange(buf.data(), buf.length()))),
+        opts_(*opts),
+        lineNum_(0),
+        head_(&buf),
+        next_(buf.next() != &buf ? buf.next() : nullptr),
+        remaining_(buf.computeChainDataLength() - buf.length()) {
     storeCurrent();
   }
 
@@ -257,25 +366,58 @@ struct Input {
   }
 
   void skipWhitespace() {
-    unsigned index = 0;
     while (true) {
-      while (index < range_.size() && range_[index] == ' ') {
-        index++;
-      }
-      if (index < range_.size()) {
-        if (range_[index] == '\n') {
+      unsigned index = 0;
+      while (true) {
+        while (index < range_.size() && range_[index] == ' ') {
           index++;
-          ++lineNum_;
-          continue;
         }
-        if (range_[index] == '\t' || range_[index] == '\r') {
-          index++;
-          continue;
+        if (index < range_.size()) {
+          if (range_[index] == '\n') {
+            index++;
+            ++lineNum_;
+            continue;
+          }
+          if (range_[index] == '\t' || range_[index] == '\r') {
+            index++;
+            continue;
+          }
         }
+        break;
+      }
+      bool const skippedAll = index == range_.size();
+      range_.advance(index);
+      storeCurrent();
+      // the whitespace may go on in the next buffer
+      if (!skippedAll || range_.empty()) {
+        break;
       }
-      break;
     }
-    range_.advance(index);
+  }
+
+  // Make the run of characters satisfying the predicate at the current
+  // position contiguous, copying it if it spans several buffers.
+  template <class Predicate>
+  void joinWhile(const Predicate& p) {
+    if (LIKELY(!next_) || !std::all_of(range_.begin(), range_.end(), p)) {
+      return;
+    }
+    std::string joined(range_.begin(), range_.end());
+    while (next_) {
+      auto segment = nextSegment();
+      auto n = size_t(
+          std::find_if_not(segment.begin(), segment.end(), p) -
+          segment.begin());
+      joined.append(segment.begin(), n);
+      remaining_ -= n;
+      if (n < segment.size()) {
+        nextOffset_ += n;
+        break;
+      }
+      popNext();
+    }
+    scratch_ = std::move(joined);
+    range_ = scratch_;
     storeCurrent();
   }
 
@@ -288,7 +430,7 @@ struct Input {
   }
 
   std::size_t size() const {
-    return range_.size();
+    return range_.size() + remaining_;
   }
 
   int operator*() const {
@@ -315,7 +457,14 @@ struct Input {
       storeCurrent();
       return true;
     }
-    return false;
+    if (LIKELY(!next_) || range_.size() >= str.size() ||
+        !startsWithAcrossBuffers(str)) {
+      return false;
+    }
+    for (size_t i = 0; i < str.size(); ++i) {
+      ++*this;
+    }
+    return true;
   }
 
   std::string context() const {
@@ -343,15 +492,58 @@ struct Input {
 
  private:
   void storeCurrent() {
+    while (UNLIKELY(range_.empty()) && next_) {
+      range_ = nextSegment();
+      remaining_ -= range_.size();
+      popNext();
+    }
     current_ = range_.empty() ? EOF : range_.front();
   }
 
+  StringPiece nextSegment() const {
+    return StringPiece(ByteRange(
+        next_->data() + nextOffset_, next_->length() - nextOffset_));
+  }
+
+  void popNext() {
+    next_ = next_->next() != head_ ? next_->next() : nullptr;
+    nextOffset_ = 0;
+  }
+
+  bool startsWithAcrossBuffers(StringPiece str) const {
+    if (!boost::starts_with(str, range_)) {
+      return false;
+    }
+    str.advance(range_.size());
+    for (auto buf = next_; buf && !str.empty();) {
+      auto segment = StringPiece(ByteRange(buf->data(), buf->length()));
+      if (buf == next_) {
+        segment.advance(nextOffset_);
+      }
+      auto n = std::min(segment.size(), str.size());
+      if (segment.subpiece(0, n) != str.subpiece(0, n)) {
+        return false;
+      }
+      str.advance(n);
+      buf = buf->next() != head_ ? buf->next() : nullptr;
+    }
+    return str.empty();
+  }
+
  private:
   StringPiece range_;
   json::serialization_opts const& opts_;
   unsigned lineNum_;
   int current_;
   unsigned int currentRecursionLevel_{0};
+  // rest of the chain, when parsing an IOBuf
+  IOBuf const* head_{nullptr};
+  IOBuf const* next_{nullptr};
+  size_t nextOffset_{0};
+  // bytes in and after next_
+  size_t remaining_{0};
+  // number that spanned several buffers
+  std::string scratch_;
 };
 
 class RecursionGuard {
@@ -474,6 +666,10 @@ dynamic parseArray(Input& in, json::metadata_map* map) {
 }
 
 dynamic parseNumber(Input& in) {
+  in.joinWhile([](char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+        (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+  });
   bool const negative = (*in == '-');
   if (negative && in.consume("-Infinity")) {
     if (in.getOpts().parse_numbers_as_strings) {
@@ -675,7 +871,8 @@ std::array<uint64_t, 2> buildExtraAsciiToEscapeBitmap(StringPiece chars) {
 std::string serialize(dynamic const& dyn, serialization_opts const& opts) {
   std::string ret;
   unsigned indentLevel = 0;
-  Printer p(ret, opts.pretty_formatting ? &indentLevel : nullptr, &opts);
+  Printer<std::string> p(
+      ret, opts.pretty_formatting ? &indentLevel : nullptr, &opts);
   p(dyn);
   return ret;
 }
@@ -684,7 +881,10 @@ std::string serialize(dynamic const& dyn, serialization_opts const& opts) {
 // unescaped in a string of sizeof(T) bytes packed in an integer of
 // type T.
 template <bool EnableExtraAsciiEscapes, class T>
-size_t firstEscapableInWord(T s, const serialization_opts& opts) {
+size_t firstEscapableInWord(
+    T s,
+    const serialization_opts& opts,
+    bool copyNonAscii) {
   static_assert(std::is_unsigned<T>::value, "Unsigned integer required");
   static constexpr T kOnes = ~T() / 255; // 0x...0101
   static constexpr T kMsbs = kOnes * 0x80; // 0x...8080
@@ -703,7 +903,7 @@ size_t firstEscapableInWord(T s, const serialization_opts& opts) {
 
   // The following masks have the MSB set for each byte of the word
   // that satisfies the corresponding condition.
-  auto isHigh = s & kMsbs; // >= 128
+  auto isHigh = copyNonAscii ? T(0) : T(s & kMsbs); // >= 128
   auto isLow = isLess(s, 0x20); // <= 0x1f
   auto needsEscape = isHigh | isLow | isChar('\\') | isChar('"');
 
@@ -738,10 +938,10 @@ size_t firstEscapableInWord(T s, const serialization_opts& opts) {
 }
 
 // Escape a string so that it is legal to print it in JSON text.
-template <bool EnableExtraAsciiEscapes>
+template <bool EnableExtraAsciiEscapes, class Output>
 void escapeStringImpl(
     StringPiece input,
-    std::string& out,
+    Output& out,
     const serialization_opts& opts) {
   auto hexDigit = [](uint8_t c) -> char {
     return c < 10 ? c + '0' : c - 10 + 'a';
@@ -753,6 +953,18 @@ void escapeStringImpl(
   auto* q = reinterpret_cast<const unsigned char*>(input.begin());
   auto* e = reinterpret_cast<const unsigned char*>(input.end());
 
+  // Unless non-ascii code points have to be encoded or replaced one at a
+  // time, validate the whole string in one vectorized pass and copy them
+  // literally along with the ascii characters.
+  const bool copyNonAscii = !opts.encode_non_ascii && !opts.skip_invalid_utf8;
+  if (copyNonAscii && opts.validate_utf8) {
+    auto valid = utf8ValidPrefixLength(input);
+    if (valid != input.size()) {
+      throw std::runtime_error(
+          to<std::string>("folly::json invalid utf8 at offset ", valid));
+    }
+  }
+
   while (p < e) {
     // Find the longest prefix that does not need escaping, and copy
     // it literally into the output string.
@@ -765,7 +977,8 @@ void escapeStringImpl(
       } else {
         word = folly::partialLoadUnaligned<uint64_t>(firstEsc, avail);
       }
-      auto prefix = firstEscapableInWord<EnableExtraAsciiEscapes>(word, opts);
+      auto prefix = firstEscapableInWord<EnableExtraAsciiEscapes>(
+          word, opts, copyNonAscii);
       DCHECK_LE(prefix, avail);
       firstEsc += prefix;
       if (prefix < 8) {
@@ -784,10 +997,9 @@ void escapeStringImpl(
 
     // Handle the next byte that may need escaping.
 
-    // Since non-ascii encoding inherently does utf8 validation
-    // we explicitly validate utf8 only if non-ascii encoding is disabled.
-    if ((opts.validate_utf8 || opts.skip_invalid_utf8) &&
-        !opts.encode_non_ascii) {
+    // Since non-ascii encoding inherently replaces invalid utf8 we
+    // explicitly replace it only if non-ascii encoding is disabled.
+    if (opts.skip_invalid_utf8 && !opts.encode_non_ascii) {
       // To achieve better spatial and temporal coherence
       // we do utf8 validation progressively along with the
       // string-escaping instead of two separate passes.
@@ -875,9 +1087,12 @@ void escapeStringImpl(
   out.push_back('\"');
 }
 
-void escapeString(
+namespace {
+
+template <class Output>
+void escapeStringTo(
     StringPiece input,
-    std::string& out,
+    Output& out,
     const serialization_opts& opts) {
   if (FOLLY_UNLIKELY(
           opts.extra_ascii_to_escape_bitmap[0] ||
@@ -888,6 +1103,43 @@ void escapeString(
   }
 }
 
+template <class Appender>
+void serializeTo(
+    dynamic const& dyn,
+    serialization_opts const& opts,
+    Appender& appender) {
+  AppenderOutput<Appender> out(appender);
+  unsigned indentLevel = 0;
+  Printer<AppenderOutput<Appender>> p(
+      out, opts.pretty_formatting ? &indentLevel : nullptr, &opts);
+  p(dyn);
+}
+
+} // namespace
+
+void escapeString(
+    StringPiece input,
+    std::string& out,
+    const serialization_opts& opts) {
+  escapeStringTo(input, out, opts);
+}
+
+void serialize(
+    dynamic const& dyn,
+    serialization_opts const& opts,
+    IOBufQueue& out,
+    std::size_t growth) {
+  io::QueueAppender appender(&out, growth);
+  serializeTo(dyn, opts, appender);
+}
+
+void serialize(
+    dynamic const& dyn,
+    serialization_opts const& opts,
+    io::Appender& out) {
+  serializeTo(dyn, opts, out);
+}
+
 std::string stripComments(StringPiece jsonC) {
   std::string result;
   enum class State {
@@ -947,6 +1199,300 @@ std::string stripComments(StringPiece jsonC) {
   return result;
 }
 
+namespace {
+
+// the characters of numbers and literals, as in parseNumber()
+bool isScalarChar(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+      (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+bool isWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+serialization_opts const& defaultParseOpts() {
+  static Indestructible<serialization_opts> opts;
+  return *opts;
+}
+
+} // namespace
+
+stream_parser::stream_parser(event_handler& handler)
+    : stream_parser(handler, defaultParseOpts()) {}
+
+stream_parser::stream_parser(
+    event_handler& handler,
+    serialization_opts const& opts)
+    : handler_(handler), opts_(opts) {}
+
+void stream_parser::feed(StringPiece data) {
+  while (!data.empty()) {
+    data.advance(step(data));
+  }
+}
+
+void stream_parser::feed(IOBufQueue& queue) {
+  if (auto buf = queue.front()) {
+    for (auto range : *buf) {
+      feed(StringPiece(range));
+    }
+  }
+  queue.move();
+}
+
+void stream_parser::finish() {
+  if (state_ == State::Scalar) {
+    endScalar();
+  }
+  switch (state_) {
+    case State::Done:
+    case State::Ignore:
+      return;
+    case State::String:
+      error("", "unterminated string");
+    case State::Value:
+    case State::FirstElement:
+    case State::NextElement:
+      error("", "expected json value");
+    case State::FirstKey:
+    case State::NextKey:
+      error("", "expected string for object key name");
+    case State::Colon:
+      error("", "expected ':'");
+    case State::CommaOrEnd:
+    case State::Scalar:
+      break;
+  }
+  error(
+      "",
+      to<std::string>("expected '", stack_.back() == '[' ? ']' : '}', '\'')
+          .c_str());
+}
+
+size_t stream_parser::step(StringPiece data) {
+  if (state_ == State::String) {
+    size_t i = 0;
+    for (; i < data.size(); ++i) {
+      char c = data[i];
+      if (c == '\n') {
+        ++lineNum_;
+      }
+      if (escape_) {
+        escape_ = false;
+      } else if (c == '\\') {
+        escape_ = true;
+      } else if (c == '\"') {
+        break;
+      }
+    }
+    if (i == data.size()) {
+      token_.append(data.begin(), data.end());
+      return data.size();
+    }
+    token_.append(data.begin(), data.begin() + i + 1);
+    endString();
+    return i + 1;
+  }
+  if (state_ == State::Scalar) {
+    auto end = std::find_if_not(data.begin(), data.end(), isScalarChar);
+    token_.append(data.begin(), end);
+    if (end == data.end()) {
+      return data.size();
+    }
+    endScalar();
+    return size_t(end - data.begin());
+  }
+  if (state_ == State::Ignore) {
+    return data.size();
+  }
+
+  char c = data.front();
+  if (isWhitespace(c)) {
+    size_t i = 0;
+    for (; i < data.size() && isWhitespace(data[i]); ++i) {
+      if (data[i] == '\n') {
+        ++lineNum_;
+      }
+    }
+    return i;
+  }
+  switch (state_) {
+    case State::Value:
+      return startValue(data);
+    case State::NextElement:
+      if (!opts_.allow_trailing_comma) {
+        state_ = State::Value;
+        return 0;
+      }
+      FOLLY_FALLTHROUGH;
+    case State::FirstElement:
+      if (c == ']') {
+        endContainer();
+        return 1;
+      }
+      state_ = State::Value;
+      return 0;
+    case State::FirstKey:
+    case State::NextKey:
+      if (c == '}' &&
+          (state_ == State::FirstKey || opts_.allow_trailing_comma)) {
+        endContainer();
+        return 1;
+      }
+      if (c != '\"') {
+        error(data, "expected string for object key name");
+      }
+      key_ = true;
+      escape_ = false;
+      token_.assign(1, c);
+      tokenLineNum_ = lineNum_;
+      state_ = State::String;
+      return 1;
+    case State::Colon:
+      if (c != ':') {
+        error(data, "expected ':'");
+      }
+      state_ = State::Value;
+      return 1;
+    case State::CommaOrEnd: {
+      bool array = stack_.back() == '[';
+      if (c == ',') {
+        state_ = array ? State::NextElement : State::NextKey;
+        return 1;
+      }
+      if (c != (array ? ']' : '}')) {
+        error(
+            data,
+            to<std::string>("expected '", array ? ']' : '}', '\'').c_str());
+      }
+      endContainer();
+      return 1;
+    }
+    case State::Done:
+      // like parseJson(), ignore anything after a null byte
+      if (c != '\0') {
+        error(data, "parsing didn't consume all input");
+      }
+      state_ = State::Ignore;
+      return data.size();
+    case State::String:
+    case State::Scalar:
+    case State::Ignore:
+      break;
+  }
+  assume_unreachable();
+}
+
+size_t stream_parser::startValue(StringPiece data) {
+  if (stack_.size() > opts_.recursion_limit) {
+    error(data, "recursion limit exceeded");
+  }
+  char c = data.front();
+  switch (c) {
+    case '[':
+      stack_.push_back(c);
+      state_ = State::FirstElement;
+      handler_.onArrayStart();
+      return 1;
+    case '{':
+      stack_.push_back(c);
+      state_ = State::FirstKey;
+      handler_.onObjectStart();
+      return 1;
+    case '\"':
+      key_ = false;
+      escape_ = false;
+      token_.assign(1, c);
+      tokenLineNum_ = lineNum_;
+      state_ = State::String;
+      return 1;
+  }
+  if (!isScalarChar(c)) {
+    error(data, "expected json value");
+  }
+  token_.clear();
+  tokenLineNum_ = lineNum_;
+  state_ = State::Scalar;
+  return 0;
+}
+
+void stream_parser::endValue() {
+  state_ = stack_.empty() ? State::Done : State::CommaOrEnd;
+}
+
+void stream_parser::endContainer() {
+  auto open = stack_.back();
+  stack_.pop_back();
+  if (open == '[') {
+    handler_.onArrayEnd();
+  } else {
+    handler_.onObjectEnd();
+  }
+  endValue();
+}
+
+void stream_parser::endString() {
+  Input in(token_, &opts_, tokenLineNum_);
+  auto str = parseString(in);
+  if (key_) {
+    state_ = State::Colon;
+    handler_.onKey(str);
+  } else {
+    endValue();
+    handler_.onString(str);
+  }
+}
+
+void stream_parser::endScalar() {
+  Input in(token_, &opts_, tokenLineNum_);
+  // clang-format off
+  dynamic value =
+      (*in == '-' || (*in >= '0' && *in <= '9')) ? parseNumber(in) :
+      in.consume("true") ? true :
+      in.consume("false") ? false :
+      in.consume("null") ? nullptr :
+      in.consume("Infinity") ?
+      (opts_.parse_numbers_as_strings ? (dynamic)"Infinity" :
+        (dynamic)std::numeric_limits<double>::infinity()) :
+      in.consume("NaN") ?
+        (opts_.parse_numbers_as_strings ? (dynamic)"NaN" :
+          (dynamic)std::numeric_limits<double>::quiet_NaN()) :
+      in.error("expected json value");
+  // clang-format on
+  endValue();
+  switch (value.type()) {
+    case dynamic::NULLT:
+      handler_.onNull();
+      break;
+    case dynamic::BOOL:
+      handler_.onBool(value.getBool());
+      break;
+    case dynamic::INT64:
+      handler_.onInt(value.getInt());
+      break;
+    case dynamic::DOUBLE:
+      handler_.onDouble(value.getDouble());
+      break;
+    case dynamic::STRING:
+      handler_.onString(value.stringPiece());
+      break;
+    case dynamic::ARRAY:
+    case dynamic::OBJECT:
+      assume_unreachable();
+  }
+  // what follows the value in the token, like the ".3" of "1.5.3", is
+  // reported as parseJson() would
+  std::string rest(in.begin(), in.size());
+  token_.clear();
+  feed(rest);
+}
+
+void stream_parser::error(StringPiece data, char const* what) const {
+  throw make_parse_error(
+      lineNum_, data.subpiece(0, 16 /* arbitrary */).str(), what);
+}
+
 } // namespace json
 
 //////////////////////////////////////////////////////////////////////
@@ -978,6 +1524,21 @@ dynamic parseJson(StringPiece range) {
   return parseJson(range, json::serialization_opts());
 }
 
+dynamic parseJson(IOBuf const& buf) {
+  return parseJson(buf, json::serialization_opts());
+}
+
+dynamic parseJson(IOBuf const& buf, json::serialization_opts const& opts) {
+  json::Input in(buf, &opts);
+
+  auto ret = parseValue(in, nullptr);
+  in.skipWhitespace();
+  if (in.size() && *in != '\0') {
+    in.error("parsing didn't consume all input");
+  }
+  return ret;
+}
+
 dynamic parseJson(StringPiece range, json::serialization_opts const& opts) {
   json::Input in(range, &opts);
 
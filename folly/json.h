@@ -40,8 +40,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 #include <folly/Function.h>
 #include <folly/Range.h>
@@ -49,6 +51,12 @@
 
 namespace folly {
 
+class IOBuf;
+class IOBufQueue;
+namespace io {
+class Appender;
+} // namespace io
+
 //////////////////////////////////////////////////////////////////////
 
 namespace json {
@@ -151,6 +159,19 @@ std::array<uint64_t, 2> buildExtraAsciiToEscapeBitmap(StringPiece chars);
  */
 std::string serialize(dynamic const&, serialization_opts const&);
 
+/*
+ * Same as above, except that the json is appended to an IOBufQueue, in
+ * buffers of growth bytes, or to an io::Appender, in the buffers it
+ * allocates.  This avoids copying large documents out of a string to
+ * send them.
+ */
+void serialize(
+    dynamic const&,
+    serialization_opts const&,
+    IOBufQueue& out,
+    std::size_t growth = 16 * 1024);
+void serialize(dynamic const&, serialization_opts const&, io::Appender& out);
+
 /*
  * Escape a string so that it is legal to print it in JSON text and
  * append the result to out.
@@ -188,6 +209,101 @@ struct parse_metadata {
 
 using metadata_map = std::unordered_map<dynamic const*, parse_metadata>;
 
+/*
+ * Receives the values of a document, in order, as a stream_parser (or
+ * bser::stream_parser) parses them.  Keys and strings are only valid
+ * during the call.
+ */
+class event_handler {
+ public:
+  virtual ~event_handler() = default;
+
+  virtual void onObjectStart() {}
+  // precedes the value of each item
+  virtual void onKey(StringPiece /* key */) {}
+  virtual void onObjectEnd() {}
+  virtual void onArrayStart() {}
+  virtual void onArrayEnd() {}
+  virtual void onString(StringPiece /* value */) {}
+  virtual void onInt(int64_t /* value */) {}
+  virtual void onDouble(double /* value */) {}
+  virtual void onBool(bool /* value */) {}
+  virtual void onNull() {}
+};
+
+/*
+ * Incremental json parser which reports the values of the document to an
+ * event_handler instead of building a dynamic.  Only the enclosing
+ * containers and the string or number being read are kept in memory, so
+ * documents of any size can be processed as they arrive.
+ *
+ * Accepts the same documents as parseJson(), with the same options (which
+ * must outlive the parser), except that object keys must be strings.
+ * Numbers parsed as strings are reported with onString().  The parser
+ * cannot be used anymore once it has thrown.
+ */
+class stream_parser {
+ public:
+  explicit stream_parser(event_handler& handler);
+  stream_parser(event_handler& handler, serialization_opts const& opts);
+
+  stream_parser(stream_parser const&) = delete;
+  stream_parser& operator=(stream_parser const&) = delete;
+
+  /*
+   * Parse the next part of the document, which may end anywhere.
+   */
+  void feed(StringPiece data);
+
+  /*
+   * Same as above, for all the data in the queue, which is then removed
+   * from it.
+   */
+  void feed(IOBufQueue& queue);
+
+  /*
+   * Signal the end of the document; throws parse_error if it is
+   * incomplete.
+   */
+  void finish();
+
+ private:
+  enum class State : uint8_t {
+    Value,
+    FirstElement,
+    NextElement,
+    FirstKey,
+    NextKey,
+    Colon,
+    CommaOrEnd,
+    String,
+    Scalar,
+    Done,
+    Ignore,
+  };
+
+  // returns the number of bytes of data used
+  size_t step(StringPiece data);
+  size_t startValue(StringPiece data);
+  void endValue();
+  void endContainer();
+  void endString();
+  void endScalar();
+  [[noreturn]] void error(StringPiece data, char const* what) const;
+
+  event_handler& handler_;
+  serialization_opts const& opts_;
+  State state_{State::Value};
+  // the containers being parsed, '[' or '{'
+  std::vector<char> stack_;
+  // the string (quotes included) or number being read
+  std::string token_;
+  bool key_{false};
+  bool escape_{false};
+  unsigned lineNum_{0};
+  unsigned tokenLineNum_{0};
+};
+
 } // namespace json
 
 //////////////////////////////////////////////////////////////////////
@@ -199,6 +315,13 @@ using metadata_map = std::unordered_map<dynamic const*, parse_metadata>;
 dynamic parseJson(StringPiece, json::serialization_opts const&);
 dynamic parseJson(StringPiece);
 
+/*
+ * Parse a json blob out of an IOBuf chain, which does not need to be
+ * coalesced first.
+ */
+dynamic parseJson(IOBuf const&, json::serialization_opts const&);
+dynamic parseJson(IOBuf const&);
+
 dynamic parseJsonWithMetadata(StringPiece range, json::metadata_map* map);
 dynamic parseJsonWithMetadata(
     StringPiece range,
@@ -0,0 +1,1192 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json_simd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/Portability.h>
+#include <folly/Unicode.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+#include <folly/portability/Constexpr.h>
+
+#include <glog/logging.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif FOLLY_SSE >= 2
+#include <emmintrin.h>
+#endif
+
+namespace folly {
+
+namespace json {
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////
+// Stage 1: structural characters
+
+constexpr size_t kBlockSize = 64;
+
+// Bit i of each mask is set if byte i of the block is...
+struct BlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+  // one of {}[]:,
+  uint64_t op;
+  uint64_t whitespace;
+};
+
+#if defined(__AVX2__)
+
+BlockMasks classify(const uint8_t* block) {
+  BlockMasks masks{0, 0, 0, 0};
+  for (size_t i = 0; i < kBlockSize; i += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+    auto eq = [&](__m256i w, char c) {
+      return _mm256_cmpeq_epi8(w, _mm256_set1_epi8(c));
+    };
+    auto bits = [](__m256i m) {
+      return uint64_t(uint32_t(_mm256_movemask_epi8(m)));
+    };
+    // [ and ] only differ from { and } by 0x20
+    auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    auto op = _mm256_or_si256(
+        _mm256_or_si256(eq(lower, '{'), eq(lower, '}')),
+        _mm256_or_si256(eq(v, ':'), eq(v, ',')));
+    auto ws = _mm256_or_si256(
+        _mm256_or_si256(eq(v, ' '), eq(v, '\t')),
+        _mm256_or_si256(eq(v, '\n'), eq(v, '\r')));
+    masks.quote |= bits(eq(v, '"')) << i;
+    masks.backslash |= bits(eq(v, '\\')) << i;
+    masks.op |= bits(op) << i;
+    masks.whitespace |= bits(ws) << i;
+  }
+  return masks;
+}
+
+#elif FOLLY_SSE >= 2
+
+BlockMasks classify(const uint8_t* block) {
+  BlockMasks masks{0, 0, 0, 0};
+  for (size_t i = 0; i < kBlockSize; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+    auto eq = [&](__m128i w, char c) {
+      return _mm_cmpeq_epi8(w, _mm_set1_epi8(c));
+    };
+    auto bits = [](__m128i m) {
+      return uint64_t(uint32_t(_mm_movemask_epi8(m)));
+    };
+    // [ and ] only differ from { and } by 0x20
+    auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    auto op = _mm_or_si128(
+        _mm_or_si128(eq(lower, '{'), eq(lower, '}')),
+        _mm_or_si128(eq(v, ':'), eq(v, ',')));
+    auto ws = _mm_or_si128(
+        _mm_or_si128(eq(v, ' '), eq(v, '\t')),
+        _mm_or_si128(eq(v, '\n'), eq(v, '\r')));
+    masks.quote |= bits(eq(v, '"')) << i;
+    masks.backslash |= bits(eq(v, '\\')) << i;
+    masks.op |= bits(op) << i;
+    masks.whitespace |= bits(ws) << i;
+  }
+  return masks;
+}
+
+#else
+
+BlockMasks classify(const uint8_t* block) {
+  BlockMasks masks{0, 0, 0, 0};
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    auto bit = uint64_t(1) << i;
+    switch (block[i]) {
+      case '"':
+        masks.quote |= bit;
+        break;
+      case '\\':
+        masks.backslash |= bit;
+        break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        masks.op |= bit;
+        break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        masks.whitespace |= bit;
+        break;
+    }
+  }
+  return masks;
+}
+
+#endif
+
+// Bit i of the result is the xor of bits 0 to i.
+uint64_t prefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// Appends the positions of the structural characters of json to out.
+// Returns false if json ends in a string.
+bool findStructurals(StringPiece json, std::vector<uint32_t>& out) {
+  auto data = reinterpret_cast<const uint8_t*>(json.data());
+  // whether the first byte of the next block is escaped
+  bool escapeCarry = false;
+  // all ones if the next block starts in a string
+  uint64_t stringCarry = 0;
+  // whether the last byte of the previous block is part of a scalar
+  uint64_t scalarCarry = 0;
+  uint8_t padded[kBlockSize];
+
+  out.reserve(out.size() + json.size() / 8);
+  for (size_t base = 0; base < json.size(); base += kBlockSize) {
+    const uint8_t* block = data + base;
+    if (json.size() - base < kBlockSize) {
+      memset(padded, ' ', kBlockSize);
+      memcpy(padded, block, json.size() - base);
+      block = padded;
+    }
+    auto masks = classify(block);
+
+    // Backslashes are rare enough to be handled one at a time.
+    uint64_t escaped = 0;
+    uint64_t backslash = masks.backslash;
+    if (escapeCarry) {
+      escaped = 1;
+      backslash &= ~uint64_t(1);
+    }
+    escapeCarry = false;
+    while (backslash) {
+      auto bit = size_t(findFirstSet(backslash) - 1);
+      if (bit == kBlockSize - 1) {
+        escapeCarry = true;
+        break;
+      }
+      escaped |= uint64_t(1) << (bit + 1);
+      backslash &= ~(uint64_t(3) << bit);
+    }
+
+    auto quotes = masks.quote & ~escaped;
+    // set from an opening quote to the byte before the closing one
+    auto inString = prefixXor(quotes) ^ stringCarry;
+    stringCarry = uint64_t(int64_t(inString) >> 63);
+
+    auto scalar = ~(masks.op | masks.whitespace | quotes | inString);
+    auto scalarStarts = scalar & ~((scalar << 1) | scalarCarry);
+    scalarCarry = scalar >> 63;
+
+    auto structural = ((masks.op & ~inString) | quotes | scalarStarts);
+    while (structural) {
+      out.push_back(uint32_t(base + findFirstSet(structural) - 1));
+      structural &= structural - 1;
+    }
+  }
+  return stringCarry == 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Stage 2: values
+
+[[noreturn]] void parseError(std::string const& what) {
+  throw_exception<parse_error>(to<std::string>("json parse error: ", what));
+}
+
+std::string decodeString(StringPiece str) {
+  if (str.find('\\') == StringPiece::npos &&
+      str.find('\0') == StringPiece::npos) {
+    return str.str();
+  }
+
+  auto readHex = [&]() -> uint16_t {
+    if (str.size() < 4) {
+      parseError("expected 4 hex digits");
+    }
+    uint16_t ret = 0;
+    for (size_t i = 0; i < 4; ++i) {
+      char c = str[i];
+      // clang-format off
+      ret = uint16_t(ret * 16 + (
+          c >= '0' && c <= '9' ? c - '0' :
+          c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+          c >= 'A' && c <= 'F' ? c - 'A' + 10 :
+          (parseError("invalid hex digit"), 0)));
+      // clang-format on
+    }
+    str.advance(4);
+    return ret;
+  };
+
+  std::string ret;
+  ret.reserve(str.size());
+  while (!str.empty()) {
+    char c = str.front();
+    str.pop_front();
+    if (c == '\0') {
+      parseError("null byte in string");
+    }
+    if (c != '\\') {
+      ret.push_back(c);
+      continue;
+    }
+    if (str.empty()) {
+      parseError("unterminated string");
+    }
+    c = str.front();
+    str.pop_front();
+    switch (c) {
+      // clang-format off
+      case '\"':    ret.push_back('\"'); break;
+      case '\\':    ret.push_back('\\'); break;
+      case '/':     ret.push_back('/');  break;
+      case 'b':     ret.push_back('\b'); break;
+      case 'f':     ret.push_back('\f'); break;
+      case 'n':     ret.push_back('\n'); break;
+      case 'r':     ret.push_back('\r'); break;
+      case 't':     ret.push_back('\t'); break;
+      // clang-format on
+      case 'u': {
+        uint32_t codePoint = readHex();
+        if (codePoint >= 0xd800 && codePoint <= 0xdbff) {
+          if (!str.removePrefix("\\u")) {
+            parseError(
+                "expected another unicode escape for second half of "
+                "surrogate pair");
+          }
+          uint16_t second = readHex();
+          if (second < 0xdc00 || second > 0xdfff) {
+            parseError("second character in surrogate pair is invalid");
+          }
+          codePoint =
+              0x10000 + ((codePoint & 0x3ff) << 10) + (second & 0x3ff);
+        } else if (codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+          parseError("invalid unicode code point (in range [0xdc00,0xdfff])");
+        }
+        ret += codePointToUtf8(codePoint);
+        break;
+      }
+      default:
+        parseError(to<std::string>("unknown escape ", c, " in string"));
+    }
+  }
+  return ret;
+}
+
+// Same grammar and conversions as parseNumber() in json.cpp, except that
+// the whole token must be a number.
+dynamic decodeNumber(StringPiece token, serialization_opts const& opts) {
+  bool const negative = token.front() == '-';
+  size_t length = negative ? 1 : 0;
+  while (length < token.size() && token[length] >= '0' &&
+         token[length] <= '9') {
+    ++length;
+  }
+  auto integral = token.subpiece(0, length);
+  if (negative && integral.size() < 2) {
+    parseError("expected digits after `-'");
+  }
+  auto rest = token.subpiece(length);
+
+  if (rest.empty()) {
+    constexpr const char* maxInt = "9223372036854775807";
+    constexpr const char* minInt = "-9223372036854775808";
+    constexpr auto maxIntLen = constexpr_strlen(maxInt);
+    constexpr auto minIntLen = constexpr_strlen(minInt);
+
+    if (opts.parse_numbers_as_strings) {
+      return integral;
+    }
+    if (LIKELY(!opts.double_fallback || integral.size() < maxIntLen) ||
+        (!negative && integral.size() == maxIntLen && integral <= maxInt) ||
+        (negative && integral.size() == minIntLen && integral <= minInt)) {
+      return to<int64_t>(integral);
+    }
+    return to<double>(integral);
+  }
+
+  auto skipDigits = [&] {
+    while (!rest.empty() && rest.front() >= '0' && rest.front() <= '9') {
+      rest.pop_front();
+    }
+  };
+  if (rest.front() == '.') {
+    rest.pop_front();
+    skipDigits();
+  } else if (rest.front() != 'e' && rest.front() != 'E') {
+    parseError("expected number");
+  }
+  if (!rest.empty() && (rest.front() == 'e' || rest.front() == 'E')) {
+    rest.pop_front();
+    if (!rest.empty() && (rest.front() == '+' || rest.front() == '-')) {
+      rest.pop_front();
+    }
+    skipDigits();
+  }
+  if (!rest.empty()) {
+    parseError("expected number");
+  }
+  if (opts.parse_numbers_as_strings) {
+    return token;
+  }
+  return to<double>(token);
+}
+
+dynamic decodeScalar(StringPiece token, serialization_opts const& opts) {
+  if (token == "true") {
+    return true;
+  } else if (token == "false") {
+    return false;
+  } else if (token == "null") {
+    return nullptr;
+  } else if (token == "Infinity" || token == "-Infinity" || token == "NaN") {
+    if (opts.parse_numbers_as_strings) {
+      return token;
+    }
+    return token == "NaN" ? std::numeric_limits<double>::quiet_NaN()
+                          : token.front() == '-'
+            ? -std::numeric_limits<double>::infinity()
+            : std::numeric_limits<double>::infinity();
+  } else if (token.front() == '-' || (token[0] >= '0' && token[0] <= '9')) {
+    return decodeNumber(token, opts);
+  }
+  parseError("expected json value");
+}
+
+bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// The number or literal whose first character is at begin.
+StringPiece scalarToken(StringPiece json, uint32_t begin, uint32_t next) {
+  auto end = begin;
+  while (end < next && !isWhitespace(json[end])) {
+    ++end;
+  }
+  return json.subpiece(begin, end - begin);
+}
+
+// Thrown by Builder on errors and on documents that are valid for
+// parseJson() but not supported here, for the caller to parse them with
+// parseJson() instead.
+struct Unsupported : std::exception {};
+
+// Builds values from the structural characters, following parseValue()
+// and friends in json.cpp.  The Handler makes the values:
+//
+//   Object beginObject();
+//   void addItem(Object&, StringPiece rawKey, Value);
+//   Value endObject(Object);
+//   Array beginArray();
+//   void addElement(Array&, Value);
+//   Value endArray(Array);
+//   Value makeString(StringPiece raw);
+//   Value makeScalar(StringPiece token);
+//
+// where raw strings are still escaped.
+template <class Handler>
+class Builder {
+ public:
+  using Value = typename Handler::Value;
+
+  Builder(
+      StringPiece json,
+      std::vector<uint32_t> const& structurals,
+      serialization_opts const& opts,
+      Handler& handler)
+      : json_(json),
+        structurals_(structurals),
+        opts_(opts),
+        handler_(handler) {}
+
+  // EOF past the last structural character
+  int peek(uint32_t index) const {
+    return index + 1 < structurals_.size()
+        ? static_cast<unsigned char>(json_[structurals_[index]])
+        : EOF;
+  }
+
+  Value parseValue(uint32_t& index, unsigned depth) {
+    if (depth > opts_.recursion_limit) {
+      throw Unsupported();
+    }
+    switch (peek(index)) {
+      case '{':
+        return parseObject(index, depth);
+      case '[':
+        return parseArray(index, depth);
+      case '"':
+        return handler_.makeString(parseString(index));
+      case '}':
+      case ']':
+      case ':':
+      case ',':
+      case EOF:
+        throw Unsupported();
+      default:
+        auto token = scalarToken(
+            json_, structurals_[index], structurals_[index + 1]);
+        ++index;
+        return handler_.makeScalar(token);
+    }
+  }
+
+ private:
+  Value parseObject(uint32_t& index, unsigned depth) {
+    ++index;
+    auto ret = handler_.beginObject();
+    if (peek(index) == '}') {
+      ++index;
+      return handler_.endObject(std::move(ret));
+    }
+    for (;;) {
+      if (opts_.allow_trailing_comma && peek(index) == '}') {
+        break;
+      }
+      // non-string keys are left to parseJson()
+      if (peek(index) != '"') {
+        throw Unsupported();
+      }
+      auto key = parseString(index);
+      if (peek(index) != ':') {
+        throw Unsupported();
+      }
+      ++index;
+      handler_.addItem(ret, key, parseValue(index, depth + 1));
+      if (peek(index) != ',') {
+        break;
+      }
+      ++index;
+    }
+    if (peek(index) != '}') {
+      throw Unsupported();
+    }
+    ++index;
+    return handler_.endObject(std::move(ret));
+  }
+
+  Value parseArray(uint32_t& index, unsigned depth) {
+    ++index;
+    auto ret = handler_.beginArray();
+    if (peek(index) == ']') {
+      ++index;
+      return handler_.endArray(std::move(ret));
+    }
+    for (;;) {
+      if (opts_.allow_trailing_comma && peek(index) == ']') {
+        break;
+      }
+      handler_.addElement(ret, parseValue(index, depth + 1));
+      if (peek(index) != ',') {
+        break;
+      }
+      ++index;
+    }
+    if (peek(index) != ']') {
+      throw Unsupported();
+    }
+    ++index;
+    return handler_.endArray(std::move(ret));
+  }
+
+  StringPiece parseString(uint32_t& index) {
+    // the closing quote is always the next structural character
+    DCHECK_EQ('"', peek(index + 1));
+    auto begin = structurals_[index] + 1;
+    auto end = structurals_[index + 1];
+    index += 2;
+    return json_.subpiece(begin, end - begin);
+  }
+
+  StringPiece json_;
+  std::vector<uint32_t> const& structurals_;
+  serialization_opts const& opts_;
+  Handler& handler_;
+};
+
+class DynamicHandler {
+ public:
+  using Value = dynamic;
+  using Object = dynamic;
+  using Array = dynamic;
+
+  explicit DynamicHandler(serialization_opts const& opts) : opts_(opts) {}
+
+  dynamic beginObject() {
+    return dynamic::object;
+  }
+  void addItem(dynamic& object, StringPiece key, dynamic value) {
+    object.insert(decodeString(key), std::move(value));
+  }
+  dynamic endObject(dynamic object) {
+    return object;
+  }
+
+  dynamic beginArray() {
+    return dynamic::array;
+  }
+  void addElement(dynamic& array, dynamic value) {
+    array.push_back(std::move(value));
+  }
+  dynamic endArray(dynamic array) {
+    return array;
+  }
+
+  dynamic makeString(StringPiece str) {
+    return decodeString(str);
+  }
+  dynamic makeScalar(StringPiece token) {
+    return decodeScalar(token, opts_);
+  }
+
+ private:
+  serialization_opts const& opts_;
+};
+
+} // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+lazy_document::lazy_document(StringPiece json) : json_(json) {
+  if (json.size() >= std::numeric_limits<uint32_t>::max()) {
+    throw_exception<std::length_error>("json document too large");
+  }
+  if (!findStructurals(json, structurals_)) {
+    parseError("unterminated string");
+  }
+  if (structurals_.empty()) {
+    parseError("expected json value");
+  }
+  structurals_.push_back(uint32_t(json.size()));
+
+  closing_.resize(structurals_.size());
+  std::vector<uint32_t> open;
+  for (uint32_t i = 0; i + 1 < structurals_.size(); ++i) {
+    char c = json[structurals_[i]];
+    if (c == '{' || c == '[') {
+      open.push_back(i);
+    } else if (c == '}' || c == ']') {
+      // } and ] follow { and [ by 2
+      if (open.empty() || json[structurals_[open.back()]] + 2 != c) {
+        parseError("unbalanced brackets");
+      }
+      closing_[open.back()] = i;
+      open.pop_back();
+    }
+  }
+  if (!open.empty()) {
+    parseError("unbalanced brackets");
+  }
+
+  auto end = root().valueEnd(0);
+  if (end + 1 != structurals_.size() && json[structurals_[end]] != '\0') {
+    parseError("parsing didn't consume all input");
+  }
+}
+
+lazy_value lazy_document::root() const {
+  return lazy_value(this, 0);
+}
+
+char lazy_value::token(uint32_t index) const {
+  return index + 1 < doc_->structurals_.size()
+      ? doc_->json_[doc_->structurals_[index]]
+      : '\0';
+}
+
+dynamic::Type lazy_value::type() const {
+  switch (token(index_)) {
+    case '{':
+      return dynamic::OBJECT;
+    case '[':
+      return dynamic::ARRAY;
+    case '"':
+      return dynamic::STRING;
+    case 't':
+    case 'f':
+      return dynamic::BOOL;
+    case 'n':
+      return dynamic::NULLT;
+    default:
+      auto text = raw();
+      return text.find_first_of(".eEIN") != StringPiece::npos
+          ? dynamic::DOUBLE
+          : dynamic::INT64;
+  }
+}
+
+bool lazy_value::isObject() const {
+  return token(index_) == '{';
+}
+
+bool lazy_value::isArray() const {
+  return token(index_) == '[';
+}
+
+bool lazy_value::isString() const {
+  return token(index_) == '"';
+}
+
+bool lazy_value::isNull() const {
+  return raw() == "null";
+}
+
+std::string lazy_value::asString() const {
+  if (!isString()) {
+    throw_exception<TypeError>("string", type());
+  }
+  return key(index_);
+}
+
+int64_t lazy_value::asInt() const {
+  if (type() != dynamic::INT64) {
+    throw_exception<TypeError>("int64", type());
+  }
+  return decodeScalar(raw(), serialization_opts()).getInt();
+}
+
+double lazy_value::asDouble() const {
+  auto t = type();
+  if (t != dynamic::DOUBLE && t != dynamic::INT64) {
+    throw_exception<TypeError>("double", t);
+  }
+  auto value = decodeScalar(raw(), serialization_opts());
+  return value.isInt() ? double(value.getInt()) : value.getDouble();
+}
+
+bool lazy_value::asBool() const {
+  if (type() != dynamic::BOOL) {
+    throw_exception<TypeError>("boolean", type());
+  }
+  return decodeScalar(raw(), serialization_opts()).getBool();
+}
+
+void lazy_value::expectContainer(char open) const {
+  if (token(index_) != open) {
+    throw_exception<TypeError>(open == '{' ? "object" : "array", type());
+  }
+}
+
+uint32_t lazy_value::firstChild() const {
+  return index_ + 1;
+}
+
+uint32_t lazy_value::valueEnd(uint32_t index) const {
+  switch (token(index)) {
+    case '{':
+    case '[':
+      return doc_->closing_[index] + 1;
+    case '"':
+      return index + 2;
+    case '}':
+    case ']':
+    case ':':
+    case ',':
+    case '\0':
+      parseError("expected json value");
+    default:
+      return index + 1;
+  }
+}
+
+void lazy_value::expectKey(uint32_t index) const {
+  if (token(index) != '"') {
+    parseError("expected string for object key name");
+  }
+  if (token(index + 2) != ':') {
+    parseError("expected ':'");
+  }
+}
+
+uint32_t lazy_value::nextChild(uint32_t index) const {
+  auto close = doc_->closing_[index_];
+  uint32_t end;
+  if (token(index_) == '{') {
+    expectKey(index);
+    end = valueEnd(index + 3);
+  } else {
+    end = valueEnd(index);
+  }
+  if (end == close) {
+    return end;
+  }
+  if (token(end) != ',') {
+    parseError("expected ',' or closing bracket");
+  }
+  if (end + 1 == close) {
+    parseError("trailing comma");
+  }
+  return end + 1;
+}
+
+std::string lazy_value::key(uint32_t index) const {
+  auto begin = doc_->structurals_[index] + 1;
+  auto end = doc_->structurals_[index + 1];
+  return decodeString(doc_->json_.subpiece(begin, end - begin));
+}
+
+std::size_t lazy_value::size() const {
+  if (!isObject() && !isArray()) {
+    throw_exception<TypeError>("object/array", type());
+  }
+  auto close = doc_->closing_[index_];
+  size_t count = 0;
+  for (auto i = firstChild(); i != close; i = nextChild(i)) {
+    ++count;
+  }
+  return count;
+}
+
+lazy_value lazy_value::operator[](std::size_t index) const {
+  expectContainer('[');
+  auto close = doc_->closing_[index_];
+  for (auto i = firstChild(); i != close; i = nextChild(i)) {
+    if (index-- == 0) {
+      return lazy_value(doc_, i);
+    }
+  }
+  throw_exception<std::out_of_range>("json array index out of range");
+}
+
+Optional<lazy_value> lazy_value::find(StringPiece key) const {
+  expectContainer('{');
+  auto close = doc_->closing_[index_];
+  for (auto i = firstChild(); i != close; i = nextChild(i)) {
+    expectKey(i);
+    auto begin = doc_->structurals_[i] + 1;
+    auto raw = doc_->json_.subpiece(begin, doc_->structurals_[i + 1] - begin);
+    if (raw.find('\\') == StringPiece::npos ? raw == key
+                                            : decodeString(raw) == key) {
+      return lazy_value(doc_, i + 3);
+    }
+  }
+  return none;
+}
+
+lazy_value lazy_value::operator[](StringPiece key) const {
+  auto value = find(key);
+  if (!value) {
+    throw_exception<std::out_of_range>(
+        to<std::string>("couldn't find key ", key, " in json object"));
+  }
+  return *value;
+}
+
+StringPiece lazy_value::raw() const {
+  auto& structurals = doc_->structurals_;
+  auto begin = structurals[index_];
+  switch (token(index_)) {
+    case '{':
+    case '[':
+      return doc_->json_.subpiece(
+          begin, structurals[doc_->closing_[index_]] + 1 - begin);
+    case '"':
+      return doc_->json_.subpiece(begin, structurals[index_ + 1] + 1 - begin);
+    default:
+      return scalarToken(doc_->json_, begin, structurals[index_ + 1]);
+  }
+}
+
+dynamic lazy_value::toDynamic() const {
+  return toDynamic(serialization_opts());
+}
+
+dynamic lazy_value::toDynamic(serialization_opts const& opts) const {
+  try {
+    DynamicHandler handler(opts);
+    Builder<DynamicHandler> builder(
+        doc_->json_, doc_->structurals_, opts, handler);
+    auto index = index_;
+    auto ret = builder.parseValue(index, 0);
+    if (index == valueEnd(index_)) {
+      return ret;
+    }
+  } catch (std::bad_alloc const&) {
+    throw;
+  } catch (std::exception const&) {
+    // parseJson() throws the error, or handles the value
+  }
+  return parseJson(raw(), opts);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+constexpr std::size_t arena_value::kLinearLookup;
+
+StringPiece arena_value::asString() const {
+  if (type_ != dynamic::STRING) {
+    throw_exception<TypeError>("string", type_);
+  }
+  return StringPiece(string_, size_);
+}
+
+int64_t arena_value::asInt() const {
+  if (type_ != dynamic::INT64) {
+    throw_exception<TypeError>("int64", type_);
+  }
+  return int_;
+}
+
+double arena_value::asDouble() const {
+  if (type_ == dynamic::INT64) {
+    return double(int_);
+  }
+  if (type_ != dynamic::DOUBLE) {
+    throw_exception<TypeError>("double", type_);
+  }
+  return double_;
+}
+
+bool arena_value::asBool() const {
+  if (type_ != dynamic::BOOL) {
+    throw_exception<TypeError>("boolean", type_);
+  }
+  return bool_;
+}
+
+std::size_t arena_value::size() const {
+  if (type_ != dynamic::ARRAY && type_ != dynamic::OBJECT &&
+      type_ != dynamic::STRING) {
+    throw_exception<TypeError>("array/object/string", type_);
+  }
+  return size_;
+}
+
+arena_value const& arena_value::operator[](std::size_t index) const {
+  auto array = elements();
+  if (index >= array.size()) {
+    throw_exception<std::out_of_range>("json array index out of range");
+  }
+  return array[index];
+}
+
+arena_value const& arena_value::operator[](StringPiece key) const {
+  auto value = get_ptr(key);
+  if (!value) {
+    throw_exception<std::out_of_range>(
+        to<std::string>("couldn't find key ", key, " in json object"));
+  }
+  return *value;
+}
+
+arena_value const* arena_value::get_ptr(StringPiece key) const {
+  auto all = items();
+  if (all.size() <= kLinearLookup) {
+    for (auto it = all.end(); it != all.begin();) {
+      if ((--it)->key == key) {
+        return &it->value;
+      }
+    }
+    return nullptr;
+  }
+  // sorted by key, then by position
+  auto sorted = reinterpret_cast<uint32_t const*>(all.end());
+  auto it = std::upper_bound(
+      sorted, sorted + all.size(), key, [&](StringPiece k, uint32_t i) {
+        return k < all[i].key;
+      });
+  if (it == sorted || all[*(it - 1)].key != key) {
+    return nullptr;
+  }
+  return &all[*(it - 1)].value;
+}
+
+Range<arena_value const*> arena_value::elements() const {
+  if (type_ != dynamic::ARRAY) {
+    throw_exception<TypeError>("array", type_);
+  }
+  return Range<arena_value const*>(elements_, size_);
+}
+
+Range<arena_item const*> arena_value::items() const {
+  if (type_ != dynamic::OBJECT) {
+    throw_exception<TypeError>("object", type_);
+  }
+  return Range<arena_item const*>(items_, size_);
+}
+
+dynamic arena_value::toDynamic() const {
+  switch (type_) {
+    case dynamic::NULLT:
+      return nullptr;
+    case dynamic::BOOL:
+      return bool_;
+    case dynamic::INT64:
+      return int_;
+    case dynamic::DOUBLE:
+      return double_;
+    case dynamic::STRING:
+      return asString();
+    case dynamic::ARRAY: {
+      dynamic ret = dynamic::array;
+      for (auto& element : elements()) {
+        ret.push_back(element.toDynamic());
+      }
+      return ret;
+    }
+    case dynamic::OBJECT: {
+      dynamic ret = dynamic::object;
+      for (auto& item : items()) {
+        ret.insert(item.key, item.value.toDynamic());
+      }
+      return ret;
+    }
+  }
+  assume_unreachable();
+}
+
+// Builds the values in the arena.  Elements and items are collected on
+// shared stacks, and copied to the arena once their container is done.
+class arena_document::Handler {
+ public:
+  using Value = arena_value;
+  using Object = size_t;
+  using Array = size_t;
+
+  Handler(SysArena& arena, serialization_opts const& opts)
+      : arena_(arena), opts_(opts) {}
+
+  size_t beginObject() {
+    return items_.size();
+  }
+  void addItem(size_t, StringPiece key, arena_value value) {
+    items_.push_back({copyString(key), value});
+  }
+  arena_value endObject(size_t begin) {
+    auto count = items_.size() - begin;
+    checkSize(count);
+    arena_value ret;
+    ret.type_ = dynamic::OBJECT;
+    ret.size_ = uint32_t(count);
+    bool indexed = count > arena_value::kLinearLookup;
+    auto bytes = count * sizeof(arena_item) +
+        (indexed ? count * sizeof(uint32_t) : 0);
+    auto items = static_cast<arena_item*>(allocate(bytes));
+    std::uninitialized_copy(items_.begin() + begin, items_.end(), items);
+    items_.resize(begin);
+    if (indexed) {
+      auto sorted = reinterpret_cast<uint32_t*>(items + count);
+      for (uint32_t i = 0; i < count; ++i) {
+        sorted[i] = i;
+      }
+      std::sort(sorted, sorted + count, [&](uint32_t a, uint32_t b) {
+        return items[a].key < items[b].key ||
+            (items[a].key == items[b].key && a < b);
+      });
+    }
+    ret.items_ = items;
+    return ret;
+  }
+
+  size_t beginArray() {
+    return elements_.size();
+  }
+  void addElement(size_t, arena_value value) {
+    elements_.push_back(value);
+  }
+  arena_value endArray(size_t begin) {
+    auto count = elements_.size() - begin;
+    checkSize(count);
+    arena_value ret;
+    ret.type_ = dynamic::ARRAY;
+    ret.size_ = uint32_t(count);
+    auto elements =
+        static_cast<arena_value*>(allocate(count * sizeof(arena_value)));
+    std::uninitialized_copy(
+        elements_.begin() + begin, elements_.end(), elements);
+    elements_.resize(begin);
+    ret.elements_ = elements;
+    return ret;
+  }
+
+  arena_value makeString(StringPiece str) {
+    return fromString(copyString(str));
+  }
+
+  arena_value makeScalar(StringPiece token) {
+    return fromDynamic(decodeScalar(token, opts_));
+  }
+
+  arena_value fromDynamic(dynamic const& value) {
+    arena_value ret;
+    switch (value.type()) {
+      case dynamic::NULLT:
+        break;
+      case dynamic::BOOL:
+        ret.type_ = dynamic::BOOL;
+        ret.bool_ = value.getBool();
+        break;
+      case dynamic::INT64:
+        ret.type_ = dynamic::INT64;
+        ret.int_ = value.getInt();
+        break;
+      case dynamic::DOUBLE:
+        ret.type_ = dynamic::DOUBLE;
+        ret.double_ = value.getDouble();
+        break;
+      case dynamic::STRING:
+        ret = fromString(storeString(value.stringPiece()));
+        break;
+      case dynamic::ARRAY: {
+        auto begin = beginArray();
+        for (auto& element : value) {
+          addElement(begin, fromDynamic(element));
+        }
+        ret = endArray(begin);
+        break;
+      }
+      case dynamic::OBJECT: {
+        auto begin = beginObject();
+        for (auto& item : value.items()) {
+          if (!item.first.isString()) {
+            throw_exception<TypeError>("string", item.first.type());
+          }
+          items_.push_back(
+              {storeString(item.first.stringPiece()),
+               fromDynamic(item.second)});
+        }
+        ret = endObject(begin);
+        break;
+      }
+    }
+    return ret;
+  }
+
+ private:
+  void* allocate(size_t bytes) {
+    // the arena does not support empty allocations
+    return arena_.allocate(std::max<size_t>(bytes, 1));
+  }
+
+  static void checkSize(size_t size) {
+    if (size >= std::numeric_limits<uint32_t>::max()) {
+      throw_exception<std::length_error>("json value too large");
+    }
+  }
+
+  arena_value fromString(StringPiece str) {
+    checkSize(str.size());
+    arena_value ret;
+    ret.type_ = dynamic::STRING;
+    ret.size_ = uint32_t(str.size());
+    ret.string_ = str.data();
+    return ret;
+  }
+
+  // copies an escaped string from the document
+  StringPiece copyString(StringPiece str) {
+    if (str.find('\\') == StringPiece::npos &&
+        str.find('\0') == StringPiece::npos) {
+      return storeString(str);
+    }
+    return storeString(decodeString(str));
+  }
+
+  StringPiece storeString(StringPiece str) {
+    auto data = static_cast<char*>(allocate(str.size()));
+    memcpy(data, str.data(), str.size());
+    return StringPiece(data, str.size());
+  }
+
+  SysArena& arena_;
+  serialization_opts const& opts_;
+  std::vector<arena_value> elements_;
+  std::vector<arena_item> items_;
+};
+
+arena_document::arena_document(StringPiece json)
+    : arena_document(json, serialization_opts()) {}
+
+arena_document::arena_document(
+    StringPiece json,
+    serialization_opts const& opts) {
+  Handler handler(arena_, opts);
+  if (json.size() < std::numeric_limits<uint32_t>::max()) {
+    try {
+      std::vector<uint32_t> structurals;
+      if (findStructurals(json, structurals)) {
+        structurals.push_back(uint32_t(json.size()));
+        Builder<Handler> builder(json, structurals, opts, handler);
+        uint32_t index = 0;
+        auto root = builder.parseValue(index, 0);
+        // like parseJson(), ignore anything after a null byte
+        auto next = builder.peek(index);
+        if (next == EOF || next == '\0') {
+          root_ = root;
+          return;
+        }
+      }
+    } catch (std::bad_alloc const&) {
+      throw;
+    } catch (std::exception const&) {
+      // parseJson() throws the error, or handles the document
+    }
+  }
+  root_ = handler.fromDynamic(parseJson(json, opts));
+}
+
+} // namespace json
+
+dynamic parseJsonSimd(StringPiece json, json::serialization_opts const& opts) {
+  if (json.size() >= std::numeric_limits<uint32_t>::max()) {
+    return parseJson(json, opts);
+  }
+  try {
+    std::vector<uint32_t> structurals;
+    if (json::findStructurals(json, structurals)) {
+      structurals.push_back(uint32_t(json.size()));
+      json::DynamicHandler handler(opts);
+      json::Builder<json::DynamicHandler> builder(
+          json, structurals, opts, handler);
+      uint32_t index = 0;
+      auto ret = builder.parseValue(index, 0);
+      // like parseJson(), ignore anything after a null byte
+      auto next = builder.peek(index);
+      if (next == EOF || next == '\0') {
+        return ret;
+      }
+    }
+  } catch (std::bad_alloc const&) {
+    throw;
+  } catch (std::exception const&) {
+    // parseJson() throws the error, or handles the document
+  }
+  return parseJson(json, opts);
+}
+
+dynamic parseJsonSimd(StringPiece json) {
+  return parseJsonSimd(json, json::serialization_opts());
+}
+
+} // namespace folly
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Two-stage json parser.
+ *
+ * The first stage finds the structural characters of the whole document
+ * ({}[]:, and the quotes outside of strings, and the first character of
+ * each number or literal) 64 bytes at a time, with AVX2 or SSE2 when the
+ * build targets them.  The second stage then either builds a dynamic from
+ * these positions, builds an arena_document, or navigates them lazily so
+ * that only the values that are used are ever decoded.
+ *
+ * parseJsonSimd() accepts the same documents as parseJson() and produces
+ * the same values and errors: documents it does not handle itself are
+ * handed over to parseJson().
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+#include <folly/memory/Arena.h>
+
+namespace folly {
+
+dynamic parseJsonSimd(StringPiece, json::serialization_opts const&);
+dynamic parseJsonSimd(StringPiece);
+
+namespace json {
+
+class lazy_value;
+
+/*
+ * Index of a json document, which must outlive it, for reading values
+ * without materializing the rest of the document.
+ *
+ * The constructor only checks that strings are terminated and brackets
+ * balanced; other syntax errors are found, and thrown as parse_error, by
+ * the accessors of the values they are in.
+ */
+class lazy_document {
+ public:
+  explicit lazy_document(StringPiece json);
+
+  lazy_value root() const;
+
+ private:
+  friend class lazy_value;
+
+  StringPiece json_;
+  // positions of the structural characters, followed by json_.size()
+  std::vector<uint32_t> structurals_;
+  // for each opening bracket, the index of the closing one
+  std::vector<uint32_t> closing_;
+};
+
+/*
+ * A value of a lazy_document, with an interface similar to dynamic's.
+ * Accessors throw TypeError when the value has another type.
+ */
+class lazy_value {
+ public:
+  /*
+   * The type of the value; numbers are INT64 or DOUBLE depending on how
+   * they are written.
+   */
+  dynamic::Type type() const;
+
+  bool isObject() const;
+  bool isArray() const;
+  bool isString() const;
+  bool isNull() const;
+
+  std::string asString() const;
+  int64_t asInt() const;
+  double asDouble() const;
+  bool asBool() const;
+
+  /*
+   * Number of elements of an array or items of an object. Linear in the
+   * number of elements, which are skipped over but not decoded.
+   */
+  std::size_t size() const;
+
+  /*
+   * Array element;  throws std::out_of_range if there is none.
+   */
+  lazy_value operator[](std::size_t index) const;
+
+  /*
+   * Object item; the first one if the key is repeated.  Throws
+   * std::out_of_range if there is none.
+   */
+  lazy_value operator[](StringPiece key) const;
+  Optional<lazy_value> find(StringPiece key) const;
+
+  /*
+   * Invoke f(lazy_value) on every element of an array.
+   */
+  template <class F>
+  void forEachElement(F&& f) const;
+
+  /*
+   * Invoke f(std::string key, lazy_value) on every item of an object.
+   */
+  template <class F>
+  void forEachItem(F&& f) const;
+
+  /*
+   * Decode the value and everything it contains.
+   */
+  dynamic toDynamic() const;
+  dynamic toDynamic(serialization_opts const& opts) const;
+
+  /*
+   * The json text of the value.
+   */
+  StringPiece raw() const;
+
+ private:
+  friend class lazy_document;
+
+  lazy_value(lazy_document const* doc, uint32_t index)
+      : doc_(doc), index_(index) {}
+
+  char token(uint32_t index) const;
+  void expectContainer(char open) const;
+  // index of the first element or item, or of the closing bracket
+  uint32_t firstChild() const;
+  // index of the element or item after the one at index, or of the
+  // closing bracket
+  uint32_t nextChild(uint32_t index) const;
+  uint32_t valueEnd(uint32_t index) const;
+  std::string key(uint32_t index) const;
+  void expectKey(uint32_t index) const;
+
+  lazy_document const* doc_;
+  uint32_t index_;
+};
+
+template <class F>
+void lazy_value::forEachElement(F&& f) const {
+  expectContainer('[');
+  auto close = doc_->closing_[index_];
+  for (auto i = firstChild(); i != close; i = nextChild(i)) {
+    f(lazy_value(doc_, i));
+  }
+}
+
+template <class F>
+void lazy_value::forEachItem(F&& f) const {
+  expectContainer('{');
+  auto close = doc_->closing_[index_];
+  for (auto i = firstChild(); i != close; i = nextChild(i)) {
+    expectKey(i);
+    f(key(i), lazy_value(doc_, i + 3));
+  }
+}
+
+struct arena_item;
+
+/*
+ * A value of an arena_document, with an interface similar to dynamic's.
+ * Accessors throw TypeError when the value has another type.
+ */
+class arena_value {
+ public:
+  dynamic::Type type() const {
+    return type_;
+  }
+
+  bool isObject() const {
+    return type_ == dynamic::OBJECT;
+  }
+  bool isArray() const {
+    return type_ == dynamic::ARRAY;
+  }
+  bool isString() const {
+    return type_ == dynamic::STRING;
+  }
+  bool isNull() const {
+    return type_ == dynamic::NULLT;
+  }
+
+  /*
+   * Points into the arena of the document.
+   */
+  StringPiece asString() const;
+  int64_t asInt() const;
+  // also converts integers
+  double asDouble() const;
+  bool asBool() const;
+
+  /*
+   * Number of elements of an array, items of an object or bytes of a
+   * string.
+   */
+  std::size_t size() const;
+
+  /*
+   * Array element;  throws std::out_of_range if there is none.
+   */
+  arena_value const& operator[](std::size_t index) const;
+
+  /*
+   * Object item; the last one if the key is repeated, as in a dynamic.
+   * Throws std::out_of_range if there is none.
+   */
+  arena_value const& operator[](StringPiece key) const;
+  arena_value const* get_ptr(StringPiece key) const;
+
+  Range<arena_value const*> elements() const;
+
+  /*
+   * The items of an object, in document order and including repeated
+   * keys.
+   */
+  Range<arena_item const*> items() const;
+
+  dynamic toDynamic() const;
+
+ private:
+  friend class arena_document;
+
+  static constexpr std::size_t kLinearLookup = 16;
+
+  dynamic::Type type_{dynamic::NULLT};
+  // of strings, arrays and objects
+  uint32_t size_{0};
+  union {
+    bool bool_;
+    int64_t int_{0};
+    double double_;
+    char const* string_;
+    arena_value const* elements_;
+    // followed by the indexes of the items sorted by key, for objects
+    // with more than kLinearLookup items
+    arena_item const* items_;
+  };
+};
+
+struct arena_item {
+  StringPiece key;
+  arena_value value;
+};
+
+/*
+ * A parsed json document whose values are all allocated in a SysArena,
+ * which makes building it cheap and destroying it O(1) in the number of
+ * values.  Values are immutable.
+ *
+ * Accepts the same documents as parseJson(), except that object keys must
+ * be strings.
+ */
+class arena_document {
+ public:
+  explicit arena_document(StringPiece json);
+  arena_document(StringPiece json, serialization_opts const& opts);
+
+  arena_document(arena_document const&) = delete;
+  arena_document& operator=(arena_document const&) = delete;
+
+  arena_value const& root() const {
+    return root_;
+  }
+
+  /*
+   * Memory used by the values, including unused space at the end of the
+   * arena's blocks.
+   */
+  std::size_t totalSize() const {
+    return arena_.totalSize();
+  }
+
+ private:
+  class Handler;
+
+  SysArena arena_;
+  arena_value root_;
+};
+
+} // namespace json
+
+} // namespace folly
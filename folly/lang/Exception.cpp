@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+// libstdc++'s exception_ptr is a pointer to the thrown object, which is
+// preceded by its __cxa_exception header; __cxa_exception_type() reads the
+// type from the header, and type_info::__do_catch() is the same matching the
+// personality routine does when looking for a handler.
+#if defined(__GLIBCXX__) && FOLLY_HAS_RTTI
+
+std::type_info const* exception_ptr_get_type(
+    std::exception_ptr const& ptr) noexcept {
+  return ptr ? ptr.__cxa_exception_type() : nullptr;
+}
+
+void* exception_ptr_get_object(
+    std::exception_ptr const& ptr,
+    std::type_info const* target) noexcept {
+  auto type = exception_ptr_get_type(ptr);
+  if (!type) {
+    return nullptr;
+  }
+  auto object = reinterpret_cast<void* const&>(ptr);
+  if (target && !target->__do_catch(type, &object, 1)) {
+    return nullptr;
+  }
+  return object;
+}
+
+#else
+
+std::type_info const* exception_ptr_get_type(
+    std::exception_ptr const&) noexcept {
+  return nullptr;
+}
+
+void* exception_ptr_get_object(
+    std::exception_ptr const&,
+    std::type_info const*) noexcept {
+  return nullptr;
+}
+
+#endif
+
+} // namespace folly
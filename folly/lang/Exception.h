@@ -18,6 +18,7 @@
 
 #include <exception>
 #include <type_traits>
+#include <typeinfo>
 #include <utility>
 
 #include <folly/CPortability.h>
@@ -237,4 +238,31 @@ FOLLY_ERASE_TRYCATCH auto catch_exception(Try&& t, Catch&& c, CatchA&&... a) ->
 #endif
 }
 
+/// exception_ptr_get_type
+///
+/// Returns the type of the object held by the exception_ptr, without
+/// rethrowing it. Returns nullptr if the exception_ptr is empty, or if the
+/// type cannot be found without rethrowing on this platform (only the
+/// libstdc++ implementation of the Itanium C++ ABI is supported).
+std::type_info const* exception_ptr_get_type(
+    std::exception_ptr const& ptr) noexcept;
+
+/// exception_ptr_get_object
+///
+/// Returns a pointer to the object held by the exception_ptr if a handler
+/// for `target` would catch it, adjusted to the `target` subobject, or the
+/// unadjusted object if `target` is nullptr. Returns nullptr otherwise, and
+/// also whenever exception_ptr_get_type() does.
+///
+/// `target` must not be a pointer type.
+void* exception_ptr_get_object(
+    std::exception_ptr const& ptr,
+    std::type_info const* target) noexcept;
+
+template <typename T>
+T* exception_ptr_get_object(std::exception_ptr const& ptr) noexcept {
+  static_assert(!std::is_pointer<T>::value, "T must not be a pointer type");
+  return static_cast<T*>(exception_ptr_get_object(ptr, &typeid(T)));
+}
+
 } // namespace folly
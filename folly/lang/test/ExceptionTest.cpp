@@ -115,3 +115,46 @@ TEST_F(ExceptionTest, catch_exception) {
   EXPECT_EQ(4, folly::catch_exception(thrower(3), returner(4)));
   EXPECT_EQ(3, folly::catch_exception<int>(thrower(3), identity));
 }
+
+namespace {
+struct Base1 {
+  int b1 = 1;
+};
+struct Base2 {
+  int b2 = 2;
+};
+struct Derived : Base1, Base2 {};
+} // namespace
+
+TEST_F(ExceptionTest, exception_ptr_get_type_and_object) {
+  EXPECT_EQ(nullptr, folly::exception_ptr_get_type({}));
+  EXPECT_EQ(nullptr, folly::exception_ptr_get_object<int>({}));
+
+  auto ex = std::make_exception_ptr(std::runtime_error("foo"));
+  auto num = std::make_exception_ptr(12);
+  auto derived = std::make_exception_ptr(Derived{});
+  if (!folly::kIsGlibcxx || !folly::kHasRtti) {
+    EXPECT_EQ(nullptr, folly::exception_ptr_get_type(ex));
+    EXPECT_EQ(nullptr, folly::exception_ptr_get_object<std::exception>(ex));
+    return;
+  }
+
+  EXPECT_TRUE(typeid(std::runtime_error) == *folly::exception_ptr_get_type(ex));
+  auto stdex = folly::exception_ptr_get_object<std::exception>(ex);
+  ASSERT_NE(nullptr, stdex);
+  EXPECT_STREQ("foo", stdex->what());
+  EXPECT_EQ(nullptr, folly::exception_ptr_get_object<std::logic_error>(ex));
+  EXPECT_EQ(nullptr, folly::exception_ptr_get_object<int>(ex));
+
+  EXPECT_TRUE(typeid(int) == *folly::exception_ptr_get_type(num));
+  ASSERT_NE(nullptr, folly::exception_ptr_get_object<int>(num));
+  EXPECT_EQ(12, *folly::exception_ptr_get_object<int>(num));
+  EXPECT_EQ(nullptr, folly::exception_ptr_get_object<std::exception>(num));
+
+  // Pointers are adjusted to the requested base, like in a catch clause
+  auto object = folly::exception_ptr_get_object(derived, nullptr);
+  auto base2 = folly::exception_ptr_get_object<Base2>(derived);
+  ASSERT_NE(nullptr, base2);
+  EXPECT_EQ(static_cast<Base2*>(static_cast<Derived*>(object)), base2);
+  EXPECT_EQ(2, base2->b2);
+}
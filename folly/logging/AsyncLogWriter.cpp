@@ -18,8 +18,10 @@
 
 #include <folly/Exception.h>
 #include <folly/FileUtil.h>
+#include <folly/Likely.h>
 #include <folly/detail/AtFork.h>
 #include <folly/logging/LoggerDB.h>
+#include <folly/portability/PThread.h>
 #include <folly/system/ThreadName.h>
 
 using folly::File;
@@ -28,8 +30,14 @@ using folly::StringPiece;
 namespace folly {
 
 constexpr size_t AsyncLogWriter::kDefaultMaxBufferSize;
+constexpr size_t AsyncLogWriter::kThreadBufferCapacity;
 
-AsyncLogWriter::AsyncLogWriter() {
+namespace {
+std::atomic<uint64_t> nextWriterId{1};
+} // namespace
+
+AsyncLogWriter::AsyncLogWriter()
+    : id_{nextWriterId.fetch_add(1, std::memory_order_relaxed)} {
   folly::detail::AtFork::registerHandler(
       this,
       [this] { return preFork(); },
@@ -56,6 +64,9 @@ AsyncLogWriter::~AsyncLogWriter() {
       stopIoThread(data, FLAG_DESTROYING);
       assert(false);
     }
+    for (const auto& buffer : data->threadBuffers) {
+      buffer->writerDestroyed.store(true, std::memory_order_relaxed);
+    }
   }
 
   // Unregister the atfork handler after stopping the I/O thread.
@@ -75,8 +86,9 @@ void AsyncLogWriter::cleanup() {
     // stopIoThread() causes the I/O thread to stop as soon as possible,
     // without waiting for all pending messages to be written.  Extract any
     // remaining messages to write them below.
+    drainThreadBuffers(data);
     ioQueue = data->getCurrentQueue();
-    numDiscarded = data->numDiscarded;
+    numDiscarded = numDiscarded_.load(std::memory_order_relaxed);
   }
 
   // If there are still any pending messages, flush them now.
@@ -90,19 +102,116 @@ void AsyncLogWriter::writeMessage(StringPiece buffer, uint32_t flags) {
 }
 
 void AsyncLogWriter::writeMessage(std::string&& buffer, uint32_t flags) {
-  auto data = data_.lock();
-  if ((data->currentBufferSize >= data->maxBufferBytes) &&
+  if ((currentBufferSize_.load(std::memory_order_relaxed) >=
+       maxBufferBytes_.load(std::memory_order_relaxed)) &&
       !(flags & NEVER_DISCARD)) {
-    ++data->numDiscarded;
+    numDiscarded_.fetch_add(1, std::memory_order_relaxed);
     return;
   }
 
-  data->currentBufferSize += buffer.size();
+  currentBufferSize_.fetch_add(buffer.size(), std::memory_order_relaxed);
+  auto* threadBuffer = getThreadBuffer();
+  if (threadBuffer->messages.write(std::move(buffer))) {
+    notifyIoThread();
+    return;
+  }
+
+  // Our buffer is full: move its messages to the current queue ourselves,
+  // ahead of this one, rather than waiting for the I/O thread.
+  auto data = data_.lock();
+  std::string message;
   auto* queue = data->getCurrentQueue();
+  while (threadBuffer->messages.read(message)) {
+    queue->emplace_back(std::move(message));
+  }
   queue->emplace_back(std::move(buffer));
   messageReady_.notify_one();
 }
 
+std::vector<std::shared_ptr<AsyncLogWriter::ThreadBuffer>>&
+AsyncLogWriter::getThreadBufferList() {
+  using List = std::vector<std::shared_ptr<ThreadBuffer>>;
+
+  // As in xlogEveryNThreadEntry(), the list is managed with a pthread key
+  // rather than as a thread_local object, so that messages can still be
+  // logged by destructors that run during thread teardown: the list is then
+  // recreated.
+  static auto pkey = [] {
+    pthread_key_t k;
+    pthread_key_create(&k, [](void* arg) {
+      auto& list = *static_cast<List**>(arg);
+      for (const auto& buffer : *list) {
+        buffer->orphaned.store(true, std::memory_order_release);
+      }
+      delete list;
+      list = nullptr;
+    });
+    return k;
+  }();
+  thread_local List* list;
+
+  if (UNLIKELY(!list)) {
+    pthread_setspecific(pkey, &list);
+    list = new List();
+  }
+  return *list;
+}
+
+AsyncLogWriter::ThreadBuffer* AsyncLogWriter::getThreadBuffer() {
+  auto& buffers = getThreadBufferList();
+  for (auto it = buffers.begin(); it != buffers.end();) {
+    if ((*it)->writerId == id_) {
+      return it->get();
+    }
+    if ((*it)->writerDestroyed.load(std::memory_order_relaxed)) {
+      it = buffers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto buffer = std::make_shared<ThreadBuffer>(id_);
+  data_.lock()->threadBuffers.push_back(buffer);
+  buffers.push_back(buffer);
+  return buffer.get();
+}
+
+void AsyncLogWriter::notifyIoThread() {
+  // Pairs with the fence in ioThread(): either the I/O thread sees the
+  // message we just buffered before it waits, or we see ioThreadWaiting_.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ioThreadWaiting_.load(std::memory_order_relaxed) &&
+      ioThreadWaiting_.exchange(false, std::memory_order_relaxed)) {
+    // The I/O thread holds the lock until it waits, so taking it here
+    // guarantees that the notification is not lost.
+    auto data = data_.lock();
+    messageReady_.notify_one();
+  }
+}
+
+void AsyncLogWriter::drainThreadBuffers(
+    folly::Synchronized<Data, std::mutex>::LockedPtr& data) {
+  auto* queue = data->getCurrentQueue();
+  auto& buffers = data->threadBuffers;
+  std::string message;
+  // One buffer after the other: the messages of different threads are not
+  // merged into the order they were logged in, see the class comment.
+  for (auto it = buffers.begin(); it != buffers.end();) {
+    auto& buffer = **it;
+    // Check orphaned first: once it is set the thread will not buffer any
+    // more messages.
+    bool orphaned = buffer.orphaned.load(std::memory_order_acquire);
+    while (buffer.messages.read(message)) {
+      queue->emplace_back(std::move(message));
+    }
+    if (orphaned) {
+      it = buffers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void AsyncLogWriter::flush() {
   auto data = data_.lock();
   auto start = data->ioThreadCounter;
@@ -125,13 +234,11 @@ void AsyncLogWriter::flush() {
 }
 
 void AsyncLogWriter::setMaxBufferSize(size_t size) {
-  auto data = data_.lock();
-  data->maxBufferBytes = size;
+  maxBufferBytes_.store(size, std::memory_order_relaxed);
 }
 
 size_t AsyncLogWriter::getMaxBufferSize() const {
-  auto data = data_.lock();
-  return data->maxBufferBytes;
+  return maxBufferBytes_.load(std::memory_order_relaxed);
 }
 
 void AsyncLogWriter::ioThread() {
@@ -146,9 +253,26 @@ void AsyncLogWriter::ioThread() {
     {
       auto data = data_.lock();
       ioQueue = data->getCurrentQueue();
-      while (ioQueue->empty() && !(data->flags & FLAG_STOP)) {
+      while (true) {
+        drainThreadBuffers(data);
+        if (!ioQueue->empty() || (data->flags & FLAG_STOP)) {
+          break;
+        }
+
+        // Announce that we are about to wait, then check the thread buffers
+        // once more: a writer thread that buffered a message after the check
+        // above will see ioThreadWaiting_ and wake us up.
+        ioThreadWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        drainThreadBuffers(data);
+        if (!ioQueue->empty() || (data->flags & FLAG_STOP)) {
+          ioThreadWaiting_.store(false, std::memory_order_relaxed);
+          break;
+        }
+
         // Wait for a message or one of the above flags to be set.
         messageReady_.wait(data.getUniqueLock());
+        ioThreadWaiting_.store(false, std::memory_order_relaxed);
       }
 
       if (data->flags & FLAG_STOP) {
@@ -165,12 +289,16 @@ void AsyncLogWriter::ioThread() {
       }
 
       ++data->ioThreadCounter;
-      numDiscarded = data->numDiscarded;
-      data->numDiscarded = 0;
-      data->currentBufferSize = 0;
+      numDiscarded = numDiscarded_.exchange(0, std::memory_order_relaxed);
     }
     ioCV_.notify_all();
 
+    size_t ioBytes = 0;
+    for (const auto& message : *ioQueue) {
+      ioBytes += message.size();
+    }
+    currentBufferSize_.fetch_sub(ioBytes, std::memory_order_relaxed);
+
     // Write the log messages now that we have released the lock
     performIO(ioQueue, numDiscarded);
 
@@ -212,6 +340,13 @@ void AsyncLogWriter::postForkChild() {
   // and we let the parent process handle writing them.
   lockedData_->queues[0].clear();
   lockedData_->queues[1].clear();
+  std::string message;
+  for (const auto& buffer : lockedData_->threadBuffers) {
+    while (buffer->messages.read(message)) {
+    }
+  }
+  currentBufferSize_.store(0, std::memory_order_relaxed);
+  numDiscarded_.store(0, std::memory_order_relaxed);
 
   // Restart the I/O thread
   restartThread();
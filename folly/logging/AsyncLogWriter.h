@@ -16,11 +16,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
 
 #include <folly/File.h>
+#include <folly/ProducerConsumerQueue.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/logging/LogWriter.h>
@@ -45,6 +48,13 @@ namespace folly {
  * However, one downside is that if your program crashes, not all log messages
  * may have been written, so you may lose messages generated immediately before
  * the crash.
+ *
+ * Messages from one thread are written in the order they were logged, but
+ * messages from different threads are not ordered with each other: each
+ * thread buffers its messages, and the I/O thread collects them one thread
+ * at a time, so a message may be written after a message another thread
+ * logged later, within the latency of one I/O thread iteration.  Order them
+ * by their timestamps if that matters.
  */
 class AsyncLogWriter : public LogWriter {
  public:
@@ -109,21 +119,45 @@ class AsyncLogWriter : public LogWriter {
     FLAG_IO_THREAD_JOINED = 0x10,
   };
 
+  /**
+   * The number of messages each writer thread can buffer before it has to
+   * take the data_ lock.
+   */
+  static constexpr size_t kThreadBufferCapacity = 512;
+
   /*
-   * A simple implementation using two queues.
-   * All writer threads enqueue into one queue while the I/O thread is
-   * processing the other.
+   * Messages buffered by one writer thread.
    *
-   * We could potentially also provide an implementation using folly::MPMCQueue
-   * in the future, which may improve contention under very high write loads.
+   * Only that thread ever writes to the queue.  Messages are only ever read
+   * with the data_ lock held, which is what lets the writer thread move them
+   * to the current queue itself when its buffer is full, so that its
+   * messages stay in order.
+   */
+  struct ThreadBuffer {
+    explicit ThreadBuffer(uint64_t id)
+        : writerId(id), messages(kThreadBufferCapacity) {}
+
+    const uint64_t writerId;
+    folly::ProducerConsumerQueue<std::string> messages;
+    // Set when the thread exits; the I/O thread then drops the buffer once
+    // it has been drained.
+    std::atomic<bool> orphaned{false};
+    // Set when the writer is destroyed; the thread then drops the buffer.
+    std::atomic<bool> writerDestroyed{false};
+  };
+
+  /*
+   * Writer threads append to their own ThreadBuffer without taking any lock.
+   * The I/O thread moves the buffered messages to one of two queues, and
+   * threads whose buffer is full (as well as flush()) enqueue into that queue
+   * directly.  All threads enqueue into one queue while the I/O thread is
+   * processing the other.
    */
   struct Data {
     std::array<std::vector<std::string>, 2> queues;
+    std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
     uint32_t flags{0};
     uint64_t ioThreadCounter{0};
-    size_t maxBufferBytes{kDefaultMaxBufferSize};
-    size_t currentBufferSize{0};
-    size_t numDiscarded{0};
     std::thread ioThread;
 
     std::vector<std::string>* getCurrentQueue() {
@@ -141,6 +175,12 @@ class AsyncLogWriter : public LogWriter {
 
   void ioThread();
 
+  ThreadBuffer* getThreadBuffer();
+  static std::vector<std::shared_ptr<ThreadBuffer>>& getThreadBufferList();
+  void drainThreadBuffers(
+      folly::Synchronized<Data, std::mutex>::LockedPtr& data);
+  void notifyIoThread();
+
   bool preFork();
   void postForkParent();
   void postForkChild();
@@ -150,6 +190,17 @@ class AsyncLogWriter : public LogWriter {
   void restartThread();
 
   folly::Synchronized<Data, std::mutex> data_;
+  // Identifies the buffers of this writer in the per-thread buffer lists
+  const uint64_t id_;
+
+  std::atomic<size_t> maxBufferBytes_{kDefaultMaxBufferSize};
+  // The size of the messages that have not been handed to performIO() yet
+  std::atomic<size_t> currentBufferSize_{0};
+  std::atomic<size_t> numDiscarded_{0};
+  // Set by the I/O thread, with the data_ lock held, before it waits on
+  // messageReady_; writer threads that find it set take the lock to wake it.
+  std::atomic<bool> ioThreadWaiting_{false};
+
   /**
    * messageReady_ is signaled by writer threads whenever they add a new
    * message to the current queue.
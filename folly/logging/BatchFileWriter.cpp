@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/logging/BatchFileWriter.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/Memory.h>
+#include <folly/logging/LoggerDB.h>
+#include <folly/portability/SysUio.h>
+#include <folly/portability/Unistd.h>
+
+namespace folly {
+
+constexpr size_t BatchFileWriter::kAlignment;
+
+namespace {
+BatchFileWriter::Options normalizeOptions(BatchFileWriter::Options options) {
+  auto align = BatchFileWriter::kAlignment;
+  options.bufferSize = std::max(
+      align, (options.bufferSize + align - 1) / align * align);
+  return options;
+}
+} // namespace
+
+void BatchFileWriter::AlignedFree::operator()(char* buffer) const {
+  aligned_free(buffer);
+}
+
+BatchFileWriter::BatchFileWriter(StringPiece path)
+    : BatchFileWriter{path, Options()} {}
+
+BatchFileWriter::BatchFileWriter(StringPiece path, const Options& options)
+    : BatchFileWriter{path.str(), File{}, options} {}
+
+BatchFileWriter::BatchFileWriter(File&& file, const Options& options)
+    : BatchFileWriter{std::string{}, std::move(file), options} {}
+
+BatchFileWriter::BatchFileWriter(
+    std::string&& path,
+    File&& file,
+    const Options& options)
+    : path_{std::move(path)}, options_{normalizeOptions(options)} {
+  try {
+    if (!file) {
+      file = File{path_, O_WRONLY | O_CREAT};
+    } else if (options_.rotateBytes != 0) {
+      throw std::invalid_argument(
+          "a BatchFileWriter can only rotate a file it opened by path");
+    }
+    openFile(std::move(file));
+  } catch (...) {
+    // The AsyncLogWriter constructor has already started the I/O thread
+    cleanup();
+    throw;
+  }
+}
+
+BatchFileWriter::~BatchFileWriter() {
+  cleanup();
+}
+
+bool BatchFileWriter::ttyOutput() const {
+  return isTty_.load(std::memory_order_relaxed);
+}
+
+void BatchFileWriter::openFile(File&& file) {
+  auto offset = lseek(file.fd(), 0, SEEK_END);
+  checkUnixError(offset, "lseek() failed on log file ", path_);
+  if (!buffer_) {
+    buffer_.reset(static_cast<char*>(
+        aligned_malloc(options_.bufferSize, kAlignment)));
+    if (!buffer_) {
+      throw std::bad_alloc();
+    }
+  }
+  isTty_.store(isatty(file.fd()), std::memory_order_relaxed);
+  file_ = std::move(file);
+  offset_ = offset;
+  syncStart_ = offset;
+  writebackStart_ = offset;
+  rotateRetryOffset_ = 0;
+}
+
+void BatchFileWriter::performIO(
+    std::vector<std::string>* ioQueue,
+    size_t numDiscarded) {
+  try {
+    writeToFile(ioQueue, numDiscarded);
+  } catch (const std::exception& ex) {
+    LoggerDB::internalWarning(
+        __FILE__,
+        __LINE__,
+        "error writing to log file ",
+        file_.fd(),
+        " in BatchFileWriter: ",
+        folly::exceptionStr(ex));
+  }
+}
+
+void BatchFileWriter::writeToFile(
+    std::vector<std::string>* ioQueue,
+    size_t numDiscarded) {
+  for (const auto& message : *ioQueue) {
+    append(message);
+  }
+  if (numDiscarded > 0) {
+    append(to<std::string>(
+        numDiscarded,
+        " log messages discarded: logging faster than we can write\n"));
+  }
+  writeBuffer();
+  sync(true);
+}
+
+void BatchFileWriter::append(StringPiece message) {
+  if (bufferLength_ + message.size() > options_.bufferSize) {
+    if (message.size() >= options_.bufferSize) {
+      // Write large messages from where they are, along with the buffer
+      writeBuffer(message);
+      return;
+    }
+    writeBuffer();
+  }
+  std::memcpy(buffer_.get() + bufferLength_, message.data(), message.size());
+  bufferLength_ += message.size();
+}
+
+void BatchFileWriter::writeBuffer(StringPiece extra) {
+  size_t length = bufferLength_ + extra.size();
+  if (length == 0) {
+    return;
+  }
+  if (options_.rotateBytes != 0 && offset_ > 0 &&
+      size_t(offset_) + length > options_.rotateBytes &&
+      offset_ >= rotateRetryOffset_) {
+    rotate();
+  }
+
+  std::array<iovec, 2> iov;
+  int count = 0;
+  if (bufferLength_ > 0) {
+    iov[count].iov_base = buffer_.get();
+    iov[count].iov_len = bufferLength_;
+    ++count;
+  }
+  if (!extra.empty()) {
+    iov[count].iov_base = const_cast<char*>(extra.data());
+    iov[count].iov_len = extra.size();
+    ++count;
+  }
+  // The batch is dropped if it cannot be written, as AsyncFileWriter does
+  bufferLength_ = 0;
+  auto ret = pwritevFull(file_.fd(), iov.data(), count, offset_);
+  checkUnixError(ret, "pwritev() failed");
+  offset_ += ret;
+  sync(false);
+}
+
+void BatchFileWriter::sync(bool endOfBatch) {
+  size_t pending = size_t(offset_ - syncStart_);
+  if (pending == 0) {
+    return;
+  }
+  switch (options_.syncPolicy) {
+    case SyncPolicy::NONE:
+      return;
+    case SyncPolicy::WRITEBACK:
+#ifdef __linux__
+      if (pending < options_.syncBytes) {
+        return;
+      }
+      // Errors are ignored: this only affects when the data is written back.
+      (void)sync_file_range(
+          file_.fd(), syncStart_, pending, SYNC_FILE_RANGE_WRITE);
+      if (writebackStart_ < syncStart_) {
+        (void)sync_file_range(
+            file_.fd(),
+            writebackStart_,
+            syncStart_ - writebackStart_,
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                SYNC_FILE_RANGE_WAIT_AFTER);
+        (void)posix_fadvise(
+            file_.fd(),
+            writebackStart_,
+            syncStart_ - writebackStart_,
+            POSIX_FADV_DONTNEED);
+      }
+      writebackStart_ = syncStart_;
+      syncStart_ = offset_;
+#endif
+      return;
+    case SyncPolicy::DATASYNC:
+      if (options_.syncBytes == 0 ? !endOfBatch
+                                  : pending < options_.syncBytes) {
+        return;
+      }
+      checkUnixError(fdatasyncNoInt(file_.fd()), "fdatasync() failed");
+      syncStart_ = offset_;
+      return;
+  }
+}
+
+void BatchFileWriter::rotate() {
+  auto rotatedPath = [&](size_t n) {
+    return n == 0 ? path_ : to<std::string>(path_, ".", n);
+  };
+  bool renamed = false;
+  try {
+    if (options_.syncPolicy == SyncPolicy::DATASYNC && offset_ > syncStart_) {
+      checkUnixError(fdatasyncNoInt(file_.fd()), "fdatasync() failed");
+    }
+
+    for (size_t n = options_.maxRotatedFiles; n > 0; --n) {
+      auto oldPath = rotatedPath(n - 1);
+      auto newPath = rotatedPath(n);
+      if (::rename(oldPath.c_str(), newPath.c_str()) != 0 && errno != ENOENT) {
+        throwSystemError("unable to rename ", oldPath, " to ", newPath);
+      }
+    }
+    renamed = options_.maxRotatedFiles > 0;
+    // Truncates the file if no rotated files are kept
+    openFile(File{path_, O_WRONLY | O_CREAT | O_TRUNC});
+  } catch (const std::exception& ex) {
+    // Keep writing to the current file, under its own name, and only try
+    // again once another rotateBytes have been written to it.
+    if (renamed) {
+      (void)::rename(rotatedPath(1).c_str(), path_.c_str());
+    }
+    rotateRetryOffset_ = offset_ + off_t(options_.rotateBytes);
+    LoggerDB::internalWarning(
+        __FILE__,
+        __LINE__,
+        "error rotating log file ",
+        path_,
+        " in BatchFileWriter: ",
+        folly::exceptionStr(ex));
+  }
+}
+
+} // namespace folly
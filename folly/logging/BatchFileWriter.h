@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/logging/AsyncLogWriter.h>
+
+namespace folly {
+
+/**
+ * An AsyncLogWriter that writes to a file in large batches, and that can
+ * sync and rotate the file.
+ *
+ * Where AsyncFileWriter issues a writev() call per 64 messages, the I/O
+ * thread of a BatchFileWriter copies the messages into a page-aligned buffer
+ * and writes it with a single pwrite() once it is full, or once the messages
+ * the I/O thread picked up have all been copied.
+ *
+ * When logging at a sustained high rate, dirty pages of the log file
+ * accumulate in the page cache until the kernel throttles the writer on
+ * writeback, which stalls logging for a long time.  The sync policy bounds
+ * the amount of dirty data instead: see SyncPolicy.
+ *
+ * The writer keeps its own file offset, so no other process or writer
+ * should append to the same file.
+ */
+class BatchFileWriter : public AsyncLogWriter {
+ public:
+  enum class SyncPolicy {
+    /**
+     * Leave writeback to the kernel.
+     */
+    NONE,
+    /**
+     * On Linux, start writeback of every syncBytes of output as soon as they
+     * are written, and wait for the previous syncBytes to be written back
+     * (which has usually happened by then) and drop them from the page cache.
+     * This bounds the dirty pages of the file to about 2 * syncBytes without
+     * the cost of fdatasync().  Does nothing on other platforms.
+     */
+    WRITEBACK,
+    /**
+     * Call fdatasync() after every syncBytes of output, or after every batch
+     * if syncBytes is 0, so that at most that much output is lost if the
+     * machine crashes.
+     */
+    DATASYNC,
+  };
+
+  struct Options {
+    /**
+     * The size of the batch buffer, rounded up to a multiple of kAlignment.
+     */
+    size_t bufferSize{256 * 1024};
+    SyncPolicy syncPolicy{SyncPolicy::WRITEBACK};
+    size_t syncBytes{4 * 1024 * 1024};
+    /**
+     * If not 0, the file is rotated before it would grow larger than this
+     * (unless it is empty): `path` is renamed to `path.1`, `path.1` to
+     * `path.2` and so on, and a new `path` is created.
+     */
+    size_t rotateBytes{0};
+    /**
+     * The number of rotated files to keep; older ones are deleted.
+     */
+    size_t maxRotatedFiles{5};
+  };
+
+  static constexpr size_t kAlignment = 4096;
+
+  /**
+   * Construct a BatchFileWriter that appends to the file at the specified
+   * path.
+   */
+  explicit BatchFileWriter(folly::StringPiece path);
+  BatchFileWriter(folly::StringPiece path, const Options& options);
+
+  /**
+   * Construct a BatchFileWriter that writes to the specified File object at
+   * its current end.  It cannot be rotated, so options.rotateBytes must be 0.
+   */
+  BatchFileWriter(folly::File&& file, const Options& options);
+
+  ~BatchFileWriter() override;
+
+  /**
+   * Returns true if the output steam is a tty.
+   */
+  bool ttyOutput() const override;
+
+  const Options& getOptions() const {
+    return options_;
+  }
+
+ private:
+  struct AlignedFree {
+    void operator()(char* buffer) const;
+  };
+
+  BatchFileWriter(
+      std::string&& path,
+      folly::File&& file,
+      const Options& options);
+
+  void performIO(std::vector<std::string>* ioQueue, size_t numDiscarded)
+      override;
+
+  void writeToFile(std::vector<std::string>* ioQueue, size_t numDiscarded);
+  void append(folly::StringPiece message);
+  // Write the batch buffer followed by extra, which may be empty
+  void writeBuffer(folly::StringPiece extra = {});
+  void sync(bool endOfBatch);
+  void rotate();
+  void openFile(folly::File&& file);
+
+  const std::string path_;
+  const Options options_;
+  // Read by ttyOutput() from any thread, updated with file_
+  std::atomic<bool> isTty_{false};
+
+  // Only used by the I/O thread, or by the destructor once it has stopped
+  folly::File file_;
+  off_t offset_{0};
+  // The start of the output that has not been synced yet, and of the output
+  // whose writeback was started by the previous sync() call.
+  off_t syncStart_{0};
+  off_t writebackStart_{0};
+  std::unique_ptr<char, AlignedFree> buffer_;
+  size_t bufferLength_{0};
+  // After a failed rotation, the offset from which to try again
+  off_t rotateRetryOffset_{0};
+};
+} // namespace folly
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/logging/BinaryLogFormatter.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Varint.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/DeferredFormat.h>
+#include <folly/logging/LogCategory.h>
+#include <folly/logging/LogMessage.h>
+
+namespace folly {
+
+namespace {
+
+enum class RecordType : uint8_t {
+  FORMAT = 1,
+  MESSAGE = 2,
+};
+
+constexpr size_t kLengthSize = sizeof(uint32_t);
+
+template <typename T>
+void appendFixed(std::string& out, T value) {
+  value = Endian::little(value);
+  char buf[sizeof(T)];
+  std::memcpy(buf, &value, sizeof(T));
+  out.append(buf, sizeof(T));
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[kMaxVarintLength64];
+  out.append(reinterpret_cast<const char*>(buf), encodeVarint(value, buf));
+}
+
+void appendString(std::string& out, StringPiece str) {
+  appendVarint(out, str.size());
+  out.append(str.data(), str.size());
+}
+
+// Returns the offset of the record, whose length is set by endRecord().
+size_t beginRecord(std::string& out, RecordType type) {
+  auto offset = out.size();
+  out.append(kLengthSize, '\0');
+  out.push_back(static_cast<char>(type));
+  return offset;
+}
+
+void endRecord(std::string& out, size_t offset) {
+  auto length = Endian::little(
+      static_cast<uint32_t>(out.size() - offset - kLengthSize));
+  std::memcpy(&out[offset], &length, kLengthSize);
+}
+
+ByteRange take(ByteRange& data, size_t size) {
+  if (data.size() < size) {
+    throw std::invalid_argument("truncated binary log record");
+  }
+  auto result = data.subpiece(0, size);
+  data.advance(size);
+  return result;
+}
+
+template <typename T>
+T takeFixed(ByteRange& data) {
+  T value;
+  std::memcpy(&value, take(data, sizeof(T)).data(), sizeof(T));
+  return Endian::little(value);
+}
+
+std::string takeString(ByteRange& data) {
+  auto size = decodeVarint(data);
+  return StringPiece{take(data, size)}.str();
+}
+
+BinaryLogRecord readMessage(
+    ByteRange data,
+    const F14FastMap<uint64_t, std::string>& formats) {
+  BinaryLogRecord record;
+  record.level = static_cast<LogLevel>(decodeVarint(data));
+  record.timestamp = std::chrono::system_clock::time_point{
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::nanoseconds{decodeZigZag(decodeVarint(data))})};
+  record.threadID = decodeVarint(data);
+  record.lineNumber = static_cast<unsigned int>(decodeVarint(data));
+  record.categoryName = takeString(data);
+  record.filename = takeString(data);
+  record.functionName = takeString(data);
+  auto formatId = takeFixed<uint64_t>(data);
+  if (formatId == 0) {
+    record.message = StringPiece{data}.str();
+  } else {
+    auto it = formats.find(formatId);
+    if (it == formats.end()) {
+      throw std::invalid_argument("unknown format in binary log record");
+    }
+    record.message = formatDeferredLogArgs(it->second, data);
+  }
+  return record;
+}
+
+} // namespace
+
+std::string BinaryLogFormatter::formatMessage(
+    const LogMessage& message,
+    const LogCategory* /* handlerCategory */) {
+  std::string result;
+  auto* format = message.getDeferredFormat();
+  if (format != nullptr &&
+      writtenFormats_.wlock()->insert(format->getId()).second) {
+    auto offset = beginRecord(result, RecordType::FORMAT);
+    appendFixed<uint64_t>(result, format->getId());
+    result.append(format->getFormat());
+    endRecord(result, offset);
+  }
+
+  auto offset = beginRecord(result, RecordType::MESSAGE);
+  appendVarint(result, static_cast<uint64_t>(message.getLevel()));
+  appendVarint(
+      result,
+      encodeZigZag(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       message.getTimestamp().time_since_epoch())
+                       .count()));
+  appendVarint(result, message.getThreadID());
+  appendVarint(result, message.getLineNumber());
+  appendString(
+      result,
+      message.getCategory() ? StringPiece{message.getCategory()->getName()}
+                            : StringPiece{});
+  appendString(result, message.getFileName());
+  appendString(result, message.getFunctionName());
+  if (format != nullptr) {
+    appendFixed<uint64_t>(result, format->getId());
+    result.append(message.getDeferredArgs());
+  } else {
+    appendFixed<uint64_t>(result, 0);
+    result.append(message.getRawMessage());
+  }
+  endRecord(result, offset);
+  return result;
+}
+
+std::vector<BinaryLogRecord> readBinaryLogRecords(ByteRange data) {
+  F14FastMap<uint64_t, std::string> formats;
+  std::vector<ByteRange> messages;
+  while (!data.empty()) {
+    auto length = takeFixed<uint32_t>(data);
+    auto record = take(data, length);
+    auto type = static_cast<RecordType>(take(record, 1)[0]);
+    if (type == RecordType::FORMAT) {
+      auto id = takeFixed<uint64_t>(record);
+      formats.emplace(id, StringPiece{record}.str());
+    } else if (type == RecordType::MESSAGE) {
+      messages.push_back(record);
+    } else {
+      throw std::invalid_argument("unknown binary log record type");
+    }
+  }
+
+  std::vector<BinaryLogRecord> result;
+  result.reserve(messages.size());
+  for (auto message : messages) {
+    result.push_back(readMessage(message, formats));
+  }
+  return result;
+}
+
+} // namespace folly
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
+#include <folly/logging/LogFormatter.h>
+#include <folly/logging/LogLevel.h>
+
+namespace folly {
+
+/**
+ * A LogFormatter that writes log messages as binary records, to be read by
+ * readBinaryLogRecords().
+ *
+ * Messages whose formatting was deferred (see FOLLY_XLOG_DEFER_FORMAT) are
+ * written as the ID of their format string and their encoded arguments,
+ * without ever being formatted.  The format string itself is written in a
+ * separate record the first time this formatter sees its ID.  Other
+ * messages are written as text.
+ *
+ * Each record is a 4-byte little-endian length followed by that many bytes.
+ * Format string IDs are hashes of the strings, so the records written by
+ * different processes can be concatenated and read together.
+ */
+class BinaryLogFormatter : public LogFormatter {
+ public:
+  std::string formatMessage(
+      const LogMessage& message,
+      const LogCategory* handlerCategory) override;
+
+ private:
+  folly::Synchronized<F14FastSet<uint64_t>> writtenFormats_;
+};
+
+/**
+ * A log message read from the records written by BinaryLogFormatter.
+ */
+struct BinaryLogRecord {
+  LogLevel level{LogLevel::UNINITIALIZED};
+  std::chrono::system_clock::time_point timestamp;
+  uint64_t threadID{0};
+  std::string categoryName;
+  std::string filename;
+  unsigned int lineNumber{0};
+  std::string functionName;
+  // not sanitized, unlike LogMessage::getMessage()
+  std::string message;
+};
+
+/**
+ * Decodes and formats all the records written by BinaryLogFormatter in
+ * data, in order.
+ *
+ * When several threads log concurrently the record with a format string may
+ * be written after the first message using it, so this needs all the
+ * records at once.  Throws std::invalid_argument if data is truncated or is
+ * not made of binary log records.
+ */
+std::vector<BinaryLogRecord> readBinaryLogRecords(folly::ByteRange data);
+
+} // namespace folly
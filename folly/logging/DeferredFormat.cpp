@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/logging/DeferredFormat.h>
+
+#include <array>
+#include <utility>
+
+#include <fmt/core.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace folly {
+namespace detail {
+namespace {
+
+/**
+ * A decoded log argument.
+ *
+ * Its fmt::formatter keeps the format spec at parse time, when the type of
+ * the argument is not known yet, and formats the value with it.
+ */
+struct DecodedLogArg {
+  DeferredLogArgType type;
+  union {
+    int64_t intValue;
+    uint64_t uintValue;
+    bool boolValue;
+    char charValue;
+    float floatValue;
+    double doubleValue;
+    const void* pointerValue;
+  };
+  folly::StringPiece stringValue;
+};
+
+} // namespace
+} // namespace detail
+} // namespace folly
+
+namespace fmt {
+
+template <>
+struct formatter<folly::detail::DecodedLogArg> {
+  template <typename ParseContext>
+  auto parse(ParseContext& ctx) -> decltype(ctx.begin()) {
+    auto it = ctx.begin();
+    size_t depth = 0;
+    while (it != ctx.end() && (*it != '}' || depth != 0)) {
+      if (*it == '{') {
+        ++depth;
+      } else if (*it == '}') {
+        --depth;
+      }
+      ++it;
+    }
+    spec_.assign(ctx.begin(), it);
+    return it;
+  }
+
+  template <typename FormatContext>
+  auto format(const folly::detail::DecodedLogArg& arg, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    using Type = folly::detail::DeferredLogArgType;
+    switch (arg.type) {
+      case Type::INT:
+        return formatValue(arg.intValue, ctx);
+      case Type::UINT:
+        return formatValue(arg.uintValue, ctx);
+      case Type::BOOL:
+        return formatValue(arg.boolValue, ctx);
+      case Type::CHAR:
+        return formatValue(arg.charValue, ctx);
+      case Type::FLOAT:
+        return formatValue(arg.floatValue, ctx);
+      case Type::DOUBLE:
+        return formatValue(arg.doubleValue, ctx);
+      case Type::STRING:
+        return formatValue(
+            fmt::string_view(arg.stringValue.data(), arg.stringValue.size()),
+            ctx);
+      case Type::POINTER:
+        return formatValue(arg.pointerValue, ctx);
+    }
+    return ctx.out();
+  }
+
+ private:
+  template <typename T, typename FormatContext>
+  auto formatValue(const T& value, FormatContext& ctx) const
+      -> decltype(ctx.out()) {
+    std::string spec;
+    spec.reserve(spec_.size() + 3);
+    spec.append("{:");
+    spec.append(spec_);
+    spec.push_back('}');
+    auto str = fmt::vformat(spec, fmt::make_format_args(value));
+    return std::copy(str.begin(), str.end(), ctx.out());
+  }
+
+  std::string spec_;
+};
+
+} // namespace fmt
+
+namespace folly {
+
+namespace {
+
+using detail::DecodedLogArg;
+using detail::DeferredLogArgType;
+
+template <size_t... I>
+std::string formatDecodedLogArgs(
+    folly::StringPiece format,
+    const DecodedLogArg* args,
+    std::index_sequence<I...>) {
+  return fmt::vformat(
+      fmt::string_view(format.data(), format.size()),
+      fmt::make_format_args(args[I]...));
+}
+
+// decodeLogArgs() never returns more than kMaxDeferredLogArgs
+std::string formatDecodedLogArgs(
+    folly::StringPiece format,
+    const DecodedLogArg* args,
+    size_t /* numArgs */,
+    std::integral_constant<size_t, kMaxDeferredLogArgs + 1>) {
+  return formatDecodedLogArgs(
+      format, args, std::make_index_sequence<kMaxDeferredLogArgs>{});
+}
+
+template <size_t N>
+std::string formatDecodedLogArgs(
+    folly::StringPiece format,
+    const DecodedLogArg* args,
+    size_t numArgs,
+    std::integral_constant<size_t, N>) {
+  if (numArgs == N) {
+    return formatDecodedLogArgs(format, args, std::make_index_sequence<N>{});
+  }
+  return formatDecodedLogArgs(
+      format, args, numArgs, std::integral_constant<size_t, N + 1>{});
+}
+
+size_t decodeLogArgs(
+    folly::ByteRange data,
+    std::array<DecodedLogArg, kMaxDeferredLogArgs>& args) {
+  size_t numArgs = 0;
+  auto take = [&](size_t size) {
+    if (data.size() < size) {
+      throw std::invalid_argument("truncated log arguments");
+    }
+    auto result = data.subpiece(0, size);
+    data.advance(size);
+    return result;
+  };
+  while (!data.empty()) {
+    if (numArgs == args.size()) {
+      throw std::invalid_argument("too many log arguments");
+    }
+    auto& arg = args[numArgs++];
+    arg.type = static_cast<DeferredLogArgType>(take(1)[0]);
+    switch (arg.type) {
+      case DeferredLogArgType::INT:
+        arg.intValue = decodeZigZag(decodeVarint(data));
+        break;
+      case DeferredLogArgType::UINT:
+        arg.uintValue = decodeVarint(data);
+        break;
+      case DeferredLogArgType::BOOL:
+        arg.boolValue = take(1)[0] != 0;
+        break;
+      case DeferredLogArgType::CHAR:
+        arg.charValue = static_cast<char>(take(1)[0]);
+        break;
+      case DeferredLogArgType::FLOAT:
+        std::memcpy(&arg.floatValue, take(sizeof(float)).data(), 4);
+        break;
+      case DeferredLogArgType::DOUBLE:
+        std::memcpy(&arg.doubleValue, take(sizeof(double)).data(), 8);
+        break;
+      case DeferredLogArgType::STRING: {
+        auto size = decodeVarint(data);
+        auto bytes = take(size);
+        arg.stringValue = folly::StringPiece{bytes};
+        break;
+      }
+      case DeferredLogArgType::POINTER:
+        arg.pointerValue = reinterpret_cast<const void*>(
+            static_cast<uintptr_t>(decodeVarint(data)));
+        break;
+      default:
+        throw std::invalid_argument("unknown log argument type");
+    }
+  }
+  return numArgs;
+}
+
+} // namespace
+
+DeferredLogFormat::DeferredLogFormat(folly::StringPiece format)
+    : format_{format.str()},
+      id_{hash::SpookyHashV2::Hash64(format.data(), format.size(), 0)} {
+  // 0 identifies messages that were formatted immediately in binary logs
+  if (id_ == 0) {
+    id_ = 1;
+  }
+}
+
+DeferredLogFormat* DeferredLogFormatSite::init(folly::StringPiece format) {
+  auto* entry = new DeferredLogFormat(format);
+  DeferredLogFormat* expected = nullptr;
+  if (!entry_.compare_exchange_strong(
+          expected, entry, std::memory_order_acq_rel)) {
+    delete entry;
+    return expected;
+  }
+  return entry;
+}
+
+std::string formatDeferredLogArgs(
+    folly::StringPiece format,
+    folly::ByteRange args) noexcept {
+  std::array<DecodedLogArg, kMaxDeferredLogArgs> decoded;
+  size_t numArgs = 0;
+  try {
+    numArgs = decodeLogArgs(args, decoded);
+    return formatDecodedLogArgs(
+        format, decoded.data(), numArgs, std::integral_constant<size_t, 0>{});
+  } catch (const std::exception& ex) {
+    // Log the format string and the arguments, as formatLogString() does
+    // for messages that are formatted immediately.
+    std::string result;
+    result.append("error formatting log message: ");
+    result.append(ex.what());
+    result.append("; format string: \"");
+    result.append(format.data(), format.size());
+    result.append("\", arguments: ");
+    for (size_t i = 0; i < numArgs; ++i) {
+      if (i != 0) {
+        result.append(", ");
+      }
+      result.append(fmt::vformat("{}", fmt::make_format_args(decoded[i])));
+    }
+    return result;
+  }
+}
+
+} // namespace folly
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <folly/CPortability.h>
+#include <folly/Likely.h>
+#include <folly/Range.h>
+#include <folly/Traits.h>
+#include <folly/Varint.h>
+
+namespace folly {
+
+/**
+ * The format string of log messages whose formatting is deferred.
+ *
+ * Its ID is a hash of the string, so that it is the same in every process
+ * and binary log records can refer to it.
+ */
+class DeferredLogFormat {
+ public:
+  explicit DeferredLogFormat(folly::StringPiece format);
+
+  uint64_t getId() const {
+    return id_;
+  }
+
+  const std::string& getFormat() const {
+    return format_;
+  }
+
+ private:
+  std::string format_;
+  uint64_t id_;
+};
+
+/**
+ * The DeferredLogFormat of a log statement, in static storage at the log
+ * statement site.
+ *
+ * This relies on zero-initialization so that it can be used before main(),
+ * and is intentionally never destroyed: log messages may refer to its
+ * DeferredLogFormat until the end of the program.
+ */
+class DeferredLogFormatSite {
+ public:
+  /**
+   * Returns the DeferredLogFormat of the format string, or nullptr if the
+   * format string differs from the one this site was first used with: the
+   * formatting of messages from log statements with varying format strings
+   * is never deferred.
+   *
+   * The strings are compared by content, as a non-literal format string may
+   * be at the same address with different contents every time.
+   */
+  const DeferredLogFormat* get(folly::StringPiece format) {
+    auto* entry = entry_.load(std::memory_order_acquire);
+    if (UNLIKELY(entry == nullptr)) {
+      entry = init(format);
+    }
+    if (format != entry->getFormat()) {
+      return nullptr;
+    }
+    return entry;
+  }
+
+ private:
+  FOLLY_NOINLINE DeferredLogFormat* init(folly::StringPiece format);
+
+  std::atomic<DeferredLogFormat*> entry_;
+};
+
+namespace detail {
+
+enum class DeferredLogArgType : uint8_t {
+  INT,
+  UINT,
+  BOOL,
+  CHAR,
+  DOUBLE,
+  STRING,
+  POINTER,
+  FLOAT,
+};
+
+inline void appendDeferredLogVarint(std::string& out, uint64_t value) {
+  uint8_t buf[kMaxVarintLength64];
+  out.append(
+      reinterpret_cast<const char*>(buf), encodeVarint(value, buf));
+}
+
+inline void appendDeferredLogTag(std::string& out, DeferredLogArgType type) {
+  out.push_back(static_cast<char>(type));
+}
+
+/**
+ * How to encode a log argument whose formatting is deferred.  Only the types
+ * specialized below can be deferred; log statements with arguments of any
+ * other type are formatted immediately.
+ */
+template <typename T, typename Enable = void>
+struct DeferredLogArg : std::false_type {};
+
+template <>
+struct DeferredLogArg<bool> : std::true_type {
+  static void encode(std::string& out, bool value) {
+    appendDeferredLogTag(out, DeferredLogArgType::BOOL);
+    out.push_back(value ? 1 : 0);
+  }
+};
+
+template <>
+struct DeferredLogArg<char> : std::true_type {
+  static void encode(std::string& out, char value) {
+    appendDeferredLogTag(out, DeferredLogArgType::CHAR);
+    out.push_back(value);
+  }
+};
+
+template <typename T>
+struct DeferredLogArg<
+    T,
+    std::enable_if_t<
+        std::is_integral<T>::value && std::is_signed<T>::value &&
+        !std::is_same<T, char>::value && !std::is_same<T, wchar_t>::value>>
+    : std::true_type {
+  static void encode(std::string& out, T value) {
+    appendDeferredLogTag(out, DeferredLogArgType::INT);
+    appendDeferredLogVarint(out, encodeZigZag(static_cast<int64_t>(value)));
+  }
+};
+
+template <typename T>
+struct DeferredLogArg<
+    T,
+    std::enable_if_t<
+        std::is_integral<T>::value && std::is_unsigned<T>::value &&
+        !std::is_same<T, bool>::value && !std::is_same<T, char>::value &&
+        !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value &&
+        !std::is_same<T, char32_t>::value>> : std::true_type {
+  static void encode(std::string& out, T value) {
+    appendDeferredLogTag(out, DeferredLogArgType::UINT);
+    appendDeferredLogVarint(out, static_cast<uint64_t>(value));
+  }
+};
+
+// float is kept as float, as it formats differently from the same value as a
+// double
+template <>
+struct DeferredLogArg<float> : std::true_type {
+  static void encode(std::string& out, float value) {
+    appendDeferredLogTag(out, DeferredLogArgType::FLOAT);
+    char buf[sizeof(value)];
+    std::memcpy(buf, &value, sizeof(value));
+    out.append(buf, sizeof(buf));
+  }
+};
+
+// long double is narrowed to double
+template <typename T>
+struct DeferredLogArg<
+    T,
+    std::enable_if_t<
+        std::is_floating_point<T>::value && !std::is_same<T, float>::value>>
+    : std::true_type {
+  static void encode(std::string& out, T value) {
+    appendDeferredLogTag(out, DeferredLogArgType::DOUBLE);
+    double d = static_cast<double>(value);
+    char buf[sizeof(d)];
+    std::memcpy(buf, &d, sizeof(d));
+    out.append(buf, sizeof(buf));
+  }
+};
+
+template <typename T>
+struct DeferredLogArg<
+    T,
+    std::enable_if_t<
+        std::is_same<T, const char*>::value || std::is_same<T, char*>::value ||
+        std::is_same<T, std::string>::value ||
+        std::is_same<T, folly::StringPiece>::value>> : std::true_type {
+  static void encode(std::string& out, folly::StringPiece value) {
+    appendDeferredLogTag(out, DeferredLogArgType::STRING);
+    appendDeferredLogVarint(out, value.size());
+    out.append(value.data(), value.size());
+  }
+  static void encode(std::string& out, const char* value) {
+    encode(out, value ? folly::StringPiece{value} : "(null)");
+  }
+};
+
+template <typename T>
+struct DeferredLogArg<
+    T,
+    std::enable_if_t<
+        std::is_same<T, const void*>::value || std::is_same<T, void*>::value ||
+        std::is_same<T, std::nullptr_t>::value>> : std::true_type {
+  static void encode(std::string& out, const void* value) {
+    appendDeferredLogTag(out, DeferredLogArgType::POINTER);
+    appendDeferredLogVarint(out, reinterpret_cast<uintptr_t>(value));
+  }
+};
+
+} // namespace detail
+
+/**
+ * The maximum number of arguments of a log message whose formatting can be
+ * deferred.
+ */
+constexpr size_t kMaxDeferredLogArgs = 16;
+
+/**
+ * Whether a log message with arguments of these types can be formatted
+ * later, from its format string and its arguments encoded with
+ * encodeDeferredLogArgs().
+ */
+template <typename... Args>
+constexpr bool canDeferLogFormat() {
+  return sizeof...(Args) <= kMaxDeferredLogArgs &&
+      StrictConjunction<detail::DeferredLogArg<std::decay_t<Args>>...>::value;
+}
+
+/**
+ * Encodes log arguments whose types satisfy canDeferLogFormat() into a
+ * compact binary string.
+ */
+template <typename... Args>
+std::string encodeDeferredLogArgs(const Args&... args) {
+  std::string result;
+  int dummy[] = {
+      0,
+      (detail::DeferredLogArg<std::decay_t<Args>>::encode(result, args), 0)...};
+  (void)dummy;
+  return result;
+}
+
+/**
+ * Formats log arguments encoded by encodeDeferredLogArgs() with the format
+ * string they were logged with.
+ *
+ * This does not throw: errors are described in the returned string, as when
+ * formatting log messages immediately.
+ */
+std::string formatDeferredLogArgs(
+    folly::StringPiece format,
+    folly::ByteRange args) noexcept;
+
+} // namespace folly
@@ -16,6 +16,8 @@
 
 #include <folly/logging/FileHandlerFactory.h>
 
+#include <folly/Conv.h>
+#include <folly/logging/BatchFileWriter.h>
 #include <folly/logging/FileWriterFactory.h>
 #include <folly/logging/StandardLogHandler.h>
 #include <folly/logging/StandardLogHandlerFactory.h>
@@ -31,10 +33,25 @@ class FileHandlerFactory::WriterFactory
       return true;
     }
 
-    // TODO(T29811675): In the future it would be nice to support log rotation,
-    // and add parameters to control when the log file should be rotated.
-
-    return fileWriterFactory_.processOption(name, value);
+    // The remaining options select a BatchFileWriter
+    if (name == "batch") {
+      batch_ = to<bool>(value);
+      return true;
+    } else if (name == "batch_buffer_size") {
+      batchOptions_.bufferSize = to<size_t>(value);
+    } else if (name == "sync") {
+      batchOptions_.syncPolicy = parseSyncPolicy(value);
+    } else if (name == "sync_bytes") {
+      batchOptions_.syncBytes = to<size_t>(value);
+    } else if (name == "rotate_bytes") {
+      batchOptions_.rotateBytes = to<size_t>(value);
+    } else if (name == "rotate_count") {
+      batchOptions_.maxRotatedFiles = to<size_t>(value);
+    } else {
+      return fileWriterFactory_.processOption(name, value);
+    }
+    hasBatchOptions_ = true;
+    return true;
   }
 
   std::shared_ptr<LogWriter> createWriter() override {
@@ -42,12 +59,46 @@ class FileHandlerFactory::WriterFactory
     if (path_.empty()) {
       throw std::invalid_argument("no path specified for file handler");
     }
+    if (batch_.value_or(hasBatchOptions_)) {
+      if (!fileWriterFactory_.isAsync()) {
+        throw std::invalid_argument(
+            "batched file handlers cannot be used with \"async=false\"");
+      }
+      auto writer = std::make_shared<BatchFileWriter>(path_, batchOptions_);
+      if (fileWriterFactory_.getMaxBufferSize().hasValue()) {
+        writer->setMaxBufferSize(fileWriterFactory_.getMaxBufferSize().value());
+      }
+      return writer;
+    }
+    if (hasBatchOptions_) {
+      throw std::invalid_argument(
+          "batched file handler options cannot be used with \"batch=false\"");
+    }
     return fileWriterFactory_.createWriter(
         File{path_, O_WRONLY | O_APPEND | O_CREAT});
   }
 
+  static BatchFileWriter::SyncPolicy parseSyncPolicy(StringPiece value) {
+    if (value == "none") {
+      return BatchFileWriter::SyncPolicy::NONE;
+    } else if (value == "writeback") {
+      return BatchFileWriter::SyncPolicy::WRITEBACK;
+    } else if (value == "datasync") {
+      return BatchFileWriter::SyncPolicy::DATASYNC;
+    }
+    throw std::invalid_argument(to<std::string>(
+        "unknown sync policy \"",
+        value,
+        "\": expected \"none\", \"writeback\" or \"datasync\""));
+  }
+
   std::string path_;
   FileWriterFactory fileWriterFactory_;
+  // Unless batch is given, any of the other batch options selects a
+  // BatchFileWriter
+  Optional<bool> batch_;
+  bool hasBatchOptions_{false};
+  BatchFileWriter::Options batchOptions_;
 };
 
 std::shared_ptr<LogHandler> FileHandlerFactory::createHandler(
@@ -36,6 +36,13 @@ class FileWriterFactory {
   bool processOption(StringPiece name, StringPiece value);
   std::shared_ptr<LogWriter> createWriter(File file);
 
+  bool isAsync() const {
+    return async_;
+  }
+  const Optional<size_t>& getMaxBufferSize() const {
+    return maxBufferSize_;
+  }
+
  private:
   bool async_{true};
   Optional<size_t> maxBufferSize_;
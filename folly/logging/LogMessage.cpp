@@ -16,6 +16,7 @@
 
 #include <folly/logging/LogMessage.h>
 
+#include <folly/logging/DeferredFormat.h>
 #include <folly/system/ThreadId.h>
 
 using std::chrono::system_clock;
@@ -59,6 +60,31 @@ LogMessage::LogMessage(
   sanitizeMessage();
 }
 
+LogMessage::LogMessage(
+    const LogCategory* category,
+    LogLevel level,
+    StringPiece filename,
+    unsigned int lineNumber,
+    StringPiece functionName,
+    const DeferredLogFormat* format,
+    std::string&& args)
+    : category_{category},
+      level_{level},
+      threadID_{getOSThreadID()},
+      timestamp_{system_clock::now()},
+      filename_{filename},
+      lineNumber_{lineNumber},
+      functionName_{functionName},
+      deferredFormat_{format},
+      deferredArgs_{std::move(args)} {}
+
+void LogMessage::formatDeferredSlow() const {
+  rawMessage_ = formatDeferredLogArgs(
+      deferredFormat_->getFormat(), StringPiece{deferredArgs_});
+  deferredFormatted_ = true;
+  sanitizeMessage();
+}
+
 StringPiece LogMessage::getFileBaseName() const {
 #ifdef _WIN32
   // Windows allows either backwards or forwards slash as path separator
@@ -81,7 +107,7 @@ StringPiece LogMessage::getFileBaseName() const {
   return filename_.subpiece(idx + 1);
 }
 
-void LogMessage::sanitizeMessage() {
+void LogMessage::sanitizeMessage() const {
   // Compute how long the sanitized string will be.
   size_t sanitizedLength = 0;
   for (const char c : rawMessage_) {
@@ -25,6 +25,7 @@
 
 namespace folly {
 
+class DeferredLogFormat;
 class LogCategory;
 
 /**
@@ -74,6 +75,21 @@ class LogMessage {
       folly::StringPiece functionName,
       std::string&& msg);
 
+  /**
+   * Construct a LogMessage whose text is only formatted, from the format and
+   * the arguments encoded by encodeDeferredLogArgs(), when it is first
+   * requested.  LogFormatters that do not need the text, like
+   * BinaryLogFormatter, never format it.
+   */
+  LogMessage(
+      const LogCategory* category,
+      LogLevel level,
+      folly::StringPiece filename,
+      unsigned int lineNumber,
+      folly::StringPiece functionName,
+      const DeferredLogFormat* format,
+      std::string&& args);
+
   const LogCategory* getCategory() const {
     return category_;
   }
@@ -104,6 +120,7 @@ class LogMessage {
   }
 
   const std::string& getMessage() const {
+    formatDeferred();
     // If no characters needed to be sanitized, message_ will be empty.
     if (message_.empty()) {
       return rawMessage_;
@@ -112,15 +129,39 @@ class LogMessage {
   }
 
   const std::string& getRawMessage() const {
+    formatDeferred();
     return rawMessage_;
   }
 
   bool containsNewlines() const {
+    formatDeferred();
     return containsNewlines_;
   }
 
+  /**
+   * The format of a message whose formatting was deferred, or nullptr.
+   */
+  const DeferredLogFormat* getDeferredFormat() const {
+    return deferredFormat_;
+  }
+
+  /**
+   * The encoded arguments of a message whose formatting was deferred.
+   */
+  const std::string& getDeferredArgs() const {
+    return deferredArgs_;
+  }
+
  private:
-  void sanitizeMessage();
+  // Not thread safe, like the rest of LogMessage's accessors are assumed to
+  // be: LogMessage objects are only read by the thread that logged them.
+  void formatDeferred() const {
+    if (deferredFormat_ != nullptr && !deferredFormatted_) {
+      formatDeferredSlow();
+    }
+  }
+  void formatDeferredSlow() const;
+  void sanitizeMessage() const;
 
   const LogCategory* const category_{nullptr};
   LogLevel const level_{static_cast<LogLevel>(0)};
@@ -148,7 +189,7 @@ class LogMessage {
    * This allows log handlers that perform special handling of multi-line
    * messages to easily detect if a message contains multiple lines or not.
    */
-  bool containsNewlines_{false};
+  mutable bool containsNewlines_{false};
 
   /**
    * rawMessage_ contains the original message.
@@ -156,7 +197,7 @@ class LogMessage {
    * This may contain arbitrary binary data, including unprintable characters
    * and nul bytes.
    */
-  std::string const rawMessage_;
+  mutable std::string rawMessage_;
 
   /**
    * message_ contains a sanitized version of the log message.
@@ -166,6 +207,14 @@ class LogMessage {
    * are responsible for deciding how they want to handle log messages with
    * internal newlines.
    */
-  std::string message_;
+  mutable std::string message_;
+
+  /**
+   * For messages whose formatting was deferred, the format and encoded
+   * arguments from which rawMessage_ is formatted on first use.
+   */
+  const DeferredLogFormat* const deferredFormat_{nullptr};
+  std::string const deferredArgs_;
+  mutable bool deferredFormatted_{false};
 };
 } // namespace folly
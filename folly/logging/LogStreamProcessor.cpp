@@ -191,6 +191,23 @@ void LogStreamProcessor::logNow() noexcept {
   //
   // Any other error here is unexpected and we also want to fail hard
   // in that situation too.
+  if (deferredFormat_) {
+    if (stream_.empty()) {
+      category_->admitMessage(LogMessage{category_,
+                                         level_,
+                                         filename_,
+                                         lineNumber_,
+                                         functionName_,
+                                         deferredFormat_,
+                                         std::move(message_)});
+      return;
+    }
+    // Text was also streamed to the message: format it now so that the
+    // text can be appended.
+    message_ = formatDeferredLogArgs(
+        deferredFormat_->getFormat(), StringPiece{message_});
+    deferredFormat_ = nullptr;
+  }
   category_->admitMessage(LogMessage{category_,
                                      level_,
                                      filename_,
@@ -20,6 +20,7 @@
 #include <folly/CPortability.h>
 #include <folly/Conv.h>
 #include <folly/Portability.h>
+#include <folly/logging/DeferredFormat.h>
 #include <folly/logging/LogCategory.h>
 #include <folly/logging/LogMessage.h>
 #include <folly/logging/LogStream.h>
@@ -48,6 +49,7 @@ class LogStreamProcessor {
  public:
   enum AppendType { APPEND };
   enum FormatType { FORMAT };
+  enum DeferredFormatType { DEFERRED_FORMAT };
 
   /**
    * LogStreamProcessor constructor for use with a LOG() macro with no extra
@@ -121,6 +123,35 @@ class LogStreamProcessor {
             INTERNAL,
             formatLogString(fmt, std::forward<Args>(args)...)) {}
 
+  /**
+   * LogStreamProcessor constructor for use with a LOG() macro with arguments
+   * to be formatted with fmt::format() when, and only if, the message text
+   * is needed: the arguments are copied into a compact binary string, or
+   * formatted immediately if canDeferLogFormat() is false for them.
+   *
+   * The formatSite argument must have static storage duration.
+   */
+  template <typename... Args>
+  LogStreamProcessor(
+      const LogCategory* category,
+      LogLevel level,
+      folly::StringPiece filename,
+      unsigned int lineNumber,
+      folly::StringPiece functionName,
+      DeferredFormatType,
+      DeferredLogFormatSite* formatSite,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept
+      : LogStreamProcessor(
+            category,
+            level,
+            filename,
+            lineNumber,
+            functionName,
+            APPEND) {
+    deferFormat(formatSite, fmt, args...);
+  }
+
   /*
    * Versions of the above constructors for use in XLOG() statements.
    *
@@ -182,6 +213,30 @@ class LogStreamProcessor {
             functionName,
             INTERNAL,
             formatLogString(fmt, std::forward<Args>(args)...)) {}
+  template <typename... Args>
+  LogStreamProcessor(
+      XlogCategoryInfo<true>* categoryInfo,
+      LogLevel level,
+      folly::StringPiece categoryName,
+      bool isCategoryNameOverridden,
+      folly::StringPiece filename,
+      unsigned int lineNumber,
+      folly::StringPiece functionName,
+      DeferredFormatType,
+      DeferredLogFormatSite* formatSite,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept
+      : LogStreamProcessor(
+            categoryInfo,
+            level,
+            categoryName,
+            isCategoryNameOverridden,
+            filename,
+            lineNumber,
+            functionName,
+            APPEND) {
+    deferFormat(formatSite, fmt, args...);
+  }
 
 #ifdef __INCLUDE_LEVEL__
   /*
@@ -256,6 +311,28 @@ class LogStreamProcessor {
             functionName,
             INTERNAL,
             formatLogString(fmt, std::forward<Args>(args)...)) {}
+  template <typename... Args>
+  LogStreamProcessor(
+      XlogFileScopeInfo* fileScopeInfo,
+      LogLevel level,
+      folly::StringPiece /* categoryName */,
+      bool /* isCategoryNameOverridden */,
+      folly::StringPiece filename,
+      unsigned int lineNumber,
+      folly::StringPiece functionName,
+      DeferredFormatType,
+      DeferredLogFormatSite* formatSite,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept
+      : LogStreamProcessor(
+            fileScopeInfo,
+            level,
+            filename,
+            lineNumber,
+            functionName,
+            APPEND) {
+    deferFormat(formatSite, fmt, args...);
+  }
 #endif
 
   ~LogStreamProcessor() noexcept;
@@ -382,12 +459,49 @@ class LogStreamProcessor {
     return result;
   }
 
+  template <typename... Args>
+  void deferFormat(
+      DeferredLogFormatSite* formatSite,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept {
+    deferFormat(
+        bool_constant<canDeferLogFormat<Args...>()>{},
+        formatSite,
+        fmt,
+        args...);
+  }
+
+  template <typename... Args>
+  FOLLY_NOINLINE void deferFormat(
+      std::true_type,
+      DeferredLogFormatSite* formatSite,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept {
+    deferredFormat_ = formatSite->get(fmt);
+    if (deferredFormat_) {
+      message_ = encodeDeferredLogArgs(args...);
+    } else {
+      message_ = formatLogString(fmt, args...);
+    }
+  }
+
+  template <typename... Args>
+  void deferFormat(
+      std::false_type,
+      DeferredLogFormatSite* /* formatSite */,
+      folly::StringPiece fmt,
+      const Args&... args) noexcept {
+    message_ = formatLogString(fmt, args...);
+  }
+
   const LogCategory* const category_;
   LogLevel const level_;
   folly::StringPiece filename_;
   unsigned int lineNumber_;
   folly::StringPiece functionName_;
+  // the encoded arguments of the message, if deferredFormat_ is set
   std::string message_;
+  const DeferredLogFormat* deferredFormat_{nullptr};
   LogStream stream_;
 };
 
@@ -21,6 +21,7 @@
 #include <cstdint>
 
 #include <folly/Chrono.h>
+#include <folly/TokenBucket.h>
 
 namespace folly {
 namespace logging {
@@ -65,5 +66,67 @@ class IntervalRateLimiter {
   std::atomic<clock::rep> timestamp_{0};
 };
 
+/**
+ * A rate limiter that admits events at a sustained rate of `rate` per second,
+ * with bursts of up to `burstSize` events, and that counts the events it
+ * rejects.
+ *
+ * An admitted event takes a token from the bucket.  A rejected event leaves
+ * the bucket alone and only increments the count of suppressed events.
+ */
+class TokenBucketRateLimiter {
+ public:
+  using Clock = double (*)();
+
+  TokenBucketRateLimiter(double rate, double burstSize)
+      : rate_{rate}, burstSize_{burstSize} {}
+
+  /**
+   * The clock read by check() when it is not given the time, in seconds.
+   * Tests can replace it to drive XLOG_TOKEN_BUCKET() by hand.
+   */
+  static std::atomic<Clock>& clock() {
+    static std::atomic<Clock> clock{&DynamicTokenBucket::defaultClockNow};
+    return clock;
+  }
+
+  bool check() {
+    return check(clock().load(std::memory_order_relaxed)());
+  }
+
+  /**
+   * Returns true if the event is admitted.  In that case
+   * lastSuppressedCount() is set to the number of events that were rejected
+   * since the previous one was admitted, for the calling thread to read.
+   */
+  bool check(double nowInSeconds) {
+    if (!bucket_.consume(1, rate_, burstSize_, nowInSeconds)) {
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    auto suppressed = suppressed_.load(std::memory_order_relaxed);
+    if (suppressed != 0) {
+      suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+    lastSuppressedCount() = suppressed;
+    return true;
+  }
+
+  /**
+   * The number of events suppressed before the last one that check()
+   * admitted in this thread, whichever limiter admitted it.
+   */
+  static uint64_t& lastSuppressedCount() {
+    static thread_local uint64_t count{0};
+    return count;
+  }
+
+ private:
+  const double rate_;
+  const double burstSize_;
+  DynamicTokenBucket bucket_;
+  std::atomic<uint64_t> suppressed_{0};
+};
+
 } // namespace logging
 } // namespace folly
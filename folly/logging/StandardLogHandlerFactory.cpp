@@ -18,6 +18,7 @@
 
 #include <folly/MapUtil.h>
 #include <folly/String.h>
+#include <folly/logging/BinaryLogFormatter.h>
 #include <folly/logging/CustomLogFormatter.h>
 #include <folly/logging/GlogStyleFormatter.h>
 #include <folly/logging/LogLevel.h>
@@ -41,6 +42,18 @@ class GlogFormatterFactory
   }
 };
 
+class BinaryLogFormatterFactory
+    : public StandardLogHandlerFactory::FormatterFactory {
+ public:
+  bool processOption(StringPiece /* name */, StringPiece /* value */) override {
+    return false;
+  }
+  std::shared_ptr<LogFormatter> createFormatter(
+      const std::shared_ptr<LogWriter>& /* logWriter */) override {
+    return std::make_shared<BinaryLogFormatter>();
+  }
+};
+
 class CustomLogFormatterFactory
     : public StandardLogHandlerFactory::FormatterFactory {
  public:
@@ -103,6 +116,8 @@ std::shared_ptr<StandardLogHandler> StandardLogHandlerFactory::createHandler(
     formatterFactory = std::make_unique<GlogFormatterFactory>();
   } else if (!formatterType || *formatterType == "custom") {
     formatterFactory = std::make_unique<CustomLogFormatterFactory>();
+  } else if (*formatterType == "binary") {
+    formatterFactory = std::make_unique<BinaryLogFormatterFactory>();
   } else {
     throw std::invalid_argument(
         to<string>("unknown log formatter type \"", *formatterType, "\""));
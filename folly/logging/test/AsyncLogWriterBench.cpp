@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/logging/AsyncLogWriter.h>
+#include <folly/portability/GFlags.h>
+
+DEFINE_int32(message_size, 64, "Size of the log messages");
+
+namespace folly {
+
+namespace {
+// An AsyncLogWriter whose I/O costs nothing, so that the benchmarks measure
+// how fast messages can be handed to the I/O thread.
+class NullLogWriter : public AsyncLogWriter {
+ public:
+  NullLogWriter() {
+    // Large enough that messages are never discarded
+    setMaxBufferSize(size_t(1) << 30);
+  }
+  ~NullLogWriter() override {
+    cleanup();
+  }
+
+  bool ttyOutput() const override {
+    return false;
+  }
+
+ private:
+  void performIO(std::vector<std::string>* logs, size_t) override {
+    doNotOptimizeAway(logs->size());
+  }
+};
+} // namespace
+
+// Log iters messages in total, as a burst from numThreads threads
+void runWriteMessageBench(size_t iters, size_t numThreads) {
+  BenchmarkSuspender braces;
+
+  NullLogWriter writer;
+  boost::barrier barrier(1 + numThreads);
+  std::vector<std::thread> threads(numThreads);
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads[t] = std::thread([&, t] {
+      std::string message(FLAGS_message_size, 'x');
+      // The first message of each thread registers its buffer
+      writer.writeMessage(message);
+
+      barrier.wait(); // A - wait for thread start
+
+      barrier.wait(); // B - init the work
+
+      for (size_t i = t; i < iters; i += numThreads) {
+        writer.writeMessage(message);
+      }
+
+      barrier.wait(); // C - join the work
+    });
+  }
+
+  barrier.wait(); // A - wait for thread start
+
+  // we want to exclude thread start/stop operations from measurement
+  braces.dismissing([&] {
+    barrier.wait(); // B - init the work
+    barrier.wait(); // C - join the work
+  });
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  writer.flush();
+}
+
+BENCHMARK_PARAM(runWriteMessageBench, 1)
+BENCHMARK_PARAM(runWriteMessageBench, 4)
+BENCHMARK_PARAM(runWriteMessageBench, 16)
+BENCHMARK_PARAM(runWriteMessageBench, 32)
+
+} // namespace folly
+
+int main(int argc, char** argv) {
+  folly::Init init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
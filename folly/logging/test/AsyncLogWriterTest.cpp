@@ -16,11 +16,18 @@
 
 #include <folly/logging/AsyncLogWriter.h>
 
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/logging/LoggerDB.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/PThread.h>
 #include <folly/test/TestUtils.h>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 using namespace folly;
 using namespace std::literals::chrono_literals;
@@ -46,8 +53,146 @@ class NoCleanUpLogWriter : public AsyncLogWriter {
     return false;
   }
 };
+
+class RecordingLogWriter : public AsyncLogWriter {
+ public:
+  ~RecordingLogWriter() override {
+    cleanup();
+  }
+
+  bool ttyOutput() const override {
+    return false;
+  }
+
+  std::vector<std::string> getMessages() {
+    return *messages_.lock();
+  }
+
+  size_t getNumDiscarded() {
+    return *numDiscarded_.lock();
+  }
+
+  // Make performIO() block until unblock() is called
+  void block() {
+    blocked_.lock();
+  }
+  void unblock() {
+    blocked_.unlock();
+  }
+
+  // Wait until the I/O thread has called performIO()
+  void waitForIO() {
+    ioStarted_.wait();
+  }
+
+ private:
+  void performIO(std::vector<std::string>* logs, size_t numDiscarded)
+      override {
+    if (!ioStartedPosted_.exchange(true)) {
+      ioStarted_.post();
+    }
+    std::lock_guard<std::mutex> guard(blocked_);
+    auto messages = messages_.lock();
+    for (auto& log : *logs) {
+      if (!log.empty()) {
+        messages->push_back(log);
+      }
+    }
+    *numDiscarded_.lock() += numDiscarded;
+  }
+
+  std::mutex blocked_;
+  folly::Baton<> ioStarted_;
+  std::atomic<bool> ioStartedPosted_{false};
+  folly::Synchronized<std::vector<std::string>, std::mutex> messages_;
+  folly::Synchronized<size_t, std::mutex> numDiscarded_{0};
+};
 } // namespace
 
+TEST(AsyncLogWriter, manyThreads) {
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kNumMessages = 5000;
+  std::vector<std::string> messages;
+  {
+    RecordingLogWriter writer;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kNumThreads; ++t) {
+      threads.emplace_back([&writer, t] {
+        for (size_t n = 0; n < kNumMessages; ++n) {
+          writer.writeMessage(folly::to<std::string>(t, " ", n));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    writer.flush();
+    messages = writer.getMessages();
+    EXPECT_EQ(0, writer.getNumDiscarded());
+  }
+
+  // Every message is written once, and the messages of each thread are
+  // written in order.
+  ASSERT_EQ(kNumThreads * kNumMessages, messages.size());
+  std::vector<size_t> next(kNumThreads, 0);
+  for (const auto& message : messages) {
+    size_t t;
+    size_t n;
+    folly::split(' ', message, t, n);
+    EXPECT_EQ(next[t], n);
+    next[t] = n + 1;
+  }
+}
+
+TEST(AsyncLogWriter, threadTeardown) {
+  static RecordingLogWriter* writer;
+  RecordingLogWriter recordingWriter;
+  writer = &recordingWriter;
+
+  // Messages logged by destructors that run during thread teardown should
+  // still be written.
+  std::thread thread([] {
+    writer->writeMessage(std::string("before"));
+    pthread_key_t key;
+    pthread_key_create(&key, [](void*) {
+      writer->writeMessage(std::string("teardown"));
+    });
+    pthread_setspecific(key, writer);
+  });
+  thread.join();
+
+  writer->flush();
+  EXPECT_THAT(
+      writer->getMessages(), testing::ElementsAre("before", "teardown"));
+}
+
+TEST(AsyncLogWriter, discard) {
+  RecordingLogWriter writer;
+  writer.setMaxBufferSize(100);
+  writer.block();
+
+  // Make sure the I/O thread is blocked in performIO(), so that nothing is
+  // written until we unblock it.
+  writer.writeMessage(std::string("first"));
+  writer.waitForIO();
+
+  std::thread thread([&] {
+    for (size_t n = 0; n < 1000; ++n) {
+      writer.writeMessage(std::string(10, 'x'));
+    }
+    writer.writeMessage(std::string("fatal"), LogWriter::NEVER_DISCARD);
+  });
+  thread.join();
+
+  writer.unblock();
+  writer.flush();
+  auto messages = writer.getMessages();
+  ASSERT_EQ(12, messages.size());
+  EXPECT_EQ("first", messages.front());
+  EXPECT_EQ("fatal", messages.back());
+  EXPECT_EQ(990, writer.getNumDiscarded());
+}
+
 TEST(AsyncLogWriterDeathTest, cleanupWarning) {
   bool flag;
   expectedMessage = &flag;
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/logging/BatchFileWriter.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using folly::test::TemporaryDirectory;
+using folly::test::TemporaryFile;
+
+namespace {
+std::string readLogFile(const std::string& path) {
+  std::string data;
+  if (!readFile(path.c_str(), data)) {
+    return "<missing>";
+  }
+  return data;
+}
+} // namespace
+
+TEST(BatchFileWriter, simpleMessages) {
+  TemporaryFile tmpFile{"logging_test"};
+  auto path = tmpFile.path().string();
+  ASSERT_EQ(4, writeFull(tmpFile.fd(), "old\n", 4));
+
+  std::string expected = "old\n";
+  {
+    BatchFileWriter writer{path};
+    for (int n = 0; n < 10; ++n) {
+      auto message = to<std::string>("message ", n, "\n");
+      writer.writeMessage(message);
+      expected += message;
+    }
+    writer.flush();
+    EXPECT_EQ(expected, readLogFile(path));
+
+    writer.writeMessage(std::string("last\n"));
+    expected += "last\n";
+  }
+  EXPECT_EQ(expected, readLogFile(path));
+}
+
+TEST(BatchFileWriter, largeMessages) {
+  TemporaryFile tmpFile{"logging_test"};
+  auto path = tmpFile.path().string();
+
+  BatchFileWriter::Options options;
+  options.bufferSize = 1;
+  std::string expected;
+  {
+    BatchFileWriter writer{path, options};
+    EXPECT_EQ(BatchFileWriter::kAlignment, writer.getOptions().bufferSize);
+    for (size_t n = 0; n < 20; ++n) {
+      // Messages smaller and larger than the buffer
+      auto message = std::string(n * 500, char('a' + n)) + "\n";
+      writer.writeMessage(message);
+      expected += message;
+    }
+  }
+  EXPECT_EQ(expected, readLogFile(path));
+}
+
+TEST(BatchFileWriter, sync) {
+  for (auto policy : {BatchFileWriter::SyncPolicy::NONE,
+                      BatchFileWriter::SyncPolicy::WRITEBACK,
+                      BatchFileWriter::SyncPolicy::DATASYNC}) {
+    for (size_t syncBytes : {0, 10, 1 << 20}) {
+      TemporaryFile tmpFile{"logging_test"};
+      auto path = tmpFile.path().string();
+
+      BatchFileWriter::Options options;
+      options.syncPolicy = policy;
+      options.syncBytes = syncBytes;
+      std::string expected;
+      {
+        BatchFileWriter writer{path, options};
+        for (int n = 0; n < 100; ++n) {
+          auto message = to<std::string>("message ", n, "\n");
+          writer.writeMessage(message);
+          expected += message;
+          if (n % 10 == 0) {
+            writer.flush();
+          }
+        }
+      }
+      EXPECT_EQ(expected, readLogFile(path));
+    }
+  }
+}
+
+TEST(BatchFileWriter, rotate) {
+  TemporaryDirectory tmpDir{"logging_test"};
+  auto path = (tmpDir.path() / "test.log").string();
+
+  BatchFileWriter::Options options;
+  options.rotateBytes = 100;
+  options.maxRotatedFiles = 2;
+  {
+    BatchFileWriter writer{path, options};
+    // Each flush() writes one batch, and the file is rotated before a batch
+    // that would make it too large.
+    for (int n = 0; n < 5; ++n) {
+      writer.writeMessage(std::string(60, char('a' + n)) + "\n");
+      writer.flush();
+    }
+  }
+  EXPECT_EQ(std::string(60, 'e') + "\n", readLogFile(path));
+  EXPECT_EQ(std::string(60, 'd') + "\n", readLogFile(path + ".1"));
+  EXPECT_EQ(std::string(60, 'c') + "\n", readLogFile(path + ".2"));
+  EXPECT_EQ("<missing>", readLogFile(path + ".3"));
+}
+
+TEST(BatchFileWriter, rotateWithoutKeepingFiles) {
+  TemporaryDirectory tmpDir{"logging_test"};
+  auto path = (tmpDir.path() / "test.log").string();
+
+  BatchFileWriter::Options options;
+  options.rotateBytes = 10;
+  options.maxRotatedFiles = 0;
+  {
+    BatchFileWriter writer{path, options};
+    writer.writeMessage(std::string("first message\n"));
+    writer.flush();
+    writer.writeMessage(std::string("second message\n"));
+  }
+  EXPECT_EQ("second message\n", readLogFile(path));
+  EXPECT_EQ("<missing>", readLogFile(path + ".1"));
+}
+
+TEST(BatchFileWriter, constructorErrors) {
+  TemporaryDirectory tmpDir{"logging_test"};
+  EXPECT_THROW(
+      BatchFileWriter((tmpDir.path() / "missing" / "test.log").string()),
+      std::system_error);
+
+  // Only files opened by path can be rotated
+  TemporaryFile tmpFile{"logging_test"};
+  BatchFileWriter::Options options;
+  options.rotateBytes = 1000;
+  EXPECT_THROW(
+      BatchFileWriter(File{tmpFile.fd(), false}, options),
+      std::invalid_argument);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Defer the formatting of the XLOGF() statements of this file.
+#define FOLLY_XLOG_DEFER_FORMAT 1
+
+#include <folly/logging/BinaryLogFormatter.h>
+
+#include <string_view>
+
+#include <fmt/core.h>
+#include <folly/logging/DeferredFormat.h>
+#include <folly/logging/LogConfigParser.h>
+#include <folly/logging/LogMessage.h>
+#include <folly/logging/LoggerDB.h>
+#include <folly/logging/test/TestLogHandler.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+using std::make_shared;
+using testing::MatchesRegex;
+
+XLOG_SET_CATEGORY_NAME("binary_log_test")
+
+namespace {
+class BinaryLogTest : public testing::Test {
+ public:
+  BinaryLogTest() {
+    auto config =
+        parseLogConfig(".=WARN:default; default=stream:stream=stderr");
+    LoggerDB::get().resetConfig(config);
+    LoggerDB::get().setLevel("binary_log_test", LogLevel::DBG9);
+    handler_ = make_shared<TestLogHandler>();
+    LoggerDB::get().getCategory("binary_log_test")->addHandler(handler_);
+  }
+
+ protected:
+  std::shared_ptr<TestLogHandler> handler_;
+};
+
+template <typename... Args>
+std::string formatDeferred(StringPiece format, const Args&... args) {
+  static_assert(canDeferLogFormat<Args...>(), "");
+  auto encoded = encodeDeferredLogArgs(args...);
+  return formatDeferredLogArgs(format, StringPiece{encoded});
+}
+} // namespace
+
+TEST(DeferredFormat, types) {
+  static_assert(canDeferLogFormat<>(), "");
+  static_assert(canDeferLogFormat<int, unsigned long, double>(), "");
+  static_assert(canDeferLogFormat<std::string, const char*, char[4]>(), "");
+  static_assert(!canDeferLogFormat<std::string_view>(), "");
+  static_assert(!canDeferLogFormat<int, int*>(), "");
+
+  std::string str = "string";
+  const void* ptr = &str;
+  EXPECT_EQ(
+      fmt::format(
+          "{} {} {} {} {} {} {} {} {}",
+          -5,
+          uint64_t(-1),
+          true,
+          'c',
+          2.5,
+          str,
+          "literal",
+          ptr,
+          int8_t(-1)),
+      formatDeferred(
+          "{} {} {} {} {} {} {} {} {}",
+          -5,
+          uint64_t(-1),
+          true,
+          'c',
+          2.5,
+          str,
+          "literal",
+          ptr,
+          int8_t(-1)));
+  EXPECT_EQ(
+      fmt::format("{:>6}|{:x}|{:.3f}|{:<4}|{:d}", "ab", 255, 1.0 / 3, 'c', 'c'),
+      formatDeferred(
+          "{:>6}|{:x}|{:.3f}|{:<4}|{:d}", "ab", 255, 1.0 / 3, 'c', 'c'));
+  // float is not formatted as a double
+  EXPECT_EQ(
+      fmt::format("{} {}", 0.1f, 0.1), formatDeferred("{} {}", 0.1f, 0.1));
+  EXPECT_EQ("b a", formatDeferred("{1} {0}", "a", "b"));
+  EXPECT_EQ("no arguments", formatDeferred("no arguments"));
+  const char* null = nullptr;
+  EXPECT_EQ("(null)", formatDeferred("{}", null));
+}
+
+TEST(DeferredFormat, errors) {
+  // The error message depends on the fmt version.
+  EXPECT_THAT(
+      formatDeferred("{}{}{}", 1, "a"),
+      MatchesRegex("error formatting log message: .*; format string: "
+                   "\"\\{\\}\\{\\}\\{\\}\", arguments: 1, a"));
+  EXPECT_EQ(
+      "error formatting log message: truncated log arguments; "
+      "format string: \"{}\", arguments: ",
+      formatDeferredLogArgs("{}", StringPiece{"\x05\x08"}.subpiece(0, 2)));
+}
+
+TEST_F(BinaryLogTest, deferredXlogf) {
+  auto& messages = handler_->getMessages();
+
+  XLOGF(INFO, "value {}: {:.1f}", 1, 0.25);
+  ASSERT_EQ(1, messages.size());
+  const auto& deferred = messages[0].first;
+  ASSERT_NE(nullptr, deferred.getDeferredFormat());
+  EXPECT_EQ("value {}: {:.1f}", deferred.getDeferredFormat()->getFormat());
+  EXPECT_EQ("value 1: 0.2", deferred.getMessage());
+  EXPECT_EQ("value 1: 0.2", deferred.getRawMessage());
+  EXPECT_FALSE(deferred.containsNewlines());
+
+  // Arguments that cannot be deferred
+  XLOGF(INFO, "{}", std::string_view("view"));
+  ASSERT_EQ(2, messages.size());
+  EXPECT_EQ(nullptr, messages[1].first.getDeferredFormat());
+  EXPECT_EQ("view", messages[1].first.getMessage());
+
+  // Streamed text
+  XLOGF(INFO, "{} and", "format") << " stream";
+  ASSERT_EQ(3, messages.size());
+  EXPECT_EQ(nullptr, messages[2].first.getDeferredFormat());
+  EXPECT_EQ("format and stream", messages[2].first.getMessage());
+
+  // Sanitization
+  XLOGF(INFO, "{}", "a\nb\x01");
+  ASSERT_EQ(4, messages.size());
+  EXPECT_TRUE(messages[3].first.containsNewlines());
+  EXPECT_EQ("a\nb\\x01", messages[3].first.getMessage());
+  EXPECT_EQ("a\nb\x01", messages[3].first.getRawMessage());
+
+  // The format string must be the same every time the statement runs for
+  // the formatting to be deferred.
+  std::vector<std::string> formats{"first {}", "second {}"};
+  for (const auto& format : formats) {
+    XLOGF(INFO, format, 5);
+  }
+  ASSERT_EQ(6, messages.size());
+  EXPECT_NE(nullptr, messages[4].first.getDeferredFormat());
+  EXPECT_EQ("first 5", messages[4].first.getMessage());
+  EXPECT_EQ(nullptr, messages[5].first.getDeferredFormat());
+  EXPECT_EQ("second 5", messages[5].first.getMessage());
+
+  // Even if it is in the same buffer every time
+  std::string format = "third {}";
+  for (auto prefix : {"third", "other"}) {
+    format.replace(0, 5, prefix);
+    XLOGF(INFO, format, 6);
+  }
+  ASSERT_EQ(8, messages.size());
+  EXPECT_NE(nullptr, messages[6].first.getDeferredFormat());
+  EXPECT_EQ("third 6", messages[6].first.getMessage());
+  EXPECT_EQ(nullptr, messages[7].first.getDeferredFormat());
+  EXPECT_EQ("other 6", messages[7].first.getMessage());
+}
+
+TEST_F(BinaryLogTest, formatter) {
+  auto& messages = handler_->getMessages();
+  for (int i = 0; i < 2; ++i) {
+    XLOGF(WARN, "message {} of {}", i, "binary log");
+  }
+  XLOG(ERR, "text");
+  ASSERT_EQ(3, messages.size());
+
+  BinaryLogFormatter formatter;
+  std::vector<std::string> records;
+  for (const auto& message : messages) {
+    records.push_back(formatter.formatMessage(message.first, message.second));
+  }
+  // The format string is only written once.
+  EXPECT_GT(records[0].size(), records[1].size());
+
+  // Records whose format string comes later, as happens when messages are
+  // logged concurrently, can be read too.
+  auto data = records[1] + records[0] + records[2];
+  auto read = readBinaryLogRecords(StringPiece{data});
+  ASSERT_EQ(3, read.size());
+  EXPECT_EQ("message 1 of binary log", read[0].message);
+  EXPECT_EQ("message 0 of binary log", read[1].message);
+  EXPECT_EQ("text", read[2].message);
+  for (size_t i = 0; i < read.size(); ++i) {
+    const auto& message = messages[i == 2 ? 2 : 1 - i].first;
+    EXPECT_EQ(message.getLevel(), read[i].level);
+    EXPECT_EQ(message.getTimestamp(), read[i].timestamp);
+    EXPECT_EQ(message.getThreadID(), read[i].threadID);
+    EXPECT_EQ("binary_log_test", read[i].categoryName);
+    EXPECT_EQ(message.getFileName(), read[i].filename);
+    EXPECT_EQ(message.getLineNumber(), read[i].lineNumber);
+    EXPECT_EQ(message.getFunctionName(), read[i].functionName);
+  }
+
+  // The formatter never formatted the deferred messages.
+  EXPECT_EQ(std::string::npos, data.find("message 0"));
+  EXPECT_EQ(std::string::npos, data.find("message 1"));
+
+  EXPECT_THROW(
+      readBinaryLogRecords(StringPiece{data}.subpiece(0, data.size() - 1)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      readBinaryLogRecords(StringPiece{records[1]}), std::invalid_argument);
+}
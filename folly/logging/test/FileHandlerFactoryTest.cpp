@@ -20,6 +20,7 @@
 #include <folly/Exception.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/logging/AsyncFileWriter.h>
+#include <folly/logging/BatchFileWriter.h>
 #include <folly/logging/GlogStyleFormatter.h>
 #include <folly/logging/ImmediateFileWriter.h>
 #include <folly/logging/StandardLogHandler.h>
@@ -149,6 +150,35 @@ TEST(FileHandlerFactory, pathWithMaxBufferSize) {
       stdHandler->getWriter().get(), tmpFile.path().string().c_str(), 4096000);
 }
 
+TEST(FileHandlerFactory, batch) {
+  FileHandlerFactory factory;
+
+  TemporaryFile tmpFile{"logging_test"};
+  auto options = LogHandlerFactory::Options{
+      make_pair("path", tmpFile.path().string()),
+      make_pair("max_buffer_size", "4096000"),
+      make_pair("sync", "datasync"),
+      make_pair("sync_bytes", "0"),
+      make_pair("rotate_bytes", "1000000"),
+      make_pair("rotate_count", "2"),
+  };
+  auto handler = factory.createHandler(options);
+
+  auto stdHandler = std::dynamic_pointer_cast<StandardLogHandler>(handler);
+  ASSERT_TRUE(stdHandler);
+
+  auto writer =
+      std::dynamic_pointer_cast<BatchFileWriter>(stdHandler->getWriter());
+  ASSERT_TRUE(writer)
+      << "handler factory should have created a BatchFileWriter";
+  EXPECT_EQ(4096000, writer->getMaxBufferSize());
+  EXPECT_EQ(
+      BatchFileWriter::SyncPolicy::DATASYNC, writer->getOptions().syncPolicy);
+  EXPECT_EQ(0, writer->getOptions().syncBytes);
+  EXPECT_EQ(1000000, writer->getOptions().rotateBytes);
+  EXPECT_EQ(2, writer->getOptions().maxRotatedFiles);
+}
+
 TEST(StreamHandlerFactory, nonAsyncStderr) {
   StreamHandlerFactory factory;
 
@@ -254,6 +284,42 @@ TEST(FileHandlerFactory, errors) {
         "must be a positive integer$");
   }
 
+  {
+    auto options = Options{
+        {"path", tmpFile.path().string()},
+        {"sync", "sometimes"},
+    };
+    EXPECT_THROW_RE(
+        factory.createHandler(options),
+        std::invalid_argument,
+        "^error processing option \"sync\": unknown sync policy "
+        "\"sometimes\"");
+  }
+
+  {
+    auto options = Options{
+        {"path", tmpFile.path().string()},
+        {"async", "false"},
+        {"batch", "true"},
+    };
+    EXPECT_THROW_RE(
+        factory.createHandler(options),
+        std::invalid_argument,
+        "batched file handlers cannot be used with \"async=false\"");
+  }
+
+  {
+    auto options = Options{
+        {"path", tmpFile.path().string()},
+        {"batch", "false"},
+        {"sync", "none"},
+    };
+    EXPECT_THROW_RE(
+        factory.createHandler(options),
+        std::invalid_argument,
+        "batched file handler options cannot be used with \"batch=false\"");
+  }
+
   {
     auto options = Options{
         {"path", tmpFile.path().string()},
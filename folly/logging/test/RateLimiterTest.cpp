@@ -119,3 +119,32 @@ TEST(RateLimiter, concurrentThreads) {
   // We should have passed the check exactly maxEvents times
   EXPECT_EQ(maxEvents, count.load(std::memory_order_relaxed));
 }
+
+TEST(RateLimiter, tokenBucket) {
+  using folly::logging::TokenBucketRateLimiter;
+
+  // 2 events per second, in bursts of up to 3
+  TokenBucketRateLimiter limiter{2, 3};
+  double now = 100;
+  for (int n = 0; n < 3; ++n) {
+    EXPECT_TRUE(limiter.check(now)) << "event " << n;
+    EXPECT_EQ(0, TokenBucketRateLimiter::lastSuppressedCount());
+  }
+  for (int n = 0; n < 10; ++n) {
+    EXPECT_FALSE(limiter.check(now)) << "event " << n;
+  }
+
+  // One more token after half a second
+  now += 0.5;
+  EXPECT_TRUE(limiter.check(now));
+  EXPECT_EQ(10, TokenBucketRateLimiter::lastSuppressedCount());
+  EXPECT_FALSE(limiter.check(now));
+
+  // The bucket never holds more than the burst size
+  now += 100;
+  for (int n = 0; n < 3; ++n) {
+    EXPECT_TRUE(limiter.check(now)) << "event " << n;
+  }
+  EXPECT_EQ(0, TokenBucketRateLimiter::lastSuppressedCount());
+  EXPECT_FALSE(limiter.check(now));
+}
@@ -16,6 +16,7 @@
 
 #include <folly/logging/xlog.h>
 
+#include <folly/ScopeGuard.h>
 #include <folly/logging/LogConfigParser.h>
 #include <folly/logging/LogHandler.h>
 #include <folly/logging/LogMessage.h>
@@ -183,6 +184,44 @@ TEST_F(XlogTest, xlog) {
   messages.clear();
 }
 
+// FOLLY_XLOG_MIN_LEVEL is checked where XLOG() statements are expanded, so
+// it can be changed for the following test only.
+#undef FOLLY_XLOG_MIN_LEVEL
+#define FOLLY_XLOG_MIN_LEVEL INFO
+
+TEST_F(XlogTest, minLevel) {
+  auto handler = make_shared<TestLogHandler>();
+  LoggerDB::get().getCategory("xlog_test")->addHandler(handler);
+  auto& messages = handler->getMessages();
+  LoggerDB::get().setLevel("xlog_test.main_file", LogLevel::DBG9);
+
+  static_assert(!xlogIsCompiledIn(LogLevel::DBG0, LogLevel::INFO), "");
+  static_assert(xlogIsCompiledIn(LogLevel::INFO, LogLevel::INFO), "");
+  static_assert(xlogIsCompiledIn(LogLevel::FATAL, LogLevel::MAX_LEVEL), "");
+  EXPECT_FALSE(XLOG_IS_ON(DBG0));
+  EXPECT_TRUE(XLOG_IS_ON(INFO));
+
+  // Arguments of compiled out statements are not evaluated
+  int evaluated = 0;
+  auto arg = [&] { return ++evaluated; };
+  XLOG(DBG0, "compiled out ", arg());
+  XLOGF(DBG5, "compiled out {}", arg());
+  XLOG_IF(DBG1, arg() > 0, "compiled out");
+  XLOG(DBG0) << "compiled out " << arg();
+  EXPECT_EQ(0, evaluated);
+  EXPECT_EQ(0, messages.size());
+
+  XLOG(INFO, "compiled in ", arg());
+  XLOG(WARN) << "compiled in " << arg();
+  EXPECT_EQ(2, evaluated);
+  ASSERT_EQ(2, messages.size());
+  EXPECT_EQ("compiled in 1", messages[0].first.getMessage());
+  EXPECT_EQ("compiled in 2", messages[1].first.getMessage());
+}
+
+#undef FOLLY_XLOG_MIN_LEVEL
+#define FOLLY_XLOG_MIN_LEVEL MIN_LEVEL
+
 TEST_F(XlogTest, perFileCategoryHandling) {
   using namespace logging_test;
 
@@ -370,6 +409,62 @@ TEST_F(XlogTest, rateLimiting) {
   handler->clearMessages();
 }
 
+TEST_F(XlogTest, rateLimitingPerThread) {
+  auto handler = make_shared<TestLogHandler>();
+  LoggerDB::get().getCategory("xlog_test")->addHandler(handler);
+  LoggerDB::get().setLevel("xlog_test", LogLevel::DBG1);
+
+  auto logMessages = [](int thread) {
+    for (size_t n = 0; n < 10; ++n) {
+      XLOG_EVERY_MS_THREAD(DBG1, 100000, "thread ", thread, " msg ", n);
+    }
+  };
+  logMessages(0);
+  std::thread([&] { logMessages(1); }).join();
+  logMessages(0);
+  EXPECT_THAT(
+      handler->getMessageValues(),
+      ElementsAre("thread 0 msg 0", "thread 1 msg 0"));
+  handler->clearMessages();
+}
+
+TEST_F(XlogTest, rateLimitingTokenBucket) {
+  auto handler = make_shared<TestLogHandler>();
+  LoggerDB::get().getCategory("xlog_test")->addHandler(handler);
+  LoggerDB::get().setLevel("xlog_test", LogLevel::DBG1);
+
+  using logging::TokenBucketRateLimiter;
+  static double now = 100;
+  auto origClock = TokenBucketRateLimiter::clock().exchange([] { return now; });
+  SCOPE_EXIT {
+    TokenBucketRateLimiter::clock().store(origClock);
+  };
+
+  // Bursts of 2 messages, then a message every 250ms
+  auto logMessages = [](size_t count) {
+    for (size_t n = 0; n < count; ++n) {
+      XLOG_TOKEN_BUCKET(DBG1, 4, 2, "msg ", n);
+    }
+  };
+  logMessages(10);
+  EXPECT_THAT(handler->getMessageValues(), ElementsAre("msg 0", "msg 1"));
+  handler->clearMessages();
+
+  now += 0.25;
+  logMessages(2);
+  EXPECT_THAT(
+      handler->getMessageValues(),
+      ElementsAre("[8 messages suppressed] msg 0"));
+  handler->clearMessages();
+
+  // Stream arguments follow the prefix
+  for (int n = 0; n < 3; ++n) {
+    XLOG_TOKEN_BUCKET(DBG1, 20, 1) << "stream " << n;
+  }
+  EXPECT_THAT(handler->getMessageValues(), ElementsAre("stream 0"));
+  handler->clearMessages();
+}
+
 TEST_F(XlogTest, rateLimitingEndOfThread) {
   auto handler = make_shared<TestLogHandler>();
   LoggerDB::get().getCategory("xlog_test")->addHandler(handler);
@@ -441,6 +536,35 @@ TEST_F(XlogTest, getXlogCategoryName) {
           "buck-out/gen/foo/bar#header-map,headers/foo/bar/test.h")));
 }
 
+TEST_F(XlogTest, constexprCategoryName) {
+  static_assert(
+      xlogCanonicalCategoryName<16>("src/test/foo.cpp", true) ==
+          "src.test.foo.cpp",
+      "");
+  static_assert(
+      xlogCanonicalCategoryName<20>("..src//test/foo.h/..", false) ==
+          "src.test.foo.h",
+      "");
+
+  constexpr auto name = XLOG_GET_CONSTEXPR_CATEGORY_NAME();
+  EXPECT_EQ("xlog_test.main_file", name);
+
+  // The names should match the canonical getXlogCategoryNameForFile() ones
+  for (StringPiece filename : {
+           "foo.cpp",
+           "/src/test/foo.cpp",
+           "src\\test\\foo.h",
+           "buck-out/gen/myproject#headers/myproject/generated_header.h",
+           "buck-out/gen/foo/bar#header-map,headers/foo/bar/test.h",
+           "buck-out/gen/foo/bar/test.h",
+       }) {
+    EXPECT_EQ(
+        LogName::canonicalize(getXlogCategoryNameForFile(filename)),
+        xlogCanonicalCategoryName<64>(filename, true).toStdString())
+        << filename;
+  }
+}
+
 TEST(Xlog, xlogStripFilename) {
   EXPECT_STREQ("c/d.txt", xlogStripFilename("/a/b/c/d.txt", "/a/b"));
   EXPECT_STREQ("c/d.txt", xlogStripFilename("/a/b/c/d.txt", "/a/b/"));
@@ -19,6 +19,7 @@
 #include <type_traits>
 #include <unordered_map>
 
+#include <folly/Conv.h>
 #include <folly/Synchronized.h>
 #include <folly/portability/PThread.h>
 
@@ -53,6 +54,14 @@ size_t& xlogEveryNThreadEntry(void const* const key) {
   }
   return (*map)[key];
 }
+
+std::string xlogSuppressedMessagesPrefix() {
+  auto count = logging::TokenBucketRateLimiter::lastSuppressedCount();
+  if (count == 0) {
+    return std::string();
+  }
+  return to<std::string>("[", count, " messages suppressed] ");
+}
 } // namespace detail
 
 namespace {
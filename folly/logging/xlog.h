@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <folly/FixedString.h>
 #include <folly/Likely.h>
 #include <folly/Portability.h>
 #include <folly/Range.h>
@@ -76,13 +77,9 @@
 /**
  * Log a message to this file's default log category, using a format string.
  */
-#define XLOGF(level, fmt, arg1, ...)       \
-  XLOG_IMPL(                               \
-      ::folly::LogLevel::level,            \
-      ::folly::LogStreamProcessor::FORMAT, \
-      fmt,                                 \
-      arg1,                                \
-      ##__VA_ARGS__)
+#define XLOGF(level, fmt, arg1, ...) \
+  XLOG_IMPL(                         \
+      ::folly::LogLevel::level, XLOG_FORMAT_ARGS(fmt), arg1, ##__VA_ARGS__)
 
 /**
  * Log a message using a format string if and only if the specified condition
@@ -93,8 +90,7 @@
   XLOG_IF_IMPL(                               \
       ::folly::LogLevel::level,               \
       cond,                                   \
-      ::folly::LogStreamProcessor::FORMAT,    \
-      fmt,                                    \
+      XLOG_FORMAT_ARGS(fmt),                  \
       arg1,                                   \
       ##__VA_ARGS__)
 
@@ -234,6 +230,79 @@ FOLLY_EXPORT FOLLY_ALWAYS_INLINE bool xlogEveryNThreadImpl(size_t n) {
         return folly_detail_xlog_limiter.check();                              \
       }(),                                                                     \
       ##__VA_ARGS__)
+
+namespace folly {
+namespace detail {
+
+template <typename Tag>
+FOLLY_EXPORT bool xlogEveryMsThreadImpl(std::chrono::milliseconds ms) {
+  static char key;
+  // The time of the last message, or 0 if none was logged yet
+  auto& last = xlogEveryNThreadEntry(&key);
+  auto now = static_cast<size_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          chrono::coarse_steady_clock::now().time_since_epoch())
+          .count() +
+      1);
+  if (last != 0 && now < last + static_cast<size_t>(ms.count())) {
+    return false;
+  }
+  last = now;
+  return true;
+}
+
+/**
+ * "[<N> messages suppressed] " if the last message admitted by a
+ * TokenBucketRateLimiter in this thread was preceded by N > 0 suppressed
+ * ones, or an empty string.
+ */
+std::string xlogSuppressedMessagesPrefix();
+
+} // namespace detail
+} // namespace folly
+
+/**
+ * Similar to XLOG(...) except only log a message every @param ms
+ * milliseconds per thread.
+ *
+ * Unlike XLOG_EVERY_MS(), which shares an atomic counter between all the
+ * threads that invoke the expansion, this only touches thread-local state,
+ * at the cost of reading the (coarse) clock on every invocation.
+ */
+#define XLOG_EVERY_MS_THREAD(level, ms, ...)                                  \
+  XLOG_IF(                                                                    \
+      level,                                                                  \
+      [] {                                                                    \
+        struct folly_detail_xlog_tag {};                                      \
+        return ::folly::detail::xlogEveryMsThreadImpl<folly_detail_xlog_tag>( \
+            std::chrono::milliseconds(ms));                                   \
+      }(),                                                                    \
+      ##__VA_ARGS__)
+
+/**
+ * Similar to XLOG(...) except that messages are admitted by a token bucket:
+ * at most @param burst messages at once, and @param rate messages per second
+ * on average.
+ *
+ * Each admitted message is prefixed with the number of messages that were
+ * suppressed since the previous one, if any, e.g.
+ * "[42 messages suppressed] connection failed".
+ *
+ * The token bucket is process-global and threadsafe.  Suppressed messages
+ * cost a clock read, a read of the bucket and an atomic increment, but are
+ * never formatted.  The clock is TokenBucketRateLimiter::clock().
+ */
+#define XLOG_TOKEN_BUCKET(level, rate, burst, ...)              \
+  XLOG_IF(                                                      \
+      level,                                                    \
+      [] {                                                      \
+        static ::folly::logging::TokenBucketRateLimiter         \
+            folly_detail_xlog_limiter((rate), (burst));         \
+        return folly_detail_xlog_limiter.check();               \
+      }(),                                                      \
+      ::folly::detail::xlogSuppressedMessagesPrefix(),          \
+      ##__VA_ARGS__)
+
 /**
  * FOLLY_XLOG_STRIP_PREFIXES can be defined to a string containing a
  * colon-separated list of directory prefixes to strip off from the filename
@@ -252,6 +321,47 @@ FOLLY_EXPORT FOLLY_ALWAYS_INLINE bool xlogEveryNThreadImpl(size_t n) {
 #define XLOG_FILENAME __FILE__
 #endif
 
+/**
+ * FOLLY_XLOG_DEFER_FORMAT can be defined to 1 to make XLOGF() statements
+ * defer formatting their messages until a LogFormatter needs their text.
+ *
+ * The logging thread then only copies the arguments into a compact binary
+ * string, unless some of them are of types that canDeferLogFormat() does
+ * not support.  Text formatters still format messages on the logging
+ * thread, but BinaryLogFormatter never does: it writes the format string ID
+ * and the encoded arguments, and the messages are formatted when the log is
+ * read.
+ */
+#ifndef FOLLY_XLOG_DEFER_FORMAT
+#define FOLLY_XLOG_DEFER_FORMAT 0
+#endif
+
+#if FOLLY_XLOG_DEFER_FORMAT
+#define XLOG_FORMAT_ARGS(fmt)                                        \
+  ::folly::LogStreamProcessor::DEFERRED_FORMAT, [] {                 \
+    static ::folly::DeferredLogFormatSite folly_detail_xlog_format;  \
+    return &folly_detail_xlog_format;                                \
+  }(),                                                               \
+      fmt
+#else
+#define XLOG_FORMAT_ARGS(fmt) ::folly::LogStreamProcessor::FORMAT, fmt
+#endif
+
+/**
+ * FOLLY_XLOG_MIN_LEVEL can be defined to the name of a LogLevel, such as
+ * INFO, to compile out all XLOG() statements with lower levels.
+ *
+ * XLOG_IS_ON() is then a compile-time false for these levels, so the
+ * optimizer drops the statements and their arguments entirely: they do not
+ * even load the category's level.  Fatal levels are never compiled out.
+ * The statements are still parsed, so they cannot bit rot.
+ *
+ * By default nothing is compiled out.
+ */
+#ifndef FOLLY_XLOG_MIN_LEVEL
+#define FOLLY_XLOG_MIN_LEVEL MIN_LEVEL
+#endif
+
 #define XLOG_IMPL(level, type, ...) \
   XLOG_ACTUAL_IMPL(                 \
       level, true, ::folly::isLogLevelFatal(level), type, ##__VA_ARGS__)
@@ -345,16 +455,18 @@ FOLLY_EXPORT FOLLY_ALWAYS_INLINE bool xlogEveryNThreadImpl(size_t n) {
  *
  * See XlogLevelInfo for the implementation details.
  */
-#define XLOG_IS_ON_IMPL(level)                              \
-  ([] {                                                     \
-    static ::folly::XlogLevelInfo<XLOG_IS_IN_HEADER_FILE>   \
-        folly_detail_xlog_level;                            \
-    return folly_detail_xlog_level.check(                   \
-        (level),                                            \
-        xlog_detail::getXlogCategoryName(XLOG_FILENAME, 0), \
-        xlog_detail::isXlogCategoryOverridden(0),           \
-        &xlog_detail::xlogFileScopeInfo);                   \
-  }())
+#define XLOG_IS_ON_IMPL(level)                                               \
+  (::folly::xlogIsCompiledIn(                                                \
+       (level), ::folly::LogLevel::FOLLY_XLOG_MIN_LEVEL) &&                  \
+   [] {                                                                      \
+     static ::folly::XlogLevelInfo<XLOG_IS_IN_HEADER_FILE>                   \
+         folly_detail_xlog_level;                                            \
+     return folly_detail_xlog_level.check(                                   \
+         (level),                                                            \
+         xlog_detail::getXlogCategoryName(XLOG_FILENAME, 0),                 \
+         xlog_detail::isXlogCategoryOverridden(0),                           \
+         &xlog_detail::xlogFileScopeInfo);                                   \
+   }())
 
 /**
  * Get the name of the log category that will be used by XLOG() statements
@@ -365,6 +477,19 @@ FOLLY_EXPORT FOLLY_ALWAYS_INLINE bool xlogEveryNThreadImpl(size_t n) {
        ? xlog_detail::getXlogCategoryName(XLOG_FILENAME, 0) \
        : ::folly::getXlogCategoryNameForFile(XLOG_FILENAME))
 
+/**
+ * Get the canonical name of the log category that will be used by XLOG()
+ * statements in this file, as a FixedString computed at compile time.
+ *
+ * Unlike XLOG_GET_CATEGORY_NAME(), the name is canonicalized the way
+ * LoggerDB does it, with dots as separators.
+ */
+#define XLOG_GET_CONSTEXPR_CATEGORY_NAME()                                  \
+  ::folly::xlogCanonicalCategoryName<                                       \
+      xlog_detail::getXlogCategoryName(XLOG_FILENAME, 0).size()>(           \
+      xlog_detail::getXlogCategoryName(XLOG_FILENAME, 0),                   \
+      !xlog_detail::isXlogCategoryOverridden(0))
+
 /**
  * Get a pointer to the LogCategory that will be used by XLOG() statements in
  * this file.
@@ -671,10 +796,91 @@ class XlogCategoryInfo<false> {
  */
 folly::StringPiece getXlogCategoryNameForFile(folly::StringPiece filename);
 
+/**
+ * Whether XLOG() statements with the given level are compiled in when
+ * FOLLY_XLOG_MIN_LEVEL is minLevel.
+ */
+constexpr bool xlogIsCompiledIn(LogLevel level, LogLevel minLevel) {
+  return level >= minLevel || isLogLevelFatal(level);
+}
+
 constexpr bool xlogIsDirSeparator(char c) {
   return c == '/' || (kIsWindows && c == '\\');
 }
 
+namespace detail {
+constexpr bool xlogIsCategorySeparator(char c) {
+  return c == '.' || c == '/' || c == '\\';
+}
+
+/*
+ * The length of the buck-out directory prefix that
+ * getXlogCategoryNameForFile() strips off the filename, if any: everything up
+ * to and including the first path component that contains a '#'.
+ */
+constexpr size_t xlogBuckOutPrefixLength(const char* filename, size_t size) {
+  constexpr char buckOut[] = "buck-out/";
+  constexpr size_t buckOutLength = sizeof(buckOut) - 1;
+  if (size < buckOutLength) {
+    return 0;
+  }
+  for (size_t idx = 0; idx < buckOutLength; ++idx) {
+    if (filename[idx] != buckOut[idx]) {
+      return 0;
+    }
+  }
+  bool componentHasHash = false;
+  for (size_t idx = buckOutLength; idx < size; ++idx) {
+    if (filename[idx] == '/') {
+      if (componentHasHash) {
+        return idx + 1;
+      }
+    } else if (filename[idx] == '#') {
+      componentHasHash = true;
+    }
+  }
+  return 0;
+}
+} // namespace detail
+
+/**
+ * Compute a canonical log category name at compile time.
+ *
+ * If isFilename is true, name is a filename, and the result is the canonical
+ * form of getXlogCategoryNameForFile(name).  Otherwise the result is just the
+ * canonical form of name, as computed by LogName::canonicalize().
+ *
+ * N is the capacity of the result, which must be at least name.size().
+ */
+template <size_t N>
+constexpr FixedString<N> xlogCanonicalCategoryName(
+    folly::StringPiece name,
+    bool isFilename) {
+  const char* data = name.data();
+  size_t start =
+      isFilename ? detail::xlogBuckOutPrefixLength(data, name.size()) : 0;
+  size_t end = name.size();
+  // Ignore trailing category separator characters
+  while (end > start && detail::xlogIsCategorySeparator(data[end - 1])) {
+    --end;
+  }
+
+  FixedString<N> result;
+  bool ignoreSeparator = true;
+  for (size_t idx = start; idx < end; ++idx) {
+    if (detail::xlogIsCategorySeparator(data[idx])) {
+      if (!ignoreSeparator) {
+        result.push_back('.');
+        ignoreSeparator = true;
+      }
+    } else {
+      result.push_back(data[idx]);
+      ignoreSeparator = false;
+    }
+  }
+  return result;
+}
+
 namespace detail {
 constexpr const char* xlogStripFilenameRecursive(
     const char* filename,
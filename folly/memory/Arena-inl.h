@@ -31,13 +31,14 @@ Arena<Alloc>::Block::allocate(Alloc& alloc, size_t size, bool allowSlack) {
   }
 
   void* mem = std::allocator_traits<Alloc>::allocate(alloc, allocSize);
-  return std::make_pair(new (mem) Block(), allocSize - sizeof(Block));
+  return std::make_pair(new (mem) Block(allocSize), allocSize - sizeof(Block));
 }
 
 template <class Alloc>
 void Arena<Alloc>::Block::deallocate(Alloc& alloc) {
+  auto const size = bytes;
   this->~Block();
-  std::allocator_traits<Alloc>::deallocate(alloc, this, 1);
+  std::allocator_traits<Alloc>::deallocate(alloc, this, size);
 }
 
 template <class Alloc>
@@ -85,6 +86,29 @@ void Arena<Alloc>::merge(Arena<Alloc>&& other) {
   other.totalAllocatedSize_ = 0;
 }
 
+template <class Alloc>
+void Arena<Alloc>::clear() {
+  BlockList kept;
+  while (!blocks_.empty()) {
+    Block& block = blocks_.front();
+    blocks_.pop_front();
+    if (kept.empty() && end_ && block.start() + block.size() == end_) {
+      kept.push_front(block);
+    } else {
+      block.deallocate(alloc());
+    }
+  }
+  blocks_.swap(kept);
+  if (blocks_.empty()) {
+    ptr_ = end_ = nullptr;
+    totalAllocatedSize_ = 0;
+  } else {
+    ptr_ = blocks_.front().start();
+    totalAllocatedSize_ = blocks_.front().size() + sizeof(Block);
+  }
+  bytesUsed_ = 0;
+}
+
 template <class Alloc>
 Arena<Alloc>::~Arena() {
   auto disposer = [this](Block* b) { b->deallocate(this->alloc()); };
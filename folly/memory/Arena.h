@@ -31,6 +31,7 @@
 #include <folly/lang/CheckedMath.h>
 #include <folly/lang/Exception.h>
 #include <folly/memory/Malloc.h>
+#include <folly/memory/MemoryResource.h>
 
 namespace folly {
 
@@ -106,6 +107,11 @@ class Arena {
   // Transfer ownership of all memory allocated from "other" to "this".
   void merge(Arena&& other);
 
+  // Free all memory allocated from the arena, except for the block that is
+  // currently being filled, which is kept for further allocations. This is
+  // constant time when everything fits in that block.
+  void clear();
+
   // Gets the total memory used by the arena
   size_t totalSize() const {
     return totalAllocatedSize_ + sizeof(Arena);
@@ -144,10 +150,17 @@ class Arena {
     char* start() {
       return reinterpret_cast<char*>(this + 1);
     }
+    size_t size() const {
+      return bytes - sizeof(Block);
+    }
 
    private:
-    Block() = default;
+    explicit Block(size_t size) : bytes(size) {}
     ~Block() = default;
+
+    // the size passed to the allocator, including the Block itself; fits
+    // in the padding to max_align_v
+    size_t bytes;
   };
 
  public:
@@ -255,6 +268,57 @@ using ArenaAllocator = CxxAllocatorAdaptor<T, Arena<Alloc>>;
 template <typename T>
 using SysArenaAllocator = ArenaAllocator<T, SysAllocator<void>>;
 
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+/**
+ * A std::pmr memory resource that allocates from an arena, such as a
+ * SysArena or a ThreadCachedArena, which must outlive it.  Containers
+ * that use it through a polymorphic_allocator (folly::pmr::F14ValueMap,
+ * folly::pmr::small_vector, folly::pmr::sorted_vector_map, ...) never
+ * free their memory; it is all freed at once with the arena.
+ *
+ *   SysArena arena;
+ *   SysArenaMemoryResource resource(arena);
+ *   folly::pmr::F14FastMap<int, int> map(&resource);
+ */
+template <class ArenaT>
+class ArenaMemoryResource : public detail::std_pmr::memory_resource {
+ public:
+  explicit ArenaMemoryResource(ArenaT& arena) : arena_(arena) {}
+
+  ArenaT& arena() const {
+    return arena_;
+  }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    // Arenas align their allocations to their maxAlign, which the
+    // caller may not know; over-aligned allocations need a retry.
+    auto p = arena_.allocate(bytes);
+    if (reinterpret_cast<uintptr_t>(p) % alignment == 0) {
+      return p;
+    }
+    auto raw = reinterpret_cast<uintptr_t>(
+        arena_.allocate(bytes + alignment - 1));
+    return reinterpret_cast<void*>((raw + alignment - 1) & ~(alignment - 1));
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t) override {
+    arena_.deallocate(p, bytes);
+  }
+
+  bool do_is_equal(
+      const detail::std_pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  ArenaT& arena_;
+};
+
+using SysArenaMemoryResource = ArenaMemoryResource<SysArena>;
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
 } // namespace folly
 
 #include <folly/memory/Arena-inl.h>
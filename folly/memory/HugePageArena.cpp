@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/memory/HugePageArena.h>
+
+#include <cstdint>
+#include <new>
+
+#include <folly/lang/Exception.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/Unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace folly {
+
+namespace {
+
+constexpr size_t kHugePageSize = HugePageArenaAllocator::kHugePageSize;
+
+// Maps size bytes aligned to kHugePageSize, by over-allocating and
+// trimming, and advises the kernel to use transparent huge pages for them.
+void* mapTransparent(size_t size) {
+  auto const mapSize = size + kHugePageSize;
+  void* p = mmap(
+      nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+      0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  auto const begin = reinterpret_cast<uintptr_t>(p);
+  auto const aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  if (aligned > begin) {
+    munmap(p, aligned - begin);
+  }
+  auto const tail = begin + mapSize - (aligned + size);
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + size), tail);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void*>(aligned);
+}
+
+void* mapHugeTlb(size_t size) {
+#ifdef MAP_HUGETLB
+  void* p = mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+      -1,
+      0);
+  if (p != MAP_FAILED) {
+    return p;
+  }
+#endif
+  return mapTransparent(size);
+}
+
+void bindToNode(void* p, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  // from <numaif.h>, which needs libnuma
+  constexpr int kMpolBind = 2;
+  constexpr size_t kBitsPerMask = 8 * sizeof(unsigned long);
+  constexpr size_t kMaxNodes = 1024;
+  if (size_t(node) >= kMaxNodes) {
+    return;
+  }
+  unsigned long mask[kMaxNodes / kBitsPerMask] = {};
+  mask[node / kBitsPerMask] = 1UL << (node % kBitsPerMask);
+  // best effort: the pages are usable on any node if this fails
+  syscall(SYS_mbind, p, size, kMpolBind, mask, kMaxNodes + 1, 0);
+#else
+  (void)p;
+  (void)size;
+  (void)node;
+#endif
+}
+
+} // namespace
+
+void* HugePageArenaAllocator::allocate(size_t size) {
+  size = goodSize(size);
+  void* p = options_.mode == Mode::HugeTlb ? mapHugeTlb(size)
+                                           : mapTransparent(size);
+  if (!p) {
+    throw_exception<std::bad_alloc>();
+  }
+  if (options_.numaNode >= 0) {
+    bindToNode(p, size, options_.numaNode);
+  }
+  return p;
+}
+
+void HugePageArenaAllocator::deallocate(void* p, size_t size) {
+  munmap(p, goodSize(size));
+}
+
+} // namespace folly
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include <folly/experimental/JemallocHugePageAllocator.h>
+#include <folly/memory/Arena.h>
+
+namespace folly {
+
+/**
+ * Allocator of arena blocks backed by huge pages, mapped with mmap:
+ *
+ * - Mode::Transparent maps 2MB-aligned memory and advises the kernel to
+ *   back it with transparent huge pages (MADV_HUGEPAGE), which works when
+ *   /sys/kernel/mm/transparent_hugepage/enabled is "always" or "madvise";
+ * - Mode::HugeTlb maps it with MAP_HUGETLB from the pool of reserved huge
+ *   pages (/proc/sys/vm/nr_hugepages), falling back to Mode::Transparent
+ *   when the pool is exhausted.
+ *
+ * If numaNode is not negative, the memory is bound to that NUMA node.
+ * Advice and binding are best effort: the memory is still usable, with
+ * regular pages or on any node, where they are not supported.
+ *
+ * Sizes are rounded up to a multiple of the huge page size; see
+ * HugePageArena.
+ */
+class HugePageArenaAllocator {
+ public:
+  using value_type = void;
+
+  static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+  enum class Mode { Transparent, HugeTlb };
+
+  struct Options {
+    Mode mode = Mode::Transparent;
+    int numaNode = -1;
+  };
+
+  HugePageArenaAllocator() = default;
+  explicit HugePageArenaAllocator(Options options) : options_(options) {}
+
+  static size_t goodSize(size_t size) {
+    return (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  }
+
+  void* allocate(size_t size);
+  void deallocate(void* p, size_t size);
+
+  const Options& options() const {
+    return options_;
+  }
+
+  friend bool operator==(
+      const HugePageArenaAllocator& a,
+      const HugePageArenaAllocator& b) {
+    return a.options_.mode == b.options_.mode &&
+        a.options_.numaNode == b.options_.numaNode;
+  }
+  friend bool operator!=(
+      const HugePageArenaAllocator& a,
+      const HugePageArenaAllocator& b) {
+    return !(a == b);
+  }
+
+ private:
+  Options options_;
+};
+
+template <>
+struct ArenaAllocatorTraits<HugePageArenaAllocator> {
+  static size_t goodSize(
+      const HugePageArenaAllocator& /* alloc */,
+      size_t size) {
+    return HugePageArenaAllocator::goodSize(size);
+  }
+};
+
+/**
+ * Arena whose blocks are made of huge pages, to avoid the TLB misses of
+ * large arenas accessed randomly.  Blocks are at least one huge page (2MB)
+ * by default.
+ */
+class HugePageArena : public Arena<HugePageArenaAllocator> {
+ public:
+  static constexpr size_t kDefaultMinBlockSize =
+      HugePageArenaAllocator::kHugePageSize - kBlockOverhead;
+
+  explicit HugePageArena(
+      HugePageArenaAllocator::Options options = {},
+      size_t minBlockSize = kDefaultMinBlockSize,
+      size_t sizeLimit = kNoSizeLimit,
+      size_t maxAlign = kDefaultMaxAlign)
+      : Arena<HugePageArenaAllocator>(
+            HugePageArenaAllocator(options),
+            minBlockSize,
+            sizeLimit,
+            maxAlign) {}
+};
+
+template <>
+struct AllocatorHasTrivialDeallocate<HugePageArena> : std::true_type {};
+
+template <typename T>
+using HugePageArenaAllocatorAdaptor = ArenaAllocator<T, HugePageArenaAllocator>;
+
+/**
+ * Arena whose blocks come from JemallocHugePageAllocator, which must have
+ * been initialized (with JemallocHugePageAllocator::init()) to get huge
+ * pages; it falls back to regular allocations otherwise.  Unlike those of
+ * HugePageArena, blocks of different arenas share huge pages.
+ */
+class JemallocHugePageArena : public Arena<JemallocHugePageAllocator> {
+ public:
+  explicit JemallocHugePageArena(
+      size_t minBlockSize = kDefaultMinBlockSize,
+      size_t sizeLimit = kNoSizeLimit,
+      size_t maxAlign = kDefaultMaxAlign)
+      : Arena<JemallocHugePageAllocator>(
+            {},
+            minBlockSize,
+            sizeLimit,
+            maxAlign) {}
+};
+
+template <>
+struct AllocatorHasTrivialDeallocate<JemallocHugePageArena> : std::true_type {};
+
+} // namespace folly
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/memory/JemallocArenaAllocator.h>
+
+#include <folly/Conv.h>
+#include <folly/lang/Exception.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
+#include <folly/portability/SysMman.h>
+#include <glog/logging.h>
+
+#include <new>
+#include <string>
+
+#if defined(FOLLY_USE_JEMALLOC) && !FOLLY_SANITIZE
+#include <jemalloc/jemalloc.h>
+#if (JEMALLOC_VERSION_MAJOR >= 5)
+#define FOLLY_JEMALLOC_ARENA_SUPPORTED 1
+#endif
+#endif
+
+namespace folly {
+
+#ifdef FOLLY_JEMALLOC_ARENA_SUPPORTED
+
+struct JemallocArena::Hooks {
+  // First, so that the hooks can find the rest from the pointer jemalloc
+  // passes them
+  extent_hooks_t hooks;
+  extent_alloc_t* originalAlloc{nullptr};
+  Options options;
+
+  // Called on the malloc path, so this must not allocate, or log
+  static void* alloc(
+      extent_hooks_t* extent,
+      void* new_addr,
+      size_t size,
+      size_t alignment,
+      bool* zero,
+      bool* commit,
+      unsigned arena_ind) {
+    auto& self = *reinterpret_cast<Hooks*>(extent);
+    void* res = self.originalAlloc(
+        extent, new_addr, size, alignment, zero, commit, arena_ind);
+    if (res == nullptr) {
+      return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (self.options.hugePages) {
+      madvise(res, size, MADV_HUGEPAGE);
+    }
+#endif
+#ifdef MADV_DONTDUMP
+    if (self.options.noDump) {
+      madvise(res, size, MADV_DONTDUMP);
+    }
+#endif
+    if (self.options.lockPages) {
+      mlock(res, size);
+    }
+    return res;
+  }
+};
+
+static std::string arenaKey(unsigned arenaIndex, const char* name) {
+  return to<std::string>("arena.", arenaIndex, ".", name);
+}
+
+JemallocArena::JemallocArena(const Options& options) {
+  if (!usingJEMalloc()) {
+    return;
+  }
+  mallctlRead("arenas.create", &arenaIndex_);
+
+  if (options.hugePages || options.lockPages || options.noDump) {
+    auto key = arenaKey(arenaIndex_, "extent_hooks");
+    extent_hooks_t* hooks;
+    mallctlRead(key.c_str(), &hooks);
+    hooks_ = std::make_unique<Hooks>();
+    hooks_->hooks = *hooks;
+    hooks_->hooks.alloc = &Hooks::alloc;
+    hooks_->originalAlloc = hooks->alloc;
+    hooks_->options = options;
+    mallctlWrite(key.c_str(), &hooks_->hooks);
+  }
+  flags_ = MALLOCX_ARENA(arenaIndex_) | MALLOCX_TCACHE_NONE;
+}
+
+JemallocArena::~JemallocArena() {
+  if (!enabled()) {
+    return;
+  }
+  try {
+    mallctlCall(arenaKey(arenaIndex_, "destroy").c_str());
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Unable to destroy arena " << arenaIndex_ << ": "
+               << ex.what();
+  }
+}
+
+void JemallocArena::purge() {
+  if (enabled()) {
+    mallctlCall(arenaKey(arenaIndex_, "purge").c_str());
+  }
+}
+
+#else // FOLLY_JEMALLOC_ARENA_SUPPORTED
+
+struct JemallocArena::Hooks {};
+
+JemallocArena::JemallocArena(const Options&) {}
+
+JemallocArena::~JemallocArena() {}
+
+void JemallocArena::purge() {}
+
+#endif // FOLLY_JEMALLOC_ARENA_SUPPORTED
+
+JemallocArena::JemallocArena() : JemallocArena(Options()) {}
+
+void* JemallocArena::allocate(size_t size) {
+  void* p = enabled() ? mallocx(size, flags_) : malloc(size);
+  if (p == nullptr) {
+    throw_exception<std::bad_alloc>();
+  }
+  return p;
+}
+
+void* JemallocArena::reallocate(void* p, size_t size) {
+  void* res = enabled() ? rallocx(p, size, flags_) : realloc(p, size);
+  if (res == nullptr) {
+    throw_exception<std::bad_alloc>();
+  }
+  return res;
+}
+
+void JemallocArena::deallocate(void* p, size_t size) {
+  if (!enabled()) {
+    free(p);
+  } else if (size != 0) {
+    sdallocx(p, size, flags_);
+  } else {
+    dallocx(p, flags_);
+  }
+}
+
+} // namespace folly
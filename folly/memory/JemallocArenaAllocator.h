@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <folly/Memory.h>
+
+namespace folly {
+
+/**
+ * A jemalloc arena of its own, for containers whose memory should not be
+ * mixed with the rest of the heap.
+ *
+ * Long-lived indexes allocated among request-scoped objects keep pages of
+ * the general arenas partially used long after the requests are gone. In
+ * a dedicated arena their pages stay dense, and can be backed by huge pages
+ * or locked in memory. Containers take it through JemallocArenaAllocator:
+ *
+ *   JemallocArena::Options options;
+ *   options.hugePages = true;
+ *   JemallocArena arena(options);
+ *
+ *   using Alloc = JemallocArenaAllocator<std::pair<const Key, Value>>;
+ *   F14NodeMap<Key, Value, Hash, Equal, Alloc> index(
+ *       0, Hash(), Equal(), Alloc(arena));
+ *
+ * Allocations bypass the thread caches, so that the arena can be destroyed
+ * along with this object, which must outlive everything allocated from it.
+ *
+ * Without jemalloc (version 5 or later), this falls back to malloc and free.
+ */
+class JemallocArena {
+ public:
+  struct Options {
+    // madvise(MADV_HUGEPAGE) the memory of the arena, so that transparent
+    // huge pages back it when THP is set to madvise
+    bool hugePages{false};
+    // mlock() the memory of the arena, so that it is never swapped out.
+    // Locked memory counts against RLIMIT_MEMLOCK, beyond which the memory
+    // is still allocated but not locked.
+    bool lockPages{false};
+    // Leave the memory of the arena out of core dumps
+    bool noDump{false};
+  };
+
+  JemallocArena();
+  explicit JemallocArena(const Options& options);
+  ~JemallocArena();
+
+  JemallocArena(const JemallocArena&) = delete;
+  JemallocArena& operator=(const JemallocArena&) = delete;
+
+  // Throws std::bad_alloc on failure, like operator new
+  void* allocate(size_t size);
+  void* reallocate(void* p, size_t size);
+  // A non-zero size must be the size p was allocated with
+  void deallocate(void* p, size_t size = 0);
+
+  // Returns the unused dirty pages of the arena to the system
+  void purge();
+
+  // Whether allocations come from a dedicated arena
+  bool enabled() const {
+    return flags_ != 0;
+  }
+  unsigned arenaIndex() const {
+    return arenaIndex_;
+  }
+  // mallocx() flags allocating from the arena, 0 if not enabled
+  int flags() const {
+    return flags_;
+  }
+
+  /**
+   * The arena of a tag type, created with Tag::options() on first use and
+   * never destroyed, for containers that only take stateless allocators,
+   * see JemallocTaggedArenaAllocator.
+   */
+  template <typename Tag>
+  static JemallocArena& forTag() {
+    static auto& arena = *new JemallocArena(Tag::options());
+    return arena;
+  }
+
+ private:
+  struct Hooks;
+
+  std::unique_ptr<Hooks> hooks_;
+  unsigned arenaIndex_{0};
+  int flags_{0};
+};
+
+template <typename T>
+using JemallocArenaAllocator = CxxAllocatorAdaptor<T, JemallocArena>;
+
+/**
+ * Tags of JemallocTaggedArenaAllocator may derive from this to get arenas
+ * with the default options, or hide options() to set their own.
+ */
+struct JemallocArenaTag {
+  static JemallocArena::Options options() {
+    return {};
+  }
+};
+
+/**
+ * Stateless allocator from the arena of a tag, for containers that
+ * construct their allocators on the fly, such as ConcurrentHashMap:
+ *
+ *   struct IndexArena : JemallocArenaTag {};
+ *   ConcurrentHashMap<
+ *       Key,
+ *       Value,
+ *       Hash,
+ *       Equal,
+ *       JemallocTaggedArenaAllocator<uint8_t, IndexArena>>
+ *       index;
+ *
+ * All containers using the same tag share its arena.
+ */
+template <typename T, typename Tag>
+class JemallocTaggedArenaAllocator {
+ public:
+  using value_type = T;
+
+  JemallocTaggedArenaAllocator() = default;
+
+  template <typename U>
+  explicit JemallocTaggedArenaAllocator(
+      const JemallocTaggedArenaAllocator<U, Tag>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        JemallocArena::forTag<Tag>().allocate(sizeof(T) * n));
+  }
+  void deallocate(T* p, std::size_t n) {
+    JemallocArena::forTag<Tag>().deallocate(p, sizeof(T) * n);
+  }
+
+  friend bool operator==(
+      const JemallocTaggedArenaAllocator&,
+      const JemallocTaggedArenaAllocator&) noexcept {
+    return true;
+  }
+  friend bool operator!=(
+      const JemallocTaggedArenaAllocator&,
+      const JemallocTaggedArenaAllocator&) noexcept {
+    return false;
+  }
+};
+
+} // namespace folly
@@ -23,30 +23,52 @@ namespace folly {
 ThreadCachedArena::ThreadCachedArena(size_t minBlockSize, size_t maxAlign)
     : minBlockSize_(minBlockSize), maxAlign_(maxAlign) {}
 
-SysArena* ThreadCachedArena::allocateThreadLocalArena() {
-  auto arena =
-      new SysArena(minBlockSize_, SysArena::kNoSizeLimit, maxAlign_);
-  auto disposer = [this](SysArena* t, TLPDestructionMode mode) {
-    std::unique_ptr<SysArena> tp(t); // ensure it gets deleted
+ThreadCachedArena::ThreadLocalArena*
+ThreadCachedArena::refreshThreadLocalArena(ThreadLocalArena* local) {
+  auto epoch = epoch_.load(std::memory_order_acquire);
+  if (local) {
+    clear(local->arena);
+    local->epoch = epoch;
+    return local;
+  }
+  local = new ThreadLocalArena(minBlockSize_, maxAlign_, epoch);
+  auto disposer = [this](ThreadLocalArena* t, TLPDestructionMode mode) {
+    std::unique_ptr<ThreadLocalArena> tp(t); // ensure it gets deleted
     if (mode == TLPDestructionMode::THIS_THREAD) {
       zombify(std::move(*t));
     }
   };
-  arena_.reset(arena, disposer);
-  return arena;
+  arena_.reset(local, disposer);
+  return local;
+}
+
+void ThreadCachedArena::zombify(ThreadLocalArena&& local) {
+  auto zombies = zombies_.wlock();
+  // under the lock, so that reset() frees the blocks if it races with this
+  if (local.epoch == epoch_.load(std::memory_order_acquire)) {
+    zombies->merge(std::move(local.arena));
+  } else {
+    totalSize_.fetch_sub(
+        local.arena.totalSize() - sizeof(SysArena), std::memory_order_relaxed);
+  }
 }
 
-void ThreadCachedArena::zombify(SysArena&& arena) {
-  zombies_.wlock()->merge(std::move(arena));
+void ThreadCachedArena::clear(SysArena& arena) {
+  size_t before = arena.totalSize();
+  arena.clear();
+  totalSize_.fetch_sub(before - arena.totalSize(), std::memory_order_relaxed);
 }
 
-size_t ThreadCachedArena::totalSize() const {
-  size_t result = sizeof(ThreadCachedArena);
-  for (const auto& arena : arena_.accessAllThreads()) {
-    result += arena.totalSize();
+void ThreadCachedArena::resetThreadLocal() {
+  if (ThreadLocalArena* local = arena_.get()) {
+    clear(local->arena);
   }
-  result += zombies_.rlock()->totalSize() - sizeof(SysArena);
-  return result;
+}
+
+void ThreadCachedArena::reset() {
+  auto zombies = zombies_.wlock();
+  epoch_.fetch_add(1, std::memory_order_acq_rel);
+  clear(*zombies);
 }
 
 } // namespace folly
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <type_traits>
 
 #include <folly/Likely.h>
@@ -35,6 +37,11 @@ namespace folly {
  * For speed, each thread gets its own Arena (see Arena.h); when threads
  * exit, the Arena gets merged into a "zombie" Arena, which will be deallocated
  * when the ThreadCachedArena object is destroyed.
+ *
+ * Long-lived threads can release their memory without destroying the arena:
+ * resetThreadLocal() frees what the calling thread allocated, for instance at
+ * the end of each request it serves, and reset() starts a new epoch, freeing
+ * what all threads allocated before it.
  */
 class ThreadCachedArena {
  public:
@@ -43,42 +50,87 @@ class ThreadCachedArena {
       size_t maxAlign = SysArena::kDefaultMaxAlign);
 
   void* allocate(size_t size) {
-    SysArena* arena = arena_.get();
-    if (UNLIKELY(!arena)) {
-      arena = allocateThreadLocalArena();
+    ThreadLocalArena* local = arena_.get();
+    if (UNLIKELY(
+            !local ||
+            local->epoch != epoch_.load(std::memory_order_acquire))) {
+      local = refreshThreadLocalArena(local);
     }
 
-    return arena->allocate(size);
+    SysArena& arena = local->arena;
+    size_t before = arena.totalSize();
+    void* p = arena.allocate(size);
+    if (UNLIKELY(arena.totalSize() != before)) {
+      totalSize_.fetch_add(
+          arena.totalSize() - before, std::memory_order_relaxed);
+    }
+    return p;
   }
 
   void deallocate(void* /* p */, size_t = 0) {
     // Deallocate? Never!
   }
 
-  // Gets the total memory used by the arena
-  size_t totalSize() const;
+  // Free the memory allocated by the calling thread, which must no longer be
+  // used by any thread, keeping one block for its next allocations. Constant
+  // time when the thread allocated less than a block since its last reset.
+  void resetThreadLocal();
+
+  // Start a new epoch: free the memory allocated by all threads so far, which
+  // must no longer be used. That of threads that exited is freed now; the
+  // others free theirs on their next allocation.
+  void reset();
+
+  // Gets the total memory used by the arena; does not lock.
+  size_t totalSize() const {
+    return sizeof(ThreadCachedArena) +
+        totalSize_.load(std::memory_order_relaxed);
+  }
 
  private:
   struct ThreadLocalPtrTag {};
 
+  struct ThreadLocalArena {
+    ThreadLocalArena(
+        size_t minBlockSize,
+        size_t maxAlign,
+        uint64_t initialEpoch)
+        : arena(minBlockSize, SysArena::kNoSizeLimit, maxAlign),
+          epoch(initialEpoch) {}
+
+    SysArena arena;
+    uint64_t epoch;
+  };
+
   ThreadCachedArena(const ThreadCachedArena&) = delete;
   ThreadCachedArena(ThreadCachedArena&&) = delete;
   ThreadCachedArena& operator=(const ThreadCachedArena&) = delete;
   ThreadCachedArena& operator=(ThreadCachedArena&&) = delete;
 
-  SysArena* allocateThreadLocalArena();
+  // Allocate the arena of the calling thread, or reset it if it belongs to a
+  // previous epoch.
+  ThreadLocalArena* refreshThreadLocalArena(ThreadLocalArena* local);
 
   // Zombify the blocks in arena, saving them for deallocation until
-  // the ThreadCachedArena is destroyed.
-  void zombify(SysArena&& arena);
+  // the ThreadCachedArena is destroyed or reset; or free them now if they
+  // belong to a previous epoch.
+  void zombify(ThreadLocalArena&& local);
+
+  // Free the blocks of arena but the current one.
+  void clear(SysArena& arena);
 
   const size_t minBlockSize_;
   const size_t maxAlign_;
 
-  ThreadLocalPtr<SysArena, ThreadLocalPtrTag> arena_; // Per-thread arena.
+  // Per-thread arena.
+  ThreadLocalPtr<ThreadLocalArena, ThreadLocalPtrTag> arena_;
 
   // Allocations from threads that are now dead.
   Synchronized<SysArena> zombies_;
+
+  std::atomic<uint64_t> epoch_{0};
+  // Of the blocks of all arenas.
+  std::atomic<size_t> totalSize_{0};
 };
 
 template <>
@@ -87,4 +139,8 @@ struct AllocatorHasTrivialDeallocate<ThreadCachedArena> : std::true_type {};
 template <typename T>
 using ThreadCachedArenaAllocator = CxxAllocatorAdaptor<T, ThreadCachedArena>;
 
+#if FOLLY_HAS_MEMORY_RESOURCE
+using ThreadCachedArenaMemoryResource = ArenaMemoryResource<ThreadCachedArena>;
+#endif
+
 } // namespace folly
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+
+#include <cstddef>
+#include <new>
+
+#include <folly/Portability.h>
+
+namespace folly {
+namespace detail {
+
+/// Free lists of memory blocks of up to Granularity * NumClasses bytes, by
+/// size rounded up to Granularity bytes, for objects that are allocated and
+/// freed at a high rate.  Meant to live in a ThreadLocalCache.
+///
+/// The blocks must come from malloc, with the size given by roundUp(), and
+/// are freed with the lists.  No block is cacheable in sanitized builds, so
+/// that the sanitizers see every allocation.
+template <std::size_t Granularity, std::size_t NumClasses>
+class FreeLists {
+  static_assert(Granularity >= sizeof(void*), "");
+
+ public:
+  FreeLists() = default;
+  FreeLists(const FreeLists&) = delete;
+  FreeLists& operator=(const FreeLists&) = delete;
+
+  ~FreeLists() {
+    for (auto& list : lists_) {
+      while (auto* block = list.head) {
+        list.head = block->next;
+        free(block);
+      }
+    }
+  }
+
+  static bool cacheable(std::size_t size) noexcept {
+    return !kIsSanitizeAddress && size <= Granularity * NumClasses;
+  }
+
+  static std::size_t roundUp(std::size_t size) noexcept {
+    return (sizeClass(size) + 1) * Granularity;
+  }
+
+  /// A cached block for a cacheable size, or nullptr if there is none.
+  void* pop(std::size_t size) noexcept {
+    auto& list = lists_[sizeClass(size)];
+    auto* block = list.head;
+    if (block) {
+      list.head = block->next;
+      --list.size;
+    }
+    return block;
+  }
+
+  /// Caches p, a block for a cacheable size, unless its list already holds
+  /// limit blocks.
+  /// @return whether p was cached
+  bool push(void* p, std::size_t size, std::size_t limit) noexcept {
+    auto& list = lists_[sizeClass(size)];
+    if (list.size >= limit) {
+      return false;
+    }
+    list.head = ::new (p) FreeBlock{list.head};
+    ++list.size;
+    return true;
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct FreeList {
+    FreeBlock* head{nullptr};
+    std::size_t size{0};
+  };
+
+  static std::size_t sizeClass(std::size_t size) noexcept {
+    return size == 0 ? 0 : (size - 1) / Granularity;
+  }
+
+  FreeList lists_[NumClasses];
+};
+
+/// The instance of T of the calling thread.
+template <typename T>
+class ThreadLocalCache {
+ public:
+  /// nullptr once the instance has been destroyed at thread exit, so that
+  /// blocks freed by the destructors of other thread locals can go back to
+  /// malloc.
+  static T* get() {
+    if (destroyed_) {
+      return nullptr;
+    }
+    static thread_local ThreadLocalCache cache;
+    return &cache.value_;
+  }
+
+ private:
+  ThreadLocalCache() = default;
+
+  ~ThreadLocalCache() {
+    destroyed_ = true;
+  }
+
+  T value_;
+  static thread_local bool destroyed_;
+};
+
+template <typename T>
+thread_local bool ThreadLocalCache<T>::destroyed_ = false;
+
+} // namespace detail
+} // namespace folly
@@ -15,9 +15,13 @@
  */
 
 #include <folly/memory/Arena.h>
+#include <folly/memory/HugePageArena.h>
 #include <folly/Memory.h>
+#include <folly/container/F14Map.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/GTest.h>
+#include <folly/small_vector.h>
+#include <folly/sorted_vector_types.h>
 
 #include <set>
 #include <vector>
@@ -147,6 +151,25 @@ TEST(Arena, Vector) {
   }
 }
 
+TEST(Arena, Clear) {
+  SysArena arena;
+  arena.clear();
+  EXPECT_EQ(sizeof(SysArena), arena.totalSize());
+
+  arena.allocate(100000);
+  for (int i = 0; i < 100; i++) {
+    arena.allocate(1000);
+  }
+  auto last = static_cast<char*>(arena.allocate(10));
+  arena.clear();
+  EXPECT_EQ(0, arena.bytesUsed());
+  EXPECT_LT(arena.totalSize(), 2 * SysArena::kDefaultMinBlockSize);
+  // the current block is kept, and reused from its start
+  auto p = static_cast<char*>(arena.allocate(10));
+  EXPECT_LT(p, last);
+  EXPECT_GT(p + SysArena::kDefaultMinBlockSize, last);
+}
+
 TEST(Arena, SizeLimit) {
   static const size_t requestedBlockSize = sizeof(size_t);
   static const size_t maxSize = 10 * requestedBlockSize;
@@ -168,6 +191,106 @@ TEST(Arena, ExtremeSize) {
   EXPECT_THROW(arena.allocate(SIZE_MAX - 2), std::bad_alloc);
 }
 
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+TEST(Arena, MemoryResource) {
+  namespace std_pmr = folly::detail::std_pmr;
+  SysArena arena;
+  SysArenaMemoryResource resource(arena);
+  // nothing may be allocated from the default resource
+  auto prevDefault = std_pmr::set_default_resource(
+      std_pmr::null_memory_resource());
+  {
+    using Inner = folly::pmr::small_vector<int, 2>;
+    folly::pmr::F14NodeMap<int, Inner> map(&resource);
+    folly::pmr::sorted_vector_map<int, Inner> sorted(
+        std::less<int>(), &resource);
+    for (int i = 0; i < 1000; i++) {
+      map[i % 10].push_back(i);
+      sorted[i % 7].push_back(i);
+    }
+    for (int i = 0; i < 10; i++) {
+      EXPECT_EQ(&resource, map[i].get_allocator().resource());
+      EXPECT_EQ(100, map[i].size());
+      EXPECT_EQ(990 + i, map[i].back());
+    }
+    EXPECT_EQ(7, sorted.size());
+    EXPECT_EQ(&resource, sorted.begin()->second.get_allocator().resource());
+    EXPECT_GT(arena.bytesUsed(), 1000 * sizeof(int));
+  }
+  std_pmr::set_default_resource(prevDefault);
+}
+
+TEST(Arena, MemoryResourceAlignment) {
+  SysArena arena(SysArena::kDefaultMinBlockSize, SysArena::kNoSizeLimit, 8);
+  SysArenaMemoryResource resource(arena);
+  for (size_t alignment : {1, 8, 16, 64, 4096}) {
+    for (int i = 0; i < 10; i++) {
+      auto p = resource.allocate(24, alignment);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % alignment);
+      resource.deallocate(p, 24, alignment);
+    }
+  }
+  EXPECT_TRUE(resource.is_equal(resource));
+  SysArenaMemoryResource other(arena);
+  EXPECT_FALSE(resource.is_equal(other));
+}
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
+namespace {
+
+template <class Alloc>
+void checkArenaAllocations(Arena<Alloc>& arena) {
+  std::vector<size_t, ArenaAllocator<size_t, Alloc>> vec{
+      ArenaAllocator<size_t, Alloc>(arena)};
+  for (size_t i = 0; i < 1000000; i++) {
+    vec.push_back(i);
+  }
+  for (size_t i = 0; i < 1000000; i++) {
+    EXPECT_EQ(i, vec[i]);
+  }
+  for (size_t size : {1, 10, 4000, 3 << 20}) {
+    auto p = static_cast<char*>(arena.allocate(size));
+    memset(p, 0xab, size);
+  }
+  EXPECT_GT(arena.totalSize(), 1000000 * sizeof(size_t));
+}
+
+} // namespace
+
+TEST(HugePageArena, Transparent) {
+  HugePageArena arena;
+  checkArenaAllocations(arena);
+}
+
+TEST(HugePageArena, HugeTlb) {
+  // falls back to transparent huge pages without reserved ones
+  HugePageArenaAllocator::Options options;
+  options.mode = HugePageArenaAllocator::Mode::HugeTlb;
+  HugePageArena arena(options);
+  checkArenaAllocations(arena);
+}
+
+TEST(HugePageArena, NumaNode) {
+  HugePageArenaAllocator::Options options;
+  options.numaNode = 0;
+  HugePageArena arena(options);
+  checkArenaAllocations(arena);
+}
+
+TEST(HugePageArena, Alignment) {
+  HugePageArenaAllocator alloc;
+  void* p = alloc.allocate(1);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % alloc.kHugePageSize);
+  alloc.deallocate(p, 1);
+}
+
+TEST(JemallocHugePageArena, Allocations) {
+  JemallocHugePageArena arena;
+  checkArenaAllocations(arena);
+}
+
 int main(int argc, char* argv[]) {
   testing::InitGoogleTest(&argc, argv);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
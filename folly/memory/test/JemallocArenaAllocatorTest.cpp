@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/memory/JemallocArenaAllocator.h>
+
+#include <string>
+#include <vector>
+
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/container/F14Map.h>
+#include <folly/memory/Malloc.h>
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+namespace {
+
+// Index of the arena p was allocated from
+unsigned arenaOf(const void* p) {
+  unsigned arena = 0;
+  size_t len = sizeof(arena);
+  EXPECT_EQ(0, mallctl("arenas.lookup", &arena, &len, &p, sizeof(p)));
+  return arena;
+}
+
+struct IndexArena : JemallocArenaTag {};
+
+struct HugePageIndexArena {
+  static JemallocArena::Options options() {
+    JemallocArena::Options options;
+    options.hugePages = true;
+    return options;
+  }
+};
+
+} // namespace
+
+TEST(JemallocArena, Allocate) {
+  JemallocArena arena;
+  EXPECT_EQ(usingJEMalloc(), arena.enabled());
+
+  void* p = arena.allocate(100);
+  memset(p, 1, 100);
+  p = arena.reallocate(p, 10000);
+  if (arena.enabled()) {
+    EXPECT_EQ(arena.arenaIndex(), arenaOf(p));
+  }
+  arena.deallocate(p, 10000);
+
+  p = arena.allocate(1);
+  arena.deallocate(p);
+  arena.purge();
+}
+
+TEST(JemallocArena, F14) {
+  JemallocArena::Options options;
+  options.hugePages = true;
+  options.noDump = true;
+  JemallocArena arena(options);
+  JemallocArena other;
+
+  using Hasher = f14::DefaultHasher<int>;
+  using KeyEqual = f14::DefaultKeyEqual<int>;
+  using Alloc = JemallocArenaAllocator<std::pair<const int, std::string>>;
+  using Map = F14NodeMap<int, std::string, Hasher, KeyEqual, Alloc>;
+  Map map(0, Hasher(), KeyEqual(), Alloc(arena));
+  Map otherMap(0, Hasher(), KeyEqual(), Alloc(other));
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = std::to_string(i);
+    otherMap[i] = std::to_string(i);
+  }
+  EXPECT_EQ("123", map.at(123));
+  EXPECT_FALSE(map.get_allocator() == otherMap.get_allocator());
+  if (arena.enabled()) {
+    EXPECT_EQ(arena.arenaIndex(), arenaOf(&*map.find(123)));
+    EXPECT_EQ(other.arenaIndex(), arenaOf(&*otherMap.find(123)));
+    EXPECT_NE(arena.arenaIndex(), other.arenaIndex());
+  }
+}
+
+TEST(JemallocArena, ConcurrentHashMap) {
+  using Alloc = JemallocTaggedArenaAllocator<uint8_t, IndexArena>;
+  ConcurrentHashMap<int, int, std::hash<int>, std::equal_to<int>, Alloc> map;
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(i, i * 2);
+  }
+  EXPECT_EQ(246, map.find(123)->second);
+  auto& arena = JemallocArena::forTag<IndexArena>();
+  EXPECT_EQ(&arena, &JemallocArena::forTag<IndexArena>());
+  EXPECT_NE(&arena, &JemallocArena::forTag<HugePageIndexArena>());
+  if (arena.enabled()) {
+    EXPECT_EQ(arena.arenaIndex(), arenaOf(&*map.find(123)));
+  }
+
+  std::vector<int, JemallocTaggedArenaAllocator<int, HugePageIndexArena>> v(
+      100, 1);
+  if (arena.enabled()) {
+    EXPECT_EQ(
+        JemallocArena::forTag<HugePageIndexArena>().arenaIndex(),
+        arenaOf(v.data()));
+  }
+}
@@ -17,6 +17,8 @@
 #include <folly/memory/ThreadCachedArena.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iterator>
 #include <map>
 #include <mutex>
@@ -29,8 +31,10 @@
 #include <folly/Benchmark.h>
 #include <folly/Memory.h>
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
 #include <folly/lang/Align.h>
 #include <folly/portability/GTest.h>
+#include <folly/small_vector.h>
 
 using namespace folly;
 
@@ -176,6 +180,105 @@ TEST(ThreadCachedArena, ThreadCachedArenaAllocator) {
   }
 }
 
+TEST(ThreadCachedArena, ResetThreadLocal) {
+  ThreadCachedArena arena;
+  // each request fits in the first block, which is reused
+  void* first = arena.allocate(100);
+  for (int request = 0; request < 100; request++) {
+    arena.resetThreadLocal();
+    EXPECT_EQ(first, arena.allocate(100));
+    for (int i = 0; i < 30; i++) {
+      std::memset(arena.allocate(100), request, 100);
+    }
+  }
+  size_t oneBlock = arena.totalSize();
+
+  ArenaTester tester(arena);
+  tester.allocate(100, 100 << 10);
+  tester.verify();
+  EXPECT_GT(arena.totalSize(), oneBlock + (100 << 10));
+  arena.resetThreadLocal();
+  EXPECT_LE(arena.totalSize(), oneBlock + (100 << 10));
+}
+
+TEST(ThreadCachedArena, Reset) {
+  ThreadCachedArena arena;
+  std::atomic<bool> done{false};
+  std::atomic<int> epoch{0};
+  std::atomic<int> seen{0};
+  // a long-lived thread, which releases its memory on its next allocation
+  std::thread worker([&] {
+    int last = -1;
+    while (!done.load()) {
+      if (epoch.load() != last) {
+        last = epoch.load();
+        ArenaTester tester(arena);
+        tester.allocate(100, 10 << 10);
+        tester.verify();
+        ++seen;
+      }
+      std::this_thread::yield();
+    }
+  });
+  while (seen.load() == 0) {
+    std::this_thread::yield();
+  }
+  // short-lived threads, whose memory is released by reset()
+  for (int t = 0; t < 4; t++) {
+    std::thread([&] {
+      ArenaTester tester(arena);
+      tester.allocate(100, 10 << 10);
+    }).join();
+  }
+  size_t used = arena.totalSize();
+  EXPECT_GT(used, 5 * ((10 << 10) / 2));
+
+  arena.reset();
+  auto reset = arena.totalSize();
+  EXPECT_LT(reset, used);
+  ++epoch;
+  while (seen.load() == 1) {
+    std::this_thread::yield();
+  }
+  done = true;
+  worker.join();
+  EXPECT_LT(arena.totalSize(), used);
+
+  arena.reset();
+  EXPECT_GE(arena.totalSize(), sizeof(ThreadCachedArena));
+}
+
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+TEST(ThreadCachedArena, MemoryResource) {
+  using Map = folly::pmr::F14FastMap<int, folly::pmr::small_vector<int, 2>>;
+
+  ThreadCachedArena arena;
+  ThreadCachedArenaMemoryResource resource(arena);
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      // each thread allocates from its own arena
+      Map map(&resource);
+      for (int i = 0; i < 1000; i++) {
+        map[i % 10].push_back(i * t);
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(100, map[i].size());
+        EXPECT_EQ((990 + i) * t, map[i].back());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_GT(arena.totalSize(), 4 * 1000 * sizeof(int));
+}
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
 namespace {
 
 static const int kNumValues = 10000;
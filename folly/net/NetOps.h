@@ -38,6 +38,8 @@
 #define FOLLY_HAVE_MSG_ERRQUEUE 1
 /* for struct sock_extended_err*/
 #include <linux/errqueue.h>
+/* for the SOF_TIMESTAMPING_* flags */
+#include <linux/net_tstamp.h>
 #endif
 
 #ifndef SO_EE_ORIGIN_ZEROCOPY
@@ -72,6 +74,26 @@
 #define UDP_MAX_SEGMENTS (1 << 6UL)
 #endif
 
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+#ifndef SO_TIMESTAMPING
+#define SO_TIMESTAMPING 37
+#endif
+
+#ifndef SCM_TIMESTAMPING
+#define SCM_TIMESTAMPING SO_TIMESTAMPING
+#endif
+
+#ifndef SO_TXTIME
+#define SO_TXTIME 61
+#endif
+
+#ifndef SCM_TXTIME
+#define SCM_TXTIME SO_TXTIME
+#endif
+
 #ifndef MSG_WAITFORONE
 struct mmsghdr {
   struct msghdr msg_hdr;
@@ -91,6 +113,11 @@ using sa_family_t = ADDRESS_FAMILY;
 #define MSG_ZEROCOPY 0x0
 #define SOL_UDP 0x0
 #define UDP_SEGMENT 0x0
+#define UDP_GRO 0x0
+#define SO_TIMESTAMPING 0x0
+#define SCM_TIMESTAMPING 0x0
+#define SO_TXTIME 0x0
+#define SCM_TXTIME 0x0
 
 // We don't actually support either of these flags
 // currently.
@@ -168,6 +195,12 @@ ssize_t recvfrom(
     sockaddr* from,
     socklen_t* fromlen);
 ssize_t recvmsg(NetworkSocket s, msghdr* message, int flags);
+int recvmmsg(
+    NetworkSocket s,
+    mmsghdr* msgvec,
+    unsigned int vlen,
+    unsigned int flags,
+    struct timespec* timeout);
 ssize_t send(NetworkSocket s, const void* buf, size_t len, int flags);
 ssize_t sendto(
     NetworkSocket s,
@@ -35,6 +35,15 @@
 #endif
 #endif
 
+#if FOLLY_USE_SYS_MEMBARRIER
+namespace {
+// Only in linux/membarrier.h since 4.14, where they are enumerators rather
+// than macros.
+constexpr int kMembarrierCmdPrivateExpedited = 1 << 3;
+constexpr int kMembarrierCmdRegisterPrivateExpedited = 1 << 4;
+} // namespace
+#endif
+
 namespace folly {
 namespace detail {
 
@@ -62,5 +71,37 @@ int sysMembarrier() {
   return -1;
 #endif
 }
+
+bool sysMembarrierPrivateExpeditedAvailable() {
+  if (!kIsLinux) {
+    return false;
+  }
+
+#if FOLLY_USE_SYS_MEMBARRIER
+  static const bool available = [] {
+    auto r = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, /* flags = */ 0);
+    if (r == -1 || !(r & kMembarrierCmdPrivateExpedited)) {
+      return false;
+    }
+    // Registration is process-wide and only needs to happen once.
+    return syscall(
+               __NR_membarrier,
+               kMembarrierCmdRegisterPrivateExpedited,
+               /* flags = */ 0) == 0;
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+int sysMembarrierPrivateExpedited() {
+#if FOLLY_USE_SYS_MEMBARRIER
+  return syscall(
+      __NR_membarrier, kMembarrierCmdPrivateExpedited, /* flags = */ 0);
+#else
+  return -1;
+#endif
+}
 } // namespace detail
 } // namespace folly
@@ -21,5 +21,13 @@ namespace detail {
 
 int sysMembarrier();
 bool sysMembarrierAvailable();
+
+// MEMBARRIER_CMD_PRIVATE_EXPEDITED only interrupts the CPUs currently
+// running threads of this process, and returns in microseconds rather than
+// waiting for a scheduler grace period as MEMBARRIER_CMD_SHARED does.
+// Available() registers the process on first use, and must have returned
+// true before sysMembarrierPrivateExpedited() is called.
+int sysMembarrierPrivateExpedited();
+bool sysMembarrierPrivateExpeditedAvailable();
 } // namespace detail
 } // namespace folly
@@ -53,6 +53,7 @@
 #include <folly/lang/Assume.h>
 #include <folly/lang/Exception.h>
 #include <folly/memory/Malloc.h>
+#include <folly/memory/MemoryResource.h>
 #include <folly/portability/Malloc.h>
 
 #if (FOLLY_X64 || FOLLY_PPC64)
@@ -83,6 +84,17 @@ namespace small_vector_policy {
  */
 struct NoHeap;
 
+/*
+ * Allocates the heap buffer with Alloc, rebound to the value type,
+ * rather than with malloc.  Stateful allocators, such as
+ * std::pmr::polymorphic_allocator, are stored in the vector, and are
+ * propagated as their allocator_traits say.
+ */
+template <class Alloc>
+struct Allocator {
+  typedef Alloc type;
+};
+
 //////////////////////////////////////////////////////////////////////
 
 } // namespace small_vector_policy
@@ -108,7 +120,9 @@ namespace detail {
  * extra copies and moves for non-trivial types.
  */
 template <class T, class Create>
-typename std::enable_if<!folly::is_trivially_copyable<T>::value>::type
+typename std::enable_if<
+    !folly::is_trivially_copyable<T>::value &&
+    !folly::IsRelocatable<T>::value>::type
 moveObjectsRightAndCreate(
     T* const first,
     T* const lastConstructed,
@@ -158,6 +172,45 @@ moveObjectsRightAndCreate(
   }
 }
 
+// Specialization for relocatable types that are not trivially copyable, such
+// as std::unique_ptr: the objects are shifted with memmove, which leaves the
+// holes as uninitialized memory, and then constructed in place. If create()
+// throws, the objects are shifted back.
+template <class T, class Create>
+typename std::enable_if<
+    !folly::is_trivially_copyable<T>::value &&
+    folly::IsRelocatable<T>::value>::type
+moveObjectsRightAndCreate(
+    T* const first,
+    T* const lastConstructed,
+    T* const realLast,
+    Create&& create) {
+  const std::size_t n = realLast - lastConstructed;
+  if (n == 0) {
+    return;
+  }
+  std::memmove(
+      static_cast<void*>(first + n),
+      static_cast<void const*>(first),
+      (lastConstructed - first) * sizeof(T));
+  std::size_t idx = 0;
+  {
+    auto rollback = makeGuard([&] {
+      for (std::size_t i = 0; i < idx; ++i) {
+        first[i].~T();
+      }
+      std::memmove(
+          static_cast<void*>(first),
+          static_cast<void const*>(first + n),
+          (lastConstructed - first) * sizeof(T));
+    });
+    for (; idx < n; ++idx) {
+      new (first + idx) T(create(idx));
+    }
+    rollback.dismiss();
+  }
+}
+
 // Specialization for trivially copyable types.  The call to
 // std::move_backward here will just turn into a memmove.
 // This must only be used with trivially copyable types because some of the
@@ -325,6 +378,65 @@ struct IntegralSizePolicy<SizeType, true>
       rollback.dismiss();
     }
   }
+
+  /*
+   * Like moveToUninitialized() and moveToUninitializedEmplace(), but also
+   * destroys [first, last) on success, leaving it as uninitialized memory.
+   * Relocatable types are copied with memcpy instead of being moved and
+   * destroyed.
+   */
+  template <class T>
+  void relocateToUninitialized(T* first, T* last, T* out) {
+    relocateToUninitialized(
+        first,
+        last,
+        out,
+        std::integral_constant<bool, folly::IsRelocatable<T>::value>());
+  }
+
+  template <class T, class EmplaceFunc>
+  void relocateToUninitializedEmplace(
+      T* begin,
+      T* end,
+      T* out,
+      SizeType pos,
+      EmplaceFunc&& emplaceFunc) {
+    if (folly::IsRelocatable<T>::value) {
+      // Must be called first so that if it throws [begin, end) is unmodified.
+      emplaceFunc(out + pos);
+      relocateToUninitialized(begin, begin + pos, out, std::true_type());
+      relocateToUninitialized(
+          begin + pos, end, out + pos + 1, std::true_type());
+    } else {
+      moveToUninitializedEmplace(
+          begin, end, out, pos, std::forward<EmplaceFunc>(emplaceFunc));
+      destroy(begin, end);
+    }
+  }
+
+ private:
+  template <class T>
+  void relocateToUninitialized(T* first, T* last, T* out, std::true_type) {
+    if (first != last) {
+      std::memcpy(
+          static_cast<void*>(out),
+          static_cast<void const*>(first),
+          (last - first) * sizeof *first);
+    }
+  }
+
+  template <class T>
+  void relocateToUninitialized(T* first, T* last, T* out, std::false_type) {
+    moveToUninitialized(first, last, out);
+    destroy(first, last);
+  }
+
+  template <class T>
+  static void destroy(T* first, T* last) {
+    for (; first != last; ++first) {
+      first->~T();
+    }
+  }
 };
 
 template <class SizeType>
@@ -344,6 +456,90 @@ struct IntegralSizePolicy<SizeType, false>
       EmplaceFunc&& /* emplaceFunc */) {
     assume_unreachable();
   }
+  template <class T>
+  void relocateToUninitialized(T* /*first*/, T* /*last*/, T* /*out*/) {
+    assume_unreachable();
+  }
+  template <class T, class EmplaceFunc>
+  void relocateToUninitializedEmplace(
+      T* /* begin */,
+      T* /* end */,
+      T* /* out */,
+      SizeType /* pos */,
+      EmplaceFunc&& /* emplaceFunc */) {
+    assume_unreachable();
+  }
+};
+
+template <class T>
+struct IsSmallVectorAllocatorPolicy : std::false_type {};
+
+template <class Alloc>
+struct IsSmallVectorAllocatorPolicy<small_vector_policy::Allocator<Alloc>>
+    : std::true_type {};
+
+template <class Value, class Policy>
+struct RebindSmallVectorAllocator {
+  typedef typename std::allocator_traits<typename Policy::type::type>::
+      template rebind_alloc<Value>
+          type;
+};
+
+/*
+ * Holds the allocator of a small_vector.  Empty allocators take no
+ * space and are default constructed when needed.
+ */
+template <class Alloc, bool = std::is_empty<Alloc>::value>
+class SmallVectorAllocatorHolder {
+ public:
+  SmallVectorAllocatorHolder() = default;
+  explicit SmallVectorAllocatorHolder(const Alloc&) {}
+
+ protected:
+  Alloc heldAllocator() const {
+    return Alloc();
+  }
+  void propagateOnCopyAssign(const SmallVectorAllocatorHolder&) {}
+  void propagateOnMoveAssign(SmallVectorAllocatorHolder&) {}
+  void propagateOnSwap(SmallVectorAllocatorHolder&) {}
+};
+
+template <class Alloc>
+class SmallVectorAllocatorHolder<Alloc, false> {
+  using Traits = std::allocator_traits<Alloc>;
+
+ public:
+  SmallVectorAllocatorHolder() : alloc_() {}
+  explicit SmallVectorAllocatorHolder(const Alloc& alloc) : alloc_(alloc) {}
+
+ protected:
+  const Alloc& heldAllocator() const {
+    return alloc_;
+  }
+  void propagateOnCopyAssign(const SmallVectorAllocatorHolder& o) {
+    assignAllocator(
+        o, typename Traits::propagate_on_container_copy_assignment());
+  }
+  void propagateOnMoveAssign(SmallVectorAllocatorHolder& o) {
+    assignAllocator(
+        o, typename Traits::propagate_on_container_move_assignment());
+  }
+  void propagateOnSwap(SmallVectorAllocatorHolder& o) {
+    swapAllocator(o, typename Traits::propagate_on_container_swap());
+  }
+
+ private:
+  void assignAllocator(const SmallVectorAllocatorHolder& o, std::true_type) {
+    alloc_ = o.alloc_;
+  }
+  void assignAllocator(const SmallVectorAllocatorHolder&, std::false_type) {}
+  void swapAllocator(SmallVectorAllocatorHolder& o, std::true_type) {
+    using std::swap;
+    swap(alloc_, o.alloc_);
+  }
+  void swapAllocator(SmallVectorAllocatorHolder&, std::false_type) {}
+
+  Alloc alloc_;
 };
 
 /*
@@ -401,6 +597,24 @@ struct small_vector_base {
    */
   typedef IntegralSizePolicy<SizeType, !HasNoHeap::value> ActualSizePolicy;
 
+  /*
+   * Determine the allocator of the heap buffer.
+   */
+  typedef typename mpl::filter_view<
+      PolicyList,
+      IsSmallVectorAllocatorPolicy<mpl::placeholders::_1>>::type
+      AllocatorPolicies;
+
+  static_assert(
+      mpl::size<AllocatorPolicies>::value <= 1,
+      "Multiple allocators specified in small_vector<>");
+
+  typedef typename mpl::eval_if<
+      mpl::empty<AllocatorPolicies>,
+      mpl::identity<std::allocator<Value>>,
+      RebindSmallVectorAllocator<Value, mpl::front<AllocatorPolicies>>>::type
+      Allocator;
+
   /*
    * Now inherit from them all.  This is done in such a convoluted
    * way to make sure we get the empty base optimizaton on all these
@@ -437,16 +651,28 @@ template <
     class PolicyA = void,
     class PolicyB = void,
     class PolicyC = void>
-class small_vector : public detail::small_vector_base<
-                         Value,
-                         RequestedMaxInline,
-                         PolicyA,
-                         PolicyB,
-                         PolicyC>::type {
-  typedef typename detail::
-      small_vector_base<Value, RequestedMaxInline, PolicyA, PolicyB, PolicyC>::
-          type BaseType;
+class small_vector
+    : public detail::small_vector_base<
+          Value,
+          RequestedMaxInline,
+          PolicyA,
+          PolicyB,
+          PolicyC>::type,
+      private detail::SmallVectorAllocatorHolder<
+          typename detail::small_vector_base<
+              Value,
+              RequestedMaxInline,
+              PolicyA,
+              PolicyB,
+              PolicyC>::Allocator> {
+  typedef detail::
+      small_vector_base<Value, RequestedMaxInline, PolicyA, PolicyB, PolicyC>
+          Base;
+  typedef typename Base::type BaseType;
   typedef typename BaseType::InternalSizeType InternalSizeType;
+  typedef detail::SmallVectorAllocatorHolder<typename Base::Allocator>
+      AllocatorHolder;
+  typedef std::allocator_traits<typename Base::Allocator> AllocatorTraits;
 
   /*
    * Figure out the max number of elements we should inline.  (If
@@ -459,7 +685,7 @@ class small_vector : public detail::small_vector_base<
  public:
   typedef std::size_t size_type;
   typedef Value value_type;
-  typedef std::allocator<Value> allocator_type;
+  typedef typename Base::Allocator allocator_type;
   typedef value_type& reference;
   typedef value_type const& const_reference;
   typedef value_type* iterator;
@@ -472,17 +698,24 @@ class small_vector : public detail::small_vector_base<
   typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
   small_vector() = default;
-  // Allocator is unused here. It is taken in for compatibility with std::vector
-  // interface, but it will be ignored.
-  small_vector(const std::allocator<Value>&) {}
-
-  small_vector(small_vector const& o) {
+  // The default std::allocator is unused, and only taken in for
+  // compatibility with the std::vector interface.
+  small_vector(const allocator_type& alloc) : AllocatorHolder(alloc) {}
+
+  small_vector(small_vector const& o)
+      : small_vector(
+            o,
+            AllocatorTraits::select_on_container_copy_construction(
+                o.get_allocator())) {}
+
+  small_vector(small_vector const& o, const allocator_type& alloc)
+      : AllocatorHolder(alloc) {
     auto n = o.size();
     makeSize(n);
     {
       auto rollback = makeGuard([&] {
         if (this->isExtern()) {
-          u.freeHeap();
+          freeHeap();
         }
       });
       std::uninitialized_copy(o.begin(), o.end(), begin());
@@ -492,7 +725,8 @@ class small_vector : public detail::small_vector_base<
   }
 
   small_vector(small_vector&& o) noexcept(
-      std::is_nothrow_move_constructible<Value>::value) {
+      std::is_nothrow_move_constructible<Value>::value)
+      : AllocatorHolder(o.get_allocator()) {
     if (o.isExtern()) {
       swap(o);
     } else {
@@ -504,10 +738,30 @@ class small_vector : public detail::small_vector_base<
     }
   }
 
+  // Moves the elements one by one if the allocators are not equal.
+  small_vector(small_vector&& o, const allocator_type& alloc)
+      : AllocatorHolder(alloc) {
+    if (o.isExtern() && alloc == o.get_allocator()) {
+      swap(o);
+    } else {
+      constructImpl(
+          std::make_move_iterator(o.begin()),
+          std::make_move_iterator(o.end()),
+          std::false_type());
+    }
+  }
+
   small_vector(std::initializer_list<value_type> il) {
     constructImpl(il.begin(), il.end(), std::false_type());
   }
 
+  small_vector(
+      std::initializer_list<value_type> il,
+      const allocator_type& alloc)
+      : AllocatorHolder(alloc) {
+    constructImpl(il.begin(), il.end(), std::false_type());
+  }
+
   explicit small_vector(size_type n) {
     doConstruct(n, [&](void* p) { new (p) value_type(); });
   }
@@ -524,17 +778,29 @@ class small_vector : public detail::small_vector_base<
     constructImpl(arg1, arg2, std::is_arithmetic<Arg>());
   }
 
+  template <class Arg>
+  small_vector(Arg arg1, Arg arg2, const allocator_type& alloc)
+      : AllocatorHolder(alloc) {
+    constructImpl(arg1, arg2, std::is_arithmetic<Arg>());
+  }
+
   ~small_vector() {
     for (auto& t : *this) {
       (&t)->~value_type();
     }
     if (this->isExtern()) {
-      u.freeHeap();
+      freeHeap();
     }
   }
 
   small_vector& operator=(small_vector const& o) {
     if (FOLLY_LIKELY(this != &o)) {
+      if (AllocatorTraits::propagate_on_container_copy_assignment::value &&
+          !(get_allocator() == o.get_allocator())) {
+        // our buffer can only be freed by our current allocator
+        resetStorage();
+      }
+      this->propagateOnCopyAssign(o);
       assign(o.begin(), o.end());
     }
     return *this;
@@ -544,6 +810,17 @@ class small_vector : public detail::small_vector_base<
     // TODO: optimization:
     // if both are internal, use move assignment where possible
     if (FOLLY_LIKELY(this != &o)) {
+      if (!(get_allocator() == o.get_allocator())) {
+        if (!AllocatorTraits::propagate_on_container_move_assignment::value) {
+          // o's buffer can't be taken over
+          assign(
+              std::make_move_iterator(o.begin()),
+              std::make_move_iterator(o.end()));
+          return *this;
+        }
+        resetStorage();
+        this->propagateOnMoveAssign(o);
+      }
       clear();
       swap(o);
     }
@@ -564,7 +841,7 @@ class small_vector : public detail::small_vector_base<
   }
 
   allocator_type get_allocator() const {
-    return {};
+    return this->heldAllocator();
   }
 
   size_type size() const {
@@ -626,6 +903,13 @@ class small_vector : public detail::small_vector_base<
   void swap(small_vector& o) {
     using std::swap; // Allow ADL on swap for our value_type.
 
+    // As with std containers, the allocators must be equal if they are
+    // not swapped.
+    assert(
+        AllocatorTraits::propagate_on_container_swap::value ||
+        get_allocator() == o.get_allocator());
+    this->propagateOnSwap(o);
+
     if (this->isExtern() && o.isExtern()) {
       this->swapSizePolicy(o);
 
@@ -779,7 +1063,7 @@ class small_vector : public detail::small_vector_base<
       return;
     }
 
-    small_vector tmp(begin(), end());
+    small_vector tmp(begin(), end(), get_allocator());
     tmp.swap(*this);
   }
 
@@ -878,20 +1162,20 @@ class small_vector : public detail::small_vector_base<
   }
 
   iterator erase(const_iterator q) {
-    std::move(unconst(q) + 1, end(), unconst(q));
-    (data() + size() - 1)->~value_type();
-    this->setSize(size() - 1);
-    return unconst(q);
+    return erase(q, q + 1);
   }
 
   iterator erase(const_iterator q1, const_iterator q2) {
     if (q1 == q2) {
       return unconst(q1);
     }
-    std::move(unconst(q2), end(), unconst(q1));
-    for (auto it = (end() - std::distance(q1, q2)); it != end(); ++it) {
-      it->~value_type();
-    }
+    eraseImpl(
+        unconst(q1),
+        unconst(q2),
+        std::integral_constant<
+            bool,
+            folly::IsRelocatable<value_type>::value &&
+                !folly::is_trivially_copyable<value_type>::value>());
     this->setSize(size() - (q2 - q1));
     return unconst(q1);
   }
@@ -1021,7 +1305,7 @@ class small_vector : public detail::small_vector_base<
     {
       auto rollback = makeGuard([&] {
         if (this->isExtern()) {
-          u.freeHeap();
+          freeHeap();
         }
       });
       detail::populateMemForward(
@@ -1037,7 +1321,7 @@ class small_vector : public detail::small_vector_base<
     {
       auto rollback = makeGuard([&] {
         if (this->isExtern()) {
-          u.freeHeap();
+          freeHeap();
         }
       });
       detail::populateMemForward(data(), n, std::forward<InitFunc>(func));
@@ -1101,19 +1385,28 @@ class small_vector : public detail::small_vector_base<
       return;
     }
 
+    auto const minBytes = newSize * sizeof(value_type);
     newSize = std::max(newSize, computeNewSize());
 
     auto needBytes = newSize * sizeof(value_type);
     // If the capacity isn't explicitly stored inline, but the heap
     // allocation is grown to over some threshold, we should store
     // a capacity at the front of the heap allocation.
-    bool heapifyCapacity =
-        !kHasInlineCapacity && needBytes > kHeapifyCapacityThreshold;
+    // Allocators don't report the usable size, so we always store it.
+    bool heapifyCapacity = !kHasInlineCapacity &&
+        (!kUsesMalloc || needBytes > kHeapifyCapacityThreshold);
     if (heapifyCapacity) {
       needBytes += kHeapifyCapacitySize;
     }
-    auto const sizeBytes = goodMallocSize(needBytes);
-    void* newh = checkedMalloc(sizeBytes);
+    auto const sizeBytes = kUsesMalloc ? goodMallocSize(needBytes) : needBytes;
+    if ((!insert || pos == size()) &&
+        expandInPlace(minBytes, sizeBytes, heapifyCapacity)) {
+      if (insert) {
+        emplaceFunc(end());
+      }
+      return;
+    }
+    void* newh = allocateHeap(sizeBytes);
     // We expect newh to be at least 2-aligned, because we want to
     // use its least significant bit as a flag.
     assert(!detail::pointerFlagGet(newh));
@@ -1124,24 +1417,21 @@ class small_vector : public detail::small_vector_base<
 
     {
       auto rollback = makeGuard([&] { //
-        free(newh);
+        deallocateHeap(newh, sizeBytes);
       });
       if (insert) {
-        // move and insert the new element
-        this->moveToUninitializedEmplace(
+        // relocate and insert the new element
+        this->relocateToUninitializedEmplace(
             begin(), end(), newp, pos, std::forward<EmplaceFunc>(emplaceFunc));
       } else {
-        // move without inserting new element
-        this->moveToUninitialized(begin(), end(), newp);
+        // relocate without inserting new element
+        this->relocateToUninitialized(begin(), end(), newp);
       }
       rollback.dismiss();
     }
-    for (auto& val : *this) {
-      val.~value_type();
-    }
 
     if (this->isExtern()) {
-      u.freeHeap();
+      freeHeap();
     }
     auto availableSizeBytes = sizeBytes;
     if (heapifyCapacity) {
@@ -1154,6 +1444,53 @@ class small_vector : public detail::small_vector_base<
     this->setCapacity(availableSizeBytes / sizeof(value_type));
   }
 
+  /*
+   * Grows the current heap allocation to at least minBytes, and up to
+   * maxBytes, with jemalloc's xallocx(), so that the elements need not be
+   * relocated. Only done when the capacity would stay stored in the same
+   * place (inline or on the heap). Returns whether it succeeded.
+   */
+  bool expandInPlace(size_t minBytes, size_t maxBytes, bool heapifyCapacity) {
+    if (!kUsesMalloc || !this->isExtern() || !usingJEMalloc()) {
+      return false;
+    }
+    bool const heapified =
+        !kHasInlineCapacity && detail::pointerFlagGet(u.pdata_.heap_);
+    if (heapified != heapifyCapacity) {
+      return false;
+    }
+    size_t const prefixBytes = heapified ? kHeapifyCapacitySize : 0;
+    if (capacity() * sizeof(value_type) + prefixBytes <
+        folly::jemallocMinInPlaceExpandable) {
+      return false;
+    }
+    minBytes += prefixBytes;
+    void* const p = detail::pointerFlagClear(u.pdata_.heap_);
+    size_t const actualBytes = xallocx(p, minBytes, maxBytes - minBytes, 0);
+    if (actualBytes < minBytes) {
+      return false;
+    }
+    this->setCapacity((actualBytes - prefixBytes) / sizeof(value_type));
+    return true;
+  }
+
+  void eraseImpl(value_type* q1, value_type* q2, std::true_type) {
+    for (auto it = q1; it != q2; ++it) {
+      it->~value_type();
+    }
+    std::memmove(
+        static_cast<void*>(q1),
+        static_cast<void const*>(q2),
+        (end() - q2) * sizeof(value_type));
+  }
+
+  void eraseImpl(value_type* q1, value_type* q2, std::false_type) {
+    std::move(q2, end(), q1);
+    for (auto it = (end() - (q2 - q1)); it != end(); ++it) {
+      it->~value_type();
+    }
+  }
+
   /*
    * This will set the capacity field, stored inline in the storage_ field
    * if there is sufficient room to store it.
@@ -1166,6 +1503,51 @@ class small_vector : public detail::small_vector_base<
     }
   }
 
+  void* allocateHeap(size_t sizeBytes) {
+    if (kUsesMalloc) {
+      return checkedMalloc(sizeBytes);
+    }
+    HeapAllocator alloc(get_allocator());
+    return std::allocator_traits<HeapAllocator>::allocate(
+        alloc, heapUnits(sizeBytes));
+  }
+
+  void deallocateHeap(void* p, size_t sizeBytes) {
+    if (kUsesMalloc) {
+      free(p);
+      return;
+    }
+    HeapAllocator alloc(get_allocator());
+    std::allocator_traits<HeapAllocator>::deallocate(
+        alloc, static_cast<HeapUnit*>(p), heapUnits(sizeBytes));
+  }
+
+  void freeHeap() {
+    auto vp = detail::pointerFlagClear(u.pdata_.heap_);
+    if (kUsesMalloc) {
+      free(vp);
+      return;
+    }
+    // the buffer was allocated for exactly capacity() elements
+    auto sizeBytes = capacity() * sizeof(value_type) +
+        (kHasInlineCapacity ? 0 : kHeapifyCapacitySize);
+    deallocateHeap(vp, sizeBytes);
+  }
+
+  // Destroys the elements and frees the heap buffer, if any.
+  void resetStorage() {
+    clear();
+    if (this->isExtern()) {
+      freeHeap();
+      u.pdata_.heap_ = nullptr;
+      this->setExtern(false);
+    }
+  }
+
+  static size_t heapUnits(size_t sizeBytes) {
+    return (sizeBytes + sizeof(HeapUnit) - 1) / sizeof(HeapUnit);
+  }
+
  private:
   struct HeapPtrWithCapacity {
     void* heap_;
@@ -1216,6 +1598,17 @@ class small_vector : public detail::small_vector_base<
       conditional<kHasInlineCapacity, HeapPtrWithCapacity, HeapPtr>::type
           PointerType;
 
+  static bool constexpr kUsesMalloc =
+      std::is_same<allocator_type, std::allocator<value_type>>::value;
+
+  // Unit of allocation with allocator_type, aligned for the elements, the
+  // capacity stored in front of them and the pointer flag.
+  static constexpr std::size_t kHeapUnitSize = constexpr_max(
+      alignof(value_type), alignof(InternalSizeType), std::size_t(2));
+  typedef std::aligned_storage_t<kHeapUnitSize, kHeapUnitSize> HeapUnit;
+  typedef typename AllocatorTraits::template rebind_alloc<HeapUnit>
+      HeapAllocator;
+
   union Data {
     explicit Data() {
       pdata_.heap_ = nullptr;
@@ -1252,11 +1645,6 @@ class small_vector : public detail::small_vector_base<
     void setCapacity(InternalSizeType c) {
       pdata_.setCapacity(c);
     }
-
-    void freeHeap() {
-      auto vp = detail::pointerFlagClear(pdata_.heap_);
-      free(vp);
-    }
   } u;
 };
 FOLLY_SV_PACK_POP
@@ -1290,6 +1678,29 @@ void erase_if(small_vector<T, MaxInline, A, B, C>& v, Predicate predicate) {
 
 //////////////////////////////////////////////////////////////////////
 
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+namespace pmr {
+
+template <
+    class Value,
+    std::size_t RequestedMaxInline = 1,
+    class PolicyA = void,
+    class PolicyB = void>
+using small_vector = folly::small_vector<
+    Value,
+    RequestedMaxInline,
+    PolicyA,
+    PolicyB,
+    small_vector_policy::Allocator<
+        folly::detail::std_pmr::polymorphic_allocator<Value>>>;
+
+} // namespace pmr
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
+
+//////////////////////////////////////////////////////////////////////
+
 namespace detail {
 
 // Format support.
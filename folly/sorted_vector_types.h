@@ -201,6 +201,73 @@ void bulk_insert(
       cont.end());
 }
 
+/*
+ * Inserts the sorted and unique [first, last) into cont, growing it by
+ * the number of new elements only: elements equal to existing ones are
+ * skipped, and the new elements are merged from the back in place, so
+ * that nothing is moved twice and no merge buffer is allocated.
+ */
+template <class OurContainer, class Vector, class Iterator>
+void bulk_insert_sorted_unique(
+    OurContainer& sorted,
+    Vector& cont,
+    Iterator first,
+    Iterator last) {
+  if (first == last) {
+    return;
+  }
+  auto const& cmp(sorted.value_comp());
+  assert(std::adjacent_find(first, last, [&](auto const& a, auto const& b) {
+           return !cmp(a, b);
+         }) == last);
+
+  // appending, as when building from sorted batches
+  if (cont.empty() || cmp(cont.back(), *first)) {
+    cont.insert(cont.end(), first, last);
+    return;
+  }
+
+  // Append the elements that are new, in order: they make the room the
+  // merge needs, and are already in place if they all go last.
+  auto const prev_size = cont.size();
+  cont.reserve(prev_size + std::distance(first, last));
+  size_t pos = 0;
+  size_t before_end = 0;
+  for (auto j = first; j != last; ++j) {
+    auto const prev_end = cont.begin() + prev_size;
+    auto i = std::lower_bound(cont.begin() + pos, prev_end, *j, cmp);
+    pos = i - cont.begin();
+    if (i == prev_end || cmp(*j, *i)) {
+      before_end += i != prev_end;
+      cont.push_back(*j);
+    }
+  }
+  if (before_end == 0) {
+    return;
+  }
+
+  // Merge the others from the back, skipping the input elements that
+  // were already there and those that went last.
+  auto const begin = cont.begin();
+  auto in = begin + prev_size;
+  auto out = cont.end() - (cont.size() - prev_size - before_end);
+  auto j = last;
+  while (cmp(*(in - 1), *std::prev(j))) {
+    --j;
+  }
+  while (before_end != 0) {
+    --j;
+    while (in != begin && cmp(*j, *(in - 1))) {
+      *--out = std::move(*--in);
+    }
+    if (in == begin || cmp(*(in - 1), *j)) {
+      *--out = *j;
+      --before_end;
+    }
+  }
+  assert(out == in);
+}
+
 template <typename Container, typename Compare>
 bool is_sorted_unique(Container const& container, Compare const& comp) {
   if (container.empty()) {
@@ -488,6 +555,16 @@ class sorted_vector_set : detail::growth_policy_wrapper<GrowthPolicy> {
     detail::bulk_insert(*this, m_.cont_, first, last);
   }
 
+  // Inserts a range whose elements must be sorted and unique, as
+  // sorted_unique_t hints, merging it in place: the only allocation is
+  // the growth of the vector, and existing elements move at most once.
+  // Elements equal to existing ones are not inserted.
+  template <class ForwardIterator>
+  void
+  bulk_insert(sorted_unique_t, ForwardIterator first, ForwardIterator last) {
+    detail::bulk_insert_sorted_unique(*this, m_.cont_, first, last);
+  }
+
   void insert(std::initializer_list<value_type> ilist) {
     insert(ilist.begin(), ilist.end());
   }
@@ -1015,6 +1092,16 @@ class sorted_vector_map : detail::growth_policy_wrapper<GrowthPolicy> {
     detail::bulk_insert(*this, m_.cont_, first, last);
   }
 
+  // Inserts a range whose elements must be sorted and unique, as
+  // sorted_unique_t hints, merging it in place: the only allocation is
+  // the growth of the vector, and existing elements move at most once.
+  // Elements equal to existing ones are not inserted.
+  template <class ForwardIterator>
+  void
+  bulk_insert(sorted_unique_t, ForwardIterator first, ForwardIterator last) {
+    detail::bulk_insert_sorted_unique(*this, m_.cont_, first, last);
+  }
+
   void insert(std::initializer_list<value_type> ilist) {
     insert(ilist.begin(), ilist.end());
   }
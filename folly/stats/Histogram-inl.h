@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <limits>
+#include <type_traits>
+
 #include <folly/Conv.h>
+#include <folly/stats/detail/BinaryEncoding.h>
 
 #include <glog/logging.h>
 
@@ -283,4 +287,61 @@ void Histogram<T>::toTSV(std::ostream& out, bool skipEmptyBuckets) const {
   }
 }
 
+template <typename T>
+void Histogram<T>::serialize(std::string& out) const {
+  detail::appendValue(out, getBucketSize());
+  detail::appendValue(out, getMin());
+  detail::appendValue(out, getMax());
+  detail::appendVarint(out, getNumBuckets());
+  for (size_t i = 0; i < getNumBuckets(); ++i) {
+    const auto& bucket = getBucketByIndex(i);
+    // the low bit tells whether the sum follows
+    bool hasSum = bucket.sum != ValueType();
+    detail::appendVarint(out, (bucket.count << 1) | (hasSum ? 1 : 0));
+    if (hasSum) {
+      detail::appendValue(out, bucket.sum);
+    }
+  }
+}
+
+template <typename T>
+Histogram<T> Histogram<T>::deserialize(ByteRange& data) {
+  auto bucketSize = detail::readValue<ValueType>(data);
+  auto min = detail::readValue<ValueType>(data);
+  auto max = detail::readValue<ValueType>(data);
+  auto numBuckets = detail::readVarint(data);
+  if (!detail::isFiniteValue(bucketSize) || !detail::isFiniteValue(min) ||
+      !detail::isFiniteValue(max) || !(bucketSize > ValueType(0)) ||
+      !(min < max)) {
+    throw std::invalid_argument("Invalid histogram encoding.");
+  }
+  // max - min must not overflow, as the constructor computes it
+  if (std::is_signed<ValueType>::value && min < ValueType(0) &&
+      max > std::numeric_limits<ValueType>::max() + min) {
+    throw std::invalid_argument("Invalid histogram encoding.");
+  }
+  // Each bucket takes at least one byte, which bounds the allocation of the
+  // constructor before it is checked against numBuckets.
+  if (numBuckets > data.size() ||
+      double((max - min) / bucketSize) > double(data.size())) {
+    throw std::invalid_argument("Invalid histogram encoding.");
+  }
+  Histogram histogram(bucketSize, min, max);
+  if (numBuckets != histogram.getNumBuckets()) {
+    throw std::invalid_argument("Invalid histogram encoding.");
+  }
+  for (size_t i = 0; i < histogram.getNumBuckets(); ++i) {
+    auto& bucket = histogram.buckets_.getByIndex(i);
+    auto countAndFlag = detail::readVarint(data);
+    bucket.count = countAndFlag >> 1;
+    if (countAndFlag & 1) {
+      bucket.sum = detail::readValue<ValueType>(data);
+      if (!detail::isFiniteValue(bucket.sum)) {
+        throw std::invalid_argument("Invalid histogram encoding.");
+      }
+    }
+  }
+  return histogram;
+}
+
 } // namespace folly
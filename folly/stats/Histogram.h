@@ -27,6 +27,7 @@
 #include <vector>
 
 #include <folly/CPortability.h>
+#include <folly/Range.h>
 #include <folly/Traits.h>
 #include <folly/stats/detail/Bucket.h>
 
@@ -451,6 +452,20 @@ class Histogram {
    */
   void toTSV(std::ostream& out, bool skipEmptyBuckets = true) const;
 
+  /*
+   * Appends a compact binary encoding of the histogram to out, from which
+   * deserialize() restores it exactly: integers are varints, and empty
+   * buckets take one byte.
+   */
+  void serialize(std::string& out) const;
+
+  /*
+   * Decodes a histogram written by serialize() from the front of data, and
+   * advances data past it.  Throws std::invalid_argument if data does not
+   * start with a valid encoding.
+   */
+  static Histogram deserialize(ByteRange& data);
+
   struct CountFromBucket {
     uint64_t operator()(const Bucket& bucket) const {
       return bucket.count;
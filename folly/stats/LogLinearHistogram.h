@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+
+namespace detail {
+
+/*
+ * The buckets of a log-linear histogram: values below 2^(SubBucketBits + 1)
+ * have a bucket each, and every following power of two range is split into
+ * 2^SubBucketBits buckets of equal width.  The width of a bucket is
+ * thus at most 2^-SubBucketBits of its lower bound.
+ */
+template <uint32_t SubBucketBits>
+struct LogLinearBuckets {
+  static_assert(
+      SubBucketBits >= 1 && SubBucketBits <= 20,
+      "SubBucketBits must be between 1 and 20");
+
+  static constexpr uint64_t kSubBuckets = uint64_t(1) << SubBucketBits;
+  static constexpr size_t kMaxNumBuckets = (65 - SubBucketBits) * kSubBuckets;
+
+  // Bucket shift b is 0 below 2 * kSubBuckets, and the position of the top
+  // bit minus SubBucketBits above: idx = b * kSubBuckets + (value >> b).
+  static size_t index(uint64_t value) {
+    uint32_t shift = findLastSet(value | kSubBuckets) - 1 - SubBucketBits;
+    return size_t(shift) * kSubBuckets + size_t(value >> shift);
+  }
+
+  static uint32_t shift(size_t idx) {
+    auto high = idx >> SubBucketBits;
+    return high <= 1 ? 0 : uint32_t(high - 1);
+  }
+
+  static uint64_t lowerBound(size_t idx) {
+    auto b = shift(idx);
+    return uint64_t(idx - size_t(b) * kSubBuckets) << b;
+  }
+
+  // inclusive
+  static uint64_t upperBound(size_t idx) {
+    return lowerBound(idx) + ((uint64_t(1) << shift(idx)) - 1);
+  }
+};
+
+} // namespace detail
+
+/*
+ * A histogram of unsigned integer values (typically latencies) with buckets
+ * of bounded relative width, as in HdrHistogram: values below
+ * 2^(SubBucketBits + 1) are recorded exactly, and others in buckets no
+ * wider than 2^-SubBucketBits of their values (3% with the default of 5).
+ * Covering values up to maxValue takes about
+ * (log2(maxValue) - SubBucketBits + 1) * 2^SubBucketBits buckets, e.g. 510
+ * buckets for values up to 10^6, and finding the bucket of a value is a few
+ * instructions around a count of leading zeros.
+ *
+ * Values above maxValue are recorded in the last bucket.  This class is not
+ * thread safe; see AtomicLogLinearHistogram.
+ */
+template <uint32_t SubBucketBits = 5>
+class LogLinearHistogram {
+  using Buckets = detail::LogLinearBuckets<SubBucketBits>;
+
+ public:
+  explicit LogLinearHistogram(
+      uint64_t maxValue = std::numeric_limits<uint64_t>::max())
+      : counts_(Buckets::index(maxValue) + 1) {}
+
+  void addValue(uint64_t value) {
+    addRepeatedValue(value, 1);
+  }
+
+  void addRepeatedValue(uint64_t value, uint64_t nSamples) {
+    counts_[getBucketIdx(value)] += nSamples;
+    count_ += nSamples;
+    sum_ += value * nSamples;
+  }
+
+  /*
+   * Adds the counts of another histogram, which must have the same number
+   * of buckets.
+   */
+  void merge(const LogLinearHistogram& other) {
+    if (other.counts_.size() != counts_.size()) {
+      throw_exception<std::invalid_argument>(
+          "Cannot merge from input histogram.");
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+  }
+
+  void clear() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+  }
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  // modulo 2^64
+  uint64_t sum() const {
+    return sum_;
+  }
+
+  size_t getNumBuckets() const {
+    return counts_.size();
+  }
+
+  size_t getBucketIdx(uint64_t value) const {
+    auto idx = Buckets::index(value);
+    return idx < counts_.size() ? idx : counts_.size() - 1;
+  }
+
+  uint64_t getBucketCount(size_t idx) const {
+    return counts_[idx];
+  }
+
+  uint64_t getBucketMin(size_t idx) const {
+    return Buckets::lowerBound(idx);
+  }
+
+  /*
+   * Inclusive; the last bucket also holds all the values above it.
+   */
+  uint64_t getBucketMax(size_t idx) const {
+    return Buckets::upperBound(idx);
+  }
+
+  /*
+   * Estimates the value at the given percentile, from 0.0 to 1.0, by
+   * interpolating linearly within its bucket.  Returns 0 if the histogram
+   * is empty.
+   */
+  uint64_t getPercentileEstimate(double pct) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    double rank = pct * double(count_);
+    uint64_t seen = 0;
+    size_t last = 0;
+    for (size_t idx = 0; idx < counts_.size(); ++idx) {
+      auto count = counts_[idx];
+      if (count == 0) {
+        continue;
+      }
+      last = idx;
+      if (double(seen + count) >= rank) {
+        double fraction = rank <= double(seen)
+            ? 0
+            : (rank - double(seen)) / double(count);
+        auto width = getBucketMax(idx) - getBucketMin(idx);
+        return getBucketMin(idx) + uint64_t(fraction * double(width));
+      }
+      seen += count;
+    }
+    return getBucketMax(last);
+  }
+
+  /*
+   * Adds the values of the histogram to a TimeseriesHistogram, or to
+   * anything with an addValue(now, value, times) method, as the middle
+   * values of their buckets.  Use a TimeseriesHistogram whose buckets are
+   * wider than the relevant buckets of this histogram.
+   */
+  template <typename Timeseries, typename TimePoint>
+  void addTo(Timeseries& timeseries, TimePoint now) const {
+    using ValueType = typename Timeseries::ValueType;
+    for (size_t idx = 0; idx < counts_.size(); ++idx) {
+      if (counts_[idx] != 0) {
+        auto middle = getBucketMin(idx) +
+            (getBucketMax(idx) - getBucketMin(idx)) / 2;
+        timeseries.addValue(now, ValueType(middle), counts_[idx]);
+      }
+    }
+  }
+
+ private:
+  template <uint32_t>
+  friend class AtomicLogLinearHistogram;
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_{0};
+  uint64_t sum_{0};
+};
+
+/*
+ * A LogLinearHistogram that any number of threads can record values into
+ * concurrently, with relaxed atomic increments of the bucket and of the
+ * sum; reads take a snapshot, which is not atomic with respect to
+ * concurrent recordings.
+ */
+template <uint32_t SubBucketBits = 5>
+class AtomicLogLinearHistogram {
+  using Buckets = detail::LogLinearBuckets<SubBucketBits>;
+
+ public:
+  explicit AtomicLogLinearHistogram(
+      uint64_t maxValue = std::numeric_limits<uint64_t>::max())
+      : numBuckets_(Buckets::index(maxValue) + 1),
+        counts_(new std::atomic<uint64_t>[numBuckets_]) {
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      counts_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void addValue(uint64_t value) {
+    addRepeatedValue(value, 1);
+  }
+
+  void addRepeatedValue(uint64_t value, uint64_t nSamples) {
+    auto idx = Buckets::index(value);
+    idx = idx < numBuckets_ ? idx : numBuckets_ - 1;
+    counts_[idx].fetch_add(nSamples, std::memory_order_relaxed);
+    sum_.fetch_add(value * nSamples, std::memory_order_relaxed);
+  }
+
+  size_t getNumBuckets() const {
+    return numBuckets_;
+  }
+
+  /*
+   * Copies the counts into a LogLinearHistogram covering the same values.
+   */
+  LogLinearHistogram<SubBucketBits> snapshot() const {
+    LogLinearHistogram<SubBucketBits> result(
+        Buckets::upperBound(numBuckets_ - 1));
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      auto count = counts_[i].load(std::memory_order_relaxed);
+      result.counts_[i] = count;
+      result.count_ += count;
+    }
+    result.sum_ = sum_.load(std::memory_order_relaxed);
+    return result;
+  }
+
+  /*
+   * Resets the histogram, and returns what it held: values recorded
+   * concurrently are either in the result or in the histogram.
+   */
+  LogLinearHistogram<SubBucketBits> exchange() {
+    LogLinearHistogram<SubBucketBits> result(
+        Buckets::upperBound(numBuckets_ - 1));
+    for (size_t i = 0; i < numBuckets_; ++i) {
+      auto count = counts_[i].exchange(0, std::memory_order_relaxed);
+      result.counts_[i] = count;
+      result.count_ += count;
+    }
+    result.sum_ = sum_.exchange(0, std::memory_order_relaxed);
+    return result;
+  }
+
+ private:
+  const size_t numBuckets_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<uint64_t> sum_{0};
+};
+
+} // namespace folly
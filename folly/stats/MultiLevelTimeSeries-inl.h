@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include <glog/logging.h>
 
 namespace folly {
@@ -25,7 +27,11 @@ MultiLevelTimeSeries<VT, CT>::MultiLevelTimeSeries(
     size_t nBuckets,
     size_t nLevels,
     const Duration levelDurations[])
-    : cachedTime_(), cachedSum_(0), cachedCount_(0) {
+    : cachedFirstTime_(),
+      cachedTime_(),
+      cachedEnd_(),
+      cachedSum_(0),
+      cachedCount_(0) {
   CHECK_GT(nLevels, 0u);
   CHECK(levelDurations);
 
@@ -44,7 +50,11 @@ template <typename VT, typename CT>
 MultiLevelTimeSeries<VT, CT>::MultiLevelTimeSeries(
     size_t nBuckets,
     std::initializer_list<Duration> durations)
-    : cachedTime_(), cachedSum_(0), cachedCount_(0) {
+    : cachedFirstTime_(),
+      cachedTime_(),
+      cachedEnd_(),
+      cachedSum_(0),
+      cachedCount_(0) {
   CHECK_GT(durations.size(), 0u);
 
   levels_.reserve(durations.size());
@@ -82,14 +92,30 @@ void MultiLevelTimeSeries<VT, CT>::addValueAggregated(
     TimePoint now,
     const ValueType& total,
     uint64_t nsamples) {
-  if (cachedTime_ != now) {
+  if (UNLIKELY(now < cachedTime_ || now >= cachedEnd_)) {
     flush();
-    cachedTime_ = now;
+    cacheTime(now);
   }
+  cachedTime_ = now;
   cachedSum_ += total;
   cachedCount_ += nsamples;
 }
 
+template <typename VT, typename CT>
+void MultiLevelTimeSeries<VT, CT>::cacheTime(TimePoint now) {
+  cachedFirstTime_ = now;
+  cachedEnd_ = TimePoint::max();
+  for (const auto& level : levels_) {
+    if (!level.isAllTime()) {
+      size_t bucketIdx;
+      TimePoint bucketStart;
+      TimePoint nextBucketStart;
+      level.getBucketInfo(now, &bucketIdx, &bucketStart, &nextBucketStart);
+      cachedEnd_ = std::min(cachedEnd_, nextBucketStart);
+    }
+  }
+}
+
 template <typename VT, typename CT>
 void MultiLevelTimeSeries<VT, CT>::update(TimePoint now) {
   flush();
@@ -103,11 +129,17 @@ void MultiLevelTimeSeries<VT, CT>::flush() {
   // update all the underlying levels
   if (cachedCount_ > 0) {
     for (size_t i = 0; i < levels_.size(); ++i) {
+      // The levels see the first and the latest times of the cached data
+      // points, which is all they would have kept of the intermediate ones.
+      if (cachedFirstTime_ != cachedTime_) {
+        levels_[i].addValueAggregated(cachedFirstTime_, ValueType(0), 0);
+      }
       levels_[i].addValueAggregated(cachedTime_, cachedSum_, cachedCount_);
     }
     cachedCount_ = 0;
     cachedSum_ = 0;
   }
+  cachedFirstTime_ = cachedTime_;
 }
 
 template <typename VT, typename CT>
@@ -116,7 +148,9 @@ void MultiLevelTimeSeries<VT, CT>::clear() {
     level.clear();
   }
 
+  cachedFirstTime_ = TimePoint();
   cachedTime_ = TimePoint();
+  cachedEnd_ = TimePoint();
   cachedSum_ = 0;
   cachedCount_ = 0;
 }
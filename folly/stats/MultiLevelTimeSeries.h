@@ -360,9 +360,11 @@ class MultiLevelTimeSeries {
   /*
    * Adds the value 'val' at time 'now' to all levels.
    *
-   * Data points added at the same time point is cached internally here and not
-   * propagated to the underlying levels until either flush() is called or when
-   * update from a different time comes.
+   * Data points added while time stays within the same bucket of every level
+   * are cached internally here and not propagated to the underlying levels
+   * until either flush() is called or a data point from a later bucket (or
+   * an earlier time) comes, so that adding one is usually just a comparison
+   * and two additions.
    *
    * This function expects time to always move forwards: it cannot be used to
    * add historical data points that have occurred in the past.  If now is
@@ -429,10 +431,15 @@ class MultiLevelTimeSeries {
  private:
   std::vector<Level> levels_;
 
-  // Updates within the same time interval are cached
-  // They are flushed out when updates from a different time comes,
-  // or flush() is called.
+  void cacheTime(TimePoint now);
+
+  // Updates within [cachedFirstTime_, cachedEnd_), the range of times
+  // falling into the same bucket of every level, are cached.
+  // They are flushed out when updates from an earlier time or from after
+  // cachedEnd_ come, or flush() is called.
+  TimePoint cachedFirstTime_;
   TimePoint cachedTime_;
+  TimePoint cachedEnd_;
   ValueType cachedSum_;
   uint64_t cachedCount_;
 };
@@ -26,8 +26,11 @@ QuantileEstimates estimatesFromDigest(
 } // namespace detail
 
 template <typename ClockT>
-SimpleQuantileEstimator<ClockT>::SimpleQuantileEstimator()
-    : bufferedDigest_(std::chrono::seconds{1}, 1000, 100) {}
+SimpleQuantileEstimator<ClockT>::SimpleQuantileEstimator(
+    typename ClockT::duration flushInterval,
+    size_t bufferSize,
+    size_t digestSize)
+    : bufferedDigest_(flushInterval, bufferSize, digestSize) {}
 
 template <typename ClockT>
 QuantileEstimates SimpleQuantileEstimator<ClockT>::estimateQuantiles(
@@ -45,8 +48,14 @@ void SimpleQuantileEstimator<ClockT>::addValue(double value, TimePoint now) {
 template <typename ClockT>
 SlidingWindowQuantileEstimator<ClockT>::SlidingWindowQuantileEstimator(
     std::chrono::seconds windowDuration,
-    size_t nWindows)
-    : bufferedSlidingWindow_(nWindows, windowDuration, 1000, 100) {}
+    size_t nWindows,
+    size_t bufferSize,
+    size_t digestSize)
+    : bufferedSlidingWindow_(
+          nWindows,
+          windowDuration,
+          bufferSize,
+          digestSize) {}
 
 template <typename ClockT>
 QuantileEstimates SlidingWindowQuantileEstimator<ClockT>::estimateQuantiles(
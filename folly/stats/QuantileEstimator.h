@@ -31,14 +31,26 @@ struct QuantileEstimates {
 };
 
 /*
- * A QuantileEstimator that buffers writes for 1 second.
+ * Writes are buffered in per-cpu buffers of bufferSize values, which are
+ * merged into per-cpu digests of digestSize centroids when full, and into
+ * the estimator's digests when buffers are flushed.
+ */
+constexpr size_t kQuantileEstimatorDefaultBufferSize = 1000;
+constexpr size_t kQuantileEstimatorDefaultDigestSize = 100;
+
+/*
+ * A QuantileEstimator that buffers writes for flushInterval (1 second by
+ * default).
  */
 template <typename ClockT = std::chrono::steady_clock>
 class SimpleQuantileEstimator {
  public:
   using TimePoint = typename ClockT::time_point;
 
-  SimpleQuantileEstimator();
+  explicit SimpleQuantileEstimator(
+      typename ClockT::duration flushInterval = std::chrono::seconds{1},
+      size_t bufferSize = kQuantileEstimatorDefaultBufferSize,
+      size_t digestSize = kQuantileEstimatorDefaultDigestSize);
 
   QuantileEstimates estimateQuantiles(
       Range<const double*> quantiles,
@@ -66,7 +78,9 @@ class SlidingWindowQuantileEstimator {
 
   SlidingWindowQuantileEstimator(
       std::chrono::seconds windowDuration,
-      size_t nWindows = 60);
+      size_t nWindows = 60,
+      size_t bufferSize = kQuantileEstimatorDefaultBufferSize,
+      size_t digestSize = kQuantileEstimatorDefaultDigestSize);
 
   QuantileEstimates estimateQuantiles(
       Range<const double*> quantiles,
@@ -18,9 +18,13 @@
 
 #include <glog/logging.h>
 
+#include <folly/lang/Exception.h>
+#include <folly/stats/detail/BinaryEncoding.h>
 #include <folly/stats/detail/DoubleRadixSort.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits>
 
 namespace folly {
@@ -210,6 +214,29 @@ TDigest TDigest::merge(sorted_equivalent_t, Range<const double*> sortedValues)
 }
 
 TDigest TDigest::merge(Range<const TDigest*> digests) {
+  if (digests.empty()) {
+    return TDigest();
+  }
+  return merge(digests, digests.begin()->maxSize_);
+}
+
+TDigest TDigest::merge(Range<const TDigest*> digests, size_t maxSize) {
+  if (digests.size() > kMaxDigestsPerMerge) {
+    // Merging is bound by memory bandwidth when the centroids of all the
+    // digests do not fit in cache; merging groups of digests first also
+    // compresses their centroids before they are merged again.
+    std::vector<TDigest> merged;
+    merged.reserve(
+        (digests.size() + kMaxDigestsPerMerge - 1) / kMaxDigestsPerMerge);
+    for (size_t i = 0; i < digests.size(); i += kMaxDigestsPerMerge) {
+      auto end = std::min(digests.size(), i + kMaxDigestsPerMerge);
+      merged.push_back(merge(
+          Range<const TDigest*>(digests.begin() + i, digests.begin() + end),
+          maxSize));
+    }
+    return merge(merged, maxSize);
+  }
+
   size_t nCentroids = 0;
   for (const auto& digest : digests) {
     nCentroids += digest.centroids_.size();
@@ -272,7 +299,6 @@ TDigest TDigest::merge(Range<const TDigest*> digests) {
 
   DCHECK(std::is_sorted(centroids.begin(), centroids.end()));
 
-  size_t maxSize = digests.begin()->maxSize_;
   TDigest result(maxSize);
 
   std::vector<Centroid> compressed;
@@ -370,6 +396,114 @@ double TDigest::estimateQuantile(double q) const {
   return clamp(value, min, max);
 }
 
+namespace {
+
+enum SerializationFlags : uint64_t {
+  kIntegralWeights = 1,
+};
+
+// Maps doubles to integers in the same order, so that the means of sorted
+// centroids map to increasing integers, whose differences are small.
+uint64_t orderedBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits >> 63 ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+double fromOrderedBits(uint64_t bits) {
+  bits = bits >> 63 ? bits & ~(uint64_t(1) << 63) : ~bits;
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+bool isIntegralWeight(double weight) {
+  return weight >= 1 && weight <= double(uint64_t(1) << 53) &&
+      weight == std::floor(weight);
+}
+
+} // namespace
+
+void TDigest::serialize(std::string& out) const {
+  bool integralWeights = std::all_of(
+      centroids_.begin(), centroids_.end(), [](const Centroid& centroid) {
+        return isIntegralWeight(centroid.weight());
+      });
+  detail::appendVarint(out, integralWeights ? kIntegralWeights : 0);
+  detail::appendVarint(out, maxSize_);
+  detail::appendFloat(out, sum_);
+  detail::appendFloat(out, count_);
+  detail::appendFloat(out, max_);
+  detail::appendFloat(out, min_);
+  detail::appendVarint(out, centroids_.size());
+  // means are sorted, so the deltas are small
+  uint64_t previous = 0;
+  for (const auto& centroid : centroids_) {
+    auto bits = orderedBits(centroid.mean());
+    detail::appendVarint(out, bits - previous);
+    previous = bits;
+  }
+  for (const auto& centroid : centroids_) {
+    if (integralWeights) {
+      detail::appendVarint(out, uint64_t(centroid.weight()));
+    } else {
+      detail::appendFloat(out, centroid.weight());
+    }
+  }
+}
+
+std::string TDigest::serialize() const {
+  std::string out;
+  serialize(out);
+  return out;
+}
+
+TDigest TDigest::deserialize(ByteRange& data) {
+  auto flags = detail::readVarint(data);
+  if (flags & ~uint64_t(kIntegralWeights)) {
+    throw_exception<std::invalid_argument>("Unknown TDigest encoding");
+  }
+  auto maxSize = detail::readVarint(data);
+  if (maxSize == 0) {
+    throw_exception<std::invalid_argument>("Invalid TDigest size");
+  }
+  TDigest result(maxSize);
+  result.sum_ = detail::readFloat<double>(data);
+  result.count_ = detail::readFloat<double>(data);
+  result.max_ = detail::readFloat<double>(data);
+  result.min_ = detail::readFloat<double>(data);
+  auto size = detail::readVarint(data);
+  // each centroid takes at least 2 bytes
+  if (size > data.size() / 2) {
+    throw_exception<std::invalid_argument>("Truncated TDigest");
+  }
+  result.centroids_.reserve(size);
+  uint64_t bits = 0;
+  for (uint64_t i = 0; i < size; ++i) {
+    auto delta = detail::readVarint(data);
+    // a wrapped delta means unsorted means
+    if (bits + delta < bits) {
+      throw_exception<std::invalid_argument>("Unsorted TDigest centroids");
+    }
+    bits += delta;
+    double mean = fromOrderedBits(bits);
+    if (!std::isfinite(mean)) {
+      throw_exception<std::invalid_argument>("Invalid TDigest centroid");
+    }
+    result.centroids_.emplace_back(mean);
+  }
+  for (auto& centroid : result.centroids_) {
+    double weight = flags & kIntegralWeights
+        ? double(detail::readVarint(data))
+        : detail::readFloat<double>(data);
+    if (!(weight > 0)) {
+      throw_exception<std::invalid_argument>("Invalid TDigest centroid");
+    }
+    centroid = Centroid(centroid.mean(), weight);
+  }
+  return result;
+}
+
 double TDigest::Centroid::add(double sum, double weight) {
   sum += (mean_ * weight_);
   weight_ += weight;
@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <string>
 #include <vector>
 
 #include <folly/Range.h>
@@ -103,15 +104,37 @@ class TDigest {
 
   /*
    * Returns a new TDigest constructed with values merged from the given
-   * digests.
+   * digests.  More than kMaxDigestsPerMerge digests are merged in groups of
+   * kMaxDigestsPerMerge, whose results are then merged, so that each merge
+   * sorts few enough centroids to stay in cache.
    */
   static TDigest merge(Range<const TDigest*> digests);
 
+  static constexpr size_t kMaxDigestsPerMerge = 16;
+
   /*
    * Estimates the value of the given quantile.
    */
   double estimateQuantile(double q) const;
 
+  /*
+   * Appends a compact binary encoding of the digest to out, from which
+   * deserialize() restores it exactly.  Centroid means are delta-encoded
+   * varints of their order-preserving bit patterns, and weights are
+   * varints when they are all integers, as they are for digests built
+   * from values.
+   */
+  void serialize(std::string& out) const;
+  std::string serialize() const;
+
+  /*
+   * Decodes a digest written by serialize() from the front of data, and
+   * advances data past it, so that digests can be read one after another
+   * from a buffer without copying it.  Throws std::invalid_argument if data
+   * does not start with a valid encoding.
+   */
+  static TDigest deserialize(ByteRange& data);
+
   double mean() const {
     return count_ ? sum_ / count_ : 0;
   }
@@ -145,6 +168,8 @@ class TDigest {
   }
 
  private:
+  static TDigest merge(Range<const TDigest*> digests, size_t maxSize);
+
   std::vector<Centroid> centroids_;
   size_t maxSize_;
   double sum_;
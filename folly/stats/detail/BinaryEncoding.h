@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <folly/Range.h>
+#include <folly/Varint.h>
+#include <folly/lang/Bits.h>
+#include <folly/lang/Exception.h>
+
+namespace folly {
+namespace detail {
+
+/*
+ * Helpers for the binary encodings of stats types: varints and
+ * little-endian floating point values, which are read from the front of a
+ * ByteRange.  Readers throw std::invalid_argument on truncated input.
+ */
+
+inline void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[kMaxVarintLength64];
+  out.append(reinterpret_cast<const char*>(buf), encodeVarint(value, buf));
+}
+
+inline uint64_t readVarint(ByteRange& data) {
+  return decodeVarint(data);
+}
+
+template <typename F>
+void appendFloat(std::string& out, F value) {
+  using Bits = std::conditional_t<sizeof(F) == 8, uint64_t, uint32_t>;
+  static_assert(sizeof(F) == sizeof(Bits), "unsupported floating point type");
+  Bits bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  bits = Endian::little(bits);
+  out.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+}
+
+template <typename F>
+F readFloat(ByteRange& data) {
+  using Bits = std::conditional_t<sizeof(F) == 8, uint64_t, uint32_t>;
+  static_assert(sizeof(F) == sizeof(Bits), "unsupported floating point type");
+  if (data.size() < sizeof(Bits)) {
+    throw_exception<std::invalid_argument>("Truncated floating point value");
+  }
+  Bits bits;
+  std::memcpy(&bits, data.data(), sizeof(bits));
+  data.advance(sizeof(bits));
+  bits = Endian::little(bits);
+  F value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Signed integers are zigzag encoded, unsigned ones are plain varints and
+// floating point values are stored as is.
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value>
+appendValue(std::string& out, T value) {
+  appendVarint(out, encodeZigZag(int64_t(value)));
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value>
+appendValue(std::string& out, T value) {
+  appendVarint(out, uint64_t(value));
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value> appendValue(
+    std::string& out,
+    T value) {
+  appendFloat(out, value);
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value, T>
+readValue(ByteRange& data) {
+  return T(decodeZigZag(readVarint(data)));
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value, T>
+readValue(ByteRange& data) {
+  return T(readVarint(data));
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value, T> readValue(
+    ByteRange& data) {
+  return readFloat<T>(data);
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral<T>::value, bool> isFiniteValue(T) {
+  return true;
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point<T>::value, bool> isFiniteValue(
+    T value) {
+  return std::isfinite(value);
+}
+
+} // namespace detail
+} // namespace folly
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/stats/detail/MannWhitney.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace folly {
+namespace detail {
+
+double median(std::vector<double> values) {
+  auto mid = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), mid, values.end());
+  if (values.size() % 2 != 0) {
+    return *mid;
+  }
+  return (*mid + *std::max_element(values.begin(), mid)) / 2;
+}
+
+double mannWhitneyGreater(
+    const std::vector<double>& x,
+    const std::vector<double>& y) {
+  size_t m = x.size();
+  size_t n = y.size();
+
+  // The groups of equal values in increasing order, as the number of values
+  // of x and of y in each.
+  std::vector<std::pair<double, bool>> all;
+  all.reserve(m + n);
+  for (auto v : x) {
+    all.emplace_back(v, true);
+  }
+  for (auto v : y) {
+    all.emplace_back(v, false);
+  }
+  std::sort(all.begin(), all.end());
+  std::vector<std::pair<size_t, size_t>> groups;
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (i == 0 || all[i].first != all[i - 1].first) {
+      groups.emplace_back(0, 0);
+    }
+    ++(all[i].second ? groups.back().first : groups.back().second);
+  }
+
+  // 2U is an integer: a value of x in a group gets 2 for every value of y in
+  // the groups below and 1 for every value of y in its own group.
+  size_t twiceU = 0;
+  size_t yBelow = 0;
+  for (auto const& group : groups) {
+    twiceU += group.first * (2 * yBelow + group.second);
+    yBelow += group.second;
+  }
+
+  // ways[i][s] is the number of ways of picking i values of x among the
+  // groups processed so far for a 2U of s, with the others going to y.
+  size_t maxTwiceU = 2 * m * n;
+  std::vector<std::vector<double>> ways(
+      m + 1, std::vector<double>(maxTwiceU + 1, 0));
+  std::vector<std::vector<double>> next(ways);
+  ways[0][0] = 1;
+  std::vector<double> binomial;
+  size_t placed = 0;
+  for (auto const& group : groups) {
+    size_t size = group.first + group.second;
+    // binomial[a] is the number of ways of picking a values of the group
+    binomial.assign(size + 1, 1);
+    for (size_t a = 1; a <= size; ++a) {
+      binomial[a] = binomial[a - 1] * double(size - a + 1) / double(a);
+    }
+    for (auto& row : next) {
+      std::fill(row.begin(), row.end(), 0);
+    }
+    for (size_t i = 0; i <= std::min(m, placed); ++i) {
+      if (placed - i > n) {
+        continue;
+      }
+      size_t below = placed - i;
+      for (size_t a = 0; a <= size && i + a <= m; ++a) {
+        if (below + size - a > n) {
+          continue;
+        }
+        size_t add = a * (2 * below + size - a);
+        for (size_t s = 0; s + add <= maxTwiceU; ++s) {
+          if (ways[i][s] != 0) {
+            next[i + a][s + add] += ways[i][s] * binomial[a];
+          }
+        }
+      }
+    }
+    std::swap(ways, next);
+    placed += size;
+  }
+
+  double total = 0;
+  double atLeast = 0;
+  for (size_t s = 0; s <= maxTwiceU; ++s) {
+    total += ways[m][s];
+    if (s >= twiceU) {
+      atLeast += ways[m][s];
+    }
+  }
+  return std::min(atLeast / total, 1.0);
+}
+
+} // namespace detail
+} // namespace folly
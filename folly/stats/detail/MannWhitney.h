@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace folly {
+namespace detail {
+
+/*
+ * The median of a non-empty sample; the mean of the two middle values if
+ * its size is even.
+ */
+double median(std::vector<double> values);
+
+/*
+ * Exact one-sided Mann-Whitney U test: the probability, if both samples
+ * come from the same distribution, of x exceeding y in at least as many
+ * pairs as observed, where ties count as half.
+ *
+ * Ties are accounted for exactly, by taking the distribution of U over the
+ * arrangements of the samples that keep the observed groups of equal
+ * values.  Without ties, this is the usual distribution of U.  The cost is
+ * O((m + n) * m * m * n) for samples of sizes m and n.
+ */
+double mannWhitneyGreater(
+    const std::vector<double>& x,
+    const std::vector<double>& y);
+
+} // namespace detail
+} // namespace folly
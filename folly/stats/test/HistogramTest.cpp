@@ -16,7 +16,10 @@
 
 #include <folly/stats/Histogram.h>
 
+#include <limits>
+
 #include <folly/portability/GTest.h>
+#include <folly/stats/detail/BinaryEncoding.h>
 
 using folly::Histogram;
 
@@ -220,3 +223,82 @@ TEST(Histogram, Counts) {
   }
   EXPECT_EQ(110, h.computeTotalCount());
 }
+
+template <typename T>
+void expectSameHistogram(const Histogram<T>& expected, const Histogram<T>& h) {
+  EXPECT_EQ(expected.getBucketSize(), h.getBucketSize());
+  EXPECT_EQ(expected.getMin(), h.getMin());
+  EXPECT_EQ(expected.getMax(), h.getMax());
+  ASSERT_EQ(expected.getNumBuckets(), h.getNumBuckets());
+  for (size_t i = 0; i < h.getNumBuckets(); ++i) {
+    EXPECT_EQ(expected.getBucketByIndex(i).count, h.getBucketByIndex(i).count);
+    EXPECT_EQ(expected.getBucketByIndex(i).sum, h.getBucketByIndex(i).sum);
+  }
+}
+
+TEST(Histogram, Serialize) {
+  Histogram<int64_t> h(10, -100, 1000);
+  for (int64_t i = -200; i < 300; i += 7) {
+    h.addValue(i);
+  }
+  h.addRepeatedValue(5000, 1000000);
+
+  std::string data;
+  h.serialize(data);
+  // mostly empty buckets
+  EXPECT_LT(data.size(), 2 * h.getNumBuckets());
+  Histogram<double> d(0.5, 0, 10);
+  d.addValue(1.25);
+  d.addValue(-3);
+  d.serialize(data);
+
+  folly::ByteRange range(folly::StringPiece{data});
+  expectSameHistogram(h, Histogram<int64_t>::deserialize(range));
+  expectSameHistogram(d, Histogram<double>::deserialize(range));
+  EXPECT_TRUE(range.empty());
+}
+
+TEST(Histogram, DeserializeInvalid) {
+  Histogram<int32_t> h(1, 0, 10);
+  h.addValue(3);
+  std::string data;
+  h.serialize(data);
+  for (size_t size = 0; size < data.size(); ++size) {
+    folly::ByteRange range(folly::StringPiece(data.data(), size));
+    EXPECT_THROW(Histogram<int32_t>::deserialize(range), std::invalid_argument);
+  }
+  // bucket size of 0
+  std::string zero(4, '\0');
+  folly::ByteRange range(folly::StringPiece{zero});
+  EXPECT_THROW(Histogram<int32_t>::deserialize(range), std::invalid_argument);
+
+  auto encode = [](auto bucketSize, auto min, auto max, uint64_t numBuckets) {
+    std::string out;
+    folly::detail::appendValue(out, bucketSize);
+    folly::detail::appendValue(out, min);
+    folly::detail::appendValue(out, max);
+    folly::detail::appendVarint(out, numBuckets);
+    return out;
+  };
+  // too many buckets for the data, rejected before allocating them
+  auto huge = encode(int64_t(1), int64_t(0), int64_t(1) << 60, 1);
+  range = folly::StringPiece{huge};
+  EXPECT_THROW(Histogram<int64_t>::deserialize(range), std::invalid_argument);
+  // max - min overflows
+  auto overflow = encode(
+      int64_t(1) << 62,
+      std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int64_t>::max(),
+      6);
+  overflow.append(6, '\0');
+  range = folly::StringPiece{overflow};
+  EXPECT_THROW(Histogram<int64_t>::deserialize(range), std::invalid_argument);
+  // not finite
+  for (double value : {std::numeric_limits<double>::infinity(),
+                       std::numeric_limits<double>::quiet_NaN()}) {
+    auto infinite = encode(1.0, 0.0, value, 1);
+    infinite.push_back('\0');
+    range = folly::StringPiece{infinite};
+    EXPECT_THROW(Histogram<double>::deserialize(range), std::invalid_argument);
+  }
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/stats/LogLinearHistogram.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <folly/portability/GTest.h>
+#include <folly/stats/TimeseriesHistogram.h>
+
+using folly::AtomicLogLinearHistogram;
+using folly::LogLinearHistogram;
+
+TEST(LogLinearHistogram, Buckets) {
+  LogLinearHistogram<5> h;
+  EXPECT_EQ((65 - 5) * 32, h.getNumBuckets());
+
+  // every value is in the bucket whose bounds contain it, and consecutive
+  // buckets are adjacent
+  for (size_t idx = 0; idx < h.getNumBuckets(); ++idx) {
+    auto min = h.getBucketMin(idx);
+    auto max = h.getBucketMax(idx);
+    EXPECT_EQ(idx, h.getBucketIdx(min));
+    EXPECT_EQ(idx, h.getBucketIdx(max));
+    EXPECT_LE((max - min) * 32, min);
+    if (idx + 1 < h.getNumBuckets()) {
+      EXPECT_EQ(max + 1, h.getBucketMin(idx + 1));
+    }
+  }
+  EXPECT_EQ(0, h.getBucketMin(0));
+  EXPECT_EQ(uint64_t(-1), h.getBucketMax(h.getNumBuckets() - 1));
+
+  // small values are exact
+  for (uint64_t v = 0; v < 64; ++v) {
+    EXPECT_EQ(v, h.getBucketIdx(v));
+  }
+}
+
+TEST(LogLinearHistogram, MaxValue) {
+  LogLinearHistogram<5> h(1000000);
+  EXPECT_EQ(510, h.getNumBuckets());
+  EXPECT_GE(h.getBucketMax(h.getNumBuckets() - 1), 1000000);
+
+  h.addValue(1000000);
+  h.addValue(uint64_t(1) << 40);
+  EXPECT_EQ(2, h.getBucketCount(h.getNumBuckets() - 1));
+  EXPECT_EQ(2, h.count());
+}
+
+TEST(LogLinearHistogram, Percentiles) {
+  LogLinearHistogram<> h;
+  for (uint64_t v = 1; v <= 100000; ++v) {
+    h.addValue(v);
+  }
+  EXPECT_EQ(100000, h.count());
+  EXPECT_EQ(uint64_t(100000) * 100001 / 2, h.sum());
+
+  for (double pct : {0.01, 0.1, 0.5, 0.9, 0.99, 0.999}) {
+    double expected = pct * 100000;
+    EXPECT_NEAR(expected, h.getPercentileEstimate(pct), expected / 32)
+        << pct;
+  }
+  EXPECT_EQ(h.getBucketMax(h.getBucketIdx(100000)), h.getPercentileEstimate(1));
+
+  LogLinearHistogram<> empty;
+  EXPECT_EQ(0, empty.getPercentileEstimate(0.5));
+}
+
+TEST(LogLinearHistogram, MergeAndClear) {
+  LogLinearHistogram<> a(1 << 20);
+  LogLinearHistogram<> b(1 << 20);
+  a.addRepeatedValue(10, 3);
+  b.addRepeatedValue(1000, 2);
+  a.merge(b);
+  EXPECT_EQ(5, a.count());
+  EXPECT_EQ(2030, a.sum());
+  EXPECT_EQ(3, a.getBucketCount(a.getBucketIdx(10)));
+  EXPECT_EQ(2, a.getBucketCount(a.getBucketIdx(1000)));
+
+  LogLinearHistogram<> c(1 << 10);
+  EXPECT_THROW(a.merge(c), std::invalid_argument);
+
+  a.clear();
+  EXPECT_EQ(0, a.count());
+  EXPECT_EQ(0, a.sum());
+  EXPECT_EQ(0, a.getBucketCount(a.getBucketIdx(10)));
+}
+
+TEST(LogLinearHistogram, Atomic) {
+  constexpr size_t kThreads = 8;
+  constexpr uint64_t kValues = 10000;
+  AtomicLogLinearHistogram<> h(1 << 20);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      for (uint64_t v = 1; v <= kValues; ++v) {
+        h.addValue(v);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto snapshot = h.snapshot();
+  EXPECT_EQ(h.getNumBuckets(), snapshot.getNumBuckets());
+  EXPECT_EQ(kThreads * kValues, snapshot.count());
+  EXPECT_EQ(kThreads * kValues * (kValues + 1) / 2, snapshot.sum());
+  EXPECT_EQ(kThreads, snapshot.getBucketCount(snapshot.getBucketIdx(1)));
+
+  auto exchanged = h.exchange();
+  EXPECT_EQ(kThreads * kValues, exchanged.count());
+  EXPECT_EQ(0, h.snapshot().count());
+  EXPECT_EQ(0, h.snapshot().sum());
+}
+
+TEST(LogLinearHistogram, AddToTimeseriesHistogram) {
+  using StatsClock = folly::LegacyStatsClock<std::chrono::seconds>;
+  LogLinearHistogram<> h;
+  for (uint64_t v = 0; v < 1000; ++v) {
+    h.addValue(v);
+  }
+
+  folly::TimeseriesHistogram<int64_t> tsh(
+      100,
+      0,
+      1000,
+      folly::MultiLevelTimeSeries<int64_t>(
+          60, {std::chrono::seconds(60), std::chrono::seconds(0)}));
+  auto now = StatsClock::time_point(std::chrono::seconds(1));
+  h.addTo(tsh, now);
+  tsh.update(now);
+
+  EXPECT_EQ(1000, tsh.count(0));
+  for (size_t b = 1; b <= 10; ++b) {
+    EXPECT_NEAR(100, tsh.getBucket(b).count(0), 10) << b;
+  }
+  EXPECT_NEAR(500, tsh.getPercentileEstimate(50, 0), 20);
+}
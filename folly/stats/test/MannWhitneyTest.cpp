@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/stats/detail/MannWhitney.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly::detail;
+
+TEST(MedianTest, Basic) {
+  EXPECT_EQ(5, median({5}));
+  EXPECT_EQ(2, median({3, 1, 2}));
+  EXPECT_EQ(2.5, median({4, 1, 3, 2}));
+  EXPECT_EQ(1, median({1, 1, 7, 1}));
+}
+
+TEST(MannWhitneyTest, Separated) {
+  // one of the C(4, 2) = 6 arrangements
+  EXPECT_DOUBLE_EQ(1.0 / 6, mannWhitneyGreater({3, 4}, {1, 2}));
+  EXPECT_DOUBLE_EQ(1, mannWhitneyGreater({1, 2}, {3, 4}));
+  // one of C(6, 3) = 20
+  EXPECT_DOUBLE_EQ(1.0 / 20, mannWhitneyGreater({4, 5, 6}, {1, 2, 3}));
+}
+
+TEST(MannWhitneyTest, NoTies) {
+  // U for sizes 2 and 2 is 0 to 4 with weights 1, 1, 2, 1, 1
+  EXPECT_DOUBLE_EQ(5.0 / 6, mannWhitneyGreater({1, 3}, {2, 4}));
+  EXPECT_DOUBLE_EQ(4.0 / 6, mannWhitneyGreater({2, 3}, {1, 4}));
+}
+
+TEST(MannWhitneyTest, Ties) {
+  // U = 2.  With the groups {1, 1} and {2, 2}, 2U is 0, 4 or 8 with weights
+  // 1, 4 and 1, so the p-value is 5/6; rounding U up to 3 in the untied
+  // distribution would give 2/6.
+  EXPECT_DOUBLE_EQ(5.0 / 6, mannWhitneyGreater({1, 2}, {1, 2}));
+  EXPECT_DOUBLE_EQ(1, mannWhitneyGreater({1, 1}, {1, 1}));
+  // U = 3.5.  With the groups {1}, {2, 2} and {3}, 2U is 1, 4 or 7 with
+  // weights 2, 2 and 2.
+  EXPECT_DOUBLE_EQ(1.0 / 3, mannWhitneyGreater({2, 3}, {1, 2}));
+  EXPECT_DOUBLE_EQ(1, mannWhitneyGreater({1, 2}, {2, 3}));
+}
@@ -88,3 +88,44 @@ TEST(SlidingWindowQuantileEstimatorTest, EstimateQuantiles) {
   EXPECT_EQ(100.0 - 0.5, estimates.quantiles[3].second);
   EXPECT_EQ(100, estimates.quantiles[4].second);
 }
+
+TEST(SimpleQuantileEstimatorTest, FlushInterval) {
+  MockClock::Now = MockClock::time_point{};
+  SimpleQuantileEstimator<MockClock> estimator(
+      std::chrono::milliseconds{100}, 10, 50);
+  for (size_t i = 1; i <= 100; ++i) {
+    estimator.addValue(i);
+  }
+
+  // values are buffered until the end of the interval
+  auto quantiles = std::array<double, 1>{{.5}};
+  EXPECT_EQ(0, estimator.estimateQuantiles(quantiles).count);
+
+  MockClock::Now += std::chrono::milliseconds{100};
+  auto estimates = estimator.estimateQuantiles(quantiles);
+  EXPECT_EQ(5050, estimates.sum);
+  EXPECT_EQ(100, estimates.count);
+}
+
+TEST(SlidingWindowQuantileEstimatorTest, BufferAndDigestSize) {
+  MockClock::Now = MockClock::time_point{};
+  SlidingWindowQuantileEstimator<MockClock> estimator(
+      std::chrono::seconds{1}, 2, 10, 50);
+  for (size_t i = 1; i <= 100; ++i) {
+    estimator.addValue(i);
+  }
+  MockClock::Now += std::chrono::seconds{1};
+  for (size_t i = 1; i <= 100; ++i) {
+    estimator.addValue(i);
+  }
+  MockClock::Now += std::chrono::seconds{1};
+
+  auto estimates = estimator.estimateQuantiles(std::array<double, 1>{{.5}});
+  EXPECT_EQ(2 * 5050, estimates.sum);
+  EXPECT_EQ(200, estimates.count);
+
+  // the first window slides out
+  MockClock::Now += std::chrono::seconds{1};
+  estimates = estimator.estimateQuantiles(std::array<double, 1>{{.5}});
+  EXPECT_EQ(100, estimates.count);
+}
@@ -115,6 +115,8 @@ BENCHMARK_NAMED_PARAM(mergeDigests, 100x10, 100, 10)
 BENCHMARK_RELATIVE_NAMED_PARAM(mergeDigests, 100x30, 100, 30)
 BENCHMARK_RELATIVE_NAMED_PARAM(mergeDigests, 100x60, 100, 60)
 BENCHMARK_RELATIVE_NAMED_PARAM(mergeDigests, 1000x60, 1000, 60)
+BENCHMARK_RELATIVE_NAMED_PARAM(mergeDigests, 100x1000, 100, 1000)
+BENCHMARK_RELATIVE_NAMED_PARAM(mergeDigests, 100x10000, 100, 10000)
 BENCHMARK_DRAW_LINE();
 BENCHMARK_NAMED_PARAM(estimateQuantile, 100x1_p001, 100, 0.001)
 BENCHMARK_RELATIVE_NAMED_PARAM(estimateQuantile, 100_p01, 100, 0.01)
@@ -19,7 +19,9 @@
 #include <chrono>
 #include <random>
 
+#include <folly/lang/Bits.h>
 #include <folly/portability/GTest.h>
+#include <folly/stats/detail/BinaryEncoding.h>
 
 using namespace folly;
 
@@ -156,6 +158,39 @@ TEST(TDigest, MergeLargeAsDigests) {
   EXPECT_EQ(999.5, digest.estimateQuantile(0.999));
 }
 
+TEST(TDigest, MergeManyDigests) {
+  std::vector<TDigest> digests;
+  TDigest digest(100);
+
+  std::vector<double> values;
+  for (int i = 1; i <= 100000; ++i) {
+    values.push_back(i);
+  }
+  std::shuffle(
+      values.begin(), values.end(), std::mt19937(std::random_device()()));
+  for (int i = 0; i < 10000; ++i) {
+    std::vector<double> unsorted_values(
+        values.begin() + (i * 10), values.begin() + (i + 1) * 10);
+    digests.push_back(digest.merge(unsorted_values));
+    if (i % 1000 == 0) {
+      digests.emplace_back(100);
+    }
+  }
+
+  digest = TDigest::merge(digests);
+
+  EXPECT_EQ(100000, digest.count());
+  EXPECT_EQ(5000050000, digest.sum());
+  EXPECT_EQ(1, digest.min());
+  EXPECT_EQ(100000, digest.max());
+  EXPECT_TRUE(std::is_sorted(
+      digest.getCentroids().begin(), digest.getCentroids().end()));
+
+  EXPECT_NEAR(100, digest.estimateQuantile(0.001), 25);
+  EXPECT_NEAR(50000, digest.estimateQuantile(0.5), 1000);
+  EXPECT_NEAR(99900, digest.estimateQuantile(0.999), 25);
+}
+
 TEST(TDigest, NegativeValues) {
   std::vector<TDigest> digests;
   TDigest digest(100);
@@ -305,6 +340,89 @@ TEST(TDigest, FloatingPointSortedTest) {
   EXPECT_EQ(std::is_sorted(centroids.begin(), centroids.end()), true);
 }
 
+void expectSameDigest(const TDigest& expected, const TDigest& actual) {
+  EXPECT_EQ(expected.maxSize(), actual.maxSize());
+  EXPECT_EQ(expected.sum(), actual.sum());
+  EXPECT_EQ(expected.count(), actual.count());
+  ASSERT_EQ(expected.getCentroids().size(), actual.getCentroids().size());
+  for (size_t i = 0; i < expected.getCentroids().size(); ++i) {
+    EXPECT_EQ(
+        expected.getCentroids()[i].mean(), actual.getCentroids()[i].mean());
+    EXPECT_EQ(
+        expected.getCentroids()[i].weight(),
+        actual.getCentroids()[i].weight());
+  }
+}
+
+TEST(TDigest, Serialize) {
+  std::vector<double> values;
+  for (int i = 1; i <= 10000; ++i) {
+    values.push_back(std::sqrt(i) - 30);
+  }
+  auto digest = TDigest(100).merge(values);
+
+  auto data = digest.serialize();
+  // smaller than the raw (mean, weight) pairs
+  EXPECT_LT(data.size(), digest.getCentroids().size() * 2 * sizeof(double));
+  ByteRange range(StringPiece{data});
+  auto decoded = TDigest::deserialize(range);
+  EXPECT_TRUE(range.empty());
+  expectSameDigest(digest, decoded);
+  EXPECT_EQ(digest.min(), decoded.min());
+  EXPECT_EQ(digest.max(), decoded.max());
+  EXPECT_EQ(digest.estimateQuantile(0.99), decoded.estimateQuantile(0.99));
+
+  // digests can be concatenated, including empty ones and ones with
+  // fractional weights
+  TDigest empty(50);
+  TDigest fractional(
+      {TDigest::Centroid(1, 0.5), TDigest::Centroid(2, 1.5)}, 3.5, 2, 2, 1);
+  std::string stream;
+  empty.serialize(stream);
+  digest.serialize(stream);
+  fractional.serialize(stream);
+  range = ByteRange(StringPiece{stream});
+  auto first = TDigest::deserialize(range);
+  EXPECT_TRUE(first.empty());
+  EXPECT_EQ(50, first.maxSize());
+  EXPECT_TRUE(std::isnan(first.min()));
+  expectSameDigest(digest, TDigest::deserialize(range));
+  expectSameDigest(fractional, TDigest::deserialize(range));
+  EXPECT_TRUE(range.empty());
+}
+
+TEST(TDigest, DeserializeInvalid) {
+  auto data = TDigest(100).merge(std::vector<double>{1, 2, 3}).serialize();
+  for (size_t size = 0; size < data.size(); ++size) {
+    ByteRange range(StringPiece(data.data(), size));
+    EXPECT_THROW(TDigest::deserialize(range), std::invalid_argument);
+  }
+
+  // maxSize of 0, after the flags
+  auto zeroSize = data;
+  zeroSize[1] = 0;
+  ByteRange range(StringPiece{zeroSize});
+  EXPECT_THROW(TDigest::deserialize(range), std::invalid_argument);
+
+  // unsorted means
+  std::string unsorted;
+  detail::appendVarint(unsorted, 1); // integral weights
+  detail::appendVarint(unsorted, 100);
+  for (double value : {3.0, 2.0, 2.0, 1.0}) {
+    detail::appendFloat(unsorted, value);
+  }
+  detail::appendVarint(unsorted, 2);
+  // means of 2 and 1, as deltas of their bits, which sort like the values
+  uint64_t two = bit_cast<uint64_t>(2.0) | (uint64_t(1) << 63);
+  uint64_t one = bit_cast<uint64_t>(1.0) | (uint64_t(1) << 63);
+  detail::appendVarint(unsorted, two);
+  detail::appendVarint(unsorted, one - two);
+  detail::appendVarint(unsorted, 1);
+  detail::appendVarint(unsorted, 1);
+  range = StringPiece{unsorted};
+  EXPECT_THROW(TDigest::deserialize(range), std::invalid_argument);
+}
+
 class DistributionTest
     : public ::testing::TestWithParam<
           std::tuple<std::pair<bool, size_t>, double, bool>> {};
@@ -1291,3 +1291,46 @@ TEST(MultiLevelTimeSeries, QueryByInterval) {
     EXPECT_EQ(expectedRate, r);
   }
 }
+
+TEST(MultiLevelTimeSeries, CachedWithinBuckets) {
+  // Data points at times that all differ but mostly share buckets must give
+  // the same levels as adding each of them to the levels directly.
+  using MsClock = folly::LegacyStatsClock<std::chrono::milliseconds>;
+  using std::chrono::milliseconds;
+  folly::MultiLevelTimeSeries<int64_t, MsClock> mhts(
+      60, {seconds(1), seconds(7), seconds(60), seconds(0)});
+  std::vector<BucketedTimeSeries<int64_t, MsClock>> expected;
+  for (auto duration : {seconds(1), seconds(7), seconds(60), seconds(0)}) {
+    expected.emplace_back(60, duration);
+  }
+
+  auto check = [&] {
+    for (size_t i = 0; i < expected.size(); ++i) {
+      const auto& level = mhts.getLevel(i);
+      EXPECT_EQ(expected[i].sum(), level.sum()) << i;
+      EXPECT_EQ(expected[i].count(), level.count()) << i;
+      EXPECT_EQ(expected[i].getEarliestTime(), level.getEarliestTime()) << i;
+      EXPECT_EQ(expected[i].getLatestTime(), level.getLatestTime()) << i;
+    }
+  };
+
+  MsClock::time_point now(milliseconds(12345));
+  for (int64_t i = 0; i < 100000; ++i) {
+    // mostly forwards by less than a millisecond bucket, sometimes by more
+    // or backwards
+    now += milliseconds(i % 97 == 0 ? 1500 : i % 13 == 0 ? -2 : i % 3);
+    mhts.addValue(now, i);
+    for (auto& level : expected) {
+      level.addValue(now, i);
+    }
+    if ((i + 1) % 10000 == 0) {
+      mhts.flush();
+      check();
+    }
+  }
+  mhts.update(now + seconds(5));
+  for (auto& level : expected) {
+    level.update(now + seconds(5));
+  }
+  check();
+}
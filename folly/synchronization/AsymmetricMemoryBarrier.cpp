@@ -83,8 +83,12 @@ void mprotectMembarrier() {
 void asymmetricHeavyBarrier(AMBFlags flags) {
   if (kIsLinux) {
     static const bool useSysMembarrier = detail::sysMembarrierAvailable();
-    // sys_membarrier currently does not support EXPEDITED
-    if (useSysMembarrier && flags != AMBFlags::EXPEDITED) {
+    static const bool useSysMembarrierExpedited =
+        detail::sysMembarrierPrivateExpeditedAvailable();
+    if (flags == AMBFlags::EXPEDITED && useSysMembarrierExpedited) {
+      auto r = detail::sysMembarrierPrivateExpedited();
+      checkUnixError(r, "membarrier");
+    } else if (useSysMembarrier && flags != AMBFlags::EXPEDITED) {
       auto r = detail::sysMembarrier();
       checkUnixError(r, "membarrier");
     } else {
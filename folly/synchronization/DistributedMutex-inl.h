@@ -29,6 +29,7 @@
 #include <folly/portability/Asm.h>
 #include <folly/synchronization/AtomicNotification.h>
 #include <folly/synchronization/AtomicUtil.h>
+#include <folly/synchronization/LockProfiler.h>
 #include <folly/synchronization/detail/InlineFunctionRef.h>
 #include <folly/synchronization/detail/Sleeper.h>
 
@@ -1195,6 +1196,7 @@ lockImplementation(
   auto nextWaitMode = kAboutToWait;
   auto timedWaiter = false;
   Waiter<Atomic>* nextSleeper = nullptr;
+  detail::LockProfilerWait profilerWait;
   while (true) {
     // construct the state needed to wait
     //
@@ -1234,6 +1236,7 @@ lockImplementation(
               /* ready */ nextSleeper};
     }
     DCHECK(previous & kLocked);
+    profilerWait.start(&mutex);
 
     // wait until we get a signal from another thread, if this returns false,
     // we got skipped and had probably been scheduled out, so try again
@@ -1276,6 +1279,7 @@ lockImplementation(
     if (combined || exceptionOccurred) {
       detach(request, state, exceptionOccurred, storage);
     }
+    profilerWait.setCombined(combined || exceptionOccurred);
 
     // if we are just coming out of a futex call, then it means that the next
     // waiter we are responsible for is also a waiter waiting on a futex, so
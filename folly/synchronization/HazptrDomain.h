@@ -21,6 +21,7 @@
 #include <folly/synchronization/HazptrRec.h>
 #include <folly/synchronization/HazptrThrLocal.h>
 
+#include <folly/Executor.h>
 #include <folly/Portability.h>
 #include <folly/synchronization/AsymmetricMemoryBarrier.h>
 
@@ -100,6 +101,19 @@ constexpr int hazptr_domain_rcount_threshold() {
  *    unprotected_ and children_, to keep track of these objects
  *    between reclamation steps and to provide inner Type B operations
  *    access to these objects.
+ *
+ *  Notes on asynchronous reclamation:
+ *  - By default, the Type A operation triggered by a retire runs on
+ *    the retiring thread, which adds its whole cost to that one
+ *    call. With set_executor(ex), such operations are added to ex
+ *    instead, and the retiring thread returns right away.
+ *  - Reclamation requested explicitly, by cleanup() and
+ *    cleanup_batch_tag(), still runs on the calling thread.
+ *  - Thresholds are reset when a reclamation is scheduled, so at most
+ *    about one reclamation per threshold crossing is pending.
+ *  - The executor must run the added functions until clear_executor()
+ *    returns, which waits for the pending ones; the destructor waits
+ *    for them too.
  */
 template <template <typename> class Atom>
 class hazptr_domain {
@@ -122,6 +136,8 @@ class hazptr_domain {
   Atom<int> hcount_{0};
   Atom<int> rcount_{0};
   Atom<uint16_t> num_bulk_reclaims_{0};
+  Atom<Executor*> executor_{nullptr};
+  Atom<int> num_async_reclaims_{0};
   bool shutdown_{false};
 
   RetiredList untagged_;
@@ -138,6 +154,7 @@ class hazptr_domain {
   /** Destructor */
   ~hazptr_domain() {
     shutdown_ = true;
+    wait_for_zero_async_reclaims();
     reclaim_all_objects();
     free_hazptr_recs();
     DCHECK(tagged_.empty());
@@ -165,6 +182,17 @@ class hazptr_domain {
     push_retired(l);
   }
 
+  /** set_executor: Runs threshold-triggered reclamation on ex */
+  void set_executor(Executor* ex) noexcept {
+    executor_.store(ex, std::memory_order_release);
+  }
+
+  /** clear_executor: Waits for the reclamation pending on the executor */
+  void clear_executor() noexcept {
+    executor_.store(nullptr, std::memory_order_release);
+    wait_for_zero_async_reclaims();
+  }
+
   /** cleanup */
   void cleanup() noexcept {
     relaxed_cleanup();
@@ -287,7 +315,40 @@ class hazptr_domain {
     if (!(lock && rlist.check_lock()) &&
         (rlist.check_threshold_try_zero_count(threshold()) ||
          check_sync_time(sync_time))) {
-      do_reclamation(rlist, lock);
+      if (!try_reclaim_async([this, &rlist, lock] {
+            do_reclamation(rlist, lock);
+          })) {
+        do_reclamation(rlist, lock);
+      }
+    }
+  }
+
+  /** try_reclaim_async: Adds f to the executor, if any */
+  template <typename Func>
+  bool try_reclaim_async(Func f) noexcept {
+    auto ex = executor_.load(std::memory_order_acquire);
+    if (ex == nullptr || shutdown_) {
+      return false;
+    }
+    num_async_reclaims_.fetch_add(1, std::memory_order_acq_rel);
+    try {
+      ex->add([this, f = std::move(f)]() mutable {
+        // Counted as a bulk reclaim so that cleanup() waits for it.
+        num_bulk_reclaims_.fetch_add(1, std::memory_order_acquire);
+        f();
+        num_bulk_reclaims_.fetch_sub(1, std::memory_order_release);
+        num_async_reclaims_.fetch_sub(1, std::memory_order_release);
+      });
+    } catch (...) {
+      num_async_reclaims_.fetch_sub(1, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  void wait_for_zero_async_reclaims() {
+    while (num_async_reclaims_.load(std::memory_order_acquire) > 0) {
+      std::this_thread::yield();
     }
   }
 
@@ -485,7 +546,9 @@ class hazptr_domain {
          try_bulk_reclaim will proceed to bulk_reclaim. */
       return;
     }
-    bulk_reclaim();
+    if (!try_reclaim_async([this] { bulk_reclaim(); })) {
+      bulk_reclaim();
+    }
   }
 
   void bulk_reclaim(bool transitive = false) {
@@ -552,7 +615,10 @@ class hazptr_domain {
     if (!check_sync_time(sync_time_)) {
       return false;
     }
-    relaxed_cleanup(); // calling regular cleanup may self deadlock
+    // calling regular cleanup may self deadlock
+    if (!try_reclaim_async([this] { relaxed_cleanup(); })) {
+      relaxed_cleanup();
+    }
     return true;
   }
 
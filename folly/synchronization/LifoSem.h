@@ -33,6 +33,7 @@
 #include <folly/lang/SafeAssert.h>
 #include <folly/synchronization/AtomicStruct.h>
 #include <folly/synchronization/SaturatingSemaphore.h>
+#include <folly/synchronization/WaitOptions.h>
 
 namespace folly {
 
@@ -174,9 +175,9 @@ struct LifoSemRawNode {
 
 /// Handoff is a type not bigger than a void* that knows how to perform a
 /// single post() -> wait() communication.  It must have a post() method.
-/// If it has a wait() method then LifoSemBase's wait() implementation
-/// will work out of the box, otherwise you will need to specialize
-/// LifoSemBase::wait accordingly.
+/// If it has wait() and try_wait_until(deadline, WaitOptions) methods then
+/// LifoSemBase's wait() implementation will work out of the box, otherwise
+/// you will need to specialize LifoSemBase::wait accordingly.
 template <typename Handoff, template <typename> class Atom>
 struct LifoSemNode : public LifoSemRawNode<Atom> {
   static_assert(
@@ -372,6 +373,12 @@ struct LifoSemBase {
   LifoSemBase(LifoSemBase const&) = delete;
   LifoSemBase& operator=(LifoSemBase const&) = delete;
 
+  /// The spin part of the wait options is passed to the Handoff, which
+  /// spins before blocking
+  FOLLY_ALWAYS_INLINE static constexpr WaitOptions wait_options() {
+    return {};
+  }
+
   /// Silently saturates if value is already 2^32-1
   bool post() {
     auto idx = incrOrPop(1);
@@ -483,9 +490,9 @@ struct LifoSemBase {
   /// has been shut down and this method would otherwise be blocking.
   /// Note that wait() doesn't throw during shutdown if tryWait() would
   /// return true
-  void wait() {
+  void wait(const WaitOptions& opt = wait_options()) {
     auto const deadline = std::chrono::steady_clock::time_point::max();
-    auto res = try_wait_until(deadline);
+    auto res = try_wait_until(deadline, opt);
     FOLLY_SAFE_DCHECK(res, "infinity time has passed");
   }
 
@@ -494,13 +501,16 @@ struct LifoSemBase {
   }
 
   template <typename Rep, typename Period>
-  bool try_wait_for(const std::chrono::duration<Rep, Period>& timeout) {
-    return try_wait_until(timeout + std::chrono::steady_clock::now());
+  bool try_wait_for(
+      const std::chrono::duration<Rep, Period>& timeout,
+      const WaitOptions& opt = wait_options()) {
+    return try_wait_until(timeout + std::chrono::steady_clock::now(), opt);
   }
 
   template <typename Clock, typename Duration>
   bool try_wait_until(
-      const std::chrono::time_point<Clock, Duration>& deadline) {
+      const std::chrono::time_point<Clock, Duration>& deadline,
+      const WaitOptions& opt = wait_options()) {
     // early check isn't required for correctness, but is an important
     // perf win if we can avoid allocating and deallocating a node
     if (tryWait()) {
@@ -518,7 +528,7 @@ struct LifoSemBase {
     }
 
     if (rv == WaitResult::PUSH) {
-      if (!node->handoff().try_wait_until(deadline)) {
+      if (!node->handoff().try_wait_until(deadline, opt)) {
         if (tryRemoveNode(*node)) {
           return false;
         } else {
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/synchronization/LockProfiler.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include <folly/Format.h>
+#include <folly/Indestructible.h>
+#include <folly/container/F14Map.h>
+#include <folly/lang/Bits.h>
+
+namespace folly {
+
+constexpr std::size_t LockProfiler::kNumBuckets;
+constexpr std::size_t LockProfiler::kNumShards;
+constexpr std::size_t LockProfiler::kMaxLocks;
+
+namespace detail {
+std::atomic<bool> lockProfilerEnabled{false};
+} // namespace detail
+
+namespace {
+
+struct Shard {
+  std::mutex mutex;
+  F14FastMap<const void*, LockProfiler::Stats> locks;
+};
+
+struct Profile {
+  std::array<Shard, LockProfiler::kNumShards> shards;
+  std::atomic<std::size_t> numLocks{0};
+  std::atomic<std::uint64_t> droppedWaits{0};
+
+  Shard& shardFor(const void* lock) {
+    auto bits = reinterpret_cast<std::uintptr_t>(lock);
+    // locks are usually at least 8 byte aligned, and often adjacent
+    return shards[(bits >> 3) % LockProfiler::kNumShards];
+  }
+
+  // Returns nullptr once kMaxLocks locks are tracked.
+  LockProfiler::Stats* find(Shard& shard, const void* lock) {
+    auto it = shard.locks.find(lock);
+    if (it != shard.locks.end()) {
+      return &it->second;
+    }
+    if (numLocks.fetch_add(1, std::memory_order_relaxed) >=
+        LockProfiler::kMaxLocks) {
+      numLocks.fetch_sub(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    auto& stats = shard.locks[lock];
+    stats.lock = lock;
+    return &stats;
+  }
+};
+
+Profile& profile() {
+  static Indestructible<Profile> profile;
+  return *profile;
+}
+
+std::size_t bucketFor(std::chrono::nanoseconds wait) {
+  auto nanos = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      wait.count(), 1));
+  return std::min<std::size_t>(
+      findLastSet(nanos) - 1, LockProfiler::kNumBuckets - 1);
+}
+
+} // namespace
+
+std::chrono::nanoseconds LockProfiler::Stats::waitQuantile(double q) const {
+  auto target = static_cast<std::uint64_t>(q * waits);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kNumBuckets; ++i) {
+    seen += waitHistogram[i];
+    if (seen > target || i == kNumBuckets - 1) {
+      if (i == kNumBuckets - 1) {
+        return maxWait;
+      }
+      return std::chrono::nanoseconds(std::uint64_t(2) << i);
+    }
+  }
+  return maxWait;
+}
+
+void LockProfiler::setEnabled(bool enabled) {
+  detail::lockProfilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void LockProfiler::setName(const void* lock, std::string name) {
+  auto& p = profile();
+  auto& shard = p.shardFor(lock);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  if (auto stats = p.find(shard, lock)) {
+    stats->name = std::move(name);
+  }
+}
+
+void LockProfiler::recordWait(
+    const void* lock,
+    std::chrono::nanoseconds wait,
+    bool combined) noexcept {
+  auto& p = profile();
+  auto& shard = p.shardFor(lock);
+  // Both locking the shard and adding the lock to it may throw.
+  std::unique_lock<std::mutex> guard(shard.mutex, std::defer_lock);
+  LockProfiler::Stats* stats = nullptr;
+  try {
+    guard.lock();
+    stats = p.find(shard, lock);
+  } catch (...) {
+  }
+  if (stats == nullptr) {
+    p.droppedWaits.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ++stats->waits;
+  stats->combined += combined;
+  stats->totalWait += wait;
+  stats->maxWait = std::max(stats->maxWait, wait);
+  ++stats->waitHistogram[bucketFor(wait)];
+}
+
+std::vector<LockProfiler::Stats> LockProfiler::topContended(std::size_t n) {
+  std::vector<Stats> all;
+  for (auto& shard : profile().shards) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    for (auto& entry : shard.locks) {
+      if (entry.second.waits > 0) {
+        all.push_back(entry.second);
+      }
+    }
+  }
+  auto byTotalWait = [](const Stats& a, const Stats& b) {
+    return a.totalWait > b.totalWait;
+  };
+  n = std::min(n, all.size());
+  std::partial_sort(all.begin(), all.begin() + n, all.end(), byTotalWait);
+  all.resize(n);
+  return all;
+}
+
+std::string LockProfiler::report(std::size_t n) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::string out = sformat(
+      "{:<24} {:>10} {:>10} {:>12} {:>10} {:>10} {:>10}\n",
+      "lock",
+      "waits",
+      "combined",
+      "total(us)",
+      "p50(us)",
+      "p99(us)",
+      "max(us)");
+  for (auto& stats : topContended(n)) {
+    auto name =
+        stats.name.empty() ? sformat("{}", stats.lock) : stats.name;
+    out += sformat(
+        "{:<24} {:>10} {:>10} {:>12} {:>10} {:>10} {:>10}\n",
+        name,
+        stats.waits,
+        stats.combined,
+        duration_cast<microseconds>(stats.totalWait).count(),
+        duration_cast<microseconds>(stats.waitQuantile(0.5)).count(),
+        duration_cast<microseconds>(stats.waitQuantile(0.99)).count(),
+        duration_cast<microseconds>(stats.maxWait).count());
+  }
+  return out;
+}
+
+std::uint64_t LockProfiler::droppedWaits() {
+  return profile().droppedWaits.load(std::memory_order_relaxed);
+}
+
+void LockProfiler::reset() {
+  auto& p = profile();
+  for (auto& shard : p.shards) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    p.numLocks.fetch_sub(shard.locks.size(), std::memory_order_relaxed);
+    shard.locks.clear();
+  }
+  p.droppedWaits.store(0, std::memory_order_relaxed);
+}
+
+} // namespace folly
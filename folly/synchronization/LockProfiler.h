@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/Likely.h>
+
+namespace folly {
+
+namespace detail {
+extern std::atomic<bool> lockProfilerEnabled;
+} // namespace detail
+
+/**
+ * Process-wide profile of the contention on folly's mutexes.
+ * DistributedMutex, SharedMutex and MicroLock report every wait for a lock
+ * to it, keyed by the address of the lock, while it is enabled.
+ *
+ * Profiling is off by default and can be turned on and off at any time.
+ * While it is off the uncontended paths of the mutexes are unchanged and
+ * the contended ones only do an extra relaxed load; while it is on, every
+ * wait also costs two clock reads and a short critical section on one of
+ * kNumShards internal mutexes.
+ *
+ * Locks are identified by their address and by the name given to
+ * setName(), if any.  A lock destroyed and then reused at the same address
+ * is merged with its predecessor.  At most kMaxLocks locks are tracked,
+ * waits on other locks are only counted by droppedWaits().
+ *
+ *  LockProfiler::setName(&configMutex, "config");
+ *  LockProfiler::setEnabled(true);
+ *  ...
+ *  LOG(INFO) << LockProfiler::report(10);
+ */
+class LockProfiler {
+ public:
+  // Bucket i of the wait histograms counts waits of [2^i, 2^(i+1))
+  // nanoseconds, the last bucket counts all longer waits.
+  static constexpr std::size_t kNumBuckets = 32;
+  static constexpr std::size_t kNumShards = 64;
+  static constexpr std::size_t kMaxLocks = 4096;
+
+  struct Stats {
+    const void* lock{nullptr};
+    std::string name;
+    // number of times a thread had to wait for the lock
+    std::uint64_t waits{0};
+    // waits after which the lock holder had run the critical section on
+    // behalf of the waiter; DistributedMutex::lock_combine() only
+    std::uint64_t combined{0};
+    std::chrono::nanoseconds totalWait{0};
+    std::chrono::nanoseconds maxWait{0};
+    std::array<std::uint64_t, kNumBuckets> waitHistogram{};
+
+    // Upper bound of the bucket holding the q-th quantile of the waits.
+    std::chrono::nanoseconds waitQuantile(double q) const;
+  };
+
+  static bool enabled() {
+    return detail::lockProfilerEnabled.load(std::memory_order_relaxed);
+  }
+  static void setEnabled(bool enabled);
+
+  static void setName(const void* lock, std::string name);
+
+  static void recordWait(
+      const void* lock,
+      std::chrono::nanoseconds wait,
+      bool combined = false) noexcept;
+
+  // The n locks with the largest total wait time, largest first.
+  static std::vector<Stats> topContended(std::size_t n);
+
+  // topContended(n) as a table, one lock per line.
+  static std::string report(std::size_t n);
+
+  static std::uint64_t droppedWaits();
+
+  // Forget all the locks, names included.
+  static void reset();
+};
+
+namespace detail {
+
+// Measures the wait for a lock, from start() to destruction, when the
+// profiler is enabled at start().
+class LockProfilerWait {
+ public:
+  LockProfilerWait() = default;
+  LockProfilerWait(const LockProfilerWait&) = delete;
+  LockProfilerWait& operator=(const LockProfilerWait&) = delete;
+
+  ~LockProfilerWait() {
+    if (UNLIKELY(lock_ != nullptr)) {
+      LockProfiler::recordWait(
+          lock_, std::chrono::steady_clock::now() - start_, combined_);
+    }
+  }
+
+  void start(const void* lock) noexcept {
+    if (UNLIKELY(LockProfiler::enabled()) && lock_ == nullptr) {
+      lock_ = lock;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  void setCombined(bool combined) noexcept {
+    combined_ = combined;
+  }
+
+ private:
+  const void* lock_{nullptr};
+  bool combined_{false};
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace detail
+} // namespace folly
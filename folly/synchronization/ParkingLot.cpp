@@ -16,22 +16,64 @@
 
 #include <folly/synchronization/ParkingLot.h>
 
+#include <algorithm>
 #include <array>
 
+#include <folly/lang/Bits.h>
+#include <folly/system/HardwareConcurrency.h>
+
 namespace folly {
 namespace parking_lot_detail {
 
-Bucket& Bucket::bucketFor(uint64_t key) {
-  constexpr size_t const kNumBuckets = kIsMobile ? 256 : 4096;
+namespace {
+
+constexpr size_t kMinBuckets = kIsMobile ? 256 : 4096;
+constexpr size_t kMaxBuckets = size_t(1) << 20;
+constexpr size_t kBucketsPerCpu = 64;
+
+std::atomic<size_t> requestedBuckets{0};
+std::atomic<bool> bucketsCreated{false};
 
-  // Statically allocating this lets us use this in allocation-sensitive
-  // contexts. This relies on the assumption that std::mutex won't dynamically
-  // allocate memory, which we assume to be the case on Linux and iOS.
-  static Indestructible<std::array<Bucket, kNumBuckets>> gBuckets;
-  return (*gBuckets)[key % kNumBuckets];
+struct Buckets {
+  Bucket* buckets;
+  size_t mask;
+};
+
+Buckets createBuckets() {
+  // Statically allocating the default buckets lets us use this in
+  // allocation-sensitive contexts. This relies on the assumption that
+  // std::mutex won't dynamically allocate memory, which we assume to be
+  // the case on Linux and iOS.
+  static Indestructible<std::array<Bucket, kMinBuckets>> gBuckets;
+
+  size_t count = requestedBuckets.load(std::memory_order_acquire);
+  if (count == 0) {
+    count = std::max(kMinBuckets, hardware_concurrency() * kBucketsPerCpu);
+  }
+  count = nextPowTwo(std::min(std::max<size_t>(count, 1), kMaxBuckets));
+  bucketsCreated.store(true, std::memory_order_release);
+  if (count == kMinBuckets) {
+    return {gBuckets->data(), count - 1};
+  }
+  // leaked, as waiters may outlive static destruction
+  return {new Bucket[count], count - 1};
+}
+
+} // namespace
+
+Bucket& Bucket::bucketFor(uint64_t key) {
+  static const Buckets buckets = createBuckets();
+  return buckets.buckets[key & buckets.mask];
 }
 
 std::atomic<uint64_t> idallocator{0};
 
 } // namespace parking_lot_detail
+
+bool setParkingLotBucketCount(size_t count) {
+  parking_lot_detail::requestedBuckets.store(
+      count, std::memory_order_release);
+  return !parking_lot_detail::bucketsCreated.load(std::memory_order_acquire);
+}
+
 } // namespace folly
@@ -24,6 +24,7 @@
 #include <folly/Indestructible.h>
 #include <folly/Portability.h>
 #include <folly/Unit.h>
+#include <folly/lang/Align.h>
 #include <folly/lang/SafeAssert.h>
 
 namespace folly {
@@ -33,10 +34,19 @@ namespace parking_lot_detail {
 struct WaitNodeBase {
   const uint64_t key_;
   const uint64_t lotid_;
+  // The waiters of a bucket are grouped by key and lot: the first
+  // waiter of a group is linked in the bucket list, and each group is
+  // a ring in FIFO order. Protected by the bucket mutex.
   WaitNodeBase* next_{nullptr};
   WaitNodeBase* prev_{nullptr};
-
-  // tricky: hold both bucket and node mutex to write, either to read
+  WaitNodeBase* groupNext_{this};
+  WaitNodeBase* groupPrev_{this};
+  bool groupHead_{false};
+  // Whether an unparker unlinked the node, and is about to wake it.
+  // Protected by the bucket mutex.
+  bool unlinked_{false};
+
+  // written with the node mutex held, once the node is unlinked
   bool signaled_;
   std::mutex mutex_;
   std::condition_variable cond_;
@@ -71,20 +81,39 @@ struct WaitNodeBase {
 
 extern std::atomic<uint64_t> idallocator;
 
-// Our emulated futex uses 4096 lists of wait nodes.  There are two levels
-// of locking: a per-list mutex that controls access to the list and a
-// per-node mutex, condvar, and bool that are used for the actual wakeups.
-// The per-node mutex allows us to do precise wakeups without thundering
-// herds.
-struct Bucket {
+// Our emulated futex uses lists of wait nodes, by default 4096 of them,
+// or 64 per cpu on larger hosts.  There are two levels of locking: a
+// per-list mutex that controls access to the list and a per-node mutex,
+// condvar, and bool that are used for the actual wakeups.  The per-node
+// mutex allows us to do precise wakeups without thundering herds.
+struct alignas(hardware_constructive_interference_size) Bucket {
   std::mutex mutex_;
-  WaitNodeBase* head_;
-  WaitNodeBase* tail_;
-  std::atomic<uint64_t> count_;
+  WaitNodeBase* head_{nullptr};
+  WaitNodeBase* tail_{nullptr};
+  std::atomic<uint64_t> count_{0};
 
   static Bucket& bucketFor(uint64_t key);
 
+  // The first waiter for key in lot, or nullptr
+  WaitNodeBase* find(uint64_t key, uint64_t lotid) const {
+    for (auto iter = head_; iter != nullptr; iter = iter->next_) {
+      if (iter->key_ == key && iter->lotid_ == lotid) {
+        return iter;
+      }
+    }
+    return nullptr;
+  }
+
   void push_back(WaitNodeBase* node) {
+    if (auto first = find(node->key_, node->lotid_)) {
+      // append to the group of first
+      node->groupNext_ = first;
+      node->groupPrev_ = first->groupPrev_;
+      first->groupPrev_->groupNext_ = node;
+      first->groupPrev_ = node;
+      return;
+    }
+    node->groupHead_ = true;
     if (tail_) {
       FOLLY_SAFE_DCHECK(head_, "");
       node->prev_ = tail_;
@@ -98,6 +127,33 @@ struct Bucket {
 
   void erase(WaitNodeBase* node) {
     FOLLY_SAFE_DCHECK(count_.load(std::memory_order_relaxed) >= 1, "");
+    if (node->groupNext_ != node) {
+      node->groupNext_->groupPrev_ = node->groupPrev_;
+      node->groupPrev_->groupNext_ = node->groupNext_;
+      if (node->groupHead_) {
+        replace(node, node->groupNext_);
+      }
+    } else {
+      unlink(node);
+    }
+    node->groupNext_ = node;
+    node->groupPrev_ = node;
+    node->groupHead_ = false;
+    count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  void replace(WaitNodeBase* node, WaitNodeBase* with) {
+    with->groupHead_ = true;
+    with->prev_ = node->prev_;
+    with->next_ = node->next_;
+    (node->prev_ ? node->prev_->next_ : head_) = with;
+    (node->next_ ? node->next_->prev_ : tail_) = with;
+    node->prev_ = nullptr;
+    node->next_ = nullptr;
+  }
+
+  void unlink(WaitNodeBase* node) {
     if (head_ == node && tail_ == node) {
       FOLLY_SAFE_DCHECK(node->prev_ == nullptr, "");
       FOLLY_SAFE_DCHECK(node->next_ == nullptr, "");
@@ -119,7 +175,8 @@ struct Bucket {
       node->next_->prev_ = node->prev_;
       node->prev_->next_ = node->next_;
     }
-    count_.fetch_sub(1, std::memory_order_relaxed);
+    node->prev_ = nullptr;
+    node->next_ = nullptr;
   }
 };
 
@@ -243,8 +300,33 @@ class ParkingLot {
    */
   template <typename Key, typename Unparker>
   void unpark(const Key key, Unparker&& func);
+
+  /*
+   * Wakes up to n of the waiters on key, in the order in which they
+   * parked, and returns how many were woken.
+   */
+  template <typename Key>
+  size_t unpark_n(const Key key, size_t n) {
+    size_t woken = 0;
+    if (n != 0) {
+      unpark(key, [&](const Data&) {
+        return ++woken < n ? UnparkControl::RemoveContinue
+                           : UnparkControl::RemoveBreak;
+      });
+    }
+    return woken;
+  }
 };
 
+/*
+ * Sets the number of buckets shared by all ParkingLots, rounded up to a
+ * power of two, instead of the default of 64 per cpu with a minimum of
+ * 4096 (256 on mobile).  Must be called before any thread parks or
+ * unparks: returns false, and has no effect, if the buckets already
+ * exist.
+ */
+bool setParkingLotBucketCount(size_t count);
+
 template <typename Data>
 template <
     typename Key,
@@ -284,11 +366,14 @@ ParkResult ParkingLot<Data>::park_until(
 
   if (status == std::cv_status::timeout) {
     // it's not really a timeout until we unlink the unsignaled node
-    std::lock_guard<std::mutex> bucketLock(bucket.mutex_);
-    if (!node.signaled()) {
+    std::unique_lock<std::mutex> bucketLock(bucket.mutex_);
+    if (!node.unlinked_) {
       bucket.erase(&node);
       return ParkResult::Timeout;
     }
+    bucketLock.unlock();
+    // an unparker is about to wake the node, and must find it alive
+    node.wait(std::chrono::steady_clock::time_point::max());
   }
 
   return ParkResult::Unpark;
@@ -306,26 +391,41 @@ void ParkingLot<Data>::unpark(const Key bits, Func&& func) {
     return;
   }
 
-  std::lock_guard<std::mutex> bucketLock(bucket.mutex_);
+  // Nodes are woken once the bucket lock is released, so that their
+  // waiters do not immediately block on it.  unlinked_ tells the timed
+  // out waiters that they need to wait for the wakeup.
+  parking_lot_detail::WaitNodeBase* toWake = nullptr;
+  parking_lot_detail::WaitNodeBase* toWakeTail = nullptr;
+  {
+    std::lock_guard<std::mutex> bucketLock(bucket.mutex_);
 
-  for (auto iter = bucket.head_; iter != nullptr;) {
-    auto node = static_cast<WaitNode*>(iter);
-    iter = iter->next_;
-    if (node->key_ == key && node->lotid_ == lotid_) {
+    auto first = bucket.find(key, lotid_);
+    auto iter = first;
+    auto last = first ? first->groupPrev_ : nullptr;
+    while (iter != nullptr) {
+      auto node = static_cast<WaitNode*>(iter);
+      iter = node == last ? nullptr : iter->groupNext_;
       auto result = std::forward<Func>(func)(node->data_);
       if (result == UnparkControl::RemoveBreak ||
           result == UnparkControl::RemoveContinue) {
         // we unlink, but waiter destroys the node
         bucket.erase(node);
-
-        node->wake();
+        node->unlinked_ = true;
+        (toWakeTail ? toWakeTail->next_ : toWake) = node;
+        toWakeTail = node;
       }
       if (result == UnparkControl::RemoveBreak ||
           result == UnparkControl::RetainBreak) {
-        return;
+        break;
       }
     }
   }
+
+  while (toWake != nullptr) {
+    auto node = toWake;
+    toWake = node->next_;
+    node->wake();
+  }
 }
 
 } // namespace folly
@@ -78,6 +78,21 @@ void rcu_domain<Tag>::call(T&& cbin) {
 template <typename Tag>
 void rcu_domain<Tag>::retire(list_node* node) noexcept {
   q_.push(node);
+  auto pending = pending_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (pending > maxPending_.load(std::memory_order_relaxed)) {
+    // Don't wait for a concurrent synchronize(), which may be waiting for
+    // our own read lock.
+    list_head finished;
+    {
+      std::unique_lock<std::mutex> g(syncMutex_, std::try_to_lock);
+      if (!g.owns_lock()) {
+        return;
+      }
+      half_sync(false, finished);
+    }
+    run_finished(finished);
+    return;
+  }
 
   // Note that it's likely we hold a read lock here,
   // so we can only half_sync(false).  half_sync(true)
@@ -95,11 +110,15 @@ void rcu_domain<Tag>::retire(list_node* node) noexcept {
       half_sync(false, finished);
     }
     // callbacks are called outside of syncMutex_
-    finished.forEach(
-        [&](list_node* item) { executor_->add(std::move(item->cb_)); });
+    run_finished(finished);
   }
 }
 
+template <typename Tag>
+void rcu_domain<Tag>::set_max_pending(size_t maxPending) noexcept {
+  maxPending_.store(maxPending, std::memory_order_relaxed);
+}
+
 template <typename Tag>
 void rcu_domain<Tag>::synchronize() noexcept {
   auto curr = version_.load(std::memory_order_acquire);
@@ -120,8 +139,7 @@ void rcu_domain<Tag>::synchronize() noexcept {
         }
       }
       // callbacks are called outside of syncMutex_
-      finished.forEach(
-          [&](list_node* node) { executor_->add(std::move(node->cb_)); });
+      run_finished(finished);
       return;
     } else {
       if (version_.load(std::memory_order_acquire) >= target) {
@@ -174,4 +192,14 @@ void rcu_domain<Tag>::half_sync(bool blocking, list_head& finished) {
   turn_.completeTurn(curr);
 }
 
+template <typename Tag>
+void rcu_domain<Tag>::run_finished(list_head& finished) {
+  size_t count = 0;
+  finished.forEach([&](list_node* node) {
+    ++count;
+    executor_->add(std::move(node->cb_));
+  });
+  pending_.fetch_sub(count, std::memory_order_relaxed);
+}
+
 } // namespace folly
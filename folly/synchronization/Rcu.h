@@ -222,12 +222,15 @@
 // specialized queues could be used if available, since only a single reader
 // reads the queue, and can splice all of the items to the executor if possible.
 //
-// synchronize_rcu() call latency is on the order of 10ms.  Multiple
+// synchronize_rcu() call latency is on the order of 10ms, or tens of
+// microseconds when the kernel supports MEMBARRIER_CMD_PRIVATE_EXPEDITED
+// (Linux 4.14), which the heavy barriers use when available.  Multiple
 // separate threads can share a synchronized period and should scale.
 //
 // rcu_retire() is a queue push, and on the order of 150 ns, however,
-// the current implementation may synchronize if the retire queue is full,
-// resulting in tail latencies of ~10ms.
+// it moves the queue through an epoch every few seconds, and on every
+// call while more than set_max_pending() calls are queued, resulting in
+// tail latencies of a full barrier.
 //
 // rcu_reader creation/destruction is ~4ns.  By comparison,
 // folly::SharedMutex::lock_shared + unlock_shared pair is ~26ns
@@ -343,6 +346,14 @@ class rcu_domain {
   void call(T&& cbin);
   void retire(list_node* node) noexcept;
 
+  // Bound the number of call()s and retire()s waiting for their grace
+  // period.  Past it, every call() and retire() tries to move the queue
+  // through an epoch without blocking, instead of only doing so every
+  // few seconds, so that memory stays bounded as long as readers make
+  // progress.  A call() whose callback deletes many objects counts once.
+  // Unbounded by default.
+  void set_max_pending(size_t maxPending) noexcept;
+
   // Ensure concurrent critical sections have finished.
   // Always waits for full synchronization.
   // read lock *must not* be held.
@@ -368,6 +379,9 @@ class rcu_domain {
   detail::ThreadCachedLists<Tag> q_;
   // Executor callbacks will eventually be run on.
   Executor* executor_{nullptr};
+  // Number of nodes in q_ and queues_.
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> maxPending_{std::numeric_limits<size_t>::max()};
   static bool singleton_; // Ensure uniqueness per-tag.
 
   // Queues for callbacks waiting to go through two epochs.
@@ -380,6 +394,9 @@ class rcu_domain {
   //
   // returns a list of callbacks ready to run in cbs.
   void half_sync(bool blocking, list_head& cbs);
+
+  // Hand callbacks returned by half_sync() to the executor.
+  void run_finished(list_head& cbs);
 };
 
 extern folly::Indestructible<rcu_domain<RcuTag>*> rcu_default_domain_;
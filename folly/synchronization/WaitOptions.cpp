@@ -19,5 +19,24 @@
 namespace folly {
 
 constexpr std::chrono::nanoseconds WaitOptions::Defaults::spin_max;
+constexpr bool WaitOptions::Defaults::spin_adaptive;
+
+namespace detail {
+std::atomic<std::int64_t> wait_options_spin_max_ns{
+    WaitOptions::Defaults::spin_max.count()};
+std::atomic<bool> wait_options_spin_adaptive{
+    WaitOptions::Defaults::spin_adaptive};
+} // namespace detail
+
+void WaitOptions::set_process_defaults(WaitOptions const& opt) {
+  if (opt.spin_max_ >= std::chrono::nanoseconds::zero()) {
+    detail::wait_options_spin_max_ns.store(
+        opt.spin_max_.count(), std::memory_order_relaxed);
+  }
+  if (opt.spin_adaptive_ != Tristate::Unset) {
+    detail::wait_options_spin_adaptive.store(
+        opt.spin_adaptive_ == Tristate::True, std::memory_order_relaxed);
+  }
+}
 
 } // namespace folly
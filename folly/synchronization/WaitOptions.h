@@ -16,12 +16,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 
 #include <folly/CPortability.h>
 
 namespace folly {
 
+namespace detail {
+// The process-wide WaitOptions; see WaitOptions::set_process_defaults.
+extern std::atomic<std::int64_t> wait_options_spin_max_ns;
+extern std::atomic<bool> wait_options_spin_adaptive;
+} // namespace detail
+
 /// WaitOptions
 ///
 /// Various synchronization primitives as well as various concurrent data
@@ -53,18 +62,52 @@ class WaitOptions {
     /// nsec is the pause instruction.
     static constexpr std::chrono::nanoseconds spin_max =
         std::chrono::microseconds(2);
+
+    /// spin_adaptive
+    ///
+    /// Whether to shorten the spin while spinning rarely succeeds. When most
+    /// waits end up blocking anyway, spinning is pure overhead; an adaptive
+    /// spin halves its duration (down to 1/64 of spin_max) each time a spin
+    /// fails and doubles it each time one succeeds. One wait in eight still
+    /// spins for the full spin_max, so that the spin grows back once waits
+    /// become short again. The state is per thread, shared by all of the
+    /// primitives the thread waits on.
+    static constexpr bool spin_adaptive = false;
   };
 
-  constexpr std::chrono::nanoseconds spin_max() const {
-    return spin_max_;
+  /// Options that are not set take the process-wide values, which start out
+  /// as Defaults and can be changed with set_process_defaults, to tune
+  /// the cpu-for-latency trade of a deployment in one place.
+  std::chrono::nanoseconds spin_max() const {
+    return spin_max_ >= std::chrono::nanoseconds::zero()
+        ? spin_max_
+        : std::chrono::nanoseconds(detail::wait_options_spin_max_ns.load(
+              std::memory_order_relaxed));
   }
   constexpr WaitOptions& spin_max(std::chrono::nanoseconds dur) {
-    spin_max_ = dur;
+    spin_max_ = std::max(dur, std::chrono::nanoseconds::zero());
     return *this;
   }
 
+  bool spin_adaptive() const {
+    return spin_adaptive_ == Tristate::Unset
+        ? detail::wait_options_spin_adaptive.load(std::memory_order_relaxed)
+        : spin_adaptive_ == Tristate::True;
+  }
+  constexpr WaitOptions& spin_adaptive(bool adaptive) {
+    spin_adaptive_ = adaptive ? Tristate::True : Tristate::False;
+    return *this;
+  }
+
+  /// Sets the process-wide values from the options set in opt.
+  static void set_process_defaults(WaitOptions const& opt);
+
  private:
-  std::chrono::nanoseconds spin_max_ = Defaults::spin_max;
+  enum class Tristate : std::uint8_t { Unset, False, True };
+
+  //  negative if unset
+  std::chrono::nanoseconds spin_max_ = std::chrono::nanoseconds(-1);
+  Tristate spin_adaptive_ = Tristate::Unset;
 };
 
 } // namespace folly
@@ -18,8 +18,10 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <thread>
 
+#include <folly/Portability.h>
 #include <folly/portability/Asm.h>
 #include <folly/synchronization/WaitOptions.h>
 
@@ -32,18 +34,59 @@ enum class spin_result {
   advance, // exceeded current wait-options component timeout
 };
 
+//  Per-thread state of WaitOptions::spin_adaptive().
+class spin_adaptation {
+ public:
+  static constexpr std::uint8_t max_shift = 6;
+  static constexpr std::uint8_t probe_period = 8;
+
+  //  The spin duration for the next wait.
+  std::chrono::nanoseconds next(std::chrono::nanoseconds spin_max) {
+    probing_ = shift_ != 0 && ++waits_ % probe_period == 0;
+    return probing_ ? spin_max : spin_max / (1 << shift_);
+  }
+
+  void record(bool success) {
+    if (success) {
+      shift_ = probing_ ? 0 : std::max(shift_, std::uint8_t(1)) - 1;
+    } else if (!probing_) {
+      shift_ = std::min(std::uint8_t(shift_ + 1), max_shift);
+    }
+  }
+
+  static spin_adaptation& instance() {
+    static FOLLY_TLS spin_adaptation state;
+    return state;
+  }
+
+ private:
+  std::uint8_t shift_{0};
+  std::uint8_t waits_{0};
+  bool probing_{false};
+};
+
 template <typename Clock, typename Duration, typename F>
 spin_result spin_pause_until(
     std::chrono::time_point<Clock, Duration> const& deadline,
     WaitOptions const& opt,
     F f) {
-  if (opt.spin_max() <= opt.spin_max().zero()) {
+  auto spin_max = opt.spin_max();
+  if (spin_max <= spin_max.zero()) {
     return spin_result::advance;
   }
 
+  spin_adaptation* adaptation = nullptr;
+  if (opt.spin_adaptive()) {
+    adaptation = &spin_adaptation::instance();
+    spin_max = adaptation->next(spin_max);
+  }
+
   auto tbegin = Clock::now();
   while (true) {
     if (f()) {
+      if (adaptation) {
+        adaptation->record(true);
+      }
       return spin_result::success;
     }
 
@@ -54,7 +97,10 @@ spin_result spin_pause_until(
 
     //  Backward time discontinuity in Clock? revise pre_block starting point
     tbegin = std::min(tbegin, tnow);
-    if (tnow >= tbegin + opt.spin_max()) {
+    if (tnow >= tbegin + spin_max) {
+      if (adaptation) {
+        adaptation->record(false);
+      }
       return spin_result::advance;
     }
 
@@ -15,6 +15,7 @@
  */
 
 #include <folly/synchronization/Hazptr.h>
+#include <folly/executors/ManualExecutor.h>
 #include <folly/synchronization/example/HazptrLockFreeLIFO.h>
 #include <folly/synchronization/example/HazptrSWMRSet.h>
 #include <folly/synchronization/example/HazptrWideCAS.h>
@@ -1215,6 +1216,29 @@ TEST(HazptrTest, reclamation_without_calling_cleanup) {
   ASSERT_GT(c_.dtors(), 0);
 }
 
+TEST(HazptrTest, reclamation_on_executor) {
+  c_.clear();
+  int objs = folly::detail::hazptr_domain_rcount_threshold();
+  folly::ManualExecutor ex;
+  hazptr_domain<> domain;
+  domain.set_executor(&ex);
+  for (int i = 0; i < objs; ++i) {
+    auto p = new Node<>;
+    p->retire(domain);
+  }
+  // Retiring threads don't reclaim anything themselves.
+  ASSERT_EQ(c_.dtors(), 0);
+  ex.run();
+  ASSERT_EQ(c_.dtors(), objs);
+  domain.clear_executor();
+  for (int i = 0; i < objs; ++i) {
+    auto p = new Node<>;
+    p->retire(domain);
+  }
+  ASSERT_GT(c_.dtors(), objs);
+  ASSERT_EQ(ex.run(), 0);
+}
+
 // Benchmark drivers
 
 template <typename InitFunc, typename Func, typename EndFunc>
@@ -308,6 +308,17 @@ TEST_F(LifoSemTest, timeout) {
   }
 }
 
+TEST(LifoSem, wait_options) {
+  LifoSem a;
+  auto noSpin = a.wait_options().spin_max(std::chrono::nanoseconds(0));
+  EXPECT_FALSE(a.try_wait_for(std::chrono::milliseconds(1), noSpin));
+  a.post();
+  EXPECT_TRUE(a.try_wait_for(std::chrono::milliseconds(1), noSpin));
+  a.post();
+  a.wait(a.wait_options().spin_adaptive(true));
+  EXPECT_FALSE(a.try_wait());
+}
+
 TEST_F(LifoSemTest, shutdown_try_wait_for) {
   long seed = folly::randomNumberSeed() % 1000000;
   LOG(INFO) << "seed=" << seed;
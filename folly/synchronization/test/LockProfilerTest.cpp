@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/synchronization/LockProfiler.h>
+
+#include <thread>
+#include <vector>
+
+#include <folly/MicroLock.h>
+#include <folly/SharedMutex.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/synchronization/DistributedMutex.h>
+
+using folly::LockProfiler;
+using namespace std::chrono_literals;
+
+namespace {
+
+class LockProfilerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LockProfiler::reset();
+    LockProfiler::setEnabled(true);
+  }
+
+  void TearDown() override {
+    LockProfiler::setEnabled(false);
+    LockProfiler::reset();
+  }
+};
+
+// Holds the lock for a while so that the lock on this thread has to wait.
+template <typename Lock>
+void contend(Lock& lock) {
+  folly::Baton<> locked;
+  std::thread holder([&] {
+    std::unique_lock<Lock> guard(lock);
+    locked.post();
+    std::this_thread::sleep_for(10ms);
+  });
+  locked.wait();
+  { std::unique_lock<Lock> guard(lock); }
+  holder.join();
+}
+
+LockProfiler::Stats statsFor(const void* lock) {
+  for (auto& stats : LockProfiler::topContended(LockProfiler::kMaxLocks)) {
+    if (stats.lock == lock) {
+      return stats;
+    }
+  }
+  return {};
+}
+
+} // namespace
+
+TEST_F(LockProfilerTest, Disabled) {
+  LockProfiler::setEnabled(false);
+  folly::SharedMutex lock;
+  contend(lock);
+  EXPECT_TRUE(LockProfiler::topContended(10).empty());
+}
+
+TEST_F(LockProfilerTest, SharedMutex) {
+  folly::SharedMutex lock;
+  LockProfiler::setName(&lock, "shared");
+  contend(lock);
+  auto stats = statsFor(&lock);
+  EXPECT_EQ("shared", stats.name);
+  EXPECT_GE(stats.waits, 1);
+  EXPECT_GE(stats.totalWait, 5ms);
+  EXPECT_GE(stats.maxWait, 5ms);
+  EXPECT_LE(stats.waitQuantile(0.5), stats.maxWait * 2);
+}
+
+TEST_F(LockProfilerTest, MicroLock) {
+  folly::MicroLock lock;
+  lock.init();
+  contend(lock);
+  EXPECT_EQ(1, LockProfiler::topContended(10).size());
+  EXPECT_GE(LockProfiler::topContended(10)[0].totalWait, 5ms);
+}
+
+TEST_F(LockProfilerTest, DistributedMutex) {
+  folly::DistributedMutex lock;
+  contend(lock);
+  auto stats = statsFor(&lock);
+  EXPECT_EQ(1, stats.waits);
+  EXPECT_EQ(0, stats.combined);
+  EXPECT_GE(stats.totalWait, 5ms);
+}
+
+TEST_F(LockProfilerTest, Combined) {
+  folly::DistributedMutex lock;
+  auto value = 0;
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (auto j = 0; j < 10000; ++j) {
+        lock.lock_combine([&] { ++value; });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(80000, value);
+  auto stats = statsFor(&lock);
+  EXPECT_LE(stats.combined, stats.waits);
+  std::uint64_t histogramTotal = 0;
+  for (auto count : stats.waitHistogram) {
+    histogramTotal += count;
+  }
+  EXPECT_EQ(stats.waits, histogramTotal);
+}
+
+TEST_F(LockProfilerTest, TopContended) {
+  int locks[3];
+  LockProfiler::recordWait(&locks[0], 1ms);
+  LockProfiler::recordWait(&locks[1], 3ms);
+  LockProfiler::recordWait(&locks[2], 1ms);
+  LockProfiler::recordWait(&locks[2], 1ms);
+  LockProfiler::setName(&locks[1], "slowest");
+
+  auto top = LockProfiler::topContended(2);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ(&locks[1], top[0].lock);
+  EXPECT_EQ(&locks[2], top[1].lock);
+  EXPECT_EQ(2, top[1].waits);
+
+  auto report = LockProfiler::report(2);
+  EXPECT_NE(std::string::npos, report.find("slowest"));
+  EXPECT_EQ(3, std::count(report.begin(), report.end(), '\n'));
+}
@@ -15,6 +15,7 @@
  */
 
 #include <thread>
+#include <vector>
 
 #include <folly/synchronization/ParkingLot.h>
 
@@ -70,6 +71,89 @@ TEST(ParkingLot, LargeWord) {
   // Validate should return false, will hang otherwise.
 }
 
+TEST(ParkingLot, UnparkN) {
+  ParkingLot<int> lot;
+  constexpr int kWaiters = 6;
+  std::atomic<int> parked{0};
+  std::atomic<int> woken{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kWaiters; ++i) {
+    // waiters on two keys, to check that they are woken separately
+    threads.emplace_back([&, i] {
+      int key = i % 2;
+      lot.park(key, i, [] { return true; }, [&] { ++parked; });
+      ++woken;
+    });
+    while (parked.load() != i + 1) {
+      std::this_thread::yield();
+    }
+  }
+
+  EXPECT_EQ(0, lot.unpark_n(0, 0));
+  std::vector<int> order;
+  lot.unpark(0, [&](int data) {
+    order.push_back(data);
+    return UnparkControl::RetainContinue;
+  });
+  // waiters of a key are visited in the order in which they parked
+  EXPECT_EQ(std::vector<int>({0, 2, 4}), order);
+
+  EXPECT_EQ(2, lot.unpark_n(1, 2));
+  while (woken.load() != 2) {
+    std::this_thread::yield();
+  }
+  order.clear();
+  lot.unpark(1, [&](int data) {
+    order.push_back(data);
+    return UnparkControl::RetainContinue;
+  });
+  EXPECT_EQ(std::vector<int>({5}), order);
+
+  EXPECT_EQ(3, lot.unpark_n(0, 10));
+  EXPECT_EQ(1, lot.unpark_n(1, 10));
+  EXPECT_EQ(0, lot.unpark_n(1, 10));
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(kWaiters, woken.load());
+}
+
+TEST(ParkingLot, TimeoutRacesUnpark) {
+  ParkingLot<> lot;
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> unparked{0};
+  std::atomic<uint64_t> timedOut{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      while (!done.load()) {
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(10);
+        auto res = lot.park_until(
+            &done, Unit{}, [&] { return !done.load(); }, [] {}, deadline);
+        if (res == ParkResult::Timeout) {
+          ++timedOut;
+        } else if (res == ParkResult::Unpark) {
+          ++unparked;
+        }
+      }
+    });
+  }
+  uint64_t woken = 0;
+  auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+  while (std::chrono::steady_clock::now() < end) {
+    woken += lot.unpark_n(&done, 3);
+  }
+  done = true;
+  for (auto& t : threads) {
+    woken += lot.unpark_n(&done, 8);
+    t.join();
+  }
+  woken += lot.unpark_n(&done, 8);
+  // every waiter that was unlinked by unpark_n reports an unpark
+  EXPECT_EQ(woken, unparked.load());
+}
+
 class WaitableMutex : public std::mutex {
   using Lot = ParkingLot<std::function<bool(void)>>;
   static Lot lot;
@@ -289,3 +289,30 @@ TEST(RcuTest, RcuObjBase) {
   synchronize_rcu();
   EXPECT_TRUE(retired);
 }
+
+TEST(RcuTest, MaxPending) {
+  struct UniqueTag;
+  rcu_domain<UniqueTag> newdomain(nullptr);
+  newdomain.set_max_pending(10);
+  int deleted = 0;
+  auto retire = [&] {
+    newdomain.call([&] { ++deleted; });
+  };
+
+  {
+    // Readers still hold back everything retired during their section.
+    rcu_reader_domain<UniqueTag> g(&newdomain);
+    for (int i = 0; i < 100; i++) {
+      retire();
+    }
+    EXPECT_EQ(0, deleted);
+  }
+
+  // Without readers, no more than the cap waits for a grace period.
+  for (int i = 0; i < 1000; i++) {
+    retire();
+  }
+  EXPECT_GE(deleted, 1100 - 10);
+  synchronize_rcu(&newdomain);
+  EXPECT_EQ(1100, deleted);
+}
@@ -163,3 +163,58 @@ TEST(SaturatingSemaphore, multi_poster_multi_waiter_may_block) {
   run_multi_poster_multi_waiter_test<true>(10, 1);
   run_multi_poster_multi_waiter_test<true>(10, 10);
 }
+
+TEST(SaturatingSemaphore, process_default_wait_options) {
+  using folly::WaitOptions;
+  EXPECT_EQ(WaitOptions::Defaults::spin_max, WaitOptions().spin_max());
+  EXPECT_FALSE(WaitOptions().spin_adaptive());
+
+  WaitOptions::set_process_defaults(
+      WaitOptions().spin_max(std::chrono::microseconds(5)));
+  EXPECT_EQ(std::chrono::microseconds(5), WaitOptions().spin_max());
+  EXPECT_EQ(
+      std::chrono::microseconds(1),
+      WaitOptions().spin_max(std::chrono::microseconds(1)).spin_max());
+  EXPECT_FALSE(WaitOptions().spin_adaptive());
+
+  WaitOptions::set_process_defaults(WaitOptions().spin_adaptive(true));
+  EXPECT_TRUE(WaitOptions().spin_adaptive());
+  EXPECT_FALSE(WaitOptions().spin_adaptive(false).spin_adaptive());
+  EXPECT_EQ(std::chrono::microseconds(5), WaitOptions().spin_max());
+
+  WaitOptions::set_process_defaults(
+      WaitOptions()
+          .spin_max(WaitOptions::Defaults::spin_max)
+          .spin_adaptive(WaitOptions::Defaults::spin_adaptive));
+}
+
+TEST(SaturatingSemaphore, adaptive_spin) {
+  using folly::detail::spin_adaptation;
+  SaturatingSemaphore<true> f;
+  auto opt = f.wait_options().spin_max(std::chrono::microseconds(64));
+  auto& adaptation = spin_adaptation::instance();
+
+  // Failed spins shorten the spin, down to 1/64 of spin_max.
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_FALSE(f.try_wait_for(
+        std::chrono::microseconds(100), opt.spin_adaptive(true)));
+  }
+  auto spins = 0;
+  while (adaptation.next(opt.spin_max()) == opt.spin_max()) {
+    ASSERT_LT(++spins, spin_adaptation::probe_period);
+  }
+  ASSERT_EQ(std::chrono::microseconds(1), adaptation.next(opt.spin_max()));
+  adaptation.record(false);
+
+  // Each successful spin doubles it, and a successful full-length probe
+  // restores it at once.
+  adaptation.next(opt.spin_max());
+  adaptation.record(true);
+  EXPECT_EQ(std::chrono::microseconds(2), adaptation.next(opt.spin_max()));
+  adaptation.record(false);
+  while (adaptation.next(opt.spin_max()) != opt.spin_max()) {
+    adaptation.record(false);
+  }
+  adaptation.record(true);
+  EXPECT_EQ(opt.spin_max(), adaptation.next(opt.spin_max()));
+}
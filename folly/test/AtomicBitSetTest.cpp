@@ -16,6 +16,10 @@
 
 #include <folly/AtomicBitSet.h>
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include <folly/portability/GFlags.h>
 #include <folly/portability/GTest.h>
 
@@ -55,6 +59,128 @@ TEST(AtomicBitSet, Simple) {
   }
 }
 
+TEST(AtomicBitSet, Scan) {
+  constexpr size_t kSize = 200;
+  AtomicBitSet<kSize> bs;
+  EXPECT_TRUE(bs.none());
+  EXPECT_EQ(kSize, bs.find_first_set());
+  EXPECT_EQ(0, bs.find_first_unset());
+
+  for (size_t i : {3, 64, 65, 130, 199}) {
+    bs.set(i);
+  }
+  EXPECT_TRUE(bs.any());
+  EXPECT_EQ(5, bs.count());
+  EXPECT_EQ(3, bs.find_first_set());
+  EXPECT_EQ(64, bs.find_first_set(4));
+  EXPECT_EQ(65, bs.find_first_set(65));
+  EXPECT_EQ(199, bs.find_first_set(131));
+  EXPECT_EQ(kSize, bs.find_first_set(kSize));
+  EXPECT_EQ(66, bs.find_first_unset(64));
+
+  std::vector<size_t> seen;
+  bs.for_each_set([&](size_t i) { seen.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{3, 64, 65, 130, 199}), seen);
+
+  bs.set_all();
+  EXPECT_EQ(kSize, bs.count());
+  EXPECT_EQ(kSize, bs.find_first_unset());
+  EXPECT_EQ(kSize, bs.set_first_unset());
+  bs.reset(150);
+  EXPECT_EQ(150, bs.set_first_unset());
+  EXPECT_TRUE(bs[150]);
+  bs.reset_all();
+  EXPECT_TRUE(bs.none());
+}
+
+TEST(AtomicBitSet, SetFirstUnsetConcurrent) {
+  constexpr size_t kSize = 1000;
+  constexpr size_t kThreads = 8;
+  AtomicBitSet<kSize> bs;
+  std::vector<std::vector<size_t>> claimed(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      size_t idx;
+      while ((idx = bs.set_first_unset()) != kSize) {
+        claimed[t].push_back(idx);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::vector<size_t> all;
+  for (auto& c : claimed) {
+    all.insert(all.end(), c.begin(), c.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(kSize, all.size());
+  for (size_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(i, all[i]);
+  }
+}
+
+TEST(DynamicAtomicBitSet, Simple) {
+  DynamicAtomicBitSet bs;
+  EXPECT_EQ(0, bs.capacity());
+  EXPECT_FALSE(bs.test(12345));
+  EXPECT_FALSE(bs.reset(12345));
+  EXPECT_EQ(0, bs.capacity());
+  EXPECT_EQ(0, bs.find_first_unset());
+  EXPECT_EQ(bs.max_size(), bs.find_first_set());
+
+  EXPECT_FALSE(bs.set(100000));
+  EXPECT_TRUE(bs.set(100000));
+  EXPECT_GT(bs.capacity(), 0);
+  EXPECT_LT(bs.capacity(), 100000);
+  EXPECT_TRUE(bs[100000]);
+  EXPECT_FALSE(bs[99999]);
+  bs.set(5);
+  EXPECT_EQ(5, bs.find_first_set());
+  EXPECT_EQ(100000, bs.find_first_set(6));
+  EXPECT_EQ(2, bs.count());
+  EXPECT_EQ(6, bs.find_first_unset(5));
+
+  std::vector<size_t> seen;
+  bs.for_each_set([&](size_t i) { seen.push_back(i); });
+  EXPECT_EQ((std::vector<size_t>{5, 100000}), seen);
+
+  bs.reset_all();
+  EXPECT_EQ(0, bs.count());
+  EXPECT_EQ(bs.max_size(), bs.find_first_set());
+}
+
+TEST(DynamicAtomicBitSet, SetFirstUnsetGrows) {
+  DynamicAtomicBitSet bs(100);
+  EXPECT_GE(bs.capacity(), 100);
+  constexpr size_t kThreads = 4;
+  constexpr size_t kPerThread = 5000;
+  std::vector<std::vector<size_t>> claimed(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < kPerThread; ++i) {
+        claimed[t].push_back(bs.set_first_unset());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::vector<size_t> all;
+  for (auto& c : claimed) {
+    all.insert(all.end(), c.begin(), c.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(kThreads * kPerThread, all.size());
+  for (size_t i = 0; i < all.size(); ++i) {
+    EXPECT_EQ(i, all[i]);
+  }
+  EXPECT_EQ(all.size(), bs.count());
+  EXPECT_EQ(all.size(), bs.find_first_unset());
+}
+
 } // namespace test
 } // namespace folly
 
@@ -18,6 +18,7 @@
 #include <folly/String.h>
 #include <folly/container/Foreach.h>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <numeric>
 #include <random>
@@ -360,6 +361,23 @@ BENCHMARK(BenchmarkSuspender_dismissing_value, iter) {
   }
 }
 
+BENCHMARK_DRAW_LINE();
+
+std::atomic<size_t> sharedCounter;
+
+BENCHMARK_MT_SCALING(sharedCounterIncrement, 4, iters, thread) {
+  FOR_EACH_RANGE (i, 0, iters) {
+    sharedCounter.fetch_add(1);
+  }
+}
+
+BENCHMARK_MT(perThreadIncrement, 4, iters, thread) {
+  size_t local = thread;
+  FOR_EACH_RANGE (i, 0, iters) {
+    doNotOptimizeAway(++local);
+  }
+}
+
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   runBenchmarks();
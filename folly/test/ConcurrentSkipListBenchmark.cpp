@@ -305,6 +305,43 @@ void BM_AddSkipList(int iters, int size) {
   }
 }
 
+// Adds the same values as BM_AddSkipList, as sorted batches of 1000.
+template <bool kBatch>
+void addSortedBatches(int iters, int size) {
+  BenchmarkSuspender susp;
+  auto skipList = SkipListType::create(kInitHeadHeight);
+  for (int i = 0; i < size; ++i) {
+    skipList.add(gData[i]);
+  }
+  std::vector<ValueType> values(
+      gData.begin() + size, gData.begin() + size + iters);
+  for (size_t i = 0; i < values.size(); i += 1000) {
+    auto end = values.begin() + std::min(values.size(), i + 1000);
+    std::sort(values.begin() + i, end);
+  }
+  susp.dismiss();
+
+  for (size_t i = 0; i < values.size(); i += 1000) {
+    auto first = values.begin() + i;
+    auto last = values.begin() + std::min(values.size(), i + 1000);
+    if (kBatch) {
+      skipList.insertSorted(first, last);
+    } else {
+      for (; first != last; ++first) {
+        skipList.add(*first);
+      }
+    }
+  }
+}
+
+void BM_AddSkipListSorted(int iters, int size) {
+  addSortedBatches<false>(iters, size);
+}
+
+void BM_InsertSortedSkipList(int iters, int size) {
+  addSortedBatches<true>(iters, size);
+}
+
 BENCHMARK(Accessor, iters) {
   BenchmarkSuspender susp;
   auto skiplist = SkipListType::createInstance(kInitHeadHeight);
@@ -558,14 +595,20 @@ BENCHMARK_DRAW_LINE();
 
 BENCHMARK_PARAM(BM_AddSet, 1000)
 BENCHMARK_PARAM(BM_AddSkipList, 1000)
+BENCHMARK_PARAM(BM_AddSkipListSorted, 1000)
+BENCHMARK_PARAM(BM_InsertSortedSkipList, 1000)
 BENCHMARK_DRAW_LINE();
 
 BENCHMARK_PARAM(BM_AddSet, 65536)
 BENCHMARK_PARAM(BM_AddSkipList, 65536)
+BENCHMARK_PARAM(BM_AddSkipListSorted, 65536)
+BENCHMARK_PARAM(BM_InsertSortedSkipList, 65536)
 BENCHMARK_DRAW_LINE();
 
 BENCHMARK_PARAM(BM_AddSet, 1000000)
 BENCHMARK_PARAM(BM_AddSkipList, 1000000)
+BENCHMARK_PARAM(BM_AddSkipListSorted, 1000000)
+BENCHMARK_PARAM(BM_InsertSortedSkipList, 1000000)
 BENCHMARK_DRAW_LINE();
 
 BENCHMARK_PARAM(BM_SetMerge, 1000)
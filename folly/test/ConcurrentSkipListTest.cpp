@@ -18,6 +18,7 @@
 
 #include <folly/ConcurrentSkipList.h>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <set>
@@ -418,6 +419,83 @@ TEST(ConcurrentSkipList, ConcurrentAccess) {
   testConcurrentAccess(1000000, 100000, kMaxValue);
 }
 
+TEST(ConcurrentSkipList, InsertSorted) {
+  auto skipList = SkipListType::create(kHeadHeight);
+  SetType verifier;
+  for (int batch = 0; batch < 50; ++batch) {
+    VectorType values;
+    for (int i = 0; i < 500; ++i) {
+      values.push_back(rand() % (kMaxValue * 10));
+    }
+    std::sort(values.begin(), values.end());
+    // a few out of order values, which are still inserted
+    if (batch % 5 == 0) {
+      std::swap(values[10], values[400]);
+    }
+    size_t expected = 0;
+    for (auto v : values) {
+      expected += verifier.insert(v).second;
+    }
+    EXPECT_EQ(expected, skipList.insertSorted(values.begin(), values.end()));
+  }
+  verifyEqual(skipList, verifier);
+}
+
+TEST(ConcurrentSkipList, ConcurrentInsertSorted) {
+  // each thread inserts its own residues, in interleaved sorted batches,
+  // while others remove values
+  auto skipList = SkipListType::create(kHeadHeight);
+  const int kThreads = 8;
+  const int kValues = 20000;
+  vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int start = 0; start < kValues; start += 1000) {
+        VectorType values;
+        for (int v = start + t; v < start + 1000; v += kThreads) {
+          values.push_back(v);
+        }
+        skipList.insertSorted(values.begin(), values.end());
+        if (t % 2 == 0) {
+          skipList.remove(start + t);
+        }
+      }
+    });
+  }
+  FOR_EACH (t, threads) { (*t).join(); }
+
+  SetType verifier;
+  for (int v = 0; v < kValues; ++v) {
+    int t = v % kThreads;
+    if (t % 2 == 1 || (v - t) % 1000 != 0) {
+      verifier.insert(v);
+    }
+  }
+  verifyEqual(skipList, verifier);
+}
+
+TEST(ConcurrentSkipList, ForEachInRange) {
+  auto skipList = SkipListType::create(kHeadHeight);
+  for (int i = 0; i < 10000; ++i) {
+    skipList.add(2 * i);
+  }
+  skipList.remove(200);
+
+  VectorType seen;
+  skipList.forEachInRange(101, 401, [&](int v) { seen.push_back(v); });
+  VectorType expected;
+  for (int v = 102; v < 401; v += 2) {
+    if (v != 200) {
+      expected.push_back(v);
+    }
+  }
+  EXPECT_EQ(expected, seen);
+
+  seen.clear();
+  skipList.forEachInRange(30000, 40000, [&](int v) { seen.push_back(v); });
+  EXPECT_TRUE(seen.empty());
+}
+
 struct NonTrivialValue {
   static std::atomic<int> InstanceCounter;
   static const int kBadPayLoad;
@@ -27,10 +27,13 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include <limits>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace folly;
@@ -562,6 +565,143 @@ TEST(Conv, DoubleToString) {
   testDoubleToString<fbstring>();
 }
 
+template <class Src>
+void checkDtoaShortest(Src value) {
+  using namespace double_conversion;
+  for (auto const& format :
+       {detail::kConvDtoaShortestFormat,
+        detail::DtoaShortestFormat{"inf", "nan", 'e', -4, 6, true, true}}) {
+    DoubleToStringConverter conv(
+        (format.emitPositiveExponentSign
+             ? DoubleToStringConverter::EMIT_POSITIVE_EXPONENT_SIGN
+             : 0) |
+            (format.emitTrailingDecimalPoint
+                 ? DoubleToStringConverter::EMIT_TRAILING_DECIMAL_POINT
+                 : 0),
+        format.infinitySymbol,
+        format.nanSymbol,
+        format.exponentCharacter,
+        format.decimalInShortestLow,
+        format.decimalInShortestHigh,
+        0,
+        0);
+    char expected[128];
+    StringBuilder builder(expected, sizeof(expected));
+    if (std::is_same<Src, float>::value) {
+      conv.ToShortestSingle(float(value), &builder);
+    } else {
+      conv.ToShortest(double(value), &builder);
+    }
+    auto const expectedLength = size_t(builder.position());
+    char actual[128];
+    auto const length =
+        detail::dtoaShortest(value, actual, sizeof(actual), format);
+    if (length == 0) {
+      // no floating point std::to_chars()
+      continue;
+    }
+    EXPECT_EQ(
+        StringPiece(expected, expectedLength), StringPiece(actual, length));
+  }
+}
+
+TEST(Conv, DtoaShortest) {
+  for (double value :
+       {0.0,
+        -0.0,
+        1.0,
+        0.1,
+        1.0 / 3,
+        123456.0,
+        1e20,
+        1e21,
+        1e-6,
+        1e-7,
+        5e-324,
+        std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN()}) {
+    checkDtoaShortest(value);
+    checkDtoaShortest(float(value));
+  }
+  std::mt19937_64 rng;
+  for (int i = 0; i < 10000; ++i) {
+    auto const bits = rng();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    checkDtoaShortest(value);
+    float single;
+    std::memcpy(&single, &bits, sizeof(single));
+    checkDtoaShortest(single);
+  }
+}
+
+TEST(Conv, DigitChunks) {
+  // every length, so each of the 8, 4 and 1 digit loops ends the parse, and
+  // a non-digit in every position
+  for (size_t size = 1; size <= 19; ++size) {
+    std::string digits;
+    uint64_t expected = 0;
+    for (size_t i = 0; i < size; ++i) {
+      digits.push_back(char('1' + i % 9));
+      expected = expected * 10 + uint64_t(1 + i % 9);
+    }
+    EXPECT_EQ(expected, to<uint64_t>(digits));
+    EXPECT_EQ(expected, to<uint64_t>(digits + " "));
+    for (size_t i = 0; i < size; ++i) {
+      for (char c : {'/', ':', 'a', '\xff', '\0'}) {
+        std::string bad = digits;
+        bad[i] = c;
+        EXPECT_FALSE(tryTo<uint64_t>(bad).hasValue()) << bad;
+        StringPiece sp(bad);
+        auto prefix = tryTo<uint64_t>(&sp);
+        EXPECT_EQ(i == 0, !prefix.hasValue());
+        EXPECT_EQ(size - i, sp.size());
+      }
+    }
+  }
+}
+
+TEST(Conv, TryToDelimited) {
+  std::vector<int64_t> out;
+  EXPECT_TRUE(tryToDelimited(',', "", out).hasValue());
+  EXPECT_TRUE(out.empty());
+  EXPECT_TRUE(
+      tryToDelimited(',', "1,-2, 3 ,12345678901234567,0", out).hasValue());
+  EXPECT_EQ(
+      (std::vector<int64_t>{1, -2, 3, 12345678901234567, 0}), out);
+
+  std::vector<uint8_t> bytes;
+  EXPECT_TRUE(tryToDelimited('\t', "1\t255", bytes).hasValue());
+  EXPECT_EQ((std::vector<uint8_t>{1, 255}), bytes);
+  bytes.clear();
+  EXPECT_EQ(
+      ConversionCode::POSITIVE_OVERFLOW,
+      tryToDelimited('\t', "1\t256", bytes).error());
+  EXPECT_EQ((std::vector<uint8_t>{1}), bytes);
+
+  out.clear();
+  EXPECT_EQ(
+      ConversionCode::NON_WHITESPACE_AFTER_END,
+      tryToDelimited(',', "1,2x,3", out).error());
+  EXPECT_EQ(
+      ConversionCode::EMPTY_INPUT_STRING,
+      tryToDelimited(',', "1,", out).error());
+  EXPECT_EQ(
+      ConversionCode::NON_DIGIT_CHAR,
+      tryToDelimited(',', "1,,2", out).error());
+  // the empty field is not skipped as leading whitespace
+  bytes.clear();
+  EXPECT_EQ(
+      ConversionCode::NON_DIGIT_CHAR,
+      tryToDelimited('\t', "1\t\t2", bytes).error());
+  EXPECT_EQ((std::vector<uint8_t>{1}), bytes);
+  bytes.clear();
+  EXPECT_TRUE(tryToDelimited('\t', " 1 \t 2 ", bytes).hasValue());
+  EXPECT_EQ((std::vector<uint8_t>{1, 2}), bytes);
+}
+
 TEST(Conv, FBStringToString) {
   fbstring foo("foo");
   string ret = to<string>(foo);
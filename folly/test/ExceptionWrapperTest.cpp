@@ -530,6 +530,18 @@ TEST(ExceptionWrapper, base_derived_non_std_exception_test) {
   EXPECT_TRUE(ew.with_exception([](const DerivedException&) {}));
 }
 
+TEST(ExceptionWrapper, base_derived_non_std_exception_ptr_test) {
+  auto ew = exception_wrapper::from_exception_ptr(
+      std::make_exception_ptr(DerivedException{}));
+  EXPECT_TRUE(ew.type() == exception_wrapper::unknown());
+  EXPECT_TRUE(ew.is_compatible_with<BaseException>());
+  EXPECT_TRUE(ew.is_compatible_with<DerivedException>());
+  EXPECT_FALSE(ew.is_compatible_with<int>());
+  EXPECT_FALSE(ew.is_compatible_with<std::exception>());
+  EXPECT_TRUE(ew.with_exception([](const BaseException&) {}));
+  EXPECT_THROW(ew.throw_exception(), DerivedException);
+}
+
 namespace {
 // Cannot be stored within an exception_wrapper
 struct BigRuntimeError : std::runtime_error {
@@ -16,6 +16,8 @@
 
 #include <folly/Fingerprint.h>
 
+#include <string>
+
 #include <glog/logging.h>
 
 #include <folly/Benchmark.h>
@@ -49,6 +51,81 @@ TEST(Fingerprint, BroderOptimization) {
   EXPECT_EQ(slow[1], fast[1]);
 }
 
+TEST(Fingerprint, BulkUpdate) {
+  // update(StringPiece) consumes 8 bytes at a time; check that it matches
+  // update8 for lengths that are not multiples of 8.
+  std::string str;
+  for (int i = 0; i < 77; i++) {
+    str.push_back(char(i * 37 + 11));
+  }
+  for (size_t len = 0; len <= str.size(); len++) {
+    StringPiece sp(str.data(), len);
+    uint64_t bulk[2];
+    uint64_t slow[2];
+    Fingerprint<128>().update(sp).write(bulk);
+    Fingerprint<128> fp;
+    for (auto c : sp) {
+      fp.update8(uint8_t(c));
+    }
+    fp.write(slow);
+    EXPECT_EQ(slow[0], bulk[0]) << len;
+    EXPECT_EQ(slow[1], bulk[1]) << len;
+  }
+}
+
+template <int BITS>
+void checkRollingFingerprint() {
+  constexpr size_t kWindow = 16;
+  std::string str;
+  for (int i = 0; i < 200; i++) {
+    str.push_back(char((i * i * 131 + i) >> 3));
+  }
+  auto bytes = ByteRange(StringPiece(str));
+
+  RollingFingerprint<BITS> rolling(kWindow);
+  EXPECT_EQ(kWindow, rolling.windowSize());
+  for (size_t i = 0; i < bytes.size(); i++) {
+    rolling.roll(bytes[i]);
+    EXPECT_EQ(i + 1 >= kWindow, rolling.full());
+    if (i + 1 < kWindow) {
+      continue;
+    }
+    // Same value as fingerprinting just the window from scratch.
+    RollingFingerprint<BITS> fresh(kWindow);
+    fresh.update(bytes.subpiece(i + 1 - kWindow, kWindow));
+    uint64_t a[2] = {0, 0};
+    uint64_t b[2] = {0, 0};
+    rolling.write(a);
+    fresh.write(b);
+    ASSERT_EQ(b[0], a[0]) << i;
+    ASSERT_EQ(b[1], a[1]) << i;
+    EXPECT_EQ(a[0], rolling.high64());
+  }
+
+  // Equal windows hash equally regardless of what preceded them, and
+  // differing windows (almost always) differ.
+  RollingFingerprint<BITS> x(kWindow);
+  RollingFingerprint<BITS> y(kWindow);
+  x.update(bytes.subpiece(0, 100));
+  y.update(bytes.subpiece(50, 50));
+  EXPECT_EQ(x.high64(), y.high64());
+  y.roll(0);
+  EXPECT_NE(x.high64(), y.high64());
+
+  x.reset();
+  EXPECT_FALSE(x.full());
+  x.update(bytes.subpiece(50, 50));
+  y.reset();
+  y.update(bytes.subpiece(50, 50));
+  EXPECT_EQ(x.high64(), y.high64());
+}
+
+TEST(Fingerprint, Rolling) {
+  checkRollingFingerprint<64>();
+  checkRollingFingerprint<96>();
+  checkRollingFingerprint<128>();
+}
+
 TEST(Fingerprint, MultiByteUpdate) {
   // Test that the multi-byte update functions (update32, update64,
   // update(StringPiece)) produce the same result as calling update8
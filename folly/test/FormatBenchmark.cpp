@@ -101,6 +101,25 @@ BENCHMARK_RELATIVE(intAppend_format) {
 
 BENCHMARK_DRAW_LINE();
 
+#if __cpp_nontype_template_parameter_auto >= 201606L && \
+    __cpp_if_constexpr >= 201606L
+constexpr auto kCounterName = makeFixedString("{}.{}.count");
+
+BENCHMARK(counterName_sformat, iters) {
+  while (iters--) {
+    doNotOptimizeAway(sformat("{}.{}.count", "service", iters));
+  }
+}
+
+BENCHMARK_RELATIVE(counterName_sformatFixedString, iters) {
+  while (iters--) {
+    doNotOptimizeAway(sformat<kCounterName>("service", iters));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+#endif
+
 template <size_t... Indexes>
 int snprintf20Numbers(int i, std::index_sequence<Indexes...>) {
   static_assert(20 == sizeof...(Indexes), "Must have exactly 20 indexes");
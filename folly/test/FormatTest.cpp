@@ -19,6 +19,7 @@
 #include <folly/portability/GTest.h>
 
 #include <string>
+#include <vector>
 
 using namespace folly;
 
@@ -574,3 +575,33 @@ TEST(Format, NoncopyableArg) {
     EXPECT_EQ(fmt.str(), "1");
   }
 }
+
+#if __cpp_nontype_template_parameter_auto >= 201606L && \
+    __cpp_if_constexpr >= 201606L
+namespace {
+constexpr auto kCounterName = folly::makeFixedString("{}.{}.count");
+constexpr auto kEscaped = folly::makeFixedString("{{{}}} }}{{");
+constexpr auto kSpecs = folly::makeFixedString("{:>5}|{:08.3f}|{:#x}|{}");
+constexpr auto kExplicit = folly::makeFixedString("{1} {0[1]} {1}");
+constexpr auto kNoArgs = folly::makeFixedString("plain");
+constexpr auto kEmpty = folly::makeFixedString("");
+constexpr auto kBadSpec = folly::makeFixedString("{:d}");
+} // namespace
+
+TEST(Format, FixedString) {
+  EXPECT_EQ("svc.get.count", sformat<kCounterName>("svc", std::string("get")));
+  EXPECT_EQ("{42} }{", sformat<kEscaped>(42));
+  EXPECT_EQ(
+      "   ab|0003.142|0xff|true", sformat<kSpecs>("ab", 3.14159, 255, true));
+  std::vector<int> v{1, 2};
+  EXPECT_EQ("x 2 x", sformat<kExplicit>(v, 'x'));
+  EXPECT_EQ("plain", sformat<kNoArgs>());
+  EXPECT_EQ("", sformat<kEmpty>());
+  // Same output as the runtime-parsed format string
+  EXPECT_EQ(
+      sformat(kSpecs.c_str(), "ab", 3.14159, 255, true),
+      sformat<kSpecs>("ab", 3.14159, 255, true));
+  // Format specs are still checked when formatting
+  EXPECT_THROW(sformat<kBadSpec>("str"), BadFormatArg);
+}
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/IPPrefixTable.h>
+
+#include <random>
+#include <string>
+
+#include <folly/portability/GTest.h>
+
+using namespace folly;
+
+namespace {
+
+using Table = IPPrefixTable<std::string>;
+
+std::string lookup(const Table& table, StringPiece addr) {
+  auto value = table.lookup(IPAddress(addr));
+  return value ? *value : "none";
+}
+
+} // namespace
+
+TEST(IPPrefixTable, Empty) {
+  Table table;
+  EXPECT_EQ(0, table.size());
+  EXPECT_EQ("none", lookup(table, "10.0.0.1"));
+  EXPECT_EQ("none", lookup(Table::Builder().build(), "::1"));
+}
+
+TEST(IPPrefixTable, LongestMatch) {
+  auto table = Table::Builder()
+                   .insert(IPAddress::createNetwork("0.0.0.0/0"), "v4 default")
+                   .insert(IPAddress::createNetwork("10.0.0.0/8"), "10/8")
+                   .insert(IPAddress::createNetwork("10.1.0.0/16"), "10.1/16")
+                   .insert(IPAddress::createNetwork("10.1.2.3/32"), "host")
+                   .insert(IPAddress::createNetwork("10.1.2.0/23"), "23")
+                   .insert(IPAddress::createNetwork("2001:db8::/32"), "db8")
+                   .insert(IPAddress::createNetwork("2001:db8::1/128"), "v6")
+                   .build();
+  EXPECT_EQ(7, table.size());
+  EXPECT_EQ("v4 default", lookup(table, "192.168.0.1"));
+  EXPECT_EQ("10/8", lookup(table, "10.2.0.1"));
+  EXPECT_EQ("10.1/16", lookup(table, "10.1.4.1"));
+  EXPECT_EQ("23", lookup(table, "10.1.3.255"));
+  EXPECT_EQ("23", lookup(table, "10.1.2.2"));
+  EXPECT_EQ("host", lookup(table, "10.1.2.3"));
+  EXPECT_EQ("db8", lookup(table, "2001:db8::2"));
+  EXPECT_EQ("v6", lookup(table, "2001:db8::1"));
+  EXPECT_EQ("none", lookup(table, "2001:db9::1"));
+  // Families are matched separately.
+  EXPECT_EQ("none", lookup(table, "::ffff:10.1.2.3"));
+}
+
+TEST(IPPrefixTable, Overwrite) {
+  auto table =
+      Table::Builder()
+          // Host bits are ignored.
+          .insert(IPAddress::createNetwork("10.1.2.3/8", -1, false), "first")
+          .insert(IPAddress::createNetwork("10.0.0.0/8"), "second")
+          .build();
+  EXPECT_EQ(1, table.size());
+  EXPECT_EQ("second", lookup(table, "10.9.9.9"));
+}
+
+TEST(IPPrefixTable, InvalidNetwork) {
+  Table::Builder builder;
+  EXPECT_THROW(
+      builder.insert(CIDRNetwork(IPAddress("10.0.0.0"), 33), "x"),
+      std::invalid_argument);
+  EXPECT_THROW(
+      builder.insert(CIDRNetwork(IPAddress(), 0), "x"), std::invalid_argument);
+}
+
+TEST(IPPrefixTable, MatchesInSubnet) {
+  // Compare against checking every network with inSubnet(), with prefixes
+  // clustered so that they nest and share trie nodes.
+  std::mt19937 rng(1);
+  auto randomV6 = [&] {
+    ByteArray16 bytes{};
+    bytes[0] = 0x20;
+    bytes[1] = uint8_t(rng() % 4);
+    for (size_t i = 2; i < 16; ++i) {
+      bytes[i] = uint8_t(rng() % 4 == 0 ? rng() : 0);
+    }
+    return IPAddress(IPAddressV6(bytes));
+  };
+  auto randomV4 = [&] {
+    return IPAddress(IPAddressV4::fromLongHBO(
+        uint32_t(0x0a000000 | (rng() & 0x00ff00ff) | (rng() % 3 << 8))));
+  };
+
+  std::vector<CIDRNetwork> networks;
+  Table::Builder builder;
+  for (size_t i = 0; i < 2000; ++i) {
+    auto addr = i % 2 ? randomV6() : randomV4();
+    auto length = uint8_t(rng() % (addr.bitCount() + 1));
+    CIDRNetwork network(addr.mask(length), length);
+    networks.push_back(network);
+    builder.insert(network, IPAddress::networkToString(network));
+  }
+  auto table = builder.build();
+
+  for (size_t i = 0; i < 20000; ++i) {
+    auto addr = i % 2 ? randomV6() : randomV4();
+    const CIDRNetwork* best = nullptr;
+    for (auto const& network : networks) {
+      if (network.first.isV4() == addr.isV4() &&
+          addr.inSubnet(network.first, network.second) &&
+          (!best || network.second > best->second)) {
+        best = &network;
+      }
+    }
+    auto value = table.lookup(addr);
+    ASSERT_EQ(best != nullptr, value != nullptr) << addr;
+    if (best) {
+      EXPECT_EQ(IPAddress::networkToString(*best), *value) << addr;
+    }
+  }
+}
+
+TEST(IPPrefixTable, AtomicUpdate) {
+  AtomicIPPrefixTable<std::string> table;
+  auto before = table.snapshot();
+  EXPECT_EQ("none", lookup(*before, "10.0.0.1"));
+
+  table.update(Table::Builder()
+                   .insert(IPAddress::createNetwork("10.0.0.0/8"), "10/8")
+                   .build());
+  EXPECT_EQ("10/8", lookup(*table.snapshot(), "10.0.0.1"));
+  // Earlier snapshots stay valid and unchanged.
+  EXPECT_EQ("none", lookup(*before, "10.0.0.1"));
+}
@@ -247,6 +247,68 @@ TEST(IndexedMemPool, no_data_races) {
   }
 }
 
+TEST(IndexedMemPool, large_capacity) {
+  // the address space is reserved upfront, but memory is only committed
+  // as elements are allocated
+  using Pool = IndexedMemPool<uint64_t, 32, 200>;
+  Pool pool(uint32_t(1) << 31);
+  std::vector<uint32_t> indexes;
+  for (uint64_t i = 0; i < 100000; ++i) {
+    uint32_t idx = pool.allocIndex();
+    ASSERT_NE(idx, 0u);
+    pool[idx] = i;
+    indexes.push_back(idx);
+  }
+  for (uint64_t i = 0; i < indexes.size(); ++i) {
+    EXPECT_EQ(i, pool[indexes[i]]);
+    EXPECT_EQ(indexes[i], pool.locateElem(&pool[indexes[i]]));
+  }
+  EXPECT_LE(pool.maxAllocatedIndex(), 100000u);
+}
+
+TEST(IndexedMemPool, cross_thread_recycle) {
+  // elements are recycled by other threads than the ones which allocated
+  // them, going through the global lists in bulk
+  const uint32_t poolSize = 1000;
+  const int nthreads = 8;
+  using Pool = IndexedMemPool<int, 4, 64>;
+  Pool pool(poolSize);
+
+  std::vector<std::vector<uint32_t>> allocated(nthreads);
+  std::vector<std::thread> thr(nthreads);
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < nthreads; ++i) {
+      thr[i] = std::thread([&, i]() {
+        // recycle what the previous thread allocated in the previous round
+        for (auto idx : allocated[(i + 1) % nthreads]) {
+          EXPECT_EQ(pool[idx], (i + 1) % nthreads);
+          pool.recycleIndex(idx);
+        }
+        allocated[(i + 1) % nthreads].clear();
+        for (uint32_t j = 0; j < poolSize / nthreads / 2; ++j) {
+          uint32_t idx = pool.allocIndex();
+          EXPECT_NE(idx, 0u);
+          pool[idx] = i;
+          allocated[i].push_back(idx);
+        }
+      });
+      thr[i].join();
+    }
+  }
+
+  // every element can still be reached from a single thread
+  for (auto& indexes : allocated) {
+    for (auto idx : indexes) {
+      pool.recycleIndex(idx);
+    }
+  }
+  uint32_t count = 0;
+  while (pool.allocIndex() != 0) {
+    ++count;
+  }
+  EXPECT_GE(count, poolSize);
+}
+
 std::atomic<int> cnum{0};
 std::atomic<int> dnum{0};
 
@@ -15,6 +15,7 @@
  */
 
 #include <folly/json.h>
+#include <folly/json_simd.h>
 
 #include <folly/Benchmark.h>
 #include <folly/Conv.h>
@@ -162,6 +163,52 @@ BENCHMARK(parseBigString, iters) {
   }
 }
 
+namespace {
+
+// an array of small config objects
+const std::string& largeDocument() {
+  static const std::string json = [] {
+    dynamic array = dynamic::array;
+    for (int i = 0; i < 1000; ++i) {
+      array.push_back(dynamic::object("id", i)("name", "service name")(
+          "weight", 0.5 * i)("enabled", i % 2 == 0)(
+          "tags", dynamic::array("a", "b\\n", "c")));
+    }
+    return toJson(array);
+  }();
+  return json;
+}
+
+} // namespace
+
+BENCHMARK(parseLargeDocument, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(parseJson(largeDocument()));
+  }
+}
+
+BENCHMARK_RELATIVE(parseLargeDocumentSimd, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(folly::parseJsonSimd(largeDocument()));
+  }
+}
+
+BENCHMARK_RELATIVE(lazyReadOneField, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::json::lazy_document doc(largeDocument());
+    folly::doNotOptimizeAway(doc.root()[500]["weight"].asDouble());
+  }
+}
+
+BENCHMARK_RELATIVE(parseLargeDocumentArena, iters) {
+  for (size_t i = 0; i < iters; ++i) {
+    folly::json::arena_document doc(largeDocument());
+    folly::doNotOptimizeAway(doc.root().size());
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK(toJson, iters) {
   dynamic something = parseJson(
       "{\"old_value\":40,\"changed\":true,\"opened\":false,\"foo\":[1,2,3,4,5,6]}");
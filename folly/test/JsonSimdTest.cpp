@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json_simd.h>
+
+#include <cmath>
+
+#include <folly/portability/GTest.h>
+
+using folly::dynamic;
+using folly::parseJson;
+using folly::parseJsonSimd;
+using folly::StringPiece;
+using folly::json::arena_document;
+using folly::json::lazy_document;
+using folly::json::parse_error;
+using folly::json::serialization_opts;
+
+namespace {
+
+// parseJsonSimd() must return what parseJson() returns, or throw the same
+// error.
+void checkSame(StringPiece json, serialization_opts const& opts) {
+  SCOPED_TRACE(json);
+  dynamic expected;
+  std::string expectedError;
+  try {
+    expected = parseJson(json, opts);
+  } catch (std::exception const& e) {
+    expectedError = e.what();
+  }
+  try {
+    auto actual = parseJsonSimd(json, opts);
+    EXPECT_EQ("", expectedError);
+    EXPECT_EQ(expected, actual);
+  } catch (std::exception const& e) {
+    EXPECT_EQ(expectedError, e.what());
+  }
+}
+
+void checkSame(StringPiece json) {
+  checkSame(json, serialization_opts());
+}
+
+const char* const kDocument = R"({
+  "name": "config",
+  "version": 12,
+  "ratio": -0.25e-3,
+  "enabled": true,
+  "parent": null,
+  "tags": ["a", "b\"c", "\u00e9\uD834\uDD1E", ""],
+  "limits": {"cpu": 4.5, "memory": 123456789012, "empty": {}, "none": []},
+  "path": "C:\\dir\\file",
+  "nested": [[1, [2, [3]]], {"x": [{"y": "z"}]}]
+})";
+
+} // namespace
+
+TEST(JsonSimd, SameAsParseJson) {
+  checkSame(kDocument);
+  for (auto json : {
+           "1",
+           "-12",
+           "0.5",
+           "1e10",
+           "\"str\"",
+           "true",
+           "null",
+           "[]",
+           "{}",
+           "  [ 1 , 2 ]  ",
+           "9223372036854775807",
+           "-9223372036854775808",
+           "Infinity",
+           "-Infinity",
+       }) {
+    checkSame(json);
+  }
+  checkSame(StringPiece("[1,2]\0garbage", 13));
+  EXPECT_TRUE(std::isnan(parseJsonSimd("NaN").asDouble()));
+}
+
+TEST(JsonSimd, Errors) {
+  for (auto json : {
+           "",
+           "   ",
+           "[1,2",
+           "[1,]",
+           "{\"a\" 1}",
+           "{\"a\":1,}",
+           "{1:2}",
+           "[1 2]",
+           "\"unterminated",
+           "\"bad \\x escape\"",
+           "\"\\uD834 lone surrogate\"",
+           "[tru]",
+           "[1true]",
+           "-",
+           "1.5.3",
+           "[1]]",
+           "]",
+           "9223372036854775808",
+           "{\"a\":1}x",
+       }) {
+    checkSame(json);
+  }
+}
+
+TEST(JsonSimd, Options) {
+  serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  checkSame("[1,2,]", opts);
+  checkSame("{\"a\":1,}", opts);
+
+  opts = serialization_opts();
+  opts.allow_non_string_keys = true;
+  checkSame("{1:2, \"a\":[3]}", opts);
+
+  opts = serialization_opts();
+  opts.parse_numbers_as_strings = true;
+  checkSame("[1, -2.5, 3e4, Infinity, -Infinity, NaN]", opts);
+
+  opts = serialization_opts();
+  opts.double_fallback = true;
+  checkSame("[9223372036854775808, -9223372036854775809]", opts);
+
+  opts = serialization_opts();
+  opts.recursion_limit = 3;
+  checkSame("[[[1]]]", opts);
+  checkSame("[[[[1]]]]", opts);
+}
+
+TEST(JsonSimd, BlockBoundaries) {
+  // escapes, strings and numbers across the 64 byte blocks
+  for (size_t i = 0; i < 140; ++i) {
+    std::string padding(i, ' ');
+    checkSame(padding + "[\"" + std::string(i, 'a') + "\\\\\\\"\", 1]");
+    checkSame(padding + "[\"" + std::string(i, 'a') + "\\\\\", 123456]");
+    checkSame("[" + padding + "12345678, \"" + padding + "\"]");
+    checkSame(padding + "{\"k\\\"" + std::string(i, '\\') + "\":" + "1}");
+  }
+}
+
+TEST(JsonSimd, Mutations) {
+  std::string json = kDocument;
+  for (size_t i = 0; i < json.size(); ++i) {
+    for (char c : StringPiece(" ,:{}[]\"\\a1-e.")) {
+      auto mutated = json;
+      mutated[i] = c;
+      checkSame(mutated);
+    }
+  }
+}
+
+TEST(JsonSimd, Lazy) {
+  lazy_document doc(kDocument);
+  auto root = doc.root();
+  EXPECT_TRUE(root.isObject());
+  EXPECT_EQ(9, root.size());
+  EXPECT_EQ("config", root["name"].asString());
+  EXPECT_EQ(12, root["version"].asInt());
+  EXPECT_EQ(dynamic::INT64, root["version"].type());
+  EXPECT_EQ(-0.25e-3, root["ratio"].asDouble());
+  EXPECT_EQ(dynamic::DOUBLE, root["ratio"].type());
+  EXPECT_EQ(12.0, root["version"].asDouble());
+  EXPECT_TRUE(root["enabled"].asBool());
+  EXPECT_TRUE(root["parent"].isNull());
+  EXPECT_EQ("C:\\dir\\file", root["path"].asString());
+
+  auto tags = root["tags"];
+  ASSERT_TRUE(tags.isArray());
+  EXPECT_EQ(4, tags.size());
+  EXPECT_EQ("b\"c", tags[1].asString());
+  EXPECT_EQ(u8"\u00e9\U0001D11E", tags[2].asString());
+  EXPECT_EQ("", tags[3].asString());
+  EXPECT_THROW(tags[4], std::out_of_range);
+
+  EXPECT_EQ("z", root["nested"][1]["x"][0]["y"].asString());
+  EXPECT_EQ(3, root["nested"][0][1][1][0].asInt());
+  EXPECT_EQ(0, root["limits"]["empty"].size());
+  EXPECT_EQ(0, root["limits"]["none"].size());
+  EXPECT_EQ("[3]", root["nested"][0][1][1].raw());
+
+  EXPECT_FALSE(root.find("missing"));
+  EXPECT_THROW(root["missing"], std::out_of_range);
+  EXPECT_THROW(root["name"].asInt(), folly::TypeError);
+  EXPECT_THROW(root["tags"]["a"], folly::TypeError);
+  EXPECT_THROW(root["name"][0], folly::TypeError);
+
+  std::vector<std::string> keys;
+  root["limits"].forEachItem(
+      [&](std::string key, folly::json::lazy_value) { keys.push_back(key); });
+  EXPECT_EQ(
+      (std::vector<std::string>{"cpu", "memory", "empty", "none"}), keys);
+  size_t count = 0;
+  tags.forEachElement([&](folly::json::lazy_value value) {
+    EXPECT_TRUE(value.isString());
+    ++count;
+  });
+  EXPECT_EQ(4, count);
+
+  EXPECT_EQ(parseJson(kDocument), root.toDynamic());
+  EXPECT_EQ(parseJson(kDocument)["limits"], root["limits"].toDynamic());
+}
+
+TEST(JsonSimd, LazyErrors) {
+  EXPECT_THROW(lazy_document(""), parse_error);
+  EXPECT_THROW(lazy_document("[1, 2"), parse_error);
+  EXPECT_THROW(lazy_document("[1, 2}"), parse_error);
+  EXPECT_THROW(lazy_document("\"abc"), parse_error);
+  EXPECT_THROW(lazy_document("[1] 2"), parse_error);
+
+  // only found when the values are read
+  lazy_document doc("{\"a\": [1 2], \"b\": {\"c\" 1}, \"d\": [1,], \"e\": x}");
+  EXPECT_NO_THROW(doc.root()["a"]);
+  EXPECT_THROW(doc.root()["a"].size(), parse_error);
+  EXPECT_THROW(doc.root()["b"]["c"], parse_error);
+  EXPECT_THROW(doc.root()["d"].size(), parse_error);
+  EXPECT_THROW(doc.root()["e"].toDynamic(), parse_error);
+  EXPECT_THROW(doc.root()["a"].toDynamic(), parse_error);
+}
+
+TEST(JsonSimd, Arena) {
+  arena_document doc(kDocument);
+  EXPECT_EQ(parseJson(kDocument), doc.root().toDynamic());
+  EXPECT_GT(doc.totalSize(), 0);
+
+  auto& root = doc.root();
+  EXPECT_TRUE(root.isObject());
+  EXPECT_EQ(9, root.size());
+  EXPECT_EQ("config", root["name"].asString());
+  EXPECT_EQ(12, root["version"].asInt());
+  EXPECT_EQ(12.0, root["version"].asDouble());
+  EXPECT_TRUE(root["enabled"].asBool());
+  EXPECT_TRUE(root["parent"].isNull());
+  EXPECT_EQ("b\"c", root["tags"][1].asString());
+  EXPECT_EQ("C:\\dir\\file", root["path"].asString());
+  EXPECT_EQ(123456789012, root["limits"]["memory"].asInt());
+  EXPECT_EQ(0, root["limits"]["empty"].size());
+  EXPECT_EQ(0, root["limits"]["none"].elements().size());
+  EXPECT_EQ("z", root["nested"][1]["x"][0]["y"].asString());
+  EXPECT_EQ(nullptr, root.get_ptr("missing"));
+  EXPECT_THROW(root["missing"], std::out_of_range);
+  EXPECT_THROW(root["tags"][4], std::out_of_range);
+  EXPECT_THROW(root["name"].asInt(), folly::TypeError);
+  EXPECT_THROW(root["version"].size(), folly::TypeError);
+
+  for (auto json : {"1", "\"\"", "[]", "{}", "[[], {}, \"\", null]"}) {
+    EXPECT_EQ(parseJson(json), arena_document(json).root().toDynamic());
+  }
+}
+
+TEST(JsonSimd, ArenaLookup) {
+  // the last item wins, as in a dynamic, but all of them are kept
+  arena_document small("{\"a\": 1, \"b\": 2, \"a\": 3}");
+  EXPECT_EQ(3, small.root()["a"].asInt());
+  ASSERT_EQ(3, small.root().items().size());
+  EXPECT_EQ("a", small.root().items()[0].key);
+  EXPECT_EQ(1, small.root().items()[0].value.asInt());
+
+  // large enough to be searched by key
+  dynamic expected = dynamic::object;
+  std::string json = "{";
+  for (int i = 0; i < 100; ++i) {
+    auto key = folly::to<std::string>("key", i % 50);
+    expected[key] = i;
+    json += folly::to<std::string>(i ? "," : "", "\"", key, "\":", i);
+  }
+  json += "}";
+  arena_document large(json);
+  EXPECT_EQ(100, large.root().size());
+  EXPECT_EQ(expected, large.root().toDynamic());
+  for (auto& item : expected.items()) {
+    EXPECT_EQ(item.second.asInt(), large.root()[item.first.asString()].asInt());
+  }
+  EXPECT_EQ(nullptr, large.root().get_ptr("key"));
+  EXPECT_EQ(nullptr, large.root().get_ptr("key99"));
+}
+
+TEST(JsonSimd, ArenaErrors) {
+  for (auto json : {"", "[1,2", "{\"a\" 1}", "\"\\x\"", "[1] 2"}) {
+    SCOPED_TRACE(json);
+    std::string expected;
+    try {
+      parseJson(json);
+    } catch (parse_error const& e) {
+      expected = e.what();
+    }
+    try {
+      arena_document doc(json);
+      ADD_FAILURE();
+    } catch (parse_error const& e) {
+      EXPECT_EQ(expected, e.what());
+    }
+  }
+
+  serialization_opts opts;
+  opts.allow_non_string_keys = true;
+  EXPECT_THROW(arena_document("{1: 2}", opts), folly::TypeError);
+  opts.parse_numbers_as_strings = true;
+  arena_document strings("[1.50]", opts);
+  EXPECT_EQ("1.50", strings.root()[0].asString());
+}
@@ -16,9 +16,13 @@
 
 #include <folly/json.h>
 
+#include <cmath>
 #include <iterator>
 #include <limits>
+#include <vector>
 
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/portability/GTest.h>
 
 using folly::dynamic;
@@ -574,6 +578,13 @@ TEST(Json, UTF8Validation) {
   EXPECT_ANY_THROW(folly::json::serialize("a\xe0\xa0\x80z\xc0\x80", opts));
   EXPECT_ANY_THROW(folly::json::serialize("a\xe0\xa0\x80z\xe0\x80\x80", opts));
 
+  // Longer strings are validated several bytes at a time.
+  const std::string pad(40, 'a');
+  EXPECT_EQ(
+      folly::json::serialize(pad + "\xe2\x82\xac\"" + pad, opts),
+      "\"" + pad + "\xe2\x82\xac\\\"" + pad + "\"");
+  EXPECT_ANY_THROW(folly::json::serialize(pad + "\xed\xa0\x80" + pad, opts));
+
   opts.skip_invalid_utf8 = true;
   EXPECT_EQ(
       folly::json::serialize("a\xe0\xa0\x80z\xc0\x80", opts),
@@ -946,3 +957,236 @@ TEST(Json, CharsToUnicodeEscape) {
       (1UL << 63) | (1UL << 36) | (1UL << 33),
       (1UL << (64 - 64)) | (1UL << (93 - 64)));
 }
+
+TEST(Json, SerializeToIOBuf) {
+  dynamic value = dynamic::object("a", dynamic::array(1, 2.5, "three"))(
+      "b", dynamic::object("c", nullptr)("d", true))(
+      "long", std::string(100, 'x'))("escaped", "\"\\\né");
+  for (bool pretty : {false, true}) {
+    folly::json::serialization_opts opts;
+    opts.pretty_formatting = pretty;
+    opts.sort_keys = true;
+    auto expected = folly::json::serialize(value, opts);
+
+    // buffers smaller than most tokens
+    folly::IOBufQueue queue;
+    folly::json::serialize(value, opts, queue, 7);
+    EXPECT_GT(queue.front()->countChainElements(), 1);
+    EXPECT_EQ(expected, queue.move()->moveToFbString().toStdString());
+
+    auto buf = folly::IOBuf::create(0);
+    folly::io::Appender appender(buf.get(), 16);
+    folly::json::serialize(value, opts, appender);
+    EXPECT_EQ(expected, buf->moveToFbString().toStdString());
+  }
+}
+
+TEST(Json, ParseIOBuf) {
+  std::string json =
+      "{\"a\": [1, -2.5e3, 12345678901, \"th\\u00e9\\uD834\\uDD1E\"],\n"
+      " \"b\" : {\"c\": null, \"d\": true, \"e\": false},\n"
+      " \"long\": \"" +
+      std::string(100, 'x') + "\", \"n\": -Infinity}  ";
+  auto expected = parseJson(json);
+
+  // split at every position, with an empty buffer in the middle
+  for (size_t i = 0; i <= json.size(); ++i) {
+    auto buf = folly::IOBuf::copyBuffer(json.data(), i);
+    buf->prependChain(folly::IOBuf::create(0));
+    buf->prependChain(
+        folly::IOBuf::copyBuffer(json.data() + i, json.size() - i));
+    EXPECT_EQ(expected, parseJson(*buf)) << i;
+  }
+
+  // one byte per buffer
+  folly::IOBufQueue queue;
+  for (char c : json) {
+    queue.append(folly::IOBuf::copyBuffer(&c, 1));
+  }
+  EXPECT_EQ(expected, parseJson(*queue.front()));
+
+  auto error = folly::IOBuf::copyBuffer("[1, ");
+  error->prependChain(folly::IOBuf::copyBuffer("tru"));
+  EXPECT_THROW(parseJson(*error), parse_error);
+  error = folly::IOBuf::copyBuffer("[1]");
+  error->prependChain(folly::IOBuf::copyBuffer(" x"));
+  EXPECT_THROW(parseJson(*error), parse_error);
+}
+
+namespace {
+
+// Rebuilds the document from the events of a stream_parser.
+class DynamicBuilder : public folly::json::event_handler {
+ public:
+  void onObjectStart() override {
+    stack_.push_back(dynamic::object);
+  }
+  void onKey(folly::StringPiece key) override {
+    keys_.push_back(key.str());
+  }
+  void onObjectEnd() override {
+    pop();
+  }
+  void onArrayStart() override {
+    stack_.push_back(dynamic::array);
+  }
+  void onArrayEnd() override {
+    pop();
+  }
+  void onString(folly::StringPiece value) override {
+    add(value);
+  }
+  void onInt(int64_t value) override {
+    add(value);
+  }
+  void onDouble(double value) override {
+    add(value);
+  }
+  void onBool(bool value) override {
+    add(value);
+  }
+  void onNull() override {
+    add(nullptr);
+  }
+
+  dynamic result;
+
+ private:
+  void pop() {
+    auto value = std::move(stack_.back());
+    stack_.pop_back();
+    add(std::move(value));
+  }
+
+  void add(dynamic value) {
+    if (stack_.empty()) {
+      result = std::move(value);
+    } else if (stack_.back().isArray()) {
+      stack_.back().push_back(std::move(value));
+    } else {
+      stack_.back()[keys_.back()] = std::move(value);
+      keys_.pop_back();
+    }
+  }
+
+  std::vector<dynamic> stack_;
+  std::vector<std::string> keys_;
+};
+
+dynamic parseStream(
+    folly::StringPiece json,
+    size_t chunk,
+    folly::json::serialization_opts const& opts) {
+  DynamicBuilder builder;
+  folly::json::stream_parser parser(builder, opts);
+  for (size_t i = 0; i < json.size(); i += chunk) {
+    parser.feed(json.subpiece(i, chunk));
+  }
+  parser.finish();
+  return builder.result;
+}
+
+dynamic parseStream(folly::StringPiece json, size_t chunk) {
+  return parseStream(json, chunk, folly::json::serialization_opts());
+}
+
+} // namespace
+
+TEST(Json, StreamParser) {
+  std::string large =
+      "{\"a\": [1, -2.5e3, 12345678901, \"th\\u00e9\\uD834\\uDD1E\"],\n"
+      " \"b\" : {\"c\": null, \"d\": true, \"e\": false, \"f\": {}},\n"
+      " \"long\": \"" +
+      std::string(100, 'x') + "\", \"n\": -Infinity, \"o\": [[], [{}]]}  ";
+  for (auto json : {
+           large.c_str(),
+           "1",
+           "-0.5e-3",
+           "\"str\"",
+           "true",
+           "null",
+           "[]",
+           "{}",
+           "  [ 1 , \"a\\\"b\" ]\n",
+           "{\"a\":1, \"a\":2}",
+       }) {
+    for (size_t chunk : {1, 2, 7, 1000}) {
+      EXPECT_EQ(parseJson(json), parseStream(json, chunk))
+          << json << " in chunks of " << chunk;
+    }
+  }
+  EXPECT_EQ(dynamic::array(1, 2), parseStream({"[1,2]\0garbage", 13}, 1));
+  EXPECT_TRUE(std::isnan(parseStream("NaN", 1).asDouble()));
+
+  folly::json::serialization_opts opts;
+  opts.allow_trailing_comma = true;
+  opts.parse_numbers_as_strings = true;
+  auto json = "{\"a\": [1.50, 2,], \"b\": -Infinity,}";
+  EXPECT_EQ(parseJson(json, opts), parseStream(json, 1, opts));
+}
+
+TEST(Json, StreamParserErrors) {
+  for (auto json : {
+           "",
+           "[1,2",
+           "[1,]",
+           "{\"a\" 1}",
+           "{\"a\":1,}",
+           "{1:2}",
+           "[1 2]",
+           "\"unterminated",
+           "\"bad \\x escape\"",
+           "[tru]",
+           "[1true]",
+           "-",
+           "1.5.3",
+           "[1]]",
+           "{\"a\":1}x",
+       }) {
+    EXPECT_THROW(parseJson(json), parse_error) << json;
+    for (size_t chunk : {1, 1000}) {
+      EXPECT_THROW(parseStream(json, chunk), parse_error) << json;
+    }
+  }
+
+  try {
+    parseStream("[1 2]", 1000);
+    ADD_FAILURE();
+  } catch (parse_error const& e) {
+    EXPECT_STREQ(
+        "json parse error on line 0 near `2]': expected ']'", e.what());
+  }
+
+  folly::json::serialization_opts opts;
+  opts.recursion_limit = 3;
+  EXPECT_NO_THROW(parseJson("[[[1]]]", opts));
+  EXPECT_NO_THROW(parseStream("[[[1]]]", 1, opts));
+  EXPECT_THROW(parseJson("[[[[1]]]]", opts), parse_error);
+  EXPECT_THROW(parseStream("[[[[1]]]]", 1, opts), parse_error);
+}
+
+TEST(Json, StreamParserIOBufQueue) {
+  // a document is only held in memory for as long as its bytes are queued
+  DynamicBuilder builder;
+  folly::json::stream_parser parser(builder);
+  folly::IOBufQueue queue;
+  size_t total = 0;
+  dynamic expected = dynamic::array;
+  parser.feed(folly::StringPiece("["));
+  for (int i = 0; i < 1000; ++i) {
+    auto chunk = folly::to<std::string>(i ? "," : "", "{\"i\": ", i, "}");
+    queue.append(folly::IOBuf::copyBuffer(chunk));
+    if (i % 10 == 9) {
+      auto length = queue.front()->computeChainDataLength();
+      EXPECT_LT(length, 200);
+      total += length;
+      parser.feed(queue);
+      EXPECT_TRUE(queue.empty());
+    }
+    expected.push_back(dynamic::object("i", i));
+  }
+  parser.feed(folly::StringPiece("]"));
+  parser.finish();
+  EXPECT_GT(total, 5000);
+  EXPECT_EQ(expected, builder.result);
+}
@@ -76,6 +76,74 @@ TEST(MPMCPipeline, TrivialAmplification) {
   EXPECT_EQ(0, a.sizeGuess());
 }
 
+TEST(MPMCPipeline, Bulk) {
+  MPMCPipeline<int, MPMCPipelineStage<int, 2>> a(10, 10);
+  for (int i = 0; i < 3; ++i) {
+    a.blockingWrite(i);
+  }
+
+  MPMCPipeline<int, MPMCPipelineStage<int, 2>>::Ticket<0> tickets[5];
+  int vals[5];
+  EXPECT_EQ(3, a.blockingReadStageBulk<0>(tickets, vals, 5));
+  EXPECT_EQ(0, vals[0]);
+  EXPECT_EQ(2, vals[2]);
+
+  std::vector<int> out = {0, 1, 10, 11, 20, 21};
+  a.blockingWriteStageBulk<0>(tickets, 3, out.begin());
+
+  for (int expected : out) {
+    int val;
+    a.blockingRead(val);
+    EXPECT_EQ(expected, val);
+  }
+  EXPECT_EQ(0, a.sizeGuess());
+}
+
+TEST(MPMCPipeline, StageStats) {
+  MPMCPipeline<int, MPMCPipelineStage<int, 2>, std::string> a(4, 4, 4);
+  auto stats = a.stageStats<0>();
+  EXPECT_EQ(0, stats.reads);
+  EXPECT_EQ(0, stats.queued);
+
+  a.blockingWrite(1);
+  a.blockingWrite(2);
+  stats = a.stageStats<0>();
+  EXPECT_EQ(2, stats.queued);
+
+  int val;
+  auto ticket = a.blockingReadStage<0>(val);
+  a.blockingWriteStage<0>(ticket, 10);
+  stats = a.stageStats<0>();
+  EXPECT_EQ(1, stats.reads);
+  EXPECT_EQ(1, stats.writes);
+  EXPECT_EQ(1, stats.queued);
+  EXPECT_EQ(1, stats.pending);
+  EXPECT_EQ(1, a.stageStats<1>().queued);
+  a.blockingWriteStage<0>(ticket, 11);
+  EXPECT_EQ(0, a.stageStats<0>().pending);
+  EXPECT_EQ(2, a.stageStats<1>().queued);
+
+  // a reader that has to wait is measured
+  std::thread reader([&] {
+    for (int i = 0; i < 3; ++i) {
+      int v;
+      auto t = a.blockingReadStage<1>(v);
+      a.blockingWriteStage<1>(t, folly::to<std::string>(v));
+    }
+  });
+  int v;
+  auto t = a.blockingReadStage<0>(v);
+  // A blocked reader has taken the ticket of the element it waits for
+  while (a.stageStats<1>().reads < 3) {
+    std::this_thread::yield();
+  }
+  a.blockingWriteStage<0>(t, 20);
+  a.blockingWriteStage<0>(t, 21);
+  reader.join();
+  EXPECT_GT(a.stageStats<1>().readWait.count(), 0);
+  EXPECT_EQ(3, a.stageStats<1>().writes);
+}
+
 TEST(MPMCPipeline, MultiThreaded) {
   constexpr size_t numThreadsPerStage = 6;
   MPMCPipeline<int, std::string, std::string> a(5, 5, 5);
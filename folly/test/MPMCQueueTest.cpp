@@ -204,6 +204,35 @@ TEST(MPMCQueue, single_thread_enqdeq) {
   }
 }
 
+TEST(MPMCQueue, single_thread_batch) {
+  // Non-dynamic version only, batches aren't supported by the dynamic one.
+  MPMCQueue<int> cq(10);
+
+  for (int pass = 0; pass < 10; ++pass) {
+    int src[15];
+    for (int i = 0; i < 15; ++i) {
+      src[i] = i;
+    }
+    EXPECT_EQ(cq.writeBatch(src, 15), 10);
+    EXPECT_EQ(cq.writeBatch(src + 10, 5), 0);
+    EXPECT_EQ(cq.size(), 10);
+
+    int dest[15];
+    EXPECT_EQ(cq.readBatch(dest, 4), 4);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(dest[i], i);
+    }
+    EXPECT_EQ(cq.writeBatch(src + 10, 5), 4);
+    EXPECT_EQ(cq.readBatch(dest, 0), 0);
+    EXPECT_EQ(cq.readBatch(dest, 15), 10);
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_EQ(dest[i], i + 4);
+    }
+    EXPECT_EQ(cq.readBatch(dest, 15), 0);
+    EXPECT_TRUE(cq.isEmpty());
+  }
+}
+
 TEST(MPMCQueue, tryenq_capacity_test) {
   // Non-dynamic version only.
   // False positive for dynamic version. Capacity can be temporarily
@@ -709,6 +738,111 @@ TEST(MPMCQueue, mt_prod_cons_emulated_futex_dynamic) {
   runMtProdConsEmulatedFutex</* Dynamic = */ true>();
 }
 
+template <typename Q>
+string batchProducerConsumerBench(
+    Q&& queue,
+    string qName,
+    int numProducers,
+    int numConsumers,
+    int numOps,
+    size_t batchSize) {
+  Q& q = queue;
+
+  struct rusage beginUsage;
+  getrusage(RUSAGE_SELF, &beginUsage);
+
+  auto beginMicro = nowMicro();
+
+  uint64_t n = numOps;
+  std::atomic<uint64_t> sum(0);
+  std::atomic<uint64_t> consumed(0);
+  std::atomic<uint64_t> failed(0);
+
+  vector<std::thread> producers(numProducers);
+  for (int t = 0; t < numProducers; ++t) {
+    producers[t] = std::thread([&, t] {
+      vector<int> batch;
+      for (int i = t; i < numOps;) {
+        batch.clear();
+        for (; i < numOps && batch.size() < batchSize; i += numProducers) {
+          batch.push_back(i);
+        }
+        for (size_t written = 0; written < batch.size();) {
+          auto count =
+              q.writeBatch(batch.data() + written, batch.size() - written);
+          if (count == 0) {
+            ++failed;
+          }
+          written += count;
+        }
+      }
+    });
+  }
+
+  vector<std::thread> consumers(numConsumers);
+  for (int t = 0; t < numConsumers; ++t) {
+    consumers[t] = std::thread([&] {
+      vector<int> batch(batchSize);
+      uint64_t localSum = 0;
+      while (consumed.load(std::memory_order_relaxed) < n) {
+        auto count = q.readBatch(batch.data(), batchSize);
+        for (size_t i = 0; i < count; ++i) {
+          localSum += batch[i];
+        }
+        consumed += count;
+      }
+      sum += localSum;
+    });
+  }
+
+  for (auto& t : producers) {
+    t.join();
+  }
+  for (auto& t : consumers) {
+    t.join();
+  }
+  EXPECT_EQ(n * (n - 1) / 2 - sum, 0);
+
+  auto endMicro = nowMicro();
+
+  struct rusage endUsage;
+  getrusage(RUSAGE_SELF, &endUsage);
+
+  uint64_t nanosPer = (1000 * (endMicro - beginMicro)) / n;
+  long csw = endUsage.ru_nvcsw + endUsage.ru_nivcsw -
+      (beginUsage.ru_nvcsw + beginUsage.ru_nivcsw);
+  uint64_t failures = failed;
+
+  return folly::sformat(
+      "{}, {} producers, {} consumers, batches of {} => {} nanos/handoff, "
+      "{} csw / {} handoff, {} failures",
+      qName,
+      numProducers,
+      numConsumers,
+      batchSize,
+      nanosPer,
+      csw,
+      n,
+      failures);
+}
+
+TEST(MPMCQueue, mt_prod_cons_batch) {
+  using QueueType = MPMCQueue<int>;
+
+  int n = 100000;
+  setFromEnv(n, "NUM_OPS");
+  for (size_t batchSize : {1, 16, 256}) {
+    LOG(INFO) << batchProducerConsumerBench(
+        QueueType(10000), "MPMCQueue<int>(10000)", 1, 1, n, batchSize);
+    LOG(INFO) << batchProducerConsumerBench(
+        QueueType(10000), "MPMCQueue<int>(10000)", 10, 1, n, batchSize);
+    LOG(INFO) << batchProducerConsumerBench(
+        QueueType(10000), "MPMCQueue<int>(10000)", 1, 10, n, batchSize);
+    LOG(INFO) << batchProducerConsumerBench(
+        QueueType(10000), "MPMCQueue<int>(10000)", 10, 10, n, batchSize);
+  }
+}
+
 template <template <typename> class Atom, bool Dynamic = false>
 void runNeverFailThread(
     int numThreads,
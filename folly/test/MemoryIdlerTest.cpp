@@ -18,8 +18,11 @@
 
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/Unistd.h>
 #include <folly/synchronization/Baton.h>
 
+#include <cstring>
 #include <memory>
 #include <thread>
 
@@ -39,6 +42,33 @@ TEST(MemoryIdler, releaseStackLargeExtra) {
   MemoryIdler::unmapUnusedStack(30000000);
 }
 
+// Platforms where MemoryIdler madvises stacks away
+constexpr bool kCanReleasePages = (kIsArchAmd64 || kIsArchPPC64) &&
+    kIsLinux && !kIsMobile && !kIsSanitizeAddress;
+
+TEST(MemoryIdler, releasePages) {
+  auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto len = 4 * pageSize;
+  void* mem = mmap(
+      nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, mem);
+  auto bytes = static_cast<char*>(mem);
+  memset(bytes, 1, len);
+
+  auto before = MemoryIdler::getStats().stackBytesReleased;
+  // Only the whole pages within the range are released
+  auto released = MemoryIdler::releasePages(bytes + 1, len - 1);
+  if (kCanReleasePages) {
+    EXPECT_EQ(3 * pageSize, released);
+    EXPECT_EQ(1, bytes[pageSize - 1]);
+    EXPECT_EQ(0, bytes[pageSize]);
+    EXPECT_EQ(0, bytes[len - 1]);
+    EXPECT_EQ(before + released, MemoryIdler::getStats().stackBytesReleased);
+  }
+  EXPECT_EQ(0, MemoryIdler::releasePages(bytes + 1, pageSize - 1));
+  munmap(mem, len);
+}
+
 TEST(MemoryIdler, releaseMallocTLS) {
   auto p = new int[4];
   MemoryIdler::flushLocalMallocCaches();
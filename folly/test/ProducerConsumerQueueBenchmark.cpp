@@ -18,9 +18,11 @@
 
 #include <folly/ProducerConsumerQueue.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -73,6 +75,32 @@ struct ThroughputTest {
     }
   }
 
+  void producerBulk(size_t batchSize) {
+    std::vector<ThroughputType> batch(batchSize);
+    for (int i = 0; i < iters_;) {
+      size_t n = std::min(batchSize, size_t(iters_ - i));
+      for (size_t j = 0; j < n; ++j) {
+        batch[j] = ThroughputType(i + j);
+      }
+      size_t written = 0;
+      while (written < n) {
+        written += queue_.writeBulk(batch.begin() + written, n - written);
+      }
+      i += int(n);
+    }
+  }
+
+  void consumerBulk(size_t batchSize) {
+    std::vector<ThroughputType> batch(batchSize);
+    for (int i = 0; i < iters_;) {
+      size_t n = queue_.readBulk(batch.begin(), batchSize);
+      for (size_t j = 0; j < n; ++j) {
+        doNotOptimizeAway(batch[j]);
+      }
+      i += int(n);
+    }
+  }
+
   QueueType queue_;
   std::atomic<bool> done_;
   const int iters_;
@@ -207,6 +235,22 @@ void BM_ProducerConsumerAffinity(int iters, int size) {
   delete test;
 }
 
+void BM_ProducerConsumerBulk(int iters, int batchSize) {
+  BenchmarkSuspender susp;
+  CHECK_GT(batchSize, 0);
+  ThroughputTest<ThroughputQueueType>* test =
+      new ThroughputTest<ThroughputQueueType>(1048574, iters, -1, -1);
+  susp.dismiss();
+
+  std::thread producer([test, batchSize] { test->producerBulk(batchSize); });
+  std::thread consumer([test, batchSize] { test->consumerBulk(batchSize); });
+
+  producer.join();
+  test->done_ = true;
+  consumer.join();
+  delete test;
+}
+
 void BM_ProducerConsumerLatency(int /* iters */, int size) {
   BenchmarkSuspender susp;
   CHECK_GT(size, 0);
@@ -227,6 +271,9 @@ void BM_ProducerConsumerLatency(int /* iters */, int size) {
 BENCHMARK_DRAW_LINE();
 
 BENCHMARK_PARAM(BM_ProducerConsumer, 1048574)
+BENCHMARK_RELATIVE_PARAM(BM_ProducerConsumerBulk, 16)
+BENCHMARK_RELATIVE_PARAM(BM_ProducerConsumerBulk, 64)
+BENCHMARK_RELATIVE_PARAM(BM_ProducerConsumerBulk, 256)
 BENCHMARK_PARAM(BM_ProducerConsumerAffinity, 1048574)
 BENCHMARK_PARAM(BM_ProducerConsumerLatency, 1048574)
 
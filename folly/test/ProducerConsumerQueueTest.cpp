@@ -16,6 +16,8 @@
 
 #include <folly/ProducerConsumerQueue.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -307,3 +309,89 @@ TEST(PCQ, Capacity) {
   folly::ProducerConsumerQueue<int> queue(3);
   EXPECT_EQ(queue.capacity(), 2); // PCQ max size is buffer size - 1.
 }
+
+TEST(PCQ, Bulk) {
+  folly::ProducerConsumerQueue<int> queue(8);
+  std::vector<int> in(20);
+  for (size_t i = 0; i < in.size(); ++i) {
+    in[i] = int(i);
+  }
+
+  EXPECT_EQ(0, queue.writeBulk(in.begin(), 0));
+  EXPECT_EQ(7, queue.writeBulk(in.begin(), in.size())); // capacity is 7
+  EXPECT_TRUE(queue.isFull());
+  EXPECT_EQ(0, queue.writeBulk(in.begin(), 1));
+
+  std::vector<int> out(20, -1);
+  EXPECT_EQ(5, queue.readBulk(out.begin(), 5));
+  EXPECT_EQ(
+      std::vector<int>({0, 1, 2, 3, 4}),
+      std::vector<int>(out.begin(), out.begin() + 5));
+
+  // Wraps around the end of the ring.
+  EXPECT_EQ(5, queue.writeBulk(in.begin() + 7, 10));
+  EXPECT_EQ(7, queue.readBulk(out.begin(), out.size()));
+  EXPECT_EQ(
+      std::vector<int>({5, 6, 7, 8, 9, 10, 11}),
+      std::vector<int>(out.begin(), out.begin() + 7));
+  EXPECT_TRUE(queue.isEmpty());
+  EXPECT_EQ(0, queue.readBulk(out.begin(), out.size()));
+
+  // Mixes with single-element operations.
+  EXPECT_TRUE(queue.write(42));
+  EXPECT_EQ(2, queue.writeBulk(in.begin(), 2));
+  int v;
+  EXPECT_TRUE(queue.read(v));
+  EXPECT_EQ(42, v);
+  EXPECT_EQ(2, queue.readBulk(out.begin(), 3));
+  EXPECT_EQ(0, out[0]);
+  EXPECT_EQ(1, out[1]);
+}
+
+TEST(PCQ, BulkDestructor) {
+  {
+    folly::ProducerConsumerQueue<DtorChecker> queue(16);
+    std::vector<DtorChecker> in(10);
+    EXPECT_EQ(10, queue.writeBulk(in.begin(), in.size()));
+    EXPECT_EQ(DtorChecker::numInstances, 20);
+
+    std::vector<DtorChecker> out(4);
+    EXPECT_EQ(DtorChecker::numInstances, 24);
+    EXPECT_EQ(4, queue.readBulk(out.begin(), out.size()));
+    EXPECT_EQ(DtorChecker::numInstances, 20);
+  }
+  EXPECT_EQ(DtorChecker::numInstances, 0);
+}
+
+TEST(PCQ, BulkConcurrent) {
+  constexpr size_t kItems = 100000;
+  constexpr size_t kBatch = 37;
+  folly::ProducerConsumerQueue<size_t> queue(1024);
+
+  std::thread producer([&] {
+    std::array<size_t, kBatch> batch;
+    size_t next = 0;
+    while (next < kItems) {
+      size_t n = std::min(kBatch, kItems - next);
+      for (size_t i = 0; i < n; ++i) {
+        batch[i] = next + i;
+      }
+      size_t written = 0;
+      while (written < n) {
+        written += queue.writeBulk(batch.begin() + written, n - written);
+      }
+      next += n;
+    }
+  });
+
+  std::array<size_t, kBatch> batch;
+  size_t expected = 0;
+  while (expected < kItems) {
+    size_t n = queue.readBulk(batch.begin(), batch.size());
+    for (size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(expected++, batch[i]);
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.isEmpty());
+}
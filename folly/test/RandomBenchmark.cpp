@@ -16,8 +16,11 @@
 
 #include <folly/Random.h>
 
+#include <algorithm>
+#include <array>
 #include <random>
 #include <thread>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -72,6 +75,77 @@ BENCHMARK(threadprng, n) {
   FOR_EACH_RANGE (i, 0, n) { doNotOptimizeAway(tprng()); }
 }
 
+BENCHMARK(philox, n) {
+  BenchmarkSuspender braces;
+  Philox4x32 rng(Random::rand64());
+
+  braces.dismiss();
+
+  FOR_EACH_RANGE (i, 0, n) { doNotOptimizeAway(rng()); }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(rand32Loop_4k, n) {
+  std::array<uint32_t, 1024> buf;
+  FOR_EACH_RANGE (i, 0, n) {
+    for (auto& v : buf) {
+      v = Random::rand32();
+    }
+    doNotOptimizeAway(buf);
+  }
+}
+
+BENCHMARK_RELATIVE(philoxFill_4k, n) {
+  BenchmarkSuspender braces;
+  Philox4x32 rng(Random::rand64());
+  std::array<uint32_t, 1024> buf;
+
+  braces.dismiss();
+
+  FOR_EACH_RANGE (i, 0, n) {
+    rng.fill(buf.data(), sizeof(buf));
+    doNotOptimizeAway(buf);
+  }
+}
+
+BENCHMARK_RELATIVE(RandomFill_4k, n) {
+  std::array<uint32_t, 1024> buf;
+  FOR_EACH_RANGE (i, 0, n) {
+    Random::fill(buf.data(), sizeof(buf));
+    doNotOptimizeAway(buf);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(stdShuffle_64k, n) {
+  BenchmarkSuspender braces;
+  std::vector<uint32_t> vals(1 << 16);
+  ThreadLocalPRNG rng;
+
+  braces.dismiss();
+
+  FOR_EACH_RANGE (i, 0, n) {
+    std::shuffle(vals.begin(), vals.end(), rng);
+    doNotOptimizeAway(vals);
+  }
+}
+
+BENCHMARK_RELATIVE(RandomShuffle_64k, n) {
+  BenchmarkSuspender braces;
+  std::vector<uint32_t> vals(1 << 16);
+
+  braces.dismiss();
+
+  FOR_EACH_RANGE (i, 0, n) {
+    Random::shuffle(vals.begin(), vals.end());
+    doNotOptimizeAway(vals);
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
 BENCHMARK(RandomDouble) {
   doNotOptimizeAway(Random::randDouble01());
 }
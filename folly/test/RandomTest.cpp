@@ -17,6 +17,7 @@
 #include <folly/Random.h>
 
 #include <algorithm>
+#include <array>
 #include <random>
 #include <thread>
 #include <unordered_set>
@@ -24,6 +25,7 @@
 
 #include <glog/logging.h>
 
+#include <folly/lang/Bits.h>
 #include <folly/portability/GTest.h>
 
 using namespace folly;
@@ -39,6 +41,7 @@ TEST(Random, StateSize) {
   EXPECT_EQ(624, StateSizeT<__gnu_cxx::sfmt19937>::value);
 #endif
   EXPECT_EQ(24, StateSizeT<std::ranlux24_base>::value);
+  EXPECT_EQ(4, StateSizeT<Philox4x32>::value);
 }
 
 TEST(Random, Simple) {
@@ -138,6 +141,172 @@ TEST(Random, sanity) {
   }
 }
 
+TEST(Random, PhiloxKnownAnswers) {
+  // Known-answer vectors from the Random123 distribution.
+  using Block = std::array<uint32_t, 4>;
+  EXPECT_EQ(
+      (Block{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}),
+      Philox4x32::block({{0, 0, 0, 0}}, {{0, 0}}));
+  EXPECT_EQ(
+      (Block{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}),
+      Philox4x32::block(
+          {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+          {{0xffffffff, 0xffffffff}}));
+  EXPECT_EQ(
+      (Block{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}),
+      Philox4x32::block(
+          {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+          {{0xa4093822, 0x299f31d0}}));
+
+  // The engine emits block(counter, key) for counter = 0, 1, ...
+  Philox4x32 rng;
+  auto expected = Philox4x32::block({{0, 0, 0, 0}}, {{0, 0}});
+  for (auto word : expected) {
+    EXPECT_EQ(word, rng());
+  }
+  expected = Philox4x32::block({{1, 0, 0, 0}}, {{0, 0}});
+  EXPECT_EQ(expected[0], rng());
+}
+
+TEST(Random, PhiloxFillMatchesSequence) {
+  for (size_t skip : {0, 1, 3, 5}) {
+    for (size_t len : {0, 3, 16, 64, 67, 200, 1000}) {
+      Philox4x32 filled(42, 7);
+      Philox4x32 stepped(42, 7);
+      for (size_t i = 0; i < skip; ++i) {
+        filled();
+        stepped();
+      }
+      std::vector<uint32_t> buf(len / 4 + 1);
+      filled.fill(buf.data(), len);
+      for (size_t i = 0; i < len / 4; ++i) {
+        EXPECT_EQ(stepped(), Endian::little(buf[i]))
+            << "skip=" << skip << " len=" << len << " i=" << i;
+      }
+      if (len % 4 != 0) {
+        stepped(); // partially used value is discarded
+      }
+      EXPECT_EQ(stepped(), filled());
+    }
+  }
+}
+
+TEST(Random, PhiloxDiscardAndStreams) {
+  for (uint64_t n : {0, 1, 3, 4, 5, 17, 1000}) {
+    for (int pre = 0; pre < 4; ++pre) {
+      Philox4x32 skipped(1);
+      Philox4x32 stepped(1);
+      for (int i = 0; i < pre; ++i) {
+        skipped();
+        stepped();
+      }
+      skipped.discard(n);
+      for (uint64_t i = 0; i < n; ++i) {
+        stepped();
+      }
+      EXPECT_EQ(stepped(), skipped()) << "n=" << n << " pre=" << pre;
+    }
+  }
+
+  Philox4x32 a(1, 0);
+  Philox4x32 b(1, 1);
+  std::unordered_set<uint32_t> seen;
+  for (int i = 0; i < 1000; ++i) {
+    seen.insert(a());
+    seen.insert(b());
+  }
+  EXPECT_EQ(2000, seen.size());
+
+  auto seeded = Random::create<Philox4x32>();
+  auto copy = seeded;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(copy(), seeded());
+  }
+}
+
+TEST(Random, Fill) {
+  std::vector<uint64_t> vals(1000);
+  Random::fill(vals.data(), vals.size() * sizeof(uint64_t));
+  EXPECT_EQ(
+      vals.size(),
+      std::unordered_set<uint64_t>(vals.begin(), vals.end()).size());
+
+  // Unaligned and odd-sized fills must not write out of bounds.
+  std::array<unsigned char, 64> buf{};
+  Random::fill(buf.data() + 1, 13);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(0, buf[14]);
+}
+
+TEST(Random, Shuffle) {
+  std::vector<int> vals(1000);
+  for (size_t i = 0; i < vals.size(); ++i) {
+    vals[i] = int(i);
+  }
+  auto shuffled = vals;
+  Random::shuffle(shuffled.begin(), shuffled.end());
+  EXPECT_NE(vals, shuffled);
+  std::sort(shuffled.begin(), shuffled.end());
+  EXPECT_EQ(vals, shuffled);
+
+  // Deterministic given the generator.
+  auto a = vals;
+  auto b = vals;
+  Philox4x32 rngA(3);
+  Philox4x32 rngB(3);
+  Random::shuffle(a.begin(), a.end(), rngA);
+  Random::shuffle(b.begin(), b.end(), rngB);
+  EXPECT_EQ(a, b);
+
+  // Every position is roughly equally likely for the first element.
+  constexpr int kItems = 4;
+  constexpr int kTrials = 40000;
+  std::array<int, kItems> counts{};
+  for (int t = 0; t < kTrials; ++t) {
+    std::array<int, kItems> items{{0, 1, 2, 3}};
+    Random::shuffle(items.begin(), items.end());
+    ++counts[items[0]];
+  }
+  for (auto c : counts) {
+    EXPECT_NEAR(kTrials / kItems, c, kTrials / 40);
+  }
+}
+
+TEST(Random, Sample) {
+  std::vector<int> vals(1000);
+  for (size_t i = 0; i < vals.size(); ++i) {
+    vals[i] = int(i);
+  }
+  std::vector<int> out(10);
+  auto end = Random::sample(vals.begin(), vals.end(), out.begin(), out.size());
+  EXPECT_EQ(out.end(), end);
+  EXPECT_EQ(out.size(), std::unordered_set<int>(out.begin(), end).size());
+  for (auto v : out) {
+    EXPECT_TRUE(v >= 0 && v < 1000);
+  }
+
+  // Fewer inputs than requested: everything is copied.
+  std::vector<int> small{1, 2, 3};
+  end = Random::sample(small.begin(), small.end(), out.begin(), out.size());
+  EXPECT_EQ(out.begin() + 3, end);
+  std::sort(out.begin(), end);
+  EXPECT_TRUE(std::equal(small.begin(), small.end(), out.begin()));
+
+  // Each element is chosen with probability k / n.
+  constexpr int kTrials = 20000;
+  std::array<int, 4> counts{};
+  std::array<int, 4> items{{0, 1, 2, 3}};
+  std::array<int, 2> chosen;
+  for (int t = 0; t < kTrials; ++t) {
+    Random::sample(items.begin(), items.end(), chosen.begin(), chosen.size());
+    ++counts[chosen[0]];
+    ++counts[chosen[1]];
+  }
+  for (auto c : counts) {
+    EXPECT_NEAR(kTrials / 2, c, kTrials / 40);
+  }
+}
+
 #ifndef _WIN32
 TEST(Random, SecureFork) {
   // Random buffer size is 128, must be less than that.
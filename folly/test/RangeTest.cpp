@@ -916,6 +916,22 @@ struct SseNeedleFinder {
   }
 };
 
+struct Sse42NeedleFinder {
+  static size_t find_first_byte_of(StringPiece haystack, StringPiece needles) {
+    return folly::CpuId().sse42()
+        ? detail::qfind_first_byte_of_sse42(haystack, needles)
+        : detail::qfind_first_byte_of_nosse(haystack, needles);
+  }
+};
+
+struct Avx2NeedleFinder {
+  static size_t find_first_byte_of(StringPiece haystack, StringPiece needles) {
+    return folly::CpuId().avx2()
+        ? detail::qfind_first_byte_of_avx2(haystack, needles)
+        : detail::qfind_first_byte_of_nosse(haystack, needles);
+  }
+};
+
 struct NoSseNeedleFinder {
   static size_t find_first_byte_of(StringPiece haystack, StringPiece needles) {
     return detail::qfind_first_byte_of_nosse(haystack, needles);
@@ -928,8 +944,12 @@ struct ByteSetNeedleFinder {
   }
 };
 
-using NeedleFinders =
-    ::testing::Types<SseNeedleFinder, NoSseNeedleFinder, ByteSetNeedleFinder>;
+using NeedleFinders = ::testing::Types<
+    SseNeedleFinder,
+    Sse42NeedleFinder,
+    Avx2NeedleFinder,
+    NoSseNeedleFinder,
+    ByteSetNeedleFinder>;
 TYPED_TEST_CASE(NeedleFinderTest, NeedleFinders);
 
 TYPED_TEST(NeedleFinderTest, Null) {
@@ -1013,6 +1033,24 @@ TYPED_TEST(NeedleFinderTest, Base) {
   }
 }
 
+TYPED_TEST(NeedleFinderTest, FewNeedles) {
+  // few needles and long haystacks, with the match in every position,
+  // including the last, partial, vector block
+  const string needles = "xyzwv";
+  for (size_t n = 1; n <= needles.size(); ++n) {
+    StringPiece delims(needles.data(), n);
+    for (size_t size = 0; size < 100; ++size) {
+      string s(size, 'a');
+      EXPECT_EQ(string::npos, this->find_first_byte_of(s, delims));
+      for (size_t i = 0; i < size; ++i) {
+        s[i] = needles[n - 1];
+        EXPECT_EQ(i, this->find_first_byte_of(s, delims));
+        s[i] = 'a';
+      }
+    }
+  }
+}
+
 const size_t kPageSize = 4096;
 // Updates contents so that any read accesses past the last byte will
 // cause a SIGSEGV.  It accomplishes this by changing access to the page that
@@ -41,6 +41,8 @@ typedef SharedMutexImpl<true, void, DeterministicAtomic, true>
     DSharedMutexReadPriority;
 typedef SharedMutexImpl<false, void, DeterministicAtomic, true>
     DSharedMutexWritePriority;
+typedef SharedMutexImpl<false, void, DeterministicAtomic, true, false, true>
+    DSharedMutexReadMostly;
 
 template <typename Lock>
 void runBasicTest() {
@@ -87,6 +89,7 @@ TEST(SharedMutex, basic) {
   runBasicTest<SharedMutexReadPriority>();
   runBasicTest<SharedMutexWritePriority>();
   runBasicTest<SharedMutexSuppressTSAN>();
+  runBasicTest<SharedMutexReadMostly>();
 }
 
 template <typename Lock>
@@ -168,6 +171,7 @@ TEST(SharedMutex, basic_holders) {
   runBasicHoldersTest<SharedMutexReadPriority>();
   runBasicHoldersTest<SharedMutexWritePriority>();
   runBasicHoldersTest<SharedMutexSuppressTSAN>();
+  runBasicHoldersTest<SharedMutexReadMostly>();
 }
 
 template <typename Lock>
@@ -195,6 +199,7 @@ TEST(SharedMutex, many_read_locks_with_tokens) {
   runManyReadLocksTestWithTokens<SharedMutexReadPriority>();
   runManyReadLocksTestWithTokens<SharedMutexWritePriority>();
   runManyReadLocksTestWithTokens<SharedMutexSuppressTSAN>();
+  runManyReadLocksTestWithTokens<SharedMutexReadMostly>();
 }
 
 template <typename Lock>
@@ -220,6 +225,7 @@ TEST(SharedMutex, many_read_locks_without_tokens) {
   runManyReadLocksTestWithoutTokens<SharedMutexReadPriority>();
   runManyReadLocksTestWithoutTokens<SharedMutexWritePriority>();
   runManyReadLocksTestWithoutTokens<SharedMutexSuppressTSAN>();
+  runManyReadLocksTestWithoutTokens<SharedMutexReadMostly>();
 }
 
 template <typename Lock>
@@ -250,6 +256,7 @@ TEST(SharedMutex, timeout_in_past) {
   runTimeoutInPastTest<SharedMutexReadPriority>();
   runTimeoutInPastTest<SharedMutexWritePriority>();
   runTimeoutInPastTest<SharedMutexSuppressTSAN>();
+  runTimeoutInPastTest<SharedMutexReadMostly>();
 }
 
 template <class Func>
@@ -337,6 +344,7 @@ TEST(SharedMutex, failing_try_timeout) {
   runFailingTryTimeoutTest<SharedMutexReadPriority>();
   runFailingTryTimeoutTest<SharedMutexWritePriority>();
   runFailingTryTimeoutTest<SharedMutexSuppressTSAN>();
+  runFailingTryTimeoutTest<SharedMutexReadMostly>();
 }
 
 template <typename Lock>
@@ -381,6 +389,7 @@ TEST(SharedMutex, basic_upgrade_tests) {
   runBasicUpgradeTest<SharedMutexReadPriority>();
   runBasicUpgradeTest<SharedMutexWritePriority>();
   runBasicUpgradeTest<SharedMutexSuppressTSAN>();
+  runBasicUpgradeTest<SharedMutexReadMostly>();
 }
 
 TEST(SharedMutex, read_has_prio) {
@@ -1025,6 +1034,13 @@ TEST(SharedMutex, concurrent_readers_of_one_lock_read_prio) {
   }
 }
 
+TEST(SharedMutex, concurrent_readers_of_one_lock_read_mostly) {
+  for (int pass = 0; pass < 10; ++pass) {
+    runContendedReaders<atomic, SharedMutexReadMostly, Locker>(
+        100000, 32, false);
+  }
+}
+
 TEST(SharedMutex, concurrent_readers_of_one_lock_write_prio) {
   for (int pass = 0; pass < 10; ++pass) {
     runContendedReaders<atomic, SharedMutexWritePriority, Locker>(
@@ -1092,6 +1108,21 @@ TEST(SharedMutex, mixed_mostly_read_write_prio) {
   }
 }
 
+TEST(SharedMutex, deterministic_mixed_mostly_read_read_mostly) {
+  for (int pass = 0; pass < 3; ++pass) {
+    DSched sched(DSched::uniform(pass));
+    runMixed<DeterministicAtomic, DSharedMutexReadMostly, Locker>(
+        1000, 3, 0.1, false);
+  }
+}
+
+TEST(SharedMutex, mixed_mostly_read_read_mostly) {
+  for (int pass = 0; pass < 5; ++pass) {
+    runMixed<atomic, SharedMutexReadMostly, TokenLocker>(
+        10000, 32, 0.1, false);
+  }
+}
+
 TEST(SharedMutex, deterministic_mixed_mostly_write_read_prio) {
   for (int pass = 0; pass < 1; ++pass) {
     DSched sched(DSched::uniform(pass));
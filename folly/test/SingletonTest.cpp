@@ -20,6 +20,7 @@
 #include <glog/logging.h>
 
 #include <folly/Singleton.h>
+#include <folly/String.h>
 #include <folly/experimental/io/FsUtil.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/portability/GMock.h>
@@ -683,6 +684,128 @@ TEST(Singleton, SingletonEagerInitParallel) {
   }
 }
 
+namespace {
+struct EagerInitDependenciesTag {};
+struct ATag {};
+struct BTag {};
+struct CTag {};
+} // namespace
+template <typename T, typename Tag = detail::DefaultTag>
+using SingletonEagerInitDependencies =
+    Singleton<T, Tag, EagerInitDependenciesTag>;
+TEST(Singleton, SingletonEagerInitDependencies) {
+  auto& vault = *SingletonVault::singleton<EagerInitDependenciesTag>();
+  folly::Synchronized<std::vector<std::string>> created;
+  auto create = [&](std::string name) {
+    created.wlock()->push_back(name);
+    return new std::string(name);
+  };
+
+  // c depends on a and on b, which is not eager itself.
+  auto a = SingletonEagerInitDependencies<std::string, ATag>([&] {
+             return create("a");
+           }).shouldEagerInit();
+  auto b = SingletonEagerInitDependencies<std::string, BTag>(
+      [&] { return create("b"); });
+  auto c = SingletonEagerInitDependencies<std::string, CTag>([&] {
+             EXPECT_EQ(2, created.rlock()->size());
+             return create("c");
+           })
+               .shouldEagerInit()
+               .dependsOn<std::string, ATag>()
+               .dependsOn<std::string, BTag>();
+  vault.registrationComplete();
+
+  {
+    TestEagerInitParallelExecutor exe(4);
+    folly::Baton<> done;
+    vault.doEagerInitVia(exe, &done);
+    done.wait();
+  }
+
+  EXPECT_EQ(3, created.rlock()->size());
+  EXPECT_EQ("c", created.rlock()->back());
+  EXPECT_EQ(3, vault.livingSingletonCount());
+  EXPECT_EQ(3, vault.initTraces().size());
+  a.get_weak(); // (avoid compile error complaining about unused var)
+  b.get_weak();
+  c.get_weak();
+}
+
+namespace {
+struct EagerInitCycleTag {};
+} // namespace
+template <typename T, typename Tag = detail::DefaultTag>
+using SingletonEagerInitCycle = Singleton<T, Tag, EagerInitCycleTag>;
+TEST(Singleton, SingletonEagerInitCycle) {
+  auto& vault = *SingletonVault::singleton<EagerInitCycleTag>();
+  // c is not part of the cycle, only depends on it
+  auto c = SingletonEagerInitCycle<std::string, CTag>()
+               .shouldEagerInit()
+               .dependsOn<std::string, ATag>();
+  auto a = SingletonEagerInitCycle<std::string, ATag>()
+               .dependsOn<std::string, BTag>();
+  auto b = SingletonEagerInitCycle<std::string, BTag>()
+               .dependsOn<std::string, ATag>();
+  vault.registrationComplete();
+
+  TestEagerInitParallelExecutor exe(1);
+  try {
+    vault.doEagerInitVia(exe);
+    ADD_FAILURE() << "doEagerInitVia() didn't throw";
+  } catch (const std::logic_error& e) {
+    StringPiece what = e.what();
+    EXPECT_TRUE(what.removePrefix("Circular dependency between eager "
+                                  "singletons: "))
+        << what;
+    // a -> b -> a, or b -> a -> b
+    std::vector<StringPiece> path;
+    folly::split(" -> ", what, path);
+    ASSERT_EQ(3, path.size()) << what;
+    EXPECT_EQ(path[0], path[2]);
+    EXPECT_NE(path[0], path[1]);
+    EXPECT_FALSE(what.contains("CTag")) << what;
+  }
+  EXPECT_EQ(0, vault.livingSingletonCount());
+  a.get_weak(); // (avoid compile error complaining about unused var)
+  b.get_weak();
+  c.get_weak();
+}
+
+namespace {
+struct InitTracesTag {};
+} // namespace
+template <typename T, typename Tag = detail::DefaultTag>
+using SingletonInitTraces = Singleton<T, Tag, InitTracesTag>;
+TEST(Singleton, SingletonInitTraces) {
+  auto& vault = *SingletonVault::singleton<InitTracesTag>();
+  SingletonInitTraces<std::string, ATag> a([] {
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return new std::string("a");
+  });
+  SingletonInitTraces<std::string, BTag> b([] {
+    return new std::string(*SingletonInitTraces<std::string, ATag>::try_get());
+  });
+  vault.registrationComplete();
+
+  SingletonInitTraces<std::string, BTag>::vivify();
+  auto traces = vault.initTraces();
+  ASSERT_EQ(2, traces.size());
+  // a was created while creating b.
+  EXPECT_EQ(
+      detail::TypeDescriptor(typeid(std::string), typeid(ATag)).name(),
+      traces[0].name);
+  EXPECT_GE(traces[0].selfDuration, std::chrono::milliseconds(10));
+  EXPECT_EQ(std::vector<std::string>{traces[0].name}, traces[1].dependencies);
+  EXPECT_GE(traces[1].duration, traces[0].duration);
+  EXPECT_LT(traces[1].selfDuration, std::chrono::milliseconds(10));
+
+  vault.destroyInstances();
+  EXPECT_TRUE(vault.initTraces().empty());
+  vault.reenableInstances();
+}
+
 struct MockTag {};
 template <typename T, typename Tag = detail::DefaultTag>
 using SingletonMock = Singleton<T, Tag, MockTag>;
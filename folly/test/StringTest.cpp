@@ -181,6 +181,12 @@ TEST(Escape, cEscape) {
       cEscape<std::string>("hello \\world\" goodbye"));
   EXPECT_EQ("hello\\nworld", cEscape<std::string>("hello\nworld"));
   EXPECT_EQ("hello\\377\\376", cEscape<std::string>("hello\xff\xfe"));
+
+  // Runs of regular characters longer than a vector block.
+  const std::string pad(20, 'x');
+  EXPECT_EQ(
+      pad + "\\?" + pad + "\\t" + pad + "\\177",
+      cEscape<std::string>(pad + "?" + pad + "\t" + pad + "\x7f"));
 }
 
 TEST(Escape, cUnescape) {
@@ -221,6 +227,16 @@ TEST(Escape, uriEscape) {
       "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ-_.~",
       uriEscape<std::string>(
           "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ-_.~"));
+  EXPECT_EQ(
+      "some%2flong%2fpath%2fwith+a+space%2c+a+comma%2fand%00nul",
+      uriEscape<std::string>(
+          "some/long/path/with a space, a comma/and" + std::string(1, '\0') +
+              "nul",
+          UriEscapeMode::QUERY));
+  EXPECT_EQ(
+      "some/long/path/with%20a%20space%2c%20a%20comma/",
+      uriEscape<std::string>(
+          "some/long/path/with a space, a comma/", UriEscapeMode::PATH));
 }
 
 TEST(Escape, uriUnescape) {
@@ -844,6 +860,25 @@ TEST(Split, pieces_fbvector) {
   piecesTest<folly::fbvector>();
 }
 
+TEST(Split, multiCharDelimiterLong) {
+  std::vector<StringPiece> parts;
+  folly::split(
+      "::", "first field::second:field::::a field longer than a block::", parts);
+  ASSERT_EQ(5, parts.size());
+  EXPECT_EQ("first field", parts[0]);
+  EXPECT_EQ("second:field", parts[1]);
+  EXPECT_EQ("", parts[2]);
+  EXPECT_EQ("a field longer than a block", parts[3]);
+  EXPECT_EQ("", parts[4]);
+
+  parts.clear();
+  const std::string overlapping = std::string(40, 'a') + "abcabcab";
+  folly::split("abcab", overlapping, parts);
+  ASSERT_EQ(2, parts.size());
+  EXPECT_EQ(std::string(40, 'a'), parts[0]);
+  EXPECT_EQ("cab", parts[1]);
+}
+
 TEST(Split, fixed) {
   StringPiece a, b, c, d;
 
@@ -25,6 +25,7 @@
 #include <folly/Exception.h>
 #include <folly/FileUtil.h>
 #include <folly/Format.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/experimental/io/FsUtil.h>
@@ -312,6 +313,48 @@ TEST(SimpleSubprocessTest, FdLeakTest) {
   });
 }
 
+TEST(SimpleSubprocessTest, CloseOtherFds) {
+  // Leave a gap below the kept fd, and an open fd on either side of it
+  int pipeFds[2];
+  checkUnixError(::pipe(pipeFds), "pipe");
+  int kept = ::dup2(pipeFds[0], 100);
+  int closedBelow = ::dup2(pipeFds[0], 50);
+  int closedAbove = ::dup2(pipeFds[0], 200);
+  SCOPE_EXIT {
+    for (int fd : {pipeFds[0], pipeFds[1], kept, closedBelow, closedAbove}) {
+      ::close(fd);
+    }
+  };
+  ASSERT_EQ(100, kept);
+
+  auto script = sformat(
+      "test -e /proc/self/fd/{} && ! test -e /proc/self/fd/{} && "
+      "! test -e /proc/self/fd/{} && ! test -e /proc/self/fd/{}",
+      kept,
+      pipeFds[1],
+      closedBelow,
+      closedAbove);
+  Subprocess proc(
+      std::vector<std::string>{"/bin/sh", "-c", script},
+      Subprocess::Options().closeOtherFds().fd(kept, kept));
+  EXPECT_EQ(0, proc.wait().exitStatus());
+}
+
+TEST(SimpleSubprocessTest, PrebuiltArgvAndEnv) {
+  const char* const argv[] = {"/bin/sh", "-c", "test \"$X\" = 42", nullptr};
+  const char* const env[] = {"X=42", nullptr};
+  const char* const otherEnv[] = {"X=43", nullptr};
+  for (int i = 0; i < 3; ++i) {
+    Subprocess proc(argv, Subprocess::Options(), nullptr, env);
+    EXPECT_EQ(0, proc.wait().exitStatus());
+  }
+  Subprocess proc(argv, Subprocess::Options(), nullptr, otherEnv);
+  EXPECT_EQ(1, proc.wait().exitStatus());
+
+  const char* const empty[] = {nullptr};
+  EXPECT_THROW(Subprocess{empty}, std::invalid_argument);
+}
+
 TEST(SimpleSubprocessTest, Detach) {
   auto start = std::chrono::steady_clock::now();
   {
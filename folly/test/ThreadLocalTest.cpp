@@ -181,6 +181,31 @@ TEST(ThreadLocalPtr, CreateOnThreadExit) {
   EXPECT_EQ(2, Widget::totalVal_);
 }
 
+TEST(ThreadLocalPtr, CreateOnThreadExitOtherTag) {
+  struct TagA {};
+  struct TagB {};
+  Widget::totalVal_ = 0;
+  ThreadLocal<Widget, TagA> wa;
+  ThreadLocal<Widget, TagB> wb;
+  ThreadLocalPtr<int, TagA> ta;
+  ThreadLocalPtr<int, TagB> tb;
+
+  std::thread([&] {
+    // Whichever tag is cleaned up first creates an element in the other,
+    // which has to be disposed after its own cleanup may have run.
+    ta.reset(new int(1), [&](int* ptr, TLPDestructionMode /* mode */) {
+      delete ptr;
+      ++wb.get()->val_;
+    });
+    tb.reset(new int(1), [&](int* ptr, TLPDestructionMode /* mode */) {
+      delete ptr;
+      ++wa.get()->val_;
+    });
+  })
+      .join();
+  EXPECT_EQ(2, Widget::totalVal_);
+}
+
 // Test deleting the ThreadLocalPtr object
 TEST(ThreadLocalPtr, CustomDeleter2) {
   Widget::totalVal_ = 0;
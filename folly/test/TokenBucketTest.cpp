@@ -16,6 +16,10 @@
 
 #include <folly/test/TokenBucketTest.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <folly/portability/GTest.h>
 
 using namespace folly;
@@ -172,3 +176,77 @@ TEST(TokenBucket, consumeOrBorrowTest) {
   // No allocation will succeed until nowInSeconds goes higher than 11s.
   EXPECT_FALSE(tokenBucket.consume(1, 10, 10, 11));
 }
+
+TEST(ShardedTokenBucket, sanity) {
+  const double rate = 10000;
+  const double burstSize = 100;
+  const double batchSize = 10;
+  ShardedTokenBucket tokenBucket(rate, burstSize, batchSize, 0);
+  double tokenCounter = 0;
+  double currentTime = 0;
+  for (; currentTime <= 10.0; currentTime += 0.001) {
+    EXPECT_FALSE(tokenBucket.consume(burstSize + batchSize + 1, currentTime));
+    while (tokenBucket.consume(1, currentTime)) {
+      tokenCounter += 1;
+    }
+    EXPECT_LE(rate * currentTime * 0.9 - 1, tokenCounter);
+    // A single thread uses one shard, which caches at most a batch
+    EXPECT_GE(rate * currentTime + batchSize + 1e-6, tokenCounter);
+  }
+}
+
+TEST(ShardedTokenBucket, denyUntilRefilled) {
+  // Powers of two, so that the token counts are exact
+  ShardedTokenBucket tokenBucket(8, 8, 2, 0);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_TRUE(tokenBucket.consume(1, 1));
+  }
+  EXPECT_FALSE(tokenBucket.consume(1, 1));
+  // Half a token was generated, and the shard doesn't ask for it
+  EXPECT_FALSE(tokenBucket.consume(1, 1.0625));
+  EXPECT_DOUBLE_EQ(0.5, tokenBucket.available(1.0625));
+  EXPECT_TRUE(tokenBucket.consume(1, 1.125));
+  EXPECT_FALSE(tokenBucket.consume(1, 1.125));
+
+  // Returned tokens are available right away
+  tokenBucket.returnTokens(3);
+  EXPECT_TRUE(tokenBucket.consume(3, 1.125));
+  EXPECT_FALSE(tokenBucket.consume(1, 1.125));
+}
+
+TEST(ShardedTokenBucket, returnTokensOverBatch) {
+  ShardedTokenBucket tokenBucket(10, 10, 2, 0);
+  EXPECT_TRUE(tokenBucket.consume(10, 1));
+  // The shard keeps a batch, the central bucket gets the rest
+  tokenBucket.returnTokens(5);
+  EXPECT_DOUBLE_EQ(5, tokenBucket.available(1));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(tokenBucket.consume(1, 1));
+  }
+  EXPECT_FALSE(tokenBucket.consume(1, 1));
+}
+
+TEST(ShardedTokenBucket, concurrent) {
+  const double burstSize = 10000;
+  const double batchSize = 10;
+  ShardedTokenBucket tokenBucket(1, burstSize, batchSize, 0);
+  std::atomic<size_t> consumed{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 16; ++t) {
+    threads.emplace_back([&] {
+      size_t count = 0;
+      while (tokenBucket.consume(1, burstSize)) {
+        ++count;
+      }
+      consumed += count;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // The shards of the other threads' cores may still hold a batch each
+  size_t numShards = CacheLocality::system().numCachesByLevel[0];
+  EXPECT_LE(burstSize - numShards * batchSize, consumed);
+  EXPECT_GE(burstSize, consumed);
+  EXPECT_NEAR(burstSize - consumed, tokenBucket.available(burstSize), 1e-6);
+}
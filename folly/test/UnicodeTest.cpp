@@ -128,3 +128,79 @@ TEST(InvalidUtf8ToCodePoint, FourCloverLeafAsSurrogates) {
 TEST(ValidUtf8ToCodePoint, LastCodePoint) {
   testValid({0xF4, 0x8F, 0xBF, 0xBF}, 0x10FFFF); // u8"\U0010FFFF";
 }
+
+TEST(Utf8ValidPrefixLength, Basic) {
+  using folly::utf8ValidPrefixLength;
+  EXPECT_EQ(utf8ValidPrefixLength(""), 0);
+  EXPECT_EQ(utf8ValidPrefixLength("abc"), 3);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xc2\x80z"), 4);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xf4\x8f\xbf\xbfz"), 6);
+  // Overlong, surrogate, above U+10FFFF, stray continuation, truncated.
+  EXPECT_EQ(utf8ValidPrefixLength("a\xc0\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xe0\x80\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xf0\x80\x80\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xed\xa0\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xf4\x90\x80\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\x80z"), 1);
+  EXPECT_EQ(utf8ValidPrefixLength("a\xe2\x82"), 1);
+  EXPECT_TRUE(folly::isValidUtf8("\xe2\x82\xac"));
+  EXPECT_FALSE(folly::isValidUtf8("\xe2\x82"));
+}
+
+TEST(Utf8ValidPrefixLength, Blocks) {
+  // Plant a valid or an invalid sequence at every offset of a string long
+  // enough to span several vector blocks, so that it straddles each block
+  // boundary.
+  const std::string valid[] = {"\xc2\xa9", "\xe2\x82\xac", "\xf0\x9f\x8d\x80"};
+  const std::string invalid[] = {
+      "\xc1\xbf", "\xe2\x82", "\xed\xbf\xbf", "\xf4\x90\x80\x80", "\xbf"};
+  for (size_t len = 16; len < 64; ++len) {
+    for (size_t i = 0; i < len; ++i) {
+      for (auto& seq : valid) {
+        // Sequences cut off by the end of the string are truncated.
+        std::string s(len, 'a');
+        s.replace(i, seq.size(), seq);
+        s.resize(len);
+        auto expected = i + seq.size() <= len ? len : i;
+        EXPECT_EQ(folly::utf8ValidPrefixLength(s), expected) << len << " " << i;
+      }
+      for (auto& seq : invalid) {
+        std::string s = std::string(len, 'x') + "tail";
+        s.replace(i, seq.size(), seq);
+        EXPECT_EQ(folly::utf8ValidPrefixLength(s), i) << len << " " << i;
+      }
+    }
+  }
+}
+
+TEST(Utf8ToUtf16, RoundTrip) {
+  std::string utf8 = "ascii only, and long enough for a few words";
+  std::u16string utf16 = u"ascii only, and long enough for a few words";
+  EXPECT_EQ(folly::utf8ToUtf16(utf8), utf16);
+  EXPECT_EQ(
+      folly::utf16ToUtf8(folly::Range<const char16_t*>(
+          utf16.data(), utf16.size())),
+      utf8);
+
+  utf8 = "a\xc2\xa9 \xe2\x82\xac \xf0\x9f\x8d\x80 \xf4\x8f\xbf\xbf z";
+  utf16 = u"a© € \U0001F340 \U0010FFFF z";
+  EXPECT_EQ(folly::utf8ToUtf16(utf8), utf16);
+  EXPECT_EQ(
+      folly::utf16ToUtf8(folly::Range<const char16_t*>(
+          utf16.data(), utf16.size())),
+      utf8);
+}
+
+TEST(Utf8ToUtf16, Invalid) {
+  EXPECT_THROW(folly::utf8ToUtf16("abc\xc0\x80"), std::runtime_error);
+  EXPECT_THROW(folly::utf8ToUtf16("abc\xed\xa0\x80"), std::runtime_error);
+  EXPECT_THROW(folly::utf8ToUtf16("abc\xe2\x82"), std::runtime_error);
+
+  const char16_t lead[] = {u'a', 0xD83C};
+  const char16_t trail[] = {u'a', 0xDF40, u'b'};
+  const char16_t reversed[] = {0xDF40, 0xD83C};
+  for (auto units :
+       {folly::range(lead), folly::range(trail), folly::range(reversed)}) {
+    EXPECT_THROW(folly::utf16ToUtf8(units), std::runtime_error);
+  }
+}
@@ -413,3 +413,48 @@ TEST(Uri, BadPortThrowsInvalidArgument) {
   constexpr folly::StringPiece s = "http://localhost:9999999999999999999/";
   EXPECT_THROW(Uri{s}, std::invalid_argument);
 }
+
+TEST(UriView, Simple) {
+  const std::string s(
+      "HTTP://user:pass@[::1]:8080/a/path?k1=v%201&bad=x=y&=v&k2+x=&k3#frag");
+  UriView u(s);
+  EXPECT_EQ("HTTP", u.scheme());
+  EXPECT_TRUE(u.hasAuthority());
+  EXPECT_EQ("user", u.username());
+  EXPECT_EQ("pass", u.password());
+  EXPECT_EQ("[::1]", u.host());
+  EXPECT_EQ("::1", u.hostname());
+  EXPECT_EQ(8080, u.port());
+  EXPECT_EQ("/a/path", u.path());
+  EXPECT_EQ("k1=v%201&bad=x=y&=v&k2+x=&k3", u.query());
+  EXPECT_EQ("frag", u.fragment());
+  // Every component is a view of the parsed string.
+  EXPECT_EQ(s.data() + s.find("/a/path"), u.path().data());
+
+  std::vector<std::pair<std::string, std::string>> raw, decoded;
+  for (auto const& param : u.queryParams()) {
+    raw.emplace_back(param.name.str(), param.value.str());
+    decoded.emplace_back(param.decodedName(), param.decodedValue());
+  }
+  using Params = std::vector<std::pair<std::string, std::string>>;
+  EXPECT_EQ((Params{{"k1", "v%201"}, {"k2+x", ""}, {"k3", ""}}), raw);
+  EXPECT_EQ((Params{{"k1", "v 1"}, {"k2 x", ""}, {"k3", ""}}), decoded);
+  EXPECT_EQ(raw, Uri(s).getQueryParams());
+}
+
+TEST(UriView, NoAuthority) {
+  UriView u("mailto:someone@example.com");
+  EXPECT_EQ("mailto", u.scheme());
+  EXPECT_FALSE(u.hasAuthority());
+  EXPECT_EQ("", u.host());
+  EXPECT_EQ("someone@example.com", u.path());
+  EXPECT_TRUE(u.queryParams().empty());
+}
+
+TEST(UriView, Invalid) {
+  EXPECT_THROW(UriView("no scheme"), std::invalid_argument);
+  EXPECT_THROW(UriView("1http://host"), std::invalid_argument);
+  EXPECT_THROW(UriView("http://host:port"), std::invalid_argument);
+  EXPECT_THROW(UriView("http://[::1/"), std::invalid_argument);
+  EXPECT_THROW(UriView("http://host:65536/"), std::invalid_argument);
+}
@@ -125,6 +125,129 @@ TEST(ZigZag, Simple) {
   EXPECT_EQ(2, decodeZigZag(4));
 }
 
+template <class Int>
+std::vector<Int> bulkVarintValues(size_t n, uint32_t seed) {
+  // runs of small values, with larger ones mixed in
+  std::mt19937 rng(seed);
+  std::vector<Int> values(n);
+  for (auto& val : values) {
+    int bits = rng() % 4 == 0 ? int(rng() % (8 * sizeof(Int))) + 1 : 7;
+    val = Int(((uint64_t(rng()) << 32) | rng()) >> (64 - bits));
+  }
+  return values;
+}
+
+template <class Int>
+void testBulkVarints() {
+  for (size_t n : {0, 1, 15, 16, 17, 33, 100, 1000}) {
+    auto values = bulkVarintValues<Int>(n, uint32_t(n));
+    std::vector<uint8_t> buf(n * kMaxVarintLength64);
+    size_t size = encodeVarints(values.data(), n, buf.data());
+
+    // the same bytes as one value at a time
+    std::vector<uint8_t> expected(n * kMaxVarintLength64);
+    uint8_t* p = expected.data();
+    for (auto val : values) {
+      p += encodeVarint(val, p);
+    }
+    ASSERT_EQ(size_t(p - expected.data()), size);
+    EXPECT_TRUE(ByteRange(buf.data(), size) == ByteRange(expected.data(), p));
+
+    std::vector<Int> decoded(n);
+    ByteRange range(buf.data(), size + 1);
+    decodeVarints(range, decoded.data(), n);
+    EXPECT_EQ(values, decoded);
+    EXPECT_EQ(1, range.size());
+
+    if (n != 0) {
+      // truncated data
+      range = ByteRange(buf.data(), size - 1);
+      EXPECT_EQ(n - 1, tryDecodeVarints(range, decoded.data(), n));
+      EXPECT_EQ(encodeVarintSize(values.back()) - 1, range.size());
+      range = ByteRange(buf.data(), size - 1);
+      EXPECT_THROW(
+          decodeVarints(range, decoded.data(), n), std::invalid_argument);
+    }
+  }
+}
+
+TEST(Varint, Bulk) {
+  testBulkVarints<uint32_t>();
+  testBulkVarints<uint64_t>();
+
+  // small values all the way
+  std::vector<uint32_t> values(100);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = uint32_t(i);
+  }
+  uint8_t buf[100];
+  EXPECT_EQ(100, encodeVarints(values.data(), values.size(), buf));
+  std::vector<uint64_t> decoded(100);
+  StringPiece sp(reinterpret_cast<const char*>(buf), sizeof(buf));
+  EXPECT_EQ(100, tryDecodeVarints(sp, decoded.data(), decoded.size()));
+  EXPECT_TRUE(sp.empty());
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), decoded.begin()));
+
+  // an invalid value stops decoding
+  std::vector<uint8_t> invalid(40, 1);
+  std::fill(invalid.begin() + 20, invalid.begin() + 30, 0xff);
+  ByteRange range(invalid.data(), invalid.size());
+  EXPECT_EQ(20, tryDecodeVarints(range, decoded.data(), 30));
+  EXPECT_EQ(20, range.size());
+  EXPECT_THROW(decodeVarints(range, decoded.data(), 1), std::invalid_argument);
+}
+
+TEST(Varint, BulkZigZag) {
+  std::vector<int64_t> values = {0, -1, 1, -64, 64, -1000000, 1000000};
+  values.push_back(std::numeric_limits<int64_t>::min());
+  values.push_back(std::numeric_limits<int64_t>::max());
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(i % 2 ? i : -i);
+  }
+  std::vector<uint8_t> buf(values.size() * kMaxVarintLength64);
+  size_t size = encodeZigZagVarints(values.data(), values.size(), buf.data());
+  std::vector<int64_t> decoded(values.size());
+  ByteRange range(buf.data(), size);
+  decodeZigZagVarints(range, decoded.data(), decoded.size());
+  EXPECT_EQ(values, decoded);
+  EXPECT_TRUE(range.empty());
+
+  std::vector<int32_t> values32 = {
+      0, -1, 1, std::numeric_limits<int32_t>::min(), 12345};
+  values32.push_back(std::numeric_limits<int32_t>::max());
+  size = encodeZigZagVarints(values32.data(), values32.size(), buf.data());
+  EXPECT_LE(size, values32.size() * kMaxVarintLength32);
+  std::vector<int32_t> decoded32(values32.size());
+  range = ByteRange(buf.data(), size);
+  decodeZigZagVarints(range, decoded32.data(), decoded32.size());
+  EXPECT_EQ(values32, decoded32);
+}
+
+TEST(Varint, BulkDelta) {
+  std::mt19937 rng(FLAGS_random_seed);
+  std::vector<uint32_t> values(1001);
+  uint32_t val = 1u << 31;
+  for (auto& v : values) {
+    val += rng() % 300;
+    v = val;
+  }
+  std::vector<uint8_t> buf(values.size() * kMaxVarintLength32);
+  size_t size = encodeDeltaVarints(values.data(), values.size(), buf.data());
+  // the first value, then mostly two byte deltas
+  EXPECT_LT(size, 5 + 2 * values.size());
+  std::vector<uint32_t> decoded(values.size());
+  ByteRange range(buf.data(), size);
+  decodeDeltaVarints(range, decoded.data(), decoded.size());
+  EXPECT_EQ(values, decoded);
+
+  std::vector<uint64_t> values64 = {1, 1, 2, 100, 1ull << 40, ~0ull};
+  size = encodeDeltaVarints(values64.data(), values64.size(), buf.data());
+  std::vector<uint64_t> decoded64(values64.size());
+  range = ByteRange(buf.data(), size);
+  decodeDeltaVarints(range, decoded64.data(), decoded64.size());
+  EXPECT_EQ(values64, decoded64);
+}
+
 namespace {
 
 constexpr size_t kNumValues = 1000;
@@ -196,6 +319,13 @@ BENCHMARK(VarintDecoding, iters) {
   }
 }
 
+BENCHMARK(VarintBulkDecoding, iters) {
+  while (iters--) {
+    ByteRange range(&(*gEncoded.begin()), &(*gEncoded.end()));
+    decodeVarints(range, gDecodedValues.data(), gDecodedValues.size());
+  }
+}
+
 } // namespace
 } // namespace test
 } // namespace folly
@@ -1183,3 +1183,205 @@ TEST(small_vector, erase_if) {
   EXPECT_EQ(3u, v[1]);
   EXPECT_EQ(5u, v[2]);
 }
+
+namespace {
+class RelocatableCounter : public Counter {
+ public:
+  using Counter::Counter;
+};
+
+// Constructing it from an int throws when the int is negative.
+struct RelocatableThrower {
+  std::unique_ptr<int> p;
+
+  /* implicit */ RelocatableThrower(int i) {
+    if (i < 0) {
+      throw std::runtime_error("negative");
+    }
+    p = std::make_unique<int>(i);
+  }
+};
+} // namespace
+
+namespace folly {
+template <>
+FOLLY_ASSUME_RELOCATABLE(RelocatableCounter);
+template <>
+FOLLY_ASSUME_RELOCATABLE(RelocatableThrower);
+} // namespace folly
+
+TEST(small_vector, RelocatableGrowthDoesNotMove) {
+  small_vector<RelocatableCounter, 2> test;
+  Counts counts;
+  for (size_t i = 0; i < 100; ++i) {
+    test.emplace_back(counts);
+  }
+  // growing from inline storage, and then on the heap, uses memcpy
+  EXPECT_EQ(0, counts.copyCount);
+  EXPECT_EQ(0, counts.moveCount);
+
+  // only the temporary is moved into place, not the other elements
+  test.emplace(test.begin(), counts);
+  test.erase(test.begin() + 10, test.begin() + 20);
+  test.erase(test.begin());
+  EXPECT_EQ(90, test.size());
+  EXPECT_EQ(0, counts.copyCount);
+  EXPECT_EQ(1, counts.moveCount);
+}
+
+TEST(small_vector, UniquePtrRelocation) {
+  small_vector<std::unique_ptr<int>, 3> v;
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(std::make_unique<int>(i));
+  }
+  v.insert(v.begin() + 1, std::make_unique<int>(-1));
+  v.emplace(v.begin() + 50, std::make_unique<int>(-2));
+  ASSERT_EQ(102, v.size());
+  EXPECT_EQ(0, *v[0]);
+  EXPECT_EQ(-1, *v[1]);
+  EXPECT_EQ(1, *v[2]);
+  EXPECT_EQ(-2, *v[50]);
+  EXPECT_EQ(48, *v[49]);
+  EXPECT_EQ(49, *v[51]);
+  EXPECT_EQ(99, *v.back());
+
+  v.erase(v.begin() + 50);
+  v.erase(v.begin() + 1);
+  v.erase(v.begin() + 10, v.begin() + 90);
+  ASSERT_EQ(20, v.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, *v[i]);
+  }
+  for (int i = 10; i < 20; ++i) {
+    EXPECT_EQ(i + 80, *v[i]);
+  }
+
+  small_vector<std::unique_ptr<int>, 3> w(std::move(v));
+  EXPECT_EQ(20, w.size());
+  EXPECT_EQ(99, *w.back());
+}
+
+TEST(small_vector, RelocatableInsertRollback) {
+  small_vector<RelocatableThrower, 2> v;
+  for (int i = 0; i == 0 || v.size() < v.capacity(); ++i) {
+    v.emplace_back(i);
+  }
+  int const n = v.size();
+  auto check = [&] {
+    ASSERT_EQ(n, v.size());
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(i, *v[i].p);
+    }
+  };
+  // growth
+  EXPECT_THROW(v.emplace(v.begin() + 1, -1), std::runtime_error);
+  check();
+  // in place
+  v.reserve(n + 8);
+  EXPECT_THROW(v.emplace(v.begin() + 1, -1), std::runtime_error);
+  check();
+  int values[] = {20, -1, 21};
+  EXPECT_THROW(
+      v.insert(v.begin() + 1, std::begin(values), std::end(values)),
+      std::runtime_error);
+  check();
+}
+
+#if FOLLY_HAS_MEMORY_RESOURCE
+
+namespace {
+using folly::detail::std_pmr::memory_resource;
+using folly::detail::std_pmr::new_delete_resource;
+
+class CountingResource : public memory_resource {
+ public:
+  size_t allocated = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    EXPECT_GE(allocated, bytes);
+    allocated -= bytes;
+    new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+} // namespace
+
+TEST(small_vector, PmrAllocator) {
+  CountingResource resource;
+  {
+    folly::pmr::small_vector<std::string, 2> v(&resource);
+    EXPECT_EQ(&resource, v.get_allocator().resource());
+    for (int i = 0; i < 100; ++i) {
+      v.push_back(folly::to<std::string>(i));
+    }
+    EXPECT_GE(resource.allocated, 100 * sizeof(std::string));
+    EXPECT_GE(v.capacity(), 100);
+
+    v.resize(10);
+    v.shrink_to_fit();
+    EXPECT_EQ(&resource, v.get_allocator().resource());
+    EXPECT_EQ(10 * sizeof(std::string), resource.allocated);
+    EXPECT_EQ("9", v.back());
+
+    // copies are made with the default resource, as with std::pmr
+    auto copy = v;
+    EXPECT_NE(&resource, copy.get_allocator().resource());
+    EXPECT_EQ(10 * sizeof(std::string), resource.allocated);
+
+    // moves take the buffer over when the resources are equal
+    folly::pmr::small_vector<std::string, 2> moved(std::move(v), &resource);
+    EXPECT_EQ(10, moved.size());
+    EXPECT_EQ(10 * sizeof(std::string), resource.allocated);
+  }
+  EXPECT_EQ(0, resource.allocated);
+}
+
+TEST(small_vector, PmrAllocatorMoveAcrossResources) {
+  CountingResource r1;
+  CountingResource r2;
+  {
+    folly::pmr::small_vector<int, 2> a({1, 2, 3, 4, 5}, &r1);
+    folly::pmr::small_vector<int, 2> b(&r2);
+    b = std::move(a);
+    // the elements were moved into a buffer of r2
+    EXPECT_EQ(&r2, b.get_allocator().resource());
+    EXPECT_EQ(5, b.size());
+    EXPECT_EQ(5, b[4]);
+    EXPECT_LT(0, r2.allocated);
+
+    folly::pmr::small_vector<int, 2> c(std::move(b), &r1);
+    EXPECT_EQ(&r1, c.get_allocator().resource());
+    EXPECT_EQ(5, c.size());
+
+    c = {6, 7};
+    EXPECT_EQ(7, c[1]);
+    a = c;
+    EXPECT_EQ(&r1, a.get_allocator().resource());
+    EXPECT_EQ(2, a.size());
+  }
+  EXPECT_EQ(0, r1.allocated);
+  EXPECT_EQ(0, r2.allocated);
+}
+
+TEST(small_vector, PmrAllocatorHeapifiedCapacity) {
+  // too small to store the capacity inline
+  CountingResource resource;
+  {
+    folly::pmr::small_vector<char, 8, uint32_t> v(&resource);
+    for (int i = 0; i < 1000; ++i) {
+      v.push_back(static_cast<char>(i));
+    }
+    EXPECT_GE(v.capacity(), 1000);
+    EXPECT_EQ(static_cast<char>(999), v.back());
+  }
+  EXPECT_EQ(0, resource.allocated);
+}
+
+#endif // FOLLY_HAS_MEMORY_RESOURCE
@@ -20,6 +20,8 @@
 #include <iterator>
 #include <list>
 #include <memory>
+#include <random>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -821,6 +823,54 @@ TEST(SortedVectorTypes, TestBulkInsertionWithDuplicatesIntoEmptySet) {
   EXPECT_THAT(set, testing::ElementsAreArray({0, 1}));
 }
 
+TEST(SortedVectorTypes, TestBulkInsertSortedUnique) {
+  std::mt19937 rng(0);
+  for (int round = 0; round < 200; ++round) {
+    std::set<int> expected;
+    std::vector<int> existing;
+    std::vector<int> added;
+    for (int i = 0; i < 100; ++i) {
+      if (rng() % 4 == 0) {
+        existing.push_back(i);
+        expected.insert(i);
+      }
+      // some of the added elements already exist
+      if (rng() % (round % 5 + 2) == 0) {
+        added.push_back(i);
+        expected.insert(i);
+      }
+    }
+    sorted_vector_set<int> set(
+        folly::sorted_unique, std::vector<int>(existing));
+    set.bulk_insert(folly::sorted_unique, added.begin(), added.end());
+    check_invariant(set);
+    EXPECT_THAT(set, testing::ElementsAreArray(expected));
+  }
+
+  // all after the existing elements, and all before them
+  sorted_vector_set<int> set{10, 20};
+  std::vector<int> const after = {30, 40};
+  set.bulk_insert(folly::sorted_unique, after.begin(), after.end());
+  std::vector<int> const before = {1, 2, 20};
+  set.bulk_insert(folly::sorted_unique, before.begin(), before.end());
+  EXPECT_THAT(set, testing::ElementsAreArray({1, 2, 10, 20, 30, 40}));
+}
+
+TEST(SortedVectorTypes, TestMapBulkInsertSortedUnique) {
+  sorted_vector_map<int, std::string> map{{2, "two"}, {4, "four"}};
+  std::list<std::pair<int, std::string>> const added = {
+      {1, "one"}, {2, "deux"}, {3, "three"}, {5, "five"}};
+  map.reserve(map.size() + added.size());
+  auto const* data = map.data();
+  map.bulk_insert(folly::sorted_unique, added.begin(), added.end());
+  // existing values are kept, and there was room already
+  EXPECT_EQ(data, map.data());
+  EXPECT_THAT(
+      map,
+      testing::ElementsAreArray(std::vector<std::pair<int, std::string>>{
+          {1, "one"}, {2, "two"}, {3, "three"}, {4, "four"}, {5, "five"}}));
+}
+
 TEST(SortedVectorTypes, TestDataPointsToFirstElement) {
   sorted_vector_set<int> set;
   sorted_vector_map<int, int> map;
@@ -14,10 +14,38 @@
  * limitations under the License.
  */
 
+// Compares the --json_verbose output of two sets of benchmark runs:
+//
+//   benchmark_compare base1.json,base2.json,base3.json new1.json,new2.json,...
+//
+// Each benchmark's time per iteration is summarized by its median across
+// runs. A change larger than --regression_threshold percent is flagged if
+// an exact one-sided Mann-Whitney U test over the runs gives a p-value of
+// at most --significance. With fewer than 3 runs on either side, no p-value
+// can be that small, and changes are flagged on the threshold alone. The
+// exit status is 1 if any benchmark regressed, so the tool can gate changes.
+// Benchmarks missing from either side are listed with a "-" on that side.
+
 #include <folly/Benchmark.h>
 #include <folly/FileUtil.h>
+#include <folly/MapUtil.h>
+#include <folly/String.h>
 #include <folly/init/Init.h>
 #include <folly/json.h>
+#include <folly/stats/detail/MannWhitney.h>
+
+#include <map>
+
+DEFINE_double(
+    regression_threshold,
+    5,
+    "Flag changes in time per iteration larger than this percentage.");
+DEFINE_double(
+    significance,
+    0.05,
+    "Flag only changes with a Mann-Whitney U test p-value at most this.");
+
+DECLARE_bool(json);
 
 using namespace std;
 
@@ -31,8 +59,165 @@ vector<detail::BenchmarkResult> resultsFromFile(const std::string& filename) {
   return ret;
 }
 
-void compareBenchmarkResults(const std::string& base, const std::string& test) {
-  printResultComparison(resultsFromFile(base), resultsFromFile(test));
+namespace {
+
+using detail::mannWhitneyGreater;
+using detail::median;
+
+using BenchmarkKey = pair<string, string>;
+
+/**
+ * Time per iteration of every benchmark in each of a set of runs, with the
+ * benchmarks in the order they first appear.
+ */
+struct BenchmarkRuns {
+  vector<BenchmarkKey> order;
+  map<BenchmarkKey, vector<double>> times;
+  size_t runs{0};
+};
+
+BenchmarkRuns runsFromFiles(StringPiece filenames) {
+  vector<string> files;
+  split(',', filenames, files, true);
+  BenchmarkRuns ret;
+  for (auto const& file : files) {
+    for (auto& result : resultsFromFile(file)) {
+      if (result.name == "-") {
+        continue;
+      }
+      BenchmarkKey key(result.file, result.name);
+      auto& times = ret.times[key];
+      if (times.empty()) {
+        ret.order.push_back(key);
+      }
+      times.push_back(result.timeInNs);
+    }
+    ++ret.runs;
+  }
+  return ret;
+}
+
+string readableTime(double ns) {
+  return prettyPrint(ns / 1E9, PRETTY_TIME, false);
+}
+
+/**
+ * Prints the comparison of two sets of runs and returns the number of
+ * regressions.
+ */
+size_t compareBenchmarkRuns(
+    const BenchmarkRuns& base,
+    const BenchmarkRuns& test) {
+  dynamic json = dynamic::array;
+  size_t regressions = 0;
+  string lastFile;
+
+  auto printName = [&](const BenchmarkKey& key) {
+    if (key.first != lastFile) {
+      printf("%s\n", string(76, '=').c_str());
+      printf(
+          "%-37s%10s %10s %9s  %7s\n",
+          key.first.c_str(),
+          "base",
+          "test",
+          "change",
+          "p-value");
+      printf("%s\n", string(76, '=').c_str());
+      lastFile = key.first;
+    }
+    string name = key.second;
+    if (!name.empty() && name[0] == '%') {
+      name.erase(0, 1);
+    }
+    printf("%-36.36s ", name.c_str());
+  };
+
+  for (auto const& key : test.order) {
+    auto const& testTimes = test.times.at(key);
+    auto baseTimes = get_ptr(base.times, key);
+    double testMedian = median(testTimes);
+    dynamic row = dynamic::object("file", key.first)("name", key.second)(
+        "test", testMedian);
+
+    if (!baseTimes) {
+      if (!FLAGS_json) {
+        printName(key);
+        printf("%10s %10s\n", "-", readableTime(testMedian).c_str());
+      }
+      json.push_back(std::move(row));
+      continue;
+    }
+
+    double baseMedian = median(*baseTimes);
+    double change = baseMedian == 0
+        ? 0
+        : (testMedian - baseMedian) / baseMedian * 100;
+    double p = change >= 0 ? mannWhitneyGreater(testTimes, *baseTimes)
+                           : mannWhitneyGreater(*baseTimes, testTimes);
+    // Smallest p-value the test can give for these sample sizes; if it
+    // cannot reach the significance level, rely on the threshold alone.
+    double minP = mannWhitneyGreater(
+        vector<double>(testTimes.size(), 1),
+        vector<double>(baseTimes->size(), 0));
+    bool significant = minP > FLAGS_significance || p <= FLAGS_significance;
+    const char* verdict = "";
+    if (significant && change > FLAGS_regression_threshold) {
+      verdict = "REGRESSION";
+      ++regressions;
+    } else if (significant && change < -FLAGS_regression_threshold) {
+      verdict = "improvement";
+    }
+
+    if (!FLAGS_json) {
+      printName(key);
+      printf(
+          "%10s %10s %+8.2f%%  %7.4f%s%s\n",
+          readableTime(baseMedian).c_str(),
+          readableTime(testMedian).c_str(),
+          change,
+          p,
+          *verdict ? "  " : "",
+          verdict);
+    }
+    row["base"] = baseMedian;
+    row["change"] = change;
+    row["p_value"] = p;
+    row["verdict"] = verdict;
+    json.push_back(std::move(row));
+  }
+
+  for (auto const& key : base.order) {
+    if (test.times.count(key)) {
+      continue;
+    }
+    double baseMedian = median(base.times.at(key));
+    if (!FLAGS_json) {
+      printName(key);
+      printf("%10s %10s\n", readableTime(baseMedian).c_str(), "-");
+    }
+    json.push_back(dynamic::object("file", key.first)("name", key.second)(
+        "base", baseMedian));
+  }
+
+  if (FLAGS_json) {
+    printf("%s\n", toPrettyJson(json).c_str());
+  } else {
+    printf("%s\n", string(76, '=').c_str());
+    printf(
+        "%zu base run(s), %zu test run(s), %zu regression(s)\n",
+        base.runs,
+        test.runs,
+        regressions);
+  }
+  return regressions;
+}
+
+} // namespace
+
+size_t compareBenchmarkResults(
+    const std::string& base,
+    const std::string& test) {
+  return compareBenchmarkRuns(runsFromFiles(base), runsFromFiles(test));
 }
 
 } // namespace folly
@@ -40,6 +225,5 @@ void compareBenchmarkResults(const std::string& base, const std::string& test) {
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
   CHECK_GT(argc, 2);
-  folly::compareBenchmarkResults(argv[1], argv[2]);
-  return 0;
+  return folly::compareBenchmarkResults(argv[1], argv[2]) == 0 ? 0 : 1;
 }